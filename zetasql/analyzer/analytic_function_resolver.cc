@@ -345,9 +345,8 @@ zetasql_base::Status AnalyticFunctionResolver::ResolveOverClauseAndCreateAnalyti
       resolved_function_call->release_argument_list(),
       resolved_function_call->error_mode(), is_distinct,
       resolved_null_handling_modifier_kind, std::move(resolved_window_frame));
-  const ResolvedColumn resolved_column(
-      resolver_->AllocateColumnId(), kAnalyticId, alias,
-      resolved_analytic_function_call->type());
+  const ResolvedColumn resolved_column = resolver_->AllocateColumn(
+      kAnalyticId, alias, resolved_analytic_function_call->type());
 
   ZETASQL_RET_CHECK(zetasql_base::InsertIfNotPresent(
       &column_to_analytic_function_map_, resolved_column,
@@ -1146,9 +1145,8 @@ zetasql_base::Status AnalyticFunctionResolver::AddColumnForWindowExpression(
     if (alias.empty()) {
       alias = column_alias;
     }
-    ResolvedColumn resolved_column(resolver_->AllocateColumnId(), query_alias,
-                                   alias,
-                                   window_expr_info->resolved_expr->type());
+    ResolvedColumn resolved_column = resolver_->AllocateColumn(
+        query_alias, alias, window_expr_info->resolved_expr->type());
     window_columns_to_compute_.emplace_back(
         MakeResolvedComputedColumn(
             resolved_column, std::move(window_expr_info->resolved_expr)));
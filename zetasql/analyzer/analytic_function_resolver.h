@@ -17,7 +17,6 @@
 #ifndef ZETASQL_ANALYZER_ANALYTIC_FUNCTION_RESOLVER_H_
 #define ZETASQL_ANALYZER_ANALYTIC_FUNCTION_RESOLVER_H_
 
-#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -27,6 +26,7 @@
 #include "zetasql/public/type.h"
 #include "zetasql/resolved_ast/resolved_ast.h"
 #include "zetasql/resolved_ast/resolved_column.h"
+#include "absl/container/flat_hash_map.h"
 #include "zetasql/base/status.h"
 
 namespace zetasql {
@@ -74,7 +74,8 @@ class AnalyticFunctionResolver {
   struct FlattenedWindowInfo;
 
   // Map from window names to related window information.
-  typedef std::map<std::string, std::unique_ptr<const FlattenedWindowInfo>>
+  typedef absl::flat_hash_map<std::string,
+                              std::unique_ptr<const FlattenedWindowInfo>>
       NamedWindowInfoMap;
 
   // Constructor. Does not take ownership of <resolver>.  Takes ownership of
@@ -191,7 +192,8 @@ class AnalyticFunctionResolver {
   // An analytic function group is uniquely  identified by a grouping window.
   // This map is used to find the group that an analytic function belongs to
   // according to the grouping window of the analytic function.
-  std::map<const ASTWindowSpecification*, AnalyticFunctionGroupInfo*>
+  absl::flat_hash_map<const ASTWindowSpecification*,
+                      AnalyticFunctionGroupInfo*>
       ast_window_spec_to_function_group_map_;
 
   // Stores info for a partitioning or ordering expression, which is called a
@@ -212,7 +214,7 @@ class AnalyticFunctionResolver {
   // BY clauses in <ast_to_resolved_info_> so that it is easy to look up the
   // resolved info of a PARTITION BY/ORDER BY clause for a function group using
   // its ASTNode (contained in the AnalyticFunctionGroupInfo).
-  std::map<const ASTNode*, std::unique_ptr<WindowExprInfoList>>
+  absl::flat_hash_map<const ASTNode*, std::unique_ptr<WindowExprInfoList>>
       ast_to_resolved_info_map_;
 
   // A resolved column is created for each analytic function call.
@@ -220,7 +222,7 @@ class AnalyticFunctionResolver {
   // function. It is used in ValidateAndRewriteExprsPostAggregation()to find the
   // resolved expressions of an analytic function call from a ResolvedColumn
   // that may need rewriting.
-  std::map<ResolvedColumn, AnalyticFunctionInfo>
+  absl::flat_hash_map<ResolvedColumn, AnalyticFunctionInfo>
       column_to_analytic_function_map_;
 
   // ResolvedComputedColumns for those partitioning/ordering expressions that
@@ -16,10 +16,16 @@
 
 #include "zetasql/public/analyzer.h"
 
+#include <time.h>
+
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <memory>
+#include <set>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "zetasql/base/logging.h"
 #include "zetasql/analyzer/function_resolver.h"
@@ -34,9 +40,14 @@
 #include "zetasql/public/parse_resume_location.h"
 #include "zetasql/public/type.h"
 #include "zetasql/public/type.pb.h"
+#include "zetasql/resolved_ast/common_subexpression_elimination.h"
 #include "zetasql/resolved_ast/resolved_ast.h"
 #include "zetasql/resolved_ast/validator.h"
+#include "zetasql/resolved_ast/with_entries.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/time.h"
+#include "zetasql/base/canonical_errors.h"
 #include "zetasql/base/map_util.h"
 #include "zetasql/base/source_location.h"
 #include "zetasql/base/ret_check.h"
@@ -355,7 +366,13 @@ zetasql_base::Status AnalyzerOptions::Deserialize(
   result->set_statement_context(proto.statement_context());
   result->set_error_message_mode(proto.error_message_mode());
   result->set_record_parse_locations(proto.record_parse_locations());
+  result->set_compact_parse_locations(proto.compact_parse_locations());
   result->set_prune_unused_columns(proto.prune_unused_columns());
+  result->set_eliminate_common_subexpressions(
+      proto.eliminate_common_subexpressions());
+  result->set_annotate_with_entries(proto.annotate_with_entries());
+  result->set_inline_single_use_with_entries(
+      proto.inline_single_use_with_entries());
   result->set_allow_undeclared_parameters(proto.allow_undeclared_parameters());
   result->set_parameter_mode(proto.parameter_mode());
 
@@ -373,7 +390,7 @@ zetasql_base::Status AnalyzerOptions::Serialize(
     FileDescriptorSetMap* map, AnalyzerOptionsProto* proto) const {
   language_options_.Serialize(proto->mutable_language_options());
 
-  for (const auto& param : query_parameters_) {
+  for (const auto& param : query_parameters()) {
     auto* param_proto = proto->add_query_parameters();
     param_proto->set_name(param.first);
     ZETASQL_RETURN_IF_ERROR(param.second->SerializeToProtoAndDistinctFileDescriptors(
@@ -385,7 +402,7 @@ zetasql_base::Status AnalyzerOptions::Serialize(
         proto->add_positional_query_parameters(), map));
   }
 
-  for (const auto& column : expression_columns_) {
+  for (const auto& column : expression_columns()) {
     auto* column_proto = proto->add_expression_columns();
     column_proto->set_name(column.first);
     ZETASQL_RETURN_IF_ERROR(column.second->SerializeToProtoAndDistinctFileDescriptors(
@@ -412,11 +429,15 @@ zetasql_base::Status AnalyzerOptions::Serialize(
   proto->set_statement_context(statement_context_);
   proto->set_error_message_mode(error_message_mode_);
   proto->set_record_parse_locations(record_parse_locations_);
+  proto->set_compact_parse_locations(compact_parse_locations_);
   proto->set_prune_unused_columns(prune_unused_columns_);
+  proto->set_eliminate_common_subexpressions(eliminate_common_subexpressions_);
+  proto->set_annotate_with_entries(annotate_with_entries_);
+  proto->set_inline_single_use_with_entries(inline_single_use_with_entries_);
   proto->set_allow_undeclared_parameters(allow_undeclared_parameters_);
   proto->set_parameter_mode(parameter_mode_);
 
-  ZETASQL_RETURN_IF_ERROR(allowed_hints_and_options_.Serialize(
+  ZETASQL_RETURN_IF_ERROR(allowed_hints_and_options().Serialize(
       map, proto->mutable_allowed_hints_and_options()));
 
   return ::zetasql_base::OkStatus();
@@ -438,7 +459,7 @@ zetasql_base::Status AnalyzerOptions::AddQueryParameter(const std::string& name,
   }
 
   if (!zetasql_base::InsertIfNotPresent(
-          &query_parameters_,
+          MutableMap(&query_parameters_),
           std::make_pair(absl::AsciiStrToLower(name), type))) {
     return MakeSqlError() << "Duplicate parameter name "
                           << absl::AsciiStrToLower(name);
@@ -487,7 +508,7 @@ zetasql_base::Status AnalyzerOptions::AddExpressionColumn(const std::string& nam
   }
 
   if (!zetasql_base::InsertIfNotPresent(
-          &expression_columns_,
+          MutableMap(&expression_columns_),
           std::make_pair(absl::AsciiStrToLower(name), type))) {
     return MakeSqlError() << "Duplicate expression column name "
                           << absl::AsciiStrToLower(name);
@@ -513,7 +534,8 @@ zetasql_base::Status AnalyzerOptions::SetInScopeExpressionColumn(
 
   const std::pair<std::string, const Type*> name_and_type(
       absl::AsciiStrToLower(name), type);
-  if (!zetasql_base::InsertIfNotPresent(&expression_columns_, name_and_type)) {
+  if (!zetasql_base::InsertIfNotPresent(MutableMap(&expression_columns_),
+                                        name_and_type)) {
     return MakeSqlError() << "Duplicate expression column name "
                           << absl::AsciiStrToLower(name);
   }
@@ -522,6 +544,32 @@ zetasql_base::Status AnalyzerOptions::SetInScopeExpressionColumn(
   return ::zetasql_base::OkStatus();
 }
 
+const AllowedHintsAndOptions& AnalyzerOptions::allowed_hints_and_options()
+    const {
+  static const AllowedHintsAndOptions* const kDefault =
+      new AllowedHintsAndOptions;
+  return allowed_hints_and_options_ == nullptr ? *kDefault
+                                               : *allowed_hints_and_options_;
+}
+
+// static
+const QueryParametersMap& AnalyzerOptions::MapOrEmpty(
+    const std::shared_ptr<QueryParametersMap>& map) {
+  static const QueryParametersMap* const kEmptyMap = new QueryParametersMap;
+  return map == nullptr ? *kEmptyMap : *map;
+}
+
+// static
+QueryParametersMap* AnalyzerOptions::MutableMap(
+    std::shared_ptr<QueryParametersMap>* map) {
+  if (*map == nullptr) {
+    *map = std::make_shared<QueryParametersMap>();
+  } else if (map->use_count() > 1) {
+    *map = std::make_shared<QueryParametersMap>(**map);
+  }
+  return map->get();
+}
+
 void AnalyzerOptions::SetDdlPseudoColumnsCallback(
     DdlPseudoColumnsCallback ddl_pseudo_columns_callback) {
   ddl_pseudo_columns_callback_ = std::move(ddl_pseudo_columns_callback);
@@ -543,6 +591,207 @@ ParserOptions AnalyzerOptions::GetParserOptions() const {
   return ParserOptions(id_string_pool(), arena());
 }
 
+ArenaUsage ArenaUsage::Of(const zetasql_base::UnsafeArena& arena) {
+  const zetasql_base::UnsafeArena::Status status = arena.status();
+  ArenaUsage usage;
+  usage.bytes_allocated = status.bytes_allocated();
+  usage.bytes_wasted = status.bytes_wasted();
+  usage.bytes_used = usage.bytes_allocated - usage.bytes_wasted -
+                     arena.bytes_until_next_allocation();
+  usage.block_count = arena.block_count();
+  return usage;
+}
+
+ArenaUsage ArenaUsage::Since(const ArenaUsage& earlier) const {
+  ArenaUsage growth;
+  growth.bytes_allocated = bytes_allocated - earlier.bytes_allocated;
+  growth.bytes_used = bytes_used - earlier.bytes_used;
+  growth.bytes_wasted = bytes_wasted - earlier.bytes_wasted;
+  growth.block_count = block_count - earlier.block_count;
+  return growth;
+}
+
+std::string ArenaUsage::DebugString() const {
+  return absl::StrCat("bytes_allocated: ", bytes_allocated,
+                      " bytes_used: ", bytes_used,
+                      " bytes_wasted: ", bytes_wasted,
+                      " block_count: ", block_count);
+}
+
+std::string PhaseTime::DebugString() const {
+  return absl::StrCat("wall_time: ", absl::FormatDuration(wall_time),
+                      " cpu_time: ", absl::FormatDuration(cpu_time));
+}
+
+std::string AnalyzerRuntimeInfo::DebugString() const {
+  return absl::StrCat(
+      "parser: {", parser_time.DebugString(), " num_tokens: ", num_tokens,
+      " num_ast_nodes: ", num_ast_nodes, " arena: {",
+      parser_arena.DebugString(), "}} resolver: {",
+      resolver_time.DebugString(),
+      " num_catalog_lookups: ", num_catalog_lookups,
+      " catalog_lookup_time: ", absl::FormatDuration(catalog_lookup_time),
+      " num_signatures_tried: ", num_signatures_tried,
+      " num_resolved_nodes: ", num_resolved_nodes, " arena: {",
+      resolver_arena.DebugString(), "}} id_string_pool_arena: {",
+      id_string_pool_arena.DebugString(), "}");
+}
+
+std::string QueryComplexity::DebugString() const {
+  return absl::StrCat("num_nodes: ", num_nodes, " max_depth: ", max_depth,
+                      " num_table_references: ", num_table_references,
+                      " estimated_resolution_cost: ",
+                      estimated_resolution_cost);
+}
+
+// Returns the weight of <node> in QueryComplexity::estimated_resolution_cost.
+static int ResolutionCostOf(const ASTNode* node) {
+  switch (node->node_kind()) {
+    // Catalog lookups, and creating the columns of the table.
+    case AST_TABLE_PATH_EXPRESSION:
+    case AST_TVF:
+      return 20;
+    // New name scopes and name lists.
+    case AST_QUERY:
+    case AST_SELECT:
+    case AST_SET_OPERATION:
+    case AST_JOIN:
+    case AST_EXPRESSION_SUBQUERY:
+    case AST_TABLE_SUBQUERY:
+      return 10;
+    // Function signature matching.
+    case AST_FUNCTION_CALL:
+    case AST_ANALYTIC_FUNCTION_CALL:
+    case AST_AND_EXPR:
+    case AST_OR_EXPR:
+    case AST_BINARY_EXPRESSION:
+    case AST_BITWISE_SHIFT_EXPRESSION:
+    case AST_UNARY_EXPRESSION:
+    case AST_BETWEEN_EXPRESSION:
+    case AST_IN_EXPRESSION:
+    case AST_CASE_NO_VALUE_EXPRESSION:
+    case AST_CASE_VALUE_EXPRESSION:
+    case AST_CAST_EXPRESSION:
+    case AST_EXTRACT_EXPRESSION:
+      return 5;
+    // Name scope lookups, which may fall back to the catalog.
+    case AST_PATH_EXPRESSION:
+      return 2;
+    default:
+      return 1;
+  }
+}
+
+QueryComplexity EstimateQueryComplexity(const ASTNode& root) {
+  QueryComplexity complexity;
+  int64_t depth = 0;
+  root.TraverseNonRecursive(
+      [&complexity, &depth](const ASTNode* node) {
+        ++complexity.num_nodes;
+        complexity.max_depth = std::max(complexity.max_depth, ++depth);
+        if (node->node_kind() == AST_TABLE_PATH_EXPRESSION ||
+            node->node_kind() == AST_TVF) {
+          ++complexity.num_table_references;
+        }
+        complexity.estimated_resolution_cost += ResolutionCostOf(node);
+        return true;
+      },
+      [&depth](const ASTNode* node) { --depth; });
+  return complexity;
+}
+
+// Returns a RESOURCE_EXHAUSTED error at <root> if its QueryComplexity exceeds
+// the limits in <options>.
+static zetasql_base::Status CheckQueryComplexity(const ASTNode& root,
+                                         const AnalyzerOptions& options) {
+  const AnalyzerLimits& limits = options.limits();
+  if (limits.max_ast_nodes == 0 && limits.max_ast_depth == 0 &&
+      limits.max_estimated_resolution_cost == 0) {
+    return ::zetasql_base::OkStatus();
+  }
+  const QueryComplexity complexity = EstimateQueryComplexity(root);
+  std::string error;
+  if (limits.max_ast_nodes > 0 && complexity.num_nodes > limits.max_ast_nodes) {
+    error = absl::StrCat("it has ", complexity.num_nodes,
+                         " syntax nodes, more than the limit of ",
+                         limits.max_ast_nodes);
+  } else if (limits.max_ast_depth > 0 &&
+             complexity.max_depth > limits.max_ast_depth) {
+    error = absl::StrCat("it is nested ", complexity.max_depth,
+                         " syntax nodes deep, more than the limit of ",
+                         limits.max_ast_depth);
+  } else if (limits.max_estimated_resolution_cost > 0 &&
+             complexity.estimated_resolution_cost >
+                 limits.max_estimated_resolution_cost) {
+    error = absl::StrCat("its estimated resolution cost is ",
+                         complexity.estimated_resolution_cost,
+                         ", more than the limit of ",
+                         limits.max_estimated_resolution_cost);
+  } else {
+    return ::zetasql_base::OkStatus();
+  }
+  return StatusWithInternalErrorLocation(
+      ::zetasql_base::ResourceExhaustedError(
+          absl::StrCat("Query is too complex to analyze: ", error)),
+      &root);
+}
+
+// Returns the CPU time used by the current thread so far, or zero if the
+// platform does not measure it.
+static absl::Duration ThreadCpuTime() {
+  timespec cpu_time;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_time) != 0) {
+    return absl::ZeroDuration();
+  }
+  return absl::DurationFromTimespec(cpu_time);
+}
+
+namespace {
+
+// Measures a phase of an analysis: its time, the growth of an arena and the
+// ResolvedNodes created from construction to the calls of the accessors.
+class PhaseTimer {
+ public:
+  explicit PhaseTimer(const zetasql_base::UnsafeArena& arena)
+      : arena_(arena),
+        arena_before_(ArenaUsage::Of(arena)),
+        resolved_nodes_before_(ResolvedNode::num_nodes_created()),
+        wall_start_(absl::Now()),
+        cpu_start_(ThreadCpuTime()) {}
+  PhaseTimer(const PhaseTimer&) = delete;
+  PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+  PhaseTime Elapsed() const {
+    PhaseTime time;
+    time.wall_time = absl::Now() - wall_start_;
+    time.cpu_time = ThreadCpuTime() - cpu_start_;
+    return time;
+  }
+  ArenaUsage ArenaGrowth() const {
+    return ArenaUsage::Of(arena_).Since(arena_before_);
+  }
+  int64_t ResolvedNodesCreated() const {
+    return ResolvedNode::num_nodes_created() - resolved_nodes_before_;
+  }
+
+ private:
+  const zetasql_base::UnsafeArena& arena_;
+  const ArenaUsage arena_before_;
+  const int64_t resolved_nodes_before_;
+  const absl::Time wall_start_;
+  const absl::Duration cpu_start_;
+};
+
+}  // namespace
+
+// Returns the runtime info of a parsing phase measured by <timer>.
+static AnalyzerRuntimeInfo ParserRuntimeInfo(const PhaseTimer& timer) {
+  AnalyzerRuntimeInfo runtime_info;
+  runtime_info.parser_time = timer.Elapsed();
+  runtime_info.parser_arena = timer.ArenaGrowth();
+  return runtime_info;
+}
+
 AnalyzerOutput::AnalyzerOutput(
     std::shared_ptr<IdStringPool> id_string_pool,
     std::shared_ptr<zetasql_base::UnsafeArena> arena,
@@ -582,6 +831,16 @@ AnalyzerOutput::AnalyzerOutput(
 AnalyzerOutput::~AnalyzerOutput() {
 }
 
+bool AnalyzerOutput::GetParseLocationRange(const ResolvedNode* node,
+                                           ParseLocationRange* range) const {
+  if (node->GetParseLocationRangeOrNULL() != nullptr) {
+    *range = *node->GetParseLocationRangeOrNULL();
+    return true;
+  }
+  return parse_locations_ != nullptr &&
+         parse_locations_->Get(node->GetParseLocationId(), range);
+}
+
 // Common post-parsing work for AnalyzeStatement() series.
 static zetasql_base::Status FinishAnalyzeStatementImpl(
     absl::string_view sql, const ParserOutput& parser_output,
@@ -600,6 +859,26 @@ static zetasql_base::Status FinishAnalyzeStatementImpl(
     return resolver->deprecation_warnings().front();
   }
 
+  if (options.eliminate_common_subexpressions()) {
+    std::unique_ptr<const ResolvedNode> root = std::move(*resolved_statement);
+    ZETASQL_RETURN_IF_ERROR(EliminateCommonSubexpressions(
+        [resolver]() { return resolver->AllocateColumnId(); }, &root));
+    resolved_statement->reset(root.release()->GetAs<ResolvedStatement>());
+    VLOG(3) << "Resolved AST after eliminating common subexpressions:\n"
+            << (*resolved_statement)->DebugString();
+  }
+
+  if (options.inline_single_use_with_entries()) {
+    std::unique_ptr<const ResolvedNode> root = std::move(*resolved_statement);
+    ZETASQL_RETURN_IF_ERROR(InlineSingleUseWithEntries(&root));
+    resolved_statement->reset(root.release()->GetAs<ResolvedStatement>());
+    VLOG(3) << "Resolved AST after inlining WITH entries:\n"
+            << (*resolved_statement)->DebugString();
+  } else if (options.annotate_with_entries()) {
+    ZETASQL_RETURN_IF_ERROR(AnnotateWithEntries(
+        const_cast<ResolvedStatement*>(resolved_statement->get())));
+  }
+
   // Make sure we're starting from a clean state for CheckFieldsAccessed.
   (*resolved_statement)->ClearFieldsAccessed();
 
@@ -621,6 +900,39 @@ static zetasql_base::Status UnsupportedStatementErrorOrStatus(
   return status;
 }
 
+// Records the runtime info of an analysis in <output>. <parser_info> has the
+// parsing phase, from ParserRuntimeInfo() or empty, <parser_output> is the
+// parse tree if known, and <resolver_timer> measured the resolving phase with
+// <resolver>.
+static void SetRuntimeInfo(const AnalyzerOptions& options,
+                           const AnalyzerRuntimeInfo& parser_info,
+                           const ParserOutput* parser_output,
+                           const PhaseTimer& resolver_timer,
+                           const Resolver& resolver, AnalyzerOutput* output) {
+  AnalyzerRuntimeInfo* runtime_info = output->mutable_runtime_info();
+  *runtime_info = parser_info;
+  if (parser_output != nullptr) {
+    runtime_info->num_tokens = parser_output->num_tokens();
+    runtime_info->num_ast_nodes = parser_output->num_ast_nodes();
+  }
+  runtime_info->resolver_time = resolver_timer.Elapsed();
+  runtime_info->resolver_arena = resolver_timer.ArenaGrowth();
+  runtime_info->num_resolved_nodes = resolver_timer.ResolvedNodesCreated();
+  const Resolver::RuntimeStats& stats = resolver.runtime_stats();
+  runtime_info->num_catalog_lookups = stats.num_catalog_lookups;
+  runtime_info->catalog_lookup_time = stats.catalog_lookup_time;
+  runtime_info->num_signatures_tried = stats.num_signatures_tried;
+  runtime_info->id_string_pool_arena =
+      ArenaUsage::Of(options.id_string_pool()->arena());
+}
+
+static zetasql_base::Status AnalyzeStatementFromParserOutputImpl(
+    const ParserOutput& parser_output,
+    std::unique_ptr<ParserOutput>* owned_parser_output_on_success,
+    const AnalyzerRuntimeInfo& parser_info, const AnalyzerOptions& options,
+    absl::string_view sql, Catalog* catalog, TypeFactory* type_factory,
+    std::unique_ptr<const AnalyzerOutput>* output);
+
 static zetasql_base::Status AnalyzeStatementImpl(
     absl::string_view sql, const AnalyzerOptions& options, Catalog* catalog,
     TypeFactory* type_factory, std::unique_ptr<const AnalyzerOutput>* output) {
@@ -629,6 +941,7 @@ static zetasql_base::Status AnalyzeStatementImpl(
   ZETASQL_RETURN_IF_ERROR(ValidateAnalyzerOptions(options));
 
   VLOG(1) << "Parsing statement:\n" << sql;
+  const PhaseTimer parser_timer(*options.arena());
   std::unique_ptr<ParserOutput> parser_output;
   const zetasql_base::Status status = ParseStatement(
       sql, options.GetParserOptions(), &parser_output);
@@ -637,8 +950,9 @@ static zetasql_base::Status AnalyzeStatementImpl(
         status, ParseResumeLocation::FromStringView(sql), options);
   }
 
-  return AnalyzeStatementFromParserOutputOwnedOnSuccess(
-      &parser_output, options, sql, catalog, type_factory, output);
+  return AnalyzeStatementFromParserOutputImpl(
+      *parser_output, &parser_output, ParserRuntimeInfo(parser_timer), options,
+      sql, catalog, type_factory, output);
 }
 
 zetasql_base::Status AnalyzeStatement(absl::string_view sql,
@@ -671,6 +985,7 @@ static zetasql_base::Status AnalyzeNextStatementImpl(
             << resume_location->byte_position();
   }
 
+  const PhaseTimer parser_timer(*options.arena());
   std::unique_ptr<ParserOutput> parser_output;
   const zetasql_base::Status status = ParseNextStatement(
       resume_location, options.GetParserOptions(), &parser_output,
@@ -680,9 +995,9 @@ static zetasql_base::Status AnalyzeNextStatementImpl(
   }
   ZETASQL_RET_CHECK(parser_output != nullptr);
 
-  return AnalyzeStatementFromParserOutputOwnedOnSuccess(
-      &parser_output, options, resume_location->input(), catalog,
-      type_factory, output);
+  return AnalyzeStatementFromParserOutputImpl(
+      *parser_output, &parser_output, ParserRuntimeInfo(parser_timer), options,
+      resume_location->input(), catalog, type_factory, output);
 }
 
 zetasql_base::Status AnalyzeNextStatement(
@@ -701,9 +1016,35 @@ zetasql_base::Status AnalyzeNextStatement(
       options.error_message_mode(), resume_location->input(), status);
 }
 
+// Passes the tables referenced by <statement> to Catalog::PrefetchTables().
+// Failures to extract the table names are ignored, since resolving the
+// statement reports a better error for them.
+static zetasql_base::Status PrefetchTables(absl::string_view sql,
+                                   const ASTStatement& statement,
+                                   const AnalyzerOptions& options,
+                                   Catalog* catalog) {
+  TableNamesSet table_names;
+  if (!table_name_resolver::FindTables(sql, statement, options, &table_names)
+           .ok() ||
+      table_names.empty()) {
+    return ::zetasql_base::OkStatus();
+  }
+  const std::vector<std::vector<std::string>> paths(table_names.begin(),
+                                                    table_names.end());
+  return catalog->PrefetchTables(paths);
+}
+
+// Returns the arena that ResolvedNodes are allocated in while analyzing with
+// <options>, or NULL if they are allocated on the heap.
+static zetasql_base::UnsafeArena* GetResolvedNodeArena(const AnalyzerOptions& options) {
+  return options.allocate_resolved_ast_in_arena() ? options.arena().get()
+                                                  : nullptr;
+}
+
 static zetasql_base::Status AnalyzeStatementFromParserOutputImpl(
-    std::unique_ptr<ParserOutput>* statement_parser_output,
-    bool take_ownership_on_success, const AnalyzerOptions& options,
+    const ParserOutput& parser_output,
+    std::unique_ptr<ParserOutput>* owned_parser_output_on_success,
+    const AnalyzerRuntimeInfo& parser_info, const AnalyzerOptions& options,
     absl::string_view sql, Catalog* catalog, TypeFactory* type_factory,
     std::unique_ptr<const AnalyzerOutput>* output) {
   AnalyzerOptions local_options = options;
@@ -711,29 +1052,41 @@ static zetasql_base::Status AnalyzeStatementFromParserOutputImpl(
   // If the arena and IdStringPool are not set in <options>, use the
   // arena and IdStringPool from the parser output by default.
   if (local_options.arena() == nullptr) {
-    ZETASQL_RET_CHECK((*statement_parser_output)->arena() != nullptr);
-    local_options.set_arena((*statement_parser_output)->arena());
+    ZETASQL_RET_CHECK(parser_output.arena() != nullptr);
+    local_options.set_arena(parser_output.arena());
   }
   if (local_options.id_string_pool() == nullptr) {
-    ZETASQL_RET_CHECK((*statement_parser_output)->id_string_pool() != nullptr);
-    local_options.set_id_string_pool(
-        (*statement_parser_output)->id_string_pool());
+    ZETASQL_RET_CHECK(parser_output.id_string_pool() != nullptr);
+    local_options.set_id_string_pool(parser_output.id_string_pool());
   }
   output->reset();
 
+  ZETASQL_RETURN_IF_ERROR(ConvertInternalErrorLocationAndAdjustErrorString(
+      local_options.error_message_mode(), sql,
+      CheckQueryComplexity(*parser_output.statement(), local_options)));
+
+  const PhaseTimer resolver_timer(*local_options.arena());
+  if (local_options.prefetch_tables()) {
+    ZETASQL_RETURN_IF_ERROR(PrefetchTables(sql, *parser_output.statement(),
+                                   local_options, catalog));
+  }
+
+  ResolvedNode::ArenaScope arena_scope(GetResolvedNodeArena(local_options));
   std::unique_ptr<const ResolvedStatement> resolved_statement;
   Resolver resolver(catalog, type_factory, &local_options);
   const zetasql_base::Status status =
       FinishAnalyzeStatementImpl(
-          sql, *(statement_parser_output->get()), &resolver, local_options,
+          sql, parser_output, &resolver, local_options,
           catalog, type_factory, &resolved_statement);
   if (!status.ok()) {
     return ConvertInternalErrorLocationAndAdjustErrorString(
         local_options.error_message_mode(), sql, status);
   }
-  std::unique_ptr<ParserOutput> owned_parser_output(
-      take_ownership_on_success ? statement_parser_output->release() : nullptr);
-  *output = absl::make_unique<AnalyzerOutput>(
+  std::unique_ptr<ParserOutput> owned_parser_output;
+  if (owned_parser_output_on_success != nullptr) {
+    owned_parser_output = std::move(*owned_parser_output_on_success);
+  }
+  auto analyzer_output = absl::make_unique<AnalyzerOutput>(
       local_options.id_string_pool(), local_options.arena(),
       std::move(resolved_statement),
       AnalyzerOutputProperties(),
@@ -743,6 +1096,10 @@ static zetasql_base::Status AnalyzeStatementFromParserOutputImpl(
           resolver.deprecation_warnings()),
       resolver.undeclared_parameters(),
       resolver.undeclared_positional_parameters());
+  analyzer_output->set_parse_locations(resolver.release_parse_locations());
+  SetRuntimeInfo(local_options, parser_info, &parser_output, resolver_timer,
+                 resolver, analyzer_output.get());
+  *output = std::move(analyzer_output);
   return zetasql_base::OkStatus();
 }
 
@@ -751,8 +1108,8 @@ zetasql_base::Status AnalyzeStatementFromParserOutputOwnedOnSuccess(
     const AnalyzerOptions& options, absl::string_view sql, Catalog* catalog,
     TypeFactory* type_factory, std::unique_ptr<const AnalyzerOutput>* output) {
   return AnalyzeStatementFromParserOutputImpl(
-      statement_parser_output, /*take_ownership_on_success=*/true, options,
-      sql, catalog, type_factory, output);
+      **statement_parser_output, statement_parser_output,
+      AnalyzerRuntimeInfo(), options, sql, catalog, type_factory, output);
 }
 
 zetasql_base::Status AnalyzeStatementFromParserOutputUnowned(
@@ -760,8 +1117,165 @@ zetasql_base::Status AnalyzeStatementFromParserOutputUnowned(
     const AnalyzerOptions& options, absl::string_view sql, Catalog* catalog,
     TypeFactory* type_factory, std::unique_ptr<const AnalyzerOutput>* output) {
   return AnalyzeStatementFromParserOutputImpl(
-      statement_parser_output, /*take_ownership_on_success=*/false, options,
-      sql, catalog, type_factory, output);
+      **statement_parser_output,
+      /*owned_parser_output_on_success=*/nullptr, AnalyzerRuntimeInfo(),
+      options, sql, catalog, type_factory, output);
+}
+
+bool QueryParameterTypesMatch(const AnalyzerOutput& analyzed,
+                              const AnalyzerOptions& options) {
+  if (analyzed.resolved_statement() == nullptr) {
+    return false;
+  }
+  std::vector<const ResolvedNode*> parameters;
+  analyzed.resolved_statement()->GetDescendantsWithKinds({RESOLVED_PARAMETER},
+                                                         &parameters);
+  for (const ResolvedNode* node : parameters) {
+    const ResolvedParameter* parameter = node->GetAs<ResolvedParameter>();
+    bool was_undeclared;
+    const Type* new_type;
+    if (!parameter->name().empty()) {
+      was_undeclared = zetasql_base::ContainsKey(
+          analyzed.undeclared_parameters(), parameter->name());
+      new_type = zetasql_base::FindPtrOrNull(options.query_parameters(),
+                                    parameter->name());
+    } else {
+      const int index = parameter->position() - 1;
+      was_undeclared =
+          index < analyzed.undeclared_positional_parameters().size();
+      new_type = index < options.positional_query_parameters().size()
+                     ? options.positional_query_parameters()[index]
+                     : nullptr;
+    }
+    if (was_undeclared) {
+      // The type was inferred from the statement, so it is inferred the same
+      // way again if the parameter stays undeclared.
+      if (new_type != nullptr || !options.allow_undeclared_parameters()) {
+        return false;
+      }
+    } else if (new_type == nullptr || !new_type->Equals(parameter->type())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns the pools of <file_descriptor_set_map>, ordered by their index.
+static std::vector<const google::protobuf::DescriptorPool*> GetDescriptorPools(
+    const FileDescriptorSetMap& file_descriptor_set_map) {
+  std::vector<const google::protobuf::DescriptorPool*> pools(
+      file_descriptor_set_map.size());
+  for (const auto& entry : file_descriptor_set_map) {
+    pools[entry.second->descriptor_set_index] = entry.first;
+  }
+  return pools;
+}
+
+zetasql_base::Status RebindQueryParameters(
+    const AnalyzerOutput& analyzed, absl::string_view sql,
+    const AnalyzerOptions& options_in, Catalog* catalog,
+    TypeFactory* type_factory, std::unique_ptr<const AnalyzerOutput>* output) {
+  output->reset();
+  ZETASQL_RET_CHECK(analyzed.resolved_statement() != nullptr)
+      << "RebindQueryParameters requires an analyzed statement";
+  if (analyzed.parser_output_ == nullptr) {
+    return MakeSqlError()
+           << "RebindQueryParameters requires an AnalyzerOutput that owns its "
+              "parse tree";
+  }
+  // Analyze in new arenas rather than the ones of the parse tree, which other
+  // threads may be rebinding from at the same time.
+  std::unique_ptr<AnalyzerOptions> copy;
+  const AnalyzerOptions& options = GetOptionsWithArenas(&options_in, &copy);
+  ZETASQL_RETURN_IF_ERROR(ValidateAnalyzerOptions(options));
+  return AnalyzeStatementFromParserOutputImpl(
+      *analyzed.parser_output_, /*owned_parser_output_on_success=*/nullptr,
+      AnalyzerRuntimeInfo(), options, sql, catalog, type_factory, output);
+}
+
+// Copies the parse location ids of the nodes of <from> to the nodes of <to>,
+// which must have been restored from the serialized form of <from>.  Ids are
+// not serialized, since they refer to the table of an AnalyzerOutput.
+static zetasql_base::Status CopyParseLocationIds(const ResolvedNode* from,
+                                         const ResolvedNode* to) {
+  std::vector<std::pair<const ResolvedNode*, const ResolvedNode*>> stack = {
+      {from, to}};
+  std::vector<const ResolvedNode*> from_children;
+  std::vector<const ResolvedNode*> to_children;
+  while (!stack.empty()) {
+    const ResolvedNode* from_node = stack.back().first;
+    const ResolvedNode* to_node = stack.back().second;
+    stack.pop_back();
+    ZETASQL_RET_CHECK_EQ(from_node->node_kind(), to_node->node_kind());
+    if (from_node->GetParseLocationId() >= 0) {
+      const_cast<ResolvedNode*>(to_node)->SetParseLocationId(
+          from_node->GetParseLocationId());
+    }
+    from_node->GetChildNodes(&from_children);
+    to_node->GetChildNodes(&to_children);
+    ZETASQL_RET_CHECK_EQ(from_children.size(), to_children.size());
+    for (int i = 0; i < from_children.size(); ++i) {
+      stack.emplace_back(from_children[i], to_children[i]);
+    }
+  }
+  return zetasql_base::OkStatus();
+}
+
+zetasql_base::StatusOr<std::unique_ptr<const AnalyzerOutput>>
+CompactAnalyzerOutput(const AnalyzerOutput& analyzed, Catalog* catalog,
+                      TypeFactory* type_factory) {
+  // Strings of a resolved tree are mostly column names, so small blocks
+  // waste little.
+  auto arena = std::make_shared<zetasql_base::UnsafeArena>(/*block_size=*/1024);
+  auto id_string_pool = std::make_shared<IdStringPool>(arena);
+
+  FileDescriptorSetMap file_descriptor_set_map;
+  std::unique_ptr<AnalyzerOutput> compacted;
+  if (analyzed.resolved_statement() != nullptr) {
+    AnyResolvedStatementProto proto;
+    ZETASQL_RETURN_IF_ERROR(analyzed.resolved_statement()->SaveTo(
+        &file_descriptor_set_map, &proto));
+    ZETASQL_ASSIGN_OR_RETURN(
+        std::unique_ptr<ResolvedStatement> statement,
+        ResolvedStatement::RestoreFrom(
+            proto, ResolvedNode::RestoreParams(
+                       GetDescriptorPools(file_descriptor_set_map), catalog,
+                       type_factory, id_string_pool.get())));
+    if (analyzed.parse_locations() != nullptr) {
+      ZETASQL_RETURN_IF_ERROR(
+          CopyParseLocationIds(analyzed.resolved_statement(), statement.get()));
+    }
+    compacted = absl::make_unique<AnalyzerOutput>(
+        id_string_pool, arena, std::move(statement),
+        analyzed.analyzer_output_properties(), /*parser_output=*/nullptr,
+        analyzed.deprecation_warnings(), analyzed.undeclared_parameters(),
+        analyzed.undeclared_positional_parameters());
+  } else {
+    ZETASQL_RET_CHECK(analyzed.resolved_expr() != nullptr);
+    AnyResolvedExprProto proto;
+    ZETASQL_RETURN_IF_ERROR(
+        analyzed.resolved_expr()->SaveTo(&file_descriptor_set_map, &proto));
+    ZETASQL_ASSIGN_OR_RETURN(
+        std::unique_ptr<ResolvedExpr> expr,
+        ResolvedExpr::RestoreFrom(
+            proto, ResolvedNode::RestoreParams(
+                       GetDescriptorPools(file_descriptor_set_map), catalog,
+                       type_factory, id_string_pool.get())));
+    if (analyzed.parse_locations() != nullptr) {
+      ZETASQL_RETURN_IF_ERROR(
+          CopyParseLocationIds(analyzed.resolved_expr(), expr.get()));
+    }
+    compacted = absl::make_unique<AnalyzerOutput>(
+        id_string_pool, arena, std::move(expr),
+        analyzed.analyzer_output_properties(), /*parser_output=*/nullptr,
+        analyzed.deprecation_warnings(), analyzed.undeclared_parameters(),
+        analyzed.undeclared_positional_parameters());
+  }
+  compacted->set_parse_locations(analyzed.parse_locations());
+  *compacted->mutable_runtime_info() = analyzed.runtime_info();
+  compacted->mutable_runtime_info()->id_string_pool_arena =
+      ArenaUsage::Of(*arena);
+  return std::unique_ptr<const AnalyzerOutput>(std::move(compacted));
 }
 
 // Coerces <resolved_expr> to <target_type>, using assignment semantics
@@ -806,9 +1320,14 @@ static zetasql_base::Status ConvertExprToTargetType(
 
 static zetasql_base::Status AnalyzeExpressionFromParserASTImpl(
     const ASTExpression& ast_expression,
-    std::unique_ptr<ParserOutput> parser_output, absl::string_view sql,
+    std::unique_ptr<ParserOutput> parser_output,
+    const AnalyzerRuntimeInfo& parser_info, absl::string_view sql,
     const AnalyzerOptions& options, Catalog* catalog, TypeFactory* type_factory,
     const Type* target_type, std::unique_ptr<const AnalyzerOutput>* output) {
+  ZETASQL_RETURN_IF_ERROR(CheckQueryComplexity(ast_expression, options));
+
+  const PhaseTimer resolver_timer(*options.arena());
+  ResolvedNode::ArenaScope arena_scope(GetResolvedNodeArena(options));
   std::unique_ptr<const ResolvedExpr> resolved_expr;
   Resolver resolver(catalog, type_factory, &options);
   ZETASQL_RETURN_IF_ERROR(resolver.ResolveStandaloneExpr(
@@ -829,7 +1348,8 @@ static zetasql_base::Status AnalyzeExpressionFromParserASTImpl(
   // Make sure we're starting from a clean state for CheckFieldsAccessed.
   resolved_expr->ClearFieldsAccessed();
 
-  *output = absl::make_unique<AnalyzerOutput>(
+  const ParserOutput* parser_output_ptr = parser_output.get();
+  auto analyzer_output = absl::make_unique<AnalyzerOutput>(
       options.id_string_pool(), options.arena(), std::move(resolved_expr),
       AnalyzerOutputProperties(),
       std::move(parser_output),
@@ -837,20 +1357,21 @@ static zetasql_base::Status AnalyzeExpressionFromParserASTImpl(
           options.error_message_mode(), sql, resolver.deprecation_warnings()),
       resolver.undeclared_parameters(),
       resolver.undeclared_positional_parameters());
+  analyzer_output->set_parse_locations(resolver.release_parse_locations());
+  SetRuntimeInfo(options, parser_info, parser_output_ptr, resolver_timer,
+                 resolver, analyzer_output.get());
+  *output = std::move(analyzer_output);
   return zetasql_base::OkStatus();
 }
 
-static zetasql_base::Status AnalyzeExpressionImpl(
-    absl::string_view sql, const AnalyzerOptions& options_in, Catalog* catalog,
+// Parses and analyzes <sql> with <options>, which must have been validated
+// and have all arenas initialized.
+static zetasql_base::Status ParseAndAnalyzeExpression(
+    absl::string_view sql, const AnalyzerOptions& options, Catalog* catalog,
     TypeFactory* type_factory, const Type* target_type,
     std::unique_ptr<const AnalyzerOutput>* output) {
-  output->reset();
-
   VLOG(1) << "Parsing expression:\n" << sql;
-  std::unique_ptr<AnalyzerOptions> copy;
-  const AnalyzerOptions& options = GetOptionsWithArenas(&options_in, &copy);
-  ZETASQL_RETURN_IF_ERROR(ValidateAnalyzerOptions(options));
-
+  const PhaseTimer parser_timer(*options.arena());
   std::unique_ptr<ParserOutput> parser_output;
   ParserOptions parser_options = options.GetParserOptions();
   ZETASQL_RETURN_IF_ERROR(ParseExpression(sql, parser_options, &parser_output));
@@ -858,8 +1379,21 @@ static zetasql_base::Status AnalyzeExpressionImpl(
   VLOG(5) << "Parsed AST:\n" << expression->DebugString();
 
   return AnalyzeExpressionFromParserASTImpl(
-      *expression, std::move(parser_output), sql, options, catalog,
-      type_factory, target_type, output);
+      *expression, std::move(parser_output), ParserRuntimeInfo(parser_timer),
+      sql, options, catalog, type_factory, target_type, output);
+}
+
+static zetasql_base::Status AnalyzeExpressionImpl(
+    absl::string_view sql, const AnalyzerOptions& options_in, Catalog* catalog,
+    TypeFactory* type_factory, const Type* target_type,
+    std::unique_ptr<const AnalyzerOutput>* output) {
+  output->reset();
+
+  std::unique_ptr<AnalyzerOptions> copy;
+  const AnalyzerOptions& options = GetOptionsWithArenas(&options_in, &copy);
+  ZETASQL_RETURN_IF_ERROR(ValidateAnalyzerOptions(options));
+  return ParseAndAnalyzeExpression(sql, options, catalog, type_factory,
+                                   target_type, output);
 }
 
 zetasql_base::Status AnalyzeExpression(absl::string_view sql,
@@ -889,12 +1423,50 @@ zetasql_base::Status AnalyzeExpressionFromParserAST(
   std::unique_ptr<AnalyzerOptions> copy;
   const AnalyzerOptions& options = GetOptionsWithArenas(&options_in, &copy);
   const zetasql_base::Status status = AnalyzeExpressionFromParserASTImpl(
-      ast_expression, /* parser_output = */ nullptr, sql, options, catalog,
-      type_factory, /*target_type=*/nullptr, output);
+      ast_expression, /* parser_output = */ nullptr, AnalyzerRuntimeInfo(), sql,
+      options, catalog, type_factory, /*target_type=*/nullptr, output);
   return ConvertInternalErrorLocationAndAdjustErrorString(
       options.error_message_mode(), sql, status);
 }
 
+PreparedExpressionAnalyzer::PreparedExpressionAnalyzer(
+    const AnalyzerOptions& options, Catalog* catalog, TypeFactory* type_factory)
+    : options_(options),
+      has_caller_arenas_(options.AreAllArenasInitialized()),
+      catalog_(catalog),
+      type_factory_(type_factory) {}
+
+zetasql_base::Status PreparedExpressionAnalyzer::Create(
+    const AnalyzerOptions& options, Catalog* catalog, TypeFactory* type_factory,
+    std::unique_ptr<PreparedExpressionAnalyzer>* prepared) {
+  ZETASQL_RETURN_IF_ERROR(ValidateAnalyzerOptions(options));
+  prepared->reset(
+      new PreparedExpressionAnalyzer(options, catalog, type_factory));
+  return zetasql_base::OkStatus();
+}
+
+zetasql_base::Status PreparedExpressionAnalyzer::Analyze(
+    absl::string_view sql, std::unique_ptr<const AnalyzerOutput>* output) {
+  return AnalyzeForAssignmentToType(sql, /*target_type=*/nullptr, output);
+}
+
+zetasql_base::Status PreparedExpressionAnalyzer::AnalyzeForAssignmentToType(
+    absl::string_view sql, const Type* target_type,
+    std::unique_ptr<const AnalyzerOutput>* output) {
+  output->reset();
+  if (!has_caller_arenas_) {
+    // Outputs hold on to the arenas they were analyzed with, so give each
+    // expression its own rather than growing one for all of them.
+    options_.set_arena(nullptr);
+    options_.set_id_string_pool(nullptr);
+    options_.CreateDefaultArenasIfNotSet();
+  }
+  return ConvertInternalErrorLocationAndAdjustErrorString(
+      options_.error_message_mode(), sql,
+      ParseAndAnalyzeExpression(sql, options_, catalog_, type_factory_,
+                                target_type, output));
+}
+
 static zetasql_base::Status AnalyzeTypeImpl(
     const std::string& type_name,
     const AnalyzerOptions& options,
@@ -0,0 +1,701 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/analyzer.h"
+
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/parser/parser.h"
+#include "zetasql/public/builtin_function.h"
+#include "zetasql/public/function_signature.h"
+#include "zetasql/public/language_options.h"
+#include "zetasql/public/parse_resume_location.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/templated_sql_function.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+
+namespace zetasql {
+
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using ::testing::Not;
+using ::zetasql_base::testing::StatusIs;
+
+namespace {
+
+// A SimpleCatalog that records the paths passed to PrefetchTables().
+class PrefetchRecordingCatalog : public SimpleCatalog {
+ public:
+  explicit PrefetchRecordingCatalog(TypeFactory* type_factory)
+      : SimpleCatalog("prefetch", type_factory) {}
+
+  zetasql_base::Status PrefetchTables(
+      absl::Span<const std::vector<std::string>> paths,
+      const FindOptions& options) override {
+    prefetched_.insert(prefetched_.end(), paths.begin(), paths.end());
+    return ::zetasql_base::OkStatus();
+  }
+
+  const std::vector<std::vector<std::string>>& prefetched() const {
+    return prefetched_;
+  }
+
+ private:
+  std::vector<std::vector<std::string>> prefetched_;
+};
+
+}  // namespace
+
+TEST(AnalyzerTest, PrefetchTables) {
+  TypeFactory type_factory;
+  PrefetchRecordingCatalog catalog(&type_factory);
+  catalog.AddOwnedTable(
+      new SimpleTable("T1", {{"a", type_factory.get_int64()}}));
+  catalog.AddOwnedTable(
+      new SimpleTable("T2", {{"a", type_factory.get_int64()}}));
+  const std::string sql = "SELECT * FROM T1 JOIN T2 USING (a)";
+
+  AnalyzerOptions options;
+  std::unique_ptr<const AnalyzerOutput> output;
+  ZETASQL_ASSERT_OK(AnalyzeStatement(sql, options, &catalog, &type_factory, &output));
+  EXPECT_THAT(catalog.prefetched(), IsEmpty());
+
+  options.set_prefetch_tables(true);
+  ZETASQL_ASSERT_OK(AnalyzeStatement(sql, options, &catalog, &type_factory, &output));
+  EXPECT_THAT(catalog.prefetched(),
+              ElementsAre(ElementsAre("T1"), ElementsAre("T2")));
+}
+
+TEST(AnalyzerTest, CachedTemplatedSQLFunctionCalls) {
+  TypeFactory type_factory;
+  SimpleCatalog catalog("templated", &type_factory);
+  catalog.AddZetaSQLFunctions(ZetaSQLBuiltinFunctionOptions(LanguageOptions()));
+  auto* add_one = new TemplatedSQLFunction(
+      {"add_one"},
+      FunctionSignature(FunctionArgumentType(ARG_TYPE_ARBITRARY),
+                        {FunctionArgumentType(ARG_TYPE_ARBITRARY)},
+                        /*context_id=*/-1),
+      /*argument_names=*/{"x"}, ParseResumeLocation::FromString("x + 1"));
+  catalog.AddOwnedFunction(add_one);
+  const std::string sql =
+      "SELECT add_one(1), add_one(2.5), add_one(3), add_one(4.5)";
+
+  AnalyzerOptions options;
+  std::unique_ptr<const AnalyzerOutput> uncached_output;
+  ZETASQL_ASSERT_OK(AnalyzeStatement(sql, options, &catalog, &type_factory,
+                             &uncached_output));
+
+  // Calls with INT64 and DOUBLE arguments are cached separately, and repeated
+  // calls and analyses produce the same tree as resolving the body each time.
+  add_one->set_cache_resolved_calls(true);
+  for (int i = 0; i < 2; ++i) {
+    std::unique_ptr<const AnalyzerOutput> output;
+    ZETASQL_ASSERT_OK(
+        AnalyzeStatement(sql, options, &catalog, &type_factory, &output));
+    EXPECT_EQ(uncached_output->resolved_statement()->DebugString(),
+              output->resolved_statement()->DebugString());
+  }
+
+  // Calls cached while resolved nodes are allocated in the arena of an
+  // analysis stay valid after that arena is released.
+  auto* add_two = new TemplatedSQLFunction(
+      {"add_two"},
+      FunctionSignature(FunctionArgumentType(ARG_TYPE_ARBITRARY),
+                        {FunctionArgumentType(ARG_TYPE_ARBITRARY)},
+                        /*context_id=*/-1),
+      /*argument_names=*/{"x"}, ParseResumeLocation::FromString("x + 2"));
+  catalog.AddOwnedFunction(add_two);
+  const std::string add_two_sql = "SELECT add_two(1), add_two(2.5)";
+  std::unique_ptr<const AnalyzerOutput> uncached_add_two;
+  ZETASQL_ASSERT_OK(AnalyzeStatement(add_two_sql, options, &catalog,
+                             &type_factory, &uncached_add_two));
+  add_two->set_cache_resolved_calls(true);
+  AnalyzerOptions arena_options;
+  arena_options.set_allocate_resolved_ast_in_arena(true);
+  for (int i = 0; i < 3; ++i) {
+    std::unique_ptr<const AnalyzerOutput> output;
+    ZETASQL_ASSERT_OK(AnalyzeStatement(add_two_sql, arena_options, &catalog,
+                               &type_factory, &output));
+    EXPECT_EQ(uncached_add_two->resolved_statement()->DebugString(),
+              output->resolved_statement()->DebugString());
+  }
+}
+
+TEST(AnalyzerTest, ArenaRuntimeInfo) {
+  TypeFactory type_factory;
+  SimpleCatalog catalog("arenas", &type_factory);
+  catalog.AddOwnedTable(
+      new SimpleTable("T", {{"a", type_factory.get_int64()}}));
+  const std::string sql = "SELECT a, a + 1 AS b FROM T WHERE a > 2";
+
+  AnalyzerOptions options;
+  options.CreateDefaultArenasIfNotSet();
+  options.set_allocate_resolved_ast_in_arena(true);
+  std::unique_ptr<const AnalyzerOutput> output;
+  ZETASQL_ASSERT_OK(AnalyzeStatement(sql, options, &catalog, &type_factory, &output));
+  const AnalyzerRuntimeInfo& info = output->runtime_info();
+  EXPECT_GT(info.parser_arena.bytes_used, 0);
+  EXPECT_GT(info.resolver_arena.bytes_used, 0);
+  EXPECT_GE(info.parser_arena.bytes_allocated, 0);
+  EXPECT_GE(info.parser_arena.block_count, 0);
+
+  // The IdStringPool shares the arena, so its usage covers both phases.
+  const ArenaUsage total = ArenaUsage::Of(*options.arena());
+  EXPECT_EQ(total.DebugString(), info.id_string_pool_arena.DebugString());
+  EXPECT_GE(total.bytes_used,
+            info.parser_arena.bytes_used + info.resolver_arena.bytes_used);
+  EXPECT_EQ(total.bytes_allocated,
+            total.bytes_used + total.bytes_wasted +
+                static_cast<int64_t>(
+                    options.arena()->bytes_until_next_allocation()));
+
+  // Analyzing an existing parse tree has no parsing phase.
+  std::unique_ptr<ParserOutput> parser_output;
+  ZETASQL_ASSERT_OK(ParseStatement(sql, options.GetParserOptions(), &parser_output));
+  ZETASQL_ASSERT_OK(AnalyzeStatementFromParserOutputUnowned(
+      &parser_output, options, sql, &catalog, &type_factory, &output));
+  EXPECT_EQ(ArenaUsage().DebugString(),
+            output->runtime_info().parser_arena.DebugString());
+  EXPECT_GT(output->runtime_info().resolver_arena.bytes_used, 0);
+}
+
+TEST(AnalyzerTest, PhaseRuntimeInfo) {
+  TypeFactory type_factory;
+  SimpleCatalog catalog("phases", &type_factory);
+  catalog.AddZetaSQLFunctions(ZetaSQLBuiltinFunctionOptions(LanguageOptions()));
+  catalog.AddOwnedTable(
+      new SimpleTable("T", {{"a", type_factory.get_int64()}}));
+  const std::string sql = "SELECT a + 1 AS b FROM T WHERE a > 2";
+
+  AnalyzerOptions options;
+  std::unique_ptr<const AnalyzerOutput> output;
+  ZETASQL_ASSERT_OK(AnalyzeStatement(sql, options, &catalog, &type_factory, &output));
+  const AnalyzerRuntimeInfo& info = output->runtime_info();
+  EXPECT_GT(info.num_tokens, 10);
+  EXPECT_GT(info.num_ast_nodes, 5);
+  EXPECT_GT(info.parser_time.wall_time, absl::ZeroDuration());
+  EXPECT_GT(info.resolver_time.wall_time, absl::ZeroDuration());
+  EXPECT_GE(info.resolver_time.wall_time, info.catalog_lookup_time);
+  // At least one lookup for the table and one for each function.
+  EXPECT_GE(info.num_catalog_lookups, 3);
+  EXPECT_GE(info.num_signatures_tried, 2);
+  EXPECT_GT(info.num_resolved_nodes, 5);
+  EXPECT_NE(std::string::npos, info.DebugString().find("num_tokens: "));
+
+  // An existing parse tree has no parsing time, but its size is known.
+  std::unique_ptr<ParserOutput> parser_output;
+  ZETASQL_ASSERT_OK(ParseStatement(sql, options.GetParserOptions(), &parser_output));
+  const int64_t num_ast_nodes = parser_output->num_ast_nodes();
+  ZETASQL_ASSERT_OK(AnalyzeStatementFromParserOutputUnowned(
+      &parser_output, options, sql, &catalog, &type_factory, &output));
+  EXPECT_EQ(absl::ZeroDuration(),
+            output->runtime_info().parser_time.wall_time);
+  EXPECT_EQ(num_ast_nodes, output->runtime_info().num_ast_nodes);
+  EXPECT_EQ(info.num_tokens, output->runtime_info().num_tokens);
+  EXPECT_EQ(info.num_catalog_lookups,
+            output->runtime_info().num_catalog_lookups);
+}
+
+TEST(AnalyzerTest, QueryComplexity) {
+  std::unique_ptr<ParserOutput> parser_output;
+  ZETASQL_ASSERT_OK(ParseStatement(
+      "WITH w AS (SELECT 1 AS x) SELECT x FROM w, T WHERE f(x) IN (1, 2, 3)",
+      ParserOptions(), &parser_output));
+  const QueryComplexity complexity =
+      EstimateQueryComplexity(*parser_output->statement());
+  EXPECT_EQ(parser_output->num_ast_nodes(), complexity.num_nodes);
+  EXPECT_GT(complexity.max_depth, 5);
+  EXPECT_LT(complexity.max_depth, complexity.num_nodes);
+  EXPECT_EQ(2, complexity.num_table_references);
+  EXPECT_GT(complexity.estimated_resolution_cost, complexity.num_nodes);
+
+  // Deep trees are traversed without recursion.
+  const int kDepth = 5000;
+  std::string deep_sql = "SELECT 1";
+  for (int i = 0; i < kDepth; ++i) absl::StrAppend(&deep_sql, " + 1");
+  ZETASQL_ASSERT_OK(ParseStatement(deep_sql, ParserOptions(), &parser_output));
+  EXPECT_GT(EstimateQueryComplexity(*parser_output->statement()).max_depth,
+            kDepth);
+}
+
+TEST(AnalyzerTest, AnalyzerLimits) {
+  TypeFactory type_factory;
+  SimpleCatalog catalog("limits", &type_factory);
+  catalog.AddZetaSQLFunctions(ZetaSQLBuiltinFunctionOptions(LanguageOptions()));
+  const std::string sql = "SELECT 1 IN (1, 2, 3, 4, 5, 6, 7, 8, 9, 10)";
+  std::unique_ptr<const AnalyzerOutput> output;
+
+  AnalyzerOptions options;
+  ZETASQL_EXPECT_OK(AnalyzeStatement(sql, options, &catalog, &type_factory, &output));
+
+  AnalyzerLimits limits;
+  limits.max_ast_nodes = 10;
+  options.set_limits(limits);
+  EXPECT_THAT(AnalyzeStatement(sql, options, &catalog, &type_factory, &output),
+              StatusIs(zetasql_base::StatusCode::kResourceExhausted,
+                       HasSubstr("syntax nodes, more than the limit of 10")));
+  EXPECT_THAT(AnalyzeExpression("1 IN (1, 2, 3, 4, 5, 6, 7, 8, 9, 10)",
+                                options, &catalog, &type_factory, &output),
+              StatusIs(zetasql_base::StatusCode::kResourceExhausted));
+
+  limits = AnalyzerLimits();
+  limits.max_ast_depth = 2;
+  options.set_limits(limits);
+  EXPECT_THAT(AnalyzeStatement(sql, options, &catalog, &type_factory, &output),
+              StatusIs(zetasql_base::StatusCode::kResourceExhausted,
+                       HasSubstr("more than the limit of 2")));
+
+  limits = AnalyzerLimits();
+  limits.max_estimated_resolution_cost = 1000;
+  options.set_limits(limits);
+  ZETASQL_EXPECT_OK(AnalyzeStatement(sql, options, &catalog, &type_factory, &output));
+
+  // Resolving a long IN list takes time and allocates many ResolvedNodes.
+  std::vector<std::string> elements;
+  for (int i = 0; i < 1000; ++i) elements.push_back(absl::StrCat(i));
+  const std::string long_sql =
+      absl::StrCat("SELECT 1 IN (", absl::StrJoin(elements, ", "), ")");
+  limits = AnalyzerLimits();
+  limits.max_resolver_time = absl::Nanoseconds(1);
+  options.set_limits(limits);
+  EXPECT_THAT(
+      AnalyzeStatement(long_sql, options, &catalog, &type_factory, &output),
+      StatusIs(zetasql_base::StatusCode::kResourceExhausted,
+               HasSubstr("resolving it took")));
+
+  limits = AnalyzerLimits();
+  limits.max_resolver_arena_bytes = 1;
+  options.set_limits(limits);
+  options.set_allocate_resolved_ast_in_arena(true);
+  EXPECT_THAT(
+      AnalyzeStatement(long_sql, options, &catalog, &type_factory, &output),
+      StatusIs(zetasql_base::StatusCode::kResourceExhausted,
+               HasSubstr("bytes of memory")));
+}
+
+TEST(AnalyzerTest, DeadlineAndCancellation) {
+  TypeFactory type_factory;
+  SimpleCatalog catalog("interrupts", &type_factory);
+  catalog.AddZetaSQLFunctions(ZetaSQLBuiltinFunctionOptions(LanguageOptions()));
+  const std::string sql = "SELECT 1 + 2";
+  std::unique_ptr<const AnalyzerOutput> output;
+
+  AnalyzerOptions options;
+  options.set_deadline(absl::Now() + absl::Hours(1));
+  auto token = std::make_shared<AnalyzerCancellationToken>();
+  options.set_cancellation_token(token);
+  ZETASQL_EXPECT_OK(AnalyzeStatement(sql, options, &catalog, &type_factory, &output));
+  ZETASQL_EXPECT_OK(
+      AnalyzeExpression("1 + 2", options, &catalog, &type_factory, &output));
+
+  token->Cancel();
+  EXPECT_THAT(AnalyzeStatement(sql, options, &catalog, &type_factory, &output),
+              StatusIs(zetasql_base::StatusCode::kCancelled));
+  EXPECT_THAT(
+      AnalyzeExpression("1 + 2", options, &catalog, &type_factory, &output),
+      StatusIs(zetasql_base::StatusCode::kCancelled));
+
+  options.set_cancellation_token(nullptr);
+  options.set_deadline(absl::Now() - absl::Seconds(1));
+  EXPECT_THAT(AnalyzeStatement(sql, options, &catalog, &type_factory, &output),
+              StatusIs(zetasql_base::StatusCode::kDeadlineExceeded));
+  EXPECT_THAT(
+      AnalyzeExpression("1 + 2", options, &catalog, &type_factory, &output),
+      StatusIs(zetasql_base::StatusCode::kDeadlineExceeded));
+}
+
+TEST(AnalyzerTest, WithEntryAnnotationAndInlining) {
+  TypeFactory type_factory;
+  SimpleCatalog catalog("with_entries", &type_factory);
+  catalog.AddOwnedTable(
+      new SimpleTable("T", {{"a", type_factory.get_int64()}}));
+  const std::string sql =
+      "WITH w1 AS (SELECT a FROM T), w2 AS (SELECT a FROM w1) "
+      "SELECT * FROM w2 JOIN w2 AS w3 USING (a)";
+  std::unique_ptr<const AnalyzerOutput> output;
+
+  AnalyzerOptions options;
+  ZETASQL_ASSERT_OK(AnalyzeStatement(sql, options, &catalog, &type_factory, &output));
+  EXPECT_THAT(output->resolved_statement()->DebugString(),
+              Not(HasSubstr("reference_count")));
+
+  options.set_annotate_with_entries(true);
+  ZETASQL_ASSERT_OK(AnalyzeStatement(sql, options, &catalog, &type_factory, &output));
+  const auto* with_scan = output->resolved_statement()
+                              ->GetAs<ResolvedQueryStmt>()
+                              ->query()
+                              ->GetAs<ResolvedWithScan>();
+  ASSERT_EQ(2, with_scan->with_entry_list_size());
+  EXPECT_EQ(1, with_scan->with_entry_list(0)->reference_count());
+  EXPECT_EQ(2, with_scan->with_entry_list(1)->reference_count());
+  EXPECT_TRUE(with_scan->with_entry_list(1)->is_deterministic());
+  EXPECT_TRUE(with_scan->with_entry_list(1)->is_cheap());
+
+  // Only w1 is inlined, into w2.
+  options.set_inline_single_use_with_entries(true);
+  ZETASQL_ASSERT_OK(AnalyzeStatement(sql, options, &catalog, &type_factory, &output));
+  with_scan = output->resolved_statement()
+                  ->GetAs<ResolvedQueryStmt>()
+                  ->query()
+                  ->GetAs<ResolvedWithScan>();
+  ASSERT_EQ(1, with_scan->with_entry_list_size());
+  EXPECT_EQ("w2", with_scan->with_entry_list(0)->with_query_name());
+  EXPECT_THAT(with_scan->with_entry_list(0)->with_subquery()->DebugString(),
+              Not(HasSubstr("WithRefScan")));
+}
+
+TEST(AnalyzerTest, RepeatedTableScans) {
+  TypeFactory type_factory;
+  SimpleCatalog catalog("repeated_scans", &type_factory);
+  catalog.AddOwnedTable(new SimpleTable(
+      "T", {{"a", type_factory.get_int64()}, {"", type_factory.get_string()}}));
+  const std::string sql =
+      "SELECT * FROM T UNION ALL SELECT * FROM T UNION ALL SELECT * FROM T";
+  AnalyzerOptions options;
+  std::unique_ptr<const AnalyzerOutput> output;
+  ZETASQL_ASSERT_OK(AnalyzeStatement(sql, options, &catalog, &type_factory, &output));
+
+  // Every scan names its columns alike, but with new column ids.
+  std::vector<const ResolvedNode*> scans;
+  output->resolved_statement()->GetDescendantsWithKinds({RESOLVED_TABLE_SCAN},
+                                                        &scans);
+  ASSERT_EQ(3, scans.size());
+  std::set<int> column_ids;
+  for (const ResolvedNode* node : scans) {
+    const auto* scan = node->GetAs<ResolvedTableScan>();
+    ASSERT_EQ(2, scan->column_list_size());
+    EXPECT_EQ("T", scan->column_list(0).table_name());
+    EXPECT_EQ("a", scan->column_list(0).name());
+    EXPECT_EQ("$col2", scan->column_list(1).name());
+    EXPECT_TRUE(scan->column_list(1).type()->IsString());
+    for (const ResolvedColumn& column : scan->column_list()) {
+      column_ids.insert(column.column_id());
+    }
+  }
+  EXPECT_EQ(6, column_ids.size());
+}
+
+TEST(AnalyzerTest, MultiRowInsertValuesCoercions) {
+  TypeFactory type_factory;
+  SimpleCatalog catalog("insert_values", &type_factory);
+  catalog.AddOwnedTable(new SimpleTable(
+      "T", {{"a", type_factory.get_int32()}, {"d", type_factory.get_date()}}));
+  AnalyzerOptions options;
+  options.mutable_language()->SetSupportsAllStatementKinds();
+
+  // Each column's coercions are checked once, but every value is converted.
+  std::unique_ptr<const AnalyzerOutput> output;
+  ZETASQL_ASSERT_OK(AnalyzeStatement(
+      "INSERT T (a, d) VALUES (1, '2019-01-01'), (2, NULL), (3, '2019-01-03')",
+      options, &catalog, &type_factory, &output));
+  const auto* insert =
+      output->resolved_statement()->GetAs<ResolvedInsertStmt>();
+  ASSERT_EQ(3, insert->row_list_size());
+  for (const auto& row : insert->row_list()) {
+    ASSERT_EQ(2, row->value_list_size());
+    const ResolvedExpr* a = row->value_list(0)->value();
+    const ResolvedExpr* d = row->value_list(1)->value();
+    EXPECT_EQ(RESOLVED_LITERAL, a->node_kind());
+    EXPECT_TRUE(a->type()->IsInt32());
+    EXPECT_EQ(RESOLVED_LITERAL, d->node_kind());
+    EXPECT_TRUE(d->type()->IsDate());
+  }
+  EXPECT_EQ(Value::Int32(3), insert->row_list(2)
+                                ->value_list(0)
+                                ->value()
+                                ->GetAs<ResolvedLiteral>()
+                                ->value());
+
+  // Values that do not coerce are still reported in any row.
+  EXPECT_THAT(
+      AnalyzeStatement("INSERT T (a, d) VALUES (1, '2019-01-01'), (2, 1.5)",
+                       options, &catalog, &type_factory, &output),
+      StatusIs(zetasql_base::StatusCode::kInvalidArgument,
+               HasSubstr("Value has type DOUBLE which cannot be inserted "
+                         "into column d")));
+  EXPECT_THAT(
+      AnalyzeStatement(
+          "INSERT T (a, d) VALUES (1, '2019-01-01'), (2, '2019-13-01')",
+          options, &catalog, &type_factory, &output),
+      StatusIs(zetasql_base::StatusCode::kInvalidArgument,
+               HasSubstr("Could not cast literal")));
+}
+
+TEST(AnalyzerTest, PreparedExpressionAnalyzer) {
+  TypeFactory type_factory;
+  SimpleCatalog catalog("prepared_expressions", &type_factory);
+  catalog.AddZetaSQLFunctions(ZetaSQLBuiltinFunctionOptions(LanguageOptions()));
+  AnalyzerOptions options;
+  ZETASQL_ASSERT_OK(options.AddExpressionColumn("x", type_factory.get_int64()));
+
+  std::unique_ptr<PreparedExpressionAnalyzer> prepared;
+  ZETASQL_ASSERT_OK(PreparedExpressionAnalyzer::Create(options, &catalog,
+                                               &type_factory, &prepared));
+  std::unique_ptr<const AnalyzerOutput> first;
+  ZETASQL_ASSERT_OK(prepared->Analyze("x + 1", &first));
+  std::unique_ptr<const AnalyzerOutput> second;
+  ZETASQL_ASSERT_OK(prepared->AnalyzeForAssignmentToType(
+      "x > 1", type_factory.get_bool(), &second));
+
+  std::unique_ptr<const AnalyzerOutput> expected;
+  ZETASQL_ASSERT_OK(AnalyzeExpression("x + 1", options, &catalog, &type_factory,
+                              &expected));
+  EXPECT_EQ(expected->resolved_expr()->DebugString(),
+            first->resolved_expr()->DebugString());
+  EXPECT_TRUE(second->resolved_expr()->type()->IsBool());
+  // Each output keeps its own arena since <options> did not provide one.
+  EXPECT_NE(first->arena(), second->arena());
+
+  EXPECT_THAT(prepared->Analyze("y + 1", &first),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument,
+                       HasSubstr("Unrecognized name: y")));
+  EXPECT_EQ(nullptr, first);
+
+  options.set_parameter_mode(PARAMETER_NONE);
+  ZETASQL_ASSERT_OK(options.AddQueryParameter("p", type_factory.get_int64()));
+  EXPECT_FALSE(PreparedExpressionAnalyzer::Create(options, &catalog,
+                                                  &type_factory, &prepared)
+                   .ok());
+}
+
+TEST(AnalyzerTest, RebindQueryParameters) {
+  TypeFactory type_factory;
+  SimpleCatalog catalog("rebind", &type_factory);
+  catalog.AddZetaSQLFunctions(ZetaSQLBuiltinFunctionOptions(LanguageOptions()));
+  const std::string sql = "SELECT @p + 1 AS x, @q AS y";
+  AnalyzerOptions options;
+  options.set_allow_undeclared_parameters(true);
+  ZETASQL_ASSERT_OK(options.AddQueryParameter("p", type_factory.get_int64()));
+  std::unique_ptr<const AnalyzerOutput> analyzed;
+  ZETASQL_ASSERT_OK(
+      AnalyzeStatement(sql, options, &catalog, &type_factory, &analyzed));
+  EXPECT_TRUE(QueryParameterTypesMatch(*analyzed, options));
+
+  // @q stays undeclared, so only the type of @p matters.
+  AnalyzerOptions same_types;
+  same_types.set_allow_undeclared_parameters(true);
+  ZETASQL_ASSERT_OK(same_types.AddQueryParameter("P", type_factory.get_int64()));
+  ZETASQL_ASSERT_OK(same_types.AddQueryParameter("unused", type_factory.get_bool()));
+  EXPECT_TRUE(QueryParameterTypesMatch(*analyzed, same_types));
+
+  AnalyzerOptions declared_q = same_types;
+  ZETASQL_ASSERT_OK(declared_q.AddQueryParameter("q", type_factory.get_int64()));
+  EXPECT_FALSE(QueryParameterTypesMatch(*analyzed, declared_q));
+
+  AnalyzerOptions new_types;
+  new_types.set_allow_undeclared_parameters(true);
+  ZETASQL_ASSERT_OK(new_types.AddQueryParameter("p", type_factory.get_double()));
+  EXPECT_FALSE(QueryParameterTypesMatch(*analyzed, new_types));
+
+  std::unique_ptr<const AnalyzerOutput> rebound;
+  ZETASQL_ASSERT_OK(RebindQueryParameters(*analyzed, sql, new_types, &catalog,
+                                  &type_factory, &rebound));
+  std::unique_ptr<const AnalyzerOutput> expected;
+  ZETASQL_ASSERT_OK(
+      AnalyzeStatement(sql, new_types, &catalog, &type_factory, &expected));
+  EXPECT_EQ(expected->resolved_statement()->DebugString(),
+            rebound->resolved_statement()->DebugString());
+  EXPECT_TRUE(rebound->resolved_statement()
+                  ->GetAs<ResolvedQueryStmt>()
+                  ->output_column_list(0)
+                  ->column()
+                  .type()
+                  ->IsDouble());
+  EXPECT_EQ(1, rebound->undeclared_parameters().size());
+  EXPECT_TRUE(QueryParameterTypesMatch(*rebound, new_types));
+  // The original output is unchanged.
+  EXPECT_TRUE(QueryParameterTypesMatch(*analyzed, options));
+
+  // Errors for the new types are reported as by AnalyzeStatement().
+  AnalyzerOptions bad_types;
+  ZETASQL_ASSERT_OK(bad_types.AddQueryParameter("p", type_factory.get_bool()));
+  ZETASQL_ASSERT_OK(bad_types.AddQueryParameter("q", type_factory.get_bool()));
+  EXPECT_THAT(RebindQueryParameters(*analyzed, sql, bad_types, &catalog,
+                                    &type_factory, &rebound),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument,
+                       HasSubstr("No matching signature")));
+  EXPECT_EQ(nullptr, rebound);
+
+  // The parse tree is needed to rebind.
+  std::unique_ptr<ParserOutput> parser_output;
+  ZETASQL_ASSERT_OK(ParseStatement(sql, ParserOptions(), &parser_output));
+  std::unique_ptr<const AnalyzerOutput> unowned;
+  ZETASQL_ASSERT_OK(AnalyzeStatementFromParserOutputUnowned(
+      &parser_output, options, sql, &catalog, &type_factory, &unowned));
+  EXPECT_FALSE(RebindQueryParameters(*unowned, sql, new_types, &catalog,
+                                     &type_factory, &rebound)
+                   .ok());
+}
+
+TEST(AnalyzerTest, CompactParseLocations) {
+  TypeFactory type_factory;
+  SimpleCatalog catalog("compact_locations", &type_factory);
+  catalog.AddZetaSQLFunctions(ZetaSQLBuiltinFunctionOptions(LanguageOptions()));
+  const std::string sql = "SELECT 1 + 23 AS x, CONCAT('abc', 'd') AS y";
+  AnalyzerOptions options;
+  options.set_record_parse_locations(true);
+  std::unique_ptr<const AnalyzerOutput> expected;
+  ZETASQL_ASSERT_OK(
+      AnalyzeStatement(sql, options, &catalog, &type_factory, &expected));
+  EXPECT_EQ(nullptr, expected->parse_locations());
+
+  options.set_compact_parse_locations(true);
+  std::unique_ptr<const AnalyzerOutput> analyzed;
+  ZETASQL_ASSERT_OK(
+      AnalyzeStatement(sql, options, &catalog, &type_factory, &analyzed));
+  ASSERT_NE(nullptr, analyzed->parse_locations());
+  std::unique_ptr<const AnalyzerOutput> compacted;
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      compacted, CompactAnalyzerOutput(*analyzed, &catalog, &type_factory));
+
+  std::vector<const ResolvedNode*> expected_literals;
+  expected->resolved_statement()->GetDescendantsWithKinds({RESOLVED_LITERAL},
+                                                          &expected_literals);
+  ASSERT_EQ(4, expected_literals.size());
+  for (const AnalyzerOutput* output : {analyzed.get(), compacted.get()}) {
+    std::vector<const ResolvedNode*> literals;
+    output->resolved_statement()->GetDescendantsWithKinds({RESOLVED_LITERAL},
+                                                          &literals);
+    ASSERT_EQ(expected_literals.size(), literals.size());
+    for (int i = 0; i < literals.size(); ++i) {
+      // The nodes only hold ids.
+      EXPECT_EQ(nullptr, literals[i]->GetParseLocationRangeOrNULL());
+      ParseLocationRange range;
+      ASSERT_TRUE(output->GetParseLocationRange(literals[i], &range));
+      EXPECT_EQ(*expected_literals[i]->GetParseLocationRangeOrNULL(), range);
+    }
+
+    LiteralReplacementMap literal_map;
+    GeneratedParameterMap generated_parameters;
+    std::string result_sql;
+    ZETASQL_ASSERT_OK(ReplaceLiteralsByParameters(sql, options, output,
+                                          &literal_map, &generated_parameters,
+                                          &result_sql));
+    EXPECT_EQ(4, generated_parameters.size());
+    EXPECT_EQ(
+        "SELECT @_p0_INT64 + @_p1_INT64 AS x, "
+        "CONCAT(@_p2_STRING, @_p3_STRING) AS y",
+        result_sql);
+  }
+}
+
+TEST(AnalyzerTest, QueryParameterTypesMatchPositional) {
+  TypeFactory type_factory;
+  SimpleCatalog catalog("rebind_positional", &type_factory);
+  AnalyzerOptions options;
+  options.set_parameter_mode(PARAMETER_POSITIONAL);
+  ZETASQL_ASSERT_OK(options.AddPositionalQueryParameter(type_factory.get_int64()));
+  std::unique_ptr<const AnalyzerOutput> analyzed;
+  ZETASQL_ASSERT_OK(AnalyzeStatement("SELECT ?", options, &catalog, &type_factory,
+                             &analyzed));
+
+  AnalyzerOptions more_parameters = options;
+  ZETASQL_ASSERT_OK(
+      more_parameters.AddPositionalQueryParameter(type_factory.get_string()));
+  EXPECT_TRUE(QueryParameterTypesMatch(*analyzed, more_parameters));
+
+  AnalyzerOptions other_type;
+  other_type.set_parameter_mode(PARAMETER_POSITIONAL);
+  ZETASQL_ASSERT_OK(
+      other_type.AddPositionalQueryParameter(type_factory.get_string()));
+  EXPECT_FALSE(QueryParameterTypesMatch(*analyzed, other_type));
+
+  AnalyzerOptions no_parameters;
+  no_parameters.set_parameter_mode(PARAMETER_POSITIONAL);
+  EXPECT_FALSE(QueryParameterTypesMatch(*analyzed, no_parameters));
+}
+
+TEST(AnalyzerTest, OptionsCopiesShareMaps) {
+  TypeFactory type_factory;
+  AnalyzerOptions base;
+  ZETASQL_ASSERT_OK(base.AddQueryParameter("p", type_factory.get_int64()));
+  ZETASQL_ASSERT_OK(base.AddExpressionColumn("c", type_factory.get_bool()));
+  AllowedHintsAndOptions allowed("qual");
+  allowed.AddOption("opt", type_factory.get_string());
+  base.set_allowed_hints_and_options(allowed);
+
+  AnalyzerOptions request = base;
+  EXPECT_EQ(&base.query_parameters(), &request.query_parameters());
+  EXPECT_EQ(&base.expression_columns(), &request.expression_columns());
+  EXPECT_EQ(&base.allowed_hints_and_options(),
+            &request.allowed_hints_and_options());
+
+  // Changes to the copy copy its map, and leave the base unchanged.
+  ZETASQL_ASSERT_OK(request.AddQueryParameter("q", type_factory.get_bool()));
+  EXPECT_NE(&base.query_parameters(), &request.query_parameters());
+  EXPECT_EQ(1, base.query_parameters().size());
+  EXPECT_EQ(2, request.query_parameters().size());
+  EXPECT_EQ(&base.expression_columns(), &request.expression_columns());
+  EXPECT_THAT(request.AddQueryParameter("P", type_factory.get_bool()),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+
+  request.clear_query_parameters();
+  EXPECT_TRUE(request.query_parameters().empty());
+  EXPECT_EQ(1, base.query_parameters().size());
+  ZETASQL_ASSERT_OK(
+      request.SetInScopeExpressionColumn("v", type_factory.get_int64()));
+  EXPECT_EQ(1, base.expression_columns().size());
+  EXPECT_EQ(2, request.expression_columns().size());
+
+  // Options that were never set have empty maps and the default hints.
+  const AnalyzerOptions empty;
+  EXPECT_TRUE(empty.query_parameters().empty());
+  EXPECT_TRUE(empty.expression_columns().empty());
+  EXPECT_FALSE(empty.allowed_hints_and_options().disallow_unknown_options);
+  EXPECT_TRUE(empty.allowed_hints_and_options().options_lower.empty());
+}
+
+TEST(AnalyzerTest, RepeatedDotStarExpansion) {
+  TypeFactory type_factory;
+  const StructType* struct_type;
+  ZETASQL_ASSERT_OK(type_factory.MakeStructType(
+      {{"a", type_factory.get_int64()},
+       {"b", type_factory.get_string()},
+       {"", type_factory.get_int64()}},
+      &struct_type));
+  SimpleCatalog catalog("repeated_dot_star", &type_factory);
+  catalog.AddOwnedTable(new SimpleTable("T", {{"s", struct_type}}));
+  const std::string sql =
+      "SELECT s.*, s.* EXCEPT (a), s.* REPLACE ('x' AS b) FROM T";
+  AnalyzerOptions options;
+  std::unique_ptr<const AnalyzerOutput> output;
+  ZETASQL_ASSERT_OK(AnalyzeStatement(sql, options, &catalog, &type_factory, &output));
+
+  // Each expansion applies its own modifiers to the same fields.
+  const auto* query = output->resolved_statement()->GetAs<ResolvedQueryStmt>();
+  std::vector<std::string> names;
+  for (const auto& column : query->output_column_list()) {
+    names.push_back(column->name());
+  }
+  EXPECT_THAT(names, ElementsAre("a", "b", "$field3", "b", "$field3", "a", "b",
+                                 "$field3"));
+}
+
+}  // namespace zetasql
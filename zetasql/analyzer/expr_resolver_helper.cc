@@ -16,7 +16,10 @@
 
 #include "zetasql/analyzer/expr_resolver_helper.h"
 
+#include <string>
+#include <tuple>
 #include <utility>
+#include <vector>
 
 #include "zetasql/base/logging.h"
 #include "zetasql/analyzer/query_resolver_helper.h"
@@ -27,6 +30,7 @@
 #include "zetasql/public/value.h"
 #include "zetasql/resolved_ast/resolved_node_kind.pb.h"
 #include "zetasql/base/string_numbers.h"
+#include "absl/hash/hash.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
 #include "zetasql/base/map_util.h"
@@ -633,4 +637,67 @@ bool IsSameExpressionForGroupBy(const ResolvedExpr* expr1,
   return true;
 }
 
+size_t HashExpressionForGroupBy(const ResolvedExpr* expr) {
+  DCHECK(expr != nullptr);
+  // IsSameExpressionForGroupBy() requires equal types, so equal expressions
+  // have equal type kinds.  Kinds that it does not support are never the same
+  // as anything, so hashing them by the node kind alone is enough.
+  const size_t node_hash = absl::Hash<std::pair<int, int>>()(
+      std::make_pair(expr->node_kind(), expr->type()->kind()));
+  switch (expr->node_kind()) {
+    case RESOLVED_LITERAL:
+      // Value hashing is consistent with Value::Equals.
+      return absl::Hash<std::pair<size_t, size_t>>()(std::make_pair(
+          node_hash, expr->GetAs<ResolvedLiteral>()->value().HashCode()));
+    case RESOLVED_PARAMETER: {
+      const ResolvedParameter* param = expr->GetAs<ResolvedParameter>();
+      return absl::Hash<std::tuple<size_t, std::string, int>>()(
+          std::make_tuple(node_hash, param->name(), param->position()));
+    }
+    case RESOLVED_EXPRESSION_COLUMN:
+      return absl::Hash<std::pair<size_t, std::string>>()(std::make_pair(
+          node_hash, expr->GetAs<ResolvedExpressionColumn>()->name()));
+    case RESOLVED_COLUMN_REF:
+      return absl::Hash<std::pair<size_t, int>>()(std::make_pair(
+          node_hash, expr->GetAs<ResolvedColumnRef>()->column().column_id()));
+    case RESOLVED_GET_STRUCT_FIELD: {
+      const ResolvedGetStructField* struct_field =
+          expr->GetAs<ResolvedGetStructField>();
+      return absl::Hash<std::tuple<size_t, int, size_t>>()(
+          std::make_tuple(node_hash, struct_field->field_idx(),
+                          HashExpressionForGroupBy(struct_field->expr())));
+    }
+    case RESOLVED_GET_PROTO_FIELD: {
+      const ResolvedGetProtoField* proto_field =
+          expr->GetAs<ResolvedGetProtoField>();
+      return absl::Hash<std::tuple<size_t, int, bool, size_t>>()(
+          std::make_tuple(node_hash, proto_field->field_descriptor()->number(),
+                          proto_field->get_has_bit(),
+                          HashExpressionForGroupBy(proto_field->expr())));
+    }
+    case RESOLVED_CAST: {
+      const ResolvedCast* cast = expr->GetAs<ResolvedCast>();
+      return absl::Hash<std::tuple<size_t, bool, size_t>>()(
+          std::make_tuple(node_hash, cast->return_null_on_error(),
+                          HashExpressionForGroupBy(cast->expr())));
+    }
+    case RESOLVED_FUNCTION_CALL: {
+      const ResolvedFunctionCall* function_call =
+          expr->GetAs<ResolvedFunctionCall>();
+      std::vector<size_t> argument_hashes;
+      argument_hashes.reserve(function_call->argument_list().size());
+      for (const std::unique_ptr<const ResolvedExpr>& argument :
+           function_call->argument_list()) {
+        argument_hashes.push_back(HashExpressionForGroupBy(argument.get()));
+      }
+      return absl::Hash<
+          std::tuple<size_t, const Function*, std::vector<size_t>>>()(
+          std::make_tuple(node_hash, function_call->function(),
+                          std::move(argument_hashes)));
+    }
+    default:
+      return node_hash;
+  }
+}
+
 }  // namespace zetasql
@@ -17,6 +17,7 @@
 #ifndef ZETASQL_ANALYZER_EXPR_RESOLVER_HELPER_H_
 #define ZETASQL_ANALYZER_EXPR_RESOLVER_HELPER_H_
 
+#include <stddef.h>
 #include <map>
 #include <memory>
 #include <string>
@@ -71,6 +72,26 @@ bool IsConstantExpression(const ResolvedExpr* expr);
 bool IsSameExpressionForGroupBy(const ResolvedExpr* expr1,
                                 const ResolvedExpr* expr2);
 
+// Hashing function consistent with IsSameExpressionForGroupBy(), i.e.
+// expressions that are the same for GROUP BY have the same hash.  Enables
+// matching an expression against many GROUP BY expressions with a single
+// lookup rather than a comparison against each of them.
+size_t HashExpressionForGroupBy(const ResolvedExpr* expr);
+
+// GROUP BY expression hashing operator for containers.
+struct GroupByExpressionHashOperator {
+  size_t operator()(const ResolvedExpr* expr) const {
+    return HashExpressionForGroupBy(expr);
+  }
+};
+
+// GROUP BY expression equality operator for containers.
+struct GroupByExpressionEqualsOperator {
+  bool operator()(const ResolvedExpr* expr1, const ResolvedExpr* expr2) const {
+    return IsSameExpressionForGroupBy(expr1, expr2);
+  }
+};
+
 // SelectColumnState contains state related to an expression in the
 // select-list of a query, while it is being resolved.  This is used and
 // mutated in multiple passes while resolving the SELECT-list and GROUP BY.
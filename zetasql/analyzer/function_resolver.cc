@@ -212,19 +212,19 @@ bool FunctionResolver::GetConcreteArgument(
       return false;
     }
     *output_argument = absl::make_unique<FunctionArgumentType>(
-        *found_type, argument.options(), num_occurrences);
+        argument.MakeConcrete(*found_type, num_occurrences));
   } else if (argument.IsRelation()) {
     // Table-valued functions should return ARG_TYPE_RELATION. There is no Type
     // object in this case, so return a new FunctionArgumentType with
     // ARG_TYPE_RELATION and the specified number of occurrences.
     *output_argument = absl::make_unique<FunctionArgumentType>(
-        ARG_TYPE_RELATION, argument.options(), num_occurrences);
+        argument.MakeConcrete(/*type=*/nullptr, num_occurrences));
   } else if (argument.IsModel()) {
     *output_argument = absl::make_unique<FunctionArgumentType>(
-        ARG_TYPE_MODEL, argument.options(), num_occurrences);
+        argument.MakeConcrete(/*type=*/nullptr, num_occurrences));
   } else {
     *output_argument = absl::make_unique<FunctionArgumentType>(
-        argument.type(), argument.options(), num_occurrences);
+        argument.MakeConcrete(argument.type(), num_occurrences));
   }
   return true;
 }
@@ -966,9 +966,100 @@ zetasql_base::Status FunctionResolver::CheckCreateAggregateFunctionProperties(
 // error message.  Currently, this code takes an early exit if a signature
 // does not match and does not accurately determine how close the signature
 // was, nor does it keep track of the best non-matching signature.
+// Calls with more arguments than this are not memoized.  These are mostly
+// long IN lists and variadic calls over literal lists, which are rarely
+// repeated exactly, and where copying and hashing the arguments for the memo
+// would cost more than matching them.
+static constexpr int kMaxMemoizedArguments = 32;
+
+// Returns true if the result of FindMatchingSignature() for <arguments> can
+// be memoized.  Relation and model arguments are not, since they only occur
+// for table-valued functions and are not compared precisely by
+// ArgumentsAreIdentical().
+static bool ArgumentsAreMemoizable(
+    const std::vector<InputArgumentType>& arguments) {
+  if (arguments.size() > kMaxMemoizedArguments) return false;
+  for (const InputArgumentType& argument : arguments) {
+    if (argument.is_relation() || argument.is_model() ||
+        !ArgumentsAreMemoizable(argument.field_types())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static size_t HashArguments(const std::vector<InputArgumentType>& arguments) {
+  size_t hash = arguments.size();
+  for (const InputArgumentType& argument : arguments) {
+    hash = hash * 31 + InputArgumentTypeLossyHasher()(argument);
+    if (argument.literal_value() != nullptr) {
+      hash = hash * 31 + argument.literal_value()->HashCode();
+    }
+    hash = hash * 31 + HashArguments(argument.field_types());
+  }
+  return hash;
+}
+
+// Stricter than InputArgumentType::operator==, which compares Types with
+// Type::Equals() and ignores literal values.
+static bool ArgumentsAreIdentical(
+    const std::vector<InputArgumentType>& arguments1,
+    const std::vector<InputArgumentType>& arguments2) {
+  if (arguments1.size() != arguments2.size()) return false;
+  for (int i = 0; i < arguments1.size(); ++i) {
+    const InputArgumentType& argument1 = arguments1[i];
+    const InputArgumentType& argument2 = arguments2[i];
+    // operator!= compares the argument categories.
+    if (argument1.type() != argument2.type() || argument1 != argument2 ||
+        !ArgumentsAreIdentical(argument1.field_types(),
+                               argument2.field_types())) {
+      return false;
+    }
+    if (argument1.is_literal() &&
+        !argument1.literal_value()->Equals(*argument2.literal_value())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t FunctionResolver::SignatureMemoKeyHash::operator()(
+    const SignatureMemoKey& key) const {
+  return std::hash<const Function*>()(key.function) * 31 +
+         HashArguments(key.arguments);
+}
+
+bool FunctionResolver::SignatureMemoKeyEq::operator()(
+    const SignatureMemoKey& key1, const SignatureMemoKey& key2) const {
+  return key1.function == key2.function &&
+         ArgumentsAreIdentical(key1.arguments, key2.arguments);
+}
+
 const FunctionSignature* FunctionResolver::FindMatchingSignature(
     const Function* function,
     const std::vector<InputArgumentType>& input_arguments) const {
+  if (!ArgumentsAreMemoizable(input_arguments)) {
+    return FindMatchingSignatureImpl(function, input_arguments);
+  }
+  SignatureMemoKey memo_key{function, input_arguments};
+  const auto it = signature_memo_.find(memo_key);
+  if (it != signature_memo_.end()) {
+    return it->second == nullptr ? nullptr
+                                 : new FunctionSignature(*it->second);
+  }
+  const FunctionSignature* result_signature =
+      FindMatchingSignatureImpl(function, input_arguments);
+  signature_memo_.emplace(
+      std::move(memo_key),
+      result_signature == nullptr
+          ? nullptr
+          : absl::make_unique<const FunctionSignature>(*result_signature));
+  return result_signature;
+}
+
+const FunctionSignature* FunctionResolver::FindMatchingSignatureImpl(
+    const Function* function,
+    const std::vector<InputArgumentType>& input_arguments) const {
   std::unique_ptr<FunctionSignature> best_result_signature;
   SignatureMatchResult best_result;
 
@@ -980,6 +1071,7 @@ const FunctionSignature* FunctionResolver::FindMatchingSignature(
   for (const FunctionSignature& signature : function->signatures()) {
     std::unique_ptr<FunctionSignature> result_signature;
     SignatureMatchResult signature_match_result;
+    resolver_->RecordSignatureTried();
     if (SignatureMatches(input_arguments, signature,
                          function->ArgumentsAreCoercible(), &result_signature,
                          &signature_match_result)) {
@@ -1354,6 +1446,9 @@ zetasql_base::Status FunctionResolver::ConvertLiteralToType(
     if (argument_literal->GetParseLocationRangeOrNULL() != nullptr) {
       replacement_literal->SetParseLocationRange(
           *argument_literal->GetParseLocationRangeOrNULL());
+    } else if (argument_literal->GetParseLocationId() >= 0) {
+      replacement_literal->SetParseLocationId(
+          argument_literal->GetParseLocationId());
     }
     // Remove parse location on the original literal.  We don't want to
     // do a replacement based on that one because it has the original type,
@@ -1710,11 +1805,60 @@ zetasql_base::Status FunctionResolver::ForwardNestedResolutionAnalysisError(
                                              parse_resume_location.input()));
 }
 
+// Returns the key under which the resolved call to <function> with
+// <actual_arguments> is cached on <function>, or an empty std::string if the call
+// must not be cached.  The body is resolved with an empty name scope, so
+// besides the argument types it only depends on the catalog, the type
+// factory and <analyzer_options>.  Calls are not cached if the body could
+// refer to query parameters, or if column ids must be unique across
+// analyses.
+static std::string GetTemplatedSQLFunctionCallCacheKey(
+    const TemplatedSQLFunction& function,
+    const AnalyzerOptions& analyzer_options,
+    const std::vector<InputArgumentType>& actual_arguments,
+    const Catalog* catalog, const TypeFactory* type_factory) {
+  if (!function.cache_resolved_calls() ||
+      analyzer_options.column_id_sequence_number() != nullptr ||
+      !analyzer_options.query_parameters().empty() ||
+      !analyzer_options.positional_query_parameters().empty() ||
+      analyzer_options.allow_undeclared_parameters()) {
+    return "";
+  }
+  LanguageOptionsProto language_options;
+  analyzer_options.language().Serialize(&language_options);
+  std::string key = absl::StrCat(
+      reinterpret_cast<uintptr_t>(catalog), ",",
+      reinterpret_cast<uintptr_t>(type_factory), ",",
+      analyzer_options.record_parse_locations(), ",",
+      language_options.SerializeAsString());
+  for (const InputArgumentType& argument : actual_arguments) {
+    absl::StrAppend(&key, ",", reinterpret_cast<uintptr_t>(argument.type()));
+  }
+  return key;
+}
+
 zetasql_base::Status FunctionResolver::ResolveTemplatedSQLFunctionCall(
     const ASTNode* ast_location, const TemplatedSQLFunction& function,
     const AnalyzerOptions& analyzer_options,
     const std::vector<InputArgumentType>& actual_arguments,
     std::shared_ptr<ResolvedFunctionCallInfo>* function_call_info_out) {
+  Catalog* catalog = catalog_;
+  if (function.resolution_catalog() != nullptr) {
+    catalog = function.resolution_catalog();
+  }
+  const std::string cache_key = GetTemplatedSQLFunctionCallCacheKey(
+      function, analyzer_options, actual_arguments, catalog, type_factory_);
+  if (!cache_key.empty()) {
+    const std::shared_ptr<const TemplatedSQLFunctionCall> cached_call =
+        function.FindCachedCall(cache_key);
+    if (cached_call != nullptr) {
+      std::unique_ptr<TemplatedSQLFunctionCall> call;
+      ZETASQL_RETURN_IF_ERROR(cached_call->Copy(&call));
+      function_call_info_out->reset(call.release());
+      return ::zetasql_base::OkStatus();
+    }
+  }
+
   // Check if this function calls itself. If so, return an error. Otherwise, add
   // a pointer to this class to the cycle detector in the analyzer options.
   CycleDetector::ObjectInfo object(
@@ -1768,10 +1912,6 @@ zetasql_base::Status FunctionResolver::ResolveTemplatedSQLFunctionCall(
       ParseExpression(function.GetParseResumeLocation(), parser_options,
                       &parser_output),
       analyzer_options.error_message_mode()));
-  Catalog* catalog = catalog_;
-  if (function.resolution_catalog() != nullptr) {
-    catalog = function.resolution_catalog();
-  }
 
   // Create a separate new resolver and resolve the function's SQL expression,
   // using the specified function arguments.
@@ -1849,9 +1989,18 @@ zetasql_base::Status FunctionResolver::ResolveTemplatedSQLFunctionCall(
   }
 
   // Return the final TemplatedSQLUDFCall with the resolved expression.
-  function_call_info_out->reset(new TemplatedSQLFunctionCall(
+  auto call = absl::make_unique<TemplatedSQLFunctionCall>(
       std::move(resolved_sql_body),
-      query_resolution_info.release_aggregate_columns_to_compute()));
+      query_resolution_info.release_aggregate_columns_to_compute());
+  if (!cache_key.empty()) {
+    // The cache outlives the arena of this analysis, so its copy must be on
+    // the heap.
+    ResolvedNode::ArenaScope heap_scope(/*arena=*/nullptr);
+    std::unique_ptr<TemplatedSQLFunctionCall> cached_call;
+    ZETASQL_RETURN_IF_ERROR(call->Copy(&cached_call));
+    function.AddCachedCall(cache_key, std::move(cached_call));
+  }
+  function_call_info_out->reset(call.release());
 
   return ::zetasql_base::OkStatus();
 }
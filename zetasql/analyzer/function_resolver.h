@@ -33,6 +33,7 @@
 #include "zetasql/public/type.h"
 #include "zetasql/public/value.h"
 #include "zetasql/resolved_ast/resolved_ast.h"
+#include "absl/container/flat_hash_map.h"
 #include "zetasql/base/status.h"
 
 namespace zetasql {
@@ -105,6 +106,10 @@ class FunctionResolver {
   //
   // Finally, once this check is complete, this method returns the result type
   // of this function call in <function_call_info>.
+  //
+  // If <function>.cache_resolved_calls() is true, the resolved call is cached
+  // on <function>, and later calls with the same argument types and options
+  // return a copy of it without resolving the body again.
   zetasql_base::Status ResolveTemplatedSQLFunctionCall(
       const ASTNode* ast_location, const TemplatedSQLFunction& function,
       const AnalyzerOptions& analyzer_options,
@@ -172,11 +177,39 @@ class FunctionResolver {
       const ExprResolutionInfo* expr_info,
       QueryResolutionInfo* query_info);
 
+  // Clears the memoized results of FindMatchingSignature().  Must be called
+  // if Functions that were passed to it may have been deleted.
+  void ClearSignatureMemo() { signature_memo_.clear(); }
+
  private:
+  // Key for <signature_memo_>: a function and the exact input arguments it
+  // was called with.  Arguments only match if they have the same Type
+  // pointers and categories, and literals only match if they have equal
+  // values, since coercion of literals depends on their values.
+  struct SignatureMemoKey {
+    const Function* function;
+    std::vector<InputArgumentType> arguments;
+  };
+  struct SignatureMemoKeyHash {
+    size_t operator()(const SignatureMemoKey& key) const;
+  };
+  struct SignatureMemoKeyEq {
+    bool operator()(const SignatureMemoKey& key1,
+                    const SignatureMemoKey& key2) const;
+  };
+
   Catalog* catalog_;           // Not owned.
   TypeFactory* type_factory_;  // Not owned.
   Resolver* resolver_;         // Not owned.
 
+  // Memoized results of FindMatchingSignature(), so that calls that repeat
+  // the same function and argument types do not repeat the coercion checks
+  // against every signature.  The value is NULL if no signature matched.
+  mutable absl::flat_hash_map<SignatureMemoKey,
+                              std::unique_ptr<const FunctionSignature>,
+                              SignatureMemoKeyHash, SignatureMemoKeyEq>
+      signature_memo_;
+
   // Represents the argument types corresponding to a SignatureArgumentKind.
   // There are three possibilities:
   // 1) The object represents an untyped NULL.
@@ -270,10 +303,16 @@ class FunctionResolver {
   // Returns a signature that matches the argument type list, returning
   // a concrete FunctionSignature if found.  If not found, returns NULL.
   // The caller takes ownership of the returned FunctionSignature.
+  // Results are memoized in <signature_memo_>.
   const FunctionSignature* FindMatchingSignature(
       const Function* function,
       const std::vector<InputArgumentType>& input_arguments) const;
 
+  // Implements FindMatchingSignature(), without memoization.
+  const FunctionSignature* FindMatchingSignatureImpl(
+      const Function* function,
+      const std::vector<InputArgumentType>& input_arguments) const;
+
   // Determines if the argument list count matches signature, returning the
   // number of times each repeated argument repeats and the number of
   // optional arguments present if true.
@@ -20,6 +20,7 @@
 #include <algorithm>
 #include <string>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "zetasql/base/logging.h"
@@ -42,27 +43,21 @@
 
 namespace zetasql {
 
-// Compares ResolvedLiterals by parse location. The ParseLocationRange must be
-// set on all compared literals.
+// A ResolvedLiteral and its parse location.
+typedef std::pair<const ResolvedLiteral*, ParseLocationRange> LocatedLiteral;
+
+// Compares ResolvedLiterals by parse location.
 struct LiteralParseLocationComparator {
-  bool operator()(const ResolvedLiteral* l1, const ResolvedLiteral* l2)
-      const {
-    DCHECK(l1->GetParseLocationRangeOrNULL() != nullptr);
-    DCHECK(l2->GetParseLocationRangeOrNULL() != nullptr);
-    return l1->GetParseLocationRangeOrNULL()->start() <
-           l2->GetParseLocationRangeOrNULL()->start();
+  bool operator()(const LocatedLiteral& l1, const LocatedLiteral& l2) const {
+    return l1.second.start() < l2.second.start();
   }
 };
 
 // Returns true if the given literals occur at the same location and have the
 // same value (and hence type). Such literals are created in analytical
-// functions. The ParseLocationRange must be set on all compared literals.
-static bool IsSameLiteral(const ResolvedLiteral* a, const ResolvedLiteral* b) {
-  DCHECK(a->GetParseLocationRangeOrNULL() != nullptr);
-  DCHECK(b->GetParseLocationRangeOrNULL() != nullptr);
-  const ParseLocationRange& location_a = *a->GetParseLocationRangeOrNULL();
-  const ParseLocationRange& location_b = *b->GetParseLocationRangeOrNULL();
-  return location_a == location_b && a->value() == b->value();
+// functions.
+static bool IsSameLiteral(const LocatedLiteral& a, const LocatedLiteral& b) {
+  return a.second == b.second && a.first->value() == b.first->value();
 }
 
 static std::string GenerateParameterName(const ResolvedLiteral* literal,
@@ -96,10 +91,11 @@ zetasql_base::Status ReplaceLiteralsByParameters(
   analyzer_output->resolved_statement()->GetDescendantsWithKinds(
       {RESOLVED_OPTION}, &option_nodes);
   std::unordered_set<const ResolvedLiteral*> ignore_options_literals;
+  ParseLocationRange location;
   for (const ResolvedNode* node : option_nodes) {
     const ResolvedOption* option = node->GetAs<ResolvedOption>();
     if (option->value()->node_kind() == RESOLVED_LITERAL &&
-        option->value()->GetParseLocationRangeOrNULL() != nullptr) {
+        analyzer_output->GetParseLocationRange(option->value(), &location)) {
       const ResolvedLiteral* option_literal =
           option->value()->GetAs<ResolvedLiteral>();
       if (zetasql_base::ContainsKey(option_names_to_ignore, option->name())) {
@@ -112,12 +108,12 @@ zetasql_base::Status ReplaceLiteralsByParameters(
   std::vector<const ResolvedNode*> literal_nodes;
   analyzer_output->resolved_statement()->GetDescendantsWithKinds(
       {RESOLVED_LITERAL}, &literal_nodes);
-  std::vector<const ResolvedLiteral*> literals;
+  std::vector<LocatedLiteral> literals;
   for (const ResolvedNode* node : literal_nodes) {
     const ResolvedLiteral* literal = node->GetAs<ResolvedLiteral>();
-    if (literal->GetParseLocationRangeOrNULL() != nullptr &&
+    if (analyzer_output->GetParseLocationRange(literal, &location) &&
         !zetasql_base::ContainsKey(ignore_options_literals, literal)) {
-      literals.push_back(literal);
+      literals.emplace_back(literal, location);
     }
   }
   std::sort(literals.begin(), literals.end(), LiteralParseLocationComparator());
@@ -130,16 +126,14 @@ zetasql_base::Status ReplaceLiteralsByParameters(
   int parameter_index = 0;  // Index used to generate unique parameter names.
   std::string parameter_name;  // Most recently used parameter name.
   for (int i = 0; i < literals.size(); ++i) {
-    const ResolvedLiteral* literal = literals[i];
-    const ParseLocationRange* location = literal->GetParseLocationRangeOrNULL();
-    ZETASQL_RET_CHECK(location != nullptr);
-    const int first_offset = location->start().GetByteOffset();
-    const int last_offset = location->end().GetByteOffset();
+    const ResolvedLiteral* literal = literals[i].first;
+    const int first_offset = literals[i].second.start().GetByteOffset();
+    const int last_offset = literals[i].second.end().GetByteOffset();
     ZETASQL_RET_CHECK(first_offset >= 0 && last_offset > first_offset &&
               last_offset <= sql.length());
     // Since literals are ordered by location, literals representing the same
     // input location are guaranteed to be consecutive.
-    if (i > 0 && IsSameLiteral(literal, literals[i - 1])) {
+    if (i > 0 && IsSameLiteral(literals[i], literals[i - 1])) {
       // Each occurrence of a literal maps to the same parameter name.
       ZETASQL_RET_CHECK(zetasql_base::InsertIfNotPresent(literal_map, literal, parameter_name));
       continue;
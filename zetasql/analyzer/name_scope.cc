@@ -149,6 +149,20 @@ NameScope::NameScope(const NameList& name_list)
 NameScope::~NameScope() {
 }
 
+const NameScope::State& NameScope::state() const {
+  static const State* const kEmptyState = new State;
+  return state_ == nullptr ? *kEmptyState : *state_;
+}
+
+NameScope::State* NameScope::mutable_state() {
+  if (state_ == nullptr) {
+    state_ = std::make_shared<State>();
+  } else if (state_.use_count() > 1) {
+    state_ = std::make_shared<State>(*state_);
+  }
+  return state_.get();
+}
+
 bool NameScope::IsEmpty() const {
   return names().empty() && value_table_columns().empty();
 }
@@ -1187,6 +1201,12 @@ NameList::NameList() {
 NameList::~NameList() {
 }
 
+void NameList::ReserveColumns(int size) {
+  columns_.reserve(columns_.size() + size);
+  IdStringHashMapCase<NameTarget>* names = name_scope_.mutable_names();
+  names->reserve(names->size() + size);
+}
+
 zetasql_base::Status NameList::AddColumn(
     IdString name, const ResolvedColumn& column, bool is_explicit) {
   columns_.emplace_back(name, column, is_explicit);
@@ -1346,6 +1366,10 @@ zetasql_base::Status NameList::MergeFromExceptColumns(
     return ::zetasql_base::OkStatus();
   }
 
+  columns_.reserve(columns_.size() + other.columns().size());
+  name_scope_.mutable_names()->reserve(name_scope_.names().size() +
+                                       other.name_scope_.names().size());
+
   // Copy the columns vector, with exclusions.
   // We're not using AddColumn because we're going to copy the NameScope
   // maps directly below.
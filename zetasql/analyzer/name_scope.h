@@ -807,39 +807,40 @@ class NameScope {
       NameTarget* field_target);
 
   // The local state for this NameScope is stored in this struct which is
-  // stored in a CopyOnWrite.  This allows cheap copies when constructing
-  // NameScopes from NameLists and in NameList::MergeFrom.
+  // shared copy-on-write between NameScopes and NameLists.  This allows cheap
+  // copies when constructing NameScopes from NameLists and in
+  // NameList::MergeFrom, which would otherwise copy every name of a wide
+  // table for each scope.
   struct State {
     // This is the main map storing the names visible in this local scope
     // (not including names from parent scopes).
-    // Using map rather than hash_map because the set is often small,
-    // and these may be constructed and destructed frequently.
     IdStringHashMapCase<NameTarget> names;
 
     // Vector of ValueTableColumns for all value tables in this local scope.
     // When looking up a name, we also look for fields of any of these columns
     // (except for fields marked as excluded for each value table column).
     std::vector<ValueTableColumn> value_table_columns;
-
-    void CopyFrom(const State& other) {
-      names = other.names;
-      value_table_columns = other.value_table_columns;
-    }
   };
-  State state_;
+  // NULL means empty.  Never modified while shared; see mutable_state().
+  std::shared_ptr<State> state_;
+
+  // Returns the state for reading.
+  const State& state() const;
+  // Returns the state for writing, first copying it if it is shared.
+  State* mutable_state();
 
-  // Accessors for fields inside the CopyOnWrite state_.
+  // Accessors for fields inside the copy-on-write state_.
   const IdStringHashMapCase<NameTarget>& names() const {
-    return state_.names;
+    return state().names;
   }
   IdStringHashMapCase<NameTarget>* mutable_names() {
-    return &state_.names;
+    return &mutable_state()->names;
   }
   const std::vector<ValueTableColumn>& value_table_columns() const {
-    return state_.value_table_columns;
+    return state().value_table_columns;
   }
   std::vector<ValueTableColumn>* mutable_value_table_columns() {
-    return &state_.value_table_columns;
+    return &mutable_state()->value_table_columns;
   }
 
   // These are used internally to optimize copying.
@@ -924,9 +925,10 @@ class NameList {
   NameList& operator=(const NameList&) = delete;
   ~NameList();
 
-  // Prepare this NameList for 'size' new columns. This is for efficiency
-  // purposes only.
-  void ReserveColumns(int size) { columns_.reserve(size); }
+  // Prepare this NameList for 'size' new columns, so that adding them
+  // does not reallocate the column vector or rehash the name map. This is
+  // for efficiency purposes only.
+  void ReserveColumns(int size);
 
   // Add a named column.
   // <is_explicit> should be true if the alias for this column is an explicit
@@ -117,6 +117,8 @@ void QueryGroupByAndAggregateInfo::Reset() {
   aggregate_expr_map.clear();
   group_by_columns_to_compute.clear();
   group_by_expr_map.clear();
+  group_by_same_expr_map.clear();
+  num_group_by_exprs_indexed = 0;
   rollup_column_list.clear();
   aggregate_columns_to_compute.clear();
   group_by_valid_field_info_map.Clear();
@@ -152,6 +154,22 @@ QueryResolutionInfo::GetEquivalentGroupByComputedColumnOrNull(
   return zetasql_base::FindPtrOrNull(group_by_info_.group_by_expr_map, expr);
 }
 
+const ResolvedComputedColumn*
+QueryResolutionInfo::GetSameGroupByComputedColumnOrNull(
+    const ResolvedExpr* expr) {
+  const std::vector<std::unique_ptr<const ResolvedComputedColumn>>& columns =
+      group_by_info_.group_by_columns_to_compute;
+  for (; group_by_info_.num_group_by_exprs_indexed < columns.size();
+       ++group_by_info_.num_group_by_exprs_indexed) {
+    const ResolvedComputedColumn* column =
+        columns[group_by_info_.num_group_by_exprs_indexed].get();
+    // emplace() keeps the first of several same expressions.
+    group_by_info_.group_by_same_expr_map.emplace(column->expr(), column);
+  }
+  return zetasql_base::FindPtrOrNull(group_by_info_.group_by_same_expr_map,
+                                     expr);
+}
+
 void QueryResolutionInfo::AddRollupColumn(
     const ResolvedComputedColumn* column) {
   group_by_info_.rollup_column_list.push_back(column);
@@ -27,6 +27,7 @@
 
 #include <cstdint>
 
+#include "zetasql/analyzer/expr_resolver_helper.h"
 #include "zetasql/analyzer/name_scope.h"
 #include "zetasql/parser/parse_tree.h"
 #include "zetasql/resolved_ast/resolved_ast.h"
@@ -126,6 +127,17 @@ struct QueryGroupByAndAggregateInfo {
                      FieldPathHashOperator, FieldPathEqualsOperator>
       group_by_expr_map;
 
+  // Map of group by expressions to entries within group_by_columns_to_compute
+  // under IsSameExpressionForGroupBy(), which unlike <group_by_expr_map>
+  // matches non-path expressions too.  Built lazily from the first
+  // <num_group_by_exprs_indexed> entries of group_by_columns_to_compute, since
+  // it is only needed when matching select list expressions to the GROUP BY.
+  absl::flat_hash_map<const ResolvedExpr*, const ResolvedComputedColumn*,
+                      GroupByExpressionHashOperator,
+                      GroupByExpressionEqualsOperator>
+      group_by_same_expr_map;
+  int num_group_by_exprs_indexed = 0;
+
   // Columns in the ROLLUP list, or an empty vector if the query does
   // not use ROLLUP. Stores unowned pointers from <group_by_columns_to_compute>.
   std::vector<const ResolvedComputedColumn*> rollup_column_list;
@@ -194,6 +206,12 @@ class QueryResolutionInfo {
   const ResolvedComputedColumn* GetEquivalentGroupByComputedColumnOrNull(
       const ResolvedExpr* expr) const;
 
+  // Returns a pointer to the first ResolvedComputedColumn in
+  // group_by_columns_to_compute() whose expression is the same as <expr>, as
+  // determined by IsSameExpressionForGroupBy(), or nullptr if there is none.
+  const ResolvedComputedColumn* GetSameGroupByComputedColumnOrNull(
+      const ResolvedExpr* expr);
+
   // Adds a rollup column <column> that is present in the group by list.
   // Does not transfer ownership.
   void AddRollupColumn(const ResolvedComputedColumn* column);
@@ -264,6 +282,8 @@ class QueryResolutionInfo {
   release_group_by_columns_to_compute() {
     std::vector<std::unique_ptr<const ResolvedComputedColumn>> tmp;
     group_by_info_.group_by_columns_to_compute.swap(tmp);
+    group_by_info_.group_by_same_expr_map.clear();
+    group_by_info_.num_group_by_exprs_indexed = 0;
     return tmp;
   }
 
@@ -52,7 +52,9 @@
 #include "zetasql/base/case.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
+#include "absl/time/time.h"
 #include "absl/types/variant.h"
+#include "zetasql/base/canonical_errors.h"
 #include "zetasql/base/map_util.h"
 #include "zetasql/base/ret_check.h"
 #include "zetasql/base/status_macros.h"
@@ -84,6 +86,9 @@ Resolver::~Resolver() {
 
 void Resolver::Reset(absl::string_view sql) {
   sql_ = sql;
+  resolve_start_time_ = absl::Now();
+  resolve_start_arena_bytes_ =
+      analyzer_options_.arena()->status().bytes_allocated();
   with_subquery_map_.clear();
   unique_with_alias_names_.clear();
   next_subquery_id_ = 1;
@@ -101,6 +106,17 @@ void Resolver::Reset(absl::string_view sql) {
   function_arguments_.clear();
   function_table_arguments_.clear();
   resolved_columns_from_table_scans_.clear();
+  function_resolver_->ClearSignatureMemo();
+  comparison_functions_.clear();
+  comparison_signatures_.clear();
+  table_scan_names_.clear();
+  star_expansions_.clear();
+  if (analyzer_options_.record_parse_locations() &&
+      analyzer_options_.compact_parse_locations()) {
+    parse_locations_ = absl::make_unique<ParseLocationTable>();
+  } else {
+    parse_locations_.reset();
+  }
 
   if (analyzer_options_.column_id_sequence_number() != nullptr) {
     next_column_id_sequence_ = analyzer_options_.column_id_sequence_number();
@@ -108,14 +124,25 @@ void Resolver::Reset(absl::string_view sql) {
     owned_column_id_sequence_ = absl::make_unique<zetasql_base::SequenceNumber>();
     next_column_id_sequence_ = owned_column_id_sequence_.get();
   }
+  next_column_id_ = 0;
+  column_id_block_end_ = 0;
+  column_id_block_size_ = kMinColumnIdBlockSize;
 }
 
 int Resolver::AllocateColumnId() {
-  int64_t id = next_column_id_sequence_->GetNext();
-  if (id == 0) {  // Avoid using column_id 0.
-    id = next_column_id_sequence_->GetNext();
-    DCHECK_NE(id, 0);
+  if (next_column_id_ == column_id_block_end_) {
+    next_column_id_ =
+        next_column_id_sequence_->GetNextBlock(column_id_block_size_);
+    column_id_block_end_ = next_column_id_ + column_id_block_size_;
+    if (column_id_block_size_ < kMaxColumnIdBlockSize) {
+      column_id_block_size_ *= 2;
+    }
+    if (next_column_id_ == 0) {  // Avoid using column_id 0.
+      ++next_column_id_;
+    }
   }
+  const int64_t id = next_column_id_++;
+  DCHECK_NE(id, 0);
   // Should be impossible for this to happen unless sharing across huge
   // numbers of queries.  If it does, column_ids will wrap around as int32s.
   DCHECK_LE(id, std::numeric_limits<int32_t>::max());
@@ -134,6 +161,55 @@ IdString Resolver::MakeIdString(absl::string_view str) const {
   return id_string_pool_->Make(str);
 }
 
+zetasql_base::Status Resolver::CheckCanContinueResolving(
+    const ASTNode* ast_location) const {
+  const AnalyzerCancellationToken* token =
+      analyzer_options_.cancellation_token().get();
+  if (token != nullptr && token->cancelled()) {
+    return StatusWithInternalErrorLocation(
+        ::zetasql_base::CancelledError("Analysis was cancelled"), ast_location);
+  }
+  const AnalyzerLimits& limits = analyzer_options_.limits();
+  if (analyzer_options_.deadline() == absl::InfiniteFuture() &&
+      limits.max_resolver_time == absl::ZeroDuration() &&
+      limits.max_resolver_arena_bytes == 0) {
+    return ::zetasql_base::OkStatus();
+  }
+  const absl::Time now = absl::Now();
+  if (now > analyzer_options_.deadline()) {
+    return StatusWithInternalErrorLocation(
+        ::zetasql_base::DeadlineExceededError(absl::StrCat(
+            "Analysis passed its deadline after resolving for ",
+            absl::FormatDuration(now - resolve_start_time_))),
+        ast_location);
+  }
+  if (limits.max_resolver_time > absl::ZeroDuration()) {
+    const absl::Duration elapsed = now - resolve_start_time_;
+    if (elapsed > limits.max_resolver_time) {
+      return StatusWithInternalErrorLocation(
+          ::zetasql_base::ResourceExhaustedError(absl::StrCat(
+              "Query is too complex to analyze: resolving it took ",
+              absl::FormatDuration(elapsed), ", more than the limit of ",
+              absl::FormatDuration(limits.max_resolver_time))),
+          ast_location);
+    }
+  }
+  if (limits.max_resolver_arena_bytes > 0) {
+    const int64_t arena_bytes =
+        analyzer_options_.arena()->status().bytes_allocated() -
+        resolve_start_arena_bytes_;
+    if (arena_bytes > limits.max_resolver_arena_bytes) {
+      return StatusWithInternalErrorLocation(
+          ::zetasql_base::ResourceExhaustedError(absl::StrCat(
+              "Query is too complex to analyze: resolving it used ",
+              arena_bytes, " bytes of memory, more than the limit of ",
+              limits.max_resolver_arena_bytes)),
+          ast_location);
+    }
+  }
+  return ::zetasql_base::OkStatus();
+}
+
 std::unique_ptr<const ResolvedLiteral> Resolver::MakeResolvedLiteral(
     const ASTNode* ast_location, const Value& value,
     bool set_has_explicit_type) const {
@@ -291,6 +367,9 @@ zetasql_base::Status Resolver::ResolveExprWithFunctionArguments(
     ExprResolutionInfo* expr_resolution_info,
     std::unique_ptr<const ResolvedExpr>* output) {
   Reset(sql);
+  // The body is part of the caller's resolved AST, but this resolver's
+  // ParseLocationTable is not, so its nodes keep their own locations.
+  parse_locations_.reset();
   for (std::pair<const IdString, std::unique_ptr<ResolvedArgumentRef>>& kv :
        *function_arguments) {
     // Take ownership of the unique pointers in 'function_arguments'.
@@ -316,6 +395,8 @@ zetasql_base::Status Resolver::ResolveQueryStatementWithFunctionArguments(
     std::unique_ptr<const ResolvedStatement>* output_stmt,
     std::shared_ptr<const NameList>* output_name_list) {
   Reset(sql);
+  // As in ResolveExprWithFunctionArguments().
+  parse_locations_.reset();
   for (std::pair<const IdString, std::unique_ptr<ResolvedArgumentRef>>& kv :
        *function_arguments) {
     // Take ownership of the unique pointers in 'function_arguments'.
@@ -629,11 +710,13 @@ zetasql_base::Status Resolver::ResolvePathExpressionAsType(
                                     : path_expr->ToIdentifierPathString());
   }
 
-  const zetasql_base::Status status =
-      catalog_->FindType(
-          (is_single_identifier ? std::vector<std::string>{single_name}
-                                : identifier_path),
-          resolved_type, analyzer_options_.find_options());
+  const std::vector<std::string> type_path =
+      is_single_identifier ? std::vector<std::string>{single_name}
+                           : identifier_path;
+  const zetasql_base::Status status = FindInCatalog("Type", type_path, [&] {
+    return catalog_->FindType(type_path, resolved_type,
+                              analyzer_options_.find_options());
+  });
   if (status.code() == zetasql_base::StatusCode::kNotFound) {
     return MakeSqlErrorAt(path_expr)
            << "Type not found: "
@@ -1052,8 +1135,10 @@ zetasql_base::Status Resolver::FindTable(
   ZETASQL_RET_CHECK(name != nullptr);
   ZETASQL_RET_CHECK(table != nullptr);
 
-  zetasql_base::Status status = catalog_->FindTable(
-      name->ToIdentifierVector(), table, analyzer_options_.find_options());
+  const std::vector<IdString> path = name->ToIdStringVector();
+  zetasql_base::Status status = FindInCatalog("Table", path, [&] {
+    return catalog_->FindTable(path, table, analyzer_options_.find_options());
+  });
   if (status.code() == zetasql_base::StatusCode::kNotFound) {
     std::string message;
     absl::StrAppend(
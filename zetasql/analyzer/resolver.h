@@ -17,6 +17,7 @@
 #ifndef ZETASQL_ANALYZER_RESOLVER_H_
 #define ZETASQL_ANALYZER_RESOLVER_H_
 
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <set>
@@ -41,6 +42,7 @@
 #include "zetasql/public/language_options.h"
 #include "zetasql/public/options.pb.h"
 #include "zetasql/public/parse_location.h"
+#include "zetasql/public/parse_location_table.h"
 #include "zetasql/public/signature_match_result.h"
 #include "zetasql/public/table_valued_function.h"
 #include "zetasql/public/type.h"
@@ -52,6 +54,7 @@
 #include "absl/base/attributes.h"
 #include "absl/base/macros.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/node_hash_map.h"
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
 #include "absl/types/span.h"
@@ -181,6 +184,38 @@ class Resolver {
     return undeclared_positional_parameters_;
   }
 
+  // With AnalyzerOptions::compact_parse_locations(), returns the table of
+  // the parse location ids recorded in the nodes of the last input
+  // analyzed, and leaves none.  Returns NULL otherwise.
+  std::unique_ptr<ParseLocationTable> release_parse_locations() {
+    return std::move(parse_locations_);
+  }
+
+  // Returns a column id not used by any column created so far, for rewrites
+  // of the resolved AST that add columns.
+  int AllocateColumnId();
+
+  // Returns a new ResolvedColumn with a column id from AllocateColumnId().
+  // Its metadata lives in the IdStringPool if ResolvedColumn is compact.
+  ResolvedColumn AllocateColumn(IdString table_name, IdString name,
+                                const Type* type) {
+    return ResolvedColumn(AllocateColumnId(), table_name, name, type,
+                          id_string_pool_);
+  }
+
+  // Work done by this Resolver since it was constructed, reported in
+  // AnalyzerRuntimeInfo.
+  struct RuntimeStats {
+    int64_t num_catalog_lookups = 0;
+    absl::Duration catalog_lookup_time;
+    int64_t num_signatures_tried = 0;
+  };
+  const RuntimeStats& runtime_stats() const { return runtime_stats_; }
+
+  // Called by the FunctionResolver for each signature it matches against the
+  // arguments of a function call.
+  void RecordSignatureTried() { ++runtime_stats_.num_signatures_tried; }
+
   const AnalyzerOptions& analyzer_options() const { return analyzer_options_; }
   const LanguageOptions& language() const {
     return analyzer_options_.language();
@@ -235,6 +270,12 @@ class Resolver {
 
   Catalog* catalog_;
   TypeFactory* type_factory_;
+  // Mutable for the const methods that look up names in <catalog_>.
+  mutable RuntimeStats runtime_stats_;
+  // Time and AnalyzerOptions::arena() size when the resolving started, for
+  // CheckCanContinueResolving().
+  absl::Time resolve_start_time_;
+  int64_t resolve_start_arena_bytes_ = 0;
   const AnalyzerOptions& analyzer_options_;  // Not owned.
   Coercer coercer_;
 
@@ -248,10 +289,22 @@ class Resolver {
   // Pool where IdStrings are allocated.  Copied from AnalyzerOptions.
   IdStringPool* const id_string_pool_;
 
-  // Next unique column_id to allocate.  Pointer may come from AnalyzerOptions.
+  // Source of unique column_ids.  Pointer may come from AnalyzerOptions.
   zetasql_base::SequenceNumber* next_column_id_sequence_ = nullptr;  // Not owned.
   std::unique_ptr<zetasql_base::SequenceNumber> owned_column_id_sequence_;
 
+  // Column ids are reserved from <next_column_id_sequence_> in blocks, so that
+  // resolvers sharing a sequence across threads mostly allocate ids without
+  // touching the shared atomic.  The ids [next_column_id_,
+  // column_id_block_end_) are reserved and unused.  Blocks start small and
+  // double up to kMaxColumnIdBlockSize, so small queries do not use up
+  // shared ids much faster than before.
+  static constexpr int64_t kMinColumnIdBlockSize = 16;
+  static constexpr int64_t kMaxColumnIdBlockSize = 4096;
+  int64_t next_column_id_ = 0;
+  int64_t column_id_block_end_ = 0;
+  int64_t column_id_block_size_ = kMinColumnIdBlockSize;
+
   // Next unique subquery ID to allocate. Used for display only.
   int next_subquery_id_;
 
@@ -390,6 +443,59 @@ class Resolver {
   absl::flat_hash_map<ResolvedColumn, const Column*, ResolvedColumnHasher>
       resolved_columns_from_table_scans_;
 
+  // The names a scan of a Table gives to the table and to each of its
+  // columns, with unnamed columns named $col<N>.
+  struct TableScanNames {
+    IdString table_name;
+    std::vector<IdString> column_names;
+  };
+
+  // TableScanNames of the Tables scanned in the current statement, so that
+  // scanning a table again does not copy its names into the IdStringPool
+  // again.  A node_hash_map, so that references to its values stay valid
+  // while resolving nested scans.  Cleared by Reset() since Tables may be deleted between
+  // statements.
+  absl::node_hash_map<const Table*, TableScanNames> table_scan_names_;
+
+  // One of the fields that star expansion of a STRUCT or PROTO type adds to
+  // the select list.
+  struct StarExpansionField {
+    IdString name;
+    const Type* type = nullptr;
+    // The index of a STRUCT field.
+    int field_index = -1;
+    // The descriptor and default value of a PROTO field.
+    const google::protobuf::FieldDescriptor* proto_field = nullptr;
+    Value default_value;
+    // The error from computing the type of a PROTO field, which is returned
+    // only if the field is expanded.
+    zetasql_base::Status type_status;
+  };
+
+  // The StarExpansionFields of the STRUCT and PROTO types expanded in the
+  // current statement, in expansion order, so that expanding a wide type
+  // again does not walk its fields, sort them or compute their types again.
+  // EXCEPT and REPLACE are applied to these by AddColumnFieldsToSelectList().
+  // A node_hash_map, so that references to its values stay valid.  Cleared
+  // by Reset() since Types may be deleted between statements.
+  absl::node_hash_map<const Type*, std::vector<StarExpansionField>>
+      star_expansions_;
+
+  // With AnalyzerOptions::compact_parse_locations(), the parse locations
+  // recorded by RecordParseLocation() since Reset().
+  std::unique_ptr<ParseLocationTable> parse_locations_;
+
+  // Functions of comparison operators found in the catalog, by function
+  // name, and the signatures that comparisons of two arguments of the same
+  // simple type resolved to, by function and argument type, so that
+  // ResolveComparisonExpr() does not repeat the catalog lookup and signature
+  // matching.  Cleared by Reset() since Functions may be deleted between
+  // statements.
+  absl::flat_hash_map<std::string, const Function*> comparison_functions_;
+  absl::flat_hash_map<std::pair<const Function*, const Type*>,
+                      std::unique_ptr<const FunctionSignature>>
+      comparison_signatures_;
+
   // Maps resolved floating point literal IDs to their original textual image.
   absl::flat_hash_map<int, std::string> float_literal_images_;
   // Next ID to assign to a float literal. The ID of 0 is reserved for
@@ -404,12 +510,34 @@ class Resolver {
     return function_resolver_.get();
   }
 
-  int AllocateColumnId();
   IdString AllocateSubqueryName();
   IdString AllocateUnnestName();
 
   IdString MakeIdString(absl::string_view str) const;
 
+  // Returns the result of <find>, which calls the Catalog::Find* method for
+  // <object_kind> on <path>. Records the lookup in runtime_stats_ and reports
+  // it to the lookup callback of the FindOptions.
+  template <typename PathT, typename FindFn>
+  zetasql_base::Status FindInCatalog(const char* object_kind, const PathT& path,
+                             FindFn find) const {
+    const absl::Time start = absl::Now();
+    zetasql_base::Status status =
+        Catalog::TraceLookup(catalog_, object_kind, absl::MakeConstSpan(path),
+                             analyzer_options_.find_options(), find);
+    ++runtime_stats_.num_catalog_lookups;
+    runtime_stats_.catalog_lookup_time += absl::Now() - start;
+    return status;
+  }
+
+  // Returns an error at <ast_location> if resolving should stop: CANCELLED if
+  // the AnalyzerOptions::cancellation_token() was cancelled, DEADLINE_EXCEEDED
+  // after the AnalyzerOptions::deadline(), and RESOURCE_EXHAUSTED if resolving
+  // has run longer or grown the arena more than AnalyzerOptions::limits()
+  // allow. Called before resolving each statement, table expression,
+  // expression and query.
+  zetasql_base::Status CheckCanContinueResolving(const ASTNode* ast_location) const;
+
   // Makes a new resolved literal and records its location.
   std::unique_ptr<const ResolvedLiteral> MakeResolvedLiteral(
       const ASTNode* ast_location, const Value& value,
@@ -1252,6 +1380,11 @@ class Resolver {
   // SelectColumnState as has_analytic.  If the column has no fields, then if
   // <column_alias_if_no_fields> is non-empty, emits the column itself,
   // and otherwise returns an error.
+  // Returns the StarExpansionFields of <type>, a STRUCT or PROTO, computing
+  // them the first time <type> is expanded in the statement.
+  zetasql_base::StatusOr<const std::vector<StarExpansionField>*> GetStarExpansion(
+      const Type* type);
+
   zetasql_base::Status AddColumnFieldsToSelectList(
       const ASTExpression* ast_expression,
       const ResolvedColumnRef* src_column_ref,
@@ -1634,6 +1767,11 @@ class Resolver {
   void MaybeRecordParseLocation(const ASTNode* ast_location,
                                 ResolvedNode* resolved_node) const;
 
+  // Records <range> as the location of <resolved_node>, in the node or with
+  // compact_parse_locations() in <parse_locations_>.
+  void RecordParseLocation(const ParseLocationRange& range,
+                           ResolvedNode* resolved_node) const;
+
   // Copies the locations of the argument name and type (if present) from the
   // 'function_argument' to the 'options'.
   void RecordArgumentParseLocationsIfPresent(
@@ -2012,6 +2150,10 @@ class Resolver {
   // the alias was explicitly defined in the query or was computed from the
   // expression. Returns the resulting resolved table scan in <output> and
   // <output_name_list>.
+  // Returns the TableScanNames of <table>, computing them on the first call
+  // for <table> in this statement.
+  const TableScanNames& GetTableScanNames(const Table* table);
+
   zetasql_base::Status ResolvePathExpressionAsTableScan(
       const ASTPathExpression* path_expr, IdString alias,
       bool has_explicit_alias, const ASTNode* alias_location,
@@ -2128,6 +2270,16 @@ class Resolver {
       ExprResolutionInfo* expr_resolution_info,
       std::unique_ptr<const ResolvedExpr>* resolved_expr_out);
 
+  // Resolves <binary_expr>, a comparison (=, !=, <>, <, <=, > or >=), as a
+  // call to <function_name>.  A comparison of two arguments of the same
+  // simple type, none of them an untyped NULL or parameter, reuses the
+  // function and signature of the first such comparison of that type, if it
+  // needed no coercions, argument checks or deprecation warnings.
+  zetasql_base::Status ResolveComparisonExpr(
+      const ASTBinaryExpression* binary_expr, const std::string& function_name,
+      ExprResolutionInfo* expr_resolution_info,
+      std::unique_ptr<const ResolvedExpr>* resolved_expr_out);
+
   zetasql_base::Status ResolveBitwiseShiftExpr(
       const ASTBitwiseShiftExpression* bitwise_shift_expr,
       ExprResolutionInfo* expr_resolution_info,
@@ -2364,11 +2516,31 @@ class Resolver {
       std::vector<std::unique_ptr<const ResolvedExpr>>* resolved_arguments_out,
       std::vector<const ASTExpression*>* ast_arguments_out);
 
+  // Records whether values are assignable to one DML target column, so that
+  // the rows of a multi-row INSERT VALUES check each column's coercions once.
+  // The key is the Type of a value and whether it is a literal, which can
+  // coerce to more types than other values. Only values whose coercion
+  // depends on nothing else are recorded: untyped values and query parameters
+  // are not, and neither are values of non-simple types, whose coercion can
+  // depend on their fields.
+  typedef absl::flat_hash_map<std::pair<const Type*, bool>, bool>
+      DMLValueCoercionCache;
+
   zetasql_base::Status ResolveInsertValuesRow(
       const ASTInsertValuesRow* ast_insert_values_row, const NameScope* scope,
       const ResolvedColumnList& insert_columns,
       std::unique_ptr<const ResolvedInsertRow>* output);
 
+  // Like ResolveInsertValuesRow() above, but uses <coercion_caches>, which
+  // has an entry per column of <insert_columns>, to check the coercions of
+  // values. The same <coercion_caches> can be used for all rows of a
+  // statement.
+  zetasql_base::Status ResolveInsertValuesRow(
+      const ASTInsertValuesRow* ast_insert_values_row, const NameScope* scope,
+      const ResolvedColumnList& insert_columns,
+      std::vector<DMLValueCoercionCache>* coercion_caches,
+      std::unique_ptr<const ResolvedInsertRow>* output);
+
   // Resolves the insert row by referencing all columns of <value_columns>.
   zetasql_base::Status ResolveInsertValuesRow(
       const ASTNode* ast_location, const ResolvedColumnList& value_columns,
@@ -2396,6 +2568,16 @@ class Resolver {
                                const char* clause_name,
                                std::unique_ptr<const ResolvedDMLValue>* output);
 
+  // Like ResolveDMLValue() above, but looks up and records in
+  // <coercion_cache>, if non-NULL, whether the value is assignable to
+  // <target_type>.
+  zetasql_base::Status ResolveDMLValue(const ASTExpression* ast_value,
+                               const Type* target_type,
+                               const NameScope* scope,
+                               const char* clause_name,
+                               DMLValueCoercionCache* coercion_cache,
+                               std::unique_ptr<const ResolvedDMLValue>* output);
+
   // Similar to above ResolveDMLValue(), but is used by INSERT clause of MERGE,
   // when the value list is omitted by using INSERT ROW. The <referenced_column>
   // is the resolved column from source.
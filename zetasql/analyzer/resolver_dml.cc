@@ -152,9 +152,8 @@ zetasql_base::Status Resolver::ResolveDeleteStatementImpl(
              << " in nested DELETE";
     }
 
-    const ResolvedColumn offset_column(AllocateColumnId(),
-                                       kArrayId /* table_name */, offset_alias,
-                                       types::Int64Type());
+    const ResolvedColumn offset_column = AllocateColumn(
+        kArrayId /* table_name */, offset_alias, types::Int64Type());
     resolved_array_offset_column = MakeResolvedColumnHolder(offset_column);
 
     // Stack a scope to include the offset column.  Stacking a scope is not
@@ -198,6 +197,18 @@ zetasql_base::Status Resolver::ResolveInsertValuesRow(
     const NameScope* scope,
     const ResolvedColumnList& insert_columns,
     std::unique_ptr<const ResolvedInsertRow>* output) {
+  return ResolveInsertValuesRow(ast_insert_values_row, scope, insert_columns,
+                                /*coercion_caches=*/nullptr, output);
+}
+
+zetasql_base::Status Resolver::ResolveInsertValuesRow(
+    const ASTInsertValuesRow* ast_insert_values_row,
+    const NameScope* scope,
+    const ResolvedColumnList& insert_columns,
+    std::vector<DMLValueCoercionCache>* coercion_caches,
+    std::unique_ptr<const ResolvedInsertRow>* output) {
+  ZETASQL_RET_CHECK(coercion_caches == nullptr ||
+            coercion_caches->size() == insert_columns.size());
   if (ast_insert_values_row->values().size() != insert_columns.size()) {
     return MakeSqlErrorAt(ast_insert_values_row)
            << "Inserted row has wrong column count; Has "
@@ -210,9 +221,11 @@ zetasql_base::Status Resolver::ResolveInsertValuesRow(
   for (int i = 0; i < ast_insert_values_row->values().size(); ++i) {
     const ASTExpression* value = ast_insert_values_row->values()[i];
     std::unique_ptr<const ResolvedDMLValue> resolved_dml_value;
-    ZETASQL_RETURN_IF_ERROR(ResolveDMLValue(value, insert_columns[i].type(), scope,
-                                    "INSERT VALUES" /* clause_name */,
-                                    &resolved_dml_value));
+    ZETASQL_RETURN_IF_ERROR(ResolveDMLValue(
+        value, insert_columns[i].type(), scope,
+        "INSERT VALUES" /* clause_name */,
+        coercion_caches == nullptr ? nullptr : &(*coercion_caches)[i],
+        &resolved_dml_value));
     dml_values.push_back(std::move(resolved_dml_value));
   }
 
@@ -492,9 +505,13 @@ zetasql_base::Status Resolver::ResolveInsertStatementImpl(
     row_list.reserve(ast_statement->rows()->rows().size());
     const NameScope* value_scope =
         is_nested ? nested_scope : empty_name_scope_.get();
+    // Rows usually have values of the same types, so each column's coercions
+    // are checked once for all rows.
+    std::vector<DMLValueCoercionCache> coercion_caches(insert_columns.size());
     for (const ASTInsertValuesRow* row : ast_statement->rows()->rows()) {
       std::unique_ptr<const ResolvedInsertRow> resolved_insert_row;
       ZETASQL_RETURN_IF_ERROR(ResolveInsertValuesRow(row, value_scope, insert_columns,
+                                             &coercion_caches,
                                              &resolved_insert_row));
       row_list.push_back(std::move(resolved_insert_row));
     }
@@ -531,6 +548,15 @@ zetasql_base::Status Resolver::ResolveDMLValue(
     const ASTExpression* ast_value, const Type* target_type,
     const NameScope* scope, const char* clause_name,
     std::unique_ptr<const ResolvedDMLValue>* output) {
+  return ResolveDMLValue(ast_value, target_type, scope, clause_name,
+                         /*coercion_cache=*/nullptr, output);
+}
+
+zetasql_base::Status Resolver::ResolveDMLValue(
+    const ASTExpression* ast_value, const Type* target_type,
+    const NameScope* scope, const char* clause_name,
+    DMLValueCoercionCache* coercion_cache,
+    std::unique_ptr<const ResolvedDMLValue>* output) {
   ZETASQL_RET_CHECK(ast_value != nullptr);
   std::unique_ptr<const ResolvedExpr> resolved_value;
   if (ast_value->node_kind() == AST_DEFAULT_LITERAL) {
@@ -542,9 +568,25 @@ zetasql_base::Status Resolver::ResolveDMLValue(
     if (!resolved_value->type()->Equals(target_type)) {
       const InputArgumentType input_argument_type =
           GetInputArgumentTypeForExpr(resolved_value.get());
-      SignatureMatchResult unused;
-      if (coercer_.AssignableTo(input_argument_type, target_type,
-                                /* is_explicit = */ false, &unused)) {
+      const bool cacheable = coercion_cache != nullptr &&
+                             !input_argument_type.is_untyped() &&
+                             !input_argument_type.is_query_parameter() &&
+                             input_argument_type.type()->IsSimpleType();
+      const std::pair<const Type*, bool> cache_key(
+          input_argument_type.type(), input_argument_type.is_literal());
+      const bool* cached_assignable =
+          cacheable ? zetasql_base::FindOrNull(*coercion_cache, cache_key)
+                    : nullptr;
+      bool assignable;
+      if (cached_assignable != nullptr) {
+        assignable = *cached_assignable;
+      } else {
+        SignatureMatchResult unused;
+        assignable = coercer_.AssignableTo(input_argument_type, target_type,
+                                           /* is_explicit = */ false, &unused);
+        if (cacheable) (*coercion_cache)[cache_key] = assignable;
+      }
+      if (assignable) {
         ZETASQL_RETURN_IF_ERROR(function_resolver_->AddCastOrConvertLiteral(
             ast_value, target_type, nullptr /* scan */,
             false /* set_has_explicit_type */, false /* return_null_on_error */,
@@ -910,10 +952,9 @@ zetasql_base::Status Resolver::PopulateUpdateTargetInfos(
         ZETASQL_RET_CHECK_EQ(function_name, kArrayAtOffset);
       }
 
-      info.array_element = absl::make_unique<ResolvedColumn>(
-          AllocateColumnId(), /*table_name=*/kArrayId,
-          /*column_name=*/kElementId,
-          info.target->type()->AsArray()->element_type());
+      info.array_element = absl::make_unique<ResolvedColumn>(AllocateColumn(
+          /*table_name=*/kArrayId, /*column_name=*/kElementId,
+          info.target->type()->AsArray()->element_type()));
 
       std::unique_ptr<ResolvedColumnRef> ref =
           MakeResolvedColumnRef(info.array_element->type(), *info.array_element,
@@ -1294,9 +1335,9 @@ zetasql_base::Status Resolver::MergeWithUpdateItem(
 
     if (resolved_update_item.element_column() == nullptr) {
       resolved_update_item.set_element_column(
-          MakeResolvedColumnHolder(ResolvedColumn(
-              AllocateColumnId(), /*table_name=*/kArrayId,
-              /*name=*/target_alias, target_type->AsArray()->element_type())));
+          MakeResolvedColumnHolder(AllocateColumn(
+              /*table_name=*/kArrayId, /*name=*/target_alias,
+              target_type->AsArray()->element_type())));
     }
 
     // We create a target scope here for nested statements that contains only
@@ -1467,9 +1508,8 @@ zetasql_base::Status Resolver::ResolveUpdateStatementImpl(
              << " in nested UPDATE";
     }
 
-    const ResolvedColumn offset_column(AllocateColumnId(),
-                                       kArrayId /* table_name */, offset_alias,
-                                       types::Int64Type());
+    const ResolvedColumn offset_column = AllocateColumn(
+        kArrayId /* table_name */, offset_alias, types::Int64Type());
     resolved_array_offset_column = MakeResolvedColumnHolder(offset_column);
 
     // Stack a scope on top of 'update_scope' to include the offset column.
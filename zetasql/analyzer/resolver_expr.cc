@@ -92,6 +92,7 @@
 #include "zetasql/base/map_util.h"
 #include "zetasql/base/ret_check.h"
 #include "zetasql/base/status.h"
+#include "zetasql/base/status_builder.h"
 #include "zetasql/base/status_macros.h"
 #include "zetasql/base/statusor.h"
 
@@ -437,8 +438,11 @@ zetasql_base::StatusOr<const google::protobuf::Descriptor*> Resolver::FindMessag
   }
 
   const Type* found_type = nullptr;
-  const zetasql_base::Status find_type_status = catalog_->FindType(
-      type_name_path, &found_type, analyzer_options_.find_options());
+  const zetasql_base::Status find_type_status =
+      FindInCatalog("Type", type_name_path, [&] {
+        return catalog_->FindType(type_name_path, &found_type,
+                                  analyzer_options_.find_options());
+      });
   if (find_type_status.code() == zetasql_base::StatusCode::kNotFound) {
     // We don't give an error if it wasn't found.  That will happen in
     // the caller so it has a chance to try generating a better error.
@@ -478,6 +482,8 @@ zetasql_base::Status Resolver::MakeResolvedDateOrTimeLiteral(
 
   switch (type_kind) {
     case TYPE_DATE: {
+      // Conversion errors are replaced by the error below.
+      zetasql_base::CodeOnlyErrorScope code_only_errors;
       int32_t date;
       if (functions::ConvertStringToDate(literal_string_value, &date).ok()) {
         *resolved_expr_out =
@@ -488,6 +494,7 @@ zetasql_base::Status Resolver::MakeResolvedDateOrTimeLiteral(
       break;
     }
     case TYPE_TIMESTAMP: {
+      zetasql_base::CodeOnlyErrorScope code_only_errors;
       if (language().LanguageFeatureEnabled(FEATURE_TIMESTAMP_NANOS)) {
         absl::Time timestamp;
         if (functions::ConvertStringToTimestamp(
@@ -514,6 +521,7 @@ zetasql_base::Status Resolver::MakeResolvedDateOrTimeLiteral(
       break;
     }
     case TYPE_TIME: {
+      zetasql_base::CodeOnlyErrorScope code_only_errors;
       TimeValue time;
       functions::TimestampScale scale =
           language().LanguageFeatureEnabled(FEATURE_TIMESTAMP_NANOS)
@@ -530,6 +538,7 @@ zetasql_base::Status Resolver::MakeResolvedDateOrTimeLiteral(
       break;
     }
     case TYPE_DATETIME: {
+      zetasql_base::CodeOnlyErrorScope code_only_errors;
       DatetimeValue datetime;
       functions::TimestampScale scale =
           language().LanguageFeatureEnabled(FEATURE_TIMESTAMP_NANOS)
@@ -568,16 +577,13 @@ zetasql_base::Status Resolver::ResolveExpr(
     ExprResolutionInfo* parent_expr_resolution_info,
     std::unique_ptr<const ResolvedExpr>* resolved_expr_out) {
   DCHECK(parent_expr_resolution_info != nullptr);
-
-  // Use a separate ExprAggregationInfo for the child because we don't
-  // want it to observe <has_aggregation> or <has_analytic> from a sibling.
-  // <has_aggregation> and <has_analytic> need to flow up the tree only, and
-  // not across.
-  std::unique_ptr<ExprResolutionInfo> expr_resolution_info(  // Save stack for
-      new ExprResolutionInfo(parent_expr_resolution_info));  // nested exprs.
+  ZETASQL_RETURN_IF_ERROR(CheckCanContinueResolving(ast_expr));
 
   switch (ast_expr->node_kind()) {
     // These cases are extracted into a separate method to reduce stack usage.
+    // Literals do not need the ExprResolutionInfo below, so they are resolved
+    // before allocating it; long IN lists and array constructors are mostly
+    // literals.
     case AST_INT_LITERAL:
     case AST_STRING_LITERAL:
     case AST_BYTES_LITERAL:
@@ -587,7 +593,18 @@ zetasql_base::Status Resolver::ResolveExpr(
     case AST_DATE_OR_TIME_LITERAL:
     case AST_NUMERIC_LITERAL:
       return ResolveLiteralExpr(ast_expr, resolved_expr_out);
+    default:
+      break;
+  }
 
+  // Use a separate ExprAggregationInfo for the child because we don't
+  // want it to observe <has_aggregation> or <has_analytic> from a sibling.
+  // <has_aggregation> and <has_analytic> need to flow up the tree only, and
+  // not across.
+  std::unique_ptr<ExprResolutionInfo> expr_resolution_info(  // Save stack for
+      new ExprResolutionInfo(parent_expr_resolution_info));  // nested exprs.
+
+  switch (ast_expr->node_kind()) {
     case AST_STAR:
       return MakeSqlErrorAt(ast_expr)
              << "Argument * can only be used in COUNT(*)"
@@ -1146,10 +1163,13 @@ zetasql_base::Status Resolver::ResolvePathExpressionAsExpression(
     // (4) We still haven't found a matching name. Try to resolve the longest
     // possible prefix of <path_expr> to a named constant.
     const Constant* constant = nullptr;
+    const std::vector<std::string> path = path_expr->ToIdentifierVector();
     zetasql_base::Status find_constant_with_path_prefix_status =
-        catalog_->FindConstantWithPathPrefix(path_expr->ToIdentifierVector(),
-                                             &num_names_consumed, &constant,
-                                             analyzer_options_.find_options());
+        FindInCatalog("Constant", path, [&] {
+          return catalog_->FindConstantWithPathPrefix(
+              path, &num_names_consumed, &constant,
+              analyzer_options_.find_options());
+        });
 
     // Handle the case where a constant was found or some internal error
     // occurred. If no constant was found, <num_names_consumed> is set to 0.
@@ -1788,11 +1808,26 @@ zetasql_base::Status Resolver::ResolveBinaryExpr(
   } else {
     const std::string& function_name =
         FunctionResolver::BinaryOperatorToFunctionName(binary_expr->op());
-    ZETASQL_RETURN_IF_ERROR(ResolveFunctionCallByNameWithoutAggregatePropertyCheck(
-        binary_expr, function_name,
-        { binary_expr->lhs(), binary_expr->rhs() },
-        *kEmptyArgumentOptionMap, expr_resolution_info,
-        &resolved_binary_expr));
+    switch (binary_expr->op()) {
+      case ASTBinaryExpression::EQ:
+      case ASTBinaryExpression::NE:
+      case ASTBinaryExpression::NE2:
+      case ASTBinaryExpression::GT:
+      case ASTBinaryExpression::LT:
+      case ASTBinaryExpression::GE:
+      case ASTBinaryExpression::LE:
+        ZETASQL_RETURN_IF_ERROR(ResolveComparisonExpr(binary_expr, function_name,
+                                              expr_resolution_info,
+                                              &resolved_binary_expr));
+        break;
+      default:
+        ZETASQL_RETURN_IF_ERROR(ResolveFunctionCallByNameWithoutAggregatePropertyCheck(
+            binary_expr, function_name,
+            { binary_expr->lhs(), binary_expr->rhs() },
+            *kEmptyArgumentOptionMap, expr_resolution_info,
+            &resolved_binary_expr));
+        break;
+    }
 
     // Give an error on literal NULL arguments to any binary expression
     // except IS.
@@ -1810,6 +1845,109 @@ zetasql_base::Status Resolver::ResolveBinaryExpr(
   return ::zetasql_base::OkStatus();
 }
 
+// Returns true if <expr>, resolved as a call to <function> with two
+// arguments of <type>, can be reused for other such calls: the call needed
+// no coercions, no checks that depend on the argument values, and no
+// deprecation warnings.
+static bool IsReusableComparison(const Function* function, const Type* type,
+                                 const ResolvedExpr& expr) {
+  if (expr.node_kind() != RESOLVED_FUNCTION_CALL ||
+      expr.GetAs<ResolvedFunctionCall>()->function() != function) {
+    return false;
+  }
+  if (!function->IsZetaSQLBuiltin() || function->IsDeprecated() ||
+      function->function_options().volatility != FunctionEnums::IMMUTABLE ||
+      function->PreResolutionConstraints() != nullptr ||
+      function->PostResolutionConstraints() != nullptr ||
+      function->GetComputeResultTypeCallback() != nullptr) {
+    return false;
+  }
+  const FunctionSignature& signature =
+      expr.GetAs<ResolvedFunctionCall>()->signature();
+  if (signature.IsDeprecated() ||
+      !signature.AdditionalDeprecationWarnings().empty() ||
+      signature.NumConcreteArguments() != 2) {
+    return false;
+  }
+  for (int i = 0; i < 2; ++i) {
+    const FunctionArgumentType& argument = signature.ConcreteArgument(i);
+    const FunctionArgumentTypeOptions& options = argument.options();
+    if (argument.type() != type || options.must_be_constant() ||
+        options.is_not_aggregate() || options.must_be_non_null() ||
+        options.has_min_value() || options.has_max_value()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+zetasql_base::Status Resolver::ResolveComparisonExpr(
+    const ASTBinaryExpression* binary_expr, const std::string& function_name,
+    ExprResolutionInfo* expr_resolution_info,
+    std::unique_ptr<const ResolvedExpr>* resolved_expr_out) {
+  // Look up the function before resolving the arguments, to give the same
+  // errors as other function calls.
+  const Function* function;
+  ResolvedFunctionCallBase::ErrorMode error_mode =
+      ResolvedFunctionCallBase::DEFAULT_ERROR_MODE;
+  auto function_it = comparison_functions_.find(function_name);
+  if (function_it != comparison_functions_.end()) {
+    function = function_it->second;
+  } else {
+    const std::vector<std::string> function_name_path = {function_name};
+    ZETASQL_RETURN_IF_ERROR(LookupFunctionFromCatalog(
+        binary_expr, function_name_path, &function, &error_mode));
+    if (error_mode == ResolvedFunctionCallBase::DEFAULT_ERROR_MODE) {
+      comparison_functions_.emplace(function_name, function);
+    }
+  }
+
+  std::vector<std::unique_ptr<const ResolvedExpr>> resolved_arguments;
+  std::vector<const ASTExpression*> ast_arguments;
+  ZETASQL_RETURN_IF_ERROR(ResolveExpressionArguments(
+      expr_resolution_info, {binary_expr->lhs(), binary_expr->rhs()},
+      *kEmptyArgumentOptionMap, &resolved_arguments, &ast_arguments));
+
+  // Untyped NULLs and parameters coerce to any type, so signature matching
+  // may treat them differently from typed arguments of the same type.
+  const Type* simple_type = nullptr;
+  if (resolved_arguments.size() == 2 &&
+      resolved_arguments[0]->type() == resolved_arguments[1]->type() &&
+      resolved_arguments[0]->type()->IsSimpleType() &&
+      !GetInputArgumentTypeForExpr(resolved_arguments[0].get()).is_untyped() &&
+      !GetInputArgumentTypeForExpr(resolved_arguments[1].get()).is_untyped()) {
+    simple_type = resolved_arguments[0]->type();
+  }
+  const std::pair<const Function*, const Type*> signature_key(function,
+                                                              simple_type);
+  if (simple_type != nullptr) {
+    auto signature_it = comparison_signatures_.find(signature_key);
+    if (signature_it != comparison_signatures_.end()) {
+      const FunctionSignature& signature = *signature_it->second;
+      *resolved_expr_out = MakeResolvedFunctionCall(
+          signature.result_type().type(), function, signature,
+          std::move(resolved_arguments), error_mode,
+          std::make_shared<ResolvedFunctionCallInfo>());
+      return ::zetasql_base::OkStatus();
+    }
+  }
+
+  ZETASQL_RETURN_IF_ERROR(ResolveFunctionCallWithResolvedArguments(
+      binary_expr,
+      ToLocations(absl::Span<const ASTExpression* const>(ast_arguments)),
+      function, error_mode, std::move(resolved_arguments), expr_resolution_info,
+      resolved_expr_out));
+  if (simple_type != nullptr &&
+      error_mode == ResolvedFunctionCallBase::DEFAULT_ERROR_MODE &&
+      IsReusableComparison(function, simple_type, **resolved_expr_out)) {
+    comparison_signatures_.emplace(
+        signature_key,
+        absl::make_unique<const FunctionSignature>(
+            (*resolved_expr_out)->GetAs<ResolvedFunctionCall>()->signature()));
+  }
+  return ::zetasql_base::OkStatus();
+}
+
 zetasql_base::Status Resolver::ResolveBitwiseShiftExpr(
     const ASTBitwiseShiftExpression* bitwise_shift_expr,
     ExprResolutionInfo* expr_resolution_info,
@@ -1978,8 +2116,8 @@ zetasql_base::Status Resolver::ResolveInSubquery(
       // column to the supertype.
       ResolvedColumnList target_columns;
       ZETASQL_RET_CHECK_EQ(1, resolved_name_list->num_columns());
-      target_columns.push_back(ResolvedColumn(
-          AllocateColumnId(), kInSubqueryCastId,
+      target_columns.push_back(AllocateColumn(
+          kInSubqueryCastId,
           resolved_name_list->column(0).column.name_id(),
           in_subquery_cast_type));
 
@@ -2028,19 +2166,53 @@ zetasql_base::Status Resolver::ResolveBetweenExpr(
   return ::zetasql_base::OkStatus();
 }
 
+// Returns the operands of the AND or OR expression <expr>, with the operands
+// of nested expressions of the same kind spliced in.  The parser already
+// flattens unparenthesized chains, so this flattens parenthesized ones like
+// "(a OR b) OR (c OR d)", which then resolve to a single n-ary $or call
+// rather than a tree of calls.  AND and OR are associative, so this does not
+// change the result.  Uses an explicit stack, so deeply nested input does not
+// recurse.
+template <class ExprType>
+static std::vector<const ASTExpression*> FlattenAssociativeOperands(
+    const ExprType* expr,
+    const absl::Span<const ASTExpression* const>& (ExprType::*operands)()
+        const) {
+  std::vector<const ASTExpression*> flattened;
+  // Operands still to be visited, in reverse order.
+  std::vector<const ASTExpression*> stack((expr->*operands)().rbegin(),
+                                          (expr->*operands)().rend());
+  while (!stack.empty()) {
+    const ASTExpression* operand = stack.back();
+    stack.pop_back();
+    if (operand->node_kind() == expr->node_kind()) {
+      const absl::Span<const ASTExpression* const>& nested =
+          (operand->GetAsOrDie<ExprType>()->*operands)();
+      stack.insert(stack.end(), nested.rbegin(), nested.rend());
+    } else {
+      flattened.push_back(operand);
+    }
+  }
+  return flattened;
+}
+
 zetasql_base::Status Resolver::ResolveAndExpr(
     const ASTAndExpr* and_expr, ExprResolutionInfo* expr_resolution_info,
     std::unique_ptr<const ResolvedExpr>* resolved_expr_out) {
+  const std::vector<const ASTExpression*> conjuncts =
+      FlattenAssociativeOperands(and_expr, &ASTAndExpr::conjuncts);
   return ResolveFunctionCallByNameWithoutAggregatePropertyCheck(
-      and_expr, "$and", and_expr->conjuncts(),
+      and_expr, "$and", conjuncts,
       *kEmptyArgumentOptionMap, expr_resolution_info, resolved_expr_out);
 }
 
 zetasql_base::Status Resolver::ResolveOrExpr(
     const ASTOrExpr* or_expr, ExprResolutionInfo* expr_resolution_info,
     std::unique_ptr<const ResolvedExpr>* resolved_expr_out) {
+  const std::vector<const ASTExpression*> disjuncts =
+      FlattenAssociativeOperands(or_expr, &ASTOrExpr::disjuncts);
   return ResolveFunctionCallByNameWithoutAggregatePropertyCheck(
-      or_expr, "$or", or_expr->disjuncts(),
+      or_expr, "$or", disjuncts,
       *kEmptyArgumentOptionMap, expr_resolution_info, resolved_expr_out);
 }
 
@@ -2989,7 +3161,11 @@ zetasql_base::Status Resolver::ResolveCastWithResolvedArgument(
     const Type* to_type,
     bool return_null_on_error,
     std::unique_ptr<const ResolvedExpr>* resolved_argument) {
-
+  // A cast to the same type is always valid, and is not added.  This is the
+  // common case after AddCastOrConvertLiteral() converted a literal.
+  if (to_type->Equals((*resolved_argument)->type())) {
+    return ::zetasql_base::OkStatus();
+  }
   if (IsValidExplicitCast(*resolved_argument, to_type)) {
     if (!to_type->Equals((*resolved_argument)->type())) {
       // Add EXPLICIT cast.
@@ -4140,8 +4316,8 @@ zetasql_base::Status Resolver::FinishResolvingAggregateFunction(
   // it out into <query_resolution_info->aggregate_columns_to_compute().
   // The actual ResolvedExpr we return is a ColumnRef pointing to that
   // function call.
-  ResolvedColumn aggregate_column(
-      AllocateColumnId(), kAggregateId, alias, resolved_agg_call->type());
+  ResolvedColumn aggregate_column =
+      AllocateColumn(kAggregateId, alias, resolved_agg_call->type());
 
   query_resolution_info->AddAggregateComputedColumn(
       ast_function_call, MakeResolvedComputedColumn(
@@ -4431,8 +4607,10 @@ zetasql_base::Status Resolver::LookupFunctionFromCatalog(
 
     stripped_name.remove_prefix(1);
     is_stripped = true;
-    find_status = catalog_->FindFunction(stripped_name, function,
-                                         analyzer_options_.find_options());
+    find_status = FindInCatalog("Function", stripped_name, [&] {
+      return catalog_->FindFunction(stripped_name, function,
+                                    analyzer_options_.find_options());
+    });
     if (find_status.ok()) {
       if (!(*function)->SupportsSafeErrorMode()) {
         return MakeSqlErrorAt(ast_location)
@@ -4442,8 +4620,10 @@ zetasql_base::Status Resolver::LookupFunctionFromCatalog(
       *error_mode = ResolvedFunctionCallBase::SAFE_ERROR_MODE;
     }
   } else {
-    find_status = catalog_->FindFunction(function_name_path, function,
-                                         analyzer_options_.find_options());
+    find_status = FindInCatalog("Function", function_name_path, [&] {
+      return catalog_->FindFunction(function_name_path, function,
+                                    analyzer_options_.find_options());
+    });
   }
 
   bool function_lookup_succeeded = find_status.ok();
@@ -54,6 +54,7 @@
 #include "zetasql/public/signature_match_result.h"
 #include "zetasql/public/strings.h"
 #include "zetasql/public/table_valued_function.h"
+#include "zetasql/public/tvf_signature_cache.h"
 #include "zetasql/public/type.h"
 #include "zetasql/public/type.pb.h"
 #include "zetasql/public/value.h"
@@ -78,6 +79,7 @@
 #include "zetasql/base/canonical_errors.h"
 #include "zetasql/base/ret_check.h"
 #include "zetasql/base/status.h"
+#include "zetasql/base/status_builder.h"
 #include "zetasql/base/status_macros.h"
 
 namespace zetasql {
@@ -147,6 +149,7 @@ zetasql_base::Status Resolver::ResolveQuery(
     bool is_outer_query,
     std::unique_ptr<const ResolvedScan>* output,
     std::shared_ptr<const NameList>* output_name_list) {
+  ZETASQL_RETURN_IF_ERROR(CheckCanContinueResolving(query));
 
   std::vector<std::unique_ptr<const ResolvedWithEntry>> with_entries;
 
@@ -633,9 +636,9 @@ void Resolver::AddColumnsForOrderByExprs(
         }
         const IdString order_column_alias =
             MakeIdString(absl::StrCat("$orderbycol", order_by_item_idx + 1));
-        ResolvedColumn resolved_column(AllocateColumnId(), query_alias,
-                                       order_column_alias,
-                                       item_info.order_expression->type());
+        ResolvedColumn resolved_column =
+            AllocateColumn(query_alias, order_column_alias,
+                           item_info.order_expression->type());
         item_info.order_column = resolved_column;
         computed_columns->emplace_back(MakeResolvedComputedColumn(
             item_info.order_column, std::move(item_info.order_expression)));
@@ -1220,10 +1223,9 @@ zetasql_base::Status Resolver::ResolveModelTransformSelectList(
              "ResolveModelTransformSelectList";
       const ResolvedColumnRef* resolved_col_ref =
           select_column_state->resolved_expr->GetAs<ResolvedColumnRef>();
-      const ResolvedColumn resolved_col_cp(
-          AllocateColumnId(), resolved_col_ref->column().table_name(),
-          select_column_state->alias.ToString(),
-          resolved_col_ref->column().type());
+      const ResolvedColumn resolved_col_cp = AllocateColumn(
+          resolved_col_ref->column().table_name_id(),
+          select_column_state->alias, resolved_col_ref->column().type());
       transform_list->push_back(MakeResolvedComputedColumn(
           resolved_col_cp,
           MakeResolvedColumnRef(resolved_col_ref->column().type(),
@@ -1390,9 +1392,9 @@ zetasql_base::Status Resolver::AnalyzeSelectColumnsToPrecomputeBeforeAggregation
         // The expression is not a simple column reference, it is a more
         // complicated expression that must be computed before aggregation
         // so that we can GROUP BY that computed column.
-        pre_group_by_column = ResolvedColumn(
-            AllocateColumnId(), kPreGroupById, select_column_state->alias,
-            select_column_state->resolved_expr->type());
+        pre_group_by_column =
+            AllocateColumn(kPreGroupById, select_column_state->alias,
+                           select_column_state->resolved_expr->type());
         // If the expression is a path expression then collect that
         // information in the QueryResolutionInfo so that we know that
         // accessing that path is valid post-GROUP BY, even if accessing
@@ -1571,9 +1573,9 @@ void Resolver::FinalizeSelectColumnStateList(
           resolved_expr->GetAs<ResolvedColumnRef>()->column();
       select_column_state->resolved_select_column = select_column;
     } else {
-      ResolvedColumn select_column(
-          AllocateColumnId(), query_alias, select_column_state->alias,
-          select_column_state->resolved_expr->type());
+      ResolvedColumn select_column =
+          AllocateColumn(query_alias, select_column_state->alias,
+                         select_column_state->resolved_expr->type());
       std::unique_ptr<ResolvedComputedColumn> resolved_computed_column =
           MakeResolvedComputedColumn(
               select_column, std::move(select_column_state->resolved_expr));
@@ -1862,8 +1864,8 @@ zetasql_base::Status Resolver::ResolveSelectDistinct(
       distinct_column = existing_computed_column->column();
     } else {
       // Create a new DISTINCT column.
-      distinct_column = ResolvedColumn(AllocateColumnId(), kDistinctId,
-                                       column.name_id(), column.type());
+      distinct_column =
+          AllocateColumn(kDistinctId, column.name_id(), column.type());
       // Add a computed column for the new post-DISTINCT column.
       query_resolution_info->AddGroupByComputedColumnIfNeeded(
           distinct_column, MakeColumnRef(column));
@@ -2180,10 +2182,8 @@ zetasql_base::Status Resolver::ResolveSelectDotStar(
   } else {
     // We resolved the DotStar to be derived from an expression.
     const Type* type = resolved_dotstar_expr->type();
-    const ResolvedColumn src_column(
-        AllocateColumnId(), kPreProjectId,
-        type->IsStruct() ? kStructId : kProtoId,
-        type);
+    const ResolvedColumn src_column = AllocateColumn(
+        kPreProjectId, type->IsStruct() ? kStructId : kProtoId, type);
 
     if (expr_resolution_info.has_analytic) {
       // The DotStar source expression contains analytic functions (and maybe
@@ -2250,6 +2250,55 @@ zetasql_base::Status Resolver::ResolveSelectDotStar(
   return ::zetasql_base::OkStatus();
 }
 
+zetasql_base::StatusOr<const std::vector<Resolver::StarExpansionField>*>
+Resolver::GetStarExpansion(const Type* type) {
+  auto it = star_expansions_.find(type);
+  if (it != star_expansions_.end()) {
+    return &it->second;
+  }
+
+  std::vector<StarExpansionField> fields;
+  if (type->IsStruct()) {
+    const StructType* struct_type = type->AsStruct();
+    fields.reserve(struct_type->num_fields());
+    for (int field_idx = 0; field_idx < struct_type->num_fields();
+         ++field_idx) {
+      const auto& struct_field = struct_type->field(field_idx);
+      StarExpansionField field;
+      field.name = MakeIdString((struct_field.name.empty())
+                                    ? absl::StrCat("$field", 1 + field_idx)
+                                    : struct_field.name);
+      field.type = struct_field.type;
+      field.field_index = field_idx;
+      fields.push_back(std::move(field));
+    }
+  } else {
+    ZETASQL_RET_CHECK(type->IsProto()) << type->DebugString();
+    const google::protobuf::Descriptor* proto_descriptor = type->AsProto()->descriptor();
+
+    // Proto fields are expanded in tag number order.
+    std::map<int32_t, const google::protobuf::FieldDescriptor*>
+        tag_number_ordered_field_map;
+    for (int proto_idx = 0; proto_idx < proto_descriptor->field_count();
+         ++proto_idx) {
+      const google::protobuf::FieldDescriptor* field = proto_descriptor->field(proto_idx);
+      ZETASQL_RET_CHECK(
+          zetasql_base::InsertIfNotPresent(&tag_number_ordered_field_map,
+                                  std::make_pair(field->number(), field)));
+    }
+    fields.reserve(tag_number_ordered_field_map.size());
+    for (const auto& entry : tag_number_ordered_field_map) {
+      StarExpansionField field;
+      field.name = MakeIdString(entry.second->name());
+      field.proto_field = entry.second;
+      field.type_status = GetProtoFieldTypeAndDefault(
+          entry.second, type_factory_, &field.type, &field.default_value);
+      fields.push_back(std::move(field));
+    }
+  }
+  return &star_expansions_.emplace(type, std::move(fields)).first->second;
+}
+
 // NOTE: The behavior of star expansion here must match
 // NameList::SelectStarHasColumn.
 zetasql_base::Status Resolver::AddColumnFieldsToSelectList(
@@ -2296,88 +2345,47 @@ zetasql_base::Status Resolver::AddColumnFieldsToSelectList(
     return ::zetasql_base::OkStatus();
   }
 
-  if (type->IsStruct()) {
-    const StructType* struct_type = type->AsStruct();
-
-    for (int field_idx = 0; field_idx < struct_type->num_fields();
-         ++field_idx) {
-      const auto& field = struct_type->field(field_idx);
-      const IdString field_name = MakeIdString(
-          (field.name.empty()) ? absl::StrCat("$field", 1 + field_idx)
-                               : field.name);
-
-      if ((excluded_field_names != nullptr &&
-           zetasql_base::ContainsKey(*excluded_field_names, field_name)) ||
-          ExcludeOrReplaceColumn(ast_expression, field_name,
-                                 column_replacements,
-                                 select_column_state_list)) {
-        continue;
-      }
-
-      // is_explicit=false because we're extracting all fields of a struct.
-      SelectColumnState* select_column_state =
-          select_column_state_list->AddSelectColumn(
-              ast_expression, field_name, false /* is_explicit */);
-      select_column_state->has_aggregation = src_column_has_aggregation;
-      select_column_state->has_analytic = src_column_has_analytic;
-      select_column_state->resolved_expr = MakeResolvedGetStructField(
-          field.type, CopyColumnRef(src_column_ref), field_idx);
-    }
-  } else {
-    const google::protobuf::Descriptor* proto_descriptor = type->AsProto()->descriptor();
-
-    std::map<int32_t, const google::protobuf::FieldDescriptor*>
-        tag_number_ordered_field_map;
-    for (int proto_idx = 0; proto_idx < proto_descriptor->field_count();
-         ++proto_idx) {
-      const google::protobuf::FieldDescriptor* field = proto_descriptor->field(proto_idx);
-      const IdString field_name = MakeIdString(field->name());
-      if (excluded_field_names != nullptr &&
-          zetasql_base::ContainsKey(*excluded_field_names, field_name)) {
-        continue;
-      }
-      ZETASQL_RET_CHECK(
-          zetasql_base::InsertIfNotPresent(&tag_number_ordered_field_map,
-                                  std::make_pair(field->number(), field)));
+  ZETASQL_ASSIGN_OR_RETURN(const std::vector<StarExpansionField>* fields,
+                   GetStarExpansion(type));
+  for (const StarExpansionField& field : *fields) {
+    if ((excluded_field_names != nullptr &&
+         zetasql_base::ContainsKey(*excluded_field_names, field.name)) ||
+        ExcludeOrReplaceColumn(ast_expression, field.name, column_replacements,
+                               select_column_state_list)) {
+      continue;
     }
 
-    for (const auto& entry : tag_number_ordered_field_map) {
-      const google::protobuf::FieldDescriptor* field = entry.second;
-
-      const IdString field_name = MakeIdString(field->name());
-      if (ExcludeOrReplaceColumn(ast_expression, field_name,
-                                 column_replacements,
-                                 select_column_state_list)) {
-        continue;
-      }
-
-      const Type* field_type;
-      Value default_value;
-      RETURN_SQL_ERROR_AT_IF_ERROR(
-          ast_expression,
-          GetProtoFieldTypeAndDefault(field, type_factory_,
-                                      &field_type, &default_value));
+    std::unique_ptr<const ResolvedExpr> field_expr;
+    if (field.proto_field == nullptr) {
+      field_expr = MakeResolvedGetStructField(
+          field.type, CopyColumnRef(src_column_ref), field.field_index);
+    } else {
+      RETURN_SQL_ERROR_AT_IF_ERROR(ast_expression, field.type_status);
       // TODO: This really should be check for
       // !field_type->IsSupportedType(language())
       // but that breaks existing tests :(
-      if (field_type->UsingFeatureV12CivilTimeType() &&
+      if (field.type->UsingFeatureV12CivilTimeType() &&
           !language().LanguageFeatureEnabled(FEATURE_V_1_2_CIVIL_TIME)) {
         return MakeSqlErrorAt(ast_expression)
-               << "Dot-star expansion includes field " << field_name
+               << "Dot-star expansion includes field " << field.name
                << " with unsupported type "
-               << field_type->TypeName(language().product_mode());
+               << field.type->TypeName(language().product_mode());
       }
-      // is_explicit=false because we're extracting all fields of a proto.
-      SelectColumnState* select_column_state =
-          select_column_state_list->AddSelectColumn(
-              ast_expression, field_name, false /* is_explicit */);
-      select_column_state->has_aggregation = src_column_has_aggregation;
-      select_column_state->has_analytic = src_column_has_analytic;
-      select_column_state->resolved_expr = MakeResolvedGetProtoField(
-          field_type, CopyColumnRef(src_column_ref), field, default_value,
-          false /* get_has_bit */, ProtoType::GetFormatAnnotation(field),
+      field_expr = MakeResolvedGetProtoField(
+          field.type, CopyColumnRef(src_column_ref), field.proto_field,
+          field.default_value, false /* get_has_bit */,
+          ProtoType::GetFormatAnnotation(field.proto_field),
           false /* return_default_value_when_unset */);
     }
+
+    // is_explicit=false because we're extracting all fields of a struct or
+    // proto.
+    SelectColumnState* select_column_state =
+        select_column_state_list->AddSelectColumn(
+            ast_expression, field.name, false /* is_explicit */);
+    select_column_state->has_aggregation = src_column_has_aggregation;
+    select_column_state->has_analytic = src_column_has_analytic;
+    select_column_state->resolved_expr = std::move(field_expr);
   }
   return ::zetasql_base::OkStatus();
 }
@@ -2541,9 +2549,9 @@ zetasql_base::Status Resolver::HandleGroupBySelectColumn(
     // expression.
     *group_by_column = existing_computed_column->column();
   } else {
-    *group_by_column = ResolvedColumn(
-        AllocateColumnId(), kGroupById, select_column_state->alias,
-        select_column_state->resolved_expr->type());
+    *group_by_column =
+        AllocateColumn(kGroupById, select_column_state->alias,
+                       select_column_state->resolved_expr->type());
   }
 
   *resolved_expr = std::move(select_column_state->resolved_expr);
@@ -2620,8 +2628,8 @@ zetasql_base::Status Resolver::HandleGroupByExpression(
           "$groupbycol",
           query_resolution_info->group_by_columns_to_compute().size() + 1));
     }
-    *group_by_column = ResolvedColumn(
-        AllocateColumnId(), kGroupById, alias, (*resolved_expr)->type());
+    *group_by_column =
+        AllocateColumn(kGroupById, alias, (*resolved_expr)->type());
   }
 
   // If the 'resolved_expr' is a path expression, we must collect
@@ -2914,9 +2922,9 @@ zetasql_base::Status Resolver::ResolveSelectColumnSecondPass(
             select_column_state->resolved_expr->
             GetAs<ResolvedColumnRef>()->column();
       } else {
-        ResolvedColumn select_column(
-            AllocateColumnId(), query_alias, select_column_state->alias,
-            select_column_state->resolved_expr->type());
+        ResolvedColumn select_column =
+            AllocateColumn(query_alias, select_column_state->alias,
+                           select_column_state->resolved_expr->type());
         query_resolution_info->select_list_columns_to_compute()->push_back(
             MakeResolvedComputedColumn(
                 select_column, std::move(select_column_state->resolved_expr)));
@@ -2970,24 +2978,17 @@ zetasql_base::Status Resolver::ResolveSelectColumnSecondPass(
         // Look at the QueryResolutionInfo to see if there is a GROUP BY
         // expression that exactly matches the ResolvedExpr from the
         // first pass resolution.
-        bool found_group_by_expression = false;
-        for (const std::unique_ptr<const ResolvedComputedColumn>&
-                 resolved_computed_column :
-             query_resolution_info->group_by_columns_to_compute()) {
-          if (IsSameExpressionForGroupBy(
-                  select_column_state->resolved_expr.get(),
-                  resolved_computed_column->expr())) {
-            // We matched this SELECT list expression to a GROUP BY
-            // expression.
-            // Update the select_column_state to point at the GROUP BY
-            // computed column.
-            select_column_state->resolved_select_column =
-                resolved_computed_column->column();
-            found_group_by_expression = true;
-            break;
-          }
-        }
-        if (!found_group_by_expression) {
+        const ResolvedComputedColumn* resolved_computed_column =
+            query_resolution_info->GetSameGroupByComputedColumnOrNull(
+                select_column_state->resolved_expr.get());
+        if (resolved_computed_column != nullptr) {
+          // We matched this SELECT list expression to a GROUP BY
+          // expression.
+          // Update the select_column_state to point at the GROUP BY
+          // computed column.
+          select_column_state->resolved_select_column =
+              resolved_computed_column->column();
+        } else {
           // TODO: Improve error message to say that expressions didn't
           // match.
           ZETASQL_RETURN_IF_ERROR(resolve_expr_status);
@@ -3000,9 +3001,8 @@ zetasql_base::Status Resolver::ResolveSelectColumnSecondPass(
             resolved_expr->GetAs<ResolvedColumnRef>()->column();
         select_column_state->resolved_select_column = select_column;
       } else {
-        ResolvedColumn select_column(AllocateColumnId(), query_alias,
-                                     select_column_state->alias,
-                                     resolved_expr->type());
+        ResolvedColumn select_column = AllocateColumn(
+            query_alias, select_column_state->alias, resolved_expr->type());
         std::unique_ptr<ResolvedComputedColumn> computed_column =
             MakeResolvedComputedColumn(select_column, std::move(resolved_expr));
         query_resolution_info->select_list_columns_to_compute()->push_back(
@@ -3154,8 +3154,8 @@ zetasql_base::Status Resolver::CreateStructFromNameList(
   }
   const StructType* struct_type;
   ZETASQL_RETURN_IF_ERROR(type_factory_->MakeStructType(fields, &struct_type));
-  const ResolvedColumn struct_column(
-      AllocateColumnId(), kMakeStructId, kStructId, struct_type);
+  const ResolvedColumn struct_column =
+      AllocateColumn(kMakeStructId, kStructId, struct_type);
 
   *computed_column = MakeResolvedComputedColumn(
       struct_column,
@@ -3194,8 +3194,8 @@ zetasql_base::Status Resolver::ConvertScanToProto(
       &arguments, &resolved_build_proto_expr));
 
   // Wrap resolved_query with a projection that creates the proto.
-  const ResolvedColumn proto_column(
-      AllocateColumnId(), kMakeProtoId, kProtoId, proto_type);
+  const ResolvedColumn proto_column =
+      AllocateColumn(kMakeProtoId, kProtoId, proto_type);
 
   *output_scan = MakeResolvedProjectScan(
       std::vector<ResolvedColumn>{proto_column},
@@ -3249,6 +3249,29 @@ static zetasql_base::Status GetSetScanEnumType(
 // Note that we allow set operations between value tables and regular
 // tables with exactly one column.  The output will be a value table if
 // the first subquery was a value table.
+namespace {
+
+// Hash and equality of the column types of set operation inputs, with the
+// equivalence of InputArgumentType::operator==.
+struct InputArgumentTypeListHasher {
+  size_t operator()(const std::vector<InputArgumentType>* types) const {
+    size_t hash = types->size();
+    for (const InputArgumentType& type : *types) {
+      hash = hash * 31 + InputArgumentTypeLossyHasher()(type);
+    }
+    return hash;
+  }
+};
+
+struct InputArgumentTypeListEq {
+  bool operator()(const std::vector<InputArgumentType>* types1,
+                  const std::vector<InputArgumentType>* types2) const {
+    return *types1 == *types2;
+  }
+};
+
+}  // namespace
+
 zetasql_base::Status Resolver::ResolveSetOperation(
     const ASTSetOperation* set_operation,
     const NameScope* scope,
@@ -3258,8 +3281,8 @@ zetasql_base::Status Resolver::ResolveSetOperation(
 
   std::vector<std::unique_ptr<ResolvedSetOperationItem>> resolved_inputs;
 
-  // Input types present for each column: column_type_lists[col_idx][scan_idx].
-  std::vector<std::vector<InputArgumentType>> column_type_lists;
+  // Input types present for each scan: input_type_lists[scan_idx][col_idx].
+  std::vector<std::vector<InputArgumentType>> input_type_lists;
   // Column names from the first subquery.  Output result will use these names.
   std::shared_ptr<const NameList> first_subquery_name_list;
 
@@ -3268,7 +3291,7 @@ zetasql_base::Status Resolver::ResolveSetOperation(
                             set_operation->GetSQLForOperation(),
                             " " /* old_sub */, "_" /* new_sub */))));
 
-  // Resolve all the input scans, and collect <column_type_lists>.
+  // Resolve all the input scans, and collect <input_type_lists>.
   for (int idx = 0; idx < set_operation->inputs().size(); ++idx) {
     const ASTQueryExpression* query_expr = set_operation->inputs()[idx];
     const IdString query_alias =
@@ -3281,7 +3304,6 @@ zetasql_base::Status Resolver::ResolveSetOperation(
 
     if (idx == 0) {  // First query in the set operation.
       first_subquery_name_list = name_list;
-      column_type_lists.resize(name_list->num_columns());
     }
 
     const auto& FormatColumnCount = [](const NameList& name_list) {
@@ -3291,7 +3313,7 @@ zetasql_base::Status Resolver::ResolveSetOperation(
                                 (name_list.num_columns() == 1 ? "" : "s"));
     };
 
-    if (name_list->num_columns() != column_type_lists.size()) {
+    if (name_list->num_columns() != first_subquery_name_list->num_columns()) {
       return MakeSqlErrorAt(query_expr)
              << "Queries in " << set_operation->GetSQLForOperation()
              << " have mismatched column count; query 1"
@@ -3301,6 +3323,9 @@ zetasql_base::Status Resolver::ResolveSetOperation(
 
     // Construct an InputArgumentType for each column in the name_list,
     // including literal values when present.
+    input_type_lists.emplace_back();
+    std::vector<InputArgumentType>& type_list = input_type_lists.back();
+    type_list.reserve(name_list->num_columns());
     for (int i = 0; i < name_list->num_columns(); ++i) {
       const ResolvedColumn& column = name_list->column(i).column;
 
@@ -3312,9 +3337,9 @@ zetasql_base::Status Resolver::ResolveSetOperation(
                                column);
       }
       if (expr != nullptr) {
-        column_type_lists[i].emplace_back(GetInputArgumentTypeForExpr(expr));
+        type_list.emplace_back(GetInputArgumentTypeForExpr(expr));
       } else {
-        column_type_lists[i].emplace_back(InputArgumentType(column.type()));
+        type_list.emplace_back(InputArgumentType(column.type()));
       }
     }
 
@@ -3328,20 +3353,42 @@ zetasql_base::Status Resolver::ResolveSetOperation(
   ResolvedSetOperationScan::SetOperationType op_type;
   ZETASQL_RETURN_IF_ERROR(GetSetScanEnumType(set_operation, &op_type));
 
+  // Generated queries often have many inputs with the same column types.
+  // The InputArgumentTypeSet of each column only keeps the first of equal
+  // types, so computing the supertypes from the first input of each distinct
+  // list of column types gives the same result.
+  std::vector<const std::vector<InputArgumentType>*> distinct_type_lists;
+  {
+    absl::flat_hash_set<const std::vector<InputArgumentType>*,
+                        InputArgumentTypeListHasher, InputArgumentTypeListEq>
+        seen_type_lists;
+    for (const std::vector<InputArgumentType>& type_list : input_type_lists) {
+      if (seen_type_lists.insert(&type_list).second) {
+        distinct_type_lists.push_back(&type_list);
+      }
+    }
+  }
+
   // Compute common supertypes and final column_list names for the set
   // operation.
   ResolvedColumnList column_list;
   std::shared_ptr<NameList> name_list(new NameList);
-  for (int i = 0; i < column_type_lists.size(); ++i) {
-    const std::vector<InputArgumentType>& type_list = column_type_lists[i];
+  for (int i = 0; i < first_subquery_name_list->num_columns(); ++i) {
     const ASTNode* ast_input_location = set_operation->inputs()[1];
 
     InputArgumentTypeSet type_set;
-    for (const InputArgumentType& type : type_list) {
-      type_set.Insert(type);
+    for (const std::vector<InputArgumentType>* type_list :
+         distinct_type_lists) {
+      type_set.Insert((*type_list)[i]);
     }
     const Type* supertype = coercer_.GetCommonSuperType(type_set);
     if (supertype == nullptr) {
+      std::vector<InputArgumentType> column_types;
+      column_types.reserve(input_type_lists.size());
+      for (const std::vector<InputArgumentType>& type_list :
+           input_type_lists) {
+        column_types.push_back(type_list[i]);
+      }
       // We location in set_operation points at the start of the first query,
       // because of how the grammar is expressed, I think.
       // Point at the start of the second query so the error is close to the
@@ -3350,7 +3397,7 @@ zetasql_base::Status Resolver::ResolveSetOperation(
              << "Column " << (i + 1) << " in "
              << set_operation->GetSQLForOperation()
              << " has incompatible types: "
-             << InputArgumentType::ArgumentsToString(type_list);
+             << InputArgumentType::ArgumentsToString(column_types);
     }
 
     std::string no_grouping_type;
@@ -3367,8 +3414,7 @@ zetasql_base::Status Resolver::ResolveSetOperation(
         first_subquery_name_list->column(i);
     const IdString name = first_subquery_named_column.name;
 
-    column_list.push_back(ResolvedColumn(
-        AllocateColumnId(), op_type_str, name, supertype));
+    column_list.push_back(AllocateColumn(op_type_str, name, supertype));
 
     ZETASQL_RETURN_IF_ERROR(name_list->AddColumn(
         name, column_list.back(), first_subquery_named_column.is_explicit));
@@ -3610,9 +3656,8 @@ zetasql_base::Status Resolver::CreateWrapperScanWithCasts(
                 ast_location, target_type, scan->get(),
                 false /* set_has_explicit_type */,
                 false /* return_null_on_error */, &casted_expr));
-        const ResolvedColumn casted_column(
-            AllocateColumnId(), scan_alias, scan_column.name_id(),
-            target_column_list[i].type());
+        const ResolvedColumn casted_column = AllocateColumn(
+            scan_alias, scan_column.name_id(), target_column_list[i].type());
 
         // These casted columns should not get pruned.  We wouldn't create them
         // if they weren't required for the query.
@@ -3704,6 +3749,8 @@ zetasql_base::Status Resolver::ResolveTableExpression(
     const NameScope* local_scope,
     std::unique_ptr<const ResolvedScan>* output,
     std::shared_ptr<const NameList>* output_name_list) {
+  ZETASQL_RETURN_IF_ERROR(CheckCanContinueResolving(table_expr));
+
   switch (table_expr->node_kind()) {
     case AST_TABLE_PATH_EXPRESSION:
       return ResolveTablePathExpression(
@@ -3931,8 +3978,8 @@ zetasql_base::Status Resolver::ResolveTablePathExpression(
     std::vector<ResolvedColumn> resolved_columns;
     if (tvf_relation->is_value_table()) {
       ZETASQL_RET_CHECK_EQ(1, tvf_relation->num_columns());
-      resolved_columns.push_back(ResolvedColumn(
-          AllocateColumnId(), path_expr->first_name()->GetAsIdString(),
+      resolved_columns.push_back(AllocateColumn(
+          path_expr->first_name()->GetAsIdString(),
           kValueColumnId, tvf_relation->column(0).type));
       ZETASQL_RETURN_IF_ERROR(new_name_list->AddValueTableColumn(
           alias, resolved_columns[0], table_ref));
@@ -3940,8 +3987,7 @@ zetasql_base::Status Resolver::ResolveTablePathExpression(
     } else {
       resolved_columns.reserve(tvf_relation->num_columns());
       for (const TVFRelation::Column& column : tvf_relation->columns()) {
-        resolved_columns.push_back(ResolvedColumn(
-            AllocateColumnId(),
+        resolved_columns.push_back(AllocateColumn(
             id_string_pool_->Make(path_expr->first_name()->GetAsString()),
             id_string_pool_->Make(column.name), column.type));
         ZETASQL_RETURN_IF_ERROR(new_name_list->AddColumn(
@@ -4151,8 +4197,7 @@ zetasql_base::Status Resolver::ResolveTablesampleClause(
         (with_weight_alias == nullptr ? kWeightAlias
                                       : with_weight_alias->GetAsIdString());
 
-    const ResolvedColumn column(
-        AllocateColumnId(),
+    const ResolvedColumn column = AllocateColumn(
         /*table_name=*/kWeightId, /*name=*/weight_alias,
         type_factory_->get_double());
     weight_column = MakeResolvedColumnHolder(column);
@@ -4230,8 +4275,8 @@ zetasql_base::Status Resolver::ResolveWithSubqueryRef(
     new_column_alias = *found;
 
     column_list.emplace_back(
-        ResolvedColumn(AllocateColumnId(), with_subquery_info.unique_alias,
-                       new_column_alias, column.type()));
+        AllocateColumn(with_subquery_info.unique_alias, new_column_alias,
+                       column.type()));
     // Build mapping from WITH subquery column to the newly created column
     // for the WITH reference.
     old_column_to_new_column[column] = column_list.back();
@@ -4242,6 +4287,7 @@ zetasql_base::Status Resolver::ResolveWithSubqueryRef(
 
   // Make a new NameList pointing at the new ResolvedColumns.
   std::shared_ptr<NameList> name_list(new NameList);
+  name_list->ReserveColumns(with_subquery_info.name_list->num_columns());
   for (const NamedColumn& named_column :
            with_subquery_info.name_list->columns()) {
     const ResolvedColumn& old_column = named_column.column;
@@ -4318,8 +4364,8 @@ zetasql_base::Status Resolver::ResolveColumnInUsing(
           ast_identifier, &resolved_get_field));
 
       // Then create a new ResolvedColumn to store this result.
-      *found_column = ResolvedColumn(
-          AllocateColumnId(), MakeIdString(absl::StrCat("$join_", side_name)),
+      *found_column = AllocateColumn(
+          MakeIdString(absl::StrCat("$join_", side_name)),
           key_name, resolved_get_field->type());
 
       *compute_expr_for_found_column = std::move(resolved_get_field);
@@ -4442,9 +4488,8 @@ zetasql_base::Status Resolver::ResolveUsing(
           std::unique_ptr<const ResolvedExpr> coalesce_expr;
           ZETASQL_RETURN_IF_ERROR(MakeCoalesceExpr(using_key, {lhs_column, rhs_column},
                                            &coalesce_expr));
-          const ResolvedColumn coalesce_column(
-              AllocateColumnId(), kFullJoinId, key_name,
-              coalesce_expr->type());
+          const ResolvedColumn coalesce_column =
+              AllocateColumn(kFullJoinId, key_name, coalesce_expr->type());
           computed_columns->push_back(MakeResolvedComputedColumn(
               coalesce_column, std::move(coalesce_expr)));
           ZETASQL_RETURN_IF_ERROR(output_name_list->AddColumn(
@@ -4795,9 +4840,13 @@ zetasql_base::Status Resolver::ResolveTVF(
   const std::string tvf_name_string = ast_tvf->name()->ToIdentifierPathString();
   const IdString tvf_name_idstring = MakeIdString(tvf_name_string);
   const TableValuedFunction* tvf_catalog_entry = nullptr;
-  const zetasql_base::Status find_status = catalog_->FindTableValuedFunction(
-      ast_tvf->name()->ToIdentifierVector(), &tvf_catalog_entry,
-      analyzer_options_.find_options());
+  const std::vector<std::string> tvf_path =
+      ast_tvf->name()->ToIdentifierVector();
+  const zetasql_base::Status find_status =
+      FindInCatalog("TableValuedFunction", tvf_path, [&] {
+        return catalog_->FindTableValuedFunction(
+            tvf_path, &tvf_catalog_entry, analyzer_options_.find_options());
+      });
   if (find_status.code() == zetasql_base::StatusCode::kNotFound) {
     std::string error_message;
     absl::StrAppend(&error_message,
@@ -4964,9 +5013,17 @@ zetasql_base::Status Resolver::ResolveTVF(
     analyzer_options.mutable_find_options()->set_cycle_detector(
         &owned_cycle_detector);
   }
-  const zetasql_base::Status resolve_status = tvf_catalog_entry->Resolve(
-      &analyzer_options, tvf_input_arguments, *result_signature, catalog_,
-      type_factory_, &tvf_signature);
+  TVFSignatureCache* tvf_signature_cache =
+      analyzer_options_.tvf_signature_cache();
+  const zetasql_base::Status resolve_status =
+      tvf_signature_cache != nullptr
+          ? tvf_signature_cache->Resolve(
+                *tvf_catalog_entry, &analyzer_options, language(),
+                tvf_input_arguments, *result_signature, catalog_,
+                type_factory_, &tvf_signature)
+          : tvf_catalog_entry->Resolve(&analyzer_options, tvf_input_arguments,
+                                       *result_signature, catalog_,
+                                       type_factory_, &tvf_signature);
 
   if (!resolve_status.ok()) {
     // The Resolve method returned an error status that is already updated
@@ -4999,13 +5056,14 @@ zetasql_base::Status Resolver::ResolveTVF(
   ResolvedColumnList column_list;
   std::shared_ptr<NameList> name_list(new NameList);
   column_list.reserve(tvf_signature->result_schema().num_columns());
+  name_list->ReserveColumns(tvf_signature->result_schema().num_columns());
   for (int i = 0; i < tvf_signature->result_schema().num_columns(); ++i) {
     const TVFRelation::Column& column =
         tvf_signature->result_schema().column(i);
     const IdString column_name = MakeIdString(
         !column.name.empty() ? column.name : absl::StrCat("$col", i));
-    column_list.push_back(ResolvedColumn(AllocateColumnId(), tvf_name_idstring,
-                                         column_name, column.type));
+    column_list.push_back(
+        AllocateColumn(tvf_name_idstring, column_name, column.type));
     if (column.is_pseudo_column) {
       ZETASQL_RETURN_IF_ERROR(
           name_list->AddPseudoColumn(column_name, column_list.back(), ast_tvf));
@@ -5364,10 +5422,10 @@ zetasql_base::Status Resolver::CoerceOrRearrangeTVFRelationArgColumns(
     if (result_type == nullptr) {
       new_column_list.push_back(provided_input_column);
     } else {
-      new_column_list.emplace_back(
-          AllocateColumnId(), new_project_alias,
+      new_column_list.push_back(AllocateColumn(
+          new_project_alias,
           resolved_tvf_arg->name_list->column(provided_col_idx).name,
-          result_type);
+          result_type));
       std::unique_ptr<const ResolvedExpr> resolved_cast(
           MakeColumnRef(provided_input_column, false /* is_correlated */));
       ZETASQL_RETURN_IF_ERROR(ResolveCastWithResolvedArgument(
@@ -5526,9 +5584,16 @@ zetasql_base::Status Resolver::ResolveArrayScan(
       const ASTPathExpression* path_expr =
           unnest->expression()->GetAs<ASTPathExpression>();
       const Table* table;
-      const zetasql_base::Status find_status =
-          catalog_->FindTable(path_expr->ToIdentifierVector(), &table,
-                              analyzer_options_.find_options());
+      zetasql_base::Status find_status;
+      {
+        // Only the code of a lookup failure is used.
+        zetasql_base::CodeOnlyErrorScope code_only_errors;
+        const std::vector<IdString> path = path_expr->ToIdStringVector();
+        find_status = FindInCatalog("Table", path, [&] {
+          return catalog_->FindTable(path, &table,
+                                     analyzer_options_.find_options());
+        });
+      }
       if (find_status.ok()) {
         return MakeSqlErrorAt(path_expr)
             << "UNNEST cannot be applied on a table: "
@@ -5567,10 +5632,9 @@ zetasql_base::Status Resolver::ResolveArrayScan(
   }
   ZETASQL_RET_CHECK(!alias.empty());
 
-  const ResolvedColumn array_element_column(
-        AllocateColumnId(),
-        kArrayId /* table_name */, alias /* column_name */,
-        value_type->AsArray()->element_type());
+  const ResolvedColumn array_element_column =
+      AllocateColumn(kArrayId /* table_name */, alias /* column_name */,
+                     value_type->AsArray()->element_type());
 
   ResolvedColumnList output_column_list;
   if (*resolved_input_scan != nullptr) {
@@ -5601,10 +5665,10 @@ zetasql_base::Status Resolver::ResolveArrayScan(
         (with_offset_alias == nullptr ? kOffsetAlias
                                       : with_offset_alias->GetAsIdString());
 
-    const ResolvedColumn column(
-        AllocateColumnId(),
-        kArrayOffsetId /* table_name */, offset_alias /* column_name */,
-        type_factory_->get_int64());
+    const ResolvedColumn column =
+        AllocateColumn(kArrayOffsetId /* table_name */,
+                       offset_alias /* column_name */,
+                       type_factory_->get_int64());
     array_position_column = MakeResolvedColumnHolder(column);
     output_column_list.push_back(array_position_column->column());
 
@@ -5719,7 +5783,16 @@ zetasql_base::Status Resolver::ResolveArrayScan(
 void Resolver::MaybeRecordParseLocation(const ASTNode* ast_location,
                                         ResolvedNode* resolved_node) const {
   if (analyzer_options_.record_parse_locations() && ast_location != nullptr) {
-    resolved_node->SetParseLocationRange(ast_location->GetParseLocationRange());
+    RecordParseLocation(ast_location->GetParseLocationRange(), resolved_node);
+  }
+}
+
+void Resolver::RecordParseLocation(const ParseLocationRange& range,
+                                   ResolvedNode* resolved_node) const {
+  if (parse_locations_ != nullptr) {
+    resolved_node->SetParseLocationId(parse_locations_->Add(range));
+  } else {
+    resolved_node->SetParseLocationRange(range);
   }
 }
 
@@ -5757,9 +5830,10 @@ zetasql_base::Status Resolver::ResolveModel(
     const ASTPathExpression* path_expr,
     std::unique_ptr<const ResolvedModel>* resolved_model) {
   const Model* model = nullptr;
-  const zetasql_base::Status find_status =
-      catalog_->FindModel(path_expr->ToIdentifierVector(), &model,
-                          analyzer_options_.find_options());
+  const std::vector<std::string> path = path_expr->ToIdentifierVector();
+  const zetasql_base::Status find_status = FindInCatalog("Model", path, [&] {
+    return catalog_->FindModel(path, &model, analyzer_options_.find_options());
+  });
 
   if (find_status.code() == zetasql_base::StatusCode::kNotFound) {
     return MakeSqlErrorAt(path_expr)
@@ -5771,6 +5845,24 @@ zetasql_base::Status Resolver::ResolveModel(
   return ::zetasql_base::OkStatus();
 }
 
+const Resolver::TableScanNames& Resolver::GetTableScanNames(
+    const Table* table) {
+  auto it = table_scan_names_.find(table);
+  if (it != table_scan_names_.end()) return it->second;
+
+  TableScanNames& names = table_scan_names_[table];
+  names.table_name = MakeIdString(table->Name());
+  names.column_names.reserve(table->NumColumns());
+  for (int i = 0; i < table->NumColumns(); ++i) {
+    IdString column_name = MakeIdString(table->GetColumn(i)->Name());
+    if (column_name.empty()) {
+      column_name = MakeIdString(absl::StrCat("$col", i + 1));
+    }
+    names.column_names.push_back(column_name);
+  }
+  return names;
+}
+
 zetasql_base::Status Resolver::ResolvePathExpressionAsTableScan(
     const ASTPathExpression* path_expr, IdString alias, bool has_explicit_alias,
     const ASTNode* alias_location, const ASTHint* hints,
@@ -5790,9 +5882,10 @@ zetasql_base::Status Resolver::ResolvePathExpressionAsTableScan(
   }
 
   const Table* table = nullptr;
-  const zetasql_base::Status find_status =
-      catalog_->FindTable(path_expr->ToIdentifierVector(), &table,
-                          analyzer_options_.find_options());
+  const std::vector<IdString> path = path_expr->ToIdStringVector();
+  const zetasql_base::Status find_status = FindInCatalog("Table", path, [&] {
+    return catalog_->FindTable(path, &table, analyzer_options_.find_options());
+  });
   if (find_status.code() == zetasql_base::StatusCode::kNotFound) {
     std::string error_message;
     absl::StrAppend(&error_message,
@@ -5821,24 +5914,28 @@ zetasql_base::Status Resolver::ResolvePathExpressionAsTableScan(
   ZETASQL_RETURN_IF_ERROR(find_status);
 
   ZETASQL_RET_CHECK(table != nullptr);
-  const IdString table_name = MakeIdString(table->Name());
+  const TableScanNames& names = GetTableScanNames(table);
+  const IdString table_name = names.table_name;
 
   const bool is_value_table = table->IsValueTable();
   if (is_value_table) {
     ZETASQL_RETURN_IF_ERROR(CheckValidValueTable(path_expr, table));
   }
 
+  const int num_columns = table->NumColumns();
+  ZETASQL_RET_CHECK_EQ(num_columns, names.column_names.size());
   ResolvedColumnList column_list;
+  column_list.reserve(num_columns);
   std::shared_ptr<NameList> name_list(new NameList);
-  for (int i = 0; i < table->NumColumns(); ++i) {
+  name_list->ReserveColumns(num_columns);
+  resolved_columns_from_table_scans_.reserve(
+      resolved_columns_from_table_scans_.size() + num_columns);
+  for (int i = 0; i < num_columns; ++i) {
     const Column* column = table->GetColumn(i);
-    IdString column_name = MakeIdString(column->Name());
-    if (column_name.empty()) {
-      column_name = MakeIdString(absl::StrCat("$col", i + 1));
-    }
+    const IdString column_name = names.column_names[i];
 
-    column_list.emplace_back(ResolvedColumn(AllocateColumnId(), table_name,
-                                            column_name, column->GetType()));
+    column_list.push_back(
+        AllocateColumn(table_name, column_name, column->GetType()));
     // Save the Catalog column for this ResolvedColumn so it can later be used
     // for checking column properties like Column::IsWritableColumn().
     resolved_columns_from_table_scans_[column_list.back()] = column;
@@ -93,6 +93,7 @@ zetasql_base::Status Resolver::ResolveStatement(
     absl::string_view sql, const ASTStatement* statement,
     std::unique_ptr<const ResolvedStatement>* output) {
   Reset(sql);
+  ZETASQL_RETURN_IF_ERROR(CheckCanContinueResolving(statement));
 
   std::unique_ptr<ResolvedStatement> stmt;
 
@@ -820,8 +821,8 @@ Resolver::ResolveColumnDefinitionNoCache(const ASTColumnDefinition* column,
   // Update column_name_list so that it can be used by the
   // ResolveGeneratedColumnInfo().
   const IdString column_name = column->name()->GetAsIdString();
-  ResolvedColumn defined_column(AllocateColumnId(), table_name_id_string,
-                                column_name, type);
+  ResolvedColumn defined_column =
+      AllocateColumn(table_name_id_string, column_name, type);
   ZETASQL_RETURN_IF_ERROR(column_name_list->AddColumn(column_name, defined_column,
                                               /* is_explicit = */ true));
 
@@ -1473,10 +1474,9 @@ zetasql_base::Status Resolver::ResolveCreateIndexStatement(
       ZETASQL_RETURN_IF_ERROR(ResolveScalarExpr(path_expression, &name_scope,
                                         /*clause_name=*/"INDEX Key Items",
                                         &resolved_expr));
-      ResolvedColumn resolved_column(
-              AllocateColumnId(), /*table_name=*/table_alias,
-              GetAliasForExpression(path_expression),
-              resolved_expr->type());
+      ResolvedColumn resolved_column = AllocateColumn(
+          /*table_name=*/table_alias, GetAliasForExpression(path_expression),
+          resolved_expr->type());
       resolved_computed_columns.push_back(
           MakeResolvedComputedColumn(
               resolved_column, std::move(resolved_expr)));
@@ -1610,8 +1610,7 @@ zetasql_base::Status Resolver::ResolveIndexUnnestExpressions(
     }
     ZETASQL_RET_CHECK(!alias_name.empty());
 
-    const ResolvedColumn array_element_column(
-        AllocateColumnId(),
+    const ResolvedColumn array_element_column = AllocateColumn(
         /*table_name=*/kArrayId, /*name=*/alias_name,
         unnest_expr_type->AsArray()->element_type());
     std::shared_ptr<NameList> new_name_list(new NameList);
@@ -1630,10 +1629,9 @@ zetasql_base::Status Resolver::ResolveIndexUnnestExpressions(
           (with_offset_alias == nullptr ? kOffsetAlias
                                         : with_offset_alias->GetAsIdString());
 
-      const ResolvedColumn column(AllocateColumnId(),
-                                  /*table_name=*/kArrayOffsetId,
-                                  /*name=*/offset_alias,
-                                  type_factory_->get_int64());
+      const ResolvedColumn column =
+          AllocateColumn(/*table_name=*/kArrayOffsetId, /*name=*/offset_alias,
+                         type_factory_->get_int64());
       array_position_column = MakeResolvedColumnHolder(column);
 
       // We add the offset column as a value table column so its name acts
@@ -1894,9 +1892,8 @@ zetasql_base::Status Resolver::ResolveCreateTableStatement(
       for (const auto& ddl_pseudo_column : ddl_pseudo_columns_map) {
         const IdString pseudo_column_name =
             MakeIdString(ddl_pseudo_column.first);
-        const ResolvedColumn pseudo_column(
-            AllocateColumnId(), table_name_id_string, pseudo_column_name,
-            ddl_pseudo_column.second);
+        const ResolvedColumn pseudo_column = AllocateColumn(
+            table_name_id_string, pseudo_column_name, ddl_pseudo_column.second);
         ZETASQL_RETURN_IF_ERROR(create_table_names.AddPseudoColumn(
             pseudo_column_name, pseudo_column, ast_statement));
         pseudo_column_list.push_back(pseudo_column);
@@ -1990,9 +1987,9 @@ zetasql_base::Status Resolver::ResolveQueryAndOutputColumns(
     output_column_list->push_back(
         MakeResolvedOutputColumn(column_name, named_column.column));
     if (column_definition_list != nullptr) {
-      ResolvedColumn defined_column(
-          AllocateColumnId(), table_name_id_string,
-          named_column.name, named_column.column.type());
+      ResolvedColumn defined_column =
+          AllocateColumn(table_name_id_string, named_column.name,
+                         named_column.column.type());
       column_definition_list->push_back(MakeResolvedColumnDefinition(
           column_name, named_column.column.type(),
           /* annotations = */ nullptr, /* is_hidden = */ false, defined_column,
@@ -2876,8 +2873,8 @@ zetasql_base::Status Resolver::CheckSQLBodyReturnTypesAndCoerceIfNeeded(
       if (provided_col_type->Equals(required_col_type)) {
         new_column_list.push_back(provided_col);
       } else {
-        new_column_list.emplace_back(AllocateColumnId(), new_project_alias,
-                                     provided_col.name_id(), required_col_type);
+        new_column_list.push_back(AllocateColumn(
+            new_project_alias, provided_col.name_id(), required_col_type));
         std::unique_ptr<const ResolvedExpr> resolved_cast =
             MakeColumnRef(provided_col, false /* is_correlated */);
         ZETASQL_RETURN_IF_ERROR(ResolveCastWithResolvedArgument(
@@ -3352,9 +3349,14 @@ zetasql_base::Status Resolver::ResolveCallStatement(
   const std::string name_string =
       ast_call->procedure_name()->ToIdentifierPathString();
   const Procedure* procedure_catalog_entry = nullptr;
-  const zetasql_base::Status find_status = catalog_->FindProcedure(
-      ast_call->procedure_name()->ToIdentifierVector(),
-      &procedure_catalog_entry, analyzer_options_.find_options());
+  const std::vector<std::string> procedure_path =
+      ast_call->procedure_name()->ToIdentifierVector();
+  const zetasql_base::Status find_status =
+      FindInCatalog("Procedure", procedure_path, [&] {
+        return catalog_->FindProcedure(procedure_path,
+                                       &procedure_catalog_entry,
+                                       analyzer_options_.find_options());
+      });
   if (find_status.code() == zetasql_base::StatusCode::kNotFound) {
     return MakeSqlErrorAt(ast_call->procedure_name())
         << "Procedure not found: " << name_string;
@@ -3916,7 +3918,7 @@ zetasql_base::Status Resolver::ResolveImportStatement(
       MakeResolvedImportStmt(kind, name_path, file_path, alias_path,
                              into_alias_path, std::move(resolved_options));
   if (analyzer_options_.record_parse_locations()) {
-    (*output)->SetParseLocationRange(import_path_location_range);
+    RecordParseLocation(import_path_location_range, output->get());
   }
   return ::zetasql_base::OkStatus();
 }
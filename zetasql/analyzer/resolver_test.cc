@@ -17,21 +17,29 @@
 #include "zetasql/analyzer/resolver.h"
 
 #include <memory>
+#include <set>
+#include <string>
+#include <vector>
 
 #include "zetasql/base/logging.h"
+#include "zetasql/base/atomic_sequence_num.h"
+#include "zetasql/analyzer/expr_resolver_helper.h"
 #include "zetasql/analyzer/name_scope.h"
 #include "zetasql/analyzer/query_resolver_helper.h"
 #include "zetasql/base/testing/status_matchers.h"
 #include "zetasql/parser/ast_node_kind.h"
 #include "zetasql/parser/parser.h"
+#include "zetasql/public/builtin_function.pb.h"
 #include "zetasql/public/simple_catalog.h"
 #include "zetasql/resolved_ast/resolved_node_kind.pb.h"
 #include "zetasql/testdata/error_catalog.h"
 #include "zetasql/testdata/sample_catalog.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
 
 namespace zetasql {
 
@@ -601,6 +609,190 @@ TEST_F(ResolverTest, TestResolveFunctions) {
                        "No matching signature for function SQRT");
 }
 
+TEST_F(ResolverTest, RepeatedFunctionCallsUseLiteralValues) {
+  auto resolve = [this](const std::string& expression,
+                        std::unique_ptr<const ResolvedExpr>* resolved) {
+    std::unique_ptr<ParserOutput> parser_output;
+    ZETASQL_ASSERT_OK(ParseExpression(expression, ParserOptions(), &parser_output));
+    ZETASQL_ASSERT_OK(ResolveExpr(parser_output->expression(), resolved));
+  };
+
+  // Repeated calls with the same argument types get the same signature.
+  std::unique_ptr<const ResolvedExpr> resolved;
+  for (int i = 0; i < 2; ++i) {
+    resolve("CAST(1 AS UINT64) + 1", &resolved);
+    EXPECT_TRUE(resolved->type()->IsUint64()) << resolved->DebugString();
+  }
+
+  // -1 cannot be coerced to UINT64, so the memoized signature for 1 must not
+  // be reused.
+  resolve("CAST(1 AS UINT64) + -1", &resolved);
+  EXPECT_FALSE(resolved->type()->IsUint64()) << resolved->DebugString();
+}
+
+TEST_F(ResolverTest, LongLiteralLists) {
+  const int kNumElements = 2000;
+  std::vector<std::string> elements;
+  for (int i = 0; i < kNumElements; ++i) {
+    // Mix INT64 and DOUBLE literals, so every INT64 literal is converted.
+    elements.push_back(i % 2 == 0 ? absl::StrCat(i) : absl::StrCat(i, ".5"));
+  }
+  const std::string list = absl::StrJoin(elements, ", ");
+
+  std::unique_ptr<ParserOutput> parser_output;
+  std::unique_ptr<const ResolvedExpr> resolved;
+  ZETASQL_ASSERT_OK(ParseExpression(absl::StrCat("1 IN (", list, ")"),
+                            ParserOptions(), &parser_output));
+  ZETASQL_ASSERT_OK(ResolveExpr(parser_output->expression(), &resolved));
+  ASSERT_EQ(RESOLVED_FUNCTION_CALL, resolved->node_kind());
+  const ResolvedFunctionCall* in_call = resolved->GetAs<ResolvedFunctionCall>();
+  EXPECT_EQ("$in", in_call->function()->Name());
+  ASSERT_EQ(kNumElements + 1, in_call->argument_list_size());
+  for (const auto& argument : in_call->argument_list()) {
+    ASSERT_EQ(RESOLVED_LITERAL, argument->node_kind());
+    EXPECT_TRUE(argument->type()->IsDouble());
+  }
+
+  ZETASQL_ASSERT_OK(ParseExpression(absl::StrCat("[", list, "]"), ParserOptions(),
+                            &parser_output));
+  ZETASQL_ASSERT_OK(ResolveExpr(parser_output->expression(), &resolved));
+  ASSERT_EQ(RESOLVED_LITERAL, resolved->node_kind());
+  const Value& array = resolved->GetAs<ResolvedLiteral>()->value();
+  EXPECT_TRUE(array.type()->AsArray()->element_type()->IsDouble());
+  ASSERT_EQ(kNumElements, array.num_elements());
+  EXPECT_EQ(Value::Double(1.5), array.element(1));
+}
+
+TEST_F(ResolverTest, RepeatedComparisonsResolveAlike) {
+  // The second resolution of each comparison reuses the signature of the
+  // first if both arguments have the same simple type, and must give the
+  // same tree as the first.
+  const std::vector<std::string> comparisons = {
+      "1 = 2", "1 != 2", "'a' < 'b'", "1.5 >= 2.5", "b'x' <> b'y'",
+      "DATE '2019-01-01' <= DATE '2019-01-02'", "1 = NULL", "1 < 2.5",
+      "NULL = NULL"};
+  for (int i = 0; i < 2; ++i) {
+    for (const std::string& comparison : comparisons) {
+      std::unique_ptr<ParserOutput> parser_output;
+      std::unique_ptr<const ResolvedExpr> first;
+      std::unique_ptr<const ResolvedExpr> second;
+      ZETASQL_ASSERT_OK(ParseExpression(comparison, ParserOptions(), &parser_output));
+      ZETASQL_ASSERT_OK(ResolveExpr(parser_output->expression(), &first));
+      ZETASQL_ASSERT_OK(ResolveExpr(parser_output->expression(), &second));
+      EXPECT_EQ(first->DebugString(), second->DebugString()) << comparison;
+      ASSERT_EQ(RESOLVED_FUNCTION_CALL, second->node_kind()) << comparison;
+      EXPECT_TRUE(second->type()->IsBool()) << comparison;
+    }
+  }
+
+  std::unique_ptr<ParserOutput> parser_output;
+  std::unique_ptr<const ResolvedExpr> resolved;
+  ZETASQL_ASSERT_OK(ParseExpression("1 = 2", ParserOptions(), &parser_output));
+  ZETASQL_ASSERT_OK(ResolveExpr(parser_output->expression(), &resolved));
+  const ResolvedFunctionCall* call = resolved->GetAs<ResolvedFunctionCall>();
+  EXPECT_EQ("$equal", call->function()->Name());
+  EXPECT_EQ(FN_EQUAL, call->signature().context_id());
+}
+
+TEST_F(ResolverTest, ParenthesizedAndOrChainsAreFlattened) {
+  std::unique_ptr<ParserOutput> parser_output;
+  ZETASQL_ASSERT_OK(ParseExpression(
+      "((true OR false) OR (false OR (true OR false))) AND "
+      "(true AND (false OR true))",
+      ParserOptions(), &parser_output));
+  std::unique_ptr<const ResolvedExpr> resolved;
+  ZETASQL_ASSERT_OK(ResolveExpr(parser_output->expression(), &resolved));
+
+  ASSERT_EQ(RESOLVED_FUNCTION_CALL, resolved->node_kind());
+  const ResolvedFunctionCall* and_call =
+      resolved->GetAs<ResolvedFunctionCall>();
+  EXPECT_EQ("$and", and_call->function()->Name());
+  // The nested AND is spliced in, but the OR inside it is not.
+  ASSERT_EQ(3, and_call->argument_list_size()) << resolved->DebugString();
+  const ResolvedFunctionCall* or_call =
+      and_call->argument_list(0)->GetAs<ResolvedFunctionCall>();
+  EXPECT_EQ("$or", or_call->function()->Name());
+  EXPECT_EQ(5, or_call->argument_list_size()) << resolved->DebugString();
+  EXPECT_EQ(3, resolved->GetTreeDepth()) << resolved->DebugString();
+}
+
+TEST_F(ResolverTest, SameExpressionsForGroupByHashAlike) {
+  // Pairs of expressions resolved separately, and whether they are the same
+  // for GROUP BY.
+  const std::vector<std::pair<std::string, bool>> expressions = {
+      {"1 + 2", true},
+      {"CAST(1.5 AS STRING)", true},
+      {"SAFE_CAST('1' AS INT64)", true},
+      {"CONCAT('a', 'b', 'c')", true},
+      {"IF(TRUE, NULL, 1.5)", true},
+      {"RAND()", false},
+      {"[1, 2, 3]", true},
+  };
+  for (const auto& expression : expressions) {
+    std::unique_ptr<ParserOutput> parser_output;
+    std::unique_ptr<const ResolvedExpr> first;
+    std::unique_ptr<const ResolvedExpr> second;
+    ZETASQL_ASSERT_OK(
+        ParseExpression(expression.first, ParserOptions(), &parser_output));
+    ZETASQL_ASSERT_OK(ResolveExpr(parser_output->expression(), &first));
+    ZETASQL_ASSERT_OK(ResolveExpr(parser_output->expression(), &second));
+    EXPECT_EQ(expression.second,
+              IsSameExpressionForGroupBy(first.get(), second.get()))
+        << expression.first;
+    if (expression.second) {
+      EXPECT_EQ(HashExpressionForGroupBy(first.get()),
+                HashExpressionForGroupBy(second.get()))
+          << expression.first;
+    }
+  }
+
+  std::unique_ptr<ParserOutput> parser_output;
+  std::unique_ptr<const ResolvedExpr> one_plus_two;
+  std::unique_ptr<const ResolvedExpr> two_plus_one;
+  ZETASQL_ASSERT_OK(ParseExpression("1 + 2", ParserOptions(), &parser_output));
+  ZETASQL_ASSERT_OK(ResolveExpr(parser_output->expression(), &one_plus_two));
+  ZETASQL_ASSERT_OK(ParseExpression("2 + 1", ParserOptions(), &parser_output));
+  ZETASQL_ASSERT_OK(ResolveExpr(parser_output->expression(), &two_plus_one));
+  EXPECT_FALSE(
+      IsSameExpressionForGroupBy(one_plus_two.get(), two_plus_one.get()));
+
+  absl::flat_hash_map<const ResolvedExpr*, int, GroupByExpressionHashOperator,
+                      GroupByExpressionEqualsOperator>
+      group_by_exprs;
+  group_by_exprs.emplace(one_plus_two.get(), 1);
+  group_by_exprs.emplace(two_plus_one.get(), 2);
+  EXPECT_EQ(2, group_by_exprs.size());
+  std::unique_ptr<const ResolvedExpr> lookup;
+  ZETASQL_ASSERT_OK(ResolveExpr(parser_output->expression(), &lookup));
+  ASSERT_TRUE(group_by_exprs.contains(lookup.get()));
+  EXPECT_EQ(2, group_by_exprs.at(lookup.get()));
+}
+
+TEST_F(ResolverTest, ColumnIdsAreReservedInBlocks) {
+  // Without a shared sequence, ids are dense and start at 1.
+  for (int i = 1; i <= 100; ++i) {
+    EXPECT_EQ(i, resolver_->AllocateColumnId());
+  }
+
+  zetasql_base::SequenceNumber sequence;
+  analyzer_options_.set_column_id_sequence_number(&sequence);
+  Resolver resolver1(sample_catalog_->catalog(), &type_factory_,
+                     &analyzer_options_);
+  Resolver resolver2(sample_catalog_->catalog(), &type_factory_,
+                     &analyzer_options_);
+  resolver1.Reset("" /* sql */);
+  resolver2.Reset("" /* sql */);
+  std::set<int> ids;
+  for (int i = 0; i < 10000; ++i) {
+    EXPECT_TRUE(ids.insert(resolver1.AllocateColumnId()).second);
+    EXPECT_TRUE(ids.insert(resolver2.AllocateColumnId()).second);
+  }
+  EXPECT_EQ(0, ids.count(0));
+  // Blocks are kept close to the number of ids used.
+  EXPECT_LT(*ids.rbegin(), 2 * 20000 + 2 * 4096);
+  analyzer_options_.set_column_id_sequence_number(nullptr);
+}
+
 TEST_F(ResolverTest, TestResolveAggregateExpressions) {
   ParseAndResolveFunction("Count(*)", "ZetaSQL:sum",
                           true /* is aggregation function */,
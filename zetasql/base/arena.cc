@@ -150,6 +150,7 @@ bool BaseArena::SatisfyAlignment(size_t alignment) {
     }
     freestart_ += waste;
     remaining_ -= waste;
+    ARENASET(status_.bytes_wasted_ += waste);
   }
   DCHECK_EQ(0, reinterpret_cast<size_t>(freestart_) & (alignment - 1));
   return true;
@@ -170,6 +171,7 @@ void BaseArena::Reset() {
 #endif
 
   ARENASET(status_.bytes_allocated_ = block_size_);
+  ARENASET(status_.bytes_wasted_ = 0);
 
   // There is no guarantee the first block is properly aligned, so
   // enforce that now.
@@ -186,6 +188,7 @@ void BaseArena::Reset() {
 // ----------------------------------------------------------------------
 
 void BaseArena::MakeNewBlock(const uint32_t alignment) {
+  ARENASET(status_.bytes_wasted_ += remaining_);
   AllocatedBlock *block = AllocNewBlock(block_size_, alignment);
   freestart_ = block->mem;
   remaining_ = block->size;
@@ -331,6 +334,7 @@ void* BaseArena::GetMemoryFallback(const size_t size, const int alignment) {
     // Use a block separate from all other allocations; in particular
     // we don't update last_alloc_ so you can't reclaim space on this block.
     AllocatedBlock* b = AllocNewBlock(size, alignment);
+    ARENASET(status_.bytes_wasted_ += b->size - size);
 #ifdef ADDRESS_SANITIZER
     ASAN_UNPOISON_MEMORY_REGION(b->mem, b->size);
 #endif
@@ -485,9 +489,39 @@ char* SafeArena::Realloc(char* original, size_t oldsize, size_t newsize) {
   return resized;
 }
 
+// ----------------------------------------------------------------------
+// RecyclingArena::Reset()
+// RecyclingArena::Realloc()
+//    Reset() drops the free lists along with the blocks they point into.
+//    Realloc() keeps the memory when the new size is in the same size
+//    class, and otherwise moves it and recycles the old memory.
+// ----------------------------------------------------------------------
+
+const size_t RecyclingArena::kMaxRecycledSize;
+
+void RecyclingArena::Reset() {
+  for (FreeChunk*& free_list : free_lists_) {
+    free_list = nullptr;
+  }
+  free_bytes_ = 0;
+  BaseArena::Reset();
+}
+
+char* RecyclingArena::Realloc(char* original, size_t oldsize, size_t newsize) {
+  if (oldsize > 0 && newsize > 0 && oldsize <= kMaxRecycledSize &&
+      newsize <= kMaxRecycledSize && SizeClass(oldsize) == SizeClass(newsize)) {
+    return original;
+  }
+  char* resized = Alloc(newsize);
+  memcpy(resized, original, oldsize < newsize ? oldsize : newsize);
+  Free(original, oldsize);
+  return resized;
+}
+
 // Avoid weak vtables by defining a dummy key method.
 void UnsafeArena::UnusedKeyMethod() {}
 void SafeArena::UnusedKeyMethod() {}
+void RecyclingArena::UnusedKeyMethod() {}
 void Gladiator::UnusedKeyMethod() {}
 
 }  // namespace zetasql_base
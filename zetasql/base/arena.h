@@ -286,11 +286,20 @@ class BaseArena {
    private:
     friend class BaseArena;
     size_t bytes_allocated_;
+    size_t bytes_wasted_;
    public:
-    Status() : bytes_allocated_(0) { }
+    Status() : bytes_allocated_(0), bytes_wasted_(0) { }
+    // Total size of the blocks the arena holds.
     size_t bytes_allocated() const {
       return bytes_allocated_;
     }
+    // Bytes of those blocks that can no longer be handed out: alignment
+    // padding, the unused tails of blocks the arena moved past, and the
+    // rounding of blocks allocated for large objects.  The bytes in use are
+    // bytes_allocated() - bytes_wasted() - bytes_until_next_allocation().
+    size_t bytes_wasted() const {
+      return bytes_wasted_;
+    }
   };
 
   // Accessors and stats counters
@@ -591,6 +600,124 @@ class SafeArena : public BaseArena {
   virtual void UnusedKeyMethod();  // Dummy key method to avoid weak vtable.
 };
 
+// A thread-compatible arena that recycles freed memory.  Allocations of up to
+// kMaxRecycledSize bytes are rounded up to a power-of-two size class, and
+// Free() puts them on the free list of their class, from which later
+// allocations of the class are served.  Larger allocations are not recycled,
+// as in UnsafeArena.  All memory is still released at once by Reset() or the
+// destructor.
+//
+// Use this arena for long-lived ArenaAllocator containers that grow and
+// shrink, which would otherwise keep extending an UnsafeArena:
+//   RecyclingArena arena(4096);
+//   std::vector<int, ArenaAllocator<int, RecyclingArena>> v(&arena);
+//
+// Free() must be passed the size allocated, as ArenaAllocator does.  Rounding
+// costs up to half of each allocation, so prefer UnsafeArena for memory that
+// is never freed.
+//
+// There is no per-thread cache of free memory: like UnsafeArena, this arena
+// is used by one thread at a time.
+class RecyclingArena : public BaseArena {
+ public:
+  static const size_t kMaxRecycledSize = size_t{1} << 16;
+
+  explicit RecyclingArena(const size_t block_size)
+    : BaseArena(nullptr, block_size, false) { }
+  RecyclingArena(char* first_block, const size_t block_size)
+    : BaseArena(first_block, block_size, false) { }
+
+  void Reset() override;
+
+  char* Alloc(const size_t size) {
+    return reinterpret_cast<char*>(AllocAligned(size, 1));
+  }
+  void* AllocAligned(const size_t size, const int align) {
+    if (size == 0 || size > kMaxRecycledSize) {
+      return GetMemory(size, align);
+    }
+    const int size_class = SizeClass(size);
+    FreeChunk* chunk = free_lists_[size_class];
+    if (chunk == nullptr || align > kDefaultAlignment) {
+      // Chunks are allocated aligned to at least kDefaultAlignment, so that
+      // they can serve any size in their class later.
+      return GetMemory(ClassSize(size_class),
+                       align > kDefaultAlignment ? align : kDefaultAlignment);
+    }
+    free_lists_[size_class] = chunk->next;
+    free_bytes_ -= ClassSize(size_class);
+    return chunk;
+  }
+  char* Calloc(const size_t size) {
+    void* return_value = Alloc(size);
+    memset(return_value, 0, size);
+    return reinterpret_cast<char*>(return_value);
+  }
+  void* CallocAligned(const size_t size, const int align) {
+    void* return_value = AllocAligned(size, align);
+    memset(return_value, 0, size);
+    return return_value;
+  }
+  // <size> must be the size <memory> was allocated with.
+  void Free(void* memory, size_t size) {
+    if (memory == nullptr || size == 0) return;
+    if (size > kMaxRecycledSize) {
+      ReturnMemory(memory, size);
+      return;
+    }
+    const int size_class = SizeClass(size);
+    FreeChunk* chunk = static_cast<FreeChunk*>(memory);
+    chunk->next = free_lists_[size_class];
+    free_lists_[size_class] = chunk;
+    free_bytes_ += ClassSize(size_class);
+  }
+  char* SlowAlloc(size_t size) override {  // "slow" 'cause it's virtual
+    return Alloc(size);
+  }
+  void SlowFree(void* memory, size_t size) override {
+    Free(memory, size);
+  }
+  char* SlowRealloc(char* memory, size_t old_size, size_t new_size) override {
+    return Realloc(memory, old_size, new_size);
+  }
+  char* Realloc(char* s, size_t oldsize, size_t newsize);
+
+  Status status() const { return status_; }
+
+  // Number of bytes remaining before the arena has to allocate another block.
+  size_t bytes_until_next_allocation() const { return remaining_; }
+
+  // Number of bytes on the free lists, waiting to be reused.
+  size_t bytes_free() const { return free_bytes_; }
+
+ private:
+  struct FreeChunk {
+    FreeChunk* next;
+  };
+
+  static const int kMinClassBits = 3;  // The smallest class holds a FreeChunk.
+  static const int kNumSizeClasses = 16 - kMinClassBits + 1;
+
+  // Returns the size class of allocations of <size> bytes.
+  // REQUIRES: 0 < size <= kMaxRecycledSize.
+  static int SizeClass(size_t size) {
+    if (size <= (size_t{1} << kMinClassBits)) return 0;
+    return 64 - __builtin_clzll(static_cast<uint64_t>(size - 1)) -
+           kMinClassBits;
+  }
+  static size_t ClassSize(int size_class) {
+    return size_t{1} << (size_class + kMinClassBits);
+  }
+
+  FreeChunk* free_lists_[kNumSizeClasses] = {};
+  size_t free_bytes_ = 0;
+
+  RecyclingArena(const RecyclingArena&) = delete;
+  RecyclingArena& operator=(const RecyclingArena&) = delete;
+
+  virtual void UnusedKeyMethod();  // Dummy key method to avoid weak vtable.
+};
+
 }  // namespace zetasql_base
 
 #endif  // THIRD_PARTY_ZETASQL_ZETASQL_BASE_ARENA_H_
@@ -905,6 +905,98 @@ TEST(ArenaTest, TestPoison) {
 
 //------------------------------------------------------------------------
 
+TEST(ArenaTest, BytesWasted) {
+  UnsafeArena arena(1024);
+  auto bytes_used = [&arena]() {
+    return arena.status().bytes_allocated() - arena.status().bytes_wasted() -
+           arena.bytes_until_next_allocation();
+  };
+  EXPECT_EQ(0, bytes_used());
+
+  arena.Alloc(1);
+  arena.AllocAligned(8, 8);  // 7 bytes of padding.
+  EXPECT_EQ(9, bytes_used());
+  EXPECT_EQ(7, arena.status().bytes_wasted());
+
+  for (int i = 0; i < 4; ++i) {
+    arena.Alloc(250);
+  }
+  EXPECT_EQ(1, arena.block_count());
+  EXPECT_EQ(1009, bytes_used());
+  // Does not fit in the rest of the first block, which is abandoned.
+  const size_t remaining = arena.bytes_until_next_allocation();
+  arena.Alloc(250);
+  EXPECT_EQ(2, arena.block_count());
+  EXPECT_EQ(7 + remaining, arena.status().bytes_wasted());
+  EXPECT_EQ(2048, arena.status().bytes_allocated());
+  EXPECT_EQ(1259, bytes_used());
+
+  // Large objects get blocks of their own, rounded up to the alignment.
+  arena.AllocAligned(1001, 8);
+  EXPECT_EQ(3, arena.block_count());
+  EXPECT_EQ(7 + remaining + 7, arena.status().bytes_wasted());
+  EXPECT_EQ(2260, bytes_used());
+
+  arena.Reset();
+  EXPECT_EQ(1, arena.block_count());
+  EXPECT_EQ(1024, arena.status().bytes_allocated());
+  EXPECT_EQ(0, bytes_used());
+}
+
+//------------------------------------------------------------------------
+
+TEST(ArenaTest, RecyclingArenaReusesFreedMemory) {
+  RecyclingArena arena(4096);
+  char* a = arena.Alloc(20);
+  char* b = arena.Alloc(30);
+  EXPECT_NE(a, b);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(b) % BaseArena::kDefaultAlignment);
+  arena.Free(a, 20);
+  EXPECT_EQ(32, arena.bytes_free());
+  // Any size in the class of <a> reuses it.
+  EXPECT_EQ(a, arena.Alloc(17));
+  EXPECT_EQ(0, arena.bytes_free());
+  arena.Free(b, 30);
+  EXPECT_NE(b, arena.Alloc(33));
+  EXPECT_EQ(b, arena.AllocAligned(32, 8));
+
+  // Realloc within a size class keeps the memory.
+  memcpy(a, "abcdefghijklmnopq", 17);
+  EXPECT_EQ(a, arena.Realloc(a, 17, 31));
+  char* c = arena.Realloc(a, 31, 100);
+  EXPECT_EQ(0, memcmp(c, "abcdefghijklmnopq", 17));
+  EXPECT_EQ(32, arena.bytes_free());
+
+  arena.Reset();
+  EXPECT_EQ(0, arena.bytes_free());
+  EXPECT_TRUE(arena.is_empty());
+}
+
+TEST(ArenaTest, RecyclingArenaAllocator) {
+  RecyclingArena arena(4096);
+  std::vector<int, ArenaAllocator<int, RecyclingArena>> v(&arena);
+  for (int round = 0; round < 100; ++round) {
+    for (int i = 0; i < 1000; ++i) {
+      v.push_back(i);
+    }
+    v.clear();
+    v.shrink_to_fit();
+  }
+  // Every round reuses the buffers freed by the previous one, so the arena
+  // holds about one round's worth of memory.
+  EXPECT_LT(arena.status().bytes_allocated(), 32 * 1024);
+
+  // Large allocations are not recycled.
+  const size_t bytes_free = arena.bytes_free();
+  const size_t large_size = RecyclingArena::kMaxRecycledSize + 1;
+  char* large = arena.Alloc(large_size);
+  arena.Free(large, large_size);
+  EXPECT_EQ(bytes_free, arena.bytes_free());
+  EXPECT_NE(large, arena.Alloc(large_size));
+}
+
+//------------------------------------------------------------------------
+
 template<class A>
 void TestStrndupUnterminated() {
   const char kFoo[3] = {'f', 'o', 'o'};
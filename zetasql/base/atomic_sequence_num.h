@@ -51,6 +51,13 @@ class SequenceNumber {
     return word_.fetch_add(1, std::memory_order_relaxed);
   }
 
+  // Reserves <n> consecutive sequence numbers with a single atomic operation
+  // and returns the first of them, as if by <n> calls to GetNext().  <n> must
+  // be positive.
+  Value GetNextBlock(Value n) {
+    return word_.fetch_add(n, std::memory_order_relaxed);
+  }
+
   // SequenceNumber is implemented as a class specifically to stop clients
   // from reading the value of word_ without also incrementing it.
   // Please do not add such a call.
@@ -19,12 +19,18 @@
 
 #include <stddef.h>
 #include <atomic>
+#include <cstdint>
 
 namespace zetasql_base {
 
 // Classes that wish to have thread-safe reference counting can simply inherit
 // from this SimpleReferenceCounted class.
 //
+// An object can also be created thread-confined, in which case its reference
+// count is updated without atomic read-modify-write operations. Only the
+// creating thread may take or drop references to such an object until
+// MakeShared() is called.
+//
 // SimpleReferenceCounted additionally provides some functions that are more
 // 'Subtle' than 'Simple':  RefCountIsOne() and OnRefCountIsZero().
 // These functions should be used with great care and only by classes that have
@@ -34,7 +40,11 @@ class SimpleReferenceCounted {
  public:
   // It is important that the ref_count_ is initialized to 1, so the caller
   // owns a reference.  The caller must eventually call Unref() to release it.
-  SimpleReferenceCounted() : ref_count_(1) {}
+  SimpleReferenceCounted() : ref_count_(1), thread_confined_(false) {}
+
+  // Creates a thread-confined object if <thread_confined> is true.
+  explicit SimpleReferenceCounted(bool thread_confined)
+      : ref_count_(1), thread_confined_(thread_confined) {}
 
   // We delete both the move constructor and copy constructor.
   // A move constructor or any function accepting an rvalue reference to a
@@ -61,17 +71,43 @@ class SimpleReferenceCounted {
 
   // Take possession of a reference on this, which must eventually be released
   // with Unref().
-  void Ref() const { ref_count_.fetch_add(1, std::memory_order_relaxed); }
+  void Ref() const {
+    if (thread_confined_) {
+      ref_count_.store(ref_count_.load(std::memory_order_relaxed) + 1,
+                       std::memory_order_relaxed);
+      return;
+    }
+    ref_count_.fetch_add(1, std::memory_order_relaxed);
+  }
 
   // Drop a reference on this, which ought to have been owned by the caller.
   // WARNING: Unref() may delete the object and it should not be touched once
   // a reference is no longer held.
   void Unref() const {
+    if (thread_confined_) {
+      const int32_t ref_count = ref_count_.load(std::memory_order_relaxed) - 1;
+      ref_count_.store(ref_count, std::memory_order_relaxed);
+      if (ref_count == 0) OnRefCountIsZero();
+      return;
+    }
     if (ref_count_.fetch_sub(1, std::memory_order_acq_rel) - 1 == 0) {
       OnRefCountIsZero();
     }
   }
 
+  // Returns true if this object is thread-confined.
+  bool IsThreadConfined() const { return thread_confined_; }
+
+  // Switches a thread-confined object to atomic reference counting, after
+  // which references to it may be passed to other threads. Must be called by
+  // the creating thread before the object is made visible to other threads,
+  // while only that thread holds references to it. Does nothing if the
+  // object is not thread-confined; in particular, it does not write to an
+  // object that other threads may be reading.
+  void MakeShared() const {
+    if (thread_confined_) thread_confined_ = false;
+  }
+
   // Returns true if the reference count is exactly 1
   //
   // Applications with a strong reference counting contract can use this value
@@ -165,6 +201,8 @@ class SimpleReferenceCounted {
 
  private:
   mutable std::atomic<int32_t> ref_count_;
+  // Only changed by MakeShared(), before the object is shared.
+  mutable bool thread_confined_;
 };
 
 }  // namespace zetasql_base
@@ -126,4 +126,27 @@ TEST(SimpleReferenceCounted, NineLives) {
   EXPECT_THAT(finalize_count, Eq(9));
 }
 
+// Tests that thread-confined objects count references the same way, and can
+// be made shared.
+TEST(SimpleReferenceCounted, ThreadConfined) {
+  SimpleReferenceCounted* shared = new SimpleReferenceCounted();
+  EXPECT_FALSE(shared->IsThreadConfined());
+  shared->Unref();
+
+  SimpleReferenceCounted* rc =
+      new SimpleReferenceCounted(/*thread_confined=*/true);
+  EXPECT_TRUE(rc->IsThreadConfined());
+  rc->Ref();
+  EXPECT_FALSE(rc->RefCountIsOne());
+  rc->Unref();
+  EXPECT_TRUE(rc->RefCountIsOne());
+
+  rc->Ref();
+  rc->MakeShared();
+  EXPECT_FALSE(rc->IsThreadConfined());
+  rc->Unref();
+  EXPECT_TRUE(rc->RefCountIsOne());
+  rc->Unref();
+}
+
 }  // namespace zetasql_base
@@ -40,28 +40,74 @@ std::ostream& operator<<(std::ostream& os, StatusCode code) {
   return os << StatusCodeToString(code);
 }
 
-Status::Status(StatusCode code, absl::string_view message)
-    : code_(code), message_(code == StatusCode::kOk ? "" : message) {}
+Status::Status(StatusCode code, absl::string_view message) {
+  if (code == StatusCode::kOk) return;
+  if (message.empty()) {
+    rep_ = InlineRep(code);
+    return;
+  }
+  HeapRep* rep = new HeapRep;
+  rep->ref_count.store(1, std::memory_order_relaxed);
+  rep->code = code;
+  rep->message = std::string(message);
+  rep_ = reinterpret_cast<uintptr_t>(rep);
+}
+
+void Status::UnrefHeapRep(HeapRep* rep) {
+  // Skip the atomic decrement for the common case of an unshared Status.
+  if (rep->ref_count.load(std::memory_order_acquire) == 1 ||
+      rep->ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    delete rep;
+  }
+}
+
+Status::HeapRep* Status::MutableHeapRep() {
+  if (!IsInline() && heap_rep()->ref_count.load(std::memory_order_acquire) == 1) {
+    return reinterpret_cast<HeapRep*>(rep_);
+  }
+  HeapRep* rep = new HeapRep;
+  rep->ref_count.store(1, std::memory_order_relaxed);
+  rep->code = code();
+  if (!IsInline()) {
+    rep->message = heap_rep()->message;
+    rep->payload = heap_rep()->payload;
+  }
+  Unref(rep_);
+  rep_ = reinterpret_cast<uintptr_t>(rep);
+  return rep;
+}
+
+bool Status::operator==(const Status& x) const {
+  if (rep_ == x.rep_) return true;
+  if (code() != x.code() || message() != x.message()) return false;
+  const bool has_payload = !IsInline() && !heap_rep()->payload.empty();
+  const bool x_has_payload = !x.IsInline() && !x.heap_rep()->payload.empty();
+  if (!has_payload || !x_has_payload) return has_payload == x_has_payload;
+  return heap_rep()->payload == x.heap_rep()->payload;
+}
 
 std::string Status::ToString() const {
-  return ok() ? "OK" : absl::StrCat(StatusCodeToString(code()), ": ", message_);
+  return ok() ? "OK" : absl::StrCat(StatusCodeToString(code()), ": ", message());
 }
 
 void Status::SetPayload(absl::string_view type_url, const StatusCord& payload) {
   if (!ok()) {
-    InsertOrUpdate(&payload_, std::string(type_url), payload);
+    InsertOrUpdate(&MutableHeapRep()->payload, std::string(type_url), payload);
   }
 }
 
 absl::optional<StatusCord> Status::GetPayload(
     absl::string_view type_url) const {
-  auto it = payload_.find(std::string(type_url));
-  if (it == payload_.end()) return absl::nullopt;
+  if (IsInline()) return absl::nullopt;
+  auto it = heap_rep()->payload.find(std::string(type_url));
+  if (it == heap_rep()->payload.end()) return absl::nullopt;
   return it->second;
 }
 
 void Status::ErasePayload(absl::string_view type_url) {
-  payload_.erase(std::string(type_url));
+  const std::string key(type_url);
+  if (IsInline() || heap_rep()->payload.count(key) == 0) return;
+  MutableHeapRep()->payload.erase(key);
 }
 
 std::ostream& operator<<(std::ostream& os, const Status& x) {
@@ -17,6 +17,9 @@
 #ifndef THIRD_PARTY_ZETASQL_ZETASQL_BASE_STATUS_H_
 #define THIRD_PARTY_ZETASQL_ZETASQL_BASE_STATUS_H_
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <ostream>
 #include <string>
 #include <unordered_map>
@@ -78,6 +81,11 @@ constexpr StatusCode DATA_LOSS = StatusCode::kDataLoss;
 
 class ABSL_MUST_USE_RESULT Status;
 
+// A Status is one word. OK and errors without a message or payloads are
+// encoded in that word and need no allocation, so returning a plain error
+// code from a hot function is as cheap as returning an int. Errors with a
+// message or payloads share a reference-counted representation, which is
+// copied when a shared Status is modified.
 class Status final {
  public:
   // Builds an OK Status.
@@ -88,8 +96,17 @@ class Status final {
   // an OK status is constructed.
   Status(StatusCode code, absl::string_view message);
 
+  Status(const Status& x) : rep_(x.rep_) { Ref(rep_); }
+  Status& operator=(const Status& x);
+  // A moved-from Status keeps its code but loses its message and payloads.
+  Status(Status&& x) noexcept : rep_(x.rep_) { x.rep_ = InlineRep(code()); }
+  Status& operator=(Status&& x) noexcept;
+  ~Status() { Unref(rep_); }
+
   // Return the error message (if any).
-  absl::string_view message() const { return message_; }
+  absl::string_view message() const {
+    return IsInline() ? absl::string_view() : heap_rep()->message;
+  }
 
   // Returns true if the Status is OK.
   ABSL_MUST_USE_RESULT bool ok() const;
@@ -128,7 +145,10 @@ class Status final {
   void IgnoreError() const;
 
   // Returns the stored status code.
-  StatusCode code() const { return code_; }
+  StatusCode code() const {
+    return IsInline() ? static_cast<StatusCode>(static_cast<intptr_t>(rep_) >> 1)
+                      : heap_rep()->code;
+  }
 
   // Retrieve a single value associated with `type_url`. Returns absl::nullopt
   // if no value is associated with `type_url`.
@@ -142,14 +162,63 @@ class Status final {
       const;
 
  private:
-  StatusCode code_ = StatusCode::kOk;
-  std::string message_;
-  // Structured error payload. String is a 'type_url' for example, a proto
-  // descriptor full name.
-  absl::node_hash_map<std::string, StatusCord> payload_;
+  // The representation of errors with a message or payloads.
+  struct HeapRep {
+    std::atomic<int32_t> ref_count;
+    StatusCode code;
+    std::string message;
+    // Structured error payload. String is a 'type_url' for example, a proto
+    // descriptor full name.
+    absl::node_hash_map<std::string, StatusCord> payload;
+  };
+
+  // rep_ is either a HeapRep*, or (code << 1) | 1 for a Status with only a
+  // code. HeapReps are aligned, so their low bit is 0.
+  static uintptr_t InlineRep(StatusCode code) {
+    return (static_cast<uintptr_t>(code) << 1) | 1;
+  }
+  static constexpr uintptr_t kOkRep = 1;
+
+  bool IsInline() const { return (rep_ & 1) != 0; }
+  const HeapRep* heap_rep() const {
+    return reinterpret_cast<const HeapRep*>(rep_);
+  }
+
+  static void Ref(uintptr_t rep) {
+    if ((rep & 1) == 0) {
+      reinterpret_cast<HeapRep*>(rep)->ref_count.fetch_add(
+          1, std::memory_order_relaxed);
+    }
+  }
+  static void Unref(uintptr_t rep) {
+    if ((rep & 1) == 0) UnrefHeapRep(reinterpret_cast<HeapRep*>(rep));
+  }
+  static void UnrefHeapRep(HeapRep* rep);
+
+  // Returns a HeapRep that this Status owns alone, creating or copying one if
+  // needed.
+  HeapRep* MutableHeapRep();
+
+  uintptr_t rep_ = kOkRep;
 };
 
-inline bool Status::ok() const { return StatusCode::kOk == code_; }
+inline Status& Status::operator=(const Status& x) {
+  Ref(x.rep_);
+  Unref(rep_);
+  rep_ = x.rep_;
+  return *this;
+}
+
+inline Status& Status::operator=(Status&& x) noexcept {
+  if (this != &x) {
+    Unref(rep_);
+    rep_ = x.rep_;
+    x.rep_ = InlineRep(code());
+  }
+  return *this;
+}
+
+inline bool Status::ok() const { return rep_ == kOkRep; }
 
 inline int Status::error_code() const { return static_cast<int>(code()); }
 
@@ -159,11 +228,6 @@ inline StatusCode Status::CanonicalCode() const { return code(); }
 
 inline Status Status::ToCanonical() const { return *this; }
 
-inline bool Status::operator==(const Status& x) const {
-  return (code_ == x.code_) && (message_ == x.message_) &&
-         (payload_ == x.payload_);
-}
-
 inline bool Status::operator!=(const Status& x) const { return !(*this == x); }
 
 inline void Status::IgnoreError() const {
@@ -173,7 +237,9 @@ inline void Status::IgnoreError() const {
 inline void Status::ForEachPayload(
     const std::function<void(absl::string_view, const StatusCord&)>& visitor)
     const {
-  for (auto it = payload_.begin(); it != payload_.end(); ++it) {
+  if (IsInline()) return;
+  for (auto it = heap_rep()->payload.begin(); it != heap_rep()->payload.end();
+       ++it) {
     visitor(it->first, it->second);
   }
 }
@@ -26,6 +26,8 @@
 
 namespace zetasql_base {
 
+thread_local bool CodeOnlyErrorScope::active_ = false;
+
 static void CopyStatusPayloads(const Status& from, Status* to) {
   from.ForEachPayload([to](absl::string_view type_url, StatusCord payload) {
       to->SetPayload(type_url, payload);});
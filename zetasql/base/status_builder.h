@@ -63,6 +63,34 @@ namespace zetasql_base {
 // - By default, the result status is not logged (but see `Log` method).
 // - All side effects (like logging) happen when the builder is converted to a
 //   status.
+// While a CodeOnlyErrorScope is alive on the current thread, StatusBuilders
+// ignore streamed messages and attached payloads, so the errors they build
+// have only a code and need no allocation or formatting.  Use it around calls
+// whose errors are only tested with ok() or code() and then dropped, such as
+// probing whether a literal converts to a type during signature matching:
+//
+//   {
+//     CodeOnlyErrorScope code_only_errors;
+//     if (ConvertStringToDate(str, &date).ok()) { ... }
+//   }
+//
+// Errors built in the scope must not be returned to callers that show them.
+// Scopes nest.
+class CodeOnlyErrorScope {
+ public:
+  CodeOnlyErrorScope() : previous_(active_) { active_ = true; }
+  CodeOnlyErrorScope(const CodeOnlyErrorScope&) = delete;
+  CodeOnlyErrorScope& operator=(const CodeOnlyErrorScope&) = delete;
+  ~CodeOnlyErrorScope() { active_ = previous_; }
+
+  // Returns true if a CodeOnlyErrorScope is alive on the current thread.
+  static bool IsActive() { return active_; }
+
+ private:
+  static thread_local bool active_;
+  const bool previous_;
+};
+
 class ABSL_MUST_USE_RESULT StatusBuilder {
  public:
   // Creates a `StatusBuilder` from an StatusCode.  If logging is enabled,
@@ -345,7 +373,7 @@ inline StatusBuilder& StatusBuilder::LogWithStackTrace(
 
 template <typename T>
 StatusBuilder& StatusBuilder::operator<<(const T& value) {
-  if (status_.ok()) return *this;
+  if (status_.ok() || CodeOnlyErrorScope::IsActive()) return *this;
   if (rep_ == nullptr) rep_.reset(new Rep());
   rep_->stream << value;
   return *this;
@@ -391,6 +419,7 @@ inline zetasql_base::SourceLocation StatusBuilder::source_location() const {
 // Returns `*this` to allow method chaining.
 template <typename T>
 StatusBuilder& StatusBuilder::Attach(const T& data) {
+  if (CodeOnlyErrorScope::IsActive()) return *this;
   AttachPayload<T>(&status_, data);
   return *this;
 }
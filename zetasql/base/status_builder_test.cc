@@ -203,6 +203,28 @@ TEST(StatusBuilderTest, MultiAttach) {
       Eq(StatusWithPayload(CANCELLED, "stick", "boom")));
 }
 
+TEST(StatusBuilderTest, CodeOnlyErrorScope) {
+  EXPECT_FALSE(CodeOnlyErrorScope::IsActive());
+  {
+    CodeOnlyErrorScope code_only_errors;
+    EXPECT_TRUE(CodeOnlyErrorScope::IsActive());
+    EXPECT_THAT(ToStatus(StatusBuilder(Cancelled(), kLoc)
+                             .Attach(MakePayloadProto("boom"))
+                         << "stick"),
+                Eq(Cancelled()));
+    {
+      CodeOnlyErrorScope nested;
+    }
+    EXPECT_TRUE(CodeOnlyErrorScope::IsActive());
+    // Messages already in the original status are kept.
+    EXPECT_THAT(ToStatus(StatusBuilder(AbortedError("hello"), kLoc) << "world"),
+                Eq(AbortedError("hello")));
+  }
+  EXPECT_FALSE(CodeOnlyErrorScope::IsActive());
+  EXPECT_THAT(ToStatus(StatusBuilder(Cancelled(), kLoc) << "booyah"),
+              Eq(CancelledError("booyah")));
+}
+
 TEST(StatusBuilderTest, BuilderOnNestedType) {
   static const char* const kError = "My custom error.";
   auto return_builder = []() -> StatusOr<StatusOr<int>> {
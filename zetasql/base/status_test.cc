@@ -226,4 +226,45 @@ TEST(Status, ForEachPayload_Multiple) {
   VisitAndAssertEquals(a, "type_b", "foo");
 }
 
+TEST(Status, OneWord) {
+  EXPECT_EQ(sizeof(void*), sizeof(Status));
+}
+
+TEST(Status, CodeOnlyWithPayload) {
+  Status a(StatusCode::kOutOfRange, "");
+  CheckStatus(a, StatusCode::kOutOfRange, "");
+  a.SetPayload("type_a", ToPayload("bar"));
+  CheckStatus(a, StatusCode::kOutOfRange, "", "type_a", "bar");
+  EXPECT_NE(Status(StatusCode::kOutOfRange, ""), a);
+  a.ErasePayload("type_a");
+  EXPECT_EQ(Status(StatusCode::kOutOfRange, ""), a);
+}
+
+TEST(Status, CopiesAreIndependent) {
+  Status a(StatusCode::kInternal, "msg");
+  a.SetPayload("type_a", ToPayload("bar"));
+  Status b = a;
+  b.SetPayload("type_b", ToPayload("foo"));
+  a.ErasePayload("type_a");
+  CheckStatus(a, StatusCode::kInternal, "msg");
+  EXPECT_EQ(ToPayload("bar"), b.GetPayload("type_a"));
+  EXPECT_EQ(ToPayload("foo"), b.GetPayload("type_b"));
+  EXPECT_EQ(absl::nullopt, a.GetPayload("type_b"));
+
+  Status c;
+  c = b;
+  b = Status(StatusCode::kAborted, "other");
+  EXPECT_EQ(ToPayload("foo"), c.GetPayload("type_b"));
+  CheckStatus(b, StatusCode::kAborted, "other");
+}
+
+TEST(Status, Move) {
+  Status a(StatusCode::kNotFound, "msg");
+  Status b = std::move(a);
+  CheckStatus(b, StatusCode::kNotFound, "msg");
+  Status c(StatusCode::kInternal, "other");
+  c = std::move(b);
+  CheckStatus(c, StatusCode::kNotFound, "msg");
+}
+
 }  // namespace zetasql_base
@@ -0,0 +1,273 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Benchmarks of parsing, analysis, SQLBuilder, Unparse and the Validator over
+// the queries of benchmark_queries.h.  Besides time and throughput, each
+// benchmark reports the heap allocations per query, counted by the global
+// operator new below.
+
+#include <stdlib.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "zetasql/benchmarks/benchmark_queries.h"
+#include "zetasql/parser/parser.h"
+#include "zetasql/public/analyzer.h"
+#include "zetasql/public/language_options.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "zetasql/resolved_ast/sql_builder.h"
+#include "zetasql/resolved_ast/validator.h"
+#include "zetasql/testdata/sample_catalog.h"
+#include "zetasql/testing/sql_workload_generator.h"
+#include "zetasql/base/status.h"
+#include "zetasql/base/statusor.h"
+
+namespace {
+std::atomic<int64_t> num_allocations{0};
+}  // namespace
+
+void* operator new(size_t size) {
+  num_allocations.fetch_add(1, std::memory_order_relaxed);
+  void* ptr = malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) throw std::bad_alloc();
+  return ptr;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { free(ptr); }
+
+namespace zetasql {
+namespace {
+
+LanguageOptions BenchmarkLanguageOptions() {
+  LanguageOptions language_options;
+  language_options.EnableMaximumLanguageFeatures();
+  return language_options;
+}
+
+SampleCatalog* GetSampleCatalog() {
+  static SampleCatalog* catalog = [] {
+    auto* catalog = new SampleCatalog(BenchmarkLanguageOptions());
+    SqlWorkloadGenerator::AddWorkloadFunctions(catalog->catalog());
+    return catalog;
+  }();
+  return catalog;
+}
+
+AnalyzerOptions BenchmarkAnalyzerOptions() {
+  return AnalyzerOptions(BenchmarkLanguageOptions());
+}
+
+// Counts the allocations of the timed loop of a benchmark, and reports them
+// and the throughput of <sql> when it goes out of scope.
+class BenchmarkReporter {
+ public:
+  BenchmarkReporter(benchmark::State* state, const std::string& sql)
+      : state_(state),
+        sql_(sql),
+        allocations_before_(
+            num_allocations.load(std::memory_order_relaxed)) {}
+  BenchmarkReporter(const BenchmarkReporter&) = delete;
+  BenchmarkReporter& operator=(const BenchmarkReporter&) = delete;
+
+  ~BenchmarkReporter() {
+    const int64_t allocations =
+        num_allocations.load(std::memory_order_relaxed) - allocations_before_;
+    state_->counters["allocs_per_query"] = benchmark::Counter(
+        allocations, benchmark::Counter::kAvgIterations);
+    state_->SetItemsProcessed(state_->iterations());
+    state_->SetBytesProcessed(state_->iterations() * sql_.size());
+  }
+
+ private:
+  benchmark::State* state_;
+  const std::string& sql_;
+  const int64_t allocations_before_;
+};
+
+// Analyzes <sql> outside of the timed loop, for the benchmarks of the
+// consumers of resolved ASTs.
+std::unique_ptr<const AnalyzerOutput> AnalyzeOrSkip(benchmark::State* state,
+                                                    const std::string& sql) {
+  TypeFactory type_factory;
+  std::unique_ptr<const AnalyzerOutput> output;
+  const zetasql_base::Status status =
+      AnalyzeStatement(sql, BenchmarkAnalyzerOptions(),
+                       GetSampleCatalog()->catalog(), &type_factory, &output);
+  if (!status.ok()) {
+    state->SkipWithError(status.ToString().c_str());
+    return nullptr;
+  }
+  return output;
+}
+
+void BM_ParseStatement(benchmark::State& state, const std::string& sql) {
+  const ParserOptions parser_options;
+  BenchmarkReporter reporter(&state, sql);
+  for (auto _ : state) {
+    std::unique_ptr<ParserOutput> output;
+    const zetasql_base::Status status =
+        ParseStatement(sql, parser_options, &output);
+    if (!status.ok()) {
+      state.SkipWithError(status.ToString().c_str());
+      break;
+    }
+    benchmark::DoNotOptimize(output);
+  }
+}
+
+void BM_AnalyzeStatement(benchmark::State& state, const std::string& sql) {
+  const AnalyzerOptions options = BenchmarkAnalyzerOptions();
+  SimpleCatalog* catalog = GetSampleCatalog()->catalog();
+  TypeFactory type_factory;
+  int64_t arena_bytes = 0;
+  {
+    BenchmarkReporter reporter(&state, sql);
+    for (auto _ : state) {
+      std::unique_ptr<const AnalyzerOutput> output;
+      const zetasql_base::Status status =
+          AnalyzeStatement(sql, options, catalog, &type_factory, &output);
+      if (!status.ok()) {
+        state.SkipWithError(status.ToString().c_str());
+        break;
+      }
+      const AnalyzerRuntimeInfo& info = output->runtime_info();
+      arena_bytes += info.parser_arena.bytes_allocated +
+                     info.resolver_arena.bytes_allocated;
+    }
+  }
+  state.counters["arena_bytes_per_query"] =
+      benchmark::Counter(arena_bytes, benchmark::Counter::kAvgIterations);
+}
+
+void BM_SQLBuilder(benchmark::State& state, const std::string& sql) {
+  std::unique_ptr<const AnalyzerOutput> output = AnalyzeOrSkip(&state, sql);
+  if (output == nullptr) return;
+  BenchmarkReporter reporter(&state, sql);
+  for (auto _ : state) {
+    SQLBuilder builder;
+    const zetasql_base::Status status =
+        builder.Process(*output->resolved_statement());
+    if (!status.ok()) {
+      state.SkipWithError(status.ToString().c_str());
+      break;
+    }
+    benchmark::DoNotOptimize(builder.sql());
+  }
+}
+
+void BM_Unparse(benchmark::State& state, const std::string& sql) {
+  std::unique_ptr<ParserOutput> output;
+  const zetasql_base::Status status =
+      ParseStatement(sql, ParserOptions(), &output);
+  if (!status.ok()) {
+    state.SkipWithError(status.ToString().c_str());
+    return;
+  }
+  BenchmarkReporter reporter(&state, sql);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Unparse(output->statement()));
+  }
+}
+
+void BM_Validator(benchmark::State& state, const std::string& sql) {
+  std::unique_ptr<const AnalyzerOutput> output = AnalyzeOrSkip(&state, sql);
+  if (output == nullptr) return;
+  BenchmarkReporter reporter(&state, sql);
+  for (auto _ : state) {
+    Validator validator(BenchmarkLanguageOptions());
+    const zetasql_base::Status status =
+        validator.ValidateResolvedStatement(output->resolved_statement());
+    if (!status.ok()) {
+      state.SkipWithError(status.ToString().c_str());
+      break;
+    }
+  }
+}
+
+// Analyzes a generated query whose <dimension> is state.range(0), with the
+// other dimensions at their defaults, for scaling curves.
+void BM_AnalyzeWorkload(benchmark::State& state,
+                        int SqlWorkloadOptions::*dimension) {
+  static const SqlWorkloadGenerator* generator = new SqlWorkloadGenerator(
+      SqlWorkloadGenerator::Create(*GetSampleCatalog()->catalog())
+          .ValueOrDie());
+  SqlWorkloadOptions options;
+  options.*dimension = state.range(0);
+  const zetasql_base::StatusOr<std::string> sql =
+      generator->GenerateQuery(options);
+  if (!sql.ok()) {
+    state.SkipWithError(sql.status().ToString().c_str());
+    return;
+  }
+  BM_AnalyzeStatement(state, sql.ValueOrDie());
+}
+
+// Registers each benchmark for each query of the corpus, as
+// <benchmark>/<query name>, and BM_AnalyzeWorkload for each dimension of
+// SqlWorkloadOptions, as BM_AnalyzeWorkload/<dimension>/<size>.
+void RegisterBenchmarks() {
+  using BenchmarkFunction = void (*)(benchmark::State&, const std::string&);
+  const std::pair<const char*, BenchmarkFunction> benchmarks[] = {
+      {"BM_ParseStatement", &BM_ParseStatement},
+      {"BM_AnalyzeStatement", &BM_AnalyzeStatement},
+      {"BM_SQLBuilder", &BM_SQLBuilder},
+      {"BM_Unparse", &BM_Unparse},
+      {"BM_Validator", &BM_Validator},
+  };
+  for (const auto& name_and_function : benchmarks) {
+    for (const BenchmarkQuery& query : BenchmarkQueries()) {
+      benchmark::RegisterBenchmark(
+          (std::string(name_and_function.first) + "/" + query.name).c_str(),
+          name_and_function.second, query.sql);
+    }
+  }
+
+  const std::pair<const char*, int SqlWorkloadOptions::*> dimensions[] = {
+      {"num_joins", &SqlWorkloadOptions::num_joins},
+      {"nesting_depth", &SqlWorkloadOptions::nesting_depth},
+      {"expression_width", &SqlWorkloadOptions::expression_width},
+      {"in_list_length", &SqlWorkloadOptions::in_list_length},
+      {"num_ctes", &SqlWorkloadOptions::num_ctes},
+      {"num_udf_calls", &SqlWorkloadOptions::num_udf_calls},
+  };
+  for (const auto& name_and_dimension : dimensions) {
+    benchmark::RegisterBenchmark(
+        (std::string("BM_AnalyzeWorkload/") + name_and_dimension.first)
+            .c_str(),
+        &BM_AnalyzeWorkload, name_and_dimension.second)
+        ->RangeMultiplier(4)
+        ->Range(1, 256);
+  }
+}
+
+}  // namespace
+}  // namespace zetasql
+
+int main(int argc, char** argv) {
+  zetasql::RegisterBenchmarks();
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
@@ -0,0 +1,83 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/benchmarks/benchmark_queries.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+
+namespace zetasql {
+
+// Joins KeyValue with itself <num_tables> times.
+static std::string JoinQuery(int num_tables) {
+  std::string sql = "SELECT t0.Key, t0.Value FROM KeyValue t0";
+  for (int i = 1; i < num_tables; ++i) {
+    absl::StrAppend(&sql, "\n  JOIN KeyValue t", i, " ON t", i - 1,
+                    ".Key = t", i, ".Key");
+  }
+  return sql;
+}
+
+// Filters KeyValue by an IN list of <num_terms> literals.
+static std::string InListQuery(int num_terms) {
+  std::string sql = "SELECT Key FROM KeyValue WHERE Key IN (";
+  for (int i = 0; i < num_terms; ++i) {
+    absl::StrAppend(&sql, i == 0 ? "" : ", ", i);
+  }
+  absl::StrAppend(&sql, ")");
+  return sql;
+}
+
+const std::vector<BenchmarkQuery>& BenchmarkQueries() {
+  static const std::vector<BenchmarkQuery>* queries =
+      new std::vector<BenchmarkQuery>{
+          {"point", "SELECT Key, Value FROM KeyValue WHERE Key = 5"},
+          {"aggregate",
+           "SELECT Value, COUNT(*) AS n, MAX(Key) AS max_key\n"
+           "FROM KeyValue\n"
+           "WHERE Value LIKE 'a%' AND Key BETWEEN 10 AND 100\n"
+           "GROUP BY Value\n"
+           "HAVING n > 1\n"
+           "ORDER BY n DESC\n"
+           "LIMIT 10"},
+          {"subqueries",
+           "WITH recent AS (\n"
+           "  SELECT Key, Value FROM KeyValue WHERE Key > 1000\n"
+           ")\n"
+           "SELECT r.Key,\n"
+           "       (SELECT COUNT(*) FROM KeyValue kv WHERE kv.Key < r.Key),\n"
+           "       ARRAY(SELECT Value FROM recent WHERE Key = r.Key)\n"
+           "FROM recent r\n"
+           "WHERE EXISTS (SELECT 1 FROM KeyValue WHERE Value = r.Value)\n"
+           "UNION ALL\n"
+           "SELECT Key, 0, [Value] FROM KeyValue"},
+          {"analytic",
+           "SELECT Key,\n"
+           "       SUM(Key) OVER (PARTITION BY Value ORDER BY Key\n"
+           "                      ROWS BETWEEN 2 PRECEDING AND CURRENT ROW),\n"
+           "       RANK() OVER (ORDER BY Key DESC)\n"
+           "FROM KeyValue"},
+          {"join_10", JoinQuery(10)},
+          {"join_100", JoinQuery(100)},
+          {"in_list_100", InListQuery(100)},
+          {"in_list_10000", InListQuery(10000)},
+      };
+  return *queries;
+}
+
+}  // namespace zetasql
@@ -0,0 +1,38 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_BENCHMARKS_BENCHMARK_QUERIES_H_
+#define ZETASQL_BENCHMARKS_BENCHMARK_QUERIES_H_
+
+#include <string>
+#include <vector>
+
+namespace zetasql {
+
+// A query to benchmark, over the tables of testdata/sample_catalog.h.
+struct BenchmarkQuery {
+  std::string name;
+  std::string sql;
+};
+
+// Returns the benchmark corpus, from tiny point queries to very large
+// generated ones.  The order and names are stable, so that results can be
+// compared across runs.
+const std::vector<BenchmarkQuery>& BenchmarkQueries();
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_BENCHMARKS_BENCHMARK_QUERIES_H_
@@ -0,0 +1,475 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Benchmarks of Values and of the function library.  The Value benchmarks run
+// once per TypeKind, and report Values per second.  The function benchmarks
+// run over kNumRows rows per iteration and report rows per second; those with
+// a columnar implementation have a _Scalar variant calling the row function
+// for each row and a _Batch variant calling the batch function once.
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "zetasql/public/cast.h"
+#include "zetasql/public/functions/batch_kernels.h"
+#include "zetasql/public/functions/date_time_util.h"
+#include "zetasql/public/functions/datetime.pb.h"
+#include "zetasql/public/language_options.h"
+#include "zetasql/public/numeric_value.h"
+#include "zetasql/public/strings.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/public/value.pb.h"
+#include "zetasql/public/value_batch.h"
+#include "zetasql/public/value_hash.h"
+#include "zetasql/testdata/test_schema.pb.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/time.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+namespace {
+
+constexpr int kNumRows = 1024;
+
+TypeFactory* GetTypeFactory() {
+  static TypeFactory* type_factory = new TypeFactory;
+  return type_factory;
+}
+
+// Returns two distinct Values of each TypeKind benchmarked, named by the
+// kind, with the first less than the second.
+const std::vector<std::pair<std::string, std::pair<Value, Value>>>&
+SampleValues() {
+  static const auto* values = [] {
+    TypeFactory* type_factory = GetTypeFactory();
+    const EnumType* enum_type;
+    ZETASQL_CHECK_OK(type_factory->MakeEnumType(zetasql_test::TestEnum_descriptor(),
+                                        &enum_type));
+    const ProtoType* proto_type;
+    ZETASQL_CHECK_OK(type_factory->MakeProtoType(
+        zetasql_test::KitchenSinkPB::descriptor(), &proto_type));
+    zetasql_test::KitchenSinkPB proto;
+    proto.set_int64_key_1(1);
+    proto.set_int64_key_2(2);
+    const StructType* struct_type;
+    ZETASQL_CHECK_OK(type_factory->MakeStructType(
+        {{"a", types::Int64Type()}, {"b", types::StringType()}},
+        &struct_type));
+    std::vector<int64_t> array_elements(100);
+    for (int i = 0; i < array_elements.size(); ++i) array_elements[i] = i;
+    std::vector<int64_t> larger_array_elements = array_elements;
+    larger_array_elements.back() = 1000;
+
+    return new std::vector<std::pair<std::string, std::pair<Value, Value>>>{
+        {"INT32", {Value::Int32(1), Value::Int32(2)}},
+        {"INT64", {Value::Int64(1), Value::Int64(2)}},
+        {"UINT32", {Value::Uint32(1), Value::Uint32(2)}},
+        {"UINT64", {Value::Uint64(1), Value::Uint64(2)}},
+        {"BOOL", {Value::Bool(false), Value::Bool(true)}},
+        {"FLOAT", {Value::Float(1.5f), Value::Float(2.5f)}},
+        {"DOUBLE", {Value::Double(1.5), Value::Double(2.5)}},
+        {"STRING_SHORT", {Value::String("abc"), Value::String("abd")}},
+        {"STRING_LONG",
+         {Value::String(std::string(1000, 'a')),
+          Value::String(std::string(1000, 'b'))}},
+        {"BYTES", {Value::Bytes("abc"), Value::Bytes("abd")}},
+        {"DATE", {Value::Date(17000), Value::Date(17001)}},
+        {"TIMESTAMP",
+         {Value::TimestampFromUnixMicros(1000000),
+          Value::TimestampFromUnixMicros(2000000)}},
+        {"TIME",
+         {Value::Time(TimeValue::FromHMSAndNanos(1, 2, 3, 4)),
+          Value::Time(TimeValue::FromHMSAndNanos(1, 2, 3, 5))}},
+        {"DATETIME",
+         {Value::Datetime(
+              DatetimeValue::FromYMDHMSAndNanos(2019, 1, 2, 3, 4, 5, 6)),
+          Value::Datetime(
+              DatetimeValue::FromYMDHMSAndNanos(2019, 1, 2, 3, 4, 5, 7))}},
+        {"NUMERIC",
+         {Value::Numeric(NumericValue(1)), Value::Numeric(NumericValue(2))}},
+        {"ENUM", {Value::Enum(enum_type, 0), Value::Enum(enum_type, 1)}},
+        {"PROTO",
+         {Value::Proto(proto_type, proto.SerializeAsString()),
+          Value::Proto(proto_type, proto.SerializeAsString())}},
+        {"STRUCT",
+         {Value::Struct(struct_type, {Value::Int64(1), Value::String("a")}),
+          Value::Struct(struct_type, {Value::Int64(1), Value::String("b")})}},
+        {"ARRAY",
+         {values::Int64Array(array_elements),
+          values::Int64Array(larger_array_elements)}},
+    };
+  }();
+  return *values;
+}
+
+void BM_ValueConstructAndCopy(benchmark::State& state, const Value& value) {
+  for (auto _ : state) {
+    Value copy = value;
+    benchmark::DoNotOptimize(copy);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_ValueHashCode(benchmark::State& state, const Value& value) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(value.HashCode());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_ValueLessThan(benchmark::State& state, const Value& value1,
+                      const Value& value2) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(value1.LessThan(value2));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_ValueSerialize(benchmark::State& state, const Value& value) {
+  ValueProto proto;
+  for (auto _ : state) {
+    ZETASQL_CHECK_OK(value.Serialize(&proto));
+    benchmark::DoNotOptimize(proto);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Reports kNumRows rows per iteration.
+void SetRowsProcessed(benchmark::State* state) {
+  state->SetItemsProcessed(state->iterations() * kNumRows);
+}
+
+std::vector<int64_t> Int64Column() {
+  std::vector<int64_t> column(kNumRows);
+  for (int i = 0; i < kNumRows; ++i) column[i] = i * 7919 - 100000;
+  return column;
+}
+
+std::vector<int32_t> DateColumn() {
+  std::vector<int32_t> column(kNumRows);
+  for (int i = 0; i < kNumRows; ++i) column[i] = 10000 + i * 37;
+  return column;
+}
+
+void BM_HashInt64_Scalar(benchmark::State& state) {
+  std::vector<Value> rows;
+  for (int64_t value : Int64Column()) rows.push_back(Value::Int64(value));
+  for (auto _ : state) {
+    for (const Value& value : rows) {
+      benchmark::DoNotOptimize(HashKeyValue(value));
+    }
+  }
+  SetRowsProcessed(&state);
+}
+BENCHMARK(BM_HashInt64_Scalar);
+
+void BM_HashInt64_Batch(benchmark::State& state) {
+  ValueBatch batch({types::Int64Type()});
+  for (int64_t value : Int64Column()) {
+    ZETASQL_CHECK_OK(batch.AppendRow({Value::Int64(value)}));
+  }
+  std::vector<uint64_t> hashes;
+  for (auto _ : state) {
+    HashBatchKeys(batch, {0}, /*seed=*/0, &hashes);
+    benchmark::DoNotOptimize(hashes.data());
+  }
+  SetRowsProcessed(&state);
+}
+BENCHMARK(BM_HashInt64_Batch);
+
+void BM_AddInt64_Scalar(benchmark::State& state) {
+  const std::vector<int64_t> in1 = Int64Column();
+  const std::vector<int64_t> in2 = Int64Column();
+  std::vector<int64_t> out(kNumRows);
+  for (auto _ : state) {
+    zetasql_base::Status error;
+    for (int i = 0; i < kNumRows; ++i) {
+      functions::Add(in1[i], in2[i], &out[i], &error);
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  SetRowsProcessed(&state);
+}
+BENCHMARK(BM_AddInt64_Scalar);
+
+void BM_AddInt64_Batch(benchmark::State& state) {
+  const std::vector<int64_t> in1 = Int64Column();
+  const std::vector<int64_t> in2 = Int64Column();
+  std::vector<int64_t> out(kNumRows);
+  for (auto _ : state) {
+    int64_t error_row;
+    zetasql_base::Status error;
+    functions::AddBatch(in1.data(), in2.data(), /*validity=*/nullptr, kNumRows,
+                        out.data(), &error_row, &error);
+    benchmark::DoNotOptimize(out.data());
+  }
+  SetRowsProcessed(&state);
+}
+BENCHMARK(BM_AddInt64_Batch);
+
+void BM_ExtractYearFromDate_Scalar(benchmark::State& state) {
+  const std::vector<int32_t> dates = DateColumn();
+  std::vector<int32_t> out(kNumRows);
+  for (auto _ : state) {
+    for (int i = 0; i < kNumRows; ++i) {
+      ZETASQL_CHECK_OK(functions::ExtractFromDate(functions::YEAR, dates[i], &out[i]));
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  SetRowsProcessed(&state);
+}
+BENCHMARK(BM_ExtractYearFromDate_Scalar);
+
+void BM_ExtractYearFromDate_Batch(benchmark::State& state) {
+  const std::vector<int32_t> dates = DateColumn();
+  std::vector<int32_t> out(kNumRows);
+  for (auto _ : state) {
+    int64_t error_row;
+    zetasql_base::Status error;
+    CHECK(functions::ExtractFromDateBatch(functions::YEAR, dates.data(),
+                                          /*validity=*/nullptr, kNumRows,
+                                          out.data(), &error_row, &error));
+    benchmark::DoNotOptimize(out.data());
+  }
+  SetRowsProcessed(&state);
+}
+BENCHMARK(BM_ExtractYearFromDate_Batch);
+
+void BM_AddMonthsToDate_Scalar(benchmark::State& state) {
+  const std::vector<int32_t> dates = DateColumn();
+  std::vector<int32_t> out(kNumRows);
+  for (auto _ : state) {
+    for (int i = 0; i < kNumRows; ++i) {
+      ZETASQL_CHECK_OK(functions::AddDate(dates[i], functions::MONTH, i % 24,
+                                  &out[i]));
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  SetRowsProcessed(&state);
+}
+BENCHMARK(BM_AddMonthsToDate_Scalar);
+
+void BM_AddMonthsToDate_Batch(benchmark::State& state) {
+  const std::vector<int32_t> dates = DateColumn();
+  std::vector<int64_t> intervals(kNumRows);
+  for (int i = 0; i < kNumRows; ++i) intervals[i] = i % 24;
+  std::vector<int32_t> out(kNumRows);
+  for (auto _ : state) {
+    int64_t error_row;
+    zetasql_base::Status error;
+    CHECK(functions::AddDateBatch(dates.data(), functions::MONTH,
+                                  intervals.data(), /*validity=*/nullptr,
+                                  kNumRows, out.data(), &error_row, &error));
+    benchmark::DoNotOptimize(out.data());
+  }
+  SetRowsProcessed(&state);
+}
+BENCHMARK(BM_AddMonthsToDate_Batch);
+
+void BM_FormatTimestamp(benchmark::State& state) {
+  std::string out;
+  for (auto _ : state) {
+    for (int i = 0; i < kNumRows; ++i) {
+      ZETASQL_CHECK_OK(functions::ConvertTimestampToStringWithoutTruncation(
+          int64_t{1500000000000000} + i * int64_t{3600000123},
+          functions::kMicroseconds, absl::UTCTimeZone(), &out));
+      benchmark::DoNotOptimize(out);
+    }
+  }
+  SetRowsProcessed(&state);
+}
+BENCHMARK(BM_FormatTimestamp);
+
+std::vector<NumericValue> NumericColumn() {
+  std::vector<NumericValue> column;
+  for (int i = 0; i < kNumRows; ++i) {
+    column.push_back(
+        NumericValue::FromDouble(i * 1.25 - 300).ValueOrDie());
+  }
+  return column;
+}
+
+void BM_NumericAdd(benchmark::State& state) {
+  const std::vector<NumericValue> values = NumericColumn();
+  for (auto _ : state) {
+    for (int i = 1; i < kNumRows; ++i) {
+      benchmark::DoNotOptimize(values[i].Add(values[i - 1]));
+    }
+  }
+  SetRowsProcessed(&state);
+}
+BENCHMARK(BM_NumericAdd);
+
+void BM_NumericMultiply(benchmark::State& state) {
+  const std::vector<NumericValue> values = NumericColumn();
+  for (auto _ : state) {
+    for (int i = 1; i < kNumRows; ++i) {
+      benchmark::DoNotOptimize(values[i].Multiply(values[i - 1]));
+    }
+  }
+  SetRowsProcessed(&state);
+}
+BENCHMARK(BM_NumericMultiply);
+
+void BM_NumericSum_Scalar(benchmark::State& state) {
+  const std::vector<NumericValue> values = NumericColumn();
+  for (auto _ : state) {
+    NumericValue::Aggregator aggregator;
+    for (const NumericValue& value : values) aggregator.Add(value);
+    benchmark::DoNotOptimize(aggregator.GetSum());
+  }
+  SetRowsProcessed(&state);
+}
+BENCHMARK(BM_NumericSum_Scalar);
+
+void BM_NumericSum_Batch(benchmark::State& state) {
+  const std::vector<NumericValue> values = NumericColumn();
+  for (auto _ : state) {
+    NumericValue::Aggregator aggregator;
+    aggregator.AddBatch(values);
+    benchmark::DoNotOptimize(aggregator.GetSum());
+  }
+  SetRowsProcessed(&state);
+}
+BENCHMARK(BM_NumericSum_Batch);
+
+// Casts kNumRows Values made by <make_value> to <to_type>.
+template <typename MakeValue>
+void CastBenchmark(benchmark::State* state, MakeValue make_value,
+                   const Type* to_type) {
+  std::vector<Value> values;
+  for (int i = 0; i < kNumRows; ++i) values.push_back(make_value(i));
+  const LanguageOptions language_options;
+  for (auto _ : *state) {
+    for (const Value& value : values) {
+      benchmark::DoNotOptimize(CastValue(value, absl::UTCTimeZone(),
+                                         language_options, to_type));
+    }
+  }
+  SetRowsProcessed(state);
+}
+
+void BM_CastInt64ToString(benchmark::State& state) {
+  CastBenchmark(
+      &state, [](int i) { return Value::Int64(i * 7919); },
+      types::StringType());
+}
+BENCHMARK(BM_CastInt64ToString);
+
+void BM_CastStringToInt64(benchmark::State& state) {
+  CastBenchmark(
+      &state, [](int i) { return Value::String(std::to_string(i * 7919)); },
+      types::Int64Type());
+}
+BENCHMARK(BM_CastStringToInt64);
+
+void BM_CastDoubleToNumeric(benchmark::State& state) {
+  CastBenchmark(
+      &state, [](int i) { return Value::Double(i * 1.25); },
+      types::NumericType());
+}
+BENCHMARK(BM_CastDoubleToNumeric);
+
+void BM_CastStringToDate(benchmark::State& state) {
+  CastBenchmark(
+      &state,
+      [](int i) {
+        return Value::String(absl::StrCat("20", 10 + i % 10, "-0", 1 + i % 9,
+                                          "-1", i % 10));
+      },
+      types::DateType());
+}
+BENCHMARK(BM_CastStringToDate);
+
+std::vector<std::string> StringColumn() {
+  std::vector<std::string> column;
+  for (int i = 0; i < kNumRows; ++i) {
+    column.push_back(absl::StrCat("row ", i, " it's a \"quoted\"\n\tvalue"));
+  }
+  return column;
+}
+
+void BM_ToStringLiteral(benchmark::State& state) {
+  const std::vector<std::string> strings = StringColumn();
+  for (auto _ : state) {
+    for (const std::string& str : strings) {
+      benchmark::DoNotOptimize(ToStringLiteral(str));
+    }
+  }
+  SetRowsProcessed(&state);
+}
+BENCHMARK(BM_ToStringLiteral);
+
+void BM_ToBytesLiteral(benchmark::State& state) {
+  const std::vector<std::string> strings = StringColumn();
+  for (auto _ : state) {
+    for (const std::string& str : strings) {
+      benchmark::DoNotOptimize(ToBytesLiteral(str));
+    }
+  }
+  SetRowsProcessed(&state);
+}
+BENCHMARK(BM_ToBytesLiteral);
+
+void BM_UnescapeString(benchmark::State& state) {
+  std::vector<std::string> escaped;
+  for (const std::string& str : StringColumn()) {
+    escaped.push_back(EscapeString(str));
+  }
+  std::string out;
+  for (auto _ : state) {
+    for (const std::string& str : escaped) {
+      ZETASQL_CHECK_OK(UnescapeString(str, &out));
+      benchmark::DoNotOptimize(out);
+    }
+  }
+  SetRowsProcessed(&state);
+}
+BENCHMARK(BM_UnescapeString);
+
+// Registers the Value benchmarks for each TypeKind, as
+// <benchmark>/<kind>.
+void RegisterValueBenchmarks() {
+  for (const auto& kind_and_values : SampleValues()) {
+    const std::string& kind = kind_and_values.first;
+    const Value& value1 = kind_and_values.second.first;
+    const Value& value2 = kind_and_values.second.second;
+    benchmark::RegisterBenchmark(
+        ("BM_ValueConstructAndCopy/" + kind).c_str(),
+        &BM_ValueConstructAndCopy, value1);
+    benchmark::RegisterBenchmark(("BM_ValueHashCode/" + kind).c_str(),
+                                 &BM_ValueHashCode, value1);
+    benchmark::RegisterBenchmark(("BM_ValueLessThan/" + kind).c_str(),
+                                 &BM_ValueLessThan, value1, value2);
+    benchmark::RegisterBenchmark(("BM_ValueSerialize/" + kind).c_str(),
+                                 &BM_ValueSerialize, value1);
+  }
+}
+
+}  // namespace
+}  // namespace zetasql
+
+int main(int argc, char** argv) {
+  zetasql::RegisterValueBenchmarks();
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
@@ -0,0 +1,163 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_COMMON_LRU_CACHE_H_
+#define ZETASQL_COMMON_LRU_CACHE_H_
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <utility>
+
+#include "zetasql/base/logging.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/hash/hash.h"
+#include "absl/synchronization/mutex.h"
+
+namespace zetasql {
+
+// Counters describing the effectiveness of an LruCache.
+struct LruCacheStats {
+  int64_t hits = 0;
+  int64_t misses = 0;
+  int64_t evictions = 0;
+};
+
+// A thread-safe, size-bounded map that evicts the least recently used entry
+// when full.  Values are copied out on lookup, so <Value> is normally
+// something cheap to copy such as a std::shared_ptr to an immutable object.
+//
+// All operations take an internal lock; computing a value to insert should
+// be done outside of the cache, between Lookup() and Insert().
+template <typename Key, typename Value, typename Hash = absl::Hash<Key>>
+class LruCache {
+ public:
+  // <max_entries> must be positive.
+  explicit LruCache(int max_entries) : max_entries_(max_entries) {
+    DCHECK_GT(max_entries_, 0);
+  }
+  LruCache(const LruCache&) = delete;
+  LruCache& operator=(const LruCache&) = delete;
+
+  // If <key> is present, copies its value to <*value>, marks the entry most
+  // recently used and returns true.  Otherwise returns false.
+  bool Lookup(const Key& key, Value* value) LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      ++stats_.misses;
+      return false;
+    }
+    ++stats_.hits;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    *value = it->second->second;
+    return true;
+  }
+
+  // Adds or replaces the entry for <key> and marks it most recently used,
+  // evicting the least recently used entries if the cache is full.
+  void Insert(const Key& key, Value value) LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      it->second->second = std::move(value);
+      entries_.splice(entries_.begin(), entries_, it->second);
+      return;
+    }
+    entries_.emplace_front(key, std::move(value));
+    index_.emplace(key, entries_.begin());
+    while (entries_.size() > max_entries_) {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+      ++stats_.evictions;
+    }
+  }
+
+  // Removes the entry for <key>, if any.
+  void Erase(const Key& key) LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      entries_.erase(it->second);
+      index_.erase(it);
+    }
+  }
+
+  // Removes all entries for which <predicate> returns true.  Returns the
+  // number of entries removed.
+  int EraseIf(const std::function<bool(const Key&, const Value&)>& predicate)
+      LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    int num_erased = 0;
+    for (auto it = entries_.begin(); it != entries_.end();) {
+      if (predicate(it->first, it->second)) {
+        index_.erase(it->first);
+        it = entries_.erase(it);
+        ++num_erased;
+      } else {
+        ++it;
+      }
+    }
+    return num_erased;
+  }
+
+  // Calls <fn> on all entries, from the most to the least recently used,
+  // without changing their order or the stats.  <fn> is called with the lock
+  // held, so it must not call back into this cache.
+  void ForEach(const std::function<void(const Key&, const Value&)>& fn) const
+      LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    for (const auto& entry : entries_) {
+      fn(entry.first, entry.second);
+    }
+  }
+
+  void Clear() LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    index_.clear();
+    entries_.clear();
+  }
+
+  int max_entries() const { return max_entries_; }
+
+  int size() const LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    return static_cast<int>(index_.size());
+  }
+
+  LruCacheStats stats() const LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    return stats_;
+  }
+
+ private:
+  typedef std::list<std::pair<Key, Value>> EntryList;
+
+  const int max_entries_;
+
+  mutable absl::Mutex mutex_;
+
+  // Most recently used entries are at the front.
+  EntryList entries_ GUARDED_BY(mutex_);
+  absl::flat_hash_map<Key, typename EntryList::iterator, Hash> index_
+      GUARDED_BY(mutex_);
+  LruCacheStats stats_ GUARDED_BY(mutex_);
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_COMMON_LRU_CACHE_H_
@@ -0,0 +1,77 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/common/lru_cache.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace zetasql {
+
+TEST(LruCacheTest, LookupAndInsert) {
+  LruCache<std::string, int> cache(/*max_entries=*/10);
+  int value = 0;
+  EXPECT_FALSE(cache.Lookup("a", &value));
+  cache.Insert("a", 1);
+  EXPECT_TRUE(cache.Lookup("a", &value));
+  EXPECT_EQ(1, value);
+
+  // Inserting an existing key replaces its value.
+  cache.Insert("a", 2);
+  EXPECT_TRUE(cache.Lookup("a", &value));
+  EXPECT_EQ(2, value);
+  EXPECT_EQ(1, cache.size());
+  EXPECT_EQ(2, cache.stats().hits);
+  EXPECT_EQ(1, cache.stats().misses);
+}
+
+TEST(LruCacheTest, EvictsLeastRecentlyUsed) {
+  LruCache<std::string, int> cache(/*max_entries=*/2);
+  int value = 0;
+  cache.Insert("a", 1);
+  cache.Insert("b", 2);
+  EXPECT_TRUE(cache.Lookup("a", &value));
+  cache.Insert("c", 3);
+  EXPECT_EQ(2, cache.size());
+  EXPECT_EQ(1, cache.stats().evictions);
+  EXPECT_TRUE(cache.Lookup("a", &value));
+  EXPECT_FALSE(cache.Lookup("b", &value));
+  EXPECT_TRUE(cache.Lookup("c", &value));
+}
+
+TEST(LruCacheTest, Erase) {
+  LruCache<std::string, int> cache(/*max_entries=*/10);
+  int value = 0;
+  cache.Insert("a", 1);
+  cache.Insert("b", 2);
+  cache.Insert("c", 3);
+  cache.Erase("a");
+  cache.Erase("not_present");
+  EXPECT_FALSE(cache.Lookup("a", &value));
+  EXPECT_EQ(2, cache.size());
+
+  EXPECT_EQ(1, cache.EraseIf([](const std::string& key, int value) {
+    return value == 3;
+  }));
+  EXPECT_FALSE(cache.Lookup("c", &value));
+  EXPECT_TRUE(cache.Lookup("b", &value));
+
+  cache.Clear();
+  EXPECT_EQ(0, cache.size());
+}
+
+}  // namespace zetasql
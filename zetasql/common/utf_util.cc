@@ -16,17 +16,59 @@
 
 #include "zetasql/common/utf_util.h"
 
+#include <string.h>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "zetasql/base/logging.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "unicode/utf8.h"
+#include "zetasql/base/bits.h"
 
 namespace zetasql {
 
 constexpr absl::string_view kReplacementCharacter = "\uFFFD";
 
+// The high bit of every byte of a 64-bit word.
+constexpr uint64_t kHighBits = 0x8080808080808080ULL;
+
+// Returns the number of leading ASCII bytes in [s, s + length). Checks 16
+// bytes at a time with SSE2 where available and 8 bytes at a time otherwise,
+// so that mostly-ASCII strings skip the per-character U8_NEXT decoding.
+static size_t SpanASCII(const char* s, size_t length) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  for (; i + 16 <= length; i += 16) {
+    const __m128i block =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+    const int mask = _mm_movemask_epi8(block);
+    if (mask != 0) {
+      return i + zetasql_base::Bits::FindLSBSetNonZero(mask);
+    }
+  }
+#endif
+  for (; i + 8 <= length; i += 8) {
+    uint64_t block;
+    memcpy(&block, s + i, sizeof(block));
+    if ((block & kHighBits) != 0) {
+      break;
+    }
+  }
+  for (; i < length && static_cast<signed char>(s[i]) >= 0; ++i) {
+  }
+  return i;
+}
+
 static int SpanWellFormedUTF8(const char* s, int length) {
   for (int i = 0; i < length;) {
+    i += static_cast<int>(SpanASCII(s + i, length - i));
+    if (i == length) {
+      break;
+    }
     int start = i;
     UChar32 c;
     U8_NEXT(s, i, length, c);
@@ -42,12 +84,50 @@ absl::string_view::size_type SpanWellFormedUTF8(absl::string_view s) {
       SpanWellFormedUTF8(s.data(), static_cast<int>(s.length())));
 }
 
+bool IsASCII(absl::string_view s) {
+  return SpanASCII(s.data(), s.length()) == s.length();
+}
+
+absl::string_view::size_type CountCodePointsUTF8(absl::string_view s) {
+  // A code point starts at every byte that is not a continuation byte
+  // (10xxxxxx), so count the continuation bytes and subtract them.
+  const char* data = s.data();
+  const size_t length = s.length();
+  size_t num_continuation_bytes = 0;
+  size_t i = 0;
+#if defined(__SSE2__)
+  // As signed bytes, continuation bytes are exactly the values below -64.
+  const __m128i kContinuationLimit = _mm_set1_epi8(-64);
+  for (; i + 16 <= length; i += 16) {
+    const __m128i block =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    num_continuation_bytes += zetasql_base::Bits::CountOnes(
+        _mm_movemask_epi8(_mm_cmplt_epi8(block, kContinuationLimit)));
+  }
+#endif
+  for (; i + 8 <= length; i += 8) {
+    uint64_t block;
+    memcpy(&block, data + i, sizeof(block));
+    // Shifting by one moves bit 6 of each byte into its bit 7.
+    num_continuation_bytes +=
+        zetasql_base::Bits::CountOnes64(block & ~(block << 1) & kHighBits);
+  }
+  for (; i < length; ++i) {
+    num_continuation_bytes += (data[i] & 0xC0) == 0x80;
+  }
+  return length - num_continuation_bytes;
+}
+
 std::string CoerceToWellFormedUTF8(absl::string_view input) {
   const char* s = input.data();
   size_t length = input.length();
   size_t prev = 0;
   std::string out;
   for (size_t i = 0; i < length;) {
+    i += SpanASCII(s + i, length - i);
+    if (i == length) {
+      break;
+    }
     size_t start = i;
     UChar32 c;
     U8_NEXT(s, i, length, c);
@@ -30,6 +30,15 @@ inline bool IsWellFormedUTF8(absl::string_view s) {
   return SpanWellFormedUTF8(s) == s.length();
 }
 
+// Returns true if every byte of `s` is ASCII, which implies that `s` is well
+// formed UTF8. Checks 16 bytes at a time where SSE2 is available.
+bool IsASCII(absl::string_view s);
+
+// Returns the number of code points in `s`, which should be well formed UTF8
+// (see IsWellFormedUTF8). For ill-formed input this is the number of bytes
+// that are not UTF8 continuation bytes.
+absl::string_view::size_type CountCodePointsUTF8(absl::string_view s);
+
 // Returns a well-formed Unicode std::string. Replaces any ill-formed
 // subsequences with the Unicode REPLACEMENT CHARACTER (U+FFFD).
 // This is usually rendered as a diamond with a question mark in the middle.
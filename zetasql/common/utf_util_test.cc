@@ -17,6 +17,7 @@
 #include "zetasql/common/utf_util.h"
 
 #include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 
 namespace zetasql {
@@ -66,6 +67,48 @@ TEST(UtfUtilTest, WellFormedUTF8) {
   TestIllFormedString("ABC\xf0\x90", 3);
 }
 
+TEST(UtfUtilTest, LongStrings) {
+  // Long enough to go through the block-at-a-time ASCII checks, with the
+  // non-ASCII character placed at every offset.
+  const std::string ascii(40, 'a');
+  TestWellFormedString(ascii);
+  for (int i = 0; i <= ascii.size(); ++i) {
+    const std::string prefix = ascii.substr(0, i);
+    TestWellFormedString(absl::StrCat(prefix, "\xe8\xb0\xb7", ascii));
+    TestIllFormedString(absl::StrCat(prefix, "\xe8\xb0", ascii), i);
+    TestIllFormedString(absl::StrCat(prefix, "\x80", ascii), i);
+  }
+}
+
+TEST(UtfUtilTest, CountCodePointsUTF8) {
+  EXPECT_EQ(0, CountCodePointsUTF8(""));
+  EXPECT_EQ(3, CountCodePointsUTF8("abc"));
+  EXPECT_EQ(1, CountCodePointsUTF8("\xc2\xbf"));
+  EXPECT_EQ(2, CountCodePointsUTF8("\xe8\xb0\xb7\xe6\xad\x8c"));
+  EXPECT_EQ(1, CountCodePointsUTF8("\xf0\x9f\x98\x80"));
+
+  std::string str;
+  for (int i = 0; i < 50; ++i) {
+    str.append("a\xc2\xbf\xe8\xb0\xb7\xf0\x9f\x98\x80");
+    EXPECT_EQ(4 * (i + 1), CountCodePointsUTF8(str));
+    EXPECT_EQ(4 * i + 1, CountCodePointsUTF8(absl::string_view(str).substr(
+                             0, str.size() - 9)));
+  }
+}
+
+TEST(UtfUtilTest, IsASCII) {
+  EXPECT_TRUE(IsASCII(""));
+  EXPECT_TRUE(IsASCII("abc\x7f"));
+  EXPECT_FALSE(IsASCII("\xc2\xbf"));
+  // Non-ASCII bytes are found at every offset of the SSE2 and 8-byte loops.
+  for (int i = 0; i < 40; ++i) {
+    std::string str(40, 'a');
+    EXPECT_TRUE(IsASCII(str));
+    str[i] = '\x80';
+    EXPECT_FALSE(IsASCII(str)) << i;
+  }
+}
+
 void TestCoerce(std::string str, std::string expected) {
   if (str == expected) {
     // Sanity check.
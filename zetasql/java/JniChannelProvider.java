@@ -25,14 +25,20 @@ import io.netty.channel.socket.nio.NioSocketChannel;
 import java.io.IOException;
 import java.net.InetSocketAddress;
 import java.net.SocketAddress;
+import java.nio.ByteBuffer;
 import java.nio.channels.SocketChannel;
 
 /** Controller class of the ZetaSQL JniChannelProvider. */
 @AutoService(ClientChannelProvider.class)
 public class JniChannelProvider implements ClientChannelProvider {
   private static final InetSocketAddress ADDRESS = new InetSocketAddress(0);
+  private static final int INITIAL_RESPONSE_BUFFER_SIZE = 64 * 1024;
   private static Channel channel = null;
 
+  /** Per-thread direct buffer that analyze() returns responses in. */
+  private static final ThreadLocal<ByteBuffer> responseBuffer =
+      ThreadLocal.withInitial(() -> ByteBuffer.allocateDirect(INITIAL_RESPONSE_BUFFER_SIZE));
+
   static {
     try {
       cz.adamh.utils.NativeUtils.loadLibraryFromJar("/zetasql/local_service/liblocal_service_jni.so");
@@ -44,6 +50,38 @@ public class JniChannelProvider implements ClientChannelProvider {
   /** Returns a SocketChannel connected to the server. */
   private static native SocketChannel getSocketChannel() throws IOException;
 
+  /**
+   * Analyzes the serialized AnalyzeRequest in the first requestSize bytes of the direct buffer
+   * request, and writes the serialized AnalyzeResponse to the start of the direct buffer response.
+   * Returns the size of the response, or minus its size if it does not fit.
+   */
+  private static native int analyzeDirect(ByteBuffer request, int requestSize, ByteBuffer response);
+
+  /** Writes the response that did not fit in the last analyzeDirect() call on this thread. */
+  private static native int takePendingResponse(ByteBuffer response);
+
+  /**
+   * Calls the Analyze RPC in process, without gRPC or copies of the request and response into
+   * Java byte arrays.
+   *
+   * @param request the serialized AnalyzeRequest, a direct buffer from position 0 to its limit
+   * @return the serialized AnalyzeResponse, valid until the next call on this thread
+   * @throws io.grpc.StatusRuntimeException if the analysis fails, as the RPC does
+   */
+  public static ByteBuffer analyze(ByteBuffer request) {
+    ByteBuffer response = responseBuffer.get();
+    int size = analyzeDirect(request, request.limit(), response);
+    if (size < 0) {
+      response = ByteBuffer.allocateDirect(Integer.highestOneBit(-size) << 1);
+      responseBuffer.set(response);
+      size = takePendingResponse(response);
+    }
+    ByteBuffer result = response.duplicate();
+    result.clear();
+    result.limit(size);
+    return result;
+  }
+
   /** Wraps one end of a socketpair for NioSocketChannel. */
   protected static class SocketPairChannel extends NioSocketChannel {
 
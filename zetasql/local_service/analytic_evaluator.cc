@@ -0,0 +1,733 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "zetasql/local_service/analytic_evaluator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#include "zetasql/public/builtin_function.pb.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/numeric_value.h"
+#include "zetasql/resolved_ast/resolved_node_kind.pb.h"
+#include "absl/memory/memory.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/source_location.h"
+#include "zetasql/base/status_builder.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+namespace local_service {
+
+namespace {
+
+typedef ResolvedWindowFrameExpr::BoundaryType BoundaryType;
+
+bool IsNaN(const Value& value) {
+  return value.type()->IsFloatingPoint() && !value.is_null() &&
+         std::isnan(value.ToDouble());
+}
+
+bool IsOffset(BoundaryType type) {
+  return type == ResolvedWindowFrameExpr::OFFSET_PRECEDING ||
+         type == ResolvedWindowFrameExpr::OFFSET_FOLLOWING;
+}
+
+bool IsRangeKeyType(const Type* type) {
+  switch (type->kind()) {
+    case TYPE_INT32:
+    case TYPE_INT64:
+    case TYPE_UINT32:
+    case TYPE_UINT64:
+    case TYPE_FLOAT:
+    case TYPE_DOUBLE:
+    case TYPE_NUMERIC:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns <value>, which has an integer or NUMERIC type, as an integer
+// that orders like it. NUMERIC values are scaled by 10^9.
+__int128 RangeKeyAsInt128(const Value& value) {
+  switch (value.type_kind()) {
+    case TYPE_INT32:
+    case TYPE_INT64:
+      return value.ToInt64();
+    case TYPE_UINT32:
+    case TYPE_UINT64:
+      return value.ToUint64();
+    default:
+      return value.numeric_value().as_packed_int();
+  }
+}
+
+bool IsNegative(const Value& value) {
+  switch (value.type_kind()) {
+    case TYPE_INT32:
+    case TYPE_INT64:
+      return value.ToInt64() < 0;
+    case TYPE_FLOAT:
+    case TYPE_DOUBLE:
+      return value.ToDouble() < 0;
+    case TYPE_NUMERIC:
+      return value.numeric_value() < NumericValue();
+    default:
+      return false;
+  }
+}
+
+int Sign(__int128 value) { return (value > 0) - (value < 0); }
+
+// Returns the sign of <a> - <b> - <c>, where |c| < 2^127, without
+// overflowing.
+int SignOfDifference(__int128 a, __int128 b, __int128 c) {
+  __int128 difference;
+  if (__builtin_sub_overflow(a, b, &difference)) return a > b ? 1 : -1;
+  __int128 result;
+  if (__builtin_sub_overflow(difference, c, &result)) {
+    return difference > 0 ? 1 : -1;
+  }
+  return Sign(result);
+}
+
+// Returns a row index moved by <offset> rows, clamped to [-1, <num_rows>].
+int64_t MoveRow(int64_t row, int64_t num_rows, int64_t offset,
+                bool following) {
+  if (following) return offset >= num_rows - row ? num_rows : row + offset;
+  return offset > row ? -1 : row - offset;
+}
+
+// The state of COUNT, SUM or AVG over the rows of a sliding frame.
+class SlidingAggregate {
+ public:
+  SlidingAggregate(AnalyticEvaluator::AnalyticFunction function,
+                   TypeKind kind)
+      : function_(function), kind_(kind) {}
+
+  void Add(const Value& value) { Update(value, 1); }
+  void Remove(const Value& value) { Update(value, -1); }
+
+  zetasql_base::StatusOr<Value> GetValue(const Type* output_type) const;
+
+ private:
+  void Update(const Value& value, int sign);
+
+  // Returns the SUM of DOUBLE values.
+  double DoubleSum() const;
+
+  const AnalyticEvaluator::AnalyticFunction function_;
+  const TypeKind kind_;
+  // The number of non-NULL values, or of rows for kCountStar.
+  int64_t count_ = 0;
+  // The sum of INT64 or UINT64 values, which cannot overflow in between.
+  __int128 int_sum_ = 0;
+  // DOUBLE values are summed without the infinities and NaNs, which are
+  // counted instead so that they can be removed.
+  double double_sum_ = 0;
+  int64_t num_nans_ = 0;
+  int64_t num_positive_infinities_ = 0;
+  int64_t num_negative_infinities_ = 0;
+  NumericValue::Aggregator numeric_sum_;
+};
+
+void SlidingAggregate::Update(const Value& value, int sign) {
+  if (function_ == AnalyticEvaluator::kCountStar) {
+    count_ += sign;
+    return;
+  }
+  if (value.is_null()) return;
+  count_ += sign;
+  if (function_ == AnalyticEvaluator::kCount) return;
+  switch (kind_) {
+    case TYPE_INT64:
+      int_sum_ += sign * static_cast<__int128>(value.int64_value());
+      break;
+    case TYPE_UINT64:
+      int_sum_ += sign * static_cast<__int128>(value.uint64_value());
+      break;
+    case TYPE_DOUBLE: {
+      const double d = value.double_value();
+      if (std::isnan(d)) {
+        num_nans_ += sign;
+      } else if (std::isinf(d)) {
+        (d > 0 ? num_positive_infinities_ : num_negative_infinities_) += sign;
+      } else {
+        double_sum_ += sign * d;
+      }
+      // Do not carry rounding errors over to later frames.
+      if (count_ == 0) double_sum_ = 0;
+      break;
+    }
+    case TYPE_NUMERIC:
+      if (sign > 0) {
+        numeric_sum_.Add(value.numeric_value());
+      } else {
+        numeric_sum_.Subtract(value.numeric_value());
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+double SlidingAggregate::DoubleSum() const {
+  if (num_nans_ > 0 ||
+      (num_positive_infinities_ > 0 && num_negative_infinities_ > 0)) {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+  if (num_positive_infinities_ > 0) {
+    return std::numeric_limits<double>::infinity();
+  }
+  if (num_negative_infinities_ > 0) {
+    return -std::numeric_limits<double>::infinity();
+  }
+  return double_sum_;
+}
+
+zetasql_base::StatusOr<Value> SlidingAggregate::GetValue(
+    const Type* output_type) const {
+  if (function_ == AnalyticEvaluator::kCount ||
+      function_ == AnalyticEvaluator::kCountStar) {
+    return Value::Int64(count_);
+  }
+  if (count_ == 0) return Value::Null(output_type);
+  const bool avg = function_ == AnalyticEvaluator::kAvg;
+  switch (kind_) {
+    case TYPE_INT64:
+      if (avg) return Value::Double(static_cast<double>(int_sum_) / count_);
+      if (int_sum_ > std::numeric_limits<int64_t>::max() ||
+          int_sum_ < std::numeric_limits<int64_t>::min()) {
+        return ::zetasql_base::OutOfRangeErrorBuilder(ZETASQL_LOC)
+               << "int64 overflow: SUM";
+      }
+      return Value::Int64(static_cast<int64_t>(int_sum_));
+    case TYPE_UINT64:
+      if (avg) return Value::Double(static_cast<double>(int_sum_) / count_);
+      if (int_sum_ > std::numeric_limits<uint64_t>::max()) {
+        return ::zetasql_base::OutOfRangeErrorBuilder(ZETASQL_LOC)
+               << "uint64 overflow: SUM";
+      }
+      return Value::Uint64(static_cast<uint64_t>(int_sum_));
+    case TYPE_DOUBLE:
+      return Value::Double(avg ? DoubleSum() / count_ : DoubleSum());
+    case TYPE_NUMERIC: {
+      ZETASQL_ASSIGN_OR_RETURN(const NumericValue result,
+                       avg ? numeric_sum_.GetAverage(count_)
+                           : numeric_sum_.GetSum());
+      return Value::Numeric(result);
+    }
+    default:
+      ZETASQL_RET_CHECK_FAIL() << "Unexpected SUM or AVG argument type";
+  }
+}
+
+// A segment tree over the argument values of a partition, which returns
+// the MIN or MAX over any range of rows in O(log n). Like the aggregate,
+// it ignores NULLs and returns NaN if there is any NaN.
+class MinMaxTree {
+ public:
+  MinMaxTree(bool max, const Type* type, std::vector<Value> values)
+      : max_(max),
+        less_(Value::MakeComparator(type)),
+        values_(std::move(values)),
+        tree_(2 * values_.size()) {
+    const int64_t n = values_.size();
+    for (int64_t i = 0; i < n; ++i) {
+      tree_[n + i] = values_[i].is_null() ? -1 : i;
+    }
+    for (int64_t i = n - 1; i > 0; --i) {
+      tree_[i] = Combine(tree_[2 * i], tree_[2 * i + 1]);
+    }
+  }
+
+  // Returns the MIN or MAX of values [start, end), or NULL if they are all
+  // NULL or there are none.
+  Value Get(int64_t start, int64_t end, const Type* type) const {
+    int64_t result = -1;
+    const int64_t n = values_.size();
+    for (start += n, end += n; start < end; start /= 2, end /= 2) {
+      if (start % 2 == 1) result = Combine(result, tree_[start++]);
+      if (end % 2 == 1) result = Combine(result, tree_[--end]);
+    }
+    return result < 0 ? Value::Null(type) : values_[result];
+  }
+
+ private:
+  // Returns whichever of values <a> and <b> the aggregate prefers, where -1
+  // stands for no value.
+  int64_t Combine(int64_t a, int64_t b) const {
+    if (a < 0) return b;
+    if (b < 0) return a;
+    const Value& x = values_[a];
+    const Value& y = values_[b];
+    if (IsNaN(x)) return a;
+    if (IsNaN(y)) return b;
+    return (max_ ? less_(x, y) : less_(y, x)) ? b : a;
+  }
+
+  const bool max_;
+  const Value::Comparator less_;
+  const std::vector<Value> values_;
+  std::vector<int64_t> tree_;
+};
+
+}  // namespace
+
+struct AnalyticEvaluator::AnalyticInfo {
+  Analytic analytic;
+  const Type* output_type = nullptr;
+};
+
+AnalyticEvaluator::AnalyticEvaluator(
+    std::unique_ptr<EvaluatorTableIterator> input,
+    std::vector<SortKey> order_keys)
+    : input_(std::move(input)), order_keys_(std::move(order_keys)) {}
+
+AnalyticEvaluator::~AnalyticEvaluator() {}
+
+zetasql_base::StatusOr<AnalyticEvaluator::Analytic> AnalyticEvaluator::AnalyticForCall(
+    const ResolvedAnalyticFunctionCall* call, int argument) {
+  const Function* function = call->function();
+  if (!function->IsZetaSQLBuiltin()) {
+    return ::zetasql_base::UnimplementedErrorBuilder(ZETASQL_LOC)
+           << "Unsupported analytic function " << function->Name();
+  }
+  if (call->distinct() ||
+      call->null_handling_modifier() !=
+          ResolvedAnalyticFunctionCall::DEFAULT_NULL_HANDLING ||
+      call->error_mode() != ResolvedAnalyticFunctionCall::DEFAULT_ERROR_MODE) {
+    return ::zetasql_base::UnimplementedErrorBuilder(ZETASQL_LOC)
+           << "Unsupported modifiers in call to " << function->Name();
+  }
+  Analytic analytic;
+  analytic.argument = argument;
+  switch (call->signature().context_id()) {
+    case FN_COUNT:
+      analytic.function = kCount;
+      break;
+    case FN_COUNT_STAR:
+      analytic.function = kCountStar;
+      analytic.argument = -1;
+      break;
+    case FN_SUM_INT64:
+    case FN_SUM_UINT64:
+    case FN_SUM_DOUBLE:
+    case FN_SUM_NUMERIC:
+      analytic.function = kSum;
+      break;
+    case FN_AVG_INT64:
+    case FN_AVG_UINT64:
+    case FN_AVG_DOUBLE:
+    case FN_AVG_NUMERIC:
+      analytic.function = kAvg;
+      break;
+    case FN_MIN:
+      analytic.function = kMin;
+      break;
+    case FN_MAX:
+      analytic.function = kMax;
+      break;
+    default:
+      return ::zetasql_base::UnimplementedErrorBuilder(ZETASQL_LOC)
+             << "Unsupported analytic function " << function->Name();
+  }
+
+  const ResolvedWindowFrame* frame = call->window_frame();
+  if (frame == nullptr) return analytic;
+  analytic.frame.unit = frame->frame_unit();
+  for (const auto& item :
+       {std::make_pair(frame->start_expr(), &analytic.frame.start),
+        std::make_pair(frame->end_expr(), &analytic.frame.end)}) {
+    const ResolvedWindowFrameExpr* expr = item.first;
+    ZETASQL_RET_CHECK(expr != nullptr);
+    FrameBoundary* boundary = item.second;
+    boundary->type = expr->boundary_type();
+    if (!IsOffset(boundary->type)) continue;
+    ZETASQL_RET_CHECK(expr->expression() != nullptr);
+    if (expr->expression()->node_kind() != RESOLVED_LITERAL) {
+      return ::zetasql_base::UnimplementedErrorBuilder(ZETASQL_LOC)
+             << "Window frame offsets must be literals";
+    }
+    boundary->offset = expr->expression()->GetAs<ResolvedLiteral>()->value();
+  }
+  return analytic;
+}
+
+zetasql_base::StatusOr<std::unique_ptr<AnalyticEvaluator>> AnalyticEvaluator::Create(
+    std::unique_ptr<EvaluatorTableIterator> input,
+    absl::Span<const int> partition_columns, std::vector<SortKey> order_keys,
+    absl::Span<const Analytic> analytics) {
+  ZETASQL_RET_CHECK(input != nullptr);
+  auto evaluator = absl::WrapUnique(
+      new AnalyticEvaluator(std::move(input), std::move(order_keys)));
+  const EvaluatorTableIterator& iterator = *evaluator->input_;
+  evaluator->num_input_columns_ = iterator.NumColumns();
+  for (int i = 0; i < iterator.NumColumns(); ++i) {
+    evaluator->column_types_.push_back(iterator.GetColumnType(i));
+  }
+  for (const int column : partition_columns) {
+    if (column < 0 || column >= iterator.NumColumns()) {
+      return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+             << "Partitioning column " << column << " is out of range";
+    }
+    evaluator->partition_columns_.push_back(column);
+  }
+  for (const SortKey& key : evaluator->order_keys_) {
+    if (key.column < 0 || key.column >= iterator.NumColumns()) {
+      return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+             << "Ordering column " << key.column << " is out of range";
+    }
+  }
+  for (const Analytic& analytic : analytics) {
+    AnalyticInfo info;
+    ZETASQL_RETURN_IF_ERROR(evaluator->InitAnalytic(analytic, &info));
+    evaluator->column_types_.push_back(info.output_type);
+    evaluator->analytics_.push_back(info);
+  }
+  return evaluator;
+}
+
+zetasql_base::Status AnalyticEvaluator::InitAnalytic(const Analytic& analytic,
+                                             AnalyticInfo* info) {
+  info->analytic = analytic;
+  const Type* argument_type = nullptr;
+  if (analytic.function != kCountStar) {
+    if (analytic.argument < 0 || analytic.argument >= num_input_columns_) {
+      return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+             << "Analytic argument column " << analytic.argument
+             << " is out of range";
+    }
+    argument_type = column_types_[analytic.argument];
+  }
+  switch (analytic.function) {
+    case kCount:
+    case kCountStar:
+      info->output_type = types::Int64Type();
+      break;
+    case kSum:
+    case kAvg:
+      switch (argument_type->kind()) {
+        case TYPE_INT64:
+        case TYPE_UINT64:
+        case TYPE_DOUBLE:
+          info->output_type =
+              analytic.function == kAvg ? types::DoubleType() : argument_type;
+          break;
+        case TYPE_NUMERIC:
+          info->output_type = argument_type;
+          break;
+        default:
+          return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+                 << "SUM and AVG do not support arguments of type "
+                 << argument_type->DebugString();
+      }
+      break;
+    case kMin:
+    case kMax:
+      if (!argument_type->SupportsOrdering()) {
+        return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+               << "MIN and MAX do not support arguments of type "
+               << argument_type->DebugString();
+      }
+      info->output_type = argument_type;
+      break;
+  }
+
+  const WindowFrame& frame = analytic.frame;
+  if (frame.start.type == ResolvedWindowFrameExpr::UNBOUNDED_FOLLOWING ||
+      frame.end.type == ResolvedWindowFrameExpr::UNBOUNDED_PRECEDING) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "Invalid window frame: "
+           << ResolvedWindowFrameExpr::BoundaryTypeToString(frame.start.type)
+           << " to "
+           << ResolvedWindowFrameExpr::BoundaryTypeToString(frame.end.type);
+  }
+  ZETASQL_RETURN_IF_ERROR(CheckBoundary(frame.start, frame.unit));
+  return CheckBoundary(frame.end, frame.unit);
+}
+
+zetasql_base::Status AnalyticEvaluator::CheckBoundary(
+    const FrameBoundary& boundary, ResolvedWindowFrame::FrameUnit unit) const {
+  if (!IsOffset(boundary.type)) return ::zetasql_base::OkStatus();
+  const Value& offset = boundary.offset;
+  const Type* expected_type = types::Int64Type();
+  if (unit == ResolvedWindowFrame::RANGE) {
+    if (order_keys_.size() != 1 ||
+        !IsRangeKeyType(column_types_[order_keys_[0].column])) {
+      return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+             << "A RANGE window frame with an offset requires exactly one "
+                "numeric ordering key";
+    }
+    expected_type = column_types_[order_keys_[0].column];
+  }
+  if (!offset.is_valid() || !offset.type()->Equals(expected_type)) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "Window frame offset must have type "
+           << expected_type->DebugString();
+  }
+  if (offset.is_null() || IsNaN(offset) || IsNegative(offset)) {
+    return ::zetasql_base::OutOfRangeErrorBuilder(ZETASQL_LOC)
+           << "Window frame offset must be non-negative and not NULL or NaN, "
+              "but is "
+           << offset.DebugString();
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+std::string AnalyticEvaluator::GetColumnName(int i) const {
+  return i < num_input_columns_ ? input_->GetColumnName(i) : "";
+}
+
+zetasql_base::Status AnalyticEvaluator::Cancel() {
+  cancelled_ = true;
+  return input_->Cancel();
+}
+
+bool AnalyticEvaluator::NextRow() {
+  if (!status_.ok()) return false;
+  if (cancelled_) {
+    status_ = ::zetasql_base::CancelledErrorBuilder(ZETASQL_LOC)
+              << "AnalyticEvaluator was cancelled";
+    return false;
+  }
+  if (current_row_ + 1 < static_cast<int64_t>(partition_.size())) {
+    ++current_row_;
+    return true;
+  }
+  status_ = ReadPartition();
+  if (status_.ok() && !partition_.empty()) status_ = EvaluatePartition();
+  if (!status_.ok() || partition_.empty()) return false;
+  ++num_partitions_;
+  current_row_ = 0;
+  return true;
+}
+
+zetasql_base::Status AnalyticEvaluator::ReadPartition() {
+  partition_.clear();
+  current_row_ = -1;
+  if (have_next_row_) {
+    partition_.push_back(std::move(next_row_));
+    have_next_row_ = false;
+  }
+  while (!input_done_) {
+    if (!input_->NextRow()) {
+      input_done_ = true;
+      return input_->Status();
+    }
+    std::vector<Value> row(num_input_columns_);
+    for (int i = 0; i < num_input_columns_; ++i) {
+      row[i] = input_->GetValue(i);
+    }
+    if (!partition_.empty()) {
+      bool same_partition = true;
+      for (const int column : partition_columns_) {
+        if (!row[column].Equals(partition_[0][column])) {
+          same_partition = false;
+          break;
+        }
+      }
+      if (!same_partition) {
+        next_row_ = std::move(row);
+        have_next_row_ = true;
+        break;
+      }
+    }
+    partition_.push_back(std::move(row));
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+bool AnalyticEvaluator::IsPeer(int64_t row, int64_t other) const {
+  for (const SortKey& key : order_keys_) {
+    if (!partition_[row][key.column].Equals(partition_[other][key.column])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int AnalyticEvaluator::CompareToBoundary(const FrameBoundary& boundary,
+                                         int64_t row, int64_t other) const {
+  switch (boundary.type) {
+    case ResolvedWindowFrameExpr::UNBOUNDED_PRECEDING:
+      return 1;
+    case ResolvedWindowFrameExpr::UNBOUNDED_FOLLOWING:
+      return -1;
+    case ResolvedWindowFrameExpr::CURRENT_ROW:
+      if (IsPeer(row, other)) return 0;
+      return other < row ? -1 : 1;
+    default:
+      break;
+  }
+  // The frame includes the rows at a distance of up to <offset> before or
+  // after <row>.
+  const bool following =
+      boundary.type == ResolvedWindowFrameExpr::OFFSET_FOLLOWING;
+  const int column = order_keys_[0].column;
+  const Value& key = partition_[row][column];
+  const Value& other_key = partition_[other][column];
+  const Value& offset = boundary.offset;
+  // NULLs and NaNs are only at distance 0 from themselves, and infinitely
+  // far from numbers, on the side where they sort.
+  const bool key_is_number = !key.is_null() && !IsNaN(key);
+  const bool other_is_number = !other_key.is_null() && !IsNaN(other_key);
+  if (!key_is_number || !other_is_number) {
+    if (key.is_null() == other_key.is_null() &&
+        key_is_number == other_is_number) {
+      const bool zero_offset = offset.type()->IsFloatingPoint()
+                                   ? offset.ToDouble() == 0
+                                   : RangeKeyAsInt128(offset) == 0;
+      if (zero_offset) return 0;
+      return following ? -1 : 1;
+    }
+    return other < row ? -1 : 1;
+  }
+
+  // The distance is other_key - key, negated if the ordering is descending.
+  const bool descending = order_keys_[0].descending;
+  if (key.type()->IsFloatingPoint()) {
+    const double a = key.ToDouble();
+    const double b = other_key.ToDouble();
+    const double distance = a == b ? 0 : (descending ? a - b : b - a);
+    const double bound = following ? offset.ToDouble() : -offset.ToDouble();
+    if (distance > bound) return 1;
+    if (distance < bound) return -1;
+    return 0;  // Including infinite distances to an infinite offset.
+  }
+  const __int128 a = RangeKeyAsInt128(key);
+  const __int128 b = RangeKeyAsInt128(other_key);
+  const __int128 bound =
+      following ? RangeKeyAsInt128(offset) : -RangeKeyAsInt128(offset);
+  return descending ? SignOfDifference(a, b, bound)
+                    : SignOfDifference(b, a, bound);
+}
+
+void AnalyticEvaluator::ComputeFrames(const WindowFrame& frame,
+                                      std::vector<int64_t>* starts,
+                                      std::vector<int64_t>* ends) const {
+  const int64_t n = partition_.size();
+  starts->resize(n);
+  ends->resize(n);
+  if (frame.unit == ResolvedWindowFrame::ROWS) {
+    for (int64_t i = 0; i < n; ++i) {
+      for (const bool is_start : {true, false}) {
+        const FrameBoundary& boundary = is_start ? frame.start : frame.end;
+        int64_t first;  // The first row at or after the boundary.
+        switch (boundary.type) {
+          case ResolvedWindowFrameExpr::UNBOUNDED_PRECEDING:
+            first = 0;
+            break;
+          case ResolvedWindowFrameExpr::UNBOUNDED_FOLLOWING:
+            first = n;
+            break;
+          case ResolvedWindowFrameExpr::CURRENT_ROW:
+            first = is_start ? i : i + 1;
+            break;
+          default: {
+            const int64_t row = MoveRow(
+                i, n, boundary.offset.int64_value(),
+                boundary.type == ResolvedWindowFrameExpr::OFFSET_FOLLOWING);
+            first = is_start ? std::max<int64_t>(row, 0)
+                             : std::min<int64_t>(row + 1, n);
+            break;
+          }
+        }
+        (is_start ? *starts : *ends)[i] = first;
+      }
+    }
+    return;
+  }
+  // In a RANGE frame, the distance from row i to each row only grows along
+  // the partition, and only shrinks as i moves forward, so the frame
+  // boundaries can be found by moving them forward.
+  int64_t start = 0;
+  int64_t end = 0;
+  for (int64_t i = 0; i < n; ++i) {
+    while (start < n && CompareToBoundary(frame.start, i, start) < 0) {
+      ++start;
+    }
+    while (end < n && CompareToBoundary(frame.end, i, end) <= 0) ++end;
+    (*starts)[i] = start;
+    (*ends)[i] = end;
+  }
+}
+
+zetasql_base::Status AnalyticEvaluator::EvaluatePartition() {
+  const int64_t n = partition_.size();
+  std::vector<int64_t> starts;
+  std::vector<int64_t> ends;
+  std::vector<std::vector<Value>> results(analytics_.size());
+  for (int a = 0; a < analytics_.size(); ++a) {
+    const Analytic& analytic = analytics_[a].analytic;
+    const Type* output_type = analytics_[a].output_type;
+    std::vector<Value>& values = results[a];
+    values.reserve(n);
+    ComputeFrames(analytic.frame, &starts, &ends);
+
+    if (analytic.function == kMin || analytic.function == kMax) {
+      std::vector<Value> arguments;
+      arguments.reserve(n);
+      for (const std::vector<Value>& row : partition_) {
+        arguments.push_back(row[analytic.argument]);
+      }
+      const MinMaxTree tree(analytic.function == kMax, output_type,
+                            std::move(arguments));
+      for (int64_t i = 0; i < n; ++i) {
+        values.push_back(starts[i] < ends[i]
+                             ? tree.Get(starts[i], ends[i], output_type)
+                             : Value::Null(output_type));
+      }
+      continue;
+    }
+
+    const Value no_argument;
+    SlidingAggregate aggregate(
+        analytic.function,
+        analytic.argument < 0
+            ? TYPE_UNKNOWN
+            : column_types_[analytic.argument]->kind());
+    auto argument = [&](int64_t row) -> const Value& {
+      return analytic.argument < 0 ? no_argument
+                                   : partition_[row][analytic.argument];
+    };
+    // The aggregate is over rows [first, last). An empty frame is kept at
+    // its start, so that both only move forward.
+    int64_t first = 0;
+    int64_t last = 0;
+    for (int64_t i = 0; i < n; ++i) {
+      const int64_t start = starts[i];
+      const int64_t end = std::max(starts[i], ends[i]);
+      for (; last < end; ++last) aggregate.Add(argument(last));
+      for (; first < start; ++first) aggregate.Remove(argument(first));
+      ZETASQL_ASSIGN_OR_RETURN(Value value, aggregate.GetValue(output_type));
+      values.push_back(std::move(value));
+    }
+  }
+  for (int64_t i = 0; i < n; ++i) {
+    for (std::vector<Value>& values : results) {
+      partition_[i].push_back(std::move(values[i]));
+    }
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+}  // namespace local_service
+}  // namespace zetasql
@@ -0,0 +1,192 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef ZETASQL_LOCAL_SERVICE_ANALYTIC_EVALUATOR_H_
+#define ZETASQL_LOCAL_SERVICE_ANALYTIC_EVALUATOR_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/local_service/sort_key_encoder.h"
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "absl/types/span.h"
+#include "zetasql/base/status.h"
+#include "zetasql/base/statusor.h"
+
+namespace zetasql {
+namespace local_service {
+
+// Computes aggregate analytic functions over window frames, as for the
+// functions of a ResolvedAnalyticFunctionGroup. Output rows have the columns
+// of the input followed by one column per analytic function.
+//
+// The input must be sorted by the partitioning columns and then by the
+// ordering keys, e.g. by an ExternalSorter with the keys from
+// AppendAnalyticGroupKeys(). Rows are read one partition at a time, so a
+// partition must fit in memory.
+//
+// The frame of each row is found by moving its first and last rows forward
+// from those of the previous row, which is possible because both only move
+// forward as the current row does, for ROWS and RANGE frames alike. COUNT,
+// SUM and AVG then add the rows entering the frame and remove those leaving
+// it, so each row costs O(1) whatever the size of its frame. MIN and MAX
+// cannot remove a value, and instead query a segment tree over the
+// partition in O(log n). Framed window queries therefore take time
+// roughly linear in the input rather than proportional to the total size of
+// the frames.
+//
+// In a RANGE frame with an offset, NULL and NaN keys are peers of equal keys
+// and infinitely far from any number, on the side where they sort.
+//
+// Example:
+//   std::vector<SortKey> order_keys;
+//   ZETASQL_RETURN_IF_ERROR(AppendOrderByKeys(group->order_by()->order_by_item_list(),
+//                                     input_scan->column_list(), &order_keys));
+//   ZETASQL_ASSIGN_OR_RETURN(
+//       AnalyticEvaluator::Analytic analytic,
+//       AnalyticEvaluator::AnalyticForCall(call, /*argument=*/1));
+//   ZETASQL_ASSIGN_OR_RETURN(
+//       std::unique_ptr<AnalyticEvaluator> evaluator,
+//       AnalyticEvaluator::Create(std::move(sorted_input),
+//                                 /*partition_columns=*/{0},
+//                                 std::move(order_keys), {analytic}));
+//
+// This class is not thread-safe, except for Cancel().
+class AnalyticEvaluator : public EvaluatorTableIterator {
+ public:
+  enum AnalyticFunction {
+    kCount,      // COUNT(x)
+    kCountStar,  // COUNT(*)
+    kSum,        // SUM(x) of INT64, UINT64, DOUBLE or NUMERIC
+    kAvg,        // AVG(x) of INT64, UINT64, DOUBLE or NUMERIC
+    kMin,        // MIN(x)
+    kMax,        // MAX(x)
+  };
+
+  struct FrameBoundary {
+    ResolvedWindowFrameExpr::BoundaryType type;
+    // The offset for OFFSET_PRECEDING and OFFSET_FOLLOWING: an INT64 number
+    // of rows in a ROWS frame, and in a RANGE frame a value of the type of
+    // the only ordering key.
+    Value offset;
+  };
+
+  // The default frame is RANGE BETWEEN UNBOUNDED PRECEDING AND CURRENT ROW,
+  // which is the whole partition if there are no ordering keys.
+  struct WindowFrame {
+    ResolvedWindowFrame::FrameUnit unit = ResolvedWindowFrame::RANGE;
+    FrameBoundary start = {ResolvedWindowFrameExpr::UNBOUNDED_PRECEDING,
+                           Value()};
+    FrameBoundary end = {ResolvedWindowFrameExpr::CURRENT_ROW, Value()};
+  };
+
+  struct Analytic {
+    AnalyticFunction function;
+    // The input column of the argument. Unused for kCountStar.
+    int argument = -1;
+    WindowFrame frame;
+  };
+
+  AnalyticEvaluator(const AnalyticEvaluator&) = delete;
+  AnalyticEvaluator& operator=(const AnalyticEvaluator&) = delete;
+  ~AnalyticEvaluator() override;
+
+  // Returns the Analytic for <call>, whose argument (if any) is in input
+  // column <argument>. Returns kUnimplemented for functions that are not
+  // listed above, for DISTINCT, IGNORE NULLS and SAFE calls, and for frame
+  // offsets that are not literals.
+  static zetasql_base::StatusOr<Analytic> AnalyticForCall(
+      const ResolvedAnalyticFunctionCall* call, int argument);
+
+  // Returns an iterator over the rows of <input> with the values of
+  // <analytics> appended. Partitions are delimited by changes in the values
+  // of <partition_columns>, and rows whose <order_keys> columns are equal
+  // are peers. A RANGE frame with an offset requires exactly one ordering
+  // key, of a numeric type. <input> must not have been read yet.
+  static zetasql_base::StatusOr<std::unique_ptr<AnalyticEvaluator>> Create(
+      std::unique_ptr<EvaluatorTableIterator> input,
+      absl::Span<const int> partition_columns,
+      std::vector<SortKey> order_keys, absl::Span<const Analytic> analytics);
+
+  int NumColumns() const override { return column_types_.size(); }
+  std::string GetColumnName(int i) const override;
+  const Type* GetColumnType(int i) const override { return column_types_[i]; }
+  bool NextRow() override;
+  const Value& GetValue(int i) const override {
+    return partition_[current_row_][i];
+  }
+  zetasql_base::Status Status() const override { return status_; }
+  zetasql_base::Status Cancel() override;
+
+  int64_t num_partitions() const { return num_partitions_; }
+
+ private:
+  struct AnalyticInfo;
+
+  AnalyticEvaluator(std::unique_ptr<EvaluatorTableIterator> input,
+                    std::vector<SortKey> order_keys);
+
+  zetasql_base::Status InitAnalytic(const Analytic& analytic, AnalyticInfo* info);
+  zetasql_base::Status CheckBoundary(const FrameBoundary& boundary,
+                             ResolvedWindowFrame::FrameUnit unit) const;
+
+  // Reads the rows of the next partition into partition_, which is left
+  // empty at the end of the input.
+  zetasql_base::Status ReadPartition();
+  // Appends the value of each analytic to each row of partition_.
+  zetasql_base::Status EvaluatePartition();
+
+  // Sets <*starts> and <*ends> to the first row and one past the last row
+  // of the frame of each row of the partition.
+  void ComputeFrames(const WindowFrame& frame, std::vector<int64_t>* starts,
+                     std::vector<int64_t>* ends) const;
+  // Returns the sign of the distance from row <row> to row <other> in the
+  // direction of the ordering, minus the offset of <boundary>.
+  int CompareToBoundary(const FrameBoundary& boundary, int64_t row,
+                        int64_t other) const;
+  bool IsPeer(int64_t row, int64_t other) const;
+
+  std::unique_ptr<EvaluatorTableIterator> input_;
+  const std::vector<SortKey> order_keys_;
+  std::vector<int> partition_columns_;
+  std::vector<AnalyticInfo> analytics_;
+  int num_input_columns_ = 0;
+  std::vector<const Type*> column_types_;
+
+  // The rows of the current partition, with their analytic values.
+  std::vector<std::vector<Value>> partition_;
+  int64_t current_row_ = -1;
+  // The first row of the next partition, if it has been read.
+  std::vector<Value> next_row_;
+  bool have_next_row_ = false;
+  bool input_done_ = false;
+  int64_t num_partitions_ = 0;
+
+  zetasql_base::Status status_;
+  std::atomic<bool> cancelled_{false};
+};
+
+}  // namespace local_service
+}  // namespace zetasql
+
+#endif  // ZETASQL_LOCAL_SERVICE_ANALYTIC_EVALUATOR_H_
@@ -0,0 +1,381 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "zetasql/local_service/analytic_evaluator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/local_service/sort_key_encoder.h"
+#include "zetasql/public/builtin_function.pb.h"
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+
+namespace zetasql {
+namespace local_service {
+
+using ::testing::ElementsAre;
+using zetasql_base::testing::StatusIs;
+
+typedef AnalyticEvaluator::Analytic Analytic;
+typedef AnalyticEvaluator::FrameBoundary FrameBoundary;
+
+// Returns <rows>, which have <types>.
+class RowIterator : public EvaluatorTableIterator {
+ public:
+  RowIterator(std::vector<const Type*> types,
+              std::vector<std::vector<Value>> rows)
+      : types_(std::move(types)), rows_(std::move(rows)) {}
+
+  int NumColumns() const override { return types_.size(); }
+  std::string GetColumnName(int i) const override { return ""; }
+  const Type* GetColumnType(int i) const override { return types_[i]; }
+  bool NextRow() override { return ++row_ < rows_.size(); }
+  const Value& GetValue(int i) const override { return rows_[row_][i]; }
+  zetasql_base::Status Status() const override { return zetasql_base::OkStatus(); }
+  zetasql_base::Status Cancel() override { return zetasql_base::OkStatus(); }
+
+ private:
+  std::vector<const Type*> types_;
+  std::vector<std::vector<Value>> rows_;
+  int row_ = -1;
+};
+
+FrameBoundary Boundary(ResolvedWindowFrameExpr::BoundaryType type,
+                       Value offset = Value()) {
+  return {type, offset};
+}
+
+Analytic MakeAnalytic(AnalyticEvaluator::AnalyticFunction function,
+                      int argument, ResolvedWindowFrame::FrameUnit unit,
+                      FrameBoundary start, FrameBoundary end) {
+  Analytic analytic;
+  analytic.function = function;
+  analytic.argument = argument;
+  analytic.frame.unit = unit;
+  analytic.frame.start = start;
+  analytic.frame.end = end;
+  return analytic;
+}
+
+// Returns the values of output column <column> of <evaluator>.
+std::vector<Value> ReadColumn(int column, EvaluatorTableIterator* evaluator) {
+  std::vector<Value> values;
+  while (evaluator->NextRow()) values.push_back(evaluator->GetValue(column));
+  ZETASQL_EXPECT_OK(evaluator->Status());
+  return values;
+}
+
+// Compares ROWS frames with every combination of boundaries to a direct
+// computation over each frame.
+TEST(AnalyticEvaluatorTest, RowsFramesMatchDirectComputation) {
+  // Rows are (partition, value), in partitions of 1, 7 and 20 rows.
+  std::vector<std::vector<Value>> rows;
+  std::vector<int> partition_starts;
+  for (const int size : {1, 7, 20}) {
+    partition_starts.push_back(rows.size());
+    for (int i = 0; i < size; ++i) {
+      rows.push_back({Value::Int64(size),
+                      i % 5 == 3 ? Value::NullInt64()
+                                 : Value::Int64((i * 37) % 11 - 5)});
+    }
+  }
+  partition_starts.push_back(rows.size());
+
+  const std::vector<FrameBoundary> boundaries = {
+      Boundary(ResolvedWindowFrameExpr::UNBOUNDED_PRECEDING),
+      Boundary(ResolvedWindowFrameExpr::OFFSET_PRECEDING, Value::Int64(3)),
+      Boundary(ResolvedWindowFrameExpr::OFFSET_PRECEDING, Value::Int64(0)),
+      Boundary(ResolvedWindowFrameExpr::CURRENT_ROW),
+      Boundary(ResolvedWindowFrameExpr::OFFSET_FOLLOWING, Value::Int64(1)),
+      Boundary(ResolvedWindowFrameExpr::OFFSET_FOLLOWING, Value::Int64(30)),
+      Boundary(ResolvedWindowFrameExpr::UNBOUNDED_FOLLOWING),
+  };
+  // The signed offset of each boundary, with +-1000 for UNBOUNDED.
+  const std::vector<int64_t> offsets = {-1000, -3, 0, 0, 1, 30, 1000};
+  for (int s = 0; s + 1 < boundaries.size(); ++s) {
+    for (int e = 1; e < boundaries.size(); ++e) {
+      std::vector<Analytic> analytics;
+      for (const auto function :
+           {AnalyticEvaluator::kCount, AnalyticEvaluator::kCountStar,
+            AnalyticEvaluator::kSum, AnalyticEvaluator::kMin,
+            AnalyticEvaluator::kMax}) {
+        analytics.push_back(MakeAnalytic(function, 1, ResolvedWindowFrame::ROWS,
+                                         boundaries[s], boundaries[e]));
+      }
+      ZETASQL_ASSERT_OK_AND_ASSIGN(
+          std::unique_ptr<AnalyticEvaluator> evaluator,
+          AnalyticEvaluator::Create(
+              absl::make_unique<RowIterator>(
+                  std::vector<const Type*>{types::Int64Type(),
+                                           types::Int64Type()},
+                  rows),
+              /*partition_columns=*/{0}, /*order_keys=*/{}, analytics));
+      for (int p = 0; p + 1 < partition_starts.size(); ++p) {
+        const int first = partition_starts[p];
+        const int last = partition_starts[p + 1];
+        for (int i = first; i < last; ++i) {
+          ASSERT_TRUE(evaluator->NextRow()) << evaluator->Status();
+          int64_t count = 0, count_star = 0, sum = 0;
+          Value min = Value::NullInt64(), max = Value::NullInt64();
+          const int start = std::max<int64_t>(first, i + offsets[s]);
+          const int end = std::min<int64_t>(last - 1, i + offsets[e]);
+          for (int j = start; j <= end; ++j) {
+            ++count_star;
+            const Value& value = rows[j][1];
+            if (value.is_null()) continue;
+            ++count;
+            sum += value.int64_value();
+            if (min.is_null() || value.LessThan(min)) min = value;
+            if (max.is_null() || max.LessThan(value)) max = value;
+          }
+          const std::string frame =
+              absl::StrCat("frame ", s, "-", e, " row ", i);
+          EXPECT_EQ(Value::Int64(count), evaluator->GetValue(2)) << frame;
+          EXPECT_EQ(Value::Int64(count_star), evaluator->GetValue(3)) << frame;
+          EXPECT_EQ(count == 0 ? Value::NullInt64() : Value::Int64(sum),
+                    evaluator->GetValue(4))
+              << frame;
+          EXPECT_EQ(min, evaluator->GetValue(5)) << frame;
+          EXPECT_EQ(max, evaluator->GetValue(6)) << frame;
+        }
+      }
+      EXPECT_FALSE(evaluator->NextRow());
+      ZETASQL_EXPECT_OK(evaluator->Status());
+      EXPECT_EQ(3, evaluator->num_partitions());
+    }
+  }
+}
+
+TEST(AnalyticEvaluatorTest, RangeFrameWithOffsets) {
+  // Rows are (key, value), sorted by key with NULLs first.
+  const std::vector<std::vector<Value>> rows = {
+      {Value::NullInt64(), Value::Int64(1)}, {Value::Int64(1), Value::Int64(2)},
+      {Value::Int64(2), Value::Int64(3)},    {Value::Int64(2), Value::Int64(4)},
+      {Value::Int64(5), Value::Int64(5)},    {Value::Int64(9), Value::Int64(6)}};
+  const Analytic analytic = MakeAnalytic(
+      AnalyticEvaluator::kSum, 1, ResolvedWindowFrame::RANGE,
+      Boundary(ResolvedWindowFrameExpr::OFFSET_PRECEDING, Value::Int64(1)),
+      Boundary(ResolvedWindowFrameExpr::OFFSET_FOLLOWING, Value::Int64(1)));
+  SortKey key;
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<AnalyticEvaluator> evaluator,
+      AnalyticEvaluator::Create(
+          absl::make_unique<RowIterator>(
+              std::vector<const Type*>{types::Int64Type(), types::Int64Type()},
+              rows),
+          /*partition_columns=*/{}, {key}, {analytic}));
+  EXPECT_THAT(ReadColumn(2, evaluator.get()),
+              ElementsAre(Value::Int64(1), Value::Int64(9), Value::Int64(9),
+                          Value::Int64(9), Value::Int64(5), Value::Int64(6)));
+
+  // The same rows in descending order, with NULLs last.
+  std::vector<std::vector<Value>> descending_rows(rows.rbegin(), rows.rend());
+  key.descending = true;
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      evaluator,
+      AnalyticEvaluator::Create(
+          absl::make_unique<RowIterator>(
+              std::vector<const Type*>{types::Int64Type(), types::Int64Type()},
+              descending_rows),
+          /*partition_columns=*/{}, {key}, {analytic}));
+  EXPECT_THAT(ReadColumn(2, evaluator.get()),
+              ElementsAre(Value::Int64(6), Value::Int64(5), Value::Int64(9),
+                          Value::Int64(9), Value::Int64(9), Value::Int64(1)));
+}
+
+TEST(AnalyticEvaluatorTest, DefaultFrameIncludesPeers) {
+  const std::vector<std::vector<Value>> rows = {
+      {Value::String("a"), Value::Double(1)},
+      {Value::String("b"), Value::Double(2)},
+      {Value::String("b"), Value::Double(4)},
+      {Value::String("c"), Value::Double(8)}};
+  Analytic analytic;
+  analytic.function = AnalyticEvaluator::kAvg;
+  analytic.argument = 1;
+  SortKey key;
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<AnalyticEvaluator> evaluator,
+      AnalyticEvaluator::Create(
+          absl::make_unique<RowIterator>(
+              std::vector<const Type*>{types::StringType(),
+                                       types::DoubleType()},
+              rows),
+          /*partition_columns=*/{}, {key}, {analytic}));
+  EXPECT_THAT(ReadColumn(2, evaluator.get()),
+              ElementsAre(Value::Double(1), Value::Double(7.0 / 3),
+                          Value::Double(7.0 / 3), Value::Double(15.0 / 4)));
+
+  // Without ordering keys, all rows are peers.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      evaluator,
+      AnalyticEvaluator::Create(
+          absl::make_unique<RowIterator>(
+              std::vector<const Type*>{types::StringType(),
+                                       types::DoubleType()},
+              rows),
+          /*partition_columns=*/{}, /*order_keys=*/{}, {analytic}));
+  EXPECT_THAT(ReadColumn(2, evaluator.get()),
+              ElementsAre(Value::Double(15.0 / 4), Value::Double(15.0 / 4),
+                          Value::Double(15.0 / 4), Value::Double(15.0 / 4)));
+}
+
+TEST(AnalyticEvaluatorTest, SlidingDoubleSumRemovesNonFiniteValues) {
+  const double inf = std::numeric_limits<double>::infinity();
+  std::vector<std::vector<Value>> rows;
+  for (const double d : {1.0, inf, 2.0, std::nan(""), 3.0, -inf, 4.0, 5.0}) {
+    rows.push_back({Value::Double(d)});
+  }
+  const Analytic analytic = MakeAnalytic(
+      AnalyticEvaluator::kSum, 0, ResolvedWindowFrame::ROWS,
+      Boundary(ResolvedWindowFrameExpr::OFFSET_PRECEDING, Value::Int64(1)),
+      Boundary(ResolvedWindowFrameExpr::CURRENT_ROW));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<AnalyticEvaluator> evaluator,
+      AnalyticEvaluator::Create(
+          absl::make_unique<RowIterator>(
+              std::vector<const Type*>{types::DoubleType()}, rows),
+          /*partition_columns=*/{}, /*order_keys=*/{}, {analytic}));
+  const std::vector<Value> sums = ReadColumn(1, evaluator.get());
+  ASSERT_EQ(rows.size(), sums.size());
+  EXPECT_EQ(Value::Double(1), sums[0]);
+  EXPECT_EQ(Value::Double(inf), sums[1]);
+  EXPECT_EQ(Value::Double(inf), sums[2]);
+  EXPECT_TRUE(std::isnan(sums[3].double_value()));
+  EXPECT_TRUE(std::isnan(sums[4].double_value()));
+  EXPECT_EQ(Value::Double(-inf), sums[5]);
+  EXPECT_EQ(Value::Double(-inf), sums[6]);
+  EXPECT_EQ(Value::Double(9), sums[7]);
+}
+
+TEST(AnalyticEvaluatorTest, SumOverflow) {
+  const int64_t max = std::numeric_limits<int64_t>::max();
+  // The running sum overflows at the second row, but a frame of one row
+  // never does.
+  const std::vector<std::vector<Value>> rows = {
+      {Value::Int64(max)}, {Value::Int64(max)}, {Value::Int64(-max)}};
+  for (const bool overflow : {false, true}) {
+    const Analytic analytic = MakeAnalytic(
+        AnalyticEvaluator::kSum, 0, ResolvedWindowFrame::ROWS,
+        Boundary(overflow ? ResolvedWindowFrameExpr::UNBOUNDED_PRECEDING
+                          : ResolvedWindowFrameExpr::CURRENT_ROW),
+        Boundary(ResolvedWindowFrameExpr::CURRENT_ROW));
+    ZETASQL_ASSERT_OK_AND_ASSIGN(
+        std::unique_ptr<AnalyticEvaluator> evaluator,
+        AnalyticEvaluator::Create(
+            absl::make_unique<RowIterator>(
+                std::vector<const Type*>{types::Int64Type()}, rows),
+            /*partition_columns=*/{}, /*order_keys=*/{}, {analytic}));
+    while (evaluator->NextRow()) {
+    }
+    if (overflow) {
+      EXPECT_THAT(evaluator->Status(),
+                  StatusIs(zetasql_base::StatusCode::kOutOfRange));
+    } else {
+      ZETASQL_EXPECT_OK(evaluator->Status());
+    }
+  }
+}
+
+TEST(AnalyticEvaluatorTest, Errors) {
+  auto create = [](const Analytic& analytic, std::vector<SortKey> keys) {
+    return AnalyticEvaluator::Create(
+               absl::make_unique<RowIterator>(
+                   std::vector<const Type*>{types::StringType(),
+                                            types::Int64Type()},
+                   std::vector<std::vector<Value>>()),
+               /*partition_columns=*/{}, std::move(keys), {analytic})
+        .status();
+  };
+  SortKey string_key;
+  SortKey int_key;
+  int_key.column = 1;
+  // RANGE offsets need a single numeric ordering key.
+  const Analytic range = MakeAnalytic(
+      AnalyticEvaluator::kCountStar, -1, ResolvedWindowFrame::RANGE,
+      Boundary(ResolvedWindowFrameExpr::OFFSET_PRECEDING, Value::Int64(1)),
+      Boundary(ResolvedWindowFrameExpr::CURRENT_ROW));
+  ZETASQL_EXPECT_OK(create(range, {int_key}));
+  EXPECT_THAT(create(range, {string_key}),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+  EXPECT_THAT(create(range, {int_key, string_key}),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+
+  const Analytic negative = MakeAnalytic(
+      AnalyticEvaluator::kCountStar, -1, ResolvedWindowFrame::ROWS,
+      Boundary(ResolvedWindowFrameExpr::OFFSET_PRECEDING, Value::Int64(-1)),
+      Boundary(ResolvedWindowFrameExpr::CURRENT_ROW));
+  EXPECT_THAT(create(negative, {}),
+              StatusIs(zetasql_base::StatusCode::kOutOfRange));
+
+  const Analytic sum_of_strings = MakeAnalytic(
+      AnalyticEvaluator::kSum, 0, ResolvedWindowFrame::ROWS,
+      Boundary(ResolvedWindowFrameExpr::UNBOUNDED_PRECEDING),
+      Boundary(ResolvedWindowFrameExpr::CURRENT_ROW));
+  EXPECT_THAT(create(sum_of_strings, {}),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+}
+
+TEST(AnalyticEvaluatorTest, AnalyticForCall) {
+  const Function sum("sum", Function::kZetaSQLFunctionGroupName,
+                     Function::AGGREGATE);
+  auto call = [&sum](bool distinct) {
+    return MakeResolvedAnalyticFunctionCall(
+        types::Int64Type(), &sum,
+        FunctionSignature(types::Int64Type(), {types::Int64Type()},
+                          FN_SUM_INT64),
+        /*argument_list=*/{}, ResolvedFunctionCall::DEFAULT_ERROR_MODE,
+        distinct, ResolvedAnalyticFunctionCall::DEFAULT_NULL_HANDLING,
+        MakeResolvedWindowFrame(
+            ResolvedWindowFrame::ROWS,
+            MakeResolvedWindowFrameExpr(
+                ResolvedWindowFrameExpr::OFFSET_PRECEDING,
+                MakeResolvedLiteral(Value::Int64(2))),
+            MakeResolvedWindowFrameExpr(ResolvedWindowFrameExpr::CURRENT_ROW,
+                                        /*expression=*/nullptr)));
+  };
+  ZETASQL_ASSERT_OK_AND_ASSIGN(const Analytic analytic,
+                       AnalyticEvaluator::AnalyticForCall(
+                           call(/*distinct=*/false).get(), /*argument=*/3));
+  EXPECT_EQ(AnalyticEvaluator::kSum, analytic.function);
+  EXPECT_EQ(3, analytic.argument);
+  EXPECT_EQ(ResolvedWindowFrame::ROWS, analytic.frame.unit);
+  EXPECT_EQ(ResolvedWindowFrameExpr::OFFSET_PRECEDING,
+            analytic.frame.start.type);
+  EXPECT_EQ(Value::Int64(2), analytic.frame.start.offset);
+  EXPECT_EQ(ResolvedWindowFrameExpr::CURRENT_ROW, analytic.frame.end.type);
+  EXPECT_THAT(AnalyticEvaluator::AnalyticForCall(call(/*distinct=*/true).get(),
+                                                 /*argument=*/3)
+                  .status(),
+              StatusIs(zetasql_base::StatusCode::kUnimplemented));
+}
+
+}  // namespace local_service
+}  // namespace zetasql
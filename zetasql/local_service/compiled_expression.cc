@@ -0,0 +1,1334 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "zetasql/local_service/compiled_expression.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/local_service/function_metrics.h"
+#include "zetasql/public/functions/arithmetics.h"
+#include "zetasql/public/functions/comparison.h"
+#include "zetasql/public/functions/date_time_util.h"
+#include "zetasql/public/numeric_value.h"
+#include "zetasql/resolved_ast/resolved_node_kind.pb.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/source_location.h"
+#include "zetasql/base/status_builder.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+namespace local_service {
+
+namespace {
+
+using Arguments = absl::Span<const Value* const>;
+
+// Same as CompiledExpression::FunctionImpl.
+using FunctionImpl = zetasql_base::Status (*)(Arguments args, Value* result);
+
+// Signature of the binary arithmetic functions in arithmetics.h.
+template <typename T>
+using ArithmeticFunction = bool (*)(T, T, T*, zetasql_base::Status*);
+
+template <typename T, ArithmeticFunction<T> function>
+zetasql_base::Status BinaryArithmetic(Arguments args, Value* result) {
+  T out;
+  zetasql_base::Status error;
+  if (!function(args[0]->Get<T>(), args[1]->Get<T>(), &out, &error)) {
+    return error;
+  }
+  *result = Value::Make<T>(out);
+  return ::zetasql_base::OkStatus();
+}
+
+// UINT64 subtraction, which gives an INT64.
+zetasql_base::Status SubtractUint64(Arguments args, Value* result) {
+  int64_t out;
+  zetasql_base::Status error;
+  if (!functions::Subtract<uint64_t, int64_t>(
+          args[0]->uint64_value(), args[1]->uint64_value(), &out, &error)) {
+    return error;
+  }
+  *result = Value::Int64(out);
+  return ::zetasql_base::OkStatus();
+}
+
+template <typename T>
+zetasql_base::Status UnaryMinus(Arguments args, Value* result) {
+  T out;
+  zetasql_base::Status error;
+  if (!functions::UnaryMinus<T, T>(args[0]->Get<T>(), &out, &error)) {
+    return error;
+  }
+  *result = Value::Make<T>(out);
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status ConcatString(Arguments args, Value* result) {
+  std::string out;
+  for (const Value* arg : args) {
+    absl::StrAppend(&out, arg->string_value());
+  }
+  *result = Value::String(out);
+  return ::zetasql_base::OkStatus();
+}
+
+// Signature of AddDate() and SubDate() in date_time_util.h.
+using DateArithmeticFunction = zetasql_base::Status (*)(
+    int32_t, functions::DateTimestampPart, int64_t, int32_t*);
+
+// DATE_ADD and DATE_SUB, whose last argument is the date part enum.
+template <DateArithmeticFunction function>
+zetasql_base::Status DateArithmetic(Arguments args, Value* result) {
+  int32_t out;
+  ZETASQL_RETURN_IF_ERROR(function(
+      args[0]->date_value(),
+      static_cast<functions::DateTimestampPart>(args[2]->enum_value()),
+      args[1]->int64_value(), &out));
+  *result = Value::Date(out);
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status DateDiff(Arguments args, Value* result) {
+  int32_t out;
+  ZETASQL_RETURN_IF_ERROR(functions::DiffDates(
+      args[0]->date_value(), args[1]->date_value(),
+      static_cast<functions::DateTimestampPart>(args[2]->enum_value()), &out));
+  *result = Value::Int64(out);
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status Not(Arguments args, Value* result) {
+  *result = Value::Bool(!args[0]->bool_value());
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status IsNull(Arguments args, Value* result) {
+  *result = Value::Bool(args[0]->is_null());
+  return ::zetasql_base::OkStatus();
+}
+
+template <bool value>
+zetasql_base::Status IsBool(Arguments args, Value* result) {
+  *result = Value::Bool(!args[0]->is_null() && args[0]->bool_value() == value);
+  return ::zetasql_base::OkStatus();
+}
+
+// Comparison of two values of the C++ type T, with the semantics of
+// <Compare>, e.g. std::less.
+template <typename T, template <typename> class Compare>
+zetasql_base::Status TypedComparison(Arguments args, Value* result) {
+  *result = Value::Bool(Compare<T>()(args[0]->Get<T>(), args[1]->Get<T>()));
+  return ::zetasql_base::OkStatus();
+}
+
+template <template <typename> class Compare>
+zetasql_base::Status CompareInt64Uint64(Arguments args, Value* result) {
+  *result = Value::Bool(Compare<int64_t>()(
+      functions::Compare64(args[0]->int64_value(), args[1]->uint64_value()),
+      0));
+  return ::zetasql_base::OkStatus();
+}
+
+template <template <typename> class Compare>
+zetasql_base::Status CompareUint64Int64(Arguments args, Value* result) {
+  *result = Value::Bool(Compare<int64_t>()(
+      0,
+      functions::Compare64(args[1]->int64_value(), args[0]->uint64_value())));
+  return ::zetasql_base::OkStatus();
+}
+
+enum class ComparisonKind {
+  kEqual,
+  kNotEqual,
+  kLess,
+  kLessOrEqual,
+  kGreater,
+  kGreaterOrEqual
+};
+
+// Comparison of values of any type, using Value::SqlEquals() and
+// Value::SqlLessThan().
+template <ComparisonKind kind>
+zetasql_base::Status GenericComparison(Arguments args, Value* result) {
+  const Value& x = *args[0];
+  const Value& y = *args[1];
+  Value out;
+  switch (kind) {
+    case ComparisonKind::kEqual:
+      out = x.SqlEquals(y);
+      break;
+    case ComparisonKind::kNotEqual:
+      out = x.SqlEquals(y);
+      if (out.is_valid()) out = Value::Bool(!out.bool_value());
+      break;
+    case ComparisonKind::kLess:
+      out = x.SqlLessThan(y);
+      break;
+    case ComparisonKind::kGreater:
+      out = y.SqlLessThan(x);
+      break;
+    case ComparisonKind::kLessOrEqual:
+    case ComparisonKind::kGreaterOrEqual: {
+      // Not the negation of the strict comparison, which would be true for
+      // NaNs.
+      const Value strict = kind == ComparisonKind::kLessOrEqual
+                               ? x.SqlLessThan(y)
+                               : y.SqlLessThan(x);
+      const Value equal = x.SqlEquals(y);
+      if (strict.is_valid() && equal.is_valid()) {
+        out = Value::Bool(strict.bool_value() || equal.bool_value());
+      }
+      break;
+    }
+  }
+  if (!out.is_valid()) {
+    return ::zetasql_base::UnimplementedErrorBuilder(ZETASQL_LOC)
+           << "Cannot compare " << x.type()->DebugString() << " and "
+           << y.type()->DebugString();
+  }
+  *result = out;
+  return ::zetasql_base::OkStatus();
+}
+
+// Returns the comparison for arguments of <type>, with a typed fast path for
+// the types whose C++ comparison has the SQL semantics.
+template <template <typename> class Compare, ComparisonKind kind>
+FunctionImpl BindComparison(const Type* type) {
+  switch (type->kind()) {
+    case TYPE_INT64:
+      return &TypedComparison<int64_t, Compare>;
+    case TYPE_UINT64:
+      return &TypedComparison<uint64_t, Compare>;
+    case TYPE_DOUBLE:
+      return &TypedComparison<double, Compare>;
+    case TYPE_BOOL:
+      return &TypedComparison<bool, Compare>;
+    default:
+      return &GenericComparison<kind>;
+  }
+}
+
+// A value of one of the types of the native tier, without the boxing of
+// Value. <string_value> points into a Value that outlives the evaluation,
+// or into the <storage> of a register.
+struct NativeScalar {
+  bool is_null = false;
+  // The value of any type but STRING. ENUM values are in int64_value.
+  union {
+    int64_t int64_value;
+    uint64_t uint64_value;
+    double double_value;
+    bool bool_value;
+    int32_t date_value;
+  } value{};
+  absl::string_view string_value;
+  std::string storage;
+};
+
+bool IsNativeType(const Type* type) {
+  switch (type->kind()) {
+    case TYPE_INT64:
+    case TYPE_UINT64:
+    case TYPE_DOUBLE:
+    case TYPE_BOOL:
+    case TYPE_DATE:
+    case TYPE_STRING:
+    case TYPE_ENUM:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Sets <*scalar> to <value>, whose type must satisfy IsNativeType().
+void Unbox(const Value& value, NativeScalar* scalar) {
+  scalar->is_null = value.is_null();
+  if (value.is_null()) return;
+  switch (value.type_kind()) {
+    case TYPE_INT64:
+      scalar->value.int64_value = value.int64_value();
+      break;
+    case TYPE_UINT64:
+      scalar->value.uint64_value = value.uint64_value();
+      break;
+    case TYPE_DOUBLE:
+      scalar->value.double_value = value.double_value();
+      break;
+    case TYPE_BOOL:
+      scalar->value.bool_value = value.bool_value();
+      break;
+    case TYPE_DATE:
+      scalar->value.date_value = value.date_value();
+      break;
+    case TYPE_STRING:
+      scalar->string_value = value.string_value();
+      break;
+    case TYPE_ENUM:
+      scalar->value.int64_value = value.enum_value();
+      break;
+    default:
+      break;
+  }
+}
+
+Value Box(const NativeScalar& scalar, const Type* type) {
+  if (scalar.is_null) return Value::Null(type);
+  switch (type->kind()) {
+    case TYPE_INT64:
+      return Value::Int64(scalar.value.int64_value);
+    case TYPE_UINT64:
+      return Value::Uint64(scalar.value.uint64_value);
+    case TYPE_DOUBLE:
+      return Value::Double(scalar.value.double_value);
+    case TYPE_BOOL:
+      return Value::Bool(scalar.value.bool_value);
+    case TYPE_DATE:
+      return Value::Date(scalar.value.date_value);
+    case TYPE_STRING:
+      return Value::String(scalar.string_value);
+    case TYPE_ENUM:
+      return Value::Enum(type->AsEnum(), scalar.value.int64_value);
+    default:
+      return Value();
+  }
+}
+
+// Copies <from> to <*to>. If <copy_string>, the string is copied into the
+// storage of <*to>, so that it stays valid when <from> changes.
+void CopyScalar(const NativeScalar& from, bool copy_string, NativeScalar* to) {
+  to->is_null = from.is_null;
+  to->value = from.value;
+  if (copy_string) {
+    to->storage.assign(from.string_value.data(), from.string_value.size());
+    to->string_value = to->storage;
+  } else {
+    to->string_value = from.string_value;
+  }
+}
+
+// The field of NativeScalar that holds the C++ type T, with DATE as
+// int32_t.
+template <typename T>
+T Get(const NativeScalar& scalar);
+template <>
+int64_t Get<int64_t>(const NativeScalar& scalar) {
+  return scalar.value.int64_value;
+}
+template <>
+uint64_t Get<uint64_t>(const NativeScalar& scalar) {
+  return scalar.value.uint64_value;
+}
+template <>
+double Get<double>(const NativeScalar& scalar) {
+  return scalar.value.double_value;
+}
+template <>
+bool Get<bool>(const NativeScalar& scalar) {
+  return scalar.value.bool_value;
+}
+template <>
+int32_t Get<int32_t>(const NativeScalar& scalar) {
+  return scalar.value.date_value;
+}
+template <>
+absl::string_view Get<absl::string_view>(const NativeScalar& scalar) {
+  return scalar.string_value;
+}
+
+template <typename T>
+void Set(T value, NativeScalar* scalar);
+template <>
+void Set<int64_t>(int64_t value, NativeScalar* scalar) {
+  scalar->is_null = false;
+  scalar->value.int64_value = value;
+}
+template <>
+void Set<uint64_t>(uint64_t value, NativeScalar* scalar) {
+  scalar->is_null = false;
+  scalar->value.uint64_value = value;
+}
+template <>
+void Set<double>(double value, NativeScalar* scalar) {
+  scalar->is_null = false;
+  scalar->value.double_value = value;
+}
+template <>
+void Set<bool>(bool value, NativeScalar* scalar) {
+  scalar->is_null = false;
+  scalar->value.bool_value = value;
+}
+template <>
+void Set<int32_t>(int32_t value, NativeScalar* scalar) {
+  scalar->is_null = false;
+  scalar->value.date_value = value;
+}
+
+// A builtin function of the native tier, which sets <*result> from the
+// <num_args> values of <args>, or returns false with <*error> set. The
+// kernels are templates over the functions of public/functions, so that
+// those are inlined.
+using NativeKernel = bool (*)(const NativeScalar* const* args, int num_args,
+                              NativeScalar* result,
+                              zetasql_base::Status* error);
+
+template <typename T, ArithmeticFunction<T> function>
+bool NativeArithmetic(const NativeScalar* const* args, int num_args,
+                      NativeScalar* result, zetasql_base::Status* error) {
+  T out;
+  if (!function(Get<T>(*args[0]), Get<T>(*args[1]), &out, error)) {
+    return false;
+  }
+  Set<T>(out, result);
+  return true;
+}
+
+bool NativeSubtractUint64(const NativeScalar* const* args, int num_args,
+                          NativeScalar* result, zetasql_base::Status* error) {
+  int64_t out;
+  if (!functions::Subtract<uint64_t, int64_t>(Get<uint64_t>(*args[0]),
+                                              Get<uint64_t>(*args[1]), &out,
+                                              error)) {
+    return false;
+  }
+  Set<int64_t>(out, result);
+  return true;
+}
+
+template <typename T>
+bool NativeUnaryMinus(const NativeScalar* const* args, int num_args,
+                      NativeScalar* result, zetasql_base::Status* error) {
+  T out;
+  if (!functions::UnaryMinus<T, T>(Get<T>(*args[0]), &out, error)) {
+    return false;
+  }
+  Set<T>(out, result);
+  return true;
+}
+
+template <typename T, template <typename> class Compare>
+bool NativeComparison(const NativeScalar* const* args, int num_args,
+                      NativeScalar* result, zetasql_base::Status* error) {
+  Set<bool>(Compare<T>()(Get<T>(*args[0]), Get<T>(*args[1])), result);
+  return true;
+}
+
+template <template <typename> class Compare>
+bool NativeCompareInt64Uint64(const NativeScalar* const* args, int num_args,
+                              NativeScalar* result,
+                              zetasql_base::Status* error) {
+  Set<bool>(Compare<int64_t>()(functions::Compare64(Get<int64_t>(*args[0]),
+                                                    Get<uint64_t>(*args[1])),
+                               0),
+            result);
+  return true;
+}
+
+template <template <typename> class Compare>
+bool NativeCompareUint64Int64(const NativeScalar* const* args, int num_args,
+                              NativeScalar* result,
+                              zetasql_base::Status* error) {
+  Set<bool>(Compare<int64_t>()(
+                0, functions::Compare64(Get<int64_t>(*args[1]),
+                                        Get<uint64_t>(*args[0]))),
+            result);
+  return true;
+}
+
+bool NativeNot(const NativeScalar* const* args, int num_args,
+               NativeScalar* result, zetasql_base::Status* error) {
+  Set<bool>(!Get<bool>(*args[0]), result);
+  return true;
+}
+
+bool NativeIsNull(const NativeScalar* const* args, int num_args,
+                  NativeScalar* result, zetasql_base::Status* error) {
+  Set<bool>(args[0]->is_null, result);
+  return true;
+}
+
+template <bool value>
+bool NativeIsBool(const NativeScalar* const* args, int num_args,
+                  NativeScalar* result, zetasql_base::Status* error) {
+  Set<bool>(!args[0]->is_null && Get<bool>(*args[0]) == value, result);
+  return true;
+}
+
+// The result is written to the storage of <*result>, which is never one of
+// <args>.
+bool NativeConcatString(const NativeScalar* const* args, int num_args,
+                        NativeScalar* result, zetasql_base::Status* error) {
+  result->storage.clear();
+  for (int i = 0; i < num_args; ++i) {
+    absl::StrAppend(&result->storage, args[i]->string_value);
+  }
+  result->is_null = false;
+  result->string_value = result->storage;
+  return true;
+}
+
+template <DateArithmeticFunction function>
+bool NativeDateArithmetic(const NativeScalar* const* args, int num_args,
+                          NativeScalar* result, zetasql_base::Status* error) {
+  int32_t out;
+  *error = function(
+      Get<int32_t>(*args[0]),
+      static_cast<functions::DateTimestampPart>(Get<int64_t>(*args[2])),
+      Get<int64_t>(*args[1]), &out);
+  if (!error->ok()) return false;
+  Set<int32_t>(out, result);
+  return true;
+}
+
+bool NativeDateDiff(const NativeScalar* const* args, int num_args,
+                    NativeScalar* result, zetasql_base::Status* error) {
+  int32_t out;
+  *error = functions::DiffDates(
+      Get<int32_t>(*args[0]), Get<int32_t>(*args[1]),
+      static_cast<functions::DateTimestampPart>(Get<int64_t>(*args[2])), &out);
+  if (!error->ok()) return false;
+  Set<int64_t>(out, result);
+  return true;
+}
+
+// Returns the native comparison for arguments of <type>, or null.
+template <template <typename> class Compare>
+NativeKernel BindNativeComparison(const Type* type) {
+  switch (type->kind()) {
+    case TYPE_INT64:
+      return &NativeComparison<int64_t, Compare>;
+    case TYPE_UINT64:
+      return &NativeComparison<uint64_t, Compare>;
+    case TYPE_DOUBLE:
+      return &NativeComparison<double, Compare>;
+    case TYPE_BOOL:
+      return &NativeComparison<bool, Compare>;
+    case TYPE_DATE:
+      return &NativeComparison<int32_t, Compare>;
+    case TYPE_STRING:
+      return &NativeComparison<absl::string_view, Compare>;
+    default:
+      return nullptr;
+  }
+}
+
+// Returns the native kernel of builtin function <id> with arguments of
+// <argument_types>, or null if there is none.
+NativeKernel BindNativeKernel(FunctionSignatureId id,
+                              const std::vector<const Type*>& argument_types) {
+  const Type* first_type =
+      argument_types.empty() ? nullptr : argument_types[0];
+  switch (id) {
+    case FN_NOT:
+      return &NativeNot;
+    case FN_IS_NULL:
+      return &NativeIsNull;
+    case FN_IS_TRUE:
+      return &NativeIsBool<true>;
+    case FN_IS_FALSE:
+      return &NativeIsBool<false>;
+
+    case FN_EQUAL:
+      return BindNativeComparison<std::equal_to>(first_type);
+    case FN_NOT_EQUAL:
+      return BindNativeComparison<std::not_equal_to>(first_type);
+    case FN_LESS:
+      return BindNativeComparison<std::less>(first_type);
+    case FN_LESS_OR_EQUAL:
+      return BindNativeComparison<std::less_equal>(first_type);
+    case FN_GREATER:
+      return BindNativeComparison<std::greater>(first_type);
+    case FN_GREATER_OR_EQUAL:
+      return BindNativeComparison<std::greater_equal>(first_type);
+    case FN_NOT_EQUAL_INT64_UINT64:
+      return &NativeCompareInt64Uint64<std::not_equal_to>;
+    case FN_NOT_EQUAL_UINT64_INT64:
+      return &NativeCompareUint64Int64<std::not_equal_to>;
+    case FN_LESS_INT64_UINT64:
+      return &NativeCompareInt64Uint64<std::less>;
+    case FN_LESS_UINT64_INT64:
+      return &NativeCompareUint64Int64<std::less>;
+    case FN_LESS_OR_EQUAL_INT64_UINT64:
+      return &NativeCompareInt64Uint64<std::less_equal>;
+    case FN_LESS_OR_EQUAL_UINT64_INT64:
+      return &NativeCompareUint64Int64<std::less_equal>;
+    case FN_GREATER_INT64_UINT64:
+      return &NativeCompareInt64Uint64<std::greater>;
+    case FN_GREATER_UINT64_INT64:
+      return &NativeCompareUint64Int64<std::greater>;
+    case FN_GREATER_OR_EQUAL_INT64_UINT64:
+      return &NativeCompareInt64Uint64<std::greater_equal>;
+    case FN_GREATER_OR_EQUAL_UINT64_INT64:
+      return &NativeCompareUint64Int64<std::greater_equal>;
+
+    case FN_ADD_INT64:
+      return &NativeArithmetic<int64_t, functions::Add<int64_t>>;
+    case FN_ADD_UINT64:
+      return &NativeArithmetic<uint64_t, functions::Add<uint64_t>>;
+    case FN_ADD_DOUBLE:
+      return &NativeArithmetic<double, functions::Add<double>>;
+    case FN_SUBTRACT_INT64:
+      return &NativeArithmetic<int64_t, functions::Subtract<int64_t, int64_t>>;
+    case FN_SUBTRACT_UINT64:
+      return &NativeSubtractUint64;
+    case FN_SUBTRACT_DOUBLE:
+      return &NativeArithmetic<double, functions::Subtract<double, double>>;
+    case FN_MULTIPLY_INT64:
+      return &NativeArithmetic<int64_t, functions::Multiply<int64_t>>;
+    case FN_MULTIPLY_UINT64:
+      return &NativeArithmetic<uint64_t, functions::Multiply<uint64_t>>;
+    case FN_MULTIPLY_DOUBLE:
+      return &NativeArithmetic<double, functions::Multiply<double>>;
+    case FN_DIVIDE_DOUBLE:
+      return &NativeArithmetic<double, functions::Divide<double>>;
+    case FN_DIV_INT64:
+      return &NativeArithmetic<int64_t, functions::Divide<int64_t>>;
+    case FN_DIV_UINT64:
+      return &NativeArithmetic<uint64_t, functions::Divide<uint64_t>>;
+    case FN_MOD_INT64:
+      return &NativeArithmetic<int64_t, functions::Modulo<int64_t>>;
+    case FN_MOD_UINT64:
+      return &NativeArithmetic<uint64_t, functions::Modulo<uint64_t>>;
+    case FN_CONCAT_STRING:
+      return &NativeConcatString;
+    case FN_DATE_ADD_DATE:
+      return &NativeDateArithmetic<functions::AddDate>;
+    case FN_DATE_SUB_DATE:
+      return &NativeDateArithmetic<functions::SubDate>;
+    case FN_DATE_DIFF_DATE:
+      return &NativeDateDiff;
+
+    case FN_UNARY_MINUS_INT64:
+      return &NativeUnaryMinus<int64_t>;
+    case FN_UNARY_MINUS_DOUBLE:
+      return &NativeUnaryMinus<double>;
+    default:
+      return nullptr;
+  }
+}
+
+}  // namespace
+
+// Generates the bytecode for a ResolvedExpr, assigning slots to expression
+// columns and parameters as they are found.
+//
+// Registers are allocated as a stack: the result register of a call is
+// allocated before compiling its arguments, and the registers above it are
+// freed once the call has been emitted.
+class CompiledExpression::Compiler {
+ public:
+  explicit Compiler(CompiledExpression* expression) : expression_(expression) {}
+
+  zetasql_base::StatusOr<Operand> Compile(const ResolvedExpr* expr) {
+    switch (expr->node_kind()) {
+      case RESOLVED_LITERAL:
+        expression_->constants_.push_back(
+            expr->GetAs<ResolvedLiteral>()->value());
+        return Operand{Operand::kConstant,
+                       static_cast<int>(expression_->constants_.size() - 1)};
+      case RESOLVED_EXPRESSION_COLUMN:
+        return Operand{
+            Operand::kColumn,
+            Slot(expr->GetAs<ResolvedExpressionColumn>()->name(), expr->type(),
+                 &expression_->column_names_, &expression_->column_types_)};
+      case RESOLVED_PARAMETER: {
+        const ResolvedParameter* parameter = expr->GetAs<ResolvedParameter>();
+        if (parameter->name().empty()) {
+          return ::zetasql_base::UnimplementedErrorBuilder(ZETASQL_LOC)
+                 << "Positional parameters are not supported in prepared "
+                    "expressions";
+        }
+        return Operand{Operand::kParameter,
+                       Slot(parameter->name(), expr->type(),
+                            &expression_->parameter_names_,
+                            &expression_->parameter_types_)};
+      }
+      case RESOLVED_FUNCTION_CALL:
+        return CompileFunctionCall(expr->GetAs<ResolvedFunctionCall>());
+      default:
+        return ::zetasql_base::UnimplementedErrorBuilder(ZETASQL_LOC)
+               << "Unsupported expression in prepared expression: "
+               << expr->node_kind_string();
+    }
+  }
+
+ private:
+  zetasql_base::StatusOr<Operand> CompileFunctionCall(
+      const ResolvedFunctionCall* call) {
+    const FunctionSignatureId id =
+        static_cast<FunctionSignatureId>(call->signature().context_id());
+    if (!call->function()->IsZetaSQLBuiltin()) {
+      return UnsupportedFunction(call);
+    }
+    const auto& arguments = call->argument_list();
+    const int dest = AllocateRegister();
+    switch (id) {
+      case FN_AND:
+      case FN_OR: {
+        const bool exit_value = id == FN_OR;
+        expression_->constants_.push_back(Value::Bool(!exit_value));
+        Emit(MakeInstruction(Instruction::kMove, dest),
+             {Operand{Operand::kConstant,
+                      static_cast<int>(expression_->constants_.size() - 1)}});
+        std::vector<int> exits;
+        for (const auto& argument : arguments) {
+          ZETASQL_ASSIGN_OR_RETURN(const Operand operand, Compile(argument.get()));
+          Instruction logical = MakeInstruction(Instruction::kLogical, dest);
+          logical.exit_value = exit_value;
+          exits.push_back(Emit(logical, {operand}));
+          FreeRegistersAbove(dest);
+        }
+        PatchJumps(exits);
+        break;
+      }
+      case FN_IF: {
+        ZETASQL_RET_CHECK_EQ(arguments.size(), 3);
+        ZETASQL_ASSIGN_OR_RETURN(const Operand condition, Compile(arguments[0].get()));
+        const int to_else_pc =
+            Emit(MakeInstruction(Instruction::kJumpUnlessTrue), {condition});
+        FreeRegistersAbove(dest);
+        ZETASQL_RETURN_IF_ERROR(CompileInto(arguments[1].get(), dest));
+        const int to_end_pc = Emit(MakeInstruction(Instruction::kJump));
+        PatchJumps({to_else_pc});
+        ZETASQL_RETURN_IF_ERROR(CompileInto(arguments[2].get(), dest));
+        PatchJumps({to_end_pc});
+        break;
+      }
+      case FN_IFNULL:
+      case FN_COALESCE: {
+        // If all arguments are NULL, dest ends up holding the NULL of the
+        // last one, which has the output type.
+        std::vector<int> exits;
+        for (int i = 0; i < arguments.size(); ++i) {
+          ZETASQL_RETURN_IF_ERROR(CompileInto(arguments[i].get(), dest));
+          if (i + 1 < arguments.size()) {
+            exits.push_back(Emit(MakeInstruction(Instruction::kJumpIfNotNull),
+                                 {Operand{Operand::kRegister, dest}}));
+          }
+        }
+        PatchJumps(exits);
+        break;
+      }
+      default: {
+        bool takes_nulls = false;
+        const FunctionImpl function = BindFunction(id, call, &takes_nulls);
+        if (function == nullptr) return UnsupportedFunction(call);
+        Instruction instruction = MakeInstruction(
+            takes_nulls ? Instruction::kCallWithNulls : Instruction::kCall,
+            dest);
+        std::vector<Operand> operands;
+        for (const auto& argument : arguments) {
+          ZETASQL_ASSIGN_OR_RETURN(const Operand operand, Compile(argument.get()));
+          operands.push_back(operand);
+        }
+        instruction.function = function;
+        instruction.function_id = id;
+        instruction.output_type = call->type();
+        instruction.safe =
+            call->error_mode() == ResolvedFunctionCall::SAFE_ERROR_MODE;
+        Emit(instruction, operands);
+        FreeRegistersAbove(dest);
+        break;
+      }
+    }
+    return Operand{Operand::kRegister, dest};
+  }
+
+  // Compiles <expr> and moves its value to register <dest>.
+  zetasql_base::Status CompileInto(const ResolvedExpr* expr, int dest) {
+    ZETASQL_ASSIGN_OR_RETURN(const Operand operand, Compile(expr));
+    if (operand.source != Operand::kRegister || operand.index != dest) {
+      Emit(MakeInstruction(Instruction::kMove, dest), {operand});
+    }
+    FreeRegistersAbove(dest);
+    return ::zetasql_base::OkStatus();
+  }
+
+  // Returns the implementation of builtin function <id>, or null if it is
+  // not supported.
+  static FunctionImpl BindFunction(FunctionSignatureId id,
+                                   const ResolvedFunctionCall* call,
+                                   bool* takes_nulls) {
+    const Type* first_type = call->argument_list_size() > 0
+                                 ? call->argument_list(0)->type()
+                                 : nullptr;
+    switch (id) {
+      case FN_NOT:
+        return &Not;
+      case FN_IS_NULL:
+        *takes_nulls = true;
+        return &IsNull;
+      case FN_IS_TRUE:
+        *takes_nulls = true;
+        return &IsBool<true>;
+      case FN_IS_FALSE:
+        *takes_nulls = true;
+        return &IsBool<false>;
+
+      case FN_EQUAL:
+        return BindComparison<std::equal_to, ComparisonKind::kEqual>(
+            first_type);
+      case FN_NOT_EQUAL:
+        return BindComparison<std::not_equal_to, ComparisonKind::kNotEqual>(
+            first_type);
+      case FN_LESS:
+        return BindComparison<std::less, ComparisonKind::kLess>(first_type);
+      case FN_LESS_OR_EQUAL:
+        return BindComparison<std::less_equal, ComparisonKind::kLessOrEqual>(
+            first_type);
+      case FN_GREATER:
+        return BindComparison<std::greater, ComparisonKind::kGreater>(
+            first_type);
+      case FN_GREATER_OR_EQUAL:
+        return BindComparison<std::greater_equal,
+                              ComparisonKind::kGreaterOrEqual>(first_type);
+      case FN_NOT_EQUAL_INT64_UINT64:
+        return &CompareInt64Uint64<std::not_equal_to>;
+      case FN_NOT_EQUAL_UINT64_INT64:
+        return &CompareUint64Int64<std::not_equal_to>;
+      case FN_LESS_INT64_UINT64:
+        return &CompareInt64Uint64<std::less>;
+      case FN_LESS_UINT64_INT64:
+        return &CompareUint64Int64<std::less>;
+      case FN_LESS_OR_EQUAL_INT64_UINT64:
+        return &CompareInt64Uint64<std::less_equal>;
+      case FN_LESS_OR_EQUAL_UINT64_INT64:
+        return &CompareUint64Int64<std::less_equal>;
+      case FN_GREATER_INT64_UINT64:
+        return &CompareInt64Uint64<std::greater>;
+      case FN_GREATER_UINT64_INT64:
+        return &CompareUint64Int64<std::greater>;
+      case FN_GREATER_OR_EQUAL_INT64_UINT64:
+        return &CompareInt64Uint64<std::greater_equal>;
+      case FN_GREATER_OR_EQUAL_UINT64_INT64:
+        return &CompareUint64Int64<std::greater_equal>;
+
+      case FN_ADD_INT64:
+        return &BinaryArithmetic<int64_t, functions::Add<int64_t>>;
+      case FN_ADD_UINT64:
+        return &BinaryArithmetic<uint64_t, functions::Add<uint64_t>>;
+      case FN_ADD_DOUBLE:
+        return &BinaryArithmetic<double, functions::Add<double>>;
+      case FN_ADD_NUMERIC:
+        return &BinaryArithmetic<NumericValue, functions::Add<NumericValue>>;
+      case FN_SUBTRACT_INT64:
+        return &BinaryArithmetic<int64_t,
+                                 functions::Subtract<int64_t, int64_t>>;
+      case FN_SUBTRACT_UINT64:
+        return &SubtractUint64;
+      case FN_SUBTRACT_DOUBLE:
+        return &BinaryArithmetic<double, functions::Subtract<double, double>>;
+      case FN_SUBTRACT_NUMERIC:
+        return &BinaryArithmetic<
+            NumericValue, functions::Subtract<NumericValue, NumericValue>>;
+      case FN_MULTIPLY_INT64:
+        return &BinaryArithmetic<int64_t, functions::Multiply<int64_t>>;
+      case FN_MULTIPLY_UINT64:
+        return &BinaryArithmetic<uint64_t, functions::Multiply<uint64_t>>;
+      case FN_MULTIPLY_DOUBLE:
+        return &BinaryArithmetic<double, functions::Multiply<double>>;
+      case FN_MULTIPLY_NUMERIC:
+        return &BinaryArithmetic<NumericValue,
+                                 functions::Multiply<NumericValue>>;
+      case FN_DIVIDE_DOUBLE:
+        return &BinaryArithmetic<double, functions::Divide<double>>;
+      case FN_DIVIDE_NUMERIC:
+        return &BinaryArithmetic<NumericValue, functions::Divide<NumericValue>>;
+      case FN_DIV_INT64:
+        return &BinaryArithmetic<int64_t, functions::Divide<int64_t>>;
+      case FN_DIV_UINT64:
+        return &BinaryArithmetic<uint64_t, functions::Divide<uint64_t>>;
+      case FN_DIV_NUMERIC:
+        return &BinaryArithmetic<NumericValue, functions::IntegerDivide>;
+      case FN_MOD_INT64:
+        return &BinaryArithmetic<int64_t, functions::Modulo<int64_t>>;
+      case FN_MOD_UINT64:
+        return &BinaryArithmetic<uint64_t, functions::Modulo<uint64_t>>;
+      case FN_MOD_NUMERIC:
+        return &BinaryArithmetic<NumericValue, functions::Modulo<NumericValue>>;
+      case FN_CONCAT_STRING:
+        return &ConcatString;
+      case FN_DATE_ADD_DATE:
+        return &DateArithmetic<functions::AddDate>;
+      case FN_DATE_SUB_DATE:
+        return &DateArithmetic<functions::SubDate>;
+      case FN_DATE_DIFF_DATE:
+        return &DateDiff;
+
+      case FN_UNARY_MINUS_INT64:
+        return &UnaryMinus<int64_t>;
+      case FN_UNARY_MINUS_DOUBLE:
+        return &UnaryMinus<double>;
+      case FN_UNARY_MINUS_NUMERIC:
+        return &UnaryMinus<NumericValue>;
+      default:
+        return nullptr;
+    }
+  }
+
+  static zetasql_base::Status UnsupportedFunction(const ResolvedFunctionCall* call) {
+    return ::zetasql_base::UnimplementedErrorBuilder(ZETASQL_LOC)
+           << "Unsupported function in prepared expression: "
+           << call->function()->SQLName();
+  }
+
+  static Instruction MakeInstruction(Instruction::Opcode opcode,
+                                     int dest = -1) {
+    Instruction instruction;
+    instruction.opcode = opcode;
+    instruction.dest = dest;
+    return instruction;
+  }
+
+  // Appends <instruction> with <arguments> and returns its index.
+  int Emit(Instruction instruction,
+           const std::vector<Operand>& arguments = {}) {
+    instruction.first_argument = expression_->operands_.size();
+    instruction.num_arguments = arguments.size();
+    expression_->operands_.insert(expression_->operands_.end(),
+                                  arguments.begin(), arguments.end());
+    if (instruction.num_arguments > expression_->max_arguments_) {
+      expression_->max_arguments_ = instruction.num_arguments;
+    }
+    expression_->instructions_.push_back(instruction);
+    return expression_->instructions_.size() - 1;
+  }
+
+  // Makes the jumps at <pcs> go to the next instruction emitted.
+  void PatchJumps(const std::vector<int>& pcs) {
+    for (const int pc : pcs) {
+      expression_->instructions_[pc].target =
+          expression_->instructions_.size();
+    }
+  }
+
+  int AllocateRegister() {
+    const int reg = next_register_++;
+    if (next_register_ > expression_->num_registers_) {
+      expression_->num_registers_ = next_register_;
+    }
+    return reg;
+  }
+
+  void FreeRegistersAbove(int reg) { next_register_ = reg + 1; }
+
+  // Returns the slot of <name> in <names>, adding it with <type> if it is
+  // new.
+  static int Slot(const std::string& name, const Type* type,
+                  std::vector<std::string>* names,
+                  std::vector<const Type*>* types) {
+    const std::string lower_name = absl::AsciiStrToLower(name);
+    for (int i = 0; i < names->size(); ++i) {
+      if ((*names)[i] == lower_name) return i;
+    }
+    names->push_back(lower_name);
+    types->push_back(type);
+    return names->size() - 1;
+  }
+
+  CompiledExpression* expression_;
+  int next_register_ = 0;
+};
+
+// The native tier of a CompiledExpression: the same instructions and
+// operands, with a kernel bound to each call and the constants unboxed.
+// Registers and slots hold NativeScalars instead of Values.
+class CompiledExpression::NativeProgram {
+ public:
+  NativeProgram(const NativeProgram&) = delete;
+  NativeProgram& operator=(const NativeProgram&) = delete;
+
+  // Returns the native translation of the bytecode of <expression>, which
+  // must outlive it, or null if the bytecode uses a type or a function
+  // that has no native kernel.
+  static std::unique_ptr<const NativeProgram> Translate(
+      const CompiledExpression& expression) {
+    auto program = absl::WrapUnique(new NativeProgram(expression));
+    if (!IsNativeType(expression.output_type_)) return nullptr;
+    for (const Type* type : expression.column_types_) {
+      if (!IsNativeType(type)) return nullptr;
+    }
+    for (const Type* type : expression.parameter_types_) {
+      if (!IsNativeType(type)) return nullptr;
+    }
+    for (const Value& constant : expression.constants_) {
+      if (!IsNativeType(constant.type())) return nullptr;
+      program->constants_.emplace_back();
+      Unbox(constant, &program->constants_.back());
+    }
+
+    // The type of the value in each register, as the instructions are
+    // visited in order. Every register is written before it is read.
+    std::vector<const Type*> register_types(expression.num_registers_);
+    auto operand_type = [&](const Operand& operand) -> const Type* {
+      switch (operand.source) {
+        case Operand::kRegister:
+          return register_types[operand.index];
+        case Operand::kConstant:
+          return expression.constants_[operand.index].type();
+        case Operand::kColumn:
+          return expression.column_types_[operand.index];
+        case Operand::kParameter:
+          return expression.parameter_types_[operand.index];
+      }
+    };
+    for (const Instruction& instruction : expression.instructions_) {
+      NativeInstruction native;
+      std::vector<const Type*> argument_types;
+      for (int i = 0; i < instruction.num_arguments; ++i) {
+        const Type* type = operand_type(
+            expression.operands_[instruction.first_argument + i]);
+        if (type == nullptr) return nullptr;
+        argument_types.push_back(type);
+      }
+      switch (instruction.opcode) {
+        case Instruction::kCall:
+        case Instruction::kCallWithNulls:
+          if (!IsNativeType(instruction.output_type)) return nullptr;
+          native.kernel =
+              BindNativeKernel(instruction.function_id, argument_types);
+          if (native.kernel == nullptr) return nullptr;
+          register_types[instruction.dest] = instruction.output_type;
+          break;
+        case Instruction::kMove:
+          native.copy_string =
+              argument_types[0]->IsString() &&
+              expression.operands_[instruction.first_argument].source ==
+                  Operand::kRegister;
+          register_types[instruction.dest] = argument_types[0];
+          break;
+        case Instruction::kLogical:
+          register_types[instruction.dest] = types::BoolType();
+          break;
+        case Instruction::kJump:
+        case Instruction::kJumpUnlessTrue:
+        case Instruction::kJumpIfNotNull:
+          break;
+      }
+      program->instructions_.push_back(native);
+    }
+    if (operand_type(expression.result_) == nullptr) return nullptr;
+    return std::unique_ptr<const NativeProgram>(std::move(program));
+  }
+
+  // Same as CompiledExpression::Evaluate(), whose checks of the arguments
+  // have already been done.
+  zetasql_base::StatusOr<Value> Evaluate(absl::Span<const Value> columns,
+                                 absl::Span<const Value> parameters) const {
+    const CompiledExpression& expression = expression_;
+    std::vector<NativeScalar> registers(expression.num_registers_);
+    std::vector<NativeScalar> native_columns(columns.size());
+    for (int i = 0; i < columns.size(); ++i) {
+      Unbox(columns[i], &native_columns[i]);
+    }
+    std::vector<NativeScalar> native_parameters(parameters.size());
+    for (int i = 0; i < parameters.size(); ++i) {
+      Unbox(parameters[i], &native_parameters[i]);
+    }
+    std::vector<const NativeScalar*> args(expression.max_arguments_);
+    auto get = [&](const Operand& operand) -> const NativeScalar& {
+      switch (operand.source) {
+        case Operand::kRegister:
+          return registers[operand.index];
+        case Operand::kConstant:
+          return constants_[operand.index];
+        case Operand::kColumn:
+          return native_columns[operand.index];
+        case Operand::kParameter:
+          return native_parameters[operand.index];
+      }
+    };
+    int pc = 0;
+    while (pc < expression.instructions_.size()) {
+      const NativeInstruction& native = instructions_[pc];
+      const Instruction& instruction = expression.instructions_[pc++];
+      switch (instruction.opcode) {
+        case Instruction::kCall:
+        case Instruction::kCallWithNulls: {
+          bool has_null = false;
+          for (int i = 0; i < instruction.num_arguments; ++i) {
+            args[i] =
+                &get(expression.operands_[instruction.first_argument + i]);
+            has_null |= args[i]->is_null;
+          }
+          NativeScalar* dest = &registers[instruction.dest];
+          if (has_null && instruction.opcode == Instruction::kCall) {
+            dest->is_null = true;
+            break;
+          }
+          zetasql_base::Status error;
+          bool ok;
+          {
+            FunctionKernelCallRecorder recorder(instruction.function_id);
+            ok = native.kernel(args.data(), instruction.num_arguments, dest,
+                               &error);
+          }
+          if (!ok) {
+            if (!instruction.safe ||
+                error.code() != zetasql_base::StatusCode::kOutOfRange) {
+              return error;
+            }
+            dest->is_null = true;
+          }
+          break;
+        }
+        case Instruction::kMove:
+          CopyScalar(get(expression.operands_[instruction.first_argument]),
+                     native.copy_string, &registers[instruction.dest]);
+          break;
+        case Instruction::kLogical: {
+          const NativeScalar& arg =
+              get(expression.operands_[instruction.first_argument]);
+          if (arg.is_null) {
+            registers[instruction.dest].is_null = true;
+          } else if (arg.value.bool_value == instruction.exit_value) {
+            Set<bool>(arg.value.bool_value, &registers[instruction.dest]);
+            pc = instruction.target;
+          }
+          break;
+        }
+        case Instruction::kJump:
+          pc = instruction.target;
+          break;
+        case Instruction::kJumpUnlessTrue: {
+          const NativeScalar& arg =
+              get(expression.operands_[instruction.first_argument]);
+          if (arg.is_null || !arg.value.bool_value) pc = instruction.target;
+          break;
+        }
+        case Instruction::kJumpIfNotNull:
+          if (!get(expression.operands_[instruction.first_argument]).is_null) {
+            pc = instruction.target;
+          }
+          break;
+      }
+    }
+    return Box(get(expression.result_), expression.output_type_);
+  }
+
+ private:
+  struct NativeInstruction {
+    // For kCall and kCallWithNulls.
+    NativeKernel kernel = nullptr;
+    // For kMove, true if the string of the operand must be copied because
+    // it is in a register that may be reused.
+    bool copy_string = false;
+  };
+
+  explicit NativeProgram(const CompiledExpression& expression)
+      : expression_(expression) {}
+
+  const CompiledExpression& expression_;
+  // One per instruction of <expression_>.
+  std::vector<NativeInstruction> instructions_;
+  // The unboxed constants of <expression_>.
+  std::vector<NativeScalar> constants_;
+};
+
+constexpr int64_t CompiledExpression::kDefaultNativeTierThreshold;
+
+CompiledExpression::CompiledExpression() {}
+
+CompiledExpression::~CompiledExpression() {}
+
+zetasql_base::StatusOr<std::unique_ptr<const CompiledExpression>>
+CompiledExpression::Compile(const ResolvedExpr* expr,
+                            int64_t native_tier_threshold) {
+  ZETASQL_RET_CHECK(expr != nullptr);
+  std::unique_ptr<CompiledExpression> expression(new CompiledExpression);
+  expression->native_tier_threshold_ = native_tier_threshold;
+  Compiler compiler(expression.get());
+  ZETASQL_ASSIGN_OR_RETURN(expression->result_, compiler.Compile(expr));
+  expression->output_type_ = expr->type();
+  return std::unique_ptr<const CompiledExpression>(std::move(expression));
+}
+
+const Value& CompiledExpression::GetOperand(
+    const Operand& operand, absl::Span<const Value> registers,
+    absl::Span<const Value> columns, absl::Span<const Value> parameters) const {
+  switch (operand.source) {
+    case Operand::kRegister:
+      return registers[operand.index];
+    case Operand::kConstant:
+      return constants_[operand.index];
+    case Operand::kColumn:
+      return columns[operand.index];
+    case Operand::kParameter:
+      return parameters[operand.index];
+  }
+}
+
+zetasql_base::StatusOr<Value> CompiledExpression::Evaluate(
+    absl::Span<const Value> columns, absl::Span<const Value> parameters) const {
+  ZETASQL_RET_CHECK_EQ(columns.size(), column_names_.size());
+  ZETASQL_RET_CHECK_EQ(parameters.size(), parameter_names_.size());
+  if (const NativeProgram* native_program = GetNativeProgram()) {
+    return native_program->Evaluate(columns, parameters);
+  }
+  std::vector<Value> registers(num_registers_);
+  std::vector<const Value*> args(max_arguments_);
+  auto get = [&](const Operand& operand) -> const Value& {
+    return GetOperand(operand, registers, columns, parameters);
+  };
+  int pc = 0;
+  while (pc < instructions_.size()) {
+    const Instruction& instruction = instructions_[pc++];
+    switch (instruction.opcode) {
+      case Instruction::kCall:
+      case Instruction::kCallWithNulls: {
+        bool has_null = false;
+        for (int i = 0; i < instruction.num_arguments; ++i) {
+          args[i] = &get(operands_[instruction.first_argument + i]);
+          has_null |= args[i]->is_null();
+        }
+        Value* dest = &registers[instruction.dest];
+        if (has_null && instruction.opcode == Instruction::kCall) {
+          *dest = Value::Null(instruction.output_type);
+          break;
+        }
+        zetasql_base::Status status;
+        {
+          FunctionKernelCallRecorder recorder(instruction.function_id);
+          status = instruction.function(
+              absl::MakeConstSpan(args.data(), instruction.num_arguments),
+              dest);
+        }
+        if (!status.ok()) {
+          if (!instruction.safe ||
+              status.code() != zetasql_base::StatusCode::kOutOfRange) {
+            return status;
+          }
+          *dest = Value::Null(instruction.output_type);
+        }
+        break;
+      }
+      case Instruction::kMove:
+        registers[instruction.dest] = get(operands_[instruction.first_argument]);
+        break;
+      case Instruction::kLogical: {
+        const Value& arg = get(operands_[instruction.first_argument]);
+        if (arg.is_null()) {
+          registers[instruction.dest] = Value::NullBool();
+        } else if (arg.bool_value() == instruction.exit_value) {
+          registers[instruction.dest] = arg;
+          pc = instruction.target;
+        }
+        break;
+      }
+      case Instruction::kJump:
+        pc = instruction.target;
+        break;
+      case Instruction::kJumpUnlessTrue: {
+        const Value& arg = get(operands_[instruction.first_argument]);
+        if (arg.is_null() || !arg.bool_value()) pc = instruction.target;
+        break;
+      }
+      case Instruction::kJumpIfNotNull:
+        if (!get(operands_[instruction.first_argument]).is_null()) pc = instruction.target;
+        break;
+    }
+  }
+  return get(result_);
+}
+
+const CompiledExpression::NativeProgram* CompiledExpression::GetNativeProgram()
+    const {
+  if (native_tier_threshold_ < 0) return nullptr;
+  if (num_evaluations_.load(std::memory_order_relaxed) <
+      native_tier_threshold_) {
+    num_evaluations_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  absl::call_once(native_program_once_, [this]() {
+    native_program_ = NativeProgram::Translate(*this);
+  });
+  return native_program_.get();
+}
+
+bool CompiledExpression::uses_native_tier() const {
+  return native_tier_threshold_ >= 0 &&
+         num_evaluations_.load(std::memory_order_relaxed) >=
+             native_tier_threshold_ &&
+         GetNativeProgram() != nullptr;
+}
+
+std::string CompiledExpression::OperandString(const Operand& operand) const {
+  switch (operand.source) {
+    case Operand::kRegister:
+      return absl::StrCat("r", operand.index);
+    case Operand::kConstant:
+      return constants_[operand.index].FullDebugString();
+    case Operand::kColumn:
+      return column_names_[operand.index];
+    case Operand::kParameter:
+      return absl::StrCat("@", parameter_names_[operand.index]);
+  }
+}
+
+std::string CompiledExpression::DebugString() const {
+  std::string out;
+  for (int pc = 0; pc < instructions_.size(); ++pc) {
+    const Instruction& instruction = instructions_[pc];
+    std::vector<std::string> arguments;
+    for (int i = 0; i < instruction.num_arguments; ++i) {
+      arguments.push_back(
+          OperandString(operands_[instruction.first_argument + i]));
+    }
+    const std::string dest = absl::StrCat("r", instruction.dest);
+    const std::string target = absl::StrCat(instruction.target);
+    absl::StrAppend(&out, pc, ": ");
+    switch (instruction.opcode) {
+      case Instruction::kCall:
+      case Instruction::kCallWithNulls:
+        absl::StrAppend(&out, dest, " = ", instruction.safe ? "SAFE." : "",
+                        FunctionSignatureId_Name(instruction.function_id), "(",
+                        absl::StrJoin(arguments, ", "), ")");
+        break;
+      case Instruction::kMove:
+        absl::StrAppend(&out, dest, " = ", arguments[0]);
+        break;
+      case Instruction::kLogical:
+        absl::StrAppend(&out, instruction.exit_value ? "OR " : "AND ", dest,
+                        ", ", arguments[0], ", exit to ", target);
+        break;
+      case Instruction::kJump:
+        absl::StrAppend(&out, "jump to ", target);
+        break;
+      case Instruction::kJumpUnlessTrue:
+        absl::StrAppend(&out, "unless ", arguments[0], " jump to ", target);
+        break;
+      case Instruction::kJumpIfNotNull:
+        absl::StrAppend(&out, "if ", arguments[0], " is not NULL jump to ",
+                        target);
+        break;
+    }
+    absl::StrAppend(&out, "\n");
+  }
+  absl::StrAppend(&out, "result: ", OperandString(result_), "\n");
+  return out;
+}
+
+}  // namespace local_service
+}  // namespace zetasql
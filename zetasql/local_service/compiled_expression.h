@@ -0,0 +1,210 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef ZETASQL_LOCAL_SERVICE_COMPILED_EXPRESSION_H_
+#define ZETASQL_LOCAL_SERVICE_COMPILED_EXPRESSION_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/public/builtin_function.pb.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "absl/base/call_once.h"
+#include "absl/types/span.h"
+#include "zetasql/base/status.h"
+#include "zetasql/base/statusor.h"
+
+namespace zetasql {
+namespace local_service {
+
+// A resolved expression compiled into register-based bytecode, so that it
+// can be evaluated many times without analyzing it again or walking the
+// resolved tree.
+//
+// Expression columns and named query parameters are bound to slots when
+// compiling: column_names() and parameter_names() give the (lower case)
+// name for each slot, column_types() and parameter_types() its type, and
+// Evaluate() takes the values in the same order.
+//
+// The bytecode is a flat list of instructions, each writing one register
+// from operands that are registers, constants, columns or parameters.
+// Builtin functions are bound to their implementations in public/functions
+// when compiling, so a call costs one indirect function call, with typed
+// fast paths for comparisons of INT64, UINT64, DOUBLE and BOOL. AND, OR,
+// IF, IFNULL and COALESCE are compiled to jumps, so that their arguments
+// are evaluated lazily. Registers are reused once their value has been
+// consumed, so an expression needs about as many registers as its depth.
+//
+// Only a subset of expressions is supported: literals, parameters,
+// expression columns, and calls to the builtin logical, comparison,
+// arithmetic, IF, IFNULL, COALESCE, CONCAT, DATE_ADD, DATE_SUB and
+// DATE_DIFF functions. Compile() returns
+// kUnimplemented for anything else.
+//
+// Hot expressions switch to a native tier: once an expression has been
+// evaluated native_tier_threshold() times, its bytecode is translated once
+// more, into instructions over unboxed INT64, UINT64, DOUBLE, BOOL, DATE
+// and STRING values, each bound to a kernel that inlines the arithmetic or
+// comparison of public/functions. This avoids creating a Value for every
+// intermediate result. Expressions that use other types, or functions
+// without a native kernel, stay on the bytecode.
+//
+// Both tiers record their kernel calls in FunctionKernelMetrics while it is
+// enabled.
+//
+// This class is thread-safe; Evaluate() can be called concurrently.
+class CompiledExpression {
+ public:
+  CompiledExpression(const CompiledExpression&) = delete;
+  CompiledExpression& operator=(const CompiledExpression&) = delete;
+  ~CompiledExpression();
+
+  // The default number of evaluations after which an expression switches
+  // to the native tier.
+  static constexpr int64_t kDefaultNativeTierThreshold = 1000;
+
+  // Compiles <expr>, which does not need to outlive the result. The
+  // expression switches to the native tier after <native_tier_threshold>
+  // evaluations, right away if it is 0, or never if it is negative.
+  static zetasql_base::StatusOr<std::unique_ptr<const CompiledExpression>> Compile(
+      const ResolvedExpr* expr,
+      int64_t native_tier_threshold = kDefaultNativeTierThreshold);
+
+  const Type* output_type() const { return output_type_; }
+  const std::vector<std::string>& column_names() const { return column_names_; }
+  const std::vector<std::string>& parameter_names() const {
+    return parameter_names_;
+  }
+  const std::vector<const Type*>& column_types() const { return column_types_; }
+  const std::vector<const Type*>& parameter_types() const {
+    return parameter_types_;
+  }
+
+  // Evaluates the expression. <columns> and <parameters> hold one value per
+  // entry of column_names() and parameter_names() respectively, with the
+  // types the expression was analyzed with.
+  zetasql_base::StatusOr<Value> Evaluate(absl::Span<const Value> columns,
+                                 absl::Span<const Value> parameters) const;
+
+  int num_registers() const { return num_registers_; }
+
+  int64_t native_tier_threshold() const { return native_tier_threshold_; }
+
+  // True if Evaluate() has switched to the native tier.
+  bool uses_native_tier() const;
+
+  // Returns the bytecode, one instruction per line.
+  std::string DebugString() const;
+
+ private:
+  class Compiler;
+  class NativeProgram;
+
+  // Where an instruction reads a value from.
+  struct Operand {
+    enum Source { kRegister, kConstant, kColumn, kParameter };
+    Source source;
+    int index;  // In the registers, constants_, columns or parameters.
+  };
+
+  // An implementation of a builtin function, which sets <*result> from
+  // <args>.
+  using FunctionImpl =
+      zetasql_base::Status (*)(absl::Span<const Value* const> args, Value* result);
+
+  struct Instruction {
+    enum Opcode {
+      // dest = function(arguments), or a NULL of output_type if any
+      // argument is NULL.
+      kCall,
+      // dest = function(arguments), for functions that take NULLs.
+      kCallWithNulls,
+      // dest = arguments[0].
+      kMove,
+      // One argument of AND (exit_value FALSE) or OR (exit_value TRUE): if
+      // arguments[0] is exit_value, sets dest to it and jumps to target; if
+      // it is NULL, sets dest to NULL.
+      kLogical,
+      // Jumps to target.
+      kJump,
+      // Jumps to target unless arguments[0] is TRUE.
+      kJumpUnlessTrue,
+      // Jumps to target if arguments[0] is not NULL.
+      kJumpIfNotNull,
+    };
+
+    Opcode opcode;
+    int dest = -1;
+    // The arguments are operands_[first_argument, first_argument +
+    // num_arguments).
+    int first_argument = 0;
+    int num_arguments = 0;
+    int target = -1;
+
+    // For kCall and kCallWithNulls.
+    FunctionImpl function = nullptr;
+    FunctionSignatureId function_id = static_cast<FunctionSignatureId>(0);
+    const Type* output_type = nullptr;
+    // If true, kOutOfRange errors from <function> give NULL.
+    bool safe = false;
+
+    // For kLogical.
+    bool exit_value = false;
+  };
+
+  CompiledExpression();
+
+  const Value& GetOperand(const Operand& operand,
+                          absl::Span<const Value> registers,
+                          absl::Span<const Value> columns,
+                          absl::Span<const Value> parameters) const;
+
+  std::string OperandString(const Operand& operand) const;
+
+  // Counts an evaluation, and returns the native tier once the threshold
+  // has been reached, translating the bytecode the first time. Returns null
+  // before that, or if the expression has no native translation.
+  const NativeProgram* GetNativeProgram() const;
+
+  std::vector<Instruction> instructions_;
+  std::vector<Operand> operands_;
+  std::vector<Value> constants_;
+  Operand result_;
+  int num_registers_ = 0;
+  int max_arguments_ = 0;
+  const Type* output_type_ = nullptr;
+  std::vector<std::string> column_names_;
+  std::vector<std::string> parameter_names_;
+  std::vector<const Type*> column_types_;
+  std::vector<const Type*> parameter_types_;
+
+  int64_t native_tier_threshold_ = kDefaultNativeTierThreshold;
+  mutable std::atomic<int64_t> num_evaluations_{0};
+  mutable absl::once_flag native_program_once_;
+  // Set by the call_once of <native_program_once_>.
+  mutable std::unique_ptr<const NativeProgram> native_program_;
+};
+
+}  // namespace local_service
+}  // namespace zetasql
+
+#endif  // ZETASQL_LOCAL_SERVICE_COMPILED_EXPRESSION_H_
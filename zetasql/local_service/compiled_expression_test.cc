@@ -0,0 +1,392 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "zetasql/local_service/compiled_expression.h"
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/local_service/function_metrics.h"
+#include "zetasql/public/builtin_function.pb.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/functions/datetime.pb.h"
+#include "zetasql/public/numeric_value.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/make_node_vector.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+
+namespace zetasql {
+namespace local_service {
+
+using zetasql_base::testing::StatusIs;
+
+class CompiledExpressionTest : public ::testing::Test {
+ protected:
+  // Returns a call to builtin function <name> with signature <id>.
+  template <typename T>
+  std::unique_ptr<const ResolvedExpr> Call(
+      const std::string& name, FunctionSignatureId id, const Type* type,
+      std::vector<std::unique_ptr<T>> argument_nodes, bool safe = false) {
+    functions_.push_back(absl::make_unique<Function>(
+        name, Function::kZetaSQLFunctionGroupName, Function::SCALAR));
+    std::vector<std::unique_ptr<const ResolvedExpr>> arguments;
+    FunctionArgumentTypeList argument_types;
+    for (auto& argument : argument_nodes) {
+      argument_types.emplace_back(argument->type());
+      arguments.push_back(std::move(argument));
+    }
+    return MakeResolvedFunctionCall(
+        type, functions_.back().get(),
+        FunctionSignature(type, argument_types, id), std::move(arguments),
+        safe ? ResolvedFunctionCall::SAFE_ERROR_MODE
+             : ResolvedFunctionCall::DEFAULT_ERROR_MODE);
+  }
+
+  std::unique_ptr<const ResolvedExpr> Literal(const Value& value) {
+    return MakeResolvedLiteral(value);
+  }
+
+  TypeFactory type_factory_;
+  std::vector<std::unique_ptr<const Function>> functions_;
+};
+
+TEST_F(CompiledExpressionTest, ColumnsAndParameters) {
+  // price * @Quantity + price
+  const Type* int64_type = types::Int64Type();
+  auto expr = Call(
+      "$add", FN_ADD_INT64, int64_type,
+      MakeNodeVector(
+          Call("$multiply", FN_MULTIPLY_INT64, int64_type,
+               MakeNodeVector(
+                   MakeResolvedExpressionColumn(int64_type, "price"),
+                   MakeResolvedParameter(int64_type, "Quantity"))),
+          MakeResolvedExpressionColumn(int64_type, "price")));
+  auto compiled = CompiledExpression::Compile(expr.get());
+  ZETASQL_ASSERT_OK(compiled.status());
+  const CompiledExpression& expression = *compiled.ValueOrDie();
+  EXPECT_TRUE(expression.output_type()->IsInt64());
+  EXPECT_THAT(expression.column_names(), testing::ElementsAre("price"));
+  EXPECT_THAT(expression.parameter_names(), testing::ElementsAre("quantity"));
+  EXPECT_THAT(expression.column_types(), testing::ElementsAre(int64_type));
+
+  expr.reset();  // The compiled expression does not refer to the tree.
+  EXPECT_EQ(Value::Int64(12),
+            expression.Evaluate({Value::Int64(3)}, {Value::Int64(3)})
+                .ValueOrDie());
+  EXPECT_EQ(Value::NullInt64(),
+            expression.Evaluate({Value::Int64(3)}, {Value::NullInt64()})
+                .ValueOrDie());
+  EXPECT_FALSE(expression.Evaluate({}, {}).ok());
+}
+
+TEST_F(CompiledExpressionTest, Logic) {
+  // (x > 1.5 AND NULL) OR x IS NULL
+  const Type* bool_type = types::BoolType();
+  auto expr = Call(
+      "$or", FN_OR, bool_type,
+      MakeNodeVector(
+          Call("$and", FN_AND, bool_type,
+               MakeNodeVector(
+                   Call("$greater", FN_GREATER, bool_type,
+                        MakeNodeVector(MakeResolvedExpressionColumn(
+                                           types::DoubleType(), "x"),
+                                       Literal(Value::Double(1.5)))),
+                   Literal(Value::NullBool()))),
+          Call("$is_null", FN_IS_NULL, bool_type,
+               MakeNodeVector(
+                   MakeResolvedExpressionColumn(types::DoubleType(), "x")))));
+  auto compiled = CompiledExpression::Compile(expr.get());
+  ZETASQL_ASSERT_OK(compiled.status());
+  const CompiledExpression& expression = *compiled.ValueOrDie();
+  EXPECT_EQ(Value::NullBool(),
+            expression.Evaluate({Value::Double(2)}, {}).ValueOrDie());
+  EXPECT_EQ(Value::Bool(false),
+            expression.Evaluate({Value::Double(1)}, {}).ValueOrDie());
+  EXPECT_EQ(Value::Bool(true),
+            expression.Evaluate({Value::NullDouble()}, {}).ValueOrDie());
+}
+
+TEST_F(CompiledExpressionTest, Bytecode) {
+  // a + b < c * 2, with registers reused once their values are consumed.
+  const Type* int64_type = types::Int64Type();
+  auto column = [int64_type](const std::string& name) {
+    return MakeResolvedExpressionColumn(int64_type, name);
+  };
+  auto expr = Call(
+      "$less", FN_LESS, types::BoolType(),
+      MakeNodeVector(
+          Call("$add", FN_ADD_INT64, int64_type,
+               MakeNodeVector(column("a"), column("b"))),
+          Call("$multiply", FN_MULTIPLY_INT64, int64_type,
+               MakeNodeVector(column("c"), Literal(Value::Int64(2))))));
+  auto compiled = CompiledExpression::Compile(expr.get());
+  ZETASQL_ASSERT_OK(compiled.status());
+  const CompiledExpression& expression = *compiled.ValueOrDie();
+  EXPECT_EQ(
+      "0: r1 = FN_ADD_INT64(a, b)\n"
+      "1: r2 = FN_MULTIPLY_INT64(c, Int64(2))\n"
+      "2: r0 = FN_LESS(r1, r2)\n"
+      "result: r0\n",
+      expression.DebugString());
+  EXPECT_EQ(3, expression.num_registers());
+  EXPECT_EQ(Value::Bool(true),
+            expression
+                .Evaluate({Value::Int64(1), Value::Int64(2), Value::Int64(2)},
+                          {})
+                .ValueOrDie());
+  EXPECT_EQ(Value::Bool(false),
+            expression
+                .Evaluate({Value::Int64(3), Value::Int64(2), Value::Int64(2)},
+                          {})
+                .ValueOrDie());
+}
+
+TEST_F(CompiledExpressionTest, Conditionals) {
+  // IF(x < 0, x + INT64_MAX + 1, COALESCE(@p, x, 0)); the overflowing branch
+  // is not evaluated unless it is taken.
+  const Type* int64_type = types::Int64Type();
+  auto x = [int64_type] {
+    return MakeResolvedExpressionColumn(int64_type, "x");
+  };
+  auto expr = Call(
+      "if", FN_IF, int64_type,
+      MakeNodeVector(
+          Call("$less", FN_LESS, types::BoolType(),
+               MakeNodeVector(x(), Literal(Value::Int64(0)))),
+          Call("$add", FN_ADD_INT64, int64_type,
+               MakeNodeVector(
+                   Call("$add", FN_ADD_INT64, int64_type,
+                        MakeNodeVector(x(), Literal(Value::Int64(
+                                                std::numeric_limits<
+                                                    int64_t>::max())))),
+                   Literal(Value::Int64(1)))),
+          Call("coalesce", FN_COALESCE, int64_type,
+               MakeNodeVector(MakeResolvedParameter(int64_type, "p"), x(),
+                              Literal(Value::Int64(0))))));
+  auto compiled = CompiledExpression::Compile(expr.get());
+  ZETASQL_ASSERT_OK(compiled.status());
+  const CompiledExpression& expression = *compiled.ValueOrDie();
+  EXPECT_EQ(Value::Int64(0),
+            expression
+                .Evaluate({Value::Int64(std::numeric_limits<int64_t>::min())},
+                          {Value::NullInt64()})
+                .ValueOrDie());
+  EXPECT_EQ(Value::Int64(7),
+            expression.Evaluate({Value::Int64(5)}, {Value::Int64(7)})
+                .ValueOrDie());
+  EXPECT_EQ(Value::Int64(5),
+            expression.Evaluate({Value::Int64(5)}, {Value::NullInt64()})
+                .ValueOrDie());
+  EXPECT_EQ(Value::Int64(0),
+            expression.Evaluate({Value::NullInt64()}, {Value::NullInt64()})
+                .ValueOrDie());
+}
+
+TEST_F(CompiledExpressionTest, SubtractUint64) {
+  auto expr = Call(
+      "$subtract", FN_SUBTRACT_UINT64, types::Int64Type(),
+      MakeNodeVector(Literal(Value::Uint64(1)), Literal(Value::Uint64(3))));
+  auto compiled = CompiledExpression::Compile(expr.get());
+  ZETASQL_ASSERT_OK(compiled.status());
+  EXPECT_EQ(Value::Int64(-2),
+            compiled.ValueOrDie()->Evaluate({}, {}).ValueOrDie());
+}
+
+TEST_F(CompiledExpressionTest, StringAndDateFunctions) {
+  auto expr = Call(
+      "concat", FN_CONCAT_STRING, types::StringType(),
+      MakeNodeVector(Literal(Value::String("a")),
+                     MakeResolvedExpressionColumn(types::StringType(), "s"),
+                     Literal(Value::String("c"))));
+  auto compiled = CompiledExpression::Compile(expr.get());
+  ZETASQL_ASSERT_OK(compiled.status());
+  EXPECT_EQ(Value::String("abc"),
+            compiled.ValueOrDie()->Evaluate({Value::String("b")}, {})
+                .ValueOrDie());
+
+  const EnumType* date_part_type;
+  ZETASQL_ASSERT_OK(type_factory_.MakeEnumType(
+      functions::DateTimestampPart_descriptor(), &date_part_type));
+  expr = Call("date_add", FN_DATE_ADD_DATE, types::DateType(),
+              MakeNodeVector(
+                  Literal(Value::Date(0)), Literal(Value::Int64(3)),
+                  Literal(Value::Enum(date_part_type, functions::DAY))));
+  compiled = CompiledExpression::Compile(expr.get());
+  ZETASQL_ASSERT_OK(compiled.status());
+  EXPECT_EQ(Value::Date(3),
+            compiled.ValueOrDie()->Evaluate({}, {}).ValueOrDie());
+}
+
+TEST_F(CompiledExpressionTest, MixedSignComparison) {
+  auto expr = Call(
+      "$less", FN_LESS_INT64_UINT64, types::BoolType(),
+      MakeNodeVector(MakeResolvedExpressionColumn(types::Int64Type(), "x"),
+                     MakeResolvedExpressionColumn(types::Uint64Type(), "y")));
+  auto compiled = CompiledExpression::Compile(expr.get());
+  ZETASQL_ASSERT_OK(compiled.status());
+  const CompiledExpression& expression = *compiled.ValueOrDie();
+  EXPECT_EQ(Value::Bool(true),
+            expression
+                .Evaluate({Value::Int64(-1),
+                           Value::Uint64(std::numeric_limits<uint64_t>::max())},
+                          {})
+                .ValueOrDie());
+  EXPECT_EQ(Value::Bool(false),
+            expression.Evaluate({Value::Int64(3), Value::Uint64(3)}, {})
+                .ValueOrDie());
+}
+
+TEST_F(CompiledExpressionTest, NativeTier) {
+  // IF(s < "m", CONCAT(s, "!"), COALESCE(@p, s)), which moves the result of
+  // CONCAT out of a register that is reused.
+  const Type* string_type = types::StringType();
+  auto s = [string_type] {
+    return MakeResolvedExpressionColumn(string_type, "s");
+  };
+  auto expr = Call(
+      "if", FN_IF, string_type,
+      MakeNodeVector(
+          Call("$less", FN_LESS, types::BoolType(),
+               MakeNodeVector(s(), Literal(Value::String("m")))),
+          Call("concat", FN_CONCAT_STRING, string_type,
+               MakeNodeVector(s(), Literal(Value::String("!")))),
+          Call("coalesce", FN_COALESCE, string_type,
+               MakeNodeVector(MakeResolvedParameter(string_type, "p"), s()))));
+  auto compiled =
+      CompiledExpression::Compile(expr.get(), /*native_tier_threshold=*/1);
+  ZETASQL_ASSERT_OK(compiled.status());
+  const CompiledExpression& expression = *compiled.ValueOrDie();
+  EXPECT_EQ(1, expression.native_tier_threshold());
+  EXPECT_FALSE(expression.uses_native_tier());
+  EXPECT_EQ(Value::String("a!"),
+            expression.Evaluate({Value::String("a")}, {Value::NullString()})
+                .ValueOrDie());
+  EXPECT_FALSE(expression.uses_native_tier());
+
+  // The same results after the switch.
+  EXPECT_EQ(Value::String("a!"),
+            expression.Evaluate({Value::String("a")}, {Value::NullString()})
+                .ValueOrDie());
+  EXPECT_TRUE(expression.uses_native_tier());
+  EXPECT_EQ(Value::String("x"),
+            expression.Evaluate({Value::String("x")}, {Value::NullString()})
+                .ValueOrDie());
+  EXPECT_EQ(Value::String("p"),
+            expression.Evaluate({Value::String("x")}, {Value::String("p")})
+                .ValueOrDie());
+  EXPECT_EQ(Value::NullString(),
+            expression.Evaluate({Value::NullString()}, {Value::NullString()})
+                .ValueOrDie());
+
+  // SAFE calls give NULL on overflow.
+  expr = Call("$add", FN_ADD_INT64, types::Int64Type(),
+              MakeNodeVector(MakeResolvedExpressionColumn(types::Int64Type(),
+                                                          "x"),
+                             Literal(Value::Int64(1))),
+              /*safe=*/true);
+  compiled =
+      CompiledExpression::Compile(expr.get(), /*native_tier_threshold=*/0);
+  ZETASQL_ASSERT_OK(compiled.status());
+  EXPECT_TRUE(compiled.ValueOrDie()->uses_native_tier());
+  EXPECT_EQ(Value::NullInt64(),
+            compiled.ValueOrDie()
+                ->Evaluate({Value::Int64(std::numeric_limits<int64_t>::max())},
+                           {})
+                .ValueOrDie());
+  EXPECT_EQ(Value::Int64(3),
+            compiled.ValueOrDie()
+                ->Evaluate({Value::Int64(2)}, {})
+                .ValueOrDie());
+
+  // NUMERIC has no native kernels, so its expressions stay on the bytecode.
+  expr = Call("$add", FN_ADD_NUMERIC, types::NumericType(),
+              MakeNodeVector(Literal(Value::Numeric(NumericValue(1))),
+                             Literal(Value::Numeric(NumericValue(2)))));
+  compiled =
+      CompiledExpression::Compile(expr.get(), /*native_tier_threshold=*/0);
+  ZETASQL_ASSERT_OK(compiled.status());
+  EXPECT_EQ(Value::Numeric(NumericValue(3)),
+            compiled.ValueOrDie()->Evaluate({}, {}).ValueOrDie());
+  EXPECT_FALSE(compiled.ValueOrDie()->uses_native_tier());
+
+  // A negative threshold disables the native tier.
+  compiled =
+      CompiledExpression::Compile(expr.get(), /*native_tier_threshold=*/-1);
+  ZETASQL_ASSERT_OK(compiled.status());
+  EXPECT_FALSE(compiled.ValueOrDie()->uses_native_tier());
+}
+
+TEST_F(CompiledExpressionTest, KernelMetrics) {
+  auto expr = Call(
+      "$add", FN_ADD_INT64, types::Int64Type(),
+      MakeNodeVector(MakeResolvedExpressionColumn(types::Int64Type(), "x"),
+                     Literal(Value::Int64(1))));
+  auto compiled =
+      CompiledExpression::Compile(expr.get(), /*native_tier_threshold=*/1);
+  ZETASQL_ASSERT_OK(compiled.status());
+  FunctionKernelMetrics::Reset();
+  FunctionKernelMetrics::SetEnabled(true);
+  // Once on the bytecode, once on the native tier, and not for NULLs.
+  for (const Value& x :
+       {Value::Int64(1), Value::Int64(2), Value::NullInt64()}) {
+    ZETASQL_ASSERT_OK(compiled.ValueOrDie()->Evaluate({x}, {}).status());
+  }
+  FunctionKernelMetrics::SetEnabled(false);
+  const std::vector<FunctionKernelStats> snapshot =
+      FunctionKernelMetrics::Snapshot();
+  FunctionKernelMetrics::Reset();
+  ASSERT_EQ(1, snapshot.size());
+  EXPECT_EQ(FN_ADD_INT64, snapshot[0].function_id);
+  EXPECT_EQ(2, snapshot[0].calls);
+}
+
+TEST_F(CompiledExpressionTest, Errors) {
+  const Type* int64_type = types::Int64Type();
+  auto overflow = [this, int64_type](bool safe) {
+    return Call("$add", FN_ADD_INT64, int64_type,
+                MakeNodeVector(
+                    Literal(Value::Int64(std::numeric_limits<int64_t>::max())),
+                    Literal(Value::Int64(1))),
+                safe);
+  };
+  auto expr = overflow(/*safe=*/false);
+  auto compiled = CompiledExpression::Compile(expr.get());
+  ZETASQL_ASSERT_OK(compiled.status());
+  EXPECT_THAT(compiled.ValueOrDie()->Evaluate({}, {}).status(),
+              StatusIs(zetasql_base::StatusCode::kOutOfRange));
+
+  expr = overflow(/*safe=*/true);
+  compiled = CompiledExpression::Compile(expr.get());
+  ZETASQL_ASSERT_OK(compiled.status());
+  EXPECT_EQ(Value::NullInt64(),
+            compiled.ValueOrDie()->Evaluate({}, {}).ValueOrDie());
+
+  expr = Call("upper", FN_UPPER_STRING, types::StringType(),
+              MakeNodeVector(Literal(Value::String("a"))));
+  EXPECT_THAT(CompiledExpression::Compile(expr.get()).status(),
+              StatusIs(zetasql_base::StatusCode::kUnimplemented));
+}
+
+}  // namespace local_service
+}  // namespace zetasql
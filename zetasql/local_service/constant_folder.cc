@@ -0,0 +1,95 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "zetasql/local_service/constant_folder.h"
+
+#include <utility>
+
+#include "zetasql/local_service/compiled_expression.h"
+#include "zetasql/public/function.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "zetasql/resolved_ast/resolved_ast_deep_copy_visitor.h"
+#include "zetasql/resolved_ast/resolved_node_kind.pb.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+namespace local_service {
+
+namespace {
+
+class ConstantFolder : public ResolvedASTDeepCopyVisitor {
+ protected:
+  zetasql_base::Status VisitResolvedFunctionCall(
+      const ResolvedFunctionCall* node) override {
+    ZETASQL_RETURN_IF_ERROR(CopyVisitResolvedFunctionCall(node));
+    const ResolvedFunctionCall* copy =
+        GetUnownedTopOfStack<ResolvedFunctionCall>();
+    if (!IsFoldable(copy)) return ::zetasql_base::OkStatus();
+
+    auto compiled = CompiledExpression::Compile(copy);
+    if (!compiled.ok()) return ::zetasql_base::OkStatus();
+    auto value = compiled.ValueOrDie()->Evaluate({}, {});
+    if (!value.ok()) return ::zetasql_base::OkStatus();
+
+    std::unique_ptr<ResolvedFunctionCall> call =
+        ConsumeTopOfStack<ResolvedFunctionCall>();
+    auto literal = MakeResolvedLiteral(call->type(), value.ValueOrDie());
+    if (call->GetParseLocationRangeOrNULL() != nullptr) {
+      literal->SetParseLocationRange(*call->GetParseLocationRangeOrNULL());
+    } else if (call->GetParseLocationId() >= 0) {
+      literal->SetParseLocationId(call->GetParseLocationId());
+    }
+    PushNodeToStack(std::move(literal));
+    return ::zetasql_base::OkStatus();
+  }
+
+ private:
+  static bool IsFoldable(const ResolvedFunctionCall* call) {
+    if (!call->function()->IsZetaSQLBuiltin() ||
+        call->function()->function_options().volatility !=
+            FunctionEnums::IMMUTABLE) {
+      return false;
+    }
+    for (const auto& argument : call->argument_list()) {
+      if (argument->node_kind() != RESOLVED_LITERAL) return false;
+    }
+    return true;
+  }
+};
+
+}  // namespace
+
+zetasql_base::Status FoldConstants(std::unique_ptr<const ResolvedNode>* root) {
+  ConstantFolder folder;
+  return folder.RewriteSubtrees(
+      [](const ResolvedNode* node) {
+        return node->node_kind() == RESOLVED_FUNCTION_CALL;
+      },
+      root);
+}
+
+zetasql_base::StatusOr<std::unique_ptr<const ResolvedNode>> FoldConstantsInCopy(
+    const ResolvedNode* node) {
+  ConstantFolder folder;
+  ZETASQL_RETURN_IF_ERROR(node->Accept(&folder));
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ResolvedNode> copy,
+                   folder.ConsumeRootNode<ResolvedNode>());
+  return std::unique_ptr<const ResolvedNode>(std::move(copy));
+}
+
+}  // namespace local_service
+}  // namespace zetasql
@@ -0,0 +1,51 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef ZETASQL_LOCAL_SERVICE_CONSTANT_FOLDER_H_
+#define ZETASQL_LOCAL_SERVICE_CONSTANT_FOLDER_H_
+
+#include <memory>
+
+#include "zetasql/resolved_ast/resolved_node.h"
+#include "zetasql/base/status.h"
+#include "zetasql/base/statusor.h"
+
+namespace zetasql {
+namespace local_service {
+
+// Replaces calls to builtin functions whose arguments are all literals by
+// literals holding their result, e.g. CONCAT('a', 'b') by 'ab', in the tree
+// at <*root>. Calls are folded bottom-up, so nested constant expressions
+// become a single literal. Only the subtrees containing function calls are
+// copied; the rest of the tree is kept.
+//
+// A call is kept as it is if its function is not IMMUTABLE according to its
+// FunctionOptions, if CompiledExpression does not support it, or if
+// evaluating it fails. Errors such as division by zero are therefore
+// reported by whatever evaluates the expression, if it is evaluated at all,
+// and never fail folding.
+zetasql_base::Status FoldConstants(std::unique_ptr<const ResolvedNode>* root);
+
+// Returns a copy of <node> with constants folded as above, for trees owned
+// by someone else, like the ones in an AnalyzerOutput.
+zetasql_base::StatusOr<std::unique_ptr<const ResolvedNode>> FoldConstantsInCopy(
+    const ResolvedNode* node);
+
+}  // namespace local_service
+}  // namespace zetasql
+
+#endif  // ZETASQL_LOCAL_SERVICE_CONSTANT_FOLDER_H_
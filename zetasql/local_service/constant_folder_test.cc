@@ -0,0 +1,137 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "zetasql/local_service/constant_folder.h"
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/builtin_function.pb.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/make_node_vector.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+
+namespace zetasql {
+namespace local_service {
+
+class ConstantFolderTest : public ::testing::Test {
+ protected:
+  // Returns a call to builtin function <name> with signature <id>.
+  template <typename T>
+  std::unique_ptr<const ResolvedExpr> Call(
+      const std::string& name, FunctionSignatureId id,
+      std::vector<std::unique_ptr<T>> argument_nodes,
+      const FunctionOptions& options = FunctionOptions()) {
+    functions_.push_back(absl::make_unique<Function>(
+        name, Function::kZetaSQLFunctionGroupName, Function::SCALAR,
+        options));
+    std::vector<std::unique_ptr<const ResolvedExpr>> arguments;
+    FunctionArgumentTypeList argument_types;
+    for (auto& argument : argument_nodes) {
+      argument_types.emplace_back(argument->type());
+      arguments.push_back(std::move(argument));
+    }
+    const Type* type = arguments[0]->type();
+    return MakeResolvedFunctionCall(
+        type, functions_.back().get(),
+        FunctionSignature(type, argument_types, id), std::move(arguments),
+        ResolvedFunctionCall::DEFAULT_ERROR_MODE);
+  }
+
+  static std::unique_ptr<const ResolvedExpr> Int64(int64_t value) {
+    return MakeResolvedLiteral(Value::Int64(value));
+  }
+
+  static std::unique_ptr<const ResolvedExpr> Fold(
+      std::unique_ptr<const ResolvedExpr> expr) {
+    std::unique_ptr<const ResolvedNode> node = std::move(expr);
+    ZETASQL_EXPECT_OK(FoldConstants(&node));
+    return std::unique_ptr<const ResolvedExpr>(
+        node.release()->GetAs<ResolvedExpr>());
+  }
+
+  std::vector<std::unique_ptr<const Function>> functions_;
+};
+
+TEST_F(ConstantFolderTest, FoldsNestedCalls) {
+  // (2 * 3) + 1
+  auto folded = Fold(Call(
+      "$add", FN_ADD_INT64,
+      MakeNodeVector(Call("$multiply", FN_MULTIPLY_INT64,
+                          MakeNodeVector(Int64(2), Int64(3))),
+                     Int64(1))));
+  ASSERT_EQ(RESOLVED_LITERAL, folded->node_kind());
+  EXPECT_EQ(Value::Int64(7), folded->GetAs<ResolvedLiteral>()->value());
+}
+
+TEST_F(ConstantFolderTest, FoldConstantsInCopy) {
+  auto expr = Call("$add", FN_ADD_INT64, MakeNodeVector(Int64(1), Int64(2)));
+  auto folded = FoldConstantsInCopy(expr.get());
+  ZETASQL_ASSERT_OK(folded.status());
+  ASSERT_EQ(RESOLVED_LITERAL, folded.ValueOrDie()->node_kind());
+  EXPECT_EQ(Value::Int64(3),
+            folded.ValueOrDie()->GetAs<ResolvedLiteral>()->value());
+  // The original tree is unchanged.
+  EXPECT_EQ(RESOLVED_FUNCTION_CALL, expr->node_kind());
+}
+
+TEST_F(ConstantFolderTest, KeepsNonConstantArguments) {
+  // x + (2 * 3)
+  auto folded = Fold(Call(
+      "$add", FN_ADD_INT64,
+      MakeNodeVector(MakeResolvedExpressionColumn(types::Int64Type(), "x"),
+                     Call("$multiply", FN_MULTIPLY_INT64,
+                          MakeNodeVector(Int64(2), Int64(3))))));
+  ASSERT_EQ(RESOLVED_FUNCTION_CALL, folded->node_kind());
+  const auto* call = folded->GetAs<ResolvedFunctionCall>();
+  EXPECT_EQ(RESOLVED_EXPRESSION_COLUMN, call->argument_list(0)->node_kind());
+  ASSERT_EQ(RESOLVED_LITERAL, call->argument_list(1)->node_kind());
+  EXPECT_EQ(Value::Int64(6),
+            call->argument_list(1)->GetAs<ResolvedLiteral>()->value());
+}
+
+TEST_F(ConstantFolderTest, KeepsCallsThatFail) {
+  // INT64_MAX + 1 overflows, so it is left for the evaluator to report.
+  auto folded = Fold(Call(
+      "$add", FN_ADD_INT64,
+      MakeNodeVector(Int64(std::numeric_limits<int64_t>::max()), Int64(1))));
+  EXPECT_EQ(RESOLVED_FUNCTION_CALL, folded->node_kind());
+}
+
+TEST_F(ConstantFolderTest, KeepsVolatileCalls) {
+  auto folded = Fold(
+      Call("$add", FN_ADD_INT64, MakeNodeVector(Int64(1), Int64(2)),
+           FunctionOptions().set_volatility(FunctionEnums::VOLATILE)));
+  EXPECT_EQ(RESOLVED_FUNCTION_CALL, folded->node_kind());
+
+  // Unsupported functions are kept too.
+  folded = Fold(Call("upper", FN_UPPER_STRING,
+                     MakeNodeVector(MakeResolvedLiteral(Value::String("a")))));
+  EXPECT_EQ(RESOLVED_FUNCTION_CALL, folded->node_kind());
+}
+
+}  // namespace local_service
+}  // namespace zetasql
@@ -0,0 +1,345 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "zetasql/local_service/external_sorter.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/source_location.h"
+#include "zetasql/base/status_builder.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+namespace local_service {
+
+class ExternalSorter::OutputIterator : public EvaluatorTableIterator {
+ public:
+  explicit OutputIterator(ExternalSorter* sorter) : sorter_(sorter) {}
+
+  int NumColumns() const override { return sorter_->column_types_.size(); }
+  std::string GetColumnName(int i) const override { return ""; }
+  const Type* GetColumnType(int i) const override {
+    return sorter_->column_types_[i];
+  }
+
+  bool NextRow() override {
+    if (!status_.ok()) return false;
+    if (cancelled_) {
+      status_ = ::zetasql_base::CancelledErrorBuilder(ZETASQL_LOC)
+                << "ExternalSorter output was cancelled";
+      return false;
+    }
+    if (sorter_->options_.limit.has_value() &&
+        num_returned_ >= *sorter_->options_.limit) {
+      return false;
+    }
+    if (sorter_->merger_ == nullptr) {
+      if (next_ >= sorter_->buffer_.size()) return false;
+      row_ = &sorter_->buffer_[next_++].row;
+    } else {
+      const zetasql_base::StatusOr<bool> found = sorter_->merger_->Next(&entry_);
+      if (!found.ok()) {
+        status_ = found.status();
+        return false;
+      }
+      if (!found.ValueOrDie()) return false;
+      row_ = &entry_.row;
+    }
+    ++num_returned_;
+    return true;
+  }
+
+  const Value& GetValue(int i) const override { return (*row_)[i]; }
+
+  zetasql_base::Status Status() const override { return status_; }
+
+  zetasql_base::Status Cancel() override {
+    cancelled_ = true;
+    return ::zetasql_base::OkStatus();
+  }
+
+ private:
+  ExternalSorter* sorter_;
+  int64_t next_ = 0;
+  int64_t num_returned_ = 0;
+  Entry entry_;
+  const std::vector<Value>* row_ = nullptr;
+  bool cancelled_ = false;
+  zetasql_base::Status status_;
+};
+
+ExternalSorter::Merger::Merger(std::vector<Run> runs,
+                               absl::Span<const Type* const> column_types)
+    : runs_(std::move(runs)),
+      column_types_(column_types.begin(), column_types.end()),
+      current_(runs_.size()),
+      num_read_(runs_.size(), 0) {}
+
+zetasql_base::Status ExternalSorter::Merger::Init() {
+  heap_.reserve(runs_.size());
+  for (int i = 0; i < runs_.size(); ++i) {
+    ZETASQL_RETURN_IF_ERROR(Advance(i));
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+namespace {
+
+// Orders a max-heap of run indexes so that its top has the smallest key,
+// and among equal keys the earliest run.
+struct HeapGreater {
+  template <typename Entries>
+  bool operator()(const Entries& current, int a, int b) const {
+    const int c = current[a].key.compare(current[b].key);
+    return c > 0 || (c == 0 && a > b);
+  }
+};
+
+}  // namespace
+
+zetasql_base::Status ExternalSorter::Merger::Advance(int i) {
+  if (num_read_[i] == runs_[i].num_rows) {
+    runs_[i].file.reset();
+    return ::zetasql_base::OkStatus();
+  }
+  ZETASQL_RETURN_IF_ERROR(runs_[i].file->ReadString(&current_[i].key));
+  ZETASQL_RETURN_IF_ERROR(runs_[i].file->ReadValues(column_types_, &current_[i].row));
+  ++num_read_[i];
+  heap_.push_back(i);
+  std::push_heap(heap_.begin(), heap_.end(), [this](int a, int b) {
+    return HeapGreater()(current_, a, b);
+  });
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::StatusOr<bool> ExternalSorter::Merger::Next(Entry* entry) {
+  if (heap_.empty()) return false;
+  std::pop_heap(heap_.begin(), heap_.end(), [this](int a, int b) {
+    return HeapGreater()(current_, a, b);
+  });
+  const int i = heap_.back();
+  heap_.pop_back();
+  std::swap(*entry, current_[i]);
+  ZETASQL_RETURN_IF_ERROR(Advance(i));
+  return true;
+}
+
+// Reserves the memory of the buffer in Options::memory_pool, and spills it
+// when another consumer of the pool needs the memory.
+class ExternalSorter::PoolConsumer : public MemoryConsumer {
+ public:
+  explicit PoolConsumer(ExternalSorter* sorter)
+      : MemoryConsumer("ExternalSorter", sorter->options_.memory_pool),
+        sorter_(sorter) {}
+
+  bool CanSpill() const override {
+    return !sorter_->finished_ && !sorter_->buffer_.empty();
+  }
+
+ protected:
+  zetasql_base::Status Spill() override { return sorter_->SpillBuffer(); }
+
+ private:
+  ExternalSorter* sorter_;
+};
+
+ExternalSorter::ExternalSorter(absl::Span<const Type* const> column_types,
+                               SortKeyEncoder encoder, const Options& options)
+    : column_types_(column_types.begin(), column_types.end()),
+      encoder_(std::move(encoder)),
+      options_(options) {
+  if (options_.memory_pool != nullptr) {
+    memory_consumer_ = absl::make_unique<PoolConsumer>(this);
+  }
+}
+
+ExternalSorter::~ExternalSorter() {}
+
+zetasql_base::StatusOr<std::unique_ptr<ExternalSorter>> ExternalSorter::Create(
+    absl::Span<const Type* const> column_types, std::vector<SortKey> keys,
+    const Options& options) {
+  if (options.merge_fan_in < 2) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "merge_fan_in must be at least 2, but is "
+           << options.merge_fan_in;
+  }
+  if (options.limit.has_value() && *options.limit < 0) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "Negative sort limit " << *options.limit;
+  }
+  ZETASQL_ASSIGN_OR_RETURN(SortKeyEncoder encoder,
+                   SortKeyEncoder::Create(column_types, std::move(keys)));
+  return absl::WrapUnique(
+      new ExternalSorter(column_types, std::move(encoder), options));
+}
+
+int64_t ExternalSorter::EntryBytes(const Entry& entry) const {
+  int64_t bytes = sizeof(Entry) + entry.key.capacity() +
+                  entry.row.size() * sizeof(Value);
+  for (const Value& value : entry.row) {
+    bytes += ValueHeapBytes(value);
+  }
+  return bytes;
+}
+
+zetasql_base::Status ExternalSorter::AddRow(absl::Span<const Value> row) {
+  ZETASQL_RET_CHECK(!finished_) << "AddRow() called after Finish()";
+  if (row.size() != column_types_.size()) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "Row has " << row.size() << " values but the sorter expects "
+           << column_types_.size();
+  }
+  if (options_.limit.has_value() && *options_.limit == 0) {
+    return ::zetasql_base::OkStatus();
+  }
+  encoder_.Encode(row, &key_);
+  if (has_cutoff_ && key_.compare(cutoff_) >= 0) {
+    return ::zetasql_base::OkStatus();
+  }
+  Entry entry;
+  entry.key = key_;
+  entry.row.assign(row.begin(), row.end());
+  memory_used_bytes_ += EntryBytes(entry);
+  buffer_.push_back(std::move(entry));
+
+  if (options_.limit.has_value() && buffer_.size() >= 2 * *options_.limit) {
+    SortBuffer();
+    memory_used_bytes_ = 0;
+    for (const Entry& kept : buffer_) {
+      memory_used_bytes_ += EntryBytes(kept);
+    }
+  }
+  if (memory_used_bytes_ > options_.memory_budget_bytes ||
+      (memory_consumer_ != nullptr &&
+       (memory_consumer_->spill_requested() ||
+        !memory_consumer_->SetUsedBytes(memory_used_bytes_).ok()))) {
+    ZETASQL_RETURN_IF_ERROR(SpillBuffer());
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status ExternalSorter::AddRows(EvaluatorTableIterator* input) {
+  if (input->NumColumns() != column_types_.size()) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "Input has " << input->NumColumns()
+           << " columns but the sorter expects " << column_types_.size();
+  }
+  std::vector<Value> row(column_types_.size());
+  while (input->NextRow()) {
+    for (int i = 0; i < row.size(); ++i) {
+      row[i] = input->GetValue(i);
+    }
+    ZETASQL_RETURN_IF_ERROR(AddRow(row));
+  }
+  return input->Status();
+}
+
+void ExternalSorter::SortBuffer() {
+  std::stable_sort(buffer_.begin(), buffer_.end(),
+                   [](const Entry& a, const Entry& b) { return a.key < b.key; });
+  if (!options_.limit.has_value() || buffer_.size() < *options_.limit) return;
+  buffer_.resize(*options_.limit);
+  // The buffer now holds <limit> rows that sort before any row at or after
+  // its last key, including later rows with an equal key.
+  has_cutoff_ = true;
+  cutoff_ = buffer_.back().key;
+}
+
+zetasql_base::Status ExternalSorter::SpillBuffer() {
+  SortBuffer();
+  Run run;
+  ZETASQL_ASSIGN_OR_RETURN(run.file, SpillFile::Create(options_.spill_directory));
+  for (const Entry& entry : buffer_) {
+    ZETASQL_RETURN_IF_ERROR(run.file->WriteString(entry.key));
+    ZETASQL_RETURN_IF_ERROR(run.file->WriteValues(entry.row));
+  }
+  ZETASQL_RETURN_IF_ERROR(run.file->Rewind());
+  run.num_rows = buffer_.size();
+  runs_.push_back(std::move(run));
+  ++num_spilled_runs_;
+  buffer_.clear();
+  memory_used_bytes_ = 0;
+  if (memory_consumer_ != nullptr) {
+    ZETASQL_RETURN_IF_ERROR(memory_consumer_->SetUsedBytes(0));
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::StatusOr<ExternalSorter::Run> ExternalSorter::MergeRuns(
+    std::vector<Run> runs) {
+  Merger merger(std::move(runs), column_types_);
+  ZETASQL_RETURN_IF_ERROR(merger.Init());
+  Run merged;
+  ZETASQL_ASSIGN_OR_RETURN(merged.file, SpillFile::Create(options_.spill_directory));
+  Entry entry;
+  while (!options_.limit.has_value() || merged.num_rows < *options_.limit) {
+    ZETASQL_ASSIGN_OR_RETURN(const bool found, merger.Next(&entry));
+    if (!found) break;
+    ZETASQL_RETURN_IF_ERROR(merged.file->WriteString(entry.key));
+    ZETASQL_RETURN_IF_ERROR(merged.file->WriteValues(entry.row));
+    ++merged.num_rows;
+  }
+  ZETASQL_RETURN_IF_ERROR(merged.file->Rewind());
+  ++num_spilled_runs_;
+  return merged;
+}
+
+zetasql_base::StatusOr<std::unique_ptr<EvaluatorTableIterator>>
+ExternalSorter::Finish() {
+  ZETASQL_RET_CHECK(!finished_) << "Finish() called twice";
+  finished_ = true;
+  if (runs_.empty()) {
+    SortBuffer();
+  } else {
+    if (!buffer_.empty()) {
+      ZETASQL_RETURN_IF_ERROR(SpillBuffer());
+    }
+    // Merge consecutive runs, so that equal keys stay in input order.
+    while (runs_.size() > options_.merge_fan_in) {
+      std::vector<Run> merged_runs;
+      for (int start = 0; start < runs_.size();
+           start += options_.merge_fan_in) {
+        const int end = std::min<int>(start + options_.merge_fan_in,
+                                      runs_.size());
+        std::vector<Run> group;
+        for (int i = start; i < end; ++i) {
+          group.push_back(std::move(runs_[i]));
+        }
+        if (group.size() == 1) {
+          merged_runs.push_back(std::move(group[0]));
+        } else {
+          ZETASQL_ASSIGN_OR_RETURN(Run merged, MergeRuns(std::move(group)));
+          merged_runs.push_back(std::move(merged));
+        }
+      }
+      runs_ = std::move(merged_runs);
+    }
+    merger_ = absl::make_unique<Merger>(std::move(runs_), column_types_);
+    runs_.clear();
+    ZETASQL_RETURN_IF_ERROR(merger_->Init());
+  }
+  return std::unique_ptr<EvaluatorTableIterator>(
+      absl::make_unique<OutputIterator>(this));
+}
+
+}  // namespace local_service
+}  // namespace zetasql
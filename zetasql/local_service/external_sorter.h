@@ -0,0 +1,187 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef ZETASQL_LOCAL_SERVICE_EXTERNAL_SORTER_H_
+#define ZETASQL_LOCAL_SERVICE_EXTERNAL_SORTER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/local_service/memory_pool.h"
+#include "zetasql/local_service/sort_key_encoder.h"
+#include "zetasql/local_service/spill_file.h"
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "zetasql/base/status.h"
+#include "zetasql/base/statusor.h"
+
+namespace zetasql {
+namespace local_service {
+
+// Sorts rows within a memory budget, as for a ResolvedOrderByScan or for
+// ordering the input of each ResolvedAnalyticFunctionGroup.
+//
+// Each row is stored with its normalized key from SortKeyEncoder, so that
+// sorting compares strings rather than Values. When the estimated size of
+// the buffered rows exceeds Options::memory_budget_bytes, they are sorted
+// into a run that is written to a SpillFile, and the buffer is cleared.
+// Finish() merges the runs with a heap of their first rows, after merging
+// them in passes of Options::merge_fan_in runs while there are more. The
+// sort is stable: rows with equal keys are returned in the order they were
+// added.
+//
+// With Options::limit, only the first <limit> rows are returned, as for
+// ORDER BY ... LIMIT. Whenever the buffer reaches twice the limit it is
+// sorted and cut down to the limit, and later rows that sort after the last
+// row kept are dropped without being copied. A small limit therefore needs
+// memory for about 2 * limit rows and never spills.
+//
+// With Options::memory_pool, the buffer also reserves its estimated size in
+// the pool and is spilled when the pool or an ancestor is full, or when
+// another operator asks for it.
+//
+// Example:
+//   std::vector<SortKey> keys;
+//   ZETASQL_RETURN_IF_ERROR(AppendOrderByKeys(scan->order_by_item_list(),
+//                                     input_scan->column_list(), &keys));
+//   ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ExternalSorter> sorter,
+//                    ExternalSorter::Create(input_types, std::move(keys),
+//                                           ExternalSorter::Options()));
+//   ZETASQL_RETURN_IF_ERROR(sorter->AddRows(input.get()));
+//   ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<EvaluatorTableIterator> output,
+//                    sorter->Finish());
+//
+// This class is not thread-safe.
+class ExternalSorter {
+ public:
+  struct Options {
+    // The estimated size of the buffered rows above which they are spilled.
+    int64_t memory_budget_bytes = int64_t{1} << 30;
+    // The directory for spill files. If empty, tmpfile() is used.
+    std::string spill_directory;
+    // The maximum number of runs merged at once. Must be at least 2.
+    int merge_fan_in = 64;
+    // If set, only the first <limit> rows are returned.
+    absl::optional<int64_t> limit;
+    // If set, the pool in which the buffer reserves its memory. Must outlive
+    // the sorter.
+    MemoryPool* memory_pool = nullptr;
+  };
+
+  ExternalSorter(const ExternalSorter&) = delete;
+  ExternalSorter& operator=(const ExternalSorter&) = delete;
+  ~ExternalSorter();
+
+  // Creates a sorter for rows of <column_types>, ordered by <keys>.
+  static zetasql_base::StatusOr<std::unique_ptr<ExternalSorter>> Create(
+      absl::Span<const Type* const> column_types, std::vector<SortKey> keys,
+      const Options& options);
+
+  // Adds one row, which must have the column types.
+  zetasql_base::Status AddRow(absl::Span<const Value> row);
+
+  // Adds all rows of <input>, which must have the column types.
+  zetasql_base::Status AddRows(EvaluatorTableIterator* input);
+
+  // Returns an iterator over the sorted rows. The iterator reads from this
+  // sorter, which must outlive it and must not be used otherwise
+  // afterwards.
+  zetasql_base::StatusOr<std::unique_ptr<EvaluatorTableIterator>> Finish();
+
+  // The number of runs written to spill files, including by merge passes.
+  int64_t num_spilled_runs() const { return num_spilled_runs_; }
+  int64_t memory_used_bytes() const { return memory_used_bytes_; }
+
+ private:
+  class OutputIterator;
+  class PoolConsumer;
+
+  struct Entry {
+    std::string key;
+    std::vector<Value> row;
+  };
+
+  // A sorted run in a spill file.
+  struct Run {
+    std::unique_ptr<SpillFile> file;
+    int64_t num_rows = 0;
+  };
+
+  // Merges runs by reading the next entry of each, in key order and for
+  // equal keys in run order.
+  class Merger {
+   public:
+    Merger(std::vector<Run> runs, absl::Span<const Type* const> column_types);
+
+    zetasql_base::Status Init();
+
+    // Sets <*entry> to the next entry. Returns false after the last one.
+    zetasql_base::StatusOr<bool> Next(Entry* entry);
+
+   private:
+    // Reads the next entry of run <i> and adds it to the heap, if any.
+    zetasql_base::Status Advance(int i);
+
+    std::vector<Run> runs_;
+    const std::vector<const Type*> column_types_;
+    std::vector<Entry> current_;
+    std::vector<int64_t> num_read_;
+    std::vector<int> heap_;
+  };
+
+  ExternalSorter(absl::Span<const Type* const> column_types,
+                 SortKeyEncoder encoder, const Options& options);
+
+  // Returns the estimated memory used by <entry>.
+  int64_t EntryBytes(const Entry& entry) const;
+
+  // Sorts the buffer and, with a limit, truncates it to the limit.
+  void SortBuffer();
+  // Writes the sorted buffer to a new run, clears it and releases its
+  // memory in the pool, if any.
+  zetasql_base::Status SpillBuffer();
+  // Merges <runs> into one run.
+  zetasql_base::StatusOr<Run> MergeRuns(std::vector<Run> runs);
+
+  const std::vector<const Type*> column_types_;
+  const SortKeyEncoder encoder_;
+  const Options options_;
+
+  std::vector<Entry> buffer_;
+  std::vector<Run> runs_;
+  std::string key_;
+  // With a limit, rows whose key is at least <cutoff_> are dropped.
+  bool has_cutoff_ = false;
+  std::string cutoff_;
+
+  int64_t memory_used_bytes_ = 0;
+  int64_t num_spilled_runs_ = 0;
+  bool finished_ = false;
+  std::unique_ptr<Merger> merger_;
+  // Only set with Options::memory_pool.
+  std::unique_ptr<MemoryConsumer> memory_consumer_;
+};
+
+}  // namespace local_service
+}  // namespace zetasql
+
+#endif  // ZETASQL_LOCAL_SERVICE_EXTERNAL_SORTER_H_
@@ -0,0 +1,186 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "zetasql/local_service/external_sorter.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/local_service/memory_pool.h"
+#include "zetasql/local_service/sort_key_encoder.h"
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace zetasql {
+namespace local_service {
+
+using zetasql_base::testing::StatusIs;
+
+// Returns the (INT64 key, INT64 sequence number) rows of <iterator>.
+std::vector<std::pair<int64_t, int64_t>> ReadRows(
+    EvaluatorTableIterator* iterator) {
+  std::vector<std::pair<int64_t, int64_t>> rows;
+  while (iterator->NextRow()) {
+    rows.emplace_back(iterator->GetValue(0).int64_value(),
+                      iterator->GetValue(1).int64_value());
+  }
+  ZETASQL_EXPECT_OK(iterator->Status());
+  return rows;
+}
+
+// Sorts rows (key, i) by key, with i from 0 to <num_rows> and key cycling
+// down through <num_keys> values, and checks that the output is sorted and
+// stable.
+void SortAndCheck(const ExternalSorter::Options& options, int num_rows,
+                  int num_keys, int64_t expected_rows,
+                  int64_t* num_spilled_runs) {
+  SortKey key;
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<ExternalSorter> sorter,
+      ExternalSorter::Create({types::Int64Type(), types::Int64Type()}, {key},
+                             options));
+  for (int i = 0; i < num_rows; ++i) {
+    ZETASQL_ASSERT_OK(sorter->AddRow(
+        {Value::Int64(num_keys - 1 - i % num_keys), Value::Int64(i)}));
+  }
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> output,
+                       sorter->Finish());
+  const std::vector<std::pair<int64_t, int64_t>> rows = ReadRows(output.get());
+  EXPECT_EQ(expected_rows, rows.size());
+  for (int i = 1; i < rows.size(); ++i) {
+    EXPECT_LT(rows[i - 1], rows[i]);
+  }
+  *num_spilled_runs = sorter->num_spilled_runs();
+}
+
+TEST(ExternalSorterTest, InMemory) {
+  int64_t num_spilled_runs;
+  SortAndCheck(ExternalSorter::Options(), 1000, 7, 1000, &num_spilled_runs);
+  EXPECT_EQ(0, num_spilled_runs);
+}
+
+TEST(ExternalSorterTest, Spills) {
+  ExternalSorter::Options options;
+  options.memory_budget_bytes = 4096;
+  options.spill_directory = ::testing::TempDir();
+  int64_t num_spilled_runs;
+  SortAndCheck(options, 2000, 13, 2000, &num_spilled_runs);
+  EXPECT_GT(num_spilled_runs, 1);
+}
+
+TEST(ExternalSorterTest, SpillsWhenThePoolIsFull) {
+  MemoryPool::Options pool_options;
+  pool_options.limit_bytes = 8192;
+  pool_options.reservation_granularity_bytes = 1024;
+  MemoryPool pool("query", pool_options);
+  ExternalSorter::Options options;
+  options.memory_pool = &pool;
+  int64_t num_spilled_runs;
+  SortAndCheck(options, 2000, 13, 2000, &num_spilled_runs);
+  EXPECT_GT(num_spilled_runs, 1);
+  EXPECT_LE(pool.peak_reserved_bytes(), 8192);
+  EXPECT_EQ(0, pool.reserved_bytes());
+
+  // Another sorter that needs the memory spills the buffer of this one.
+  SortKey key;
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<ExternalSorter> sorter,
+      ExternalSorter::Create({types::Int64Type(), types::Int64Type()}, {key},
+                             options));
+  for (int i = 0; i < 50; ++i) {
+    ZETASQL_ASSERT_OK(sorter->AddRow({Value::Int64(i), Value::Int64(i)}));
+  }
+  EXPECT_EQ(0, sorter->num_spilled_runs());
+  SortAndCheck(options, 2000, 13, 2000, &num_spilled_runs);
+  EXPECT_EQ(1, sorter->num_spilled_runs());
+}
+
+TEST(ExternalSorterTest, MergePasses) {
+  ExternalSorter::Options options;
+  options.memory_budget_bytes = 1024;
+  options.merge_fan_in = 2;
+  int64_t num_spilled_runs;
+  SortAndCheck(options, 2000, 13, 2000, &num_spilled_runs);
+  EXPECT_GT(num_spilled_runs, 10);
+}
+
+TEST(ExternalSorterTest, TopN) {
+  ExternalSorter::Options options;
+  options.limit = 10;
+  int64_t num_spilled_runs;
+  SortAndCheck(options, 1000, 100, 10, &num_spilled_runs);
+  EXPECT_EQ(0, num_spilled_runs);
+
+  options.limit = 0;
+  SortAndCheck(options, 100, 3, 0, &num_spilled_runs);
+}
+
+TEST(ExternalSorterTest, TopNWithSpilledRuns) {
+  ExternalSorter::Options options;
+  options.memory_budget_bytes = 1024;
+  options.merge_fan_in = 2;
+  options.limit = 500;
+  int64_t num_spilled_runs;
+  SortAndCheck(options, 3000, 13, 500, &num_spilled_runs);
+  EXPECT_GT(num_spilled_runs, 1);
+}
+
+TEST(ExternalSorterTest, DescendingNullsLast) {
+  SortKey key;
+  key.descending = true;
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<ExternalSorter> sorter,
+      ExternalSorter::Create({types::StringType()}, {key},
+                             ExternalSorter::Options()));
+  for (const Value& value : {Value::String("b"), Value::NullString(),
+                             Value::String("a"), Value::String("ab")}) {
+    ZETASQL_ASSERT_OK(sorter->AddRow({value}));
+  }
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> output,
+                       sorter->Finish());
+  std::vector<Value> values;
+  while (output->NextRow()) values.push_back(output->GetValue(0));
+  EXPECT_EQ(std::vector<Value>({Value::String("b"), Value::String("ab"),
+                                Value::String("a"), Value::NullString()}),
+            values);
+}
+
+TEST(ExternalSorterTest, Errors) {
+  SortKey key;
+  ExternalSorter::Options options;
+  options.merge_fan_in = 1;
+  EXPECT_THAT(
+      ExternalSorter::Create({types::Int64Type()}, {key}, options).status(),
+      StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<ExternalSorter> sorter,
+      ExternalSorter::Create({types::Int64Type()}, {key},
+                             ExternalSorter::Options()));
+  EXPECT_THAT(sorter->AddRow({Value::Int64(1), Value::Int64(2)}),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+}
+
+}  // namespace local_service
+}  // namespace zetasql
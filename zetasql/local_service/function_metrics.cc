@@ -0,0 +1,199 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/local_service/function_metrics.h"
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+
+namespace zetasql {
+namespace local_service {
+
+namespace {
+
+ABSL_CONST_INIT std::atomic<int> sampling_period_value{64};
+
+struct Counters {
+  int64_t calls = 0;
+  int64_t sampled_calls = 0;
+  int64_t sampled_nanos = 0;
+  int64_t latency_histogram[FunctionKernelStats::kNumLatencyBuckets] = {};
+
+  void Add(const Counters& other) {
+    calls += other.calls;
+    sampled_calls += other.sampled_calls;
+    sampled_nanos += other.sampled_nanos;
+    for (int i = 0; i < FunctionKernelStats::kNumLatencyBuckets; ++i) {
+      latency_histogram[i] += other.latency_histogram[i];
+    }
+  }
+};
+
+using CountersMap = absl::flat_hash_map<FunctionSignatureId, Counters>;
+
+class ThreadMetrics;
+
+// All the threads that have counters, and the sums of those of the threads
+// that have exited. The registry is locked before the counters of any
+// thread.
+struct Registry {
+  absl::Mutex mutex;
+  absl::flat_hash_set<ThreadMetrics*> threads GUARDED_BY(mutex);
+  CountersMap exited GUARDED_BY(mutex);
+};
+
+Registry* GetRegistry() {
+  static Registry* registry = new Registry;
+  return registry;
+}
+
+// The counters of one thread. Only that thread changes them, so their
+// mutex is only contended by Snapshot() and Reset().
+class ThreadMetrics {
+ public:
+  ThreadMetrics() {
+    Registry* registry = GetRegistry();
+    absl::MutexLock lock(&registry->mutex);
+    registry->threads.insert(this);
+  }
+  ThreadMetrics(const ThreadMetrics&) = delete;
+  ThreadMetrics& operator=(const ThreadMetrics&) = delete;
+
+  ~ThreadMetrics() {
+    Registry* registry = GetRegistry();
+    absl::MutexLock registry_lock(&registry->mutex);
+    registry->threads.erase(this);
+    absl::MutexLock lock(&mutex);
+    for (const auto& entry : counters) {
+      registry->exited[entry.first].Add(entry.second);
+    }
+  }
+
+  absl::Mutex mutex;
+  CountersMap counters GUARDED_BY(mutex);
+  // The number of calls to count before timing the next one.
+  int calls_until_sample = 0;
+};
+
+ThreadMetrics* GetThreadMetrics() {
+  static thread_local ThreadMetrics metrics;
+  return &metrics;
+}
+
+// Returns the histogram bucket of a call that took <nanos>.
+int LatencyBucket(int64_t nanos) {
+  int bucket = 0;
+  while (nanos > 0 && bucket < FunctionKernelStats::kNumLatencyBuckets - 1) {
+    nanos >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+}  // namespace
+
+constexpr int FunctionKernelStats::kNumLatencyBuckets;
+
+std::atomic<bool> FunctionKernelMetrics::enabled_{false};
+
+void FunctionKernelMetrics::SetEnabled(bool enabled) {
+  enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+void FunctionKernelMetrics::SetSamplingPeriod(int period) {
+  sampling_period_value.store(std::max(period, 1), std::memory_order_relaxed);
+}
+
+int FunctionKernelMetrics::sampling_period() {
+  return sampling_period_value.load(std::memory_order_relaxed);
+}
+
+std::vector<FunctionKernelStats> FunctionKernelMetrics::Snapshot() {
+  CountersMap totals;
+  {
+    Registry* registry = GetRegistry();
+    absl::MutexLock registry_lock(&registry->mutex);
+    totals = registry->exited;
+    for (ThreadMetrics* thread : registry->threads) {
+      absl::MutexLock lock(&thread->mutex);
+      for (const auto& entry : thread->counters) {
+        totals[entry.first].Add(entry.second);
+      }
+    }
+  }
+
+  std::vector<FunctionKernelStats> snapshot;
+  snapshot.reserve(totals.size());
+  for (const auto& entry : totals) {
+    FunctionKernelStats stats;
+    stats.function_id = entry.first;
+    stats.calls = entry.second.calls;
+    stats.sampled_calls = entry.second.sampled_calls;
+    stats.sampled_nanos = entry.second.sampled_nanos;
+    stats.latency_histogram.assign(
+        std::begin(entry.second.latency_histogram),
+        std::end(entry.second.latency_histogram));
+    snapshot.push_back(std::move(stats));
+  }
+  std::sort(snapshot.begin(), snapshot.end(),
+            [](const FunctionKernelStats& a, const FunctionKernelStats& b) {
+              return std::make_tuple(-a.calls, a.function_id) <
+                     std::make_tuple(-b.calls, b.function_id);
+            });
+  return snapshot;
+}
+
+void FunctionKernelMetrics::Reset() {
+  Registry* registry = GetRegistry();
+  absl::MutexLock registry_lock(&registry->mutex);
+  registry->exited.clear();
+  for (ThreadMetrics* thread : registry->threads) {
+    absl::MutexLock lock(&thread->mutex);
+    thread->counters.clear();
+  }
+}
+
+void FunctionKernelCallRecorder::Start(FunctionSignatureId function_id) {
+  ThreadMetrics* metrics = GetThreadMetrics();
+  {
+    absl::MutexLock lock(&metrics->mutex);
+    ++metrics->counters[function_id].calls;
+  }
+  if (--metrics->calls_until_sample > 0) return;
+  metrics->calls_until_sample = FunctionKernelMetrics::sampling_period();
+  function_id_ = function_id;
+  start_nanos_ = absl::GetCurrentTimeNanos();
+}
+
+void FunctionKernelCallRecorder::Finish() {
+  const int64_t nanos = absl::GetCurrentTimeNanos() - start_nanos_;
+  ThreadMetrics* metrics = GetThreadMetrics();
+  absl::MutexLock lock(&metrics->mutex);
+  Counters& counters = metrics->counters[function_id_];
+  ++counters.sampled_calls;
+  counters.sampled_nanos += nanos;
+  ++counters.latency_histogram[LatencyBucket(nanos)];
+}
+
+}  // namespace local_service
+}  // namespace zetasql
@@ -0,0 +1,111 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_LOCAL_SERVICE_FUNCTION_METRICS_H_
+#define ZETASQL_LOCAL_SERVICE_FUNCTION_METRICS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "zetasql/public/builtin_function.pb.h"
+#include "absl/base/optimization.h"
+
+namespace zetasql {
+namespace local_service {
+
+// The calls of the kernel of one builtin function, summed over all threads.
+struct FunctionKernelStats {
+  static constexpr int kNumLatencyBuckets = 32;
+
+  FunctionSignatureId function_id = static_cast<FunctionSignatureId>(0);
+  int64_t calls = 0;
+  // The calls that were timed, one in FunctionKernelMetrics::
+  // sampling_period(), and their total time.
+  int64_t sampled_calls = 0;
+  int64_t sampled_nanos = 0;
+  // latency_histogram[i] counts the sampled calls that took at least
+  // 2^(i-1) and less than 2^i nanoseconds; the last bucket also counts the
+  // slower ones.
+  std::vector<int64_t> latency_histogram;
+};
+
+// Optional instrumentation of the builtin function kernels that
+// CompiledExpression dispatches by FunctionSignatureId, to find the
+// functions a workload spends its time in.
+//
+// While enabled, each call is counted in counters of the calling thread,
+// and one call in sampling_period() is timed. Snapshot() sums the counters
+// of all threads, including those that have exited. When disabled, which
+// is the default, a call costs one relaxed atomic load.
+//
+// All methods are thread-safe.
+class FunctionKernelMetrics {
+ public:
+  FunctionKernelMetrics() = delete;
+
+  static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+  static void SetEnabled(bool enabled);
+
+  // Sets how many calls are counted for each call that is timed, per
+  // thread. Defaults to 64; values below 1 mean 1.
+  static void SetSamplingPeriod(int period);
+  static int sampling_period();
+
+  // Returns the stats of the functions called since the last Reset(), with
+  // the most called first.
+  static std::vector<FunctionKernelStats> Snapshot();
+
+  // Clears the counters of all threads.
+  static void Reset();
+
+ private:
+  static std::atomic<bool> enabled_;
+};
+
+// Records one call of the kernel of <function_id> in FunctionKernelMetrics
+// while the recorder is alive, if the metrics are enabled:
+//
+//   FunctionKernelCallRecorder recorder(instruction.function_id);
+//   status = instruction.function(args, &result);
+class FunctionKernelCallRecorder {
+ public:
+  explicit FunctionKernelCallRecorder(FunctionSignatureId function_id) {
+    if (ABSL_PREDICT_FALSE(FunctionKernelMetrics::enabled())) {
+      Start(function_id);
+    }
+  }
+  FunctionKernelCallRecorder(const FunctionKernelCallRecorder&) = delete;
+  FunctionKernelCallRecorder& operator=(const FunctionKernelCallRecorder&) =
+      delete;
+
+  ~FunctionKernelCallRecorder() {
+    if (ABSL_PREDICT_FALSE(start_nanos_ >= 0)) Finish();
+  }
+
+ private:
+  void Start(FunctionSignatureId function_id);
+  void Finish();
+
+  FunctionSignatureId function_id_ = static_cast<FunctionSignatureId>(0);
+  // The start of a timed call, or -1.
+  int64_t start_nanos_ = -1;
+};
+
+}  // namespace local_service
+}  // namespace zetasql
+
+#endif  // ZETASQL_LOCAL_SERVICE_FUNCTION_METRICS_H_
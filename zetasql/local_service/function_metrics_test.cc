@@ -0,0 +1,96 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/local_service/function_metrics.h"
+
+#include <cstdint>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "zetasql/public/builtin_function.pb.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace zetasql {
+namespace local_service {
+
+class FunctionKernelMetricsTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    FunctionKernelMetrics::Reset();
+    FunctionKernelMetrics::SetSamplingPeriod(1);
+    FunctionKernelMetrics::SetEnabled(true);
+  }
+
+  void TearDown() override {
+    FunctionKernelMetrics::SetEnabled(false);
+    FunctionKernelMetrics::SetSamplingPeriod(64);
+    FunctionKernelMetrics::Reset();
+  }
+
+  static void Call(FunctionSignatureId function_id, int times) {
+    for (int i = 0; i < times; ++i) {
+      FunctionKernelCallRecorder recorder(function_id);
+    }
+  }
+};
+
+TEST_F(FunctionKernelMetricsTest, SumsThreads) {
+  Call(FN_ADD_INT64, 3);
+  std::thread thread([] {
+    Call(FN_ADD_INT64, 2);
+    Call(FN_LESS, 7);
+  });
+  thread.join();  // Its counters outlive it.
+
+  const std::vector<FunctionKernelStats> snapshot =
+      FunctionKernelMetrics::Snapshot();
+  ASSERT_EQ(2, snapshot.size());
+  EXPECT_EQ(FN_LESS, snapshot[0].function_id);
+  EXPECT_EQ(7, snapshot[0].calls);
+  EXPECT_EQ(FN_ADD_INT64, snapshot[1].function_id);
+  EXPECT_EQ(5, snapshot[1].calls);
+  EXPECT_EQ(5, snapshot[1].sampled_calls);
+  ASSERT_EQ(FunctionKernelStats::kNumLatencyBuckets,
+            snapshot[1].latency_histogram.size());
+  int64_t histogram_calls = 0;
+  for (const int64_t count : snapshot[1].latency_histogram) {
+    histogram_calls += count;
+  }
+  EXPECT_EQ(5, histogram_calls);
+
+  FunctionKernelMetrics::Reset();
+  EXPECT_TRUE(FunctionKernelMetrics::Snapshot().empty());
+}
+
+TEST_F(FunctionKernelMetricsTest, SamplesAndDisables) {
+  FunctionKernelMetrics::SetSamplingPeriod(4);
+  Call(FN_CONCAT_STRING, 8);
+  std::vector<FunctionKernelStats> snapshot =
+      FunctionKernelMetrics::Snapshot();
+  ASSERT_EQ(1, snapshot.size());
+  EXPECT_EQ(8, snapshot[0].calls);
+  EXPECT_EQ(2, snapshot[0].sampled_calls);
+
+  FunctionKernelMetrics::SetEnabled(false);
+  Call(FN_CONCAT_STRING, 8);
+  snapshot = FunctionKernelMetrics::Snapshot();
+  ASSERT_EQ(1, snapshot.size());
+  EXPECT_EQ(8, snapshot[0].calls);
+}
+
+}  // namespace local_service
+}  // namespace zetasql
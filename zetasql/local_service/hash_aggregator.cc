@@ -0,0 +1,744 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "zetasql/local_service/hash_aggregator.h"
+
+#include <atomic>
+#include <cmath>
+#include <utility>
+
+#include "zetasql/base/logging.h"
+#include "zetasql/public/builtin_function.pb.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/functions/arithmetics.h"
+#include "absl/memory/memory.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/source_location.h"
+#include "zetasql/base/status_builder.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+namespace local_service {
+
+namespace {
+
+// How the state of an aggregate holds its running value.
+enum class StateKind { kInt64, kUint64, kDouble, kNumeric, kBool, kValue };
+
+constexpr int kInitialSlots = 16;
+
+// Mixes the bits of <hash>, so that both the low bits, which pick the slot,
+// and the high bits, which pick the spill partition, depend on every key.
+uint64_t MixHash(uint64_t hash) {
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+// Returns the hash of a group, which combines Value::HashCode() of its keys
+// and so is consistent with Value::Equals().
+uint64_t HashKeys(absl::Span<const Value> keys) {
+  uint64_t hash = 0x9e3779b97f4a7c15ULL;
+  for (const Value& key : keys) {
+    hash = (hash ^ key.HashCode()) * 0x100000001b3ULL;
+  }
+  return MixHash(hash);
+}
+
+bool IsNaN(const Value& value) {
+  return value.type()->IsFloatingPoint() && !value.is_null() &&
+         std::isnan(value.ToDouble());
+}
+
+// Returns how SUM and AVG accumulate values of <type>.
+zetasql_base::StatusOr<StateKind> SumKind(const Type* type) {
+  switch (type->kind()) {
+    case TYPE_INT64:
+      return StateKind::kInt64;
+    case TYPE_UINT64:
+      return StateKind::kUint64;
+    case TYPE_DOUBLE:
+      return StateKind::kDouble;
+    case TYPE_NUMERIC:
+      return StateKind::kNumeric;
+    default:
+      return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+             << "SUM and AVG do not support arguments of type "
+             << type->DebugString();
+  }
+}
+
+}  // namespace
+
+struct HashAggregator::AggregateInfo {
+  AggregateFunction function;
+  int argument;
+  StateKind kind = StateKind::kValue;
+  const Type* partial_type = nullptr;
+  const Type* output_type = nullptr;
+  // For kMin and kMax, orders the argument values.
+  Value::Comparator less;
+};
+
+struct HashAggregator::State {
+  // The number of non-NULL values aggregated, or of rows for kCountStar.
+  // For kSum it is only compared with 0.
+  int64_t count = 0;
+  union {
+    int64_t int64_value = 0;
+    uint64_t uint64_value;
+    double double_value;
+    bool bool_value;
+  };
+  NumericValue::Aggregator numeric;
+  // For kMin, kMax and kAnyValue.
+  Value value;
+};
+
+class HashAggregator::OutputIterator : public EvaluatorTableIterator {
+ public:
+  explicit OutputIterator(HashAggregator* aggregator)
+      : aggregator_(aggregator) {}
+
+  int NumColumns() const override {
+    return aggregator_->output_types_.size();
+  }
+  std::string GetColumnName(int i) const override { return ""; }
+  const Type* GetColumnType(int i) const override {
+    return aggregator_->output_types_[i];
+  }
+
+  bool NextRow() override {
+    if (!status_.ok()) return false;
+    if (cancelled_) {
+      status_ = ::zetasql_base::CancelledErrorBuilder(ZETASQL_LOC)
+                << "HashAggregator output was cancelled";
+      return false;
+    }
+    while (next_group_ >= aggregator_->num_groups()) {
+      if (next_partition_ >= aggregator_->spill_files_.size()) return false;
+      status_ = aggregator_->LoadPartition(next_partition_++);
+      if (!status_.ok()) return false;
+      next_group_ = 0;
+    }
+    status_ = aggregator_->GetRow(
+        next_group_++, aggregator_->mode_ == kPartial, &row_);
+    return status_.ok();
+  }
+
+  const Value& GetValue(int i) const override { return row_[i]; }
+
+  zetasql_base::Status Status() const override { return status_; }
+
+  zetasql_base::Status Cancel() override {
+    cancelled_ = true;
+    return ::zetasql_base::OkStatus();
+  }
+
+ private:
+  HashAggregator* aggregator_;
+  int64_t next_group_ = 0;
+  int next_partition_ = 0;
+  std::vector<Value> row_;
+  zetasql_base::Status status_;
+  std::atomic<bool> cancelled_{false};
+};
+
+// Reserves the memory of the table in Options::memory_pool, and spills it
+// when another consumer of the pool needs the memory.
+class HashAggregator::PoolConsumer : public MemoryConsumer {
+ public:
+  explicit PoolConsumer(HashAggregator* aggregator)
+      : MemoryConsumer("HashAggregator", aggregator->options_.memory_pool),
+        aggregator_(aggregator) {}
+
+  bool CanSpill() const override {
+    return !aggregator_->finished_ && aggregator_->num_groups() > 0;
+  }
+
+ protected:
+  zetasql_base::Status Spill() override { return aggregator_->Spill(); }
+
+ private:
+  HashAggregator* aggregator_;
+};
+
+HashAggregator::HashAggregator(const Options& options,
+                               TypeFactory* type_factory)
+    : options_(options), type_factory_(type_factory) {}
+
+HashAggregator::~HashAggregator() {}
+
+zetasql_base::StatusOr<HashAggregator::Aggregate> HashAggregator::AggregateForCall(
+    const ResolvedAggregateFunctionCall* call, int argument) {
+  const Function* function = call->function();
+  if (!function->IsZetaSQLBuiltin()) {
+    return ::zetasql_base::UnimplementedErrorBuilder(ZETASQL_LOC)
+           << "Unsupported aggregate function " << function->Name();
+  }
+  if (call->distinct() || call->having_modifier() != nullptr ||
+      call->order_by_item_list_size() > 0 || call->limit() != nullptr ||
+      call->null_handling_modifier() !=
+          ResolvedAggregateFunctionCall::DEFAULT_NULL_HANDLING ||
+      call->error_mode() != ResolvedAggregateFunctionCall::DEFAULT_ERROR_MODE) {
+    return ::zetasql_base::UnimplementedErrorBuilder(ZETASQL_LOC)
+           << "Unsupported modifiers in call to " << function->Name();
+  }
+  Aggregate aggregate;
+  aggregate.argument = argument;
+  switch (call->signature().context_id()) {
+    case FN_COUNT:
+      aggregate.function = kCount;
+      break;
+    case FN_COUNT_STAR:
+      aggregate.function = kCountStar;
+      aggregate.argument = -1;
+      break;
+    case FN_SUM_INT64:
+    case FN_SUM_UINT64:
+    case FN_SUM_DOUBLE:
+    case FN_SUM_NUMERIC:
+      aggregate.function = kSum;
+      break;
+    case FN_AVG_INT64:
+    case FN_AVG_UINT64:
+    case FN_AVG_DOUBLE:
+    case FN_AVG_NUMERIC:
+      aggregate.function = kAvg;
+      break;
+    case FN_MIN:
+      aggregate.function = kMin;
+      break;
+    case FN_MAX:
+      aggregate.function = kMax;
+      break;
+    case FN_ANY_VALUE:
+      aggregate.function = kAnyValue;
+      break;
+    case FN_LOGICAL_AND:
+      aggregate.function = kLogicalAnd;
+      break;
+    case FN_LOGICAL_OR:
+      aggregate.function = kLogicalOr;
+      break;
+    default:
+      return ::zetasql_base::UnimplementedErrorBuilder(ZETASQL_LOC)
+             << "Unsupported aggregate function " << function->Name();
+  }
+  return aggregate;
+}
+
+zetasql_base::StatusOr<std::unique_ptr<HashAggregator>> HashAggregator::Create(
+    absl::Span<const Type* const> input_types,
+    absl::Span<const int> key_columns, absl::Span<const Aggregate> aggregates,
+    Mode mode, const Options& options, TypeFactory* type_factory) {
+  ZETASQL_RET_CHECK(type_factory != nullptr);
+  if (options.num_spill_partitions < 1) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "num_spill_partitions must be positive";
+  }
+  auto aggregator =
+      absl::WrapUnique(new HashAggregator(options, type_factory));
+  aggregator->mode_ = mode;
+  aggregator->num_input_columns_ = input_types.size();
+  for (const int column : key_columns) {
+    if (column < 0 || column >= input_types.size()) {
+      return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+             << "Key column " << column << " is out of range";
+    }
+    aggregator->key_columns_.push_back(column);
+    aggregator->key_types_.push_back(input_types[column]);
+  }
+  for (const Aggregate& aggregate : aggregates) {
+    AggregateInfo info;
+    info.function = aggregate.function;
+    info.argument = aggregate.argument;
+    const Type* argument_type = nullptr;
+    if (aggregate.function != kCountStar || mode == kFinal) {
+      if (aggregate.argument < 0 ||
+          aggregate.argument >= input_types.size()) {
+        return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+               << "Aggregate argument column " << aggregate.argument
+               << " is out of range";
+      }
+      argument_type = input_types[aggregate.argument];
+    }
+    ZETASQL_RETURN_IF_ERROR(aggregator->InitAggregate(argument_type, &info));
+    aggregator->aggregates_.push_back(info);
+    aggregator->partial_types_.push_back(info.partial_type);
+  }
+
+  aggregator->output_types_ = aggregator->key_types_;
+  aggregator->spill_types_ = aggregator->key_types_;
+  for (const AggregateInfo& info : aggregator->aggregates_) {
+    aggregator->output_types_.push_back(
+        mode == kPartial ? info.partial_type : info.output_type);
+    aggregator->spill_types_.push_back(info.partial_type);
+  }
+  // Each group also has about two slots in the table.
+  aggregator->group_bytes_ = sizeof(uint64_t) + 2 * sizeof(int32_t) +
+                             key_columns.size() * sizeof(Value) +
+                             aggregates.size() * sizeof(State);
+  aggregator->Clear();
+  if (options.memory_pool != nullptr) {
+    aggregator->memory_consumer_ =
+        absl::make_unique<PoolConsumer>(aggregator.get());
+  }
+  return aggregator;
+}
+
+zetasql_base::Status HashAggregator::InitAggregate(const Type* argument_type,
+                                           AggregateInfo* info) {
+  const bool final = mode_ == kFinal;
+  switch (info->function) {
+    case kCount:
+    case kCountStar:
+      info->kind = StateKind::kInt64;
+      info->partial_type = types::Int64Type();
+      info->output_type = types::Int64Type();
+      break;
+    case kSum: {
+      // A partial NUMERIC sum is a serialized NumericValue::Aggregator.
+      const Type* value_type = final && argument_type->IsBytes()
+                                   ? types::NumericType()
+                                   : argument_type;
+      ZETASQL_ASSIGN_OR_RETURN(info->kind, SumKind(value_type));
+      info->partial_type = info->kind == StateKind::kNumeric
+                               ? types::BytesType()
+                               : value_type;
+      info->output_type = value_type;
+      break;
+    }
+    case kAvg: {
+      const Type* value_type = argument_type;
+      if (final) {
+        if (!argument_type->IsStruct() ||
+            argument_type->AsStruct()->num_fields() != 2) {
+          return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+                 << "Invalid partial AVG state of type "
+                 << argument_type->DebugString();
+        }
+        value_type = argument_type->AsStruct()->field(0).type;
+        if (value_type->IsBytes()) value_type = types::NumericType();
+      }
+      ZETASQL_ASSIGN_OR_RETURN(info->kind, SumKind(value_type));
+      // Integers are averaged as doubles.
+      if (info->kind != StateKind::kNumeric) info->kind = StateKind::kDouble;
+      const bool numeric = info->kind == StateKind::kNumeric;
+      const StructType* partial_type;
+      ZETASQL_RETURN_IF_ERROR(type_factory_->MakeStructType(
+          {{"sum", numeric ? types::BytesType() : types::DoubleType()},
+           {"count", types::Int64Type()}},
+          &partial_type));
+      info->partial_type = partial_type;
+      info->output_type =
+          numeric ? types::NumericType() : types::DoubleType();
+      break;
+    }
+    case kMin:
+    case kMax:
+      if (!argument_type->SupportsOrdering()) {
+        return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+               << "MIN and MAX do not support arguments of type "
+               << argument_type->DebugString();
+      }
+      info->less = Value::MakeComparator(argument_type);
+      ABSL_FALLTHROUGH_INTENDED;
+    case kAnyValue:
+      info->kind = StateKind::kValue;
+      info->partial_type = argument_type;
+      info->output_type = argument_type;
+      break;
+    case kLogicalAnd:
+    case kLogicalOr:
+      if (!argument_type->IsBool()) {
+        return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+               << "LOGICAL_AND and LOGICAL_OR require BOOL arguments, not "
+               << argument_type->DebugString();
+      }
+      info->kind = StateKind::kBool;
+      info->partial_type = types::BoolType();
+      info->output_type = types::BoolType();
+      break;
+  }
+  if (final && !argument_type->Equivalent(info->partial_type)) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "Invalid partial state of type " << argument_type->DebugString()
+           << ", expected " << info->partial_type->DebugString();
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+void HashAggregator::Clear() {
+  slots_.assign(kInitialSlots, -1);
+  group_hashes_.clear();
+  keys_.clear();
+  states_.clear();
+  memory_used_bytes_ = 0;
+  if (memory_consumer_ != nullptr) {
+    // Releasing memory cannot fail.
+    memory_consumer_->SetUsedBytes(0).IgnoreError();
+  }
+}
+
+void HashAggregator::Grow() {
+  slots_.assign(slots_.size() * 2, -1);
+  const uint64_t mask = slots_.size() - 1;
+  for (int32_t group = 0; group < group_hashes_.size(); ++group) {
+    uint64_t i = group_hashes_[group] & mask;
+    while (slots_[i] >= 0) i = (i + 1) & mask;
+    slots_[i] = group;
+  }
+}
+
+int HashAggregator::FindOrAddGroup(absl::Span<const Value> keys,
+                                   uint64_t hash) {
+  const int num_keys = key_types_.size();
+  const uint64_t mask = slots_.size() - 1;
+  for (uint64_t i = hash & mask;; i = (i + 1) & mask) {
+    const int32_t group = slots_[i];
+    if (group < 0) break;
+    if (group_hashes_[group] != hash) continue;
+    bool equal = true;
+    for (int k = 0; k < num_keys; ++k) {
+      if (!keys_[group * num_keys + k].Equals(keys[k])) {
+        equal = false;
+        break;
+      }
+    }
+    if (equal) return group;
+  }
+
+  const int32_t group = group_hashes_.size();
+  group_hashes_.push_back(hash);
+  for (const Value& key : keys) {
+    keys_.push_back(key);
+    memory_used_bytes_ += ValueHeapBytes(key);
+  }
+  states_.resize(states_.size() + aggregates_.size());
+  memory_used_bytes_ += group_bytes_;
+  if (2 * group_hashes_.size() > slots_.size()) {
+    Grow();
+  } else {
+    uint64_t i = hash & mask;
+    while (slots_[i] >= 0) i = (i + 1) & mask;
+    slots_[i] = group;
+  }
+  return group;
+}
+
+void HashAggregator::SetValue(const Value& value, State* state) {
+  memory_used_bytes_ += ValueHeapBytes(value) - ValueHeapBytes(state->value);
+  state->value = value;
+}
+
+zetasql_base::Status HashAggregator::Accumulate(const AggregateInfo& info,
+                                        const Value& value, State* state) {
+  if (info.function == kCountStar) {
+    ++state->count;
+    return ::zetasql_base::OkStatus();
+  }
+  if (value.is_null()) return ::zetasql_base::OkStatus();
+  zetasql_base::Status status;
+  switch (info.function) {
+    case kCount:
+    case kCountStar:
+      break;
+    case kSum:
+    case kAvg:
+      switch (info.kind) {
+        case StateKind::kInt64:
+          if (!functions::Add(state->int64_value, value.int64_value(),
+                              &state->int64_value, &status)) {
+            return status;
+          }
+          break;
+        case StateKind::kUint64:
+          if (!functions::Add(state->uint64_value, value.uint64_value(),
+                              &state->uint64_value, &status)) {
+            return status;
+          }
+          break;
+        case StateKind::kDouble:
+          state->double_value += value.ToDouble();
+          break;
+        case StateKind::kNumeric:
+          state->numeric.Add(value.numeric_value());
+          break;
+        default:
+          ZETASQL_RET_CHECK_FAIL() << "Unexpected state for SUM or AVG";
+      }
+      break;
+    case kMin:
+    case kMax:
+      // NaN is returned if there is any NaN in the input.
+      if (state->count == 0 ||
+          (!IsNaN(state->value) &&
+           (IsNaN(value) || (info.function == kMin
+                                 ? info.less(value, state->value)
+                                 : info.less(state->value, value))))) {
+        SetValue(value, state);
+      }
+      break;
+    case kAnyValue:
+      if (state->count == 0) SetValue(value, state);
+      break;
+    case kLogicalAnd:
+      state->bool_value =
+          (state->count == 0 || state->bool_value) && value.bool_value();
+      break;
+    case kLogicalOr:
+      state->bool_value =
+          (state->count > 0 && state->bool_value) || value.bool_value();
+      break;
+  }
+  ++state->count;
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status HashAggregator::Merge(const AggregateInfo& info,
+                                   const Value& partial, State* state) {
+  switch (info.function) {
+    case kCount:
+    case kCountStar:
+      ZETASQL_RET_CHECK(!partial.is_null());
+      state->count += partial.int64_value();
+      return ::zetasql_base::OkStatus();
+    case kSum:
+      if (info.kind == StateKind::kNumeric && !partial.is_null()) {
+        ZETASQL_ASSIGN_OR_RETURN(const NumericValue::Aggregator sum,
+                         NumericValue::Aggregator::DeserializeFromProtoBytes(
+                             partial.bytes_value()));
+        state->numeric.MergeWith(sum);
+        ++state->count;
+        return ::zetasql_base::OkStatus();
+      }
+      return Accumulate(info, partial, state);
+    case kAvg: {
+      ZETASQL_RET_CHECK(!partial.is_null());
+      const int64_t count = partial.field(1).int64_value();
+      if (count == 0) return ::zetasql_base::OkStatus();
+      if (info.kind == StateKind::kNumeric) {
+        ZETASQL_ASSIGN_OR_RETURN(const NumericValue::Aggregator sum,
+                         NumericValue::Aggregator::DeserializeFromProtoBytes(
+                             partial.field(0).bytes_value()));
+        state->numeric.MergeWith(sum);
+      } else {
+        state->double_value += partial.field(0).double_value();
+      }
+      state->count += count;
+      return ::zetasql_base::OkStatus();
+    }
+    default:
+      // The partial state of the other aggregates is their final value.
+      return Accumulate(info, partial, state);
+  }
+}
+
+Value HashAggregator::PartialValue(const AggregateInfo& info,
+                                   const State& state) const {
+  switch (info.function) {
+    case kCount:
+    case kCountStar:
+      return Value::Int64(state.count);
+    case kSum:
+      if (state.count == 0) return Value::Null(info.partial_type);
+      switch (info.kind) {
+        case StateKind::kInt64:
+          return Value::Int64(state.int64_value);
+        case StateKind::kUint64:
+          return Value::Uint64(state.uint64_value);
+        case StateKind::kDouble:
+          return Value::Double(state.double_value);
+        default:
+          return Value::Bytes(state.numeric.SerializeAsCompactProtoBytes());
+      }
+    case kAvg:
+      return Value::Struct(
+          info.partial_type->AsStruct(),
+          {info.kind == StateKind::kNumeric
+               ? Value::Bytes(state.numeric.SerializeAsCompactProtoBytes())
+               : Value::Double(state.double_value),
+           Value::Int64(state.count)});
+    case kLogicalAnd:
+    case kLogicalOr:
+      if (state.count == 0) return Value::NullBool();
+      return Value::Bool(state.bool_value);
+    default:
+      if (state.count == 0) return Value::Null(info.partial_type);
+      return state.value;
+  }
+}
+
+zetasql_base::StatusOr<Value> HashAggregator::FinalValue(const AggregateInfo& info,
+                                                 const State& state) const {
+  if (info.kind == StateKind::kNumeric) {
+    if (state.count == 0) return Value::NullNumeric();
+    if (info.function == kSum) {
+      ZETASQL_ASSIGN_OR_RETURN(const NumericValue sum, state.numeric.GetSum());
+      return Value::Numeric(sum);
+    }
+    ZETASQL_ASSIGN_OR_RETURN(const NumericValue average,
+                     state.numeric.GetAverage(state.count));
+    return Value::Numeric(average);
+  }
+  if (info.function == kAvg) {
+    if (state.count == 0) return Value::NullDouble();
+    return Value::Double(state.double_value / state.count);
+  }
+  return PartialValue(info, state);
+}
+
+zetasql_base::Status HashAggregator::AddRow(absl::Span<const Value> row) {
+  ZETASQL_RET_CHECK(!finished_) << "AddRow() called after Finish()";
+  if (row.size() != num_input_columns_) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "Row has " << row.size() << " values but the aggregator expects "
+           << num_input_columns_;
+  }
+  key_buffer_.clear();
+  for (const int column : key_columns_) {
+    key_buffer_.push_back(row[column]);
+  }
+  const int group = FindOrAddGroup(key_buffer_, HashKeys(key_buffer_));
+  State* states = &states_[group * aggregates_.size()];
+  const Value no_argument;
+  for (int i = 0; i < aggregates_.size(); ++i) {
+    const AggregateInfo& info = aggregates_[i];
+    const Value& value = info.argument >= 0 ? row[info.argument] : no_argument;
+    if (mode_ == kFinal) {
+      ZETASQL_RETURN_IF_ERROR(Merge(info, value, &states[i]));
+    } else {
+      ZETASQL_RETURN_IF_ERROR(Accumulate(info, value, &states[i]));
+    }
+  }
+  if (memory_used_bytes_ > options_.memory_budget_bytes) return Spill();
+  if (memory_consumer_ != nullptr &&
+      (memory_consumer_->spill_requested() ||
+       !memory_consumer_->SetUsedBytes(memory_used_bytes_).ok())) {
+    return Spill();
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status HashAggregator::AddRows(EvaluatorTableIterator* input) {
+  if (input->NumColumns() != num_input_columns_) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "Input has " << input->NumColumns()
+           << " columns but the aggregator expects " << num_input_columns_;
+  }
+  std::vector<Value> row(num_input_columns_);
+  while (input->NextRow()) {
+    for (int i = 0; i < row.size(); ++i) {
+      row[i] = input->GetValue(i);
+    }
+    ZETASQL_RETURN_IF_ERROR(AddRow(row));
+  }
+  return input->Status();
+}
+
+zetasql_base::Status HashAggregator::MergeRow(absl::Span<const Value> row,
+                                      uint64_t hash) {
+  const int num_keys = key_types_.size();
+  const int group = FindOrAddGroup(row.subspan(0, num_keys), hash);
+  State* states = &states_[group * aggregates_.size()];
+  for (int i = 0; i < aggregates_.size(); ++i) {
+    ZETASQL_RETURN_IF_ERROR(
+        Merge(aggregates_[i], row[num_keys + i], &states[i]));
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status HashAggregator::GetRow(int group, bool partial,
+                                    std::vector<Value>* row) const {
+  const int num_keys = key_types_.size();
+  row->assign(keys_.begin() + group * num_keys,
+              keys_.begin() + (group + 1) * num_keys);
+  const State* states = &states_[group * aggregates_.size()];
+  for (int i = 0; i < aggregates_.size(); ++i) {
+    if (partial) {
+      row->push_back(PartialValue(aggregates_[i], states[i]));
+    } else {
+      ZETASQL_ASSIGN_OR_RETURN(Value value,
+                       FinalValue(aggregates_[i], states[i]));
+      row->push_back(std::move(value));
+    }
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status HashAggregator::Spill() {
+  if (spill_files_.empty()) {
+    for (int i = 0; i < options_.num_spill_partitions; ++i) {
+      ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<SpillFile> file,
+                       SpillFile::Create(options_.spill_directory));
+      spill_files_.push_back(std::move(file));
+    }
+  }
+  // A spilled group is the hash of its keys, followed by its partial row.
+  std::vector<Value> row;
+  for (int group = 0; group < num_groups(); ++group) {
+    ZETASQL_RETURN_IF_ERROR(GetRow(group, /*partial=*/true, &row));
+    const uint64_t hash = group_hashes_[group];
+    SpillFile* file = spill_files_[(hash >> 32) % spill_files_.size()].get();
+    ZETASQL_RETURN_IF_ERROR(file->Write(&hash, sizeof(hash)));
+    ZETASQL_RETURN_IF_ERROR(file->WriteValues(row));
+    ++num_spilled_rows_;
+  }
+  Clear();
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status HashAggregator::LoadPartition(int partition) {
+  Clear();
+  SpillFile* file = spill_files_[partition].get();
+  ZETASQL_RETURN_IF_ERROR(file->Rewind());
+  std::vector<Value> row;
+  uint64_t hash;
+  while (true) {
+    ZETASQL_ASSIGN_OR_RETURN(const bool found, file->Read(&hash, sizeof(hash)));
+    if (!found) break;
+    ZETASQL_RETURN_IF_ERROR(file->ReadValues(spill_types_, &row));
+    ZETASQL_RETURN_IF_ERROR(MergeRow(row, hash));
+    if (memory_consumer_ != nullptr) {
+      ZETASQL_RETURN_IF_ERROR(
+          memory_consumer_->SetUsedBytes(memory_used_bytes_));
+    }
+  }
+  spill_files_[partition].reset();
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::StatusOr<std::unique_ptr<EvaluatorTableIterator>>
+HashAggregator::Finish() {
+  ZETASQL_RET_CHECK(!finished_) << "Finish() called twice";
+  finished_ = true;
+  if (!spill_files_.empty()) {
+    ZETASQL_RETURN_IF_ERROR(Spill());
+  } else if (key_types_.empty() && group_hashes_.empty()) {
+    // Aggregation without GROUP BY has one output row even without input.
+    FindOrAddGroup({}, HashKeys({}));
+  }
+  return std::unique_ptr<EvaluatorTableIterator>(
+      absl::make_unique<OutputIterator>(this));
+}
+
+}  // namespace local_service
+}  // namespace zetasql
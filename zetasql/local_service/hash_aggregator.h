@@ -0,0 +1,238 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef ZETASQL_LOCAL_SERVICE_HASH_AGGREGATOR_H_
+#define ZETASQL_LOCAL_SERVICE_HASH_AGGREGATOR_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/local_service/memory_pool.h"
+#include "zetasql/local_service/spill_file.h"
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/numeric_value.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "absl/types/span.h"
+#include "zetasql/base/status.h"
+#include "zetasql/base/statusor.h"
+
+namespace zetasql {
+namespace local_service {
+
+// Groups rows by a list of key columns and computes builtin aggregates for
+// each group, as for a ResolvedAggregateScan without grouping sets.
+//
+// Groups are kept in an open-addressing hash table with linear probing,
+// keyed by a hash that combines Value::HashCode() of each key, and compared
+// with Value::Equals(), so that NULLs group together and so do NaNs. Each
+// group holds one fixed-size state per aggregate.
+//
+// Aggregation can be split in two phases: aggregators in kPartial mode
+// output one partial state per aggregate rather than the final value, and
+// an aggregator in kFinal mode merges rows of such partial states, for
+// example from several workers, into the final values.
+//
+// When the estimated size of the hash table exceeds
+// Options::memory_budget_bytes, all groups are written as partial states to
+// one of Options::num_spill_partitions temporary files, chosen by the hash
+// of their keys, and the table is cleared. Finish() then merges each
+// partition back in memory, one at a time, so a partition must fit in
+// memory; partitions are not spilled again.
+//
+// With Options::memory_pool, the table also reserves its estimated size in
+// the pool and spills when the pool or an ancestor is full, or when another
+// operator asks it to. Loading a partition that does not fit in the pool
+// fails with kResourceExhausted.
+//
+// Example:
+//   ZETASQL_ASSIGN_OR_RETURN(
+//       std::unique_ptr<HashAggregator> aggregator,
+//       HashAggregator::Create(input_types, /*key_columns=*/{0},
+//                              {{HashAggregator::kSum, 1}},
+//                              HashAggregator::kComplete,
+//                              HashAggregator::Options(), &type_factory));
+//   ZETASQL_RETURN_IF_ERROR(aggregator->AddRows(input.get()));
+//   ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<EvaluatorTableIterator> output,
+//                    aggregator->Finish());
+//
+// This class is not thread-safe.
+class HashAggregator {
+ public:
+  enum AggregateFunction {
+    kCount,       // COUNT(x)
+    kCountStar,   // COUNT(*)
+    kSum,         // SUM(x) of INT64, UINT64, DOUBLE or NUMERIC
+    kAvg,         // AVG(x) of INT64, UINT64, DOUBLE or NUMERIC
+    kMin,         // MIN(x)
+    kMax,         // MAX(x)
+    kAnyValue,    // ANY_VALUE(x)
+    kLogicalAnd,  // LOGICAL_AND(x)
+    kLogicalOr,   // LOGICAL_OR(x)
+  };
+
+  enum Mode {
+    // Input rows are aggregated into final values.
+    kComplete,
+    // Input rows are aggregated into partial states.
+    kPartial,
+    // Input rows hold partial states, which are merged into final values.
+    kFinal,
+  };
+
+  struct Aggregate {
+    AggregateFunction function;
+    // The input column of the argument, or of the partial state in kFinal
+    // mode. Unused for kCountStar.
+    int argument = -1;
+  };
+
+  struct Options {
+    // The estimated size of the hash table above which groups are spilled.
+    int64_t memory_budget_bytes = int64_t{1} << 30;
+    // The directory for spill files. If empty, tmpfile() is used.
+    std::string spill_directory;
+    int num_spill_partitions = 16;
+    // If set, the pool in which the table reserves its memory. Must outlive
+    // the aggregator.
+    MemoryPool* memory_pool = nullptr;
+  };
+
+  HashAggregator(const HashAggregator&) = delete;
+  HashAggregator& operator=(const HashAggregator&) = delete;
+  ~HashAggregator();
+
+  // Returns the Aggregate for <call>, whose argument (if any) is in input
+  // column <argument>. Returns kUnimplemented for functions that are not
+  // listed above and for DISTINCT, HAVING, ORDER BY, LIMIT, IGNORE NULLS
+  // and SAFE calls.
+  static zetasql_base::StatusOr<Aggregate> AggregateForCall(
+      const ResolvedAggregateFunctionCall* call, int argument);
+
+  // Creates an aggregator for rows of <input_types>, grouped by the columns
+  // <key_columns>. In kFinal mode the input rows must have the output types
+  // of a kPartial aggregator with the same aggregates, and <key_columns> and
+  // the arguments of <aggregates> must index its columns. <type_factory>
+  // must outlive the result.
+  static zetasql_base::StatusOr<std::unique_ptr<HashAggregator>> Create(
+      absl::Span<const Type* const> input_types,
+      absl::Span<const int> key_columns,
+      absl::Span<const Aggregate> aggregates, Mode mode,
+      const Options& options, TypeFactory* type_factory);
+
+  // The types of the output rows: the keys, followed by the final value of
+  // each aggregate, or its partial state in kPartial mode.
+  const std::vector<const Type*>& output_types() const {
+    return output_types_;
+  }
+
+  // Adds one input row. Returns kOutOfRange on arithmetic overflow.
+  zetasql_base::Status AddRow(absl::Span<const Value> row);
+
+  // Adds all rows of <input>, which must have the input types.
+  zetasql_base::Status AddRows(EvaluatorTableIterator* input);
+
+  // Returns an iterator over one row per group, in no particular order.
+  // Spilled partitions are read back as the iterator reaches them. The
+  // iterator reads from this aggregator, which must outlive it and must not
+  // be used otherwise afterwards.
+  zetasql_base::StatusOr<std::unique_ptr<EvaluatorTableIterator>> Finish();
+
+  int64_t num_groups() const { return group_hashes_.size(); }
+  int64_t memory_used_bytes() const { return memory_used_bytes_; }
+  int64_t num_spilled_rows() const { return num_spilled_rows_; }
+
+ private:
+  class OutputIterator;
+  class PoolConsumer;
+  struct AggregateInfo;
+  struct State;
+
+  HashAggregator(const Options& options, TypeFactory* type_factory);
+
+  // Sets the kind and types of <info> for an argument of <argument_type>,
+  // which is null for kCountStar outside kFinal mode.
+  zetasql_base::Status InitAggregate(const Type* argument_type,
+                             AggregateInfo* info);
+
+  // Returns the group with <keys> and <hash>, adding it if needed.
+  int FindOrAddGroup(absl::Span<const Value> keys, uint64_t hash);
+  void Grow();
+
+  zetasql_base::Status Accumulate(const AggregateInfo& info, const Value& value,
+                          State* state);
+  zetasql_base::Status Merge(const AggregateInfo& info, const Value& partial,
+                     State* state);
+  // Sets the value of <state>, keeping memory_used_bytes_ up to date.
+  void SetValue(const Value& value, State* state);
+  Value PartialValue(const AggregateInfo& info, const State& state) const;
+  zetasql_base::StatusOr<Value> FinalValue(const AggregateInfo& info,
+                                   const State& state) const;
+
+  // Adds a row of keys followed by partial states.
+  zetasql_base::Status MergeRow(absl::Span<const Value> row, uint64_t hash);
+
+  // Returns output row <group>, or the partial row for spilling if
+  // <partial> is true.
+  zetasql_base::Status GetRow(int group, bool partial,
+                      std::vector<Value>* row) const;
+
+  // Writes every group to its spill partition and clears the table.
+  zetasql_base::Status Spill();
+  // Clears the table and loads spill partition <partition> into it.
+  zetasql_base::Status LoadPartition(int partition);
+  // Clears the table and releases its memory in the pool, if any.
+  void Clear();
+
+  const Options options_;
+  TypeFactory* type_factory_;
+  Mode mode_ = kComplete;
+  int num_input_columns_ = 0;
+  std::vector<int> key_columns_;
+  std::vector<const Type*> key_types_;
+  std::vector<AggregateInfo> aggregates_;
+  std::vector<const Type*> partial_types_;
+  std::vector<const Type*> output_types_;
+  // The keys followed by the partial states, as written to spill files.
+  std::vector<const Type*> spill_types_;
+  // The estimated size of each group, not counting the contents of values.
+  int64_t group_bytes_ = 0;
+
+  // The hash table: each slot holds a group index or -1, and group i has
+  // keys_[i * num keys, ...), states_[i * num aggregates, ...) and hash
+  // group_hashes_[i].
+  std::vector<int32_t> slots_;
+  std::vector<uint64_t> group_hashes_;
+  std::vector<Value> keys_;
+  std::vector<State> states_;
+  int64_t memory_used_bytes_ = 0;
+
+  std::vector<std::unique_ptr<SpillFile>> spill_files_;
+  int64_t num_spilled_rows_ = 0;
+  bool finished_ = false;
+  std::vector<Value> key_buffer_;
+  // Only set with Options::memory_pool.
+  std::unique_ptr<MemoryConsumer> memory_consumer_;
+};
+
+}  // namespace local_service
+}  // namespace zetasql
+
+#endif  // ZETASQL_LOCAL_SERVICE_HASH_AGGREGATOR_H_
@@ -0,0 +1,327 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "zetasql/local_service/hash_aggregator.h"
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/builtin_function.pb.h"
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/numeric_value.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+
+namespace zetasql {
+namespace local_service {
+
+using zetasql_base::testing::StatusIs;
+
+// Returns <rows>, which have <types>.
+class RowIterator : public EvaluatorTableIterator {
+ public:
+  RowIterator(std::vector<const Type*> types,
+              std::vector<std::vector<Value>> rows)
+      : types_(std::move(types)), rows_(std::move(rows)) {}
+
+  int NumColumns() const override { return types_.size(); }
+  std::string GetColumnName(int i) const override { return ""; }
+  const Type* GetColumnType(int i) const override { return types_[i]; }
+  bool NextRow() override { return ++row_ < rows_.size(); }
+  const Value& GetValue(int i) const override { return rows_[row_][i]; }
+  zetasql_base::Status Status() const override { return zetasql_base::OkStatus(); }
+  zetasql_base::Status Cancel() override { return zetasql_base::OkStatus(); }
+
+ private:
+  std::vector<const Type*> types_;
+  std::vector<std::vector<Value>> rows_;
+  int row_ = -1;
+};
+
+// Returns the rows of <iterator>, keyed by the debug strings of their first
+// <num_keys> values.
+std::map<std::string, std::vector<Value>> ReadRows(
+    int num_keys, EvaluatorTableIterator* iterator) {
+  std::map<std::string, std::vector<Value>> rows;
+  while (iterator->NextRow()) {
+    std::vector<std::string> keys;
+    std::vector<Value> values;
+    for (int i = 0; i < iterator->NumColumns(); ++i) {
+      if (i < num_keys) {
+        keys.push_back(iterator->GetValue(i).DebugString());
+      } else {
+        values.push_back(iterator->GetValue(i));
+      }
+    }
+    EXPECT_TRUE(rows.emplace(absl::StrJoin(keys, ","), values).second);
+  }
+  ZETASQL_EXPECT_OK(iterator->Status());
+  return rows;
+}
+
+class HashAggregatorTest : public ::testing::Test {
+ protected:
+  // Aggregates <rows> of <types> in kComplete mode.
+  std::map<std::string, std::vector<Value>> Aggregate(
+      std::vector<const Type*> types, std::vector<std::vector<Value>> rows,
+      const std::vector<int>& key_columns,
+      const std::vector<HashAggregator::Aggregate>& aggregates,
+      const HashAggregator::Options& options = HashAggregator::Options()) {
+    auto aggregator =
+        HashAggregator::Create(types, key_columns, aggregates,
+                               HashAggregator::kComplete, options,
+                               &type_factory_);
+    ZETASQL_EXPECT_OK(aggregator.status());
+    if (!aggregator.ok()) return {};
+    RowIterator input(types, std::move(rows));
+    ZETASQL_EXPECT_OK(aggregator.ValueOrDie()->AddRows(&input));
+    num_spilled_rows_ = aggregator.ValueOrDie()->num_spilled_rows();
+    auto output = aggregator.ValueOrDie()->Finish();
+    ZETASQL_EXPECT_OK(output.status());
+    if (!output.ok()) return {};
+    return ReadRows(key_columns.size(), output.ValueOrDie().get());
+  }
+
+  TypeFactory type_factory_;
+  int64_t num_spilled_rows_ = 0;
+};
+
+TEST_F(HashAggregatorTest, GroupsAndAggregates) {
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  auto rows = Aggregate(
+      {types::StringType(), types::Int64Type(), types::DoubleType(),
+       types::BoolType()},
+      {{Value::String("a"), Value::Int64(1), Value::Double(1.5),
+        Value::Bool(true)},
+       {Value::String("b"), Value::NullInt64(), Value::Double(nan),
+        Value::Bool(false)},
+       {Value::String("a"), Value::Int64(3), Value::NullDouble(),
+        Value::Bool(false)},
+       {Value::NullString(), Value::Int64(5), Value::Double(2),
+        Value::Bool(true)},
+       {Value::String("b"), Value::Int64(2), Value::Double(1),
+        Value::NullBool()}},
+      /*key_columns=*/{0},
+      {{HashAggregator::kCountStar},
+       {HashAggregator::kCount, 1},
+       {HashAggregator::kSum, 1},
+       {HashAggregator::kAvg, 1},
+       {HashAggregator::kMin, 2},
+       {HashAggregator::kMax, 2},
+       {HashAggregator::kLogicalAnd, 3},
+       {HashAggregator::kAnyValue, 1}});
+  ASSERT_EQ(3, rows.size());
+  EXPECT_EQ(std::vector<Value>({Value::Int64(2), Value::Int64(2),
+                                Value::Int64(4), Value::Double(2),
+                                Value::Double(1.5), Value::Double(1.5),
+                                Value::Bool(false), Value::Int64(1)}),
+            rows["\"a\""]);
+  EXPECT_EQ(std::vector<Value>({Value::Int64(2), Value::Int64(1),
+                                Value::Int64(2), Value::Double(2),
+                                Value::Double(nan), Value::Double(nan),
+                                Value::Bool(false), Value::Int64(2)}),
+            rows["\"b\""]);
+  EXPECT_EQ(std::vector<Value>({Value::Int64(1), Value::Int64(1),
+                                Value::Int64(5), Value::Double(5),
+                                Value::Double(2), Value::Double(2),
+                                Value::Bool(true), Value::Int64(5)}),
+            rows["NULL"]);
+}
+
+TEST_F(HashAggregatorTest, NoGroupBy) {
+  // Without GROUP BY there is one row even without input.
+  auto rows = Aggregate({types::Int64Type()}, /*rows=*/{}, /*key_columns=*/{},
+                        {{HashAggregator::kCountStar},
+                         {HashAggregator::kSum, 0}});
+  ASSERT_EQ(1, rows.size());
+  EXPECT_EQ(std::vector<Value>({Value::Int64(0), Value::NullInt64()}),
+            rows[""]);
+}
+
+TEST_F(HashAggregatorTest, PartialAndFinal) {
+  const std::vector<const Type*> types = {
+      types::Int64Type(), types::NumericType(), types::StringType()};
+  const std::vector<HashAggregator::Aggregate> aggregates = {
+      {HashAggregator::kSum, 1},
+      {HashAggregator::kAvg, 1},
+      {HashAggregator::kAvg, 0},
+      {HashAggregator::kCount, 2},
+      {HashAggregator::kMax, 2}};
+  const std::vector<std::vector<Value>> inputs[] = {
+      {{Value::Int64(1), Value::Numeric(NumericValue(3)), Value::String("x")},
+       {Value::Int64(2), Value::NullNumeric(), Value::String("y")}},
+      {{Value::Int64(1), Value::Numeric(NumericValue(4)), Value::NullString()},
+       {Value::Int64(1), Value::Numeric(NumericValue(2)), Value::String("z")}},
+  };
+
+  std::vector<std::vector<Value>> partial_rows;
+  std::vector<const Type*> partial_types;
+  for (const auto& input : inputs) {
+    ZETASQL_ASSERT_OK_AND_ASSIGN(
+        auto aggregator,
+        HashAggregator::Create(types, /*key_columns=*/{0}, aggregates,
+                               HashAggregator::kPartial,
+                               HashAggregator::Options(), &type_factory_));
+    RowIterator rows(types, input);
+    ZETASQL_ASSERT_OK(aggregator->AddRows(&rows));
+    ZETASQL_ASSERT_OK_AND_ASSIGN(auto output, aggregator->Finish());
+    partial_types = aggregator->output_types();
+    while (output->NextRow()) {
+      std::vector<Value> row;
+      for (int i = 0; i < output->NumColumns(); ++i) {
+        row.push_back(output->GetValue(i));
+      }
+      partial_rows.push_back(row);
+    }
+    ZETASQL_ASSERT_OK(output->Status());
+  }
+  ASSERT_EQ(6, partial_types.size());
+  EXPECT_TRUE(partial_types[1]->IsBytes());
+  EXPECT_TRUE(partial_types[2]->IsStruct());
+
+  const std::vector<HashAggregator::Aggregate> final_aggregates = {
+      {HashAggregator::kSum, 1},
+      {HashAggregator::kAvg, 2},
+      {HashAggregator::kAvg, 3},
+      {HashAggregator::kCount, 4},
+      {HashAggregator::kMax, 5}};
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto aggregator,
+      HashAggregator::Create(partial_types, /*key_columns=*/{0},
+                             final_aggregates, HashAggregator::kFinal,
+                             HashAggregator::Options(), &type_factory_));
+  EXPECT_TRUE(aggregator->output_types()[1]->IsNumericType());
+  EXPECT_TRUE(aggregator->output_types()[3]->IsDouble());
+  RowIterator rows(partial_types, partial_rows);
+  ZETASQL_ASSERT_OK(aggregator->AddRows(&rows));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto output, aggregator->Finish());
+  auto result = ReadRows(1, output.get());
+  ASSERT_EQ(2, result.size());
+  EXPECT_EQ(std::vector<Value>({Value::Numeric(NumericValue(9)),
+                                Value::Numeric(NumericValue(3)),
+                                Value::Double(1), Value::Int64(2),
+                                Value::String("z")}),
+            result["1"]);
+  EXPECT_EQ(std::vector<Value>({Value::NullNumeric(), Value::NullNumeric(),
+                                Value::Double(2), Value::Int64(1),
+                                Value::String("y")}),
+            result["2"]);
+
+  // The partial states must match the aggregates.
+  EXPECT_THAT(HashAggregator::Create(types, /*key_columns=*/{0}, aggregates,
+                                     HashAggregator::kFinal,
+                                     HashAggregator::Options(), &type_factory_)
+                  .status(),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+}
+
+TEST_F(HashAggregatorTest, Spill) {
+  std::vector<std::vector<Value>> input;
+  for (int i = 0; i < 1000; ++i) {
+    input.push_back({Value::String(absl::StrCat("key", i % 100)),
+                     Value::Int64(i)});
+  }
+  const std::vector<const Type*> types = {types::StringType(),
+                                          types::Int64Type()};
+  const std::vector<HashAggregator::Aggregate> aggregates = {
+      {HashAggregator::kCountStar}, {HashAggregator::kSum, 1},
+      {HashAggregator::kMin, 1}};
+  const auto expected = Aggregate(types, input, {0}, aggregates);
+  ASSERT_EQ(100, expected.size());
+  EXPECT_EQ(0, num_spilled_rows_);
+  EXPECT_EQ(std::vector<Value>(
+                {Value::Int64(10), Value::Int64(4570), Value::Int64(7)}),
+            expected.at("\"key7\""));
+
+  HashAggregator::Options options;
+  options.memory_budget_bytes = 2000;
+  options.num_spill_partitions = 4;
+  EXPECT_EQ(expected, Aggregate(types, input, {0}, aggregates, options));
+  EXPECT_GT(num_spilled_rows_, 100);
+
+  options.spill_directory = ::testing::TempDir();
+  options.memory_budget_bytes = 0;
+  EXPECT_EQ(expected, Aggregate(types, input, {0}, aggregates, options));
+  EXPECT_EQ(1000, num_spilled_rows_);
+}
+
+TEST_F(HashAggregatorTest, Errors) {
+  const std::vector<const Type*> types = {types::Int64Type(),
+                                          types::StringType()};
+  EXPECT_THAT(HashAggregator::Create(types, /*key_columns=*/{2}, {},
+                                     HashAggregator::kComplete,
+                                     HashAggregator::Options(), &type_factory_)
+                  .status(),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+  EXPECT_THAT(HashAggregator::Create(types, /*key_columns=*/{0},
+                                     {{HashAggregator::kSum, 1}},
+                                     HashAggregator::kComplete,
+                                     HashAggregator::Options(), &type_factory_)
+                  .status(),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto aggregator,
+      HashAggregator::Create(types, /*key_columns=*/{},
+                             {{HashAggregator::kSum, 0}},
+                             HashAggregator::kComplete,
+                             HashAggregator::Options(), &type_factory_));
+  ZETASQL_ASSERT_OK(aggregator->AddRow(
+      {Value::Int64(std::numeric_limits<int64_t>::max()), Value::String("")}));
+  EXPECT_THAT(aggregator->AddRow({Value::Int64(1), Value::String("")}),
+              StatusIs(zetasql_base::StatusCode::kOutOfRange));
+  EXPECT_THAT(aggregator->AddRow({Value::Int64(1)}),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+}
+
+TEST_F(HashAggregatorTest, AggregateForCall) {
+  const Function sum("sum", Function::kZetaSQLFunctionGroupName,
+                     Function::AGGREGATE);
+  auto call = [&sum](bool distinct) {
+    return MakeResolvedAggregateFunctionCall(
+        types::Int64Type(), &sum,
+        FunctionSignature(types::Int64Type(), {types::Int64Type()},
+                          FN_SUM_INT64),
+        /*argument_list=*/{}, ResolvedFunctionCall::DEFAULT_ERROR_MODE,
+        distinct, ResolvedAggregateFunctionCall::DEFAULT_NULL_HANDLING,
+        /*having_modifier=*/nullptr, /*order_by_item_list=*/{},
+        /*limit=*/nullptr, /*function_call_info=*/nullptr);
+  };
+  ZETASQL_ASSERT_OK_AND_ASSIGN(const HashAggregator::Aggregate aggregate,
+                       HashAggregator::AggregateForCall(
+                           call(/*distinct=*/false).get(), /*argument=*/3));
+  EXPECT_EQ(HashAggregator::kSum, aggregate.function);
+  EXPECT_EQ(3, aggregate.argument);
+  EXPECT_THAT(HashAggregator::AggregateForCall(call(/*distinct=*/true).get(),
+                                               /*argument=*/3)
+                  .status(),
+              StatusIs(zetasql_base::StatusCode::kUnimplemented));
+}
+
+}  // namespace local_service
+}  // namespace zetasql
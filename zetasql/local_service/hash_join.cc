@@ -0,0 +1,487 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "zetasql/local_service/hash_join.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "zetasql/base/logging.h"
+#include "zetasql/local_service/spill_file.h"
+#include "zetasql/public/builtin_function.pb.h"
+#include "zetasql/public/value_bloom_filter.h"
+#include "zetasql/public/value_hash.h"
+#include "zetasql/resolved_ast/resolved_node_kind.pb.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/memory/memory.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/source_location.h"
+#include "zetasql/base/status_builder.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+namespace local_service {
+
+namespace {
+
+constexpr int kRowsPerBlock = 1024;
+
+// In Partition::next, marks build rows that cannot match any probe row.
+constexpr int32_t kUnmatchable = -2;
+
+bool IsNullOrNaN(const Value& value) {
+  return value.is_null() ||
+         (value.type()->IsFloatingPoint() && std::isnan(value.ToDouble()));
+}
+
+bool HasNullOrNaNKey(absl::Span<const Value> row, absl::Span<const int> keys) {
+  for (const int key : keys) {
+    if (IsNullOrNaN(row[key])) return true;
+  }
+  return false;
+}
+
+// Appends the conjuncts of <expr> to <conjuncts>.
+void AddConjuncts(const ResolvedExpr* expr,
+                  std::vector<const ResolvedExpr*>* conjuncts) {
+  if (expr->node_kind() == RESOLVED_FUNCTION_CALL) {
+    const ResolvedFunctionCall* call = expr->GetAs<ResolvedFunctionCall>();
+    if (call->function()->IsZetaSQLBuiltin() &&
+        call->signature().context_id() == FN_AND) {
+      for (const auto& argument : call->argument_list()) {
+        AddConjuncts(argument.get(), conjuncts);
+      }
+      return;
+    }
+  }
+  conjuncts->push_back(expr);
+}
+
+// Returns the column id of <expr> if it is a non-correlated column
+// reference, or -1.
+int ColumnIdOf(const ResolvedExpr* expr) {
+  if (expr->node_kind() != RESOLVED_COLUMN_REF) return -1;
+  const ResolvedColumnRef* ref = expr->GetAs<ResolvedColumnRef>();
+  return ref->is_correlated() ? -1 : ref->column().column_id();
+}
+
+}  // namespace
+
+// Stores rows of Values in blocks of kRowsPerBlock rows, so that adding a
+// row never moves the earlier ones.
+class HashJoin::RowArena {
+ public:
+  explicit RowArena(int num_columns) : num_columns_(num_columns) {}
+
+  // Returns the Values of a new row, which are invalid.
+  Value* AddRow() {
+    if (num_rows_ % kRowsPerBlock == 0) {
+      blocks_.emplace_back(new Value[kRowsPerBlock * num_columns_]);
+    }
+    return blocks_.back().get() + (num_rows_++ % kRowsPerBlock) * num_columns_;
+  }
+
+  absl::Span<const Value> row(int i) const {
+    return absl::Span<const Value>(
+        blocks_[i / kRowsPerBlock].get() + (i % kRowsPerBlock) * num_columns_,
+        num_columns_);
+  }
+
+  int num_rows() const { return num_rows_; }
+
+ private:
+  int num_columns_;
+  int num_rows_ = 0;
+  std::vector<std::unique_ptr<Value[]>> blocks_;
+};
+
+// The build rows whose key hashes fall in one partition, in a chained hash
+// table.
+struct HashJoin::Partition {
+  explicit Partition(int num_columns) : rows(num_columns) {}
+
+  RowArena rows;
+  std::vector<uint64_t> hashes;
+  // The next row in the same bucket, -1 at the end, or kUnmatchable.
+  std::vector<int32_t> next;
+  // The first row of each bucket, or -1. The size is a power of two.
+  std::vector<int32_t> buckets;
+  // Whether each row has matched, for joins that keep unmatched build rows.
+  std::vector<bool> matched;
+};
+
+HashJoin::HashJoin(JoinType join_type, const Options& options)
+    : join_type_(join_type), options_(options) {}
+
+HashJoin::~HashJoin() {}
+
+zetasql_base::StatusOr<HashJoin::JoinType> HashJoin::JoinTypeForScan(
+    const ResolvedJoinScan* join) {
+  switch (join->join_type()) {
+    case ResolvedJoinScan::INNER:
+      return kInner;
+    case ResolvedJoinScan::LEFT:
+      return kLeft;
+    case ResolvedJoinScan::RIGHT:
+      return kRight;
+    case ResolvedJoinScan::FULL:
+      return kFull;
+    default:
+      return ::zetasql_base::UnimplementedErrorBuilder(ZETASQL_LOC)
+             << "Unsupported join type " << join->join_type();
+  }
+}
+
+zetasql_base::Status HashJoin::FindEquiJoinKeys(
+    const ResolvedJoinScan* join, std::vector<int>* left_keys,
+    std::vector<int>* right_keys, std::vector<const ResolvedExpr*>* residual) {
+  ZETASQL_RET_CHECK(join != nullptr);
+  if (join->join_expr() == nullptr) return ::zetasql_base::OkStatus();
+
+  absl::flat_hash_map<int, int> left_columns;
+  absl::flat_hash_map<int, int> right_columns;
+  const ResolvedColumnList& left_list = join->left_scan()->column_list();
+  const ResolvedColumnList& right_list = join->right_scan()->column_list();
+  for (int i = 0; i < left_list.size(); ++i) {
+    left_columns.emplace(left_list[i].column_id(), i);
+  }
+  for (int i = 0; i < right_list.size(); ++i) {
+    right_columns.emplace(right_list[i].column_id(), i);
+  }
+
+  std::vector<const ResolvedExpr*> conjuncts;
+  AddConjuncts(join->join_expr(), &conjuncts);
+  for (const ResolvedExpr* conjunct : conjuncts) {
+    if (conjunct->node_kind() == RESOLVED_FUNCTION_CALL) {
+      const ResolvedFunctionCall* call =
+          conjunct->GetAs<ResolvedFunctionCall>();
+      if (call->function()->IsZetaSQLBuiltin() &&
+          call->signature().context_id() == FN_EQUAL &&
+          call->argument_list_size() == 2) {
+        const ResolvedExpr* a = call->argument_list(0);
+        const ResolvedExpr* b = call->argument_list(1);
+        int a_id = ColumnIdOf(a);
+        int b_id = ColumnIdOf(b);
+        if (!left_columns.contains(a_id)) std::swap(a_id, b_id);
+        if (a->type()->Equivalent(b->type()) &&
+            left_columns.contains(a_id) && right_columns.contains(b_id)) {
+          left_keys->push_back(left_columns[a_id]);
+          right_keys->push_back(right_columns[b_id]);
+          continue;
+        }
+      }
+    }
+    residual->push_back(conjunct);
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::StatusOr<std::unique_ptr<HashJoin>> HashJoin::Create(
+    JoinType join_type, std::unique_ptr<EvaluatorTableIterator> probe,
+    absl::Span<const int> probe_keys,
+    std::unique_ptr<EvaluatorTableIterator> build,
+    absl::Span<const int> build_keys, Predicate residual,
+    const Options& options) {
+  ZETASQL_RET_CHECK(probe != nullptr);
+  ZETASQL_RET_CHECK(build != nullptr);
+  if (probe_keys.size() != build_keys.size()) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "The join has " << probe_keys.size() << " probe keys but "
+           << build_keys.size() << " build keys";
+  }
+  if (options.num_partitions < 1 ||
+      (options.num_partitions & (options.num_partitions - 1)) != 0) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "num_partitions must be a power of two";
+  }
+  if (options.batch_size < 1) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "batch_size must be positive";
+  }
+  for (int i = 0; i < probe_keys.size(); ++i) {
+    if (probe_keys[i] < 0 || probe_keys[i] >= probe->NumColumns() ||
+        build_keys[i] < 0 || build_keys[i] >= build->NumColumns()) {
+      return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+             << "Join key " << i << " is out of range";
+    }
+    const Type* probe_type = probe->GetColumnType(probe_keys[i]);
+    const Type* build_type = build->GetColumnType(build_keys[i]);
+    if (!probe_type->Equivalent(build_type)) {
+      return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+             << "Join key " << i << " has types " << probe_type->DebugString()
+             << " and " << build_type->DebugString();
+    }
+  }
+
+  auto join = absl::WrapUnique(new HashJoin(join_type, options));
+  join->probe_keys_.assign(probe_keys.begin(), probe_keys.end());
+  join->build_keys_.assign(build_keys.begin(), build_keys.end());
+  join->residual_ = std::move(residual);
+  for (int i = 0; i < probe->NumColumns(); ++i) {
+    join->column_types_.push_back(probe->GetColumnType(i));
+    join->probe_nulls_.push_back(Value::Null(probe->GetColumnType(i)));
+  }
+  for (int i = 0; i < build->NumColumns(); ++i) {
+    join->column_types_.push_back(build->GetColumnType(i));
+    join->build_nulls_.push_back(Value::Null(build->GetColumnType(i)));
+  }
+  join->probe_ = std::move(probe);
+  join->build_ = std::move(build);
+  join->probe_row_.resize(join->probe_nulls_.size());
+  join->row_.resize(join->column_types_.size());
+  join->partitions_.reserve(options.num_partitions);
+  for (int i = 0; i < options.num_partitions; ++i) {
+    join->partitions_.emplace_back(join->build_nulls_.size());
+  }
+  if (options.memory_pool != nullptr) {
+    join->memory_consumer_ =
+        absl::make_unique<MemoryConsumer>("HashJoin", options.memory_pool);
+  }
+
+  ZETASQL_RETURN_IF_ERROR(join->ReadBuildInput());
+  ZETASQL_RETURN_IF_ERROR(join->PushDownFilters());
+  return join;
+}
+
+zetasql_base::Status HashJoin::ReadBuildInput() {
+  const bool keep_build = join_type_ == kRight || join_type_ == kFull;
+  const int num_columns = build_nulls_.size();
+  ValueBatch batch;
+  std::vector<Value> row(num_columns);
+  std::vector<uint64_t> hashes;
+  while (build_->NextBatch(options_.batch_size, &batch)) {
+    HashBatchKeys(batch, build_keys_, kDefaultKeyHashSeed, &hashes);
+    for (int r = 0; r < batch.num_rows(); ++r) {
+      for (int c = 0; c < num_columns; ++c) {
+        row[c] = batch.column(c).GetValue(r);
+      }
+      const bool matchable = !HasNullOrNaNKey(row, build_keys_);
+      if (!matchable && !keep_build) continue;
+      const uint64_t hash = hashes[r];
+      Partition& partition =
+          partitions_[matchable ? hash >> 32 & (partitions_.size() - 1) : 0];
+      std::copy(row.begin(), row.end(), partition.rows.AddRow());
+      partition.hashes.push_back(hash);
+      partition.next.push_back(matchable ? -1 : kUnmatchable);
+      ++num_build_rows_;
+      // The row, its hash, its link and about one bucket.
+      memory_used_bytes_ += num_columns * sizeof(Value) + sizeof(uint64_t) +
+                            2 * sizeof(int32_t);
+      for (const Value& value : row) {
+        memory_used_bytes_ += ValueHeapBytes(value);
+      }
+      if (memory_consumer_ != nullptr) {
+        ZETASQL_RETURN_IF_ERROR(
+            memory_consumer_->SetUsedBytes(memory_used_bytes_));
+      }
+    }
+  }
+  ZETASQL_RETURN_IF_ERROR(build_->Status());
+
+  for (Partition& partition : partitions_) {
+    const int num_rows = partition.rows.num_rows();
+    int num_buckets = 1;
+    while (num_buckets < num_rows) num_buckets *= 2;
+    partition.buckets.assign(num_buckets, -1);
+    // Linking the rows from last to first keeps each bucket in input order.
+    for (int i = num_rows - 1; i >= 0; --i) {
+      if (partition.next[i] == kUnmatchable) continue;
+      int32_t& bucket =
+          partition.buckets[partition.hashes[i] & (num_buckets - 1)];
+      partition.next[i] = bucket;
+      bucket = i;
+    }
+    if (keep_build) partition.matched.assign(num_rows, false);
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status HashJoin::PushDownFilters() {
+  // Filtering the probe input would drop unmatched probe rows.
+  if (!options_.push_down_filters || join_type_ == kLeft ||
+      join_type_ == kFull || probe_keys_.empty()) {
+    return ::zetasql_base::OkStatus();
+  }
+  absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map;
+  for (int k = 0; k < probe_keys_.size(); ++k) {
+    if (filter_map.contains(probe_keys_[k])) continue;
+    const int build_column = build_keys_[k];
+
+    absl::flat_hash_set<Value> distinct_keys;
+    bool use_in_list = true;
+    for (const Partition& partition : partitions_) {
+      for (int i = 0; i < partition.rows.num_rows() && use_in_list; ++i) {
+        if (partition.next[i] == kUnmatchable) continue;
+        distinct_keys.insert(partition.rows.row(i)[build_column]);
+        use_in_list = distinct_keys.size() <= options_.max_in_list_size;
+      }
+    }
+    if (use_in_list) {
+      std::vector<Value> in_list(distinct_keys.begin(), distinct_keys.end());
+      if (!in_list.empty()) {
+        std::sort(in_list.begin(), in_list.end(),
+                  Value::MakeComparator(in_list[0].type()));
+      }
+      filter_map[probe_keys_[k]] = absl::make_unique<ColumnFilter>(in_list);
+      continue;
+    }
+    auto bloom_filter = std::make_shared<ValueBloomFilter>(
+        num_build_rows_, options_.bloom_filter_bits_per_key);
+    for (const Partition& partition : partitions_) {
+      for (int i = 0; i < partition.rows.num_rows(); ++i) {
+        if (partition.next[i] == kUnmatchable) continue;
+        bloom_filter->Add(partition.rows.row(i)[build_column]);
+      }
+    }
+    filter_map[probe_keys_[k]] = absl::make_unique<ColumnFilter>(
+        std::shared_ptr<const ValueBloomFilter>(std::move(bloom_filter)));
+  }
+  return probe_->SetColumnFilterMap(std::move(filter_map));
+}
+
+std::string HashJoin::GetColumnName(int i) const {
+  const int num_probe_columns = probe_nulls_.size();
+  return i < num_probe_columns ? probe_->GetColumnName(i)
+                               : build_->GetColumnName(i - num_probe_columns);
+}
+
+zetasql_base::Status HashJoin::Cancel() {
+  cancelled_ = true;
+  return probe_->Cancel();
+}
+
+void HashJoin::SetRow(absl::Span<const Value> probe_row,
+                      absl::Span<const Value> build_row) {
+  std::copy(build_row.begin(), build_row.end(),
+            std::copy(probe_row.begin(), probe_row.end(), row_.begin()));
+}
+
+bool HashJoin::NextProbeRow() {
+  if (probe_batch_row_ >= probe_batch_.num_rows()) {
+    if (!probe_->NextBatch(options_.batch_size, &probe_batch_)) {
+      status_ = probe_->Status();
+      return false;
+    }
+    HashBatchKeys(probe_batch_, probe_keys_, kDefaultKeyHashSeed,
+                  &probe_batch_hashes_);
+    probe_batch_row_ = 0;
+  }
+  const int r = probe_batch_row_++;
+  for (int c = 0; c < probe_row_.size(); ++c) {
+    probe_row_[c] = probe_batch_.column(c).GetValue(r);
+  }
+  ++num_probe_rows_;
+
+  match_ = -1;
+  if (!HasNullOrNaNKey(probe_row_, probe_keys_)) {
+    probe_hash_ = probe_batch_hashes_[r];
+    probe_partition_ = probe_hash_ >> 32 & (partitions_.size() - 1);
+    const Partition& partition = partitions_[probe_partition_];
+    match_ = partition.buckets[probe_hash_ & (partition.buckets.size() - 1)];
+  }
+  return true;
+}
+
+int HashJoin::NextMatch() {
+  Partition& partition = partitions_[probe_partition_];
+  while (match_ >= 0) {
+    const int row = match_;
+    match_ = partition.next[row];
+    if (partition.hashes[row] != probe_hash_) continue;
+    const absl::Span<const Value> build_row = partition.rows.row(row);
+    bool equal = true;
+    for (int k = 0; k < probe_keys_.size(); ++k) {
+      if (!probe_row_[probe_keys_[k]].Equals(build_row[build_keys_[k]])) {
+        equal = false;
+        break;
+      }
+    }
+    if (!equal) continue;
+    if (residual_ != nullptr) {
+      const zetasql_base::StatusOr<bool> joins = residual_(probe_row_, build_row);
+      if (!joins.ok()) {
+        status_ = joins.status();
+        return -1;
+      }
+      if (!joins.ValueOrDie()) continue;
+    }
+    if (!partition.matched.empty()) partition.matched[row] = true;
+    return row;
+  }
+  return -1;
+}
+
+bool HashJoin::NextUnmatchedBuildRow() {
+  while (unmatched_partition_ < partitions_.size()) {
+    const Partition& partition = partitions_[unmatched_partition_];
+    while (unmatched_row_ < partition.rows.num_rows()) {
+      const int row = unmatched_row_++;
+      if (!partition.matched[row]) {
+        SetRow(probe_nulls_, partition.rows.row(row));
+        return true;
+      }
+    }
+    ++unmatched_partition_;
+    unmatched_row_ = 0;
+  }
+  return false;
+}
+
+bool HashJoin::NextRow() {
+  if (!status_.ok()) return false;
+  if (cancelled_) {
+    status_ = ::zetasql_base::CancelledErrorBuilder(ZETASQL_LOC)
+              << "HashJoin was cancelled";
+    return false;
+  }
+  const bool keep_probe = join_type_ == kLeft || join_type_ == kFull;
+  while (phase_ == kProbe) {
+    if (!have_probe_row_) {
+      if (!NextProbeRow()) {
+        if (!status_.ok()) return false;
+        phase_ = join_type_ == kRight || join_type_ == kFull
+                     ? kUnmatchedBuild
+                     : kDone;
+        break;
+      }
+      have_probe_row_ = true;
+      probe_row_matched_ = false;
+    }
+    const int match = NextMatch();
+    if (match >= 0) {
+      SetRow(probe_row_, partitions_[probe_partition_].rows.row(match));
+      probe_row_matched_ = true;
+      return true;
+    }
+    if (!status_.ok()) return false;
+    have_probe_row_ = false;
+    if (keep_probe && !probe_row_matched_) {
+      SetRow(probe_row_, build_nulls_);
+      return true;
+    }
+  }
+  if (phase_ == kUnmatchedBuild) {
+    if (NextUnmatchedBuildRow()) return true;
+    phase_ = kDone;
+  }
+  return false;
+}
+
+}  // namespace local_service
+}  // namespace zetasql
@@ -0,0 +1,214 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef ZETASQL_LOCAL_SERVICE_HASH_JOIN_H_
+#define ZETASQL_LOCAL_SERVICE_HASH_JOIN_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/local_service/memory_pool.h"
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/value.h"
+#include "zetasql/public/value_batch.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "absl/types/span.h"
+#include "zetasql/base/status.h"
+#include "zetasql/base/statusor.h"
+
+namespace zetasql {
+namespace local_service {
+
+// Joins the rows of a probe input to the rows of a build input with equal
+// keys, as for a ResolvedJoinScan whose left_scan is the probe input and
+// whose right_scan is the build input. Output rows have the columns of the
+// probe input followed by those of the build input.
+//
+// Create() reads the whole build input into a hash table, partitioned by
+// the hash of the keys, whose rows are stored in blocks of Values. The
+// probe input is then read in batches of Options::batch_size rows as the
+// output is read. Keys are compared with SQL equality: NULL and NaN keys do
+// not match anything.
+//
+// Unless unmatched probe rows are kept (kLeft and kFull), the probe input
+// gets a ColumnFilter for each probe key column through
+// SetColumnFilterMap(): an IN list of the build keys if there are at most
+// Options::max_in_list_size of them, and otherwise a ValueBloomFilter. A
+// probe input that uses them, e.g. for a star schema query whose dimension
+// filters drop most rows of the fact table, can skip most of its rows.
+//
+// With Options::memory_pool, the hash table reserves its estimated size in
+// the pool as the build input is read. The build side cannot spill, so
+// Create() fails with kResourceExhausted if it does not fit.
+//
+// Example:
+//   std::vector<int> left_keys, right_keys;
+//   std::vector<const ResolvedExpr*> residual;
+//   ZETASQL_RETURN_IF_ERROR(HashJoin::FindEquiJoinKeys(join_scan, &left_keys,
+//                                              &right_keys, &residual));
+//   ZETASQL_ASSIGN_OR_RETURN(HashJoin::JoinType join_type,
+//                    HashJoin::JoinTypeForScan(join_scan));
+//   ZETASQL_ASSIGN_OR_RETURN(
+//       std::unique_ptr<HashJoin> join,
+//       HashJoin::Create(join_type, std::move(left), left_keys,
+//                        std::move(right), right_keys,
+//                        /*residual=*/nullptr, HashJoin::Options()));
+//
+// This class is not thread-safe, except for Cancel().
+class HashJoin : public EvaluatorTableIterator {
+ public:
+  enum JoinType {
+    kInner,
+    kLeft,   // Keeps unmatched probe rows.
+    kRight,  // Keeps unmatched build rows.
+    kFull,   // Keeps both.
+  };
+
+  struct Options {
+    // The number of partitions of the build side, a power of two.
+    int num_partitions = 16;
+    // The number of probe rows read at once.
+    int batch_size = 1024;
+    // The largest number of distinct build keys in a key column for which
+    // the probe input gets an IN list filter rather than a Bloom filter.
+    int max_in_list_size = 256;
+    double bloom_filter_bits_per_key = 10;
+    // If false, the probe input gets no column filters.
+    bool push_down_filters = true;
+    // If set, the pool in which the hash table reserves its memory. Must
+    // outlive the join.
+    MemoryPool* memory_pool = nullptr;
+  };
+
+  // Returns whether a probe row and a build row with equal keys join, for
+  // conditions of the join other than key equality.
+  typedef std::function<zetasql_base::StatusOr<bool>(absl::Span<const Value> probe_row,
+                                             absl::Span<const Value> build_row)>
+      Predicate;
+
+  HashJoin(const HashJoin&) = delete;
+  HashJoin& operator=(const HashJoin&) = delete;
+  ~HashJoin() override;
+
+  // Returns the JoinType of <join>, whose left_scan is the probe input.
+  static zetasql_base::StatusOr<JoinType> JoinTypeForScan(const ResolvedJoinScan* join);
+
+  // Finds the conjuncts of the join_expr of <join> that compare a column of
+  // its left_scan with a column of its right_scan of an equivalent type, and
+  // appends the indexes in their column_lists to <left_keys> and
+  // <right_keys>. Other conjuncts are appended to <residual>.
+  static zetasql_base::Status FindEquiJoinKeys(
+      const ResolvedJoinScan* join, std::vector<int>* left_keys,
+      std::vector<int>* right_keys, std::vector<const ResolvedExpr*>* residual);
+
+  // Reads all rows of <build> and returns an iterator over the join of the
+  // rows of <probe> to them, on <probe_keys> equal to <build_keys>, and
+  // <residual> if it is not null. The key columns must have equivalent
+  // types. <probe> must not have been read yet.
+  static zetasql_base::StatusOr<std::unique_ptr<HashJoin>> Create(
+      JoinType join_type, std::unique_ptr<EvaluatorTableIterator> probe,
+      absl::Span<const int> probe_keys,
+      std::unique_ptr<EvaluatorTableIterator> build,
+      absl::Span<const int> build_keys, Predicate residual,
+      const Options& options);
+
+  int NumColumns() const override { return column_types_.size(); }
+  std::string GetColumnName(int i) const override;
+  const Type* GetColumnType(int i) const override { return column_types_[i]; }
+  bool NextRow() override;
+  const Value& GetValue(int i) const override { return row_[i]; }
+  zetasql_base::Status Status() const override { return status_; }
+  zetasql_base::Status Cancel() override;
+
+  int64_t num_build_rows() const { return num_build_rows_; }
+  // The estimated size of the hash table.
+  int64_t memory_used_bytes() const { return memory_used_bytes_; }
+  // The number of rows read from the probe input so far.
+  int64_t num_probe_rows() const { return num_probe_rows_; }
+
+ private:
+  class RowArena;
+  struct Partition;
+
+  HashJoin(JoinType join_type, const Options& options);
+
+  zetasql_base::Status ReadBuildInput();
+  zetasql_base::Status PushDownFilters();
+
+  // Reads the next probe row into probe_row_. Returns false at the end of
+  // the probe input, or on error.
+  bool NextProbeRow();
+  // Returns the next build row matching the current probe row, or -1 if
+  // there are no more or on error.
+  int NextMatch();
+  // Sets row_ to the next unmatched build row, or returns false.
+  bool NextUnmatchedBuildRow();
+
+  void SetRow(absl::Span<const Value> probe_row,
+              absl::Span<const Value> build_row);
+
+  const JoinType join_type_;
+  const Options options_;
+  std::unique_ptr<EvaluatorTableIterator> probe_;
+  std::unique_ptr<EvaluatorTableIterator> build_;
+  std::vector<int> probe_keys_;
+  std::vector<int> build_keys_;
+  Predicate residual_;
+  std::vector<const Type*> column_types_;
+  std::vector<Value> probe_nulls_;
+  std::vector<Value> build_nulls_;
+
+  std::vector<Partition> partitions_;
+  int64_t num_build_rows_ = 0;
+  int64_t memory_used_bytes_ = 0;
+  // Only set with Options::memory_pool.
+  std::unique_ptr<MemoryConsumer> memory_consumer_;
+
+  enum Phase { kProbe, kUnmatchedBuild, kDone };
+  Phase phase_ = kProbe;
+  ValueBatch probe_batch_;
+  // The HashBatchKeys() of the probe keys of probe_batch_.
+  std::vector<uint64_t> probe_batch_hashes_;
+  int probe_batch_row_ = 0;
+  std::vector<Value> probe_row_;
+  int64_t num_probe_rows_ = 0;
+  // Whether probe_row_ holds a probe row whose matches are being returned.
+  bool have_probe_row_ = false;
+  // The partition and next build row probed by the current probe row, which
+  // has hash probe_hash_. match_ is -1 if the probe row has no more
+  // candidates.
+  int probe_partition_ = 0;
+  uint64_t probe_hash_ = 0;
+  int match_ = -1;
+  bool probe_row_matched_ = false;
+  // The position of NextUnmatchedBuildRow().
+  int unmatched_partition_ = 0;
+  int unmatched_row_ = 0;
+
+  std::vector<Value> row_;
+  zetasql_base::Status status_;
+  std::atomic<bool> cancelled_{false};
+};
+
+}  // namespace local_service
+}  // namespace zetasql
+
+#endif  // ZETASQL_LOCAL_SERVICE_HASH_JOIN_H_
@@ -0,0 +1,303 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "zetasql/local_service/hash_join.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/builtin_function.pb.h"
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/make_node_vector.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+
+namespace zetasql {
+namespace local_service {
+
+using ::testing::ElementsAre;
+using zetasql_base::testing::StatusIs;
+
+// Returns <rows>, skipping those that fail the filters passed to
+// SetColumnFilterMap() like a storage engine would.
+class FilteringIterator : public EvaluatorTableIterator {
+ public:
+  FilteringIterator(std::vector<const Type*> types,
+                    std::vector<std::vector<Value>> rows)
+      : types_(std::move(types)), rows_(std::move(rows)) {}
+
+  int NumColumns() const override { return types_.size(); }
+  std::string GetColumnName(int i) const override {
+    return absl::StrCat("c", i);
+  }
+  const Type* GetColumnType(int i) const override { return types_[i]; }
+
+  zetasql_base::Status SetColumnFilterMap(
+      absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map)
+      override {
+    filter_map_ = std::move(filter_map);
+    return zetasql_base::OkStatus();
+  }
+
+  bool NextRow() override {
+    while (++row_ < rows_.size()) {
+      if (PassesFilters(rows_[row_])) return true;
+    }
+    return false;
+  }
+  const Value& GetValue(int i) const override { return rows_[row_][i]; }
+  zetasql_base::Status Status() const override { return zetasql_base::OkStatus(); }
+  zetasql_base::Status Cancel() override { return zetasql_base::OkStatus(); }
+
+  const absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>>& filter_map()
+      const {
+    return filter_map_;
+  }
+
+ private:
+  bool PassesFilters(const std::vector<Value>& row) const {
+    for (const auto& entry : filter_map_) {
+      const Value& value = row[entry.first];
+      const ColumnFilter& filter = *entry.second;
+      switch (filter.kind()) {
+        case ColumnFilter::kInList:
+          if (std::find(filter.in_list().begin(), filter.in_list().end(),
+                        value) == filter.in_list().end()) {
+            return false;
+          }
+          break;
+        case ColumnFilter::kBloomFilter:
+          if (!filter.bloom_filter().MayContain(value)) return false;
+          break;
+        default:
+          break;
+      }
+    }
+    return true;
+  }
+
+  std::vector<const Type*> types_;
+  std::vector<std::vector<Value>> rows_;
+  int row_ = -1;
+  absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map_;
+};
+
+// Returns the rows of <iterator> as sorted strings.
+std::vector<std::string> ReadRows(EvaluatorTableIterator* iterator) {
+  std::vector<std::string> rows;
+  while (iterator->NextRow()) {
+    std::vector<std::string> values;
+    for (int i = 0; i < iterator->NumColumns(); ++i) {
+      values.push_back(iterator->GetValue(i).DebugString());
+    }
+    rows.push_back(absl::StrJoin(values, ","));
+  }
+  ZETASQL_EXPECT_OK(iterator->Status());
+  std::sort(rows.begin(), rows.end());
+  return rows;
+}
+
+class HashJoinTest : public ::testing::Test {
+ protected:
+  // Probe rows (id, name) and build rows (id, v), joined on id.
+  std::unique_ptr<FilteringIterator> Probe() {
+    return absl::make_unique<FilteringIterator>(
+        std::vector<const Type*>{types::Int64Type(), types::StringType()},
+        std::vector<std::vector<Value>>{
+            {Value::Int64(1), Value::String("a")},
+            {Value::Int64(2), Value::String("b")},
+            {Value::Int64(2), Value::String("c")},
+            {Value::NullInt64(), Value::String("d")},
+            {Value::Int64(4), Value::String("e")}});
+  }
+  std::unique_ptr<FilteringIterator> Build() {
+    return absl::make_unique<FilteringIterator>(
+        std::vector<const Type*>{types::Int64Type(), types::DoubleType()},
+        std::vector<std::vector<Value>>{{Value::Int64(2), Value::Double(20)},
+                                        {Value::Int64(2), Value::Double(21)},
+                                        {Value::Int64(1), Value::Double(10)},
+                                        {Value::NullInt64(), Value::Double(0)},
+                                        {Value::Int64(3), Value::Double(30)}});
+  }
+
+  std::vector<std::string> Join(HashJoin::JoinType join_type,
+                                HashJoin::Predicate residual = nullptr) {
+    auto join =
+        HashJoin::Create(join_type, Probe(), {0}, Build(), {0},
+                         std::move(residual), HashJoin::Options());
+    ZETASQL_EXPECT_OK(join.status());
+    if (!join.ok()) return {};
+    return ReadRows(join.ValueOrDie().get());
+  }
+};
+
+TEST_F(HashJoinTest, InnerJoin) {
+  EXPECT_THAT(Join(HashJoin::kInner),
+              ElementsAre("1,\"a\",1,10", "2,\"b\",2,20", "2,\"b\",2,21",
+                          "2,\"c\",2,20", "2,\"c\",2,21"));
+
+  // The probe input gets the build keys as an IN list.
+  FilteringIterator* probe = Probe().release();
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto join,
+      HashJoin::Create(HashJoin::kInner,
+                       std::unique_ptr<EvaluatorTableIterator>(probe), {0},
+                       Build(), {0}, nullptr, HashJoin::Options()));
+  ASSERT_EQ(1, probe->filter_map().size());
+  const ColumnFilter& filter = *probe->filter_map().at(0);
+  ASSERT_EQ(ColumnFilter::kInList, filter.kind());
+  EXPECT_THAT(filter.in_list(),
+              ElementsAre(Value::Int64(1), Value::Int64(2), Value::Int64(3)));
+  EXPECT_EQ(5, ReadRows(join.get()).size());
+  EXPECT_EQ(4, join->num_build_rows());
+  EXPECT_EQ(3, join->num_probe_rows());
+  EXPECT_EQ("c1", join->GetColumnName(1));
+  EXPECT_EQ("c0", join->GetColumnName(2));
+}
+
+TEST_F(HashJoinTest, OuterJoins) {
+  EXPECT_THAT(Join(HashJoin::kLeft),
+              ElementsAre("1,\"a\",1,10", "2,\"b\",2,20", "2,\"b\",2,21",
+                          "2,\"c\",2,20", "2,\"c\",2,21", "4,\"e\",NULL,NULL",
+                          "NULL,\"d\",NULL,NULL"));
+  EXPECT_THAT(Join(HashJoin::kRight),
+              ElementsAre("1,\"a\",1,10", "2,\"b\",2,20", "2,\"b\",2,21",
+                          "2,\"c\",2,20", "2,\"c\",2,21", "NULL,NULL,3,30",
+                          "NULL,NULL,NULL,0"));
+  EXPECT_THAT(
+      Join(HashJoin::kFull),
+      ElementsAre("1,\"a\",1,10", "2,\"b\",2,20", "2,\"b\",2,21",
+                  "2,\"c\",2,20", "2,\"c\",2,21", "4,\"e\",NULL,NULL",
+                  "NULL,\"d\",NULL,NULL", "NULL,NULL,3,30",
+                  "NULL,NULL,NULL,0"));
+}
+
+TEST_F(HashJoinTest, Residual) {
+  const HashJoin::Predicate residual =
+      [](absl::Span<const Value> probe_row,
+         absl::Span<const Value> build_row) -> zetasql_base::StatusOr<bool> {
+    return build_row[1].double_value() > 20;
+  };
+  EXPECT_THAT(Join(HashJoin::kInner, residual),
+              ElementsAre("2,\"b\",2,21", "2,\"c\",2,21"));
+  EXPECT_THAT(Join(HashJoin::kRight, residual),
+              ElementsAre("2,\"b\",2,21", "2,\"c\",2,21", "NULL,NULL,1,10",
+                          "NULL,NULL,2,20", "NULL,NULL,3,30",
+                          "NULL,NULL,NULL,0"));
+}
+
+TEST_F(HashJoinTest, BloomFilter) {
+  std::vector<std::vector<Value>> probe_rows;
+  for (int64_t i = 0; i < 10000; ++i) {
+    probe_rows.push_back({Value::Int64(i)});
+  }
+  std::vector<std::vector<Value>> build_rows;
+  for (int64_t i = 0; i < 1000; ++i) {
+    build_rows.push_back({Value::Int64(i * 10)});
+  }
+  auto* probe = new FilteringIterator({types::Int64Type()}, probe_rows);
+  HashJoin::Options options;
+  options.max_in_list_size = 100;
+  options.batch_size = 64;
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      auto join,
+      HashJoin::Create(
+          HashJoin::kInner, std::unique_ptr<EvaluatorTableIterator>(probe),
+          {0},
+          absl::make_unique<FilteringIterator>(
+              std::vector<const Type*>{types::Int64Type()}, build_rows),
+          {0}, nullptr, options));
+  ASSERT_EQ(ColumnFilter::kBloomFilter, probe->filter_map().at(0)->kind());
+  EXPECT_EQ(1000, ReadRows(join.get()).size());
+  EXPECT_GE(join->num_probe_rows(), 1000);
+  EXPECT_LT(join->num_probe_rows(), 1300);
+}
+
+TEST_F(HashJoinTest, Errors) {
+  EXPECT_THAT(HashJoin::Create(HashJoin::kInner, Probe(), {1}, Build(), {0},
+                               nullptr, HashJoin::Options())
+                  .status(),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+  EXPECT_THAT(HashJoin::Create(HashJoin::kInner, Probe(), {0}, Build(), {},
+                               nullptr, HashJoin::Options())
+                  .status(),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+  HashJoin::Options options;
+  options.num_partitions = 3;
+  EXPECT_THAT(HashJoin::Create(HashJoin::kInner, Probe(), {0}, Build(), {0},
+                               nullptr, options)
+                  .status(),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+}
+
+TEST_F(HashJoinTest, FindEquiJoinKeys) {
+  const Function equal("$equal", Function::kZetaSQLFunctionGroupName,
+                       Function::SCALAR);
+  const Function and_function("$and", Function::kZetaSQLFunctionGroupName,
+                              Function::SCALAR);
+  const Type* int64_type = types::Int64Type();
+  const Type* bool_type = types::BoolType();
+  const ResolvedColumn a(1, "L", "a", int64_type);
+  const ResolvedColumn b(2, "L", "b", int64_type);
+  const ResolvedColumn c(3, "R", "c", int64_type);
+  auto call = [&](const Function* function, FunctionSignatureId id,
+                  std::unique_ptr<const ResolvedExpr> x,
+                  std::unique_ptr<const ResolvedExpr> y) {
+    const Type* type = x->type();
+    return MakeResolvedFunctionCall(
+        bool_type, function,
+        FunctionSignature(bool_type, {type, type}, id),
+        MakeNodeVector(std::move(x), std::move(y)),
+        ResolvedFunctionCall::DEFAULT_ERROR_MODE);
+  };
+  auto join = MakeResolvedJoinScan(
+      {a, b, c}, ResolvedJoinScan::INNER,
+      MakeResolvedTableScan({a, b}, /*table=*/nullptr,
+                            /*for_system_time_expr=*/nullptr),
+      MakeResolvedTableScan({c}, /*table=*/nullptr,
+                            /*for_system_time_expr=*/nullptr),
+      call(&and_function, FN_AND,
+           call(&equal, FN_EQUAL, MakeResolvedColumnRef(int64_type, c, false),
+                MakeResolvedColumnRef(int64_type, b, false)),
+           call(&equal, FN_EQUAL, MakeResolvedColumnRef(int64_type, a, false),
+                MakeResolvedLiteral(Value::Int64(1)))));
+  std::vector<int> left_keys, right_keys;
+  std::vector<const ResolvedExpr*> residual;
+  ZETASQL_ASSERT_OK(HashJoin::FindEquiJoinKeys(join.get(), &left_keys, &right_keys,
+                                       &residual));
+  EXPECT_THAT(left_keys, ElementsAre(1));
+  EXPECT_THAT(right_keys, ElementsAre(0));
+  ASSERT_EQ(1, residual.size());
+  EXPECT_EQ(RESOLVED_FUNCTION_CALL, residual[0]->node_kind());
+  ZETASQL_ASSERT_OK_AND_ASSIGN(const HashJoin::JoinType join_type,
+                       HashJoin::JoinTypeForScan(join.get()));
+  EXPECT_EQ(HashJoin::kInner, join_type);
+}
+
+}  // namespace local_service
+}  // namespace zetasql
@@ -17,7 +17,9 @@
 #include "zetasql/local_service/local_service.h"
 
 #include <algorithm>
+#include <functional>
 #include <map>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -27,7 +29,10 @@
 #include "google/protobuf/descriptor.h"
 #include "zetasql/common/errors.h"
 #include "zetasql/common/proto_helper.h"
+#include "zetasql/local_service/compiled_expression.h"
+#include "zetasql/local_service/constant_folder.h"
 #include "zetasql/local_service/state.h"
+#include "zetasql/parser/parser.h"
 #include "zetasql/proto/simple_catalog.pb.h"
 #include "zetasql/public/builtin_function.h"
 #include "zetasql/public/function.h"
@@ -38,9 +43,15 @@
 #include "zetasql/public/type.pb.h"
 #include "zetasql/public/value.h"
 #include "zetasql/public/value.pb.h"
+#include "zetasql/resolved_ast/compact_serialization.h"
 #include "zetasql/resolved_ast/resolved_ast.h"
 #include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "zetasql/base/map_util.h"
 #include "zetasql/base/source_location.h"
 #include "zetasql/base/ret_check.h"
 #include "zetasql/base/status_macros.h"
@@ -54,7 +65,8 @@ using google::protobuf::RepeatedPtrField;
 namespace {
 
 // Populate the existing pools into the map with existing indices, to make sure
-// the serialized type will use the same indices.
+// the serialized type will use the same indices.  The client sent the
+// descriptors of these pools, so they are not serialized again.
 void PopulateExistingPoolsToFileDescriptorSetMap(
     const std::vector<const google::protobuf::DescriptorPool*>& pools,
     FileDescriptorSetMap* file_descriptor_set_map) {
@@ -66,6 +78,7 @@ void PopulateExistingPoolsToFileDescriptorSetMap(
     CHECK_EQ(entry.get(), nullptr);
     entry = absl::make_unique<Type::FileDescriptorEntry>();
     entry->descriptor_set_index = i;
+    entry->file_descriptors_known_to_reader = true;
   }
 
   CHECK_EQ(pools.size(), file_descriptor_set_map->size());
@@ -174,13 +187,46 @@ class RegisteredCatalogState : public BaseSavedState {
     return ::zetasql_base::OkStatus();
   }
 
-  SimpleCatalog* GetCatalog() {
+  // Get a pointer to the catalog, which UpdateCatalog() will not change for
+  // the life duration of <catalog_lock>. Callers must hold the lock until
+  // they no longer use the catalog or the objects they found in it.
+  SimpleCatalog* GetCatalog(
+      std::unique_ptr<absl::ReaderMutexLock>* catalog_lock) {
+    *catalog_lock = absl::make_unique<absl::ReaderMutexLock>(&update_mutex_);
     absl::MutexLock lock(&mutex_);
     CHECK(initialized_);
     return catalog_.get();
   }
 
+  // Returns the AnalyzerOptions deserialized from <proto>. Callers analyzing
+  // with one registered catalog mostly repeat the same few options, so the
+  // last kMaxCachedAnalyzerOptions distinct ones are kept deserialized.
+  zetasql_base::StatusOr<std::shared_ptr<const AnalyzerOptions>>
+  GetAnalyzerOptions(const AnalyzerOptionsProto& proto) {
+    std::string key;
+    proto.SerializeToString(&key);
+    {
+      absl::MutexLock lock(&options_mutex_);
+      const std::shared_ptr<const AnalyzerOptions>* cached =
+          zetasql_base::FindOrNull(analyzer_options_, key);
+      if (cached != nullptr) {
+        return *cached;
+      }
+    }
+
+    auto options = std::make_shared<AnalyzerOptions>();
+    ZETASQL_RETURN_IF_ERROR(AnalyzerOptions::Deserialize(
+        proto, GetDescriptorPools(), GetTypeFactory(), options.get()));
+    absl::MutexLock lock(&options_mutex_);
+    if (analyzer_options_.size() >= kMaxCachedAnalyzerOptions) {
+      analyzer_options_.clear();
+    }
+    analyzer_options_.emplace(std::move(key), options);
+    return std::shared_ptr<const AnalyzerOptions>(std::move(options));
+  }
+
   zetasql_base::Status AddSimpleTable(const AddSimpleTableRequest& request) {
+    absl::WriterMutexLock update_lock(&update_mutex_);
     absl::MutexLock lock(&mutex_);
     std::unique_ptr<SimpleTable> table;
     ZETASQL_RETURN_IF_ERROR(
@@ -193,8 +239,90 @@ class RegisteredCatalogState : public BaseSavedState {
     return ::zetasql_base::OkStatus();
   }
 
+  zetasql_base::Status UpdateCatalog(const UpdateCatalogRequest& request,
+                             UpdateCatalogResponse* response) {
+    absl::WriterMutexLock update_lock(&update_mutex_);
+    absl::MutexLock lock(&mutex_);
+    if (request.has_expected_version() &&
+        request.expected_version() != catalog_->version()) {
+      return ::zetasql_base::FailedPreconditionErrorBuilder(ZETASQL_LOC)
+             << "Registered catalog " << GetId() << " is at version "
+             << catalog_->version() << ", not "
+             << request.expected_version();
+    }
+    ZETASQL_RETURN_IF_ERROR(
+        MergeFileDescriptorSetsToPools(request.file_descriptor_set(),
+                                       &pools_, &const_pools_));
+
+    // Deserializes all the new objects before changing the catalog, so that
+    // a failed update leaves it as it was.
+    std::vector<std::pair<std::string, std::unique_ptr<SimpleTable>>> tables;
+    for (const SimpleTableProto& table_proto : request.add_table()) {
+      std::unique_ptr<SimpleTable> table;
+      ZETASQL_RETURN_IF_ERROR(SimpleTable::Deserialize(table_proto, const_pools_,
+                                               &factory_, &table));
+      tables.emplace_back(table_proto.has_name_in_catalog()
+                              ? table_proto.name_in_catalog()
+                              : table_proto.name(),
+                          std::move(table));
+    }
+    std::vector<std::unique_ptr<Function>> functions;
+    for (const FunctionProto& function_proto : request.add_function()) {
+      std::unique_ptr<Function> function;
+      ZETASQL_RETURN_IF_ERROR(Function::Deserialize(function_proto, const_pools_,
+                                            &factory_, &function));
+      functions.push_back(std::move(function));
+    }
+    std::vector<std::unique_ptr<SimpleConstant>> constants;
+    for (const SimpleConstantProto& constant_proto : request.add_constant()) {
+      std::unique_ptr<SimpleConstant> constant;
+      ZETASQL_RETURN_IF_ERROR(SimpleConstant::Deserialize(
+          constant_proto, const_pools_, &factory_, &constant));
+      constants.push_back(std::move(constant));
+    }
+
+    for (const std::string& name : request.remove_table()) {
+      catalog_->RemoveTable(name);
+    }
+    for (const std::string& name : request.remove_function()) {
+      catalog_->RemoveFunction(name);
+    }
+    for (const std::string& name : request.remove_constant()) {
+      catalog_->RemoveConstant(name);
+    }
+    for (auto& name_and_table : tables) {
+      catalog_->RemoveTable(name_and_table.first);
+      catalog_->AddOwnedTable(name_and_table.first,
+                              std::move(name_and_table.second));
+    }
+    for (std::unique_ptr<Function>& function : functions) {
+      catalog_->RemoveFunction(function->Name());
+      if (!function->alias_name().empty()) {
+        catalog_->RemoveFunction(function->alias_name());
+      }
+      catalog_->AddOwnedFunction(std::move(function));
+    }
+    for (std::unique_ptr<SimpleConstant>& constant : constants) {
+      catalog_->RemoveConstant(constant->Name());
+      catalog_->AddOwnedConstant(std::move(constant));
+    }
+    response->set_version(catalog_->version());
+    return ::zetasql_base::OkStatus();
+  }
+
  private:
+  static constexpr int kMaxCachedAnalyzerOptions = 16;
+
+  // Held for reading while analyzing with the catalog, and for writing while
+  // changing it, so that no analysis sees objects that are deleted.
+  absl::Mutex update_mutex_ ACQUIRED_BEFORE(mutex_);
+
   std::unique_ptr<SimpleCatalog> catalog_ GUARDED_BY(mutex_);
+
+  absl::Mutex options_mutex_;
+  // Keyed by the serialized AnalyzerOptionsProto.
+  absl::flat_hash_map<std::string, std::shared_ptr<const AnalyzerOptions>>
+      analyzer_options_ GUARDED_BY(options_mutex_);
 };
 
 class RegisteredCatalogPool : public SharedStatePool<RegisteredCatalogState> {};
@@ -229,13 +357,367 @@ class RegisteredParseResumeLocationState : public GenericState {
 class RegisteredParseResumeLocationPool
     : public SharedStatePool<RegisteredParseResumeLocationState> {};
 
+// An expression that has been analyzed and compiled once, to be evaluated by
+// any number of Evaluate() calls. Builtin functions are the only functions
+// visible to the expression.
+class PreparedExpressionState : public BaseSavedState {
+ public:
+  PreparedExpressionState() : BaseSavedState() {}
+  PreparedExpressionState(const PreparedExpressionState&) = delete;
+  PreparedExpressionState& operator=(const PreparedExpressionState&) = delete;
+
+  zetasql_base::Status InitForPrepare(const PrepareRequest& request) {
+    ZETASQL_RETURN_IF_ERROR(BaseSavedState::Init(request.file_descriptor_set()));
+
+    absl::MutexLock lock(&mutex_);
+    AnalyzerOptions options;
+    ZETASQL_RETURN_IF_ERROR(AnalyzerOptions::Deserialize(request.options(), const_pools_,
+                                                 &factory_, &options));
+    return Compile(request.sql(), options);
+  }
+
+  // Initializes from an EvaluateRequest without a prepared expression, which
+  // declares its columns and parameters with the types in the request.
+  zetasql_base::Status InitForEvaluate(const EvaluateRequest& request) {
+    ZETASQL_RETURN_IF_ERROR(BaseSavedState::Init(request.file_descriptor_set()));
+
+    absl::MutexLock lock(&mutex_);
+    AnalyzerOptions options;
+    for (const EvaluateRequest::Parameter& column : request.columns()) {
+      const Type* type;
+      ZETASQL_RETURN_IF_ERROR(factory_.DeserializeFromProtoUsingExistingPools(
+          column.type(), const_pools_, &type));
+      ZETASQL_RETURN_IF_ERROR(options.AddExpressionColumn(column.name(), type));
+    }
+    for (const EvaluateRequest::Parameter& param : request.params()) {
+      const Type* type;
+      ZETASQL_RETURN_IF_ERROR(factory_.DeserializeFromProtoUsingExistingPools(
+          param.type(), const_pools_, &type));
+      ZETASQL_RETURN_IF_ERROR(options.AddQueryParameter(param.name(), type));
+    }
+    return Compile(request.sql(), options);
+  }
+
+  // The compiled expression, which does not change after initialization.
+  const CompiledExpression* GetExpression() {
+    absl::MutexLock lock(&mutex_);
+    CHECK(initialized_);
+    return expression_.get();
+  }
+
+ private:
+  zetasql_base::Status Compile(const std::string& sql, const AnalyzerOptions& options)
+      EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    SimpleCatalog catalog("prepared_expression", &factory_);
+    catalog.AddSharedZetaSQLFunctions(options.language());
+    std::unique_ptr<const AnalyzerOutput> output;
+    ZETASQL_RETURN_IF_ERROR(
+        AnalyzeExpression(sql, options, &catalog, &factory_, &output));
+    // Constant subexpressions are evaluated once here, not on every row.
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<const ResolvedNode> expr,
+                     FoldConstantsInCopy(output->resolved_expr()));
+    ZETASQL_ASSIGN_OR_RETURN(
+        expression_, CompiledExpression::Compile(expr->GetAs<ResolvedExpr>()));
+    initialized_ = true;
+    return ::zetasql_base::OkStatus();
+  }
+
+  std::unique_ptr<const CompiledExpression> expression_ GUARDED_BY(mutex_);
+};
+
+class PreparedExpressionPool
+    : public SharedStatePool<PreparedExpressionState> {};
+
+namespace {
+
+// Deserializes the values of <request_values> that are needed for the
+// slots with <names> and <types> into <values>, in slot order.
+zetasql_base::Status GetSlotValues(
+    const RepeatedPtrField<EvaluateRequest::Parameter>& request_values,
+    const std::vector<std::string>& names, const std::vector<const Type*>& types,
+    absl::string_view kind, std::vector<Value>* values) {
+  absl::flat_hash_map<std::string, const ValueProto*> values_by_name;
+  for (const EvaluateRequest::Parameter& value : request_values) {
+    values_by_name[absl::AsciiStrToLower(value.name())] = &value.value();
+  }
+  values->clear();
+  values->reserve(names.size());
+  for (int i = 0; i < names.size(); ++i) {
+    const ValueProto* const* value_proto =
+        zetasql_base::FindOrNull(values_by_name, names[i]);
+    if (value_proto == nullptr) {
+      return MakeSqlError() << "Missing value for " << kind << " " << names[i];
+    }
+    ZETASQL_ASSIGN_OR_RETURN(Value value, Value::Deserialize(**value_proto, types[i]));
+    values->push_back(std::move(value));
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+// Finds the column of <request_columns> for each of the slots with <names>,
+// and checks that it has <num_rows> values or a single value.
+zetasql_base::Status GetSlotColumns(
+    const RepeatedPtrField<EvaluateBatchRequest::Column>& request_columns,
+    const std::vector<std::string>& names, int64_t num_rows,
+    absl::string_view kind,
+    std::vector<const RepeatedPtrField<ValueProto>*>* columns) {
+  absl::flat_hash_map<std::string, const RepeatedPtrField<ValueProto>*>
+      columns_by_name;
+  for (const EvaluateBatchRequest::Column& column : request_columns) {
+    columns_by_name[absl::AsciiStrToLower(column.name())] = &column.values();
+  }
+  columns->clear();
+  for (const std::string& name : names) {
+    const RepeatedPtrField<ValueProto>* const* values =
+        zetasql_base::FindOrNull(columns_by_name, name);
+    if (values == nullptr) {
+      return MakeSqlError() << "Missing values for " << kind << " " << name;
+    }
+    if ((*values)->size() != num_rows && (*values)->size() != 1) {
+      return MakeSqlError() << "Expected " << num_rows << " values for "
+                            << kind << " " << name << ", but got "
+                            << (*values)->size();
+    }
+    columns->push_back(*values);
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+// Sets <row> to the values of <columns> at <row_index>, deserialized with
+// <types>. Columns with a single value are only deserialized for the first
+// row, and keep that value afterwards.
+zetasql_base::Status GetRowValues(
+    const std::vector<const RepeatedPtrField<ValueProto>*>& columns,
+    const std::vector<const Type*>& types, int64_t row_index,
+    std::vector<Value>* row) {
+  row->resize(columns.size());
+  for (int i = 0; i < columns.size(); ++i) {
+    const RepeatedPtrField<ValueProto>& values = *columns[i];
+    if (values.size() == 1 && row_index > 0) continue;
+    ZETASQL_ASSIGN_OR_RETURN(
+        (*row)[i],
+        Value::Deserialize(values.Get(values.size() == 1 ? 0 : row_index),
+                           types[i]));
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+// Evaluates <expression> for each row of <request>, in order, and passes the
+// result of each row to <consume>.
+zetasql_base::Status EvaluateRows(
+    const CompiledExpression& expression, const EvaluateBatchRequest& request,
+    const std::function<zetasql_base::Status(int64_t, const Value&)>& consume) {
+  const int64_t num_rows = request.num_rows();
+  if (num_rows < 0) {
+    return MakeSqlError() << "Invalid number of rows: " << num_rows;
+  }
+  std::vector<const RepeatedPtrField<ValueProto>*> column_values;
+  ZETASQL_RETURN_IF_ERROR(GetSlotColumns(request.columns(),
+                                 expression.column_names(), num_rows,
+                                 "column", &column_values));
+  std::vector<const RepeatedPtrField<ValueProto>*> param_values;
+  ZETASQL_RETURN_IF_ERROR(GetSlotColumns(request.params(),
+                                 expression.parameter_names(), num_rows,
+                                 "parameter", &param_values));
+
+  std::vector<Value> columns;
+  std::vector<Value> params;
+  for (int64_t row = 0; row < num_rows; ++row) {
+    ZETASQL_RETURN_IF_ERROR(GetRowValues(column_values, expression.column_types(),
+                                 row, &columns));
+    ZETASQL_RETURN_IF_ERROR(GetRowValues(param_values, expression.parameter_types(),
+                                 row, &params));
+    zetasql_base::StatusOr<Value> result = expression.Evaluate(columns, params);
+    if (!result.ok()) {
+      return ::zetasql_base::StatusBuilder(result.status(), ZETASQL_LOC)
+             << "in row " << row;
+    }
+    ZETASQL_RETURN_IF_ERROR(consume(row, result.ValueOrDie()));
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+}  // namespace
+
 ZetaSqlLocalServiceImpl::ZetaSqlLocalServiceImpl()
     : registered_catalogs_(new RegisteredCatalogPool()),
       registered_parse_resume_locations_(
-          new RegisteredParseResumeLocationPool()) {}
+          new RegisteredParseResumeLocationPool()),
+      prepared_expressions_(new PreparedExpressionPool()) {}
 
 ZetaSqlLocalServiceImpl::~ZetaSqlLocalServiceImpl() {}
 
+zetasql_base::Status ZetaSqlLocalServiceImpl::Prepare(const PrepareRequest& request,
+                                                PrepareResponse* response) {
+  std::unique_ptr<PreparedExpressionState> state(new PreparedExpressionState());
+  ZETASQL_RETURN_IF_ERROR(state->InitForPrepare(request));
+  const CompiledExpression* expression = state->GetExpression();
+
+  FileDescriptorSetMap file_descriptor_set_map;
+  PopulateExistingPoolsToFileDescriptorSetMap(state->GetDescriptorPools(),
+                                              &file_descriptor_set_map);
+  ZETASQL_RETURN_IF_ERROR(expression->output_type()->SerializeToProtoAndDistinctFileDescriptors(
+      response->mutable_output_type(), &file_descriptor_set_map));
+
+  int64_t id = prepared_expressions_->Register(state.release());
+  ZETASQL_RET_CHECK_NE(-1, id)
+      << "Failed to register prepared expression, this shouldn't happen.";
+  response->set_prepared_expression_id(id);
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status ZetaSqlLocalServiceImpl::Evaluate(const EvaluateRequest& request,
+                                                 EvaluateResponse* response) {
+  std::shared_ptr<PreparedExpressionState> shared_state;
+  std::unique_ptr<PreparedExpressionState> new_state;
+  PreparedExpressionState* state;
+  if (request.has_prepared_expression_id()) {
+    int64_t id = request.prepared_expression_id();
+    shared_state = prepared_expressions_->Get(id);
+    state = shared_state.get();
+    if (state == nullptr) {
+      return MakeSqlError() << "Unknown prepared expression ID: " << id;
+    }
+    response->set_prepared_expression_id(id);
+  } else {
+    new_state = absl::make_unique<PreparedExpressionState>();
+    state = new_state.get();
+    ZETASQL_RETURN_IF_ERROR(state->InitForEvaluate(request));
+  }
+
+  // Only values are read from the request; their types are known from the
+  // prepared expression.
+  const CompiledExpression* expression = state->GetExpression();
+  std::vector<Value> columns;
+  ZETASQL_RETURN_IF_ERROR(GetSlotValues(request.columns(), expression->column_names(),
+                                expression->column_types(), "column",
+                                &columns));
+  std::vector<Value> params;
+  ZETASQL_RETURN_IF_ERROR(GetSlotValues(request.params(),
+                                expression->parameter_names(),
+                                expression->parameter_types(), "parameter",
+                                &params));
+  ZETASQL_ASSIGN_OR_RETURN(const Value result, expression->Evaluate(columns, params));
+
+  ZETASQL_RETURN_IF_ERROR(result.Serialize(response->mutable_value()));
+  FileDescriptorSetMap file_descriptor_set_map;
+  PopulateExistingPoolsToFileDescriptorSetMap(state->GetDescriptorPools(),
+                                              &file_descriptor_set_map);
+  return result.type()->SerializeToProtoAndDistinctFileDescriptors(
+      response->mutable_type(), &file_descriptor_set_map);
+}
+
+zetasql_base::Status ZetaSqlLocalServiceImpl::EvaluateBatch(
+    const EvaluateBatchRequest& request, EvaluateBatchResponse* response) {
+  int64_t id = request.prepared_expression_id();
+  std::shared_ptr<PreparedExpressionState> state =
+      prepared_expressions_->Get(id);
+  if (state == nullptr) {
+    return MakeSqlError() << "Unknown prepared expression ID: " << id;
+  }
+
+  const CompiledExpression* expression = state->GetExpression();
+  response->mutable_values()->Reserve(std::max<int64_t>(request.num_rows(), 0));
+  ZETASQL_RETURN_IF_ERROR(EvaluateRows(
+      *expression, request, [response](int64_t row, const Value& result) {
+        return result.Serialize(response->add_values());
+      }));
+
+  FileDescriptorSetMap file_descriptor_set_map;
+  PopulateExistingPoolsToFileDescriptorSetMap(state->GetDescriptorPools(),
+                                              &file_descriptor_set_map);
+  return expression->output_type()->SerializeToProtoAndDistinctFileDescriptors(
+      response->mutable_type(), &file_descriptor_set_map);
+}
+
+zetasql_base::Status ZetaSqlLocalServiceImpl::EvaluateBatchStream(
+    const EvaluateBatchRequest& request,
+    const std::function<bool(const EvaluateBatchResponse&)>& write) {
+  int64_t id = request.prepared_expression_id();
+  std::shared_ptr<PreparedExpressionState> state =
+      prepared_expressions_->Get(id);
+  if (state == nullptr) {
+    return MakeSqlError() << "Unknown prepared expression ID: " << id;
+  }
+  const int64_t max_chunk_bytes =
+      request.has_max_chunk_bytes() ? request.max_chunk_bytes() : 1 << 20;
+
+  const CompiledExpression* expression = state->GetExpression();
+  // An ARRAY of ARRAYs is not a valid value, so ARRAY results are never
+  // packed.
+  const bool packed = request.packed_values() &&
+                      !expression->output_type()->IsArray();
+  TypeFactory type_factory;
+  const ArrayType* chunk_type = nullptr;
+  if (packed) {
+    ZETASQL_RETURN_IF_ERROR(
+        type_factory.MakeArrayType(expression->output_type(), &chunk_type));
+  }
+
+  EvaluateBatchResponse response;
+  response.set_first_row(0);
+  FileDescriptorSetMap file_descriptor_set_map;
+  PopulateExistingPoolsToFileDescriptorSetMap(state->GetDescriptorPools(),
+                                              &file_descriptor_set_map);
+  ZETASQL_RETURN_IF_ERROR(
+      expression->output_type()->SerializeToProtoAndDistinctFileDescriptors(
+          response.mutable_type(), &file_descriptor_set_map));
+
+  // The results of the rows of the current chunk, if packed.
+  std::vector<Value> chunk;
+  int64_t num_chunk_rows = 0;
+  int64_t chunk_bytes = 0;
+  auto flush = [&]() -> zetasql_base::Status {
+    if (packed) {
+      ZETASQL_RETURN_IF_ERROR(Value::Array(chunk_type, chunk).Serialize(
+          response.mutable_packed_values(), /*pack_arrays=*/true));
+      chunk.clear();
+    }
+    if (!write(response)) {
+      return ::zetasql_base::CancelledErrorBuilder(ZETASQL_LOC)
+             << "EvaluateBatchStream was cancelled";
+    }
+    response.set_first_row(response.first_row() + num_chunk_rows);
+    response.clear_type();
+    response.clear_values();
+    response.clear_packed_values();
+    num_chunk_rows = 0;
+    chunk_bytes = 0;
+    return ::zetasql_base::OkStatus();
+  };
+
+  ZETASQL_RETURN_IF_ERROR(EvaluateRows(
+      *expression, request,
+      [&](int64_t row, const Value& result) -> zetasql_base::Status {
+        // The in-memory size of the values bounds their serialized size
+        // well enough, without serializing them twice.
+        const int64_t bytes = result.physical_byte_size();
+        if (num_chunk_rows > 0 && chunk_bytes + bytes > max_chunk_bytes) {
+          ZETASQL_RETURN_IF_ERROR(flush());
+        }
+        if (packed) {
+          chunk.push_back(result);
+        } else {
+          ZETASQL_RETURN_IF_ERROR(result.Serialize(response.add_values()));
+        }
+        ++num_chunk_rows;
+        chunk_bytes += bytes;
+        return ::zetasql_base::OkStatus();
+      }));
+  // A request without rows still gets one response, with the type.
+  if (num_chunk_rows > 0 || response.has_type()) {
+    ZETASQL_RETURN_IF_ERROR(flush());
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status ZetaSqlLocalServiceImpl::Unprepare(int64_t id) {
+  if (prepared_expressions_->Delete(id)) {
+    return ::zetasql_base::OkStatus();
+  }
+  return MakeSqlError() << "Unknown prepared expression ID: " << id;
+}
+
 zetasql_base::Status ZetaSqlLocalServiceImpl::GetTableFromProto(
     const TableFromProtoRequest& request, SimpleTableProto* response) {
   TypeFactory factory;
@@ -319,19 +801,107 @@ zetasql_base::Status ZetaSqlLocalServiceImpl::Analyze(const AnalyzeRequest& requ
   return AnalyzeImpl(request, catalog_state, location, response);
 }
 
+zetasql_base::Status ZetaSqlLocalServiceImpl::AnalyzeScript(
+    const std::function<bool(AnalyzeScriptRequest*)>& read,
+    const std::function<bool(const AnalyzeResponse&)>& write) {
+  AnalyzeScriptRequest request;
+  if (!read(&request)) {
+    return ::zetasql_base::OkStatus();
+  }
+
+  // Holds a registered catalog for the whole stream, so that unregistering
+  // it meanwhile does not delete it.
+  std::shared_ptr<RegisteredCatalogState> catalog_state;
+  if (request.has_registered_catalog_id()) {
+    int64_t id = request.registered_catalog_id();
+    catalog_state = registered_catalogs_->Get(id);
+    if (catalog_state == nullptr) {
+      return MakeSqlError() << "Registered catalog " << id << " unknown.";
+    }
+  } else {
+    catalog_state = std::make_shared<RegisteredCatalogState>();
+    ZETASQL_RETURN_IF_ERROR(catalog_state->Init(request.simple_catalog(),
+                                        request.file_descriptor_set()));
+  }
+
+  // The settings that SerializeResolvedStatement() reads.
+  AnalyzeRequest settings;
+  settings.set_compact_resolved_statement(
+      request.compact_resolved_statement());
+  settings.set_fold_constants(request.fold_constants());
+
+  ZETASQL_ASSIGN_OR_RETURN(std::shared_ptr<const AnalyzerOptions> options_ptr,
+                   catalog_state->GetAnalyzerOptions(request.options()));
+  const AnalyzerOptions& options = *options_ptr;
+  const ParserOptions parser_options = options.GetParserOptions();
+
+  TypeFactory factory;
+  std::string script = request.sql_chunk();
+  int position = 0;
+  bool end_of_stream = false;
+  while (true) {
+    // Analyzes the complete statements in <script>, or all the rest of it
+    // at the end of the stream.
+    bool at_end_of_input = false;
+    while (!at_end_of_input) {
+      const absl::string_view rest = absl::string_view(script).substr(position);
+      if (end_of_stream && absl::StripAsciiWhitespace(rest).empty()) {
+        return ::zetasql_base::OkStatus();
+      }
+      ParseResumeLocation location =
+          ParseResumeLocation::FromStringView(script);
+      location.set_byte_position(position);
+      std::unique_ptr<ParserOutput> parser_output;
+      const zetasql_base::Status parse_status = ParseNextStatement(
+          &location, parser_options, &parser_output, &at_end_of_input);
+      if (!end_of_stream && (!parse_status.ok() || at_end_of_input)) {
+        break;
+      }
+      ZETASQL_RETURN_IF_ERROR(ConvertInternalErrorLocationAndAdjustErrorString(
+          options.error_message_mode(), script, parse_status));
+
+      std::unique_ptr<absl::ReaderMutexLock> catalog_lock;
+      std::unique_ptr<const AnalyzerOutput> output;
+      ZETASQL_RETURN_IF_ERROR(AnalyzeStatementFromParserOutputOwnedOnSuccess(
+          &parser_output, options, script,
+          catalog_state->GetCatalog(&catalog_lock), &factory, &output));
+      AnalyzeResponse response;
+      ZETASQL_RETURN_IF_ERROR(SerializeResolvedStatement(
+          settings, output.get(), script, &response, catalog_state.get()));
+      catalog_lock.reset();
+      position = location.byte_position();
+      response.set_resume_byte_position(position);
+      if (!write(response)) {
+        return ::zetasql_base::CancelledErrorBuilder(ZETASQL_LOC)
+               << "AnalyzeScript response stream closed";
+      }
+    }
+    if (end_of_stream) {
+      return ::zetasql_base::OkStatus();
+    }
+    request.Clear();
+    if (read(&request)) {
+      absl::StrAppend(&script, request.sql_chunk());
+    } else {
+      end_of_stream = true;
+    }
+  }
+}
+
 zetasql_base::Status ZetaSqlLocalServiceImpl::AnalyzeImpl(
     const AnalyzeRequest& request, RegisteredCatalogState* catalog_state,
     ParseResumeLocation* location, AnalyzeResponse* response) {
-  AnalyzerOptions options;
-  ZETASQL_RETURN_IF_ERROR(AnalyzerOptions::Deserialize(
-      request.options(), catalog_state->GetDescriptorPools(),
-      catalog_state->GetTypeFactory(), &options));
+  ZETASQL_ASSIGN_OR_RETURN(std::shared_ptr<const AnalyzerOptions> options_ptr,
+                   catalog_state->GetAnalyzerOptions(request.options()));
+  const AnalyzerOptions& options = *options_ptr;
 
   if (!(request.has_sql_statement() || location != nullptr)) {
     return ::zetasql_base::UnknownErrorBuilder(ZETASQL_LOC)
            << "Unrecognized AnalyzeRequest target " << request.target_case();
   }
 
+  std::unique_ptr<absl::ReaderMutexLock> catalog_lock;
+  SimpleCatalog* catalog = catalog_state->GetCatalog(&catalog_lock);
   std::unique_ptr<const AnalyzerOutput> output;
   TypeFactory factory;
 
@@ -339,18 +909,18 @@ zetasql_base::Status ZetaSqlLocalServiceImpl::AnalyzeImpl(
     const std::string& sql = request.sql_statement();
 
     ZETASQL_RETURN_IF_ERROR(zetasql::AnalyzeStatement(
-        sql, options, catalog_state->GetCatalog(), &factory, &output));
+        sql, options, catalog, &factory, &output));
 
-    ZETASQL_RETURN_IF_ERROR(
-        SerializeResolvedStatement(output.get(), sql, response, catalog_state));
+    ZETASQL_RETURN_IF_ERROR(SerializeResolvedStatement(request, output.get(), sql,
+                                               response, catalog_state));
   } else if (location != nullptr) {
     bool at_end_of_input;
     ZETASQL_RETURN_IF_ERROR(zetasql::AnalyzeNextStatement(
-        location, options, catalog_state->GetCatalog(), &factory, &output,
+        location, options, catalog, &factory, &output,
         &at_end_of_input));
 
     ZETASQL_RETURN_IF_ERROR(SerializeResolvedStatement(
-        output.get(), location->input(), response, catalog_state));
+        request, output.get(), location->input(), response, catalog_state));
     response->set_resume_byte_position(location->byte_position());
   }
   return ::zetasql_base::OkStatus();
@@ -409,15 +979,30 @@ zetasql_base::Status ZetaSqlLocalServiceImpl::ExtractTableNamesFromNextStatement
 }
 
 zetasql_base::Status ZetaSqlLocalServiceImpl::SerializeResolvedStatement(
-    const AnalyzerOutput* output, absl::string_view statement,
-    AnalyzeResponse* response, RegisteredCatalogState* state) {
+    const AnalyzeRequest& request, const AnalyzerOutput* output,
+    absl::string_view statement, AnalyzeResponse* response,
+    RegisteredCatalogState* state) {
   const std::vector<const google::protobuf::DescriptorPool*>& pools =
       state->GetDescriptorPools();
   FileDescriptorSetMap file_descriptor_set_map;
   PopulateExistingPoolsToFileDescriptorSetMap(pools, &file_descriptor_set_map);
 
-  ZETASQL_RETURN_IF_ERROR(output->resolved_statement()->SaveTo(
-      &file_descriptor_set_map, response->mutable_resolved_statement()));
+  const ResolvedStatement* resolved_statement = output->resolved_statement();
+  std::unique_ptr<const ResolvedNode> folded_statement;
+  if (request.fold_constants()) {
+    ZETASQL_ASSIGN_OR_RETURN(folded_statement,
+                     FoldConstantsInCopy(resolved_statement));
+    resolved_statement = folded_statement->GetAs<ResolvedStatement>();
+  }
+
+  if (request.compact_resolved_statement()) {
+    ZETASQL_RETURN_IF_ERROR(SerializeResolvedStatementCompact(
+        *resolved_statement, &file_descriptor_set_map,
+        response->mutable_compact_resolved_statement()));
+  } else {
+    ZETASQL_RETURN_IF_ERROR(resolved_statement->SaveTo(
+        &file_descriptor_set_map, response->mutable_resolved_statement()));
+  }
 
   // If the file_descriptor_set_map contains more descriptor pools than those
   // passed in the request, the additonal one must be the generated descriptor
@@ -486,17 +1071,38 @@ zetasql_base::Status ZetaSqlLocalServiceImpl::UnregisterParseResumeLocation(
 zetasql_base::Status ZetaSqlLocalServiceImpl::GetBuiltinFunctions(
     const ZetaSQLBuiltinFunctionOptionsProto& proto,
     GetBuiltinFunctionsResponse* resp) {
+  std::string key;
+  proto.SerializeToString(&key);
+  {
+    absl::MutexLock lock(&builtin_functions_mutex_);
+    const std::shared_ptr<const GetBuiltinFunctionsResponse>* cached =
+        zetasql_base::FindOrNull(builtin_functions_responses_, key);
+    if (cached != nullptr) {
+      *resp = **cached;
+      return ::zetasql_base::OkStatus();
+    }
+  }
+
   TypeFactory factory;
   std::map<std::string, std::unique_ptr<Function>> functions;
   ZetaSQLBuiltinFunctionOptions options(proto);
 
   zetasql::GetZetaSQLFunctions(&factory, options, &functions);
 
+  auto response = std::make_shared<GetBuiltinFunctionsResponse>();
   FileDescriptorSetMap map;
   for (const auto& function : functions) {
-    ZETASQL_RETURN_IF_ERROR(function.second->Serialize(&map, resp->add_function()));
+    ZETASQL_RETURN_IF_ERROR(
+        function.second->Serialize(&map, response->add_function()));
   }
+  *resp = *response;
 
+  absl::MutexLock lock(&builtin_functions_mutex_);
+  if (builtin_functions_responses_.size() >=
+      kMaxCachedBuiltinFunctionsResponses) {
+    builtin_functions_responses_.clear();
+  }
+  builtin_functions_responses_.emplace(std::move(key), std::move(response));
   return ::zetasql_base::OkStatus();
 }
 
@@ -513,6 +1119,17 @@ zetasql_base::Status ZetaSqlLocalServiceImpl::AddSimpleTable(
   return ::zetasql_base::OkStatus();
 }
 
+zetasql_base::Status ZetaSqlLocalServiceImpl::UpdateCatalog(
+    const UpdateCatalogRequest& request, UpdateCatalogResponse* response) {
+  int64_t id = request.registered_catalog_id();
+  std::shared_ptr<RegisteredCatalogState> shared_state =
+      registered_catalogs_->Get(id);
+  if (shared_state == nullptr) {
+    return MakeSqlError() << "Unknown catalog ID: " << id;
+  }
+  return shared_state->UpdateCatalog(request, response);
+}
+
 zetasql_base::Status ZetaSqlLocalServiceImpl::GetLanguageOptions(
     const LanguageOptionsRequest& request, LanguageOptionsProto* response) {
   zetasql::LanguageOptions options;
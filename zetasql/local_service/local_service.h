@@ -18,7 +18,9 @@
 #define ZETASQL_LOCAL_SERVICE_LOCAL_SERVICE_H_
 
 #include <stddef.h>
+#include <functional>
 #include <memory>
+#include <string>
 
 #include "zetasql/local_service/local_service.pb.h"
 #include "zetasql/proto/options.pb.h"
@@ -26,12 +28,16 @@
 #include "zetasql/public/parse_resume_location.h"
 #include "zetasql/public/parse_resume_location.pb.h"
 #include <cstdint>
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "zetasql/base/status.h"
 
 namespace zetasql {
 namespace local_service {
 
+class PreparedExpressionPool;
 class RegisteredCatalogPool;
 class RegisteredCatalogState;
 class RegisteredParseResumeLocationPool;
@@ -45,18 +51,62 @@ class ZetaSqlLocalServiceImpl {
       delete;
   ~ZetaSqlLocalServiceImpl();
 
+  // Analyzes and compiles the expression in <request>, and keeps it until
+  // Unprepare() is called with the returned id.
+  zetasql_base::Status Prepare(const PrepareRequest& request, PrepareResponse* response);
+
+  // Evaluates a prepared expression, or analyzes and evaluates the
+  // expression in <request> if it has no prepared expression id.
+  zetasql_base::Status Evaluate(const EvaluateRequest& request,
+                        EvaluateResponse* response);
+
+  // Evaluates a prepared expression for each row of <request>.
+  zetasql_base::Status EvaluateBatch(const EvaluateBatchRequest& request,
+                             EvaluateBatchResponse* response);
+
+  // Same as EvaluateBatch(), but evaluates the rows one chunk at a time and
+  // passes each chunk to <write> before evaluating the next one. Returns a
+  // kCancelled error if <write> returns false.
+  zetasql_base::Status EvaluateBatchStream(
+      const EvaluateBatchRequest& request,
+      const std::function<bool(const EvaluateBatchResponse&)>& write);
+
+  zetasql_base::Status Unprepare(int64_t id);
+
   zetasql_base::Status GetTableFromProto(const TableFromProtoRequest& request,
                                  SimpleTableProto* response);
 
+  // Returns the builtin functions of <proto>.  Clients mostly ask for the
+  // same few options, so the last kMaxCachedBuiltinFunctionsResponses
+  // distinct responses are kept.  To register a catalog with these
+  // functions, set SimpleCatalogProto.builtin_function_options rather than
+  // sending them back.
   zetasql_base::Status GetBuiltinFunctions(
       const ZetaSQLBuiltinFunctionOptionsProto& proto,
       GetBuiltinFunctionsResponse* resp);
 
   zetasql_base::Status AddSimpleTable(const AddSimpleTableRequest& request);
 
+  // Applies the changes in <request> to a registered catalog, waiting for
+  // the analyses using it to finish.
+  zetasql_base::Status UpdateCatalog(const UpdateCatalogRequest& request,
+                             UpdateCatalogResponse* response);
+
   zetasql_base::Status Analyze(const AnalyzeRequest& request,
                        AnalyzeResponse* response);
 
+  // Analyzes a script that arrives in chunks. <read> fills in the next
+  // request and returns false at the end of the stream. Each statement is
+  // passed to <write> as soon as it is complete, that is, as soon as more
+  // than whitespace follows its semicolon or the stream has ended. Returns a
+  // kCancelled error if <write> returns false.
+  //
+  // A statement that does not parse yet is retried when more of the script
+  // arrives, so its errors are returned only at the end of the stream.
+  zetasql_base::Status AnalyzeScript(
+      const std::function<bool(AnalyzeScriptRequest*)>& read,
+      const std::function<bool(const AnalyzeResponse&)>& write);
+
   zetasql_base::Status AnalyzeImpl(const AnalyzeRequest& request,
                            RegisteredCatalogState* catalog_state,
                            ParseResumeLocation* location,
@@ -70,7 +120,11 @@ class ZetaSqlLocalServiceImpl {
       const ExtractTableNamesFromNextStatementRequest& request,
       ExtractTableNamesFromNextStatementResponse* response);
 
-  zetasql_base::Status SerializeResolvedStatement(const AnalyzerOutput* output,
+  // Serializes the resolved statement in <output> into <response>, using
+  // the compact encoding if the request asks for it, after folding
+  // constants if it asks for that.
+  zetasql_base::Status SerializeResolvedStatement(const AnalyzeRequest& request,
+                                          const AnalyzerOutput* output,
                                           absl::string_view statement,
                                           AnalyzeResponse* response,
                                           RegisteredCatalogState* state);
@@ -92,6 +146,14 @@ class ZetaSqlLocalServiceImpl {
   std::unique_ptr<RegisteredCatalogPool> registered_catalogs_;
   std::unique_ptr<RegisteredParseResumeLocationPool>
       registered_parse_resume_locations_;
+  std::unique_ptr<PreparedExpressionPool> prepared_expressions_;
+
+  static constexpr int kMaxCachedBuiltinFunctionsResponses = 8;
+  absl::Mutex builtin_functions_mutex_;
+  // GetBuiltinFunctions() responses, by the serialized options.
+  absl::flat_hash_map<std::string,
+                      std::shared_ptr<const GetBuiltinFunctionsResponse>>
+      builtin_functions_responses_ GUARDED_BY(builtin_functions_mutex_);
 
   friend class ZetaSqlLocalServiceImplTest;
 };
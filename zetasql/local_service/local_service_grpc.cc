@@ -82,6 +82,41 @@ grpc::Status ToGrpcStatus(zetasql_base::Status status) {
 
 }  // namespace
 
+grpc::Status ZetaSqlLocalServiceGrpcImpl::Prepare(grpc::ServerContext* context,
+                                                  const PrepareRequest* req,
+                                                  PrepareResponse* resp) {
+  return ToGrpcStatus(service_.Prepare(*req, resp));
+}
+
+grpc::Status ZetaSqlLocalServiceGrpcImpl::Evaluate(grpc::ServerContext* context,
+                                                   const EvaluateRequest* req,
+                                                   EvaluateResponse* resp) {
+  return ToGrpcStatus(service_.Evaluate(*req, resp));
+}
+
+grpc::Status ZetaSqlLocalServiceGrpcImpl::EvaluateBatch(
+    grpc::ServerContext* context, const EvaluateBatchRequest* req,
+    EvaluateBatchResponse* resp) {
+  return ToGrpcStatus(service_.EvaluateBatch(*req, resp));
+}
+
+grpc::Status ZetaSqlLocalServiceGrpcImpl::EvaluateBatchStream(
+    grpc::ServerContext* context, const EvaluateBatchRequest* req,
+    grpc::ServerWriter<EvaluateBatchResponse>* writer) {
+  // Write() blocks while the client is not reading, which keeps at most a
+  // chunk or so in flight; evaluation stops once the call is cancelled.
+  return ToGrpcStatus(service_.EvaluateBatchStream(
+      *req, [context, writer](const EvaluateBatchResponse& resp) {
+        return !context->IsCancelled() && writer->Write(resp);
+      }));
+}
+
+grpc::Status ZetaSqlLocalServiceGrpcImpl::Unprepare(
+    grpc::ServerContext* context, const UnprepareRequest* req,
+    google::protobuf::Empty* unused) {
+  return ToGrpcStatus(service_.Unprepare(req->prepared_expression_id()));
+}
+
 grpc::Status ZetaSqlLocalServiceGrpcImpl::GetTableFromProto(
     grpc::ServerContext* context, const TableFromProtoRequest* req,
     SimpleTableProto* resp) {
@@ -94,6 +129,14 @@ grpc::Status ZetaSqlLocalServiceGrpcImpl::Analyze(
   return ToGrpcStatus(service_.Analyze(*req, resp));
 }
 
+grpc::Status ZetaSqlLocalServiceGrpcImpl::AnalyzeScript(
+    grpc::ServerContext* context,
+    grpc::ServerReaderWriter<AnalyzeResponse, AnalyzeScriptRequest>* stream) {
+  return ToGrpcStatus(service_.AnalyzeScript(
+      [stream](AnalyzeScriptRequest* req) { return stream->Read(req); },
+      [stream](const AnalyzeResponse& resp) { return stream->Write(resp); }));
+}
+
 grpc::Status ZetaSqlLocalServiceGrpcImpl::ExtractTableNamesFromStatement(
     grpc::ServerContext* context,
     const ExtractTableNamesFromStatementRequest* req,
@@ -148,6 +191,12 @@ grpc::Status ZetaSqlLocalServiceGrpcImpl::AddSimpleTable(
   return ToGrpcStatus(service_.AddSimpleTable(*req));
 }
 
+grpc::Status ZetaSqlLocalServiceGrpcImpl::UpdateCatalog(
+    grpc::ServerContext* context, const UpdateCatalogRequest* req,
+    UpdateCatalogResponse* resp) {
+  return ToGrpcStatus(service_.UpdateCatalog(*req, resp));
+}
+
 grpc::Status ZetaSqlLocalServiceGrpcImpl::GetLanguageOptions(
     grpc::ServerContext* context, const LanguageOptionsRequest* req,
     LanguageOptionsProto* resp) {
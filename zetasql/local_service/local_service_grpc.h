@@ -32,6 +32,24 @@ class ZetaSqlLocalServiceGrpcImpl
     : public ZetaSqlLocalService::Service {
  public:
 
+  grpc::Status Prepare(grpc::ServerContext* context, const PrepareRequest* req,
+                       PrepareResponse* resp) override;
+
+  grpc::Status Evaluate(grpc::ServerContext* context, const EvaluateRequest* req,
+                        EvaluateResponse* resp) override;
+
+  grpc::Status EvaluateBatch(grpc::ServerContext* context,
+                             const EvaluateBatchRequest* req,
+                             EvaluateBatchResponse* resp) override;
+
+  grpc::Status EvaluateBatchStream(
+      grpc::ServerContext* context, const EvaluateBatchRequest* req,
+      grpc::ServerWriter<EvaluateBatchResponse>* writer) override;
+
+  grpc::Status Unprepare(grpc::ServerContext* context,
+                         const UnprepareRequest* req,
+                         google::protobuf::Empty* unused) override;
+
   grpc::Status GetTableFromProto(grpc::ServerContext* context,
                                  const TableFromProtoRequest* req,
                                  SimpleTableProto* resp) override;
@@ -39,6 +57,11 @@ class ZetaSqlLocalServiceGrpcImpl
   grpc::Status Analyze(grpc::ServerContext* context, const AnalyzeRequest* req,
                        AnalyzeResponse* resp) override;
 
+  grpc::Status AnalyzeScript(
+      grpc::ServerContext* context,
+      grpc::ServerReaderWriter<AnalyzeResponse, AnalyzeScriptRequest>* stream)
+      override;
+
   grpc::Status ExtractTableNamesFromStatement(
       grpc::ServerContext* context,
       const ExtractTableNamesFromStatementRequest* req,
@@ -75,10 +98,18 @@ class ZetaSqlLocalServiceGrpcImpl
                               const AddSimpleTableRequest* req,
                               google::protobuf::Empty* unused) override;
 
+  grpc::Status UpdateCatalog(grpc::ServerContext* context,
+                             const UpdateCatalogRequest* req,
+                             UpdateCatalogResponse* resp) override;
+
   grpc::Status GetLanguageOptions(grpc::ServerContext* context,
                                   const LanguageOptionsRequest* req,
                                   LanguageOptionsProto* resp) override;
 
+  // The service that the RPCs are delegated to, for callers in the same
+  // process that bypass gRPC.
+  ZetaSqlLocalServiceImpl* service() { return &service_; }
+
  private:
   ZetaSqlLocalServiceImpl service_;
 };
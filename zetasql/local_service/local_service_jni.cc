@@ -23,26 +23,95 @@
 #include <string.h>
 #include <sys/socket.h>
 #include <unistd.h>
+#include <cstdint>
 #include <memory>
+#include <string>
 
+#include "google/protobuf/arena.h"
+#include "zetasql/local_service/local_service.pb.h"
 #include "zetasql/local_service/local_service_grpc.h"
+#include "zetasql/base/source_location.h"
+#include "zetasql/base/status.h"
+#include "zetasql/base/status_builder.h"
 
 namespace zetasql {
 namespace local_service {
 namespace {
 
+static ZetaSqlLocalServiceGrpcImpl* GetService() {
+  // The service must remain for the lifetime of the server.
+  static ZetaSqlLocalServiceGrpcImpl* service =
+      new ZetaSqlLocalServiceGrpcImpl();
+  return service;
+}
+
 static grpc::Server* GetServer() {
   static grpc::Server* server = []() {
-    // The service must remain for the lifetime of the server.
-    static ZetaSqlLocalServiceGrpcImpl* service =
-        new ZetaSqlLocalServiceGrpcImpl();
     grpc::ServerBuilder builder;
-    builder.RegisterService(service);
+    builder.RegisterService(GetService());
     return builder.BuildAndStart().release();
   }();
   return server;
 }
 
+// The serialized response of the last direct call on this thread that did
+// not fit in its response buffer.
+static thread_local std::string* pending_response = nullptr;
+
+// Throws an io.grpc.StatusRuntimeException for <status>, the same exception
+// that a failed call through the gRPC channel throws.
+static void ThrowStatusException(JNIEnv* env,
+                                 const zetasql_base::Status& status) {
+  jclass status_class = env->FindClass("io/grpc/Status");
+  if (status_class == nullptr) {
+    return;
+  }
+  jmethodID from_code_value = env->GetStaticMethodID(
+      status_class, "fromCodeValue", "(I)Lio/grpc/Status;");
+  jmethodID with_description = env->GetMethodID(
+      status_class, "withDescription", "(Ljava/lang/String;)Lio/grpc/Status;");
+  jmethodID as_runtime_exception = env->GetMethodID(
+      status_class, "asRuntimeException",
+      "()Lio/grpc/StatusRuntimeException;");
+  if (from_code_value == nullptr || with_description == nullptr ||
+      as_runtime_exception == nullptr) {
+    return;
+  }
+  // zetasql_base::StatusCode values are the same as gRPC status codes.
+  jobject grpc_status = env->CallStaticObjectMethod(
+      status_class, from_code_value, static_cast<jint>(status.code()));
+  jstring message = env->NewStringUTF(status.error_message().c_str());
+  if (grpc_status == nullptr || message == nullptr) {
+    return;
+  }
+  grpc_status = env->CallObjectMethod(grpc_status, with_description, message);
+  if (grpc_status == nullptr) {
+    return;
+  }
+  jobject exception = env->CallObjectMethod(grpc_status, as_runtime_exception);
+  if (exception != nullptr) {
+    env->Throw(static_cast<jthrowable>(exception));
+  }
+}
+
+// Copies <data> into the direct ByteBuffer <buffer> if it fits, and returns
+// its size. Otherwise keeps it as the pending response of this thread and
+// returns minus its size.
+static jint CopyResponse(JNIEnv* env, const std::string& data,
+                         jobject buffer) {
+  void* address = env->GetDirectBufferAddress(buffer);
+  const jlong capacity = env->GetDirectBufferCapacity(buffer);
+  if (address != nullptr && capacity >= static_cast<jlong>(data.size())) {
+    memcpy(address, data.data(), data.size());
+    return data.size();
+  }
+  if (pending_response == nullptr) {
+    pending_response = new std::string;
+  }
+  *pending_response = data;
+  return -static_cast<jint>(data.size());
+}
+
 static void ErrnoSocketException(JNIEnv* env) {
   char buf[128];
   char* outstr = strerror_r(errno, buf, sizeof(buf));
@@ -122,6 +191,65 @@ Java_com_google_zetasql_JniChannelProvider_getSocketChannel(
   return sc;
 }
 
+extern "C" JNIEXPORT jint JNICALL
+Java_com_google_zetasql_JniChannelProvider_analyzeDirect(
+    JNIEnv* env, jclass, jobject request, jint request_size,
+    jobject response) {
+  const void* request_address = env->GetDirectBufferAddress(request);
+  if (request_address == nullptr ||
+      env->GetDirectBufferCapacity(request) < request_size) {
+    const zetasql_base::Status status =
+        ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+        << "Request is not a direct ByteBuffer of " << request_size
+        << " bytes";
+    ThrowStatusException(env, status);
+    return 0;
+  }
+
+  // Parses the request straight from the Java buffer into an arena, which
+  // frees it and the response in one go.
+  google::protobuf::Arena arena;
+  AnalyzeRequest* analyze_request =
+      google::protobuf::Arena::CreateMessage<AnalyzeRequest>(&arena);
+  AnalyzeResponse* analyze_response =
+      google::protobuf::Arena::CreateMessage<AnalyzeResponse>(&arena);
+  if (!analyze_request->ParseFromArray(request_address, request_size)) {
+    const zetasql_base::Status status =
+        ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+        << "Cannot parse AnalyzeRequest";
+    ThrowStatusException(env, status);
+    return 0;
+  }
+  const zetasql_base::Status status =
+      GetService()->service()->Analyze(*analyze_request, analyze_response);
+  if (!status.ok()) {
+    ThrowStatusException(env, status);
+    return 0;
+  }
+
+  void* response_address = env->GetDirectBufferAddress(response);
+  const size_t response_size = analyze_response->ByteSizeLong();
+  if (response_address != nullptr &&
+      env->GetDirectBufferCapacity(response) >=
+          static_cast<jlong>(response_size)) {
+    analyze_response->SerializeWithCachedSizesToArray(
+        static_cast<uint8_t*>(response_address));
+    return response_size;
+  }
+  return CopyResponse(env, analyze_response->SerializeAsString(), response);
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_google_zetasql_JniChannelProvider_takePendingResponse(
+    JNIEnv* env, jclass, jobject response) {
+  if (pending_response == nullptr || pending_response->empty()) {
+    return 0;
+  }
+  std::string data;
+  data.swap(*pending_response);
+  return CopyResponse(env, data, response);
+}
+
 }  // namespace
 }  // namespace local_service
 }  // namespace zetasql
@@ -28,6 +28,24 @@ extern "C" JNIEXPORT jobject JNICALL
 Java_com_google_zetasql_JniChannelProvider_getSocketChannel(
     JNIEnv* env);
 
+// Analyzes the serialized AnalyzeRequest in the first <request_size> bytes of
+// the direct ByteBuffer <request> without going through gRPC, and writes the
+// serialized AnalyzeResponse to the start of the direct ByteBuffer
+// <response>. Returns the size of the response, or minus its size if it does
+// not fit in <response>, in which case takePendingResponse() returns it.
+// Errors are thrown as io.grpc.StatusRuntimeException.
+extern "C" JNIEXPORT jint JNICALL
+Java_com_google_zetasql_JniChannelProvider_analyzeDirect(
+    JNIEnv* env, jclass, jobject request, jint request_size,
+    jobject response);
+
+// Writes the response of the last analyzeDirect() call on this thread that
+// did not fit in its buffer to the direct ByteBuffer <response>, with the
+// same return value as analyzeDirect().
+extern "C" JNIEXPORT jint JNICALL
+Java_com_google_zetasql_JniChannelProvider_takePendingResponse(
+    JNIEnv* env, jclass, jobject response);
+
 }  // namespace local_service
 }  // namespace zetasql
 
@@ -18,6 +18,7 @@
 
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "zetasql/base/logging.h"
 #include "zetasql/base/path.h"
@@ -36,6 +37,7 @@
 #include "zetasql/public/type.pb.h"
 #include "zetasql/public/value.h"
 #include "zetasql/public/value.pb.h"
+#include "zetasql/resolved_ast/compact_serialization.h"
 #include "zetasql/testdata/test_schema.pb.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -62,11 +64,56 @@ class ZetaSqlLocalServiceImplTest : public ::testing::Test {
     pool_ = absl::make_unique<google::protobuf::DescriptorPool>(proto_importer_->pool());
   }
 
+  zetasql_base::Status Prepare(const PrepareRequest& request,
+                       PrepareResponse* response) {
+    return service_.Prepare(request, response);
+  }
+
+  zetasql_base::Status Evaluate(const EvaluateRequest& request,
+                        EvaluateResponse* response) {
+    return service_.Evaluate(request, response);
+  }
+
+  zetasql_base::Status EvaluateBatch(const EvaluateBatchRequest& request,
+                             EvaluateBatchResponse* response) {
+    return service_.EvaluateBatch(request, response);
+  }
+
+  zetasql_base::Status EvaluateBatchStream(
+      const EvaluateBatchRequest& request,
+      std::vector<EvaluateBatchResponse>* responses) {
+    return service_.EvaluateBatchStream(
+        request, [responses](const EvaluateBatchResponse& response) {
+          responses->push_back(response);
+          return true;
+        });
+  }
+
+  zetasql_base::Status Unprepare(int64_t id) { return service_.Unprepare(id); }
+
   zetasql_base::Status Analyze(const AnalyzeRequest& request,
                        AnalyzeResponse* response) {
     return service_.Analyze(request, response);
   }
 
+  // Sends <requests> to AnalyzeScript(), and records in <responses> the
+  // number of requests read before each response was written.
+  zetasql_base::Status AnalyzeScript(
+      const std::vector<AnalyzeScriptRequest>& requests,
+      std::vector<std::pair<int, AnalyzeResponse>>* responses) {
+    int num_read = 0;
+    return service_.AnalyzeScript(
+        [&](AnalyzeScriptRequest* request) {
+          if (num_read == requests.size()) return false;
+          *request = requests[num_read++];
+          return true;
+        },
+        [&](const AnalyzeResponse& response) {
+          responses->emplace_back(num_read, response);
+          return true;
+        });
+  }
+
   zetasql_base::Status ExtractTableNamesFromStatement(
       const ExtractTableNamesFromStatementRequest& request,
       ExtractTableNamesFromStatementResponse* response) {
@@ -91,6 +138,16 @@ class ZetaSqlLocalServiceImplTest : public ::testing::Test {
     return service_.AddSimpleTable(request);
   }
 
+  zetasql_base::Status RegisterCatalog(const RegisterCatalogRequest& request,
+                               RegisterResponse* response) {
+    return service_.RegisterCatalog(request, response);
+  }
+
+  zetasql_base::Status UpdateCatalog(const UpdateCatalogRequest& request,
+                             UpdateCatalogResponse* response) {
+    return service_.UpdateCatalog(request, response);
+  }
+
   zetasql_base::Status GetTableFromProto(const TableFromProtoRequest& request,
                                  SimpleTableProto* response) {
     return service_.GetTableFromProto(request, response);
@@ -207,6 +264,175 @@ TEST_F(ZetaSqlLocalServiceImplTest, AnalyzeWrongCatalogId) {
             internal::StatusToString(status));
 }
 
+TEST_F(ZetaSqlLocalServiceImplTest, PrepareEvaluateUnprepare) {
+  PrepareRequest prepare_request;
+  prepare_request.set_sql("price * @quantity > 10 AND price IS NOT NULL");
+  google::protobuf::TextFormat::ParseFromString(R"(
+      expression_columns { name: "Price" type { type_kind: TYPE_INT64 } }
+      query_parameters { name: "quantity" type { type_kind: TYPE_INT64 } })",
+                                      prepare_request.mutable_options());
+  PrepareResponse prepare_response;
+  ZETASQL_ASSERT_OK(Prepare(prepare_request, &prepare_response));
+  EXPECT_EQ(TYPE_BOOL, prepare_response.output_type().type_kind());
+  const int64_t id = prepare_response.prepared_expression_id();
+
+  // Only the values are needed for a prepared expression.
+  for (int64_t price : {2, 3}) {
+    EvaluateRequest request;
+    request.set_prepared_expression_id(id);
+    EvaluateRequest::Parameter* column = request.add_columns();
+    column->set_name("price");
+    column->mutable_value()->set_int64_value(price);
+    EvaluateRequest::Parameter* param = request.add_params();
+    param->set_name("quantity");
+    param->mutable_value()->set_int64_value(4);
+
+    EvaluateResponse response;
+    ZETASQL_ASSERT_OK(Evaluate(request, &response));
+    EXPECT_EQ(id, response.prepared_expression_id());
+    EXPECT_EQ(TYPE_BOOL, response.type().type_kind());
+    EXPECT_EQ(price * 4 > 10, response.value().bool_value());
+  }
+
+  EvaluateRequest missing_column;
+  missing_column.set_prepared_expression_id(id);
+  EvaluateResponse response;
+  EXPECT_FALSE(Evaluate(missing_column, &response).ok());
+
+  ZETASQL_EXPECT_OK(Unprepare(id));
+  EXPECT_FALSE(Unprepare(id).ok());
+  missing_column.add_columns()->set_name("price");
+  EXPECT_FALSE(Evaluate(missing_column, &response).ok());
+}
+
+TEST_F(ZetaSqlLocalServiceImplTest, EvaluateBatch) {
+  PrepareRequest prepare_request;
+  prepare_request.set_sql("price * @quantity");
+  google::protobuf::TextFormat::ParseFromString(R"(
+      expression_columns { name: "price" type { type_kind: TYPE_INT64 } }
+      query_parameters { name: "quantity" type { type_kind: TYPE_INT64 } })",
+                                      prepare_request.mutable_options());
+  PrepareResponse prepare_response;
+  ZETASQL_ASSERT_OK(Prepare(prepare_request, &prepare_response));
+
+  EvaluateBatchRequest request;
+  request.set_prepared_expression_id(
+      prepare_response.prepared_expression_id());
+  // The single parameter value is used for every row.
+  google::protobuf::TextFormat::ParseFromString(R"(
+      num_rows: 3
+      columns {
+        name: "price"
+        values { int64_value: 1 }
+        values {}
+        values { int64_value: 3 }
+      }
+      params { name: "quantity" values { int64_value: 10 } })",
+                                      &request);
+  EvaluateBatchResponse response;
+  ZETASQL_ASSERT_OK(EvaluateBatch(request, &response));
+  EXPECT_EQ(TYPE_INT64, response.type().type_kind());
+  ASSERT_EQ(3, response.values_size());
+  EXPECT_EQ(10, response.values(0).int64_value());
+  EXPECT_FALSE(response.values(1).has_int64_value());
+  EXPECT_EQ(30, response.values(2).int64_value());
+
+  request.set_num_rows(2);
+  EXPECT_FALSE(EvaluateBatch(request, &response).ok());
+}
+
+TEST_F(ZetaSqlLocalServiceImplTest, EvaluateBatchStream) {
+  PrepareRequest prepare_request;
+  prepare_request.set_sql("x * 2");
+  google::protobuf::TextFormat::ParseFromString(R"(
+      expression_columns { name: "x" type { type_kind: TYPE_INT64 } })",
+                                      prepare_request.mutable_options());
+  PrepareResponse prepare_response;
+  ZETASQL_ASSERT_OK(Prepare(prepare_request, &prepare_response));
+
+  EvaluateBatchRequest request;
+  request.set_prepared_expression_id(
+      prepare_response.prepared_expression_id());
+  request.set_num_rows(5);
+  EvaluateBatchRequest::Column* column = request.add_columns();
+  column->set_name("x");
+  for (int i = 0; i < 5; ++i) {
+    column->add_values()->set_int64_value(i);
+  }
+  // Each chunk holds two values.
+  request.set_max_chunk_bytes(2 * Value::Int64(0).physical_byte_size());
+
+  std::vector<EvaluateBatchResponse> responses;
+  ZETASQL_ASSERT_OK(EvaluateBatchStream(request, &responses));
+  ASSERT_EQ(3, responses.size());
+  EXPECT_EQ(TYPE_INT64, responses[0].type().type_kind());
+  EXPECT_FALSE(responses[1].has_type());
+  std::vector<int64_t> first_rows;
+  std::vector<int64_t> values;
+  for (const EvaluateBatchResponse& response : responses) {
+    first_rows.push_back(response.first_row());
+    for (const ValueProto& value : response.values()) {
+      values.push_back(value.int64_value());
+    }
+  }
+  EXPECT_THAT(first_rows, ::testing::ElementsAre(0, 2, 4));
+  EXPECT_THAT(values, ::testing::ElementsAre(0, 2, 4, 6, 8));
+
+  // Packed chunks hold arrays of the results.
+  request.set_packed_values(true);
+  responses.clear();
+  ZETASQL_ASSERT_OK(EvaluateBatchStream(request, &responses));
+  ASSERT_EQ(3, responses.size());
+  EXPECT_EQ(0, responses[1].values_size());
+  EXPECT_THAT(responses[1].packed_values().array_value().packed_int64(),
+              ::testing::ElementsAre(4, 6));
+
+  // A write that fails cancels the evaluation.
+  int num_writes = 0;
+  EXPECT_THAT(service_.EvaluateBatchStream(
+                  request,
+                  [&num_writes](const EvaluateBatchResponse& response) {
+                    return ++num_writes < 2;
+                  }),
+              ::zetasql_base::testing::StatusIs(
+                  zetasql_base::StatusCode::kCancelled));
+  EXPECT_EQ(2, num_writes);
+
+  // Without rows, the stream has just the type.
+  request.set_num_rows(0);
+  request.clear_columns();
+  responses.clear();
+  ZETASQL_ASSERT_OK(EvaluateBatchStream(request, &responses));
+  ASSERT_EQ(1, responses.size());
+  EXPECT_EQ(TYPE_INT64, responses[0].type().type_kind());
+}
+
+TEST_F(ZetaSqlLocalServiceImplTest, EvaluateWithoutPrepare) {
+  EvaluateRequest request;
+  request.set_sql("IF(x > 1.5, x, -x)");
+  google::protobuf::TextFormat::ParseFromString(R"(
+      columns {
+        name: "x"
+        value { double_value: 1 }
+        type { type_kind: TYPE_DOUBLE }
+      })",
+                                      &request);
+  EvaluateResponse response;
+  ZETASQL_ASSERT_OK(Evaluate(request, &response));
+  EXPECT_FALSE(response.has_prepared_expression_id());
+  EXPECT_EQ(TYPE_DOUBLE, response.type().type_kind());
+  EXPECT_EQ(-1, response.value().double_value());
+}
+
+TEST_F(ZetaSqlLocalServiceImplTest, EvaluateUnsupportedExpression) {
+  PrepareRequest request;
+  request.set_sql("CONCAT('a', 'b')");
+  PrepareResponse response;
+  EXPECT_THAT(Prepare(request, &response),
+              zetasql_base::testing::StatusIs(
+                  zetasql_base::StatusCode::kUnimplemented));
+}
+
 TEST_F(ZetaSqlLocalServiceImplTest, ExtractTableNamesFromStatement) {
   ExtractTableNamesFromStatementRequest request;
   request.set_sql_statement("select count(1) from foo.bar;");
@@ -427,6 +653,71 @@ TEST_F(ZetaSqlLocalServiceImplTest, AddSimpleTableWithWrongCatalogId) {
             internal::StatusToString(status));
 }
 
+TEST_F(ZetaSqlLocalServiceImplTest, UpdateCatalog) {
+  RegisterCatalogRequest register_request;
+  ZETASQL_CHECK(google::protobuf::TextFormat::ParseFromString(
+      R"pb(simple_catalog {
+             name: "foo"
+             table {
+               name: "bar"
+               column {
+                 name: "baz"
+                 type { type_kind: TYPE_INT32 }
+               }
+             }
+           })pb",
+      &register_request));
+  RegisterResponse register_response;
+  ZETASQL_ASSERT_OK(RegisterCatalog(register_request, &register_response));
+  const int64_t id = register_response.registered_id();
+
+  AnalyzeRequest analyze_request;
+  analyze_request.set_registered_catalog_id(id);
+  analyze_request.set_sql_statement("select qux from bar, new_table");
+  AnalyzeResponse analyze_response;
+  EXPECT_FALSE(Analyze(analyze_request, &analyze_response).ok());
+
+  // Replaces bar and adds new_table.
+  UpdateCatalogRequest update_request;
+  ZETASQL_CHECK(google::protobuf::TextFormat::ParseFromString(
+      R"pb(add_table {
+             name: "bar"
+             column {
+               name: "qux"
+               type { type_kind: TYPE_STRING }
+             }
+           }
+           add_table { name: "new_table" }
+           add_constant {
+             name_path: "c"
+             type { type_kind: TYPE_INT64 }
+             value { int64_value: 1 }
+           })pb",
+      &update_request));
+  update_request.set_registered_catalog_id(id);
+  UpdateCatalogResponse update_response;
+  ZETASQL_ASSERT_OK(UpdateCatalog(update_request, &update_response));
+  const int64_t version = update_response.version();
+  ZETASQL_EXPECT_OK(Analyze(analyze_request, &analyze_response));
+
+  // Updates against a stale version fail and change nothing.
+  UpdateCatalogRequest stale_request;
+  stale_request.set_registered_catalog_id(id);
+  stale_request.set_expected_version(version + 1);
+  stale_request.add_remove_table("bar");
+  EXPECT_EQ(zetasql_base::StatusCode::kFailedPrecondition,
+            UpdateCatalog(stale_request, &update_response).code());
+  ZETASQL_EXPECT_OK(Analyze(analyze_request, &analyze_response));
+
+  stale_request.set_expected_version(version);
+  ZETASQL_ASSERT_OK(UpdateCatalog(stale_request, &update_response));
+  EXPECT_NE(version, update_response.version());
+  EXPECT_FALSE(Analyze(analyze_request, &analyze_response).ok());
+
+  ZETASQL_EXPECT_OK(UnregisterCatalog(id));
+  EXPECT_FALSE(UpdateCatalog(stale_request, &update_response).ok());
+}
+
 TEST_F(ZetaSqlLocalServiceImplTest, Analyze) {
   const std::string catalog_proto_text = R"pb(
     name: "foo"
@@ -471,6 +762,101 @@ TEST_F(ZetaSqlLocalServiceImplTest, Analyze) {
   EXPECT_EQ(40, response3.resume_byte_position());
 }
 
+TEST_F(ZetaSqlLocalServiceImplTest, AnalyzeCompact) {
+  const std::string catalog_proto_text = R"pb(
+    name: "foo"
+    table {
+      name: "bar"
+      serialization_id: 1
+      column {
+        name: "baz"
+        type { type_kind: TYPE_INT32 }
+        is_pseudo_column: false
+      }
+    })pb";
+
+  SimpleCatalogProto catalog;
+  ZETASQL_CHECK(google::protobuf::TextFormat::ParseFromString(catalog_proto_text, &catalog));
+
+  AnalyzeRequest request;
+  *request.mutable_simple_catalog() = catalog;
+  request.set_sql_statement("select baz from bar;");
+  AnalyzeResponse response;
+  ZETASQL_ASSERT_OK(Analyze(request, &response));
+
+  request.set_compact_resolved_statement(true);
+  AnalyzeResponse compact_response;
+  ZETASQL_ASSERT_OK(Analyze(request, &compact_response));
+  ASSERT_TRUE(compact_response.has_compact_resolved_statement());
+
+  AnyResolvedStatementProto decoded;
+  ZETASQL_ASSERT_OK(DecodeCompactResolvedAstProto(
+      compact_response.compact_resolved_statement(), &decoded));
+  EXPECT_THAT(decoded, EqualsProto(response.resolved_statement()));
+}
+
+TEST_F(ZetaSqlLocalServiceImplTest, AnalyzeScript) {
+  const std::string catalog_proto_text = R"pb(
+    name: "foo"
+    table {
+      name: "bar"
+      serialization_id: 1
+      column {
+        name: "baz"
+        type { type_kind: TYPE_INT32 }
+        is_pseudo_column: false
+      }
+    })pb";
+
+  SimpleCatalogProto catalog;
+  ZETASQL_CHECK(google::protobuf::TextFormat::ParseFromString(catalog_proto_text, &catalog));
+
+  // The chunks split the second statement inside a keyword, and the third
+  // statement has no semicolon.
+  std::vector<AnalyzeScriptRequest> requests(4);
+  *requests[0].mutable_simple_catalog() = catalog;
+  requests[0].set_sql_chunk("select baz from bar; select baz fr");
+  requests[1].set_sql_chunk("om bar;");
+  requests[2].set_sql_chunk("\n");
+  requests[3].set_sql_chunk("select 1");
+
+  std::vector<std::pair<int, AnalyzeResponse>> responses;
+  ZETASQL_ASSERT_OK(AnalyzeScript(requests, &responses));
+  ASSERT_EQ(3, responses.size());
+  // The second statement is complete only when the third one starts, and the
+  // third one only at the end of the stream.
+  EXPECT_EQ(1, responses[0].first);
+  EXPECT_EQ(20, responses[0].second.resume_byte_position());
+  EXPECT_EQ(4, responses[1].first);
+  EXPECT_EQ(41, responses[1].second.resume_byte_position());
+  EXPECT_EQ(4, responses[2].first);
+  EXPECT_EQ(50, responses[2].second.resume_byte_position());
+
+  AnalyzeRequest request;
+  *request.mutable_simple_catalog() = catalog;
+  request.set_sql_statement("select baz from bar;");
+  AnalyzeResponse response;
+  ZETASQL_ASSERT_OK(Analyze(request, &response));
+  EXPECT_THAT(responses[0].second.resolved_statement(),
+              EqualsProto(response.resolved_statement()));
+
+  // Errors end the stream, after the responses for the statements before.
+  requests.resize(1);
+  requests[0].set_sql_chunk("select baz from bar; select qux from bar");
+  responses.clear();
+  EXPECT_FALSE(AnalyzeScript(requests, &responses).ok());
+  EXPECT_EQ(1, responses.size());
+}
+
+TEST_F(ZetaSqlLocalServiceImplTest, AnalyzeScriptWrongCatalogId) {
+  std::vector<AnalyzeScriptRequest> requests(1);
+  requests[0].set_registered_catalog_id(12345);
+  requests[0].set_sql_chunk("select 1");
+  std::vector<std::pair<int, AnalyzeResponse>> responses;
+  EXPECT_FALSE(AnalyzeScript(requests, &responses).ok());
+  EXPECT_TRUE(responses.empty());
+}
+
 TEST_F(ZetaSqlLocalServiceImplTest, GetBuiltinFunctions) {
   ZetaSQLBuiltinFunctionOptionsProto proto;
   GetBuiltinFunctionsResponse response;
@@ -599,6 +985,16 @@ TEST_F(ZetaSqlLocalServiceImplTest, GetBuiltinFunctions) {
   EXPECT_EQ(2, response.function_size());
   EXPECT_EQ(function1.DebugString(), response.function(0).DebugString());
   EXPECT_EQ(function2.DebugString(), response.function(1).DebugString());
+
+  // Repeated calls, which are answered from the cache, give the same
+  // response; other options give theirs.
+  GetBuiltinFunctionsResponse cached_response;
+  ZETASQL_ASSERT_OK(GetBuiltinFunctions(proto, &cached_response));
+  EXPECT_EQ(response.DebugString(), cached_response.DebugString());
+  proto.add_include_function_ids(FN_ABS_DOUBLE);
+  proto.clear_exclude_function_ids();
+  ZETASQL_ASSERT_OK(GetBuiltinFunctions(proto, &cached_response));
+  EXPECT_EQ(4, cached_response.function_size());
 }
 
 }  // namespace local_service
@@ -0,0 +1,221 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/local_service/memory_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "zetasql/base/logging.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "zetasql/base/source_location.h"
+#include "zetasql/base/status_builder.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+namespace local_service {
+
+constexpr int64_t MemoryPool::kNoLimit;
+
+MemoryPool::MemoryPool(std::string name, const Options& options)
+    : name_(std::move(name)),
+      limit_bytes_(options.limit_bytes),
+      parent_(nullptr),
+      root_(this),
+      granularity_bytes_(options.reservation_granularity_bytes),
+      owned_mutex_(absl::make_unique<absl::Mutex>()),
+      mutex_(owned_mutex_.get()) {
+  CHECK_GT(granularity_bytes_, 0);
+}
+
+MemoryPool::MemoryPool(std::string name, int64_t limit_bytes,
+                       MemoryPool* parent)
+    : name_(std::move(name)),
+      limit_bytes_(limit_bytes),
+      parent_(parent),
+      root_(parent->root_),
+      granularity_bytes_(parent->granularity_bytes_),
+      mutex_(parent->mutex_) {
+  absl::MutexLock lock(mutex_);
+  parent_->children_.push_back(this);
+}
+
+MemoryPool::~MemoryPool() {
+  absl::MutexLock lock(mutex_);
+  DCHECK(children_.empty()) << name_;
+  DCHECK(consumers_.empty()) << name_;
+  if (parent_ != nullptr) {
+    std::vector<MemoryPool*>& siblings = parent_->children_;
+    siblings.erase(std::find(siblings.begin(), siblings.end(), this));
+  }
+}
+
+int64_t MemoryPool::reserved_bytes() const {
+  absl::MutexLock lock(mutex_);
+  return reserved_bytes_;
+}
+
+int64_t MemoryPool::peak_reserved_bytes() const {
+  absl::MutexLock lock(mutex_);
+  return peak_reserved_bytes_;
+}
+
+std::string MemoryPool::DebugString() const {
+  absl::MutexLock lock(mutex_);
+  std::string out;
+  AppendDebugString(/*depth=*/0, &out);
+  return out;
+}
+
+void MemoryPool::AppendDebugString(int depth, std::string* out) const {
+  const std::string indent(2 * depth, ' ');
+  absl::StrAppend(out, indent, name_, ": ", reserved_bytes_, " reserved");
+  if (limit_bytes_ != kNoLimit) absl::StrAppend(out, " of ", limit_bytes_);
+  absl::StrAppend(out, ", peak ", peak_reserved_bytes_, "\n");
+  for (const MemoryConsumer* consumer : consumers_) {
+    absl::StrAppend(out, indent, "  ", consumer->name(), ": ",
+                    consumer->used_bytes(), " used\n");
+  }
+  for (const MemoryPool* child : children_) {
+    child->AppendDebugString(depth + 1, out);
+  }
+}
+
+MemoryPool* MemoryPool::TryReserve(int64_t bytes) {
+  for (MemoryPool* pool = this; pool != nullptr; pool = pool->parent_) {
+    if (bytes > pool->limit_bytes_ - pool->reserved_bytes_) return pool;
+  }
+  for (MemoryPool* pool = this; pool != nullptr; pool = pool->parent_) {
+    pool->reserved_bytes_ += bytes;
+    pool->peak_reserved_bytes_ =
+        std::max(pool->peak_reserved_bytes_, pool->reserved_bytes_);
+  }
+  return nullptr;
+}
+
+void MemoryPool::Release(int64_t bytes) {
+  for (MemoryPool* pool = this; pool != nullptr; pool = pool->parent_) {
+    pool->reserved_bytes_ -= bytes;
+  }
+}
+
+void MemoryPool::AppendConsumers(
+    const MemoryPool* excluded, std::vector<MemoryConsumer*>* consumers) const {
+  if (this != excluded) {
+    for (MemoryConsumer* consumer : consumers_) {
+      if (consumer->used_bytes() > 0) consumers->push_back(consumer);
+    }
+  }
+  for (const MemoryPool* child : children_) {
+    child->AppendConsumers(excluded, consumers);
+  }
+}
+
+MemoryConsumer::MemoryConsumer(std::string name, MemoryPool* pool)
+    : name_(std::move(name)), pool_(pool) {
+  absl::MutexLock lock(pool_->mutex_);
+  pool_->consumers_.push_back(this);
+}
+
+MemoryConsumer::~MemoryConsumer() {
+  absl::MutexLock lock(pool_->mutex_);
+  pool_->Release(reserved_bytes_);
+  std::vector<MemoryConsumer*>& consumers = pool_->consumers_;
+  consumers.erase(std::find(consumers.begin(), consumers.end(), this));
+}
+
+zetasql_base::Status MemoryConsumer::SetUsedBytes(int64_t bytes) {
+  DCHECK_GE(bytes, 0);
+  const int64_t granularity = pool_->granularity_bytes_;
+  const int64_t to_reserve =
+      (bytes + granularity - 1) / granularity * granularity;
+  if (to_reserve <= reserved_bytes_) {
+    if (to_reserve < reserved_bytes_) {
+      absl::MutexLock lock(pool_->mutex_);
+      pool_->Release(reserved_bytes_ - to_reserve);
+      reserved_bytes_ = to_reserve;
+    }
+    if (bytes < used_bytes()) spill_requested_ = false;
+    used_bytes_ = bytes;
+    return ::zetasql_base::OkStatus();
+  }
+
+  // Ask the other consumers of the pool to spill until the bytes fit, each
+  // at most once.
+  const int64_t needed = to_reserve - reserved_bytes_;
+  busy_ = true;
+  std::vector<MemoryConsumer*> asked;
+  MemoryPool* full;
+  while (true) {
+    MemoryConsumer* victim = nullptr;
+    {
+      absl::MutexLock lock(pool_->mutex_);
+      full = pool_->TryReserve(needed);
+      if (full == nullptr) {
+        reserved_bytes_ = to_reserve;
+        used_bytes_ = bytes;
+        busy_ = false;
+        return ::zetasql_base::OkStatus();
+      }
+      for (MemoryConsumer* consumer : pool_->consumers_) {
+        if (consumer->busy_ || consumer->used_bytes() == 0 ||
+            !consumer->CanSpill() ||
+            std::find(asked.begin(), asked.end(), consumer) != asked.end()) {
+          continue;
+        }
+        if (victim == nullptr ||
+            consumer->used_bytes() > victim->used_bytes()) {
+          victim = consumer;
+        }
+      }
+    }
+    if (victim == nullptr) break;
+    asked.push_back(victim);
+    victim->busy_ = true;
+    const zetasql_base::Status status = victim->Spill();
+    victim->busy_ = false;
+    if (!status.ok()) {
+      busy_ = false;
+      return status;
+    }
+  }
+  busy_ = false;
+
+  // Ask the largest consumers of other pools under the full one to spill
+  // when they next grow.
+  absl::MutexLock lock(pool_->mutex_);
+  std::vector<MemoryConsumer*> others;
+  full->AppendConsumers(pool_, &others);
+  std::sort(others.begin(), others.end(),
+            [](const MemoryConsumer* a, const MemoryConsumer* b) {
+              return a->used_bytes() > b->used_bytes();
+            });
+  int64_t deficit = full->reserved_bytes_ + needed - full->limit_bytes_;
+  for (MemoryConsumer* consumer : others) {
+    if (deficit <= 0) break;
+    consumer->spill_requested_ = true;
+    deficit -= consumer->used_bytes();
+  }
+  return ::zetasql_base::ResourceExhaustedErrorBuilder(ZETASQL_LOC)
+         << "Cannot reserve " << needed << " more bytes for " << name_
+         << " in memory pool " << pool_->name() << ": memory pool "
+         << full->name() << " has " << full->reserved_bytes_
+         << " of its limit of " << full->limit_bytes_ << " bytes reserved";
+}
+
+}  // namespace local_service
+}  // namespace zetasql
@@ -0,0 +1,196 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_LOCAL_SERVICE_MEMORY_POOL_H_
+#define ZETASQL_LOCAL_SERVICE_MEMORY_POOL_H_
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+namespace local_service {
+
+class MemoryConsumer;
+
+// A node of a tree of memory limits, e.g. a root pool for the process with
+// a child pool for each query, whose MemoryConsumers are its operators. The
+// bytes reserved by a consumer count against its pool and all ancestors, so
+// one query cannot use all the memory of a shared process.
+//
+// When a reservation would exceed the limit of a pool, the other spillable
+// consumers of the same pool as the requester are asked to Spill(), largest
+// first, until it fits. They are called synchronously, on the thread of the
+// requester, so the consumers of one pool must only be used from one thread
+// at a time, as the operators of a query are. Spillable consumers of other
+// pools under the exceeded one are asked asynchronously, through
+// MemoryConsumer::spill_requested(), which they check when they next grow.
+// If the reservation still does not fit it fails with RESOURCE_EXHAUSTED,
+// and the requester spills itself or gives up.
+//
+// Consumers reserve in multiples of Options::reservation_granularity_bytes,
+// so that operators can report their size after every row while the pools,
+// which share one mutex per tree, are only locked once per granule.
+//
+// Example:
+//   MemoryPool::Options pool_options;
+//   pool_options.limit_bytes = int64_t{8} << 30;
+//   MemoryPool process_pool("process", pool_options);
+//   ...
+//   MemoryPool query_pool("query 17", /*limit_bytes=*/int64_t{2} << 30,
+//                         &process_pool);
+//   HashAggregator::Options options;
+//   options.memory_pool = &query_pool;
+//
+// This class is thread-safe.
+class MemoryPool {
+ public:
+  static constexpr int64_t kNoLimit = std::numeric_limits<int64_t>::max();
+
+  struct Options {
+    int64_t limit_bytes = kNoLimit;
+    // Must be positive.
+    int64_t reservation_granularity_bytes = 64 << 10;
+  };
+
+  // Creates a root pool.
+  MemoryPool(std::string name, const Options& options);
+  // Creates a child pool of <parent>, which must outlive it, with the
+  // granularity of its root.
+  MemoryPool(std::string name, int64_t limit_bytes, MemoryPool* parent);
+  MemoryPool(const MemoryPool&) = delete;
+  MemoryPool& operator=(const MemoryPool&) = delete;
+  // All child pools and consumers must have been destroyed.
+  ~MemoryPool();
+
+  const std::string& name() const { return name_; }
+  int64_t limit_bytes() const { return limit_bytes_; }
+
+  // The bytes reserved by the consumers of this pool and its descendants,
+  // and the largest value it has had.
+  int64_t reserved_bytes() const;
+  int64_t peak_reserved_bytes() const;
+
+  // Returns the pools and consumers of this subtree with their reservations,
+  // one per line, for error messages and debugging.
+  std::string DebugString() const;
+
+ private:
+  friend class MemoryConsumer;
+
+  // Reserves <bytes> more in this pool and its ancestors, or returns the
+  // lowest of them whose limit it would exceed without reserving anything.
+  MemoryPool* TryReserve(int64_t bytes) EXCLUSIVE_LOCKS_REQUIRED(*mutex_);
+  void Release(int64_t bytes) EXCLUSIVE_LOCKS_REQUIRED(*mutex_);
+
+  // Appends the consumers of this subtree that use memory, other than those
+  // of <excluded>.
+  void AppendConsumers(const MemoryPool* excluded,
+                       std::vector<MemoryConsumer*>* consumers) const
+      EXCLUSIVE_LOCKS_REQUIRED(*mutex_);
+
+  void AppendDebugString(int depth, std::string* out) const
+      EXCLUSIVE_LOCKS_REQUIRED(*mutex_);
+
+  const std::string name_;
+  const int64_t limit_bytes_;
+  MemoryPool* const parent_;
+  MemoryPool* const root_;
+  const int64_t granularity_bytes_;
+
+  // Only set for the root; children use the mutex of the root.
+  std::unique_ptr<absl::Mutex> owned_mutex_;
+  absl::Mutex* const mutex_;
+
+  std::vector<MemoryPool*> children_ GUARDED_BY(*mutex_);
+  std::vector<MemoryConsumer*> consumers_ GUARDED_BY(*mutex_);
+  int64_t reserved_bytes_ GUARDED_BY(*mutex_) = 0;
+  int64_t peak_reserved_bytes_ GUARDED_BY(*mutex_) = 0;
+};
+
+// The memory of one operator, reserved in a MemoryPool. Operators that can
+// release memory by writing it to disk, like HashAggregator and
+// ExternalSorter, override CanSpill() and Spill(). Others, like the build
+// side of a HashJoin or an ARRAY_AGG accumulating a Value::Array, only
+// report their size, e.g. from Value::physical_byte_size() or the
+// bytes_allocated() of an arena, and fail when it does not fit.
+//
+// This class is thread-compatible, except that spill_requested() and
+// used_bytes() may be called from any thread.
+class MemoryConsumer {
+ public:
+  // <pool> must outlive this consumer.
+  MemoryConsumer(std::string name, MemoryPool* pool);
+  MemoryConsumer(const MemoryConsumer&) = delete;
+  MemoryConsumer& operator=(const MemoryConsumer&) = delete;
+  // Releases the reservation.
+  virtual ~MemoryConsumer();
+
+  const std::string& name() const { return name_; }
+  MemoryPool* pool() const { return pool_; }
+
+  // Sets the bytes used by this consumer, reserving or releasing them in its
+  // pool. Growing may make other consumers of the pool spill. Returns
+  // RESOURCE_EXHAUSTED if the bytes do not fit in the limit of the pool or
+  // an ancestor; the used bytes are then unchanged, and the caller should
+  // spill or fail. Shrinking always succeeds and clears spill_requested().
+  zetasql_base::Status SetUsedBytes(int64_t bytes);
+
+  int64_t used_bytes() const {
+    return used_bytes_.load(std::memory_order_relaxed);
+  }
+
+  // Whether a consumer of another pool asked this one to spill because a
+  // common ancestor is full.
+  bool spill_requested() const {
+    return spill_requested_.load(std::memory_order_relaxed);
+  }
+
+  // Whether Spill() can release memory now.
+  virtual bool CanSpill() const { return false; }
+
+ protected:
+  // Writes data to disk to release memory, calling SetUsedBytes() with the
+  // smaller size. Called by SetUsedBytes() of another consumer of the same
+  // pool, on its thread, while this consumer is not in use.
+  virtual zetasql_base::Status Spill() { return ::zetasql_base::OkStatus(); }
+
+ private:
+  friend class MemoryPool;
+
+  const std::string name_;
+  MemoryPool* const pool_;
+  std::atomic<int64_t> used_bytes_{0};
+  // Only changed by the thread of this consumer, under the mutex of the
+  // pool, so that thread reads it without locking.
+  int64_t reserved_bytes_ = 0;
+  std::atomic<bool> spill_requested_{false};
+  // Whether this consumer is growing or spilling, so that it is not asked
+  // to spill.
+  bool busy_ = false;
+};
+
+}  // namespace local_service
+}  // namespace zetasql
+
+#endif  // ZETASQL_LOCAL_SERVICE_MEMORY_POOL_H_
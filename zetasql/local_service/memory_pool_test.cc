@@ -0,0 +1,145 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/local_service/memory_pool.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+
+namespace zetasql {
+namespace local_service {
+namespace {
+
+using ::testing::HasSubstr;
+using zetasql_base::testing::StatusIs;
+
+// A consumer that releases all its memory when asked to spill.
+class SpillableConsumer : public MemoryConsumer {
+ public:
+  SpillableConsumer(std::string name, MemoryPool* pool)
+      : MemoryConsumer(std::move(name), pool) {}
+
+  bool CanSpill() const override { return true; }
+  int num_spills() const { return num_spills_; }
+
+ protected:
+  zetasql_base::Status Spill() override {
+    ++num_spills_;
+    return SetUsedBytes(0);
+  }
+
+ private:
+  int num_spills_ = 0;
+};
+
+MemoryPool::Options PoolOptions(int64_t limit_bytes) {
+  MemoryPool::Options options;
+  options.limit_bytes = limit_bytes;
+  options.reservation_granularity_bytes = 100;
+  return options;
+}
+
+TEST(MemoryPoolTest, ReservesGranulesInAncestors) {
+  MemoryPool root("root", PoolOptions(1000));
+  MemoryPool query("query", MemoryPool::kNoLimit, &root);
+  {
+    MemoryConsumer consumer("consumer", &query);
+    ZETASQL_EXPECT_OK(consumer.SetUsedBytes(1));
+    EXPECT_EQ(1, consumer.used_bytes());
+    EXPECT_EQ(100, query.reserved_bytes());
+    EXPECT_EQ(100, root.reserved_bytes());
+
+    ZETASQL_EXPECT_OK(consumer.SetUsedBytes(450));
+    EXPECT_EQ(500, root.reserved_bytes());
+    ZETASQL_EXPECT_OK(consumer.SetUsedBytes(120));
+    EXPECT_EQ(200, query.reserved_bytes());
+    EXPECT_EQ(200, root.reserved_bytes());
+    EXPECT_EQ(500, root.peak_reserved_bytes());
+    EXPECT_THAT(root.DebugString(), HasSubstr("consumer: 120 used"));
+  }
+  EXPECT_EQ(0, query.reserved_bytes());
+  EXPECT_EQ(0, root.reserved_bytes());
+}
+
+TEST(MemoryPoolTest, FailsAboveTheLimitOfAnAncestor) {
+  MemoryPool root("root", PoolOptions(1000));
+  MemoryPool query("query", /*limit_bytes=*/5000, &root);
+  MemoryConsumer consumer("consumer", &query);
+  ZETASQL_EXPECT_OK(consumer.SetUsedBytes(1000));
+  EXPECT_THAT(consumer.SetUsedBytes(1001),
+              StatusIs(zetasql_base::StatusCode::kResourceExhausted,
+                       HasSubstr("memory pool root")));
+  EXPECT_EQ(1000, consumer.used_bytes());
+  EXPECT_EQ(1000, query.reserved_bytes());
+}
+
+TEST(MemoryPoolTest, SpillsOtherConsumersOfThePool) {
+  MemoryPool query("query", PoolOptions(1000));
+  SpillableConsumer small("small", &query);
+  SpillableConsumer large("large", &query);
+  MemoryConsumer unspillable("unspillable", &query);
+  ZETASQL_EXPECT_OK(unspillable.SetUsedBytes(300));
+  ZETASQL_EXPECT_OK(small.SetUsedBytes(200));
+  ZETASQL_EXPECT_OK(large.SetUsedBytes(400));
+
+  // Spilling the largest consumer is enough.
+  MemoryConsumer requester("requester", &query);
+  ZETASQL_EXPECT_OK(requester.SetUsedBytes(300));
+  EXPECT_EQ(1, large.num_spills());
+  EXPECT_EQ(0, small.num_spills());
+  EXPECT_EQ(800, query.reserved_bytes());
+
+  // A request that cannot fit even after spilling everything fails.
+  EXPECT_THAT(requester.SetUsedBytes(800),
+              StatusIs(zetasql_base::StatusCode::kResourceExhausted));
+  EXPECT_EQ(1, small.num_spills());
+  EXPECT_EQ(300, requester.used_bytes());
+  EXPECT_EQ(600, query.reserved_bytes());
+}
+
+TEST(MemoryPoolTest, RequestsSpillsInOtherPools) {
+  MemoryPool root("root", PoolOptions(1000));
+  MemoryPool query1("query 1", MemoryPool::kNoLimit, &root);
+  MemoryPool query2("query 2", MemoryPool::kNoLimit, &root);
+  auto other = absl::make_unique<SpillableConsumer>("other", &query1);
+  MemoryConsumer requester("requester", &query2);
+  ZETASQL_EXPECT_OK(other->SetUsedBytes(800));
+
+  // Consumers of other pools are not spilled on this thread, but asked to.
+  EXPECT_THAT(requester.SetUsedBytes(300),
+              StatusIs(zetasql_base::StatusCode::kResourceExhausted));
+  EXPECT_EQ(0, other->num_spills());
+  EXPECT_TRUE(other->spill_requested());
+  EXPECT_FALSE(requester.spill_requested());
+
+  ZETASQL_EXPECT_OK(other->SetUsedBytes(100));
+  EXPECT_FALSE(other->spill_requested());
+  ZETASQL_EXPECT_OK(requester.SetUsedBytes(300));
+  other.reset();
+  EXPECT_EQ(0, query1.reserved_bytes());
+  EXPECT_EQ(300, root.reserved_bytes());
+}
+
+}  // namespace
+}  // namespace local_service
+}  // namespace zetasql
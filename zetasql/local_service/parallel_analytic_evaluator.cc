@@ -0,0 +1,334 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/local_service/parallel_analytic_evaluator.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "zetasql/public/value_hash.h"
+#include "absl/memory/memory.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/source_location.h"
+#include "zetasql/base/status_builder.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+namespace local_service {
+
+namespace {
+
+// Returns one row with the index of a bucket, so that each bucket is a
+// partition of the second pipeline and runs as its own task.
+class BucketIndexIterator : public EvaluatorTableIterator {
+ public:
+  explicit BucketIndexIterator(int bucket) : value_(Value::Int64(bucket)) {}
+
+  int NumColumns() const override { return 1; }
+  std::string GetColumnName(int i) const override { return "bucket"; }
+  const Type* GetColumnType(int i) const override {
+    return types::Int64Type();
+  }
+  bool NextRow() override {
+    if (done_) return false;
+    done_ = true;
+    return true;
+  }
+  const Value& GetValue(int i) const override { return value_; }
+  zetasql_base::Status Status() const override { return ::zetasql_base::OkStatus(); }
+  zetasql_base::Status Cancel() override { return ::zetasql_base::OkStatus(); }
+
+ private:
+  const Value value_;
+  bool done_ = false;
+};
+
+}  // namespace
+
+ParallelAnalyticEvaluator::ParallelAnalyticEvaluator(
+    MorselScheduler* scheduler,
+    std::vector<std::unique_ptr<EvaluatorTableIterator>> inputs,
+    std::vector<SortKey> order_keys, SortKeyEncoder encoder,
+    const Options& options)
+    : scheduler_(scheduler),
+      order_keys_(std::move(order_keys)),
+      encoder_(std::move(encoder)),
+      options_(options),
+      inputs_(std::move(inputs)) {}
+
+ParallelAnalyticEvaluator::~ParallelAnalyticEvaluator() {}
+
+zetasql_base::StatusOr<std::unique_ptr<ParallelAnalyticEvaluator>>
+ParallelAnalyticEvaluator::Create(
+    MorselScheduler* scheduler,
+    std::vector<std::unique_ptr<EvaluatorTableIterator>> inputs,
+    absl::Span<const int> partition_columns, std::vector<SortKey> order_keys,
+    absl::Span<const AnalyticEvaluator::Analytic> analytics,
+    const Options& options) {
+  ZETASQL_RET_CHECK(scheduler != nullptr);
+  ZETASQL_RET_CHECK(!inputs.empty());
+  if (options.sorter_options.memory_pool != nullptr) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "The buckets of a ParallelAnalyticEvaluator cannot share a "
+              "memory pool";
+  }
+  std::vector<const Type*> input_types;
+  std::vector<std::string> input_names;
+  for (int i = 0; i < inputs[0]->NumColumns(); ++i) {
+    input_types.push_back(inputs[0]->GetColumnType(i));
+    input_names.push_back(inputs[0]->GetColumnName(i));
+  }
+  for (const auto& input : inputs) {
+    ZETASQL_RET_CHECK(input != nullptr);
+    bool same_types = input->NumColumns() == input_types.size();
+    for (int i = 0; same_types && i < input_types.size(); ++i) {
+      same_types = input->GetColumnType(i)->Equals(input_types[i]);
+    }
+    if (!same_types) {
+      return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+             << "The inputs of a ParallelAnalyticEvaluator must have the "
+                "same column types";
+    }
+  }
+
+  std::vector<SortKey> sort_keys;
+  for (const int column : partition_columns) {
+    SortKey key;
+    key.column = column;
+    sort_keys.push_back(key);
+  }
+  sort_keys.insert(sort_keys.end(), order_keys.begin(), order_keys.end());
+  ZETASQL_ASSIGN_OR_RETURN(SortKeyEncoder encoder,
+                   SortKeyEncoder::Create(input_types, sort_keys));
+
+  // Checks the analytics and finds their types with an evaluator over no
+  // rows, as each bucket will be evaluated.
+  ZETASQL_ASSIGN_OR_RETURN(
+      std::unique_ptr<ExternalSorter> sorter,
+      ExternalSorter::Create(input_types, sort_keys, options.sorter_options));
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<EvaluatorTableIterator> sorted,
+                   sorter->Finish());
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<AnalyticEvaluator> empty_evaluator,
+                   AnalyticEvaluator::Create(std::move(sorted),
+                                             partition_columns, order_keys,
+                                             analytics));
+
+  auto evaluator = absl::WrapUnique(new ParallelAnalyticEvaluator(
+      scheduler, std::move(inputs), std::move(order_keys), std::move(encoder),
+      options));
+  evaluator->partition_columns_.assign(partition_columns.begin(),
+                                       partition_columns.end());
+  evaluator->analytics_.assign(analytics.begin(), analytics.end());
+  for (int i = 0; i < empty_evaluator->NumColumns(); ++i) {
+    evaluator->column_types_.push_back(empty_evaluator->GetColumnType(i));
+  }
+  evaluator->input_types_ = std::move(input_types);
+  evaluator->input_names_ = std::move(input_names);
+  const int num_buckets = options.num_buckets > 0
+                              ? options.num_buckets
+                              : 4 * scheduler->num_threads();
+  evaluator->buckets_.resize(num_buckets);
+  return evaluator;
+}
+
+std::string ParallelAnalyticEvaluator::GetColumnName(int i) const {
+  return i < input_names_.size() ? input_names_[i] : "";
+}
+
+zetasql_base::Status ParallelAnalyticEvaluator::Cancel() {
+  cancelled_ = true;
+  absl::MutexLock lock(&mutex_);
+  if (query_ != nullptr) query_->Cancel();
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status ParallelAnalyticEvaluator::Evaluate() {
+  const int num_workers = scheduler_->num_threads();
+  worker_buckets_.assign(
+      num_workers, std::vector<ValueBatch>(buckets_.size(),
+                                           ValueBatch(input_types_)));
+  worker_hashes_.resize(num_workers);
+
+  std::vector<MorselPipeline> pipelines(2);
+  pipelines[0].create_partitions =
+      [this]() -> zetasql_base::StatusOr<MorselPipeline::PartitionList> {
+    MorselPipeline::PartitionList partitions = std::move(inputs_);
+    return partitions;
+  };
+  pipelines[0].process_morsel = [this](int worker, const ValueBatch& morsel) {
+    return PartitionMorsel(worker, morsel);
+  };
+  pipelines[1].create_partitions =
+      [this]() -> zetasql_base::StatusOr<MorselPipeline::PartitionList> {
+    MorselPipeline::PartitionList partitions;
+    for (int bucket = 0; bucket < buckets_.size(); ++bucket) {
+      for (const std::vector<ValueBatch>& batches : worker_buckets_) {
+        if (batches[bucket].num_rows() > 0) {
+          partitions.push_back(absl::make_unique<BucketIndexIterator>(bucket));
+          break;
+        }
+      }
+    }
+    return partitions;
+  };
+  pipelines[1].process_morsel =
+      [this](int worker, const ValueBatch& morsel) -> zetasql_base::Status {
+    for (int i = 0; i < morsel.num_rows(); ++i) {
+      ZETASQL_RETURN_IF_ERROR(EvaluateBucket(morsel.column(0).int64_data()[i]));
+    }
+    return ::zetasql_base::OkStatus();
+  };
+  pipelines[1].dependencies = {0};
+
+  std::shared_ptr<MorselQuery> query;
+  {
+    absl::MutexLock lock(&mutex_);
+    if (cancelled_) {
+      return ::zetasql_base::CancelledErrorBuilder(ZETASQL_LOC)
+             << "ParallelAnalyticEvaluator was cancelled";
+    }
+    ZETASQL_ASSIGN_OR_RETURN(query_, scheduler_->Submit(std::move(pipelines),
+                                                options_.priority));
+    query = query_;
+  }
+  const zetasql_base::Status status = query->Wait();
+  worker_buckets_.clear();
+  worker_hashes_.clear();
+  return status;
+}
+
+zetasql_base::Status ParallelAnalyticEvaluator::PartitionMorsel(
+    int worker, const ValueBatch& morsel) {
+  std::vector<uint64_t>* hashes = &worker_hashes_[worker];
+  HashBatchKeys(morsel, partition_columns_, kDefaultKeyHashSeed, hashes);
+  std::vector<ValueBatch>& buckets = worker_buckets_[worker];
+  // Consecutive rows of the same bucket, as in input clustered by the
+  // partitioning columns, are copied at once.
+  int begin = 0;
+  while (begin < morsel.num_rows()) {
+    const int bucket = (*hashes)[begin] % buckets.size();
+    int end = begin + 1;
+    while (end < morsel.num_rows() &&
+           (*hashes)[end] % buckets.size() == bucket) {
+      ++end;
+    }
+    buckets[bucket].AppendRows(morsel, begin, end);
+    begin = end;
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status ParallelAnalyticEvaluator::EvaluateBucket(int bucket) {
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ExternalSorter> sorter,
+                   ExternalSorter::Create(input_types_, encoder_.keys(),
+                                          options_.sorter_options));
+  for (std::vector<ValueBatch>& batches : worker_buckets_) {
+    ValueBatch& batch = batches[bucket];
+    for (int i = 0; i < batch.num_rows(); ++i) {
+      ZETASQL_RETURN_IF_ERROR(sorter->AddRow(batch.GetRow(i)));
+    }
+    // Only the task of this bucket reads it.
+    batch = ValueBatch();
+  }
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<EvaluatorTableIterator> sorted,
+                   sorter->Finish());
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<AnalyticEvaluator> evaluator,
+                   AnalyticEvaluator::Create(std::move(sorted),
+                                             partition_columns_, order_keys_,
+                                             analytics_));
+  std::vector<std::vector<Value>>& output = buckets_[bucket].output;
+  while (evaluator->NextRow()) {
+    if (cancelled_) {
+      return ::zetasql_base::CancelledErrorBuilder(ZETASQL_LOC)
+             << "ParallelAnalyticEvaluator was cancelled";
+    }
+    std::vector<Value> row;
+    row.reserve(evaluator->NumColumns());
+    for (int i = 0; i < evaluator->NumColumns(); ++i) {
+      row.push_back(evaluator->GetValue(i));
+    }
+    output.push_back(std::move(row));
+  }
+  ZETASQL_RETURN_IF_ERROR(evaluator->Status());
+  num_partitions_ += evaluator->num_partitions();
+  return ::zetasql_base::OkStatus();
+}
+
+bool ParallelAnalyticEvaluator::NextRow() {
+  if (!status_.ok()) return false;
+  if (cancelled_) {
+    status_ = ::zetasql_base::CancelledErrorBuilder(ZETASQL_LOC)
+              << "ParallelAnalyticEvaluator was cancelled";
+    return false;
+  }
+  if (!evaluated_) {
+    evaluated_ = true;
+    status_ = Evaluate();
+    if (!status_.ok()) return false;
+    if (options_.ordered_output) {
+      for (int i = 0; i < buckets_.size(); ++i) {
+        if (buckets_[i].output.empty()) continue;
+        encoder_.Encode(buckets_[i].output[0], &buckets_[i].key);
+        heap_.push_back(i);
+      }
+    }
+  }
+  return options_.ordered_output ? NextOrderedRow() : NextBucketRow();
+}
+
+bool ParallelAnalyticEvaluator::NextBucketRow() {
+  ++current_row_;
+  while (current_bucket_ < buckets_.size() &&
+         current_row_ >= buckets_[current_bucket_].output.size()) {
+    // Frees each bucket once its rows have been returned.
+    std::vector<std::vector<Value>>().swap(buckets_[current_bucket_].output);
+    ++current_bucket_;
+    current_row_ = 0;
+  }
+  return current_bucket_ < buckets_.size();
+}
+
+bool ParallelAnalyticEvaluator::NextOrderedRow() {
+  // The smallest key on top. A window partition is in only one bucket, so
+  // keys of different buckets are never equal, but ties are still broken
+  // deterministically.
+  const auto greater = [this](int a, int b) {
+    const int compare = buckets_[a].key.compare(buckets_[b].key);
+    return compare != 0 ? compare > 0 : a > b;
+  };
+  // Puts the bucket of the current row back into the heap if it has more.
+  if (current_row_ >= 0) {
+    Bucket& bucket = buckets_[current_bucket_];
+    if (++bucket.next_row < bucket.output.size()) {
+      encoder_.Encode(bucket.output[bucket.next_row], &bucket.key);
+      heap_.push_back(current_bucket_);
+      std::push_heap(heap_.begin(), heap_.end(), greater);
+    } else {
+      std::vector<std::vector<Value>>().swap(bucket.output);
+    }
+  } else {
+    std::make_heap(heap_.begin(), heap_.end(), greater);
+  }
+  if (heap_.empty()) return false;
+  std::pop_heap(heap_.begin(), heap_.end(), greater);
+  current_bucket_ = heap_.back();
+  heap_.pop_back();
+  current_row_ = buckets_[current_bucket_].next_row;
+  return true;
+}
+
+}  // namespace local_service
+}  // namespace zetasql
@@ -0,0 +1,190 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_LOCAL_SERVICE_PARALLEL_ANALYTIC_EVALUATOR_H_
+#define ZETASQL_LOCAL_SERVICE_PARALLEL_ANALYTIC_EVALUATOR_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/local_service/analytic_evaluator.h"
+#include "zetasql/local_service/external_sorter.h"
+#include "zetasql/local_service/sort_key_encoder.h"
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/morsel_scheduler.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/public/value_batch.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "zetasql/base/status.h"
+#include "zetasql/base/statusor.h"
+
+namespace zetasql {
+namespace local_service {
+
+// Computes the same analytic functions as AnalyticEvaluator, over unsorted
+// input, on the workers of a MorselScheduler.
+//
+// The rows of the input partitions are hash-partitioned by the values of
+// the partitioning columns into Options::num_buckets buckets, in one
+// pipeline whose workers each keep their own buckets. Since all rows of a
+// window partition are in the same bucket, a second pipeline then sorts
+// each bucket with an ExternalSorter and evaluates it with an
+// AnalyticEvaluator, one bucket per task, so that different buckets are
+// sorted and evaluated on different workers. Without partitioning columns
+// there is only one window partition, and the evaluation is not parallel.
+//
+// The output rows of each bucket are sorted by the partitioning columns and
+// then by the ordering keys. With Options::ordered_output, the buckets are
+// merged in that order, which is the order of the output of an
+// AnalyticEvaluator over the input sorted by AppendAnalyticGroupKeys().
+// Otherwise they are returned one bucket after another, which is cheaper.
+//
+// All rows are evaluated on the first call to NextRow(), which waits for the
+// query on the scheduler, and each bucket is kept in memory until its rows
+// have been returned. It must not be read from a callback running on
+// the same scheduler.
+//
+// Example:
+//   std::vector<std::unique_ptr<EvaluatorTableIterator>> inputs;
+//   ZETASQL_ASSIGN_OR_RETURN(inputs,
+//                    table->CreatePartitionedIterators(column_idxs, 0));
+//   ZETASQL_ASSIGN_OR_RETURN(
+//       std::unique_ptr<ParallelAnalyticEvaluator> evaluator,
+//       ParallelAnalyticEvaluator::Create(
+//           &scheduler, std::move(inputs), /*partition_columns=*/{0},
+//           std::move(order_keys), {analytic},
+//           ParallelAnalyticEvaluator::Options()));
+//
+// This class is not thread-safe, except for Cancel().
+class ParallelAnalyticEvaluator : public EvaluatorTableIterator {
+ public:
+  struct Options {
+    // The number of hash partitions of the input. Zero means four per
+    // worker of the scheduler, so that workers finishing small buckets
+    // early can take others.
+    int num_buckets = 0;
+    // Whether to return the rows in the order of the partitioning columns
+    // and then the ordering keys.
+    bool ordered_output = false;
+    // For the sorter of each bucket. The memory budget applies to each
+    // bucket separately. Must not have a memory_pool, since the buckets are
+    // sorted on different threads at once.
+    ExternalSorter::Options sorter_options;
+    // The priority of the query on the scheduler.
+    int priority = 0;
+  };
+
+  ParallelAnalyticEvaluator(const ParallelAnalyticEvaluator&) = delete;
+  ParallelAnalyticEvaluator& operator=(const ParallelAnalyticEvaluator&) =
+      delete;
+  ~ParallelAnalyticEvaluator() override;
+
+  // Returns an iterator over the rows of <inputs> with the values of
+  // <analytics> appended, as AnalyticEvaluator::Create() does for sorted
+  // input. <inputs> must be non-empty and have the same columns, e.g. the
+  // partitions from Table::CreatePartitionedIterators(), and must not have
+  // been read yet. <scheduler> must outlive the evaluator.
+  static zetasql_base::StatusOr<std::unique_ptr<ParallelAnalyticEvaluator>> Create(
+      MorselScheduler* scheduler,
+      std::vector<std::unique_ptr<EvaluatorTableIterator>> inputs,
+      absl::Span<const int> partition_columns,
+      std::vector<SortKey> order_keys,
+      absl::Span<const AnalyticEvaluator::Analytic> analytics,
+      const Options& options);
+
+  int NumColumns() const override { return column_types_.size(); }
+  std::string GetColumnName(int i) const override;
+  const Type* GetColumnType(int i) const override { return column_types_[i]; }
+  bool NextRow() override;
+  const Value& GetValue(int i) const override {
+    return buckets_[current_bucket_].output[current_row_][i];
+  }
+  zetasql_base::Status Status() const override { return status_; }
+  zetasql_base::Status Cancel() override;
+
+  int num_buckets() const { return buckets_.size(); }
+  // The number of window partitions, once all rows have been evaluated.
+  int64_t num_partitions() const { return num_partitions_; }
+
+ private:
+  struct Bucket {
+    // The output rows, with the analytic values.
+    std::vector<std::vector<Value>> output;
+    // With Options::ordered_output, the sort key of output[next_row].
+    std::string key;
+    int64_t next_row = 0;
+  };
+
+  ParallelAnalyticEvaluator(
+      MorselScheduler* scheduler,
+      std::vector<std::unique_ptr<EvaluatorTableIterator>> inputs,
+      std::vector<SortKey> order_keys, SortKeyEncoder encoder,
+      const Options& options);
+
+  // Runs both pipelines on the scheduler and waits for them.
+  zetasql_base::Status Evaluate();
+  // Appends the rows of <morsel> to the buckets of <worker>.
+  zetasql_base::Status PartitionMorsel(int worker, const ValueBatch& morsel);
+  // Sorts and evaluates the rows of bucket <bucket> of all workers.
+  zetasql_base::Status EvaluateBucket(int bucket);
+
+  // Moves to the next output row of the buckets in order, or with
+  // Options::ordered_output of the bucket with the smallest key.
+  bool NextBucketRow();
+  bool NextOrderedRow();
+
+  MorselScheduler* const scheduler_;
+  const std::vector<SortKey> order_keys_;
+  // Of the partitioning columns and then the ordering keys.
+  const SortKeyEncoder encoder_;
+  const Options options_;
+  std::vector<int> partition_columns_;
+  std::vector<AnalyticEvaluator::Analytic> analytics_;
+  std::vector<const Type*> input_types_;
+  std::vector<std::string> input_names_;
+  std::vector<const Type*> column_types_;
+
+  // Read by the first pipeline, which takes them.
+  std::vector<std::unique_ptr<EvaluatorTableIterator>> inputs_;
+  // The input rows of each bucket of each worker, indexed by worker and
+  // then by bucket, and the hashes of the current morsel of each worker.
+  std::vector<std::vector<ValueBatch>> worker_buckets_;
+  std::vector<std::vector<uint64_t>> worker_hashes_;
+  std::vector<Bucket> buckets_;
+  std::atomic<int64_t> num_partitions_{0};
+
+  bool evaluated_ = false;
+  // With Options::ordered_output, the buckets that have rows left, as a
+  // heap ordered by their keys.
+  std::vector<int> heap_;
+  int current_bucket_ = 0;
+  int64_t current_row_ = -1;
+
+  zetasql_base::Status status_;
+  std::atomic<bool> cancelled_{false};
+  absl::Mutex mutex_;
+  std::shared_ptr<MorselQuery> query_ GUARDED_BY(mutex_);
+};
+
+}  // namespace local_service
+}  // namespace zetasql
+
+#endif  // ZETASQL_LOCAL_SERVICE_PARALLEL_ANALYTIC_EVALUATOR_H_
@@ -0,0 +1,267 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/local_service/parallel_analytic_evaluator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/local_service/memory_pool.h"
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/morsel_scheduler.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+
+namespace zetasql {
+namespace local_service {
+
+using zetasql_base::testing::StatusIs;
+
+typedef AnalyticEvaluator::Analytic Analytic;
+
+// Returns <rows>, which have <types>.
+class RowIterator : public EvaluatorTableIterator {
+ public:
+  RowIterator(std::vector<const Type*> types,
+              std::vector<std::vector<Value>> rows)
+      : types_(std::move(types)), rows_(std::move(rows)) {}
+
+  int NumColumns() const override { return types_.size(); }
+  std::string GetColumnName(int i) const override {
+    return i == 0 ? "user_id" : "value";
+  }
+  const Type* GetColumnType(int i) const override { return types_[i]; }
+  bool NextRow() override { return ++row_ < rows_.size(); }
+  const Value& GetValue(int i) const override { return rows_[row_][i]; }
+  zetasql_base::Status Status() const override { return zetasql_base::OkStatus(); }
+  zetasql_base::Status Cancel() override { return zetasql_base::OkStatus(); }
+
+ private:
+  std::vector<const Type*> types_;
+  std::vector<std::vector<Value>> rows_;
+  int row_ = -1;
+};
+
+class ParallelAnalyticEvaluatorTest : public ::testing::Test {
+ protected:
+  ParallelAnalyticEvaluatorTest()
+      : types_({types::Int64Type(), types::Int64Type()}) {
+    // Rows are (user_id, value) with unique values, so that the order
+    // within a partition is total. User 3 is NULL, which is a partition too.
+    for (int64_t i = 0; i < 2000; ++i) {
+      const int64_t user = (i * 7919) % 101;
+      rows_.push_back({user == 3 ? Value::NullInt64() : Value::Int64(user),
+                       Value::Int64((i * 104729) % 2003)});
+    }
+    // SUM(value) OVER (PARTITION BY user_id ORDER BY value
+    //                  ROWS BETWEEN 2 PRECEDING AND CURRENT ROW)
+    Analytic sum;
+    sum.function = AnalyticEvaluator::kSum;
+    sum.argument = 1;
+    sum.frame.unit = ResolvedWindowFrame::ROWS;
+    sum.frame.start = {ResolvedWindowFrameExpr::OFFSET_PRECEDING,
+                       Value::Int64(2)};
+    // COUNT(*) OVER (PARTITION BY user_id)
+    Analytic count;
+    count.function = AnalyticEvaluator::kCountStar;
+    count.frame.end = {ResolvedWindowFrameExpr::UNBOUNDED_FOLLOWING, Value()};
+    analytics_ = {sum, count};
+    SortKey value_key;
+    value_key.column = 1;
+    order_keys_ = {value_key};
+  }
+
+  // Returns the rows split round-robin into <num_inputs> inputs.
+  std::vector<std::unique_ptr<EvaluatorTableIterator>> Inputs(
+      int num_inputs) const {
+    std::vector<std::vector<std::vector<Value>>> rows(num_inputs);
+    for (int i = 0; i < rows_.size(); ++i) {
+      rows[i % num_inputs].push_back(rows_[i]);
+    }
+    std::vector<std::unique_ptr<EvaluatorTableIterator>> inputs;
+    for (auto& input_rows : rows) {
+      inputs.push_back(
+          absl::make_unique<RowIterator>(types_, std::move(input_rows)));
+    }
+    return inputs;
+  }
+
+  // Returns the output of an AnalyticEvaluator over the sorted rows.
+  std::vector<std::vector<Value>> Expected() const {
+    std::vector<std::vector<Value>> sorted = rows_;
+    std::sort(sorted.begin(), sorted.end(),
+              [](const std::vector<Value>& a, const std::vector<Value>& b) {
+                if (!a[0].Equals(b[0])) return a[0].LessThan(b[0]);
+                return a[1].LessThan(b[1]);
+              });
+    std::unique_ptr<AnalyticEvaluator> evaluator =
+        AnalyticEvaluator::Create(
+            absl::make_unique<RowIterator>(types_, std::move(sorted)),
+            /*partition_columns=*/{0}, order_keys_, analytics_)
+            .ValueOrDie();
+    return ReadRows(evaluator.get());
+  }
+
+  static std::vector<std::vector<Value>> ReadRows(
+      EvaluatorTableIterator* iterator) {
+    std::vector<std::vector<Value>> rows;
+    while (iterator->NextRow()) {
+      std::vector<Value> row;
+      for (int i = 0; i < iterator->NumColumns(); ++i) {
+        row.push_back(iterator->GetValue(i));
+      }
+      rows.push_back(std::move(row));
+    }
+    ZETASQL_EXPECT_OK(iterator->Status());
+    return rows;
+  }
+
+  const std::vector<const Type*> types_;
+  std::vector<std::vector<Value>> rows_;
+  std::vector<Analytic> analytics_;
+  std::vector<SortKey> order_keys_;
+};
+
+TEST_F(ParallelAnalyticEvaluatorTest, OrderedOutputMatchesSequential) {
+  MorselScheduler::Options scheduler_options;
+  scheduler_options.num_threads = 4;
+  scheduler_options.morsel_rows = 64;
+  MorselScheduler scheduler(scheduler_options);
+  ParallelAnalyticEvaluator::Options options;
+  options.num_buckets = 7;
+  options.ordered_output = true;
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<ParallelAnalyticEvaluator> evaluator,
+      ParallelAnalyticEvaluator::Create(&scheduler, Inputs(3),
+                                        /*partition_columns=*/{0},
+                                        order_keys_, analytics_, options));
+  ASSERT_EQ(4, evaluator->NumColumns());
+  EXPECT_EQ("user_id", evaluator->GetColumnName(0));
+  EXPECT_EQ("", evaluator->GetColumnName(2));
+  EXPECT_TRUE(evaluator->GetColumnType(3)->IsInt64());
+
+  EXPECT_EQ(Expected(), ReadRows(evaluator.get()));
+  EXPECT_EQ(7, evaluator->num_buckets());
+  EXPECT_EQ(101, evaluator->num_partitions());
+}
+
+TEST_F(ParallelAnalyticEvaluatorTest, UnorderedOutputHasTheSameRows) {
+  MorselScheduler::Options scheduler_options;
+  scheduler_options.num_threads = 3;
+  scheduler_options.morsel_rows = 100;
+  MorselScheduler scheduler(scheduler_options);
+  // A small sort budget spills the buckets.
+  ParallelAnalyticEvaluator::Options options;
+  options.sorter_options.memory_budget_bytes = 4096;
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<ParallelAnalyticEvaluator> evaluator,
+      ParallelAnalyticEvaluator::Create(&scheduler, Inputs(5),
+                                        /*partition_columns=*/{0},
+                                        order_keys_, analytics_, options));
+  std::vector<std::vector<Value>> rows = ReadRows(evaluator.get());
+  EXPECT_EQ(12, evaluator->num_buckets());
+
+  // Each window partition is returned in order and in one piece.
+  std::vector<std::vector<Value>> expected = Expected();
+  ASSERT_EQ(expected.size(), rows.size());
+  std::set<std::string> finished_users;
+  for (int i = 1; i < rows.size(); ++i) {
+    if (rows[i][0].Equals(rows[i - 1][0])) {
+      EXPECT_TRUE(rows[i - 1][1].LessThan(rows[i][1])) << i;
+    } else {
+      finished_users.insert(rows[i - 1][0].DebugString());
+      EXPECT_EQ(0, finished_users.count(rows[i][0].DebugString())) << i;
+    }
+  }
+  const auto less = [](const std::vector<Value>& a,
+                       const std::vector<Value>& b) {
+    return a[1].LessThan(b[1]);
+  };
+  std::sort(rows.begin(), rows.end(), less);
+  std::sort(expected.begin(), expected.end(), less);
+  EXPECT_EQ(expected, rows);
+}
+
+TEST_F(ParallelAnalyticEvaluatorTest, WithoutPartitioningColumns) {
+  MorselScheduler::Options scheduler_options;
+  scheduler_options.num_threads = 2;
+  MorselScheduler scheduler(scheduler_options);
+  // COUNT(*) OVER ()
+  Analytic count;
+  count.function = AnalyticEvaluator::kCountStar;
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<ParallelAnalyticEvaluator> evaluator,
+      ParallelAnalyticEvaluator::Create(
+          &scheduler, Inputs(2), /*partition_columns=*/{},
+          /*order_keys=*/{}, {count}, ParallelAnalyticEvaluator::Options()));
+  std::vector<std::vector<Value>> rows = ReadRows(evaluator.get());
+  ASSERT_EQ(rows_.size(), rows.size());
+  for (const std::vector<Value>& row : rows) {
+    EXPECT_EQ(Value::Int64(rows_.size()), row[2]);
+  }
+  EXPECT_EQ(1, evaluator->num_partitions());
+}
+
+TEST_F(ParallelAnalyticEvaluatorTest, Errors) {
+  MorselScheduler scheduler;
+  ParallelAnalyticEvaluator::Options options;
+  MemoryPool pool("pool", MemoryPool::Options());
+  options.sorter_options.memory_pool = &pool;
+  EXPECT_THAT(ParallelAnalyticEvaluator::Create(&scheduler, Inputs(2), {0},
+                                                order_keys_, analytics_,
+                                                options)
+                  .status(),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+
+  options.sorter_options.memory_pool = nullptr;
+  std::vector<std::unique_ptr<EvaluatorTableIterator>> inputs = Inputs(1);
+  inputs.push_back(absl::make_unique<RowIterator>(
+      std::vector<const Type*>{types::Int64Type(), types::StringType()},
+      std::vector<std::vector<Value>>()));
+  EXPECT_THAT(ParallelAnalyticEvaluator::Create(&scheduler, std::move(inputs),
+                                                {0}, order_keys_, analytics_,
+                                                options)
+                  .status(),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+
+  EXPECT_THAT(ParallelAnalyticEvaluator::Create(&scheduler, Inputs(1), {2},
+                                                order_keys_, analytics_,
+                                                options)
+                  .status(),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+
+  // Cancelled before the first row.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<ParallelAnalyticEvaluator> evaluator,
+      ParallelAnalyticEvaluator::Create(&scheduler, Inputs(2), {0},
+                                        order_keys_, analytics_, options));
+  ZETASQL_EXPECT_OK(evaluator->Cancel());
+  EXPECT_FALSE(evaluator->NextRow());
+  EXPECT_THAT(evaluator->Status(),
+              StatusIs(zetasql_base::StatusCode::kCancelled));
+}
+
+}  // namespace local_service
+}  // namespace zetasql
@@ -0,0 +1,103 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "zetasql/local_service/sort_key_encoder.h"
+
+#include <string>
+#include <utility>
+
+#include "zetasql/public/normalized_key.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/source_location.h"
+#include "zetasql/base/status_builder.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+namespace local_service {
+
+namespace {
+
+// Returns the index of <column> in <columns>.
+zetasql_base::StatusOr<int> ColumnIndex(const ResolvedColumn& column,
+                                const ResolvedColumnList& columns) {
+  for (int i = 0; i < columns.size(); ++i) {
+    if (columns[i] == column) return i;
+  }
+  return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+         << "Sort column " << column.DebugString()
+         << " is not a column of the input";
+}
+
+}  // namespace
+
+zetasql_base::Status AppendOrderByKeys(
+    absl::Span<const std::unique_ptr<const ResolvedOrderByItem>> items,
+    const ResolvedColumnList& columns, std::vector<SortKey>* keys) {
+  for (const auto& item : items) {
+    SortKey key;
+    ZETASQL_ASSIGN_OR_RETURN(key.column,
+                     ColumnIndex(item->column_ref()->column(), columns));
+    key.descending = item->is_descending();
+    keys->push_back(key);
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status AppendAnalyticGroupKeys(const ResolvedAnalyticFunctionGroup* group,
+                                     const ResolvedColumnList& columns,
+                                     std::vector<SortKey>* keys) {
+  ZETASQL_RET_CHECK(group != nullptr);
+  if (group->partition_by() != nullptr) {
+    for (const auto& column_ref : group->partition_by()->partition_by_list()) {
+      SortKey key;
+      ZETASQL_ASSIGN_OR_RETURN(key.column, ColumnIndex(column_ref->column(), columns));
+      keys->push_back(key);
+    }
+  }
+  if (group->order_by() != nullptr) {
+    ZETASQL_RETURN_IF_ERROR(AppendOrderByKeys(group->order_by()->order_by_item_list(),
+                                      columns, keys));
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::StatusOr<SortKeyEncoder> SortKeyEncoder::Create(
+    absl::Span<const Type* const> column_types, std::vector<SortKey> keys) {
+  for (const SortKey& key : keys) {
+    if (key.column < 0 || key.column >= column_types.size()) {
+      return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+             << "Sort key column " << key.column << " is out of range";
+    }
+    const Type* type = column_types[key.column];
+    if (!SupportsNormalizedKey(type)) {
+      return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+             << "Cannot sort by a column of type " << type->DebugString();
+    }
+  }
+  return SortKeyEncoder(std::move(keys));
+}
+
+void SortKeyEncoder::Encode(absl::Span<const Value> row,
+                            std::string* key) const {
+  key->clear();
+  for (const SortKey& sort_key : keys_) {
+    AppendNormalizedKey(row[sort_key.column], sort_key.descending, key);
+  }
+}
+
+}  // namespace local_service
+}  // namespace zetasql
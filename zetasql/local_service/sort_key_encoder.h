@@ -0,0 +1,82 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef ZETASQL_LOCAL_SERVICE_SORT_KEY_ENCODER_H_
+#define ZETASQL_LOCAL_SERVICE_SORT_KEY_ENCODER_H_
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "absl/types/span.h"
+#include "zetasql/base/status.h"
+#include "zetasql/base/statusor.h"
+
+namespace zetasql {
+namespace local_service {
+
+// One column of a sort order, as an index in the sorted rows.
+struct SortKey {
+  int column = 0;
+  bool descending = false;
+};
+
+// Appends the sort keys of <items> to <keys>. Each item must order by a
+// column in <columns>, and its key indexes that column.
+zetasql_base::Status AppendOrderByKeys(
+    absl::Span<const std::unique_ptr<const ResolvedOrderByItem>> items,
+    const ResolvedColumnList& columns, std::vector<SortKey>* keys);
+
+// Appends the keys that sort the input rows of <group> by its partitioning
+// and then its ordering, as needed to compute its analytic functions.
+zetasql_base::Status AppendAnalyticGroupKeys(const ResolvedAnalyticFunctionGroup* group,
+                                     const ResolvedColumnList& columns,
+                                     std::vector<SortKey>* keys);
+
+// Encodes the sort keys of rows as normalized keys (see
+// zetasql/public/normalized_key.h): strings whose bytewise order is the order
+// of the rows. Keys can be compared with memcmp semantics
+// (std::string::compare), which is much cheaper than comparing Values.
+//
+// Supported types are those with SupportsNormalizedKey().
+class SortKeyEncoder {
+ public:
+  // Returns kInvalidArgument if a key column is out of range of
+  // <column_types> or has an unsupported type.
+  static zetasql_base::StatusOr<SortKeyEncoder> Create(
+      absl::Span<const Type* const> column_types, std::vector<SortKey> keys);
+
+  // Sets <*key> to the normalized key of <row>, which has the column types.
+  void Encode(absl::Span<const Value> row, std::string* key) const;
+
+  const std::vector<SortKey>& keys() const { return keys_; }
+
+ private:
+  explicit SortKeyEncoder(std::vector<SortKey> keys)
+      : keys_(std::move(keys)) {}
+
+  std::vector<SortKey> keys_;
+};
+
+}  // namespace local_service
+}  // namespace zetasql
+
+#endif  // ZETASQL_LOCAL_SERVICE_SORT_KEY_ENCODER_H_
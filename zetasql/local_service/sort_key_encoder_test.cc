@@ -0,0 +1,140 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "zetasql/local_service/sort_key_encoder.h"
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/numeric_value.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace zetasql {
+namespace local_service {
+
+using zetasql_base::testing::StatusIs;
+
+// Returns the normalized key of <value> as a single ascending or descending
+// key.
+std::string EncodeOne(const Value& value, bool descending = false) {
+  SortKey key;
+  key.descending = descending;
+  zetasql_base::StatusOr<SortKeyEncoder> encoder =
+      SortKeyEncoder::Create({value.type()}, {key});
+  ZETASQL_CHECK_OK(encoder.status());
+  std::string encoded;
+  encoder.ValueOrDie().Encode({value}, &encoded);
+  return encoded;
+}
+
+// Expects the keys of <values>, which are in strictly increasing order, to
+// be in the same order, and in reverse order when descending.
+void ExpectOrdered(const std::vector<Value>& values) {
+  for (int i = 0; i + 1 < values.size(); ++i) {
+    ASSERT_TRUE(values[i].LessThan(values[i + 1]))
+        << values[i].DebugString() << " " << values[i + 1].DebugString();
+    EXPECT_LT(EncodeOne(values[i]), EncodeOne(values[i + 1]))
+        << values[i].DebugString() << " " << values[i + 1].DebugString();
+    EXPECT_GT(EncodeOne(values[i], /*descending=*/true),
+              EncodeOne(values[i + 1], /*descending=*/true))
+        << values[i].DebugString() << " " << values[i + 1].DebugString();
+  }
+}
+
+TEST(SortKeyEncoderTest, Int64) {
+  ExpectOrdered({Value::NullInt64(),
+                 Value::Int64(std::numeric_limits<int64_t>::min()),
+                 Value::Int64(-1), Value::Int64(0), Value::Int64(1),
+                 Value::Int64(std::numeric_limits<int64_t>::max())});
+}
+
+TEST(SortKeyEncoderTest, Uint64) {
+  ExpectOrdered({Value::NullUint64(), Value::Uint64(0), Value::Uint64(1),
+                 Value::Uint64(std::numeric_limits<uint64_t>::max())});
+}
+
+TEST(SortKeyEncoderTest, Double) {
+  const double inf = std::numeric_limits<double>::infinity();
+  ExpectOrdered({Value::NullDouble(), Value::Double(std::nan("")),
+                 Value::Double(-inf), Value::Double(-1.5), Value::Double(0),
+                 Value::Double(1e-300), Value::Double(2), Value::Double(inf)});
+  EXPECT_EQ(EncodeOne(Value::Double(0)), EncodeOne(Value::Double(-0.0)));
+}
+
+TEST(SortKeyEncoderTest, Numeric) {
+  ExpectOrdered({Value::NullNumeric(),
+                 Value::Numeric(NumericValue::MinValue()),
+                 Value::Numeric(NumericValue(-1)), Value::Numeric(NumericValue()),
+                 Value::Numeric(NumericValue(1)),
+                 Value::Numeric(NumericValue::MaxValue())});
+}
+
+TEST(SortKeyEncoderTest, String) {
+  ExpectOrdered({Value::NullString(), Value::String(""), Value::String("a"),
+                 Value::String(std::string("a\0", 2)),
+                 Value::String(std::string("a\0b", 3)), Value::String("a\x01"),
+                 Value::String("ab"), Value::String("b")});
+}
+
+TEST(SortKeyEncoderTest, TimeTypes) {
+  ExpectOrdered({Value::NullDate(), Value::Date(-10), Value::Date(0),
+                 Value::Date(10)});
+  ExpectOrdered({Value::NullTimestamp(),
+                 Value::TimestampFromUnixMicros(-1000001),
+                 Value::TimestampFromUnixMicros(-1),
+                 Value::TimestampFromUnixMicros(0),
+                 Value::TimestampFromUnixMicros(1)});
+}
+
+TEST(SortKeyEncoderTest, MultipleKeys) {
+  SortKey first;
+  first.column = 1;
+  SortKey second;
+  second.column = 0;
+  second.descending = true;
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      SortKeyEncoder encoder,
+      SortKeyEncoder::Create({types::Int64Type(), types::StringType()},
+                             {first, second}));
+  std::string a, b, c;
+  encoder.Encode({Value::Int64(1), Value::String("x")}, &a);
+  encoder.Encode({Value::Int64(2), Value::String("xy")}, &b);
+  encoder.Encode({Value::Int64(3), Value::String("xy")}, &c);
+  // The string keys must not run into the integer keys that follow them.
+  EXPECT_LT(a, c);
+  EXPECT_LT(c, b);
+}
+
+TEST(SortKeyEncoderTest, Errors) {
+  SortKey key;
+  key.column = 1;
+  EXPECT_THAT(SortKeyEncoder::Create({types::Int64Type()}, {key}).status(),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+  key.column = 0;
+  EXPECT_THAT(
+      SortKeyEncoder::Create({types::Int64ArrayType()}, {key}).status(),
+      StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+}
+
+}  // namespace local_service
+}  // namespace zetasql
@@ -0,0 +1,165 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "zetasql/local_service/spill_file.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "zetasql/public/value.pb.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "zetasql/base/source_location.h"
+#include "zetasql/base/status_builder.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+namespace local_service {
+
+// Spill files are read and written sequentially, so they get large buffers.
+static constexpr size_t kBufferSize = 1 << 20;
+
+SpillFile::~SpillFile() { fclose(file_); }
+
+zetasql_base::StatusOr<std::unique_ptr<SpillFile>> SpillFile::Create(
+    const std::string& directory) {
+  FILE* file;
+  if (directory.empty()) {
+    file = tmpfile();
+    if (file == nullptr) {
+      return ::zetasql_base::InternalErrorBuilder(ZETASQL_LOC)
+             << "Cannot create a spill file: " << strerror(errno);
+    }
+  } else {
+    std::string path = absl::StrCat(directory, "/zetasql_spill_XXXXXX");
+    const int fd = mkstemp(&path[0]);
+    if (fd < 0) {
+      return ::zetasql_base::InternalErrorBuilder(ZETASQL_LOC)
+             << "Cannot create a spill file in " << directory << ": "
+             << strerror(errno);
+    }
+    unlink(path.c_str());
+    file = fdopen(fd, "w+b");
+    if (file == nullptr) {
+      close(fd);
+      return ::zetasql_base::InternalErrorBuilder(ZETASQL_LOC)
+             << "Cannot open spill file " << path << ": " << strerror(errno);
+    }
+  }
+  setvbuf(file, nullptr, _IOFBF, kBufferSize);
+  return absl::WrapUnique(new SpillFile(file));
+}
+
+zetasql_base::Status SpillFile::Write(const void* data, size_t size) {
+  if (fwrite(data, 1, size, file_) != size) {
+    return ::zetasql_base::InternalErrorBuilder(ZETASQL_LOC)
+           << "Cannot write to spill file: " << strerror(errno);
+  }
+  bytes_written_ += size;
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status SpillFile::WriteString(absl::string_view bytes) {
+  const uint32_t size = bytes.size();
+  ZETASQL_RETURN_IF_ERROR(Write(&size, sizeof(size)));
+  return Write(bytes.data(), size);
+}
+
+zetasql_base::Status SpillFile::WriteValues(absl::Span<const Value> values) {
+  ValueProto proto;
+  for (const Value& value : values) {
+    ZETASQL_RETURN_IF_ERROR(value.Serialize(&proto));
+    if (!proto.SerializeToString(&buffer_)) {
+      return ::zetasql_base::InternalErrorBuilder(ZETASQL_LOC)
+             << "Cannot serialize " << value.type()->DebugString();
+    }
+    ZETASQL_RETURN_IF_ERROR(WriteString(buffer_));
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status SpillFile::Rewind() {
+  if (fflush(file_) != 0 || fseek(file_, 0, SEEK_SET) != 0) {
+    return ::zetasql_base::InternalErrorBuilder(ZETASQL_LOC)
+           << "Cannot rewind spill file: " << strerror(errno);
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::StatusOr<bool> SpillFile::Read(void* data, size_t size) {
+  const size_t read = fread(data, 1, size, file_);
+  if (read == size) return true;
+  if (read == 0 && feof(file_)) return false;
+  return ::zetasql_base::InternalErrorBuilder(ZETASQL_LOC)
+         << "Cannot read from spill file";
+}
+
+zetasql_base::Status SpillFile::ReadString(std::string* bytes) {
+  uint32_t size;
+  ZETASQL_ASSIGN_OR_RETURN(bool found, Read(&size, sizeof(size)));
+  if (found) {
+    bytes->resize(size);
+    ZETASQL_ASSIGN_OR_RETURN(found, Read(&(*bytes)[0], size));
+  }
+  if (!found) {
+    return ::zetasql_base::InternalErrorBuilder(ZETASQL_LOC)
+           << "Unexpected end of spill file";
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status SpillFile::ReadValues(absl::Span<const Type* const> types,
+                                   std::vector<Value>* values) {
+  values->resize(types.size());
+  ValueProto proto;
+  for (int i = 0; i < types.size(); ++i) {
+    ZETASQL_RETURN_IF_ERROR(ReadString(&buffer_));
+    if (!proto.ParseFromString(buffer_)) {
+      return ::zetasql_base::InternalErrorBuilder(ZETASQL_LOC)
+             << "Corrupt value in spill file";
+    }
+    ZETASQL_ASSIGN_OR_RETURN((*values)[i], Value::Deserialize(proto, types[i]));
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+int64_t ValueHeapBytes(const Value& value) {
+  if (!value.is_valid() || value.is_null()) return 0;
+  switch (value.type_kind()) {
+    case TYPE_STRING:
+      return value.string_value().size();
+    case TYPE_BYTES:
+      return value.bytes_value().size();
+    case TYPE_ARRAY:
+    case TYPE_STRUCT: {
+      int64_t bytes = 0;
+      for (const Value& element : value.type_kind() == TYPE_ARRAY
+                                      ? value.elements()
+                                      : value.fields()) {
+        bytes += sizeof(Value) + ValueHeapBytes(element);
+      }
+      return bytes;
+    }
+    default:
+      return 0;
+  }
+}
+
+}  // namespace local_service
+}  // namespace zetasql
@@ -0,0 +1,90 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef ZETASQL_LOCAL_SERVICE_SPILL_FILE_H_
+#define ZETASQL_LOCAL_SERVICE_SPILL_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "zetasql/base/status.h"
+#include "zetasql/base/statusor.h"
+
+namespace zetasql {
+namespace local_service {
+
+// A temporary file for operators that write rows to disk when they exceed
+// their memory budget. The file has no name, so it is deleted when closed.
+//
+// Data is written sequentially, then read back from the start after
+// Rewind(). A Value is stored as a 32-bit length and a serialized ValueProto,
+// so reading it back requires its type.
+//
+// This class is not thread-safe.
+class SpillFile {
+ public:
+  SpillFile(const SpillFile&) = delete;
+  SpillFile& operator=(const SpillFile&) = delete;
+  ~SpillFile();
+
+  // Creates an empty file in <directory>, or with tmpfile() if <directory>
+  // is empty.
+  static zetasql_base::StatusOr<std::unique_ptr<SpillFile>> Create(
+      const std::string& directory);
+
+  zetasql_base::Status Write(const void* data, size_t size);
+  // Writes a 32-bit length followed by <bytes>.
+  zetasql_base::Status WriteString(absl::string_view bytes);
+  zetasql_base::Status WriteValues(absl::Span<const Value> values);
+
+  // Moves to the start of the file, for reading what was written.
+  zetasql_base::Status Rewind();
+
+  // Reads <size> bytes into <data>. Returns false if the file ends before
+  // the first byte, and an error if it ends later.
+  zetasql_base::StatusOr<bool> Read(void* data, size_t size);
+  zetasql_base::Status ReadString(std::string* bytes);
+  // Reads one value of each of <types>.
+  zetasql_base::Status ReadValues(absl::Span<const Type* const> types,
+                          std::vector<Value>* values);
+
+  int64_t bytes_written() const { return bytes_written_; }
+
+ private:
+  explicit SpillFile(FILE* file) : file_(file) {}
+
+  FILE* file_;
+  int64_t bytes_written_ = 0;
+  std::string buffer_;
+};
+
+// Returns an estimate of the memory that <value> holds outside the Value
+// itself, for accounting against a memory budget.
+int64_t ValueHeapBytes(const Value& value);
+
+}  // namespace local_service
+}  // namespace zetasql
+
+#endif  // ZETASQL_LOCAL_SERVICE_SPILL_FILE_H_
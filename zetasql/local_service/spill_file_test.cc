@@ -0,0 +1,79 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "zetasql/local_service/spill_file.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace zetasql {
+namespace local_service {
+
+using zetasql_base::testing::StatusIs;
+
+TEST(SpillFileTest, WriteAndRead) {
+  for (const std::string& directory : {std::string(), ::testing::TempDir()}) {
+    ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<SpillFile> file,
+                         SpillFile::Create(directory));
+    const uint64_t number = 12345;
+    const std::vector<Value> values = {Value::Int64(5), Value::NullString(),
+                                       Value::String("abc")};
+    ZETASQL_ASSERT_OK(file->Write(&number, sizeof(number)));
+    ZETASQL_ASSERT_OK(file->WriteValues(values));
+    ZETASQL_ASSERT_OK(file->WriteString(""));
+    EXPECT_GT(file->bytes_written(), sizeof(number));
+
+    ZETASQL_ASSERT_OK(file->Rewind());
+    uint64_t read_number = 0;
+    ZETASQL_ASSERT_OK_AND_ASSIGN(bool found,
+                         file->Read(&read_number, sizeof(read_number)));
+    EXPECT_TRUE(found);
+    EXPECT_EQ(number, read_number);
+    std::vector<Value> read_values;
+    ZETASQL_ASSERT_OK(file->ReadValues(
+        {types::Int64Type(), types::StringType(), types::StringType()},
+        &read_values));
+    EXPECT_EQ(values, read_values);
+    std::string bytes = "x";
+    ZETASQL_ASSERT_OK(file->ReadString(&bytes));
+    EXPECT_EQ("", bytes);
+
+    ZETASQL_ASSERT_OK_AND_ASSIGN(found,
+                         file->Read(&read_number, sizeof(read_number)));
+    EXPECT_FALSE(found);
+    EXPECT_THAT(file->ReadString(&bytes),
+                StatusIs(zetasql_base::StatusCode::kInternal));
+  }
+}
+
+TEST(SpillFileTest, ValueHeapBytes) {
+  EXPECT_EQ(0, ValueHeapBytes(Value()));
+  EXPECT_EQ(0, ValueHeapBytes(Value::Int64(1)));
+  EXPECT_EQ(0, ValueHeapBytes(Value::NullString()));
+  EXPECT_EQ(3, ValueHeapBytes(Value::String("abc")));
+}
+
+}  // namespace local_service
+}  // namespace zetasql
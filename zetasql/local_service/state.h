@@ -18,6 +18,8 @@
 #define ZETASQL_LOCAL_SERVICE_STATE_H_
 
 #include <stddef.h>
+#include <algorithm>
+#include <atomic>
 #include <map>
 #include <memory>
 #include <type_traits>
@@ -25,6 +27,8 @@
 #include <cstdint>
 #include "absl/base/thread_annotations.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "zetasql/base/map_util.h"
 
 namespace zetasql {
@@ -34,10 +38,24 @@ class GenericState;
 
 // Pool of saved states that can be shared by multiple statements.
 // The state class T must extend GenericState and must be thread safe.
+//
+// The states are spread over kNumShards shards by id, each with its own
+// reader-writer lock, so that concurrent Get() calls only share a reader lock
+// and registering or deleting a state blocks only its shard.
 template<class T>
 class SharedStatePool {
  public:
-  SharedStatePool() : next_id_(0) {}
+  static constexpr int kNumShards = 16;
+
+  struct Stats {
+    int64_t num_states = 0;
+    // Number of states deleted by EvictIdle().
+    int64_t num_evicted = 0;
+    // Longest time since any state was registered or last returned by Get().
+    absl::Duration max_idle_time;
+  };
+
+  SharedStatePool() : next_id_(0), num_evicted_(0) {}
   SharedStatePool(const SharedStatePool&) = delete;
   SharedStatePool& operator=(const SharedStatePool&) = delete;
 
@@ -48,52 +66,126 @@ class SharedStatePool {
       return -1;
     }
 
-    absl::MutexLock lock(&mutex_);
-    int64_t id = next_id_++;
+    int64_t id = next_id_.fetch_add(1, std::memory_order_relaxed);
+    Shard& shard = ShardFor(id);
+    absl::WriterMutexLock lock(&shard.mutex);
     if (!state->SetId(id)) {
       return -1;
     }
-    saved_states_[id].reset(state);
+    Entry& entry = shard.saved_states[id];
+    entry.state.reset(state);
+    entry.last_used_nanos.store(absl::GetCurrentTimeNanos(),
+                                std::memory_order_relaxed);
     return id;
   }
 
   bool Has(int64_t id) const {
-    absl::MutexLock lock(&mutex_);
-    return zetasql_base::ContainsKey(saved_states_, id);
+    const Shard& shard = ShardFor(id);
+    absl::ReaderMutexLock lock(&shard.mutex);
+    return zetasql_base::ContainsKey(shard.saved_states, id);
   }
 
   // Get a state object with given id, ownership is shared by the pool and all
   // threads that currently hold the state object.
   std::shared_ptr<T> Get(int64_t id) {
-    absl::MutexLock lock(&mutex_);
-    std::shared_ptr<T>* result = zetasql_base::FindOrNull(saved_states_, id);
-    if (result == nullptr) {
+    const Shard& shard = ShardFor(id);
+    absl::ReaderMutexLock lock(&shard.mutex);
+    const Entry* entry = zetasql_base::FindOrNull(shard.saved_states, id);
+    if (entry == nullptr) {
       return nullptr;
-    } else {
-      return *result;
     }
+    // Only stores a stale time, so that threads getting the same state
+    // mostly just read its cache line.
+    const int64_t now = absl::GetCurrentTimeNanos();
+    if (now - entry->last_used_nanos.load(std::memory_order_relaxed) >
+        kLastUsedResolutionNanos) {
+      entry->last_used_nanos.store(now, std::memory_order_relaxed);
+    }
+    return entry->state;
   }
 
   // Removes a state object from the pool. The state will be deleted immediately
   // if not held by any other threads, or after all threads releasing it.
   bool Delete(int64_t id) {
-    absl::MutexLock lock(&mutex_);
-    if (!zetasql_base::ContainsKey(saved_states_, id)) {
-      return false;
+    Shard& shard = ShardFor(id);
+    absl::WriterMutexLock lock(&shard.mutex);
+    return shard.saved_states.erase(id) > 0;
+  }
+
+  // Removes the states that have not been returned by Get() for at least
+  // <max_idle_time> and that no other thread holds. Returns the number of
+  // states removed.
+  int64_t EvictIdle(absl::Duration max_idle_time) {
+    const int64_t oldest_nanos =
+        absl::GetCurrentTimeNanos() - absl::ToInt64Nanoseconds(max_idle_time);
+    int64_t num_evicted = 0;
+    for (Shard& shard : shards_) {
+      absl::WriterMutexLock lock(&shard.mutex);
+      for (auto it = shard.saved_states.begin();
+           it != shard.saved_states.end();) {
+        const Entry& entry = it->second;
+        if (entry.last_used_nanos.load(std::memory_order_relaxed) <=
+                oldest_nanos &&
+            entry.state.use_count() == 1) {
+          it = shard.saved_states.erase(it);
+          ++num_evicted;
+        } else {
+          ++it;
+        }
+      }
     }
-    saved_states_.erase(id);
-    return true;
+    num_evicted_.fetch_add(num_evicted, std::memory_order_relaxed);
+    return num_evicted;
   }
 
-  size_t NumSavedStates() {
-    absl::MutexLock lock(&mutex_);
-    return saved_states_.size();
+  size_t NumSavedStates() const {
+    size_t num_states = 0;
+    for (const Shard& shard : shards_) {
+      absl::ReaderMutexLock lock(&shard.mutex);
+      num_states += shard.saved_states.size();
+    }
+    return num_states;
+  }
+
+  Stats GetStats() const {
+    Stats stats;
+    int64_t oldest_nanos = absl::GetCurrentTimeNanos();
+    const int64_t now = oldest_nanos;
+    for (const Shard& shard : shards_) {
+      absl::ReaderMutexLock lock(&shard.mutex);
+      stats.num_states += shard.saved_states.size();
+      for (const auto& id_and_entry : shard.saved_states) {
+        oldest_nanos = std::min(oldest_nanos,
+                                id_and_entry.second.last_used_nanos.load(
+                                    std::memory_order_relaxed));
+      }
+    }
+    stats.num_evicted = num_evicted_.load(std::memory_order_relaxed);
+    stats.max_idle_time = absl::Nanoseconds(now - oldest_nanos);
+    return stats;
   }
 
  private:
-  mutable absl::Mutex mutex_;
-  int64_t next_id_ GUARDED_BY(mutex_);
-  std::map<int64_t, std::shared_ptr<T>> saved_states_ GUARDED_BY(mutex_);
+  // Get() records its time only when the last one recorded is older than
+  // this.
+  static constexpr int64_t kLastUsedResolutionNanos = 1000 * 1000;
+
+  struct Entry {
+    std::shared_ptr<T> state;
+    mutable std::atomic<int64_t> last_used_nanos{0};
+  };
+
+  struct Shard {
+    mutable absl::Mutex mutex;
+    std::map<int64_t, Entry> saved_states GUARDED_BY(mutex);
+  };
+
+  Shard& ShardFor(int64_t id) { return shards_[id % kNumShards]; }
+  const Shard& ShardFor(int64_t id) const { return shards_[id % kNumShards]; }
+
+  std::atomic<int64_t> next_id_;
+  std::atomic<int64_t> num_evicted_;
+  Shard shards_[kNumShards];
 
   static_assert(
       std::is_base_of<GenericState, T>::value,
@@ -0,0 +1,96 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/local_service/state.h"
+
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/time/time.h"
+
+namespace zetasql {
+namespace local_service {
+
+class TestState : public GenericState {};
+
+TEST(SharedStatePoolTest, RegisterGetDelete) {
+  SharedStatePool<TestState> pool;
+  EXPECT_EQ(-1, pool.Register(nullptr));
+
+  std::vector<int64_t> ids;
+  for (int i = 0; i < 2 * SharedStatePool<TestState>::kNumShards + 1; ++i) {
+    ids.push_back(pool.Register(new TestState));
+    EXPECT_EQ(i, ids.back());
+  }
+  EXPECT_EQ(ids.size(), pool.NumSavedStates());
+  for (int64_t id : ids) {
+    ASSERT_TRUE(pool.Has(id));
+    EXPECT_EQ(id, pool.Get(id)->GetId());
+  }
+
+  std::shared_ptr<TestState> held = pool.Get(ids[0]);
+  EXPECT_TRUE(pool.Delete(ids[0]));
+  EXPECT_FALSE(pool.Delete(ids[0]));
+  EXPECT_FALSE(pool.Has(ids[0]));
+  EXPECT_EQ(nullptr, pool.Get(ids[0]));
+  EXPECT_EQ(ids[0], held->GetId());
+  EXPECT_EQ(ids.size() - 1, pool.NumSavedStates());
+}
+
+TEST(SharedStatePoolTest, EvictIdle) {
+  SharedStatePool<TestState> pool;
+  const int64_t held_id = pool.Register(new TestState);
+  const int64_t idle_id = pool.Register(new TestState);
+  std::shared_ptr<TestState> held = pool.Get(held_id);
+
+  EXPECT_EQ(0, pool.EvictIdle(absl::Hours(1)));
+  // Held states are not evicted, however long they are idle.
+  EXPECT_EQ(1, pool.EvictIdle(absl::ZeroDuration()));
+  EXPECT_FALSE(pool.Has(idle_id));
+  EXPECT_TRUE(pool.Has(held_id));
+
+  held.reset();
+  EXPECT_EQ(1, pool.EvictIdle(absl::ZeroDuration()));
+  const SharedStatePool<TestState>::Stats stats = pool.GetStats();
+  EXPECT_EQ(0, stats.num_states);
+  EXPECT_EQ(2, stats.num_evicted);
+  EXPECT_EQ(absl::ZeroDuration(), stats.max_idle_time);
+}
+
+TEST(SharedStatePoolTest, ConcurrentAccess) {
+  SharedStatePool<TestState> pool;
+  const int64_t shared_id = pool.Register(new TestState);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&pool, shared_id] {
+      for (int i = 0; i < 1000; ++i) {
+        EXPECT_NE(nullptr, pool.Get(shared_id));
+        const int64_t id = pool.Register(new TestState);
+        EXPECT_NE(nullptr, pool.Get(id));
+        EXPECT_TRUE(pool.Delete(id));
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(1, pool.NumSavedStates());
+}
+
+}  // namespace local_service
+}  // namespace zetasql
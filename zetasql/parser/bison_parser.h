@@ -17,7 +17,9 @@
 #ifndef ZETASQL_PARSER_BISON_PARSER_H_
 #define ZETASQL_PARSER_BISON_PARSER_H_
 
+#include <cstdint>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "zetasql/base/arena.h"
@@ -118,6 +120,7 @@ class BisonParser {
   template <typename T>
   T* CreateASTNode(const zetasql_bison_parser::location& bison_location) {
     T* result = new (zetasql_base::AllocateInArena, arena_) T;
+    result->set_children_arena(arena_);
     SetNodeLocation(bison_location, result);
     allocated_ast_nodes_->push_back(std::unique_ptr<ASTNode>(result));
     return result;
@@ -131,6 +134,7 @@ class BisonParser {
       const zetasql_bison_parser::location& bison_location,
       absl::Span<ASTNode* const> children) {
     T* result = new (zetasql_base::AllocateInArena, arena_) T;
+    result->set_children_arena(arena_);
     SetNodeLocation(bison_location, result);
     allocated_ast_nodes_->push_back(std::unique_ptr<ASTNode>(result));
     result->AddChildren(children);
@@ -146,6 +150,7 @@ class BisonParser {
       const zetasql_bison_parser::location& bison_location_end,
       absl::Span<ASTNode* const> children) {
     T* result = new (zetasql_base::AllocateInArena, arena_) T;
+    result->set_children_arena(arena_);
     SetNodeLocation(bison_location_start, bison_location_end, result);
     allocated_ast_nodes_->push_back(std::unique_ptr<ASTNode>(result));
     result->AddChildren(children);
@@ -227,6 +232,11 @@ class BisonParser {
   }
 
   IdString filename() const { return filename_; }
+
+  // Returns the number of tokens read by the last Parse().
+  int64_t num_tokens() const {
+    return tokenizer_ == nullptr ? 0 : tokenizer_->num_tokens();
+  }
   IdStringPool* id_string_pool() const { return id_string_pool_; }
 
   // Returns the next 1-based parameter position.
@@ -234,6 +244,14 @@ class BisonParser {
     return ++previous_positional_parameter_position_;
   }
 
+  // Returns the ASTNodes that were allocated through CreateASTNode(), and
+  // stops tracking them.  This is for a BisonParser created with the
+  // stand-alone constructor; Parse() returns them in its output instead.
+  std::unique_ptr<std::vector<std::unique_ptr<ASTNode>>>
+  ReleaseAllocatedASTNodes() {
+    return std::move(allocated_ast_nodes_);
+  }
+
  private:
   // Identifiers and literal values are allocated from this arena. Not owned.
   // Only valid during Parse().
@@ -17,12 +17,12 @@
 #ifndef ZETASQL_PARSER_FLEX_TOKENIZER_H_
 #define ZETASQL_PARSER_FLEX_TOKENIZER_H_
 
-#include <sstream>
+#include <algorithm>
+#include <cstring>
 #include <string>
 
 #include "zetasql/parser/position.hh"
 #include <cstdint>
-#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 
 // Some contortions to avoid duplicate inclusion of FlexLexer.h in the
@@ -48,20 +48,14 @@ class ZetaSqlFlexTokenizer final : public ZetaSqlFlexTokenizerBase {
   // Constructs a simple wrapper around a flex generated tokenizer. 'mode'
   // controls the first token that is returned to the bison parser, which
   // determines the starting production used by the parser.  The 'filename'
-  // must outlive this object.
+  // and the 'input' must outlive this object.
   ZetaSqlFlexTokenizer(BisonParserMode mode, absl::string_view filename,
                          absl::string_view input, int start_offset)
       : filename_(filename),
         start_offset_(start_offset),
         input_size_(static_cast<int64_t>(input.size())),
         mode_(mode),
-        input_stream_(absl::StrCat(input, kEofSentinelInput)) {
-    // Seek the stringstream to the start_offset, and then instruct flex to read
-    // from the stream. (Flex has the ability to read multiple consecutive
-    // streams, but we only ever feed it one.)
-    input_stream_.seekg(start_offset, std::ios_base::beg);
-    switch_streams(&input_stream_ /* new_in */, nullptr /* new_out */);
-  }
+        remaining_input_(input.substr(start_offset)) {}
 
   ZetaSqlFlexTokenizer(const ZetaSqlFlexTokenizer&) = delete;
   ZetaSqlFlexTokenizer& operator=(const ZetaSqlFlexTokenizer&) = delete;
@@ -70,9 +64,13 @@ class ZetaSqlFlexTokenizer final : public ZetaSqlFlexTokenizerBase {
   // 'yylloc' must be the location of the previous token that was returned.
   int GetNextTokenFlex(zetasql_bison_parser::location* yylloc) {
     prev_token_ = GetNextTokenFlexImpl(yylloc);
+    ++num_tokens_;
     return prev_token_;
   }
 
+  // Returns the number of tokens returned by GetNextTokenFlex() so far.
+  int64_t num_tokens() const { return num_tokens_; }
+
   // This is the "nice" API for the tokenizer, to be used by GetParseTokens().
   // On input, 'location' must be the location of the previous token that was
   // generated. Returns the Bison token id in 'token' and the ZetaSQL location
@@ -111,6 +109,23 @@ class ZetaSqlFlexTokenizer final : public ZetaSqlFlexTokenizerBase {
     override_error_ = MakeSqlError() << msg;
   }
 
+  // This is called by flex to fill its buffer. It copies the input directly
+  // into 'buf', instead of reading it through an std::istream on a copy of the
+  // input, followed by the EOF sentinel. Returns the number of bytes copied,
+  // or 0 at the end of the input.
+  int LexerInput(char* buf, int max_size) override {
+    if (remaining_input_.empty()) {
+      if (sentinel_read_) return 0;
+      sentinel_read_ = true;
+      remaining_input_ = kEofSentinelInput;
+    }
+    const int size =
+        static_cast<int>(std::min<size_t>(max_size, remaining_input_.size()));
+    memcpy(buf, remaining_input_.data(), size);
+    remaining_input_.remove_prefix(size);
+    return size;
+  }
+
   // EOF sentinel input. This is appended to the input and used as a sentinel in
   // the tokenizer. The reason for doing this is that some tokenizer rules
   // try to match trailing context of the form [^...] where "..." is a set of
@@ -136,6 +151,8 @@ class ZetaSqlFlexTokenizer final : public ZetaSqlFlexTokenizerBase {
   // action in tokenizer rules based on context.
   int prev_token_ = 0;
 
+  int64_t num_tokens_ = 0;
+
   // The (optional) filename from which the statement is being parsed.
   absl::string_view filename_;
 
@@ -150,11 +167,13 @@ class ZetaSqlFlexTokenizer final : public ZetaSqlFlexTokenizerBase {
   // determines the mode that we'll run in.
   const BisonParserMode mode_;
 
-  // Stream on the input. This is what is consumed by flex. It consists of the
-  // input (of size input_size_) plus a single byte \001 which is used as a
-  // sentinel value in the tokenizer (but only if it occurs at location
-  // input_size_).
-  std::istringstream input_stream_;
+  // The part of the input that has not been given to flex yet. After it is
+  // consumed, flex gets kEofSentinelInput, which is used as a sentinel value
+  // in the tokenizer (but only if it occurs at location input_size_).
+  absl::string_view remaining_input_;
+
+  // True once kEofSentinelInput has been given to flex.
+  bool sentinel_read_ = false;
 
   // The tokenizer may want to return an error directly. It does this by
   // returning EOF to the bison parser, which then may or may not spew out its
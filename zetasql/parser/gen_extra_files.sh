@@ -16,12 +16,13 @@
 
 #!/bin/bash
 
-if [[ "$#" != 4 ]]; then
+if [[ "$#" != 5 ]]; then
   # Expected args are filenames for these:
   #   parse_tree.h                  (input)
   #   ZetaSqlParserVisitor.h      (output)
   #   parse_tree_decls.h            (output)
   #   parse_tree_accept_methods.inc (output)
+  #   parse_tree_node_factory.inc   (output)
   echo "Wrong args to gen_extra_files.sh"
   exit 1
 fi
@@ -108,3 +109,17 @@ d
 EOF
 echo '}  // namespace zetasql'
 ) > "$4"
+
+# Generate parse_tree_node_factory.inc, which has a case returning a new
+# node in <arena> for the kind of each non-abstract AST node class in
+# parse_tree.h.
+# It is included in the body of a switch on an ASTNodeKind.
+sed -f - "$1" > "$5" <<EOF
+# Matches the start of a final (i.e., non-abstract) class.
+/^class AST[a-zA-Z]* final : public/ {
+  s/class \(AST[a-zA-Z]*\).*/  case \1::kConcreteNodeKind:\n    return new (zetasql_base::AllocateInArena, arena) \1;/
+  p
+}
+# Delete everything else so we just keep the cases.
+d
+EOF
@@ -24,6 +24,7 @@
 #include "zetasql/base/path.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/strings/ascii.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "re2/re2.h"
@@ -70,6 +71,41 @@ TEST(GetKeywordInfo, NonHit) {
   EXPECT_FALSE(info != nullptr);
 }
 
+TEST(GetKeywordInfo, AllKeywordsCaseInsensitively) {
+  for (const KeywordInfo& keyword_info : GetAllKeywords()) {
+    const std::string& keyword = keyword_info.keyword();
+    const std::string lower = absl::AsciiStrToLower(keyword);
+    EXPECT_EQ(&keyword_info, GetKeywordInfo(keyword)) << keyword;
+    EXPECT_EQ(&keyword_info, GetKeywordInfo(lower)) << keyword;
+    EXPECT_EQ(&keyword_info,
+              GetKeywordInfo(absl::StrCat(lower.substr(0, 1),
+                                          keyword.substr(1))))
+        << keyword;
+    EXPECT_EQ(&keyword_info,
+              GetKeywordInfoForBisonToken(keyword_info.bison_token()))
+        << keyword;
+    EXPECT_EQ(keyword_info.IsReserved() ? &keyword_info : nullptr,
+              GetReservedKeywordInfo(lower))
+        << keyword;
+
+    // Prefixes, extensions and other characters do not match.
+    EXPECT_EQ(nullptr, GetKeywordInfo(keyword.substr(0, keyword.size() - 1)))
+        << keyword;
+    // Keys are padded with zero bytes when they are hashed.
+    EXPECT_EQ(nullptr, GetKeywordInfo(keyword + std::string(1, '\0')))
+        << keyword;
+    if (keyword.find('_') != std::string::npos) {
+      std::string changed = keyword;
+      changed[keyword.find('_')] = '\x7f';
+      EXPECT_EQ(nullptr, GetKeywordInfo(changed)) << keyword;
+    }
+  }
+  EXPECT_EQ(nullptr, GetKeywordInfo(""));
+  EXPECT_EQ(nullptr, GetKeywordInfo(std::string(1000, 'a')));
+  EXPECT_EQ(nullptr, GetKeywordInfoForBisonToken(-1));
+  EXPECT_EQ(nullptr, GetKeywordInfoForBisonToken(';'));
+}
+
 // Returns a section of lines from file 'file_path' delimited by
 // BEGIN_<section_delimiter> and END_<section_delimiter>. The section
 // delimiters do not need to be on a line by themselves. The lines that contain
@@ -0,0 +1,273 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/parser/parse_cache.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/base/arena.h"
+#include "zetasql/parser/parse_tree.h"
+#include "zetasql/parser/parse_tree_serializer.h"
+#include "zetasql/parser/parser.h"
+#include "zetasql/public/id_string.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/strip.h"
+#include "zetasql/base/endian.h"
+#include "zetasql/base/source_location.h"
+#include "zetasql/base/status.h"
+#include "zetasql/base/status_builder.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+namespace {
+
+// The file written by SaveToFile() is kFileMagic, then the build id and the
+// entries.  Each entry is its key, then the number of tokens and the
+// serialized parse tree.  Strings are written with a 32-bit length, and all
+// integers are little-endian.
+constexpr absl::string_view kFileMagic = "ZetaSQL ParseCache 1\n";
+
+void AppendUint64(uint64_t value, std::string* output) {
+  char buffer[sizeof(value)];
+  zetasql_base::LittleEndian::Store64(buffer, value);
+  output->append(buffer, sizeof(buffer));
+}
+
+void AppendString(absl::string_view value, std::string* output) {
+  char buffer[sizeof(uint32_t)];
+  zetasql_base::LittleEndian::Store32(buffer, static_cast<uint32_t>(value.size()));
+  output->append(buffer, sizeof(buffer));
+  output->append(value.data(), value.size());
+}
+
+bool ReadString(absl::string_view* input, absl::string_view* value) {
+  if (input->size() < sizeof(uint32_t)) return false;
+  const uint32_t size = zetasql_base::LittleEndian::Load32(input->data());
+  input->remove_prefix(sizeof(uint32_t));
+  if (input->size() < size) return false;
+  *value = input->substr(0, size);
+  input->remove_prefix(size);
+  return true;
+}
+
+}  // namespace
+
+ParseCache::ParseCache(int max_entries) : cache_(max_entries) {}
+
+ParseCache::~ParseCache() {}
+
+std::string ParseCache::MakeKey(ParseKind kind, absl::string_view text) {
+  return absl::StrCat(absl::string_view(reinterpret_cast<const char*>(&kind),
+                                        1),
+                      text);
+}
+
+zetasql_base::Status ParseCache::ParseStatement(
+    absl::string_view statement_string,
+    std::shared_ptr<const ParserOutput>* output) {
+  std::string key = MakeKey(ParseKind::kStatement, statement_string);
+  if (cache_.Lookup(key, output) || LookupPersisted(key, output)) {
+    return ::zetasql_base::OkStatus();
+  }
+  // Parse outside the lock.  The default ParserOptions create a fresh arena
+  // and IdStringPool, which become owned by the cached ParserOutput.
+  std::unique_ptr<ParserOutput> parser_output;
+  ZETASQL_RETURN_IF_ERROR(zetasql::ParseStatement(statement_string, ParserOptions(),
+                                          &parser_output));
+  *output = std::move(parser_output);
+  cache_.Insert(key, *output);
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status ParseCache::ParseExpression(
+    absl::string_view expression_string,
+    std::shared_ptr<const ParserOutput>* output) {
+  std::string key = MakeKey(ParseKind::kExpression, expression_string);
+  if (cache_.Lookup(key, output) || LookupPersisted(key, output)) {
+    return ::zetasql_base::OkStatus();
+  }
+  std::unique_ptr<ParserOutput> parser_output;
+  ZETASQL_RETURN_IF_ERROR(zetasql::ParseExpression(expression_string, ParserOptions(),
+                                           &parser_output));
+  *output = std::move(parser_output);
+  cache_.Insert(key, *output);
+  return ::zetasql_base::OkStatus();
+}
+
+bool ParseCache::LookupPersisted(const std::string& key,
+                                 std::shared_ptr<const ParserOutput>* output) {
+  std::shared_ptr<const PersistedEntries> persisted;
+  {
+    absl::MutexLock lock(&mutex_);
+    persisted = persisted_;
+  }
+  if (persisted == nullptr) return false;
+  auto it = persisted->entries.find(key);
+  if (it == persisted->entries.end()) return false;
+
+  absl::string_view entry = it->second;
+  if (entry.size() < sizeof(uint64_t)) return false;
+  const int64_t num_tokens =
+      static_cast<int64_t>(zetasql_base::LittleEndian::Load64(entry.data()));
+  entry.remove_prefix(sizeof(uint64_t));
+
+  auto arena = std::make_shared<zetasql_base::UnsafeArena>(/*block_size=*/4096);
+  auto id_string_pool = std::make_shared<IdStringPool>(arena);
+  std::unique_ptr<ASTNode> root;
+  std::vector<std::unique_ptr<ASTNode>> other_allocated_ast_nodes;
+  // Entries that do not decode are parsed again, as on a miss.
+  if (!DeserializeParseTree(entry, id_string_pool.get(), arena.get(), &root,
+                            &other_allocated_ast_nodes)
+           .ok()) {
+    return false;
+  }
+  std::unique_ptr<ParserOutput> parser_output;
+  if (static_cast<ParseKind>(key[0]) == ParseKind::kStatement) {
+    if (!root->IsStatement()) return false;
+    parser_output = absl::make_unique<ParserOutput>(
+        id_string_pool, arena, std::move(other_allocated_ast_nodes),
+        std::unique_ptr<ASTStatement>(
+            root.release()->GetAsOrDie<ASTStatement>()));
+  } else {
+    if (!root->IsExpression()) return false;
+    parser_output = absl::make_unique<ParserOutput>(
+        id_string_pool, arena, std::move(other_allocated_ast_nodes),
+        std::unique_ptr<ASTExpression>(
+            root.release()->GetAsOrDie<ASTExpression>()));
+  }
+  parser_output->set_num_tokens(num_tokens);
+  *output = std::move(parser_output);
+  cache_.Insert(key, *output);
+  return true;
+}
+
+zetasql_base::Status ParseCache::SaveToFile(const std::string& path,
+                                    absl::string_view build_id) const {
+  // Serialize outside the lock of <cache_>.
+  std::vector<std::pair<std::string, std::shared_ptr<const ParserOutput>>>
+      entries;
+  cache_.ForEach([&entries](const std::string& key,
+                            const std::shared_ptr<const ParserOutput>& value) {
+    entries.emplace_back(key, value);
+  });
+
+  std::string data(kFileMagic);
+  AppendString(build_id, &data);
+  for (const auto& entry : entries) {
+    const ParserOutput& parser_output = *entry.second;
+    const ASTNode* root;
+    if (static_cast<ParseKind>(entry.first[0]) == ParseKind::kStatement) {
+      root = parser_output.statement();
+    } else {
+      root = parser_output.expression();
+    }
+    AppendString(entry.first, &data);
+    std::string serialized;
+    AppendUint64(static_cast<uint64_t>(parser_output.num_tokens()),
+                 &serialized);
+    SerializeParseTree(*root, &serialized);
+    AppendString(serialized, &data);
+  }
+
+  const std::string temp_path = absl::StrCat(path, ".tmp");
+  {
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    file.write(data.data(), data.size());
+    file.close();
+    if (!file) {
+      return zetasql_base::InternalErrorBuilder(ZETASQL_LOC)
+             << "Failed to write parse cache file " << temp_path;
+    }
+  }
+  if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+    return zetasql_base::InternalErrorBuilder(ZETASQL_LOC)
+           << "Failed to rename parse cache file " << temp_path << " to "
+           << path;
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status ParseCache::LoadFromFile(const std::string& path,
+                                      absl::string_view build_id) {
+  auto persisted = std::make_shared<PersistedEntries>();
+  {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+      // A missing file is a cold start.
+      return ::zetasql_base::OkStatus();
+    }
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    if (file.bad()) {
+      return zetasql_base::InternalErrorBuilder(ZETASQL_LOC)
+             << "Failed to read parse cache file " << path;
+    }
+    persisted->data = contents.str();
+  }
+
+  absl::string_view input = persisted->data;
+  absl::string_view file_build_id;
+  if (!absl::ConsumePrefix(&input, kFileMagic) ||
+      !ReadString(&input, &file_build_id)) {
+    return zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "Not a parse cache file: " << path;
+  }
+  if (file_build_id != build_id) {
+    // The file was saved by another build, which may encode or parse
+    // differently.
+    return ::zetasql_base::OkStatus();
+  }
+  while (!input.empty()) {
+    absl::string_view key;
+    absl::string_view entry;
+    if (!ReadString(&input, &key) || key.empty() ||
+        !ReadString(&input, &entry)) {
+      return zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+             << "Corrupt parse cache file: " << path;
+    }
+    persisted->entries.emplace(key, entry);
+  }
+
+  absl::MutexLock lock(&mutex_);
+  persisted_ = std::move(persisted);
+  return ::zetasql_base::OkStatus();
+}
+
+void ParseCache::Clear() {
+  {
+    absl::MutexLock lock(&mutex_);
+    persisted_.reset();
+  }
+  cache_.Clear();
+}
+
+int ParseCache::num_persisted_entries() const {
+  absl::MutexLock lock(&mutex_);
+  return persisted_ == nullptr
+             ? 0
+             : static_cast<int>(persisted_->entries.size());
+}
+
+}  // namespace zetasql
@@ -0,0 +1,132 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PARSER_PARSE_CACHE_H_
+#define ZETASQL_PARSER_PARSE_CACHE_H_
+
+#include <memory>
+#include <string>
+
+#include "zetasql/common/lru_cache.h"
+#include "zetasql/parser/parser.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+
+// A thread-safe, size-bounded LRU cache of parse trees.
+//
+// Each cached ParserOutput is parsed into its own IdStringPool and arena, so
+// it stays valid for as long as any caller holds a reference to it,
+// independently of the cache and of other entries.  Cached outputs are
+// immutable and may be read concurrently from multiple threads.
+//
+// Entries are keyed by the exact input text and the kind of parse (statement
+// or expression).  The text is not normalized, because the parse locations
+// recorded in the AST are byte offsets into the original input and must stay
+// correct for error reporting.  ParserOptions carries no settings that
+// affect the produced tree, so it does not participate in the key; any arena
+// or IdStringPool set in the ParserOptions is ignored.
+//
+// Parse errors are not cached.
+//
+// The entries can be saved to a file and loaded by a later process, so that
+// it starts with a warm cache.  The file stores the parse trees in the
+// encoding of SerializeParseTree(), which only the same build can read, so
+// it is tagged with a build id chosen by the caller, such as the build label
+// of the binary.  Loaded entries are decoded when they are first looked up,
+// which is much cheaper than parsing.
+//
+// Example:
+//   ParseCache cache(/*max_entries=*/1000);
+//   ZETASQL_RETURN_IF_ERROR(cache.LoadFromFile(cache_path, build_id));
+//   std::shared_ptr<const ParserOutput> parser_output;
+//   ZETASQL_RETURN_IF_ERROR(cache.ParseStatement(sql, &parser_output));
+//   ... parser_output->statement() ...
+//   ZETASQL_RETURN_IF_ERROR(cache.SaveToFile(cache_path, build_id));
+class ParseCache {
+ public:
+  // <max_entries> must be positive.
+  explicit ParseCache(int max_entries);
+  ParseCache(const ParseCache&) = delete;
+  ParseCache& operator=(const ParseCache&) = delete;
+  ~ParseCache();
+
+  // Same as zetasql::ParseStatement(), but returns a shared ParserOutput
+  // that may come from the cache.
+  zetasql_base::Status ParseStatement(absl::string_view statement_string,
+                              std::shared_ptr<const ParserOutput>* output);
+
+  // Same as zetasql::ParseExpression(), but returns a shared ParserOutput
+  // that may come from the cache.
+  zetasql_base::Status ParseExpression(absl::string_view expression_string,
+                               std::shared_ptr<const ParserOutput>* output);
+
+  // Writes all entries to <path>, tagged with <build_id>.  The file is
+  // written under a temporary name and then renamed to <path>, so concurrent
+  // readers see either the old or the new file.
+  zetasql_base::Status SaveToFile(const std::string& path,
+                          absl::string_view build_id) const;
+
+  // Makes the entries in <path> available to lookups that miss in memory,
+  // replacing those of any previous LoadFromFile().  Loads nothing if <path>
+  // does not exist or was saved with a different <build_id>.  Returns an
+  // error if <path> cannot be read or is corrupt.
+  zetasql_base::Status LoadFromFile(const std::string& path,
+                            absl::string_view build_id);
+
+  // Removes all entries, including those loaded from a file.  Outputs
+  // already handed out remain valid.
+  void Clear();
+
+  int max_entries() const { return cache_.max_entries(); }
+  int size() const { return cache_.size(); }
+  LruCacheStats stats() const { return cache_.stats(); }
+
+  // The number of entries loaded by LoadFromFile(), whether or not they were
+  // looked up yet.
+  int num_persisted_entries() const;
+
+ private:
+  enum class ParseKind : char { kStatement = 's', kExpression = 'e' };
+
+  // The contents of a file loaded by LoadFromFile(), and the entries in it.
+  struct PersistedEntries {
+    std::string data;
+    // Maps keys to the serialized entries, which are views into <data>.
+    absl::flat_hash_map<absl::string_view, absl::string_view> entries;
+  };
+
+  static std::string MakeKey(ParseKind kind, absl::string_view text);
+
+  // Looks up <key> in the entries loaded by LoadFromFile(), and if found,
+  // decodes it into <output> and adds it to <cache_>.
+  bool LookupPersisted(const std::string& key,
+                       std::shared_ptr<const ParserOutput>* output);
+
+  LruCache<std::string, std::shared_ptr<const ParserOutput>> cache_;
+
+  mutable absl::Mutex mutex_;
+  // Immutable once set, so lookups decode entries without holding <mutex_>.
+  std::shared_ptr<const PersistedEntries> persisted_ GUARDED_BY(mutex_);
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PARSER_PARSE_CACHE_H_
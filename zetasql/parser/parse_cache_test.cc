@@ -0,0 +1,172 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/parser/parse_cache.h"
+
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/parser/parse_tree.h"
+#include "zetasql/parser/parser.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+
+namespace zetasql {
+
+using testing::NotNull;
+using zetasql_base::testing::StatusIs;
+
+TEST(ParseCacheTest, HitReturnsSameOutput) {
+  ParseCache cache(/*max_entries=*/10);
+  std::shared_ptr<const ParserOutput> output1;
+  std::shared_ptr<const ParserOutput> output2;
+  ZETASQL_ASSERT_OK(cache.ParseStatement("SELECT 1", &output1));
+  ZETASQL_ASSERT_OK(cache.ParseStatement("SELECT 1", &output2));
+  ASSERT_THAT(output1->statement(), NotNull());
+  EXPECT_EQ(output1.get(), output2.get());
+  EXPECT_EQ(1, cache.size());
+  EXPECT_EQ(1, cache.stats().hits);
+  EXPECT_EQ(1, cache.stats().misses);
+}
+
+TEST(ParseCacheTest, StatementsAndExpressionsAreKeyedSeparately) {
+  ParseCache cache(/*max_entries=*/10);
+  std::shared_ptr<const ParserOutput> statement;
+  std::shared_ptr<const ParserOutput> expression;
+  ZETASQL_ASSERT_OK(cache.ParseStatement("SELECT 1", &statement));
+  ZETASQL_ASSERT_OK(cache.ParseExpression("1", &expression));
+  ASSERT_THAT(expression->expression(), NotNull());
+  EXPECT_EQ(AST_INT_LITERAL, expression->expression()->node_kind());
+  EXPECT_EQ(2, cache.size());
+}
+
+TEST(ParseCacheTest, EvictsLeastRecentlyUsed) {
+  ParseCache cache(/*max_entries=*/2);
+  std::shared_ptr<const ParserOutput> a;
+  std::shared_ptr<const ParserOutput> b;
+  std::shared_ptr<const ParserOutput> c;
+  std::shared_ptr<const ParserOutput> lookup;
+  ZETASQL_ASSERT_OK(cache.ParseStatement("SELECT a", &a));
+  ZETASQL_ASSERT_OK(cache.ParseStatement("SELECT b", &b));
+  // Touch "a" so that "b" is the least recently used entry.
+  ZETASQL_ASSERT_OK(cache.ParseStatement("SELECT a", &lookup));
+  EXPECT_EQ(a.get(), lookup.get());
+  ZETASQL_ASSERT_OK(cache.ParseStatement("SELECT c", &c));
+  EXPECT_EQ(2, cache.size());
+  EXPECT_EQ(1, cache.stats().evictions);
+
+  ZETASQL_ASSERT_OK(cache.ParseStatement("SELECT a", &lookup));
+  EXPECT_EQ(a.get(), lookup.get());
+  ZETASQL_ASSERT_OK(cache.ParseStatement("SELECT b", &lookup));
+  EXPECT_NE(b.get(), lookup.get());
+
+  // The evicted output is still usable by its holder.
+  EXPECT_EQ("SELECT\n  b\n", Unparse(b->statement()));
+}
+
+TEST(ParseCacheTest, ErrorsAreNotCached) {
+  ParseCache cache(/*max_entries=*/10);
+  std::shared_ptr<const ParserOutput> output;
+  EXPECT_FALSE(cache.ParseStatement("SELECT FROM", &output).ok());
+  EXPECT_EQ(0, cache.size());
+}
+
+TEST(ParseCacheTest, Clear) {
+  ParseCache cache(/*max_entries=*/10);
+  std::shared_ptr<const ParserOutput> output;
+  ZETASQL_ASSERT_OK(cache.ParseStatement("SELECT 1", &output));
+  cache.Clear();
+  EXPECT_EQ(0, cache.size());
+  ASSERT_THAT(output->statement(), NotNull());
+}
+
+TEST(ParseCacheTest, SaveAndLoad) {
+  const std::string path =
+      absl::StrCat(::testing::TempDir(), "/parse_cache_save_and_load");
+  std::shared_ptr<const ParserOutput> statement;
+  std::shared_ptr<const ParserOutput> expression;
+  {
+    ParseCache cache(/*max_entries=*/10);
+    ZETASQL_ASSERT_OK(cache.ParseStatement("SELECT a FROM t WHERE b > 1", &statement));
+    ZETASQL_ASSERT_OK(cache.ParseExpression("f(x) + 1", &expression));
+    ZETASQL_ASSERT_OK(cache.SaveToFile(path, "build_1"));
+  }
+
+  ParseCache cache(/*max_entries=*/10);
+  ZETASQL_ASSERT_OK(cache.LoadFromFile(path, "build_1"));
+  EXPECT_EQ(2, cache.num_persisted_entries());
+  EXPECT_EQ(0, cache.size());
+
+  std::shared_ptr<const ParserOutput> loaded;
+  ZETASQL_ASSERT_OK(cache.ParseStatement("SELECT a FROM t WHERE b > 1", &loaded));
+  ASSERT_THAT(loaded->statement(), NotNull());
+  EXPECT_EQ(statement->statement()->DebugString(),
+            loaded->statement()->DebugString());
+  EXPECT_EQ(statement->num_tokens(), loaded->num_tokens());
+  // The decoded entry is now cached in memory.
+  EXPECT_EQ(1, cache.size());
+  std::shared_ptr<const ParserOutput> lookup;
+  ZETASQL_ASSERT_OK(cache.ParseStatement("SELECT a FROM t WHERE b > 1", &lookup));
+  EXPECT_EQ(loaded.get(), lookup.get());
+
+  ZETASQL_ASSERT_OK(cache.ParseExpression("f(x) + 1", &loaded));
+  ASSERT_THAT(loaded->expression(), NotNull());
+  EXPECT_EQ(expression->expression()->DebugString(),
+            loaded->expression()->DebugString());
+
+  // Entries are keyed by parse kind also in the file.
+  ZETASQL_ASSERT_OK(cache.ParseStatement("SELECT 2", &loaded));
+  EXPECT_EQ(3, cache.size());
+}
+
+TEST(ParseCacheTest, LoadIgnoresOtherBuildsAndMissingFiles) {
+  const std::string path =
+      absl::StrCat(::testing::TempDir(), "/parse_cache_other_build");
+  {
+    ParseCache cache(/*max_entries=*/10);
+    std::shared_ptr<const ParserOutput> output;
+    ZETASQL_ASSERT_OK(cache.ParseStatement("SELECT 1", &output));
+    ZETASQL_ASSERT_OK(cache.SaveToFile(path, "build_1"));
+  }
+  ParseCache cache(/*max_entries=*/10);
+  ZETASQL_ASSERT_OK(cache.LoadFromFile(path, "build_2"));
+  EXPECT_EQ(0, cache.num_persisted_entries());
+  ZETASQL_ASSERT_OK(cache.LoadFromFile(absl::StrCat(path, ".missing"), "build_1"));
+  EXPECT_EQ(0, cache.num_persisted_entries());
+
+  ZETASQL_ASSERT_OK(cache.LoadFromFile(path, "build_1"));
+  EXPECT_EQ(1, cache.num_persisted_entries());
+  cache.Clear();
+  EXPECT_EQ(0, cache.num_persisted_entries());
+}
+
+TEST(ParseCacheTest, LoadRejectsCorruptFiles) {
+  const std::string path =
+      absl::StrCat(::testing::TempDir(), "/parse_cache_corrupt");
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << "not a parse cache";
+  }
+  ParseCache cache(/*max_entries=*/10);
+  EXPECT_THAT(cache.LoadFromFile(path, "build_1"),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+  EXPECT_EQ(0, cache.num_persisted_entries());
+}
+
+}  // namespace zetasql
@@ -277,18 +277,49 @@ static const absl::flat_hash_map<ASTNodeKind, std::string>& GetNodeNamesMap() {
   return map;
 }
 
-ASTNode::~ASTNode() {}
+ASTNode::~ASTNode() {
+  if (children_arena_ == nullptr) {
+    delete[] children_;
+  }
+}
+
+void ASTNode::ReserveChildren(int min_capacity) {
+  if (min_capacity <= children_capacity_) return;
+  // Lists like SELECT columns grow one child at a time, so grow
+  // geometrically.  A replaced arena array is only reclaimed with the arena,
+  // which bounds the waste by the final size of the list.
+  const int new_capacity = std::max({min_capacity, 2 * children_capacity_, 2});
+  ASTNode** new_children;
+  if (children_arena_ != nullptr) {
+    new_children = static_cast<ASTNode**>(children_arena_->AllocAligned(
+        new_capacity * sizeof(ASTNode*), alignof(ASTNode*)));
+  } else {
+    new_children = new ASTNode*[new_capacity];
+  }
+  std::copy(children_, children_ + num_children_, new_children);
+  if (children_arena_ == nullptr) {
+    delete[] children_;
+  }
+  children_ = new_children;
+  children_capacity_ = new_capacity;
+}
 
 void ASTNode::AddChild(ASTNode* child) {
   DCHECK(child != nullptr);
-  children_.push_back(child);
+  ReserveChildren(num_children_ + 1);
+  children_[num_children_++] = child;
   child->set_parent(this);
 }
 
 void ASTNode::AddChildren(absl::Span<ASTNode* const> children) {
+  ReserveChildren(num_children_ + static_cast<int>(std::count_if(
+                                      children.begin(), children.end(),
+                                      [](const ASTNode* child) {
+                                        return child != nullptr;
+                                      })));
   for (ASTNode* child : children) {
     if (child != nullptr) {
-      children_.push_back(child);
+      children_[num_children_++] = child;
       child->set_parent(this);
     }
   }
@@ -299,11 +330,39 @@ void ASTNode::Accept(ParseTreeVisitor* visitor, void* data) const {
 }
 
 void ASTNode::ChildrenAccept(ParseTreeVisitor* visitor, void* data) const {
-  for (int i = 0; i < children_.size(); ++i) {
+  for (int i = 0; i < num_children_; ++i) {
     children_[i]->Accept(visitor, data);
   }
 }
 
+void ASTNode::TraverseNonRecursive(
+    const std::function<bool(const ASTNode*)>& pre_visit,
+    const std::function<void(const ASTNode*)>& post_visit) const {
+  // Each entry is a node whose children are being visited, and the index of
+  // its next child to visit.
+  std::vector<std::pair<const ASTNode*, int>> stack;
+  auto enter = [&pre_visit, &post_visit, &stack](const ASTNode* node) {
+    if (pre_visit == nullptr || pre_visit(node)) {
+      stack.emplace_back(node, 0);
+    } else if (post_visit != nullptr) {
+      post_visit(node);
+    }
+  };
+
+  enter(this);
+  while (!stack.empty()) {
+    const ASTNode* node = stack.back().first;
+    const int next_child = stack.back().second;
+    if (next_child < node->num_children()) {
+      ++stack.back().second;
+      enter(node->child(next_child));
+    } else {
+      stack.pop_back();
+      if (post_visit != nullptr) post_visit(node);
+    }
+  }
+}
+
 std::string ASTNode::NodeKindToString(ASTNodeKind node_kind) {
   // Subtle: we must ensure that default_value outlives the FindWithDefault
   // call.
@@ -345,8 +404,11 @@ void ASTNode::Dumper::Dump() {
     return;
   }
   ++current_depth_;
-  const auto& children = node_->children_;
-  for (ASTNode* n : children) {
+  // Dump() changes node_, so read the children of this node up front.
+  ASTNode* const* children = node_->children_;
+  const int num_children = node_->num_children_;
+  for (int i = 0; i < num_children; ++i) {
+    ASTNode* n = children[i];
     if (n != nullptr) {
       node_ = n;
       Dump();
@@ -670,6 +732,15 @@ std::vector<std::string> ASTPathExpression::ToIdentifierVector() const {
   return ret;
 }
 
+std::vector<IdString> ASTPathExpression::ToIdStringVector() const {
+  std::vector<IdString> ret;
+  ret.reserve(names_.size());
+  for (const ASTIdentifier* name : names_) {
+    ret.push_back(name->GetAsIdString());
+  }
+  return ret;
+}
+
 std::string ASTParameterExpr::SingleNodeDebugString() const {
   if (name() != nullptr) {
     return ASTNode::SingleNodeDebugString();
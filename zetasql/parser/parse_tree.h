@@ -18,6 +18,7 @@
 #define ZETASQL_PARSER_PARSE_TREE_H_
 
 #include <stddef.h>
+#include <functional>
 #include <set>
 #include <string>
 #include <type_traits>
@@ -32,7 +33,6 @@
 #include "zetasql/public/parse_location.h"
 #include "zetasql/public/type.pb.h"
 #include "absl/base/attributes.h"
-#include "absl/container/inlined_vector.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
@@ -42,7 +42,7 @@
 // This header file has definitions for the AST classes.
 //
 // During the AST construction process, AddChild / AddChildren() add to the
-// children_ vector.  In InitFields(), we store pointers to children into named
+// children_ array.  In InitFields(), we store pointers to children into named
 // member fields with more specific types.  This allows users to navigate to
 // specific child objects directly.
 //
@@ -125,14 +125,14 @@ class ASTNode : public zetasql_base::ArenaOnlyGladiator {
 
   // Access to child nodes with generic types.
   int num_children() const {
-    return children_.size();
+    return num_children_;
   }
   const ASTNode* child(int i) const { return children_[i]; }
   ASTNode* mutable_child(int i) { return children_[i]; }
 
   // Returns the index of the first child of a node kind or -1 if not found.
   int find_child_index(ASTNodeKind kind) const {
-    for (int i = 0; i < children_.size(); i++) {
+    for (int i = 0; i < num_children_; i++) {
       if (children_[i]->node_kind_ == kind) {
         return i;
       }
@@ -207,6 +207,18 @@ class ASTNode : public zetasql_base::ArenaOnlyGladiator {
   // Visit children in order.
   void ChildrenAccept(ParseTreeVisitor* visitor, void* data) const;
 
+  // Traverses this node and its descendants in depth-first order using an
+  // explicit stack instead of recursion, so arbitrarily deep trees (e.g. long
+  // generated OR chains) can be traversed on small thread stacks.
+  //
+  // <pre_visit> is called on each node before its children.  If it returns
+  // false, the children of that node are skipped.  <post_visit> is called
+  // after the children, for every node <pre_visit> was called on.  Either
+  // callback may be empty.
+  void TraverseNonRecursive(
+      const std::function<bool(const ASTNode*)>& pre_visit,
+      const std::function<void(const ASTNode*)>& post_visit) const;
+
   std::string DebugString(int max_depth = 512) const;
 
   // Moves the start location forward by 'bytes' byte positions.
@@ -411,6 +423,13 @@ class ASTNode : public zetasql_base::ArenaOnlyGladiator {
  private:
   friend class ::zetasql::parser::BisonParser;
 
+  // Makes AddChild / AddChildren() allocate the child list in <arena>, which
+  // must outlive this node.  Must be called before any children are added.
+  void set_children_arena(zetasql_base::UnsafeArena* arena) {
+    DCHECK(children_ == nullptr);
+    children_arena_ = arena;
+  }
+
   // Helper class for DebugString().
   class Dumper {
    public:
@@ -440,8 +459,19 @@ class ASTNode : public zetasql_base::ArenaOnlyGladiator {
 
   ParseLocationRange parse_location_range_;
 
-  // Many nodes have one to two children, so InlinedVector saves allocations.
-  absl::InlinedVector<ASTNode*, 4> children_;
+  // Makes room for at least <min_capacity> children.
+  void ReserveChildren(int min_capacity);
+
+  // The children of this node, in an array of <children_capacity_> with the
+  // first <num_children_> used.  The array is allocated in <children_arena_>
+  // if it is set, which the parser does for all of the nodes it creates, so
+  // that parsing does not allocate on the heap per node and freeing the AST
+  // does not free the child lists one by one.  Otherwise it is allocated on
+  // the heap and owned.
+  ASTNode** children_ = nullptr;
+  int num_children_ = 0;
+  int children_capacity_ = 0;
+  zetasql_base::UnsafeArena* children_arena_ = nullptr;  // Not owned.
 };
 
 // This is a fake ASTNode implementation that exists only for tests,
@@ -2319,6 +2349,10 @@ class ASTPathExpression final : public ASTGeneralizedPathExpression {
   // Return the vector of identifier strings (without quoting).
   std::vector<std::string> ToIdentifierVector() const;
 
+  // Return the vector of identifiers as IdStrings.  Unlike
+  // ToIdentifierVector(), this does not copy the names.
+  std::vector<IdString> ToIdStringVector() const;
+
  private:
   void InitFields() final {
     FieldLoader fl(this);
@@ -0,0 +1,698 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/parser/parse_tree_serializer.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "zetasql/parser/parse_tree.h"
+#include "zetasql/public/id_string.h"
+#include "zetasql/public/parse_location.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "zetasql/base/arena.h"
+#include "zetasql/base/canonical_errors.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+
+namespace {
+
+// Version of the encoding, written first.  Change it whenever the encoding
+// changes in a way that the ASTNodeKind values and node fields don't cover.
+constexpr uint64_t kFormatVersion = 1;
+
+// The maximum nesting depth that DeserializeParseTree() accepts, to bound its
+// recursion on corrupt input.  The parser fails on much shallower trees.
+constexpr int kMaxDepth = 10000;
+
+void PutVarint(uint64_t value, std::string* output) {
+  while (value >= 0x80) {
+    output->push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  output->push_back(static_cast<char>(value));
+}
+
+bool GetVarint(absl::string_view* input, uint64_t* value) {
+  uint64_t result = 0;
+  for (int shift = 0; shift < 64 && !input->empty(); shift += 7) {
+    const uint8_t byte = static_cast<uint8_t>(input->front());
+    input->remove_prefix(1);
+    result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+uint64_t ZigZagEncode(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+int64_t ZigZagDecode(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// Calls archive->Field(value, setter) for each field of <node> that is not a
+// child pointer, with the current value of the field and a function that sets
+// it.  ParseTreeWriter only reads the values and ParseTreeReader only calls
+// the setters, so this lists the fields once for both of them.
+//
+// Every node field that the parser sets must be listed here.
+template <typename Archive>
+void TransferFields(ASTNode* node, Archive* archive) {
+  if (ASTExpression* expression = node->GetAsOrNull<ASTExpression>()) {
+    archive->Field(expression->parenthesized(),
+                   [expression](bool v) { expression->set_parenthesized(v); });
+  }
+  if (ASTLeaf* leaf = node->GetAsOrNull<ASTLeaf>()) {
+    archive->Field(leaf->image(), [leaf](absl::string_view v) {
+      leaf->set_image(std::string(v));
+    });
+  }
+  if (ASTQueryExpression* query_expression =
+          node->GetAsOrNull<ASTQueryExpression>()) {
+    archive->Field(query_expression->parenthesized(),
+                   [query_expression](bool v) {
+                     query_expression->set_parenthesized(v);
+                   });
+  }
+  if (ASTCreateStatement* create = node->GetAsOrNull<ASTCreateStatement>()) {
+    archive->Field(create->scope(), [create](ASTCreateStatement::Scope v) {
+      create->set_scope(v);
+    });
+    archive->Field(create->is_or_replace(),
+                   [create](bool v) { create->set_is_or_replace(v); });
+    archive->Field(create->is_if_not_exists(),
+                   [create](bool v) { create->set_is_if_not_exists(v); });
+  }
+  if (ASTCreateFunctionStmtBase* create =
+          node->GetAsOrNull<ASTCreateFunctionStmtBase>()) {
+    archive->Field(create->sql_security(),
+                   [create](ASTCreateStatement::SqlSecurity v) {
+                     create->set_sql_security(v);
+                   });
+  }
+  if (ASTCreateViewStatementBase* create =
+          node->GetAsOrNull<ASTCreateViewStatementBase>()) {
+    archive->Field(create->sql_security(),
+                   [create](ASTCreateStatement::SqlSecurity v) {
+                     create->set_sql_security(v);
+                   });
+  }
+  if (ASTAlterStatementBase* alter =
+          node->GetAsOrNull<ASTAlterStatementBase>()) {
+    archive->Field(alter->is_if_exists(),
+                   [alter](bool v) { alter->set_is_if_exists(v); });
+  }
+  if (ASTBreakContinueStatement* statement =
+          node->GetAsOrNull<ASTBreakContinueStatement>()) {
+    archive->Field(statement->keyword(),
+                   [statement](ASTBreakContinueStatement::BreakContinueKeyword
+                                   v) { statement->set_keyword(v); });
+  }
+
+  switch (node->node_kind()) {
+    case AST_TRANSACTION_READ_WRITE_MODE: {
+      auto* n = node->GetAsOrDie<ASTTransactionReadWriteMode>();
+      archive->Field(n->mode(), [n](ASTTransactionReadWriteMode::Mode v) {
+        n->set_mode(v);
+      });
+      break;
+    }
+    case AST_DROP_STATEMENT: {
+      auto* n = node->GetAsOrDie<ASTDropStatement>();
+      archive->Field(n->schema_object_kind(),
+                     [n](SchemaObjectKind v) { n->set_schema_object_kind(v); });
+      archive->Field(n->is_if_exists(),
+                     [n](bool v) { n->set_is_if_exists(v); });
+      break;
+    }
+    case AST_DROP_FUNCTION_STATEMENT: {
+      auto* n = node->GetAsOrDie<ASTDropFunctionStatement>();
+      archive->Field(n->is_if_exists(),
+                     [n](bool v) { n->set_is_if_exists(v); });
+      break;
+    }
+    case AST_DROP_ROW_POLICY_STATEMENT: {
+      auto* n = node->GetAsOrDie<ASTDropRowPolicyStatement>();
+      archive->Field(n->is_if_exists(),
+                     [n](bool v) { n->set_is_if_exists(v); });
+      break;
+    }
+    case AST_DROP_MATERIALIZED_VIEW_STATEMENT: {
+      auto* n = node->GetAsOrDie<ASTDropMaterializedViewStatement>();
+      archive->Field(n->is_if_exists(),
+                     [n](bool v) { n->set_is_if_exists(v); });
+      break;
+    }
+    case AST_IMPORT_STATEMENT: {
+      auto* n = node->GetAsOrDie<ASTImportStatement>();
+      archive->Field(n->import_kind(), [n](ASTImportStatement::ImportKind v) {
+        n->set_import_kind(v);
+      });
+      break;
+    }
+    case AST_QUERY: {
+      auto* n = node->GetAsOrDie<ASTQuery>();
+      archive->Field(n->is_nested(), [n](bool v) { n->set_is_nested(v); });
+      break;
+    }
+    case AST_SET_OPERATION: {
+      auto* n = node->GetAsOrDie<ASTSetOperation>();
+      archive->Field(n->op_type(), [n](ASTSetOperation::OperationType v) {
+        n->set_op_type(v);
+      });
+      archive->Field(n->distinct(), [n](bool v) { n->set_distinct(v); });
+      break;
+    }
+    case AST_SELECT: {
+      auto* n = node->GetAsOrDie<ASTSelect>();
+      archive->Field(n->distinct(), [n](bool v) { n->set_distinct(v); });
+      break;
+    }
+    case AST_SELECT_AS: {
+      auto* n = node->GetAsOrDie<ASTSelectAs>();
+      archive->Field(n->as_mode(),
+                     [n](ASTSelectAs::AsMode v) { n->set_as_mode(v); });
+      break;
+    }
+    case AST_JOIN: {
+      auto* n = node->GetAsOrDie<ASTJoin>();
+      archive->Field(n->join_type(),
+                     [n](ASTJoin::JoinType v) { n->set_join_type(v); });
+      archive->Field(n->join_hint(),
+                     [n](ASTJoin::JoinHint v) { n->set_join_hint(v); });
+      archive->Field(n->natural(), [n](bool v) { n->set_natural(v); });
+      break;
+    }
+    case AST_ORDERING_EXPRESSION: {
+      auto* n = node->GetAsOrDie<ASTOrderingExpression>();
+      archive->Field(n->descending(), [n](bool v) { n->set_descending(v); });
+      break;
+    }
+    case AST_HAVING_MODIFIER: {
+      auto* n = node->GetAsOrDie<ASTHavingModifier>();
+      archive->Field(n->modifier_kind(),
+                     [n](ASTHavingModifier::ModifierKind v) {
+                       n->set_modifier_kind(v);
+                     });
+      break;
+    }
+    case AST_BINARY_EXPRESSION: {
+      auto* n = node->GetAsOrDie<ASTBinaryExpression>();
+      archive->Field(n->op(),
+                     [n](ASTBinaryExpression::Op v) { n->set_op(v); });
+      archive->Field(n->is_not(), [n](bool v) { n->set_is_not(v); });
+      break;
+    }
+    case AST_BITWISE_SHIFT_EXPRESSION: {
+      auto* n = node->GetAsOrDie<ASTBitwiseShiftExpression>();
+      archive->Field(n->is_left_shift(),
+                     [n](bool v) { n->set_is_left_shift(v); });
+      break;
+    }
+    case AST_IN_EXPRESSION: {
+      auto* n = node->GetAsOrDie<ASTInExpression>();
+      archive->Field(n->is_not(), [n](bool v) { n->set_is_not(v); });
+      break;
+    }
+    case AST_BETWEEN_EXPRESSION: {
+      auto* n = node->GetAsOrDie<ASTBetweenExpression>();
+      archive->Field(n->is_not(), [n](bool v) { n->set_is_not(v); });
+      break;
+    }
+    case AST_UNARY_EXPRESSION: {
+      auto* n = node->GetAsOrDie<ASTUnaryExpression>();
+      archive->Field(n->op(), [n](ASTUnaryExpression::Op v) { n->set_op(v); });
+      break;
+    }
+    case AST_CAST_EXPRESSION: {
+      auto* n = node->GetAsOrDie<ASTCastExpression>();
+      archive->Field(n->is_safe_cast(),
+                     [n](bool v) { n->set_is_safe_cast(v); });
+      break;
+    }
+    case AST_PARAMETER_EXPR: {
+      auto* n = node->GetAsOrDie<ASTParameterExpr>();
+      archive->Field(n->position(), [n](int v) { n->set_position(v); });
+      break;
+    }
+    case AST_FUNCTION_CALL: {
+      auto* n = node->GetAsOrDie<ASTFunctionCall>();
+      archive->Field(n->distinct(), [n](bool v) { n->set_distinct(v); });
+      archive->Field(n->null_handling_modifier(),
+                     [n](ASTFunctionCall::NullHandlingModifier v) {
+                       n->set_null_handling_modifier(v);
+                     });
+      archive->Field(n->is_current_date_time_without_parentheses(),
+                     [n](bool v) {
+                       n->set_is_current_date_time_without_parentheses(v);
+                     });
+      break;
+    }
+    case AST_WINDOW_FRAME_EXPR: {
+      auto* n = node->GetAsOrDie<ASTWindowFrameExpr>();
+      archive->Field(n->boundary_type(),
+                     [n](ASTWindowFrameExpr::BoundaryType v) {
+                       n->set_boundary_type(v);
+                     });
+      break;
+    }
+    case AST_WINDOW_FRAME: {
+      auto* n = node->GetAsOrDie<ASTWindowFrame>();
+      archive->Field(n->frame_unit(),
+                     [n](ASTWindowFrame::FrameUnit v) { n->set_unit(v); });
+      break;
+    }
+    case AST_EXPRESSION_SUBQUERY: {
+      auto* n = node->GetAsOrDie<ASTExpressionSubquery>();
+      archive->Field(n->modifier(), [n](ASTExpressionSubquery::Modifier v) {
+        n->set_modifier(v);
+      });
+      break;
+    }
+    case AST_IDENTIFIER: {
+      auto* n = node->GetAsOrDie<ASTIdentifier>();
+      archive->Field(n->GetAsIdString(),
+                     [n](IdString v) { n->SetIdentifier(v); });
+      break;
+    }
+    case AST_STRING_LITERAL: {
+      auto* n = node->GetAsOrDie<ASTStringLiteral>();
+      archive->Field(n->string_value(), [n](absl::string_view v) {
+        n->set_string_value(std::string(v));
+      });
+      break;
+    }
+    case AST_BYTES_LITERAL: {
+      auto* n = node->GetAsOrDie<ASTBytesLiteral>();
+      archive->Field(n->bytes_value(), [n](absl::string_view v) {
+        n->set_bytes_value(std::string(v));
+      });
+      break;
+    }
+    case AST_BOOLEAN_LITERAL: {
+      auto* n = node->GetAsOrDie<ASTBooleanLiteral>();
+      archive->Field(n->value(), [n](bool v) { n->set_value(v); });
+      break;
+    }
+    case AST_DATE_OR_TIME_LITERAL: {
+      auto* n = node->GetAsOrDie<ASTDateOrTimeLiteral>();
+      archive->Field(n->type_kind(),
+                     [n](TypeKind v) { n->set_type_kind(v); });
+      break;
+    }
+    case AST_FUNCTION_PARAMETER: {
+      auto* n = node->GetAsOrDie<ASTFunctionParameter>();
+      archive->Field(n->is_not_aggregate(),
+                     [n](bool v) { n->set_is_not_aggregate(v); });
+      archive->Field(n->procedure_parameter_mode(),
+                     [n](ASTFunctionParameter::ProcedureParameterMode v) {
+                       n->set_procedure_parameter_mode(v);
+                     });
+      break;
+    }
+    case AST_CREATE_FUNCTION_STATEMENT: {
+      auto* n = node->GetAsOrDie<ASTCreateFunctionStatement>();
+      archive->Field(n->is_aggregate(),
+                     [n](bool v) { n->set_is_aggregate(v); });
+      break;
+    }
+    case AST_CREATE_INDEX_STATEMENT: {
+      auto* n = node->GetAsOrDie<ASTCreateIndexStatement>();
+      archive->Field(n->is_unique(), [n](bool v) { n->set_is_unique(v); });
+      break;
+    }
+    case AST_TEMPLATED_PARAMETER_TYPE: {
+      auto* n = node->GetAsOrDie<ASTTemplatedParameterType>();
+      archive->Field(n->kind(),
+                     [n](ASTTemplatedParameterType::TemplatedTypeKind v) {
+                       n->set_kind(v);
+                     });
+      break;
+    }
+    case AST_GENERATED_COLUMN_INFO: {
+      auto* n = node->GetAsOrDie<ASTGeneratedColumnInfo>();
+      archive->Field(n->is_stored(), [n](bool v) { n->set_is_stored(v); });
+      break;
+    }
+    case AST_CHECK_CONSTRAINT: {
+      auto* n = node->GetAsOrDie<ASTCheckConstraint>();
+      archive->Field(n->is_enforced(), [n](bool v) { n->set_is_enforced(v); });
+      break;
+    }
+    case AST_COLUMN_POSITION: {
+      auto* n = node->GetAsOrDie<ASTColumnPosition>();
+      archive->Field(n->type(),
+                     [n](ASTColumnPosition::RelativePositionType v) {
+                       n->set_type(v);
+                     });
+      break;
+    }
+    case AST_INSERT_STATEMENT: {
+      auto* n = node->GetAsOrDie<ASTInsertStatement>();
+      archive->Field(n->parse_progress(),
+                     [n](ASTInsertStatement::ParseProgress v) {
+                       n->set_parse_progress(v);
+                     });
+      archive->Field(n->insert_mode(), [n](ASTInsertStatement::InsertMode v) {
+        n->set_insert_mode(v);
+      });
+      break;
+    }
+    case AST_MERGE_ACTION: {
+      auto* n = node->GetAsOrDie<ASTMergeAction>();
+      archive->Field(n->action_type(), [n](ASTMergeAction::ActionType v) {
+        n->set_action_type(v);
+      });
+      break;
+    }
+    case AST_MERGE_WHEN_CLAUSE: {
+      auto* n = node->GetAsOrDie<ASTMergeWhenClause>();
+      archive->Field(n->match_type(), [n](ASTMergeWhenClause::MatchType v) {
+        n->set_match_type(v);
+      });
+      break;
+    }
+    case AST_SAMPLE_SIZE: {
+      auto* n = node->GetAsOrDie<ASTSampleSize>();
+      archive->Field(n->unit(),
+                     [n](ASTSampleSize::Unit v) { n->set_unit(v); });
+      break;
+    }
+    case AST_ADD_CONSTRAINT_ACTION: {
+      auto* n = node->GetAsOrDie<ASTAddConstraintAction>();
+      archive->Field(n->is_if_not_exists(),
+                     [n](bool v) { n->set_is_if_not_exists(v); });
+      break;
+    }
+    case AST_DROP_CONSTRAINT_ACTION: {
+      auto* n = node->GetAsOrDie<ASTDropConstraintAction>();
+      archive->Field(n->is_if_exists(),
+                     [n](bool v) { n->set_is_if_exists(v); });
+      break;
+    }
+    case AST_ALTER_CONSTRAINT_ENFORCEMENT_ACTION: {
+      auto* n = node->GetAsOrDie<ASTAlterConstraintEnforcementAction>();
+      archive->Field(n->is_if_exists(),
+                     [n](bool v) { n->set_is_if_exists(v); });
+      archive->Field(n->is_enforced(), [n](bool v) { n->set_is_enforced(v); });
+      break;
+    }
+    case AST_ALTER_CONSTRAINT_SET_OPTIONS_ACTION: {
+      auto* n = node->GetAsOrDie<ASTAlterConstraintSetOptionsAction>();
+      archive->Field(n->is_if_exists(),
+                     [n](bool v) { n->set_is_if_exists(v); });
+      break;
+    }
+    case AST_ADD_COLUMN_ACTION: {
+      auto* n = node->GetAsOrDie<ASTAddColumnAction>();
+      archive->Field(n->is_if_not_exists(),
+                     [n](bool v) { n->set_is_if_not_exists(v); });
+      break;
+    }
+    case AST_DROP_COLUMN_ACTION: {
+      auto* n = node->GetAsOrDie<ASTDropColumnAction>();
+      archive->Field(n->is_if_exists(),
+                     [n](bool v) { n->set_is_if_exists(v); });
+      break;
+    }
+    case AST_FOREIGN_KEY_ACTIONS: {
+      auto* n = node->GetAsOrDie<ASTForeignKeyActions>();
+      archive->Field(n->update_action(), [n](ASTForeignKeyActions::Action v) {
+        n->set_update_action(v);
+      });
+      archive->Field(n->delete_action(), [n](ASTForeignKeyActions::Action v) {
+        n->set_delete_action(v);
+      });
+      break;
+    }
+    case AST_FOREIGN_KEY_REFERENCE: {
+      auto* n = node->GetAsOrDie<ASTForeignKeyReference>();
+      archive->Field(n->match(),
+                     [n](ASTForeignKeyReference::Match v) { n->set_match(v); });
+      archive->Field(n->enforced(), [n](bool v) { n->set_enforced(v); });
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+class ParseTreeWriter {
+ public:
+  explicit ParseTreeWriter(std::string* output) : output_(output) {}
+  ParseTreeWriter(const ParseTreeWriter&) = delete;
+  ParseTreeWriter& operator=(const ParseTreeWriter&) = delete;
+
+  void WriteTree(const ASTNode* root) {
+    PutVarint(kFormatVersion, output_);
+    WriteNode(root);
+  }
+
+  template <typename T, typename Setter>
+  void Field(const T& value, const Setter& /* setter */) {
+    Put(value);
+  }
+
+ private:
+  // Filenames are written once, at their first use, and then referred to
+  // by their index.  Index filenames_.size() means a new filename follows.
+  void PutFilename(absl::string_view filename) {
+    auto insert_result =
+        filenames_.emplace(filename, static_cast<int>(filenames_.size()));
+    PutVarint(insert_result.first->second, output_);
+    if (insert_result.second) {
+      Put(filename);
+    }
+  }
+
+  void WriteNode(const ASTNode* node) {
+    PutVarint(node->node_kind(), output_);
+    const ParseLocationRange& range = node->GetParseLocationRange();
+    PutFilename(range.start().filename());
+    PutFilename(range.end().filename());
+    PutVarint(range.start().GetByteOffset(), output_);
+    Put(static_cast<int64_t>(range.end().GetByteOffset()) -
+        range.start().GetByteOffset());
+    // TransferFields() only reads through the pointer when writing.
+    TransferFields(const_cast<ASTNode*>(node), this);
+    PutVarint(node->num_children(), output_);
+    for (int i = 0; i < node->num_children(); ++i) {
+      WriteNode(node->child(i));
+    }
+  }
+
+  void Put(bool value) { output_->push_back(value ? 1 : 0); }
+  void Put(int64_t value) { PutVarint(ZigZagEncode(value), output_); }
+  void Put(int value) { Put(static_cast<int64_t>(value)); }
+  void Put(absl::string_view value) {
+    PutVarint(value.size(), output_);
+    output_->append(value.data(), value.size());
+  }
+  void Put(const std::string& value) { Put(absl::string_view(value)); }
+  void Put(IdString value) { Put(value.ToStringView()); }
+  template <typename EnumT>
+  typename std::enable_if<std::is_enum<EnumT>::value>::type Put(EnumT value) {
+    Put(static_cast<int64_t>(value));
+  }
+
+  std::string* output_;  // Not owned.
+  absl::flat_hash_map<absl::string_view, int> filenames_;
+};
+
+class ParseTreeReader {
+ public:
+  ParseTreeReader(absl::string_view input, IdStringPool* id_string_pool,
+                  zetasql_base::UnsafeArena* arena)
+      : input_(input), id_string_pool_(id_string_pool), arena_(arena) {}
+  ParseTreeReader(const ParseTreeReader&) = delete;
+  ParseTreeReader& operator=(const ParseTreeReader&) = delete;
+
+  zetasql_base::Status ReadTree(
+      std::unique_ptr<ASTNode>* output,
+      std::vector<std::unique_ptr<ASTNode>>* other_allocated_ast_nodes) {
+    uint64_t version;
+    if (!GetVarint(&input_, &version) || version != kFormatVersion) {
+      return zetasql_base::InvalidArgumentError(
+          "Unsupported serialized parse tree version");
+    }
+    // On errors, <nodes_> deletes the nodes read so far.
+    if (!ReadNode(/*depth=*/0) || !input_.empty()) {
+      return zetasql_base::InvalidArgumentError("Corrupt serialized parse tree");
+    }
+    // The root is read first.
+    *output = std::move(nodes_.front());
+    other_allocated_ast_nodes->clear();
+    other_allocated_ast_nodes->reserve(nodes_.size() - 1);
+    for (int i = 1; i < nodes_.size(); ++i) {
+      other_allocated_ast_nodes->push_back(std::move(nodes_[i]));
+    }
+    return ::zetasql_base::OkStatus();
+  }
+
+  template <typename T, typename Setter>
+  void Field(const T& /* value */, const Setter& setter) {
+    T value{};
+    if (!Get(&value)) {
+      ok_ = false;
+    }
+    setter(value);
+  }
+
+ private:
+  bool GetFilename(absl::string_view* filename) {
+    uint64_t index;
+    if (!GetVarint(&input_, &index) || index > filenames_.size()) {
+      return false;
+    }
+    if (index == filenames_.size()) {
+      absl::string_view new_filename;
+      if (!Get(&new_filename)) return false;
+      filenames_.push_back(id_string_pool_->Make(new_filename).ToStringView());
+    }
+    *filename = filenames_[index];
+    return true;
+  }
+
+  // Reads a node and its descendants, and appends them to <nodes_>.
+  // Returns NULL on corrupt input.
+  ASTNode* ReadNode(int depth) {
+    uint64_t kind;
+    if (depth > kMaxDepth || !GetVarint(&input_, &kind) ||
+        kind > static_cast<uint64_t>(kLastASTNodeKind)) {
+      return nullptr;
+    }
+    ASTNode* node = NewNode(static_cast<ASTNodeKind>(kind), arena_);
+    if (node == nullptr) return nullptr;
+    nodes_.push_back(std::unique_ptr<ASTNode>(node));
+
+    absl::string_view start_filename;
+    absl::string_view end_filename;
+    uint64_t start_offset;
+    int64_t length;
+    if (!GetFilename(&start_filename) || !GetFilename(&end_filename) ||
+        !GetVarint(&input_, &start_offset) || !Get(&length)) {
+      return nullptr;
+    }
+    node->set_start_location(ParseLocationPoint::FromByteOffset(
+        start_filename, static_cast<int>(start_offset)));
+    node->set_end_location(ParseLocationPoint::FromByteOffset(
+        end_filename, static_cast<int>(start_offset + length)));
+
+    TransferFields(node, this);
+    uint64_t num_children;
+    if (!ok_ || !GetVarint(&input_, &num_children) ||
+        num_children > input_.size()) {
+      return nullptr;
+    }
+    for (uint64_t i = 0; i < num_children; ++i) {
+      ASTNode* child = ReadNode(depth + 1);
+      if (child == nullptr) return nullptr;
+      node->AddChild(child);
+    }
+    node->InitFields();
+    return node;
+  }
+
+  // Returns a new node of <kind> allocated in <arena>, or NULL if <kind> is
+  // not the kind of a non-abstract node class.
+  static ASTNode* NewNode(ASTNodeKind kind, zetasql_base::UnsafeArena* arena) {
+    switch (kind) {
+#include "zetasql/parser/parse_tree_node_factory.inc"
+      default:
+        return nullptr;
+    }
+  }
+
+  bool Get(bool* value) {
+    uint64_t v;
+    if (!GetVarint(&input_, &v) || v > 1) return false;
+    *value = (v != 0);
+    return true;
+  }
+  bool Get(int64_t* value) {
+    uint64_t v;
+    if (!GetVarint(&input_, &v)) return false;
+    *value = ZigZagDecode(v);
+    return true;
+  }
+  bool Get(int* value) {
+    int64_t v;
+    if (!Get(&v)) return false;
+    *value = static_cast<int>(v);
+    return true;
+  }
+  bool Get(absl::string_view* value) {
+    uint64_t size;
+    if (!GetVarint(&input_, &size) || size > input_.size()) return false;
+    *value = input_.substr(0, size);
+    input_.remove_prefix(size);
+    return true;
+  }
+  bool Get(std::string* value) {
+    absl::string_view v;
+    if (!Get(&v)) return false;
+    *value = std::string(v);
+    return true;
+  }
+  bool Get(IdString* value) {
+    absl::string_view v;
+    if (!Get(&v)) return false;
+    *value = id_string_pool_->Make(v);
+    return true;
+  }
+  template <typename EnumT>
+  typename std::enable_if<std::is_enum<EnumT>::value, bool>::type Get(
+      EnumT* value) {
+    int64_t v;
+    if (!Get(&v)) return false;
+    *value = static_cast<EnumT>(v);
+    return true;
+  }
+
+  absl::string_view input_;
+  IdStringPool* id_string_pool_;  // Not owned.
+  zetasql_base::UnsafeArena* arena_;     // Not owned.
+  std::vector<absl::string_view> filenames_;
+  std::vector<std::unique_ptr<ASTNode>> nodes_;
+  bool ok_ = true;
+};
+
+}  // namespace
+
+void SerializeParseTree(const ASTNode& root, std::string* output) {
+  ParseTreeWriter(output).WriteTree(&root);
+}
+
+zetasql_base::Status DeserializeParseTree(
+    absl::string_view input, IdStringPool* id_string_pool,
+    zetasql_base::UnsafeArena* arena, std::unique_ptr<ASTNode>* output,
+    std::vector<std::unique_ptr<ASTNode>>* other_allocated_ast_nodes) {
+  return ParseTreeReader(input, id_string_pool, arena)
+      .ReadTree(output, other_allocated_ast_nodes);
+}
+
+}  // namespace zetasql
@@ -0,0 +1,56 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PARSER_PARSE_TREE_SERIALIZER_H_
+#define ZETASQL_PARSER_PARSE_TREE_SERIALIZER_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/arena.h"
+#include "zetasql/parser/parse_tree.h"
+#include "zetasql/public/id_string.h"
+#include "absl/strings/string_view.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+
+// Appends a compact binary encoding of the parse tree rooted at <root> to
+// <output>.  The encoding has the kind, the location and the non-child fields
+// of each node, with integers as varints, and the children of each node after
+// it.  Nodes that the parser allocated but that are not in the tree are not
+// included.
+//
+// The encoding depends on the ASTNodeKind values and the node fields of this
+// build, so it must only be read back by the same build of ZetaSQL.  Callers
+// that store it, as ParseCache does, must key it by their build.
+void SerializeParseTree(const ASTNode& root, std::string* output);
+
+// Reconstructs a parse tree written by SerializeParseTree().  As with the
+// parser, the root is returned in <output> and <other_allocated_ast_nodes>
+// owns all the other nodes.  The nodes are allocated in <arena>, and the
+// IdStrings and the filenames of the parse locations in <id_string_pool>,
+// which must both outlive the tree.  Returns an error if <input> is not a
+// valid encoding, and then leaves the outputs unchanged.
+zetasql_base::Status DeserializeParseTree(
+    absl::string_view input, IdStringPool* id_string_pool,
+    zetasql_base::UnsafeArena* arena, std::unique_ptr<ASTNode>* output,
+    std::vector<std::unique_ptr<ASTNode>>* other_allocated_ast_nodes);
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PARSER_PARSE_TREE_SERIALIZER_H_
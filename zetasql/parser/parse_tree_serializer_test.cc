@@ -0,0 +1,143 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/parser/parse_tree_serializer.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/arena.h"
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/parser/parse_tree.h"
+#include "zetasql/parser/parser.h"
+#include "zetasql/public/id_string.h"
+#include "zetasql/public/parse_resume_location.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/string_view.h"
+
+namespace zetasql {
+namespace {
+
+using zetasql_base::testing::StatusIs;
+
+// Serializes <root>, deserializes it, and checks that the result prints and
+// unparses the same as <root>.
+void ExpectRoundTrip(const ASTNode& root) {
+  std::string serialized;
+  SerializeParseTree(root, &serialized);
+
+  zetasql_base::UnsafeArena arena(/*block_size=*/4096);
+  IdStringPool id_string_pool;
+  std::unique_ptr<ASTNode> output;
+  std::vector<std::unique_ptr<ASTNode>> other_allocated_ast_nodes;
+  ZETASQL_ASSERT_OK(DeserializeParseTree(serialized, &id_string_pool, &arena,
+                                 &output, &other_allocated_ast_nodes));
+  EXPECT_EQ(root.DebugString(), output->DebugString());
+  EXPECT_EQ(Unparse(&root), Unparse(output.get()));
+  EXPECT_EQ(nullptr, output->parent());
+}
+
+TEST(ParseTreeSerializerTest, RoundTripStatements) {
+  for (const std::string& sql : std::vector<std::string>{
+           "SELECT 1",
+           "SELECT DISTINCT a, b AS c FROM t WHERE x IS NOT NULL",
+           "SELECT AS STRUCT 1 a, 'x' b",
+           "SELECT * EXCEPT (a) REPLACE (1 AS b) FROM t",
+           "(SELECT 1) UNION ALL SELECT 2 ORDER BY 1 DESC LIMIT 3",
+           "SELECT a FROM t1 NATURAL LEFT JOIN t2 CROSS JOIN t3 "
+           "FULL OUTER HASH JOIN t4 USING (k)",
+           "SELECT COUNT(DISTINCT x IGNORE NULLS), CURRENT_DATE, "
+           "SUM(y) OVER (PARTITION BY z ORDER BY w "
+           "ROWS BETWEEN 2 PRECEDING AND CURRENT ROW) FROM t",
+           "SELECT x NOT IN (1, 2), y NOT BETWEEN 1 AND 2, NOT z, -w, "
+           "a << 2, b >> 1, SAFE_CAST(c AS INT64), @p, ?",
+           "SELECT b'bytes', r'raw', DATE '2019-01-01', TRUE, 1.5, "
+           "EXISTS(SELECT 1), ARRAY(SELECT 1), (SELECT 1), `quoted id`",
+           "SELECT a FROM t TABLESAMPLE RESERVOIR (10 ROWS)",
+           "DROP TABLE IF EXISTS a.b",
+           "CREATE OR REPLACE TEMP TABLE IF NOT EXISTS t (a INT64 NOT NULL, "
+           "b STRING AS (UPPER(a)) STORED, CHECK (a > 0) NOT ENFORCED)",
+           "CREATE TEMP AGGREGATE FUNCTION f(x INT64 NOT AGGREGATE) "
+           "RETURNS INT64 SQL SECURITY INVOKER AS (x)",
+           "CREATE UNIQUE INDEX i ON t(a)",
+           "CREATE VIEW v SQL SECURITY DEFINER AS SELECT 1",
+           "ALTER TABLE IF EXISTS t ADD COLUMN IF NOT EXISTS c INT64, "
+           "DROP COLUMN IF EXISTS d",
+           "INSERT OR REPLACE INTO t (a) VALUES (1), (2)",
+           "MERGE t USING s ON t.a = s.a "
+           "WHEN MATCHED THEN DELETE "
+           "WHEN NOT MATCHED BY SOURCE THEN UPDATE SET a = 1 "
+           "WHEN NOT MATCHED THEN INSERT ROW",
+           "IMPORT PROTO 'a/b.proto'",
+           "START TRANSACTION READ ONLY",
+       }) {
+    SCOPED_TRACE(sql);
+    std::unique_ptr<ParserOutput> parser_output;
+    ZETASQL_ASSERT_OK(ParseStatement(sql, ParserOptions(), &parser_output));
+    ExpectRoundTrip(*parser_output->statement());
+  }
+}
+
+TEST(ParseTreeSerializerTest, RoundTripScript) {
+  std::unique_ptr<ParserOutput> parser_output;
+  ZETASQL_ASSERT_OK(ParseScript("LOOP BREAK; CONTINUE; END LOOP;", ParserOptions(),
+                        ERROR_MESSAGE_WITH_PAYLOAD, &parser_output));
+  ExpectRoundTrip(*parser_output->script());
+}
+
+TEST(ParseTreeSerializerTest, KeepsFilenames) {
+  ParseResumeLocation resume_location =
+      ParseResumeLocation::FromString("file.sql", "SELECT a + 1");
+  std::unique_ptr<ParserOutput> parser_output;
+  bool at_end_of_input;
+  ZETASQL_ASSERT_OK(ParseNextStatement(&resume_location, ParserOptions(),
+                               &parser_output, &at_end_of_input));
+  ExpectRoundTrip(*parser_output->statement());
+  EXPECT_EQ("file.sql",
+            parser_output->statement()->GetParseLocationRange().start()
+                .filename());
+}
+
+TEST(ParseTreeSerializerTest, RejectsCorruptInput) {
+  std::unique_ptr<ParserOutput> parser_output;
+  ZETASQL_ASSERT_OK(ParseStatement("SELECT a, f(b) FROM t", ParserOptions(),
+                           &parser_output));
+  std::string serialized;
+  SerializeParseTree(*parser_output->statement(), &serialized);
+
+  zetasql_base::UnsafeArena arena(/*block_size=*/4096);
+  IdStringPool id_string_pool;
+  std::unique_ptr<ASTNode> output;
+  std::vector<std::unique_ptr<ASTNode>> other_allocated_ast_nodes;
+  // Every proper prefix fails, and leaves the outputs unchanged.
+  for (int size = 0; size < serialized.size(); ++size) {
+    EXPECT_THAT(
+        DeserializeParseTree(absl::string_view(serialized).substr(0, size),
+                             &id_string_pool, &arena, &output,
+                             &other_allocated_ast_nodes),
+        StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+    EXPECT_EQ(nullptr, output);
+    EXPECT_TRUE(other_allocated_ast_nodes.empty());
+  }
+  EXPECT_THAT(DeserializeParseTree(serialized + "x", &id_string_pool, &arena,
+                                   &output, &other_allocated_ast_nodes),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace zetasql
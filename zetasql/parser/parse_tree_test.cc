@@ -247,6 +247,63 @@ TEST(ParseTreeTest, NodeKindCategories_LiteralExpression) {
   EXPECT_FALSE(expr->IsTableExpression());
 }
 
+TEST(ParseTreeTest, ManyChildren) {
+  // The child list of the select list grows one child at a time in the
+  // parser arena.
+  std::string sql = "SELECT c0";
+  for (int i = 1; i < 100; ++i) {
+    absl::StrAppend(&sql, ", c", i);
+  }
+
+  std::unique_ptr<ParserOutput> parser_output;
+  ZETASQL_ASSERT_OK(ParseStatement(sql, ParserOptions(), &parser_output));
+  const ASTQueryStatement* statement =
+      parser_output->statement()->GetAsOrDie<ASTQueryStatement>();
+  const ASTSelectList* select_list =
+      statement->query()->query_expr()->GetAsOrDie<ASTSelect>()->select_list();
+  ASSERT_EQ(100, select_list->num_children());
+  ASSERT_EQ(100, select_list->columns().size());
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(select_list, select_list->child(i)->parent());
+    EXPECT_EQ(select_list->child(i), select_list->columns()[i]);
+    EXPECT_EQ(absl::StrCat("c", i),
+              select_list->columns()[i]
+                  ->expression()
+                  ->GetAsOrDie<ASTPathExpression>()
+                  ->first_name()
+                  ->GetAsString());
+  }
+}
+
+// Appends the DebugString() of <node> at <depth>, recursively.
+static void AppendExpectedDebugString(const ASTNode* node, int depth,
+                                      std::string* out) {
+  absl::StrAppend(out, std::string(depth * 2, ' '),
+                  node->SingleNodeDebugString(), " [",
+                  node->GetLocationString(), "]\n");
+  for (int i = 0; i < node->num_children(); ++i) {
+    if (node->child(i) != nullptr) {
+      AppendExpectedDebugString(node->child(i), depth + 1, out);
+    }
+  }
+}
+
+TEST(ParseTreeTest, DebugStringWithManyChildren) {
+  std::unique_ptr<ParserOutput> parser_output;
+  ZETASQL_ASSERT_OK(ParseStatement("SELECT a, b + 1, f(c, d, e) FROM t",
+                           ParserOptions(), &parser_output));
+  const ASTStatement* statement = parser_output->statement();
+  std::string expected;
+  AppendExpectedDebugString(statement, /*depth=*/0, &expected);
+  const std::string debug_string = statement->DebugString();
+  EXPECT_EQ(expected, debug_string);
+  // Every child of the select list and of the call is dumped.
+  for (const char* name : {"Identifier(a)", "Identifier(b)", "Identifier(c)",
+                           "Identifier(d)", "Identifier(e)", "Identifier(t)"}) {
+    EXPECT_THAT(debug_string, ::testing::HasSubstr(name));
+  }
+}
+
 TEST(ParseTreeTest, GetDescendantsWithKinds) {
   const std::string sql =
       "select * from (select 1+0x2, x+y), "
@@ -310,5 +367,44 @@ TEST(ParseTreeTest, GetDescendantsWithKinds) {
   EXPECT_EQ("BinaryExpression:6 SetOperation:1", CountNodeKinds(found_nodes));
 }
 
+TEST(ParseTreeTest, TraverseNonRecursive) {
+  const std::string sql = "select f(x+y), (select 1)";
+  std::unique_ptr<ParserOutput> parser_output;
+  ZETASQL_ASSERT_OK(ParseStatement(sql, ParserOptions(), &parser_output));
+  const ASTStatement* statement = parser_output->statement();
+
+  // Pre and post visits nest like the tree, and skipped subtrees are not
+  // entered.
+  std::vector<const ASTNode*> stack;
+  int num_nodes = 0;
+  int num_int_literals = 0;
+  statement->TraverseNonRecursive(
+      [&](const ASTNode* node) {
+        if (!stack.empty()) {
+          EXPECT_EQ(stack.back(), node->parent());
+        }
+        stack.push_back(node);
+        ++num_nodes;
+        if (node->node_kind() == AST_INT_LITERAL) ++num_int_literals;
+        return node->node_kind() != AST_FUNCTION_CALL;
+      },
+      [&](const ASTNode* node) {
+        ASSERT_FALSE(stack.empty());
+        EXPECT_EQ(stack.back(), node);
+        stack.pop_back();
+      });
+  EXPECT_TRUE(stack.empty());
+  EXPECT_EQ(1, num_int_literals);
+
+  int num_all_nodes = 0;
+  statement->TraverseNonRecursive(
+      [&num_all_nodes](const ASTNode*) {
+        ++num_all_nodes;
+        return true;
+      },
+      nullptr);
+  EXPECT_LT(num_nodes, num_all_nodes);
+}
+
 }  // namespace
 }  // namespace zetasql
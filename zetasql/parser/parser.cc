@@ -16,6 +16,7 @@
 
 #include "zetasql/parser/parser.h"
 
+#include <cstdint>
 #include <memory>
 
 #include "zetasql/base/logging.h"
@@ -25,6 +26,7 @@
 #include "zetasql/parser/parse_tree.h"
 #include "zetasql/parser/parse_tree_errors.h"
 #include "zetasql/parser/parse_tree_visitor.h"
+#include "zetasql/parser/simple_expression_parser.h"
 #include "zetasql/public/id_string.h"
 #include "zetasql/public/options.pb.h"
 #include "zetasql/public/parse_resume_location.h"
@@ -103,6 +105,7 @@ zetasql_base::Status ParseStatement(absl::string_view statement_string,
   *output = absl::make_unique<ParserOutput>(
       parser_options.id_string_pool(), parser_options.arena(),
       std::move(other_allocated_ast_nodes), std::move(statement));
+  (*output)->set_num_tokens(parser.num_tokens());
   return ::zetasql_base::OkStatus();
 }
 
@@ -135,6 +138,7 @@ zetasql_base::Status ParseScript(absl::string_view script_string,
   *output = absl::make_unique<ParserOutput>(
       parser_options.id_string_pool(), parser_options.arena(),
       std::move(other_allocated_ast_nodes), std::move(script));
+  (*output)->set_num_tokens(parser.num_tokens());
   return ::zetasql_base::OkStatus();
 }
 
@@ -182,6 +186,7 @@ zetasql_base::Status ParseNextStatementInternal(ParseResumeLocation* resume_loca
   *output = absl::make_unique<ParserOutput>(
       parser_options.id_string_pool(), parser_options.arena(),
       std::move(other_allocated_ast_nodes), std::move(statement));
+  (*output)->set_num_tokens(parser.num_tokens());
   return ::zetasql_base::OkStatus();
 }
 }  // namespace
@@ -228,6 +233,7 @@ zetasql_base::Status ParseType(absl::string_view type_string,
   *output = absl::make_unique<ParserOutput>(
       parser_options.id_string_pool(), parser_options.arena(),
       std::move(other_allocated_ast_nodes), std::move(type));
+  (*output)->set_num_tokens(parser.num_tokens());
   return ::zetasql_base::OkStatus();
 }
 
@@ -237,9 +243,27 @@ zetasql_base::Status ParseExpression(absl::string_view expression_string,
   ParserOptions parser_options = parser_options_in;
   parser_options.CreateDefaultArenasIfNotSet();
 
-  parser::BisonParser parser;
   std::unique_ptr<ASTNode> ast_node;
   std::vector<std::unique_ptr<ASTNode>> other_allocated_ast_nodes;
+  // Most expressions parsed on their own are small, and the hand-written
+  // parser handles them without the Bison parser.  It gives up on anything
+  // it does not handle, including all errors.
+  int64_t num_tokens;
+  if (parser::ParseSimpleExpression(
+          expression_string, parser_options.id_string_pool().get(),
+          parser_options.arena().get(), &ast_node, &other_allocated_ast_nodes,
+          &num_tokens)) {
+    ZETASQL_RET_CHECK(ast_node->IsExpression());
+    std::unique_ptr<ASTExpression> expression(
+        ast_node.release()->GetAsOrDie<ASTExpression>());
+    *output = absl::make_unique<ParserOutput>(
+        parser_options.id_string_pool(), parser_options.arena(),
+        std::move(other_allocated_ast_nodes), std::move(expression));
+    (*output)->set_num_tokens(num_tokens);
+    return ::zetasql_base::OkStatus();
+  }
+
+  parser::BisonParser parser;
   zetasql_base::Status status = parser.Parse(
       BisonParserMode::kExpression, /* filename = */ absl::string_view(),
       expression_string, 0 /* offset */, parser_options.id_string_pool().get(),
@@ -257,6 +281,7 @@ zetasql_base::Status ParseExpression(absl::string_view expression_string,
       parser_options.id_string_pool(), parser_options.arena(),
       std::move(other_allocated_ast_nodes),
       std::move(expression));
+  (*output)->set_num_tokens(parser.num_tokens());
   return ::zetasql_base::OkStatus();
 }
 
@@ -286,6 +311,7 @@ zetasql_base::Status ParseExpression(const ParseResumeLocation& resume_location,
       parser_options.id_string_pool(), parser_options.arena(),
       std::move(other_allocated_ast_nodes),
       std::move(expression));
+  (*output)->set_num_tokens(parser.num_tokens());
   return ::zetasql_base::OkStatus();
 }
 
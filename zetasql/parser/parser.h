@@ -17,6 +17,8 @@
 #ifndef ZETASQL_PARSER_PARSER_H_
 #define ZETASQL_PARSER_PARSER_H_
 
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 #include <utility>
@@ -115,6 +117,15 @@ class ParserOutput {
   // ParserOptions.
   const std::shared_ptr<zetasql_base::UnsafeArena>& arena() const { return arena_; }
 
+  // Returns the number of tokens the parser read to produce this output.
+  int64_t num_tokens() const { return num_tokens_; }
+  void set_num_tokens(int64_t num_tokens) { num_tokens_ = num_tokens; }
+
+  // Returns the number of ASTNodes in the parse tree.
+  int64_t num_ast_nodes() const {
+    return static_cast<int64_t>(other_allocated_ast_nodes_.size()) + 1;
+  }
+
  private:
   template<class T>
       T* GetNodeAs() const {
@@ -133,6 +144,8 @@ class ParserOutput {
   absl::variant<std::unique_ptr<ASTStatement>, std::unique_ptr<ASTScript>,
                 std::unique_ptr<ASTType>, std::unique_ptr<ASTExpression>>
       node_;
+
+  int64_t num_tokens_ = 0;
 };
 
 // Parses <statement_string> and returns the parser output in <output> upon
@@ -222,6 +235,13 @@ zetasql_base::Status ParseExpression(const ParseResumeLocation& resume_location,
 // Works for any AST node.
 std::string Unparse(const ASTNode* root);
 
+// Like above, but passes the SQL to <sink> a line at a time as it is
+// produced, instead of building the whole std::string.  Each line ends with
+// '\n'.  Memory use is bounded by the longest line, which makes this
+// suitable for very large scripts.
+void Unparse(const ASTNode* root,
+             const std::function<void(absl::string_view)>& sink);
+
 // Parse the first few keywords from <input> (ignoring whitespace, comments and
 // hints) to determine what kind of statement it is (if it is valid).
 //
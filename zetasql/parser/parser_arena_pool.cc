@@ -0,0 +1,78 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/parser/parser_arena_pool.h"
+
+#include <algorithm>
+#include <memory>
+
+#include "zetasql/public/id_string.h"
+
+namespace zetasql {
+
+constexpr size_t ParserArenaPool::kMinBlockSize;
+constexpr size_t ParserArenaPool::kMaxBlockSize;
+constexpr size_t ParserArenaPool::kArenaBytesPerInputByte;
+
+ParserArenaPool::ParserArenaPool(int max_pooled_arenas)
+    : max_pooled_arenas_(max_pooled_arenas) {}
+
+ParserArenaPool::~ParserArenaPool() {}
+
+std::shared_ptr<zetasql_base::UnsafeArena> ParserArenaPool::NewArena(
+    size_t block_size) {
+  ++num_arenas_created_;
+  return std::make_shared<zetasql_base::UnsafeArena>(block_size);
+}
+
+ParserOptions ParserArenaPool::GetParserOptions(absl::string_view input) {
+  return GetParserOptionsWithSizeHint(input.size() * kArenaBytesPerInputByte);
+}
+
+ParserOptions ParserArenaPool::GetParserOptionsWithSizeHint(size_t size_hint) {
+  const size_t hinted_block_size =
+      std::min(std::max(size_hint, kMinBlockSize), kMaxBlockSize);
+
+  std::shared_ptr<zetasql_base::UnsafeArena> arena;
+  for (std::shared_ptr<zetasql_base::UnsafeArena>& pooled_arena : arenas_) {
+    // The pool holds the only reference once every ParserOutput and
+    // IdStringPool using the arena is gone.
+    if (pooled_arena.use_count() != 1) continue;
+
+    // bytes_allocated() includes any overflow blocks from the last use,
+    // which makes it the high-water mark for this arena.
+    const size_t block_size = std::min(
+        std::max(pooled_arena->status().bytes_allocated(), hinted_block_size),
+        kMaxBlockSize);
+    if (block_size > pooled_arena->block_size()) {
+      pooled_arena = NewArena(block_size);
+    } else {
+      pooled_arena->Reset();
+      ++num_arenas_reused_;
+    }
+    arena = pooled_arena;
+    break;
+  }
+  if (arena == nullptr) {
+    arena = NewArena(hinted_block_size);
+    if (num_pooled_arenas() < max_pooled_arenas_) {
+      arenas_.push_back(arena);
+    }
+  }
+  return ParserOptions(std::make_shared<IdStringPool>(arena), arena);
+}
+
+}  // namespace zetasql
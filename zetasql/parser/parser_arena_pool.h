@@ -0,0 +1,103 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PARSER_PARSER_ARENA_POOL_H_
+#define ZETASQL_PARSER_PARSER_ARENA_POOL_H_
+
+#include <stddef.h>
+
+#include <memory>
+#include <vector>
+
+#include "zetasql/base/arena.h"
+#include "zetasql/parser/parser.h"
+#include "absl/strings/string_view.h"
+
+namespace zetasql {
+
+// Recycles parser arenas across statements, for batch workloads that parse
+// many statements one after another.
+//
+// GetParserOptions() returns ParserOptions with an arena and a fresh
+// IdStringPool for parsing one input.  The arena is taken from the pool when
+// one is free, i.e. when no ParserOutput, IdStringPool or ParserOptions
+// still refers to it, and is Reset() before it is reused.  Reset() keeps the
+// first block of the arena, and arenas whose last use outgrew their first
+// block are replaced by one whose first block covers that high-water mark,
+// so steady-state parsing does not allocate arena blocks.  A new arena's
+// first block is sized from the input length.
+//
+// Holding on to a ParserOutput keeps its arena out of the pool, so callers
+// should destroy each output before parsing the next statement.  When no
+// pooled arena is free, a new arena is created, and it is added to the pool
+// if the pool has room.
+//
+// Not thread-safe.  Each thread should use its own pool.
+//
+// Example:
+//   ParserArenaPool pool;
+//   for (absl::string_view sql : statements) {
+//     std::unique_ptr<ParserOutput> output;
+//     ZETASQL_RETURN_IF_ERROR(
+//         ParseStatement(sql, pool.GetParserOptions(sql), &output));
+//     ...
+//   }
+class ParserArenaPool {
+ public:
+  // Smallest and largest first block size for pooled arenas.  Inputs that
+  // need more than the largest size use overflow blocks as usual.
+  static constexpr size_t kMinBlockSize = 4096;
+  static constexpr size_t kMaxBlockSize = 1 << 20;
+
+  // Number of arena bytes to reserve per input byte when sizing a new
+  // arena from the input length.
+  static constexpr size_t kArenaBytesPerInputByte = 32;
+
+  // Keeps at most <max_pooled_arenas> arenas for reuse.
+  explicit ParserArenaPool(int max_pooled_arenas = 4);
+  ParserArenaPool(const ParserArenaPool&) = delete;
+  ParserArenaPool& operator=(const ParserArenaPool&) = delete;
+  ~ParserArenaPool();
+
+  // Returns options for parsing <input>.  <input> is only used as a size
+  // hint.
+  ParserOptions GetParserOptions(absl::string_view input);
+
+  // Returns options with an arena whose first block is at least
+  // <size_hint> bytes, clamped to [kMinBlockSize, kMaxBlockSize].
+  ParserOptions GetParserOptionsWithSizeHint(size_t size_hint);
+
+  int num_pooled_arenas() const { return static_cast<int>(arenas_.size()); }
+
+  // Stats for tests and monitoring.  <num_arenas_created> counts every
+  // arena allocated by the pool, including ones that replaced a pooled
+  // arena that was too small.  <num_arenas_reused> counts arenas that were
+  // Reset() and reused.
+  int num_arenas_created() const { return num_arenas_created_; }
+  int num_arenas_reused() const { return num_arenas_reused_; }
+
+ private:
+  std::shared_ptr<zetasql_base::UnsafeArena> NewArena(size_t block_size);
+
+  const int max_pooled_arenas_;
+  std::vector<std::shared_ptr<zetasql_base::UnsafeArena>> arenas_;
+  int num_arenas_created_ = 0;
+  int num_arenas_reused_ = 0;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PARSER_PARSER_ARENA_POOL_H_
@@ -0,0 +1,101 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/parser/parser_arena_pool.h"
+
+#include <memory>
+#include <string>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/parser/parse_tree.h"
+#include "zetasql/parser/parser.h"
+#include "gtest/gtest.h"
+
+namespace zetasql {
+
+TEST(ParserArenaPoolTest, ReusesFreeArenas) {
+  ParserArenaPool pool;
+  zetasql_base::UnsafeArena* first_arena;
+  {
+    ParserOptions options = pool.GetParserOptions("SELECT 1");
+    first_arena = options.arena().get();
+    ASSERT_NE(nullptr, options.id_string_pool());
+    EXPECT_EQ(ParserArenaPool::kMinBlockSize, first_arena->block_size());
+  }
+  ParserOptions options = pool.GetParserOptions("SELECT 2");
+  EXPECT_EQ(first_arena, options.arena().get());
+  EXPECT_EQ(1, pool.num_arenas_created());
+  EXPECT_EQ(1, pool.num_arenas_reused());
+
+  // <options> still holds the pooled arena, so a second arena is needed.
+  ParserOptions other_options = pool.GetParserOptions("SELECT 3");
+  EXPECT_NE(first_arena, other_options.arena().get());
+  EXPECT_EQ(2, pool.num_arenas_created());
+  EXPECT_EQ(2, pool.num_pooled_arenas());
+}
+
+TEST(ParserArenaPoolTest, LimitsPooledArenas) {
+  ParserArenaPool pool(/*max_pooled_arenas=*/1);
+  ParserOptions options1 = pool.GetParserOptions("SELECT 1");
+  ParserOptions options2 = pool.GetParserOptions("SELECT 2");
+  EXPECT_EQ(2, pool.num_arenas_created());
+  EXPECT_EQ(1, pool.num_pooled_arenas());
+}
+
+TEST(ParserArenaPoolTest, SizesArenasFromInputAndHighWaterMark) {
+  ParserArenaPool pool;
+  const std::string input(1000, ' ');
+  {
+    ParserOptions options = pool.GetParserOptions(input);
+    EXPECT_EQ(1000 * ParserArenaPool::kArenaBytesPerInputByte,
+              options.arena()->block_size());
+  }
+  {
+    ParserOptions options = pool.GetParserOptionsWithSizeHint(0);
+    // The arena from the larger input is reused as is.
+    EXPECT_EQ(1000 * ParserArenaPool::kArenaBytesPerInputByte,
+              options.arena()->block_size());
+    // Grow the arena past its first block.
+    for (int i = 0; i < 10; ++i) {
+      options.arena()->Alloc(options.arena()->block_size() / 2);
+    }
+  }
+  const size_t high_water = [&pool] {
+    ParserOptions options = pool.GetParserOptionsWithSizeHint(0);
+    return options.arena()->block_size();
+  }();
+  EXPECT_GT(high_water, 1000 * ParserArenaPool::kArenaBytesPerInputByte);
+  EXPECT_LE(high_water, ParserArenaPool::kMaxBlockSize);
+  EXPECT_EQ(2, pool.num_arenas_created());
+
+  const std::string huge_input(ParserArenaPool::kMaxBlockSize, ' ');
+  ParserOptions options = pool.GetParserOptions(huge_input);
+  EXPECT_EQ(ParserArenaPool::kMaxBlockSize, options.arena()->block_size());
+}
+
+TEST(ParserArenaPoolTest, ParsesWithPooledArenas) {
+  ParserArenaPool pool;
+  for (const std::string sql : {"SELECT 1", "SELECT a FROM t", "SELECT 3"}) {
+    std::unique_ptr<ParserOutput> output;
+    ZETASQL_ASSERT_OK(ParseStatement(sql, pool.GetParserOptions(sql), &output));
+    ASSERT_NE(nullptr, output->statement());
+    EXPECT_EQ(AST_QUERY_STATEMENT, output->statement()->node_kind());
+  }
+  EXPECT_EQ(1, pool.num_arenas_created());
+  EXPECT_EQ(2, pool.num_arenas_reused());
+}
+
+}  // namespace zetasql
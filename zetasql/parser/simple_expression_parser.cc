@@ -0,0 +1,904 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/parser/simple_expression_parser.h"
+
+#include <string>
+#include <utility>
+
+#include "zetasql/parser/bison_parser.bison.h"
+#include "zetasql/parser/bison_parser.h"
+#include "zetasql/parser/keywords.h"
+#include "zetasql/parser/location.hh"
+#include "zetasql/public/strings.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/memory/memory.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+namespace parser {
+namespace {
+
+using BisonToken = zetasql_bison_parser::BisonParserImpl::token;
+
+enum class TokenKind {
+  kEndOfInput,
+  kIdentifier,
+  kIntegerLiteral,
+  kFloatingPointLiteral,
+  kStringLiteral,
+  kKwAnd,
+  kKwAs,
+  kKwCase,
+  kKwCast,
+  kKwElse,
+  kKwEnd,
+  kKwFalse,
+  kKwIs,
+  kKwNot,
+  kKwNull,
+  kKwOr,
+  kKwSafeCast,
+  kKwThen,
+  kKwTrue,
+  kKwWhen,
+  kLeftParen,
+  kRightParen,
+  kComma,
+  kDot,
+  kStar,
+  kPlus,
+  kMinus,
+  kSlash,
+  kAt,
+  kQuestionMark,
+  kEquals,
+  kNotEqualsCStyle,
+  kNotEqualsSqlStyle,
+  kLess,
+  kLessEquals,
+  kGreater,
+  kGreaterEquals,
+};
+
+struct Token {
+  TokenKind kind;
+  // Byte offsets of the token in the input.
+  int start;
+  int end;
+};
+
+using TokenVector = absl::InlinedVector<Token, 32>;
+
+bool IsWhitespace(char c) {
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\b' ||
+         c == '\f' || c == '\v';
+}
+
+bool IsDecimalDigit(char c) { return c >= '0' && c <= '9'; }
+
+bool IsHexDigit(char c) {
+  return IsDecimalDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+bool IsIdentifierStart(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+bool IsIdentifierChar(char c) {
+  return IsIdentifierStart(c) || IsDecimalDigit(c);
+}
+
+// The Flex tokenizer switches to a mode that tokenizes any word, including
+// keywords and words starting with digits, as an identifier after a "." that
+// follows one of these tokens.
+bool IsDotIdentifierPrefix(TokenKind kind) {
+  return kind == TokenKind::kIdentifier || kind == TokenKind::kRightParen ||
+         kind == TokenKind::kQuestionMark;
+}
+
+// Returns the kind of the keyword with Bison token <bison_token>, or false if
+// the keyword is not handled here.
+bool GetKeywordTokenKind(int bison_token, TokenKind* kind) {
+  switch (bison_token) {
+    case BisonToken::KW_AND:
+      *kind = TokenKind::kKwAnd;
+      return true;
+    case BisonToken::KW_AS:
+      *kind = TokenKind::kKwAs;
+      return true;
+    case BisonToken::KW_CASE:
+      *kind = TokenKind::kKwCase;
+      return true;
+    case BisonToken::KW_CAST:
+      *kind = TokenKind::kKwCast;
+      return true;
+    case BisonToken::KW_ELSE:
+      *kind = TokenKind::kKwElse;
+      return true;
+    case BisonToken::KW_END:
+      *kind = TokenKind::kKwEnd;
+      return true;
+    case BisonToken::KW_FALSE:
+      *kind = TokenKind::kKwFalse;
+      return true;
+    case BisonToken::KW_IS:
+      *kind = TokenKind::kKwIs;
+      return true;
+    case BisonToken::KW_NOT:
+      *kind = TokenKind::kKwNot;
+      return true;
+    case BisonToken::KW_NULL:
+      *kind = TokenKind::kKwNull;
+      return true;
+    case BisonToken::KW_OR:
+      *kind = TokenKind::kKwOr;
+      return true;
+    case BisonToken::KW_SAFE_CAST:
+      *kind = TokenKind::kKwSafeCast;
+      return true;
+    case BisonToken::KW_THEN:
+      *kind = TokenKind::kKwThen;
+      return true;
+    case BisonToken::KW_TRUE:
+      *kind = TokenKind::kKwTrue;
+      return true;
+    case BisonToken::KW_WHEN:
+      *kind = TokenKind::kKwWhen;
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Scans a quoted string or backquoted identifier starting at <*pos>, which
+// holds the quote character, and moves <*pos> past the closing quote. The
+// quoted text may contain escapes but no unescaped newlines. Returns false
+// if the text is not terminated or contains an escaped newline, which the
+// Flex tokenizer treats differently.
+bool ScanQuoted(absl::string_view input, int* pos) {
+  const char quote = input[*pos];
+  int i = *pos + 1;
+  while (i < input.size()) {
+    const char c = input[i];
+    if (c == quote) {
+      *pos = i + 1;
+      return true;
+    }
+    if (c == '\n' || c == '\r') return false;
+    if (c == '\\') {
+      if (i + 1 >= input.size() || input[i + 1] == '\n' ||
+          input[i + 1] == '\r') {
+        return false;
+      }
+      i += 2;
+    } else {
+      ++i;
+    }
+  }
+  return false;
+}
+
+// Splits <input> into tokens like the Flex tokenizer, ending with a
+// kEndOfInput token. Returns false when it encounters something that the
+// parser below does not handle, or that it would tokenize differently from
+// the Flex tokenizer.
+bool Tokenize(absl::string_view input, TokenVector* tokens) {
+  bool in_dot_identifier_mode = false;
+  int i = 0;
+  while (true) {
+    while (i < input.size() && IsWhitespace(input[i])) ++i;
+    if (i == input.size()) break;
+    const int start = i;
+    const char c = input[i];
+    const char next = i + 1 < input.size() ? input[i + 1] : '\0';
+    const bool after_dot_identifier_prefix =
+        !tokens->empty() && IsDotIdentifierPrefix(tokens->back().kind);
+    TokenKind kind;
+    if (in_dot_identifier_mode) {
+      in_dot_identifier_mode = false;
+      if (IsIdentifierChar(c)) {
+        while (i < input.size() && IsIdentifierChar(input[i])) ++i;
+        tokens->push_back({TokenKind::kIdentifier, start, i});
+        continue;
+      }
+      if (c == '`') {
+        if (!ScanQuoted(input, &i)) return false;
+        tokens->push_back({TokenKind::kIdentifier, start, i});
+        continue;
+      }
+      // Like the Flex tokenizer, fall back to the regular rules.
+    }
+    if (IsIdentifierStart(c)) {
+      while (i < input.size() && IsIdentifierChar(input[i])) ++i;
+      // Prefixes of raw strings and bytes literals.
+      if (i < input.size() &&
+          (input[i] == '\'' || input[i] == '"' || input[i] == '`')) {
+        return false;
+      }
+      const absl::string_view word = input.substr(start, i - start);
+      if (const KeywordInfo* keyword_info = GetKeywordInfo(word)) {
+        if (!GetKeywordTokenKind(keyword_info->bison_token(), &kind)) {
+          return false;
+        }
+      } else if (NonReservedIdentifierMustBeBackquoted(word)) {
+        // For example CURRENT_DATE, which is a function call without
+        // parentheses.
+        return false;
+      } else {
+        kind = TokenKind::kIdentifier;
+      }
+    } else if (IsDecimalDigit(c) ||
+               (c == '.' && IsDecimalDigit(next) &&
+                !after_dot_identifier_prefix)) {
+      kind = TokenKind::kIntegerLiteral;
+      if (c == '0' && (next == 'x' || next == 'X') && i + 2 < input.size() &&
+          IsHexDigit(input[i + 2])) {
+        i += 2;
+        while (i < input.size() && IsHexDigit(input[i])) ++i;
+      } else {
+        while (i < input.size() && IsDecimalDigit(input[i])) ++i;
+        if (i < input.size() && input[i] == '.') {
+          kind = TokenKind::kFloatingPointLiteral;
+          ++i;
+          while (i < input.size() && IsDecimalDigit(input[i])) ++i;
+        }
+        if (i < input.size() && (input[i] == 'e' || input[i] == 'E')) {
+          int exponent = i + 1;
+          if (exponent < input.size() &&
+              (input[exponent] == '+' || input[exponent] == '-')) {
+            ++exponent;
+          }
+          if (exponent < input.size() && IsDecimalDigit(input[exponent])) {
+            kind = TokenKind::kFloatingPointLiteral;
+            i = exponent;
+            while (i < input.size() && IsDecimalDigit(input[i])) ++i;
+          }
+        }
+      }
+      // The Flex tokenizer rejects a number directly followed by an
+      // identifier, and tokenizes "1.2.3" and "1.x" in ways that are never
+      // valid here.
+      if (i < input.size() &&
+          (IsIdentifierChar(input[i]) || input[i] == '.' ||
+           input[i] == '\'' || input[i] == '"' || input[i] == '`')) {
+        return false;
+      }
+    } else {
+      switch (c) {
+        case '`':
+          if (!ScanQuoted(input, &i)) return false;
+          kind = TokenKind::kIdentifier;
+          break;
+        case '\'':
+        case '"':
+          // Triple-quoted strings.
+          if (next == c && i + 2 < input.size() && input[i + 2] == c) {
+            return false;
+          }
+          if (!ScanQuoted(input, &i)) return false;
+          kind = TokenKind::kStringLiteral;
+          break;
+        case '.':
+          if (!after_dot_identifier_prefix) return false;
+          in_dot_identifier_mode = true;
+          kind = TokenKind::kDot;
+          ++i;
+          break;
+        case '(':
+          kind = TokenKind::kLeftParen;
+          ++i;
+          break;
+        case ')':
+          kind = TokenKind::kRightParen;
+          ++i;
+          break;
+        case ',':
+          kind = TokenKind::kComma;
+          ++i;
+          break;
+        case '*':
+          kind = TokenKind::kStar;
+          ++i;
+          break;
+        case '+':
+          kind = TokenKind::kPlus;
+          ++i;
+          break;
+        case '?':
+          kind = TokenKind::kQuestionMark;
+          ++i;
+          break;
+        case '-':
+          if (next == '-') return false;  // Comment.
+          kind = TokenKind::kMinus;
+          ++i;
+          break;
+        case '/':
+          if (next == '*') return false;  // Comment.
+          kind = TokenKind::kSlash;
+          ++i;
+          break;
+        case '@': {
+          // Hints start with "@{" or "@" and an integer.
+          int after = i + 1;
+          while (after < input.size() && IsWhitespace(input[after])) ++after;
+          if (after < input.size() &&
+              (input[after] == '{' || IsDecimalDigit(input[after]))) {
+            return false;
+          }
+          kind = TokenKind::kAt;
+          ++i;
+          break;
+        }
+        case '=':
+          if (next == '>') return false;  // Named argument.
+          kind = TokenKind::kEquals;
+          ++i;
+          break;
+        case '!':
+          if (next != '=') return false;
+          kind = TokenKind::kNotEqualsCStyle;
+          i += 2;
+          break;
+        case '<':
+          if (next == '<') return false;  // Shift.
+          if (next == '=') {
+            kind = TokenKind::kLessEquals;
+            i += 2;
+          } else if (next == '>') {
+            kind = TokenKind::kNotEqualsSqlStyle;
+            i += 2;
+          } else {
+            kind = TokenKind::kLess;
+            ++i;
+          }
+          break;
+        case '>':
+          if (next == '>') return false;  // Shift.
+          if (next == '=') {
+            kind = TokenKind::kGreaterEquals;
+            i += 2;
+          } else {
+            kind = TokenKind::kGreater;
+            ++i;
+          }
+          break;
+        default:
+          // Comments, other operators and non-ASCII input.
+          return false;
+      }
+    }
+    tokens->push_back({kind, start, i});
+  }
+  tokens->push_back({TokenKind::kEndOfInput, i, i});
+  return true;
+}
+
+// Binding powers of the binary operators, from loosest to tightest, matching
+// the precedence declarations in bison_parser.y.
+enum Precedence {
+  kNoPrecedence = 0,
+  kOrPrecedence,
+  kAndPrecedence,
+  kNotPrecedence,
+  kComparisonPrecedence,
+  kAdditivePrecedence,
+  kMultiplicativePrecedence,
+  kUnaryPrecedence,
+  kPrimaryPrecedence,
+};
+
+Precedence GetBinaryOperatorPrecedence(TokenKind kind) {
+  switch (kind) {
+    case TokenKind::kKwOr:
+      return kOrPrecedence;
+    case TokenKind::kKwAnd:
+      return kAndPrecedence;
+    case TokenKind::kKwIs:
+    case TokenKind::kEquals:
+    case TokenKind::kNotEqualsCStyle:
+    case TokenKind::kNotEqualsSqlStyle:
+    case TokenKind::kLess:
+    case TokenKind::kLessEquals:
+    case TokenKind::kGreater:
+    case TokenKind::kGreaterEquals:
+      return kComparisonPrecedence;
+    case TokenKind::kPlus:
+    case TokenKind::kMinus:
+      return kAdditivePrecedence;
+    case TokenKind::kStar:
+    case TokenKind::kSlash:
+      return kMultiplicativePrecedence;
+    default:
+      return kNoPrecedence;
+  }
+}
+
+ASTBinaryExpression::Op GetBinaryOp(TokenKind kind) {
+  switch (kind) {
+    case TokenKind::kEquals:
+      return ASTBinaryExpression::EQ;
+    case TokenKind::kNotEqualsCStyle:
+      return ASTBinaryExpression::NE;
+    case TokenKind::kNotEqualsSqlStyle:
+      return ASTBinaryExpression::NE2;
+    case TokenKind::kLess:
+      return ASTBinaryExpression::LT;
+    case TokenKind::kLessEquals:
+      return ASTBinaryExpression::LE;
+    case TokenKind::kGreater:
+      return ASTBinaryExpression::GT;
+    case TokenKind::kGreaterEquals:
+      return ASTBinaryExpression::GE;
+    case TokenKind::kPlus:
+      return ASTBinaryExpression::PLUS;
+    case TokenKind::kMinus:
+      return ASTBinaryExpression::MINUS;
+    case TokenKind::kStar:
+      return ASTBinaryExpression::MULTIPLY;
+    case TokenKind::kSlash:
+      return ASTBinaryExpression::DIVIDE;
+    default:
+      return ASTBinaryExpression::NOT_SET;
+  }
+}
+
+class SimpleExpressionParser {
+ public:
+  SimpleExpressionParser(absl::string_view input, const TokenVector* tokens,
+                         BisonParser* parser)
+      : input_(input), tokens_(*tokens), parser_(parser) {}
+  SimpleExpressionParser(const SimpleExpressionParser&) = delete;
+  SimpleExpressionParser& operator=(const SimpleExpressionParser&) = delete;
+
+  // Parses the whole input as an expression, returning it in <result>.
+  bool ParseInput(ASTExpression** result) {
+    ParsedExpression expression;
+    if (!ParseExpression(kOrPrecedence, &expression) ||
+        Peek().kind != TokenKind::kEndOfInput) {
+      return false;
+    }
+    *result = expression.node;
+    return true;
+  }
+
+ private:
+  // An expression and the input range of its grammar rule in the Bison
+  // parser, which is what enclosing rules use for their locations. This is
+  // different from the node location for a parenthesized expression.
+  struct ParsedExpression {
+    ASTExpression* node = nullptr;
+    int start = 0;
+    int end = 0;
+  };
+
+  const Token& Peek() const { return tokens_[position_]; }
+  const Token& Next() { return tokens_[position_++]; }
+
+  // Consumes the next token if it has <kind>.
+  bool Consume(TokenKind kind, Token* token = nullptr) {
+    if (Peek().kind != kind) return false;
+    if (token != nullptr) *token = Peek();
+    ++position_;
+    return true;
+  }
+
+  absl::string_view GetText(const Token& token) const {
+    return input_.substr(token.start, token.end - token.start);
+  }
+
+  static zetasql_bison_parser::location Location(int start, int end) {
+    zetasql_bison_parser::location location;
+    location.begin.column = start;
+    location.end.column = end;
+    return location;
+  }
+
+  static zetasql_bison_parser::location Location(const Token& token) {
+    return Location(token.start, token.end);
+  }
+
+  // Parses an expression whose binary operators all bind at least as tightly
+  // as <min_precedence>.
+  bool ParseExpression(Precedence min_precedence, ParsedExpression* result) {
+    ParsedExpression lhs;
+    if (!ParseUnaryExpression(min_precedence, &lhs)) return false;
+    while (true) {
+      const Token op = Peek();
+      const Precedence precedence = GetBinaryOperatorPrecedence(op.kind);
+      if (precedence == kNoPrecedence || precedence < min_precedence) break;
+      ++position_;
+      // The comparison operators are not associative, and the grammar
+      // rejects a comparison on their left side.
+      if (precedence == kComparisonPrecedence &&
+          !lhs.node->IsAllowedInComparison()) {
+        return false;
+      }
+      ParsedExpression rhs;
+      ASTExpression* node;
+      if (op.kind == TokenKind::kKwIs) {
+        const bool is_not = Consume(TokenKind::kKwNot);
+        const Token literal_token = Peek();
+        if (literal_token.kind != TokenKind::kKwNull &&
+            literal_token.kind != TokenKind::kKwTrue &&
+            literal_token.kind != TokenKind::kKwFalse) {
+          return false;
+        }
+        if (!ParsePrimaryExpression(&rhs)) return false;
+        auto* binary_expression = parser_->CreateASTNode<ASTBinaryExpression>(
+            Location(op.start, rhs.end), {lhs.node, rhs.node});
+        binary_expression->set_is_not(is_not);
+        binary_expression->set_op(ASTBinaryExpression::IS);
+        node = binary_expression;
+      } else if (op.kind == TokenKind::kKwAnd ||
+                 op.kind == TokenKind::kKwOr) {
+        if (!ParseExpression(static_cast<Precedence>(precedence + 1), &rhs)) {
+          return false;
+        }
+        const ASTNodeKind kind =
+            op.kind == TokenKind::kKwAnd ? AST_AND_EXPR : AST_OR_EXPR;
+        if (lhs.node->node_kind() == kind && !lhs.node->parenthesized()) {
+          // Flatten a series of ANDs or ORs into one node.
+          lhs.node->AddChild(rhs.node);
+          node = parser_->WithEndLocation(lhs.node,
+                                          Location(rhs.start, rhs.end));
+        } else if (kind == AST_AND_EXPR) {
+          node = parser_->CreateASTNode<ASTAndExpr>(
+              Location(lhs.start, rhs.end), {lhs.node, rhs.node});
+        } else {
+          node = parser_->CreateASTNode<ASTOrExpr>(
+              Location(lhs.start, rhs.end), {lhs.node, rhs.node});
+        }
+      } else {
+        if (!ParseExpression(static_cast<Precedence>(precedence + 1), &rhs)) {
+          return false;
+        }
+        auto* binary_expression = parser_->CreateASTNode<ASTBinaryExpression>(
+            Location(op.start, rhs.end), {lhs.node, rhs.node});
+        binary_expression->set_op(GetBinaryOp(op.kind));
+        node = binary_expression;
+      }
+      lhs.node = node;
+      lhs.end = rhs.end;
+    }
+    *result = lhs;
+    return true;
+  }
+
+  bool ParseUnaryExpression(Precedence min_precedence,
+                            ParsedExpression* result) {
+    const Token op = Peek();
+    ASTUnaryExpression::Op unary_op;
+    ParsedExpression operand;
+    switch (op.kind) {
+      case TokenKind::kKwNot:
+        // The grammar rejects NOT as an operand of a tighter operator, such
+        // as "a = NOT b".
+        if (min_precedence > kNotPrecedence) return false;
+        ++position_;
+        if (!ParseExpression(kComparisonPrecedence, &operand)) return false;
+        unary_op = ASTUnaryExpression::NOT;
+        break;
+      case TokenKind::kPlus:
+      case TokenKind::kMinus:
+        ++position_;
+        if (!ParseExpression(kPrimaryPrecedence, &operand)) return false;
+        unary_op = op.kind == TokenKind::kPlus ? ASTUnaryExpression::PLUS
+                                               : ASTUnaryExpression::MINUS;
+        break;
+      default:
+        return ParsePrimaryExpression(result);
+    }
+    auto* expression = parser_->CreateASTNode<ASTUnaryExpression>(
+        Location(op.start, operand.end), {operand.node});
+    expression->set_op(unary_op);
+    result->node = expression;
+    result->start = op.start;
+    result->end = operand.end;
+    return true;
+  }
+
+  bool ParsePrimaryExpression(ParsedExpression* result) {
+    const Token token = Next();
+    result->start = token.start;
+    result->end = token.end;
+    switch (token.kind) {
+      case TokenKind::kKwNull: {
+        auto* literal =
+            parser_->CreateASTNode<ASTNullLiteral>(Location(token));
+        literal->set_image(std::string(GetText(token)));
+        result->node = literal;
+        break;
+      }
+      case TokenKind::kKwTrue:
+      case TokenKind::kKwFalse: {
+        auto* literal =
+            parser_->CreateASTNode<ASTBooleanLiteral>(Location(token));
+        literal->set_value(token.kind == TokenKind::kKwTrue);
+        literal->set_image(std::string(GetText(token)));
+        result->node = literal;
+        break;
+      }
+      case TokenKind::kIntegerLiteral: {
+        auto* literal = parser_->CreateASTNode<ASTIntLiteral>(Location(token));
+        literal->set_image(std::string(GetText(token)));
+        result->node = literal;
+        break;
+      }
+      case TokenKind::kFloatingPointLiteral: {
+        auto* literal =
+            parser_->CreateASTNode<ASTFloatLiteral>(Location(token));
+        literal->set_image(std::string(GetText(token)));
+        result->node = literal;
+        break;
+      }
+      case TokenKind::kStringLiteral: {
+        const absl::string_view input_text = GetText(token);
+        std::string str;
+        if (!ParseStringLiteral(input_text, &str).ok()) return false;
+        auto* literal =
+            parser_->CreateASTNode<ASTStringLiteral>(Location(token));
+        literal->set_string_value(std::move(str));
+        literal->set_image(std::string(input_text));
+        result->node = literal;
+        break;
+      }
+      case TokenKind::kIdentifier: {
+        --position_;
+        ASTPathExpression* path;
+        if (!ParsePathExpression(&path, &result->end)) return false;
+        result->node = path;
+        if (Peek().kind == TokenKind::kLeftParen &&
+            !ParseFunctionCall(path, result)) {
+          return false;
+        }
+        break;
+      }
+      case TokenKind::kAt: {
+        Token name_token;
+        ASTIdentifier* name;
+        if (!Consume(TokenKind::kIdentifier, &name_token) ||
+            !MakeIdentifier(name_token, &name)) {
+          return false;
+        }
+        result->end = name_token.end;
+        result->node = parser_->CreateASTNode<ASTParameterExpr>(
+            Location(token.start, name_token.end), {name});
+        break;
+      }
+      case TokenKind::kQuestionMark: {
+        auto* parameter_expr =
+            parser_->CreateASTNode<ASTParameterExpr>(Location(token), {});
+        parameter_expr->set_position(
+            parser_->GetNextPositionalParameterPosition());
+        result->node = parameter_expr;
+        break;
+      }
+      case TokenKind::kLeftParen: {
+        ParsedExpression inner;
+        Token close;
+        // "(a, b)" is a struct constructor.
+        if (!ParseExpression(kOrPrecedence, &inner) ||
+            !Consume(TokenKind::kRightParen, &close)) {
+          return false;
+        }
+        // The location of the expression does not include the parentheses.
+        inner.node->set_parenthesized(true);
+        result->node = inner.node;
+        result->end = close.end;
+        break;
+      }
+      case TokenKind::kKwCase:
+        if (!ParseCaseExpression(token, result)) return false;
+        break;
+      case TokenKind::kKwCast:
+      case TokenKind::kKwSafeCast:
+        if (!ParseCastExpression(token, result)) return false;
+        break;
+      default:
+        return false;
+    }
+    // Field accesses on anything but a path, array element accesses and
+    // calls on anything but a path are not handled.
+    const TokenKind next = Peek().kind;
+    return next != TokenKind::kDot && next != TokenKind::kLeftParen;
+  }
+
+  bool MakeIdentifier(const Token& token, ASTIdentifier** identifier) {
+    const absl::string_view text = GetText(token);
+    if (text[0] == '`') {
+      std::string str;
+      if (!ParseGeneralizedIdentifier(text, &str).ok()) return false;
+      *identifier = parser_->MakeIdentifier(Location(token), str);
+    } else {
+      *identifier = parser_->MakeIdentifier(Location(token), text);
+    }
+    return true;
+  }
+
+  // Parses a path of one or more identifiers separated by ".", and returns
+  // the end of its input range in <end>.
+  bool ParsePathExpression(ASTPathExpression** path, int* end) {
+    Token token;
+    ASTIdentifier* identifier;
+    if (!Consume(TokenKind::kIdentifier, &token) ||
+        !MakeIdentifier(token, &identifier)) {
+      return false;
+    }
+    *path = parser_->CreateASTNode<ASTPathExpression>(Location(token),
+                                                      {identifier});
+    while (Consume(TokenKind::kDot)) {
+      if (!Consume(TokenKind::kIdentifier, &token) ||
+          !MakeIdentifier(token, &identifier)) {
+        return false;
+      }
+      (*path)->AddChild(identifier);
+      parser_->WithEndLocation(*path, Location(token));
+    }
+    *end = token.end;
+    return true;
+  }
+
+  // Parses the arguments of a call to <function>, whose input range is in
+  // <result>, and returns the call in <result>.
+  bool ParseFunctionCall(ASTPathExpression* function,
+                         ParsedExpression* result) {
+    const Token open = Next();
+    auto* function_call = parser_->CreateASTNode<ASTFunctionCall>(
+        Location(result->start, open.end), {function});
+    function_call->set_distinct(false);
+    Token close;
+    if (!Consume(TokenKind::kRightParen, &close)) {
+      Token star;
+      if (Consume(TokenKind::kStar, &star)) {
+        auto* star_node = parser_->CreateASTNode<ASTStar>(Location(star));
+        star_node->set_image("*");
+        function_call->AddChild(star_node);
+      } else {
+        ParsedExpression argument;
+        if (!ParseExpression(kOrPrecedence, &argument)) return false;
+        function_call->AddChild(argument.node);
+      }
+      while (Consume(TokenKind::kComma)) {
+        ParsedExpression argument;
+        if (!ParseExpression(kOrPrecedence, &argument)) return false;
+        function_call->AddChild(argument.node);
+      }
+      if (!Consume(TokenKind::kRightParen, &close)) return false;
+      function_call->set_null_handling_modifier(
+          ASTFunctionCall::DEFAULT_NULL_HANDLING);
+    }
+    parser_->WithEndLocation(function_call, Location(close));
+    result->node = function_call;
+    result->end = close.end;
+    return true;
+  }
+
+  // Parses the rest of a CASE expression that starts with <case_token>.
+  bool ParseCaseExpression(const Token& case_token, ParsedExpression* result) {
+    absl::InlinedVector<ASTNode*, 8> children;
+    ParsedExpression expression;
+    const bool has_value = Peek().kind != TokenKind::kKwWhen;
+    if (has_value) {
+      if (!ParseExpression(kOrPrecedence, &expression)) return false;
+      children.push_back(expression.node);
+    }
+    if (Peek().kind != TokenKind::kKwWhen) return false;
+    while (Consume(TokenKind::kKwWhen)) {
+      if (!ParseExpression(kOrPrecedence, &expression)) return false;
+      children.push_back(expression.node);
+      if (!Consume(TokenKind::kKwThen) ||
+          !ParseExpression(kOrPrecedence, &expression)) {
+        return false;
+      }
+      children.push_back(expression.node);
+    }
+    if (Consume(TokenKind::kKwElse)) {
+      if (!ParseExpression(kOrPrecedence, &expression)) return false;
+      children.push_back(expression.node);
+    }
+    Token end;
+    if (!Consume(TokenKind::kKwEnd, &end)) return false;
+    const zetasql_bison_parser::location location =
+        Location(case_token.start, end.end);
+    if (has_value) {
+      result->node =
+          parser_->CreateASTNode<ASTCaseValueExpression>(location, children);
+    } else {
+      result->node =
+          parser_->CreateASTNode<ASTCaseNoValueExpression>(location, children);
+    }
+    result->end = end.end;
+    return true;
+  }
+
+  // Parses the rest of a CAST or SAFE_CAST to a named type that starts with
+  // <cast_token>.
+  bool ParseCastExpression(const Token& cast_token, ParsedExpression* result) {
+    ParsedExpression expression;
+    ASTPathExpression* type_name;
+    int type_name_end;
+    Token close;
+    if (!Consume(TokenKind::kLeftParen) ||
+        !ParseExpression(kOrPrecedence, &expression) ||
+        !Consume(TokenKind::kKwAs) || Peek().kind != TokenKind::kIdentifier) {
+      return false;
+    }
+    const int type_name_start = Peek().start;
+    if (!ParsePathExpression(&type_name, &type_name_end) ||
+        !Consume(TokenKind::kRightParen, &close)) {
+      return false;
+    }
+    auto* type = parser_->CreateASTNode<ASTSimpleType>(
+        Location(type_name_start, type_name_end), {type_name});
+    auto* cast = parser_->CreateASTNode<ASTCastExpression>(
+        Location(cast_token.start, close.end), {expression.node, type});
+    cast->set_is_safe_cast(cast_token.kind == TokenKind::kKwSafeCast);
+    result->node = cast;
+    result->end = close.end;
+    return true;
+  }
+
+  const absl::string_view input_;
+  const TokenVector& tokens_;
+  BisonParser* const parser_;
+  int position_ = 0;
+};
+
+}  // namespace
+
+bool ParseSimpleExpression(
+    absl::string_view input, IdStringPool* id_string_pool,
+    zetasql_base::UnsafeArena* arena, std::unique_ptr<ASTNode>* output,
+    std::vector<std::unique_ptr<ASTNode>>* other_allocated_ast_nodes,
+    int64_t* num_tokens) {
+  TokenVector tokens;
+  if (!Tokenize(input, &tokens)) return false;
+
+  BisonParser parser(
+      arena, absl::make_unique<std::vector<std::unique_ptr<ASTNode>>>(),
+      id_string_pool, input);
+  ASTExpression* expression;
+  if (!SimpleExpressionParser(input, &tokens, &parser)
+           .ParseInput(&expression)) {
+    return false;
+  }
+
+  // As in BisonParser::Parse().
+  std::unique_ptr<std::vector<std::unique_ptr<ASTNode>>> allocated_ast_nodes =
+      parser.ReleaseAllocatedASTNodes();
+  for (const auto& ast_node : *allocated_ast_nodes) {
+    ast_node->InitFields();
+  }
+  int output_index = allocated_ast_nodes->size() - 1;
+  while (output_index >= 0 &&
+         (*allocated_ast_nodes)[output_index].get() != expression) {
+    --output_index;
+  }
+  DCHECK_GE(output_index, 0);
+  if (output_index < 0) return false;
+  *output = std::move((*allocated_ast_nodes)[output_index]);
+  // There's no need to erase the entry in allocated_ast_nodes.
+  *other_allocated_ast_nodes = std::move(*allocated_ast_nodes);
+  // The Flex tokenizer also returns a token for the parser mode and an
+  // end-of-input token, which is the last entry of <tokens>.
+  *num_tokens = tokens.size() + 1;
+  return true;
+}
+
+}  // namespace parser
+}  // namespace zetasql
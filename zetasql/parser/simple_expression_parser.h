@@ -0,0 +1,64 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PARSER_SIMPLE_EXPRESSION_PARSER_H_
+#define ZETASQL_PARSER_SIMPLE_EXPRESSION_PARSER_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "zetasql/base/arena.h"
+#include "zetasql/parser/parse_tree.h"
+#include "zetasql/public/id_string.h"
+#include "absl/strings/string_view.h"
+
+namespace zetasql {
+namespace parser {
+
+// A hand-written precedence climbing parser for the part of the expression
+// grammar that small expressions such as filters typically use:
+// - NULL, boolean, integer, floating point and string literals,
+// - identifiers, paths and query parameters,
+// - OR, AND, NOT, IS [NOT] NULL/TRUE/FALSE, the comparison operators,
+//   "+", "-", "*", "/" and unary "+" and "-",
+// - parenthesized expressions,
+// - function calls with plain arguments, including COUNT(*),
+// - CASE, CAST and SAFE_CAST to a named type.
+// It avoids the setup and the table-driven state machine of the Bison parser,
+// and produces exactly the tree, including the locations, that the Bison
+// parser produces for the same input in BisonParserMode::kExpression.
+//
+// It never reports errors. It gives up on any input that uses anything else,
+// including comments, keywords that it does not handle and any input that
+// is not a valid expression, and the caller then parses the input with the
+// Bison parser, which produces the result or the error.
+//
+// Returns true if it parsed all of <input>. Then <output>,
+// <other_allocated_ast_nodes> and <num_tokens> are set as for
+// BisonParser::Parse() in BisonParserMode::kExpression with no filename and
+// start offset 0. Returns false if it gave up, and then leaves the outputs
+// unchanged. Either way, it may allocate in <id_string_pool> and <arena>.
+bool ParseSimpleExpression(
+    absl::string_view input, IdStringPool* id_string_pool,
+    zetasql_base::UnsafeArena* arena, std::unique_ptr<ASTNode>* output,
+    std::vector<std::unique_ptr<ASTNode>>* other_allocated_ast_nodes,
+    int64_t* num_tokens);
+
+}  // namespace parser
+}  // namespace zetasql
+
+#endif  // ZETASQL_PARSER_SIMPLE_EXPRESSION_PARSER_H_
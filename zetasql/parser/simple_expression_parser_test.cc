@@ -0,0 +1,159 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/parser/simple_expression_parser.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/parser/parse_tree.h"
+#include "zetasql/parser/parser.h"
+#include "zetasql/public/id_string.h"
+#include "zetasql/public/parse_resume_location.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "zetasql/base/arena.h"
+
+namespace zetasql {
+namespace parser {
+namespace {
+
+using zetasql_base::testing::StatusIs;
+
+// Checks that ParseSimpleExpression() handles <input> and produces the same
+// tree and token count as the Bison parser.  ParseExpression() with a
+// ParseResumeLocation always uses the Bison parser.
+void ExpectSameAsBison(const std::string& input) {
+  SCOPED_TRACE(input);
+  IdStringPool id_string_pool;
+  zetasql_base::UnsafeArena arena(/*block_size=*/4096);
+  std::unique_ptr<ASTNode> output;
+  std::vector<std::unique_ptr<ASTNode>> other_allocated_ast_nodes;
+  int64_t num_tokens = -1;
+  ASSERT_TRUE(ParseSimpleExpression(input, &id_string_pool, &arena, &output,
+                                    &other_allocated_ast_nodes, &num_tokens));
+  ASSERT_TRUE(output != nullptr);
+
+  std::unique_ptr<ParserOutput> bison_output;
+  ZETASQL_ASSERT_OK(ParseExpression(ParseResumeLocation::FromStringView(input),
+                            ParserOptions(), &bison_output));
+  EXPECT_EQ(bison_output->expression()->DebugString(), output->DebugString());
+  EXPECT_EQ(bison_output->num_tokens(), num_tokens);
+}
+
+TEST(SimpleExpressionParserTest, SameAsBison) {
+  for (const std::string& input : std::vector<std::string>{
+           "1",
+           "  x  ",
+           "NULL",
+           "true OR FALSE",
+           "1.5e3",
+           ".5",
+           "'abc'",
+           "\"a\\nb\"",
+           "a.b.c",
+           "`a b`.`select`",
+           "a.select.from",
+           "@param",
+           "?",
+           "? + ?",
+           "a = 1 AND b.c IS NOT NULL",
+           "a AND b AND c OR d",
+           "(a AND b) AND c",
+           "a AND (b AND c)",
+           "NOT a",
+           "NOT a = b AND c",
+           "x IS TRUE",
+           "x IS NOT FALSE",
+           "1 + 2 * 3 - 4 / 5",
+           "(1 + 2) * 3",
+           "-x + +y",
+           "- -1",
+           "-(a) * 2",
+           "a < b",
+           "a <= b OR a >= b OR a <> b OR a != b",
+           "f()",
+           "f(x, 2) + -3",
+           "a.b.f(1, (2))",
+           "COUNT(*)",
+           "count(*) > 0",
+           "CASE WHEN x THEN 'a' ELSE 'b' END",
+           "CASE x WHEN 1 THEN 2 WHEN 3 THEN 4 END",
+           "CAST(x AS INT64)",
+           "SAFE_CAST(x + 1 AS a.b)",
+           "CASE WHEN x IS NULL THEN CAST(y AS STRING) END",
+       }) {
+    ExpectSameAsBison(input);
+  }
+}
+
+TEST(SimpleExpressionParserTest, GivesUp) {
+  for (const std::string& input : std::vector<std::string>{
+           "",
+           "a +",
+           "(a",
+           "a b",
+           "1 = 2 = 3",
+           "a IS 1",
+           "x -- comment",
+           "x /* comment */",
+           "DATE '2019-01-01'",
+           "x IN (1, 2)",
+           "x BETWEEN 1 AND 2",
+           "x LIKE 'a'",
+           "[1, 2]",
+           "a[OFFSET(1)]",
+           "(1, 2)",
+           "f(DISTINCT x)",
+           "f(a => 1)",
+           "1 << 2",
+           "a || b",
+           "@@sysvar",
+           "'''abc'''",
+           "STRUCT(1)",
+           "(SELECT 1)",
+           "CAST(x AS ARRAY<INT64>)",
+           "123abc",
+       }) {
+    SCOPED_TRACE(input);
+    IdStringPool id_string_pool;
+    zetasql_base::UnsafeArena arena(/*block_size=*/4096);
+    std::unique_ptr<ASTNode> output;
+    std::vector<std::unique_ptr<ASTNode>> other_allocated_ast_nodes;
+    int64_t num_tokens = -1;
+    EXPECT_FALSE(ParseSimpleExpression(input, &id_string_pool, &arena,
+                                       &output, &other_allocated_ast_nodes,
+                                       &num_tokens));
+    EXPECT_TRUE(output == nullptr);
+    EXPECT_TRUE(other_allocated_ast_nodes.empty());
+    EXPECT_EQ(-1, num_tokens);
+  }
+}
+
+TEST(SimpleExpressionParserTest, ParseExpressionReportsErrors) {
+  std::unique_ptr<ParserOutput> output;
+  EXPECT_THAT(ParseExpression("a +", ParserOptions(), &output),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+  ZETASQL_EXPECT_OK(ParseExpression("a + 1", ParserOptions(), &output));
+  EXPECT_EQ(5, output->num_tokens());
+}
+
+}  // namespace
+}  // namespace parser
+}  // namespace zetasql
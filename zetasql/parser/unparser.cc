@@ -17,6 +17,7 @@
 #include "zetasql/parser/unparser.h"
 
 #include <ctype.h>
+#include <functional>
 #include <set>
 #include <utility>
 
@@ -38,6 +39,13 @@ std::string Unparse(const ASTNode* node) {
   return unparsed_;
 }
 
+void Unparse(const ASTNode* node,
+             const std::function<void(absl::string_view)>& sink) {
+  parser::Unparser unparser(sink);
+  node->Accept(&unparser, nullptr);
+  unparser.FlushLine();
+}
+
 namespace parser {
 
 // Formatter ---------------------------------------------------------
@@ -45,6 +53,12 @@ namespace parser {
 static const int kDefaultNumIndentSpaces = 2;
 static const int kNumColumnLimit = 100;
 
+Formatter::Formatter(std::string* unparsed)
+    : sink_([unparsed](absl::string_view line) {
+        absl::StrAppend(unparsed, line);
+      }),
+      at_line_start_(unparsed->empty() || unparsed->back() == '\n') {}
+
 void Formatter::Indent() {
   absl::StrAppend(&indentation_, std::string(kDefaultNumIndentSpaces, ' '));
 }
@@ -122,7 +136,8 @@ void Formatter::FormatLine(absl::string_view s) {
 bool Formatter::LastTokenIsSeparator() {
   // These are keywords emitted in uppercase in Unparser, so don't need to make
   // them case insensitive.
-  static const std::set<std::string> kWordSperarator = { "AND", "OR", "ON", "IN" };
+  static const std::set<absl::string_view> kWordSperarator = {"AND", "OR",
+                                                              "ON", "IN"};
   static const std::set<char> kNonWordSperarator = {
       ',', '<', '>', '-', '+', '=', '*', '/', '%' };
   if (buffer_.empty()) return false;
@@ -135,16 +150,19 @@ bool Formatter::LastTokenIsSeparator() {
   while (last_token_index >= 0 && isalnum(buffer_[last_token_index])) {
     --last_token_index;
   }
-  std::string last_token = buffer_.substr(last_token_index + 1);
+  const absl::string_view last_token =
+      absl::string_view(buffer_).substr(last_token_index + 1);
   return zetasql_base::ContainsKey(kWordSperarator, last_token);
 }
 
 void Formatter::FlushLine() {
-  if ((unparsed_->empty() || unparsed_->back() == '\n') && buffer_.empty()) {
+  if (at_line_start_ && buffer_.empty()) {
     return;
   }
-  absl::StrAppend(unparsed_, buffer_, "\n");
+  buffer_.push_back('\n');
+  sink_(buffer_);
   buffer_.clear();
+  at_line_start_ = true;
 }
 
 // Unparser -------------------------------------------------------------------
@@ -17,7 +17,9 @@
 #ifndef ZETASQL_PARSER_UNPARSER_H_
 #define ZETASQL_PARSER_UNPARSER_H_
 
+#include <functional>
 #include <string>
+#include <utility>
 
 #include "zetasql/base/logging.h"
 #include "zetasql/parser/parse_tree.h"
@@ -54,7 +56,17 @@ class Formatter {
     Formatter* formatter_;
   };
 
-  explicit Formatter(std::string* unparsed) : unparsed_(unparsed) {}
+  // Receives the formatted output one line at a time.  Each line passed to
+  // it, including its indentation, ends with '\n'.
+  typedef std::function<void(absl::string_view line)> LineSink;
+
+  // Appends the formatted output to <*unparsed>.
+  explicit Formatter(std::string* unparsed);
+
+  // Passes each formatted line to <sink> as soon as it is complete, so only
+  // the current line is held in memory.
+  explicit Formatter(LineSink sink)
+      : sink_(std::move(sink)), at_line_start_(true) {}
   Formatter(const Formatter&) = delete;
   Formatter& operator=(const Formatter&) = delete;
 
@@ -76,7 +88,7 @@ class Formatter {
   //    FormatLine(")");
   void FormatLine(absl::string_view s);
 
-  // Flushes buffer_ to unparsed_, with a line break at the end.
+  // Flushes buffer_ to the output, with a line break at the end.
   // It will do nothing if it's a new line and buffer_ is empty, to avoid empty
   // lines.
   // Remember to call FlushLine() once after the whole process is over in case
@@ -94,20 +106,25 @@ class Formatter {
   // Indentation that will be prepended to a new line.
   std::string indentation_;
 
-  // Appended to unparsed_ with a line break at the end in FlushLine().
+  // Passed to sink_ with a line break at the end in FlushLine().
   std::string buffer_;
 
   // The length of indentation at the beginning of buffer_. We have to save it
   // in a variable since indentation_ is dynamically changing.
   int indentation_length_in_buffer_;
 
-  // Unparsed result, not owned.
-  std::string* unparsed_;
+  // Receives the formatted lines.
+  LineSink sink_;
+
+  // True if nothing has been output yet or the output ends with a line
+  // break.
+  bool at_line_start_;
 };
 
 class Unparser : public ParseTreeVisitor {
  public:
   explicit Unparser(std::string* unparsed) : formatter_(unparsed) {}
+  explicit Unparser(Formatter::LineSink sink) : formatter_(std::move(sink)) {}
   Unparser(const Unparser&) = delete;
   Unparser& operator=(const Unparser&) = delete;
   ~Unparser() override {}
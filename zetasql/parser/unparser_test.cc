@@ -17,11 +17,14 @@
 #include "zetasql/parser/unparser.h"
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "zetasql/base/testing/status_matchers.h"
 #include "zetasql/parser/parser.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/strings/string_view.h"
 
 namespace zetasql {
 
@@ -84,4 +87,35 @@ TEST(TestUnparser, ExpressionTest) {
                     expression_string, unparsed_expression_string);
 }
 
+TEST(TestUnparser, FormatterLineSink) {
+  std::vector<std::string> lines;
+  parser::Formatter formatter([&lines](absl::string_view line) {
+    lines.emplace_back(line);
+  });
+  formatter.FormatLine("SELECT");
+  {
+    parser::Formatter::Indenter indenter(&formatter);
+    formatter.Format("a");
+    formatter.Format(",");
+    formatter.Format("b");
+    // Nothing is output until the line is complete.
+    EXPECT_EQ(1, lines.size());
+    formatter.FlushLine();
+  }
+  formatter.FormatLine("FROM");
+  // Empty lines are not output.
+  formatter.FlushLine();
+  formatter.FormatLine("");
+  EXPECT_THAT(lines, testing::ElementsAre("SELECT\n", "  a, b\n", "FROM\n"));
+
+  // Appending to a std::string gives the same output.
+  std::string unparsed;
+  parser::Formatter string_formatter(&unparsed);
+  string_formatter.FormatLine("SELECT");
+  string_formatter.FlushLine();
+  string_formatter.Format("1");
+  string_formatter.FlushLine();
+  EXPECT_EQ("SELECT\n1\n", unparsed);
+}
+
 }  // namespace zetasql
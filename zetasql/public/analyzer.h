@@ -17,6 +17,8 @@
 #ifndef ZETASQL_PUBLIC_ANALYZER_H_
 #define ZETASQL_PUBLIC_ANALYZER_H_
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
 #include <map>
 #include <memory>
@@ -33,6 +35,7 @@
 #include "zetasql/public/id_string.h"
 #include "zetasql/public/language_options.h"
 #include "zetasql/public/options.pb.h"
+#include "zetasql/public/parse_location_table.h"
 #include "zetasql/public/type.h"
 #include "zetasql/public/value.h"
 #include "absl/container/node_hash_set.h"
@@ -40,10 +43,12 @@
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
 #include "zetasql/base/status.h"
+#include "zetasql/base/statusor.h"
 
 namespace zetasql {
 
 class ASTExpression;
+class ASTNode;
 class ASTScript;
 class ASTStatement;
 class ParseResumeLocation;
@@ -51,8 +56,10 @@ class ParserOptions;
 class ParserOutput;
 class ResolvedExpr;
 class ResolvedLiteral;
+class ResolvedNode;
 class ResolvedOption;
 class ResolvedStatement;
+class TVFSignatureCache;
 
 typedef std::map<std::string, const Type*> QueryParametersMap;
 
@@ -146,6 +153,50 @@ struct AllowedHintsAndOptions {
   zetasql_base::Status AddOptionImpl(const std::string& name, const Type* type);
 };
 
+// Limits on the work an analysis may do, so that pathological queries (e.g.
+// thousands of nested expressions or huge IN lists, often from query
+// generators) fail quickly instead of tying up the analyzing thread. Zero
+// means no limit, which is the default. An analysis that exceeds a limit fails
+// with RESOURCE_EXHAUSTED.
+struct AnalyzerLimits {
+  // Limits on the QueryComplexity of the parse tree, checked before resolving
+  // it.
+  int64_t max_ast_nodes = 0;
+  int64_t max_ast_depth = 0;
+  int64_t max_estimated_resolution_cost = 0;
+
+  // Limits on resolving, checked as expressions and queries are resolved.
+  // Wall time since resolving started.
+  absl::Duration max_resolver_time = absl::ZeroDuration();
+  // Growth of AnalyzerOptions::arena() since resolving started.
+  int64_t max_resolver_arena_bytes = 0;
+};
+
+// Lets one thread cancel analyses running on other threads, e.g. when the
+// client that requested them has gone away. An analysis whose
+// AnalyzerOptions::cancellation_token() has been cancelled stops at the next
+// statement, scan or expression it resolves, and fails with CANCELLED.
+//
+// Example:
+//   auto token = std::make_shared<AnalyzerCancellationToken>();
+//   options.set_cancellation_token(token);
+//   ... AnalyzeStatement(sql, options, ...) on one thread ...
+//   token->Cancel();  // On another thread.
+class AnalyzerCancellationToken {
+ public:
+  AnalyzerCancellationToken() {}
+  AnalyzerCancellationToken(const AnalyzerCancellationToken&) = delete;
+  AnalyzerCancellationToken& operator=(const AnalyzerCancellationToken&) =
+      delete;
+
+  // Thread-safe. Cancellation cannot be undone.
+  void Cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+  bool cancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<bool> cancelled_{false};
+};
+
 // AnalyzerOptions contains options that affect analyzer behavior. The language
 // options that control the language accepted are accessible via the
 // language() member.
@@ -233,12 +284,12 @@ class AnalyzerOptions {
   zetasql_base::Status AddQueryParameter(const std::string& name, const Type* type);
 
   const QueryParametersMap& query_parameters() const {
-    return query_parameters_;
+    return MapOrEmpty(query_parameters_);
   }
 
   // Clears <query_parameters_>.
   void clear_query_parameters() {
-    query_parameters_.clear();
+    query_parameters_.reset();
   }
 
   // Adds a positional query parameter.
@@ -324,7 +375,7 @@ class AnalyzerOptions {
   // This doesn't include the columns resolved using the
   // 'lookup_expression_column_callback_' function.
   const QueryParametersMap& expression_columns() const {
-    return expression_columns_;
+    return MapOrEmpty(expression_columns_);
   }
 
   bool has_in_scope_expression_column() const {
@@ -430,6 +481,16 @@ class AnalyzerOptions {
     return record_parse_locations_;
   }
 
+  // If true along with record_parse_locations(), the parse locations of
+  // resolved nodes are kept in a ParseLocationTable in the AnalyzerOutput,
+  // and the nodes only store their ids, which saves memory and allocations
+  // for each location.  They are then obtained via
+  // AnalyzerOutput::GetParseLocationRange().
+  void set_compact_parse_locations(bool value) {
+    compact_parse_locations_ = value;
+  }
+  bool compact_parse_locations() const { return compact_parse_locations_; }
+
   // Controls whether undeclared parameters are allowed. Undeclared parameters
   // don't appear in query_parameters(). Their type will be assigned by the
   // analyzer in the output AST and returned in
@@ -458,13 +519,94 @@ class AnalyzerOptions {
   void set_prune_unused_columns(bool value) { prune_unused_columns_ = value; }
   bool prune_unused_columns() const { return prune_unused_columns_; }
 
-  void set_allowed_hints_and_options(const AllowedHintsAndOptions& allowed) {
-    allowed_hints_and_options_ = allowed;
+  // If true, expressions that a scan in the resolved AST of a statement
+  // would compute several times per row are computed once, into a new
+  // column, by a ResolvedProjectScan inserted below it.  See
+  // EliminateCommonSubexpressions() in
+  // resolved_ast/common_subexpression_elimination.h.
+  void set_eliminate_common_subexpressions(bool value) {
+    eliminate_common_subexpressions_ = value;
+  }
+  bool eliminate_common_subexpressions() const {
+    return eliminate_common_subexpressions_;
+  }
+
+  // If true, each ResolvedWithEntry in the resolved AST of a statement has
+  // its reference_count, is_deterministic and is_cheap fields set.  See
+  // AnnotateWithEntries() in resolved_ast/with_entries.h.
+  void set_annotate_with_entries(bool value) {
+    annotate_with_entries_ = value;
+  }
+  bool annotate_with_entries() const { return annotate_with_entries_; }
+
+  // If true, WITH subqueries referenced only once in the resolved AST of a
+  // statement are inlined in place of their reference, and the remaining
+  // ResolvedWithEntries are annotated as for annotate_with_entries().  See
+  // InlineSingleUseWithEntries() in resolved_ast/with_entries.h.
+  void set_inline_single_use_with_entries(bool value) {
+    inline_single_use_with_entries_ = value;
+  }
+  bool inline_single_use_with_entries() const {
+    return inline_single_use_with_entries_;
+  }
+
+  // If true, AnalyzeStatement() and related functions extract the table
+  // names referenced by each statement and pass them to
+  // Catalog::PrefetchTables() before resolving the statement.
+  void set_prefetch_tables(bool value) { prefetch_tables_ = value; }
+  bool prefetch_tables() const { return prefetch_tables_; }
+
+  // If set, the output schemas of table-valued function calls come from
+  // <cache> when an earlier analysis sharing it resolved a call to the same
+  // TVF with the same argument types, instead of from
+  // TableValuedFunction::Resolve().  See public/tvf_signature_cache.h for
+  // the TVFs this is valid for.  The cache must outlive the analyses.
+  void set_tvf_signature_cache(TVFSignatureCache* cache) {
+    tvf_signature_cache_ = cache;
   }
-  const AllowedHintsAndOptions& allowed_hints_and_options() const {
-    return allowed_hints_and_options_;
+  TVFSignatureCache* tvf_signature_cache() const {
+    return tvf_signature_cache_;
   }
 
+  // If true, the resolved AST is allocated in arena() rather than on the
+  // heap, so nodes are allocated together and freeing them is cheap.  The
+  // resolved AST must then not outlive arena(); AnalyzerOutput keeps arena()
+  // alive, so this only matters to callers that take nodes out of it.
+  void set_allocate_resolved_ast_in_arena(bool value) {
+    allocate_resolved_ast_in_arena_ = value;
+  }
+  bool allocate_resolved_ast_in_arena() const {
+    return allocate_resolved_ast_in_arena_;
+  }
+
+  // A time after which analyses with these options stop at the next
+  // statement, scan or expression they resolve, and fail with
+  // DEADLINE_EXCEEDED. Parsing is not interrupted. Defaults to no deadline.
+  void set_deadline(absl::Time deadline) { deadline_ = deadline; }
+  absl::Time deadline() const { return deadline_; }
+
+  // A token that cancels analyses with these options. May be shared by the
+  // options of several analyses, which are all cancelled together. See
+  // AnalyzerCancellationToken.
+  void set_cancellation_token(
+      std::shared_ptr<const AnalyzerCancellationToken> token) {
+    cancellation_token_ = std::move(token);
+  }
+  const std::shared_ptr<const AnalyzerCancellationToken>& cancellation_token()
+      const {
+    return cancellation_token_;
+  }
+
+  // Limits on the work of an analysis. See AnalyzerLimits.
+  void set_limits(const AnalyzerLimits& limits) { limits_ = limits; }
+  const AnalyzerLimits& limits() const { return limits_; }
+
+  void set_allowed_hints_and_options(const AllowedHintsAndOptions& allowed) {
+    allowed_hints_and_options_ =
+        std::make_shared<const AllowedHintsAndOptions>(allowed);
+  }
+  const AllowedHintsAndOptions& allowed_hints_and_options() const;
+
   // Returns the ParserOptions to use for these AnalyzerOptions, including the
   // same id_string_pool() and arena() values.
   ParserOptions GetParserOptions() const;
@@ -486,8 +628,13 @@ class AnalyzerOptions {
   // The keys are lowercased.  Only used in named parameter mode.
   // This doesn't include the columns resolved using the
   // 'lookup_expression_column_callback_' function.
-  QueryParametersMap query_parameters_;
-  QueryParametersMap expression_columns_;
+  //
+  // The maps are shared copy-on-write between copies of AnalyzerOptions, so
+  // that copying base options for each request and adding parameters to the
+  // copy does not copy the maps of the base.  NULL means empty.  Never
+  // modified while shared; see MutableMap().
+  std::shared_ptr<QueryParametersMap> query_parameters_;
+  std::shared_ptr<QueryParametersMap> expression_columns_;
 
   // Callback function to resolve columns in standalone expressions.
   LookupExpressionColumnCallback lookup_expression_column_callback_ = nullptr;
@@ -510,7 +657,9 @@ class AnalyzerOptions {
 
   // If set, use this to allocate column_ids for the resolved AST.
   // This can be used to analyze multiple queries and ensure that
-  // all resolved ASTs have non-overlapping column_ids.
+  // all resolved ASTs have non-overlapping column_ids.  Each analysis reserves
+  // ids from it in blocks, so the ids of one resolved AST need not be
+  // contiguous with those of the analysis before it.
   zetasql_base::SequenceNumber* column_id_sequence_number_ = nullptr;  // Not owned.
 
   // Allocate parts of the parse tree and resolved AST in this arena.
@@ -537,6 +686,9 @@ class AnalyzerOptions {
   // If set to true, record parse locations in ResolvedNodes.
   bool record_parse_locations_ = false;
 
+  // If set to true, record them in the ParseLocationTable of the output.
+  bool compact_parse_locations_ = false;
+
   bool allow_undeclared_parameters_ = false;
 
   ParameterMode parameter_mode_ = PARAMETER_NAMED;
@@ -551,10 +703,45 @@ class AnalyzerOptions {
   // and then remove this option.
   bool prune_unused_columns_ = false;
 
+  // If true, share common subexpressions in the resolved AST of statements.
+  bool eliminate_common_subexpressions_ = false;
+
+  // If true, annotate the ResolvedWithEntries of statements.
+  bool annotate_with_entries_ = false;
+
+  // If true, inline single-use WITH subqueries in statements.
+  bool inline_single_use_with_entries_ = false;
+
+  // If true, call Catalog::PrefetchTables() before resolving statements.
+  // This does not affect the analyzer output, so it is not serialized.
+  bool prefetch_tables_ = false;
+
+  // Not owned.  This does not affect the analyzer output, so it is not
+  // serialized.
+  TVFSignatureCache* tvf_signature_cache_ = nullptr;
+
+  // If true, allocate ResolvedNodes in arena_.  This does not affect the
+  // analyzer output, so it is not serialized.
+  bool allocate_resolved_ast_in_arena_ = false;
+
+  // Limits on the work of an analysis, and the deadline and cancellation of
+  // it.  These do not affect the analyzer output, so they are not serialized.
+  AnalyzerLimits limits_;
+  absl::Time deadline_ = absl::InfiniteFuture();
+  std::shared_ptr<const AnalyzerCancellationToken> cancellation_token_;
+
   // This specifies the set of allowed hints and options, their expected
   // types, and whether to give errors on unrecognized names.
-  // See the class definition for details.
-  AllowedHintsAndOptions allowed_hints_and_options_;
+  // See the class definition for details.  Shared between copies of
+  // AnalyzerOptions; NULL means the default AllowedHintsAndOptions.
+  std::shared_ptr<const AllowedHintsAndOptions> allowed_hints_and_options_;
+
+  // Returns <map> for reading.
+  static const QueryParametersMap& MapOrEmpty(
+      const std::shared_ptr<QueryParametersMap>& map);
+  // Returns <*map> for writing, first copying it if it is shared.
+  static QueryParametersMap* MutableMap(
+      std::shared_ptr<QueryParametersMap>* map);
 
   // Copyable
 };
@@ -567,6 +754,71 @@ class AnalyzerOutputProperties {
   // Copyable
 };
 
+// Memory used in an arena, or its growth over an interval.
+struct ArenaUsage {
+  // Total size of the arena's blocks.
+  int64_t bytes_allocated = 0;
+  // Bytes handed out to allocations.
+  int64_t bytes_used = 0;
+  // Bytes that can no longer be handed out: alignment padding and the unused
+  // tails of blocks the arena moved past.
+  int64_t bytes_wasted = 0;
+  int64_t block_count = 0;
+
+  static ArenaUsage Of(const zetasql_base::UnsafeArena& arena);
+
+  // Returns the growth from <earlier> to this usage.
+  ArenaUsage Since(const ArenaUsage& earlier) const;
+
+  std::string DebugString() const;
+};
+
+// Time taken by a phase of an analysis.
+struct PhaseTime {
+  absl::Duration wall_time;
+  // CPU time of the analyzing thread.
+  absl::Duration cpu_time;
+
+  std::string DebugString() const;
+};
+
+// Memory, time and work counts of producing an AnalyzerOutput, for sizing
+// arenas, finding where slow analyses spend their time and monitoring
+// regressions. Collecting these costs a few clock reads per phase and per
+// catalog lookup, so they are always collected.
+struct AnalyzerRuntimeInfo {
+  // Growth of AnalyzerOutput::arena() and time taken while parsing. Zero when
+  // the analysis started from an existing parse tree.
+  ArenaUsage parser_arena;
+  PhaseTime parser_time;
+  // Tokens read and ASTNodes created by the parser. Zero when the analysis
+  // started from an ASTExpression without its ParserOutput.
+  int64_t num_tokens = 0;
+  int64_t num_ast_nodes = 0;
+
+  // Growth of AnalyzerOutput::arena() while resolving, which includes the
+  // resolved AST when AnalyzerOptions::allocate_resolved_ast_in_arena().
+  ArenaUsage resolver_arena;
+  // Time taken by resolving, which includes Catalog::PrefetchTables(), the
+  // catalog lookups below and rewrites of the resolved AST.
+  PhaseTime resolver_time;
+  // Calls of the Catalog::Find* methods, and their total wall time.
+  int64_t num_catalog_lookups = 0;
+  absl::Duration catalog_lookup_time;
+  // Function signatures matched against the arguments of function calls.
+  int64_t num_signatures_tried = 0;
+  // ResolvedNodes created, including those discarded or rewritten away.
+  int64_t num_resolved_nodes = 0;
+
+  // Usage of the IdStringPool's arena when the analysis finished. This arena is
+  // usually also AnalyzerOutput::arena(), so its growth while parsing and
+  // resolving is included above, and it may hold data from other analyses
+  // that shared it.
+  ArenaUsage id_string_pool_arena;
+
+  std::string DebugString() const;
+};
+
 class AnalyzerOutput {
  public:
   AnalyzerOutput(
@@ -646,7 +898,32 @@ class AnalyzerOutput {
     return analyzer_output_properties_;
   }
 
+  const AnalyzerRuntimeInfo& runtime_info() const { return runtime_info_; }
+  AnalyzerRuntimeInfo* mutable_runtime_info() { return &runtime_info_; }
+
+  // With AnalyzerOptions::compact_parse_locations(), the table of the parse
+  // locations of the resolved nodes, or NULL otherwise.
+  std::shared_ptr<const ParseLocationTable> parse_locations() const {
+    return parse_locations_;
+  }
+  void set_parse_locations(
+      std::shared_ptr<const ParseLocationTable> parse_locations) {
+    parse_locations_ = std::move(parse_locations);
+  }
+
+  // Sets <*range> to the parse location of <node> in the resolved AST, from
+  // the node itself or from parse_locations(), and returns true, or returns
+  // false if it has none.
+  bool GetParseLocationRange(const ResolvedNode* node,
+                             ParseLocationRange* range) const;
+
  private:
+  // Reanalyzes from <parser_output_>.
+  friend zetasql_base::Status RebindQueryParameters(
+      const AnalyzerOutput& analyzed, absl::string_view sql,
+      const AnalyzerOptions& options, Catalog* catalog,
+      TypeFactory* type_factory, std::unique_ptr<const AnalyzerOutput>* output);
+
   // This IdStringPool and arena must be kept alive for the Resolved trees below
   // to be valid.
   std::shared_ptr<IdStringPool> id_string_pool_;
@@ -657,6 +934,10 @@ class AnalyzerOutput {
 
   AnalyzerOutputProperties analyzer_output_properties_;
 
+  AnalyzerRuntimeInfo runtime_info_;
+
+  std::shared_ptr<const ParseLocationTable> parse_locations_;
+
   // AnalyzerOutput can (but is not guaranteed to) take ownership of the parser
   // output so deleting the parser AST can be deferred.  Deleting the parser
   // AST is expensive.  This allows engines to defer AnalyzerOutput cleanup
@@ -723,6 +1004,49 @@ zetasql_base::Status AnalyzeStatementFromParserOutputUnowned(
     const AnalyzerOptions& options, absl::string_view sql, Catalog* catalog,
     TypeFactory* type_factory, std::unique_ptr<const AnalyzerOutput>* output);
 
+// Returns true if analyzing the statement of <analyzed> again with the query
+// parameters of <options> would give the same resolved statement, because
+// every parameter the statement references keeps its type.  A parameter that
+// was undeclared in <analyzed> matches only if it is still undeclared and
+// <options> allows undeclared parameters.  All other settings in <options> are
+// assumed to be the ones <analyzed> was produced with.
+//
+// Engines that cache plans by SQL text can use this to share one plan across
+// requests that bind the parameters differently but with the same types.
+bool QueryParameterTypesMatch(const AnalyzerOutput& analyzed,
+                              const AnalyzerOptions& options);
+
+// Analyzes the statement of <analyzed>, which AnalyzeStatement() or
+// AnalyzeNextStatement() produced from <sql>, again with the query parameters
+// of <options>.  This skips parsing by reusing the parse tree kept in
+// <analyzed>; resolution is redone for the whole statement, since a new
+// parameter type can change coercions, function signatures and output column
+// types anywhere above it.  Callers should check QueryParameterTypesMatch()
+// first and keep using <analyzed> when it returns true.
+//
+// <*output> may refer to IdStrings owned by <analyzed>, so <analyzed> must
+// outlive it.  Returns an error if <analyzed> does not own its parse tree, as
+// is the case for AnalyzeStatementFromParserOutputUnowned() and expressions.
+zetasql_base::Status RebindQueryParameters(
+    const AnalyzerOutput& analyzed, absl::string_view sql,
+    const AnalyzerOptions& options, Catalog* catalog, TypeFactory* type_factory,
+    std::unique_ptr<const AnalyzerOutput>* output);
+
+// Returns a copy of <analyzed> that holds only what its resolved statement or
+// expression needs, for keeping many analyses, e.g. in a cache.  The copy has
+// no parse tree, and its IdStrings are in a new IdStringPool with its own
+// arena, so the arenas used while parsing and resolving can be released
+// with <analyzed>.  RebindQueryParameters() cannot be used with the copy.
+//
+// The resolved tree is rebuilt through ResolvedNode::SaveTo() and
+// RestoreFrom(), so <catalog> must find every object that the analysis of
+// <analyzed> found, and <type_factory> owns the non-simple types of the
+// copy's tree and must outlive it.  Types of the query parameters are those
+// of <analyzed>.  The copy shares the parse_locations() of <analyzed>.
+zetasql_base::StatusOr<std::unique_ptr<const AnalyzerOutput>>
+CompactAnalyzerOutput(const AnalyzerOutput& analyzed, Catalog* catalog,
+                      TypeFactory* type_factory);
+
 // Analyze a ZetaSQL expression.  The expression may include query
 // parameters, subqueries, and any other valid expression syntax.
 //
@@ -760,6 +1084,55 @@ zetasql_base::Status AnalyzeExpressionFromParserAST(
     absl::string_view sql, TypeFactory* type_factory, Catalog* catalog,
     std::unique_ptr<const AnalyzerOutput>* output);
 
+// Analyzes many standalone expressions against the same AnalyzerOptions and
+// Catalog, as AnalyzeExpression() does, without validating and copying the
+// options for each expression.  This helps callers that analyze large
+// numbers of filter expressions over the same expression columns.
+//
+// Unless <options> already has an arena and IdStringPool, every
+// Analyze call creates new ones so that each AnalyzerOutput only keeps
+// alive the memory for its own expression.
+//
+// Not thread-safe.  Callers analyzing from several threads should prepare
+// one PreparedExpressionAnalyzer per thread.
+class PreparedExpressionAnalyzer {
+ public:
+  // Validates <options> and creates a PreparedExpressionAnalyzer for them in
+  // <*prepared>.  Does not take ownership of <catalog> or <type_factory>,
+  // which must outlive it.
+  static zetasql_base::Status Create(
+      const AnalyzerOptions& options, Catalog* catalog,
+      TypeFactory* type_factory,
+      std::unique_ptr<PreparedExpressionAnalyzer>* prepared);
+
+  PreparedExpressionAnalyzer(const PreparedExpressionAnalyzer&) = delete;
+  PreparedExpressionAnalyzer& operator=(const PreparedExpressionAnalyzer&) =
+      delete;
+
+  // Same as AnalyzeExpression() with the prepared options and catalog.
+  zetasql_base::Status Analyze(absl::string_view sql,
+                       std::unique_ptr<const AnalyzerOutput>* output);
+
+  // Same as AnalyzeExpressionForAssignmentToType() with the prepared options
+  // and catalog.
+  zetasql_base::Status AnalyzeForAssignmentToType(
+      absl::string_view sql, const Type* target_type,
+      std::unique_ptr<const AnalyzerOutput>* output);
+
+  const AnalyzerOptions& options() const { return options_; }
+
+ private:
+  PreparedExpressionAnalyzer(const AnalyzerOptions& options, Catalog* catalog,
+                             TypeFactory* type_factory);
+
+  AnalyzerOptions options_;
+  // True if <options_> came with an arena and IdStringPool, which are then
+  // shared by all outputs.
+  const bool has_caller_arenas_;
+  Catalog* catalog_;  // Not owned.
+  TypeFactory* type_factory_;  // Not owned.
+};
+
 // Parse and analyze a ZetaSQL type name.
 // The type may reference type names from <catalog>.
 // Returns a type in <output_type> on success.
@@ -855,6 +1228,28 @@ zetasql_base::Status ExtractTableNamesFromASTScript(const ASTScript& ast_script,
                                             absl::string_view sql,
                                             TableNamesSet* table_names);
 
+// Size and shape of a parse tree, as a cheap predictor of the work of
+// resolving it.
+struct QueryComplexity {
+  // ASTNodes in the tree, and the length of its longest root-to-leaf path,
+  // counting nodes.
+  int64_t num_nodes = 0;
+  int64_t max_depth = 0;
+  // Table path expressions and TVF calls, including references to WITH
+  // aliases. Each is usually a catalog lookup.
+  int64_t num_table_references = 0;
+  // Weighted count of the nodes, where the nodes that make the resolver look
+  // up names in the catalog, match function signatures or build name scopes
+  // weigh more. Only comparisons between estimates are meaningful.
+  int64_t estimated_resolution_cost = 0;
+
+  std::string DebugString() const;
+};
+
+// Computes the QueryComplexity of the tree rooted at <root>, in time linear in
+// its size and without recursion, so it is safe on arbitrarily deep trees.
+QueryComplexity EstimateQueryComplexity(const ASTNode& root);
+
 // Resolved "FOR SYSTEM_TIME AS OF" expression.
 struct TableResolutionTimeExpr {
   const ASTExpression* ast_expr;
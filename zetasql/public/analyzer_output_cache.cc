@@ -0,0 +1,101 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/analyzer_output_cache.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "zetasql/proto/options.pb.h"
+#include "absl/strings/str_cat.h"
+#include "zetasql/base/status.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+AnalyzerOutputCache::AnalyzerOutputCache(int max_entries)
+    : cache_(max_entries) {}
+
+AnalyzerOutputCache::~AnalyzerOutputCache() {}
+
+bool AnalyzerOutputCache::MakeKey(absl::string_view sql,
+                                  const AnalyzerOptions& options,
+                                  const SimpleCatalog* catalog,
+                                  const TypeFactory* type_factory,
+                                  std::string* key) {
+  if (options.lookup_expression_column_callback() != nullptr ||
+      options.ddl_pseudo_columns_callback() != nullptr ||
+      options.column_id_sequence_number() != nullptr) {
+    return false;
+  }
+  // Proto and enum types in the options are serialized by name, so the
+  // DescriptorPools they come from are recorded in the key as well.
+  FileDescriptorSetMap file_descriptor_set_map;
+  AnalyzerOptionsProto options_proto;
+  if (!options.Serialize(&file_descriptor_set_map, &options_proto).ok()) {
+    return false;
+  }
+  std::string serialized_options;
+  if (!options_proto.SerializeToString(&serialized_options)) {
+    return false;
+  }
+  // All fields before the options have a known terminator, so distinct
+  // inputs always produce distinct keys.
+  *key = absl::StrCat(absl::Hex(catalog), ",", absl::Hex(type_factory), ",",
+                      catalog->version());
+  for (const auto& entry : file_descriptor_set_map) {
+    absl::StrAppend(key, ",", absl::Hex(entry.first));
+  }
+  absl::StrAppend(key, ";", sql.size(), ":", sql, serialized_options);
+  return true;
+}
+
+zetasql_base::Status AnalyzerOutputCache::AnalyzeStatement(
+    absl::string_view sql, const AnalyzerOptions& options,
+    SimpleCatalog* catalog, TypeFactory* type_factory,
+    std::shared_ptr<const AnalyzerOutput>* output) {
+  std::string key;
+  const bool cacheable = MakeKey(sql, options, catalog, type_factory, &key);
+  Entry entry;
+  if (cacheable && cache_.Lookup(key, &entry)) {
+    *output = std::move(entry.output);
+    return ::zetasql_base::OkStatus();
+  }
+  // Analyze outside of the cache lock.  Concurrent misses on the same key
+  // may both analyze; the last one to finish wins.
+  std::unique_ptr<const AnalyzerOutput> analyzer_output;
+  ZETASQL_RETURN_IF_ERROR(zetasql::AnalyzeStatement(sql, options, catalog,
+                                            type_factory, &analyzer_output));
+  if (cacheable && compact_outputs_) {
+    ZETASQL_ASSIGN_OR_RETURN(
+        analyzer_output,
+        CompactAnalyzerOutput(*analyzer_output, catalog, type_factory));
+  }
+  *output = std::move(analyzer_output);
+  if (cacheable) {
+    cache_.Insert(key, Entry{catalog, *output});
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+int AnalyzerOutputCache::InvalidateCatalog(const SimpleCatalog* catalog) {
+  return cache_.EraseIf([catalog](const std::string& key, const Entry& entry) {
+    return entry.catalog == catalog;
+  });
+}
+
+}  // namespace zetasql
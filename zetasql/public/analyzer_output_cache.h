@@ -0,0 +1,108 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PUBLIC_ANALYZER_OUTPUT_CACHE_H_
+#define ZETASQL_PUBLIC_ANALYZER_OUTPUT_CACHE_H_
+
+#include <memory>
+#include <string>
+
+#include "zetasql/common/lru_cache.h"
+#include "zetasql/public/analyzer.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "absl/strings/string_view.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+
+// A thread-safe, size-bounded LRU cache of analyzed statements.
+//
+// Entries are keyed by the exact SQL text, the serialized AnalyzerOptions,
+// the SimpleCatalog and TypeFactory used, and SimpleCatalog::version().
+// Any change to the catalog (or to a SimpleCatalog nested in it) therefore
+// makes earlier entries unreachable; they age out of the cache as new
+// entries are added, or can be dropped eagerly with InvalidateCatalog().
+//
+// Options that cannot be captured in the key bypass the cache, and the
+// statement is analyzed normally.  This is the case when the options have a
+// lookup_expression_column_callback(), a ddl_pseudo_columns_callback() or a
+// column_id_sequence_number(), or when the options fail to serialize.
+//
+// Cached outputs are immutable and may be shared between threads.  They
+// refer to objects owned by the catalog and the TypeFactory, both of which
+// must outlive every output returned from the cache.  Objects reachable from
+// the catalog must not be modified in ways that change analysis results
+// without also changing the catalog version, e.g. by mutating a SimpleTable
+// in place.
+//
+// Analysis errors are not cached.
+class AnalyzerOutputCache {
+ public:
+  // <max_entries> must be positive.
+  explicit AnalyzerOutputCache(int max_entries);
+  AnalyzerOutputCache(const AnalyzerOutputCache&) = delete;
+  AnalyzerOutputCache& operator=(const AnalyzerOutputCache&) = delete;
+  ~AnalyzerOutputCache();
+
+  // Same as zetasql::AnalyzeStatement(), but returns a shared
+  // AnalyzerOutput that may come from the cache.
+  zetasql_base::Status AnalyzeStatement(absl::string_view sql,
+                                const AnalyzerOptions& options,
+                                SimpleCatalog* catalog,
+                                TypeFactory* type_factory,
+                                std::shared_ptr<const AnalyzerOutput>* output);
+
+  // Removes all entries that were analyzed against <catalog>, regardless of
+  // version.  Must be called before <catalog> is destroyed if the cache may
+  // outlive it.  Returns the number of entries removed.
+  int InvalidateCatalog(const SimpleCatalog* catalog);
+
+  // If true, outputs are compacted with CompactAnalyzerOutput() before they
+  // are cached, which drops their parse trees and parser arenas at the cost
+  // of a serialization round trip of each analyzed statement.  Must be set
+  // before the cache is used.
+  void set_compact_outputs(bool compact_outputs) {
+    compact_outputs_ = compact_outputs;
+  }
+  bool compact_outputs() const { return compact_outputs_; }
+
+  // Removes all entries.  Outputs already handed out remain valid.
+  void Clear() { cache_.Clear(); }
+
+  int max_entries() const { return cache_.max_entries(); }
+  int size() const { return cache_.size(); }
+  LruCacheStats stats() const { return cache_.stats(); }
+
+ private:
+  struct Entry {
+    const SimpleCatalog* catalog;
+    std::shared_ptr<const AnalyzerOutput> output;
+  };
+
+  // Computes the cache key for the given inputs into <*key>.  Returns false
+  // if the inputs cannot be cached.
+  static bool MakeKey(absl::string_view sql, const AnalyzerOptions& options,
+                      const SimpleCatalog* catalog,
+                      const TypeFactory* type_factory, std::string* key);
+
+  LruCache<std::string, Entry> cache_;
+  bool compact_outputs_ = false;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_ANALYZER_OUTPUT_CACHE_H_
@@ -0,0 +1,130 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/analyzer_output_cache.h"
+
+#include <memory>
+#include <string>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/analyzer.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace zetasql {
+
+using testing::NotNull;
+
+class AnalyzerOutputCacheTest : public ::testing::Test {
+ protected:
+  AnalyzerOutputCacheTest() : catalog_("catalog", &type_factory_) {
+    catalog_.AddOwnedTable(new SimpleTable(
+        "T", {{"key", type_factory_.get_int64()}}));
+  }
+
+  zetasql_base::Status Analyze(absl::string_view sql,
+                       std::shared_ptr<const AnalyzerOutput>* output) {
+    return cache_.AnalyzeStatement(sql, options_, &catalog_, &type_factory_,
+                                   output);
+  }
+
+  TypeFactory type_factory_;
+  SimpleCatalog catalog_;
+  AnalyzerOptions options_;
+  AnalyzerOutputCache cache_{/*max_entries=*/10};
+};
+
+TEST_F(AnalyzerOutputCacheTest, HitReturnsSameOutput) {
+  std::shared_ptr<const AnalyzerOutput> output1;
+  std::shared_ptr<const AnalyzerOutput> output2;
+  ZETASQL_ASSERT_OK(Analyze("SELECT key FROM T", &output1));
+  ZETASQL_ASSERT_OK(Analyze("SELECT key FROM T", &output2));
+  ASSERT_THAT(output1->resolved_statement(), NotNull());
+  EXPECT_EQ(output1.get(), output2.get());
+  EXPECT_EQ(1, cache_.size());
+  EXPECT_EQ(1, cache_.stats().hits);
+}
+
+TEST_F(AnalyzerOutputCacheTest, OptionsAreKeyed) {
+  std::shared_ptr<const AnalyzerOutput> output1;
+  std::shared_ptr<const AnalyzerOutput> output2;
+  ZETASQL_ASSERT_OK(options_.AddQueryParameter("p", type_factory_.get_int64()));
+  ZETASQL_ASSERT_OK(Analyze("SELECT @p", &output1));
+  ZETASQL_ASSERT_OK(options_.AddQueryParameter("q", type_factory_.get_int64()));
+  ZETASQL_ASSERT_OK(Analyze("SELECT @p", &output2));
+  EXPECT_NE(output1.get(), output2.get());
+}
+
+TEST_F(AnalyzerOutputCacheTest, CatalogChangesInvalidate) {
+  std::shared_ptr<const AnalyzerOutput> output1;
+  std::shared_ptr<const AnalyzerOutput> output2;
+  ZETASQL_ASSERT_OK(Analyze("SELECT key FROM T", &output1));
+
+  // Changes to a nested SimpleCatalog are visible through the parent.
+  SimpleCatalog* nested = catalog_.MakeOwnedSimpleCatalog("nested");
+  ZETASQL_ASSERT_OK(Analyze("SELECT key FROM T", &output1));
+  nested->AddOwnedTable(new SimpleTable("U"));
+  ZETASQL_ASSERT_OK(Analyze("SELECT key FROM T", &output2));
+  EXPECT_NE(output1.get(), output2.get());
+
+  EXPECT_EQ(3, cache_.InvalidateCatalog(&catalog_));
+  EXPECT_EQ(0, cache_.size());
+}
+
+TEST_F(AnalyzerOutputCacheTest, ErrorsAreNotCached) {
+  std::shared_ptr<const AnalyzerOutput> output;
+  EXPECT_FALSE(Analyze("SELECT missing FROM T", &output).ok());
+  EXPECT_EQ(0, cache_.size());
+}
+
+TEST_F(AnalyzerOutputCacheTest, UncacheableOptionsBypassCache) {
+  zetasql_base::SequenceNumber sequence;
+  options_.set_column_id_sequence_number(&sequence);
+  std::shared_ptr<const AnalyzerOutput> output;
+  ZETASQL_ASSERT_OK(Analyze("SELECT key FROM T", &output));
+  ASSERT_THAT(output->resolved_statement(), NotNull());
+  EXPECT_EQ(0, cache_.size());
+}
+
+TEST_F(AnalyzerOutputCacheTest, CompactOutputs) {
+  catalog_.AddZetaSQLFunctions();
+  const std::string sql = "SELECT key, key + 1 AS next_key FROM T";
+  std::unique_ptr<const AnalyzerOutput> expected;
+  ZETASQL_ASSERT_OK(AnalyzeStatement(sql, options_, &catalog_, &type_factory_,
+                             &expected));
+
+  cache_.set_compact_outputs(true);
+  std::shared_ptr<const AnalyzerOutput> output1;
+  std::shared_ptr<const AnalyzerOutput> output2;
+  ZETASQL_ASSERT_OK(Analyze(sql, &output1));
+  ZETASQL_ASSERT_OK(Analyze(sql, &output2));
+  EXPECT_EQ(output1.get(), output2.get());
+  ASSERT_THAT(output1->resolved_statement(), NotNull());
+  EXPECT_EQ(expected->resolved_statement()->DebugString(),
+            output1->resolved_statement()->DebugString());
+
+  // The compacted arena holds only the strings of the resolved tree.
+  EXPECT_NE(expected->arena().get(), output1->arena().get());
+  EXPECT_LT(ArenaUsage::Of(*output1->arena()).bytes_allocated,
+            ArenaUsage::Of(*expected->arena()).bytes_allocated);
+  EXPECT_EQ(ArenaUsage::Of(*output1->arena()).bytes_used,
+            output1->runtime_info().id_string_pool_arena.bytes_used);
+}
+
+}  // namespace zetasql
@@ -0,0 +1,95 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/batch_reader_table_iterator.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "zetasql/base/logging.h"
+#include "zetasql/base/source_location.h"
+#include "zetasql/base/status_builder.h"
+
+namespace zetasql {
+
+BatchReaderTableIterator::BatchReaderTableIterator(
+    std::unique_ptr<ValueBatchReader> reader)
+    : reader_(std::move(reader)) {
+  for (int i = 0; i < reader_->NumColumns(); ++i) {
+    column_types_.push_back(reader_->GetColumnType(i));
+  }
+  current_ = ValueBatch(column_types_);
+  row_.resize(column_types_.size());
+}
+
+bool BatchReaderTableIterator::AdvanceBatch() {
+  while (!done_) {
+    if (cancelled_.load()) {
+      status_ = ::zetasql_base::CancelledErrorBuilder(ZETASQL_LOC)
+                << "Table scan was cancelled";
+      done_ = true;
+    } else if (absl::Now() >= deadline_) {
+      status_ = ::zetasql_base::DeadlineExceededErrorBuilder(ZETASQL_LOC)
+                << "Deadline exceeded while reading table";
+      done_ = true;
+    } else if (!reader_->ReadNext(&current_)) {
+      status_ = reader_->Status();
+      done_ = true;
+    } else {
+      DCHECK_EQ(current_.num_columns(), column_types_.size());
+      next_row_in_current_ = 0;
+      if (current_.num_rows() > 0) return true;
+    }
+  }
+  return false;
+}
+
+bool BatchReaderTableIterator::NextRow() {
+  if (next_row_in_current_ >= current_.num_rows() && !AdvanceBatch()) {
+    return false;
+  }
+  for (int i = 0; i < row_.size(); ++i) {
+    row_[i] = current_.column(i).GetValue(next_row_in_current_);
+  }
+  ++next_row_in_current_;
+  return true;
+}
+
+bool BatchReaderTableIterator::NextBatch(int max_rows, ValueBatch* batch) {
+  if (next_row_in_current_ >= current_.num_rows() && !AdvanceBatch()) {
+    batch->Clear();
+    return false;
+  }
+  if (next_row_in_current_ == 0 && current_.num_rows() <= max_rows) {
+    // Hand over the whole batch without copying.
+    std::swap(*batch, current_);
+    current_ = ValueBatch(column_types_);
+    return true;
+  }
+  *batch = ValueBatch(column_types_);
+  const int end =
+      std::min(current_.num_rows(), next_row_in_current_ + max_rows);
+  batch->AppendRows(current_, next_row_in_current_, end);
+  next_row_in_current_ = end;
+  return true;
+}
+
+zetasql_base::Status BatchReaderTableIterator::Cancel() {
+  cancelled_.store(true);
+  return ::zetasql_base::OkStatus();
+}
+
+}  // namespace zetasql
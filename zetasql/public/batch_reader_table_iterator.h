@@ -0,0 +1,108 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PUBLIC_BATCH_READER_TABLE_ITERATOR_H_
+#define ZETASQL_PUBLIC_BATCH_READER_TABLE_ITERATOR_H_
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/public/value_batch.h"
+#include "absl/time/time.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+
+// A stream of ValueBatches with a fixed set of columns, such as an adapter
+// over a columnar storage format.  ColumnVectors use the layout of Arrow
+// arrays (a validity bitmap, contiguous values, and 64-bit offsets into the
+// data of strings), so an adapter can usually fill them with one copy of
+// each buffer.
+class ValueBatchReader {
+ public:
+  virtual ~ValueBatchReader() {}
+
+  virtual int NumColumns() const = 0;
+  virtual std::string GetColumnName(int i) const = 0;
+  virtual const Type* GetColumnType(int i) const = 0;
+
+  // Replaces the contents of '*batch' with the next batch, whose columns
+  // have the types of this reader.  Batches may be empty.  Returns false at
+  // the end of the stream or on an error; the caller must then check
+  // 'Status()'.
+  virtual bool ReadNext(ValueBatch* batch) = 0;
+
+  // Returns OK unless the last call to ReadNext() returned false because of
+  // an error.
+  virtual zetasql_base::Status Status() const = 0;
+};
+
+// An EvaluatorTableIterator over the batches of a ValueBatchReader.
+//
+// NextBatch() hands over each batch the reader produced without copying it
+// when it fits in 'max_rows', and otherwise copies slices of its buffers, so
+// batched consumers never create a Value per cell.  NextRow() and GetValue()
+// convert the cells of one row at a time.
+//
+// Cancel() may be called from any thread, and makes the next call to
+// NextRow() or NextBatch() fail with a kCancelled Status().  The deadline is
+// checked before each batch is read.
+class BatchReaderTableIterator : public EvaluatorTableIterator {
+ public:
+  explicit BatchReaderTableIterator(std::unique_ptr<ValueBatchReader> reader);
+  BatchReaderTableIterator(const BatchReaderTableIterator&) = delete;
+  BatchReaderTableIterator& operator=(const BatchReaderTableIterator&) =
+      delete;
+
+  int NumColumns() const override { return column_types_.size(); }
+  std::string GetColumnName(int i) const override {
+    return reader_->GetColumnName(i);
+  }
+  const Type* GetColumnType(int i) const override { return column_types_[i]; }
+
+  bool NextRow() override;
+  const Value& GetValue(int i) const override { return row_[i]; }
+  bool NextBatch(int max_rows, ValueBatch* batch) override;
+
+  zetasql_base::Status Status() const override { return status_; }
+  zetasql_base::Status Cancel() override;
+  void SetDeadline(absl::Time deadline) override { deadline_ = deadline; }
+
+ private:
+  // Makes 'current_' the next batch of the reader with at least one row.
+  // Returns false at the end of the rows, after setting 'status_'.
+  bool AdvanceBatch();
+
+  const std::unique_ptr<ValueBatchReader> reader_;
+  std::vector<const Type*> column_types_;
+  absl::Time deadline_ = absl::InfiniteFuture();
+  std::atomic<bool> cancelled_{false};
+
+  ValueBatch current_;
+  int next_row_in_current_ = 0;  // Index of the next unread row of 'current_'.
+  std::vector<Value> row_;
+  bool done_ = false;
+  zetasql_base::Status status_;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_BATCH_READER_TABLE_ITERATOR_H_
@@ -0,0 +1,143 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/batch_reader_table_iterator.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/public/value_batch.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace zetasql {
+namespace {
+
+using zetasql_base::testing::StatusIs;
+
+// Returns batches of rows (i, "s<i>") with the given sizes, then
+// <final_status>.
+class TestReader : public ValueBatchReader {
+ public:
+  TestReader(std::vector<int> batch_sizes, zetasql_base::Status final_status)
+      : batch_sizes_(std::move(batch_sizes)),
+        final_status_(std::move(final_status)) {}
+
+  int NumColumns() const override { return 2; }
+  std::string GetColumnName(int i) const override {
+    return i == 0 ? "key" : "value";
+  }
+  const Type* GetColumnType(int i) const override {
+    return i == 0 ? types::Int64Type() : types::StringType();
+  }
+
+  bool ReadNext(ValueBatch* batch) override {
+    if (next_batch_ == batch_sizes_.size()) {
+      status_ = final_status_;
+      return false;
+    }
+    *batch = ValueBatch({types::Int64Type(), types::StringType()});
+    for (int i = 0; i < batch_sizes_[next_batch_]; ++i, ++next_row_) {
+      batch->mutable_column(0)->AppendInt64(next_row_);
+      batch->mutable_column(1)->AppendString(absl::StrCat("s", next_row_));
+    }
+    batch->set_num_rows(batch_sizes_[next_batch_]);
+    ++next_batch_;
+    return true;
+  }
+
+  zetasql_base::Status Status() const override { return status_; }
+
+ private:
+  const std::vector<int> batch_sizes_;
+  const zetasql_base::Status final_status_;
+  int next_batch_ = 0;
+  int next_row_ = 0;
+  zetasql_base::Status status_;
+};
+
+std::unique_ptr<BatchReaderTableIterator> MakeIterator(
+    std::vector<int> batch_sizes,
+    zetasql_base::Status final_status = zetasql_base::OkStatus()) {
+  return absl::make_unique<BatchReaderTableIterator>(
+      absl::make_unique<TestReader>(std::move(batch_sizes),
+                                    std::move(final_status)));
+}
+
+TEST(BatchReaderTableIteratorTest, NextRow) {
+  std::unique_ptr<BatchReaderTableIterator> iter = MakeIterator({2, 0, 3});
+  ASSERT_EQ(2, iter->NumColumns());
+  EXPECT_EQ("value", iter->GetColumnName(1));
+  EXPECT_TRUE(iter->GetColumnType(1)->IsString());
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_TRUE(iter->NextRow());
+    EXPECT_EQ(Value::Int64(i), iter->GetValue(0));
+    EXPECT_EQ(Value::String(absl::StrCat("s", i)), iter->GetValue(1));
+  }
+  EXPECT_FALSE(iter->NextRow());
+  ZETASQL_EXPECT_OK(iter->Status());
+}
+
+TEST(BatchReaderTableIteratorTest, NextBatch) {
+  std::unique_ptr<BatchReaderTableIterator> iter = MakeIterator({3, 10, 4});
+  ValueBatch batch;
+  std::vector<int> sizes;
+  int next_row = 0;
+  while (iter->NextBatch(/*max_rows=*/4, &batch)) {
+    sizes.push_back(batch.num_rows());
+    for (int row = 0; row < batch.num_rows(); ++row, ++next_row) {
+      EXPECT_EQ(next_row, batch.column(0).int64_data()[row]);
+      EXPECT_EQ(absl::StrCat("s", next_row),
+                batch.column(1).GetStringView(row));
+    }
+  }
+  ZETASQL_EXPECT_OK(iter->Status());
+  // Batches that fit are passed through, and larger ones are split.
+  EXPECT_THAT(sizes, testing::ElementsAre(3, 4, 4, 2, 4));
+  EXPECT_EQ(0, batch.num_rows());
+}
+
+TEST(BatchReaderTableIteratorTest, Errors) {
+  std::unique_ptr<BatchReaderTableIterator> iter =
+      MakeIterator({1}, zetasql_base::InternalError("read failed"));
+  EXPECT_TRUE(iter->NextRow());
+  EXPECT_FALSE(iter->NextRow());
+  EXPECT_THAT(iter->Status(), StatusIs(zetasql_base::StatusCode::kInternal));
+
+  iter = MakeIterator({1, 1});
+  EXPECT_TRUE(iter->NextRow());
+  ZETASQL_EXPECT_OK(iter->Cancel());
+  EXPECT_FALSE(iter->NextRow());
+  EXPECT_THAT(iter->Status(), StatusIs(zetasql_base::StatusCode::kCancelled));
+
+  iter = MakeIterator({1});
+  iter->SetDeadline(absl::Now() - absl::Seconds(1));
+  EXPECT_FALSE(iter->NextRow());
+  EXPECT_THAT(iter->Status(),
+              StatusIs(zetasql_base::StatusCode::kDeadlineExceeded));
+}
+
+}  // namespace
+}  // namespace zetasql
@@ -32,6 +32,7 @@
 #include "google/type/timeofday.pb.h"
 #include "zetasql/common/errors.h"
 #include "zetasql/proto/options.pb.h"
+#include "zetasql/public/builtin_function_internal.h"
 #include "zetasql/public/catalog.h"
 #include "zetasql/public/cycle_detector.h"
 #include "zetasql/public/function.h"
@@ -44,6 +45,8 @@
 #include "zetasql/public/value.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/memory/memory.h"
+#include "absl/synchronization/mutex.h"
 #include "zetasql/base/bind_front.h"
 #include "zetasql/base/case.h"
 #include "absl/strings/str_cat.h"
@@ -73,7 +76,6 @@ ZetaSQLBuiltinFunctionOptions::ZetaSQLBuiltinFunctionOptions(
 using ::zetasql_base::bind_front;
 using ::zetasql::functions::DateTimestampPartToSQL;
 
-using FunctionIdToNameMap = absl::flat_hash_map<FunctionSignatureId, std::string>;
 using NameToFunctionMap = std::map<std::string, std::unique_ptr<Function>>;
 
 // If std::string literal is compared against bytes, then we want the error message
@@ -83,10 +85,12 @@ static constexpr absl::string_view kErrorMessageCompareStringLiteralToBytes =
     "comparable. To write a BYTES literal, use a b-prefixed literal "
     "such as b'bytes value'";
 
-static const FunctionIdToNameMap& GetFunctionIdToNameMap() {
-  static FunctionIdToNameMap* id_map = [] () {
-    // Initialize map from ZetaSQL function to function names.
-    FunctionIdToNameMap* id_map = new FunctionIdToNameMap();
+// Returns the BuiltinSignatureInfo of every FunctionSignatureId, indexed by
+// the id. The entries of ids that are not builtin signatures have no name.
+static const std::vector<BuiltinSignatureInfo>& GetBuiltinSignatureInfos() {
+  static const std::vector<BuiltinSignatureInfo>* infos = [] () {
+    auto* infos =
+        new std::vector<BuiltinSignatureInfo>(FunctionSignatureId_ARRAYSIZE);
     TypeFactory type_factory;
     NameToFunctionMap functions;
 
@@ -106,21 +110,31 @@ static const FunctionIdToNameMap& GetFunctionIdToNameMap() {
     for (const auto& function_entry : functions) {
       for (const FunctionSignature& signature :
                function_entry.second->signatures()) {
-        zetasql_base::InsertOrDie(
-            id_map,
-            static_cast<FunctionSignatureId>(signature.context_id()),
-            function_entry.first);
+        const int64_t id = signature.context_id();
+        CHECK(id >= 0 && id < FunctionSignatureId_ARRAYSIZE) << id;
+        BuiltinSignatureInfo& info = (*infos)[id];
+        CHECK(info.function_name.empty())
+            << "Duplicate FunctionSignatureId " << id;
+        info.id = static_cast<FunctionSignatureId>(id);
+        info.function_name = function_entry.first;
+        info.mode = function_entry.second->mode();
       }
     }
-    return id_map;
+    return infos;
   } ();
-  return *id_map;
+  return *infos;
+}
+
+const BuiltinSignatureInfo* GetBuiltinSignatureInfo(FunctionSignatureId id) {
+  if (id < 0 || id >= FunctionSignatureId_ARRAYSIZE) return nullptr;
+  const BuiltinSignatureInfo& info = GetBuiltinSignatureInfos()[id];
+  return info.function_name.empty() ? nullptr : &info;
 }
 
 const std::string FunctionSignatureIdToName(FunctionSignatureId id) {
-  const std::string* name = zetasql_base::FindOrNull(GetFunctionIdToNameMap(), id);
-  if (name != nullptr) {
-    return *name;
+  const BuiltinSignatureInfo* info = GetBuiltinSignatureInfo(id);
+  if (info != nullptr) {
+    return info->function_name;
   }
   return absl::StrCat("<INVALID FUNCTION ID: ", id, ">");
 }
@@ -4441,38 +4455,125 @@ static void GetGeographyFunctions(
                  geography_required);
 }
 
-void GetZetaSQLFunctions(TypeFactory* type_factory,
-                           const ZetaSQLBuiltinFunctionOptions& options,
-                           NameToFunctionMap* functions) {
-  GetDatetimeFunctions(type_factory, options, functions);
-  GetArithmeticFunctions(type_factory, options, functions);
-  GetBitwiseFunctions(type_factory, options, functions);
-  GetAggregateFunctions(type_factory, options, functions);
-  GetApproxFunctions(type_factory, options, functions);
-  GetStatisticalFunctions(type_factory, options, functions);
-  GetBooleanFunctions(type_factory, options, functions);
-  GetLogicFunctions(type_factory, options, functions);
-  GetStringFunctions(type_factory, options, functions);
-  GetRegexFunctions(type_factory, options, functions);
-  GetMiscellaneousFunctions(type_factory, options, functions);
-  GetMathFunctions(type_factory, options, functions);
-  GetHllCountFunctions(type_factory, options, functions);
-  GetKllQuantilesFunctions(type_factory, options, functions);
-  GetProto3ConversionFunctions(type_factory, options, functions);
+static void GetAnalyticFunctionsIfEnabled(
+    TypeFactory* type_factory, const ZetaSQLBuiltinFunctionOptions& options,
+    NameToFunctionMap* functions) {
   if (options.language_options.LanguageFeatureEnabled(
           FEATURE_ANALYTIC_FUNCTIONS)) {
     GetAnalyticFunctions(type_factory, options, functions);
   }
-  GetNetFunctions(type_factory, options, functions);
-  GetHashingFunctions(type_factory, options, functions);
+}
+
+static void GetEncryptionFunctionsIfEnabled(
+    TypeFactory* type_factory, const ZetaSQLBuiltinFunctionOptions& options,
+    NameToFunctionMap* functions) {
   if (options.language_options.LanguageFeatureEnabled(FEATURE_ENCRYPTION)) {
     GetEncryptionFunctions(type_factory, options, functions);
   }
+}
+
+static void GetGeographyFunctionsIfEnabled(
+    TypeFactory* type_factory, const ZetaSQLBuiltinFunctionOptions& options,
+    NameToFunctionMap* functions) {
   if (options.language_options.LanguageFeatureEnabled(FEATURE_GEOGRAPHY)) {
     GetGeographyFunctions(type_factory, options, functions);
   }
 }
 
+using GetFunctionGroupFn = void (*)(TypeFactory*,
+                                    const ZetaSQLBuiltinFunctionOptions&,
+                                    NameToFunctionMap*);
+
+// The groups of functions added by GetZetaSQLFunctions(), in order.  The
+// indexes of these groups are stored in the generated builtin function
+// index, so it must be regenerated when groups are added or reordered.
+static constexpr GetFunctionGroupFn kFunctionGroups[] = {
+    &GetDatetimeFunctions,
+    &GetArithmeticFunctions,
+    &GetBitwiseFunctions,
+    &GetAggregateFunctions,
+    &GetApproxFunctions,
+    &GetStatisticalFunctions,
+    &GetBooleanFunctions,
+    &GetLogicFunctions,
+    &GetStringFunctions,
+    &GetRegexFunctions,
+    &GetMiscellaneousFunctions,
+    &GetMathFunctions,
+    &GetHllCountFunctions,
+    &GetKllQuantilesFunctions,
+    &GetProto3ConversionFunctions,
+    &GetAnalyticFunctionsIfEnabled,
+    &GetNetFunctions,
+    &GetHashingFunctions,
+    &GetEncryptionFunctionsIfEnabled,
+    &GetGeographyFunctionsIfEnabled,
+};
+
+int NumZetaSQLFunctionGroups() {
+  return static_cast<int>(sizeof(kFunctionGroups) / sizeof(kFunctionGroups[0]));
+}
+
+void GetZetaSQLFunctionGroup(int group, TypeFactory* type_factory,
+                               const ZetaSQLBuiltinFunctionOptions& options,
+                               NameToFunctionMap* functions) {
+  CHECK_GE(group, 0);
+  CHECK_LT(group, NumZetaSQLFunctionGroups());
+  kFunctionGroups[group](type_factory, options, functions);
+}
+
+void GetZetaSQLFunctions(TypeFactory* type_factory,
+                           const ZetaSQLBuiltinFunctionOptions& options,
+                           NameToFunctionMap* functions) {
+  for (const GetFunctionGroupFn get_function_group : kFunctionGroups) {
+    get_function_group(type_factory, options, functions);
+  }
+}
+
+// Returns a key that is equal for two ZetaSQLBuiltinFunctionOptions when they
+// are equal.
+static std::string BuiltinFunctionOptionsKey(
+    const ZetaSQLBuiltinFunctionOptions& options) {
+  ZetaSQLBuiltinFunctionOptionsProto proto;
+  options.language_options.Serialize(proto.mutable_language_options());
+  // The id sets are unordered, so sort them to make the key deterministic.
+  std::vector<FunctionSignatureId> ids(options.include_function_ids.begin(),
+                                       options.include_function_ids.end());
+  std::sort(ids.begin(), ids.end());
+  for (const FunctionSignatureId id : ids) {
+    proto.add_include_function_ids(id);
+  }
+  ids.assign(options.exclude_function_ids.begin(),
+             options.exclude_function_ids.end());
+  std::sort(ids.begin(), ids.end());
+  for (const FunctionSignatureId id : ids) {
+    proto.add_exclude_function_ids(id);
+  }
+  return proto.SerializeAsString();
+}
+
+const NameToFunctionMap& GetSharedZetaSQLFunctions(
+    const ZetaSQLBuiltinFunctionOptions& options) {
+  struct Registry {
+    absl::Mutex mutex;
+    TypeFactory type_factory;
+    absl::flat_hash_map<std::string, std::unique_ptr<const NameToFunctionMap>>
+        functions GUARDED_BY(mutex);
+  };
+  static Registry* registry = new Registry;
+
+  const std::string key = BuiltinFunctionOptionsKey(options);
+  absl::MutexLock l(&registry->mutex);
+  std::unique_ptr<const NameToFunctionMap>& functions =
+      registry->functions[key];
+  if (functions == nullptr) {
+    auto new_functions = absl::make_unique<NameToFunctionMap>();
+    GetZetaSQLFunctions(&registry->type_factory, options, new_functions.get());
+    functions = std::move(new_functions);
+  }
+  return *functions;
+}
+
 bool FunctionMayHaveUnintendedArgumentCoercion(const Function* function) {
   if (function->NumSignatures() == 0 ||
       !function->ArgumentsAreCoercible()) {
@@ -38,6 +38,20 @@ struct FunctionSignatureIdHasher {
 
 const std::string FunctionSignatureIdToName(FunctionSignatureId id);
 
+// Describes the builtin function signature with a FunctionSignatureId, which
+// is the context_id() of the signature.
+struct BuiltinSignatureInfo {
+  FunctionSignatureId id = __FunctionSignatureId__switch_must_have_a_default__;
+  // The key of the function in GetZetaSQLFunctions(), like "$add".
+  std::string function_name;
+  Function::Mode mode = Function::SCALAR;
+};
+
+// Returns the BuiltinSignatureInfo for <id>, or NULL if no builtin function
+// has a signature with that id under any options.  Takes constant time after
+// the first call, which builds a table of all builtin signatures.
+const BuiltinSignatureInfo* GetBuiltinSignatureInfo(FunctionSignatureId id);
+
 // Controls whether builtin FunctionSignatureIds and their matching
 // FunctionSignatures are included or excluded for an implementation.
 //
@@ -88,6 +102,14 @@ void GetZetaSQLFunctions(
     TypeFactory* type_factory, const ZetaSQLBuiltinFunctionOptions& options,
     std::map<std::string, std::unique_ptr<Function>>* functions);
 
+// Returns the same functions as GetZetaSQLFunctions(), from a process-wide
+// registry.  The functions for each distinct <options> are built on first
+// use, using a TypeFactory owned by the registry, and are never freed or
+// modified afterwards, so callers can keep pointers to them forever.
+// This function is thread-safe.
+const std::map<std::string, std::unique_ptr<Function>>&
+GetSharedZetaSQLFunctions(const ZetaSQLBuiltinFunctionOptions& options);
+
 // If the function allows argument coercion, then checks the function
 // signatures to see if they are defined for floating point and
 // only one of signed/unsigned integer arguments (but not both integer
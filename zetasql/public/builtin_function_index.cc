@@ -0,0 +1,88 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/builtin_function_index.h"
+
+#include <algorithm>
+#include <map>
+#include <utility>
+
+#include "zetasql/public/builtin_function_internal.h"
+#include "absl/strings/ascii.h"
+#include "zetasql/base/source_location.h"
+#include "zetasql/base/status_builder.h"
+
+namespace zetasql {
+
+namespace {
+
+struct IndexEntry {
+  const char* name;
+  int group;
+};
+
+// Sorted by name.
+constexpr IndexEntry kBuiltinFunctionIndex[] = {
+#include "zetasql/public/builtin_function_index.inc"
+};
+
+// Returns the index entry for lower case <name>, or NULL.
+const IndexEntry* FindIndexEntry(absl::string_view name) {
+  const IndexEntry* begin = std::begin(kBuiltinFunctionIndex);
+  const IndexEntry* end = std::end(kBuiltinFunctionIndex);
+  const IndexEntry* it = std::lower_bound(
+      begin, end, name, [](const IndexEntry& entry, absl::string_view name) {
+        return absl::string_view(entry.name) < name;
+      });
+  if (it == end || absl::string_view(it->name) != name) {
+    return nullptr;
+  }
+  return it;
+}
+
+}  // namespace
+
+bool IsZetaSQLFunctionName(absl::string_view name) {
+  return FindIndexEntry(absl::AsciiStrToLower(name)) != nullptr;
+}
+
+std::vector<std::string> GetZetaSQLFunctionNames() {
+  std::vector<std::string> names;
+  for (const IndexEntry& entry : kBuiltinFunctionIndex) {
+    names.push_back(entry.name);
+  }
+  return names;
+}
+
+zetasql_base::Status GetZetaSQLFunction(
+    TypeFactory* type_factory, const ZetaSQLBuiltinFunctionOptions& options,
+    absl::string_view name, std::unique_ptr<Function>* function) {
+  const std::string lower_name = absl::AsciiStrToLower(name);
+  const IndexEntry* entry = FindIndexEntry(lower_name);
+  if (entry != nullptr) {
+    std::map<std::string, std::unique_ptr<Function>> functions;
+    GetZetaSQLFunctionGroup(entry->group, type_factory, options, &functions);
+    auto it = functions.find(lower_name);
+    if (it != functions.end()) {
+      *function = std::move(it->second);
+      return ::zetasql_base::OkStatus();
+    }
+  }
+  return ::zetasql_base::NotFoundErrorBuilder(ZETASQL_LOC)
+         << "Builtin function not found: " << name;
+}
+
+}  // namespace zetasql
@@ -0,0 +1,59 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PUBLIC_BUILTIN_FUNCTION_INDEX_H_
+#define ZETASQL_PUBLIC_BUILTIN_FUNCTION_INDEX_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/public/builtin_function.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/type.h"
+#include "absl/strings/string_view.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+
+// Functions for building individual builtin functions on demand, for
+// Catalogs that only need a few of them, such as in short-lived tools.
+// They look the function up in an index of builtin function names
+// generated at build time, and then build only the group of builtin
+// functions that contains it, instead of all of them as
+// GetZetaSQLFunctions() does.
+
+// Returns true if <name> is the name of a builtin function under some
+// ZetaSQLBuiltinFunctionOptions.  <name> is the key used by
+// GetZetaSQLFunctions(), like "concat", "$add" or "net.format_ip", and is
+// case insensitive.
+bool IsZetaSQLFunctionName(absl::string_view name);
+
+// Returns the names of all builtin functions in the index, in sorted order.
+std::vector<std::string> GetZetaSQLFunctionNames();
+
+// Sets <*function> to the builtin function named <name>, with the same
+// signatures that GetZetaSQLFunctions() would give it for <options>.  New
+// Types are added to <type_factory> as needed, and <type_factory> must
+// outlive <*function>.  Returns NOT_FOUND if there is no such function or
+// <options> excludes it.
+zetasql_base::Status GetZetaSQLFunction(
+    TypeFactory* type_factory, const ZetaSQLBuiltinFunctionOptions& options,
+    absl::string_view name, std::unique_ptr<Function>* function);
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_BUILTIN_FUNCTION_INDEX_H_
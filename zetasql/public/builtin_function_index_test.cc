@@ -0,0 +1,81 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/builtin_function_index.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/builtin_function.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/language_options.h"
+#include "zetasql/public/type.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace zetasql {
+
+TEST(BuiltinFunctionIndexTest, MatchesGetZetaSQLFunctions) {
+  LanguageOptions language_options;
+  language_options.EnableMaximumLanguageFeaturesForDevelopment();
+  const ZetaSQLBuiltinFunctionOptions options(language_options);
+  TypeFactory type_factory;
+  std::map<std::string, std::unique_ptr<Function>> functions;
+  GetZetaSQLFunctions(&type_factory, options, &functions);
+
+  // With all features enabled, the index has exactly the same functions.
+  std::vector<std::string> names;
+  for (const auto& entry : functions) {
+    names.push_back(entry.first);
+  }
+  EXPECT_EQ(names, GetZetaSQLFunctionNames());
+
+  for (const auto& entry : functions) {
+    std::unique_ptr<Function> function;
+    ZETASQL_ASSERT_OK(
+        GetZetaSQLFunction(&type_factory, options, entry.first, &function));
+    EXPECT_EQ(entry.second->DebugString(/*verbose=*/true),
+              function->DebugString(/*verbose=*/true));
+  }
+}
+
+TEST(BuiltinFunctionIndexTest, Lookups) {
+  TypeFactory type_factory;
+  std::unique_ptr<Function> function;
+  ZETASQL_ASSERT_OK(GetZetaSQLFunction(
+      &type_factory, ZetaSQLBuiltinFunctionOptions(), "CONCAT", &function));
+  EXPECT_EQ("concat", function->Name());
+  EXPECT_TRUE(IsZetaSQLFunctionName("Net.Format_IP"));
+
+  EXPECT_FALSE(IsZetaSQLFunctionName("no_such_function"));
+  EXPECT_EQ(zetasql_base::StatusCode::kNotFound,
+            GetZetaSQLFunction(&type_factory, ZetaSQLBuiltinFunctionOptions(),
+                                 "no_such_function", &function)
+                .code());
+
+  // Functions that <options> excludes are not found.
+  LanguageOptions external_options;
+  external_options.set_product_mode(PRODUCT_EXTERNAL);
+  EXPECT_EQ(zetasql_base::StatusCode::kNotFound,
+            GetZetaSQLFunction(&type_factory, external_options,
+                                 "net.format_ip", &function)
+                .code());
+}
+
+}  // namespace zetasql
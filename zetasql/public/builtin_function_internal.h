@@ -0,0 +1,49 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PUBLIC_BUILTIN_FUNCTION_INTERNAL_H_
+#define ZETASQL_PUBLIC_BUILTIN_FUNCTION_INTERNAL_H_
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "zetasql/public/builtin_function.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/type.h"
+
+namespace zetasql {
+
+// GetZetaSQLFunctions() adds builtin functions in groups, such as the
+// datetime functions or the string functions.  These let callers build a
+// single group at a time.  Each function name belongs to one group for all
+// ZetaSQLBuiltinFunctionOptions, which is what makes the generated index used
+// by GetZetaSQLFunction() valid.
+
+// Returns the number of builtin function groups.
+int NumZetaSQLFunctionGroups();
+
+// Adds the functions in group <group>, which must be less than
+// NumZetaSQLFunctionGroups(), to <functions>.  Calling this for every group
+// is equivalent to calling GetZetaSQLFunctions().
+void GetZetaSQLFunctionGroup(
+    int group, TypeFactory* type_factory,
+    const ZetaSQLBuiltinFunctionOptions& options,
+    std::map<std::string, std::unique_ptr<Function>>* functions);
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_BUILTIN_FUNCTION_INTERNAL_H_
@@ -0,0 +1,112 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PUBLIC_BUILTIN_FUNCTION_REGISTRY_H_
+#define ZETASQL_PUBLIC_BUILTIN_FUNCTION_REGISTRY_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "zetasql/public/builtin_function.pb.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/function_signature.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/optional.h"
+#include "zetasql/base/canonical_errors.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+
+// A table from builtin FunctionSignatureIds to an engine's implementations of
+// them, of type KernelT, such as a function pointer.  It is an array indexed
+// by the id, so finding the kernel of a builtin function call is a bounds
+// check and a load, instead of a std::map or name lookup.
+//
+// Example:
+//   using ScalarKernel = bool (*)(absl::Span<const Value>, Value*,
+//                                 zetasql_base::Status*);
+//   BuiltinFunctionRegistry<ScalarKernel> registry;
+//   ZETASQL_RETURN_IF_ERROR(registry.Register(FN_ADD_INT64, &AddInt64));
+//   ...
+//   const ScalarKernel* kernel = registry.FindForCall(
+//       *call->function(), call->signature());
+//
+// Register() is not thread-safe; the const methods are.
+template <typename KernelT>
+class BuiltinFunctionRegistry {
+ public:
+  BuiltinFunctionRegistry() : kernels_(FunctionSignatureId_ARRAYSIZE) {}
+  BuiltinFunctionRegistry(const BuiltinFunctionRegistry&) = default;
+  BuiltinFunctionRegistry& operator=(const BuiltinFunctionRegistry&) = default;
+
+  // Registers <kernel> for <id>.  Returns an error if <id> is not a valid
+  // FunctionSignatureId or already has a kernel.
+  zetasql_base::Status Register(FunctionSignatureId id, KernelT kernel) {
+    if (!IsValidId(id)) {
+      return zetasql_base::InvalidArgumentError(
+          absl::StrCat("Invalid FunctionSignatureId: ", id));
+    }
+    if (kernels_[id].has_value()) {
+      return zetasql_base::AlreadyExistsError(absl::StrCat(
+          "A kernel is already registered for ",
+          FunctionSignatureId_Name(id)));
+    }
+    kernels_[id] = std::move(kernel);
+    ++num_registered_;
+    return zetasql_base::OkStatus();
+  }
+
+  // Removes the kernel for <id>, if any.
+  void Unregister(FunctionSignatureId id) {
+    if (IsValidId(id) && kernels_[id].has_value()) {
+      kernels_[id].reset();
+      --num_registered_;
+    }
+  }
+
+  // Returns the kernel registered for <id>, or NULL.
+  const KernelT* Find(FunctionSignatureId id) const {
+    if (!IsValidId(id) || !kernels_[id].has_value()) return nullptr;
+    return &*kernels_[id];
+  }
+
+  // Returns the kernel for a call to <function> with <signature>, as in a
+  // ResolvedFunctionCall, or NULL if <function> is not a builtin function or
+  // no kernel is registered for the signature.
+  const KernelT* FindForCall(const Function& function,
+                             const FunctionSignature& signature) const {
+    if (!function.IsZetaSQLBuiltin()) return nullptr;
+    const int64_t id = signature.context_id();
+    if (id < 0 || id >= FunctionSignatureId_ARRAYSIZE) return nullptr;
+    return Find(static_cast<FunctionSignatureId>(id));
+  }
+
+  // The number of ids with a kernel.
+  int num_registered() const { return num_registered_; }
+
+ private:
+  static bool IsValidId(FunctionSignatureId id) {
+    return id >= 0 && id < FunctionSignatureId_ARRAYSIZE;
+  }
+
+  std::vector<absl::optional<KernelT>> kernels_;
+  int num_registered_ = 0;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_BUILTIN_FUNCTION_REGISTRY_H_
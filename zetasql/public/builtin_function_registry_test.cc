@@ -0,0 +1,88 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/builtin_function_registry.h"
+
+#include <cstdint>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/type.h"
+
+namespace zetasql {
+namespace {
+
+using testing::IsNull;
+using testing::NotNull;
+using zetasql_base::testing::StatusIs;
+
+using Kernel = int64_t (*)(int64_t, int64_t);
+
+int64_t Add(int64_t a, int64_t b) { return a + b; }
+int64_t Subtract(int64_t a, int64_t b) { return a - b; }
+
+TEST(BuiltinFunctionRegistryTest, RegisterAndFind) {
+  BuiltinFunctionRegistry<Kernel> registry;
+  EXPECT_EQ(0, registry.num_registered());
+  ZETASQL_ASSERT_OK(registry.Register(FN_ADD_INT64, &Add));
+  ZETASQL_ASSERT_OK(registry.Register(FN_SUBTRACT_INT64, &Subtract));
+  EXPECT_EQ(2, registry.num_registered());
+
+  const Kernel* kernel = registry.Find(FN_ADD_INT64);
+  ASSERT_THAT(kernel, NotNull());
+  EXPECT_EQ(5, (*kernel)(2, 3));
+  EXPECT_EQ(-1, (*registry.Find(FN_SUBTRACT_INT64))(2, 3));
+  EXPECT_THAT(registry.Find(FN_ADD_UINT64), IsNull());
+  EXPECT_THAT(
+      registry.Find(__FunctionSignatureId__switch_must_have_a_default__),
+      IsNull());
+
+  EXPECT_THAT(registry.Register(FN_ADD_INT64, &Subtract),
+              StatusIs(zetasql_base::StatusCode::kAlreadyExists));
+  EXPECT_THAT(registry.Register(
+                  __FunctionSignatureId__switch_must_have_a_default__, &Add),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+
+  registry.Unregister(FN_ADD_INT64);
+  EXPECT_THAT(registry.Find(FN_ADD_INT64), IsNull());
+  EXPECT_EQ(1, registry.num_registered());
+  ZETASQL_EXPECT_OK(registry.Register(FN_ADD_INT64, &Subtract));
+}
+
+TEST(BuiltinFunctionRegistryTest, FindForCall) {
+  BuiltinFunctionRegistry<Kernel> registry;
+  ZETASQL_ASSERT_OK(registry.Register(FN_ADD_INT64, &Add));
+
+  const FunctionSignature signature(
+      types::Int64Type(), {types::Int64Type(), types::Int64Type()},
+      FN_ADD_INT64);
+  const Function builtin("$add", Function::kZetaSQLFunctionGroupName,
+                         Function::SCALAR, {signature});
+  const Function user_defined("$add", "user_defined", Function::SCALAR,
+                              {signature});
+  EXPECT_THAT(registry.FindForCall(builtin, signature), NotNull());
+  EXPECT_THAT(registry.FindForCall(user_defined, signature), IsNull());
+
+  const FunctionSignature other_signature(
+      types::Int64Type(), {types::Int64Type(), types::Int64Type()},
+      /*context_id=*/-5);
+  EXPECT_THAT(registry.FindForCall(builtin, other_signature), IsNull());
+}
+
+}  // namespace
+}  // namespace zetasql
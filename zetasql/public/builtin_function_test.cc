@@ -140,7 +140,18 @@ TEST(SimpleBuiltinFunctionTests, SanityTests) {
 
     EXPECT_THAT(zetasql_base::FindOrNull(functions, function_name), NotNull())
         << "Not found (id " << id << "): " << function_name;
+
+    const BuiltinSignatureInfo* info = GetBuiltinSignatureInfo(id);
+    ASSERT_THAT(info, NotNull()) << id;
+    EXPECT_EQ(id, info->id);
+    EXPECT_EQ(function_name, info->function_name);
   }
+  EXPECT_THAT(GetBuiltinSignatureInfo(FN_INVALID_FUNCTION_ID), IsNull());
+  EXPECT_THAT(GetBuiltinSignatureInfo(
+                  __FunctionSignatureId__switch_must_have_a_default__),
+              IsNull());
+  EXPECT_EQ(Function::AGGREGATE, GetBuiltinSignatureInfo(FN_COUNT)->mode);
+  EXPECT_EQ(Function::SCALAR, GetBuiltinSignatureInfo(FN_ADD_INT64)->mode);
 }
 
 TEST(SimpleBuiltinFunctionTests, BasicTests) {
@@ -16,8 +16,10 @@
 
 #include "zetasql/public/cast.h"
 
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "zetasql/base/logging.h"
@@ -358,6 +360,145 @@ static zetasql_base::StatusOr<Value> StringToNumeric(const Value& v) {
   }
 }
 
+static zetasql_base::StatusOr<Value> StringToBytes(const Value& v) {
+  return Value::Bytes(v.string_value());
+}
+
+static zetasql_base::StatusOr<Value> BytesToString(const Value& v) {
+  const std::string& utf8 = v.bytes_value();
+  // No escaping is needed since the bytes value is already unescaped.
+  if (!IsWellFormedUTF8(utf8)) {
+    return MakeEvalError() << "Invalid cast of bytes to UTF8 string";
+  }
+  return Value::String(utf8);
+}
+
+static zetasql_base::StatusOr<Value> EnumToString(const Value& v) {
+  return Value::String(v.enum_name());
+}
+
+static zetasql_base::StatusOr<Value> EnumToInt32(const Value& v) {
+  return Value::Int32(v.enum_value());
+}
+
+template <typename T>
+static zetasql_base::StatusOr<Value> EnumToNumeric(const Value& v) {
+  return NumericValueCast<int32_t, T>(v.enum_value());
+}
+
+// A cast of a non-NULL Value that depends only on the type kinds involved,
+// and not on the full types, the time zone or the LanguageOptions.
+typedef zetasql_base::StatusOr<Value> (*SimpleCastFunction)(const Value& value);
+
+// Returns the SimpleCastFunction for casting from <from_kind> to <to_kind>,
+// or nullptr if that cast needs more than the kinds.  Identity casts are not
+// included.
+static SimpleCastFunction GetSimpleCastFunction(TypeKind from_kind,
+                                                TypeKind to_kind) {
+  switch (FCT(from_kind, to_kind)) {
+    case FCT(TYPE_INT32, TYPE_INT64): return &NumericCast<int32_t, int64_t>;
+    case FCT(TYPE_INT32, TYPE_UINT32): return &NumericCast<int32_t, uint32_t>;
+    case FCT(TYPE_INT32, TYPE_UINT64): return &NumericCast<int32_t, uint64_t>;
+    case FCT(TYPE_INT32, TYPE_BOOL): return &NumericCast<int32_t, bool>;
+    case FCT(TYPE_INT32, TYPE_FLOAT): return &NumericCast<int32_t, float>;
+    case FCT(TYPE_INT32, TYPE_DOUBLE): return &NumericCast<int32_t, double>;
+    case FCT(TYPE_INT32, TYPE_STRING): return &NumericToString<int32_t>;
+    case FCT(TYPE_INT32, TYPE_NUMERIC):
+      return &NumericCast<int32_t, NumericValue>;
+
+    case FCT(TYPE_UINT32, TYPE_INT32): return &NumericCast<uint32_t, int32_t>;
+    case FCT(TYPE_UINT32, TYPE_INT64): return &NumericCast<uint32_t, int64_t>;
+    case FCT(TYPE_UINT32, TYPE_UINT64): return &NumericCast<uint32_t, uint64_t>;
+    case FCT(TYPE_UINT32, TYPE_BOOL): return &NumericCast<uint32_t, bool>;
+    case FCT(TYPE_UINT32, TYPE_FLOAT): return &NumericCast<uint32_t, float>;
+    case FCT(TYPE_UINT32, TYPE_DOUBLE): return &NumericCast<uint32_t, double>;
+    case FCT(TYPE_UINT32, TYPE_STRING): return &NumericToString<uint32_t>;
+    case FCT(TYPE_UINT32, TYPE_NUMERIC):
+      return &NumericCast<uint32_t, NumericValue>;
+
+    case FCT(TYPE_INT64, TYPE_INT32): return &NumericCast<int64_t, int32_t>;
+    case FCT(TYPE_INT64, TYPE_UINT32): return &NumericCast<int64_t, uint32_t>;
+    case FCT(TYPE_INT64, TYPE_UINT64): return &NumericCast<int64_t, uint64_t>;
+    case FCT(TYPE_INT64, TYPE_BOOL): return &NumericCast<int64_t, bool>;
+    case FCT(TYPE_INT64, TYPE_FLOAT): return &NumericCast<int64_t, float>;
+    case FCT(TYPE_INT64, TYPE_DOUBLE): return &NumericCast<int64_t, double>;
+    case FCT(TYPE_INT64, TYPE_STRING): return &NumericToString<int64_t>;
+    case FCT(TYPE_INT64, TYPE_NUMERIC):
+      return &NumericCast<int64_t, NumericValue>;
+
+    case FCT(TYPE_UINT64, TYPE_INT32): return &NumericCast<uint64_t, int32_t>;
+    case FCT(TYPE_UINT64, TYPE_INT64): return &NumericCast<uint64_t, int64_t>;
+    case FCT(TYPE_UINT64, TYPE_UINT32): return &NumericCast<uint64_t, uint32_t>;
+    case FCT(TYPE_UINT64, TYPE_BOOL): return &NumericCast<uint64_t, bool>;
+    case FCT(TYPE_UINT64, TYPE_FLOAT): return &NumericCast<uint64_t, float>;
+    case FCT(TYPE_UINT64, TYPE_DOUBLE): return &NumericCast<uint64_t, double>;
+    case FCT(TYPE_UINT64, TYPE_STRING): return &NumericToString<uint64_t>;
+    case FCT(TYPE_UINT64, TYPE_NUMERIC):
+      return &NumericCast<uint64_t, NumericValue>;
+
+    case FCT(TYPE_BOOL, TYPE_INT32): return &NumericCast<bool, int32_t>;
+    case FCT(TYPE_BOOL, TYPE_INT64): return &NumericCast<bool, int64_t>;
+    case FCT(TYPE_BOOL, TYPE_UINT32): return &NumericCast<bool, uint32_t>;
+    case FCT(TYPE_BOOL, TYPE_UINT64): return &NumericCast<bool, uint64_t>;
+    case FCT(TYPE_BOOL, TYPE_STRING): return &NumericToString<bool>;
+
+    case FCT(TYPE_FLOAT, TYPE_INT32): return &NumericCast<float, int32_t>;
+    case FCT(TYPE_FLOAT, TYPE_INT64): return &NumericCast<float, int64_t>;
+    case FCT(TYPE_FLOAT, TYPE_UINT32): return &NumericCast<float, uint32_t>;
+    case FCT(TYPE_FLOAT, TYPE_UINT64): return &NumericCast<float, uint64_t>;
+    case FCT(TYPE_FLOAT, TYPE_DOUBLE): return &NumericCast<float, double>;
+    case FCT(TYPE_FLOAT, TYPE_STRING): return &NumericToString<float>;
+    case FCT(TYPE_FLOAT, TYPE_NUMERIC):
+      return &NumericCast<float, NumericValue>;
+
+    case FCT(TYPE_DOUBLE, TYPE_INT32): return &NumericCast<double, int32_t>;
+    case FCT(TYPE_DOUBLE, TYPE_INT64): return &NumericCast<double, int64_t>;
+    case FCT(TYPE_DOUBLE, TYPE_UINT32): return &NumericCast<double, uint32_t>;
+    case FCT(TYPE_DOUBLE, TYPE_UINT64): return &NumericCast<double, uint64_t>;
+    case FCT(TYPE_DOUBLE, TYPE_FLOAT): return &NumericCast<double, float>;
+    case FCT(TYPE_DOUBLE, TYPE_STRING): return &NumericToString<double>;
+    case FCT(TYPE_DOUBLE, TYPE_NUMERIC):
+      return &NumericCast<double, NumericValue>;
+
+    case FCT(TYPE_NUMERIC, TYPE_INT32):
+      return &NumericCast<NumericValue, int32_t>;
+    case FCT(TYPE_NUMERIC, TYPE_INT64):
+      return &NumericCast<NumericValue, int64_t>;
+    case FCT(TYPE_NUMERIC, TYPE_UINT32):
+      return &NumericCast<NumericValue, uint32_t>;
+    case FCT(TYPE_NUMERIC, TYPE_UINT64):
+      return &NumericCast<NumericValue, uint64_t>;
+    case FCT(TYPE_NUMERIC, TYPE_FLOAT):
+      return &NumericCast<NumericValue, float>;
+    case FCT(TYPE_NUMERIC, TYPE_DOUBLE):
+      return &NumericCast<NumericValue, double>;
+    case FCT(TYPE_NUMERIC, TYPE_STRING):
+      return &NumericToString<NumericValue>;
+
+    case FCT(TYPE_STRING, TYPE_BOOL): return &StringToNumeric<bool>;
+    case FCT(TYPE_STRING, TYPE_INT32): return &StringToNumeric<int32_t>;
+    case FCT(TYPE_STRING, TYPE_INT64): return &StringToNumeric<int64_t>;
+    case FCT(TYPE_STRING, TYPE_UINT32): return &StringToNumeric<uint32_t>;
+    case FCT(TYPE_STRING, TYPE_UINT64): return &StringToNumeric<uint64_t>;
+    case FCT(TYPE_STRING, TYPE_FLOAT): return &StringToNumeric<float>;
+    case FCT(TYPE_STRING, TYPE_DOUBLE): return &StringToNumeric<double>;
+    case FCT(TYPE_STRING, TYPE_NUMERIC):
+      return &StringToNumeric<NumericValue>;
+
+    case FCT(TYPE_STRING, TYPE_BYTES): return &StringToBytes;
+    case FCT(TYPE_BYTES, TYPE_STRING): return &BytesToString;
+
+    case FCT(TYPE_ENUM, TYPE_STRING): return &EnumToString;
+    case FCT(TYPE_ENUM, TYPE_INT32): return &EnumToInt32;
+    case FCT(TYPE_ENUM, TYPE_INT64): return &EnumToNumeric<int64_t>;
+    case FCT(TYPE_ENUM, TYPE_UINT32): return &EnumToNumeric<uint32_t>;
+    case FCT(TYPE_ENUM, TYPE_UINT64): return &EnumToNumeric<uint64_t>;
+
+    default:
+      return nullptr;
+  }
+}
+
 zetasql_base::StatusOr<Value> CastValue(const Value& from_value,
                                 absl::TimeZone default_timezone,
                                 const LanguageOptions& language_options,
@@ -401,74 +542,16 @@ zetasql_base::StatusOr<Value> CastValue(const Value& from_value,
     return Value::Null(to_type);
   }
 
+  // Casts between simple types that depend only on the type kinds.
+  const SimpleCastFunction simple_cast_function =
+      GetSimpleCastFunction(v.type_kind(), to_type->kind());
+  if (simple_cast_function != nullptr) {
+    return simple_cast_function(v);
+  }
+
   // TODO: Consider breaking this up, as the switch is extremely
   // large.
   switch (FCT(v.type()->kind(), to_type->kind())) {
-    // Numeric casts. Identity casts are handled above.
-    case FCT(TYPE_INT32, TYPE_INT64): return NumericCast<int32_t, int64_t>(v);
-    case FCT(TYPE_INT32, TYPE_UINT32): return NumericCast<int32_t, uint32_t>(v);
-    case FCT(TYPE_INT32, TYPE_UINT64): return NumericCast<int32_t, uint64_t>(v);
-    case FCT(TYPE_INT32, TYPE_BOOL): return NumericCast<int32_t, bool>(v);
-    case FCT(TYPE_INT32, TYPE_FLOAT): return NumericCast<int32_t, float>(v);
-    case FCT(TYPE_INT32, TYPE_DOUBLE): return NumericCast<int32_t, double>(v);
-    case FCT(TYPE_INT32, TYPE_STRING): return NumericToString<int32_t>(v);
-    case FCT(TYPE_INT32, TYPE_NUMERIC):
-      return NumericCast<int32_t, NumericValue>(v);
-
-    case FCT(TYPE_UINT32, TYPE_INT32): return NumericCast<uint32_t, int32_t>(v);
-    case FCT(TYPE_UINT32, TYPE_INT64): return NumericCast<uint32_t, int64_t>(v);
-    case FCT(TYPE_UINT32, TYPE_UINT64): return NumericCast<uint32_t, uint64_t>(v);
-    case FCT(TYPE_UINT32, TYPE_BOOL): return NumericCast<uint32_t, bool>(v);
-    case FCT(TYPE_UINT32, TYPE_FLOAT): return NumericCast<uint32_t, float>(v);
-    case FCT(TYPE_UINT32, TYPE_DOUBLE): return NumericCast<uint32_t, double>(v);
-    case FCT(TYPE_UINT32, TYPE_STRING): return NumericToString<uint32_t>(v);
-    case FCT(TYPE_UINT32, TYPE_NUMERIC):
-      return NumericCast<uint32_t, NumericValue>(v);
-
-    case FCT(TYPE_INT64, TYPE_INT32): return NumericCast<int64_t, int32_t>(v);
-    case FCT(TYPE_INT64, TYPE_UINT32): return NumericCast<int64_t, uint32_t>(v);
-    case FCT(TYPE_INT64, TYPE_UINT64): return NumericCast<int64_t, uint64_t>(v);
-    case FCT(TYPE_INT64, TYPE_BOOL): return NumericCast<int64_t, bool>(v);
-    case FCT(TYPE_INT64, TYPE_FLOAT): return NumericCast<int64_t, float>(v);
-    case FCT(TYPE_INT64, TYPE_DOUBLE): return NumericCast<int64_t, double>(v);
-    case FCT(TYPE_INT64, TYPE_STRING): return NumericToString<int64_t>(v);
-    case FCT(TYPE_INT64, TYPE_NUMERIC):
-      return NumericCast<int64_t, NumericValue>(v);
-
-    case FCT(TYPE_UINT64, TYPE_INT32): return NumericCast<uint64_t, int32_t>(v);
-    case FCT(TYPE_UINT64, TYPE_INT64): return NumericCast<uint64_t, int64_t>(v);
-    case FCT(TYPE_UINT64, TYPE_UINT32): return NumericCast<uint64_t, uint32_t>(v);
-    case FCT(TYPE_UINT64, TYPE_BOOL): return NumericCast<uint64_t, bool>(v);
-    case FCT(TYPE_UINT64, TYPE_FLOAT): return NumericCast<uint64_t, float>(v);
-    case FCT(TYPE_UINT64, TYPE_DOUBLE): return NumericCast<uint64_t, double>(v);
-    case FCT(TYPE_UINT64, TYPE_STRING): return NumericToString<uint64_t>(v);
-    case FCT(TYPE_UINT64, TYPE_NUMERIC):
-      return NumericCast<uint64_t, NumericValue>(v);
-
-    case FCT(TYPE_BOOL, TYPE_INT32): return NumericCast<bool, int32_t>(v);
-    case FCT(TYPE_BOOL, TYPE_INT64): return NumericCast<bool, int64_t>(v);
-    case FCT(TYPE_BOOL, TYPE_UINT32): return NumericCast<bool, uint32_t>(v);
-    case FCT(TYPE_BOOL, TYPE_UINT64): return NumericCast<bool, uint64_t>(v);
-    case FCT(TYPE_BOOL, TYPE_STRING): return NumericToString<bool>(v);
-
-    case FCT(TYPE_FLOAT, TYPE_INT32): return NumericCast<float, int32_t>(v);
-    case FCT(TYPE_FLOAT, TYPE_INT64): return NumericCast<float, int64_t>(v);
-    case FCT(TYPE_FLOAT, TYPE_UINT32): return NumericCast<float, uint32_t>(v);
-    case FCT(TYPE_FLOAT, TYPE_UINT64): return NumericCast<float, uint64_t>(v);
-    case FCT(TYPE_FLOAT, TYPE_DOUBLE): return NumericCast<float, double>(v);
-    case FCT(TYPE_FLOAT, TYPE_STRING): return NumericToString<float>(v);
-    case FCT(TYPE_FLOAT, TYPE_NUMERIC):
-      return NumericCast<float, NumericValue>(v);
-
-    case FCT(TYPE_DOUBLE, TYPE_INT32): return NumericCast<double, int32_t>(v);
-    case FCT(TYPE_DOUBLE, TYPE_INT64): return NumericCast<double, int64_t>(v);
-    case FCT(TYPE_DOUBLE, TYPE_UINT32): return NumericCast<double, uint32_t>(v);
-    case FCT(TYPE_DOUBLE, TYPE_UINT64): return NumericCast<double, uint64_t>(v);
-    case FCT(TYPE_DOUBLE, TYPE_FLOAT): return NumericCast<double, float>(v);
-    case FCT(TYPE_DOUBLE, TYPE_STRING): return NumericToString<double>(v);
-    case FCT(TYPE_DOUBLE, TYPE_NUMERIC):
-      return NumericCast<double, NumericValue>(v);
-
     case FCT(TYPE_INT32, TYPE_ENUM):
     case FCT(TYPE_INT64, TYPE_ENUM):
     case FCT(TYPE_UINT32, TYPE_ENUM): {
@@ -492,16 +575,6 @@ zetasql_base::StatusOr<Value> CastValue(const Value& from_value,
       return to_value;
     }
 
-    case FCT(TYPE_STRING, TYPE_BOOL): return StringToNumeric<bool>(v);
-    case FCT(TYPE_STRING, TYPE_INT32): return StringToNumeric<int32_t>(v);
-    case FCT(TYPE_STRING, TYPE_INT64): return StringToNumeric<int64_t>(v);
-    case FCT(TYPE_STRING, TYPE_UINT32): return StringToNumeric<uint32_t>(v);
-    case FCT(TYPE_STRING, TYPE_UINT64): return StringToNumeric<uint64_t>(v);
-    case FCT(TYPE_STRING, TYPE_FLOAT): return StringToNumeric<float>(v);
-    case FCT(TYPE_STRING, TYPE_DOUBLE): return StringToNumeric<double>(v);
-    case FCT(TYPE_STRING, TYPE_NUMERIC):
-      return StringToNumeric<NumericValue>(v);
-
     case FCT(TYPE_STRING, TYPE_ENUM): {
       const Value to_value = Value::Enum(to_type->AsEnum(), v.string_value());
       if (!to_value.is_valid()) {
@@ -562,9 +635,6 @@ zetasql_base::StatusOr<Value> CastValue(const Value& from_value,
           functions::kMicroseconds, default_timezone, &date));
       return Value::Date(date);
     }
-    case FCT(TYPE_STRING, TYPE_BYTES):
-      return Value::Bytes(v.string_value());
-
     case FCT(TYPE_STRING, TYPE_PROTO): {
       if (to_type->AsProto()->descriptor() == nullptr) {
         // TODO: Cannot currently get here, since a ProtoType
@@ -600,15 +670,6 @@ zetasql_base::StatusOr<Value> CastValue(const Value& from_value,
       return Value::Proto(to_type->AsProto(), cord_value);
     }
 
-    case FCT(TYPE_BYTES, TYPE_STRING): {
-      const std::string& utf8 = v.bytes_value();
-      // No escaping is needed since the bytes value is already unescaped.
-      if (!IsWellFormedUTF8(utf8)) {
-        return MakeEvalError() << "Invalid cast of bytes to UTF8 string";
-      }
-      return Value::String(utf8);
-    }
-
     case FCT(TYPE_BYTES, TYPE_PROTO):
       // Opaque proto support does not affect this implementation, which does
       // no validation.
@@ -619,18 +680,6 @@ zetasql_base::StatusOr<Value> CastValue(const Value& from_value,
       return Value::String(date);
     }
 
-    case FCT(TYPE_ENUM, TYPE_STRING):
-      return Value::String(v.enum_name());
-
-    case FCT(TYPE_ENUM, TYPE_INT32):
-      return Value::Int32(v.enum_value());
-    case FCT(TYPE_ENUM, TYPE_INT64):
-      return NumericValueCast<int32_t, int64_t>(v.enum_value());
-    case FCT(TYPE_ENUM, TYPE_UINT32):
-      return NumericValueCast<int32_t, uint32_t>(v.enum_value());
-    case FCT(TYPE_ENUM, TYPE_UINT64):
-      return NumericValueCast<int32_t, uint64_t>(v.enum_value());
-
     case FCT(TYPE_ENUM, TYPE_ENUM): {
       if (!v.type()->Equivalent(to_type)) {
         return MakeSqlError() << "Invalid enum cast from "
@@ -724,7 +773,8 @@ zetasql_base::StatusOr<Value> CastValue(const Value& from_value,
                       to_type->AsStruct()->field(i).type));
       }
 
-      return Value::Struct(to_type->AsStruct(), casted_field_values);
+      return Value::UnsafeStruct(to_type->AsStruct(),
+                                 std::move(casted_field_values));
     }
 
     case FCT(TYPE_PROTO, TYPE_STRING): {
@@ -778,10 +828,16 @@ zetasql_base::StatusOr<Value> CastValue(const Value& from_value,
       }
 
       const Type* to_element_type = to_type->AsArray()->element_type();
+      // Resolve the element cast once rather than once per element.
+      const SimpleCastFunction element_cast_function = GetSimpleCastFunction(
+          v.type()->AsArray()->element_type()->kind(), to_element_type->kind());
       std::vector<Value> casted_elements(v.num_elements());
       for (int i = 0; i < v.num_elements(); ++i) {
         if (v.element(i).is_null()) {
           casted_elements[i] = Value::Null(to_element_type);
+        } else if (element_cast_function != nullptr) {
+          ZETASQL_ASSIGN_OR_RETURN(casted_elements[i],
+                           element_cast_function(v.element(i)));
         } else {
           ZETASQL_ASSIGN_OR_RETURN(casted_elements[i],
                            CastValue(v.element(i), default_timezone,
@@ -793,21 +849,6 @@ zetasql_base::StatusOr<Value> CastValue(const Value& from_value,
                                          std::move(casted_elements));
     }
 
-    case FCT(TYPE_NUMERIC, TYPE_INT32):
-      return NumericCast<NumericValue, int32_t>(v);
-    case FCT(TYPE_NUMERIC, TYPE_INT64):
-      return NumericCast<NumericValue, int64_t>(v);
-    case FCT(TYPE_NUMERIC, TYPE_UINT32):
-      return NumericCast<NumericValue, uint32_t>(v);
-    case FCT(TYPE_NUMERIC, TYPE_UINT64):
-      return NumericCast<NumericValue, uint64_t>(v);
-    case FCT(TYPE_NUMERIC, TYPE_FLOAT):
-      return NumericCast<NumericValue, float>(v);
-    case FCT(TYPE_NUMERIC, TYPE_DOUBLE):
-      return NumericCast<NumericValue, double>(v);
-    case FCT(TYPE_NUMERIC, TYPE_STRING):
-      return NumericToString<NumericValue>(v);
-
     // TODO: implement missing casts.
     default:
       return ::zetasql_base::UnimplementedErrorBuilder(ZETASQL_LOC)
@@ -816,4 +857,59 @@ zetasql_base::StatusOr<Value> CastValue(const Value& from_value,
   }
 }
 
+CastPlan::CastPlan(const Type* from_type, const Type* to_type,
+                   absl::TimeZone default_timezone,
+                   const LanguageOptions& language_options)
+    : from_type_(from_type),
+      to_type_(to_type),
+      default_timezone_(default_timezone),
+      language_options_(language_options) {}
+
+zetasql_base::StatusOr<CastPlan> CastPlan::Create(
+    const Type* from_type, const Type* to_type,
+    absl::TimeZone default_timezone,
+    const LanguageOptions& language_options) {
+  CastPlan plan(from_type, to_type, default_timezone, language_options);
+  if (from_type->Equals(to_type)) {
+    plan.is_identity_ = true;
+    return plan;
+  }
+  if (!zetasql_base::ContainsKey(GetZetaSQLCasts(),
+                        TypeKindPair(from_type->kind(), to_type->kind()))) {
+    return MakeSqlError() << "Unsupported cast from "
+                          << from_type->DebugString() << " to "
+                          << to_type->DebugString();
+  }
+  plan.simple_cast_function_ =
+      GetSimpleCastFunction(from_type->kind(), to_type->kind());
+  return plan;
+}
+
+zetasql_base::StatusOr<Value> CastPlan::Cast(const Value& from_value) const {
+  DCHECK(from_value.type()->Equals(from_type_));
+  if (is_identity_) {
+    return from_value;
+  }
+  if (simple_cast_function_ != nullptr) {
+    if (from_value.is_null()) {
+      return Value::Null(to_type_);
+    }
+    return simple_cast_function_(from_value);
+  }
+  return CastValue(from_value, default_timezone_, language_options_, to_type_);
+}
+
+zetasql_base::Status CastPlan::CastValues(absl::Span<const Value> from_values,
+                                  std::vector<Value>* to_values) const {
+  to_values->resize(from_values.size());
+  if (is_identity_) {
+    std::copy(from_values.begin(), from_values.end(), to_values->begin());
+    return ::zetasql_base::OkStatus();
+  }
+  for (int i = 0; i < from_values.size(); ++i) {
+    ZETASQL_ASSIGN_OR_RETURN((*to_values)[i], Cast(from_values[i]));
+  }
+  return ::zetasql_base::OkStatus();
+}
+
 }  // namespace zetasql
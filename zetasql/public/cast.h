@@ -17,10 +17,15 @@
 #ifndef ZETASQL_PUBLIC_CAST_H_
 #define ZETASQL_PUBLIC_CAST_H_
 
+#include <vector>
+
+#include "zetasql/public/language_options.h"
 #include "zetasql/public/type.h"
 #include "zetasql/public/value.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "zetasql/base/status.h"
 #include "zetasql/base/statusor.h"
 
 // The full specification for ZetaSQL casting and coercion is at:
@@ -28,8 +33,6 @@
 
 namespace zetasql {
 
-class LanguageOptions;
-
 // Identifies the conditions where casting/coercion from type <A> to type <B>
 // is valid.  EXPLICIT means coercion can only be performed if explicitly
 // present in the SQL query, i.e. CAST(column AS INT32).
@@ -115,6 +118,63 @@ inline zetasql_base::StatusOr<Value> CastStatusOrValue(
   return CastValue(from_value, default_timezone, language_options, to_type);
 }
 
+// A cast from one Type to another, resolved once and then applied to any
+// number of Values of the source Type.  Casting a column of values through a
+// CastPlan gives the same results as calling CastValue() on each value, but
+// the checks that depend only on the types and the options are done once.
+//
+// Example:
+//   ZETASQL_ASSIGN_OR_RETURN(const CastPlan plan,
+//                    CastPlan::Create(types::StringType(), types::Int64Type(),
+//                                     timezone, language_options));
+//   std::vector<Value> results;
+//   ZETASQL_RETURN_IF_ERROR(plan.CastValues(values, &results));
+//
+// A CastPlan is copyable and keeps its own copy of the LanguageOptions.
+// <from_type> and <to_type> must outlive it.
+class CastPlan {
+ public:
+  // Returns an error if a value of <from_type> can never be cast to <to_type>,
+  // which is the same error that CastValue() returns for each such value.
+  static zetasql_base::StatusOr<CastPlan> Create(
+      const Type* from_type, const Type* to_type,
+      absl::TimeZone default_timezone,
+      const LanguageOptions& language_options);
+
+  const Type* from_type() const { return from_type_; }
+  const Type* to_type() const { return to_type_; }
+
+  // Same as CastValue(<from_value>, ...) with the types and options of this
+  // plan.  <from_value> must have the Type <from_type()>.
+  zetasql_base::StatusOr<Value> Cast(const Value& from_value) const;
+
+  // Casts each of <from_values> into the corresponding element of
+  // <to_values>, which is resized to match.  Stops and returns the error for
+  // the first value that fails to cast, in which case the contents of
+  // <to_values> are unspecified.
+  zetasql_base::Status CastValues(absl::Span<const Value> from_values,
+                          std::vector<Value>* to_values) const;
+
+ private:
+  // A cast between two simple types that does not depend on the time zone or
+  // the LanguageOptions.  Never called with a NULL value.
+  typedef zetasql_base::StatusOr<Value> (*SimpleCastFunction)(const Value& value);
+
+  CastPlan(const Type* from_type, const Type* to_type,
+           absl::TimeZone default_timezone,
+           const LanguageOptions& language_options);
+
+  const Type* from_type_;
+  const Type* to_type_;
+  absl::TimeZone default_timezone_;
+  LanguageOptions language_options_;
+  // True if <from_type_> and <to_type_> are equal, so that values are
+  // returned unchanged.
+  bool is_identity_ = false;
+  // If not null, used instead of CastValue() for non-NULL values.
+  SimpleCastFunction simple_cast_function_ = nullptr;
+};
+
 }  // namespace zetasql
 
 #endif  // ZETASQL_PUBLIC_CAST_H_
@@ -0,0 +1,103 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/cast.h"
+
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/language_options.h"
+#include "zetasql/public/numeric_value.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/time/time.h"
+
+namespace zetasql {
+
+using zetasql_base::testing::StatusIs;
+
+// Checks that casting each of <values> through a CastPlan gives the same
+// result as CastValue(), both one at a time and as a batch.
+static void TestCastPlan(const Type* from_type, const Type* to_type,
+                         const std::vector<Value>& values) {
+  LanguageOptions language_options;
+  const absl::TimeZone timezone = absl::UTCTimeZone();
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      const CastPlan plan,
+      CastPlan::Create(from_type, to_type, timezone, language_options));
+  EXPECT_EQ(from_type, plan.from_type());
+  EXPECT_EQ(to_type, plan.to_type());
+
+  bool all_ok = true;
+  std::vector<Value> expected;
+  for (const Value& value : values) {
+    const zetasql_base::StatusOr<Value> expected_or =
+        CastValue(value, timezone, language_options, to_type);
+    const zetasql_base::StatusOr<Value> result = plan.Cast(value);
+    ASSERT_EQ(expected_or.ok(), result.ok()) << value.DebugString();
+    if (expected_or.ok()) {
+      EXPECT_EQ(expected_or.ValueOrDie(), result.ValueOrDie())
+          << value.DebugString();
+      expected.push_back(expected_or.ValueOrDie());
+    } else {
+      EXPECT_EQ(expected_or.status(), result.status()) << value.DebugString();
+      all_ok = false;
+    }
+  }
+
+  std::vector<Value> results;
+  const zetasql_base::Status status = plan.CastValues(values, &results);
+  EXPECT_EQ(all_ok, status.ok()) << status;
+  if (all_ok) {
+    EXPECT_EQ(expected, results);
+  }
+}
+
+TEST(CastPlanTest, MatchesCastValue) {
+  TestCastPlan(types::Int64Type(), types::Int32Type(),
+               {Value::Int64(1), Value::NullInt64(), Value::Int64(-7)});
+  TestCastPlan(types::Int64Type(), types::Int32Type(),
+               {Value::Int64(1), Value::Int64(int64_t{1} << 40)});
+  TestCastPlan(types::StringType(), types::Int64Type(),
+               {Value::String("12"), Value::String(" 0x1f"),
+                Value::NullString()});
+  TestCastPlan(types::StringType(), types::DoubleType(),
+               {Value::String("1.5"), Value::String("abc")});
+  TestCastPlan(types::DoubleType(), types::StringType(),
+               {Value::Double(0.1), Value::NullDouble()});
+  TestCastPlan(types::NumericType(), types::StringType(),
+               {Value::Numeric(NumericValue(12)), Value::NullNumeric()});
+  TestCastPlan(types::BytesType(), types::StringType(),
+               {Value::Bytes("abc"), Value::Bytes("\xff")});
+  TestCastPlan(types::StringType(), types::DateType(),
+               {Value::String("2019-03-22"), Value::NullString()});
+  TestCastPlan(types::StringType(), types::StringType(),
+               {Value::String("abc"), Value::NullString()});
+  TestCastPlan(types::Int64ArrayType(), types::StringArrayType(),
+               {Value::Array(types::Int64ArrayType(),
+                             {Value::Int64(1), Value::NullInt64()}),
+                Value::Null(types::Int64ArrayType())});
+}
+
+TEST(CastPlanTest, UnsupportedCast) {
+  EXPECT_THAT(CastPlan::Create(types::DateType(), types::Int64Type(),
+                               absl::UTCTimeZone(), LanguageOptions()),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+}
+
+}  // namespace zetasql
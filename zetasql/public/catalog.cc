@@ -25,6 +25,19 @@
 
 namespace zetasql {
 
+void Catalog::ReportLookup(const Catalog* catalog, const char* object_kind,
+                           absl::Span<const std::string> path,
+                           const zetasql_base::Status& status,
+                           absl::Duration latency, const FindOptions& options) {
+  LookupEvent event;
+  event.catalog = catalog;
+  event.object_kind = object_kind;
+  event.path = path;
+  event.status = &status;
+  event.latency = latency;
+  options.lookup_callback()(event);
+}
+
 // TODO We may want to change the interfaces to just return a bool.
 // The resolver never uses the error message that gets returned from here.
 zetasql_base::Status Catalog::FindTable(
@@ -45,7 +58,9 @@ zetasql_base::Status Catalog::FindTable(
     }
     const absl::Span<const std::string> path_suffix =
         path.subspan(1, path.size() - 1);
-    return catalog->FindTable(path_suffix, table, options);
+    return TraceLookup(catalog, "Table", path_suffix, options, [&] {
+      return catalog->FindTable(path_suffix, table, options);
+    });
   } else {
     ZETASQL_RETURN_IF_ERROR(GetTable(name, table, options));
     if (*table == nullptr) {
@@ -55,6 +70,17 @@ zetasql_base::Status Catalog::FindTable(
   }
 }
 
+zetasql_base::Status Catalog::FindTable(absl::Span<const IdString> path,
+                                const Table** table,
+                                const FindOptions& options) {
+  std::vector<std::string> string_path;
+  string_path.reserve(path.size());
+  for (const IdString name : path) {
+    string_path.push_back(name.ToString());
+  }
+  return FindTable(string_path, table, options);
+}
+
 zetasql_base::Status Catalog::FindModel(const absl::Span<const std::string>& path,
                                 const Model** model,
                                 const FindOptions& options) {
@@ -72,7 +98,9 @@ zetasql_base::Status Catalog::FindModel(const absl::Span<const std::string>& pat
     }
     const absl::Span<const std::string> path_suffix =
         path.subspan(1, path.size() - 1);
-    return catalog->FindModel(path_suffix, model, options);
+    return TraceLookup(catalog, "Model", path_suffix, options, [&] {
+      return catalog->FindModel(path_suffix, model, options);
+    });
   } else {
     ZETASQL_RETURN_IF_ERROR(GetModel(name, model, options));
     if (*model == nullptr) {
@@ -100,7 +128,9 @@ zetasql_base::Status Catalog::FindFunction(
     }
     const absl::Span<const std::string> path_suffix
       = path.subspan(1, path.size() - 1);
-    return catalog->FindFunction(path_suffix, function, options);
+    return TraceLookup(catalog, "Function", path_suffix, options, [&] {
+      return catalog->FindFunction(path_suffix, function, options);
+    });
   } else {
     ZETASQL_RETURN_IF_ERROR(GetFunction(name, function, options));
     if (*function == nullptr) {
@@ -128,7 +158,9 @@ zetasql_base::Status Catalog::FindTableValuedFunction(
     }
     const absl::Span<const std::string> path_suffix =
         path.subspan(1, path.size() - 1);
-    return catalog->FindTableValuedFunction(path_suffix, function, options);
+    return TraceLookup(catalog, "TableValuedFunction", path_suffix, options, [&] {
+      return catalog->FindTableValuedFunction(path_suffix, function, options);
+    });
   } else {
     ZETASQL_RETURN_IF_ERROR(GetTableValuedFunction(name, function, options));
     if (*function == nullptr) {
@@ -155,7 +187,9 @@ zetasql_base::Status Catalog::FindProcedure(
     }
     const absl::Span<const std::string> path_suffix =
         path.subspan(1, path.size() - 1);
-    return catalog->FindProcedure(path_suffix, procedure, options);
+    return TraceLookup(catalog, "Procedure", path_suffix, options, [&] {
+      return catalog->FindProcedure(path_suffix, procedure, options);
+    });
   } else {
     ZETASQL_RETURN_IF_ERROR(GetProcedure(name, procedure, options));
     if (*procedure == nullptr) {
@@ -198,7 +232,9 @@ zetasql_base::Status Catalog::FindType(
     }
     const absl::Span<const std::string> path_suffix =
         path.subspan(1, path.size() - 1);
-    return catalog->FindType(path_suffix, type, options);
+    return TraceLookup(catalog, "Type", path_suffix, options, [&] {
+      return catalog->FindType(path_suffix, type, options);
+    });
   } else {
     ZETASQL_RETURN_IF_ERROR(GetType(name, type, options));
     if (*type == nullptr) {
@@ -263,9 +299,13 @@ zetasql_base::Status Catalog::FindConstantWithPathPrefixImpl(
       // be a struct-typed constant (see below).
       const absl::Span<const std::string> path_suffix =
           path.subspan(1, path.size() - 1);
+      const auto find_in_next_catalog = [&] {
+        return next_resolved_catalog->FindConstantWithPathPrefix(
+            path_suffix, num_names_consumed, constant, options);
+      };
       const zetasql_base::Status find_constant_with_path_prefix_status =
-          next_resolved_catalog->FindConstantWithPathPrefix(
-              path_suffix, num_names_consumed, constant, options);
+          TraceLookup(next_resolved_catalog, "Constant", path_suffix, options,
+                      find_in_next_catalog);
       if (find_constant_with_path_prefix_status.code() !=
           zetasql_base::StatusCode::kNotFound) {
         *num_names_consumed += 1;
@@ -355,6 +395,12 @@ std::string Catalog::SuggestConstant(const absl::Span<const std::string>& mistyp
   return "";
 }
 
+zetasql_base::Status Catalog::PrefetchTables(
+    absl::Span<const std::vector<std::string>> paths,
+    const FindOptions& options) {
+  return ::zetasql_base::OkStatus();
+}
+
 zetasql_base::Status Catalog::GetTable(
     const std::string& name,
     const Table** table,
@@ -469,4 +515,18 @@ zetasql_base::Status Catalog::EmptyNamePathInternalError(
       << "Invalid empty " << object_type << " name path";
 }
 
+zetasql_base::StatusOr<std::vector<std::unique_ptr<EvaluatorTableIterator>>>
+Table::CreatePartitionedIterators(absl::Span<const int> column_idxs,
+                                  int max_partitions) const {
+  if (max_partitions <= 0) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "max_partitions must be positive, but is " << max_partitions;
+  }
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<EvaluatorTableIterator> iterator,
+                   CreateEvaluatorTableIterator(column_idxs));
+  std::vector<std::unique_ptr<EvaluatorTableIterator>> iterators;
+  iterators.push_back(std::move(iterator));
+  return iterators;
+}
+
 }  // namespace zetasql
@@ -17,14 +17,19 @@
 #ifndef ZETASQL_PUBLIC_CATALOG_H_
 #define ZETASQL_PUBLIC_CATALOG_H_
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <type_traits>
 #include <vector>
 
 #include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/id_string.h"
 #include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
 #include <cstdint>
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "zetasql/base/source_location.h"
 #include "zetasql/base/status.h"
@@ -110,6 +115,22 @@ class Catalog {
   // Suitable for log messages, but not necessarily a valid SQL path expression.
   virtual std::string FullName() const = 0;
 
+  // A finished lookup, reported to FindOptions::lookup_callback().
+  struct LookupEvent {
+    // The Catalog searched, which is a nested Catalog of the one the lookup
+    // started in for lookups made while traversing nested Catalogs.
+    const Catalog* catalog = nullptr;
+    // The kind of object looked up: "Table", "Function", "Type", "Constant",
+    // "Model", "TableValuedFunction" or "Procedure".
+    const char* object_kind = "";
+    // The path looked up in <catalog>.
+    absl::Span<const std::string> path;
+    // The result of the lookup. NOT_FOUND if there is no such object.
+    const zetasql_base::Status* status = nullptr;
+    absl::Duration latency;
+  };
+  typedef std::function<void(const LookupEvent&)> LookupCallback;
+
   // Options for a LookupName call.
   class FindOptions {
    public:
@@ -125,6 +146,21 @@ class Catalog {
       return cycle_detector_;
     }
 
+    // If set, <callback> is called after each lookup by the analyzer, and
+    // after each lookup in a nested Catalog made by the default Find*()
+    // implementations, with the path and latency of the lookup. This is meant
+    // for tracing and metrics, like finding slow lookups in remote catalogs.
+    // Catalogs that override Find*() and traverse nested Catalogs themselves
+    // can report their nested lookups with TraceLookup().
+    //
+    // The callback is called on the thread of the lookup, and must be
+    // thread-safe if lookups are made from several threads. It is not called
+    // for GetX() calls or for PrefetchTables().
+    void set_lookup_callback(LookupCallback callback) {
+      lookup_callback_ = std::move(callback);
+    }
+    const LookupCallback& lookup_callback() const { return lookup_callback_; }
+
    private:
     // Possibly deadlines, Tasks for cancellation, etc.
 
@@ -133,8 +169,51 @@ class Catalog {
     // since Find*() calls may update the CycleDetector.
     // Not owned.
     CycleDetector* cycle_detector_ = nullptr;
+
+    LookupCallback lookup_callback_;
   };
 
+  // Returns the result of <find>, which looks up an object of <object_kind> on
+  // <path> in <catalog> with <options>, and reports the lookup to
+  // options.lookup_callback() if it is set.  Without a callback this only
+  // calls <find>.
+  template <typename FindFn>
+  static zetasql_base::Status TraceLookup(const Catalog* catalog,
+                                  const char* object_kind,
+                                  absl::Span<const std::string> path,
+                                  const FindOptions& options, FindFn find) {
+    if (options.lookup_callback() == nullptr) {
+      return find();
+    }
+    const absl::Time start = absl::Now();
+    const zetasql_base::Status status = find();
+    ReportLookup(catalog, object_kind, path, status, absl::Now() - start,
+                 options);
+    return status;
+  }
+
+  // Same as above, for lookups on a path of IdStrings.  The path is only
+  // copied into strings when there is a callback.
+  template <typename FindFn>
+  static zetasql_base::Status TraceLookup(const Catalog* catalog,
+                                  const char* object_kind,
+                                  absl::Span<const IdString> path,
+                                  const FindOptions& options, FindFn find) {
+    if (options.lookup_callback() == nullptr) {
+      return find();
+    }
+    const absl::Time start = absl::Now();
+    const zetasql_base::Status status = find();
+    std::vector<std::string> string_path;
+    string_path.reserve(path.size());
+    for (const IdString name : path) {
+      string_path.push_back(name.ToString());
+    }
+    ReportLookup(catalog, object_kind, string_path, status,
+                 absl::Now() - start, options);
+    return status;
+  }
+
   // The FindX methods look up an object of type X from this Catalog on <path>.
   //
   // If a Catalog implementation supports looking up an object by path, it
@@ -168,6 +247,14 @@ class Catalog {
                                  const Table** table,
                                  const FindOptions& options = FindOptions());
 
+  // Variant of FindTable() for callers that already hold the path as
+  // IdStrings, like the resolver.  The default implementation copies <path>
+  // into strings and calls FindTable() above, so Catalogs only need to
+  // override this to avoid that copy, as SimpleCatalog does.
+  virtual zetasql_base::Status FindTable(absl::Span<const IdString> path,
+                                 const Table** table,
+                                 const FindOptions& options = FindOptions());
+
   virtual zetasql_base::Status FindModel(const absl::Span<const std::string>& path,
                                  const Model** model,
                                  const FindOptions& options = FindOptions());
@@ -237,6 +324,20 @@ class Catalog {
       const absl::Span<const std::string> path, int* num_names_consumed,
       const Constant** constant, const FindOptions& options = FindOptions());
 
+  // Called by the analyzer before resolving a statement when
+  // AnalyzerOptions::prefetch_tables() is set, with the paths of all tables
+  // the statement references (as computed by ExtractTableNamesFromStatement).
+  // Catalogs whose metadata is remote can override this to fetch all of the
+  // tables in one batch, so that the FindTable() calls made during
+  // resolution do not each need a round trip.
+  //
+  // This is only a hint.  Paths that do not name tables should be ignored
+  // rather than reported as errors, since resolution reports those.  Other
+  // errors fail the analysis.  The default implementation does nothing.
+  virtual zetasql_base::Status PrefetchTables(
+      absl::Span<const std::vector<std::string>> paths,
+      const FindOptions& options = FindOptions());
+
   // Overloaded helper functions that forward the call to the appropriate
   // Find*() function based on the <object> argument type.
   zetasql_base::Status FindObject(absl::Span<const std::string> path,
@@ -435,6 +536,12 @@ class Catalog {
     }
   }
 
+  // Calls options.lookup_callback() for a lookup.
+  static void ReportLookup(const Catalog* catalog, const char* object_kind,
+                           absl::Span<const std::string> path,
+                           const zetasql_base::Status& status,
+                           absl::Duration latency, const FindOptions& options);
+
   // Recursive implementation of FindConstantWithPathPrefix().
   //
   // <num_names_consumed> is an input/output parameter that indicates the length
@@ -445,6 +552,32 @@ class Catalog {
       const Constant** constant, const FindOptions& options);
 };
 
+// Estimated statistics of a column of a Table. Unknown statistics are
+// absl::nullopt, invalid Values or empty.
+struct ColumnStatistics {
+  // The number of distinct non-NULL values.
+  absl::optional<int64_t> distinct_count;
+  // The fraction of rows in which the column is NULL, in [0, 1].
+  absl::optional<double> null_fraction;
+  // The smallest and largest non-NULL values, of the type of the column.
+  Value min;
+  Value max;
+  // An opaque name of a histogram of the column, for the engine that
+  // provided the statistics to look up.
+  std::string histogram_id;
+};
+
+// Estimated statistics of a Table, for rewrites of the resolved AST that
+// make cost-based decisions, like join ordering or access path selection.
+// Statistics are hints: they may be stale, and never change query results.
+struct TableStatistics {
+  absl::optional<int64_t> row_count;
+  // The total size of the rows in storage.
+  absl::optional<int64_t> total_bytes;
+  // Empty, or one entry per column of the table, by column index.
+  std::vector<ColumnStatistics> columns;
+};
+
 // A table or table-like object visible in a ZetaSQL query.
 class Table {
  public:
@@ -480,6 +613,22 @@ class Table {
   // (broken link)
   virtual bool IsValueTable() const { return false; }
 
+  // Returns the statistics of this table, or null if there are none. The
+  // result is owned by the table and stays valid while the table is
+  // unchanged.
+  //
+  // Not used for zetasql analysis.
+  virtual const TableStatistics* GetStatistics() const { return nullptr; }
+
+  // Returns an opaque token for the current contents of this table, such as
+  // a snapshot id or a version number, which changes whenever the rows
+  // change, or an empty string if the table does not track its versions.
+  // Results computed from a table can be reused while its token is the same,
+  // see QueryResultCache.
+  //
+  // Not used for zetasql analysis.
+  virtual std::string GetVersionToken() const { return ""; }
+
   // Return an ID that can be used to represent this table in a serialized
   // resolved AST. Callers using serialized resolved ASTs should ensure that
   // all tables in their Catalog have unique IDs.
@@ -497,6 +646,54 @@ class Table {
            << " does not support the API in evaluator.h";
   }
 
+  // Returns between 1 and <max_partitions> iterators over disjoint parts of
+  // this table, which together cover all of its rows. Each iterator is
+  // independent of the others and can be read on a different thread, so a
+  // scan can use several cores. The rows of the table are the concatenation
+  // of the rows of the iterators in order.
+  //
+  // The default implementation returns the single iterator from
+  // CreateEvaluatorTableIterator(). Tables that have a natural partitioning,
+  // like files or key ranges, can override it.
+  //
+  // <max_partitions> must be positive.
+  //
+  // Not used for zetasql analysis.
+  virtual zetasql_base::StatusOr<std::vector<std::unique_ptr<EvaluatorTableIterator>>>
+  CreatePartitionedIterators(absl::Span<const int> column_idxs,
+                             int max_partitions) const;
+
+  // Returns whether CreateIndexLookupIterator() supports lookups on
+  // <key_column_idxs>, e.g. because they are the primary key of a key-value
+  // table. An executor can then join a probe input to this table by looking
+  // up batches of probe keys, rather than by scanning the whole table.
+  //
+  // Not used for zetasql analysis.
+  virtual bool SupportsIndexLookup(
+      absl::Span<const int> key_column_idxs) const {
+    return false;
+  }
+
+  // Returns an iterator over the rows of this table whose columns
+  // <key_column_idxs> are equal to one of <keys>, each a tuple of values of
+  // the types of those columns. The rows have the columns <column_idxs>,
+  // followed by an INT64 column with the index in <keys> of the matching
+  // key. The rows of each key are consecutive, and the keys are in the
+  // order of <keys>. Keys are compared with SQL equality, so keys with a
+  // NULL or NaN match no rows.
+  //
+  // Returns kUnimplemented if SupportsIndexLookup(<key_column_idxs>) is
+  // false, which is the default.
+  //
+  // Not used for zetasql analysis.
+  virtual zetasql_base::StatusOr<std::unique_ptr<EvaluatorTableIterator>>
+  CreateIndexLookupIterator(absl::Span<const int> column_idxs,
+                            absl::Span<const int> key_column_idxs,
+                            absl::Span<const std::vector<Value>> keys) const {
+    return zetasql_base::UnimplementedErrorBuilder(ZETASQL_LOC)
+           << "Table " << FullName() << " does not support index lookups";
+  }
+
   // Returns whether or not this Table is a specific table interface or
   // implementation.
   template <class TableSubclass>
@@ -0,0 +1,192 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/catalog_snapshot.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "google/protobuf/descriptor.pb.h"
+#include "zetasql/common/proto_helper.h"
+#include "zetasql/proto/simple_catalog.pb.h"
+#include "zetasql/public/type.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/strip.h"
+#include "zetasql/base/endian.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/source_location.h"
+#include "zetasql/base/status.h"
+#include "zetasql/base/status_builder.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+namespace {
+
+// A snapshot file is kFileMagic, then the build id, the number of
+// FileDescriptorSets, each serialized FileDescriptorSet in the order of
+// their descriptor set indexes, and the serialized SimpleCatalogProto.
+// Strings are written with a 32-bit length, and all integers are
+// little-endian.
+constexpr absl::string_view kFileMagic = "ZetaSQL CatalogSnapshot 1\n";
+
+void AppendUint32(uint32_t value, std::string* output) {
+  char buffer[sizeof(value)];
+  zetasql_base::LittleEndian::Store32(buffer, value);
+  output->append(buffer, sizeof(buffer));
+}
+
+void AppendString(absl::string_view value, std::string* output) {
+  AppendUint32(static_cast<uint32_t>(value.size()), output);
+  output->append(value.data(), value.size());
+}
+
+bool ReadUint32(absl::string_view* input, uint32_t* value) {
+  if (input->size() < sizeof(uint32_t)) return false;
+  *value = zetasql_base::LittleEndian::Load32(input->data());
+  input->remove_prefix(sizeof(uint32_t));
+  return true;
+}
+
+bool ReadString(absl::string_view* input, absl::string_view* value) {
+  uint32_t size;
+  if (!ReadUint32(input, &size) || input->size() < size) return false;
+  *value = input->substr(0, size);
+  input->remove_prefix(size);
+  return true;
+}
+
+}  // namespace
+
+CatalogSnapshot::~CatalogSnapshot() {}
+
+zetasql_base::Status CatalogSnapshot::Write(
+    const SimpleCatalog& catalog,
+    const ZetaSQLBuiltinFunctionOptionsProto* builtin_function_options,
+    absl::string_view build_id, const std::string& path) {
+  FileDescriptorSetMap file_descriptor_set_map;
+  SimpleCatalogProto proto;
+  ZETASQL_RETURN_IF_ERROR(catalog.Serialize(&file_descriptor_set_map, &proto));
+  if (builtin_function_options != nullptr) {
+    *proto.mutable_builtin_function_options() = *builtin_function_options;
+  }
+
+  std::vector<const google::protobuf::FileDescriptorSet*> file_descriptor_sets(
+      file_descriptor_set_map.size());
+  for (const auto& entry : file_descriptor_set_map) {
+    const int index = entry.second->descriptor_set_index;
+    ZETASQL_RET_CHECK(index >= 0 && index < file_descriptor_sets.size());
+    file_descriptor_sets[index] = &entry.second->file_descriptor_set;
+  }
+
+  std::string data(kFileMagic);
+  AppendString(build_id, &data);
+  AppendUint32(static_cast<uint32_t>(file_descriptor_sets.size()), &data);
+  for (const google::protobuf::FileDescriptorSet* file_descriptor_set :
+       file_descriptor_sets) {
+    AppendString(file_descriptor_set->SerializeAsString(), &data);
+  }
+  AppendString(proto.SerializeAsString(), &data);
+
+  const std::string temp_path = absl::StrCat(path, ".tmp");
+  {
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    file.write(data.data(), data.size());
+    file.close();
+    if (!file) {
+      return zetasql_base::InternalErrorBuilder(ZETASQL_LOC)
+             << "Failed to write catalog snapshot file " << temp_path;
+    }
+  }
+  if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+    return zetasql_base::InternalErrorBuilder(ZETASQL_LOC)
+           << "Failed to rename catalog snapshot file " << temp_path << " to "
+           << path;
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status CatalogSnapshot::Open(
+    const std::string& path, absl::string_view build_id,
+    std::unique_ptr<CatalogSnapshot>* snapshot) {
+  std::unique_ptr<CatalogSnapshot> result(new CatalogSnapshot);
+  {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+      return zetasql_base::NotFoundErrorBuilder(ZETASQL_LOC)
+             << "Catalog snapshot file not found: " << path;
+    }
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    if (file.bad()) {
+      return zetasql_base::InternalErrorBuilder(ZETASQL_LOC)
+             << "Failed to read catalog snapshot file " << path;
+    }
+    result->data_ = contents.str();
+  }
+
+  absl::string_view input = result->data_;
+  absl::string_view file_build_id;
+  if (!absl::ConsumePrefix(&input, kFileMagic) ||
+      !ReadString(&input, &file_build_id)) {
+    return zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "Not a catalog snapshot file: " << path;
+  }
+  if (file_build_id != build_id) {
+    return zetasql_base::FailedPreconditionErrorBuilder(ZETASQL_LOC)
+           << "Catalog snapshot file " << path << " was written by build "
+           << file_build_id << ", not " << build_id;
+  }
+
+  uint32_t num_file_descriptor_sets;
+  if (!ReadUint32(&input, &num_file_descriptor_sets)) {
+    return zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "Corrupt catalog snapshot file: " << path;
+  }
+  for (uint32_t i = 0; i < num_file_descriptor_sets; ++i) {
+    absl::string_view serialized;
+    google::protobuf::FileDescriptorSet file_descriptor_set;
+    if (!ReadString(&input, &serialized) ||
+        !file_descriptor_set.ParseFromArray(
+            serialized.data(), static_cast<int>(serialized.size()))) {
+      return zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+             << "Corrupt catalog snapshot file: " << path;
+    }
+    auto pool = absl::make_unique<google::protobuf::DescriptorPool>();
+    ZETASQL_RETURN_IF_ERROR(
+        AddFileDescriptorSetToPool(&file_descriptor_set, pool.get()));
+    result->const_pools_.push_back(pool.get());
+    result->pools_.push_back(std::move(pool));
+  }
+
+  absl::string_view serialized_catalog;
+  if (!ReadString(&input, &serialized_catalog) || !input.empty()) {
+    return zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "Corrupt catalog snapshot file: " << path;
+  }
+  ZETASQL_RETURN_IF_ERROR(LazySimpleCatalog::Create(
+      serialized_catalog, result->const_pools_, &result->catalog_));
+  *snapshot = std::move(result);
+  return ::zetasql_base::OkStatus();
+}
+
+}  // namespace zetasql
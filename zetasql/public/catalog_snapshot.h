@@ -0,0 +1,99 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PUBLIC_CATALOG_SNAPSHOT_H_
+#define ZETASQL_PUBLIC_CATALOG_SNAPSHOT_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "google/protobuf/descriptor.h"
+#include "zetasql/proto/options.pb.h"
+#include "zetasql/public/lazy_simple_catalog.h"
+#include "zetasql/public/simple_catalog.h"
+#include "absl/strings/string_view.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+
+// A SimpleCatalog saved to a single file, so that other processes can open
+// it at startup instead of building the catalog again.
+//
+// Opening a snapshot reads the file once and builds the DescriptorPools of
+// the proto and enum types it uses.  The catalog itself is a
+// LazySimpleCatalog over the bytes of the file, so tables are decoded only
+// when they are first looked up, and builtin functions are added from their
+// options rather than stored one by one.
+//
+// A snapshot is tied to the build that wrote it, like ParseCache files:
+// the writer passes a build id, and Open() with a different build id fails.
+//
+// This class is thread-compatible; the catalog it returns is as thread-safe
+// as LazySimpleCatalog.
+class CatalogSnapshot {
+ public:
+  CatalogSnapshot(const CatalogSnapshot&) = delete;
+  CatalogSnapshot& operator=(const CatalogSnapshot&) = delete;
+  ~CatalogSnapshot();
+
+  // Writes <catalog>, which must only contain objects that
+  // SimpleCatalog::Serialize() supports, to the file <path>.  Builtin
+  // functions are not written; if <builtin_function_options> is non-NULL,
+  // the opened catalog gets the builtin functions for those options.
+  // The file is written to a temporary file first and then renamed, so
+  // readers never see a partial snapshot.
+  static zetasql_base::Status Write(
+      const SimpleCatalog& catalog,
+      const ZetaSQLBuiltinFunctionOptionsProto* builtin_function_options,
+      absl::string_view build_id, const std::string& path);
+
+  // Opens the snapshot in the file <path>.  Returns a NOT_FOUND error if the
+  // file does not exist, a FAILED_PRECONDITION error if it was written with
+  // another build id, and an INVALID_ARGUMENT error if it is not a valid
+  // snapshot.
+  static zetasql_base::Status Open(const std::string& path,
+                           absl::string_view build_id,
+                           std::unique_ptr<CatalogSnapshot>* snapshot);
+
+  // The catalog, which owns its TypeFactory.  It is valid as long as this
+  // snapshot is.
+  LazySimpleCatalog* catalog() const { return catalog_.get(); }
+
+  // The DescriptorPools of the proto and enum types in catalog().
+  const std::vector<const google::protobuf::DescriptorPool*>& descriptor_pools()
+      const {
+    return const_pools_;
+  }
+
+ private:
+  CatalogSnapshot() {}
+
+  // The contents of the file.  catalog_ refers to the bytes of the
+  // serialized SimpleCatalogProto in it.
+  std::string data_;
+
+  std::vector<std::unique_ptr<google::protobuf::DescriptorPool>> pools_;
+  std::vector<const google::protobuf::DescriptorPool*> const_pools_;
+
+  // Declared last so that it is destroyed before the data and pools it
+  // refers to.
+  std::unique_ptr<LazySimpleCatalog> catalog_;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_CATALOG_SNAPSHOT_H_
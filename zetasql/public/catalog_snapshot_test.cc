@@ -0,0 +1,111 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/catalog_snapshot.h"
+
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+
+#include "google/protobuf/descriptor.pb.h"
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/proto/options.pb.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+
+namespace zetasql {
+
+using ::testing::NotNull;
+using ::zetasql_base::testing::StatusIs;
+
+class CatalogSnapshotTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    path_ = absl::StrCat(::testing::TempDir(), "/catalog_snapshot");
+    SimpleCatalog catalog("root");
+    TypeFactory* types = catalog.type_factory();
+    const ProtoType* proto_type;
+    ZETASQL_ASSERT_OK(types->MakeProtoType(
+        google::protobuf::FileDescriptorProto::descriptor(), &proto_type));
+    catalog.AddOwnedTable(new SimpleTable(
+        "T1", {{"a", types->get_int64()}, {"p", proto_type}}));
+    SimpleCatalog* nested = catalog.MakeOwnedSimpleCatalog("nested");
+    nested->AddOwnedTable(new SimpleTable("T2", {{"b", types->get_bool()}}));
+
+    const ZetaSQLBuiltinFunctionOptionsProto builtin_function_options;
+    ZETASQL_ASSERT_OK(CatalogSnapshot::Write(catalog, &builtin_function_options,
+                                     "build_1", path_));
+  }
+
+  std::string path_;
+};
+
+TEST_F(CatalogSnapshotTest, WriteAndOpen) {
+  std::unique_ptr<CatalogSnapshot> snapshot;
+  ZETASQL_ASSERT_OK(CatalogSnapshot::Open(path_, "build_1", &snapshot));
+  LazySimpleCatalog* catalog = snapshot->catalog();
+  EXPECT_EQ("root", catalog->FullName());
+  EXPECT_EQ(1, catalog->num_pending_tables());
+  EXPECT_EQ(1, snapshot->descriptor_pools().size());
+
+  const Table* table;
+  ZETASQL_ASSERT_OK(catalog->FindTable({"t1"}, &table));
+  ASSERT_THAT(table, NotNull());
+  ASSERT_EQ(2, table->NumColumns());
+  const Type* type = table->GetColumn(1)->GetType();
+  ASSERT_TRUE(type->IsProto());
+  EXPECT_EQ("google.protobuf.FileDescriptorProto",
+            type->AsProto()->descriptor()->full_name());
+  EXPECT_EQ(snapshot->descriptor_pools()[0],
+            type->AsProto()->descriptor()->file()->pool());
+
+  ZETASQL_ASSERT_OK(catalog->FindTable({"nested", "T2"}, &table));
+  EXPECT_EQ("T2", table->Name());
+
+  // Builtin functions come from the options stored in the snapshot.
+  const Function* function;
+  ZETASQL_ASSERT_OK(catalog->FindFunction({"concat"}, &function));
+  EXPECT_TRUE(function->IsZetaSQLBuiltin());
+}
+
+TEST_F(CatalogSnapshotTest, OpenErrors) {
+  std::unique_ptr<CatalogSnapshot> snapshot;
+  EXPECT_THAT(CatalogSnapshot::Open(path_, "build_2", &snapshot),
+              StatusIs(zetasql_base::StatusCode::kFailedPrecondition));
+  EXPECT_THAT(
+      CatalogSnapshot::Open(absl::StrCat(path_, ".missing"), "build_1",
+                            &snapshot),
+      StatusIs(zetasql_base::StatusCode::kNotFound));
+
+  const std::string corrupt_path = absl::StrCat(path_, ".corrupt");
+  {
+    std::ifstream in(path_, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(in)),
+                         std::istreambuf_iterator<char>());
+    std::ofstream out(corrupt_path, std::ios::binary | std::ios::trunc);
+    out << contents.substr(0, contents.size() - 1);
+  }
+  EXPECT_THAT(CatalogSnapshot::Open(corrupt_path, "build_1", &snapshot),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+  EXPECT_EQ(nullptr, snapshot);
+}
+
+}  // namespace zetasql
@@ -53,16 +53,26 @@ inline bool IsValidTimeFields(int64_t hour, int64_t minute, int64_t second,
          second < 60 && IsValidNanoseconds(nanosecond);
 }
 
+// The days of each month of common years, indexed by any 4-bit month.
+static constexpr int8_t kDaysInMonth[16] = {0,  31, 28, 31, 30, 31, 30, 31,
+                                            31, 30, 31, 30, 31, 0,  0,  0};
+
+// Returns the days of <month> of <year>, or 0 if <month> is not in [1, 12].
+// Computed without branches for the batch kernels.
+// REQUIRES: 0 <= month < 16
+inline int64_t DaysInMonth(int64_t year, int64_t month) {
+  const bool leap =
+      ((year & 3) == 0) & ((year % 100 != 0) | (year % 400 == 0));
+  return kDaysInMonth[month] + ((month == 2) & leap);
+}
+
 // A day is strictly 24 hours, an hour is 60 minutes and a minute is 60 seconds.
 // Leap seconds are not allowed.
 inline bool IsValidDatetimeFields(int64_t year, int64_t month, int64_t day,
                                   int64_t hour, int64_t minute, int64_t second,
                                   int64_t nanosecond) {
-  // CivilDay helps to determine if the specified day is valid for the month,
-  // and in the case of February, the year.
-  const absl::CivilDay civil_day(year, month, day);
   return year >= 1 && year <= 9999 && month >= 1 && month <= 12 && day >= 1 &&
-         day <= 31 && civil_day.day() == day &&
+         day <= DaysInMonth(year, month) &&
          IsValidTimeFields(hour, minute, second, nanosecond);
 }
 
@@ -402,4 +412,143 @@ std::string DatetimeValue::DebugString() const {
   return std::string(output);
 }
 
+// The kernels below use non-short-circuit operators on purpose, so that each
+// row compiles to straight-line code.
+
+bool ValidatePacked64TimeMicros(const int64_t* packed, int64_t num_rows,
+                                bool* valid) {
+  bool all_valid = true;
+  for (int64_t i = 0; i < num_rows; ++i) {
+    const uint64_t bits = absl::bit_cast<uint64_t>(packed[i]);
+    const uint64_t seconds = bits >> kMicrosShift;
+    // The hour is not masked, so that higher bits make it out of range.
+    const bool row_valid = ((seconds >> kHourShift) < 24) &
+                           (((seconds & kMinuteMask) >> kMinuteShift) < 60) &
+                           ((seconds & kSecondMask) < 60) &
+                           ((bits & kMicrosMask) < 1000000);
+    if (valid != nullptr) valid[i] = row_valid;
+    all_valid &= row_valid;
+  }
+  return all_valid;
+}
+
+bool ValidatePacked64DatetimeMicros(const int64_t* packed, int64_t num_rows,
+                                    bool* valid) {
+  bool all_valid = true;
+  for (int64_t i = 0; i < num_rows; ++i) {
+    const uint64_t bits = absl::bit_cast<uint64_t>(packed[i]);
+    const uint64_t seconds = bits >> kMicrosShift;
+    // The year is not masked, so that higher bits make it out of range.
+    const int64_t year = static_cast<int64_t>(seconds >> kYearShift);
+    const int64_t month = (seconds & kMonthMask) >> kMonthShift;
+    const int64_t day = (seconds & kDayMask) >> kDayShift;
+    const bool row_valid = (year >= 1) & (year <= 9999) & (day >= 1) &
+                           (day <= DaysInMonth(year, month)) &
+                           (((seconds & kHourMask) >> kHourShift) < 24) &
+                           (((seconds & kMinuteMask) >> kMinuteShift) < 60) &
+                           ((seconds & kSecondMask) < 60) &
+                           ((bits & kMicrosMask) < 1000000);
+    if (valid != nullptr) valid[i] = row_valid;
+    all_valid &= row_valid;
+  }
+  return all_valid;
+}
+
+// Sets output[i] to the bits of packed[i] under <mask> of the micros
+// encoding, shifted down by <shift>.
+static void ExtractPackedBits(const int64_t* packed, int64_t num_rows,
+                              uint64_t mask, int shift, int32_t* output) {
+  for (int64_t i = 0; i < num_rows; ++i) {
+    output[i] = static_cast<int32_t>(
+        (absl::bit_cast<uint64_t>(packed[i]) & mask) >> shift);
+  }
+}
+
+// Returns the mask of <field> in the micros encoding.
+static uint64_t Packed64MicrosMask(CivilTimeField field) {
+  switch (field) {
+    case CivilTimeField::kYear:
+      return kYearMask << kMicrosShift;
+    case CivilTimeField::kMonth:
+      return kMonthMask << kMicrosShift;
+    case CivilTimeField::kDay:
+      return kDayMask << kMicrosShift;
+    case CivilTimeField::kHour:
+      return kHourMask << kMicrosShift;
+    case CivilTimeField::kMinute:
+      return kMinuteMask << kMicrosShift;
+    case CivilTimeField::kSecond:
+      return kSecondMask << kMicrosShift;
+    case CivilTimeField::kMicrosecond:
+      return kMicrosMask;
+  }
+  return 0;
+}
+
+// Returns the shift of <field> in the micros encoding.
+static int Packed64MicrosShift(CivilTimeField field) {
+  switch (field) {
+    case CivilTimeField::kYear:
+      return kYearShift + kMicrosShift;
+    case CivilTimeField::kMonth:
+      return kMonthShift + kMicrosShift;
+    case CivilTimeField::kDay:
+      return kDayShift + kMicrosShift;
+    case CivilTimeField::kHour:
+      return kHourShift + kMicrosShift;
+    case CivilTimeField::kMinute:
+      return kMinuteShift + kMicrosShift;
+    case CivilTimeField::kSecond:
+      return kSecondShift + kMicrosShift;
+    case CivilTimeField::kMicrosecond:
+      return 0;
+  }
+  return 0;
+}
+
+void ExtractFromPacked64TimeMicros(CivilTimeField field, const int64_t* packed,
+                                   int64_t num_rows, int32_t* output) {
+  DCHECK(field != CivilTimeField::kYear && field != CivilTimeField::kMonth &&
+         field != CivilTimeField::kDay);
+  ExtractPackedBits(packed, num_rows, Packed64MicrosMask(field),
+                    Packed64MicrosShift(field), output);
+}
+
+void ExtractFromPacked64DatetimeMicros(CivilTimeField field,
+                                       const int64_t* packed, int64_t num_rows,
+                                       int32_t* output) {
+  ExtractPackedBits(packed, num_rows, Packed64MicrosMask(field),
+                    Packed64MicrosShift(field), output);
+}
+
+void TimeValuesFromPacked64Micros(const int64_t* packed, int64_t num_rows,
+                                  TimeValue* output) {
+  for (int64_t i = 0; i < num_rows; ++i) {
+    output[i] = TimeValue::FromPacked64Micros(packed[i]);
+  }
+}
+
+void DatetimeValuesFromPacked64Micros(const int64_t* packed, int64_t num_rows,
+                                      DatetimeValue* output) {
+  for (int64_t i = 0; i < num_rows; ++i) {
+    output[i] = DatetimeValue::FromPacked64Micros(packed[i]);
+  }
+}
+
+void Packed64MicrosFromTimeValues(const TimeValue* values, int64_t num_rows,
+                                  int64_t* output) {
+  for (int64_t i = 0; i < num_rows; ++i) {
+    DCHECK(values[i].IsValid());
+    output[i] = values[i].Packed64TimeMicros();
+  }
+}
+
+void Packed64MicrosFromDatetimeValues(const DatetimeValue* values,
+                                      int64_t num_rows, int64_t* output) {
+  for (int64_t i = 0; i < num_rows; ++i) {
+    DCHECK(values[i].IsValid());
+    output[i] = values[i].Packed64DatetimeMicros();
+  }
+}
+
 }  // namespace zetasql
@@ -378,6 +378,52 @@ static const int kMicrosShift = 20;
 static const unsigned int kNanosMask  = 0x3FFFFFFF;  // 30 bits
 static const int kNanosShift = 30;
 
+// Batch kernels over arrays of <num_rows> TIME and DATETIME values packed at
+// micros precision, as Packed64TimeMicros() and Packed64DatetimeMicros(), for
+// columnar storage. They work on the bit fields directly and compute every
+// row without branching on the values, so that compilers can vectorize them,
+// instead of unpacking each value into a TimeValue or DatetimeValue.
+
+// Sets valid[i] to whether packed[i] is a valid packed value, the same as
+// FromPacked64Micros(packed[i]).IsValid(), unless <valid> is NULL. Returns
+// true if all the values are valid.
+bool ValidatePacked64TimeMicros(const int64_t* packed, int64_t num_rows,
+                                bool* valid);
+bool ValidatePacked64DatetimeMicros(const int64_t* packed, int64_t num_rows,
+                                    bool* valid);
+
+// The fields of packed values for the Extract kernels below.
+enum class CivilTimeField {
+  kYear,
+  kMonth,
+  kDay,
+  kHour,
+  kMinute,
+  kSecond,
+  kMicrosecond,
+};
+
+// Sets output[i] to <field> of packed[i], the same as the corresponding
+// accessor of FromPacked64Micros(packed[i]). The outputs of invalid values
+// are unspecified.
+// REQUIRES: <field> is kHour, kMinute, kSecond or kMicrosecond for TIME.
+void ExtractFromPacked64TimeMicros(CivilTimeField field, const int64_t* packed,
+                                   int64_t num_rows, int32_t* output);
+void ExtractFromPacked64DatetimeMicros(CivilTimeField field,
+                                       const int64_t* packed, int64_t num_rows,
+                                       int32_t* output);
+
+// Batch versions of FromPacked64Micros() and Packed64*Micros(). Packing
+// requires valid values.
+void TimeValuesFromPacked64Micros(const int64_t* packed, int64_t num_rows,
+                                  TimeValue* output);
+void DatetimeValuesFromPacked64Micros(const int64_t* packed, int64_t num_rows,
+                                      DatetimeValue* output);
+void Packed64MicrosFromTimeValues(const TimeValue* values, int64_t num_rows,
+                                  int64_t* output);
+void Packed64MicrosFromDatetimeValues(const DatetimeValue* values,
+                                      int64_t num_rows, int64_t* output);
+
 }  // namespace zetasql
 
 #endif  // ZETASQL_PUBLIC_CIVIL_TIME_H_
@@ -16,6 +16,8 @@
 
 #include "zetasql/public/civil_time.h"
 
+#include <memory>
+#include <random>
 #include <utility>
 #include <vector>
 
@@ -24,8 +26,9 @@
 #include <cstdint>
 #include "absl/time/civil_time.h"
 
-using zetasql::TimeValue;
+using zetasql::CivilTimeField;
 using zetasql::DatetimeValue;
+using zetasql::TimeValue;
 
 namespace {
 
@@ -539,4 +542,134 @@ TEST(CivilTimeValuesTest, DatetimeValueNormalizationTest) {
   ASSERT_FALSE(datetime.IsValid());
 }
 
+// Returns packed TIME and DATETIME test values: valid values at the limits of
+// each field and leap days, invalid ones beyond them, and random bits in
+// and outside of the encodings.
+std::vector<int64_t> PackedMicrosTestValues() {
+  std::vector<int64_t> values;
+  for (int year : {1, 1900, 1970, 2000, 2004, 2019, 9999, 10000}) {
+    for (int month : {1, 2, 12, 13}) {
+      for (int day : {1, 28, 29, 30, 31}) {
+        const int64_t seconds = (int64_t{year} << 26) | (month << 22) |
+                                (day << 17) | (23 << 12) | (59 << 6) | 59;
+        values.push_back((seconds << zetasql::kMicrosShift) | 999999);
+        values.push_back(seconds << zetasql::kMicrosShift);
+      }
+    }
+  }
+  for (int64_t value : {int64_t{0}, int64_t{-1}, int64_t{0x1EC843800000000},
+                        int64_t{0x1EC8420F0000000}, int64_t{0x1EC842003C00000},
+                        int64_t{0x1EC8420000F4240}, int64_t{0x11EC842000000000},
+                        int64_t{0x17BEFAF3F0F423F}, int64_t{0x17C000000000}}) {
+    values.push_back(value);
+  }
+  std::mt19937_64 random(2019);
+  for (int i = 0; i < 1000; ++i) {
+    const uint64_t bits = random();
+    values.push_back(static_cast<int64_t>(bits >> (i % 64)));
+  }
+  return values;
+}
+
+TEST(CivilTimeValuesTest, PackedTimeMicrosKernels) {
+  const std::vector<int64_t> packed = PackedMicrosTestValues();
+  const int64_t num_rows = packed.size();
+  std::unique_ptr<bool[]> valid(new bool[num_rows]);
+  EXPECT_FALSE(zetasql::ValidatePacked64TimeMicros(packed.data(), num_rows,
+                                                     valid.get()));
+  std::vector<TimeValue> times(num_rows);
+  zetasql::TimeValuesFromPacked64Micros(packed.data(), num_rows,
+                                          times.data());
+  std::vector<int32_t> hours(num_rows), minutes(num_rows), seconds(num_rows),
+      micros(num_rows);
+  zetasql::ExtractFromPacked64TimeMicros(CivilTimeField::kHour, packed.data(),
+                                           num_rows, hours.data());
+  zetasql::ExtractFromPacked64TimeMicros(
+      CivilTimeField::kMinute, packed.data(), num_rows, minutes.data());
+  zetasql::ExtractFromPacked64TimeMicros(
+      CivilTimeField::kSecond, packed.data(), num_rows, seconds.data());
+  zetasql::ExtractFromPacked64TimeMicros(
+      CivilTimeField::kMicrosecond, packed.data(), num_rows, micros.data());
+
+  int num_valid = 0;
+  std::vector<TimeValue> valid_times;
+  for (int64_t i = 0; i < num_rows; ++i) {
+    const TimeValue time = TimeValue::FromPacked64Micros(packed[i]);
+    ASSERT_EQ(time.IsValid(), valid[i]) << packed[i];
+    ASSERT_EQ(time.DebugString(), times[i].DebugString());
+    if (!time.IsValid()) continue;
+    ++num_valid;
+    valid_times.push_back(time);
+    EXPECT_EQ(time.Hour(), hours[i]);
+    EXPECT_EQ(time.Minute(), minutes[i]);
+    EXPECT_EQ(time.Second(), seconds[i]);
+    EXPECT_EQ(time.Microseconds(), micros[i]);
+  }
+  EXPECT_GT(num_valid, 0);
+
+  std::vector<int64_t> repacked(valid_times.size());
+  zetasql::Packed64MicrosFromTimeValues(valid_times.data(), valid_times.size(),
+                                          repacked.data());
+  EXPECT_TRUE(zetasql::ValidatePacked64TimeMicros(
+      repacked.data(), repacked.size(), /*valid=*/nullptr));
+  for (int i = 0; i < valid_times.size(); ++i) {
+    EXPECT_EQ(valid_times[i].Packed64TimeMicros(), repacked[i]);
+  }
+}
+
+TEST(CivilTimeValuesTest, PackedDatetimeMicrosKernels) {
+  const std::vector<int64_t> packed = PackedMicrosTestValues();
+  const int64_t num_rows = packed.size();
+  std::unique_ptr<bool[]> valid(new bool[num_rows]);
+  EXPECT_FALSE(zetasql::ValidatePacked64DatetimeMicros(
+      packed.data(), num_rows, valid.get()));
+  std::vector<DatetimeValue> datetimes(num_rows);
+  zetasql::DatetimeValuesFromPacked64Micros(packed.data(), num_rows,
+                                              datetimes.data());
+  const CivilTimeField fields[] = {
+      CivilTimeField::kYear,   CivilTimeField::kMonth,
+      CivilTimeField::kDay,    CivilTimeField::kHour,
+      CivilTimeField::kMinute, CivilTimeField::kSecond,
+      CivilTimeField::kMicrosecond};
+  std::vector<std::vector<int32_t>> extracted;
+  for (CivilTimeField field : fields) {
+    extracted.emplace_back(num_rows);
+    zetasql::ExtractFromPacked64DatetimeMicros(field, packed.data(), num_rows,
+                                                 extracted.back().data());
+  }
+
+  int num_valid = 0;
+  std::vector<DatetimeValue> valid_datetimes;
+  for (int64_t i = 0; i < num_rows; ++i) {
+    const DatetimeValue datetime = DatetimeValue::FromPacked64Micros(packed[i]);
+    ASSERT_EQ(datetime.IsValid(), valid[i]) << packed[i];
+    ASSERT_EQ(datetime.DebugString(), datetimes[i].DebugString());
+    if (!datetime.IsValid()) continue;
+    ++num_valid;
+    valid_datetimes.push_back(datetime);
+    EXPECT_EQ(datetime.Year(), extracted[0][i]);
+    EXPECT_EQ(datetime.Month(), extracted[1][i]);
+    EXPECT_EQ(datetime.Day(), extracted[2][i]);
+    EXPECT_EQ(datetime.Hour(), extracted[3][i]);
+    EXPECT_EQ(datetime.Minute(), extracted[4][i]);
+    EXPECT_EQ(datetime.Second(), extracted[5][i]);
+    EXPECT_EQ(datetime.Microseconds(), extracted[6][i]);
+  }
+  // The leap days of 2000 and 2004 are valid, those of 1900 and 2019 not.
+  EXPECT_GT(num_valid, 0);
+  EXPECT_TRUE(DatetimeValue::FromYMDHMSAndMicros(2000, 2, 29, 0, 0, 0, 0)
+                  .IsValid());
+  EXPECT_FALSE(DatetimeValue::FromYMDHMSAndMicros(1900, 2, 29, 0, 0, 0, 0)
+                   .IsValid());
+
+  std::vector<int64_t> repacked(valid_datetimes.size());
+  zetasql::Packed64MicrosFromDatetimeValues(
+      valid_datetimes.data(), valid_datetimes.size(), repacked.data());
+  EXPECT_TRUE(zetasql::ValidatePacked64DatetimeMicros(
+      repacked.data(), repacked.size(), /*valid=*/nullptr));
+  for (int i = 0; i < valid_datetimes.size(); ++i) {
+    EXPECT_EQ(valid_datetimes[i].Packed64DatetimeMicros(), repacked[i]);
+  }
+}
+
 }  // namespace
@@ -31,6 +31,7 @@
 #include "absl/algorithm/container.h"
 #include "zetasql/base/map_util.h"
 #include "zetasql/base/status.h"
+#include "zetasql/base/status_builder.h"
 #include "zetasql/base/statusor.h"
 
 namespace zetasql {
@@ -97,11 +98,50 @@ int GetLiteralCoercionCost(const Value& literal_value, const Type* to_type) {
                                    literal_value.type()->kind());
 }
 
+namespace {
+
+// Dense copy of GetZetaSQLCasts(), indexed by [from_kind][to_kind], so that
+// finding the cast between two TypeKinds is an array lookup rather than a
+// hash lookup.  Entries for disallowed casts are NULL.
+class CastTable {
+ public:
+  CastTable() {
+    for (auto& row : casts_) {
+      std::fill(std::begin(row), std::end(row), nullptr);
+    }
+    for (const auto& entry : GetZetaSQLCasts()) {
+      casts_[entry.first.first][entry.first.second] = &entry.second;
+    }
+  }
+
+  CastTable(const CastTable&) = delete;
+  CastTable& operator=(const CastTable&) = delete;
+
+  const CastFunctionProperty* Find(TypeKind from_kind,
+                                   TypeKind to_kind) const {
+    return casts_[from_kind][to_kind];
+  }
+
+ private:
+  // Points into GetZetaSQLCasts(), which is never modified.
+  const CastFunctionProperty* casts_[TypeKind_MAX + 1][TypeKind_MAX + 1];
+};
+
+}  // namespace
+
+// Returns the CastFunctionProperty for casting <from_kind> to <to_kind>, or
+// NULL if the cast is not allowed.
+static const CastFunctionProperty* FindCast(TypeKind from_kind,
+                                            TypeKind to_kind) {
+  static const CastTable* cast_table = new CastTable;
+  return cast_table->Find(from_kind, to_kind);
+}
+
 static bool GetCastFunctionType(
     const TypeKind from_kind, const TypeKind to_kind,
     CastFunctionType* cast_type) {
   const CastFunctionProperty* cast_function_property =
-      zetasql_base::FindOrNull(GetZetaSQLCasts(), TypeKindPair(from_kind, to_kind));
+      FindCast(from_kind, to_kind);
   if (cast_function_property == nullptr) {
     return false;
   }
@@ -587,8 +627,8 @@ bool Coercer::ParameterCoercesTo(const Type* from_type, const Type* to_type,
         is_explicit, result);
   }
 
-  const CastFunctionProperty* property = zetasql_base::FindOrNull(
-      GetZetaSQLCasts(), TypeKindPair(from_type->kind(), to_type->kind()));
+  const CastFunctionProperty* property =
+      FindCast(from_type->kind(), to_type->kind());
   if (property != nullptr &&
       (SupportsParameterCoercion(property->type) ||
        (is_explicit && SupportsExplicitCast(property->type))) &&
@@ -609,8 +649,8 @@ bool Coercer::ParameterCoercesTo(const Type* from_type, const Type* to_type,
 bool Coercer::TypeCoercesTo(const Type* from_type, const Type* to_type,
                             bool is_explicit,
                             SignatureMatchResult* result) const {
-  const CastFunctionProperty* property = zetasql_base::FindOrNull(
-      GetZetaSQLCasts(), TypeKindPair(from_type->kind(), to_type->kind()));
+  const CastFunctionProperty* property =
+      FindCast(from_type->kind(), to_type->kind());
   if (property == nullptr) {
     result->incr_non_matched_arguments();
     return false;
@@ -784,6 +824,8 @@ bool Coercer::LiteralCoercesTo(const Value& literal_value, const Type* to_type,
   if (TypeCoercesTo(literal_value.type(), to_type, is_explicit,
                     &local_result)) {
     if (coerced_value != nullptr) {
+      // A failed cast only means that this signature does not match.
+      zetasql_base::CodeOnlyErrorScope code_only_errors;
       const zetasql_base::StatusOr<Value> status_or_coerced_value = CastValue(
           literal_value, default_timezone_, language_options_, to_type);
       if (!status_or_coerced_value.ok()) {
@@ -828,6 +870,7 @@ bool Coercer::LiteralCoercesTo(const Value& literal_value, const Type* to_type,
     // seems like it should logically be considered as an exact match.  Same
     // for narrowing a DOUBLE to FLOAT, and INT64 to other INT types.
     if (coerced_value != nullptr) {
+      zetasql_base::CodeOnlyErrorScope code_only_errors;
       const zetasql_base::StatusOr<Value> status_or_coerced_value = CastValue(
           literal_value, default_timezone_, language_options_, to_type);
       if (!status_or_coerced_value.ok()) {
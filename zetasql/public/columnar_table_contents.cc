@@ -0,0 +1,376 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/columnar_table_contents.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <utility>
+
+#include "zetasql/public/batch_reader_table_iterator.h"
+#include "zetasql/public/language_options.h"
+#include "zetasql/public/value_bloom_filter.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "zetasql/base/source_location.h"
+#include "zetasql/base/status_builder.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+namespace {
+
+bool IsNaN(const Value& value) {
+  switch (value.type_kind()) {
+    case TYPE_FLOAT:
+      return std::isnan(value.float_value());
+    case TYPE_DOUBLE:
+      return std::isnan(value.double_value());
+    default:
+      return false;
+  }
+}
+
+bool SqlLess(const Value& a, const Value& b) {
+  const Value less = a.SqlLessThan(b);
+  return !less.is_null() && less.bool_value();
+}
+
+// Returns a uniformly distributed number in [0, 1) that only depends on
+// <seed> and <chunk>.
+double ChunkSampleKey(uint64_t seed, int chunk) {
+  uint64_t hash = seed + (static_cast<uint64_t>(chunk) + 1) *
+                             0x9e3779b97f4a7c15ULL;
+  hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+  hash ^= hash >> 31;
+  return (hash >> 11) * 0x1.0p-53;
+}
+
+// Returns the contents of a non-NULL STRING or BYTES value.
+absl::string_view StringOrBytes(const Value& value) {
+  return value.type_kind() == TYPE_STRING ? value.string_value()
+                                          : value.bytes_value();
+}
+
+// Reads the chunks of a ColumnarTableContents, one batch per chunk.
+class ChunkReader : public ValueBatchReader {
+ public:
+  ChunkReader(std::shared_ptr<const ColumnarTableContents> contents,
+              absl::Span<const int> column_idxs,
+              std::vector<std::string> column_names, int begin_chunk,
+              int end_chunk)
+      : contents_(std::move(contents)),
+        column_idxs_(column_idxs.begin(), column_idxs.end()),
+        column_names_(std::move(column_names)),
+        next_chunk_(begin_chunk),
+        end_chunk_(end_chunk) {
+    for (const int column : column_idxs_) {
+      column_types_.push_back(contents_->column_type(column));
+    }
+  }
+
+  int NumColumns() const override { return column_idxs_.size(); }
+  std::string GetColumnName(int i) const override { return column_names_[i]; }
+  const Type* GetColumnType(int i) const override { return column_types_[i]; }
+
+  bool ReadNext(ValueBatch* batch) override {
+    while (next_chunk_ < end_chunk_) {
+      const int chunk = next_chunk_++;
+      if (sample_fraction_.has_value() &&
+          ChunkSampleKey(sample_seed_, chunk) >= *sample_fraction_) {
+        continue;
+      }
+      if (!ChunkMayPass(chunk)) continue;
+      if (batch->num_columns() != column_types_.size()) {
+        *batch = ValueBatch(column_types_);
+      } else {
+        batch->Clear();
+      }
+      const int num_rows = contents_->chunk_num_rows(chunk);
+      for (int i = 0; i < column_idxs_.size(); ++i) {
+        ColumnVector* output = batch->mutable_column(i);
+        if (!required_columns_.has_value() ||
+            std::binary_search(required_columns_->begin(),
+                               required_columns_->end(), i)) {
+          contents_->AppendChunk(chunk, column_idxs_[i], output);
+        } else {
+          for (int row = 0; row < num_rows; ++row) output->AppendNull();
+        }
+      }
+      batch->set_num_rows(num_rows);
+      return true;
+    }
+    return false;
+  }
+
+  zetasql_base::Status Status() const override {
+    return ::zetasql_base::OkStatus();
+  }
+
+  void set_map_filters(std::vector<std::pair<int, ColumnFilter>> filters) {
+    map_filters_ = std::move(filters);
+  }
+  void set_pushdown(const ScanPushdown& pushdown) {
+    required_columns_ = pushdown.required_columns;
+    pushdown_filters_ = pushdown.filters;
+  }
+  // Keeps each chunk with probability <fraction>, as a function of <seed>
+  // and the index of the chunk, so that partitions sample like a full scan.
+  void set_sample(double fraction, uint64_t seed) {
+    sample_fraction_ = fraction;
+    sample_seed_ = seed;
+  }
+
+ private:
+  bool ChunkMayPass(int chunk) const {
+    for (const auto* filters : {&map_filters_, &pushdown_filters_}) {
+      for (const auto& filter : *filters) {
+        if (!contents_->ChunkMayPass(chunk, column_idxs_[filter.first],
+                                     filter.second)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  const std::shared_ptr<const ColumnarTableContents> contents_;
+  const std::vector<int> column_idxs_;
+  const std::vector<std::string> column_names_;
+  std::vector<const Type*> column_types_;
+  int next_chunk_;
+  const int end_chunk_;
+
+  std::vector<std::pair<int, ColumnFilter>> map_filters_;
+  absl::optional<std::vector<int>> required_columns_;
+  std::vector<std::pair<int, ColumnFilter>> pushdown_filters_;
+  absl::optional<double> sample_fraction_;
+  uint64_t sample_seed_ = 0;
+};
+
+class ChunkTableIterator : public BatchReaderTableIterator {
+ public:
+  // Takes ownership of <reader>.
+  explicit ChunkTableIterator(ChunkReader* reader)
+      : BatchReaderTableIterator(absl::WrapUnique(reader)), reader_(reader) {}
+
+  zetasql_base::Status SetColumnFilterMap(
+      absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map)
+      override {
+    std::vector<std::pair<int, ColumnFilter>> filters;
+    for (const auto& entry : filter_map) {
+      filters.emplace_back(entry.first, *entry.second);
+    }
+    reader_->set_map_filters(std::move(filters));
+    return ::zetasql_base::OkStatus();
+  }
+
+  zetasql_base::Status SetScanPushdown(const ScanPushdown& pushdown,
+                               bool* rows_ordered) override {
+    reader_->set_pushdown(pushdown);
+    *rows_ordered = false;
+    return ::zetasql_base::OkStatus();
+  }
+
+  // Samples whole chunks for kSystem.
+  zetasql_base::Status SetSample(const TableSample& sample,
+                         bool* sampled) override {
+    *sampled = sample.method == TableSample::kSystem;
+    if (!*sampled) return ::zetasql_base::OkStatus();
+    uint64_t seed;
+    if (sample.seed.has_value()) {
+      seed = *sample.seed;
+    } else {
+      std::random_device random;
+      seed = (static_cast<uint64_t>(random()) << 32) ^ random();
+    }
+    reader_->set_sample(sample.percent / 100, seed);
+    return ::zetasql_base::OkStatus();
+  }
+
+ private:
+  ChunkReader* const reader_;  // Owned by BatchReaderTableIterator.
+};
+
+}  // namespace
+
+zetasql_base::Status ColumnarTableContents::Create(
+    absl::Span<const Type* const> column_types,
+    const std::vector<std::vector<Value>>& rows,
+    const ColumnarTableOptions& options,
+    std::unique_ptr<ColumnarTableContents>* contents) {
+  if (options.chunk_rows <= 0) {
+    return zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "chunk_rows must be positive, but is " << options.chunk_rows;
+  }
+  for (int row = 0; row < rows.size(); ++row) {
+    if (rows[row].size() != column_types.size()) {
+      return zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+             << "Row " << row << " has " << rows[row].size()
+             << " values instead of " << column_types.size();
+    }
+    for (int column = 0; column < column_types.size(); ++column) {
+      const Value& value = rows[row][column];
+      if (!value.is_valid() ||
+          !value.type()->Equivalent(column_types[column])) {
+        return zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+               << "Value " << value.DebugString() << " of row " << row
+               << " does not have the type of column " << column << ", "
+               << column_types[column]->DebugString();
+      }
+    }
+  }
+
+  std::unique_ptr<ColumnarTableContents> result(new ColumnarTableContents);
+  result->column_types_.assign(column_types.begin(), column_types.end());
+  result->num_rows_ = rows.size();
+  for (int64_t begin = 0; begin < rows.size(); begin += options.chunk_rows) {
+    const int64_t end =
+        std::min<int64_t>(rows.size(), begin + options.chunk_rows);
+    Chunk chunk;
+    chunk.num_rows = end - begin;
+    for (int column = 0; column < column_types.size(); ++column) {
+      const Type* type = column_types[column];
+      ColumnChunk column_chunk(type);
+      ZoneMap& zone_map = column_chunk.zone_map;
+      const bool has_min_max = type->SupportsOrdering(
+          LanguageOptions(), /*type_description=*/nullptr);
+      for (int64_t row = begin; row < end; ++row) {
+        const Value& value = rows[row][column];
+        if (value.is_null()) {
+          ++zone_map.null_count;
+        } else if (has_min_max && !IsNaN(value)) {
+          if (!zone_map.min.is_valid() || SqlLess(value, zone_map.min)) {
+            zone_map.min = value;
+          }
+          if (!zone_map.max.is_valid() || SqlLess(zone_map.max, value)) {
+            zone_map.max = value;
+          }
+        }
+      }
+
+      absl::flat_hash_map<absl::string_view, int32_t> dictionary;
+      if (options.dictionary_encoding &&
+          column_chunk.values.storage() == ColumnVector::kString) {
+        for (int64_t row = begin; row < end; ++row) {
+          const Value& value = rows[row][column];
+          if (!value.is_null()) {
+            dictionary.emplace(StringOrBytes(value), dictionary.size());
+          }
+        }
+      }
+      const int64_t num_values = chunk.num_rows - zone_map.null_count;
+      if (!dictionary.empty() && dictionary.size() * 2 <= num_values) {
+        std::vector<absl::string_view> distinct_values(dictionary.size());
+        for (const auto& entry : dictionary) {
+          distinct_values[entry.second] = entry.first;
+        }
+        for (const absl::string_view value : distinct_values) {
+          column_chunk.values.AppendString(value);
+        }
+        for (int64_t row = begin; row < end; ++row) {
+          const Value& value = rows[row][column];
+          column_chunk.codes.push_back(
+              value.is_null() ? -1 : dictionary[StringOrBytes(value)]);
+        }
+      } else {
+        column_chunk.values.Reserve(chunk.num_rows);
+        for (int64_t row = begin; row < end; ++row) {
+          ZETASQL_RETURN_IF_ERROR(column_chunk.values.Append(rows[row][column]));
+        }
+      }
+      chunk.columns.push_back(std::move(column_chunk));
+    }
+    result->chunks_.push_back(std::move(chunk));
+  }
+  *contents = std::move(result);
+  return ::zetasql_base::OkStatus();
+}
+
+bool ColumnarTableContents::ChunkMayPass(int chunk, int column,
+                                         const ColumnFilter& filter) const {
+  const ColumnChunk& column_chunk = chunks_[chunk].columns[column];
+  const ZoneMap& zone_map = column_chunk.zone_map;
+  // NULLs never pass a filter.
+  if (zone_map.null_count == chunks_[chunk].num_rows) return false;
+  switch (filter.kind()) {
+    case ColumnFilter::kRange:
+      if (!zone_map.min.is_valid()) return true;
+      return (!filter.lower_bound().is_valid() ||
+              !SqlLess(zone_map.max, filter.lower_bound())) &&
+             (!filter.upper_bound().is_valid() ||
+              !SqlLess(filter.upper_bound(), zone_map.min));
+    case ColumnFilter::kInList:
+      if (!zone_map.min.is_valid()) return true;
+      for (const Value& element : filter.in_list()) {
+        if (!SqlLess(element, zone_map.min) &&
+            !SqlLess(zone_map.max, element)) {
+          return true;
+        }
+      }
+      return false;
+    case ColumnFilter::kBloomFilter:
+      // Only a dictionary lists the values of a chunk.
+      if (column_chunk.codes.empty()) return true;
+      for (const Value& value : column_chunk.values.GetValues()) {
+        if (filter.bloom_filter().MayContain(value)) return true;
+      }
+      return false;
+    default:
+      return true;
+  }
+}
+
+void ColumnarTableContents::AppendChunk(int chunk, int column,
+                                        ColumnVector* output) const {
+  const ColumnChunk& column_chunk = chunks_[chunk].columns[column];
+  if (column_chunk.codes.empty()) {
+    output->AppendRange(column_chunk.values, 0, column_chunk.values.size());
+    return;
+  }
+  output->Reserve(output->size() + column_chunk.codes.size());
+  for (const int32_t code : column_chunk.codes) {
+    if (code < 0) {
+      output->AppendNull();
+    } else {
+      output->AppendString(column_chunk.values.GetStringView(code));
+    }
+  }
+}
+
+Value ColumnarTableContents::GetValue(int chunk, int row, int column) const {
+  const ColumnChunk& column_chunk = chunks_[chunk].columns[column];
+  if (column_chunk.codes.empty()) return column_chunk.values.GetValue(row);
+  const int32_t code = column_chunk.codes[row];
+  if (code < 0) return Value::Null(column_types_[column]);
+  return column_chunk.values.GetValue(code);
+}
+
+std::unique_ptr<EvaluatorTableIterator> ColumnarTableContents::CreateIterator(
+    std::shared_ptr<const ColumnarTableContents> contents,
+    absl::Span<const int> column_idxs, std::vector<std::string> column_names,
+    int begin_chunk, int end_chunk) {
+  return absl::make_unique<ChunkTableIterator>(
+      new ChunkReader(std::move(contents), column_idxs,
+                      std::move(column_names), begin_chunk, end_chunk));
+}
+
+}  // namespace zetasql
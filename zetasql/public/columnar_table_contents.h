@@ -0,0 +1,139 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PUBLIC_COLUMNAR_TABLE_CONTENTS_H_
+#define ZETASQL_PUBLIC_COLUMNAR_TABLE_CONTENTS_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/public/value_batch.h"
+#include "absl/types/span.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+
+struct ColumnarTableOptions {
+  // The number of rows of each chunk, except possibly the last one.
+  int chunk_rows = 4096;
+  // If true, STRING and BYTES columns of a chunk with at most half as many
+  // distinct values as non-NULL values store each distinct value once.
+  bool dictionary_encoding = true;
+};
+
+// The rows of a table, stored by column in chunks of consecutive rows.
+//
+// Each chunk of a column is a ColumnVector, or a dictionary of its distinct
+// values with one code per row. Each chunk of a column also has a zone map,
+// its NULL count and the minimum and maximum of its other values, so that
+// scans with a ColumnFilter can skip chunks without reading them.
+//
+// Contents are immutable and are shared between the iterators created from
+// them.
+//
+// Example:
+//   std::unique_ptr<ColumnarTableContents> contents;
+//   ZETASQL_RETURN_IF_ERROR(ColumnarTableContents::Create(
+//       {types::Int64Type()}, {{Value::Int64(1)}, {Value::Int64(2)}},
+//       ColumnarTableOptions(), &contents));
+class ColumnarTableContents {
+ public:
+  struct ZoneMap {
+    int null_count = 0;
+    // The minimum and maximum of the values that are not NULL or NaN. Both
+    // are invalid if there are no such values or the type does not support
+    // ordering.
+    Value min;
+    Value max;
+  };
+
+  ColumnarTableContents(const ColumnarTableContents&) = delete;
+  ColumnarTableContents& operator=(const ColumnarTableContents&) = delete;
+
+  // Returns an error if a row does not have one value of the type of each
+  // column.
+  static zetasql_base::Status Create(absl::Span<const Type* const> column_types,
+                             const std::vector<std::vector<Value>>& rows,
+                             const ColumnarTableOptions& options,
+                             std::unique_ptr<ColumnarTableContents>* contents);
+
+  int num_columns() const { return column_types_.size(); }
+  const Type* column_type(int column) const { return column_types_[column]; }
+  int64_t num_rows() const { return num_rows_; }
+  int num_chunks() const { return chunks_.size(); }
+  int chunk_num_rows(int chunk) const { return chunks_[chunk].num_rows; }
+
+  const ZoneMap& zone_map(int chunk, int column) const {
+    return chunks_[chunk].columns[column].zone_map;
+  }
+  bool IsDictionaryEncoded(int chunk, int column) const {
+    return !chunks_[chunk].columns[column].codes.empty();
+  }
+
+  // Returns false if no row of <chunk> can pass <filter> on <column>, using
+  // its zone map and, for Bloom filters, its dictionary.
+  bool ChunkMayPass(int chunk, int column, const ColumnFilter& filter) const;
+
+  // Appends the values of <column> in <chunk> to <output>, which has the
+  // type of the column.
+  void AppendChunk(int chunk, int column, ColumnVector* output) const;
+
+  // Returns the value of <column> in row <row> of <chunk>.
+  Value GetValue(int chunk, int row, int column) const;
+
+  // Returns an iterator over the rows of chunks [begin_chunk, end_chunk) with
+  // columns <column_idxs> of <contents>, named <column_names>. The iterator
+  // skips the chunks that cannot pass the filters of SetColumnFilterMap() or
+  // SetScanPushdown(), and returns NULL for columns that the pushdown does
+  // not require. For a TableSample::kSystem sample, each chunk is a block.
+  static std::unique_ptr<EvaluatorTableIterator> CreateIterator(
+      std::shared_ptr<const ColumnarTableContents> contents,
+      absl::Span<const int> column_idxs, std::vector<std::string> column_names,
+      int begin_chunk, int end_chunk);
+
+ private:
+  struct ColumnChunk {
+    explicit ColumnChunk(const Type* type) : values(type) {}
+
+    // The values of the rows of the chunk, or the distinct values if
+    // dictionary encoded.
+    ColumnVector values;
+    // If not empty, the index in <values> of the value of each row, or -1
+    // for NULL.
+    std::vector<int32_t> codes;
+    ZoneMap zone_map;
+  };
+
+  struct Chunk {
+    int num_rows = 0;
+    std::vector<ColumnChunk> columns;
+  };
+
+  ColumnarTableContents() {}
+
+  std::vector<const Type*> column_types_;
+  int64_t num_rows_ = 0;
+  std::vector<Chunk> chunks_;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_COLUMNAR_TABLE_CONTENTS_H_
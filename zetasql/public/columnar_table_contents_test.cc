@@ -0,0 +1,232 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/columnar_table_contents.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/public/value_batch.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+
+namespace zetasql {
+namespace {
+
+using ::testing::ElementsAre;
+using ::zetasql_base::testing::StatusIs;
+
+// Returns rows (i, "s<i % 3>") for i in [0, num_rows), with a NULL key in
+// every tenth row.
+std::vector<std::vector<Value>> MakeRows(int num_rows) {
+  std::vector<std::vector<Value>> rows;
+  for (int i = 0; i < num_rows; ++i) {
+    rows.push_back({i % 10 == 9 ? Value::NullInt64() : Value::Int64(i),
+                    Value::String(absl::StrCat("s", i % 3))});
+  }
+  return rows;
+}
+
+std::unique_ptr<ColumnarTableContents> MakeContents(int num_rows) {
+  ColumnarTableOptions options;
+  options.chunk_rows = 10;
+  std::unique_ptr<ColumnarTableContents> contents;
+  ZETASQL_CHECK_OK(ColumnarTableContents::Create(
+      {types::Int64Type(), types::StringType()}, MakeRows(num_rows), options,
+      &contents));
+  return contents;
+}
+
+// Returns the keys of the rows of <iterator>.
+std::vector<int64_t> ReadKeys(EvaluatorTableIterator* iterator) {
+  std::vector<int64_t> keys;
+  while (iterator->NextRow()) {
+    keys.push_back(iterator->GetValue(0).is_null()
+                       ? -1
+                       : iterator->GetValue(0).int64_value());
+  }
+  ZETASQL_EXPECT_OK(iterator->Status());
+  return keys;
+}
+
+TEST(ColumnarTableContentsTest, ChunksAndZoneMaps) {
+  std::unique_ptr<ColumnarTableContents> contents = MakeContents(25);
+  EXPECT_EQ(25, contents->num_rows());
+  ASSERT_EQ(3, contents->num_chunks());
+  EXPECT_EQ(5, contents->chunk_num_rows(2));
+
+  const ColumnarTableContents::ZoneMap& zone_map = contents->zone_map(1, 0);
+  EXPECT_EQ(1, zone_map.null_count);
+  EXPECT_EQ(Value::Int64(10), zone_map.min);
+  EXPECT_EQ(Value::Int64(18), zone_map.max);
+
+  // The keys are all distinct, and the strings have three values.
+  EXPECT_FALSE(contents->IsDictionaryEncoded(0, 0));
+  EXPECT_TRUE(contents->IsDictionaryEncoded(0, 1));
+  EXPECT_EQ(Value::String("s0"), contents->zone_map(0, 1).min);
+  EXPECT_EQ(Value::String("s2"), contents->zone_map(0, 1).max);
+
+  // Both encodings read back the original rows.
+  ColumnVector strings(types::StringType());
+  contents->AppendChunk(1, 1, &strings);
+  ASSERT_EQ(10, strings.size());
+  EXPECT_EQ(Value::String("s1"), strings.GetValue(0));
+  EXPECT_EQ(Value::String("s0"), strings.GetValue(8));
+  ColumnVector keys(types::Int64Type());
+  contents->AppendChunk(2, 0, &keys);
+  EXPECT_THAT(keys.GetValues(),
+              ElementsAre(Value::Int64(20), Value::Int64(21), Value::Int64(22),
+                          Value::Int64(23), Value::Int64(24)));
+}
+
+TEST(ColumnarTableContentsTest, DictionaryEncodingCanBeDisabled) {
+  ColumnarTableOptions options;
+  options.dictionary_encoding = false;
+  std::unique_ptr<ColumnarTableContents> contents;
+  ZETASQL_ASSERT_OK(ColumnarTableContents::Create(
+      {types::Int64Type(), types::StringType()}, MakeRows(20), options,
+      &contents));
+  EXPECT_FALSE(contents->IsDictionaryEncoded(0, 1));
+}
+
+TEST(ColumnarTableContentsTest, ChunkMayPass) {
+  std::unique_ptr<ColumnarTableContents> contents = MakeContents(30);
+  const ColumnFilter range(Value::Int64(12), Value::Int64(15));
+  EXPECT_FALSE(contents->ChunkMayPass(0, 0, range));
+  EXPECT_TRUE(contents->ChunkMayPass(1, 0, range));
+  EXPECT_FALSE(contents->ChunkMayPass(2, 0, range));
+
+  const ColumnFilter in_list(std::vector<Value>{Value::Int64(5),
+                                                Value::Int64(25)});
+  EXPECT_TRUE(contents->ChunkMayPass(0, 0, in_list));
+  EXPECT_FALSE(contents->ChunkMayPass(1, 0, in_list));
+  EXPECT_TRUE(contents->ChunkMayPass(2, 0, in_list));
+
+  const ColumnFilter strings(Value::String("t"), Value());
+  EXPECT_FALSE(contents->ChunkMayPass(0, 1, strings));
+}
+
+TEST(ColumnarTableContentsTest, IteratorSkipsChunks) {
+  std::shared_ptr<const ColumnarTableContents> contents = MakeContents(30);
+  std::unique_ptr<EvaluatorTableIterator> iterator =
+      ColumnarTableContents::CreateIterator(contents, {0, 1}, {"key", "value"},
+                                            0, contents->num_chunks());
+  EXPECT_EQ("value", iterator->GetColumnName(1));
+  absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map;
+  filter_map[0] =
+      absl::make_unique<ColumnFilter>(Value::Int64(12), Value::Int64(15));
+  ZETASQL_ASSERT_OK(iterator->SetColumnFilterMap(std::move(filter_map)));
+
+  // Only the rows of the second chunk are returned. The evaluator applies the
+  // filter to them.
+  EXPECT_THAT(ReadKeys(iterator.get()),
+              ElementsAre(10, 11, 12, 13, 14, 15, 16, 17, 18, -1));
+}
+
+TEST(ColumnarTableContentsTest, IteratorUsesPushdown) {
+  std::shared_ptr<const ColumnarTableContents> contents = MakeContents(30);
+  std::unique_ptr<EvaluatorTableIterator> iterator =
+      ColumnarTableContents::CreateIterator(contents, {1, 0}, {"value", "key"},
+                                            1, 3);
+  ScanPushdown pushdown;
+  pushdown.required_columns = std::vector<int>{1};
+  pushdown.filters.emplace_back(1, ColumnFilter(Value::Int64(25), Value()));
+  bool rows_ordered;
+  ZETASQL_ASSERT_OK(iterator->SetScanPushdown(pushdown, &rows_ordered));
+  EXPECT_FALSE(rows_ordered);
+
+  ValueBatch batch;
+  ASSERT_TRUE(iterator->NextBatch(100, &batch));
+  ASSERT_EQ(10, batch.num_rows());
+  EXPECT_EQ(Value::NullString(), batch.column(0).GetValue(0));
+  EXPECT_EQ(Value::Int64(20), batch.column(1).GetValue(0));
+  EXPECT_FALSE(iterator->NextBatch(100, &batch));
+  ZETASQL_EXPECT_OK(iterator->Status());
+}
+
+TEST(ColumnarTableContentsTest, IteratorSamplesChunks) {
+  std::shared_ptr<const ColumnarTableContents> contents = MakeContents(1000);
+  // Returns the keys of a scan of chunks [begin_chunk, end_chunk) with
+  // <sample>, or of all rows if the iterator does not sample.
+  auto read_sample = [&contents](const TableSample& sample, int begin_chunk,
+                                 int end_chunk, bool* sampled) {
+    std::unique_ptr<EvaluatorTableIterator> iterator =
+        ColumnarTableContents::CreateIterator(contents, {0}, {"key"},
+                                              begin_chunk, end_chunk);
+    ZETASQL_CHECK_OK(iterator->SetSample(sample, sampled));
+    return ReadKeys(iterator.get());
+  };
+
+  TableSample sample;
+  sample.method = TableSample::kSystem;
+  sample.percent = 30;
+  sample.seed = 17;
+  bool sampled;
+  const std::vector<int64_t> keys = read_sample(sample, 0, 100, &sampled);
+  EXPECT_TRUE(sampled);
+  // Whole chunks of 10 rows are kept.
+  EXPECT_EQ(0, keys.size() % 10);
+  EXPECT_GT(keys.size(), 150);
+  EXPECT_LT(keys.size(), 450);
+
+  // The same seed gives the same sample, also when read in partitions.
+  EXPECT_EQ(keys, read_sample(sample, 0, 100, &sampled));
+  std::vector<int64_t> partitioned_keys = read_sample(sample, 0, 40, &sampled);
+  for (int64_t key : read_sample(sample, 40, 100, &sampled)) {
+    partitioned_keys.push_back(key);
+  }
+  EXPECT_EQ(keys, partitioned_keys);
+
+  sample.percent = 100;
+  EXPECT_EQ(1000, read_sample(sample, 0, 100, &sampled).size());
+  sample.percent = 0;
+  EXPECT_TRUE(read_sample(sample, 0, 100, &sampled).empty());
+
+  // Other methods are left to the evaluator.
+  sample.method = TableSample::kBernoulli;
+  EXPECT_EQ(1000, read_sample(sample, 0, 100, &sampled).size());
+  EXPECT_FALSE(sampled);
+}
+
+TEST(ColumnarTableContentsTest, CreateErrors) {
+  std::unique_ptr<ColumnarTableContents> contents;
+  EXPECT_THAT(
+      ColumnarTableContents::Create({types::Int64Type()},
+                                    {{Value::Int64(1), Value::Int64(2)}},
+                                    ColumnarTableOptions(), &contents),
+      StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+  EXPECT_THAT(ColumnarTableContents::Create({types::Int64Type()},
+                                            {{Value::String("a")}},
+                                            ColumnarTableOptions(), &contents),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+  ColumnarTableOptions options;
+  options.chunk_rows = 0;
+  EXPECT_THAT(ColumnarTableContents::Create({types::Int64Type()}, {}, options,
+                                            &contents),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace zetasql
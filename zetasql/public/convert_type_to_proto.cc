@@ -536,6 +536,105 @@ zetasql_base::Status ConvertStructToProto(
                                            file);
 }
 
+StructToProtoDescriptorCache::StructToProtoDescriptorCache(
+    const ConvertTypeToProtoOptions& options)
+    : options_(options) {}
+
+StructToProtoDescriptorCache::~StructToProtoDescriptorCache() {}
+
+// Appends to <key> a string that identifies <type> exactly, including the
+// case of field names, and adds to <files> the files of the PROTO and ENUM
+// types in it.
+static void AppendStructSchemaKey(
+    const Type* type, std::string* key,
+    std::set<const google::protobuf::FileDescriptor*>* files) {
+  switch (type->kind()) {
+    case TYPE_STRUCT:
+      absl::StrAppend(key, "S", type->AsStruct()->num_fields(), "(");
+      for (const StructType::StructField& field : type->AsStruct()->fields()) {
+        absl::StrAppend(key, field.name.size(), ":", field.name);
+        AppendStructSchemaKey(field.type, key, files);
+      }
+      absl::StrAppend(key, ")");
+      return;
+    case TYPE_ARRAY:
+      absl::StrAppend(key, "A");
+      AppendStructSchemaKey(type->AsArray()->element_type(), key, files);
+      return;
+    case TYPE_PROTO: {
+      const google::protobuf::Descriptor* descriptor = type->AsProto()->descriptor();
+      absl::StrAppend(key, "P", descriptor->full_name().size(), ":",
+                      descriptor->full_name());
+      files->insert(descriptor->file());
+      return;
+    }
+    case TYPE_ENUM: {
+      const google::protobuf::EnumDescriptor* descriptor =
+          type->AsEnum()->enum_descriptor();
+      absl::StrAppend(key, "E", descriptor->full_name().size(), ":",
+                      descriptor->full_name());
+      files->insert(descriptor->file());
+      return;
+    }
+    default:
+      absl::StrAppend(key, "K", type->kind(), ";");
+      return;
+  }
+}
+
+zetasql_base::Status StructToProtoDescriptorCache::AddFileToPool(
+    const google::protobuf::FileDescriptor* file) {
+  if (pool_.FindFileByName(file->name()) != nullptr) {
+    return ::zetasql_base::OkStatus();
+  }
+  for (int i = 0; i < file->dependency_count(); ++i) {
+    ZETASQL_RETURN_IF_ERROR(AddFileToPool(file->dependency(i)));
+  }
+  google::protobuf::FileDescriptorProto file_proto;
+  file->CopyTo(&file_proto);
+  ZETASQL_RET_CHECK(pool_.BuildFile(file_proto) != nullptr)
+      << "Cannot copy " << file->name() << " into the descriptor pool";
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status StructToProtoDescriptorCache::GetDescriptor(
+    const StructType* struct_type, const google::protobuf::Descriptor** descriptor) {
+  ZETASQL_RET_CHECK(options_.output_field_descriptor_map == nullptr);
+  std::string key;
+  std::set<const google::protobuf::FileDescriptor*> files;
+  AppendStructSchemaKey(struct_type, &key, &files);
+
+  absl::MutexLock lock(&mutex_);
+  auto it = descriptors_.find(key);
+  if (it != descriptors_.end()) {
+    *descriptor = it->second;
+    return ::zetasql_base::OkStatus();
+  }
+
+  ZETASQL_RETURN_IF_ERROR(AddFileToPool(FieldFormat::descriptor()->file()));
+  for (const google::protobuf::FileDescriptor* file : files) {
+    ZETASQL_RETURN_IF_ERROR(AddFileToPool(file));
+  }
+
+  ConvertTypeToProtoOptions options = options_;
+  options.add_import_statements = true;
+  google::protobuf::FileDescriptorProto file_proto;
+  ZETASQL_RETURN_IF_ERROR(ConvertStructToProto(struct_type, &file_proto, options));
+  // Every schema gets its own file and package, so that all the messages can
+  // have the same name.
+  const std::string package =
+      absl::StrCat("zetasql_generated.struct_", descriptors_.size());
+  file_proto.set_name(absl::StrCat(package, ".proto"));
+  file_proto.set_package(package);
+  const google::protobuf::FileDescriptor* file = pool_.BuildFile(file_proto);
+  ZETASQL_RET_CHECK(file != nullptr)
+      << "Cannot build the proto for " << struct_type->DebugString();
+  ZETASQL_RET_CHECK_EQ(1, file->message_type_count());
+  *descriptor = file->message_type(0);
+  descriptors_.emplace(std::move(key), *descriptor);
+  return ::zetasql_base::OkStatus();
+}
+
 zetasql_base::Status ConvertArrayToProto(
     const ArrayType* array_type,
     google::protobuf::FileDescriptorProto* file,
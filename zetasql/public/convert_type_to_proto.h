@@ -27,6 +27,9 @@
 #include "zetasql/public/proto/type_annotation.pb.h"
 #include "zetasql/public/type.h"
 #include "zetasql/public/type.pb.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
 #include "zetasql/base/status.h"
 
 namespace zetasql {
@@ -234,6 +237,55 @@ zetasql_base::Status ConvertTableToProto(
     google::protobuf::FileDescriptorProto* file,
     const ConvertTypeToProtoOptions& options = ConvertTypeToProtoOptions());
 
+// Converts StructTypes to proto Descriptors, as ConvertStructToProto does, and
+// builds them in a DescriptorPool owned by this object. Each struct schema is
+// converted once: StructTypes with the same field names (case sensitively)
+// and field types get the same Descriptor, even if they come from different
+// TypeFactories. This avoids converting and building the same schema again
+// for every batch of values.
+//
+// The files of PROTO and ENUM types in converted structs are copied into the
+// pool, so those Descriptors must outlive this object, and different
+// Descriptors used in converted structs must not have the same file names.
+//
+// This class is thread-safe.
+class StructToProtoDescriptorCache {
+ public:
+  // <options> are used for all conversions.  They must not set
+  // output_field_descriptor_map, and add_import_statements is ignored.
+  explicit StructToProtoDescriptorCache(
+      const ConvertTypeToProtoOptions& options = ConvertTypeToProtoOptions());
+  StructToProtoDescriptorCache(const StructToProtoDescriptorCache&) = delete;
+  StructToProtoDescriptorCache& operator=(
+      const StructToProtoDescriptorCache&) = delete;
+  ~StructToProtoDescriptorCache();
+
+  // Returns in <descriptor> the Descriptor in pool() for values of
+  // <struct_type>.  The Descriptor stays valid for the lifetime of this
+  // object.
+  zetasql_base::Status GetDescriptor(const StructType* struct_type,
+                             const google::protobuf::Descriptor** descriptor)
+      LOCKS_EXCLUDED(mutex_);
+
+  // The pool with all the converted Descriptors.
+  const google::protobuf::DescriptorPool* pool() const { return &pool_; }
+
+ private:
+  // Builds a copy of <file> and its dependencies in pool_, unless they are
+  // already there.
+  zetasql_base::Status AddFileToPool(const google::protobuf::FileDescriptor* file)
+      EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const ConvertTypeToProtoOptions options_;
+
+  absl::Mutex mutex_;
+  // Only built while <mutex_> is held.  Finding Descriptors does not need it.
+  google::protobuf::DescriptorPool pool_;
+  // Keyed by a string that identifies the struct schema.
+  absl::flat_hash_map<std::string, const google::protobuf::Descriptor*> descriptors_
+      GUARDED_BY(mutex_);
+};
+
 // Given a FileDescriptorProto, find the message named <message_full_name> and
 // set the [zetasql.table_type=VALUE_TABLE] annotation inside it.
 // Return error if the message is not found.
@@ -0,0 +1,671 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/csv_table_iterator.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "zetasql/common/utf_util.h"
+#include "zetasql/public/functions/convert_string.h"
+#include "zetasql/public/functions/date_time_util.h"
+#include "zetasql/public/value.h"
+#include "zetasql/public/value_batch.h"
+#include "zetasql/public/value_bloom_filter.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/escaping.h"
+#include "absl/types/optional.h"
+#include "zetasql/base/bits.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/source_location.h"
+#include "zetasql/base/status_builder.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+namespace {
+
+// The number of rows read into each ValueBatch.
+constexpr int kBatchRows = 1024;
+
+bool IsNaN(const Value& value) {
+  switch (value.type_kind()) {
+    case TYPE_FLOAT:
+      return std::isnan(value.float_value());
+    case TYPE_DOUBLE:
+      return std::isnan(value.double_value());
+    default:
+      return false;
+  }
+}
+
+bool SqlLess(const Value& a, const Value& b) {
+  const Value less = a.SqlLessThan(b);
+  return !less.is_null() && less.bool_value();
+}
+
+// Returns true if the non-NULL, non-NaN <value> passes <filter>.
+bool Passes(const Value& value, const ColumnFilter& filter) {
+  switch (filter.kind()) {
+    case ColumnFilter::kRange:
+      return (!filter.lower_bound().is_valid() ||
+              !SqlLess(value, filter.lower_bound())) &&
+             (!filter.upper_bound().is_valid() ||
+              !SqlLess(filter.upper_bound(), value));
+    case ColumnFilter::kInList:
+      for (const Value& element : filter.in_list()) {
+        const Value equal = value.SqlEquals(element);
+        if (!equal.is_null() && equal.bool_value()) return true;
+      }
+      return false;
+    case ColumnFilter::kBloomFilter:
+      return filter.bloom_filter().MayContain(value);
+    default:
+      return true;
+  }
+}
+
+// Returns the index of the first set bit of <errors>, which has one.
+int FirstError(const std::vector<uint64_t>& errors) {
+  for (int i = 0; i < errors.size(); ++i) {
+    if (errors[i] != 0) {
+      return i * 64 + zetasql_base::Bits::FindLSBSetNonZero64(errors[i]);
+    }
+  }
+  return -1;
+}
+
+bool IsSupportedType(const Type* type) {
+  switch (type->kind()) {
+    case TYPE_BOOL:
+    case TYPE_INT32:
+    case TYPE_INT64:
+    case TYPE_UINT32:
+    case TYPE_UINT64:
+    case TYPE_FLOAT:
+    case TYPE_DOUBLE:
+    case TYPE_STRING:
+    case TYPE_BYTES:
+    case TYPE_DATE:
+    case TYPE_TIMESTAMP:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+MappedFile::~MappedFile() {
+  if (!data_.empty()) {
+    munmap(const_cast<char*>(data_.data()), data_.size());
+  }
+}
+
+zetasql_base::Status MappedFile::Open(const std::string& path,
+                              std::unique_ptr<MappedFile>* file) {
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    if (errno == ENOENT) {
+      return zetasql_base::NotFoundErrorBuilder(ZETASQL_LOC)
+             << "File not found: " << path;
+    }
+    return zetasql_base::InternalErrorBuilder(ZETASQL_LOC)
+           << "Failed to open " << path << ": " << strerror(errno);
+  }
+  std::unique_ptr<MappedFile> result(new MappedFile);
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    const int error = errno;
+    close(fd);
+    return zetasql_base::InternalErrorBuilder(ZETASQL_LOC)
+           << "Failed to stat " << path << ": " << strerror(error);
+  }
+  if (file_stat.st_size > 0) {
+    void* data =
+        mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      const int error = errno;
+      close(fd);
+      return zetasql_base::InternalErrorBuilder(ZETASQL_LOC)
+             << "Failed to map " << path << ": " << strerror(error);
+    }
+    // Rows are read once from start to end.
+    madvise(data, file_stat.st_size, MADV_SEQUENTIAL);
+    result->data_ =
+        absl::string_view(static_cast<const char*>(data), file_stat.st_size);
+  }
+  close(fd);
+  *file = std::move(result);
+  return ::zetasql_base::OkStatus();
+}
+
+void SplitCsvPartitions(absl::string_view data, int num_partitions,
+                        std::vector<int64_t>* boundaries) {
+  const int64_t size = data.size();
+  boundaries->assign(1, 0);
+  for (int i = 1; i < num_partitions; ++i) {
+    int64_t boundary = size * i / num_partitions;
+    if (boundary <= boundaries->back()) continue;
+    if (data[boundary - 1] != '\n') {
+      const void* newline =
+          memchr(data.data() + boundary, '\n', size - boundary);
+      if (newline == nullptr) break;
+      boundary = static_cast<const char*>(newline) - data.data() + 1;
+    }
+    if (boundary >= size) break;
+    boundaries->push_back(boundary);
+  }
+  boundaries->push_back(size);
+}
+
+// Splits the rows of the text into fields, and converts the fields of the
+// required columns one column of a batch at a time.
+class CsvTableIterator::Reader : public ValueBatchReader {
+ public:
+  Reader(absl::string_view data, int64_t begin, int64_t end,
+         std::vector<Column> columns, const CsvFormat& format)
+      : data_(data),
+        pos_(begin),
+        end_(std::min<int64_t>(end, data.size())),
+        columns_(std::move(columns)),
+        format_(format),
+        column_fields_(columns_.size()) {}
+
+  int NumColumns() const override { return columns_.size(); }
+  std::string GetColumnName(int i) const override { return columns_[i].name; }
+  const Type* GetColumnType(int i) const override { return columns_[i].type; }
+
+  bool ReadNext(ValueBatch* batch) override;
+  zetasql_base::Status Status() const override { return status_; }
+
+  void set_map_filters(std::vector<std::pair<int, ColumnFilter>> filters) {
+    map_filters_ = std::move(filters);
+  }
+  void set_pushdown(absl::optional<std::vector<int>> required_columns,
+                    std::vector<std::pair<int, ColumnFilter>> filters) {
+    required_columns_ = std::move(required_columns);
+    pushdown_filters_ = std::move(filters);
+  }
+
+ private:
+  // Positions the reader at the first row that starts in [begin, end) and
+  // decides which columns are converted.
+  zetasql_base::Status Start();
+
+  // Returns the offset of the first byte at or after <pos> that is the
+  // delimiter, the quote, or a line break, or the size of the data.
+  int64_t FindSpecial(int64_t pos) const;
+
+  // Splits the row starting at *pos into fields_, and moves *pos to the start
+  // of the next row. NULL fields are string_views with a null data().
+  zetasql_base::Status SplitRow(int64_t* pos);
+
+  zetasql_base::Status ReadBatch(ValueBatch* batch);
+
+  // Converts the fields of column <column> of the current batch.
+  zetasql_base::Status ConvertColumn(int column, ColumnVector* output);
+
+  template <typename T>
+  zetasql_base::Status ConvertNumbers(int column, ColumnVector* output);
+
+  // Appends the converted <values> of the non-NULL fields of <column>, and
+  // NULL for the others.
+  template <typename T, typename AppendFn>
+  void AppendConverted(int column, const T* values, AppendFn append,
+                       ColumnVector* output);
+
+  zetasql_base::Status FieldError(int column, int value_index) const;
+
+  // Removes the rows of <batch> that fail a filter.
+  void ApplyFilters(ValueBatch* batch);
+
+  const absl::string_view data_;
+  int64_t pos_;  // The start of the next row.
+  const int64_t end_;
+  const std::vector<Column> columns_;
+  const CsvFormat format_;
+
+  std::vector<std::pair<int, ColumnFilter>> map_filters_;
+  absl::optional<std::vector<int>> required_columns_;
+  std::vector<std::pair<int, ColumnFilter>> pushdown_filters_;
+
+  bool started_ = false;
+  std::vector<bool> convert_column_;
+  std::vector<std::pair<int, ColumnFilter>> filters_;
+  zetasql_base::Status status_;
+
+  // Reused for each batch.
+  std::vector<absl::string_view> fields_;
+  std::vector<std::vector<absl::string_view>> column_fields_;
+  std::vector<int64_t> row_offsets_;
+  // Holds quoted fields with doubled quotes, without the second quotes.
+  std::deque<std::string> unescaped_fields_;
+  std::vector<absl::string_view> values_;  // The non-NULL fields of a column.
+  std::vector<int> value_rows_;            // The row of each of values_.
+  std::vector<uint64_t> errors_;
+  std::vector<bool> keep_;
+};
+
+zetasql_base::Status CsvTableIterator::Reader::Start() {
+  for (int i = 0; i < columns_.size(); ++i) {
+    const bool required =
+        !required_columns_.has_value() ||
+        std::binary_search(required_columns_->begin(),
+                           required_columns_->end(), i);
+    convert_column_.push_back(required);
+  }
+  filters_ = map_filters_;
+  filters_.insert(filters_.end(), pushdown_filters_.begin(),
+                  pushdown_filters_.end());
+  for (const auto& filter : filters_) {
+    convert_column_[filter.first] = true;
+  }
+
+  if (pos_ >= end_) return ::zetasql_base::OkStatus();
+  if (pos_ > 0 && data_[pos_ - 1] != '\n') {
+    // The row containing <begin> belongs to the previous partition.
+    const void* newline = memchr(data_.data() + pos_, '\n', end_ - pos_);
+    pos_ = newline == nullptr
+               ? end_
+               : static_cast<const char*>(newline) - data_.data() + 1;
+  } else if (pos_ == 0 && format_.has_header) {
+    ZETASQL_RETURN_IF_ERROR(SplitRow(&pos_));
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+int64_t CsvTableIterator::Reader::FindSpecial(int64_t pos) const {
+  const char* data = data_.data();
+  const int64_t size = data_.size();
+  const char delimiter = format_.delimiter;
+  const char quote = format_.quote;
+#if defined(__SSE2__)
+  const __m128i delimiters = _mm_set1_epi8(delimiter);
+  // Without quoting, the delimiter stands in for the quote.
+  const __m128i quotes = _mm_set1_epi8(quote != '\0' ? quote : delimiter);
+  const __m128i newlines = _mm_set1_epi8('\n');
+  const __m128i returns = _mm_set1_epi8('\r');
+  for (; pos + 16 <= size; pos += 16) {
+    const __m128i block =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+    const __m128i special =
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, delimiters),
+                                  _mm_cmpeq_epi8(block, quotes)),
+                     _mm_or_si128(_mm_cmpeq_epi8(block, newlines),
+                                  _mm_cmpeq_epi8(block, returns)));
+    const int mask = _mm_movemask_epi8(special);
+    if (mask != 0) {
+      return pos + zetasql_base::Bits::FindLSBSetNonZero(mask);
+    }
+  }
+#endif
+  for (; pos < size; ++pos) {
+    const char c = data[pos];
+    if (c == delimiter || c == '\n' || c == '\r' ||
+        (quote != '\0' && c == quote)) {
+      break;
+    }
+  }
+  return pos;
+}
+
+zetasql_base::Status CsvTableIterator::Reader::SplitRow(int64_t* pos) {
+  const char* data = data_.data();
+  const int64_t size = data_.size();
+  const char quote = format_.quote;
+  int64_t p = *pos;
+  fields_.clear();
+  while (true) {
+    if (quote != '\0' && p < size && data[p] == quote) {
+      const int64_t field_start = p;
+      std::string* unescaped = nullptr;
+      int64_t value_start = p + 1;
+      while (true) {
+        const void* found =
+            memchr(data + value_start, quote, size - value_start);
+        if (found == nullptr) {
+          return zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+                 << "Unterminated quoted field at byte offset "
+                 << field_start;
+        }
+        const int64_t quote_pos = static_cast<const char*>(found) - data;
+        if (quote_pos + 1 < size && data[quote_pos + 1] == quote) {
+          if (unescaped == nullptr) {
+            unescaped_fields_.emplace_back();
+            unescaped = &unescaped_fields_.back();
+          }
+          unescaped->append(data + value_start, quote_pos + 1 - value_start);
+          value_start = quote_pos + 2;
+          continue;
+        }
+        absl::string_view value(data + value_start, quote_pos - value_start);
+        if (unescaped != nullptr) {
+          unescaped->append(value.data(), value.size());
+          value = *unescaped;
+        }
+        fields_.push_back(value);
+        p = quote_pos + 1;
+        break;
+      }
+      if (p < size && data[p] != format_.delimiter && data[p] != '\n' &&
+          !(data[p] == '\r' && p + 1 < size && data[p + 1] == '\n')) {
+        return zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+               << "Unexpected character after quoted field at byte offset "
+               << p;
+      }
+    } else {
+      const int64_t field_start = p;
+      while (true) {
+        p = FindSpecial(p);
+        // A carriage return that does not end the row is part of the field.
+        if (p < size && data[p] == '\r' &&
+            !(p + 1 < size && data[p + 1] == '\n')) {
+          ++p;
+          continue;
+        }
+        break;
+      }
+      if (p < size && quote != '\0' && data[p] == quote) {
+        return zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+               << "Unexpected quote in unquoted field at byte offset " << p;
+      }
+      fields_.push_back(p == field_start
+                            ? absl::string_view()
+                            : absl::string_view(data + field_start,
+                                                p - field_start));
+    }
+    if (p >= size) break;
+    if (data[p] == format_.delimiter) {
+      ++p;
+      continue;
+    }
+    // The row ends with "\n" or "\r\n".
+    p += data[p] == '\r' ? 2 : 1;
+    break;
+  }
+  *pos = p;
+  return ::zetasql_base::OkStatus();
+}
+
+bool CsvTableIterator::Reader::ReadNext(ValueBatch* batch) {
+  if (!status_.ok()) return false;
+  if (!started_) {
+    started_ = true;
+    status_ = Start();
+    if (!status_.ok()) return false;
+  }
+  if (pos_ >= end_) return false;
+  status_ = ReadBatch(batch);
+  return status_.ok();
+}
+
+zetasql_base::Status CsvTableIterator::Reader::ReadBatch(ValueBatch* batch) {
+  if (batch->num_columns() != columns_.size()) {
+    std::vector<const Type*> column_types;
+    for (const Column& column : columns_) column_types.push_back(column.type);
+    *batch = ValueBatch(column_types);
+  } else {
+    batch->Clear();
+  }
+  unescaped_fields_.clear();
+  row_offsets_.clear();
+  for (std::vector<absl::string_view>& fields : column_fields_) {
+    fields.clear();
+  }
+
+  while (pos_ < end_ && row_offsets_.size() < kBatchRows) {
+    const int64_t row_offset = pos_;
+    ZETASQL_RETURN_IF_ERROR(SplitRow(&pos_));
+    if (fields_.size() != columns_.size()) {
+      return zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+             << "Row at byte offset " << row_offset << " has "
+             << fields_.size() << " fields instead of " << columns_.size();
+    }
+    row_offsets_.push_back(row_offset);
+    for (int i = 0; i < columns_.size(); ++i) {
+      if (convert_column_[i]) column_fields_[i].push_back(fields_[i]);
+    }
+  }
+
+  const int num_rows = row_offsets_.size();
+  for (int i = 0; i < columns_.size(); ++i) {
+    ColumnVector* output = batch->mutable_column(i);
+    output->Reserve(num_rows);
+    if (convert_column_[i]) {
+      ZETASQL_RETURN_IF_ERROR(ConvertColumn(i, output));
+    } else {
+      for (int row = 0; row < num_rows; ++row) output->AppendNull();
+    }
+  }
+  batch->set_num_rows(num_rows);
+  if (!filters_.empty()) ApplyFilters(batch);
+  return ::zetasql_base::OkStatus();
+}
+
+template <typename T, typename AppendFn>
+void CsvTableIterator::Reader::AppendConverted(int column, const T* values,
+                                               AppendFn append,
+                                               ColumnVector* output) {
+  int next_value = 0;
+  for (const absl::string_view field : column_fields_[column]) {
+    if (field.data() == nullptr) {
+      output->AppendNull();
+    } else {
+      append(values[next_value++]);
+    }
+  }
+}
+
+template <typename T>
+zetasql_base::Status CsvTableIterator::Reader::ConvertNumbers(int column,
+                                                      ColumnVector* output) {
+  std::unique_ptr<T[]> numbers(new T[values_.size()]);
+  if (functions::StringsToNumerics<T>(values_, numbers.get(),
+                                      errors_.data()) > 0) {
+    return FieldError(column, FirstError(errors_));
+  }
+  if (std::is_floating_point<T>::value) {
+    AppendConverted(
+        column, numbers.get(),
+        [output](T value) { output->AppendDouble(static_cast<double>(value)); },
+        output);
+  } else {
+    AppendConverted(
+        column, numbers.get(),
+        [output](T value) { output->AppendInt64(static_cast<int64_t>(value)); },
+        output);
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status CsvTableIterator::Reader::ConvertColumn(int column,
+                                                     ColumnVector* output) {
+  values_.clear();
+  value_rows_.clear();
+  const std::vector<absl::string_view>& fields = column_fields_[column];
+  for (int row = 0; row < fields.size(); ++row) {
+    if (fields[row].data() != nullptr) {
+      values_.push_back(fields[row]);
+      value_rows_.push_back(row);
+    }
+  }
+  errors_.resize((values_.size() + 63) / 64);
+
+  switch (columns_[column].type->kind()) {
+    case TYPE_BOOL:
+      return ConvertNumbers<bool>(column, output);
+    case TYPE_INT32:
+      return ConvertNumbers<int32_t>(column, output);
+    case TYPE_INT64:
+      return ConvertNumbers<int64_t>(column, output);
+    case TYPE_UINT32:
+      return ConvertNumbers<uint32_t>(column, output);
+    case TYPE_UINT64:
+      return ConvertNumbers<uint64_t>(column, output);
+    case TYPE_FLOAT:
+      return ConvertNumbers<float>(column, output);
+    case TYPE_DOUBLE:
+      return ConvertNumbers<double>(column, output);
+    case TYPE_STRING:
+      for (int i = 0; i < values_.size(); ++i) {
+        if (!IsWellFormedUTF8(values_[i])) return FieldError(column, i);
+      }
+      ABSL_FALLTHROUGH_INTENDED;
+    case TYPE_BYTES:
+      AppendConverted(
+          column, values_.data(),
+          [output](absl::string_view value) { output->AppendString(value); },
+          output);
+      return ::zetasql_base::OkStatus();
+    case TYPE_DATE: {
+      std::vector<int32_t> dates(values_.size());
+      for (int i = 0; i < values_.size(); ++i) {
+        if (!functions::ConvertStringToDate(values_[i], &dates[i]).ok()) {
+          return FieldError(column, i);
+        }
+      }
+      AppendConverted(
+          column, dates.data(),
+          [output](int32_t value) { output->AppendInt64(value); }, output);
+      return ::zetasql_base::OkStatus();
+    }
+    case TYPE_TIMESTAMP: {
+      std::vector<int64_t> micros(values_.size());
+      if (functions::ConvertStringsToTimestamps(
+              values_, functions::TimestampStringFormat::kAny,
+              format_.default_timezone, functions::kMicroseconds,
+              /*allow_tz_in_str=*/true, micros.data(), errors_.data()) > 0) {
+        return FieldError(column, FirstError(errors_));
+      }
+      zetasql_base::Status status;
+      AppendConverted(
+          column, micros.data(),
+          [output, &status](int64_t value) {
+            status.Update(
+                output->Append(Value::TimestampFromUnixMicros(value)));
+          },
+          output);
+      return status;
+    }
+    default:
+      ZETASQL_RET_CHECK_FAIL() << "Unsupported column type "
+                       << columns_[column].type->DebugString();
+  }
+}
+
+zetasql_base::Status CsvTableIterator::Reader::FieldError(int column,
+                                                  int value_index) const {
+  return zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+         << "Invalid " << columns_[column].type->DebugString() << " value \""
+         << absl::CHexEscape(values_[value_index]) << "\" in column "
+         << columns_[column].name << " of the row at byte offset "
+         << row_offsets_[value_rows_[value_index]];
+}
+
+void CsvTableIterator::Reader::ApplyFilters(ValueBatch* batch) {
+  const int num_rows = batch->num_rows();
+  keep_.assign(num_rows, true);
+  for (const auto& filter : filters_) {
+    const ColumnVector& column = batch->column(filter.first);
+    for (int row = 0; row < num_rows; ++row) {
+      if (!keep_[row]) continue;
+      if (column.IsNull(row)) {
+        keep_[row] = false;
+        continue;
+      }
+      const Value value = column.GetValue(row);
+      keep_[row] = !IsNaN(value) && Passes(value, filter.second);
+    }
+  }
+  if (std::find(keep_.begin(), keep_.end(), false) == keep_.end()) return;
+
+  std::vector<const Type*> column_types;
+  for (const Column& column : columns_) column_types.push_back(column.type);
+  ValueBatch kept(column_types);
+  for (int row = 0; row < num_rows;) {
+    if (!keep_[row]) {
+      ++row;
+      continue;
+    }
+    const int begin = row;
+    while (row < num_rows && keep_[row]) ++row;
+    kept.AppendRows(*batch, begin, row);
+  }
+  *batch = std::move(kept);
+}
+
+CsvTableIterator::CsvTableIterator(Reader* reader)
+    : BatchReaderTableIterator(absl::WrapUnique(reader)), reader_(reader) {}
+
+zetasql_base::Status CsvTableIterator::Create(
+    absl::string_view data, int64_t begin, int64_t end,
+    std::vector<Column> columns, const CsvFormat& format,
+    std::unique_ptr<CsvTableIterator>* iterator) {
+  for (const Column& column : columns) {
+    if (!IsSupportedType(column.type)) {
+      return zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+             << "Column " << column.name
+             << " of a CSV table has unsupported type "
+             << column.type->DebugString();
+    }
+  }
+  if (format.delimiter == '\n' || format.delimiter == '\r' ||
+      format.delimiter == format.quote) {
+    return zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "Invalid CSV delimiter";
+  }
+  if (begin < 0 || begin > end) {
+    return zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "Invalid CSV byte range [" << begin << ", " << end << ")";
+  }
+  iterator->reset(new CsvTableIterator(
+      new Reader(data, begin, end, std::move(columns), format)));
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status CsvTableIterator::SetColumnFilterMap(
+    absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map) {
+  std::vector<std::pair<int, ColumnFilter>> filters;
+  for (const auto& entry : filter_map) {
+    filters.emplace_back(entry.first, *entry.second);
+  }
+  reader_->set_map_filters(std::move(filters));
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status CsvTableIterator::SetScanPushdown(
+    const ScanPushdown& pushdown, bool* rows_ordered) {
+  reader_->set_pushdown(pushdown.required_columns, pushdown.filters);
+  *rows_ordered = false;
+  return ::zetasql_base::OkStatus();
+}
+
+}  // namespace zetasql
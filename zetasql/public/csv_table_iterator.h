@@ -0,0 +1,134 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PUBLIC_CSV_TABLE_ITERATOR_H_
+#define ZETASQL_PUBLIC_CSV_TABLE_ITERATOR_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/public/batch_reader_table_iterator.h"
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/type.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+
+// How the text of a CSV or TSV file is laid out.
+struct CsvFormat {
+  // Separates the fields of a row.  Rows end with "\n" or "\r\n".
+  char delimiter = ',';
+  // Encloses fields that contain the delimiter, line breaks or the quote
+  // itself, which is then doubled.  '\0' disables quoting, as for TSV files.
+  char quote = '"';
+  // If true, the first row of the file holds column names and is skipped.
+  bool has_header = false;
+  // The time zone of TIMESTAMP fields that do not specify one.
+  absl::TimeZone default_timezone = absl::UTCTimeZone();
+};
+
+// A read-only memory mapping of a whole file.
+class MappedFile {
+ public:
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile();
+
+  static zetasql_base::Status Open(const std::string& path,
+                           std::unique_ptr<MappedFile>* file);
+
+  absl::string_view data() const { return data_; }
+
+ private:
+  MappedFile() {}
+
+  absl::string_view data_;
+};
+
+// Returns the boundaries of up to <num_partitions> byte ranges of <data> of
+// about the same size, each starting at the start of a row: partition i is
+// [(*boundaries)[i], (*boundaries)[i + 1]).  Ranges are found from line
+// breaks only, so this must not be used for files with quoted line breaks.
+void SplitCsvPartitions(absl::string_view data, int num_partitions,
+                        std::vector<int64_t>* boundaries);
+
+// An EvaluatorTableIterator over the rows of CSV text, such as a
+// MappedFile.
+//
+// Fields are found by scanning 16 bytes at a time with SSE2 where
+// available, and are converted a column of a batch of rows at a time with
+// the bulk string conversions, so only the columns that SetScanPushdown()
+// marks as required, or that have filters, are converted; the others are
+// NULL.  Rows that fail the filters of SetColumnFilterMap() or
+// SetScanPushdown() are skipped.
+//
+// Empty unquoted fields are NULL, and quoted ones are empty strings.  Fields
+// are otherwise converted as by CAST from STRING.  Supported column types
+// are BOOL, INT32, INT64, UINT32, UINT64, FLOAT, DOUBLE, STRING, BYTES, DATE
+// and TIMESTAMP.  A malformed row or field ends the scan with an
+// INVALID_ARGUMENT Status() that gives its byte offset.
+//
+// A file can be scanned in parallel by creating one iterator for each range
+// from SplitCsvPartitions().  An iterator for the byte range [begin, end)
+// reads the rows that start in the range; a row starts at offset 0 or just
+// after a line break.
+class CsvTableIterator : public BatchReaderTableIterator {
+ public:
+  struct Column {
+    std::string name;
+    const Type* type;
+  };
+
+  // Creates an iterator over the rows of <data> that start in [begin, end).
+  // <data> must outlive the iterator.
+  static zetasql_base::Status Create(absl::string_view data, int64_t begin,
+                             int64_t end, std::vector<Column> columns,
+                             const CsvFormat& format,
+                             std::unique_ptr<CsvTableIterator>* iterator);
+
+  // Same as above, for all the rows of <data>.
+  static zetasql_base::Status Create(absl::string_view data,
+                             std::vector<Column> columns,
+                             const CsvFormat& format,
+                             std::unique_ptr<CsvTableIterator>* iterator) {
+    return Create(data, 0, data.size(), std::move(columns), format, iterator);
+  }
+
+  // Both are applied when the first row is read, so they must be called
+  // before then.
+  zetasql_base::Status SetColumnFilterMap(
+      absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map)
+      override;
+  zetasql_base::Status SetScanPushdown(const ScanPushdown& pushdown,
+                               bool* rows_ordered) override;
+
+ private:
+  class Reader;
+
+  // Takes ownership of <reader>.
+  explicit CsvTableIterator(Reader* reader);
+
+  Reader* const reader_;  // Owned by BatchReaderTableIterator.
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_CSV_TABLE_ITERATOR_H_
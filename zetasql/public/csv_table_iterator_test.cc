@@ -0,0 +1,269 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/csv_table_iterator.h"
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+
+namespace zetasql {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::zetasql_base::testing::StatusIs;
+
+std::vector<CsvTableIterator::Column> KeyValueColumns() {
+  return {{"key", types::Int64Type()}, {"value", types::StringType()}};
+}
+
+// Reads all rows of <iterator> with NextRow().
+std::vector<std::vector<Value>> ReadRows(EvaluatorTableIterator* iterator) {
+  std::vector<std::vector<Value>> rows;
+  while (iterator->NextRow()) {
+    std::vector<Value> row;
+    for (int i = 0; i < iterator->NumColumns(); ++i) {
+      row.push_back(iterator->GetValue(i));
+    }
+    rows.push_back(std::move(row));
+  }
+  return rows;
+}
+
+TEST(CsvTableIteratorTest, ConvertsTypes) {
+  const std::string data =
+      "true,-5,7,1.5,2.25,caf\xc3\xa9,\\x01,2019-03-04,"
+      "2019-03-04 05:06:07.5+01\n"
+      ",,,,,,,,\n";
+  std::unique_ptr<CsvTableIterator> iterator;
+  ZETASQL_ASSERT_OK(CsvTableIterator::Create(
+      data,
+      {{"b", types::BoolType()},
+       {"i", types::Int32Type()},
+       {"u", types::Uint64Type()},
+       {"f", types::FloatType()},
+       {"d", types::DoubleType()},
+       {"s", types::StringType()},
+       {"y", types::BytesType()},
+       {"date", types::DateType()},
+       {"t", types::TimestampType()}},
+      CsvFormat(), &iterator));
+
+  ValueBatch batch;
+  ASSERT_TRUE(iterator->NextBatch(10, &batch));
+  ASSERT_EQ(2, batch.num_rows());
+  EXPECT_THAT(
+      batch.GetRow(0),
+      ElementsAre(Value::Bool(true), Value::Int32(-5), Value::Uint64(7),
+                  Value::Float(1.5), Value::Double(2.25),
+                  Value::String("caf\xc3\xa9"), Value::Bytes("\\x01"),
+                  Value::Date(17959),
+                  Value::TimestampFromUnixMicros(1551672367500000)));
+  for (const Value& value : batch.GetRow(1)) {
+    EXPECT_TRUE(value.is_null());
+  }
+  EXPECT_FALSE(iterator->NextBatch(10, &batch));
+  ZETASQL_EXPECT_OK(iterator->Status());
+}
+
+TEST(CsvTableIteratorTest, QuotedFields) {
+  const std::string data =
+      "1,\"a,b\"\r\n"
+      "2,\"say \"\"hi\"\"\"\n"
+      "3,\"\"\n"
+      "4,\"two\nlines\"";
+  std::unique_ptr<CsvTableIterator> iterator;
+  ZETASQL_ASSERT_OK(CsvTableIterator::Create(data, KeyValueColumns(),
+                                     CsvFormat(), &iterator));
+  EXPECT_THAT(
+      ReadRows(iterator.get()),
+      ElementsAre(ElementsAre(Value::Int64(1), Value::String("a,b")),
+                  ElementsAre(Value::Int64(2), Value::String("say \"hi\"")),
+                  ElementsAre(Value::Int64(3), Value::String("")),
+                  ElementsAre(Value::Int64(4), Value::String("two\nlines"))));
+  ZETASQL_EXPECT_OK(iterator->Status());
+}
+
+TEST(CsvTableIteratorTest, TsvWithHeader) {
+  const std::string data =
+      "key\tvalue\n"
+      "1\t\"x\"\n"
+      "2\t\n";
+  CsvFormat format;
+  format.delimiter = '\t';
+  format.quote = '\0';
+  format.has_header = true;
+  std::unique_ptr<CsvTableIterator> iterator;
+  ZETASQL_ASSERT_OK(
+      CsvTableIterator::Create(data, KeyValueColumns(), format, &iterator));
+  EXPECT_THAT(
+      ReadRows(iterator.get()),
+      ElementsAre(ElementsAre(Value::Int64(1), Value::String("\"x\"")),
+                  ElementsAre(Value::Int64(2), Value::NullString())));
+  ZETASQL_EXPECT_OK(iterator->Status());
+}
+
+TEST(CsvTableIteratorTest, ConvertsOnlyRequiredColumns) {
+  // The second field is not a valid INT64, but is never converted.
+  const std::string data = "1,x\n2,y\n";
+  std::unique_ptr<CsvTableIterator> iterator;
+  ZETASQL_ASSERT_OK(CsvTableIterator::Create(
+      data, {{"key", types::Int64Type()}, {"unused", types::Int64Type()}},
+      CsvFormat(), &iterator));
+  ScanPushdown pushdown;
+  pushdown.required_columns = std::vector<int>{0};
+  bool rows_ordered;
+  ZETASQL_ASSERT_OK(iterator->SetScanPushdown(pushdown, &rows_ordered));
+  EXPECT_FALSE(rows_ordered);
+  EXPECT_THAT(ReadRows(iterator.get()),
+              ElementsAre(ElementsAre(Value::Int64(1), Value::NullInt64()),
+                          ElementsAre(Value::Int64(2), Value::NullInt64())));
+  ZETASQL_EXPECT_OK(iterator->Status());
+}
+
+TEST(CsvTableIteratorTest, AppliesFilters) {
+  std::string data;
+  for (int i = 0; i < 3000; ++i) {
+    absl::StrAppend(&data, i, ",s", i, "\n");
+  }
+  absl::StrAppend(&data, ",null\n");
+  std::unique_ptr<CsvTableIterator> iterator;
+  ZETASQL_ASSERT_OK(CsvTableIterator::Create(data, KeyValueColumns(),
+                                     CsvFormat(), &iterator));
+  // The filtered column is converted even though it is not required.
+  ScanPushdown pushdown;
+  pushdown.required_columns = std::vector<int>{1};
+  pushdown.filters.emplace_back(
+      0, ColumnFilter(Value::Int64(1000), Value::Int64(2100)));
+  bool rows_ordered;
+  ZETASQL_ASSERT_OK(iterator->SetScanPushdown(pushdown, &rows_ordered));
+  absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map;
+  filter_map[0] = absl::make_unique<ColumnFilter>(Value(), Value::Int64(1001));
+  ZETASQL_ASSERT_OK(iterator->SetColumnFilterMap(std::move(filter_map)));
+
+  EXPECT_THAT(
+      ReadRows(iterator.get()),
+      ElementsAre(ElementsAre(Value::Int64(1000), Value::String("s1000")),
+                  ElementsAre(Value::Int64(1001), Value::String("s1001"))));
+  ZETASQL_EXPECT_OK(iterator->Status());
+}
+
+TEST(CsvTableIteratorTest, PartitionsCoverAllRows) {
+  std::string data;
+  for (int i = 0; i < 1000; ++i) {
+    absl::StrAppend(&data, i, ",", std::string(i % 7, 'x'), "\n");
+  }
+  for (int num_partitions : {1, 3, 16}) {
+    std::vector<int64_t> boundaries;
+    SplitCsvPartitions(data, num_partitions, &boundaries);
+    ASSERT_EQ(num_partitions + 1, boundaries.size());
+    std::vector<int64_t> keys;
+    for (int i = 0; i + 1 < boundaries.size(); ++i) {
+      std::unique_ptr<CsvTableIterator> iterator;
+      ZETASQL_ASSERT_OK(CsvTableIterator::Create(data, boundaries[i],
+                                         boundaries[i + 1], KeyValueColumns(),
+                                         CsvFormat(), &iterator));
+      for (const std::vector<Value>& row : ReadRows(iterator.get())) {
+        keys.push_back(row[0].int64_value());
+      }
+      ZETASQL_EXPECT_OK(iterator->Status());
+    }
+    ASSERT_EQ(1000, keys.size());
+    for (int i = 0; i < keys.size(); ++i) EXPECT_EQ(i, keys[i]);
+  }
+
+  // Ranges that do not start at a row start skip the partial row.
+  std::vector<int64_t> keys;
+  for (int64_t begin = 0; begin < data.size(); begin += 1000) {
+    std::unique_ptr<CsvTableIterator> iterator;
+    ZETASQL_ASSERT_OK(CsvTableIterator::Create(data, begin, begin + 1000,
+                                       KeyValueColumns(), CsvFormat(),
+                                       &iterator));
+    for (const std::vector<Value>& row : ReadRows(iterator.get())) {
+      keys.push_back(row[0].int64_value());
+    }
+  }
+  ASSERT_EQ(1000, keys.size());
+  for (int i = 0; i < keys.size(); ++i) EXPECT_EQ(i, keys[i]);
+}
+
+TEST(CsvTableIteratorTest, Errors) {
+  std::unique_ptr<CsvTableIterator> iterator;
+  EXPECT_THAT(
+      CsvTableIterator::Create(
+          "", {{"a", types::Int64ArrayType()}}, CsvFormat(), &iterator),
+      StatusIs(zetasql_base::StatusCode::kInvalidArgument,
+               HasSubstr("unsupported type")));
+
+  struct ErrorTest {
+    std::string data;
+    std::string message;
+  };
+  const std::vector<ErrorTest> tests = {
+      {"1,a\n2\n", "Row at byte offset 4 has 1 fields instead of 2"},
+      {"1,a,b\n", "has 3 fields instead of 2"},
+      {"1,a\nx,b\n", "Invalid INT64 value \"x\" in column key of the row at "
+                     "byte offset 4"},
+      {"1,a\"b\n", "Unexpected quote in unquoted field at byte offset 3"},
+      {"1,\"ab\"c\n", "Unexpected character after quoted field"},
+      {"1,\"ab\n", "Unterminated quoted field at byte offset 2"},
+      {"1,\xff\n", "Invalid STRING value"},
+  };
+  for (const ErrorTest& test : tests) {
+    ZETASQL_ASSERT_OK(CsvTableIterator::Create(test.data, KeyValueColumns(),
+                                       CsvFormat(), &iterator));
+    EXPECT_FALSE(iterator->NextRow()) << test.data;
+    EXPECT_THAT(iterator->Status(),
+                StatusIs(zetasql_base::StatusCode::kInvalidArgument,
+                         HasSubstr(test.message)))
+        << test.data;
+  }
+}
+
+TEST(MappedFileTest, Open) {
+  const std::string path = absl::StrCat(::testing::TempDir(), "/mapped.csv");
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << "1,a\n2,b\n";
+  }
+  std::unique_ptr<MappedFile> file;
+  ZETASQL_ASSERT_OK(MappedFile::Open(path, &file));
+  EXPECT_EQ("1,a\n2,b\n", file->data());
+
+  std::unique_ptr<CsvTableIterator> iterator;
+  ZETASQL_ASSERT_OK(CsvTableIterator::Create(file->data(), KeyValueColumns(),
+                                     CsvFormat(), &iterator));
+  EXPECT_EQ(2, ReadRows(iterator.get()).size());
+
+  EXPECT_THAT(MappedFile::Open(absl::StrCat(path, ".missing"), &file),
+              StatusIs(zetasql_base::StatusCode::kNotFound));
+}
+
+}  // namespace
+}  // namespace zetasql
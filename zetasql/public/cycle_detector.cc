@@ -19,7 +19,6 @@
 #include "zetasql/base/logging.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
-#include "zetasql/base/map_util.h"
 #include "zetasql/base/source_location.h"
 #include "zetasql/base/status_builder.h"
 
@@ -47,7 +46,7 @@ zetasql_base::Status CycleDetector::ObjectInfo::DetectCycle(const std::string& o
 }
 
 bool CycleDetector::DetectCycleOrPushObject(const ObjectInfo* object_info) {
-  const bool cycle_detected = !zetasql_base::InsertIfNotPresent(&objects_, object_info);
+  const bool cycle_detected = !objects_.insert(object_info->object()).second;
   if (!cycle_detected) {
     object_deque_.emplace_back(object_info);
   }
@@ -66,7 +65,7 @@ void CycleDetector::PopObject(const ObjectInfo* expected_object_info) {
     // In non-DEBUG code, return as a no-op.
     return;
   }
-  objects_.erase(object_deque_.back());
+  objects_.erase(object_deque_.back()->object());
   object_deque_.pop_back();
   // Expected invariant.
   DCHECK_EQ(objects_.size(), object_deque_.size());
@@ -18,11 +18,11 @@
 #define ZETASQL_PUBLIC_CYCLE_DETECTOR_H_
 
 #include <deque>
-#include <set>
 #include <string>
 #include <vector>
 
 #include "absl/base/attributes.h"
+#include "absl/container/flat_hash_set.h"
 #include "zetasql/base/status.h"
 
 namespace zetasql {
@@ -134,18 +134,9 @@ class CycleDetector {
   // detail that a deque is used).  Does not own the ObjectInfos.
   std::deque<const ObjectInfo*> object_deque_;
 
-  // Comparison function for ObjectInfo.
-  struct ObjectInfoLess {
-    bool operator()(const CycleDetector::ObjectInfo* object1,
-                    const CycleDetector::ObjectInfo* object2) const {
-      return object1->object() < object2->object();
-    }
-  };
-
-  // Set of objects currently being tracked, to provide fast cycle detection
-  // after inserting a new element into the <object_deque_>.  Does not own
-  // ObjectInfos.
-  std::set<const ObjectInfo*, ObjectInfoLess> objects_;
+  // Objects of the ObjectInfos in <object_deque_>, so that detecting a cycle
+  // takes constant time however deep the stack is.
+  absl::flat_hash_set<const void*> objects_;
 };
 
 }  // namespace zetasql
@@ -16,7 +16,11 @@
 
 #include "zetasql/public/cycle_detector.h"
 
+#include <memory>
+#include <vector>
+
 #include "gtest/gtest.h"
+#include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 
@@ -178,4 +182,26 @@ TEST_F(CycleDetectorTest, CycleDetectorTests) {
   EXPECT_TRUE(cycle_detector()->IsEmpty());
 }
 
+TEST_F(CycleDetectorTest, DeepStack) {
+  constexpr int kDepth = 10000;
+  std::vector<int> objects(kDepth);
+  std::vector<std::unique_ptr<CycleDetector::ObjectInfo>> infos;
+  for (int i = 0; i < kDepth; ++i) {
+    infos.push_back(absl::make_unique<CycleDetector::ObjectInfo>(
+        absl::StrCat("obj", i), &objects[i], cycle_detector()));
+    ASSERT_TRUE(infos.back()->DetectCycle("object").ok());
+  }
+  EXPECT_EQ(kDepth, cycle_detector()->Size());
+  {
+    CycleDetector::ObjectInfo again("again", &objects[0], cycle_detector());
+    EXPECT_FALSE(again.DetectCycle("object").ok());
+  }
+  while (!infos.empty()) infos.pop_back();
+  EXPECT_TRUE(cycle_detector()->IsEmpty());
+
+  // Popped objects can be added again.
+  CycleDetector::ObjectInfo again("again", &objects[0], cycle_detector());
+  EXPECT_TRUE(again.DetectCycle("object").ok());
+}
+
 }  // namespace zetasql
@@ -19,12 +19,24 @@
 #ifndef ZETASQL_PUBLIC_EVALUATOR_TABLE_ITERATOR_H_
 #define ZETASQL_PUBLIC_EVALUATOR_TABLE_ITERATOR_H_
 
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "zetasql/base/logging.h"
 #include "zetasql/public/value.h"
+#include "zetasql/public/value_batch.h"
+#include "zetasql/public/value_bloom_filter.h"
+#include "absl/types/optional.h"
 #include "zetasql/base/status.h"
 
 namespace zetasql {
 
 struct ColumnFilter;
+struct ScanPushdown;
+struct TableSample;
 
 // Iterator interface for a user-supplied table in a PreparedQuery.
 //
@@ -87,6 +99,9 @@ class EvaluatorTableIterator {
   //
   //   - WHERE Column1 = 10 AND (Column2 BETWEEN 100 AND 200)
   //
+  // A hash join probing this iterator with the keys of its other input may
+  // also pass a kInList or kBloomFilter filter built from those keys.
+  //
   // Note that the algebrizer is not able to express ORs or NOTs through this
   // API, so queries may have to be rewritten for performance reasons if that
   // proves to be important.
@@ -128,6 +143,35 @@ class EvaluatorTableIterator {
     return zetasql_base::OkStatus();
   }
 
+  // Like SetColumnFilterMap(), this is called just before the first call to
+  // NextRow() or NextBatch(), and gives more information about how the rows
+  // will be used. See ScanPushdown for what each part permits the iterator to
+  // do. Everything except the sort order is best-effort and may be ignored.
+  //
+  // If the iterator will return its rows in the order of
+  // 'pushdown.order_by', it sets '*rows_ordered' to true, and the evaluator
+  // does not sort them again. Otherwise it sets it to false.
+  virtual zetasql_base::Status SetScanPushdown(const ScanPushdown& pushdown,
+                                       bool* rows_ordered) {
+    *rows_ordered = false;
+    return zetasql_base::OkStatus();
+  }
+
+  // Called just before the first call to NextRow() or NextBatch(), after
+  // SetScanPushdown(), if the rows of the scan are sampled by a TABLESAMPLE.
+  // Unlike the rest of the pushdown, the sample is not re-applied: if the
+  // iterator returns only a sample of its rows as described by 'sample', it
+  // sets '*sampled' to true, and the evaluator does not sample them again.
+  // Otherwise it sets it to false, and the evaluator samples the rows.
+  //
+  // Storage that samples whole blocks for TableSample::kSystem need not
+  // read the blocks that are left out.
+  virtual zetasql_base::Status SetSample(const TableSample& sample,
+                                 bool* sampled) {
+    *sampled = false;
+    return zetasql_base::OkStatus();
+  }
+
   // Returns false if there is no next row. The caller must then check
   // 'Status()'. If NextRow() returns false, the only allowed operations on this
   // iterator are NumColumns(), GetColumnName(), GetColumnType(), and Status().
@@ -139,6 +183,48 @@ class EvaluatorTableIterator {
   // returned true.
   virtual const Value& GetValue(int i) const = 0;
 
+  // Replaces the contents of '*batch' with the next rows of this iterator, at
+  // least one and at most 'max_rows' of them. Returns false if there are no
+  // more rows; the caller must then check 'Status()', as for NextRow(). The
+  // columns of '*batch' are reset to this iterator's column types if they do
+  // not already match.
+  //
+  // An iterator is read either with NextRow() and GetValue() or with
+  // NextBatch(), not both. The default implementation is built on NextRow().
+  // Implementations backed by columnar storage can override it to fill the
+  // ColumnVectors of '*batch' directly, without creating a Value per cell.
+  // 'max_rows' must be positive.
+  virtual bool NextBatch(int max_rows, ValueBatch* batch) {
+    if (!BatchMatchesColumns(*batch)) {
+      std::vector<const Type*> column_types;
+      for (int i = 0; i < NumColumns(); ++i) {
+        column_types.push_back(GetColumnType(i));
+      }
+      *batch = ValueBatch(column_types);
+    } else {
+      batch->Clear();
+    }
+    if (end_of_rows_) return false;
+    std::vector<Value> row(NumColumns());
+    while (batch->num_rows() < max_rows) {
+      if (!NextRow()) {
+        end_of_rows_ = true;
+        break;
+      }
+      for (int i = 0; i < row.size(); ++i) {
+        row[i] = GetValue(i);
+      }
+      const zetasql_base::Status status = batch->AppendRow(row);
+      if (!status.ok()) {
+        LOG(DFATAL) << "GetValue() returned a value of the wrong type: "
+                    << status;
+        end_of_rows_ = true;
+        break;
+      }
+    }
+    return batch->num_rows() > 0;
+  }
+
   // Returns OK unless the last call to NextRow() returned false because of an
   // error (including cancellation).
   virtual zetasql_base::Status Status() const = 0;
@@ -156,6 +242,20 @@ class EvaluatorTableIterator {
   // set a deadline member and check for its expiration inside processing loops
   // or in NextRow().
   virtual void SetDeadline(absl::Time deadline) {}
+
+ private:
+  // Returns true if the columns of 'batch' have this iterator's column types.
+  bool BatchMatchesColumns(const ValueBatch& batch) const {
+    if (batch.num_columns() != NumColumns()) return false;
+    for (int i = 0; i < NumColumns(); ++i) {
+      if (!batch.column(i).type()->Equals(GetColumnType(i))) return false;
+    }
+    return true;
+  }
+
+  // Set by the default NextBatch() once NextRow() has returned false, so that
+  // NextRow() is not called again.
+  bool end_of_rows_ = false;
 };
 
 // Represents a restriction of values needed by a scan for a particular
@@ -182,6 +282,9 @@ class ColumnFilter {
     kRange,
     // Represents a list of non-NULL/non-NaN values.
     kInList,
+    // Represents a superset of a set of non-NULL/non-NaN values, as a
+    // ValueBloomFilter. Rows are kept if the filter may contain their value.
+    kBloomFilter,
     // Switches must have a default case to allow us to add more kinds of
     // ValueFilters to the API.
     __Kind__switches_must_have_a_default
@@ -200,6 +303,10 @@ class ColumnFilter {
   explicit ColumnFilter(absl::Span<const Value> in_list)
       : kind_(kInList), values_(in_list.begin(), in_list.end()) {}
 
+  // Constructs a kBloomFilter ColumnFilter. 'bloom_filter' must not be null.
+  explicit ColumnFilter(std::shared_ptr<const ValueBloomFilter> bloom_filter)
+      : kind_(kBloomFilter), bloom_filter_(std::move(bloom_filter)) {}
+
   const Kind kind() const { return kind_; }
 
   // Returns the range boundaries of this filter. 'kind()' must be kRange. The
@@ -212,11 +319,79 @@ class ColumnFilter {
   // elements of this list are NULL or NaN.
   const std::vector<Value>& in_list() const { return values_; }
 
+  // Returns the Bloom filter of this filter, which must have 'kind()'
+  // kBloomFilter. Values of the column's type that it does not contain can
+  // be skipped.
+  const ValueBloomFilter& bloom_filter() const { return *bloom_filter_; }
+
  private:
   Kind kind_;
   // If 'kind_ == kRange', this has two elements, the lower bound and the upper
   // bound.
   std::vector<Value> values_;
+  // Set if 'kind_ == kBloomFilter'.
+  std::shared_ptr<const ValueBloomFilter> bloom_filter_;
+};
+
+// Information pushed down from the query into a scan through
+// EvaluatorTableIterator::SetScanPushdown(). Column numbers are indexes of
+// columns in the scan (not the Table).
+struct ScanPushdown {
+  struct SortKey {
+    int column = 0;
+    bool descending = false;
+  };
+
+  // Returns true if the values of column 'column' are read.
+  bool IsColumnRequired(int column) const {
+    if (!required_columns.has_value()) return true;
+    return std::binary_search(required_columns->begin(),
+                              required_columns->end(), column);
+  }
+
+  // If set, the columns whose values are read, in increasing order. For
+  // other columns, GetValue() and NextBatch() may return NULL instead of
+  // reading the real value. May be empty, e.g. for SELECT COUNT(*).
+  absl::optional<std::vector<int>> required_columns;
+
+  // If set, no more than this many rows will be read, so the iterator need not
+  // fetch or prepare more than that. The iterator must still return rows
+  // until then, since the evaluator re-applies all filters.
+  absl::optional<int64_t> limit;
+
+  // The order in which the rows are needed, most significant key first.
+  // Ordering is in the sense of Value::SqlLessThan(), with NULLs first in
+  // ascending order. Empty if the order does not matter.
+  std::vector<SortKey> order_by;
+
+  // Filters that must all hold for a row to affect the result, so rows that
+  // fail any of them may be skipped. Unlike the filter map in
+  // SetColumnFilterMap(), a column may have several filters here, e.g. both
+  // a range and an IN list. The evaluator re-applies all of them.
+  std::vector<std::pair<int, ColumnFilter>> filters;
+};
+
+// A TABLESAMPLE of the rows of a scan, passed to
+// EvaluatorTableIterator::SetSample().
+struct TableSample {
+  enum Method {
+    // Each row is kept with probability 'percent' / 100.
+    kBernoulli,
+    // Each block of rows, as the storage defines blocks, is kept with
+    // probability 'percent' / 100.
+    kSystem,
+    // A uniform sample of 'rows' rows, or all rows if there are fewer.
+    kReservoir,
+  };
+
+  Method method = kBernoulli;
+  // For kBernoulli and kSystem, in [0, 100].
+  double percent = 0;
+  // For kReservoir, non-negative.
+  int64_t rows = 0;
+  // The REPEATABLE argument, if any. The same seed on the same contents
+  // must give the same sample.
+  absl::optional<int64_t> seed;
 };
 
 }  // namespace zetasql
@@ -0,0 +1,112 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/evaluator_table_iterator.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/public/value_batch.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+
+namespace zetasql {
+
+// Returns rows (i, "row_i") for i in [0, num_rows).
+class TestIterator : public EvaluatorTableIterator {
+ public:
+  explicit TestIterator(int num_rows) : num_rows_(num_rows) {}
+
+  int NumColumns() const override { return 2; }
+  std::string GetColumnName(int i) const override {
+    return i == 0 ? "key" : "value";
+  }
+  const Type* GetColumnType(int i) const override {
+    return i == 0 ? types::Int64Type() : types::StringType();
+  }
+
+  bool NextRow() override {
+    // NextRow() must not be called again after returning false.
+    EXPECT_LE(next_row_, num_rows_);
+    if (next_row_ == num_rows_) {
+      ++next_row_;
+      return false;
+    }
+    values_ = {Value::Int64(next_row_),
+               Value::String(absl::StrCat("row_", next_row_))};
+    ++next_row_;
+    return true;
+  }
+  const Value& GetValue(int i) const override { return values_[i]; }
+  zetasql_base::Status Status() const override { return zetasql_base::OkStatus(); }
+  zetasql_base::Status Cancel() override { return zetasql_base::OkStatus(); }
+
+ private:
+  const int num_rows_;
+  int next_row_ = 0;
+  std::vector<Value> values_;
+};
+
+TEST(EvaluatorTableIteratorTest, DefaultNextBatch) {
+  TestIterator iterator(/*num_rows=*/5);
+  // The batch is reset to the iterator's columns.
+  ValueBatch batch({types::BoolType()});
+  std::vector<int> batch_sizes;
+  int64_t next_key = 0;
+  while (iterator.NextBatch(/*max_rows=*/2, &batch)) {
+    ASSERT_EQ(2, batch.num_columns());
+    batch_sizes.push_back(batch.num_rows());
+    for (int row = 0; row < batch.num_rows(); ++row) {
+      EXPECT_EQ(next_key, batch.column(0).int64_data()[row]);
+      EXPECT_EQ(absl::StrCat("row_", next_key),
+                batch.column(1).GetStringView(row));
+      ++next_key;
+    }
+  }
+  ZETASQL_EXPECT_OK(iterator.Status());
+  EXPECT_THAT(batch_sizes, testing::ElementsAre(2, 2, 1));
+  EXPECT_EQ(0, batch.num_rows());
+  // Calling it again after the end is fine.
+  EXPECT_FALSE(iterator.NextBatch(/*max_rows=*/2, &batch));
+}
+
+TEST(EvaluatorTableIteratorTest, ScanPushdown) {
+  ScanPushdown pushdown;
+  EXPECT_TRUE(pushdown.IsColumnRequired(1));
+  pushdown.required_columns = std::vector<int>{0, 3};
+  EXPECT_TRUE(pushdown.IsColumnRequired(0));
+  EXPECT_FALSE(pushdown.IsColumnRequired(1));
+  EXPECT_TRUE(pushdown.IsColumnRequired(3));
+  pushdown.limit = 10;
+  pushdown.order_by.push_back({/*column=*/0, /*descending=*/true});
+  pushdown.filters.emplace_back(
+      0, ColumnFilter(Value::Int64(1), Value::Int64(5)));
+  pushdown.filters.emplace_back(
+      0, ColumnFilter(std::vector<Value>{Value::Int64(2)}));
+
+  // By default the pushdown is ignored and the rows are not ordered.
+  TestIterator iterator(/*num_rows=*/1);
+  bool rows_ordered = true;
+  ZETASQL_EXPECT_OK(iterator.SetScanPushdown(pushdown, &rows_ordered));
+  EXPECT_FALSE(rows_ordered);
+}
+
+}  // namespace zetasql
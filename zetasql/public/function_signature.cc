@@ -16,7 +16,10 @@
 
 #include "zetasql/public/function_signature.h"
 
+#include <algorithm>
 #include <set>
+#include <string>
+#include <tuple>
 
 #include "zetasql/common/errors.h"
 #include "zetasql/proto/function.pb.h"
@@ -27,11 +30,14 @@
 #include "zetasql/public/strings.h"
 #include "zetasql/public/table_valued_function.h"
 #include "zetasql/resolved_ast/serialization.pb.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/hash/hash.h"
 #include "absl/memory/memory.h"
 #include "zetasql/base/case.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/optional.h"
 #include "zetasql/base/map_util.h"
 #include "zetasql/base/canonical_errors.h"
@@ -42,6 +48,53 @@
 
 namespace zetasql {
 
+namespace {
+
+// A process-wide pool of immutable objects, keyed by strings that identify
+// their contents, which hands out the same object for equal keys while it
+// is in use.  The pool does not keep objects alive; entries of released
+// objects are dropped as it grows.
+template <class T>
+class InternPool {
+ public:
+  // Returns the object for <key>, calling <make> to create it if there is
+  // none in use.
+  template <class MakeFunction>
+  std::shared_ptr<const T> Intern(const std::string& key,
+                                  const MakeFunction& make) {
+    absl::MutexLock l(&mutex_);
+    std::weak_ptr<const T>& entry = entries_[key];
+    std::shared_ptr<const T> object = entry.lock();
+    if (object != nullptr) {
+      return object;
+    }
+    object = make();
+    entry = object;
+    if (entries_.size() >= sweep_size_) {
+      for (auto it = entries_.begin(); it != entries_.end();) {
+        if (it->second.expired()) {
+          entries_.erase(it++);
+        } else {
+          ++it;
+        }
+      }
+      sweep_size_ = std::max<size_t>(kMinSweepSize, 2 * entries_.size());
+    }
+    return object;
+  }
+
+ private:
+  static constexpr size_t kMinSweepSize = 1024;
+
+  absl::Mutex mutex_;
+  absl::flat_hash_map<std::string, std::weak_ptr<const T>> entries_
+      GUARDED_BY(mutex_);
+  // The size at which to drop the entries of released objects.
+  size_t sweep_size_ GUARDED_BY(mutex_) = kMinSweepSize;
+};
+
+}  // namespace
+
 FunctionArgumentTypeOptions::FunctionArgumentTypeOptions(
     const TVFRelation& relation_input_schema,
     bool extra_relation_input_columns_allowed)
@@ -299,6 +352,32 @@ FunctionArgumentType::SimpleOptions(ArgumentCardinality cardinality) {
   }
 }
 
+std::shared_ptr<const FunctionArgumentTypeOptions>
+FunctionArgumentType::InternOptions(
+    const FunctionArgumentTypeOptions& options) {
+  // Relation schemas are compared by identity and parse locations differ
+  // for every argument, so such options are not worth interning.
+  if (options.has_relation_input_schema() ||
+      options.argument_name_parse_location().has_value() ||
+      options.argument_type_parse_location().has_value()) {
+    return std::make_shared<FunctionArgumentTypeOptions>(options);
+  }
+  static auto* pool = new InternPool<FunctionArgumentTypeOptions>();
+  // The argument name is last, so that distinct options have distinct keys.
+  const std::string key = absl::StrCat(
+      options.cardinality(), ",", options.must_be_constant(),
+      options.must_be_non_null(), options.is_not_aggregate(),
+      options.must_support_equality(), options.must_support_ordering(),
+      options.must_support_grouping(), ",", options.has_min_value(), ",",
+      options.min_value(), ",", options.has_max_value(), ",",
+      options.max_value(), ",", options.extra_relation_input_columns_allowed(),
+      ",", options.procedure_argument_mode(), ",",
+      options.has_argument_name() ? options.argument_name() : "");
+  return pool->Intern(key, [&options]() {
+    return std::make_shared<const FunctionArgumentTypeOptions>(options);
+  });
+}
+
 FunctionArgumentType::FunctionArgumentType(
     SignatureArgumentKind kind, const Type* type,
     std::shared_ptr<const FunctionArgumentTypeOptions> options,
@@ -319,10 +398,8 @@ FunctionArgumentType::FunctionArgumentType(SignatureArgumentKind kind,
 FunctionArgumentType::FunctionArgumentType(
     SignatureArgumentKind kind, const FunctionArgumentTypeOptions& options,
     int num_occurrences)
-    : FunctionArgumentType(
-          kind, /*type=*/nullptr,
-          std::make_shared<FunctionArgumentTypeOptions>(options),
-          num_occurrences) {}
+    : FunctionArgumentType(kind, /*type=*/nullptr, InternOptions(options),
+                           num_occurrences) {}
 
 FunctionArgumentType::FunctionArgumentType(SignatureArgumentKind kind,
                                            int num_occurrences)
@@ -338,10 +415,8 @@ FunctionArgumentType::FunctionArgumentType(const Type* type,
 FunctionArgumentType::FunctionArgumentType(
     const Type* type, const FunctionArgumentTypeOptions& options,
     int num_occurrences)
-    : FunctionArgumentType(
-          ARG_TYPE_FIXED, type,
-          std::make_shared<FunctionArgumentTypeOptions>(options),
-          num_occurrences) {}
+    : FunctionArgumentType(ARG_TYPE_FIXED, type, InternOptions(options),
+                           num_occurrences) {}
 
 FunctionArgumentType::FunctionArgumentType(const Type* type,
                                            int num_occurrences)
@@ -479,12 +554,10 @@ std::string FunctionArgumentType::GetSQLDeclaration(ProductMode product_mode) co
 FunctionSignature::FunctionSignature(const FunctionArgumentType& result_type,
                                      const FunctionArgumentTypeList& arguments,
                                      void* context_ptr)
-    : arguments_(arguments), result_type_(result_type),
-      num_repeated_arguments_(ComputeNumRepeatedArguments()),
-      num_optional_arguments_(ComputeNumOptionalArguments()),
+    : arguments_(GetArgumentList(arguments)), result_type_(result_type),
       context_ptr_(context_ptr), options_(FunctionSignatureOptions()) {
   ZETASQL_DCHECK_OK(IsValid());
-  ComputeConcreteArgumentTypes();
+  is_concrete_ = ComputeIsConcrete();
 }
 
 FunctionSignature::FunctionSignature(const FunctionArgumentType& result_type,
@@ -497,14 +570,12 @@ FunctionSignature::FunctionSignature(const FunctionArgumentType& result_type,
                                      const FunctionArgumentTypeList& arguments,
                                      int64_t context_id,
                                      const FunctionSignatureOptions& options)
-    : arguments_(arguments),
+    : arguments_(GetArgumentList(arguments)),
       result_type_(result_type),
-      num_repeated_arguments_(ComputeNumRepeatedArguments()),
-      num_optional_arguments_(ComputeNumOptionalArguments()),
       context_id_(context_id),
       options_(options) {
   ZETASQL_DCHECK_OK(IsValid());
-  ComputeConcreteArgumentTypes();
+  is_concrete_ = ComputeIsConcrete();
 }
 
 zetasql_base::Status FunctionSignature::Deserialize(
@@ -569,17 +640,18 @@ bool FunctionSignature::HasUnsupportedType(
   return false;
 }
 
-void FunctionSignature::ComputeConcreteArgumentTypes() {
-  // TODO: Do we really care if the result signature is concrete?
-  is_concrete_ = ComputeIsConcrete();
-  if (!HasConcreteArguments()) return;
+namespace {
 
+// Returns the concrete arguments of a signature with <arguments>, with the
+// repeated and optional ones expanded.
+FunctionArgumentTypeList ComputeConcreteArguments(
+    const FunctionArgumentTypeList& arguments) {
   // Count number of concrete args, and find the range of repeateds.
   int first_repeated_idx = -1;
   int last_repeated_idx = -1;
   int num_concrete_args = 0;
-  for (int idx = 0; idx < arguments_.size(); ++idx) {
-    const FunctionArgumentType& arg = arguments_[idx];
+  for (int idx = 0; idx < arguments.size(); ++idx) {
+    const FunctionArgumentType& arg = arguments[idx];
     if (arg.repeated()) {
       if (first_repeated_idx == -1) first_repeated_idx = idx;
       last_repeated_idx = idx;
@@ -589,53 +661,115 @@ void FunctionSignature::ComputeConcreteArgumentTypes() {
     }
   }
 
-  concrete_arguments_.reserve(num_concrete_args);
+  FunctionArgumentTypeList concrete_arguments;
+  concrete_arguments.reserve(num_concrete_args);
 
   if (first_repeated_idx == -1) {
     // If we have no repeateds, just loop through and copy present args.
-    for (int idx = 0; idx < arguments_.size(); ++idx) {
-      const FunctionArgumentType& arg = arguments_[idx];
+    for (int idx = 0; idx < arguments.size(); ++idx) {
+      const FunctionArgumentType& arg = arguments[idx];
       if (arg.num_occurrences() == 1) {
-        concrete_arguments_.push_back(arg);
+        concrete_arguments.push_back(arg);
       }
     }
   } else {
     // Add arguments that come before repeated arguments.
     for (int idx = 0; idx < first_repeated_idx; ++idx) {
-      const FunctionArgumentType& arg = arguments_[idx];
+      const FunctionArgumentType& arg = arguments[idx];
       if (arg.num_occurrences() == 1) {
-        concrete_arguments_.push_back(arg);
+        concrete_arguments.push_back(arg);
       }
     }
 
     // Add concrete repetitions of all repeated arguments.
     const int num_repeated_occurrences =
-        arguments_[first_repeated_idx].num_occurrences();
+        arguments[first_repeated_idx].num_occurrences();
     for (int c = 0; c < num_repeated_occurrences; ++c) {
       for (int idx = first_repeated_idx; idx <= last_repeated_idx; ++idx) {
-        concrete_arguments_.push_back(arguments_[idx]);
+        concrete_arguments.push_back(arguments[idx]);
       }
     }
 
     // Add any arguments that come after the repeated arguments.
-    for (int idx = last_repeated_idx + 1; idx < arguments_.size(); ++idx) {
-      const FunctionArgumentType& arg = arguments_[idx];
+    for (int idx = last_repeated_idx + 1; idx < arguments.size(); ++idx) {
+      const FunctionArgumentType& arg = arguments[idx];
       if (arg.num_occurrences() == 1) {
-        concrete_arguments_.push_back(arg);
+        concrete_arguments.push_back(arg);
       }
     }
   }
+  return concrete_arguments;
 }
 
-bool FunctionSignature::HasConcreteArguments() const {
-  if (is_concrete_) {
-    return true;
-  }
-  for (const FunctionArgumentType& argument : arguments_) {
+}  // namespace
+
+std::shared_ptr<const FunctionSignature::ArgumentList>
+FunctionSignature::GetArgumentList(const FunctionArgumentTypeList& arguments) {
+  // Options are interned, so their identity stands for their contents.
+  size_t hash = arguments.size();
+  bool concrete = false;
+  for (const FunctionArgumentType& argument : arguments) {
+    hash = absl::Hash<std::tuple<size_t, int, const Type*, const void*, int>>()(
+        std::make_tuple(hash, argument.kind(), argument.type(),
+                        &argument.options(), argument.num_occurrences()));
+    concrete |= argument.num_occurrences() >= 0;
+  }
+  const auto make = [&arguments, hash]() {
+    auto list = std::make_shared<ArgumentList>();
+    list->arguments = arguments;
     // Missing templated arguments may have unknown types in a concrete
     // signature if they are omitted in a function call.
-    if (argument.num_occurrences() > 0 &&
-        !argument.IsConcrete()) {
+    list->has_concrete_arguments = std::none_of(
+        arguments.begin(), arguments.end(),
+        [](const FunctionArgumentType& argument) {
+          return argument.num_occurrences() > 0 && !argument.IsConcrete();
+        });
+    if (list->has_concrete_arguments) {
+      list->concrete_arguments = ComputeConcreteArguments(arguments);
+    }
+    int first_repeated = -1;
+    int last_repeated = -1;
+    for (int idx = 0; idx < arguments.size(); ++idx) {
+      if (arguments[idx].repeated()) {
+        if (first_repeated == -1) first_repeated = idx;
+        last_repeated = idx;
+      }
+    }
+    list->num_repeated_arguments =
+        first_repeated == -1 ? 0 : last_repeated - first_repeated + 1;
+    int idx = arguments.size();
+    while (idx - 1 >= 0 && arguments[idx - 1].optional()) {
+      --idx;
+    }
+    list->num_optional_arguments = arguments.size() - idx;
+    list->hash = hash;
+    return std::shared_ptr<const ArgumentList>(std::move(list));
+  };
+  // Concrete arguments are mostly made for one call during analysis, and
+  // are not worth a lookup in the pool.
+  if (concrete) {
+    return make();
+  }
+  static auto* pool = new InternPool<ArgumentList>();
+  std::string key;
+  for (const FunctionArgumentType& argument : arguments) {
+    absl::StrAppend(&key, argument.kind(), ",", absl::Hex(argument.type()),
+                    ",", absl::Hex(&argument.options()), ";");
+  }
+  return pool->Intern(key, make);
+}
+
+bool FunctionSignature::HasIdenticalArguments(
+    const FunctionSignature& other) const {
+  if (arguments_ == other.arguments_) {
+    return true;
+  }
+  if (arguments_->hash != other.arguments_->hash ||
+      arguments().size() != other.arguments().size()) {
+    return false;
+  }
+  for (int i = 0; i < arguments().size(); ++i) {
+    if (!argument(i).IsIdenticalTo(other.argument(i))) {
       return false;
     }
   }
@@ -666,7 +800,7 @@ std::string FunctionSignature::DebugString(const std::string& function_name,
                                       bool verbose) const {
   std::string result = absl::StrCat(function_name, "(");
   int first = true;
-  for (const FunctionArgumentType& argument : arguments_) {
+  for (const FunctionArgumentType& argument : arguments()) {
     absl::StrAppend(&result, (first ? "" : ", "),
                     argument.DebugString(verbose));
     first = false;
@@ -696,19 +830,19 @@ std::string FunctionSignature::SignaturesToString(
 std::string FunctionSignature::GetSQLDeclaration(
     const std::vector<std::string>& argument_names, ProductMode product_mode) const {
   std::string out = "(";
-  for (int i = 0; i < arguments_.size(); ++i) {
+  for (int i = 0; i < arguments().size(); ++i) {
     if (i > 0) out += ", ";
-    if (arguments_[i].options().procedure_argument_mode() !=
+    if (arguments()[i].options().procedure_argument_mode() !=
         FunctionEnums::NOT_SET) {
       absl::StrAppend(&out,
                       FunctionEnums::ProcedureArgumentMode_Name(
-                          arguments_[i].options().procedure_argument_mode()),
+                          arguments()[i].options().procedure_argument_mode()),
                       " ");
     }
     if (argument_names.size() > i) {
       absl::StrAppend(&out, ToIdentifierLiteral(argument_names[i]), " ");
     }
-    absl::StrAppend(&out, arguments_[i].GetSQLDeclaration(product_mode));
+    absl::StrAppend(&out, arguments()[i].GetSQLDeclaration(product_mode));
   }
   absl::StrAppend(&out, ")");
   if (!result_type_.IsVoid() &&
@@ -754,7 +888,7 @@ zetasql_base::Status FunctionSignature::IsValid() const {
       result_type_.kind() != ARG_TYPE_ARBITRARY &&
       !result_type_.IsRelation()) {
     bool result_type_matches_an_argument_type = false;
-    for (const auto& arg : arguments_) {
+    for (const auto& arg : arguments()) {
       if (result_type_.TemplatedKindIsRelated(arg.kind())) {
         result_type_matches_an_argument_type = true;
         break;
@@ -771,7 +905,7 @@ zetasql_base::Status FunctionSignature::IsValid() const {
   bool saw_optional = false;
   bool after_repeated_block = false;
   bool in_repeated_block = false;
-  for (const FunctionArgumentType& arg : arguments_) {
+  for (const FunctionArgumentType& arg : arguments()) {
     ZETASQL_RETURN_IF_ERROR(arg.IsValid());
     if (arg.IsVoid()) {
       return MakeSqlError() << "Arguments cannot have type VOID: "
@@ -799,9 +933,9 @@ zetasql_base::Status FunctionSignature::IsValid() const {
   if (first_repeated >= 0) {
     const int last_repeated = LastRepeatedArgumentIndex();
     const int repeated_occurrences =
-        arguments_[first_repeated].num_occurrences();
+        arguments()[first_repeated].num_occurrences();
     for (int i = first_repeated + 1; i <= last_repeated; ++i) {
-      if (arguments_[i].num_occurrences() != repeated_occurrences) {
+      if (arguments()[i].num_occurrences() != repeated_occurrences) {
         return MakeSqlError()
                << "Repeated arguments must have the same num_occurrences: "
                << DebugString();
@@ -889,8 +1023,8 @@ zetasql_base::Status FunctionSignature::IsValidForProcedure() const {
 }
 
 int FunctionSignature::FirstRepeatedArgumentIndex() const {
-  for (int idx = 0; idx < arguments_.size(); ++idx) {
-    if (arguments_[idx].repeated()) {
+  for (int idx = 0; idx < arguments().size(); ++idx) {
+    if (arguments()[idx].repeated()) {
       return idx;
     }
   }
@@ -898,8 +1032,8 @@ int FunctionSignature::FirstRepeatedArgumentIndex() const {
 }
 
 int FunctionSignature::LastRepeatedArgumentIndex() const {
-  for (int idx = arguments_.size() - 1; idx >= 0; --idx) {
-    if (arguments_[idx].repeated()) {
+  for (int idx = arguments().size() - 1; idx >= 0; --idx) {
+    if (arguments()[idx].repeated()) {
       return idx;
     }
   }
@@ -907,22 +1041,7 @@ int FunctionSignature::LastRepeatedArgumentIndex() const {
 }
 
 int FunctionSignature::NumRequiredArguments() const {
-  return arguments_.size() - NumRepeatedArguments() - NumOptionalArguments();
-}
-
-int FunctionSignature::ComputeNumRepeatedArguments() const {
-  if (FirstRepeatedArgumentIndex() == -1) {
-    return 0;
-  }
-  return LastRepeatedArgumentIndex() - FirstRepeatedArgumentIndex() + 1;
-}
-
-int FunctionSignature::ComputeNumOptionalArguments() const {
-  int idx = arguments_.size();
-  while (idx - 1 >= 0 && arguments_[idx - 1].optional()) {
-    --idx;
-  }
-  return arguments_.size() - idx;
+  return arguments().size() - NumRepeatedArguments() - NumOptionalArguments();
 }
 
 void FunctionSignature::SetConcreteResultType(const Type* type) {
@@ -385,6 +385,25 @@ class FunctionArgumentType {
   void IncrementNumOccurrences() { ++num_occurrences_; }
   void set_num_occurrences(int num) { num_occurrences_ = num; }
 
+  // Returns a concrete copy of this argument with <num_occurrences> that
+  // shares its options, of fixed type <type>, or of the same relation or
+  // model kind if <type> is NULL.
+  FunctionArgumentType MakeConcrete(const Type* type,
+                                    int num_occurrences) const {
+    return FunctionArgumentType(type == nullptr ? kind_ : ARG_TYPE_FIXED, type,
+                                options_, num_occurrences);
+  }
+
+  // Returns true if this argument and <other> have the same kind, type,
+  // options and number of occurrences.  Options are equal only if they are
+  // the same object, which they are for equal options without a relation
+  // schema or parse locations, since those are interned.
+  bool IsIdenticalTo(const FunctionArgumentType& other) const {
+    return kind_ == other.kind_ && type_ == other.type_ &&
+           options_ == other.options_ &&
+           num_occurrences_ == other.num_occurrences_;
+  }
+
   // Returns NULL if kind_ is not ARG_TYPE_FIXED.
   const Type* type() const { return type_; }
 
@@ -448,6 +467,12 @@ class FunctionArgumentType {
   static std::shared_ptr<const FunctionArgumentTypeOptions> SimpleOptions(
       ArgumentCardinality cardinality = FunctionEnums::REQUIRED);
 
+  // Returns options equal to <options>, shared with all other arguments
+  // that have equal options unless they have a relation schema or parse
+  // locations.  Thousands of builtin arguments have the same few options.
+  static std::shared_ptr<const FunctionArgumentTypeOptions> InternOptions(
+      const FunctionArgumentTypeOptions& options);
+
   SignatureArgumentKind kind_;
   const Type* type_;
 
@@ -612,11 +637,11 @@ class FunctionSignature {
       FunctionSignatureProto* proto) const;
 
   const FunctionArgumentTypeList& arguments() const {
-    return arguments_;
+    return arguments_->arguments;
   }
 
   const FunctionArgumentType& argument(int idx) const {
-    return arguments_[idx];
+    return arguments_->arguments[idx];
   }
 
   // Returns the number of concrete arguments, with repeated and optional
@@ -624,7 +649,7 @@ class FunctionSignature {
   // Requires: HasConcreteArguments()
   int NumConcreteArguments() const {
     DCHECK(HasConcreteArguments());
-    return concrete_arguments_.size();
+    return arguments_->concrete_arguments.size();
   }
 
   // Returns concrete argument number <concrete_idx>.
@@ -633,7 +658,7 @@ class FunctionSignature {
   // Requires that the signature has concrete arguments.
   const FunctionArgumentType& ConcreteArgument(int concrete_idx) const {
     DCHECK(HasConcreteArguments());
-    return concrete_arguments_[concrete_idx];
+    return arguments_->concrete_arguments[concrete_idx];
   }
 
   // Returns the Type associated with the concrete argument number
@@ -663,7 +688,15 @@ class FunctionSignature {
   bool IsConcrete() const { return is_concrete_; }
 
   // Returns TRUE if all arguments are concrete.
-  bool HasConcreteArguments() const;
+  bool HasConcreteArguments() const {
+    return arguments_->has_concrete_arguments;
+  }
+
+  // Returns true if this signature and <other> have identical arguments, see
+  // FunctionArgumentType::IsIdenticalTo().  Signatures that are not
+  // concrete share their arguments with all others with identical
+  // arguments, so this is usually a pointer comparison.
+  bool HasIdenticalArguments(const FunctionSignature& other) const;
 
   // Determines whether the argument and result types are valid.  Additionally,
   // it requires that all repeated arguments are consecutive, and all optional
@@ -690,8 +723,12 @@ class FunctionSignature {
 
   // Gets the number of required, repeated or optional arguments.
   int NumRequiredArguments() const;
-  int NumRepeatedArguments() const { return num_repeated_arguments_; }
-  int NumOptionalArguments() const { return num_optional_arguments_; }
+  int NumRepeatedArguments() const {
+    return arguments_->num_repeated_arguments;
+  }
+  int NumOptionalArguments() const {
+    return arguments_->num_optional_arguments;
+  }
 
   // Returns whether or not the constraints are satisfied.
   // If <constraints_callback> is NULL, returns true.
@@ -738,7 +775,7 @@ class FunctionSignature {
 
   // Returns true if this function signature contains any templated arguments.
   bool IsTemplated() const {
-    for (const FunctionArgumentType& arg : arguments_) {
+    for (const FunctionArgumentType& arg : arguments()) {
       if (arg.IsTemplated()) {
         return true;
       }
@@ -747,16 +784,35 @@ class FunctionSignature {
   }
 
  private:
-  bool ComputeIsConcrete() const;
-  void ComputeConcreteArgumentTypes();
+  // The arguments of a signature and the properties derived from them,
+  // which never change.  They are shared by the copies of a signature, and
+  // by all signatures with identical arguments that are not concrete, like
+  // those of builtin functions, through a process-wide pool.
+  struct ArgumentList {
+    FunctionArgumentTypeList arguments;
+    // The arguments with the repeated and optional ones expanded, if
+    // <has_concrete_arguments>.  We precompute and materialize the list of
+    // concrete arguments because we end up asking for these repeatedly.
+    // This vector could be large if functions have huge numbers of
+    // arguments, but then we probably have other data structures that are
+    // proportionally large too.
+    bool has_concrete_arguments = false;
+    FunctionArgumentTypeList concrete_arguments;
+    int num_repeated_arguments = 0;
+    int num_optional_arguments = 0;
+    // A hash of the kinds, types, options and occurrences of the arguments.
+    size_t hash = 0;
+  };
+
+  // Returns the ArgumentList of <arguments>, from the pool if they are not
+  // concrete.
+  static std::shared_ptr<const ArgumentList> GetArgumentList(
+      const FunctionArgumentTypeList& arguments);
 
-  int ComputeNumRepeatedArguments() const;
-  int ComputeNumOptionalArguments() const;
+  bool ComputeIsConcrete() const;
 
-  FunctionArgumentTypeList arguments_;
+  std::shared_ptr<const ArgumentList> arguments_;
   FunctionArgumentType result_type_;
-  int num_repeated_arguments_ = -1;
-  int num_optional_arguments_ = -1;
 
   // This union should hold enough context for the implementation
   // to map a specific function signature back to an evaluator for the
@@ -772,12 +828,7 @@ class FunctionSignature {
   // list of concrete input arguments.
   FunctionSignatureOptions options_;
 
-  // We precompute and materialize the list of concrete arguments because
-  // we end up asking for these repeatedly.  This vector could be large if
-  // functions have huge numbers of arguments, but then we probably have other
-  // data structures that are proportionally large too.
   bool is_concrete_ = false;
-  FunctionArgumentTypeList concrete_arguments_;
 
   friend class FunctionSerializationTests;
   // Copyable.
@@ -930,4 +930,47 @@ TEST(FunctionSignatureTests, TestIsTemplatedSignature) {
   }
 }
 
+TEST(FunctionSignatureTests, TestSharedArguments) {
+  TypeFactory factory;
+  FunctionArgumentTypeOptions options(FunctionArgumentType::OPTIONAL);
+  options.set_argument_name("x");
+  const FunctionArgumentType arg1(factory.get_int64(), options);
+  const FunctionArgumentType arg2(ARG_TYPE_ANY_1, options);
+  // Equal options are shared.
+  EXPECT_EQ(&arg1.options(), &arg2.options());
+  options.set_argument_name("y");
+  const FunctionArgumentType arg3(factory.get_int64(), options);
+  EXPECT_NE(&arg1.options(), &arg3.options());
+
+  // Concrete arguments share the options of their templated arguments.
+  const FunctionArgumentType concrete =
+      arg2.MakeConcrete(factory.get_string(), /*num_occurrences=*/1);
+  EXPECT_EQ(ARG_TYPE_FIXED, concrete.kind());
+  EXPECT_TRUE(concrete.type()->IsString());
+  EXPECT_EQ(1, concrete.num_occurrences());
+  EXPECT_EQ(&arg2.options(), &concrete.options());
+
+  const FunctionArgumentType result(factory.get_bool());
+  const FunctionSignature signature1(result, {arg1, arg2},
+                                     /*context_ptr=*/nullptr);
+  const FunctionSignature signature2(result, {arg1, arg2},
+                                     /*context_ptr=*/nullptr);
+  const FunctionSignature signature3(result, {arg3, arg2},
+                                     /*context_ptr=*/nullptr);
+  EXPECT_EQ(&signature1.arguments(), &signature2.arguments());
+  EXPECT_TRUE(signature1.HasIdenticalArguments(signature2));
+  EXPECT_FALSE(signature1.HasIdenticalArguments(signature3));
+  EXPECT_EQ(2, signature1.NumOptionalArguments());
+
+  // Concrete signatures have their own arguments, which are still identical.
+  const FunctionSignature concrete1(result, {concrete},
+                                    /*context_ptr=*/nullptr);
+  const FunctionSignature concrete2(result, {concrete},
+                                    /*context_ptr=*/nullptr);
+  EXPECT_TRUE(concrete1.HasConcreteArguments());
+  EXPECT_TRUE(concrete1.HasIdenticalArguments(concrete2));
+  EXPECT_EQ(1, concrete1.NumConcreteArguments());
+  EXPECT_TRUE(concrete1.ConcreteArgumentType(0)->IsString());
+}
+
 }  // namespace zetasql
@@ -246,14 +246,15 @@ class FunctionSerializationTests : public ::testing::Test {
   static void ExpectEqualsIgnoringCallbacks(
       const FunctionSignature& signature1,
       const FunctionSignature& signature2) {
-    ExpectEqualsIgnoringCallbacks(signature1.arguments_, signature2.arguments_);
+    ExpectEqualsIgnoringCallbacks(signature1.arguments(),
+                                  signature2.arguments());
     ExpectEqualsIgnoringCallbacks(signature1.result_type_,
                                   signature2.result_type_);
     EXPECT_EQ(signature1.context_id_, signature2.context_id_);
     ExpectEqualsIgnoringCallbacks(signature1.options_, signature2.options_);
     EXPECT_EQ(signature1.is_concrete_, signature2.is_concrete_);
-    ExpectEqualsIgnoringCallbacks(signature1.concrete_arguments_,
-                                  signature2.concrete_arguments_);
+    ExpectEqualsIgnoringCallbacks(signature1.arguments_->concrete_arguments,
+                                  signature2.arguments_->concrete_arguments);
 
     // These will test that all FunctionArgumentTypeOptions get serialized
     // and deserialized correctly.
@@ -0,0 +1,507 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/functions/approx_sketches.h"
+
+#include <limits>
+
+#include "absl/strings/str_cat.h"
+#include "zetasql/base/bits.h"
+#include "zetasql/base/canonical_errors.h"
+
+namespace zetasql {
+namespace functions {
+
+namespace sketch_internal {
+
+void AppendVarint(uint64_t value, std::string* out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+bool ConsumeVarint(absl::string_view* in, uint64_t* value) {
+  *value = 0;
+  for (int shift = 0; shift < 64 && !in->empty(); shift += 7) {
+    const uint8_t byte = static_cast<uint8_t>(in->front());
+    in->remove_prefix(1);
+    *value |= uint64_t{byte & 0x7Fu} << shift;
+    if ((byte & 0x80) == 0) return true;
+  }
+  return false;
+}
+
+zetasql_base::Status CorruptSketchError(absl::string_view name) {
+  return zetasql_base::OutOfRangeError(
+      absl::StrCat("Invalid serialized ", name));
+}
+
+}  // namespace sketch_internal
+
+namespace {
+
+using sketch_internal::AppendVarint;
+using sketch_internal::ConsumeVarint;
+using sketch_internal::CorruptSketchError;
+
+constexpr uint8_t kHllVersion = 1;
+constexpr uint8_t kSpaceSavingVersion = 1;
+constexpr int kRankBits = 6;
+
+uint64_t Mix64(uint64_t h) {
+  // The finalizer of MurmurHash3.
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+// The position of the first 1 bit in the top <bits> bits of <w>, counting
+// from 1, or <bits> + 1 if they are all 0.
+int Rank(uint64_t w, int bits) {
+  const uint64_t top = w | (uint64_t{1} << (63 - bits));
+  return zetasql_base::Bits::CountLeadingZeros64(top) + 1;
+}
+
+uint32_t SparseIndex(uint32_t entry) { return entry >> kRankBits; }
+int SparseRank(uint32_t entry) { return entry & ((1 << kRankBits) - 1); }
+
+// Adds the register of a sparse entry at <sparse_precision> to <registers>
+// at <precision>.
+void AddSparseEntryToDense(uint32_t entry, int precision, int sparse_precision,
+                           std::vector<uint8_t>* registers) {
+  const int extra_bits = sparse_precision - precision;
+  const uint32_t sparse_index = SparseIndex(entry);
+  const uint32_t low = sparse_index & ((uint32_t{1} << extra_bits) - 1);
+  const int rank =
+      low != 0 ? extra_bits - zetasql_base::Bits::Log2Floor64(low)
+               : extra_bits + SparseRank(entry);
+  uint8_t& reg = (*registers)[sparse_index >> extra_bits];
+  reg = std::max<uint8_t>(reg, rank);
+}
+
+double Sigma(double x) {
+  if (x == 1) return std::numeric_limits<double>::infinity();
+  double y = 1;
+  double z = x;
+  double z_prev;
+  do {
+    x *= x;
+    z_prev = z;
+    z += x * y;
+    y += y;
+  } while (z != z_prev);
+  return z;
+}
+
+double Tau(double x) {
+  if (x == 0 || x == 1) return 0;
+  double y = 1;
+  double z = 1 - x;
+  double z_prev;
+  do {
+    x = std::sqrt(x);
+    z_prev = z;
+    y *= 0.5;
+    z -= (1 - x) * (1 - x) * y;
+  } while (z != z_prev);
+  return z / 3;
+}
+
+// The estimator of Ertl, "New cardinality estimation algorithms for
+// HyperLogLog sketches" (2017), from <histogram>[r], the number of the 2^p
+// registers with rank r, for r in [0, 64 - p + 1].
+int64_t EstimateFromHistogram(const std::vector<int64_t>& histogram, int p) {
+  const double m = static_cast<double>(uint64_t{1} << p);
+  if (histogram[0] == m) return 0;
+  const int q = 64 - p;
+  double z = m * Tau(1 - histogram[q + 1] / m);
+  for (int k = q; k >= 1; --k) {
+    z += histogram[k];
+    z *= 0.5;
+  }
+  z += m * Sigma(histogram[0] / m);
+  const double alpha_inf = 0.5 / std::log(2.0);
+  return static_cast<int64_t>(std::llround(alpha_inf * m * m / z));
+}
+
+}  // namespace
+
+uint64_t SketchHashInt64(int64_t value) {
+  return Mix64(static_cast<uint64_t>(value));
+}
+
+uint64_t SketchHashBytes(absl::string_view value) {
+  // MurmurHash64A.
+  constexpr uint64_t kMul = 0xc6a4a7935bd1e995ULL;
+  constexpr int kShift = 47;
+  uint64_t h = 0x9747b28c ^ (value.size() * kMul);
+  absl::string_view rest = value;
+  while (rest.size() >= 8) {
+    uint64_t k;
+    sketch_internal::ConsumeFixed64(&rest, &k);
+    k *= kMul;
+    k ^= k >> kShift;
+    k *= kMul;
+    h ^= k;
+    h *= kMul;
+  }
+  if (!rest.empty()) {
+    for (int i = static_cast<int>(rest.size()) - 1; i >= 0; --i) {
+      h ^= uint64_t{static_cast<uint8_t>(rest[i])} << (8 * i);
+    }
+    h *= kMul;
+  }
+  h ^= h >> kShift;
+  h *= kMul;
+  h ^= h >> kShift;
+  return h;
+}
+
+// ----------------------- HyperLogLogPlusPlus -----------------------
+
+zetasql_base::StatusOr<HyperLogLogPlusPlus> HyperLogLogPlusPlus::Create(
+    int precision, int sparse_precision) {
+  if (precision < kMinPrecision || precision > kMaxPrecision) {
+    return zetasql_base::OutOfRangeError(
+        absl::StrCat("HyperLogLog++ precision must be between ", kMinPrecision,
+                     " and ", kMaxPrecision, ": ", precision));
+  }
+  if (sparse_precision < precision ||
+      sparse_precision > kMaxSparsePrecision) {
+    return zetasql_base::OutOfRangeError(absl::StrCat(
+        "HyperLogLog++ sparse precision must be between the precision and ",
+        kMaxSparsePrecision, ": ", sparse_precision));
+  }
+  return HyperLogLogPlusPlus(precision, sparse_precision);
+}
+
+void HyperLogLogPlusPlus::AddHash(uint64_t hash) {
+  if (!is_sparse()) {
+    const uint8_t rank = Rank(hash << precision_, 64 - precision_);
+    uint8_t& reg = registers_[hash >> (64 - precision_)];
+    reg = std::max(reg, rank);
+    return;
+  }
+  const uint32_t index = static_cast<uint32_t>(hash >> (64 - sparse_precision_));
+  const int rank = Rank(hash << sparse_precision_, 64 - sparse_precision_);
+  sparse_buffer_.push_back(index << kRankBits | rank);
+  // Buffering keeps insertion amortized O(log n) instead of O(n).
+  if (sparse_buffer_.size() >= std::max(16, (1 << precision_) / 16)) {
+    FlushSparseBuffer();
+  }
+}
+
+void HyperLogLogPlusPlus::FlushSparseBuffer() const {
+  if (sparse_buffer_.empty()) return;
+  sparse_.insert(sparse_.end(), sparse_buffer_.begin(), sparse_buffer_.end());
+  sparse_buffer_.clear();
+  // Sorting by entry puts the largest rank of each index last.
+  std::sort(sparse_.begin(), sparse_.end());
+  size_t out = 0;
+  for (size_t i = 0; i < sparse_.size(); ++i) {
+    if (i + 1 < sparse_.size() &&
+        SparseIndex(sparse_[i]) == SparseIndex(sparse_[i + 1])) {
+      continue;
+    }
+    sparse_[out++] = sparse_[i];
+  }
+  sparse_.resize(out);
+  // A sparse entry takes four bytes and a dense register one.
+  if (sparse_.size() > (1 << precision_) / 4) {
+    ConvertToDense();
+  }
+}
+
+void HyperLogLogPlusPlus::ConvertToDense() const {
+  FlushSparseBuffer();
+  if (!is_sparse()) return;
+  registers_.assign(1 << precision_, 0);
+  for (const uint32_t entry : sparse_) {
+    AddSparseEntryToDense(entry, precision_, sparse_precision_, &registers_);
+  }
+  std::vector<uint32_t>().swap(sparse_);
+}
+
+zetasql_base::Status HyperLogLogPlusPlus::Merge(const HyperLogLogPlusPlus& other) {
+  if (precision_ != other.precision_ ||
+      sparse_precision_ != other.sparse_precision_) {
+    return zetasql_base::InvalidArgumentError(absl::StrCat(
+        "Cannot merge HyperLogLog++ sketches with different precisions: (",
+        precision_, ", ", sparse_precision_, ") and (", other.precision_, ", ",
+        other.sparse_precision_, ")"));
+  }
+  if (!other.is_sparse()) {
+    ConvertToDense();
+    for (size_t i = 0; i < registers_.size(); ++i) {
+      registers_[i] = std::max(registers_[i], other.registers_[i]);
+    }
+    return zetasql_base::OkStatus();
+  }
+  other.FlushSparseBuffer();
+  if (!is_sparse()) {
+    for (const uint32_t entry : other.sparse_) {
+      AddSparseEntryToDense(entry, precision_, sparse_precision_, &registers_);
+    }
+    return zetasql_base::OkStatus();
+  }
+  sparse_buffer_.insert(sparse_buffer_.end(), other.sparse_.begin(),
+                        other.sparse_.end());
+  FlushSparseBuffer();
+  return zetasql_base::OkStatus();
+}
+
+int64_t HyperLogLogPlusPlus::Estimate() const {
+  FlushSparseBuffer();
+  if (!is_sparse()) {
+    std::vector<int64_t> histogram(64 - precision_ + 2, 0);
+    for (const uint8_t reg : registers_) {
+      ++histogram[reg];
+    }
+    return EstimateFromHistogram(histogram, precision_);
+  }
+  // The sparse list is a HyperLogLog sketch at the sparse precision whose
+  // registers not in the list are 0.
+  std::vector<int64_t> histogram(64 - sparse_precision_ + 2, 0);
+  histogram[0] = (int64_t{1} << sparse_precision_) - sparse_.size();
+  for (const uint32_t entry : sparse_) {
+    ++histogram[SparseRank(entry)];
+  }
+  return EstimateFromHistogram(histogram, sparse_precision_);
+}
+
+std::string HyperLogLogPlusPlus::Serialize() const {
+  FlushSparseBuffer();
+  std::string out;
+  out.push_back(static_cast<char>(kHllVersion));
+  out.push_back(static_cast<char>(precision_));
+  out.push_back(static_cast<char>(sparse_precision_));
+  out.push_back(is_sparse() ? 0 : 1);
+  if (is_sparse()) {
+    AppendVarint(sparse_.size(), &out);
+    uint32_t previous = 0;
+    for (const uint32_t entry : sparse_) {
+      AppendVarint(entry - previous, &out);
+      previous = entry;
+    }
+  } else {
+    out.append(registers_.begin(), registers_.end());
+  }
+  return out;
+}
+
+zetasql_base::StatusOr<HyperLogLogPlusPlus> HyperLogLogPlusPlus::Deserialize(
+    absl::string_view bytes) {
+  const zetasql_base::Status error = CorruptSketchError("HyperLogLog++ sketch");
+  if (bytes.size() < 4 || bytes[0] != kHllVersion ||
+      static_cast<uint8_t>(bytes[3]) > 1) {
+    return error;
+  }
+  auto created = Create(bytes[1], bytes[2]);
+  if (!created.ok()) return error;
+  HyperLogLogPlusPlus sketch = std::move(created).ValueOrDie();
+  const bool is_sparse = bytes[3] == 0;
+  bytes.remove_prefix(4);
+  if (is_sparse) {
+    uint64_t size;
+    if (!ConsumeVarint(&bytes, &size) || size > bytes.size()) return error;
+    uint64_t entry = 0;
+    for (uint64_t i = 0; i < size; ++i) {
+      uint64_t delta;
+      if (!ConsumeVarint(&bytes, &delta) || (i > 0 && delta == 0)) {
+        return error;
+      }
+      entry += delta;
+      if (entry >> kRankBits >= (uint64_t{1} << sketch.sparse_precision_) ||
+          SparseRank(entry) == 0 ||
+          SparseRank(entry) > 64 - sketch.sparse_precision_ + 1 ||
+          (i > 0 && SparseIndex(entry) == SparseIndex(sketch.sparse_.back()))) {
+        return error;
+      }
+      sketch.sparse_.push_back(static_cast<uint32_t>(entry));
+    }
+    if (!bytes.empty()) return error;
+  } else {
+    if (bytes.size() != (size_t{1} << sketch.precision_)) return error;
+    for (const char reg : bytes) {
+      if (static_cast<uint8_t>(reg) > 64 - sketch.precision_ + 1) return error;
+    }
+    sketch.registers_.assign(bytes.begin(), bytes.end());
+  }
+  return sketch;
+}
+
+// ----------------------- SpaceSavingTopK -----------------------
+
+SpaceSavingTopK& SpaceSavingTopK::operator=(const SpaceSavingTopK& other) {
+  if (this == &other) return *this;
+  capacity_ = other.capacity_;
+  size_ = other.size_;
+  counters_ = other.counters_;
+  by_count_.clear();
+  for (const auto& key_and_counter : counters_) {
+    by_count_.insert(&key_and_counter);
+  }
+  return *this;
+}
+
+int64_t SpaceSavingTopK::MissingCount() const {
+  if (counters_.size() < capacity_) return 0;
+  return (*by_count_.begin())->second.count;
+}
+
+void SpaceSavingTopK::Insert(std::string key, Counter counter) {
+  auto inserted = counters_.emplace(std::move(key), counter);
+  by_count_.insert(&*inserted.first);
+}
+
+void SpaceSavingTopK::Add(absl::string_view key, int64_t weight) {
+  if (weight <= 0) return;
+  size_ += weight;
+  auto it = counters_.find(key);
+  if (it != counters_.end()) {
+    by_count_.erase(&*it);
+    it->second.count += weight;
+    by_count_.insert(&*it);
+    return;
+  }
+  if (counters_.size() < capacity_) {
+    Insert(std::string(key), {weight, 0});
+    return;
+  }
+  // Replace the key with the smallest count, whose count the new key may
+  // have had.
+  const auto* min = *by_count_.begin();
+  const int64_t min_count = min->second.count;
+  by_count_.erase(by_count_.begin());
+  counters_.erase(counters_.find(min->first));
+  Insert(std::string(key), {min_count + weight, min_count});
+}
+
+void SpaceSavingTopK::Merge(const SpaceSavingTopK& other) {
+  // A key missing from a full summary may have had up to its smallest count.
+  const int64_t missing = MissingCount();
+  const int64_t other_missing = other.MissingCount();
+  std::vector<Entry> entries;
+  for (const auto& key_and_counter : counters_) {
+    Entry entry{key_and_counter.first, key_and_counter.second.count,
+                key_and_counter.second.error};
+    auto it = other.counters_.find(entry.key);
+    if (it != other.counters_.end()) {
+      entry.count += it->second.count;
+      entry.error += it->second.error;
+    } else {
+      entry.count += other_missing;
+      entry.error += other_missing;
+    }
+    entries.push_back(std::move(entry));
+  }
+  for (const auto& key_and_counter : other.counters_) {
+    if (counters_.contains(key_and_counter.first)) continue;
+    entries.push_back({key_and_counter.first,
+                       key_and_counter.second.count + missing,
+                       key_and_counter.second.error + missing});
+  }
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry& a, const Entry& b) {
+              if (a.count != b.count) return a.count > b.count;
+              return a.key < b.key;
+            });
+  if (entries.size() > capacity_) {
+    entries.resize(capacity_);
+  }
+  by_count_.clear();
+  counters_.clear();
+  for (Entry& entry : entries) {
+    Insert(std::move(entry.key), {entry.count, entry.error});
+  }
+  size_ += other.size_;
+}
+
+std::vector<SpaceSavingTopK::Entry> SpaceSavingTopK::TopK(int64_t k) const {
+  std::vector<Entry> entries;
+  for (const auto& key_and_counter : counters_) {
+    entries.push_back({key_and_counter.first, key_and_counter.second.count,
+                       key_and_counter.second.error});
+  }
+  std::sort(entries.begin(), entries.end(),
+                   [](const Entry& a, const Entry& b) {
+                     if (a.count != b.count) return a.count > b.count;
+                     return a.key < b.key;
+                   });
+  if (k >= 0 && entries.size() > k) {
+    entries.resize(k);
+  }
+  return entries;
+}
+
+std::string SpaceSavingTopK::Serialize() const {
+  std::string out;
+  out.push_back(static_cast<char>(kSpaceSavingVersion));
+  AppendVarint(capacity_, &out);
+  AppendVarint(size_, &out);
+  AppendVarint(counters_.size(), &out);
+  // In a fixed order, so that equal summaries serialize the same way.
+  for (const auto* key_and_counter : by_count_) {
+    AppendVarint(key_and_counter->first.size(), &out);
+    out.append(key_and_counter->first);
+    AppendVarint(key_and_counter->second.count, &out);
+    AppendVarint(key_and_counter->second.error, &out);
+  }
+  return out;
+}
+
+zetasql_base::StatusOr<SpaceSavingTopK> SpaceSavingTopK::Deserialize(
+    absl::string_view bytes) {
+  const zetasql_base::Status error = CorruptSketchError("top-k summary");
+  if (bytes.empty() || bytes[0] != kSpaceSavingVersion) return error;
+  bytes.remove_prefix(1);
+  constexpr uint64_t kMaxCount = std::numeric_limits<int64_t>::max();
+  uint64_t capacity, size, num_counters;
+  if (!ConsumeVarint(&bytes, &capacity) || !ConsumeVarint(&bytes, &size) ||
+      !ConsumeVarint(&bytes, &num_counters) || capacity == 0 ||
+      capacity > kMaxCount || size > kMaxCount || num_counters > capacity ||
+      num_counters > bytes.size()) {
+    return error;
+  }
+  SpaceSavingTopK summary(capacity);
+  summary.size_ = size;
+  for (uint64_t i = 0; i < num_counters; ++i) {
+    uint64_t key_size, count, counter_error;
+    if (!ConsumeVarint(&bytes, &key_size) || key_size > bytes.size()) {
+      return error;
+    }
+    std::string key(bytes.substr(0, key_size));
+    bytes.remove_prefix(key_size);
+    if (!ConsumeVarint(&bytes, &count) ||
+        !ConsumeVarint(&bytes, &counter_error) || count == 0 ||
+        count > size || counter_error >= count ||
+        summary.counters_.contains(key)) {
+      return error;
+    }
+    summary.Insert(std::move(key), {static_cast<int64_t>(count),
+                                    static_cast<int64_t>(counter_error)});
+  }
+  if (!bytes.empty()) return error;
+  return summary;
+}
+
+}  // namespace functions
+}  // namespace zetasql
@@ -0,0 +1,481 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Aggregate states for APPROX_COUNT_DISTINCT, APPROX_QUANTILES and
+// APPROX_TOP_COUNT. Each takes bounded memory, can be merged with others of
+// the same kind, and serializes to a BYTES value, so partial aggregates
+// computed on different machines can be combined.
+//
+//   HyperLogLogPlusPlus  Distinct counts of 64-bit hashes of the values, with
+//                        a sparse representation for small counts.
+//   KllQuantileSketch    Approximate quantiles of numeric values.
+//   SpaceSavingTopK      The most frequent keys and their approximate counts.
+//
+// Serialized states include a version byte and are checked when they are
+// deserialized, so corrupt or foreign bytes give an error rather than a
+// crash. None of the classes is thread-safe.
+
+#ifndef ZETASQL_PUBLIC_FUNCTIONS_APPROX_SKETCHES_H_
+#define ZETASQL_PUBLIC_FUNCTIONS_APPROX_SKETCHES_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/container/node_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "zetasql/base/status.h"
+#include "zetasql/base/statusor.h"
+
+namespace zetasql {
+namespace functions {
+
+// Hashes for HyperLogLogPlusPlus that, unlike absl::Hash and the hashes of
+// value_hash.h, are the same in every binary, so that sketches built by
+// different processes can be merged. SketchHashInt64() is a bijection, and
+// SketchHashBytes() is MurmurHash64A.
+uint64_t SketchHashInt64(int64_t value);
+uint64_t SketchHashBytes(absl::string_view value);
+
+// A HyperLogLog++ sketch of a set of 64-bit hashes. Small sets are kept as a
+// sorted list of registers at <sparse_precision>, which is converted to
+// 2^<precision> one-byte registers once it would be larger. Estimates use
+// the improved estimator of Ertl (2017), which needs no bias correction
+// tables; the standard error is about 1.04 / sqrt(2^precision).
+class HyperLogLogPlusPlus {
+ public:
+  static constexpr int kMinPrecision = 10;
+  static constexpr int kMaxPrecision = 24;
+  static constexpr int kMaxSparsePrecision = 25;
+  static constexpr int kDefaultPrecision = 15;
+  static constexpr int kDefaultSparsePrecision = 20;
+
+  HyperLogLogPlusPlus()
+      : HyperLogLogPlusPlus(kDefaultPrecision, kDefaultSparsePrecision) {}
+
+  // Returns an empty sketch. Requires kMinPrecision <= <precision> <=
+  // kMaxPrecision and <precision> <= <sparse_precision> <=
+  // kMaxSparsePrecision.
+  static zetasql_base::StatusOr<HyperLogLogPlusPlus> Create(int precision,
+                                                    int sparse_precision);
+
+  // Adds a hash such as SketchHashInt64() of a value.
+  void AddHash(uint64_t hash);
+
+  // Adds the hashes of <other>, which must have the same precisions.
+  zetasql_base::Status Merge(const HyperLogLogPlusPlus& other);
+
+  // Returns the estimated number of distinct hashes added.
+  int64_t Estimate() const;
+
+  int precision() const { return precision_; }
+  int sparse_precision() const { return sparse_precision_; }
+  bool is_sparse() const { return registers_.empty(); }
+
+  std::string Serialize() const;
+  static zetasql_base::StatusOr<HyperLogLogPlusPlus> Deserialize(
+      absl::string_view bytes);
+
+ private:
+  HyperLogLogPlusPlus(int precision, int sparse_precision)
+      : precision_(precision), sparse_precision_(sparse_precision) {}
+
+  // Sorts <sparse_buffer_> into <sparse_>, keeping the largest rank of each
+  // register, and converts to dense if the list is then too long.
+  void FlushSparseBuffer() const;
+  void ConvertToDense() const;
+
+  int precision_;
+  int sparse_precision_;
+  // The sparse representation: register index << 6 | rank, sorted by index
+  // with one entry per index, plus entries added since the last flush.
+  // Mutable so that Estimate() and Serialize() can flush them.
+  mutable std::vector<uint32_t> sparse_;
+  mutable std::vector<uint32_t> sparse_buffer_;
+  // The dense representation, empty while the sketch is sparse.
+  mutable std::vector<uint8_t> registers_;
+};
+
+// A KLL sketch (Karnin, Lang and Liberty, 2016) of a multiset of values of
+// type T, which is int64_t, uint64_t or double; NaNs must not be added. It
+// keeps O(k) of the values added; a quantile query returns one of them whose
+// rank is within about 1.7 / k * size() of the rank asked for. Compactions
+// choose which half of the values to keep with a deterministic coin, so the
+// same inputs in the same order give the same sketch.
+template <typename T>
+class KllQuantileSketch {
+ public:
+  static_assert(std::is_arithmetic<T>::value && sizeof(T) == 8,
+                "KllQuantileSketch supports int64_t, uint64_t and double");
+  static constexpr int kDefaultK = 200;
+
+  // <k> is at least 8.
+  explicit KllQuantileSketch(int k = kDefaultK)
+      : k_(std::max(k, 8)), levels_(1) {}
+
+  void Add(T value);
+
+  // Adds the values of <other>, which may have a different k.
+  void Merge(const KllQuantileSketch& other);
+
+  // The number of values added.
+  int64_t size() const { return size_; }
+  int k() const { return k_; }
+
+  // Returns an approximate <fraction> quantile, for 0 <= <fraction> <= 1. 0
+  // and 1 give the exact minimum and maximum. REQUIRES: size() > 0.
+  T Quantile(double fraction) const;
+
+  // Sets <*quantiles> to the <number> + 1 boundaries of APPROX_QUANTILES:
+  // the minimum, the i / <number> quantiles, and the maximum. REQUIRES:
+  // size() > 0 and <number> > 0.
+  void Quantiles(int number, std::vector<T>* quantiles) const;
+
+  std::string Serialize() const;
+  static zetasql_base::StatusOr<KllQuantileSketch> Deserialize(
+      absl::string_view bytes);
+
+ private:
+  // The number of values level <level> may hold before it is compacted.
+  int64_t LevelCapacity(int level) const {
+    return capacity_by_depth_[levels_.size() - 1 - level];
+  }
+  // Extends <capacity_by_depth_> to the number of levels.
+  void UpdateCapacities();
+  // Compacts levels until the sketch fits in the sum of their capacities.
+  void Compress();
+  bool NextCoin();
+
+  int k_;
+  int64_t size_ = 0;
+  T min_ = T();
+  T max_ = T();
+  uint64_t coin_state_ = 0x853c49e6748fea9bULL;
+  // levels_[i] holds values of weight 2^i.
+  std::vector<std::vector<T>> levels_;
+  // The capacity of the level i below the top, and the sum of the
+  // capacities of all levels.
+  std::vector<int64_t> capacity_by_depth_;
+  int64_t total_capacity_ = 0;
+  // The number of values in <levels_>.
+  int64_t num_retained_ = 0;
+};
+
+// The Space-Saving algorithm (Metwally, Agrawal and El Abbadi, 2005) over
+// string keys, such as the encodings of normalized_key.h. It keeps at most
+// <capacity> keys; every key whose count is more than size() / <capacity>
+// is kept, and each count is at most error() larger than the true count.
+// Merging follows the mergeable summaries of Agarwal et al. (2012).
+class SpaceSavingTopK {
+ public:
+  struct Entry {
+    std::string key;
+    int64_t count;
+    // The amount by which <count> may exceed the true count.
+    int64_t error;
+  };
+
+  // <capacity> is at least 1.
+  explicit SpaceSavingTopK(int64_t capacity)
+      : capacity_(std::max<int64_t>(capacity, 1)) {}
+
+  SpaceSavingTopK(const SpaceSavingTopK& other) { *this = other; }
+  SpaceSavingTopK& operator=(const SpaceSavingTopK& other);
+  SpaceSavingTopK(SpaceSavingTopK&&) = default;
+  SpaceSavingTopK& operator=(SpaceSavingTopK&&) = default;
+
+  // Adds <weight> > 0 occurrences of <key>.
+  void Add(absl::string_view key, int64_t weight = 1);
+
+  // Adds the occurrences of <other>, which may have a different capacity.
+  void Merge(const SpaceSavingTopK& other);
+
+  // Returns the <k> keys with the largest counts, by decreasing count and
+  // then by key.
+  std::vector<Entry> TopK(int64_t k) const;
+
+  int64_t capacity() const { return capacity_; }
+  // The total weight added.
+  int64_t size() const { return size_; }
+
+  std::string Serialize() const;
+  static zetasql_base::StatusOr<SpaceSavingTopK> Deserialize(
+      absl::string_view bytes);
+
+ private:
+  struct Counter {
+    int64_t count;
+    int64_t error;
+  };
+  using CounterMap = absl::node_hash_map<std::string, Counter>;
+  // Orders counters by count, then by key, so that the first is evicted.
+  struct CounterLess {
+    bool operator()(const CounterMap::value_type* a,
+                    const CounterMap::value_type* b) const {
+      if (a->second.count != b->second.count) {
+        return a->second.count < b->second.count;
+      }
+      return a->first < b->first;
+    }
+  };
+
+  // The count that a key that is not kept may have.
+  int64_t MissingCount() const;
+  void Insert(std::string key, Counter counter);
+
+  int64_t capacity_;
+  int64_t size_ = 0;
+  CounterMap counters_;
+  // Points into <counters_>, whose elements do not move.
+  std::set<const CounterMap::value_type*, CounterLess> by_count_;
+};
+
+// ----------------------- Internal parts -----------------------
+// These are implementation details. Do not use outside of this file.
+
+namespace sketch_internal {
+
+void AppendVarint(uint64_t value, std::string* out);
+bool ConsumeVarint(absl::string_view* in, uint64_t* value);
+
+inline void AppendFixed64(uint64_t value, std::string* out) {
+  char bytes[8];
+  for (int i = 0; i < 8; ++i) {
+    bytes[i] = static_cast<char>(value >> (8 * i));
+  }
+  out->append(bytes, 8);
+}
+
+inline bool ConsumeFixed64(absl::string_view* in, uint64_t* value) {
+  if (in->size() < 8) return false;
+  *value = 0;
+  for (int i = 0; i < 8; ++i) {
+    *value |= uint64_t{static_cast<uint8_t>((*in)[i])} << (8 * i);
+  }
+  in->remove_prefix(8);
+  return true;
+}
+
+template <typename T>
+uint64_t ToBits(T value) {
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+template <typename T>
+T FromBits(uint64_t bits) {
+  T value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+zetasql_base::Status CorruptSketchError(absl::string_view name);
+
+constexpr uint8_t kKllVersion = 1;
+
+}  // namespace sketch_internal
+
+template <typename T>
+void KllQuantileSketch<T>::Add(T value) {
+  if (size_ == 0) {
+    min_ = value;
+    max_ = value;
+  } else {
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+  }
+  ++size_;
+  ++num_retained_;
+  levels_[0].push_back(value);
+  Compress();
+}
+
+template <typename T>
+void KllQuantileSketch<T>::Merge(const KllQuantileSketch& other) {
+  if (other.size_ == 0) return;
+  if (size_ == 0) {
+    min_ = other.min_;
+    max_ = other.max_;
+  } else {
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+  }
+  size_ += other.size_;
+  if (levels_.size() < other.levels_.size()) {
+    levels_.resize(other.levels_.size());
+  }
+  for (int i = 0; i < other.levels_.size(); ++i) {
+    levels_[i].insert(levels_[i].end(), other.levels_[i].begin(),
+                      other.levels_[i].end());
+  }
+  num_retained_ += other.num_retained_;
+  Compress();
+}
+
+template <typename T>
+void KllQuantileSketch<T>::UpdateCapacities() {
+  while (capacity_by_depth_.size() < levels_.size()) {
+    const int64_t capacity = std::max<int64_t>(
+        2, static_cast<int64_t>(std::ceil(
+               k_ * std::pow(2.0 / 3.0, capacity_by_depth_.size()))));
+    capacity_by_depth_.push_back(capacity);
+    total_capacity_ += capacity;
+  }
+}
+
+template <typename T>
+bool KllQuantileSketch<T>::NextCoin() {
+  // xorshift64.
+  coin_state_ ^= coin_state_ << 13;
+  coin_state_ ^= coin_state_ >> 7;
+  coin_state_ ^= coin_state_ << 17;
+  return (coin_state_ & 1) != 0;
+}
+
+template <typename T>
+void KllQuantileSketch<T>::Compress() {
+  UpdateCapacities();
+  while (num_retained_ > total_capacity_) {
+    // Compact the lowest level that is full: sort it and move every other
+    // value to the level above with twice the weight, keeping one value
+    // behind if the count is odd.
+    int level = 0;
+    while (levels_[level].size() < LevelCapacity(level)) {
+      ++level;
+    }
+    if (level + 1 == levels_.size()) {
+      levels_.emplace_back();
+      UpdateCapacities();
+    }
+    std::vector<T>& values = levels_[level];
+    std::sort(values.begin(), values.end());
+    const size_t num_pairs = values.size() / 2;
+    const size_t offset = NextCoin() ? 1 : 0;
+    std::vector<T>& above = levels_[level + 1];
+    for (size_t i = 0; i < num_pairs; ++i) {
+      above.push_back(values[2 * i + offset]);
+    }
+    num_retained_ -= num_pairs;
+    if (values.size() % 2 == 1) {
+      values[0] = values.back();
+      values.resize(1);
+    } else {
+      values.clear();
+    }
+  }
+}
+
+template <typename T>
+T KllQuantileSketch<T>::Quantile(double fraction) const {
+  if (fraction <= 0) return min_;
+  if (fraction >= 1) return max_;
+  std::vector<std::pair<T, int64_t>> weighted;
+  for (int i = 0; i < levels_.size(); ++i) {
+    for (const T value : levels_[i]) {
+      weighted.emplace_back(value, int64_t{1} << i);
+    }
+  }
+  std::sort(weighted.begin(), weighted.end());
+  const double target = fraction * size_;
+  int64_t rank = 0;
+  for (const auto& value_and_weight : weighted) {
+    rank += value_and_weight.second;
+    if (rank >= target) return value_and_weight.first;
+  }
+  return max_;
+}
+
+template <typename T>
+void KllQuantileSketch<T>::Quantiles(int number,
+                                     std::vector<T>* quantiles) const {
+  quantiles->clear();
+  for (int i = 0; i <= number; ++i) {
+    quantiles->push_back(Quantile(static_cast<double>(i) / number));
+  }
+}
+
+template <typename T>
+std::string KllQuantileSketch<T>::Serialize() const {
+  std::string out;
+  out.push_back(static_cast<char>(sketch_internal::kKllVersion));
+  sketch_internal::AppendVarint(k_, &out);
+  sketch_internal::AppendVarint(size_, &out);
+  sketch_internal::AppendFixed64(sketch_internal::ToBits(min_), &out);
+  sketch_internal::AppendFixed64(sketch_internal::ToBits(max_), &out);
+  sketch_internal::AppendVarint(levels_.size(), &out);
+  for (const std::vector<T>& level : levels_) {
+    sketch_internal::AppendVarint(level.size(), &out);
+    for (const T value : level) {
+      sketch_internal::AppendFixed64(sketch_internal::ToBits(value), &out);
+    }
+  }
+  return out;
+}
+
+template <typename T>
+zetasql_base::StatusOr<KllQuantileSketch<T>> KllQuantileSketch<T>::Deserialize(
+    absl::string_view bytes) {
+  const zetasql_base::Status error =
+      sketch_internal::CorruptSketchError("KLL quantile sketch");
+  if (bytes.empty() || bytes[0] != sketch_internal::kKllVersion) return error;
+  bytes.remove_prefix(1);
+  uint64_t k, size, min_bits, max_bits, num_levels;
+  if (!sketch_internal::ConsumeVarint(&bytes, &k) ||
+      !sketch_internal::ConsumeVarint(&bytes, &size) ||
+      !sketch_internal::ConsumeFixed64(&bytes, &min_bits) ||
+      !sketch_internal::ConsumeFixed64(&bytes, &max_bits) ||
+      !sketch_internal::ConsumeVarint(&bytes, &num_levels) || k < 8 ||
+      k > (1 << 20) || num_levels == 0 || num_levels > 62 ||
+      size > (uint64_t{1} << 62)) {
+    return error;
+  }
+  KllQuantileSketch sketch(static_cast<int>(k));
+  sketch.size_ = static_cast<int64_t>(size);
+  sketch.min_ = sketch_internal::FromBits<T>(min_bits);
+  sketch.max_ = sketch_internal::FromBits<T>(max_bits);
+  sketch.levels_.resize(num_levels);
+  uint64_t total_weight = 0;
+  for (int i = 0; i < num_levels; ++i) {
+    uint64_t level_size;
+    if (!sketch_internal::ConsumeVarint(&bytes, &level_size) ||
+        level_size > bytes.size() / 8) {
+      return error;
+    }
+    std::vector<T>& level = sketch.levels_[i];
+    for (uint64_t j = 0; j < level_size; ++j) {
+      uint64_t bits;
+      sketch_internal::ConsumeFixed64(&bytes, &bits);
+      level.push_back(sketch_internal::FromBits<T>(bits));
+    }
+    total_weight += level_size << i;
+    sketch.num_retained_ += level_size;
+  }
+  if (!bytes.empty() || total_weight != size) return error;
+  sketch.UpdateCapacities();
+  return sketch;
+}
+
+}  // namespace functions
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_FUNCTIONS_APPROX_SKETCHES_H_
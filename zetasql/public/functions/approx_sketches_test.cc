@@ -0,0 +1,279 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/functions/approx_sketches.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+
+namespace zetasql {
+namespace functions {
+namespace {
+
+using ::testing::ElementsAre;
+using zetasql_base::testing::StatusIs;
+
+MATCHER_P2(IsWithinFraction, expected, fraction, "") {
+  return std::abs(static_cast<double>(arg) - expected) <= fraction * expected;
+}
+
+TEST(ApproxSketchesTest, StableHashes) {
+  // These values must never change, or serialized sketches could no longer
+  // be merged with new ones.
+  EXPECT_EQ(0u, SketchHashInt64(0));
+  EXPECT_NE(SketchHashInt64(1), SketchHashInt64(2));
+  EXPECT_EQ(SketchHashBytes("abc"), SketchHashBytes(std::string("abc")));
+  EXPECT_NE(SketchHashBytes("abcdefgh1"), SketchHashBytes("abcdefgh2"));
+  EXPECT_NE(SketchHashBytes(""), SketchHashBytes(std::string(1, '\0')));
+}
+
+TEST(HyperLogLogPlusPlusTest, Create) {
+  EXPECT_THAT(HyperLogLogPlusPlus::Create(9, 20).status(),
+              StatusIs(zetasql_base::StatusCode::kOutOfRange));
+  EXPECT_THAT(HyperLogLogPlusPlus::Create(15, 14).status(),
+              StatusIs(zetasql_base::StatusCode::kOutOfRange));
+  EXPECT_THAT(HyperLogLogPlusPlus::Create(15, 26).status(),
+              StatusIs(zetasql_base::StatusCode::kOutOfRange));
+  ZETASQL_ASSERT_OK(HyperLogLogPlusPlus::Create(24, 25).status());
+}
+
+TEST(HyperLogLogPlusPlusTest, Estimate) {
+  HyperLogLogPlusPlus hll;
+  EXPECT_EQ(0, hll.Estimate());
+  for (int64_t i = 0; i < 100; ++i) {
+    hll.AddHash(SketchHashInt64(i));
+    hll.AddHash(SketchHashInt64(i));
+  }
+  EXPECT_TRUE(hll.is_sparse());
+  EXPECT_EQ(100, hll.Estimate());
+
+  for (int64_t i = 100; i < 200000; ++i) {
+    hll.AddHash(SketchHashInt64(i));
+  }
+  EXPECT_FALSE(hll.is_sparse());
+  EXPECT_THAT(hll.Estimate(), IsWithinFraction(200000, 0.03));
+}
+
+TEST(HyperLogLogPlusPlusTest, SparseAndDenseAgree) {
+  HyperLogLogPlusPlus sparse;
+  for (int64_t i = 0; i < 5000; ++i) {
+    sparse.AddHash(SketchHashBytes(absl::StrCat("key", i)));
+  }
+  ASSERT_TRUE(sparse.is_sparse());
+  EXPECT_THAT(sparse.Estimate(), IsWithinFraction(5000, 0.01));
+
+  // Merging a sparse sketch into a dense one gives the same registers as
+  // adding its hashes.
+  HyperLogLogPlusPlus dense;
+  HyperLogLogPlusPlus dense_copy;
+  for (int64_t i = 0; i < 100000; ++i) {
+    dense.AddHash(SketchHashInt64(-i));
+    dense_copy.AddHash(SketchHashInt64(-i));
+  }
+  ASSERT_FALSE(dense.is_sparse());
+  ZETASQL_ASSERT_OK(dense.Merge(sparse));
+  for (int64_t i = 0; i < 5000; ++i) {
+    dense_copy.AddHash(SketchHashBytes(absl::StrCat("key", i)));
+  }
+  EXPECT_EQ(dense_copy.Serialize(), dense.Serialize());
+  EXPECT_THAT(dense.Estimate(), IsWithinFraction(105000, 0.03));
+}
+
+TEST(HyperLogLogPlusPlusTest, Merge) {
+  HyperLogLogPlusPlus a;
+  HyperLogLogPlusPlus b;
+  for (int64_t i = 0; i < 3000; ++i) {
+    a.AddHash(SketchHashInt64(i));
+    b.AddHash(SketchHashInt64(i + 2000));
+  }
+  ZETASQL_ASSERT_OK(a.Merge(b));
+  EXPECT_THAT(a.Estimate(), IsWithinFraction(5000, 0.01));
+
+  HyperLogLogPlusPlus other = HyperLogLogPlusPlus::Create(14, 20).ValueOrDie();
+  EXPECT_THAT(a.Merge(other),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+}
+
+TEST(HyperLogLogPlusPlusTest, Serialize) {
+  HyperLogLogPlusPlus empty;
+  HyperLogLogPlusPlus sparse;
+  HyperLogLogPlusPlus dense = HyperLogLogPlusPlus::Create(12, 18).ValueOrDie();
+  for (int64_t i = 0; i < 20000; ++i) {
+    if (i < 1000) sparse.AddHash(SketchHashInt64(i));
+    dense.AddHash(SketchHashInt64(i));
+  }
+  for (const HyperLogLogPlusPlus* hll : {&empty, &sparse, &dense}) {
+    const std::string bytes = hll->Serialize();
+    ZETASQL_ASSERT_OK_AND_ASSIGN(HyperLogLogPlusPlus copy,
+                         HyperLogLogPlusPlus::Deserialize(bytes));
+    EXPECT_EQ(hll->precision(), copy.precision());
+    EXPECT_EQ(hll->sparse_precision(), copy.sparse_precision());
+    EXPECT_EQ(hll->is_sparse(), copy.is_sparse());
+    EXPECT_EQ(hll->Estimate(), copy.Estimate());
+    EXPECT_EQ(bytes, copy.Serialize());
+  }
+  // The sparse form is much smaller than the registers.
+  EXPECT_LT(sparse.Serialize().size(), 3000);
+
+  const std::string bytes = sparse.Serialize();
+  for (const std::string& corrupt :
+       {std::string(), std::string("\x02\x0f\x14\x00", 4),
+        bytes.substr(0, bytes.size() - 1), absl::StrCat(bytes, "x"),
+        dense.Serialize().substr(1)}) {
+    EXPECT_THAT(HyperLogLogPlusPlus::Deserialize(corrupt).status(),
+                StatusIs(zetasql_base::StatusCode::kOutOfRange));
+  }
+}
+
+TEST(KllQuantileSketchTest, SmallInputsAreExact) {
+  KllQuantileSketch<int64_t> sketch;
+  for (int64_t i = 10; i >= 0; --i) {
+    sketch.Add(i * 10);
+  }
+  EXPECT_EQ(11, sketch.size());
+  std::vector<int64_t> quantiles;
+  sketch.Quantiles(2, &quantiles);
+  EXPECT_THAT(quantiles, ElementsAre(0, 50, 100));
+  sketch.Quantiles(10, &quantiles);
+  EXPECT_THAT(quantiles,
+              ElementsAre(0, 10, 20, 30, 40, 50, 60, 70, 80, 90, 100));
+}
+
+TEST(KllQuantileSketchTest, LargeInputs) {
+  KllQuantileSketch<double> sketch;
+  constexpr int64_t kSize = 1000000;
+  for (int64_t i = 0; i < kSize; ++i) {
+    // A permutation of [0, kSize).
+    sketch.Add(static_cast<double>((i * 7919) % kSize));
+  }
+  EXPECT_EQ(0, sketch.Quantile(0));
+  EXPECT_EQ(kSize - 1, sketch.Quantile(1));
+  for (double fraction : {0.1, 0.25, 0.5, 0.9, 0.99}) {
+    EXPECT_NEAR(fraction * kSize, sketch.Quantile(fraction), 0.02 * kSize)
+        << fraction;
+  }
+  // The sketch stays small.
+  EXPECT_LT(sketch.Serialize().size(), 8 * 1000);
+}
+
+TEST(KllQuantileSketchTest, Merge) {
+  KllQuantileSketch<uint64_t> low;
+  KllQuantileSketch<uint64_t> high(100);
+  for (uint64_t i = 0; i < 50000; ++i) {
+    low.Add(i);
+    high.Add(i + 50000);
+  }
+  low.Merge(high);
+  EXPECT_EQ(100000, low.size());
+  EXPECT_EQ(0, low.Quantile(0));
+  EXPECT_EQ(99999, low.Quantile(1));
+  EXPECT_NEAR(50000, low.Quantile(0.5), 2000);
+}
+
+TEST(KllQuantileSketchTest, Serialize) {
+  KllQuantileSketch<double> sketch(50);
+  for (int i = 0; i < 10000; ++i) {
+    sketch.Add(i * 0.5);
+  }
+  const std::string bytes = sketch.Serialize();
+  ZETASQL_ASSERT_OK_AND_ASSIGN(KllQuantileSketch<double> copy,
+                       KllQuantileSketch<double>::Deserialize(bytes));
+  EXPECT_EQ(50, copy.k());
+  EXPECT_EQ(sketch.size(), copy.size());
+  EXPECT_EQ(sketch.Quantile(0.3), copy.Quantile(0.3));
+  EXPECT_EQ(bytes, copy.Serialize());
+
+  for (const std::string& corrupt :
+       {std::string(), bytes.substr(0, bytes.size() - 1),
+        absl::StrCat(bytes, "x"), absl::StrCat("\x02", bytes.substr(1))}) {
+    EXPECT_THAT(KllQuantileSketch<double>::Deserialize(corrupt).status(),
+                StatusIs(zetasql_base::StatusCode::kOutOfRange));
+  }
+}
+
+TEST(SpaceSavingTopKTest, ExactWhenUnderCapacity) {
+  SpaceSavingTopK top(10);
+  top.Add("b", 3);
+  top.Add("a");
+  top.Add("c", 3);
+  top.Add("a");
+  std::vector<SpaceSavingTopK::Entry> entries = top.TopK(2);
+  ASSERT_EQ(2, entries.size());
+  EXPECT_EQ("b", entries[0].key);
+  EXPECT_EQ(3, entries[0].count);
+  EXPECT_EQ(0, entries[0].error);
+  EXPECT_EQ("c", entries[1].key);
+  EXPECT_EQ(3, top.TopK(10).size());
+  EXPECT_EQ(8, top.size());
+}
+
+TEST(SpaceSavingTopKTest, HeavyHittersSurvive) {
+  SpaceSavingTopK top(20);
+  for (int i = 0; i < 10000; ++i) {
+    top.Add(absl::StrCat("rare", i));
+    if (i % 4 == 0) top.Add("heavy");
+    if (i % 10 == 0) top.Add("medium");
+  }
+  std::vector<SpaceSavingTopK::Entry> entries = top.TopK(2);
+  ASSERT_EQ(2, entries.size());
+  EXPECT_EQ("heavy", entries[0].key);
+  EXPECT_GE(entries[0].count, 2500);
+  EXPECT_LE(entries[0].count - entries[0].error, 2500);
+  EXPECT_EQ("medium", entries[1].key);
+  EXPECT_GE(entries[1].count, 1000);
+}
+
+TEST(SpaceSavingTopKTest, MergeAndSerialize) {
+  SpaceSavingTopK a(5);
+  SpaceSavingTopK b(5);
+  for (int i = 0; i < 1000; ++i) {
+    a.Add(absl::StrCat("a", i % 50));
+    b.Add(absl::StrCat("b", i % 50));
+    a.Add("both");
+    b.Add("both", 2);
+  }
+  a.Merge(b);
+  EXPECT_EQ(5000, a.size());
+  std::vector<SpaceSavingTopK::Entry> entries = a.TopK(1);
+  ASSERT_EQ(1, entries.size());
+  EXPECT_EQ("both", entries[0].key);
+  EXPECT_GE(entries[0].count, 3000);
+  EXPECT_EQ(5, a.TopK(100).size());
+
+  const std::string bytes = a.Serialize();
+  ZETASQL_ASSERT_OK_AND_ASSIGN(SpaceSavingTopK copy,
+                       SpaceSavingTopK::Deserialize(bytes));
+  EXPECT_EQ(bytes, copy.Serialize());
+  EXPECT_EQ(a.capacity(), copy.capacity());
+  EXPECT_EQ("both", copy.TopK(1)[0].key);
+
+  for (const std::string& corrupt :
+       {std::string(), bytes.substr(0, bytes.size() - 1),
+        absl::StrCat(bytes, "x")}) {
+    EXPECT_THAT(SpaceSavingTopK::Deserialize(corrupt).status(),
+                StatusIs(zetasql_base::StatusCode::kOutOfRange));
+  }
+}
+
+}  // namespace
+}  // namespace functions
+}  // namespace zetasql
@@ -0,0 +1,330 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+// This file implements the arithmetic and comparison functions of
+// arithmetics.h and comparison.h over batches of rows, for columnar
+// evaluation. The following functions are defined:
+//
+//   bool AddBatch(const T* in1, const T* in2, const uint64_t* validity,
+//                 int64_t num_rows, T* out, int64_t* error_row,
+//                 zetasql_base::Status* error);
+//   bool SubtractBatch(...);   // Same arguments as AddBatch(), but <out> is
+//                              // int64_t* for uint64_t inputs.
+//   bool MultiplyBatch(...);
+//   bool DivideBatch(...);     // Only for double.
+//
+//   void EqualBatch(const T* in1, const T* in2, int64_t num_rows, bool* out);
+//   void NotEqualBatch(...);   // Same arguments as EqualBatch().
+//   void LessBatch(...);
+//   void LessOrEqualBatch(...);
+//   void GreaterBatch(...);
+//   void GreaterOrEqualBatch(...);
+//
+//   void AndValidity(const uint64_t* validity1, const uint64_t* validity2,
+//                    int64_t num_rows, uint64_t* out);
+//
+// T is int64_t, uint64_t or double. Inputs and outputs are arrays of
+// <num_rows> values, e.g. ColumnVector::int64_data() and double_data(), and
+// validity bitmaps have the layout of ColumnVector::validity(): bit i % 64
+// of word i / 64 is set if row i is not NULL. A null validity pointer means
+// that no row is NULL.
+//
+// The arithmetic functions compute every row without branching, and only
+// combine an overflow flag over the batch, so the loops are vectorized by
+// the compiler. If the flag is set, the rows that are not NULL are checked
+// again with the scalar functions of arithmetics.h; on the first one that
+// fails, the function returns false, sets *error_row to its index and sets
+// *error to the error of the scalar function. Rows that are NULL never give
+// errors. Output values for NULL rows, and all output values after an
+// error, are unspecified.
+//
+// The comparison functions ignore NULLs; the result of row i is only
+// meaningful if the row is valid in AndValidity() of both inputs.
+
+#ifndef ZETASQL_PUBLIC_FUNCTIONS_BATCH_KERNELS_H_
+#define ZETASQL_PUBLIC_FUNCTIONS_BATCH_KERNELS_H_
+
+#include <cmath>
+#include <cstdint>
+#include <functional>
+
+#include "zetasql/public/functions/arithmetics.h"
+#include "absl/base/optimization.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+namespace functions {
+
+inline bool IsValidRow(const uint64_t* validity, int64_t row) {
+  return validity == nullptr ||
+         (validity[row / 64] & (uint64_t{1} << (row % 64))) != 0;
+}
+
+inline void AndValidity(const uint64_t* validity1, const uint64_t* validity2,
+                        int64_t num_rows, uint64_t* out) {
+  const int64_t num_words = (num_rows + 63) / 64;
+  for (int64_t i = 0; i < num_words; ++i) {
+    out[i] = (validity1 == nullptr ? ~uint64_t{0} : validity1[i]) &
+             (validity2 == nullptr ? ~uint64_t{0} : validity2[i]);
+  }
+}
+
+// ----------------------- Internal parts -----------------------
+// These are implementation details. Do not use outside of this file.
+
+namespace internal {
+
+// Each kernel has an OutType, which is T unless noted, and
+//   static bool Unchecked(T in1, T in2, OutType* out);
+// which sets *out without checking for errors and returns true if the
+// scalar function may fail for these inputs, and
+//   static bool Checked(T in1, T in2, OutType* out,
+//                       zetasql_base::Status* error);
+// which is the scalar function.
+template <typename T> struct AddKernel;
+template <typename T> struct SubtractKernel;
+template <typename T> struct MultiplyKernel;
+template <typename T> struct DivideKernel;
+
+template <typename T>
+struct KernelTypes {
+  using OutType = T;
+};
+
+// Signed overflow is detected on the wrapped unsigned result, to keep the
+// loops free of undefined behavior and branches.
+template <>
+struct AddKernel<int64_t> : public KernelTypes<int64_t> {
+  static bool Unchecked(int64_t in1, int64_t in2, int64_t* out) {
+    *out = static_cast<int64_t>(static_cast<uint64_t>(in1) +
+                                static_cast<uint64_t>(in2));
+    return ((in1 ^ *out) & (in2 ^ *out)) < 0;
+  }
+  static bool Checked(int64_t in1, int64_t in2, int64_t* out,
+                      zetasql_base::Status* error) {
+    return Add<int64_t>(in1, in2, out, error);
+  }
+};
+
+template <>
+struct SubtractKernel<int64_t> : public KernelTypes<int64_t> {
+  static bool Unchecked(int64_t in1, int64_t in2, int64_t* out) {
+    *out = static_cast<int64_t>(static_cast<uint64_t>(in1) -
+                                static_cast<uint64_t>(in2));
+    return ((in1 ^ in2) & (in1 ^ *out)) < 0;
+  }
+  static bool Checked(int64_t in1, int64_t in2, int64_t* out,
+                      zetasql_base::Status* error) {
+    return Subtract<int64_t, int64_t>(in1, in2, out, error);
+  }
+};
+
+template <>
+struct AddKernel<uint64_t> : public KernelTypes<uint64_t> {
+  static bool Unchecked(uint64_t in1, uint64_t in2, uint64_t* out) {
+    *out = in1 + in2;
+    return *out < in1;
+  }
+  static bool Checked(uint64_t in1, uint64_t in2, uint64_t* out,
+                      zetasql_base::Status* error) {
+    return Add<uint64_t>(in1, in2, out, error);
+  }
+};
+
+// As for Subtract(), the difference of UINT64 values is an INT64.
+template <>
+struct SubtractKernel<uint64_t> {
+  using OutType = int64_t;
+  static bool Unchecked(uint64_t in1, uint64_t in2, int64_t* out) {
+    *out = static_cast<int64_t>(in1 - in2);
+    return (in1 >= in2) != (*out >= 0);
+  }
+  static bool Checked(uint64_t in1, uint64_t in2, int64_t* out,
+                      zetasql_base::Status* error) {
+    return Subtract<uint64_t, int64_t>(in1, in2, out, error);
+  }
+};
+
+template <typename T>
+struct IntegerMultiplyKernel : public KernelTypes<T> {
+  static bool Unchecked(T in1, T in2, T* out) {
+    return __builtin_mul_overflow(in1, in2, out);
+  }
+  static bool Checked(T in1, T in2, T* out, zetasql_base::Status* error) {
+    return Multiply<T>(in1, in2, out, error);
+  }
+};
+
+template <>
+struct MultiplyKernel<int64_t> : public IntegerMultiplyKernel<int64_t> {};
+template <>
+struct MultiplyKernel<uint64_t> : public IntegerMultiplyKernel<uint64_t> {};
+
+// Floating point operations only fail if the result is not finite, which is
+// also true when an input is not finite; the scalar check sorts those out.
+template <>
+struct AddKernel<double> : public KernelTypes<double> {
+  static bool Unchecked(double in1, double in2, double* out) {
+    *out = in1 + in2;
+    return !std::isfinite(*out);
+  }
+  static bool Checked(double in1, double in2, double* out,
+                      zetasql_base::Status* error) {
+    return Add<double>(in1, in2, out, error);
+  }
+};
+
+template <>
+struct SubtractKernel<double> : public KernelTypes<double> {
+  static bool Unchecked(double in1, double in2, double* out) {
+    *out = in1 - in2;
+    return !std::isfinite(*out);
+  }
+  static bool Checked(double in1, double in2, double* out,
+                      zetasql_base::Status* error) {
+    return Subtract<double, double>(in1, in2, out, error);
+  }
+};
+
+template <>
+struct MultiplyKernel<double> : public KernelTypes<double> {
+  static bool Unchecked(double in1, double in2, double* out) {
+    *out = in1 * in2;
+    return !std::isfinite(*out);
+  }
+  static bool Checked(double in1, double in2, double* out,
+                      zetasql_base::Status* error) {
+    return Multiply<double>(in1, in2, out, error);
+  }
+};
+
+template <>
+struct DivideKernel<double> : public KernelTypes<double> {
+  static bool Unchecked(double in1, double in2, double* out) {
+    *out = in1 / in2;
+    return (in2 == 0) | !std::isfinite(*out);
+  }
+  static bool Checked(double in1, double in2, double* out,
+                      zetasql_base::Status* error) {
+    return Divide<double>(in1, in2, out, error);
+  }
+};
+
+template <typename Kernel, typename T>
+inline bool ArithmeticBatch(const T* in1, const T* in2,
+                            const uint64_t* validity, int64_t num_rows,
+                            typename Kernel::OutType* out, int64_t* error_row,
+                            zetasql_base::Status* error) {
+  bool may_fail = false;
+  for (int64_t i = 0; i < num_rows; ++i) {
+    may_fail |= Kernel::Unchecked(in1[i], in2[i], &out[i]);
+  }
+  if (ABSL_PREDICT_TRUE(!may_fail)) return true;
+  for (int64_t i = 0; i < num_rows; ++i) {
+    if (!IsValidRow(validity, i)) continue;
+    if (!Kernel::Checked(in1[i], in2[i], &out[i], error)) {
+      *error_row = i;
+      return false;
+    }
+  }
+  return true;
+}
+
+template <template <typename> class Compare, typename T>
+inline void ComparisonBatch(const T* in1, const T* in2, int64_t num_rows,
+                            bool* out) {
+  const Compare<T> compare;
+  for (int64_t i = 0; i < num_rows; ++i) {
+    out[i] = compare(in1[i], in2[i]);
+  }
+}
+
+}  // namespace internal
+
+template <typename T>
+inline bool AddBatch(const T* in1, const T* in2, const uint64_t* validity,
+                     int64_t num_rows, T* out, int64_t* error_row,
+                     zetasql_base::Status* error) {
+  return internal::ArithmeticBatch<internal::AddKernel<T>>(
+      in1, in2, validity, num_rows, out, error_row, error);
+}
+
+template <typename T>
+inline bool SubtractBatch(const T* in1, const T* in2, const uint64_t* validity,
+                          int64_t num_rows,
+                          typename internal::SubtractKernel<T>::OutType* out,
+                          int64_t* error_row, zetasql_base::Status* error) {
+  return internal::ArithmeticBatch<internal::SubtractKernel<T>>(
+      in1, in2, validity, num_rows, out, error_row, error);
+}
+
+template <typename T>
+inline bool MultiplyBatch(const T* in1, const T* in2, const uint64_t* validity,
+                          int64_t num_rows, T* out, int64_t* error_row,
+                          zetasql_base::Status* error) {
+  return internal::ArithmeticBatch<internal::MultiplyKernel<T>>(
+      in1, in2, validity, num_rows, out, error_row, error);
+}
+
+template <typename T>
+inline bool DivideBatch(const T* in1, const T* in2, const uint64_t* validity,
+                        int64_t num_rows, T* out, int64_t* error_row,
+                        zetasql_base::Status* error) {
+  return internal::ArithmeticBatch<internal::DivideKernel<T>>(
+      in1, in2, validity, num_rows, out, error_row, error);
+}
+
+template <typename T>
+inline void EqualBatch(const T* in1, const T* in2, int64_t num_rows,
+                       bool* out) {
+  internal::ComparisonBatch<std::equal_to>(in1, in2, num_rows, out);
+}
+
+template <typename T>
+inline void NotEqualBatch(const T* in1, const T* in2, int64_t num_rows,
+                          bool* out) {
+  internal::ComparisonBatch<std::not_equal_to>(in1, in2, num_rows, out);
+}
+
+template <typename T>
+inline void LessBatch(const T* in1, const T* in2, int64_t num_rows,
+                      bool* out) {
+  internal::ComparisonBatch<std::less>(in1, in2, num_rows, out);
+}
+
+template <typename T>
+inline void LessOrEqualBatch(const T* in1, const T* in2, int64_t num_rows,
+                             bool* out) {
+  internal::ComparisonBatch<std::less_equal>(in1, in2, num_rows, out);
+}
+
+template <typename T>
+inline void GreaterBatch(const T* in1, const T* in2, int64_t num_rows,
+                         bool* out) {
+  internal::ComparisonBatch<std::greater>(in1, in2, num_rows, out);
+}
+
+template <typename T>
+inline void GreaterOrEqualBatch(const T* in1, const T* in2, int64_t num_rows,
+                                bool* out) {
+  internal::ComparisonBatch<std::greater_equal>(in1, in2, num_rows, out);
+}
+
+}  // namespace functions
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_FUNCTIONS_BATCH_KERNELS_H_
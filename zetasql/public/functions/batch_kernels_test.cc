@@ -0,0 +1,161 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "zetasql/public/functions/batch_kernels.h"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace zetasql {
+namespace functions {
+namespace {
+
+using ::testing::ElementsAre;
+using zetasql_base::testing::StatusIs;
+
+constexpr int64_t kInt64Max = std::numeric_limits<int64_t>::max();
+constexpr int64_t kInt64Min = std::numeric_limits<int64_t>::min();
+
+TEST(BatchKernelsTest, AddInt64) {
+  const std::vector<int64_t> in1 = {1, kInt64Max, -5, kInt64Min};
+  const std::vector<int64_t> in2 = {2, 0, -6, 0};
+  std::vector<int64_t> out(4);
+  int64_t error_row = -1;
+  zetasql_base::Status error;
+  EXPECT_TRUE(AddBatch(in1.data(), in2.data(), /*validity=*/nullptr, 4,
+                       out.data(), &error_row, &error));
+  EXPECT_THAT(out, ElementsAre(3, kInt64Max, -11, kInt64Min));
+  ZETASQL_EXPECT_OK(error);
+  EXPECT_EQ(-1, error_row);
+}
+
+TEST(BatchKernelsTest, OverflowIsReportedByRow) {
+  const std::vector<int64_t> in1 = {1, kInt64Max, 3, kInt64Max};
+  const std::vector<int64_t> in2 = {1, 1, 1, 2};
+  std::vector<int64_t> out(4);
+  int64_t error_row = -1;
+  zetasql_base::Status error;
+  EXPECT_FALSE(AddBatch(in1.data(), in2.data(), /*validity=*/nullptr, 4,
+                        out.data(), &error_row, &error));
+  EXPECT_EQ(1, error_row);
+  EXPECT_THAT(error, StatusIs(zetasql_base::StatusCode::kOutOfRange));
+
+  // Row 1 is NULL, so the first error is in row 3.
+  const uint64_t validity[] = {0b1101};
+  error_row = -1;
+  error = zetasql_base::OkStatus();
+  EXPECT_FALSE(AddBatch(in1.data(), in2.data(), validity, 4, out.data(),
+                        &error_row, &error));
+  EXPECT_EQ(3, error_row);
+
+  // No error if only NULL rows overflow.
+  const uint64_t first_rows_valid[] = {0b0101};
+  EXPECT_TRUE(AddBatch(in1.data(), in2.data(), first_rows_valid, 4,
+                       out.data(), &error_row, &error));
+  EXPECT_EQ(2, out[0]);
+  EXPECT_EQ(4, out[2]);
+}
+
+TEST(BatchKernelsTest, SubtractAndMultiply) {
+  const std::vector<int64_t> in1 = {10, kInt64Min, 7};
+  const std::vector<int64_t> in2 = {3, 1, -2};
+  std::vector<int64_t> out(3);
+  int64_t error_row = -1;
+  zetasql_base::Status error;
+  EXPECT_FALSE(SubtractBatch(in1.data(), in2.data(), nullptr, 3, out.data(),
+                             &error_row, &error));
+  EXPECT_EQ(1, error_row);
+  EXPECT_TRUE(MultiplyBatch(in1.data(), in2.data() + 2, nullptr, 1,
+                            out.data(), &error_row, &error));
+  EXPECT_EQ(-20, out[0]);
+
+  // UINT64 subtraction gives INT64.
+  const std::vector<uint64_t> u1 = {5, 1, std::numeric_limits<uint64_t>::max()};
+  const std::vector<uint64_t> u2 = {3, 2, 0};
+  std::vector<int64_t> uout(3);
+  EXPECT_FALSE(SubtractBatch(u1.data(), u2.data(), nullptr, 3, uout.data(),
+                             &error_row, &error));
+  EXPECT_EQ(2, error_row);
+  EXPECT_THAT(uout, ElementsAre(2, -1, testing::_));
+}
+
+TEST(BatchKernelsTest, Double) {
+  const double kInf = std::numeric_limits<double>::infinity();
+  const double kMax = std::numeric_limits<double>::max();
+  const std::vector<double> in1 = {1.5, kInf, kMax};
+  const std::vector<double> in2 = {2, 1, kMax};
+  std::vector<double> out(3);
+  int64_t error_row = -1;
+  zetasql_base::Status error;
+  // Infinite inputs are not errors, but overflow is.
+  EXPECT_FALSE(AddBatch(in1.data(), in2.data(), nullptr, 3, out.data(),
+                        &error_row, &error));
+  EXPECT_EQ(2, error_row);
+  EXPECT_EQ(3.5, out[0]);
+  EXPECT_EQ(kInf, out[1]);
+
+  const std::vector<double> zeros = {0, 0};
+  EXPECT_FALSE(DivideBatch(in1.data(), zeros.data(), nullptr, 2, out.data(),
+                           &error_row, &error));
+  EXPECT_EQ(0, error_row);
+  EXPECT_THAT(error, StatusIs(zetasql_base::StatusCode::kOutOfRange));
+}
+
+TEST(BatchKernelsTest, Comparisons) {
+  const double kNaN = std::numeric_limits<double>::quiet_NaN();
+  const std::vector<double> in1 = {1, 2, kNaN};
+  const std::vector<double> in2 = {2, 2, kNaN};
+  bool out[3];
+  LessBatch(in1.data(), in2.data(), 3, out);
+  EXPECT_THAT(out, ElementsAre(true, false, false));
+  LessOrEqualBatch(in1.data(), in2.data(), 3, out);
+  EXPECT_THAT(out, ElementsAre(true, true, false));
+  GreaterOrEqualBatch(in1.data(), in2.data(), 3, out);
+  EXPECT_THAT(out, ElementsAre(false, true, false));
+  EqualBatch(in1.data(), in2.data(), 3, out);
+  EXPECT_THAT(out, ElementsAre(false, true, false));
+  NotEqualBatch(in1.data(), in2.data(), 3, out);
+  EXPECT_THAT(out, ElementsAre(true, false, true));
+
+  const std::vector<int64_t> i1 = {-1, 5};
+  const std::vector<int64_t> i2 = {1, 5};
+  GreaterBatch(i1.data(), i2.data(), 2, out);
+  EXPECT_THAT(absl::MakeSpan(out, 2), ElementsAre(false, false));
+}
+
+TEST(BatchKernelsTest, AndValidity) {
+  const uint64_t validity1[] = {0b0110, ~uint64_t{0}};
+  const uint64_t validity2[] = {0b1100, 1};
+  uint64_t out[2];
+  AndValidity(validity1, validity2, 65, out);
+  EXPECT_EQ(0b0100, out[0]);
+  EXPECT_EQ(1, out[1]);
+  AndValidity(validity1, nullptr, 65, out);
+  EXPECT_EQ(0b0110, out[0]);
+  EXPECT_TRUE(IsValidRow(out, 64));
+  EXPECT_FALSE(IsValidRow(out, 0));
+  EXPECT_TRUE(IsValidRow(nullptr, 3));
+}
+
+}  // namespace
+}  // namespace functions
+}  // namespace zetasql
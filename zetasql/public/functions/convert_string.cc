@@ -16,6 +16,8 @@
 
 #include "zetasql/public/functions/convert_string.h"
 
+#include <string.h>
+
 #include "zetasql/common/string_util.h"
 #include "zetasql/public/functions/util.h"
 #include "zetasql/base/string_numbers.h"
@@ -24,6 +26,7 @@
 #include "absl/strings/escaping.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
 #include "absl/strings/strip.h"
 #include "zetasql/base/statusor.h"
 
@@ -58,6 +61,14 @@ bool IsHex(absl::string_view str) {
   return str.size() >= 2 && str[0] == '0' && (str[1] == 'x' || str[1] == 'X');
 }
 
+// Returns the error StringToNumeric() reports for a bad 'value'.
+zetasql_base::Status MakeStringToNumericErrorStatus(absl::string_view message,
+                                            absl::string_view value) {
+  zetasql_base::Status status;
+  internal::UpdateError(&status, FormatError(message, value));
+  return status;
+}
+
 constexpr absl::string_view kTrueStringValue = "true";
 constexpr absl::string_view kFalseStringValue = "false";
 
@@ -120,83 +131,253 @@ bool NumericToString(NumericValue value, std::string* out, zetasql_base::Status*
 }
 
 template <>
-bool StringToNumeric(absl::string_view value, bool* out, zetasql_base::Status* error) {
+int NumericToChars(bool value, char* buf) {
+  const absl::string_view str = value ? kTrueStringValue : kFalseStringValue;
+  memcpy(buf, str.data(), str.size());
+  return static_cast<int>(str.size());
+}
+
+template <>
+int NumericToChars(int32_t value, char* buf) {
+  return static_cast<int>(absl::numbers_internal::FastIntToBuffer(value, buf) -
+                          buf);
+}
+
+template <>
+int NumericToChars(int64_t value, char* buf) {
+  return static_cast<int>(absl::numbers_internal::FastIntToBuffer(value, buf) -
+                          buf);
+}
+
+template <>
+int NumericToChars(uint32_t value, char* buf) {
+  return static_cast<int>(absl::numbers_internal::FastIntToBuffer(value, buf) -
+                          buf);
+}
+
+template <>
+int NumericToChars(uint64_t value, char* buf) {
+  return static_cast<int>(absl::numbers_internal::FastIntToBuffer(value, buf) -
+                          buf);
+}
+
+// The formats match RoundTripFloatToString() and RoundTripDoubleToString().
+template <>
+int NumericToChars(float value, char* buf) {
+  return absl::SNPrintF(buf, kNumericToCharsBufferSize, "%.9g", value);
+}
+
+template <>
+int NumericToChars(double value, char* buf) {
+  return absl::SNPrintF(buf, kNumericToCharsBufferSize, "%.17g", value);
+}
+
+template <>
+int NumericToChars(NumericValue value, char* buf) {
+  static_assert(NumericValue::kMaxFormattedLength <= kNumericToCharsBufferSize,
+                "kNumericToCharsBufferSize is too small for NUMERIC");
+  return value.FormatTo(buf);
+}
+
+template <>
+ConvertStringError TryStringToNumeric(absl::string_view value, bool* out) {
   if (zetasql_base::CaseEqual(value, kTrueStringValue)) {
     *out = true;
   } else if (zetasql_base::CaseEqual(value, kFalseStringValue)) {
     *out = false;
   } else {
-    return internal::UpdateError(error,
-                                 FormatError("Bad bool value: ", value));
+    return ConvertStringError::kBadValue;
   }
-  return true;
+  return ConvertStringError::kOk;
 }
 
 template <>
-bool StringToNumeric(absl::string_view value, int32_t* out, zetasql_base::Status* error) {
+ConvertStringError TryStringToNumeric(absl::string_view value, int32_t* out) {
   TrimLeadingSpaces(&value);
   if (ABSL_PREDICT_FALSE(IsHex(value))) {
     if (ABSL_PREDICT_TRUE(
             zetasql_base::safe_strto32_base(value, out, 16 /* base */)))
-      return true;
+      return ConvertStringError::kOk;
   } else {
-    if (ABSL_PREDICT_TRUE(absl::SimpleAtoi(value, out))) return true;
+    if (ABSL_PREDICT_TRUE(absl::SimpleAtoi(value, out))) {
+      return ConvertStringError::kOk;
+    }
   }
-  return internal::UpdateError(error, FormatError("Bad int32_t value: ", value));
+  return ConvertStringError::kBadValue;
 }
 
 template <>
-bool StringToNumeric(absl::string_view value, int64_t* out, zetasql_base::Status* error) {
+ConvertStringError TryStringToNumeric(absl::string_view value, int64_t* out) {
   TrimLeadingSpaces(&value);
   if (ABSL_PREDICT_FALSE(IsHex(value))) {
     if (ABSL_PREDICT_TRUE(
             zetasql_base::safe_strto64_base(value, out, 16 /* base */)))
-      return true;
+      return ConvertStringError::kOk;
   } else {
-    if (ABSL_PREDICT_TRUE(absl::SimpleAtoi(value, out))) return true;
+    if (ABSL_PREDICT_TRUE(absl::SimpleAtoi(value, out))) {
+      return ConvertStringError::kOk;
+    }
   }
-  return internal::UpdateError(error, FormatError("Bad int64_t value: ", value));
+  return ConvertStringError::kBadValue;
 }
 
 template <>
-bool StringToNumeric(absl::string_view value, uint32_t* out,
-                     zetasql_base::Status* error) {
+ConvertStringError TryStringToNumeric(absl::string_view value, uint32_t* out) {
   TrimLeadingSpaces(&value);
   if (ABSL_PREDICT_FALSE(IsHex(value))) {
     if (ABSL_PREDICT_TRUE(
             zetasql_base::safe_strtou32_base(value, out, 16 /* base */)))
-      return true;
+      return ConvertStringError::kOk;
   } else {
-    if (ABSL_PREDICT_TRUE(absl::SimpleAtoi(value, out))) return true;
+    if (ABSL_PREDICT_TRUE(absl::SimpleAtoi(value, out))) {
+      return ConvertStringError::kOk;
+    }
   }
-  return internal::UpdateError(error, FormatError("Bad uint32_t value: ", value));
+  return ConvertStringError::kBadValue;
 }
 
 template <>
-bool StringToNumeric(absl::string_view value, uint64_t* out,
-                     zetasql_base::Status* error) {
+ConvertStringError TryStringToNumeric(absl::string_view value, uint64_t* out) {
   TrimLeadingSpaces(&value);
   if (ABSL_PREDICT_FALSE(IsHex(value))) {
     if (ABSL_PREDICT_TRUE(
             zetasql_base::safe_strtou64_base(value, out, 16 /* base */)))
-      return true;
+      return ConvertStringError::kOk;
   } else {
-    if (ABSL_PREDICT_TRUE(absl::SimpleAtoi(value, out))) return true;
+    if (ABSL_PREDICT_TRUE(absl::SimpleAtoi(value, out))) {
+      return ConvertStringError::kOk;
+    }
+  }
+  return ConvertStringError::kBadValue;
+}
+
+template <>
+ConvertStringError TryStringToNumeric(absl::string_view value, float* out) {
+  if (ABSL_PREDICT_TRUE(absl::SimpleAtof(value, out))) {
+    return ConvertStringError::kOk;
+  }
+  return ConvertStringError::kBadValue;
+}
+
+template <>
+ConvertStringError TryStringToNumeric(absl::string_view value, double* out) {
+  if (ABSL_PREDICT_TRUE(absl::SimpleAtod(value, out))) {
+    return ConvertStringError::kOk;
+  }
+  return ConvertStringError::kBadValue;
+}
+
+template <>
+ConvertStringError TryStringToNumeric(absl::string_view value,
+                                      NumericValue* out) {
+  // NumericValue::FromString() builds a Status only for invalid input.
+  const auto numeric_status = NumericValue::FromString(value);
+  if (ABSL_PREDICT_TRUE(numeric_status.ok())) {
+    *out = numeric_status.ValueOrDie();
+    return ConvertStringError::kOk;
+  }
+  return ConvertStringError::kBadValue;
+}
+
+template <>
+zetasql_base::Status MakeStringToNumericError<bool>(absl::string_view value) {
+  return MakeStringToNumericErrorStatus("Bad bool value: ", value);
+}
+
+template <>
+zetasql_base::Status MakeStringToNumericError<int32_t>(absl::string_view value) {
+  TrimLeadingSpaces(&value);
+  return MakeStringToNumericErrorStatus("Bad int32_t value: ", value);
+}
+
+template <>
+zetasql_base::Status MakeStringToNumericError<int64_t>(absl::string_view value) {
+  TrimLeadingSpaces(&value);
+  return MakeStringToNumericErrorStatus("Bad int64_t value: ", value);
+}
+
+template <>
+zetasql_base::Status MakeStringToNumericError<uint32_t>(absl::string_view value) {
+  TrimLeadingSpaces(&value);
+  return MakeStringToNumericErrorStatus("Bad uint32_t value: ", value);
+}
+
+template <>
+zetasql_base::Status MakeStringToNumericError<uint64_t>(absl::string_view value) {
+  TrimLeadingSpaces(&value);
+  return MakeStringToNumericErrorStatus("Bad uint64_t value: ", value);
+}
+
+template <>
+zetasql_base::Status MakeStringToNumericError<float>(absl::string_view value) {
+  return MakeStringToNumericErrorStatus("Bad float value: ", value);
+}
+
+template <>
+zetasql_base::Status MakeStringToNumericError<double>(absl::string_view value) {
+  return MakeStringToNumericErrorStatus("Bad double value: ", value);
+}
+
+template <>
+zetasql_base::Status MakeStringToNumericError<NumericValue>(
+    absl::string_view value) {
+  return NumericValue::FromString(value).status();
+}
+
+namespace {
+
+// Implements StringToNumeric() in terms of TryStringToNumeric().
+template <typename T>
+bool StringToNumericWithError(absl::string_view value, T* out,
+                              zetasql_base::Status* error) {
+  if (ABSL_PREDICT_TRUE(TryStringToNumeric(value, out) ==
+                        ConvertStringError::kOk)) {
+    return true;
+  }
+  if (error != nullptr && error->ok()) {
+    *error = MakeStringToNumericError<T>(value);
   }
-  return internal::UpdateError(error, FormatError("Bad uint64_t value: ", value));
+  return false;
+}
+
+}  // anonymous namespace
+
+template <>
+bool StringToNumeric(absl::string_view value, bool* out, zetasql_base::Status* error) {
+  return StringToNumericWithError(value, out, error);
+}
+
+template <>
+bool StringToNumeric(absl::string_view value, int32_t* out, zetasql_base::Status* error) {
+  return StringToNumericWithError(value, out, error);
+}
+
+template <>
+bool StringToNumeric(absl::string_view value, int64_t* out, zetasql_base::Status* error) {
+  return StringToNumericWithError(value, out, error);
+}
+
+template <>
+bool StringToNumeric(absl::string_view value, uint32_t* out,
+                     zetasql_base::Status* error) {
+  return StringToNumericWithError(value, out, error);
+}
+
+template <>
+bool StringToNumeric(absl::string_view value, uint64_t* out,
+                     zetasql_base::Status* error) {
+  return StringToNumericWithError(value, out, error);
 }
 
 template <>
 bool StringToNumeric(absl::string_view value, float* out, zetasql_base::Status* error) {
-  if (ABSL_PREDICT_TRUE(absl::SimpleAtof(value, out))) return true;
-  return internal::UpdateError(error, FormatError("Bad float value: ", value));
+  return StringToNumericWithError(value, out, error);
 }
 
 template <>
 bool StringToNumeric(absl::string_view value, double* out,
                      zetasql_base::Status* error) {
-  if (ABSL_PREDICT_TRUE(absl::SimpleAtod(value, out))) return true;
-  return internal::UpdateError(error, FormatError("Bad double value: ", value));
+  return StringToNumericWithError(value, out, error);
 }
 
 template <>
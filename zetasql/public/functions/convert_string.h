@@ -25,15 +25,29 @@
 // Here T must be one of the following seven types: bool, int32_t, int64_t, uint32_t,
 // uint64_t, float, double.
 // On error both functions return false and update *error.
+//
+// Variants that do not allocate are also defined for use in tight loops:
+//
+//   template <typename T>
+//   int NumericToChars(T value, char* buf);
+//   template <typename T>
+//   ConvertStringError TryStringToNumeric(absl::string_view value, T* out);
+//   template <typename T>
+//   zetasql_base::Status MakeStringToNumericError(absl::string_view value);
+//   template <typename T>
+//   int64_t StringsToNumerics(absl::Span<const absl::string_view> values,
+//                             T* out, uint64_t* errors);
 
 #ifndef ZETASQL_PUBLIC_FUNCTIONS_CONVERT_STRING_H_
 #define ZETASQL_PUBLIC_FUNCTIONS_CONVERT_STRING_H_
 
+#include <algorithm>
 #include <string>
 
 #include "zetasql/public/numeric_value.h"
 #include <cstdint>
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "zetasql/base/status.h"
 
 namespace zetasql {
@@ -85,6 +99,97 @@ template <>
 bool StringToNumeric(absl::string_view value, NumericValue* out,
                      zetasql_base::Status* error);
 
+// Size of a buffer that can hold the output of NumericToChars() for any of the
+// supported types.
+constexpr int kNumericToCharsBufferSize = 48;
+
+// Same as NumericToString(), but writes the value into <buf>, which must have
+// room for kNumericToCharsBufferSize characters, and returns the number of
+// characters written. No terminating null character is guaranteed. Cannot fail.
+template <typename T>
+int NumericToChars(T value, char* buf) = delete;
+
+template <> int NumericToChars(bool value, char* buf);
+template <> int NumericToChars(int32_t value, char* buf);
+template <> int NumericToChars(int64_t value, char* buf);
+template <> int NumericToChars(uint32_t value, char* buf);
+template <> int NumericToChars(uint64_t value, char* buf);
+template <> int NumericToChars(float value, char* buf);
+template <> int NumericToChars(double value, char* buf);
+template <> int NumericToChars(NumericValue value, char* buf);
+
+// Outcome of TryStringToNumeric().
+enum class ConvertStringError {
+  kOk = 0,
+  // The string is not a valid representation of a value of the type.
+  kBadValue = 1,
+};
+
+// Same as StringToNumeric(), but reports failure through the returned
+// ConvertStringError instead of building a zetasql_base::Status. The Status that
+// StringToNumeric() would have produced can be built afterwards with
+// MakeStringToNumericError().
+template <typename T>
+ConvertStringError TryStringToNumeric(absl::string_view value, T* out) = delete;
+
+template <>
+ConvertStringError TryStringToNumeric(absl::string_view value, bool* out);
+template <>
+ConvertStringError TryStringToNumeric(absl::string_view value, int32_t* out);
+template <>
+ConvertStringError TryStringToNumeric(absl::string_view value, int64_t* out);
+template <>
+ConvertStringError TryStringToNumeric(absl::string_view value, uint32_t* out);
+template <>
+ConvertStringError TryStringToNumeric(absl::string_view value, uint64_t* out);
+template <>
+ConvertStringError TryStringToNumeric(absl::string_view value, float* out);
+template <>
+ConvertStringError TryStringToNumeric(absl::string_view value, double* out);
+template <>
+ConvertStringError TryStringToNumeric(absl::string_view value,
+                                      NumericValue* out);
+
+// Returns the error that StringToNumeric<T>() reports for <value>, which must
+// be a value that TryStringToNumeric<T>() fails to convert.
+template <typename T>
+zetasql_base::Status MakeStringToNumericError(absl::string_view value) = delete;
+
+template <> zetasql_base::Status MakeStringToNumericError<bool>(absl::string_view value);
+template <>
+zetasql_base::Status MakeStringToNumericError<int32_t>(absl::string_view value);
+template <>
+zetasql_base::Status MakeStringToNumericError<int64_t>(absl::string_view value);
+template <>
+zetasql_base::Status MakeStringToNumericError<uint32_t>(absl::string_view value);
+template <>
+zetasql_base::Status MakeStringToNumericError<uint64_t>(absl::string_view value);
+template <>
+zetasql_base::Status MakeStringToNumericError<float>(absl::string_view value);
+template <>
+zetasql_base::Status MakeStringToNumericError<double>(absl::string_view value);
+template <>
+zetasql_base::Status MakeStringToNumericError<NumericValue>(absl::string_view value);
+
+// Converts each of <values> with TryStringToNumeric<T>() into the
+// corresponding element of <out>. Sets bit i % 64 of errors[i / 64] if
+// values[i] cannot be converted, in which case out[i] is unspecified, and
+// clears it otherwise. Returns the number of values that cannot be converted.
+template <typename T>
+int64_t StringsToNumerics(absl::Span<const absl::string_view> values, T* out,
+                          uint64_t* errors) {
+  const int64_t num_values = values.size();
+  std::fill(errors, errors + (num_values + 63) / 64, 0);
+  int64_t num_errors = 0;
+  for (int64_t i = 0; i < num_values; ++i) {
+    if (TryStringToNumeric(values[i], &out[i]) != ConvertStringError::kOk) {
+      errors[i / 64] |= uint64_t{1} << (i % 64);
+      ++num_errors;
+    }
+  }
+  return num_errors;
+}
+
 }  // namespace functions
 }  // namespace zetasql
 
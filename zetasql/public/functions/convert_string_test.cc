@@ -30,6 +30,7 @@
 #include "gtest/gtest.h"
 #include "absl/strings/ascii.h"
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "zetasql/base/status.h"
 
@@ -146,11 +147,70 @@ void TestLongString() {
   EXPECT_TRUE(absl::EndsWith(error.message(), "\0\0\0..."));
 }
 
+// NumericToChars() must produce the same characters as NumericToString().
+template <typename T>
+void TestNumericToCharsValue(T value) {
+  std::string expected;
+  zetasql_base::Status error;
+  EXPECT_TRUE(NumericToString<T>(value, &expected, &error));
+  char buf[kNumericToCharsBufferSize];
+  const int length = NumericToChars<T>(value, buf);
+  ASSERT_LE(length, kNumericToCharsBufferSize);
+  EXPECT_EQ(expected, absl::string_view(buf, length));
+}
+
+template <typename T>
+void TestNumericToChars() {
+  TestNumericToCharsValue<T>(0);
+  TestNumericToCharsValue<T>(1);
+  TestNumericToCharsValue(std::numeric_limits<T>::min());
+  TestNumericToCharsValue(std::numeric_limits<T>::max());
+  TestNumericToCharsValue(std::numeric_limits<T>::lowest());
+  if (std::numeric_limits<T>::has_denorm) {
+    TestNumericToCharsValue(std::numeric_limits<T>::denorm_min());
+  }
+  if (std::numeric_limits<T>::has_infinity) {
+    TestNumericToCharsValue(-std::numeric_limits<T>::infinity());
+  }
+  if (std::numeric_limits<T>::has_quiet_NaN) {
+    TestNumericToCharsValue(std::numeric_limits<T>::quiet_NaN());
+  }
+}
+
+// TryStringToNumeric() followed by MakeStringToNumericError() on failure must
+// behave like StringToNumeric().
+template <typename T>
+void TestTryStringToNumeric(absl::string_view str) {
+  T expected{};
+  zetasql_base::Status expected_error;
+  const bool expected_ok = StringToNumeric<T>(str, &expected, &expected_error);
+  T out{};
+  const ConvertStringError result = TryStringToNumeric<T>(str, &out);
+  EXPECT_EQ(expected_ok, result == ConvertStringError::kOk) << str;
+  if (expected_ok) {
+    EXPECT_EQ(absl::StrCat(expected), absl::StrCat(out)) << str;
+  } else {
+    EXPECT_EQ(expected_error, MakeStringToNumericError<T>(str)) << str;
+  }
+}
+
+template <typename T>
+void TestTryStringToNumeric() {
+  for (absl::string_view str :
+       {"", "0", "1", "-1", "  12", "0x1f", "-0x1F", "  0x10", "0x", "1.5",
+        "1e10", "-2147483649", "4294967296", "18446744073709551616", "inf",
+        "-inf", "nan", "true", "FALSE", "tru", "abc", " ", "12 "}) {
+    TestTryStringToNumeric<T>(str);
+  }
+}
+
 template <typename T>
 void TestAll() {
   TestRoundtrip<T>();
   TestSingleChar<T>();
   TestLongString<T>();
+  TestNumericToChars<T>();
+  TestTryStringToNumeric<T>();
 }
 
 TEST(Convert, TestBool) {
@@ -181,5 +241,48 @@ TEST(Convert, TestDouble) {
   TestAll<double>();
 }
 
+TEST(Convert, TestNumeric) {
+  for (NumericValue value :
+       {NumericValue(), NumericValue(-1), NumericValue::MinValue(),
+        NumericValue::MaxValue(),
+        NumericValue::FromStringStrict("0.000000001").ValueOrDie()}) {
+    TestNumericToCharsValue(value);
+  }
+  for (absl::string_view str :
+       {"", "0", "-1.5", "  12", "1e10", "1e30", "0.0000000001", "abc"}) {
+    NumericValue expected;
+    zetasql_base::Status expected_error;
+    const bool expected_ok =
+        StringToNumeric(str, &expected, &expected_error);
+    NumericValue out;
+    EXPECT_EQ(expected_ok,
+              TryStringToNumeric(str, &out) == ConvertStringError::kOk)
+        << str;
+    if (expected_ok) {
+      EXPECT_EQ(expected, out) << str;
+    } else {
+      EXPECT_EQ(expected_error, MakeStringToNumericError<NumericValue>(str));
+    }
+  }
+}
+
+TEST(Convert, StringsToNumerics) {
+  std::vector<std::string> storage;
+  for (int i = 0; i < 150; ++i) {
+    storage.push_back(i % 7 == 0 ? "x" : absl::StrCat(i));
+  }
+  const std::vector<absl::string_view> values(storage.begin(), storage.end());
+  std::vector<int64_t> out(values.size());
+  std::vector<uint64_t> errors(3, ~uint64_t{0});
+  EXPECT_EQ(22, StringsToNumerics<int64_t>(values, out.data(), errors.data()));
+  for (int i = 0; i < values.size(); ++i) {
+    EXPECT_EQ(i % 7 == 0, (errors[i / 64] >> (i % 64)) & 1) << i;
+    if (i % 7 != 0) {
+      EXPECT_EQ(i, out[i]);
+    }
+  }
+  EXPECT_EQ(0, errors[2] >> (150 - 128));
+}
+
 }  // namespace functions
 }  // namespace zetasql
@@ -0,0 +1,439 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/functions/date_kernels.h"
+
+#include <algorithm>
+
+#include "absl/time/civil_time.h"
+#include "zetasql/base/no_destructor.h"
+
+namespace zetasql {
+namespace functions {
+namespace date_time_util_internal {
+
+namespace {
+
+constexpr int32_t kMinDate = -719162;  // 0001-01-01
+constexpr int32_t kMaxDate = 2932896;  // 9999-12-31
+constexpr int32_t kMaxYear = 9999;
+
+// Intervals are clamped to this before they are multiplied, which keeps the
+// arithmetic in int64_t and the result far out of range.
+constexpr int64_t kMaxInterval = int64_t{1} << 40;
+
+struct DateTables {
+  DateTables() {
+    const absl::CivilDay epoch(1970, 1, 1);
+    for (int32_t year = 0; year <= kMaxYear + 1; ++year) {
+      year_start[year] =
+          static_cast<int32_t>(absl::CivilDay(year, 1, 1) - epoch);
+    }
+    for (int leap = 0; leap < 2; ++leap) {
+      const absl::civil_year_t year = leap ? 2000 : 2001;
+      const absl::CivilDay jan1(year, 1, 1);
+      for (int month = 1; month <= 13; ++month) {
+        days_before_month[leap][month] =
+            static_cast<int16_t>(absl::CivilDay(year, month, 1) - jan1);
+      }
+      days_before_month[leap][0] = 0;
+      for (int day = 0; day < 366; ++day) {
+        month_of_day_of_year[leap][day] =
+            static_cast<uint8_t>((jan1 + day).month());
+      }
+    }
+  }
+
+  // The date of January 1 of each year from 0 to kMaxYear + 1.
+  int32_t year_start[kMaxYear + 2];
+  // The days of the year before each month from 1 to 12, and before the
+  // next year at 13, of common and leap years.
+  int16_t days_before_month[2][14];
+  // The month of each day of the year from 0, of common and leap years.
+  uint8_t month_of_day_of_year[2][366];
+};
+
+const DateTables& GetDateTables() {
+  static const zetasql_base::NoDestructor<DateTables> tables;
+  return *tables;
+}
+
+struct CivilDate {
+  int32_t year;
+  int32_t leap;         // 1 for leap years, 0 otherwise.
+  int32_t day_of_year;  // From 0.
+  int32_t month;
+  int32_t day;
+};
+
+inline bool IsOutOfRange(int64_t date) {
+  return (date < kMinDate) | (date > kMaxDate);
+}
+
+inline int32_t ClampDate(int64_t date) {
+  return static_cast<int32_t>(
+      std::min<int64_t>(std::max<int64_t>(date, kMinDate), kMaxDate));
+}
+
+// <date> must be valid. A 400-year cycle has 146097 days, so the estimate of
+// the year is off by at most one, which the table lookups correct.
+inline CivilDate ToCivilDate(const DateTables& tables, int32_t date) {
+  CivilDate civil;
+  int32_t year =
+      static_cast<int32_t>(int64_t{date - kMinDate} * 400 / 146097) + 1;
+  year += tables.year_start[year + 1] <= date;
+  year -= tables.year_start[year] > date;
+  civil.year = year;
+  civil.leap = tables.year_start[year + 1] - tables.year_start[year] - 365;
+  civil.day_of_year = date - tables.year_start[year];
+  civil.month = tables.month_of_day_of_year[civil.leap][civil.day_of_year];
+  civil.day = civil.day_of_year -
+              tables.days_before_month[civil.leap][civil.month] + 1;
+  return civil;
+}
+
+// <year> must be between 1 and kMaxYear, and <day> must be in the month.
+inline int32_t FromCivilDate(const DateTables& tables, int32_t year,
+                             int32_t leap, int32_t month, int32_t day) {
+  return tables.year_start[year] + tables.days_before_month[leap][month] +
+         day - 1;
+}
+
+// From 0 for Sunday to 6 for Saturday. 0001-01-01 is a Monday.
+inline int32_t Weekday(int32_t date) { return (date - kMinDate + 1) % 7; }
+
+// The first day of the week of <date>, for weeks that start on
+// <first_weekday>. Can be before 0001-01-01.
+inline int32_t WeekStart(int32_t date, int32_t first_weekday) {
+  return date - (Weekday(date) - first_weekday + 7) % 7;
+}
+
+// Returns the first weekday of the WEEK parts, or -1 for other parts.
+int32_t FirstWeekdayOfWeek(DateTimestampPart part) {
+  switch (part) {
+    case WEEK:
+      return 0;
+    case WEEK_MONDAY:
+      return 1;
+    case WEEK_TUESDAY:
+      return 2;
+    case WEEK_WEDNESDAY:
+      return 3;
+    case WEEK_THURSDAY:
+      return 4;
+    case WEEK_FRIDAY:
+      return 5;
+    case WEEK_SATURDAY:
+      return 6;
+    default:
+      return -1;
+  }
+}
+
+// Runs <kernel>, which sets its output and returns true if the scalar
+// function may fail, on every date clamped to the valid range. Dates out of
+// range always may fail.
+template <typename Kernel>
+inline void UnaryLoop(const int32_t* dates, int64_t num_rows, int32_t* output,
+                      bool* may_fail, Kernel kernel) {
+  bool fail = false;
+  for (int64_t i = 0; i < num_rows; ++i) {
+    fail |= IsOutOfRange(dates[i]) | kernel(ClampDate(dates[i]), &output[i]);
+  }
+  *may_fail = fail;
+}
+
+template <typename Kernel>
+inline void BinaryLoop(const int32_t* dates1, const int32_t* dates2,
+                       int64_t num_rows, int32_t* output, bool* may_fail,
+                       Kernel kernel) {
+  bool fail = false;
+  for (int64_t i = 0; i < num_rows; ++i) {
+    fail |= IsOutOfRange(dates1[i]) | IsOutOfRange(dates2[i]) |
+            kernel(ClampDate(dates1[i]), ClampDate(dates2[i]), &output[i]);
+  }
+  *may_fail = fail;
+}
+
+template <typename Kernel>
+inline void AddLoop(const int32_t* dates, const int64_t* intervals,
+                    int64_t num_rows, int32_t* output, bool* may_fail,
+                    Kernel kernel) {
+  bool fail = false;
+  for (int64_t i = 0; i < num_rows; ++i) {
+    const int64_t interval =
+        std::min(std::max(intervals[i], -kMaxInterval), kMaxInterval);
+    fail |= IsOutOfRange(dates[i]) |
+            kernel(ClampDate(dates[i]), interval, &output[i]);
+  }
+  *may_fail = fail;
+}
+
+}  // namespace
+
+bool ExtractFromDateKernel(DateTimestampPart part, const int32_t* dates,
+                           int64_t num_rows, int32_t* output, bool* may_fail) {
+  const DateTables& tables = GetDateTables();
+  switch (part) {
+    case YEAR:
+      UnaryLoop(dates, num_rows, output, may_fail,
+                [&tables](int32_t date, int32_t* out) {
+                  *out = ToCivilDate(tables, date).year;
+                  return false;
+                });
+      return true;
+    case QUARTER:
+      UnaryLoop(dates, num_rows, output, may_fail,
+                [&tables](int32_t date, int32_t* out) {
+                  *out = (ToCivilDate(tables, date).month - 1) / 3 + 1;
+                  return false;
+                });
+      return true;
+    case MONTH:
+      UnaryLoop(dates, num_rows, output, may_fail,
+                [&tables](int32_t date, int32_t* out) {
+                  *out = ToCivilDate(tables, date).month;
+                  return false;
+                });
+      return true;
+    case DAY:
+      UnaryLoop(dates, num_rows, output, may_fail,
+                [&tables](int32_t date, int32_t* out) {
+                  *out = ToCivilDate(tables, date).day;
+                  return false;
+                });
+      return true;
+    case DAYOFWEEK:
+      UnaryLoop(dates, num_rows, output, may_fail,
+                [](int32_t date, int32_t* out) {
+                  *out = Weekday(date) + 1;
+                  return false;
+                });
+      return true;
+    case DAYOFYEAR:
+      UnaryLoop(dates, num_rows, output, may_fail,
+                [&tables](int32_t date, int32_t* out) {
+                  *out = ToCivilDate(tables, date).day_of_year + 1;
+                  return false;
+                });
+      return true;
+    case WEEK:
+    case WEEK_MONDAY:
+    case WEEK_TUESDAY:
+    case WEEK_WEDNESDAY:
+    case WEEK_THURSDAY:
+    case WEEK_FRIDAY:
+    case WEEK_SATURDAY: {
+      // Week 1 starts on the first <first_weekday> of the year, and the days
+      // before it are in week 0.
+      const int32_t first_weekday = FirstWeekdayOfWeek(part);
+      UnaryLoop(dates, num_rows, output, may_fail,
+                [&tables, first_weekday](int32_t date, int32_t* out) {
+                  const int32_t jan1 =
+                      tables.year_start[ToCivilDate(tables, date).year];
+                  const int32_t week1 =
+                      jan1 + (first_weekday - Weekday(jan1) + 7) % 7;
+                  *out = (date - week1 + 7) / 7;
+                  return false;
+                });
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+bool AddDateKernel(const int32_t* dates, DateTimestampPart part,
+                   const int64_t* intervals, int64_t num_rows, int32_t* output,
+                   bool* may_fail) {
+  const DateTables& tables = GetDateTables();
+  int64_t months_per_interval;
+  switch (part) {
+    case DAY:
+      AddLoop(dates, intervals, num_rows, output, may_fail,
+              [](int32_t date, int64_t interval, int32_t* out) {
+                const int64_t result = date + interval;
+                *out = ClampDate(result);
+                return IsOutOfRange(result);
+              });
+      return true;
+    case WEEK:
+      AddLoop(dates, intervals, num_rows, output, may_fail,
+              [](int32_t date, int64_t interval, int32_t* out) {
+                const int64_t result = date + 7 * interval;
+                *out = ClampDate(result);
+                return IsOutOfRange(result);
+              });
+      return true;
+    case MONTH:
+      months_per_interval = 1;
+      break;
+    case QUARTER:
+      months_per_interval = 3;
+      break;
+    case YEAR:
+      months_per_interval = 12;
+      break;
+    default:
+      return false;
+  }
+  // As for AddDate(), the day is moved back to the last day of the month if
+  // the month is shorter.
+  AddLoop(dates, intervals, num_rows, output, may_fail,
+          [&tables, months_per_interval](int32_t date, int64_t interval,
+                                         int32_t* out) {
+            const CivilDate civil = ToCivilDate(tables, date);
+            const int64_t months = int64_t{civil.year} * 12 + civil.month - 1 +
+                                   interval * months_per_interval;
+            const bool out_of_range =
+                (months < 12) | (months >= (kMaxYear + 1) * 12);
+            const int64_t clamped =
+                std::min<int64_t>(std::max<int64_t>(months, 12),
+                                  (kMaxYear + 1) * 12 - 1);
+            const int32_t year = static_cast<int32_t>(clamped / 12);
+            const int32_t month = static_cast<int32_t>(clamped % 12) + 1;
+            const int32_t leap =
+                tables.year_start[year + 1] - tables.year_start[year] - 365;
+            const int32_t days_in_month =
+                tables.days_before_month[leap][month + 1] -
+                tables.days_before_month[leap][month];
+            *out = FromCivilDate(tables, year, leap, month,
+                                 std::min(civil.day, days_in_month));
+            return out_of_range;
+          });
+  return true;
+}
+
+bool DiffDatesKernel(const int32_t* dates1, const int32_t* dates2,
+                     DateTimestampPart part, int64_t num_rows, int32_t* output,
+                     bool* may_fail) {
+  const DateTables& tables = GetDateTables();
+  switch (part) {
+    case DAY:
+      BinaryLoop(dates1, dates2, num_rows, output, may_fail,
+                 [](int32_t date1, int32_t date2, int32_t* out) {
+                   *out = date1 - date2;
+                   return false;
+                 });
+      return true;
+    case WEEK:
+    case WEEK_MONDAY:
+    case WEEK_TUESDAY:
+    case WEEK_WEDNESDAY:
+    case WEEK_THURSDAY:
+    case WEEK_FRIDAY:
+    case WEEK_SATURDAY: {
+      const int32_t first_weekday = FirstWeekdayOfWeek(part);
+      BinaryLoop(dates1, dates2, num_rows, output, may_fail,
+                 [first_weekday](int32_t date1, int32_t date2, int32_t* out) {
+                   *out = (WeekStart(date1, first_weekday) -
+                           WeekStart(date2, first_weekday)) /
+                          7;
+                   return false;
+                 });
+      return true;
+    }
+    case MONTH:
+      BinaryLoop(dates1, dates2, num_rows, output, may_fail,
+                 [&tables](int32_t date1, int32_t date2, int32_t* out) {
+                   const CivilDate civil1 = ToCivilDate(tables, date1);
+                   const CivilDate civil2 = ToCivilDate(tables, date2);
+                   *out = (civil1.year - civil2.year) * 12 +
+                          (civil1.month - civil2.month);
+                   return false;
+                 });
+      return true;
+    case QUARTER:
+      BinaryLoop(dates1, dates2, num_rows, output, may_fail,
+                 [&tables](int32_t date1, int32_t date2, int32_t* out) {
+                   const CivilDate civil1 = ToCivilDate(tables, date1);
+                   const CivilDate civil2 = ToCivilDate(tables, date2);
+                   *out = (civil1.year * 12 + civil1.month - 1) / 3 -
+                          (civil2.year * 12 + civil2.month - 1) / 3;
+                   return false;
+                 });
+      return true;
+    case YEAR:
+      BinaryLoop(dates1, dates2, num_rows, output, may_fail,
+                 [&tables](int32_t date1, int32_t date2, int32_t* out) {
+                   *out = ToCivilDate(tables, date1).year -
+                          ToCivilDate(tables, date2).year;
+                   return false;
+                 });
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool TruncateDateKernel(const int32_t* dates, DateTimestampPart part,
+                        int64_t num_rows, int32_t* output, bool* may_fail) {
+  const DateTables& tables = GetDateTables();
+  switch (part) {
+    case YEAR:
+      UnaryLoop(dates, num_rows, output, may_fail,
+                [&tables](int32_t date, int32_t* out) {
+                  *out = tables.year_start[ToCivilDate(tables, date).year];
+                  return false;
+                });
+      return true;
+    case QUARTER:
+      UnaryLoop(dates, num_rows, output, may_fail,
+                [&tables](int32_t date, int32_t* out) {
+                  const CivilDate civil = ToCivilDate(tables, date);
+                  *out = FromCivilDate(tables, civil.year, civil.leap,
+                                       (civil.month - 1) / 3 * 3 + 1, 1);
+                  return false;
+                });
+      return true;
+    case MONTH:
+      UnaryLoop(dates, num_rows, output, may_fail,
+                [&tables](int32_t date, int32_t* out) {
+                  *out = date - ToCivilDate(tables, date).day + 1;
+                  return false;
+                });
+      return true;
+    case WEEK:
+    case WEEK_MONDAY:
+    case WEEK_TUESDAY:
+    case WEEK_WEDNESDAY:
+    case WEEK_THURSDAY:
+    case WEEK_FRIDAY:
+    case WEEK_SATURDAY: {
+      // The week of 0001-01-01 can start before it, which is an error.
+      const int32_t first_weekday = FirstWeekdayOfWeek(part);
+      UnaryLoop(dates, num_rows, output, may_fail,
+                [first_weekday](int32_t date, int32_t* out) {
+                  *out = WeekStart(date, first_weekday);
+                  return *out < kMinDate;
+                });
+      return true;
+    }
+    case DAY:
+      UnaryLoop(dates, num_rows, output, may_fail,
+                [](int32_t date, int32_t* out) {
+                  *out = date;
+                  return false;
+                });
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace date_time_util_internal
+}  // namespace functions
+}  // namespace zetasql
@@ -0,0 +1,93 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+// Integer kernels for ExtractFromDate(), AddDate(), DiffDates() and
+// TruncateDate() of date_time_util.h on the common date parts: YEAR, QUARTER,
+// MONTH, WEEK, WEEK_<WEEKDAY> and DAY, and for extraction also DAYOFWEEK and
+// DAYOFYEAR. Dates are days from 1970-01-01, as in date_time_util.h, and are
+// split into civil days with a table of the first day of every year and
+// tables of the months of the days of the year, instead of through
+// absl::CivilDay.
+//
+// The kernels over arrays of <num_rows> dates compute every row without
+// branching on the values, and return false if they do not cover <part>.
+// Otherwise they set *may_fail to whether the scalar function may fail for
+// any row, in which case the output of that row is unspecified and callers
+// must compute it with the scalar function, which also gives the error. The
+// ISOYEAR and ISOWEEK parts, and the parts that are errors for dates, are
+// left to the scalar functions.
+
+#ifndef ZETASQL_PUBLIC_FUNCTIONS_DATE_KERNELS_H_
+#define ZETASQL_PUBLIC_FUNCTIONS_DATE_KERNELS_H_
+
+#include <cstdint>
+
+#include "zetasql/public/functions/datetime.pb.h"
+
+namespace zetasql {
+namespace functions {
+namespace date_time_util_internal {
+
+bool ExtractFromDateKernel(DateTimestampPart part, const int32_t* dates,
+                           int64_t num_rows, int32_t* output, bool* may_fail);
+
+bool AddDateKernel(const int32_t* dates, DateTimestampPart part,
+                   const int64_t* intervals, int64_t num_rows, int32_t* output,
+                   bool* may_fail);
+
+bool DiffDatesKernel(const int32_t* dates1, const int32_t* dates2,
+                     DateTimestampPart part, int64_t num_rows, int32_t* output,
+                     bool* may_fail);
+
+bool TruncateDateKernel(const int32_t* dates, DateTimestampPart part,
+                        int64_t num_rows, int32_t* output, bool* may_fail);
+
+// Single-row versions of the kernels above. Return true and set *output if
+// the kernel covers <part> and the scalar function cannot fail, and false
+// otherwise.
+inline bool ExtractFromDateKernel(DateTimestampPart part, int32_t date,
+                                  int32_t* output) {
+  bool may_fail;
+  return ExtractFromDateKernel(part, &date, 1, output, &may_fail) &&
+         !may_fail;
+}
+
+inline bool AddDateKernel(int32_t date, DateTimestampPart part,
+                          int64_t interval, int32_t* output) {
+  bool may_fail;
+  return AddDateKernel(&date, part, &interval, 1, output, &may_fail) &&
+         !may_fail;
+}
+
+inline bool DiffDatesKernel(int32_t date1, int32_t date2,
+                            DateTimestampPart part, int32_t* output) {
+  bool may_fail;
+  return DiffDatesKernel(&date1, &date2, part, 1, output, &may_fail) &&
+         !may_fail;
+}
+
+inline bool TruncateDateKernel(int32_t date, DateTimestampPart part,
+                               int32_t* output) {
+  bool may_fail;
+  return TruncateDateKernel(&date, part, 1, output, &may_fail) && !may_fail;
+}
+
+}  // namespace date_time_util_internal
+}  // namespace functions
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_FUNCTIONS_DATE_KERNELS_H_
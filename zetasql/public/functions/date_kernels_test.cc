@@ -0,0 +1,414 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/functions/date_kernels.h"
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/functions/date_time_util.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/time/civil_time.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+namespace functions {
+namespace date_time_util_internal {
+namespace {
+
+constexpr int32_t kMinDate = -719162;  // 0001-01-01
+constexpr int32_t kMaxDate = 2932896;  // 9999-12-31
+
+const absl::CivilDay kEpoch(1970, 1, 1);
+
+absl::CivilDay ToCivilDay(int32_t date) { return kEpoch + date; }
+int32_t ToDate(absl::CivilDay day) {
+  return static_cast<int32_t>(day - kEpoch);
+}
+
+const DateTimestampPart kWeekParts[] = {
+    WEEK,          WEEK_MONDAY, WEEK_TUESDAY,  WEEK_WEDNESDAY,
+    WEEK_THURSDAY, WEEK_FRIDAY, WEEK_SATURDAY,
+};
+
+absl::Weekday FirstWeekday(DateTimestampPart part) {
+  switch (part) {
+    case WEEK_MONDAY:
+      return absl::Weekday::monday;
+    case WEEK_TUESDAY:
+      return absl::Weekday::tuesday;
+    case WEEK_WEDNESDAY:
+      return absl::Weekday::wednesday;
+    case WEEK_THURSDAY:
+      return absl::Weekday::thursday;
+    case WEEK_FRIDAY:
+      return absl::Weekday::friday;
+    case WEEK_SATURDAY:
+      return absl::Weekday::saturday;
+    default:
+      return absl::Weekday::sunday;
+  }
+}
+
+bool IsWeekPart(DateTimestampPart part) {
+  return std::find(std::begin(kWeekParts), std::end(kWeekParts), part) !=
+         std::end(kWeekParts);
+}
+
+// The expected results, computed with absl::CivilDay.
+int32_t ExpectedExtract(DateTimestampPart part, int32_t date) {
+  const absl::CivilDay day = ToCivilDay(date);
+  if (IsWeekPart(part)) {
+    const absl::CivilDay week1 = absl::NextWeekday(
+        absl::CivilDay(day.year(), 1, 1) - 1, FirstWeekday(part));
+    return day < week1 ? 0 : static_cast<int32_t>((day - week1) / 7 + 1);
+  }
+  switch (part) {
+    case YEAR:
+      return static_cast<int32_t>(day.year());
+    case QUARTER:
+      return (day.month() - 1) / 3 + 1;
+    case MONTH:
+      return day.month();
+    case DAY:
+      return day.day();
+    case DAYOFWEEK:
+      return (static_cast<int>(absl::GetWeekday(day)) + 1) % 7 + 1;
+    case DAYOFYEAR:
+      return absl::GetYearDay(day);
+    default:
+      ADD_FAILURE() << DateTimestampPart_Name(part);
+      return 0;
+  }
+}
+
+// Can be before 0001-01-01 for the WEEK parts.
+int32_t ExpectedTruncate(DateTimestampPart part, int32_t date) {
+  const absl::CivilDay day = ToCivilDay(date);
+  if (IsWeekPart(part)) {
+    return ToDate(absl::PrevWeekday(day + 1, FirstWeekday(part)));
+  }
+  switch (part) {
+    case YEAR:
+      return ToDate(absl::CivilDay(day.year(), 1, 1));
+    case QUARTER:
+      return ToDate(absl::CivilDay(day.year(), (day.month() - 1) / 3 * 3 + 1));
+    case MONTH:
+      return ToDate(absl::CivilDay(absl::CivilMonth(day)));
+    case DAY:
+      return date;
+    default:
+      ADD_FAILURE() << DateTimestampPart_Name(part);
+      return 0;
+  }
+}
+
+int32_t ExpectedDiff(DateTimestampPart part, int32_t date1, int32_t date2) {
+  const absl::CivilDay day1 = ToCivilDay(date1);
+  const absl::CivilDay day2 = ToCivilDay(date2);
+  if (IsWeekPart(part)) {
+    return (ExpectedTruncate(part, date1) - ExpectedTruncate(part, date2)) / 7;
+  }
+  switch (part) {
+    case DAY:
+      return date1 - date2;
+    case MONTH:
+      return static_cast<int32_t>(absl::CivilMonth(day1) -
+                                  absl::CivilMonth(day2));
+    case QUARTER:
+      return static_cast<int32_t>((day1.year() * 12 + day1.month() - 1) / 3 -
+                                  (day2.year() * 12 + day2.month() - 1) / 3);
+    case YEAR:
+      return static_cast<int32_t>(day1.year() - day2.year());
+    default:
+      ADD_FAILURE() << DateTimestampPart_Name(part);
+      return 0;
+  }
+}
+
+// Returns false if the result is out of range.
+bool ExpectedAdd(DateTimestampPart part, int32_t date, int64_t interval,
+                 int32_t* output) {
+  // AddDate() takes intervals of int32_t.
+  if (interval < std::numeric_limits<int32_t>::min() ||
+      interval > std::numeric_limits<int32_t>::max()) {
+    return false;
+  }
+  const absl::CivilDay day = ToCivilDay(date);
+  int64_t result;
+  if (part == DAY || part == WEEK) {
+    result = date + interval * (part == WEEK ? 7 : 1);
+  } else {
+    const int64_t months_per_interval =
+        part == YEAR ? 12 : (part == QUARTER ? 3 : 1);
+    const absl::CivilMonth month =
+        absl::CivilMonth(day) + interval * months_per_interval;
+    if (month.year() < 1 || month.year() > 9999) return false;
+    const int days_in_month =
+        absl::CivilDay(month + 1) - absl::CivilDay(month);
+    result = ToDate(absl::CivilDay(month.year(), month.month(),
+                                   std::min(day.day(), days_in_month)));
+  }
+  if (result < kMinDate || result > kMaxDate) return false;
+  *output = static_cast<int32_t>(result);
+  return true;
+}
+
+// Every date of the first and last years, and of the years around 2000, and
+// every 13th date in between.
+std::vector<int32_t> TestDates() {
+  const int32_t dense_begin = ToDate(absl::CivilDay(1896, 1, 1));
+  const int32_t dense_end = ToDate(absl::CivilDay(2105, 1, 1));
+  std::vector<int32_t> dates;
+  for (int32_t date = kMinDate; date <= kMaxDate;) {
+    dates.push_back(date);
+    const bool dense = date < kMinDate + 1500 || date > kMaxDate - 1500 ||
+                       (date >= dense_begin && date < dense_end);
+    date += dense ? 1 : 13;
+  }
+  return dates;
+}
+
+std::vector<int32_t> RandomDates(int num_dates, std::mt19937* random) {
+  std::uniform_int_distribution<int32_t> dates(kMinDate, kMaxDate);
+  std::vector<int32_t> result = {kMinDate, kMinDate + 1, kMaxDate,
+                                 kMaxDate - 1, 0, -1};
+  while (result.size() < num_dates) result.push_back(dates(*random));
+  return result;
+}
+
+TEST(DateKernelsTest, ExtractFromDateMatchesCivilDay) {
+  const std::vector<int32_t> dates = TestDates();
+  std::vector<int32_t> output(dates.size());
+  std::vector<DateTimestampPart> parts = {YEAR,      QUARTER,  MONTH,
+                                          DAY,       DAYOFWEEK, DAYOFYEAR};
+  parts.insert(parts.end(), std::begin(kWeekParts), std::end(kWeekParts));
+  for (DateTimestampPart part : parts) {
+    bool may_fail = true;
+    ASSERT_TRUE(ExtractFromDateKernel(part, dates.data(), dates.size(),
+                                      output.data(), &may_fail))
+        << DateTimestampPart_Name(part);
+    EXPECT_FALSE(may_fail);
+    int num_mismatches = 0;
+    for (int i = 0; i < dates.size() && num_mismatches < 10; ++i) {
+      if (output[i] != ExpectedExtract(part, dates[i])) {
+        ++num_mismatches;
+        ADD_FAILURE() << DateTimestampPart_Name(part) << " of "
+                      << ToCivilDay(dates[i]) << ": " << output[i];
+      }
+    }
+  }
+}
+
+TEST(DateKernelsTest, TruncateDateMatchesCivilDay) {
+  const std::vector<int32_t> dates = TestDates();
+  std::vector<int32_t> output(dates.size());
+  std::vector<DateTimestampPart> parts = {YEAR, QUARTER, MONTH, DAY};
+  parts.insert(parts.end(), std::begin(kWeekParts), std::end(kWeekParts));
+  for (DateTimestampPart part : parts) {
+    bool may_fail = false;
+    ASSERT_TRUE(TruncateDateKernel(dates.data(), part, dates.size(),
+                                   output.data(), &may_fail))
+        << DateTimestampPart_Name(part);
+    // 0001-01-01 is a Monday, so for weeks that start on another day it is
+    // in a week that starts before the first valid date.
+    EXPECT_EQ(ExpectedTruncate(part, kMinDate) < kMinDate, may_fail)
+        << DateTimestampPart_Name(part);
+    int num_mismatches = 0;
+    for (int i = 0; i < dates.size() && num_mismatches < 10; ++i) {
+      if (output[i] != ExpectedTruncate(part, dates[i])) {
+        ++num_mismatches;
+        ADD_FAILURE() << DateTimestampPart_Name(part) << " of "
+                      << ToCivilDay(dates[i]) << ": " << output[i];
+      }
+    }
+    int32_t truncated;
+    EXPECT_EQ(ExpectedTruncate(part, kMinDate) >= kMinDate,
+              TruncateDateKernel(kMinDate, part, &truncated))
+        << DateTimestampPart_Name(part);
+  }
+}
+
+TEST(DateKernelsTest, DiffDatesMatchesCivilDay) {
+  std::mt19937 random(12345);
+  const std::vector<int32_t> dates1 = RandomDates(100000, &random);
+  std::vector<int32_t> dates2 = RandomDates(100000, &random);
+  // Also dates near each other.
+  for (int i = 0; i < dates2.size(); i += 2) {
+    dates2[i] =
+        std::max(kMinDate, std::min(kMaxDate, dates1[i] + i % 800 - 400));
+  }
+  std::vector<int32_t> output(dates1.size());
+  std::vector<DateTimestampPart> parts = {YEAR, QUARTER, MONTH, DAY};
+  parts.insert(parts.end(), std::begin(kWeekParts), std::end(kWeekParts));
+  for (DateTimestampPart part : parts) {
+    bool may_fail = true;
+    ASSERT_TRUE(DiffDatesKernel(dates1.data(), dates2.data(), part,
+                                dates1.size(), output.data(), &may_fail))
+        << DateTimestampPart_Name(part);
+    EXPECT_FALSE(may_fail);
+    for (int i = 0; i < dates1.size(); ++i) {
+      ASSERT_EQ(ExpectedDiff(part, dates1[i], dates2[i]), output[i])
+          << DateTimestampPart_Name(part) << " " << ToCivilDay(dates1[i])
+          << " - " << ToCivilDay(dates2[i]);
+    }
+  }
+}
+
+TEST(DateKernelsTest, AddDateMatchesCivilDay) {
+  std::mt19937 random(12345);
+  const std::vector<int32_t> dates = RandomDates(100000, &random);
+  std::uniform_int_distribution<int64_t> small(-50, 50);
+  std::uniform_int_distribution<int64_t> large(-4000000, 4000000);
+  const std::vector<int64_t> extreme = {
+      std::numeric_limits<int64_t>::max(), std::numeric_limits<int64_t>::min(),
+      std::numeric_limits<int32_t>::max(), std::numeric_limits<int32_t>::min(),
+      int64_t{1} << 40, -(int64_t{1} << 40)};
+  std::vector<int64_t> intervals;
+  for (int i = 0; i < dates.size(); ++i) {
+    intervals.push_back(i % 100 < extreme.size()
+                            ? extreme[i % 100]
+                            : (i % 2 == 0 ? small(random) : large(random)));
+  }
+  std::vector<int32_t> output(dates.size());
+  for (DateTimestampPart part : {DAY, WEEK, MONTH, QUARTER, YEAR}) {
+    bool may_fail = false;
+    ASSERT_TRUE(AddDateKernel(dates.data(), part, intervals.data(),
+                              dates.size(), output.data(), &may_fail))
+        << DateTimestampPart_Name(part);
+    EXPECT_TRUE(may_fail);
+    for (int i = 0; i < dates.size(); ++i) {
+      int32_t expected;
+      const bool expected_ok =
+          ExpectedAdd(part, dates[i], intervals[i], &expected);
+      int32_t result;
+      ASSERT_EQ(expected_ok,
+                AddDateKernel(dates[i], part, intervals[i], &result))
+          << DateTimestampPart_Name(part) << " " << ToCivilDay(dates[i])
+          << " + " << intervals[i];
+      if (expected_ok) {
+        ASSERT_EQ(expected, output[i])
+            << DateTimestampPart_Name(part) << " " << ToCivilDay(dates[i])
+            << " + " << intervals[i];
+        ASSERT_EQ(expected, result);
+      }
+    }
+  }
+}
+
+TEST(DateKernelsTest, InvalidDatesMayFail) {
+  int32_t output;
+  for (int32_t date : {kMinDate - 1, kMaxDate + 1,
+                       std::numeric_limits<int32_t>::min(),
+                       std::numeric_limits<int32_t>::max()}) {
+    EXPECT_FALSE(ExtractFromDateKernel(YEAR, date, &output));
+    EXPECT_FALSE(TruncateDateKernel(date, MONTH, &output));
+    EXPECT_FALSE(DiffDatesKernel(date, 0, DAY, &output));
+    EXPECT_FALSE(DiffDatesKernel(0, date, DAY, &output));
+    EXPECT_FALSE(AddDateKernel(date, DAY, 0, &output));
+  }
+}
+
+TEST(DateKernelsTest, PartsLeftToScalarFunctions) {
+  const int32_t date = 0;
+  int32_t output;
+  bool may_fail;
+  for (DateTimestampPart part : {ISOYEAR, ISOWEEK, DATE, HOUR, NANOSECOND}) {
+    EXPECT_FALSE(ExtractFromDateKernel(part, &date, 1, &output, &may_fail));
+    EXPECT_FALSE(TruncateDateKernel(&date, part, 1, &output, &may_fail));
+    EXPECT_FALSE(DiffDatesKernel(&date, &date, part, 1, &output, &may_fail));
+  }
+  const int64_t interval = 1;
+  EXPECT_FALSE(
+      AddDateKernel(&date, WEEK_MONDAY, &interval, 1, &output, &may_fail));
+  EXPECT_FALSE(AddDateKernel(&date, HOUR, &interval, 1, &output, &may_fail));
+}
+
+TEST(DateBatchTest, MatchesScalarFunctions) {
+  std::mt19937 random(12345);
+  const std::vector<int32_t> dates = RandomDates(1000, &random);
+  const std::vector<int32_t> dates2 = RandomDates(1000, &random);
+  const std::vector<int64_t> intervals(dates.size(), 7);
+  std::vector<int32_t> output(dates.size());
+  int64_t error_row;
+  zetasql_base::Status error;
+  // ISOWEEK and ISOYEAR are computed by the scalar functions.
+  for (DateTimestampPart part : {YEAR, MONTH, WEEK_FRIDAY, ISOWEEK, ISOYEAR}) {
+    ASSERT_TRUE(ExtractFromDateBatch(part, dates.data(), nullptr, dates.size(),
+                                     output.data(), &error_row, &error));
+    for (int i = 0; i < dates.size(); ++i) {
+      int32_t expected;
+      ZETASQL_ASSERT_OK(ExtractFromDate(part, dates[i], &expected));
+      EXPECT_EQ(expected, output[i]) << DateTimestampPart_Name(part);
+    }
+    ASSERT_TRUE(DiffDatesBatch(dates.data(), dates2.data(), part, nullptr,
+                               dates.size(), output.data(), &error_row,
+                               &error));
+    for (int i = 0; i < dates.size(); ++i) {
+      int32_t expected;
+      ZETASQL_ASSERT_OK(DiffDates(dates[i], dates2[i], part, &expected));
+      EXPECT_EQ(expected, output[i]) << DateTimestampPart_Name(part);
+    }
+  }
+  ASSERT_TRUE(TruncateDateBatch(dates.data(), ISOYEAR, nullptr, dates.size(),
+                                output.data(), &error_row, &error));
+  for (int i = 0; i < dates.size(); ++i) {
+    int32_t expected;
+    ZETASQL_ASSERT_OK(TruncateDate(dates[i], ISOYEAR, &expected));
+    EXPECT_EQ(expected, output[i]);
+  }
+}
+
+TEST(DateBatchTest, ReportsFirstErrorOfRowsThatAreNotNull) {
+  // Adding a month to 9999-12-31 overflows, but row 1 is NULL.
+  const std::vector<int32_t> dates = {0, kMaxDate, 100, kMaxDate};
+  const std::vector<int64_t> intervals = {1, 1, 1, 1};
+  const uint64_t validity = 0b1101;
+  std::vector<int32_t> output(dates.size());
+  int64_t error_row = -1;
+  zetasql_base::Status error;
+  EXPECT_FALSE(AddDateBatch(dates.data(), MONTH, intervals.data(), &validity,
+                            dates.size(), output.data(), &error_row, &error));
+  EXPECT_EQ(3, error_row);
+  int32_t scalar_output;
+  EXPECT_EQ(AddDate(kMaxDate, MONTH, 1, &scalar_output), error);
+
+  const uint64_t no_errors = 0b0101;
+  EXPECT_TRUE(AddDateBatch(dates.data(), MONTH, intervals.data(), &no_errors,
+                           dates.size(), output.data(), &error_row, &error));
+  EXPECT_EQ(31, output[0]);
+  EXPECT_EQ(130, output[2]);
+
+  // Truncating 0001-01-01 to WEEK gives 0000-12-31.
+  const int32_t min_date = kMinDate;
+  EXPECT_FALSE(TruncateDateBatch(&min_date, WEEK, nullptr, 1, output.data(),
+                                 &error_row, &error));
+  EXPECT_EQ(0, error_row);
+  EXPECT_THAT(error, ::zetasql_base::testing::StatusIs(
+                         zetasql_base::StatusCode::kOutOfRange));
+  EXPECT_FALSE(ExtractFromDateBatch(HOUR, dates.data(), nullptr, dates.size(),
+                                    output.data(), &error_row, &error));
+  EXPECT_EQ(0, error_row);
+}
+
+}  // namespace
+}  // namespace date_time_util_internal
+}  // namespace functions
+}  // namespace zetasql
@@ -0,0 +1,668 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/functions/date_time_format.h"
+
+#include <cstring>
+#include <limits>
+#include <string>
+#include <utility>
+
+#include "zetasql/common/errors.h"
+#include "zetasql/public/functions/date_time_util.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/strip.h"
+#include "absl/time/civil_time.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+namespace functions {
+
+// The values that the elements of a format are rendered from. The fields are
+// those of the civil time in the time zone, normalized as in
+// FormatTimestampToString().
+struct CompiledDateTimeFormat::Fields {
+  absl::CivilSecond civil;
+  int64_t nanos;
+  // Seconds east of UTC, a whole number of minutes.
+  int offset;
+  absl::Time time;
+  absl::TimeZone timezone;
+};
+
+namespace {
+
+// Indexed by absl::Weekday, which starts on Monday.
+constexpr const char* kWeekdayNames[] = {"Monday",   "Tuesday", "Wednesday",
+                                         "Thursday", "Friday",  "Saturday",
+                                         "Sunday"};
+constexpr const char* kMonthNames[] = {
+    "January", "February", "March",     "April",   "May",      "June",
+    "July",    "August",   "September", "October", "November", "December"};
+
+// Appends <value> to <out> as <width> digits, zero padded. Requires that
+// <value> is non-negative and has at most <width> digits.
+void AppendDigits(int64_t value, int width, std::string* out) {
+  char digits[16];
+  for (int i = width - 1; i >= 0; --i) {
+    digits[i] = '0' + value % 10;
+    value /= 10;
+  }
+  out->append(digits, width);
+}
+
+void AppendOffset(int offset, bool colon, std::string* out) {
+  out->push_back(offset < 0 ? '-' : '+');
+  const int minutes = (offset < 0 ? -offset : offset) / 60;
+  AppendDigits(minutes / 60, 2, out);
+  if (colon) out->push_back(':');
+  AppendDigits(minutes % 60, 2, out);
+}
+
+// Appends the ZetaSQL format of %Z, 'UTC[+/-H]' or 'UTC[+/-HHMM]', as
+// internal_functions::ExpandPercentZQ() does.
+void AppendTimeZone(int offset, std::string* out) {
+  out->append("UTC");
+  if (offset == 0) return;
+  out->push_back(offset < 0 ? '-' : '+');
+  const int minutes = (offset < 0 ? -offset : offset) / 60;
+  if (minutes % 60 != 0) {
+    AppendDigits(minutes / 60, 2, out);
+    AppendDigits(minutes % 60, 2, out);
+  } else {
+    absl::StrAppend(out, minutes / 60);
+  }
+}
+
+int Hour12(int hour) { return hour % 12 == 0 ? 12 : hour % 12; }
+
+// Returns the end of the element that starts with the '%' at <pos> of
+// <format>, for an element that absl::FormatTime() interprets: flags, a
+// width, an E or O modifier and a conversion character. A '%' ends the
+// element early, so that it can start the next one.
+size_t FallbackElementEnd(absl::string_view format, size_t pos) {
+  size_t end = pos + 1;
+  while (end < format.size() && strchr("_-0^#", format[end]) != nullptr) ++end;
+  while (end < format.size() && absl::ascii_isdigit(format[end])) ++end;
+  if (end < format.size() && (format[end] == 'E' || format[end] == 'O')) {
+    ++end;
+    while (end < format.size() &&
+           (format[end] == '*' || absl::ascii_isdigit(format[end]))) {
+      ++end;
+    }
+  }
+  if (end < format.size() && format[end] != '%') ++end;
+  return end;
+}
+
+// Consumes a number of at most <max_digits> digits (any number if zero),
+// preceded by '-' if <allow_sign>, from the front of <str>. Returns false if
+// there is none or it is outside [<min>, <max>].
+bool ConsumeNumber(int max_digits, bool allow_sign, int64_t min, int64_t max,
+                   absl::string_view* str, int64_t* value) {
+  bool negative = false;
+  if (allow_sign && !str->empty() && str->front() == '-') {
+    negative = true;
+    str->remove_prefix(1);
+  }
+  int64_t result = 0;
+  int digits = 0;
+  while (!str->empty() && absl::ascii_isdigit(str->front()) &&
+         (max_digits == 0 || digits < max_digits)) {
+    if (result > (std::numeric_limits<int64_t>::max() - (str->front() - '0')) /
+                     10) {
+      return false;
+    }
+    result = result * 10 + (str->front() - '0');
+    str->remove_prefix(1);
+    ++digits;
+  }
+  if (digits == 0) return false;
+  if (negative) result = -result;
+  if (result < min || result > max) return false;
+  *value = result;
+  return true;
+}
+
+// Consumes the value of %z (<colon> false) or %Ez (<colon> true): 'Z', or a
+// sign and two digits of hours, optionally followed by two digits of minutes
+// that are preceded by ':' for %Ez.
+bool ConsumeOffset(bool colon, absl::string_view* str, int* offset) {
+  if (!str->empty() && (str->front() == 'Z' || str->front() == 'z')) {
+    str->remove_prefix(1);
+    *offset = 0;
+    return true;
+  }
+  if (str->empty() || (str->front() != '+' && str->front() != '-')) {
+    return false;
+  }
+  const int sign = str->front() == '-' ? -1 : 1;
+  absl::string_view rest = str->substr(1);
+  int64_t hours;
+  if (rest.size() < 2 || !absl::ascii_isdigit(rest[1]) ||
+      !ConsumeNumber(2, /*allow_sign=*/false, 0, 23, &rest, &hours)) {
+    return false;
+  }
+  int64_t minutes = 0;
+  absl::string_view minutes_str = rest;
+  if (colon && !minutes_str.empty() && minutes_str.front() == ':') {
+    minutes_str.remove_prefix(1);
+  }
+  if (minutes_str.size() >= 2 && absl::ascii_isdigit(minutes_str[0]) &&
+      absl::ascii_isdigit(minutes_str[1]) &&
+      ConsumeNumber(2, /*allow_sign=*/false, 0, 59, &minutes_str, &minutes)) {
+    rest = minutes_str;
+  }
+  *str = rest;
+  *offset = sign * static_cast<int>(hours * 3600 + minutes * 60);
+  return true;
+}
+
+bool ConsumeYear(absl::string_view* str, int64_t* year) {
+  return ConsumeNumber(0, /*allow_sign=*/true,
+                       -std::numeric_limits<int64_t>::max(),
+                       std::numeric_limits<int64_t>::max(), str, year);
+}
+
+void SkipWhitespace(absl::string_view* str) {
+  while (!str->empty() && absl::ascii_isspace(str->front())) {
+    str->remove_prefix(1);
+  }
+}
+
+}  // namespace
+
+CompiledDateTimeFormat::CompiledDateTimeFormat(absl::string_view format_string,
+                                               bool for_date,
+                                               bool expand_quarter)
+    : for_date_(for_date) {
+  if (for_date) {
+    internal_functions::SanitizeDateFormat(format_string, &format_string_);
+  } else {
+    format_string_ = std::string(format_string);
+  }
+  Compile(expand_quarter);
+}
+
+CompiledDateTimeFormat CompiledDateTimeFormat::ForTimestamp(
+    absl::string_view format_string, bool expand_quarter) {
+  return CompiledDateTimeFormat(format_string, /*for_date=*/false,
+                                expand_quarter);
+}
+
+CompiledDateTimeFormat CompiledDateTimeFormat::ForDate(
+    absl::string_view format_string, bool expand_quarter) {
+  return CompiledDateTimeFormat(format_string, /*for_date=*/true,
+                                expand_quarter);
+}
+
+void CompiledDateTimeFormat::Compile(bool expand_quarter) {
+  const absl::string_view format = format_string_;
+  auto add_literal = [this](size_t begin, size_t end) {
+    if (begin == end) return;
+    if (!elements_.empty() && elements_.back().kind == Element::kLiteral &&
+        elements_.back().begin + elements_.back().length == begin) {
+      elements_.back().length += end - begin;
+      return;
+    }
+    Element element;
+    element.kind = Element::kLiteral;
+    element.begin = begin;
+    element.length = end - begin;
+    elements_.push_back(element);
+  };
+
+  size_t literal_begin = 0;
+  size_t pos = 0;
+  while (pos < format.size()) {
+    // As in absl::FormatTime(), a '%' at the end is literal.
+    if (format[pos] != '%' || pos + 1 == format.size()) {
+      ++pos;
+      continue;
+    }
+    add_literal(literal_begin, pos);
+    Element element;
+    element.kind = Element::kFallback;
+    size_t end = pos + 2;
+    switch (format[pos + 1]) {
+      case '%':
+        add_literal(pos + 1, pos + 2);
+        pos = literal_begin = end;
+        continue;
+      case 'Y': element.kind = Element::kYear; break;
+      case 'm': element.kind = Element::kMonth; break;
+      case 'd': element.kind = Element::kDay; break;
+      case 'e': element.kind = Element::kDaySpacePadded; break;
+      case 'H': element.kind = Element::kHour; break;
+      case 'I': element.kind = Element::kHour12; break;
+      case 'M': element.kind = Element::kMinute; break;
+      case 'S': element.kind = Element::kSecond; break;
+      case 'z': element.kind = Element::kOffset; break;
+      case 'F': element.kind = Element::kDate; break;
+      case 'T': element.kind = Element::kTime; break;
+      case 'D': element.kind = Element::kDateSlashes; break;
+      case 'R': element.kind = Element::kHourMinute; break;
+      case 'y': element.kind = Element::kYearOfCentury; break;
+      case 'j': element.kind = Element::kDayOfYear; break;
+      case 'p': element.kind = Element::kAmPm; break;
+      case 'A': element.kind = Element::kWeekdayName; break;
+      case 'a': element.kind = Element::kWeekdayAbbrev; break;
+      case 'B': element.kind = Element::kMonthName; break;
+      case 'b':
+      case 'h': element.kind = Element::kMonthAbbrev; break;
+      case 'u': element.kind = Element::kWeekdayFromMonday; break;
+      case 'w': element.kind = Element::kWeekdayFromSunday; break;
+      case 's': element.kind = Element::kUnixSeconds; break;
+      case 'Z': element.kind = Element::kTimeZone; break;
+      case 'Q':
+        if (expand_quarter) element.kind = Element::kQuarter;
+        break;
+      case 'E': {
+        const absl::string_view extension = format.substr(pos + 2);
+        if (absl::StartsWith(extension, "z")) {
+          element.kind = Element::kOffsetColon;
+          end = pos + 3;
+        } else if (absl::StartsWith(extension, "*S")) {
+          element.kind = Element::kSecondAllDigits;
+          end = pos + 4;
+        } else {
+          size_t digits = 0;
+          while (digits < extension.size() &&
+                 absl::ascii_isdigit(extension[digits])) {
+            ++digits;
+          }
+          // Up to nanoseconds; absl::FormatTime() renders more digits.
+          if (digits == 1 && extension.size() > 1 && extension[1] == 'S') {
+            element.kind = Element::kSecondFraction;
+            element.width = extension[0] - '0';
+            end = pos + 4;
+          }
+        }
+        break;
+      }
+      default:
+        break;
+    }
+    if (element.kind == Element::kFallback) {
+      end = FallbackElementEnd(format, pos);
+      element.fallback = std::string(format.substr(pos, end - pos));
+    }
+    switch (element.kind) {
+      case Element::kYear:
+      case Element::kMonth:
+      case Element::kDay:
+      case Element::kHour:
+      case Element::kMinute:
+      case Element::kSecond:
+      case Element::kSecondAllDigits:
+      case Element::kOffset:
+      case Element::kOffsetColon:
+      case Element::kDate:
+      case Element::kTime:
+        break;
+      case Element::kQuarter:
+      case Element::kTimeZone:
+        has_zetasql_element_ = true;
+        parse_directly_ = false;
+        break;
+      default:
+        parse_directly_ = false;
+        break;
+    }
+    elements_.push_back(std::move(element));
+    pos = literal_begin = end;
+  }
+  add_literal(literal_begin, format.size());
+}
+
+void CompiledDateTimeFormat::Render(const Fields& fields,
+                                    std::string* out) const {
+  const absl::CivilSecond& civil = fields.civil;
+  for (const Element& element : elements_) {
+    switch (element.kind) {
+      case Element::kLiteral:
+        out->append(format_string_, element.begin, element.length);
+        break;
+      case Element::kYear:
+        absl::StrAppend(out, civil.year());
+        break;
+      case Element::kMonth:
+        AppendDigits(civil.month(), 2, out);
+        break;
+      case Element::kDay:
+        AppendDigits(civil.day(), 2, out);
+        break;
+      case Element::kDaySpacePadded:
+        out->push_back(civil.day() < 10
+                           ? ' '
+                           : static_cast<char>('0' + civil.day() / 10));
+        out->push_back(static_cast<char>('0' + civil.day() % 10));
+        break;
+      case Element::kHour:
+        AppendDigits(civil.hour(), 2, out);
+        break;
+      case Element::kHour12:
+        AppendDigits(Hour12(civil.hour()), 2, out);
+        break;
+      case Element::kMinute:
+        AppendDigits(civil.minute(), 2, out);
+        break;
+      case Element::kSecond:
+        AppendDigits(civil.second(), 2, out);
+        break;
+      case Element::kSecondFraction: {
+        AppendDigits(civil.second(), 2, out);
+        if (element.width > 0) {
+          out->push_back('.');
+          int64_t fraction = fields.nanos;
+          for (int i = element.width; i < 9; ++i) fraction /= 10;
+          AppendDigits(fraction, element.width, out);
+        }
+        break;
+      }
+      case Element::kSecondAllDigits: {
+        AppendDigits(civil.second(), 2, out);
+        if (fields.nanos != 0) {
+          int64_t fraction = fields.nanos;
+          int width = 9;
+          while (fraction % 10 == 0) {
+            fraction /= 10;
+            --width;
+          }
+          out->push_back('.');
+          AppendDigits(fraction, width, out);
+        }
+        break;
+      }
+      case Element::kOffset:
+        AppendOffset(fields.offset, /*colon=*/false, out);
+        break;
+      case Element::kOffsetColon:
+        AppendOffset(fields.offset, /*colon=*/true, out);
+        break;
+      case Element::kDate:
+        absl::StrAppend(out, civil.year());
+        out->push_back('-');
+        AppendDigits(civil.month(), 2, out);
+        out->push_back('-');
+        AppendDigits(civil.day(), 2, out);
+        break;
+      case Element::kTime:
+        AppendDigits(civil.hour(), 2, out);
+        out->push_back(':');
+        AppendDigits(civil.minute(), 2, out);
+        out->push_back(':');
+        AppendDigits(civil.second(), 2, out);
+        break;
+      case Element::kDateSlashes:
+        AppendDigits(civil.month(), 2, out);
+        out->push_back('/');
+        AppendDigits(civil.day(), 2, out);
+        out->push_back('/');
+        AppendDigits((civil.year() % 100 + 100) % 100, 2, out);
+        break;
+      case Element::kHourMinute:
+        AppendDigits(civil.hour(), 2, out);
+        out->push_back(':');
+        AppendDigits(civil.minute(), 2, out);
+        break;
+      case Element::kYearOfCentury:
+        AppendDigits((civil.year() % 100 + 100) % 100, 2, out);
+        break;
+      case Element::kDayOfYear:
+        AppendDigits(absl::GetYearDay(absl::CivilDay(civil)), 3, out);
+        break;
+      case Element::kAmPm:
+        out->append(civil.hour() < 12 ? "AM" : "PM");
+        break;
+      case Element::kWeekdayName:
+        out->append(kWeekdayNames[static_cast<int>(
+            absl::GetWeekday(absl::CivilDay(civil)))]);
+        break;
+      case Element::kWeekdayAbbrev:
+        out->append(kWeekdayNames[static_cast<int>(absl::GetWeekday(
+                        absl::CivilDay(civil)))],
+                    3);
+        break;
+      case Element::kMonthName:
+        out->append(kMonthNames[civil.month() - 1]);
+        break;
+      case Element::kMonthAbbrev:
+        out->append(kMonthNames[civil.month() - 1], 3);
+        break;
+      case Element::kWeekdayFromMonday:
+        out->push_back(
+            '1' + static_cast<int>(absl::GetWeekday(absl::CivilDay(civil))));
+        break;
+      case Element::kWeekdayFromSunday:
+        out->push_back(
+            '0' +
+            (static_cast<int>(absl::GetWeekday(absl::CivilDay(civil))) + 1) %
+                7);
+        break;
+      case Element::kUnixSeconds:
+        absl::StrAppend(out, absl::ToUnixSeconds(fields.time));
+        break;
+      case Element::kQuarter:
+        absl::StrAppend(out, (civil.month() - 1) / 3 + 1);
+        break;
+      case Element::kTimeZone:
+        AppendTimeZone(fields.offset, out);
+        break;
+      case Element::kFallback:
+        out->append(
+            absl::FormatTime(element.fallback, fields.time, fields.timezone));
+        break;
+    }
+  }
+}
+
+zetasql_base::Status CompiledDateTimeFormat::FormatTimestamp(
+    absl::Time timestamp, absl::TimeZone timezone, std::string* out) const {
+  if (!IsValidTime(timestamp)) {
+    return MakeEvalError() << "Invalid timestamp value: "
+                           << absl::ToUnixMicros(timestamp);
+  }
+  absl::TimeZone::CivilInfo info = timezone.At(timestamp);
+  // Sub-minute offsets are truncated to minutes, as in
+  // FormatTimestampToString().
+  if (const int seconds_offset = info.offset % 60) {
+    timezone = absl::FixedTimeZone(info.offset - seconds_offset);
+    info = timezone.At(timestamp);
+  }
+  Fields fields;
+  fields.civil = info.cs;
+  fields.nanos = absl::ToInt64Nanoseconds(info.subsecond);
+  fields.offset = info.offset;
+  fields.time = timestamp;
+  fields.timezone = timezone;
+  out->clear();
+  Render(fields, out);
+  return zetasql_base::OkStatus();
+}
+
+zetasql_base::Status CompiledDateTimeFormat::FormatTimestamp(
+    int64_t timestamp, absl::TimeZone timezone, std::string* out) const {
+  return FormatTimestamp(absl::FromUnixMicros(timestamp), timezone, out);
+}
+
+zetasql_base::Status CompiledDateTimeFormat::FormatDate(int32_t date,
+                                                std::string* out) const {
+  ZETASQL_RET_CHECK(for_date_) << "Not a date format: " << format_string_;
+  if (!IsValidDate(date)) {
+    return MakeEvalError() << "Invalid date value: " << date;
+  }
+  // Midnight UTC on that date, without looking up the civil time.
+  Fields fields;
+  fields.civil = absl::CivilSecond(absl::CivilDay(1970, 1, 1) + date);
+  fields.nanos = 0;
+  fields.offset = 0;
+  fields.time = absl::FromUnixSeconds(static_cast<int64_t>(date) * 86400);
+  fields.timezone = absl::UTCTimeZone();
+  out->clear();
+  Render(fields, out);
+  return zetasql_base::OkStatus();
+}
+
+zetasql_base::Status CompiledDateTimeFormat::ParseTimestamp(
+    absl::string_view str, absl::TimeZone default_timezone,
+    absl::Time* timestamp) const {
+  if (has_zetasql_element_) {
+    return MakeEvalError() << "Format elements %Q and %Z are not supported "
+                              "for parsing: "
+                           << format_string_;
+  }
+  if (parse_directly_) {
+    ZETASQL_RETURN_IF_ERROR(ParseDirectly(str, default_timezone, timestamp));
+  } else {
+    std::string error;
+    if (!absl::ParseTime(format_string_, std::string(str), default_timezone,
+                         timestamp, &error)) {
+      return MakeEvalError() << "Failed to parse input string \"" << str
+                             << "\": " << error;
+    }
+  }
+  if (!IsValidTime(*timestamp)) {
+    return MakeEvalError() << "Timestamp is out of range: \"" << str << "\"";
+  }
+  return zetasql_base::OkStatus();
+}
+
+// Matches the elements against <str> as absl::ParseTime() does: whitespace in
+// the format matches any whitespace, as does leading and trailing whitespace,
+// numbers have at most two digits except for the year, and fields that are not
+// in the format default to 1970-01-01 00:00:00. Fractional seconds are
+// truncated to nanoseconds.
+zetasql_base::Status CompiledDateTimeFormat::ParseDirectly(
+    absl::string_view str, absl::TimeZone default_timezone,
+    absl::Time* timestamp) const {
+  int64_t year = 1970, month = 1, day = 1, hour = 0, minute = 0, second = 0;
+  int64_t nanos = 0;
+  int offset = 0;
+  bool has_offset = false;
+
+  absl::string_view input = str;
+  SkipWhitespace(&input);
+  auto consume_date = [&input, &year, &month, &day]() {
+    return ConsumeYear(&input, &year) &&
+           absl::ConsumePrefix(&input, "-") &&
+           ConsumeNumber(2, /*allow_sign=*/false, 1, 12, &input, &month) &&
+           absl::ConsumePrefix(&input, "-") &&
+           ConsumeNumber(2, /*allow_sign=*/false, 1, 31, &input, &day);
+  };
+  auto consume_time = [&input, &hour, &minute, &second]() {
+    return ConsumeNumber(2, /*allow_sign=*/false, 0, 23, &input, &hour) &&
+           absl::ConsumePrefix(&input, ":") &&
+           ConsumeNumber(2, /*allow_sign=*/false, 0, 59, &input, &minute) &&
+           absl::ConsumePrefix(&input, ":") &&
+           ConsumeNumber(2, /*allow_sign=*/false, 0, 60, &input, &second);
+  };
+
+  for (const Element& element : elements_) {
+    bool ok = true;
+    switch (element.kind) {
+      case Element::kLiteral:
+        for (const char c : absl::string_view(format_string_).substr(
+                 element.begin, element.length)) {
+          if (absl::ascii_isspace(c)) {
+            SkipWhitespace(&input);
+          } else if (input.empty() || input.front() != c) {
+            ok = false;
+            break;
+          } else {
+            input.remove_prefix(1);
+          }
+        }
+        break;
+      case Element::kYear:
+        ok = ConsumeYear(&input, &year);
+        break;
+      case Element::kMonth:
+        ok = ConsumeNumber(2, /*allow_sign=*/false, 1, 12, &input, &month);
+        break;
+      case Element::kDay:
+        ok = ConsumeNumber(2, /*allow_sign=*/false, 1, 31, &input, &day);
+        break;
+      case Element::kHour:
+        ok = ConsumeNumber(2, /*allow_sign=*/false, 0, 23, &input, &hour);
+        break;
+      case Element::kMinute:
+        ok = ConsumeNumber(2, /*allow_sign=*/false, 0, 59, &input, &minute);
+        break;
+      case Element::kSecond:
+        ok = ConsumeNumber(2, /*allow_sign=*/false, 0, 60, &input, &second);
+        break;
+      case Element::kSecondAllDigits:
+        ok = ConsumeNumber(2, /*allow_sign=*/false, 0, 60, &input, &second);
+        if (ok && absl::ConsumePrefix(&input, ".")) {
+          int digits = 0;
+          nanos = 0;
+          while (!input.empty() && absl::ascii_isdigit(input.front())) {
+            if (digits < 9) nanos = nanos * 10 + (input.front() - '0');
+            input.remove_prefix(1);
+            ++digits;
+          }
+          for (int i = digits; i < 9; ++i) nanos *= 10;
+          ok = digits > 0;
+        }
+        break;
+      case Element::kOffset:
+      case Element::kOffsetColon:
+        ok = ConsumeOffset(element.kind == Element::kOffsetColon, &input,
+                           &offset);
+        has_offset = true;
+        break;
+      case Element::kDate:
+        ok = consume_date();
+        break;
+      case Element::kTime:
+        ok = consume_time();
+        break;
+      default:
+        ZETASQL_RET_CHECK_FAIL() << "Element cannot be parsed directly: "
+                         << element.kind;
+    }
+    if (!ok) {
+      return MakeEvalError() << "Failed to parse input string \"" << str
+                             << "\" with format \"" << format_string_ << "\"";
+    }
+  }
+  SkipWhitespace(&input);
+  if (!input.empty()) {
+    return MakeEvalError() << "Illegal trailing data in input string \"" << str
+                           << "\" for format \"" << format_string_ << "\"";
+  }
+
+  // A leap second is the first second of the next minute.
+  const bool leap_second = second == 60;
+  const absl::CivilSecond civil(year, month, day, hour, minute,
+                                leap_second ? 59 : second);
+  if (civil.year() != year || civil.month() != month || civil.day() != day) {
+    return MakeEvalError() << "Out-of-range field in input string \"" << str
+                           << "\"";
+  }
+  *timestamp = has_offset ? absl::FromCivil(civil, absl::FixedTimeZone(offset))
+                          : default_timezone.At(civil).pre;
+  if (leap_second) *timestamp += absl::Seconds(1);
+  *timestamp += absl::Nanoseconds(nanos);
+  return zetasql_base::OkStatus();
+}
+
+}  // namespace functions
+}  // namespace zetasql
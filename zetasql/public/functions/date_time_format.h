@@ -0,0 +1,160 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef ZETASQL_PUBLIC_FUNCTIONS_DATE_TIME_FORMAT_H_
+#define ZETASQL_PUBLIC_FUNCTIONS_DATE_TIME_FORMAT_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+namespace functions {
+
+// A FORMAT_TIMESTAMP() or FORMAT_DATE() format string that is parsed once,
+// for callers that format many values with the same format, e.g. when the
+// format argument of a query is a constant.
+//
+// FormatTimestampToString() and FormatDateToString() rewrite the format
+// string for %Q and %Z and then have absl::FormatTime() scan it again for
+// each value. A CompiledDateTimeFormat instead splits the format string into
+// a list of elements up front, and renders the common ones (the numeric
+// fields, fractional seconds, offsets, %Q, %Z and the en-US names of days
+// and months) directly into the output string, which is cleared but keeps its
+// capacity, so formatting into a reused string does not allocate. Other
+// elements are passed to absl::FormatTime() one at a time. The output is the
+// same as that of the corresponding function in date_time_util.h.
+//
+// Example:
+//   const CompiledDateTimeFormat format =
+//       CompiledDateTimeFormat::ForTimestamp("%Y-%m-%d %H:%M:%E*S %Z");
+//   std::string output;
+//   for (absl::Time timestamp : timestamps) {
+//     ZETASQL_RETURN_IF_ERROR(format.FormatTimestamp(timestamp, timezone, &output));
+//     ...
+//   }
+//
+// This class is thread-compatible; const methods may be called concurrently.
+class CompiledDateTimeFormat {
+ public:
+  // Compiles <format_string> as for FormatTimestampToString(). See there for
+  // <expand_quarter>.
+  static CompiledDateTimeFormat ForTimestamp(absl::string_view format_string,
+                                             bool expand_quarter = true);
+
+  // Compiles <format_string> as for FormatDateToString(), so that the
+  // elements for hours, minutes, seconds and time zones are output as is.
+  static CompiledDateTimeFormat ForDate(absl::string_view format_string,
+                                        bool expand_quarter = true);
+
+  // Same as FormatTimestampToString() with the compiled format string.
+  zetasql_base::Status FormatTimestamp(absl::Time timestamp, absl::TimeZone timezone,
+                               std::string* out) const;
+  // Same as above, with <timestamp> in microseconds from 1970-01-01 UTC.
+  zetasql_base::Status FormatTimestamp(int64_t timestamp, absl::TimeZone timezone,
+                               std::string* out) const;
+
+  // Same as FormatDateToString() with the compiled format string. Requires
+  // that this format was compiled by ForDate().
+  zetasql_base::Status FormatDate(int32_t date, std::string* out) const;
+
+  // Parses <str> with the compiled format string as absl::ParseTime() does,
+  // with <default_timezone> applying unless <str> has an offset for %z or
+  // %Ez. Formats made of literal text and %Y, %m, %d, %H, %M, %S, %E*S, %z,
+  // %Ez, %F, %T and %% are matched directly against <str>, and others are
+  // passed to absl::ParseTime(). Returns an error if <str> does not match
+  // the format, if the format has %Q or %Z, or if the result is not a valid
+  // timestamp.
+  zetasql_base::Status ParseTimestamp(absl::string_view str,
+                              absl::TimeZone default_timezone,
+                              absl::Time* timestamp) const;
+
+  const std::string& format_string() const { return format_string_; }
+
+ private:
+  struct Element {
+    enum Kind {
+      kLiteral,            // text, or % for %%
+      kYear,               // %Y
+      kMonth,              // %m
+      kDay,                // %d
+      kDaySpacePadded,     // %e
+      kHour,               // %H
+      kHour12,             // %I
+      kMinute,             // %M
+      kSecond,             // %S
+      kSecondFraction,     // %E<width>S
+      kSecondAllDigits,    // %E*S
+      kOffset,             // %z
+      kOffsetColon,        // %Ez
+      kDate,               // %F
+      kTime,               // %T
+      kDateSlashes,        // %D
+      kHourMinute,         // %R
+      kYearOfCentury,      // %y
+      kDayOfYear,          // %j
+      kAmPm,               // %p
+      kWeekdayName,        // %A
+      kWeekdayAbbrev,      // %a
+      kMonthName,          // %B
+      kMonthAbbrev,        // %b and %h
+      kWeekdayFromMonday,  // %u
+      kWeekdayFromSunday,  // %w
+      kUnixSeconds,        // %s
+      kQuarter,            // %Q
+      kTimeZone,           // %Z
+      kFallback,           // anything else, passed to absl::FormatTime()
+    };
+
+    Kind kind;
+    // The text of a kLiteral, as a range of format_string_.
+    int begin = 0;
+    int length = 0;
+    // The number of fractional digits of a kSecondFraction.
+    int width = 0;
+    // The format element of a kFallback.
+    std::string fallback;
+  };
+  struct Fields;
+
+  CompiledDateTimeFormat(absl::string_view format_string, bool for_date,
+                         bool expand_quarter);
+
+  void Compile(bool expand_quarter);
+  void Render(const Fields& fields, std::string* out) const;
+  zetasql_base::Status ParseDirectly(absl::string_view str,
+                             absl::TimeZone default_timezone,
+                             absl::Time* timestamp) const;
+
+  // The format string after escaping the elements that do not apply, which
+  // literal elements refer to.
+  std::string format_string_;
+  bool for_date_;
+  std::vector<Element> elements_;
+  // True if ParseTimestamp() can match every element directly.
+  bool parse_directly_ = true;
+  bool has_zetasql_element_ = false;
+};
+
+}  // namespace functions
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_FUNCTIONS_DATE_TIME_FORMAT_H_
@@ -0,0 +1,230 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/functions/date_time_format.h"
+
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/functions/date_time_util.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/time/civil_time.h"
+#include "absl/time/time.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+namespace functions {
+namespace {
+
+using ::zetasql_base::testing::StatusIs;
+
+const char* const kFormats[] = {
+    "",
+    "literal text",
+    "%Y-%m-%d %H:%M:%S",
+    "%Y-%m-%d %H:%M:%E*S%Ez",
+    "%F %T %z",
+    "%E0S %E3S %E6S %E9S %E12S",
+    "%e %j %y %D %R %I %p",
+    "%A %a %B %b %h %u %w",
+    "%s",
+    "Q%Q %Z",
+    "%%Q %%Z %%%Y %% %",
+    "%c %x %X %U %W %V %G %g %C %k %l %r %E4Y %Ey %Ec %Oy",
+    "%-d %_m %5Y %E*z %EQ %E3Q %E%d",
+    "%Y%m%d%H%M%S",
+    "%H:%M %n%t",
+};
+
+std::vector<absl::Time> TestTimes() {
+  const absl::TimeZone utc = absl::UTCTimeZone();
+  return {
+      absl::FromCivil(absl::CivilSecond(1970, 1, 1, 0, 0, 0), utc),
+      absl::FromCivil(absl::CivilSecond(2019, 3, 10, 2, 30, 15), utc) +
+          absl::Microseconds(123456),
+      absl::FromCivil(absl::CivilSecond(2000, 12, 31, 23, 59, 59), utc) +
+          absl::Nanoseconds(120),
+      absl::FromCivil(absl::CivilSecond(1, 1, 1, 0, 0, 0), utc),
+      absl::FromCivil(absl::CivilSecond(1883, 7, 4, 12, 0, 5), utc) +
+          absl::Milliseconds(5),
+      absl::FromCivil(absl::CivilSecond(9999, 12, 31, 23, 59, 59), utc) +
+          absl::Microseconds(999999),
+  };
+}
+
+std::vector<absl::TimeZone> TestTimeZones() {
+  std::vector<absl::TimeZone> timezones = {absl::UTCTimeZone(),
+                                           absl::FixedTimeZone(-8 * 3600),
+                                           absl::FixedTimeZone(5 * 3600 + 1800),
+                                           absl::FixedTimeZone(-3600 - 90)};
+  absl::TimeZone los_angeles;
+  if (absl::LoadTimeZone("America/Los_Angeles", &los_angeles)) {
+    timezones.push_back(los_angeles);
+  }
+  return timezones;
+}
+
+TEST(CompiledDateTimeFormatTest, FormatTimestampMatchesFormatTimestampToString) {
+  for (const char* format_string : kFormats) {
+    for (bool expand_quarter : {true, false}) {
+      const CompiledDateTimeFormat format =
+          CompiledDateTimeFormat::ForTimestamp(format_string, expand_quarter);
+      for (absl::Time time : TestTimes()) {
+        for (absl::TimeZone timezone : TestTimeZones()) {
+          std::string expected;
+          ZETASQL_ASSERT_OK(FormatTimestampToString(format_string, time, timezone,
+                                            expand_quarter, &expected));
+          std::string output = "previous output";
+          ZETASQL_ASSERT_OK(format.FormatTimestamp(time, timezone, &output));
+          EXPECT_EQ(expected, output)
+              << "format: " << format_string << " time: " << time
+              << " timezone: " << timezone.name();
+        }
+      }
+    }
+  }
+}
+
+TEST(CompiledDateTimeFormatTest, FormatDateMatchesFormatDateToString) {
+  const std::vector<int32_t> dates = {0, -1, 17966, -719162, 2932896, 11016};
+  for (const char* format_string : kFormats) {
+    const CompiledDateTimeFormat format =
+        CompiledDateTimeFormat::ForDate(format_string);
+    for (int32_t date : dates) {
+      std::string expected;
+      ZETASQL_ASSERT_OK(FormatDateToString(format_string, date, &expected));
+      std::string output;
+      ZETASQL_ASSERT_OK(format.FormatDate(date, &output));
+      EXPECT_EQ(expected, output)
+          << "format: " << format_string << " date: " << date;
+    }
+  }
+}
+
+TEST(CompiledDateTimeFormatTest, MicrosecondTimestamps) {
+  const CompiledDateTimeFormat format =
+      CompiledDateTimeFormat::ForTimestamp("%F %H:%M:%E6S");
+  std::string output;
+  ZETASQL_ASSERT_OK(format.FormatTimestamp(int64_t{1553225415123456},
+                                   absl::UTCTimeZone(), &output));
+  EXPECT_EQ("2019-03-22 03:30:15.123456", output);
+}
+
+TEST(CompiledDateTimeFormatTest, ReusesOutputBuffer) {
+  const CompiledDateTimeFormat format =
+      CompiledDateTimeFormat::ForTimestamp("%Y-%m-%d %H:%M:%E*S %Z");
+  std::string output;
+  output.reserve(64);
+  const char* data = output.data();
+  for (absl::Time time : TestTimes()) {
+    ZETASQL_ASSERT_OK(format.FormatTimestamp(time, absl::UTCTimeZone(), &output));
+    EXPECT_EQ(data, output.data());
+  }
+}
+
+TEST(CompiledDateTimeFormatTest, Errors) {
+  const CompiledDateTimeFormat timestamp_format =
+      CompiledDateTimeFormat::ForTimestamp("%Y");
+  std::string output;
+  EXPECT_THAT(timestamp_format.FormatTimestamp(absl::InfiniteFuture(),
+                                               absl::UTCTimeZone(), &output),
+              StatusIs(zetasql_base::StatusCode::kOutOfRange));
+  EXPECT_THAT(timestamp_format.FormatDate(0, &output),
+              StatusIs(zetasql_base::StatusCode::kInternal));
+
+  const CompiledDateTimeFormat date_format =
+      CompiledDateTimeFormat::ForDate("%Y");
+  EXPECT_THAT(date_format.FormatDate(2932897, &output),
+              StatusIs(zetasql_base::StatusCode::kOutOfRange));
+}
+
+TEST(CompiledDateTimeFormatTest, ParseTimestampMatchesParseTime) {
+  absl::TimeZone los_angeles;
+  ASSERT_TRUE(absl::LoadTimeZone("America/Los_Angeles", &los_angeles));
+  struct ParseTest {
+    const char* format;
+    const char* input;
+  };
+  const std::vector<ParseTest> tests = {
+      {"%Y-%m-%d", "2019-01-02"},
+      {"%Y-%m-%d", " 2019-1-2 "},
+      {"%Y-%m-%d", "0002019-01-02"},
+      {"%Y-%m-%d %H:%M:%S", "2019-03-10 02:30:00"},
+      {"%Y-%m-%d %H:%M:%S", "2019-11-03 01:30:00"},
+      {"%F %T", "2019-12-31 23:59:60"},
+      {"%F %H:%M:%E*S", "2019-12-31 23:59:59.5"},
+      {"%F %H:%M:%E*S", "2019-12-31 23:59:59.123456789"},
+      {"%F %H:%M:%E*S", "2019-12-31 23:59:59"},
+      {"%F %T%z", "2019-12-31 23:59:59+0530"},
+      {"%F %T %z", "2019-12-31 23:59:59 -08"},
+      {"%F %T %z", "2019-12-31 23:59:59 Z"},
+      {"%F %T %Ez", "2019-12-31 23:59:59 +05:30"},
+      {"%F %T %Ez", "2019-12-31 23:59:59 -0100"},
+      {"%Y %m", "2019 \t 03"},
+      {"%%%Y", "%2019"},
+      {"%Y-%m-%d", "2019-02-30"},
+      {"%Y-%m-%d", "2019-13-01"},
+      {"%Y-%m-%d", "2019- 2-03"},
+      {"%Y-%m-%d", "+2019-01-02"},
+      {"%Y-%m-%d", "2019-01-02x"},
+      {"%F %H:%M:%E*S", "2019-12-31 23:59:59."},
+      {"%T %z", "01:02:03 +05:30"},
+      {"%T %z", "01:02:03 +0560"},
+      {"%T %z", "01:02:03 +2400"},
+      {"%H:%M:%S", "24:00:00"},
+      {"%Y%m%d", "20190304"},
+      {"%Y", "10000"},
+      // Passed to absl::ParseTime().
+      {"%d %b %Y", "04 Mar 2019"},
+      {"%F %H:%M:%E3S", "2019-12-31 23:59:59.123"},
+  };
+  for (const ParseTest& test : tests) {
+    const CompiledDateTimeFormat format =
+        CompiledDateTimeFormat::ForTimestamp(test.format);
+    absl::Time expected;
+    std::string error;
+    const bool expected_ok =
+        absl::ParseTime(test.format, test.input, los_angeles, &expected,
+                        &error) &&
+        IsValidTime(expected);
+    absl::Time parsed;
+    const zetasql_base::Status status =
+        format.ParseTimestamp(test.input, los_angeles, &parsed);
+    EXPECT_EQ(expected_ok, status.ok())
+        << "format: " << test.format << " input: " << test.input << " "
+        << status;
+    if (expected_ok && status.ok()) {
+      EXPECT_EQ(expected, parsed)
+          << "format: " << test.format << " input: " << test.input;
+    }
+  }
+}
+
+TEST(CompiledDateTimeFormatTest, ParseTimestampRejectsZetaSqlElements) {
+  absl::Time parsed;
+  EXPECT_THAT(CompiledDateTimeFormat::ForTimestamp("%Y Q%Q")
+                  .ParseTimestamp("2019 Q1", absl::UTCTimeZone(), &parsed),
+              StatusIs(zetasql_base::StatusCode::kOutOfRange));
+  EXPECT_THAT(CompiledDateTimeFormat::ForTimestamp("%Y %Z")
+                  .ParseTimestamp("2019 UTC", absl::UTCTimeZone(), &parsed),
+              StatusIs(zetasql_base::StatusCode::kOutOfRange));
+}
+
+}  // namespace
+}  // namespace functions
+}  // namespace zetasql
@@ -16,19 +16,26 @@
 
 #include "zetasql/public/functions/date_time_util.h"
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdlib>
 #include <cstring>
 #include <functional>
 #include <limits>
 #include <memory>
 #include <string>
+#include <utility>
 
 #include "zetasql/base/logging.h"
 #include "zetasql/common/errors.h"
 #include "zetasql/public/functions/arithmetics.h"
+#include "zetasql/public/functions/batch_kernels.h"
+#include "zetasql/public/functions/date_kernels.h"
 #include "zetasql/public/functions/date_time_util_internal.h"
+#include "zetasql/public/functions/time_zone_cache.h"
 #include "zetasql/public/type.h"
 #include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/strip.h"
@@ -36,6 +43,7 @@
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "zetasql/base/mathutil.h"
+#include "zetasql/base/no_destructor.h"
 #include "zetasql/base/ret_check.h"
 #include "zetasql/base/status_macros.h"
 #include "zetasql/base/statusor.h"
@@ -67,6 +75,43 @@ absl::CivilDay EpochDaysToCivilDay(int32_t days_since_epoch) {
   return kEpochDay + days_since_epoch;
 }
 
+constexpr char kTwoDigits[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// Writes the two decimal digits of <x> < 100 to <out> and returns the
+// position after them.
+inline char* WriteTwoDigits(int x, char* out) {
+  memcpy(out, &kTwoDigits[2 * x], 2);
+  return out + 2;
+}
+
+// Sets the civil date of <days> since the epoch, in the proleptic Gregorian
+// calendar, with only integer arithmetic on 400-year eras that start on
+// March 1 so that the leap day is the last day of a year.
+inline void CivilFromEpochDays(int64_t days, int* year, int* month, int* day) {
+  const int64_t shifted = days + 719468;  // Days since 0000-03-01.
+  const int64_t era = (shifted >= 0 ? shifted : shifted - 146096) / 146097;
+  const int day_of_era = static_cast<int>(shifted - era * 146097);
+  const int year_of_era = (day_of_era - day_of_era / 1460 +
+                           day_of_era / 36524 - day_of_era / 146096) /
+                          365;
+  const int day_of_year =
+      day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+  const int shifted_month = (5 * day_of_year + 2) / 153;  // 0 is March.
+  *day = day_of_year - (153 * shifted_month + 2) / 5 + 1;
+  *month = shifted_month < 10 ? shifted_month + 3 : shifted_month - 9;
+  *year = static_cast<int>(era * 400) + year_of_era + (*month <= 2 ? 1 : 0);
+}
+
 }  // namespace
 
 bool IsValidDate(int32_t date) {
@@ -1114,6 +1159,18 @@ static zetasql_base::Status ConvertTimestampToStringInternal(
     bool truncate_trailing_zeros, std::string* out) {
   // When converting timestamp to std::string the result has 0, 3, or 6 digits
   // with trailing sets of three zeros truncated.
+  int offset_seconds;
+  if (scale == kMicroseconds && truncate_trailing_zeros &&
+      GetFixedTimeZoneOffset(timezone, &offset_seconds)) {
+    char buffer[kMaxCanonicalTimestampLength];
+    const int length =
+        FormatTimestampMicrosToBuffer(timestamp, offset_seconds, buffer);
+    // Invalid timestamps get the error of the general path.
+    if (length > 0) {
+      out->assign(buffer, length);
+      return ::zetasql_base::OkStatus();
+    }
+  }
   if (truncate_trailing_zeros) {
     NarrowTimestampIfPossible(&timestamp, &scale);
   }
@@ -1731,6 +1788,72 @@ zetasql_base::Status ConvertTimestampToStringWithTruncation(
                                                 out);
 }
 
+bool GetFixedTimeZoneOffset(absl::TimeZone timezone, int* offset_seconds) {
+  if (timezone != absl::UTCTimeZone() &&
+      !absl::StartsWith(timezone.name(), "Fixed/")) {
+    return false;
+  }
+  const int offset = timezone.At(absl::UnixEpoch()).offset;
+  *offset_seconds = offset - offset % 60;
+  return true;
+}
+
+int FormatTimestampMicrosToBuffer(int64_t timestamp, int offset_seconds,
+                                  char* buffer) {
+  if (!IsValidTimestamp(timestamp, kMicroseconds)) return 0;
+  DCHECK_EQ(offset_seconds % 60, 0);
+  DCHECK(IsValidTimeZone(offset_seconds / 60));
+  const int64_t local_micros =
+      timestamp + int64_t{offset_seconds} * 1000 * 1000;
+  int64_t days = local_micros / kNaiveNumMicrosPerDay;
+  int64_t micros_of_day = local_micros % kNaiveNumMicrosPerDay;
+  if (micros_of_day < 0) {
+    micros_of_day += kNaiveNumMicrosPerDay;
+    --days;
+  }
+  int year, month, day;
+  CivilFromEpochDays(days, &year, &month, &day);
+  const int64_t seconds_of_day = micros_of_day / 1000000;
+  const int subsecond = static_cast<int>(micros_of_day % 1000000);
+
+  // The local year is 0000 to 10000 for valid timestamps and offsets.
+  char* out = buffer;
+  if (year >= 10000) *out++ = static_cast<char>('0' + year / 10000);
+  out = WriteTwoDigits(year / 100 % 100, out);
+  out = WriteTwoDigits(year % 100, out);
+  *out++ = '-';
+  out = WriteTwoDigits(month, out);
+  *out++ = '-';
+  out = WriteTwoDigits(day, out);
+  *out++ = ' ';
+  out = WriteTwoDigits(static_cast<int>(seconds_of_day / 3600), out);
+  *out++ = ':';
+  out = WriteTwoDigits(static_cast<int>(seconds_of_day / 60 % 60), out);
+  *out++ = ':';
+  out = WriteTwoDigits(static_cast<int>(seconds_of_day % 60), out);
+  // As in ConvertTimestampToStringWithTruncation(), there are 0, 3 or 6
+  // fractional digits.
+  if (subsecond != 0) {
+    *out++ = '.';
+    out = WriteTwoDigits(subsecond / 10000, out);
+    out = WriteTwoDigits(subsecond / 100 % 100, out);
+    if (subsecond % 1000 == 0) {
+      --out;
+    } else {
+      out = WriteTwoDigits(subsecond % 100, out);
+    }
+  }
+  // The offset is "+HH:MM", without ":00", as %Ez with the ":00" removed.
+  const int offset_minutes = std::abs(offset_seconds) / 60;
+  *out++ = offset_seconds < 0 ? '-' : '+';
+  out = WriteTwoDigits(offset_minutes / 60, out);
+  if (offset_minutes % 60 != 0) {
+    *out++ = ':';
+    out = WriteTwoDigits(offset_minutes % 60, out);
+  }
+  return static_cast<int>(out - buffer);
+}
+
 zetasql_base::Status ConvertTimeToString(TimeValue time, TimestampScale scale,
                                  std::string* out) {
   ZETASQL_RET_CHECK(scale == kMicroseconds || scale == kNanoseconds)
@@ -1997,8 +2120,8 @@ zetasql_base::Status ConvertTimestampToString(absl::Time input, TimestampScale s
   return ConvertTimestampToString(input, scale, timezone, output);
 }
 
-zetasql_base::Status MakeTimeZone(absl::string_view timezone_string,
-                          absl::TimeZone* timezone) {
+static zetasql_base::Status MakeTimeZoneUncached(
+    absl::string_view timezone_string, absl::TimeZone* timezone) {
   // An empty time zone is an error.  There is no inherent default.
   if (timezone_string.empty()) {
     return MakeEvalError() << "Invalid empty time zone";
@@ -2029,6 +2152,24 @@ zetasql_base::Status MakeTimeZone(absl::string_view timezone_string,
   return ::zetasql_base::OkStatus();
 }
 
+// Time zone strings come from SQL function arguments and are usually the same
+// for every row, so they are parsed and loaded only once per process.
+static zetasql_base::Status LookupCachedTimeZone(
+    absl::string_view timezone_string,
+    const date_time_util_internal::CachedTimeZone** cached) {
+  static zetasql_base::NoDestructor<date_time_util_internal::TimeZoneCache> cache(
+      &MakeTimeZoneUncached);
+  return cache->Lookup(timezone_string, cached);
+}
+
+zetasql_base::Status MakeTimeZone(absl::string_view timezone_string,
+                          absl::TimeZone* timezone) {
+  const date_time_util_internal::CachedTimeZone* cached;
+  ZETASQL_RETURN_IF_ERROR(LookupCachedTimeZone(timezone_string, &cached));
+  *timezone = cached->timezone();
+  return ::zetasql_base::OkStatus();
+}
+
 zetasql_base::Status ConvertStringToDate(absl::string_view str, int32_t* date) {
   int year = 0, month = 0, day = 0, idx = 0;
   if (!ParseStringToDateParts(str, &idx, &year, &month, &day) ||
@@ -2115,6 +2256,129 @@ zetasql_base::Status ConvertStringToTimestamp(absl::string_view str,
   return ::zetasql_base::OkStatus();
 }
 
+// Parses the two digits at offset <idx> of <str> into <value>.
+static bool ParseTwoDigits(absl::string_view str, int idx, int* value) {
+  if (!CheckRemainingLength(str, idx, 2 /* remaining_length */) ||
+      !absl::ascii_isdigit(str[idx]) || !absl::ascii_isdigit(str[idx + 1])) {
+    return false;
+  }
+  *value = (str[idx] - '0') * 10 + (str[idx + 1] - '0');
+  return true;
+}
+
+// Converts <str> to <timestamp> if it is of the fixed form of
+// TimestampStringFormat::kFixedIso8601, without looking up time zones or
+// creating a Status. Returns false if it is not of that form or does not
+// convert, in which case ConvertStringToTimestamp() decides. Every string
+// converted here converts to the same timestamp there.
+static bool ConvertFixedIso8601StringToTimestamp(
+    absl::string_view str, absl::TimeZone default_timezone,
+    TimestampScale scale, bool allow_tz_in_str, int64_t* timestamp) {
+  int century, year_of_century, month, day;
+  if (!ParseTwoDigits(str, 0, &century) ||
+      !ParseTwoDigits(str, 2, &year_of_century) ||
+      !CheckRemainingLength(str, 4, 6 /* remaining_length */) ||
+      str[4] != '-' || !ParseTwoDigits(str, 5, &month) || str[7] != '-' ||
+      !ParseTwoDigits(str, 8, &day)) {
+    return false;
+  }
+  int hour = 0, minute = 0, second = 0, subsecond = 0;
+  int idx = 10;
+  if (idx < static_cast<int64_t>(str.length())) {
+    if ((str[idx] != ' ' && str[idx] != 'T' && str[idx] != 't') ||
+        !CheckRemainingLength(str, idx, 9 /* remaining_length */) ||
+        !ParseTwoDigits(str, idx + 1, &hour) || str[idx + 3] != ':' ||
+        !ParseTwoDigits(str, idx + 4, &minute) || str[idx + 6] != ':' ||
+        !ParseTwoDigits(str, idx + 7, &second)) {
+      return false;
+    }
+    idx += 9;
+    if (idx < static_cast<int64_t>(str.length()) && str[idx] == '.') {
+      ++idx;
+      // More digits than <scale> are left for the time zone, where they do
+      // not parse.
+      int num_digits = 0;
+      while (num_digits < scale && idx < static_cast<int64_t>(str.length()) &&
+             absl::ascii_isdigit(str[idx])) {
+        subsecond = subsecond * 10 + (str[idx] - '0');
+        ++idx;
+        ++num_digits;
+      }
+      if (num_digits == 0) return false;
+      subsecond *= powers_of_ten[scale - num_digits];
+    }
+  }
+  bool string_includes_timezone = false;
+  int64_t offset_seconds = 0;
+  if (idx < static_cast<int64_t>(str.length())) {
+    if (!allow_tz_in_str) return false;
+    string_includes_timezone = true;
+    const char timezone_sign = str[idx];
+    if (timezone_sign == 'Z' || timezone_sign == 'z') {
+      if (idx + 1 != str.size()) return false;
+    } else {
+      int timezone_hour, timezone_minute = 0;
+      if (!ParseTwoDigits(str, idx + 1, &timezone_hour)) return false;
+      idx += 3;
+      if (idx < static_cast<int64_t>(str.length()) &&
+          (str[idx] != ':' || !ParseTwoDigits(str, idx + 1, &timezone_minute) ||
+           idx + 3 != str.size())) {
+        return false;
+      }
+      if (!TimeZonePartsToOffset(timezone_sign, timezone_hour,
+                                 timezone_minute, kSeconds, &offset_seconds)) {
+        return false;
+      }
+    }
+  }
+  const int year = century * 100 + year_of_century;
+  if (!IsValidDay(year, month, day) ||
+      !IsValidTimeOfDay(hour, minute, second)) {
+    return false;
+  }
+  absl::Time time;
+  if (string_includes_timezone) {
+    // A fixed offset, so the civil time needs no time zone lookup.
+    const int64_t days = absl::CivilDay(year, month, day) - kEpochDay;
+    time = absl::FromUnixSeconds(days * kNaiveNumSecondsPerDay +
+                                 hour * kNaiveNumSecondsPerHour +
+                                 minute * kNaiveNumSecondsPerMinute + second -
+                                 offset_seconds);
+  } else {
+    time = default_timezone
+               .At(absl::CivilSecond(year, month, day, hour, minute, second))
+               .pre;
+  }
+  time += MakeDuration(subsecond, scale);
+  return IsValidTime(time) && FromTime(time, scale, timestamp) &&
+         IsValidTimestamp(*timestamp, scale);
+}
+
+int64_t ConvertStringsToTimestamps(absl::Span<const absl::string_view> strs,
+                                   TimestampStringFormat format,
+                                   absl::TimeZone default_timezone,
+                                   TimestampScale scale, bool allow_tz_in_str,
+                                   int64_t* output, uint64_t* errors) {
+  const int64_t num_rows = strs.size();
+  std::fill(errors, errors + (num_rows + 63) / 64, 0);
+  int64_t num_errors = 0;
+  for (int64_t i = 0; i < num_rows; ++i) {
+    if (ConvertFixedIso8601StringToTimestamp(strs[i], default_timezone, scale,
+                                             allow_tz_in_str, &output[i])) {
+      continue;
+    }
+    if (format == TimestampStringFormat::kAny &&
+        ConvertStringToTimestamp(strs[i], default_timezone, scale,
+                                 allow_tz_in_str, &output[i])
+            .ok()) {
+      continue;
+    }
+    errors[i / 64] |= uint64_t{1} << (i % 64);
+    ++num_errors;
+  }
+  return num_errors;
+}
+
 zetasql_base::Status ConvertStringToTime(absl::string_view str, TimestampScale scale,
                                  TimeValue* output) {
   ZETASQL_RET_CHECK(scale == kMicroseconds || scale == kNanoseconds)
@@ -2254,9 +2518,17 @@ zetasql_base::Status ExtractFromTimestamp(DateTimestampPart part, int64_t timest
                                   TimestampScale scale,
                                   absl::string_view timezone_string,
                                   int32_t* output) {
-  absl::TimeZone timezone;
-  ZETASQL_RETURN_IF_ERROR(MakeTimeZone(timezone_string, &timezone));
-  return ExtractFromTimestamp(part, timestamp, scale, timezone, output);
+  const date_time_util_internal::CachedTimeZone* cached;
+  ZETASQL_RETURN_IF_ERROR(LookupCachedTimeZone(timezone_string, &cached));
+  absl::CivilDay day;
+  absl::Time day_start;
+  if (part == DATE && IsValidTimestamp(timestamp, scale) &&
+      cached->LookupDay(MakeTime(timestamp, scale), &day, &day_start)) {
+    *output = CivilDayToEpochDays(day);
+    return ::zetasql_base::OkStatus();
+  }
+  return ExtractFromTimestamp(part, timestamp, scale, cached->timezone(),
+                              output);
 }
 
 zetasql_base::Status ExtractFromTimestamp(DateTimestampPart part, absl::Time base_time,
@@ -2278,13 +2550,23 @@ zetasql_base::Status ExtractFromTimestamp(DateTimestampPart part, absl::Time bas
 zetasql_base::Status ExtractFromTimestamp(DateTimestampPart part, absl::Time base_time,
                                   absl::string_view timezone_string,
                                   int32_t* output) {
-  absl::TimeZone timezone;
-  ZETASQL_RETURN_IF_ERROR(MakeTimeZone(timezone_string, &timezone));
-  return ExtractFromTimestamp(part, base_time, timezone, output);
+  const date_time_util_internal::CachedTimeZone* cached;
+  ZETASQL_RETURN_IF_ERROR(LookupCachedTimeZone(timezone_string, &cached));
+  absl::CivilDay day;
+  absl::Time day_start;
+  if (part == DATE && IsValidTime(base_time) &&
+      cached->LookupDay(base_time, &day, &day_start)) {
+    *output = CivilDayToEpochDays(day);
+    return ::zetasql_base::OkStatus();
+  }
+  return ExtractFromTimestamp(part, base_time, cached->timezone(), output);
 }
 
 zetasql_base::Status ExtractFromDate(DateTimestampPart part, int32_t date,
                              int32_t* output) {
+  if (date_time_util_internal::ExtractFromDateKernel(part, date, output)) {
+    return ::zetasql_base::OkStatus();
+  }
   if (!IsValidDate(date)) {
     return MakeEvalError() << "Invalid date value: " << date;
   }
@@ -2756,6 +3038,9 @@ zetasql_base::Status AddDateOverflow(int32_t date, DateTimestampPart part, int32
 
 zetasql_base::Status AddDate(int32_t date, DateTimestampPart part, int64_t interval,
                      int32_t* output) {
+  if (date_time_util_internal::AddDateKernel(date, part, interval, output)) {
+    return zetasql_base::OkStatus();
+  }
   // The interval is an int64_t to match the ZetaSQL function signature.
   // Below we will do safe casting with it, so it must be in
   // the domain of int32_t numbers.
@@ -2785,6 +3070,9 @@ zetasql_base::Status SubDate(int32_t date, DateTimestampPart part, int64_t inter
 
 zetasql_base::Status DiffDates(int32_t date1, int32_t date2, DateTimestampPart part,
                        int32_t* output) {
+  if (date_time_util_internal::DiffDatesKernel(date1, date2, part, output)) {
+    return ::zetasql_base::OkStatus();
+  }
   if (!IsValidDate(date1)) {
     return MakeEvalError() << "Invalid date value: " << date1;
   }
@@ -3409,9 +3697,121 @@ zetasql_base::Status TruncateTime(const TimeValue& time, DateTimestampPart part,
 }
 
 zetasql_base::Status TruncateDate(int32_t date, DateTimestampPart part, int32_t* output) {
+  if (date_time_util_internal::TruncateDateKernel(date, part, output)) {
+    return ::zetasql_base::OkStatus();
+  }
   return TruncateDateImpl(date, part, /*enforce_range=*/true, output);
 }
 
+// Finishes a batch of one of the date functions after its kernel ran.
+// <covered> and <may_fail> are as returned by the kernel. If the kernel could
+// not compute every row, computes the rows that are not NULL with <scalar>,
+// which is called with the index of a row and returns the status of the
+// scalar function.
+template <typename Scalar>
+static bool FinishDateBatch(bool covered, bool may_fail,
+                            const uint64_t* validity, int64_t num_rows,
+                            const Scalar& scalar, int64_t* error_row,
+                            zetasql_base::Status* error) {
+  if (ABSL_PREDICT_TRUE(covered && !may_fail)) return true;
+  for (int64_t i = 0; i < num_rows; ++i) {
+    if (!IsValidRow(validity, i)) continue;
+    zetasql_base::Status status = scalar(i);
+    if (!status.ok()) {
+      *error_row = i;
+      *error = std::move(status);
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ExtractFromDateBatch(DateTimestampPart part, const int32_t* dates,
+                          const uint64_t* validity, int64_t num_rows,
+                          int32_t* output, int64_t* error_row,
+                          zetasql_base::Status* error) {
+  bool may_fail = false;
+  const bool covered = date_time_util_internal::ExtractFromDateKernel(
+      part, dates, num_rows, output, &may_fail);
+  return FinishDateBatch(
+      covered, may_fail, validity, num_rows,
+      [=](int64_t i) { return ExtractFromDate(part, dates[i], &output[i]); },
+      error_row, error);
+}
+
+bool AddDateBatch(const int32_t* dates, DateTimestampPart part,
+                  const int64_t* intervals, const uint64_t* validity,
+                  int64_t num_rows, int32_t* output, int64_t* error_row,
+                  zetasql_base::Status* error) {
+  bool may_fail = false;
+  const bool covered = date_time_util_internal::AddDateKernel(
+      dates, part, intervals, num_rows, output, &may_fail);
+  return FinishDateBatch(
+      covered, may_fail, validity, num_rows,
+      [=](int64_t i) {
+        return AddDate(dates[i], part, intervals[i], &output[i]);
+      },
+      error_row, error);
+}
+
+bool DiffDatesBatch(const int32_t* dates1, const int32_t* dates2,
+                    DateTimestampPart part, const uint64_t* validity,
+                    int64_t num_rows, int32_t* output, int64_t* error_row,
+                    zetasql_base::Status* error) {
+  bool may_fail = false;
+  const bool covered = date_time_util_internal::DiffDatesKernel(
+      dates1, dates2, part, num_rows, output, &may_fail);
+  return FinishDateBatch(
+      covered, may_fail, validity, num_rows,
+      [=](int64_t i) {
+        return DiffDates(dates1[i], dates2[i], part, &output[i]);
+      },
+      error_row, error);
+}
+
+bool TruncateDateBatch(const int32_t* dates, DateTimestampPart part,
+                       const uint64_t* validity, int64_t num_rows,
+                       int32_t* output, int64_t* error_row,
+                       zetasql_base::Status* error) {
+  bool may_fail = false;
+  const bool covered = date_time_util_internal::TruncateDateKernel(
+      dates, part, num_rows, output, &may_fail);
+  return FinishDateBatch(
+      covered, may_fail, validity, num_rows,
+      [=](int64_t i) { return TruncateDate(dates[i], part, &output[i]); },
+      error_row, error);
+}
+
+bool ConvertTimestampMicrosToStringBatch(const int64_t* timestamps,
+                                         absl::TimeZone timezone,
+                                         const uint64_t* validity,
+                                         int64_t num_rows, std::string* output,
+                                         int64_t* error_row,
+                                         zetasql_base::Status* error) {
+  int offset_seconds;
+  const bool fixed = GetFixedTimeZoneOffset(timezone, &offset_seconds);
+  char buffer[kMaxCanonicalTimestampLength];
+  for (int64_t i = 0; i < num_rows; ++i) {
+    if (!IsValidRow(validity, i)) continue;
+    if (fixed) {
+      const int length =
+          FormatTimestampMicrosToBuffer(timestamps[i], offset_seconds, buffer);
+      if (ABSL_PREDICT_TRUE(length > 0)) {
+        output[i].assign(buffer, length);
+        continue;
+      }
+    }
+    zetasql_base::Status status = ConvertTimestampToStringWithTruncation(
+        timestamps[i], kMicroseconds, timezone, &output[i]);
+    if (!status.ok()) {
+      *error_row = i;
+      *error = std::move(status);
+      return false;
+    }
+  }
+  return true;
+}
+
 zetasql_base::Status TimestampTrunc(int64_t timestamp, absl::TimeZone timezone,
                             DateTimestampPart part, int64_t* output) {
   return TimestampTruncImpl(timestamp, kMicroseconds, NEW_TIMESTAMP_TYPE,
@@ -3420,9 +3820,16 @@ zetasql_base::Status TimestampTrunc(int64_t timestamp, absl::TimeZone timezone,
 
 zetasql_base::Status TimestampTrunc(int64_t timestamp, absl::string_view timezone_string,
                             DateTimestampPart part, int64_t* output) {
-  absl::TimeZone timezone;
-  ZETASQL_RETURN_IF_ERROR(MakeTimeZone(timezone_string, &timezone));
-  return TimestampTrunc(timestamp, timezone, part, output);
+  const date_time_util_internal::CachedTimeZone* cached;
+  ZETASQL_RETURN_IF_ERROR(LookupCachedTimeZone(timezone_string, &cached));
+  absl::CivilDay day;
+  absl::Time day_start;
+  if (part == DAY && IsValidTimestamp(timestamp, kMicroseconds) &&
+      cached->LookupDay(MakeTime(timestamp, kMicroseconds), &day, &day_start)) {
+    *output = absl::ToUnixMicros(day_start);
+    return ::zetasql_base::OkStatus();
+  }
+  return TimestampTrunc(timestamp, cached->timezone(), part, output);
 }
 
 zetasql_base::Status TimestampTrunc(absl::Time timestamp, absl::TimeZone timezone,
@@ -3464,9 +3871,14 @@ zetasql_base::Status TimestampTrunc(absl::Time timestamp, absl::TimeZone timezon
 zetasql_base::Status TimestampTrunc(absl::Time timestamp,
                             absl::string_view timezone_string,
                             DateTimestampPart part, absl::Time* output) {
-  absl::TimeZone timezone;
-  ZETASQL_RETURN_IF_ERROR(MakeTimeZone(timezone_string, &timezone));
-  return TimestampTrunc(timestamp, timezone, part, output);
+  const date_time_util_internal::CachedTimeZone* cached;
+  ZETASQL_RETURN_IF_ERROR(LookupCachedTimeZone(timezone_string, &cached));
+  absl::CivilDay day;
+  if (part == DAY && IsValidTime(timestamp) &&
+      cached->LookupDay(timestamp, &day, output)) {
+    return ::zetasql_base::OkStatus();
+  }
+  return TimestampTrunc(timestamp, cached->timezone(), part, output);
 }
 
 zetasql_base::Status TruncateTimestamp(int64_t timestamp, TimestampScale scale,
@@ -3805,6 +4217,10 @@ zetasql_base::Status ExpandPercentZQ(absl::string_view format_string,
   return zetasql_base::OkStatus();
 }
 
+void SanitizeDateFormat(absl::string_view format_string, std::string* out) {
+  functions::SanitizeDateFormat(format_string, out);
+}
+
 }  // namespace internal_functions
 }  // namespace functions
 }  // namespace zetasql
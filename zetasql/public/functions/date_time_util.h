@@ -28,6 +28,7 @@
 #include <cstdint>
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "zetasql/base/status.h"
 
 // ZetaSQL dates are represented as an int32_t value, indicating the offset
@@ -127,6 +128,39 @@ zetasql_base::Status ConvertTimestampToStringWithTruncation(
     int64_t timestamp, TimestampScale scale, absl::string_view timezone_string,
     std::string* out);
 
+// The maximum length of the strings written by
+// FormatTimestampMicrosToBuffer(), e.g. "10000-01-01 09:44:59.999999+09:45".
+constexpr int kMaxCanonicalTimestampLength = 33;
+
+// Returns true if <timezone> has the same offset at all times, i.e. it is
+// UTC or a fixed-offset time zone such as MakeTimeZone() returns for "+HH:MM"
+// strings, and sets <*offset_seconds> to that offset. The offset is truncated
+// to whole minutes, as in the canonical timestamp format.
+bool GetFixedTimeZoneOffset(absl::TimeZone timezone, int* offset_seconds);
+
+// Writes <timestamp> in microseconds in the canonical format of
+// ConvertTimestampToStringWithTruncation() with kMicroseconds, in the
+// fixed-offset time zone <offset_seconds> east of UTC, which must be a whole
+// number of minutes, to <buffer> with room for kMaxCanonicalTimestampLength
+// characters. Returns the number of characters written, or 0 if <timestamp>
+// is not valid. The digits are written without absl::FormatTime() or time
+// zone lookups, so this is much faster.
+int FormatTimestampMicrosToBuffer(int64_t timestamp, int offset_seconds,
+                                  char* buffer);
+
+// Batch version of ConvertTimestampToStringWithTruncation() with
+// kMicroseconds, over <num_rows> timestamps with a <validity> bitmap as in
+// batch_kernels.h. Uses FormatTimestampMicrosToBuffer() if <timezone> has a
+// fixed offset. On the first row that is not NULL and is not valid, returns
+// false, sets *error_row to its index and sets *error. Output strings for
+// NULL rows, and all output strings after an error, are unspecified.
+bool ConvertTimestampMicrosToStringBatch(const int64_t* timestamps,
+                                         absl::TimeZone timezone,
+                                         const uint64_t* validity,
+                                         int64_t num_rows, std::string* output,
+                                         int64_t* error_row,
+                                         zetasql_base::Status* error);
+
 // Populates <out> in canonical timestamp format based on the specified
 // <timezone>, for example:
 //   "2014-01-31 12:22:34.123456789-08".
@@ -306,6 +340,32 @@ zetasql_base::Status ConvertStringToTimestamp(absl::string_view str,
                                       TimestampScale scale,
                                       bool allow_tz_in_str, absl::Time* output);
 
+// The formats of the strings for ConvertStringsToTimestamps().
+enum class TimestampStringFormat {
+  // Any string that ConvertStringToTimestamp() accepts. Strings of the fixed
+  // form below are detected and parsed without the general parser.
+  kAny,
+  // Only strings of the fixed form
+  //   YYYY-MM-DD[( |T|t)HH:MM:SS[.DDDDDDDDD]][Z|z|(+|-)HH[:MM]]
+  // with exactly two digits in each field, as written by most other systems.
+  // Other strings are errors, even if ConvertStringToTimestamp() accepts
+  // them.
+  kFixedIso8601,
+};
+
+// Bulk version of ConvertStringToTimestamp() with <allow_tz_in_str>, for
+// loading data. Converts each string of <strs> to output[i]. Instead of
+// returning an error, sets bit i % 64 of errors[i / 64] for each string that
+// does not convert, whose output is then unspecified, and clears the bits of
+// the other strings. <errors> must have (strs.size() + 63) / 64 words.
+// Returns the number of strings that do not convert; callers that need the
+// error message of one can call ConvertStringToTimestamp() on it.
+int64_t ConvertStringsToTimestamps(absl::Span<const absl::string_view> strs,
+                                   TimestampStringFormat format,
+                                   absl::TimeZone default_timezone,
+                                   TimestampScale scale, bool allow_tz_in_str,
+                                   int64_t* output, uint64_t* errors);
+
 // Converts the std::string representation of a time to a time value of the specified
 // <scale>. Returns error status if there are more fractional digits than
 // <scale>, or conversion otherwise fails.
@@ -791,6 +851,32 @@ zetasql_base::Status TruncateTime(const TimeValue& time, DateTimestampPart part,
 // is not allowed.
 zetasql_base::Status TruncateDate(int32_t date, DateTimestampPart part, int32_t* output);
 
+// Batch versions of ExtractFromDate(), AddDate(), DiffDates() and
+// TruncateDate() for columnar evaluation, over arrays of <num_rows> dates (and
+// intervals) with a <validity> bitmap as in batch_kernels.h. The common date
+// parts are computed without branching on the values, so these are much
+// faster than calling the scalar functions for each row. On the first row
+// that is not NULL for which the scalar function fails, returns false, sets
+// *error_row to its index and sets *error to the error of the scalar
+// function. Output values for NULL rows, and all output values after an
+// error, are unspecified.
+bool ExtractFromDateBatch(DateTimestampPart part, const int32_t* dates,
+                          const uint64_t* validity, int64_t num_rows,
+                          int32_t* output, int64_t* error_row,
+                          zetasql_base::Status* error);
+bool AddDateBatch(const int32_t* dates, DateTimestampPart part,
+                  const int64_t* intervals, const uint64_t* validity,
+                  int64_t num_rows, int32_t* output, int64_t* error_row,
+                  zetasql_base::Status* error);
+bool DiffDatesBatch(const int32_t* dates1, const int32_t* dates2,
+                    DateTimestampPart part, const uint64_t* validity,
+                    int64_t num_rows, int32_t* output, int64_t* error_row,
+                    zetasql_base::Status* error);
+bool TruncateDateBatch(const int32_t* dates, DateTimestampPart part,
+                       const uint64_t* validity, int64_t num_rows,
+                       int32_t* output, int64_t* error_row,
+                       zetasql_base::Status* error);
+
 // Truncates the timestamp to the beginning of the specified DateTimestampPart
 // granularity.  Assumes that the input <timestamp> is at MICROSECOND precision.
 // For example: TIMESTAMP_TRUNC("2013-12-03 12:34:56.987654", SECOND)
@@ -895,6 +981,10 @@ zetasql_base::Status ExpandPercentZQ(absl::string_view format_string,
                              bool expand_quarter,
                              std::string* expanded_format_string);
 
+// Escapes the format elements of <format_string> that do not apply to dates
+// into <out>, as FormatDateToString() does.
+void SanitizeDateFormat(absl::string_view format_string, std::string* out);
+
 }  // namespace internal_functions
 }  // namespace functions
 }  // namespace zetasql
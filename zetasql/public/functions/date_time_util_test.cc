@@ -0,0 +1,265 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/functions/date_time_util.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/type.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+
+namespace zetasql {
+namespace functions {
+namespace {
+
+// Strings of the fixed form and not, valid and not.
+const std::vector<absl::string_view>& TimestampStrings() {
+  static const auto* strings = new std::vector<absl::string_view>({
+      "2019-03-22 03:30:15",
+      "2019-03-22T03:30:15.123456",
+      "2019-03-22t03:30:15.1",
+      "2019-03-22 03:30:15.123456789",
+      "2019-03-22 03:30:15.1234567891",
+      "2019-03-22 03:30:15.",
+      "2019-03-22 03:30:15Z",
+      "2019-03-22 03:30:15.5z",
+      "2019-03-22 03:30:15Zx",
+      "2019-03-22 03:30:15+05",
+      "2019-03-22 03:30:15-08:00",
+      "2019-03-22 03:30:15+14:00",
+      "2019-03-22 03:30:15+14:01",
+      "2019-03-22 03:30:15+15",
+      "2019-03-22 03:30:15+5",
+      "2019-03-22 03:30:15+05:3",
+      "2019-03-22 03:30:15 UTC",
+      "2019-03-22 03:30:15 America/Los_Angeles",
+      "2019-03-22 03:30:15 +05",
+      "2019-03-22",
+      "2019-3-22 3:30:15",
+      "2019-03-22 03:30",
+      "2019-03-22 24:00:00",
+      "2019-03-22 23:59:60",
+      "2019-03-22 23:59:60.5",
+      "2019-02-29 00:00:00",
+      "2020-02-29 00:00:00",
+      "2019-13-01 00:00:00",
+      "0001-01-01 00:00:00",
+      "0001-01-01 00:00:00+01",
+      "0000-12-31 23:59:59",
+      "9999-12-31 23:59:59.999999",
+      "9999-12-31 23:59:59.999999-01",
+      "10000-01-01 00:00:00",
+      "1677-09-21 00:12:43.145224192",
+      "2262-04-11 23:47:16.854775807",
+      "2262-04-11 23:47:16.854775808",
+      "2019-11-03 01:30:00",
+      "2019-03-10 02:30:00",
+      "",
+      "2019",
+      "2019-03-2x 00:00:00",
+      " 2019-03-22 03:30:15",
+  });
+  return *strings;
+}
+
+std::vector<absl::TimeZone> TestTimeZones() {
+  std::vector<absl::TimeZone> timezones = {absl::UTCTimeZone(),
+                                           absl::FixedTimeZone(-8 * 3600)};
+  absl::TimeZone los_angeles;
+  if (absl::LoadTimeZone("America/Los_Angeles", &los_angeles)) {
+    timezones.push_back(los_angeles);
+  }
+  return timezones;
+}
+
+bool IsError(const std::vector<uint64_t>& errors, int i) {
+  return (errors[i / 64] & (uint64_t{1} << (i % 64))) != 0;
+}
+
+TEST(ConvertStringsToTimestampsTest, MatchesConvertStringToTimestamp) {
+  const std::vector<absl::string_view>& strings = TimestampStrings();
+  for (TimestampScale scale : {kSeconds, kMicroseconds, kNanoseconds}) {
+    for (bool allow_tz_in_str : {true, false}) {
+      for (absl::TimeZone timezone : TestTimeZones()) {
+        std::vector<int64_t> output(strings.size());
+        std::vector<uint64_t> errors((strings.size() + 63) / 64, ~uint64_t{0});
+        const int64_t num_errors = ConvertStringsToTimestamps(
+            strings, TimestampStringFormat::kAny, timezone, scale,
+            allow_tz_in_str, output.data(), errors.data());
+        int64_t expected_num_errors = 0;
+        for (int i = 0; i < strings.size(); ++i) {
+          int64_t expected;
+          const bool expected_ok =
+              ConvertStringToTimestamp(strings[i], timezone, scale,
+                                       allow_tz_in_str, &expected)
+                  .ok();
+          expected_num_errors += !expected_ok;
+          EXPECT_EQ(!expected_ok, IsError(errors, i))
+              << strings[i] << " scale " << scale << " allow_tz_in_str "
+              << allow_tz_in_str << " " << timezone.name();
+          if (expected_ok) {
+            EXPECT_EQ(expected, output[i])
+                << strings[i] << " scale " << scale << " " << timezone.name();
+          }
+        }
+        EXPECT_EQ(expected_num_errors, num_errors);
+      }
+    }
+  }
+}
+
+TEST(ConvertStringsToTimestampsTest, FixedIso8601RejectsOtherForms) {
+  const std::vector<absl::string_view> strings = {
+      "2019-03-22 03:30:15.25+05:30", "2019-3-22 03:30:15",
+      "2019-03-22 03:30:15 UTC", "2019-03-22T03:30:15Z", "2019-02-29"};
+  std::vector<int64_t> output(strings.size());
+  std::vector<uint64_t> errors(1);
+  EXPECT_EQ(3, ConvertStringsToTimestamps(
+                   strings, TimestampStringFormat::kFixedIso8601,
+                   absl::UTCTimeZone(), kMicroseconds,
+                   /*allow_tz_in_str=*/true, output.data(), errors.data()));
+  EXPECT_EQ(0b10110, errors[0]);
+  EXPECT_EQ(1553205615250000, output[0]);
+  EXPECT_EQ(1553225415000000, output[3]);
+}
+
+TEST(ConvertStringsToTimestampsTest, ManyRows) {
+  std::vector<std::string> storage;
+  for (int i = 0; i < 200; ++i) {
+    storage.push_back(i % 3 == 0 ? "bad" : "2019-03-22 03:30:15");
+  }
+  const std::vector<absl::string_view> strings(storage.begin(), storage.end());
+  std::vector<int64_t> output(strings.size());
+  std::vector<uint64_t> errors((strings.size() + 63) / 64);
+  EXPECT_EQ(67, ConvertStringsToTimestamps(
+                    strings, TimestampStringFormat::kAny, absl::UTCTimeZone(),
+                    kMicroseconds, /*allow_tz_in_str=*/true, output.data(),
+                    errors.data()));
+  for (int i = 0; i < strings.size(); ++i) {
+    EXPECT_EQ(i % 3 == 0, IsError(errors, i)) << i;
+    if (i % 3 != 0) {
+      EXPECT_EQ(1553225415000000, output[i]);
+    }
+  }
+}
+
+// Timestamps in microseconds around the ends of the range, days, leap days
+// and each number of fractional digits.
+std::vector<int64_t> TimestampMicros() {
+  std::vector<int64_t> timestamps = {
+      types::kTimestampMin, types::kTimestampMin + 1,
+      types::kTimestampMax, types::kTimestampMax - 999999,
+      0, -1, 1, 999, 1000, 1000000, -1000, -1000000, 1553225415123456,
+      1553225415120000, 1553225415100000, 951782400000000,  // 2000-02-29
+      -2203891200000000,  // 1900-03-01
+      253402300799000000};  // 9999-12-31 23:59:59
+  for (int64_t t = types::kTimestampMin; t < types::kTimestampMax;
+       t += 12345678901234567) {
+    timestamps.push_back(t);
+  }
+  return timestamps;
+}
+
+std::vector<absl::TimeZone> FixedTestTimeZones() {
+  std::vector<absl::TimeZone> timezones;
+  for (const char* timezone_string :
+       {"UTC", "+00:00", "-08", "+05:30", "-00:30", "+14", "-14:00",
+        "+09:45"}) {
+    absl::TimeZone timezone;
+    ZETASQL_CHECK_OK(MakeTimeZone(timezone_string, &timezone));
+    timezones.push_back(timezone);
+  }
+  return timezones;
+}
+
+TEST(FormatTimestampMicrosToBufferTest, MatchesFormatTime) {
+  for (absl::TimeZone timezone : FixedTestTimeZones()) {
+    int offset_seconds;
+    ASSERT_TRUE(GetFixedTimeZoneOffset(timezone, &offset_seconds))
+        << timezone.name();
+    for (int64_t timestamp : TimestampMicros()) {
+      // The absl::Time overload always formats with absl::FormatTime().
+      std::string expected;
+      ZETASQL_ASSERT_OK(ConvertTimestampToString(
+          absl::FromUnixMicros(timestamp), kMicroseconds, timezone, &expected));
+      char buffer[kMaxCanonicalTimestampLength];
+      const int length =
+          FormatTimestampMicrosToBuffer(timestamp, offset_seconds, buffer);
+      EXPECT_EQ(expected, std::string(buffer, length))
+          << timestamp << " " << timezone.name();
+
+      std::string output;
+      ZETASQL_ASSERT_OK(ConvertTimestampToStringWithTruncation(
+          timestamp, kMicroseconds, timezone, &output));
+      EXPECT_EQ(expected, output);
+    }
+  }
+  char buffer[kMaxCanonicalTimestampLength];
+  EXPECT_EQ(0, FormatTimestampMicrosToBuffer(types::kTimestampMax + 1, 0,
+                                             buffer));
+  EXPECT_EQ(0, FormatTimestampMicrosToBuffer(types::kTimestampMin - 1, 0,
+                                             buffer));
+
+  absl::TimeZone los_angeles;
+  if (absl::LoadTimeZone("America/Los_Angeles", &los_angeles)) {
+    int offset_seconds;
+    EXPECT_FALSE(GetFixedTimeZoneOffset(los_angeles, &offset_seconds));
+  }
+}
+
+TEST(FormatTimestampMicrosToBufferTest, Batch) {
+  const std::vector<int64_t> timestamps = TimestampMicros();
+  const std::vector<uint64_t> validity(1, ~uint64_t{1});  // Row 0 is NULL.
+  std::vector<absl::TimeZone> timezones = TestTimeZones();
+  timezones.push_back(FixedTestTimeZones()[3]);
+  for (absl::TimeZone timezone : timezones) {
+    std::vector<std::string> output(timestamps.size());
+    int64_t error_row = -1;
+    zetasql_base::Status error;
+    ASSERT_TRUE(ConvertTimestampMicrosToStringBatch(
+        timestamps.data(), timezone, validity.data(), timestamps.size(),
+        output.data(), &error_row, &error));
+    EXPECT_EQ("", output[0]);
+    for (int i = 1; i < timestamps.size(); ++i) {
+      std::string expected;
+      ZETASQL_ASSERT_OK(ConvertTimestampToString(
+          absl::FromUnixMicros(timestamps[i]), kMicroseconds, timezone,
+          &expected));
+      EXPECT_EQ(expected, output[i]) << timestamps[i] << " " << timezone.name();
+    }
+  }
+
+  const std::vector<int64_t> invalid = {0, types::kTimestampMax + 1, 0};
+  std::vector<std::string> output(invalid.size());
+  int64_t error_row = -1;
+  zetasql_base::Status error;
+  EXPECT_FALSE(ConvertTimestampMicrosToStringBatch(
+      invalid.data(), absl::UTCTimeZone(), /*validity=*/nullptr,
+      invalid.size(), output.data(), &error_row, &error));
+  EXPECT_EQ(1, error_row);
+  EXPECT_FALSE(error.ok());
+  EXPECT_EQ("1970-01-01 00:00:00+00", output[0]);
+}
+
+}  // namespace
+}  // namespace functions
+}  // namespace zetasql
@@ -0,0 +1,187 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/functions/like.h"
+
+#include <algorithm>
+
+#include "zetasql/public/functions/util.h"
+#include "absl/strings/match.h"
+
+namespace zetasql {
+namespace functions {
+
+bool LikeMatcher::Initialize(absl::string_view pattern, bool is_bytes,
+                             zetasql_base::Status* error) {
+  is_bytes_ = is_bytes;
+  tokens_.clear();
+  literal_.clear();
+  bool has_any_char = false;
+  for (size_t i = 0; i < pattern.size(); ++i) {
+    switch (pattern[i]) {
+      case '%':
+        if (tokens_.empty() || tokens_.back().kind != kAnyString) {
+          tokens_.push_back({kAnyString, 0});
+        }
+        break;
+      case '_':
+        tokens_.push_back({kAnyChar, 0});
+        has_any_char = true;
+        break;
+      case '\\':
+        if (++i == pattern.size()) {
+          return internal::UpdateError(error,
+                                       "LIKE pattern ends with a backslash");
+        }
+        tokens_.push_back({kLiteralByte, pattern[i]});
+        break;
+      default:
+        tokens_.push_back({kLiteralByte, pattern[i]});
+        break;
+    }
+  }
+
+  // Without '_', the pattern is literal text with '%'s; it has a specialized
+  // matcher if the '%'s are only at the ends.
+  const bool leading = !tokens_.empty() && tokens_.front().kind == kAnyString;
+  const bool trailing = tokens_.size() > (leading ? 1 : 0) &&
+                        tokens_.back().kind == kAnyString;
+  kind_ = kGeneral;
+  if (!has_any_char) {
+    const auto begin = tokens_.begin() + (leading ? 1 : 0);
+    const auto end = tokens_.end() - (trailing ? 1 : 0);
+    if (std::none_of(begin, end, [](const Token& token) {
+          return token.kind == kAnyString;
+        })) {
+      for (auto it = begin; it != end; ++it) {
+        literal_.push_back(it->byte);
+      }
+      if (literal_.empty() && leading) {
+        kind_ = kPrefix;
+      } else if (leading && trailing) {
+        kind_ = kContains;
+      } else if (leading) {
+        kind_ = kSuffix;
+      } else if (trailing) {
+        kind_ = kPrefix;
+      } else {
+        kind_ = kExact;
+      }
+    }
+  }
+  if (kind_ != kGeneral) {
+    tokens_.clear();
+  }
+  return true;
+}
+
+bool LikeMatcher::Matches(absl::string_view str) const {
+  switch (kind_) {
+    case kExact:
+      return str == literal_;
+    case kPrefix:
+      return absl::StartsWith(str, literal_);
+    case kSuffix:
+      return absl::EndsWith(str, literal_);
+    case kContains:
+      return absl::StrContains(str, literal_);
+    case kGeneral:
+      break;
+  }
+  return MatchesGeneral(str);
+}
+
+size_t LikeMatcher::CharLength(absl::string_view str, size_t pos) const {
+  if (is_bytes_) return 1;
+  // Bytes that do not start a well-formed character count as one character.
+  const unsigned char lead = static_cast<unsigned char>(str[pos]);
+  size_t length = 1;
+  if ((lead & 0xE0) == 0xC0) {
+    length = 2;
+  } else if ((lead & 0xF0) == 0xE0) {
+    length = 3;
+  } else if ((lead & 0xF8) == 0xF0) {
+    length = 4;
+  }
+  return std::min(length, str.size() - pos);
+}
+
+bool LikeMatcher::MatchesGeneral(absl::string_view str) const {
+  // Matches tokens left to right. On a mismatch, the last '%' takes one more
+  // character and matching resumes after it; earlier '%'s never need to take
+  // more, so this takes O(|str| * |tokens|) time at worst.
+  const size_t num_tokens = tokens_.size();
+  size_t s = 0;
+  size_t t = 0;
+  size_t last_any_string = num_tokens;
+  size_t any_string_end = 0;
+  while (s < str.size()) {
+    if (t < num_tokens && tokens_[t].kind == kLiteralByte &&
+        tokens_[t].byte == str[s]) {
+      ++s;
+      ++t;
+    } else if (t < num_tokens && tokens_[t].kind == kAnyChar) {
+      s += CharLength(str, s);
+      ++t;
+    } else if (t < num_tokens && tokens_[t].kind == kAnyString) {
+      last_any_string = t++;
+      any_string_end = s;
+    } else if (last_any_string != num_tokens) {
+      t = last_any_string + 1;
+      any_string_end += CharLength(str, any_string_end);
+      s = any_string_end;
+    } else {
+      return false;
+    }
+  }
+  while (t < num_tokens && tokens_[t].kind == kAnyString) {
+    ++t;
+  }
+  return t == num_tokens;
+}
+
+bool LikeMatcher::GetMatchRange(std::string* lower,
+                                absl::optional<std::string>* upper) const {
+  switch (kind_) {
+    case kExact:
+      *lower = literal_;
+      *upper = literal_;
+      return true;
+    case kPrefix: {
+      *lower = literal_;
+      // The smallest value after every string with the prefix is the prefix
+      // without its trailing 0xFF bytes and with its last byte incremented.
+      std::string successor = literal_;
+      while (!successor.empty() &&
+             static_cast<unsigned char>(successor.back()) == 0xFF) {
+        successor.pop_back();
+      }
+      if (successor.empty()) {
+        upper->reset();
+      } else {
+        successor.back() = static_cast<char>(
+            static_cast<unsigned char>(successor.back()) + 1);
+        *upper = std::move(successor);
+      }
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+}  // namespace functions
+}  // namespace zetasql
@@ -0,0 +1,105 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// This file implements the LIKE operator ($like) over STRING and BYTES.
+//
+// In a LIKE pattern, '%' matches any number of characters, '_' matches one
+// character, and a backslash makes the character after it match itself. For
+// BYTES, characters are bytes.
+
+#ifndef ZETASQL_PUBLIC_FUNCTIONS_LIKE_H_
+#define ZETASQL_PUBLIC_FUNCTIONS_LIKE_H_
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+namespace functions {
+
+// A LIKE pattern compiled into the cheapest matcher for its shape. Patterns
+// with constant text and '%' only at the ends are matched with a comparison
+// or a substring search; others go through a matcher that backtracks only to
+// the last '%'.
+//
+// Once initialized, this class is thread-safe.
+class LikeMatcher {
+ public:
+  enum Kind {
+    // 'abc': the input equals literal().
+    kExact,
+    // 'abc%': the input starts with literal(). '%' is a kPrefix with an empty
+    // literal().
+    kPrefix,
+    // '%abc': the input ends with literal().
+    kSuffix,
+    // '%abc%': the input contains literal().
+    kContains,
+    // Any other pattern, e.g. with '_' or with '%' in the middle.
+    kGeneral,
+  };
+
+  LikeMatcher() {}
+
+  // Compiles <pattern>, for BYTES inputs if <is_bytes> and STRING inputs
+  // otherwise. Returns false and sets *error if the pattern ends with an
+  // unescaped backslash.
+  bool Initialize(absl::string_view pattern, bool is_bytes,
+                  zetasql_base::Status* error);
+
+  // Returns true if <str> matches the pattern.
+  bool Matches(absl::string_view str) const;
+
+  Kind kind() const { return kind_; }
+
+  // The unescaped text of the pattern without its '%'s. REQUIRES: kind() is
+  // not kGeneral.
+  const std::string& literal() const { return literal_; }
+
+  // For kExact and kPrefix patterns, sets *lower and *upper to an inclusive
+  // range of values that contains every matching input, as for a kRange
+  // ColumnFilter passed to EvaluatorTableIterator::SetColumnFilters(). *upper
+  // is unset if the range has no upper bound, e.g. for '%'. For STRING,
+  // *upper may not be valid UTF-8, but it still orders after every match.
+  // Returns false for other kinds.
+  bool GetMatchRange(std::string* lower,
+                     absl::optional<std::string>* upper) const;
+
+ private:
+  enum TokenKind { kLiteralByte, kAnyChar, kAnyString };
+  struct Token {
+    TokenKind kind;
+    char byte;  // For kLiteralByte.
+  };
+
+  bool MatchesGeneral(absl::string_view str) const;
+  // Returns the length of the character of the input at str[pos].
+  size_t CharLength(absl::string_view str, size_t pos) const;
+
+  Kind kind_ = kExact;
+  bool is_bytes_ = false;
+  std::string literal_;
+  // The pattern for kGeneral, with consecutive kAnyStrings collapsed.
+  std::vector<Token> tokens_;
+};
+
+}  // namespace functions
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_FUNCTIONS_LIKE_H_
@@ -0,0 +1,137 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/functions/like.h"
+
+#include <string>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+
+namespace zetasql {
+namespace functions {
+namespace {
+
+using ::testing::HasSubstr;
+using zetasql_base::testing::StatusIs;
+
+LikeMatcher MakeMatcher(absl::string_view pattern, bool is_bytes = false) {
+  LikeMatcher matcher;
+  zetasql_base::Status error;
+  EXPECT_TRUE(matcher.Initialize(pattern, is_bytes, &error)) << error;
+  return matcher;
+}
+
+TEST(LikeMatcherTest, Kinds) {
+  struct {
+    const char* pattern;
+    LikeMatcher::Kind kind;
+    const char* literal;
+  } const kCases[] = {
+      {"abc", LikeMatcher::kExact, "abc"},
+      {"", LikeMatcher::kExact, ""},
+      {"abc%", LikeMatcher::kPrefix, "abc"},
+      {"%", LikeMatcher::kPrefix, ""},
+      {"%%", LikeMatcher::kPrefix, ""},
+      {"%abc", LikeMatcher::kSuffix, "abc"},
+      {"%abc%%", LikeMatcher::kContains, "abc"},
+      {"a\\%c\\_%", LikeMatcher::kPrefix, "a%c_"},
+      {"a%c", LikeMatcher::kGeneral, ""},
+      {"a_c", LikeMatcher::kGeneral, ""},
+      {"_", LikeMatcher::kGeneral, ""},
+  };
+  for (const auto& test : kCases) {
+    const LikeMatcher matcher = MakeMatcher(test.pattern);
+    EXPECT_EQ(test.kind, matcher.kind()) << test.pattern;
+    if (test.kind != LikeMatcher::kGeneral) {
+      EXPECT_EQ(test.literal, matcher.literal()) << test.pattern;
+    }
+  }
+}
+
+TEST(LikeMatcherTest, Matches) {
+  struct {
+    const char* pattern;
+    const char* str;
+    bool matches;
+  } const kCases[] = {
+      {"abc", "abc", true},       {"abc", "abcd", false},
+      {"abc%", "abcd", true},     {"abc%", "xabc", false},
+      {"%abc", "xabc", true},     {"%abc", "abcx", false},
+      {"%bc%", "abcd", true},     {"%bc%", "acbd", false},
+      {"%", "", true},            {"", "", true},
+      {"", "a", false},           {"a%c", "abbbc", true},
+      {"a%c", "abbbcd", false},   {"a%b%c", "aXbYbZc", true},
+      {"a%b%c", "acb", false},    {"a_c", "abc", true},
+      {"a_c", "ac", false},       {"%a_", "bab", true},
+      {"%a%a%", "aa", true},      {"%a%a%", "a", false},
+      {"\\%%", "%x", true},       {"\\%%", "x%", false},
+      {"a\\\\b", "a\\b", true},   {"%_%_%", "x", false},
+  };
+  for (const auto& test : kCases) {
+    EXPECT_EQ(test.matches, MakeMatcher(test.pattern).Matches(test.str))
+        << test.pattern << " " << test.str;
+  }
+}
+
+TEST(LikeMatcherTest, CharactersAndBytes) {
+  // "é" is one character but two bytes.
+  EXPECT_TRUE(MakeMatcher("_").Matches("\xC3\xA9"));
+  EXPECT_FALSE(MakeMatcher("_", /*is_bytes=*/true).Matches("\xC3\xA9"));
+  EXPECT_TRUE(MakeMatcher("__", /*is_bytes=*/true).Matches("\xC3\xA9"));
+  EXPECT_TRUE(MakeMatcher("%_b").Matches("a\xC3\xA9" "b"));
+  EXPECT_FALSE(MakeMatcher("%__b").Matches("\xC3\xA9" "b"));
+}
+
+TEST(LikeMatcherTest, Errors) {
+  LikeMatcher matcher;
+  zetasql_base::Status error;
+  EXPECT_FALSE(matcher.Initialize("abc\\", /*is_bytes=*/false, &error));
+  EXPECT_THAT(error, StatusIs(zetasql_base::StatusCode::kOutOfRange,
+                              HasSubstr("ends with a backslash")));
+}
+
+TEST(LikeMatcherTest, MatchRange) {
+  std::string lower;
+  absl::optional<std::string> upper;
+  ASSERT_TRUE(MakeMatcher("abc").GetMatchRange(&lower, &upper));
+  EXPECT_EQ("abc", lower);
+  EXPECT_EQ("abc", upper.value());
+
+  ASSERT_TRUE(MakeMatcher("abc%").GetMatchRange(&lower, &upper));
+  EXPECT_EQ("abc", lower);
+  EXPECT_EQ("abd", upper.value());
+
+  ASSERT_TRUE(
+      MakeMatcher("a\xFF\xFF%", /*is_bytes=*/true).GetMatchRange(&lower,
+                                                                 &upper));
+  EXPECT_EQ("a\xFF\xFF", lower);
+  EXPECT_EQ("b", upper.value());
+
+  ASSERT_TRUE(MakeMatcher("%").GetMatchRange(&lower, &upper));
+  EXPECT_EQ("", lower);
+  EXPECT_FALSE(upper.has_value());
+
+  EXPECT_FALSE(MakeMatcher("%abc").GetMatchRange(&lower, &upper));
+  EXPECT_FALSE(MakeMatcher("a_c%").GetMatchRange(&lower, &upper));
+}
+
+}  // namespace
+}  // namespace functions
+}  // namespace zetasql
@@ -0,0 +1,208 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/functions/regexp.h"
+
+#include <algorithm>
+
+#include "zetasql/public/functions/util.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+
+namespace zetasql {
+namespace functions {
+
+namespace {
+
+// \0 to \9 in a REGEXP_REPLACE rewrite.
+constexpr int kMaxRewriteGroups = 10;
+
+re2::StringPiece ToStringPiece(absl::string_view str) {
+  return re2::StringPiece(str.data(), str.size());
+}
+
+// Returns the number of bytes of the character starting at str[pos], which
+// is 1 if it is not a well-formed lead byte.
+size_t Utf8CharLength(absl::string_view str, size_t pos) {
+  const unsigned char lead = static_cast<unsigned char>(str[pos]);
+  size_t length = 1;
+  if ((lead & 0xE0) == 0xC0) {
+    length = 2;
+  } else if ((lead & 0xF0) == 0xE0) {
+    length = 3;
+  } else if ((lead & 0xF8) == 0xF0) {
+    length = 4;
+  }
+  return std::min(length, str.size() - pos);
+}
+
+}  // namespace
+
+bool RegExp::InitializePatternUtf8(absl::string_view pattern,
+                                   zetasql_base::Status* error) {
+  RE2::Options options;
+  options.set_encoding(RE2::Options::EncodingUTF8);
+  return InitializePattern(pattern, options, error);
+}
+
+bool RegExp::InitializePatternBytes(absl::string_view pattern,
+                                    zetasql_base::Status* error) {
+  RE2::Options options;
+  options.set_encoding(RE2::Options::EncodingLatin1);
+  return InitializePattern(pattern, options, error);
+}
+
+bool RegExp::InitializePattern(absl::string_view pattern, RE2::Options options,
+                               zetasql_base::Status* error) {
+  options.set_log_errors(false);
+  auto re = absl::make_unique<const RE2>(ToStringPiece(pattern), options);
+  if (!re->ok()) {
+    return internal::UpdateError(
+        error, absl::StrCat("Cannot parse regular expression: ", re->error()));
+  }
+  re_ = std::move(re);
+  return true;
+}
+
+bool RegExp::Contains(absl::string_view str, bool* out,
+                      zetasql_base::Status* error) const {
+  *out = re_->Match(ToStringPiece(str), 0, str.size(), RE2::UNANCHORED,
+                    /*submatch=*/nullptr, /*nsubmatch=*/0);
+  return true;
+}
+
+bool RegExp::Match(absl::string_view str, bool* out,
+                   zetasql_base::Status* error) const {
+  *out = re_->Match(ToStringPiece(str), 0, str.size(), RE2::ANCHOR_BOTH,
+                    /*submatch=*/nullptr, /*nsubmatch=*/0);
+  return true;
+}
+
+bool RegExp::Extract(absl::string_view str, absl::string_view* out,
+                     bool* is_null, zetasql_base::Status* error) const {
+  const int num_groups = re_->NumberOfCapturingGroups();
+  if (num_groups > 1) {
+    return internal::UpdateError(
+        error,
+        "Regular expressions passed into extraction functions must not have "
+        "more than 1 capturing group");
+  }
+  re2::StringPiece groups[2];
+  if (!re_->Match(ToStringPiece(str), 0, str.size(), RE2::UNANCHORED, groups,
+                  num_groups + 1)) {
+    *is_null = true;
+    return true;
+  }
+  const re2::StringPiece& match = groups[num_groups];
+  // A capturing group that takes no part in the match is NULL.
+  *is_null = match.data() == nullptr;
+  *out = absl::string_view(match.data(), match.size());
+  return true;
+}
+
+bool RegExp::Replace(absl::string_view str, absl::string_view newsub,
+                     std::string* out, zetasql_base::Status* error) const {
+  std::string rewrite_error;
+  if (!re_->CheckRewriteString(ToStringPiece(newsub), &rewrite_error)) {
+    return internal::UpdateError(
+        error, absl::StrCat("Invalid REGEXP_REPLACE pattern: ", rewrite_error));
+  }
+  const int num_groups =
+      std::min(re_->NumberOfCapturingGroups() + 1, kMaxRewriteGroups);
+  const bool is_utf8 = re_->options().encoding() == RE2::Options::EncodingUTF8;
+  re2::StringPiece groups[kMaxRewriteGroups];
+
+  out->clear();
+  size_t pos = 0;
+  // The end of the last match, after which an empty match is not replaced,
+  // as in RE2::GlobalReplace().
+  size_t last_end = absl::string_view::npos;
+  while (pos <= str.size()) {
+    if (!re_->Match(ToStringPiece(str), pos, str.size(), RE2::UNANCHORED,
+                    groups, num_groups)) {
+      break;
+    }
+    const size_t match_start = groups[0].data() - str.data();
+    out->append(str.data() + pos, match_start - pos);
+    if (groups[0].empty() && match_start == last_end) {
+      // Skip ahead one character to find the next match.
+      if (pos == str.size()) break;
+      const size_t length = is_utf8 ? Utf8CharLength(str, pos) : 1;
+      out->append(str.data() + pos, length);
+      pos += length;
+      continue;
+    }
+    re_->Rewrite(out, ToStringPiece(newsub), groups, num_groups);
+    pos = match_start + groups[0].size();
+    last_end = pos;
+  }
+  if (pos < str.size()) {
+    out->append(str.data() + pos, str.size() - pos);
+  }
+  return true;
+}
+
+void RegexpContainsBatch(const RegExp& regexp, const char* data,
+                         const int64_t* offsets, const uint64_t* validity,
+                         int64_t num_rows, bool* out) {
+  const RE2& re = regexp.re();
+  for (int64_t i = 0; i < num_rows; ++i) {
+    if (validity != nullptr &&
+        (validity[i / 64] & (uint64_t{1} << (i % 64))) == 0) {
+      out[i] = false;
+      continue;
+    }
+    const size_t size = offsets[i + 1] - offsets[i];
+    out[i] = re.Match(re2::StringPiece(data + offsets[i], size), 0, size,
+                      RE2::UNANCHORED, /*submatch=*/nullptr, /*nsubmatch=*/0);
+  }
+}
+
+zetasql_base::Status RegExpCache::Lookup(absl::string_view pattern, bool is_bytes,
+                                 std::shared_ptr<const RegExp>* regexp) {
+  const std::string key = absl::StrCat(is_bytes ? "b" : "s", pattern);
+  {
+    absl::ReaderMutexLock lock(&mutex_);
+    auto it = regexps_.find(key);
+    if (it != regexps_.end()) {
+      *regexp = it->second;
+      return zetasql_base::OkStatus();
+    }
+  }
+
+  // Compile outside the lock; if another thread adds the same pattern first,
+  // its RegExp is kept.
+  auto compiled = std::make_shared<RegExp>();
+  zetasql_base::Status error;
+  if (is_bytes ? !compiled->InitializePatternBytes(pattern, &error)
+               : !compiled->InitializePatternUtf8(pattern, &error)) {
+    return error;
+  }
+  absl::MutexLock lock(&mutex_);
+  if (regexps_.size() >= max_entries_ && !regexps_.contains(key)) {
+    regexps_.clear();
+  }
+  *regexp = regexps_.emplace(key, std::move(compiled)).first->second;
+  return zetasql_base::OkStatus();
+}
+
+int64_t RegExpCache::size() const {
+  absl::ReaderMutexLock lock(&mutex_);
+  return regexps_.size();
+}
+
+}  // namespace functions
+}  // namespace zetasql
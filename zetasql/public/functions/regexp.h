@@ -0,0 +1,133 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// This file implements the REGEXP_MATCH, REGEXP_CONTAINS, REGEXP_EXTRACT and
+// REGEXP_REPLACE functions over STRING and BYTES.
+//
+// A RegExp is compiled once from its pattern and then applied to any number
+// of inputs, so engines should initialize one when an expression with a
+// constant pattern is prepared, and look patterns that vary per row up in a
+// RegExpCache.
+
+#ifndef ZETASQL_PUBLIC_FUNCTIONS_REGEXP_H_
+#define ZETASQL_PUBLIC_FUNCTIONS_REGEXP_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "zetasql/base/status.h"
+#include "re2/re2.h"
+
+namespace zetasql {
+namespace functions {
+
+// A compiled regular expression for the REGEXP_* functions. The functions
+// return false and set *error on errors, as in arithmetics.h.
+//
+// Once initialized, this class is thread-safe.
+class RegExp {
+ public:
+  RegExp() {}
+  RegExp(const RegExp&) = delete;
+  RegExp& operator=(const RegExp&) = delete;
+
+  // Compiles <pattern> for STRING inputs, in which it matches characters.
+  bool InitializePatternUtf8(absl::string_view pattern,
+                             zetasql_base::Status* error);
+
+  // Compiles <pattern> for BYTES inputs, in which it matches bytes.
+  bool InitializePatternBytes(absl::string_view pattern,
+                              zetasql_base::Status* error);
+
+  // REGEXP_CONTAINS: sets *out to whether a substring of <str> matches.
+  bool Contains(absl::string_view str, bool* out,
+                zetasql_base::Status* error) const;
+
+  // REGEXP_MATCH: sets *out to whether all of <str> matches.
+  bool Match(absl::string_view str, bool* out, zetasql_base::Status* error) const;
+
+  // REGEXP_EXTRACT: sets *out to the first match in <str>, or to its capturing
+  // group if the pattern has one, and *is_null to whether there is no such
+  // match. *out points into <str>. It is an error for the pattern to have more
+  // than one capturing group.
+  bool Extract(absl::string_view str, absl::string_view* out, bool* is_null,
+               zetasql_base::Status* error) const;
+
+  // REGEXP_REPLACE: sets *out to <str> with every non-overlapping match
+  // replaced by <newsub>, in which \0 to \9 stand for the match and its
+  // capturing groups and \\ for a backslash.
+  bool Replace(absl::string_view str, absl::string_view newsub,
+               std::string* out, zetasql_base::Status* error) const;
+
+  // REQUIRES: the pattern is initialized.
+  const RE2& re() const { return *re_; }
+
+ private:
+  bool InitializePattern(absl::string_view pattern, RE2::Options options,
+                         zetasql_base::Status* error);
+
+  std::unique_ptr<const RE2> re_;
+};
+
+// REGEXP_CONTAINS over a column of <num_rows> strings in the layout of
+// ColumnVector::string_data() and offsets(): row i is
+// [data + offsets[i], data + offsets[i + 1]). Sets out[i] for every row; the
+// value for rows that are NULL in <validity>, which may be null, is false.
+// Never fails once <regexp> is initialized.
+void RegexpContainsBatch(const RegExp& regexp, const char* data,
+                         const int64_t* offsets, const uint64_t* validity,
+                         int64_t num_rows, bool* out);
+
+// A map from patterns to RegExps compiled the first time each pattern is
+// looked up, for patterns that are not constant. STRING and BYTES patterns
+// are kept apart. When the cache has <max_entries> patterns, it is cleared
+// before the next one is added, so it stays bounded when every row has a
+// different pattern; RegExps in use are kept alive by their shared_ptrs.
+//
+// This class is thread-safe.
+class RegExpCache {
+ public:
+  explicit RegExpCache(int64_t max_entries = 1000)
+      : max_entries_(max_entries) {}
+  RegExpCache(const RegExpCache&) = delete;
+  RegExpCache& operator=(const RegExpCache&) = delete;
+
+  // Sets *regexp to <pattern> compiled for BYTES inputs if <is_bytes> and
+  // for STRING inputs otherwise. Returns the error from initializing the
+  // RegExp if the pattern does not compile; such patterns are not cached.
+  zetasql_base::Status Lookup(absl::string_view pattern, bool is_bytes,
+                      std::shared_ptr<const RegExp>* regexp)
+      LOCKS_EXCLUDED(mutex_);
+
+  int64_t size() const LOCKS_EXCLUDED(mutex_);
+
+ private:
+  const int64_t max_entries_;
+  mutable absl::Mutex mutex_;
+  // Keyed by 'b' or 's' followed by the pattern.
+  absl::flat_hash_map<std::string, std::shared_ptr<const RegExp>> regexps_
+      GUARDED_BY(mutex_);
+};
+
+}  // namespace functions
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_FUNCTIONS_REGEXP_H_
@@ -0,0 +1,167 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/functions/regexp.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+
+namespace zetasql {
+namespace functions {
+namespace {
+
+using ::testing::HasSubstr;
+using zetasql_base::testing::StatusIs;
+
+std::unique_ptr<RegExp> MakeRegExp(absl::string_view pattern,
+                                   bool is_bytes = false) {
+  auto regexp = absl::make_unique<RegExp>();
+  zetasql_base::Status error;
+  const bool ok = is_bytes ? regexp->InitializePatternBytes(pattern, &error)
+                           : regexp->InitializePatternUtf8(pattern, &error);
+  EXPECT_TRUE(ok) << error;
+  return regexp;
+}
+
+TEST(RegExpTest, ContainsAndMatch) {
+  std::unique_ptr<RegExp> regexp = MakeRegExp("b+");
+  zetasql_base::Status error;
+  bool out;
+  ASSERT_TRUE(regexp->Contains("abbc", &out, &error));
+  EXPECT_TRUE(out);
+  ASSERT_TRUE(regexp->Contains("ac", &out, &error));
+  EXPECT_FALSE(out);
+  ASSERT_TRUE(regexp->Match("abbc", &out, &error));
+  EXPECT_FALSE(out);
+  ASSERT_TRUE(regexp->Match("bb", &out, &error));
+  EXPECT_TRUE(out);
+}
+
+TEST(RegExpTest, Utf8AndBytes) {
+  zetasql_base::Status error;
+  bool out;
+  // "." is one character in STRING mode and one byte in BYTES mode.
+  ASSERT_TRUE(MakeRegExp("^.$")->Contains("\xC3\xA9", &out, &error));
+  EXPECT_TRUE(out);
+  ASSERT_TRUE(MakeRegExp("^.$", /*is_bytes=*/true)
+                  ->Contains("\xC3\xA9", &out, &error));
+  EXPECT_FALSE(out);
+}
+
+TEST(RegExpTest, Extract) {
+  zetasql_base::Status error;
+  absl::string_view out;
+  bool is_null;
+  ASSERT_TRUE(MakeRegExp("b+")->Extract("abbc", &out, &is_null, &error));
+  EXPECT_FALSE(is_null);
+  EXPECT_EQ("bb", out);
+  ASSERT_TRUE(MakeRegExp("a(b+)")->Extract("abbc", &out, &is_null, &error));
+  EXPECT_FALSE(is_null);
+  EXPECT_EQ("bb", out);
+  ASSERT_TRUE(MakeRegExp("x")->Extract("abbc", &out, &is_null, &error));
+  EXPECT_TRUE(is_null);
+  ASSERT_TRUE(MakeRegExp("a(x)?")->Extract("abbc", &out, &is_null, &error));
+  EXPECT_TRUE(is_null);
+
+  EXPECT_FALSE(MakeRegExp("(a)(b)")->Extract("ab", &out, &is_null, &error));
+  EXPECT_THAT(error, StatusIs(zetasql_base::StatusCode::kOutOfRange,
+                              HasSubstr("more than 1 capturing group")));
+}
+
+TEST(RegExpTest, Replace) {
+  zetasql_base::Status error;
+  std::string out;
+  ASSERT_TRUE(MakeRegExp("b+")->Replace("abbcb", "X", &out, &error));
+  EXPECT_EQ("aXcX", out);
+  ASSERT_TRUE(
+      MakeRegExp("(a)(b)")->Replace("abab", "\\2\\1\\\\", &out, &error));
+  EXPECT_EQ("ba\\ba\\", out);
+  ASSERT_TRUE(MakeRegExp("x*")->Replace("abc", "-", &out, &error));
+  EXPECT_EQ("-a-b-c-", out);
+  // Empty matches skip whole characters in STRING mode.
+  ASSERT_TRUE(MakeRegExp("")->Replace("\xC3\xA9", "-", &out, &error));
+  EXPECT_EQ("-\xC3\xA9-", out);
+
+  EXPECT_FALSE(MakeRegExp("a")->Replace("abc", "\\1", &out, &error));
+  EXPECT_THAT(error, StatusIs(zetasql_base::StatusCode::kOutOfRange,
+                              HasSubstr("Invalid REGEXP_REPLACE pattern")));
+}
+
+TEST(RegExpTest, InvalidPattern) {
+  RegExp regexp;
+  zetasql_base::Status error;
+  EXPECT_FALSE(regexp.InitializePatternUtf8("(", &error));
+  EXPECT_THAT(error, StatusIs(zetasql_base::StatusCode::kOutOfRange,
+                              HasSubstr("Cannot parse regular expression")));
+}
+
+TEST(RegExpTest, ContainsBatch) {
+  const std::string data = "abbcacb";
+  const std::vector<int64_t> offsets = {0, 2, 4, 5, 7};
+  const uint64_t validity = 0b1011;
+  bool out[4];
+  RegexpContainsBatch(*MakeRegExp("b$"), data.data(), offsets.data(),
+                      &validity, 4, out);
+  // "ab", "bc", NULL, "cb".
+  EXPECT_TRUE(out[0]);
+  EXPECT_FALSE(out[1]);
+  EXPECT_FALSE(out[2]);
+  EXPECT_TRUE(out[3]);
+}
+
+TEST(RegExpCacheTest, Lookup) {
+  RegExpCache cache(/*max_entries=*/2);
+  std::shared_ptr<const RegExp> first;
+  ZETASQL_ASSERT_OK(cache.Lookup("^.$", /*is_bytes=*/false, &first));
+  std::shared_ptr<const RegExp> again;
+  ZETASQL_ASSERT_OK(cache.Lookup("^.$", /*is_bytes=*/false, &again));
+  EXPECT_EQ(first, again);
+  std::shared_ptr<const RegExp> bytes;
+  ZETASQL_ASSERT_OK(cache.Lookup("^.$", /*is_bytes=*/true, &bytes));
+  EXPECT_NE(first, bytes);
+  EXPECT_EQ(2, cache.size());
+
+  zetasql_base::Status error;
+  bool out;
+  ASSERT_TRUE(first->Contains("\xC3\xA9", &out, &error));
+  EXPECT_TRUE(out);
+  ASSERT_TRUE(bytes->Contains("\xC3\xA9", &out, &error));
+  EXPECT_FALSE(out);
+
+  // The cache is cleared when it is full; RegExps already looked up remain
+  // usable.
+  std::shared_ptr<const RegExp> other;
+  ZETASQL_ASSERT_OK(cache.Lookup("a", /*is_bytes=*/false, &other));
+  EXPECT_EQ(1, cache.size());
+  ASSERT_TRUE(first->Contains("x", &out, &error));
+  EXPECT_TRUE(out);
+
+  EXPECT_THAT(cache.Lookup("(", /*is_bytes=*/false, &other),
+              StatusIs(zetasql_base::StatusCode::kOutOfRange));
+  EXPECT_EQ(1, cache.size());
+}
+
+}  // namespace
+}  // namespace functions
+}  // namespace zetasql
@@ -0,0 +1,166 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/functions/string.h"
+
+#include <cstdint>
+
+#include "zetasql/common/utf_util.h"
+#include "zetasql/public/functions/util.h"
+#include "absl/strings/str_cat.h"
+#include "unicode/bytestream.h"
+#include "unicode/locid.h"
+#include "unicode/normalizer2.h"
+#include "unicode/unistr.h"
+
+namespace zetasql {
+namespace functions {
+
+namespace {
+
+constexpr char kInvalidUtf8Error[] = "A string is not valid UTF-8";
+
+// Maps the ASCII letters of <str> to upper case if <upper> and to lower case
+// otherwise, and copies every other byte. Written without branches on the
+// bytes so that the loop is vectorized.
+void MapAsciiCase(absl::string_view str, bool upper, std::string* out) {
+  const uint8_t first = upper ? 'a' : 'A';
+  out->resize(str.size());
+  const uint8_t* in = reinterpret_cast<const uint8_t*>(str.data());
+  char* dest = &(*out)[0];
+  for (size_t i = 0; i < str.size(); ++i) {
+    const uint8_t c = in[i];
+    const bool is_letter = static_cast<uint8_t>(c - first) < 26;
+    dest[i] = static_cast<char>(c ^ (is_letter << 5));
+  }
+}
+
+icu::UnicodeString ToUnicodeString(absl::string_view str) {
+  return icu::UnicodeString::fromUTF8(
+      icu::StringPiece(str.data(), static_cast<int32_t>(str.size())));
+}
+
+const icu::Normalizer2* GetNormalizer(NormalizeMode mode,
+                                      UErrorCode* status) {
+  switch (mode) {
+    case NFKC:
+      return icu::Normalizer2::getNFKCInstance(*status);
+    case NFD:
+      return icu::Normalizer2::getNFDInstance(*status);
+    case NFKD:
+      return icu::Normalizer2::getNFKDInstance(*status);
+    case NFC:
+    default:
+      return icu::Normalizer2::getNFCInstance(*status);
+  }
+}
+
+}  // namespace
+
+bool UpperUtf8(absl::string_view str, std::string* out,
+               zetasql_base::Status* error) {
+  if (IsASCII(str)) {
+    MapAsciiCase(str, /*upper=*/true, out);
+    return true;
+  }
+  if (!IsWellFormedUTF8(str)) {
+    return internal::UpdateError(error, kInvalidUtf8Error);
+  }
+  out->clear();
+  ToUnicodeString(str).toUpper(icu::Locale::getRoot()).toUTF8String(*out);
+  return true;
+}
+
+bool LowerUtf8(absl::string_view str, std::string* out,
+               zetasql_base::Status* error) {
+  if (IsASCII(str)) {
+    MapAsciiCase(str, /*upper=*/false, out);
+    return true;
+  }
+  if (!IsWellFormedUTF8(str)) {
+    return internal::UpdateError(error, kInvalidUtf8Error);
+  }
+  out->clear();
+  ToUnicodeString(str).toLower(icu::Locale::getRoot()).toUTF8String(*out);
+  return true;
+}
+
+bool UpperBytes(absl::string_view str, std::string* out,
+                zetasql_base::Status* error) {
+  MapAsciiCase(str, /*upper=*/true, out);
+  return true;
+}
+
+bool LowerBytes(absl::string_view str, std::string* out,
+                zetasql_base::Status* error) {
+  MapAsciiCase(str, /*upper=*/false, out);
+  return true;
+}
+
+bool Normalize(absl::string_view str, NormalizeMode mode, bool is_casefold,
+               std::string* out, zetasql_base::Status* error) {
+  if (IsASCII(str)) {
+    // Case folding maps ASCII to lower case.
+    if (is_casefold) {
+      MapAsciiCase(str, /*upper=*/false, out);
+    } else {
+      out->assign(str.data(), str.size());
+    }
+    return true;
+  }
+  if (!IsWellFormedUTF8(str)) {
+    return internal::UpdateError(error, kInvalidUtf8Error);
+  }
+
+  UErrorCode status = U_ZERO_ERROR;
+  const icu::StringPiece piece(str.data(), static_cast<int32_t>(str.size()));
+  out->clear();
+  if (is_casefold && mode != NFKC) {
+    // Only NFKC has a combined case folding normalizer.
+    const icu::Normalizer2* normalizer = GetNormalizer(mode, &status);
+    icu::UnicodeString folded = ToUnicodeString(str);
+    folded.foldCase();
+    icu::UnicodeString normalized;
+    if (U_SUCCESS(status)) {
+      normalizer->normalize(folded, normalized, status);
+    }
+    if (U_SUCCESS(status)) {
+      normalized.toUTF8String(*out);
+    }
+  } else {
+    const icu::Normalizer2* normalizer =
+        is_casefold ? icu::Normalizer2::getNFKCCasefoldInstance(status)
+                    : GetNormalizer(mode, &status);
+    if (U_SUCCESS(status) && normalizer->isNormalizedUTF8(piece, status)) {
+      out->assign(str.data(), str.size());
+      return true;
+    }
+    if (U_SUCCESS(status)) {
+      icu::StringByteSink<std::string> sink(out);
+      normalizer->normalizeUTF8(/*options=*/0, piece, sink,
+                                /*edits=*/nullptr, status);
+    }
+  }
+  if (U_FAILURE(status)) {
+    return internal::UpdateError(
+        error, absl::StrCat("Failed to normalize a string: ",
+                            u_errorName(status)));
+  }
+  return true;
+}
+
+}  // namespace functions
+}  // namespace zetasql
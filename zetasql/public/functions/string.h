@@ -0,0 +1,59 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// This file implements UPPER, LOWER, NORMALIZE and NORMALIZE_AND_CASEFOLD.
+//
+// STRING inputs that are all ASCII, which is most of them in practice, are
+// mapped byte by byte without ICU: ASCII has no multi-character case
+// mappings and is already in every normalization form. Other inputs go
+// through ICU with the root locale, after a quick check in the case of
+// normalization, so the results are always those of ICU.
+//
+// The functions return false and set *error on errors, as in arithmetics.h.
+// The only error is a STRING input that is not valid UTF-8.
+
+#ifndef ZETASQL_PUBLIC_FUNCTIONS_STRING_H_
+#define ZETASQL_PUBLIC_FUNCTIONS_STRING_H_
+
+#include <string>
+
+#include "zetasql/public/functions/normalize_mode.pb.h"
+#include "absl/strings/string_view.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+namespace functions {
+
+// UPPER and LOWER for STRING.
+bool UpperUtf8(absl::string_view str, std::string* out,
+               zetasql_base::Status* error);
+bool LowerUtf8(absl::string_view str, std::string* out,
+               zetasql_base::Status* error);
+
+// UPPER and LOWER for BYTES, which only map the ASCII letters. Never fail.
+bool UpperBytes(absl::string_view str, std::string* out,
+                zetasql_base::Status* error);
+bool LowerBytes(absl::string_view str, std::string* out,
+                zetasql_base::Status* error);
+
+// NORMALIZE if <is_casefold> is false and NORMALIZE_AND_CASEFOLD otherwise.
+bool Normalize(absl::string_view str, NormalizeMode mode, bool is_casefold,
+               std::string* out, zetasql_base::Status* error);
+
+}  // namespace functions
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_FUNCTIONS_STRING_H_
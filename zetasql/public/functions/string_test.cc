@@ -0,0 +1,96 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/functions/string.h"
+
+#include <string>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace zetasql {
+namespace functions {
+namespace {
+
+using zetasql_base::testing::StatusIs;
+
+std::string Upper(absl::string_view str) {
+  std::string out;
+  zetasql_base::Status error;
+  EXPECT_TRUE(UpperUtf8(str, &out, &error)) << error;
+  return out;
+}
+
+std::string Lower(absl::string_view str) {
+  std::string out;
+  zetasql_base::Status error;
+  EXPECT_TRUE(LowerUtf8(str, &out, &error)) << error;
+  return out;
+}
+
+std::string Normalized(absl::string_view str, NormalizeMode mode,
+                       bool is_casefold = false) {
+  std::string out;
+  zetasql_base::Status error;
+  EXPECT_TRUE(Normalize(str, mode, is_casefold, &out, &error)) << error;
+  return out;
+}
+
+TEST(StringTest, UpperAndLower) {
+  EXPECT_EQ("", Upper(""));
+  EXPECT_EQ("ABC XYZ@[`{09", Upper("abc xYz@[`{09"));
+  EXPECT_EQ("abc xyz@[`{09", Lower("ABC XyZ@[`{09"));
+  // Non-ASCII strings use the full case mappings of ICU.
+  EXPECT_EQ("STRASSE", Upper("straße"));
+  EXPECT_EQ("ÉTÉ", Upper("été"));
+  EXPECT_EQ("été", Lower("ÉTÉ"));
+
+  std::string out;
+  zetasql_base::Status error;
+  ASSERT_TRUE(UpperBytes("ab\xE9", &out, &error));
+  EXPECT_EQ("AB\xE9", out);
+  ASSERT_TRUE(LowerBytes("AB\xC9", &out, &error));
+  EXPECT_EQ("ab\xC9", out);
+}
+
+TEST(StringTest, Normalize) {
+  EXPECT_EQ("abc", Normalized("abc", NFD));
+  EXPECT_EQ("abc", Normalized("aBC", NFC, /*is_casefold=*/true));
+  // "e" and a combining acute accent compose into U+00E9.
+  EXPECT_EQ("\xC3\xA9", Normalized("e\xCC\x81", NFC));
+  EXPECT_EQ("e\xCC\x81", Normalized("\xC3\xA9", NFD));
+  EXPECT_EQ("\xC3\xA9", Normalized("\xC3\xA9", NFC));
+  EXPECT_EQ("TM", Normalized("™", NFKC));
+  EXPECT_EQ("™", Normalized("™", NFC));
+  EXPECT_EQ("tm", Normalized("™", NFKC, /*is_casefold=*/true));
+  EXPECT_EQ("e\xCC\x81", Normalized("\xC3\x89", NFD, /*is_casefold=*/true));
+  EXPECT_EQ("strasse", Normalized("Straße", NFC, /*is_casefold=*/true));
+}
+
+TEST(StringTest, InvalidUtf8) {
+  std::string out;
+  zetasql_base::Status error;
+  EXPECT_FALSE(UpperUtf8("a\xC1", &out, &error));
+  EXPECT_THAT(error, StatusIs(zetasql_base::StatusCode::kOutOfRange));
+  error = zetasql_base::OkStatus();
+  EXPECT_FALSE(Normalize("a\xC1", NFC, /*is_casefold=*/false, &out, &error));
+  EXPECT_THAT(error, StatusIs(zetasql_base::StatusCode::kOutOfRange));
+}
+
+}  // namespace
+}  // namespace functions
+}  // namespace zetasql
@@ -0,0 +1,118 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/functions/time_zone_cache.h"
+
+#include <algorithm>
+#include <string>
+
+#include "absl/memory/memory.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+namespace functions {
+namespace date_time_util_internal {
+
+namespace {
+
+constexpr int64_t kSecondsPerDay = 24 * 60 * 60;
+
+// The first day of the table, at 0 seconds from the epoch in UTC.
+constexpr absl::CivilDay kFirstDay(1970, 1, 1);
+constexpr int64_t kNumDays = absl::CivilDay(2070, 1, 1) - kFirstDay;
+
+}  // namespace
+
+void CachedTimeZone::InitDayStarts() const {
+  day_starts_.reserve(kNumDays + 1);
+  for (int64_t i = 0; i <= kNumDays; ++i) {
+    const int64_t start = absl::ToUnixSeconds(
+        timezone_.At(absl::CivilSecond(kFirstDay + i)).pre);
+    if (!day_starts_.empty() && start < day_starts_.back()) {
+      day_starts_.clear();
+      day_starts_.shrink_to_fit();
+      return;
+    }
+    day_starts_.push_back(start);
+  }
+  // Within a day without a transition, every time is on that day. Around a
+  // transition, e.g. when clocks go back from 00:01 to 23:01, the times after
+  // the start of a day can belong to the day before.
+  day_has_transition_.resize(kNumDays);
+  for (int64_t i = 0; i < kNumDays; ++i) {
+    if (day_starts_[i] == day_starts_[i + 1]) continue;
+    const absl::TimeZone::CivilInfo first =
+        timezone_.At(absl::FromUnixSeconds(day_starts_[i]));
+    const absl::TimeZone::CivilInfo last =
+        timezone_.At(absl::FromUnixSeconds(day_starts_[i + 1] - 1));
+    day_has_transition_[i] = first.offset != last.offset ||
+                             first.cs != absl::CivilSecond(kFirstDay + i);
+  }
+}
+
+bool CachedTimeZone::LookupDay(absl::Time time, absl::CivilDay* day,
+                               absl::Time* day_start) const {
+  absl::call_once(day_starts_once_, [this]() { InitDayStarts(); });
+  if (day_starts_.empty()) return false;
+  const int64_t seconds = absl::ToUnixSeconds(time);
+  if (seconds < day_starts_.front() || seconds >= day_starts_.back()) {
+    return false;
+  }
+  // The offset of the time zone is less than a day, so the civil day is
+  // within one day of the UTC day. Days can also be empty, when a time zone
+  // skips one, which the loops step over.
+  int64_t i = std::min(std::max<int64_t>(seconds / kSecondsPerDay, 0),
+                       kNumDays - 1);
+  while (day_starts_[i] > seconds) --i;
+  while (day_starts_[i + 1] <= seconds) ++i;
+  if (day_has_transition_[i]) return false;
+  *day = kFirstDay + i;
+  *day_start = absl::FromUnixSeconds(day_starts_[i]);
+  return true;
+}
+
+zetasql_base::Status TimeZoneCache::Lookup(absl::string_view timezone_string,
+                                   const CachedTimeZone** cached) {
+  {
+    absl::ReaderMutexLock lock(&mutex_);
+    auto it = zones_.find(timezone_string);
+    if (it != zones_.end()) {
+      *cached = it->second.get();
+      return zetasql_base::OkStatus();
+    }
+  }
+  // Loading may read a zoneinfo file, so it is done without holding the lock.
+  // Two threads may then load the same time zone, and the first one to insert
+  // it wins.
+  absl::TimeZone timezone;
+  ZETASQL_RETURN_IF_ERROR(loader_(timezone_string, &timezone));
+  absl::MutexLock lock(&mutex_);
+  std::unique_ptr<CachedTimeZone>& entry = zones_[std::string(timezone_string)];
+  if (entry == nullptr) {
+    entry = absl::make_unique<CachedTimeZone>(timezone);
+  }
+  *cached = entry.get();
+  return zetasql_base::OkStatus();
+}
+
+int64_t TimeZoneCache::size() const {
+  absl::ReaderMutexLock lock(&mutex_);
+  return zones_.size();
+}
+
+}  // namespace date_time_util_internal
+}  // namespace functions
+}  // namespace zetasql
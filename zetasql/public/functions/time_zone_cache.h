@@ -0,0 +1,109 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PUBLIC_FUNCTIONS_TIME_ZONE_CACHE_H_
+#define ZETASQL_PUBLIC_FUNCTIONS_TIME_ZONE_CACHE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/call_once.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/civil_time.h"
+#include "absl/time/time.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+namespace functions {
+namespace date_time_util_internal {
+
+// A time zone together with the start of each of its civil days from
+// 1970-01-01 to 2069-12-31, so that the civil day of a timestamp and the start
+// of that day (as for TIMESTAMP_TRUNC(timestamp, DAY)) can be found with a
+// couple of comparisons instead of two time zone lookups. The table takes
+// about 300KB and is built on first use. Days with a transition, of which
+// there are usually two a year, are left to the time zone.
+//
+// This class is thread-safe.
+class CachedTimeZone {
+ public:
+  explicit CachedTimeZone(absl::TimeZone timezone) : timezone_(timezone) {}
+  CachedTimeZone(const CachedTimeZone&) = delete;
+  CachedTimeZone& operator=(const CachedTimeZone&) = delete;
+
+  const absl::TimeZone& timezone() const { return timezone_; }
+
+  // Sets <*day> to the civil day of <time> in the time zone and <*day_start>
+  // to timezone().At(absl::CivilSecond(*day)).pre. Returns false, leaving
+  // both unchanged, if <time> is outside the days of the table or on a day
+  // with a transition of the time zone, for which callers must look the day
+  // up in timezone().
+  bool LookupDay(absl::Time time, absl::CivilDay* day,
+                 absl::Time* day_start) const;
+
+ private:
+  void InitDayStarts() const;
+
+  const absl::TimeZone timezone_;
+  mutable absl::once_flag day_starts_once_;
+  // The start of each day of the table and of the day after it, in seconds
+  // from the epoch. Empty if the starts are not in order, which would mean
+  // that they do not split time into civil days.
+  mutable std::vector<int64_t> day_starts_;
+  // Whether the offset of the time zone changes during each day of the
+  // table, in which case LookupDay() returns false.
+  mutable std::vector<bool> day_has_transition_;
+};
+
+// A read-mostly map from time zone strings to CachedTimeZones, which are
+// loaded by a <loader> such as MakeTimeZone() the first time each string is
+// looked up. Only strings that load are added, and there are finitely many
+// of those, so the cache is not bounded.
+//
+// This class is thread-safe.
+class TimeZoneCache {
+ public:
+  using Loader = zetasql_base::Status (*)(absl::string_view timezone_string,
+                                  absl::TimeZone* timezone);
+
+  explicit TimeZoneCache(Loader loader) : loader_(loader) {}
+  TimeZoneCache(const TimeZoneCache&) = delete;
+  TimeZoneCache& operator=(const TimeZoneCache&) = delete;
+
+  // Sets <*cached> to the time zone of <timezone_string>, which lives as long
+  // as the cache. Returns the error from the loader if it does not load.
+  zetasql_base::Status Lookup(absl::string_view timezone_string,
+                      const CachedTimeZone** cached) LOCKS_EXCLUDED(mutex_);
+
+  int64_t size() const LOCKS_EXCLUDED(mutex_);
+
+ private:
+  const Loader loader_;
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<std::string, std::unique_ptr<CachedTimeZone>> zones_
+      GUARDED_BY(mutex_);
+};
+
+}  // namespace date_time_util_internal
+}  // namespace functions
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_FUNCTIONS_TIME_ZONE_CACHE_H_
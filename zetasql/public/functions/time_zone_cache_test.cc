@@ -0,0 +1,151 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/functions/time_zone_cache.h"
+
+#include <random>
+#include <string>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/time/civil_time.h"
+#include "absl/time/time.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+namespace functions {
+namespace date_time_util_internal {
+namespace {
+
+using ::zetasql_base::testing::StatusIs;
+
+// Checks LookupDay() against the civil day of <time>, and the start of that
+// day as TIMESTAMP_TRUNC(time, DAY) computes it. Returns false if LookupDay()
+// left the day to the time zone, as for days with a transition.
+bool CheckLookupDay(const CachedTimeZone& cached, absl::Time time) {
+  const absl::TimeZone& timezone = cached.timezone();
+  const absl::CivilDay expected_day(timezone.At(time).cs);
+  const absl::Time expected_start =
+      timezone.At(absl::CivilSecond(expected_day)).pre;
+  absl::CivilDay day;
+  absl::Time day_start;
+  if (!cached.LookupDay(time, &day, &day_start)) return false;
+  EXPECT_EQ(expected_day, day) << timezone.name() << " " << time;
+  EXPECT_EQ(expected_start, day_start) << timezone.name() << " " << time;
+  return true;
+}
+
+TEST(CachedTimeZoneTest, LookupDayMatchesTimeZone) {
+  std::vector<absl::TimeZone> timezones = {
+      absl::UTCTimeZone(), absl::FixedTimeZone(-8 * 3600),
+      absl::FixedTimeZone(14 * 3600), absl::FixedTimeZone(-(12 * 3600 + 59))};
+  for (const char* name :
+       {"America/Los_Angeles", "America/Sao_Paulo", "Pacific/Apia",
+        "Australia/Lord_Howe", "Asia/Kolkata", "America/St_Johns"}) {
+    absl::TimeZone timezone;
+    if (absl::LoadTimeZone(name, &timezone)) timezones.push_back(timezone);
+  }
+  std::mt19937_64 random(12345);
+  const absl::Time first = absl::FromCivil(absl::CivilDay(1970, 1, 2),
+                                           absl::UTCTimeZone());
+  const absl::Time last = absl::FromCivil(absl::CivilDay(2069, 12, 30),
+                                          absl::UTCTimeZone());
+  for (const absl::TimeZone& timezone : timezones) {
+    const CachedTimeZone cached(timezone);
+    std::uniform_int_distribution<int64_t> micros(absl::ToUnixMicros(first),
+                                                  absl::ToUnixMicros(last));
+    int num_found = 0;
+    for (int i = 0; i < 10000; ++i) {
+      num_found += CheckLookupDay(cached, absl::FromUnixMicros(micros(random)));
+    }
+    EXPECT_GT(num_found, 9900) << timezone.name();
+    // Around the start of each day, which is where a transition at midnight
+    // would show.
+    for (absl::CivilDay day(2010, 1, 1); day < absl::CivilDay(2013, 1, 1);
+         ++day) {
+      const absl::Time start = timezone.At(absl::CivilSecond(day)).pre;
+      CheckLookupDay(cached, start - absl::Nanoseconds(1));
+      CheckLookupDay(cached, start);
+      CheckLookupDay(cached, start + absl::Hours(1));
+    }
+  }
+}
+
+TEST(CachedTimeZoneTest, LookupDayOutsideTable) {
+  const CachedTimeZone cached(absl::FixedTimeZone(-8 * 3600));
+  absl::CivilDay day;
+  absl::Time day_start;
+  EXPECT_FALSE(cached.LookupDay(
+      absl::FromCivil(absl::CivilDay(1969, 12, 31), absl::UTCTimeZone()),
+      &day, &day_start));
+  EXPECT_FALSE(cached.LookupDay(
+      absl::FromCivil(absl::CivilDay(2070, 1, 2), absl::UTCTimeZone()), &day,
+      &day_start));
+  // Still 2069-12-31 in the time zone.
+  ASSERT_TRUE(cached.LookupDay(
+      absl::FromCivil(absl::CivilDay(2070, 1, 1), absl::UTCTimeZone()), &day,
+      &day_start));
+  EXPECT_EQ(absl::CivilDay(2069, 12, 31), day);
+}
+
+int num_loads = 0;
+
+zetasql_base::Status CountingLoader(absl::string_view timezone_string,
+                            absl::TimeZone* timezone) {
+  ++num_loads;
+  if (timezone_string == "bad") {
+    return zetasql_base::Status(zetasql_base::StatusCode::kOutOfRange, "bad");
+  }
+  *timezone =
+      absl::FixedTimeZone(3600 * static_cast<int>(timezone_string.size()));
+  return zetasql_base::OkStatus();
+}
+
+TEST(TimeZoneCacheTest, LoadsEachTimeZoneOnce) {
+  num_loads = 0;
+  TimeZoneCache cache(&CountingLoader);
+  const CachedTimeZone* first;
+  ZETASQL_ASSERT_OK(cache.Lookup("+1", &first));
+  EXPECT_EQ(absl::FixedTimeZone(2 * 3600), first->timezone());
+  const CachedTimeZone* second;
+  ZETASQL_ASSERT_OK(cache.Lookup("+1", &second));
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(1, num_loads);
+
+  const CachedTimeZone* other;
+  ZETASQL_ASSERT_OK(cache.Lookup("+01", &other));
+  EXPECT_NE(first, other);
+  EXPECT_EQ(2, num_loads);
+  EXPECT_EQ(2, cache.size());
+}
+
+TEST(TimeZoneCacheTest, ErrorsAreNotCached) {
+  num_loads = 0;
+  TimeZoneCache cache(&CountingLoader);
+  const CachedTimeZone* cached;
+  EXPECT_THAT(cache.Lookup("bad", &cached),
+              StatusIs(zetasql_base::StatusCode::kOutOfRange));
+  EXPECT_THAT(cache.Lookup("bad", &cached),
+              StatusIs(zetasql_base::StatusCode::kOutOfRange));
+  EXPECT_EQ(2, num_loads);
+  EXPECT_EQ(0, cache.size());
+}
+
+}  // namespace
+}  // namespace date_time_util_internal
+}  // namespace functions
+}  // namespace zetasql
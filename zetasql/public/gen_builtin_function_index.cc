@@ -0,0 +1,63 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Writes the builtin function index included by builtin_function_index.cc
+// to stdout.  Each line is an initializer {"<name>", <group>} for one
+// builtin function, sorted by name, where <name> is the key used by
+// GetZetaSQLFunctions() and <group> is the index of the group that
+// GetZetaSQLFunctionGroup() builds it in.
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "zetasql/base/logging.h"
+#include "zetasql/public/builtin_function.h"
+#include "zetasql/public/builtin_function_internal.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/language_options.h"
+#include "zetasql/public/type.h"
+#include "absl/strings/ascii.h"
+#include "zetasql/base/map_util.h"
+
+int main(int argc, char** argv) {
+  // Enable everything, to get every function that exists under any options.
+  zetasql::LanguageOptions language_options;
+  language_options.EnableMaximumLanguageFeaturesForDevelopment();
+  language_options.set_product_mode(zetasql::PRODUCT_INTERNAL);
+  const zetasql::ZetaSQLBuiltinFunctionOptions options(language_options);
+
+  zetasql::TypeFactory type_factory;
+  std::map<std::string, int> index;
+  for (int group = 0; group < zetasql::NumZetaSQLFunctionGroups(); ++group) {
+    std::map<std::string, std::unique_ptr<zetasql::Function>> functions;
+    zetasql::GetZetaSQLFunctionGroup(group, &type_factory, options,
+                                         &functions);
+    for (const auto& entry : functions) {
+      // Lookups lower case the requested name.
+      CHECK_EQ(absl::AsciiStrToLower(entry.first), entry.first);
+      CHECK(zetasql_base::InsertIfNotPresent(&index, entry.first, group))
+          << "Function " << entry.first << " is in more than one group";
+    }
+  }
+
+  std::cout << "// Generated by gen_builtin_function_index.  Do not edit.\n";
+  for (const auto& entry : index) {
+    std::cout << "{\"" << entry.first << "\", " << entry.second << "},\n";
+  }
+  return 0;
+}
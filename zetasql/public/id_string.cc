@@ -16,70 +16,193 @@
 
 #include "zetasql/public/id_string.h"
 
+#include <atomic>
+#include <functional>
+#include <thread>  // NOLINT(build/c++11)
+
 #include "zetasql/base/logging.h"
 #include "zetasql/base/case.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/hash/hash.h"
 #include "absl/synchronization/mutex.h"
-#include "zetasql/base/map_util.h"
 
 namespace zetasql {
 
+namespace {
+
+#ifndef NDEBUG
+// The table of live pool ids, in chunks that are allocated as the number of
+// slots grows and are never freed, so that readers need no lock.
+constexpr int64_t kSlotsPerChunk = 1024;
+constexpr int64_t kMaxPoolSlots = int64_t{1} << 20;
+static_assert(kMaxPoolSlots % kSlotsPerChunk == 0, "Partial chunk");
+std::atomic<std::atomic<int64_t>*> pool_slot_chunks[kMaxPoolSlots /
+                                                    kSlotsPerChunk];
+
+std::atomic<int64_t>* PoolSlot(int64_t slot) {
+  std::atomic<int64_t>* chunk =
+      pool_slot_chunks[slot / kSlotsPerChunk].load(std::memory_order_acquire);
+  return chunk == nullptr ? nullptr : &chunk[slot % kSlotsPerChunk];
+}
+#endif
+
+// MakeGlobal() allocates in one of these pools, chosen by thread.
+constexpr int kNumGlobalPoolShards = 16;
+
+struct GlobalPoolShard {
+  absl::Mutex mutex;
+  IdStringPool pool GUARDED_BY(mutex);
+};
+
+GlobalPoolShard* GlobalPoolShardForThisThread() {
+  static GlobalPoolShard* shards = new GlobalPoolShard[kNumGlobalPoolShards];
+  static thread_local const int shard =
+      std::hash<std::thread::id>()(std::this_thread::get_id()) %
+      kNumGlobalPoolShards;
+  return &shards[shard];
+}
+
+}  // namespace
+
 #ifndef NDEBUG
 
 absl::Mutex IdStringPool::global_mutex_;
 
-// Initialize lazily in IdStringPool::AllocatePoolId when first pool is created.
-std::unordered_set<int64_t>* IdStringPool::live_pool_ids_ = nullptr;
+// Initialized lazily in IdStringPool::ReleasePoolId.
+std::vector<int64_t>* IdStringPool::free_pool_slots_ = nullptr;
+
+int64_t IdStringPool::num_pool_slots_ = 0;
 
-int64_t IdStringPool::max_pool_id_ = 0;
+int64_t IdStringPool::max_pool_generation_ = 0;
 
 // static
 void IdStringPool::CheckPoolIdAlive(int64_t pool_id) {
-  absl::MutexLock l(&global_mutex_);
-  DCHECK(live_pool_ids_ != nullptr);
-  if (!zetasql_base::ContainsKey(*live_pool_ids_, pool_id)) {
+  const std::atomic<int64_t>* slot = PoolSlot(pool_id & (kMaxPoolSlots - 1));
+  if (slot == nullptr || slot->load(std::memory_order_acquire) != pool_id) {
     LOG(FATAL) << "IdString was accessed after its IdStringPool ("
                << pool_id << ") was destructed";
   }
 }
 #endif
 
+// Indexes the IdString::Shareds of a deduplicating pool by their contents.
+class IdStringPool::DedupSet {
+ public:
+  const IdString::Shared* Find(absl::string_view str) const {
+    auto it = set_.find(str);
+    return it == set_.end() ? nullptr : *it;
+  }
+
+  void Insert(const IdString::Shared* shared) { set_.insert(shared); }
+
+ private:
+  struct Hash {
+    using is_transparent = void;
+    size_t operator()(absl::string_view str) const {
+      return absl::Hash<absl::string_view>()(str);
+    }
+    size_t operator()(const IdString::Shared* shared) const {
+      return (*this)(shared->str);
+    }
+  };
+  struct Eq {
+    using is_transparent = void;
+    static absl::string_view View(absl::string_view str) { return str; }
+    static absl::string_view View(const IdString::Shared* shared) {
+      return shared->str;
+    }
+    template <typename A, typename B>
+    bool operator()(const A& a, const B& b) const {
+      return View(a) == View(b);
+    }
+  };
+
+  absl::flat_hash_set<const IdString::Shared*, Hash, Eq> set_;
+};
+
 IdStringPool::IdStringPool()
-#ifndef NDEBUG
-    : arena_(std::make_shared<zetasql_base::UnsafeArena>(/*block_size=*/1024)),
-      pool_id_(AllocatePoolId()) {
-  VLOG(1) << "Allocated IdStringPool " << pool_id_;
-#else
-    : arena_(std::make_shared<zetasql_base::UnsafeArena>(/*block_size=*/1024)) {
-#endif
-}
+    : IdStringPool(
+          std::make_shared<zetasql_base::UnsafeArena>(/*block_size=*/1024),
+          Options()) {}
 
 IdStringPool::IdStringPool(const std::shared_ptr<zetasql_base::UnsafeArena>& arena)
+    : IdStringPool(arena, Options()) {}
+
+IdStringPool::IdStringPool(const Options& options)
+    : IdStringPool(
+          std::make_shared<zetasql_base::UnsafeArena>(/*block_size=*/1024),
+          options) {}
+
+IdStringPool::IdStringPool(const std::shared_ptr<zetasql_base::UnsafeArena>& arena,
+                           const Options& options)
 #ifndef NDEBUG
-    : arena_(arena), pool_id_(AllocatePoolId()) {
+    : arena_(arena),
+      dedup_set_(options.deduplicate ? new DedupSet : nullptr),
+      pool_id_(AllocatePoolId()) {
   VLOG(1) << "Allocated IdStringPool " << pool_id_;
 #else
-    : arena_(arena) {
+    : arena_(arena), dedup_set_(options.deduplicate ? new DedupSet : nullptr) {
 #endif
 }
 
 IdStringPool::~IdStringPool() {
 #ifndef NDEBUG
   VLOG(1) << "Deleting IdStringPool " << pool_id_;
-  absl::MutexLock l(&global_mutex_);
-  CHECK_EQ(1, live_pool_ids_->erase(pool_id_));
+  ReleasePoolId(pool_id_);
 #endif
 }
 
 #ifndef NDEBUG
 int64_t IdStringPool::AllocatePoolId() {
+  static_assert(int64_t{1} << kPoolSlotBits == kMaxPoolSlots,
+                "kPoolSlotBits does not match the slot table");
   absl::MutexLock l(&global_mutex_);
-  if (live_pool_ids_ == nullptr) live_pool_ids_ = new std::unordered_set<int64_t>;
-  int64_t pool_id = ++max_pool_id_;
-  zetasql_base::InsertOrDie(live_pool_ids_, pool_id);
+  int64_t slot;
+  if (free_pool_slots_ != nullptr && !free_pool_slots_->empty()) {
+    slot = free_pool_slots_->back();
+    free_pool_slots_->pop_back();
+  } else {
+    slot = num_pool_slots_++;
+    CHECK_LT(slot, kMaxPoolSlots) << "Too many live IdStringPools";
+    if (slot % kSlotsPerChunk == 0) {
+      pool_slot_chunks[slot / kSlotsPerChunk].store(
+          new std::atomic<int64_t>[kSlotsPerChunk](),
+          std::memory_order_release);
+    }
+  }
+  const int64_t pool_id = (++max_pool_generation_ << kPoolSlotBits) | slot;
+  PoolSlot(slot)->store(pool_id, std::memory_order_release);
   return pool_id;
 }
+
+void IdStringPool::ReleasePoolId(int64_t pool_id) {
+  absl::MutexLock l(&global_mutex_);
+  const int64_t slot = pool_id & (kMaxPoolSlots - 1);
+  std::atomic<int64_t>* pool_slot = PoolSlot(slot);
+  CHECK(pool_slot != nullptr &&
+        pool_slot->load(std::memory_order_relaxed) == pool_id)
+      << "Unknown IdStringPool " << pool_id;
+  pool_slot->store(0, std::memory_order_release);
+  if (free_pool_slots_ == nullptr) free_pool_slots_ = new std::vector<int64_t>;
+  free_pool_slots_->push_back(slot);
+}
 #endif
 
+const IdString::Shared* IdStringPool::MakeDeduplicated(absl::string_view str) {
+  const IdString::Shared* shared = dedup_set_->Find(str);
+  if (shared == nullptr) {
+    shared = MakeShared(str);
+    dedup_set_->Insert(shared);
+  }
+  return shared;
+}
+
+IdString IdStringPool::MakeGlobal(absl::string_view str) {
+  GlobalPoolShard* shard = GlobalPoolShardForThisThread();
+  absl::MutexLock lock(&shard->mutex);
+  return shard->pool.Make(str);
+}
+
 // We want to keep one global empty std::string constant so that we can implement
 // the default constructor and clear() as assignment, without allocating
 // a new Shared object.
@@ -106,10 +106,22 @@ class IdString {
     return value_->str;
   }
 
+  // Return the lower-cased value as a string_view.  This is a cheap
+  // operation, since the lower-cased copy is made when the IdString is
+  // created.
+  absl::string_view ToLowerStringView() const {
+    CheckAlive();
+    return value_->str_lower;
+  }
+
   bool Equals(IdString other) const {
     CheckAlive();
     other.CheckAlive();
     if (value_ == other.value_) return true;
+    if (value_->dedup_domain != nullptr &&
+        value_->dedup_domain == other.value_->dedup_domain) {
+      return false;
+    }
     if (size() != other.size()) return false;
     const int64_t* str_words = reinterpret_cast<const int64_t*>(value_->str.data());
     const int64_t* other_str_words =
@@ -194,8 +206,11 @@ class IdString {
     // <sp_lower> must be the lowercased version of <sp>. <size_words> must be
     // the size of 'sp' and 'sp_lower', rounded up to a multiple of 8 bytes.
     Shared(const absl::string_view sp, const absl::string_view sp_lower,
-           int64_t size_words)
-        : str(sp), str_lower(sp_lower), size_words(size_words) {}
+           int64_t size_words, const void* dedup_domain)
+        : str(sp),
+          str_lower(sp_lower),
+          size_words(size_words),
+          dedup_domain(dedup_domain) {}
     Shared(const Shared&) = delete;
     Shared& operator=(const Shared&) = delete;
 
@@ -236,6 +251,11 @@ class IdString {
     // Size of 'str' and 'str_lower' in 64-bit words, rounded up.
     const int64_t size_words;
 
+    // For strings made by a deduplicating IdStringPool, identifies the pool.
+    // Different Shareds with the same non-NULL dedup_domain have different
+    // contents. NULL for other strings.
+    const void* const dedup_domain;
+
    private:
     // Hash of <str>.
     mutable size_t hash_ = 0;
@@ -391,9 +411,21 @@ using IdStringHashMapCase =
 // TODO Consider variants, like an interning IdStringPool.
 class IdStringPool {
  public:
+  struct Options {
+    // If true, Make() stores each distinct string once, and returns IdStrings
+    // that share it for equal strings. This saves memory when the same
+    // identifiers are made many times, as for large generated queries, and
+    // IdString::Equals() of two strings from this pool compares only their
+    // pointers. Each Make() call costs a hash table lookup.
+    bool deduplicate = false;
+  };
+
   // Pass 'arena' to use an existing arena.
   IdStringPool();
   explicit IdStringPool(const std::shared_ptr<zetasql_base::UnsafeArena>& arena);
+  explicit IdStringPool(const Options& options);
+  IdStringPool(const std::shared_ptr<zetasql_base::UnsafeArena>& arena,
+               const Options& options);
 #ifndef SWIG
   IdStringPool(const IdStringPool&) = delete;
   IdStringPool& operator=(const IdStringPool&) = delete;
@@ -402,18 +434,33 @@ class IdStringPool {
 
   // Make an IdString with contents allocated in this pool.
   IdString Make(absl::string_view str) {
+    const IdString::Shared* shared =
+        dedup_set_ == nullptr ? MakeShared(str) : MakeDeduplicated(str);
 #ifndef NDEBUG
-    return IdString(MakeShared(str), pool_id_);
+    return IdString(shared, pool_id_);
 #else
-    return IdString(MakeShared(str));
+    return IdString(shared);
 #endif
   }
 
   // Create an IdString in the global IdStringPool.  Memory will never be freed.
-  // This function is thread safe.
+  // This function is thread safe. The global pool is sharded by thread, so
+  // concurrent calls rarely contend.
   static IdString MakeGlobal(absl::string_view str);
 
+  // Returns the arena that holds the strings made in this pool.
+  const zetasql_base::UnsafeArena& arena() const { return *arena_; }
+  // Objects that must live exactly as long as those strings, like the
+  // ResolvedColumnInfo of a compact ResolvedColumn, may be allocated in it too.
+  zetasql_base::UnsafeArena* mutable_arena() { return arena_.get(); }
+
  private:
+  class DedupSet;
+
+  // Returns the IdString::Shared in dedup_set_ for <str>, adding it if there
+  // is none yet.
+  const IdString::Shared* MakeDeduplicated(absl::string_view str);
+
   // Make an IdString::Shared for <str>, allocated in the arena.
   const IdString::Shared* MakeShared(absl::string_view str) {
     static_assert(sizeof(IdString::Shared) % sizeof(int64_t) == 0,
@@ -451,43 +498,49 @@ class IdStringPool {
 
     absl::string_view copied_lower_str(string_buf, str.size());
     absl::string_view copied_str(string_buf + padded_size, str.size());
-    const IdString::Shared* shared = new (shared_buf)
-        IdString::Shared(copied_str, copied_lower_str, padded_size_words);
+    const IdString::Shared* shared = new (shared_buf) IdString::Shared(
+        copied_str, copied_lower_str, padded_size_words, dedup_set_.get());
     return shared;
   }
 
   std::shared_ptr<zetasql_base::UnsafeArena> arena_;
 
+  // The strings of a deduplicating pool. NULL for other pools.
+  std::unique_ptr<DedupSet> dedup_set_;
+
 #ifndef NDEBUG
+  // In debug mode we store a pool_id in each IdString and check that we never
+  // access an IdString after its IdStringPool is gone. Every live pool owns a
+  // slot in a table that holds its pool_id, so this check reads one word
+  // without locking. The low kPoolSlotBits of a pool_id are its slot, and the
+  // rest a generation that is never reused, so the IdStrings of a destroyed
+  // pool do not match their slot even after another pool reuses it.
+  static constexpr int kPoolSlotBits = 20;
+
+  // Guards allocating and releasing pool ids, but not reading them.
   static absl::Mutex global_mutex_;
 
-  // Set of IdStringPools that are currently alive.  This is used so we
-  // can store a pool_id in each IdString in debug mode and check that
-  // we never access an IdString after its IdStringPool is gone.
-  static std::unordered_set<int64_t>* live_pool_ids_
+  // The slots below num_pool_slots_ that no live pool owns.
+  static std::vector<int64_t>* free_pool_slots_
       GUARDED_BY(global_mutex_) PT_GUARDED_BY(global_mutex_);
 
-  static int64_t max_pool_id_ GUARDED_BY(global_mutex_);
+  static int64_t num_pool_slots_ GUARDED_BY(global_mutex_);
+
+  static int64_t max_pool_generation_ GUARDED_BY(global_mutex_);
 
   static int64_t AllocatePoolId();
+  static void ReleasePoolId(int64_t pool_id);
 
   // Check that <pool_id> is still alive.  Crash if not.
   static void CheckPoolIdAlive(int64_t pool_id);
 
-  // Unique identifier for this IdStringPool.  Used in live_pool_ids_.
+  // Unique identifier for this IdStringPool.
   const int64_t pool_id_;
 #endif
 
   friend IdString;
 };
 
-inline IdString IdStringPool::MakeGlobal(absl::string_view str) {
-  static IdStringPool* global_pool = new IdStringPool;
-  static absl::Mutex global_pool_mutex;
-  absl::MutexLock lock(&global_pool_mutex);
-  return global_pool->Make(str);
-}
-
 inline IdString IdString::MakeGlobal(absl::string_view str) {
   return IdStringPool::MakeGlobal(str);
 }
@@ -16,11 +16,15 @@
 
 #include "zetasql/public/id_string.h"
 
+#include <memory>
 #include <set>
+#include <thread>  // NOLINT(build/c++11)
 #include <unordered_set>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/memory/memory.h"
 #include "absl/strings/ascii.h"
 #include "zetasql/base/case.h"
 #include "absl/strings/str_join.h"
@@ -411,6 +415,71 @@ TEST(IdStringPool, Lifetime) {
   s4.CheckAlive();
 }
 
+TEST(IdStringPool, ReusedPoolSlot) {
+  IdString dead;
+  {
+    IdStringPool pool;
+    dead = pool.Make("dead");
+  }
+  // New pools may take the place of the destroyed one, but its strings stay
+  // dead.
+  std::vector<std::unique_ptr<IdStringPool>> pools;
+  std::vector<IdString> live;
+  for (int i = 0; i < 5; ++i) {
+    pools.push_back(absl::make_unique<IdStringPool>());
+    live.push_back(pools.back()->Make("live"));
+  }
+  for (const IdString& s : live) {
+    EXPECT_EQ("live", s.ToStringView());
+  }
+  EXPECT_DEBUG_DEATH(dead.ToStringView(), kPoolIsDeadMsg);
+}
+
+TEST(IdString, MakeGlobalFromThreads) {
+  std::vector<std::thread> threads;
+  std::vector<IdString> strings(8);
+  for (int i = 0; i < strings.size(); ++i) {
+    threads.emplace_back([i, &strings]() {
+      for (int j = 0; j < 100; ++j) {
+        strings[i] = IdString::MakeGlobal(absl::StrCat("thread_", i));
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  for (int i = 0; i < strings.size(); ++i) {
+    EXPECT_EQ(absl::StrCat("thread_", i), strings[i].ToStringView());
+  }
+}
+
+TEST(IdStringPool, Deduplicate) {
+  IdStringPool::Options options;
+  options.deduplicate = true;
+  IdStringPool pool(options);
+  IdStringPool other_pool(options);
+  IdStringPool plain_pool;
+
+  const IdString a = pool.Make("customer_id");
+  const IdString b = pool.Make(std::string("customer_id"));
+  const IdString upper = pool.Make("CUSTOMER_ID");
+  EXPECT_EQ(a.data(), b.data());
+  EXPECT_NE(a.data(), upper.data());
+  EXPECT_TRUE(a.Equals(b));
+  EXPECT_FALSE(a.Equals(upper));
+  EXPECT_TRUE(a.CaseEquals(upper));
+  EXPECT_FALSE(a.Equals(pool.Make("customer_ie")));
+  EXPECT_TRUE(pool.Make("").empty());
+
+  // Strings compare by value across pools.
+  const IdString c = other_pool.Make("customer_id");
+  const IdString d = plain_pool.Make("customer_id");
+  EXPECT_NE(a.data(), c.data());
+  EXPECT_TRUE(a.Equals(c));
+  EXPECT_TRUE(a.Equals(d));
+  EXPECT_TRUE(d.Equals(a));
+  EXPECT_FALSE(upper.Equals(c));
+  EXPECT_NE(plain_pool.Make("customer_id").data(), d.data());
+}
+
 TEST(IdString, ToLower) {
   IdString s1 = ID("ABcd");
   IdString s2;
@@ -0,0 +1,203 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/incremental_analyzer.h"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/public/parse_resume_location.h"
+#include "zetasql/public/parse_tokens.h"
+#include "absl/strings/match.h"
+#include "zetasql/base/source_location.h"
+#include "zetasql/base/status.h"
+#include "zetasql/base/status_builder.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+namespace {
+
+// Splits <sql> into statements like SplitStatements(), but starting at byte
+// offset <start>, which must be the start of a statement.  Appends the start
+// offsets of the statements to <*starts>.  Stops at the end of <sql>, or at
+// the first statement start at or after <resync_after> for which
+// <is_old_start> returns true.  Sets <*stopped_at> to that offset, or to -1 at
+// the end of <sql>.
+zetasql_base::Status SplitFrom(absl::string_view sql, int start, int resync_after,
+                       const std::function<bool(int)>& is_old_start,
+                       std::vector<int>* starts, int* stopped_at) {
+  ParseResumeLocation resume_location =
+      ParseResumeLocation::FromStringView(sql);
+  resume_location.set_byte_position(start);
+  ParseTokenOptions options;
+  options.stop_at_end_of_statement = true;
+  std::vector<ParseToken> tokens;
+  while (true) {
+    const int position = resume_location.byte_position();
+    if (position >= resync_after && is_old_start(position)) {
+      *stopped_at = position;
+      return ::zetasql_base::OkStatus();
+    }
+    tokens.clear();
+    ZETASQL_RETURN_IF_ERROR(GetParseTokens(options, &resume_location, &tokens));
+    const bool at_end_of_input = tokens.back().IsEndOfInput();
+    // A segment holding nothing but the end of input has no statement.
+    if (!(at_end_of_input && tokens.size() == 1)) {
+      starts->push_back(position);
+    }
+    if (at_end_of_input) {
+      *stopped_at = -1;
+      return ::zetasql_base::OkStatus();
+    }
+  }
+}
+
+bool HasLineBreak(absl::string_view text) {
+  return absl::StrContains(text, '\n') || absl::StrContains(text, '\r');
+}
+
+}  // namespace
+
+IncrementalAnalyzer::IncrementalAnalyzer(const AnalyzerOptions& options,
+                                         Catalog* catalog,
+                                         TypeFactory* type_factory)
+    : options_(options), catalog_(catalog), type_factory_(type_factory) {}
+
+IncrementalAnalyzer::Statement IncrementalAnalyzer::AnalyzeStatementAt(
+    int start) {
+  ParseResumeLocation resume_location =
+      ParseResumeLocation::FromStringView(sql_);
+  resume_location.set_byte_position(start);
+  std::unique_ptr<const AnalyzerOutput> output;
+  bool at_end_of_input;
+  Statement statement;
+  statement.start = start;
+  statement.status =
+      AnalyzeNextStatement(&resume_location, options_, catalog_, type_factory_,
+                           &output, &at_end_of_input);
+  if (statement.status.ok()) {
+    statement.output = std::move(output);
+  }
+  ++num_statements_analyzed_;
+  return statement;
+}
+
+zetasql_base::Status IncrementalAnalyzer::SetScript(absl::string_view sql) {
+  std::vector<int> starts;
+  int stopped_at;
+  ZETASQL_RETURN_IF_ERROR(SplitFrom(sql, /*start=*/0, /*resync_after=*/-1,
+                            [](int position) { return false; }, &starts,
+                            &stopped_at));
+  sql_ = std::string(sql);
+  statements_.clear();
+  num_statements_analyzed_ = 0;
+  for (const int start : starts) {
+    statements_.push_back(AnalyzeStatementAt(start));
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status IncrementalAnalyzer::ApplyEdit(int start, int length,
+                                            absl::string_view replacement) {
+  if (start < 0 || length < 0 || start > sql_.size() ||
+      length > sql_.size() - start) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "Edit range [" << start << ", " << start + length
+           << ") is outside of the script of length " << sql_.size();
+  }
+  std::string new_sql = sql_;
+  new_sql.replace(start, length, replacement.data(), replacement.size());
+  if (statements_.empty()) {
+    return SetScript(new_sql);
+  }
+  const absl::string_view removed =
+      absl::string_view(sql_).substr(start, length);
+  const int delta = static_cast<int>(replacement.size()) - length;
+  // True if text after the edit moves to a different byte offset or line.
+  const bool moves_text =
+      delta != 0 || HasLineBreak(removed) || HasLineBreak(replacement);
+
+  // The first statement that may have changed is the one containing
+  // <start>.  Statements that start at or after the end of the removed
+  // text, shifted by <delta>, are where splitting can resynchronize.
+  auto first_changed =
+      std::upper_bound(statements_.begin(), statements_.end(), start,
+                       [](int offset, const Statement& statement) {
+                         return offset < statement.start;
+                       });
+  if (first_changed != statements_.begin()) --first_changed;
+  const auto first_after_edit =
+      std::lower_bound(first_changed, statements_.end(), start + length,
+                       [](const Statement& statement, int offset) {
+                         return statement.start < offset;
+                       });
+  auto resync_statement = statements_.end();
+  auto is_old_start = [&](int new_position) {
+    const int old_position = new_position - delta;
+    resync_statement =
+        std::lower_bound(first_after_edit, statements_.end(), old_position,
+                         [](const Statement& statement, int offset) {
+                           return statement.start < offset;
+                         });
+    return resync_statement != statements_.end() &&
+           resync_statement->start == old_position;
+  };
+
+  std::vector<int> new_starts;
+  int stopped_at;
+  ZETASQL_RETURN_IF_ERROR(SplitFrom(
+      new_sql, first_changed->start,
+      /*resync_after=*/start + static_cast<int>(replacement.size()),
+      is_old_start, &new_starts, &stopped_at));
+  if (stopped_at < 0) {
+    resync_statement = statements_.end();
+  }
+
+  // Everything before <first_changed> is unchanged.
+  std::vector<Statement> old_statements = std::move(statements_);
+  const int first_changed_index = first_changed - old_statements.begin();
+  const int resync_index = resync_statement - old_statements.begin();
+  sql_ = std::move(new_sql);
+  num_statements_analyzed_ = 0;
+  statements_.clear();
+  for (int i = 0; i < first_changed_index; ++i) {
+    statements_.push_back(std::move(old_statements[i]));
+  }
+  for (const int new_start : new_starts) {
+    statements_.push_back(AnalyzeStatementAt(new_start));
+  }
+  for (int i = resync_index; i < old_statements.size(); ++i) {
+    Statement& statement = old_statements[i];
+    const int new_start = statement.start + delta;
+    if (moves_text &&
+        (!statement.status.ok() ||
+         !statement.output->deprecation_warnings().empty() ||
+         options_.record_parse_locations())) {
+      statements_.push_back(AnalyzeStatementAt(new_start));
+    } else {
+      statement.start = new_start;
+      statements_.push_back(std::move(statement));
+    }
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+}  // namespace zetasql
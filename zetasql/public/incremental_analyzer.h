@@ -0,0 +1,103 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PUBLIC_INCREMENTAL_ANALYZER_H_
+#define ZETASQL_PUBLIC_INCREMENTAL_ANALYZER_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/public/analyzer.h"
+#include "zetasql/public/catalog.h"
+#include "zetasql/public/type.h"
+#include "absl/strings/string_view.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+
+// Analyzes a multi-statement script and keeps it analyzed across edits, for
+// editors that re-analyze after every keystroke.
+//
+// After an edit, only the statements whose text the edit touches are split
+// and analyzed again.  Splitting restarts at the start of the first edited
+// statement and stops as soon as it reaches an old statement boundary after
+// the edit, so both splitting and analysis scale with the size of the edit
+// rather than of the script.  Statements outside the edit keep their
+// AnalyzerOutput.
+//
+// Statements are analyzed independently, as by AnalyzeStatementsInParallel:
+// the analyzer does not apply DDL, so unchanged statements never need to be
+// analyzed again because of an earlier statement.
+//
+// Outputs and errors can carry byte offsets and line numbers.  A statement
+// after an edit that moves it is analyzed again, rather than reused, if it
+// failed, has deprecation warnings or was analyzed with
+// record_parse_locations(), since those would otherwise refer to the old
+// positions.
+//
+// <catalog> and <type_factory> must outlive this object.  Not thread-safe.
+class IncrementalAnalyzer {
+ public:
+  // One statement of the script.
+  struct Statement {
+    // Byte offset of the start of the statement in sql().
+    int start = 0;
+    // The result of analyzing the statement.  <output> is NULL if <status>
+    // is not OK.
+    zetasql_base::Status status;
+    std::shared_ptr<const AnalyzerOutput> output;
+  };
+
+  IncrementalAnalyzer(const AnalyzerOptions& options, Catalog* catalog,
+                      TypeFactory* type_factory);
+  IncrementalAnalyzer(const IncrementalAnalyzer&) = delete;
+  IncrementalAnalyzer& operator=(const IncrementalAnalyzer&) = delete;
+
+  // Replaces the script with <sql> and analyzes all of it.  Errors analyzing
+  // individual statements are reported in statements(); the returned status
+  // is an error only if <sql> cannot be split into statements.
+  zetasql_base::Status SetScript(absl::string_view sql);
+
+  // Replaces the <length> bytes of sql() starting at <start> with
+  // <replacement>, and analyzes the statements that changed.  On error,
+  // which only happens if the edited script cannot be split into
+  // statements or the range is out of bounds, the script is left unchanged.
+  zetasql_base::Status ApplyEdit(int start, int length, absl::string_view replacement);
+
+  const std::string& sql() const { return sql_; }
+  const std::vector<Statement>& statements() const { return statements_; }
+
+  // Returns the number of statements that were analyzed by the last call to
+  // SetScript() or ApplyEdit().
+  int num_statements_analyzed() const { return num_statements_analyzed_; }
+
+ private:
+  // Returns a Statement starting at <start> in sql_, analyzed.
+  Statement AnalyzeStatementAt(int start);
+
+  const AnalyzerOptions options_;
+  Catalog* const catalog_;
+  TypeFactory* const type_factory_;
+
+  std::string sql_;
+  std::vector<Statement> statements_;
+  int num_statements_analyzed_ = 0;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_INCREMENTAL_ANALYZER_H_
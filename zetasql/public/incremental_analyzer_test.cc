@@ -0,0 +1,103 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/incremental_analyzer.h"
+
+#include <memory>
+#include <string>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/analyzer.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace zetasql {
+
+class IncrementalAnalyzerTest : public ::testing::Test {
+ protected:
+  IncrementalAnalyzerTest()
+      : catalog_("catalog", &type_factory_),
+        analyzer_(AnalyzerOptions(), &catalog_, &type_factory_) {
+    catalog_.AddOwnedTable(
+        new SimpleTable("T", {{"key", type_factory_.get_int64()}}));
+  }
+
+  // Returns the SQL of each statement in the script.
+  std::vector<std::string> StatementTexts() const {
+    std::vector<std::string> texts;
+    const std::vector<IncrementalAnalyzer::Statement>& statements =
+        analyzer_.statements();
+    for (int i = 0; i < statements.size(); ++i) {
+      const int end = i + 1 < statements.size() ? statements[i + 1].start
+                                                : analyzer_.sql().size();
+      texts.push_back(analyzer_.sql().substr(statements[i].start,
+                                             end - statements[i].start));
+    }
+    return texts;
+  }
+
+  TypeFactory type_factory_;
+  SimpleCatalog catalog_;
+  IncrementalAnalyzer analyzer_;
+};
+
+TEST_F(IncrementalAnalyzerTest, EditReanalyzesOnlyChangedStatement) {
+  ZETASQL_ASSERT_OK(analyzer_.SetScript("SELECT 1; SELECT key FROM T; SELECT 3;"));
+  ASSERT_EQ(3, analyzer_.statements().size());
+  EXPECT_EQ(3, analyzer_.num_statements_analyzed());
+  const AnalyzerOutput* first = analyzer_.statements()[0].output.get();
+  const AnalyzerOutput* last = analyzer_.statements()[2].output.get();
+
+  // Change "key" to "key + 10" in the second statement.
+  ZETASQL_ASSERT_OK(analyzer_.ApplyEdit(20, 0, " + 10"));
+  EXPECT_EQ("SELECT 1; SELECT key + 10 FROM T; SELECT 3;", analyzer_.sql());
+  ASSERT_EQ(3, analyzer_.statements().size());
+  EXPECT_EQ(1, analyzer_.num_statements_analyzed());
+  EXPECT_EQ(first, analyzer_.statements()[0].output.get());
+  EXPECT_EQ(last, analyzer_.statements()[2].output.get());
+  EXPECT_EQ(33, analyzer_.statements()[2].start);
+  EXPECT_THAT(StatementTexts(),
+              testing::ElementsAre("SELECT 1;", " SELECT key + 10 FROM T;",
+                                   " SELECT 3;"));
+}
+
+TEST_F(IncrementalAnalyzerTest, EditSplitsAndMergesStatements) {
+  ZETASQL_ASSERT_OK(analyzer_.SetScript("SELECT 1; SELECT 2;"));
+
+  // Inserting a ";" splits the first statement's segment in two.
+  ZETASQL_ASSERT_OK(analyzer_.ApplyEdit(9, 0, " SELECT 5;"));
+  EXPECT_THAT(StatementTexts(),
+              testing::ElementsAre("SELECT 1;", " SELECT 5;", " SELECT 2;"));
+  EXPECT_EQ(1, analyzer_.num_statements_analyzed());
+
+  // Removing a ";" merges two statements, which then fail to parse.
+  ZETASQL_ASSERT_OK(analyzer_.ApplyEdit(8, 1, ""));
+  EXPECT_THAT(StatementTexts(),
+              testing::ElementsAre("SELECT 1 SELECT 5;", " SELECT 2;"));
+  EXPECT_FALSE(analyzer_.statements()[0].status.ok());
+  ZETASQL_EXPECT_OK(analyzer_.statements()[1].status);
+}
+
+TEST_F(IncrementalAnalyzerTest, InvalidRange) {
+  ZETASQL_ASSERT_OK(analyzer_.SetScript("SELECT 1;"));
+  EXPECT_FALSE(analyzer_.ApplyEdit(5, 10, "x").ok());
+  EXPECT_FALSE(analyzer_.ApplyEdit(-1, 0, "x").ok());
+  EXPECT_EQ("SELECT 1;", analyzer_.sql());
+}
+
+}  // namespace zetasql
@@ -80,6 +80,24 @@ std::set<LanguageFeature> LanguageOptions::GetLanguageFeaturesForVersion(
 
 void LanguageOptions::SetLanguageVersion(LanguageVersion version) {
   enabled_language_features_ = GetLanguageFeaturesForVersion(version);
+  UpdateLanguageFeatureBits();
+}
+
+void LanguageOptions::UpdateLanguageFeatureBits() {
+  enabled_language_feature_bits_.reset();
+  for (LanguageFeature feature : enabled_language_features_) {
+    const int bit = LanguageFeatureBit(feature);
+    if (bit >= 0) enabled_language_feature_bits_.set(bit);
+  }
+}
+
+void LanguageOptions::UpdateSupportedStatementKindBits() {
+  supported_statement_kind_bits_.reset();
+  for (ResolvedNodeKind kind : supported_statement_kinds_) {
+    if (kind >= 0 && kind < ResolvedNodeKind_ARRAYSIZE) {
+      supported_statement_kind_bits_.set(kind);
+    }
+  }
 }
 
 LanguageOptions LanguageOptions::MaximumFeatures() {
@@ -108,11 +126,13 @@ LanguageOptions::LanguageOptions(const LanguageOptionsProto& proto)
   for (int i = 0; i <  proto.supported_statement_kinds_size(); ++i) {
     supported_statement_kinds_.insert(proto.supported_statement_kinds(i));
   }
+  UpdateSupportedStatementKindBits();
   if (proto.enabled_language_features_size() > 0) {
     enabled_language_features_.clear();
     for (int i = 0; i <  proto.enabled_language_features_size(); ++i) {
       enabled_language_features_.insert(proto.enabled_language_features(i));
     }
+    UpdateLanguageFeatureBits();
   }
 }
 
@@ -17,6 +17,7 @@
 #ifndef ZETASQL_PUBLIC_LANGUAGE_OPTIONS_H_
 #define ZETASQL_PUBLIC_LANGUAGE_OPTIONS_H_
 
+#include <bitset>
 #include <set>
 #include <string>
 
@@ -48,8 +49,11 @@ class LanguageOptions {
   // Returns true if 'kind' is supported.
   ABSL_MUST_USE_RESULT bool SupportsStatementKind(
       const ResolvedNodeKind kind) const {
-    return supported_statement_kinds_.empty() ||
-           zetasql_base::ContainsKey(supported_statement_kinds_, kind);
+    if (supported_statement_kinds_.empty()) return true;
+    if (kind >= 0 && kind < ResolvedNodeKind_ARRAYSIZE) {
+      return supported_statement_kind_bits_[kind];
+    }
+    return zetasql_base::ContainsKey(supported_statement_kinds_, kind);
   }
 
   // The provided set of ResolvedNodeKind enums indicates the statements
@@ -63,21 +67,28 @@ class LanguageOptions {
   void SetSupportedStatementKinds(
       const std::set<ResolvedNodeKind>& supported_statement_kinds) {
     supported_statement_kinds_ = supported_statement_kinds;
+    UpdateSupportedStatementKindBits();
   }
 
   // Equivalent to SetSupportedStatementKinds({}).
   void SetSupportsAllStatementKinds() {
     supported_statement_kinds_.clear();
+    supported_statement_kind_bits_.reset();
   }
 
   // Adds <kind> to the set of supported statement kinds.
   void AddSupportedStatementKind(ResolvedNodeKind kind) {
     zetasql_base::InsertIfNotPresent(&supported_statement_kinds_, kind);
+    if (kind >= 0 && kind < ResolvedNodeKind_ARRAYSIZE) {
+      supported_statement_kind_bits_.set(kind);
+    }
   }
 
   // Returns whether or not <feature> is enabled.
   ABSL_MUST_USE_RESULT bool LanguageFeatureEnabled(
       LanguageFeature feature) const {
+    const int bit = LanguageFeatureBit(feature);
+    if (bit >= 0) return enabled_language_feature_bits_[bit];
     return zetasql_base::ContainsKey(enabled_language_features_, feature);
   }
 
@@ -96,6 +107,8 @@ class LanguageOptions {
   // Enables support for the specified <feature>.
   void EnableLanguageFeature(LanguageFeature feature) {
     zetasql_base::InsertIfNotPresent(&enabled_language_features_, feature);
+    const int bit = LanguageFeatureBit(feature);
+    if (bit >= 0) enabled_language_feature_bits_.set(bit);
   }
   // DEPRECATED.  This is the old name for EnableLanguageFeature.
   void EnableOptionalFeature(LanguageFeature feature) {
@@ -104,6 +117,7 @@ class LanguageOptions {
 
   void SetEnabledLanguageFeatures(const std::set<LanguageFeature>& features) {
     enabled_language_features_ = features;
+    UpdateLanguageFeatureBits();
   }
 
   const std::set<LanguageFeature>& GetEnabledLanguageFeatures() const {
@@ -116,6 +130,7 @@ class LanguageOptions {
 
   void DisableAllLanguageFeatures() {
     enabled_language_features_.clear();
+    enabled_language_feature_bits_.reset();
   }
 
   // Enable all optional features that are enabled in the idealized ZetaSQL
@@ -167,6 +182,43 @@ class LanguageOptions {
   // are excluded.
   void EnableMaximumLanguageFeatures(bool for_development);
 
+  // The LanguageFeature values are grouped in ranges: the unversioned
+  // features from 1, the features of each version N.M from N * 10000 + M *
+  // 1000 + 1, and the in-development test features just below 1000000. Each
+  // range gets kFeatureBitsPerRange bits, so that LanguageFeatureEnabled()
+  // is a bit test; features beyond them fall back to the set.
+  static constexpr int kFeatureBitsPerRange = 128;
+  static constexpr int kNumVersionFeatureRanges = 9;  // Versions 1.1 to 1.9.
+  static constexpr int kNumFeatureBits =
+      (kNumVersionFeatureRanges + 2) * kFeatureBitsPerRange;
+
+  // Returns the bit of 'feature' in 'enabled_language_feature_bits_', or -1
+  // if it has none.
+  static int LanguageFeatureBit(LanguageFeature feature) {
+    const int value = feature;
+    int range;
+    int offset;
+    if (value >= 0 && value < kFeatureBitsPerRange) {
+      range = 0;
+      offset = value;
+    } else if (value > 11000 &&
+               value < 11000 + kNumVersionFeatureRanges * 1000) {
+      range = value / 1000 - 10;
+      offset = value % 1000;
+    } else if (value >= 1000000 - kFeatureBitsPerRange && value < 1000000) {
+      range = kNumVersionFeatureRanges + 1;
+      offset = value - (1000000 - kFeatureBitsPerRange);
+    } else {
+      return -1;
+    }
+    if (offset >= kFeatureBitsPerRange) return -1;
+    return range * kFeatureBitsPerRange + offset;
+  }
+
+  // Recompute the bits from the sets.
+  void UpdateLanguageFeatureBits();
+  void UpdateSupportedStatementKindBits();
+
   // ======================================================================
   // NOTE: Please update options.proto and LanguageOptions.java accordingly
   // when adding new fields here.
@@ -176,6 +228,10 @@ class LanguageOptions {
   // zetasql::RESOLVED_QUERY_STMT. An empty set, the default, indicates no
   // restrictions.
   std::set<ResolvedNodeKind> supported_statement_kinds_ = {RESOLVED_QUERY_STMT};
+  // The kinds in 'supported_statement_kinds_' that are less than
+  // ResolvedNodeKind_ARRAYSIZE.
+  std::bitset<ResolvedNodeKind_ARRAYSIZE> supported_statement_kind_bits_ =
+      std::bitset<ResolvedNodeKind_ARRAYSIZE>().set(RESOLVED_QUERY_STMT);
 
   // This can be used to select strict name resolution mode.
   // In strict mode, implicit column names cannot be used unqualified.
@@ -194,6 +250,8 @@ class LanguageOptions {
   // are supported.  If a query includes unsupported features an error is
   // returned.
   std::set<LanguageFeature> enabled_language_features_;
+  // The bits of the features in 'enabled_language_features_' that have one.
+  std::bitset<kNumFeatureBits> enabled_language_feature_bits_;
 
   // If true, return an error on deprecated syntax rather than returning
   // deprecation_warnings.
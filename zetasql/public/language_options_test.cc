@@ -16,6 +16,8 @@
 
 #include "zetasql/public/language_options.h"
 
+#include <bitset>
+
 #include "google/protobuf/descriptor.h"
 #include "zetasql/public/options.pb.h"
 #include "zetasql/resolved_ast/resolved_node_kind.pb.h"
@@ -207,6 +209,49 @@ TEST(LanguageOptions, EnableMaximumLanguageFeaturesForDevelopment) {
       __LanguageFeature__switch_must_have_a_default__));
 }
 
+TEST(LanguageOptions, FeatureBitsMatchSets) {
+  const std::set<LanguageFeature> all_features =
+      GetEnumValues<LanguageFeature>(LanguageFeature_descriptor());
+  // Enabling each feature alone enables exactly that feature, whatever its
+  // range.
+  for (LanguageFeature feature : all_features) {
+    LanguageOptions options;
+    options.EnableLanguageFeature(feature);
+    for (LanguageFeature other : all_features) {
+      EXPECT_EQ(feature == other, options.LanguageFeatureEnabled(other))
+          << LanguageFeature_Name(feature) << " " << LanguageFeature_Name(other);
+    }
+  }
+
+  LanguageOptions options;
+  options.SetEnabledLanguageFeatures(
+      {FEATURE_TABLESAMPLE, FEATURE_V_1_2_CIVIL_TIME,
+       FEATURE_TEST_IDEALLY_DISABLED_AND_IN_DEVELOPMENT});
+  EXPECT_TRUE(options.LanguageFeatureEnabled(FEATURE_TABLESAMPLE));
+  EXPECT_TRUE(options.LanguageFeatureEnabled(FEATURE_V_1_2_CIVIL_TIME));
+  EXPECT_TRUE(options.LanguageFeatureEnabled(
+      FEATURE_TEST_IDEALLY_DISABLED_AND_IN_DEVELOPMENT));
+  EXPECT_FALSE(options.LanguageFeatureEnabled(FEATURE_ANALYTIC_FUNCTIONS));
+  options.SetLanguageVersion(VERSION_1_1);
+  EXPECT_FALSE(options.LanguageFeatureEnabled(FEATURE_TABLESAMPLE));
+  EXPECT_TRUE(options.LanguageFeatureEnabled(FEATURE_V_1_1_ORDER_BY_COLLATE));
+  options.DisableAllLanguageFeatures();
+  EXPECT_FALSE(
+      options.LanguageFeatureEnabled(FEATURE_V_1_1_ORDER_BY_COLLATE));
+
+  // Values outside the ranges with bits fall back to the set.
+  const LanguageFeature unnamed = static_cast<LanguageFeature>(50000);
+  EXPECT_FALSE(options.LanguageFeatureEnabled(unnamed));
+  options.EnableLanguageFeature(unnamed);
+  EXPECT_TRUE(options.LanguageFeatureEnabled(unnamed));
+
+  options.SetSupportedStatementKinds({RESOLVED_EXPLAIN_STMT});
+  EXPECT_TRUE(options.SupportsStatementKind(RESOLVED_EXPLAIN_STMT));
+  EXPECT_FALSE(options.SupportsStatementKind(RESOLVED_QUERY_STMT));
+  options.AddSupportedStatementKind(RESOLVED_QUERY_STMT);
+  EXPECT_TRUE(options.SupportsStatementKind(RESOLVED_QUERY_STMT));
+}
+
 TEST(LanguageOptions, Deserialize) {
   LanguageOptionsProto proto;
   proto.set_product_mode(PRODUCT_EXTERNAL);
@@ -247,10 +292,12 @@ TEST(LanguageOptions, GetEnabledLanguageFeaturesAsString) {
 }
 
 TEST(LanguageOptions, ClassAndProtoSize) {
+  // The sets and the bitsets that cache them.
   EXPECT_EQ(16,
       sizeof(LanguageOptions) -
       sizeof(std::set<ResolvedNodeKind>) -
-      sizeof(std::set<LanguageFeature>))
+      sizeof(std::bitset<ResolvedNodeKind_ARRAYSIZE>) -
+      sizeof(std::set<LanguageFeature>) - sizeof(std::bitset<11 * 128>))
       << "The size of LanguageOptions class has changed, please also update "
       << "the proto and serialization code if you added/removed fields in it.";
   EXPECT_EQ(5, LanguageOptionsProto::descriptor()->field_count())
@@ -0,0 +1,226 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/lazy_simple_catalog.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/wire_format_lite.h"
+#include "zetasql/proto/simple_catalog.pb.h"
+#include "zetasql/public/simple_table.pb.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/ascii.h"
+#include "zetasql/base/source_location.h"
+#include "zetasql/base/status_builder.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+using google::protobuf::internal::WireFormatLite;
+
+namespace {
+
+// Field numbers in SimpleCatalogProto and SimpleTableProto that are handled
+// without fully parsing the proto.
+constexpr int kCatalogNameField = SimpleCatalogProto::kNameFieldNumber;
+constexpr int kCatalogTableField = SimpleCatalogProto::kTableFieldNumber;
+constexpr int kCatalogCatalogField = SimpleCatalogProto::kCatalogFieldNumber;
+constexpr int kTableNameField = SimpleTableProto::kNameFieldNumber;
+constexpr int kTableNameInCatalogField =
+    SimpleTableProto::kNameInCatalogFieldNumber;
+
+zetasql_base::Status MalformedProtoError(absl::string_view what) {
+  return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+         << "Malformed serialized " << what;
+}
+
+google::protobuf::io::CodedInputStream MakeInputStream(absl::string_view bytes) {
+  return google::protobuf::io::CodedInputStream(
+      reinterpret_cast<const uint8_t*>(bytes.data()),
+      static_cast<int>(bytes.size()));
+}
+
+// Reads the length-delimited payload of the field whose tag was just read
+// from <input>, which is backed by <bytes>.
+bool ReadLengthDelimited(absl::string_view bytes,
+                         google::protobuf::io::CodedInputStream* input,
+                         absl::string_view* payload) {
+  uint32_t length;
+  if (!input->ReadVarint32(&length)) return false;
+  const int start = input->CurrentPosition();
+  if (!input->Skip(length)) return false;
+  *payload = bytes.substr(start, length);
+  return true;
+}
+
+// Scans the top-level fields of the serialized message <bytes> for string
+// fields <field_number> and, if nonzero, <override_field_number>.  Sets
+// <*value> to the last value of <override_field_number> if present, or
+// otherwise to the last value of <field_number>.  Nested messages are
+// skipped without being decoded.
+bool FindName(absl::string_view bytes, int field_number,
+              int override_field_number, std::string* value) {
+  google::protobuf::io::CodedInputStream input = MakeInputStream(bytes);
+  bool found_override = false;
+  value->clear();
+  while (true) {
+    const uint32_t tag = input.ReadTag();
+    if (tag == 0) return input.ConsumedEntireMessage();
+    const int number = WireFormatLite::GetTagFieldNumber(tag);
+    if (WireFormatLite::GetTagWireType(tag) ==
+            WireFormatLite::WIRETYPE_LENGTH_DELIMITED &&
+        (number == field_number || number == override_field_number)) {
+      absl::string_view payload;
+      if (!ReadLengthDelimited(bytes, &input, &payload)) return false;
+      if (number == override_field_number && override_field_number != 0) {
+        found_override = true;
+        *value = std::string(payload);
+      } else if (!found_override) {
+        *value = std::string(payload);
+      }
+    } else if (!WireFormatLite::SkipField(&input, tag)) {
+      return false;
+    }
+  }
+}
+
+}  // namespace
+
+LazySimpleCatalog::LazySimpleCatalog(
+    const std::string& name, TypeFactory* type_factory,
+    const std::vector<const google::protobuf::DescriptorPool*>& pools)
+    : SimpleCatalog(name, type_factory), pools_(pools) {}
+
+zetasql_base::Status LazySimpleCatalog::Create(
+    absl::string_view serialized_proto,
+    const std::vector<const google::protobuf::DescriptorPool*>& pools,
+    std::unique_ptr<LazySimpleCatalog>* result) {
+  std::string name;
+  if (!FindName(serialized_proto, kCatalogNameField,
+                /*override_field_number=*/0, &name)) {
+    return MalformedProtoError("SimpleCatalogProto");
+  }
+  // Create a top level catalog that owns the TypeFactory.
+  std::unique_ptr<LazySimpleCatalog> catalog(
+      new LazySimpleCatalog(name, /*type_factory=*/nullptr, pools));
+  ZETASQL_RETURN_IF_ERROR(catalog->Load(serialized_proto));
+  *result = std::move(catalog);
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status LazySimpleCatalog::Load(absl::string_view serialized_proto) {
+  // Fields other than tables and nested catalogs are copied, still
+  // serialized, into <remainder> and deserialized normally.
+  std::string remainder;
+  google::protobuf::io::CodedInputStream input = MakeInputStream(serialized_proto);
+  while (true) {
+    const int field_start = input.CurrentPosition();
+    const uint32_t tag = input.ReadTag();
+    if (tag == 0) break;
+    const int number = WireFormatLite::GetTagFieldNumber(tag);
+    const bool length_delimited = WireFormatLite::GetTagWireType(tag) ==
+                                  WireFormatLite::WIRETYPE_LENGTH_DELIMITED;
+    if (length_delimited && number == kCatalogTableField) {
+      absl::string_view table_bytes;
+      std::string table_name;
+      if (!ReadLengthDelimited(serialized_proto, &input, &table_bytes) ||
+          !FindName(table_bytes, kTableNameField, kTableNameInCatalogField,
+                    &table_name)) {
+        return MalformedProtoError("SimpleTableProto");
+      }
+      absl::MutexLock l(&lazy_mutex_);
+      if (!pending_tables_
+               .emplace(absl::AsciiStrToLower(table_name), table_bytes)
+               .second) {
+        return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+               << "Duplicate table " << table_name << " in catalog "
+               << FullName();
+      }
+    } else if (length_delimited && number == kCatalogCatalogField) {
+      absl::string_view catalog_bytes;
+      std::string catalog_name;
+      if (!ReadLengthDelimited(serialized_proto, &input, &catalog_bytes) ||
+          !FindName(catalog_bytes, kCatalogNameField,
+                    /*override_field_number=*/0, &catalog_name)) {
+        return MalformedProtoError("SimpleCatalogProto");
+      }
+      std::unique_ptr<LazySimpleCatalog> sub_catalog(
+          new LazySimpleCatalog(catalog_name, type_factory(), pools_));
+      ZETASQL_RETURN_IF_ERROR(sub_catalog->Load(catalog_bytes));
+      AddOwnedCatalog(catalog_name, std::move(sub_catalog));
+    } else {
+      if (!WireFormatLite::SkipField(&input, tag)) {
+        return MalformedProtoError("SimpleCatalogProto");
+      }
+      const absl::string_view field_bytes = serialized_proto.substr(
+          field_start, input.CurrentPosition() - field_start);
+      remainder.append(field_bytes.data(), field_bytes.size());
+    }
+  }
+  if (!input.ConsumedEntireMessage()) {
+    return MalformedProtoError("SimpleCatalogProto");
+  }
+
+  SimpleCatalogProto proto;
+  if (!proto.ParseFromString(remainder)) {
+    return MalformedProtoError("SimpleCatalogProto");
+  }
+  return DeserializeImpl(proto, pools_, this);
+}
+
+zetasql_base::Status LazySimpleCatalog::LoadPendingTable(absl::string_view lower_name) {
+  absl::MutexLock l(&lazy_mutex_);
+  auto it = pending_tables_.find(lower_name);
+  if (it == pending_tables_.end()) {
+    return ::zetasql_base::OkStatus();
+  }
+  SimpleTableProto table_proto;
+  if (!table_proto.ParseFromArray(it->second.data(),
+                                  static_cast<int>(it->second.size()))) {
+    return MalformedProtoError("SimpleTableProto");
+  }
+  std::unique_ptr<SimpleTable> simple_table;
+  ZETASQL_RETURN_IF_ERROR(SimpleTable::Deserialize(table_proto, pools_,
+                                           type_factory(), &simple_table));
+  AddOwnedTable(it->first, std::move(simple_table));
+  pending_tables_.erase(it);
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status LazySimpleCatalog::GetTable(const std::string& name,
+                                         const Table** table,
+                                         const FindOptions& options) {
+  ZETASQL_RETURN_IF_ERROR(LoadPendingTable(absl::AsciiStrToLower(name)));
+  return SimpleCatalog::GetTable(name, table, options);
+}
+
+zetasql_base::Status LazySimpleCatalog::GetTable(IdString name, const Table** table,
+                                         const FindOptions& options) {
+  ZETASQL_RETURN_IF_ERROR(LoadPendingTable(name.ToLowerStringView()));
+  return SimpleCatalog::GetTable(name, table, options);
+}
+
+int LazySimpleCatalog::num_pending_tables() const {
+  absl::MutexLock l(&lazy_mutex_);
+  return static_cast<int>(pending_tables_.size());
+}
+
+}  // namespace zetasql
@@ -0,0 +1,102 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PUBLIC_LAZY_SIMPLE_CATALOG_H_
+#define ZETASQL_PUBLIC_LAZY_SIMPLE_CATALOG_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "google/protobuf/descriptor.h"
+#include "zetasql/public/id_string.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+
+// A SimpleCatalog loaded from a serialized SimpleCatalogProto, that
+// deserializes tables only when they are first looked up.
+//
+// Creating the catalog scans the serialized bytes once to build an index
+// from table name to the bytes of its SimpleTableProto, without decoding
+// columns or types.  Nested catalogs are loaded lazily in the same way.
+// Everything else in the proto (types, functions, procedures, constants,
+// builtin function options) is small and is deserialized eagerly.
+//
+// The serialized bytes are not copied.  They must outlive the catalog, so
+// they may point into a memory-mapped file.  The DescriptorPools must also
+// outlive the catalog.
+//
+// Errors in a table's serialized form are reported by the GetTable() or
+// FindTable() call that first looks the table up.
+//
+// Tables that have not been looked up yet are not returned by tables(),
+// table_names() or Serialize().
+class LazySimpleCatalog : public SimpleCatalog {
+ public:
+  LazySimpleCatalog(const LazySimpleCatalog&) = delete;
+  LazySimpleCatalog& operator=(const LazySimpleCatalog&) = delete;
+
+  // Creates a catalog from <serialized_proto>, a serialized
+  // SimpleCatalogProto.  The resulting catalog owns its TypeFactory.
+  static zetasql_base::Status Create(
+      absl::string_view serialized_proto,
+      const std::vector<const google::protobuf::DescriptorPool*>& pools,
+      std::unique_ptr<LazySimpleCatalog>* result);
+
+  zetasql_base::Status GetTable(const std::string& name, const Table** table,
+                        const FindOptions& options = FindOptions()) override
+      LOCKS_EXCLUDED(lazy_mutex_);
+  zetasql_base::Status GetTable(IdString name, const Table** table,
+                        const FindOptions& options = FindOptions()) override
+      LOCKS_EXCLUDED(lazy_mutex_);
+
+  // Returns the number of tables that have not been deserialized yet,
+  // not counting tables in nested catalogs.
+  int num_pending_tables() const LOCKS_EXCLUDED(lazy_mutex_);
+
+ private:
+  LazySimpleCatalog(const std::string& name, TypeFactory* type_factory,
+                    const std::vector<const google::protobuf::DescriptorPool*>& pools);
+
+  // Indexes the tables and nested catalogs in <serialized_proto> and
+  // deserializes everything else.
+  zetasql_base::Status Load(absl::string_view serialized_proto);
+
+  // Deserializes and adds the table named <lower_name>, if it has not been
+  // looked up yet.
+  zetasql_base::Status LoadPendingTable(absl::string_view lower_name)
+      LOCKS_EXCLUDED(lazy_mutex_);
+
+  const std::vector<const google::protobuf::DescriptorPool*> pools_;
+
+  mutable absl::Mutex lazy_mutex_;
+
+  // Serialized SimpleTableProtos of tables that have not been looked up
+  // yet, keyed by lower case name in this catalog.
+  absl::flat_hash_map<std::string, absl::string_view> pending_tables_
+      GUARDED_BY(lazy_mutex_);
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_LAZY_SIMPLE_CATALOG_H_
@@ -0,0 +1,123 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/lazy_simple_catalog.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/proto/simple_catalog.pb.h"
+#include "zetasql/public/id_string.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+
+namespace zetasql {
+
+using ::testing::NotNull;
+
+class LazySimpleCatalogTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    SimpleCatalog catalog("root");
+    TypeFactory* types = catalog.type_factory();
+    catalog.AddOwnedTable(new SimpleTable(
+        "T1", {{"a", types->get_int64()}, {"b", types->get_string()}}));
+    catalog.AddOwnedTable("Alias", absl::make_unique<SimpleTable>(
+                                       "T2", std::vector<SimpleTable::NameAndType>{
+                                                 {"c", types->get_double()}}));
+    SimpleCatalog* nested = catalog.MakeOwnedSimpleCatalog("nested");
+    nested->AddOwnedTable(
+        new SimpleTable("T3", {{"d", types->get_bool()}}));
+    catalog.AddType("my_int", types->get_int64());
+
+    FileDescriptorSetMap file_descriptor_set_map;
+    SimpleCatalogProto proto;
+    ZETASQL_ASSERT_OK(catalog.Serialize(&file_descriptor_set_map, &proto));
+    ASSERT_TRUE(proto.SerializeToString(&serialized_));
+  }
+
+  std::string serialized_;
+};
+
+TEST_F(LazySimpleCatalogTest, TablesAreLoadedOnLookup) {
+  std::unique_ptr<LazySimpleCatalog> catalog;
+  ZETASQL_ASSERT_OK(LazySimpleCatalog::Create(serialized_, {}, &catalog));
+  EXPECT_EQ("root", catalog->FullName());
+  EXPECT_EQ(2, catalog->num_pending_tables());
+  EXPECT_TRUE(catalog->tables().empty());
+
+  const Table* table;
+  ZETASQL_ASSERT_OK(catalog->FindTable({"t1"}, &table));
+  ASSERT_THAT(table, NotNull());
+  EXPECT_EQ("T1", table->Name());
+  EXPECT_EQ(2, table->NumColumns());
+  EXPECT_EQ(1, catalog->num_pending_tables());
+
+  // A second lookup returns the same table.
+  const Table* table2;
+  ZETASQL_ASSERT_OK(catalog->FindTable({"T1"}, &table2));
+  EXPECT_EQ(table, table2);
+
+  // Tables are indexed by their name in the catalog.
+  ZETASQL_ASSERT_OK(catalog->FindTable({"alias"}, &table));
+  EXPECT_EQ("T2", table->Name());
+  EXPECT_EQ(0, catalog->num_pending_tables());
+
+  EXPECT_FALSE(catalog->FindTable({"T2"}, &table).ok());
+}
+
+TEST_F(LazySimpleCatalogTest, IdStringLookupsLoadTables) {
+  std::unique_ptr<LazySimpleCatalog> catalog;
+  ZETASQL_ASSERT_OK(LazySimpleCatalog::Create(serialized_, {}, &catalog));
+
+  IdStringPool pool;
+  const Table* table;
+  ZETASQL_ASSERT_OK(catalog->FindTable({pool.Make("T1")}, &table));
+  ASSERT_THAT(table, NotNull());
+  EXPECT_EQ("T1", table->Name());
+  EXPECT_EQ(1, catalog->num_pending_tables());
+
+  ZETASQL_ASSERT_OK(catalog->FindTable({pool.Make("Nested"), pool.Make("t3")}, &table));
+  EXPECT_EQ("T3", table->Name());
+}
+
+TEST_F(LazySimpleCatalogTest, NestedCatalogsAndOtherObjects) {
+  std::unique_ptr<LazySimpleCatalog> catalog;
+  ZETASQL_ASSERT_OK(LazySimpleCatalog::Create(serialized_, {}, &catalog));
+
+  const Table* table;
+  ZETASQL_ASSERT_OK(catalog->FindTable({"nested", "T3"}, &table));
+  EXPECT_EQ("T3", table->Name());
+
+  const Type* type;
+  ZETASQL_ASSERT_OK(catalog->FindType({"my_int"}, &type));
+  EXPECT_TRUE(type->IsInt64());
+}
+
+TEST_F(LazySimpleCatalogTest, MalformedInput) {
+  std::unique_ptr<LazySimpleCatalog> catalog;
+  EXPECT_FALSE(
+      LazySimpleCatalog::Create(serialized_.substr(0, serialized_.size() - 3),
+                                {}, &catalog)
+          .ok());
+}
+
+}  // namespace zetasql
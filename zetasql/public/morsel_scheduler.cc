@@ -0,0 +1,281 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/morsel_scheduler.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "zetasql/base/logging.h"
+#include "absl/memory/memory.h"
+#include "zetasql/base/source_location.h"
+#include "zetasql/base/status_builder.h"
+
+namespace zetasql {
+
+MorselQuery::MorselQuery(std::vector<MorselPipeline> pipelines, int priority)
+    : priority_(priority) {
+  for (MorselPipeline& pipeline : pipelines) {
+    pipelines_.push_back(absl::make_unique<PipelineState>());
+    pipelines_.back()->num_pending = pipeline.dependencies.size();
+    pipelines_.back()->pipeline = std::move(pipeline);
+  }
+  for (int i = 0; i < pipelines_.size(); ++i) {
+    for (int dependency : pipelines_[i]->pipeline.dependencies) {
+      pipelines_[dependency]->dependents.push_back(i);
+    }
+  }
+}
+
+zetasql_base::Status MorselQuery::Wait() {
+  absl::MutexLock lock(&mutex_);
+  mutex_.Await(absl::Condition(&done_));
+  return status_;
+}
+
+bool MorselQuery::IsDone() const {
+  absl::MutexLock lock(&mutex_);
+  return done_;
+}
+
+void MorselQuery::Cancel() {
+  Fail(::zetasql_base::CancelledErrorBuilder(ZETASQL_LOC) << "Query cancelled");
+}
+
+void MorselQuery::Fail(zetasql_base::Status status) {
+  absl::MutexLock lock(&mutex_);
+  if (status_.ok()) status_ = std::move(status);
+  failed_.store(true, std::memory_order_release);
+}
+
+void MorselQuery::AddTasks(int num_tasks) { num_tasks_ += num_tasks; }
+
+void MorselQuery::RemoveTask() {
+  if (num_tasks_.fetch_sub(1) == 1) {
+    absl::MutexLock lock(&mutex_);
+    done_ = true;
+  }
+}
+
+MorselScheduler::MorselScheduler(const Options& options)
+    : morsel_rows_(options.morsel_rows) {
+  CHECK_GT(morsel_rows_, 0);
+  int num_threads = options.num_threads;
+  if (num_threads <= 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (int i = 0; i < num_threads; ++i) {
+    workers_.push_back(absl::make_unique<Worker>());
+  }
+  // Start the threads once all workers exist, since they steal from each
+  // other.
+  for (int i = 0; i < num_threads; ++i) {
+    workers_[i]->thread = std::thread([this, i] { RunWorker(i); });
+  }
+}
+
+MorselScheduler::~MorselScheduler() {
+  {
+    absl::MutexLock lock(&idle_mutex_);
+    shutdown_ = true;
+    idle_cond_var_.SignalAll();
+  }
+  for (const std::unique_ptr<Worker>& worker : workers_) {
+    worker->thread.join();
+  }
+  // A worker may have queued tasks on another one that had already stopped.
+  for (const std::unique_ptr<Worker>& worker : workers_) {
+    absl::MutexLock lock(&worker->mutex);
+    for (const std::unique_ptr<Task>& task : worker->queue) {
+      task->query->Cancel();
+      task->query->RemoveTask();
+    }
+    worker->queue.clear();
+  }
+}
+
+zetasql_base::StatusOr<std::shared_ptr<MorselQuery>> MorselScheduler::Submit(
+    std::vector<MorselPipeline> pipelines, int priority) {
+  for (int i = 0; i < pipelines.size(); ++i) {
+    const MorselPipeline& pipeline = pipelines[i];
+    if (pipeline.create_partitions == nullptr ||
+        pipeline.process_morsel == nullptr) {
+      return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+             << "Pipeline " << i
+             << " needs create_partitions and process_morsel";
+    }
+    for (int dependency : pipeline.dependencies) {
+      if (dependency < 0 || dependency >= i) {
+        return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+               << "Pipeline " << i << " has invalid dependency "
+               << dependency;
+      }
+    }
+  }
+  std::shared_ptr<MorselQuery> query(
+      new MorselQuery(std::move(pipelines), priority));
+  for (int i = 0; i < query->pipelines_.size(); ++i) {
+    if (query->pipelines_[i]->pipeline.dependencies.empty()) {
+      StartPipeline(query, i);
+    }
+  }
+  // Drop the task count that kept the query from finishing while starting.
+  query->RemoveTask();
+  return query;
+}
+
+void MorselScheduler::RunWorker(int worker) {
+  while (true) {
+    std::unique_ptr<Task> task = TakeTask(worker);
+    if (task == nullptr) {
+      absl::MutexLock lock(&idle_mutex_);
+      if (shutdown_) return;
+      // QueueTask() signals after incrementing <num_queued_> if it sees an
+      // idle worker, and this checks <num_queued_> after incrementing
+      // <num_idle_>, so a queued task cannot be missed.
+      ++num_idle_;
+      while (num_queued_ <= 0 && !shutdown_) {
+        idle_cond_var_.Wait(&idle_mutex_);
+      }
+      --num_idle_;
+      continue;
+    }
+    task = RunMorsel(worker, std::move(task));
+    if (task != nullptr) {
+      QueueTask(worker, std::move(task), /*first=*/true);
+    }
+  }
+}
+
+std::unique_ptr<MorselScheduler::Task> MorselScheduler::TakeTask(int worker) {
+  for (int i = 0; i < workers_.size(); ++i) {
+    Worker* victim = workers_[(worker + i) % workers_.size()].get();
+    absl::MutexLock lock(&victim->mutex);
+    if (!victim->queue.empty()) {
+      std::unique_ptr<Task> task = std::move(victim->queue.front());
+      victim->queue.pop_front();
+      --num_queued_;
+      return task;
+    }
+  }
+  return nullptr;
+}
+
+void MorselScheduler::QueueTask(int worker, std::unique_ptr<Task> task,
+                                bool first) {
+  const int priority = task->query->priority();
+  {
+    Worker* queue_worker = workers_[worker].get();
+    absl::MutexLock lock(&queue_worker->mutex);
+    std::deque<std::unique_ptr<Task>>& queue = queue_worker->queue;
+    auto it = queue.begin();
+    while (it != queue.end() &&
+           ((*it)->query->priority() > priority ||
+            (!first && (*it)->query->priority() == priority))) {
+      ++it;
+    }
+    queue.insert(it, std::move(task));
+  }
+  ++num_queued_;
+  if (num_idle_ > 0) {
+    absl::MutexLock lock(&idle_mutex_);
+    idle_cond_var_.Signal();
+  }
+}
+
+std::unique_ptr<MorselScheduler::Task> MorselScheduler::RunMorsel(
+    int worker, std::unique_ptr<Task> task) {
+  MorselQuery* query = task->query.get();
+  if (shutdown_) query->Cancel();
+  if (query->failed()) {
+    query->RemoveTask();
+    return nullptr;
+  }
+  MorselQuery::PipelineState* state =
+      query->pipelines_[task->pipeline_index].get();
+  if (task->partition->NextBatch(morsel_rows_, &task->morsel)) {
+    zetasql_base::Status status =
+        state->pipeline.process_morsel(worker, task->morsel);
+    if (!status.ok()) {
+      query->Fail(std::move(status));
+      query->RemoveTask();
+      return nullptr;
+    }
+    return task;
+  }
+  zetasql_base::Status status = task->partition->Status();
+  if (!status.ok()) {
+    query->Fail(std::move(status));
+  } else {
+    task->partition.reset();
+    if (--state->num_pending == 0) {
+      FinishPipeline(task->query, task->pipeline_index);
+    }
+  }
+  // Only after the dependents have been queued, so that the query cannot be
+  // done before them.
+  query->RemoveTask();
+  return nullptr;
+}
+
+void MorselScheduler::StartPipeline(const std::shared_ptr<MorselQuery>& query,
+                                    int pipeline_index) {
+  if (shutdown_) query->Cancel();
+  if (query->failed()) return;
+  MorselQuery::PipelineState* state = query->pipelines_[pipeline_index].get();
+  zetasql_base::StatusOr<MorselPipeline::PartitionList> partitions =
+      state->pipeline.create_partitions();
+  if (!partitions.ok()) {
+    query->Fail(partitions.status());
+    return;
+  }
+  if (partitions.ValueOrDie().empty()) {
+    FinishPipeline(query, pipeline_index);
+    return;
+  }
+  const int num_partitions = partitions.ValueOrDie().size();
+  state->num_pending = num_partitions;
+  query->AddTasks(num_partitions);
+  const int first_worker = next_worker_++ % workers_.size();
+  for (int i = 0; i < num_partitions; ++i) {
+    auto task = absl::make_unique<Task>();
+    task->query = query;
+    task->pipeline_index = pipeline_index;
+    task->partition = std::move(partitions.ValueOrDie()[i]);
+    QueueTask((first_worker + i) % workers_.size(), std::move(task),
+              /*first=*/false);
+  }
+}
+
+void MorselScheduler::FinishPipeline(const std::shared_ptr<MorselQuery>& query,
+                                     int pipeline_index) {
+  if (query->failed()) return;
+  MorselQuery::PipelineState* state = query->pipelines_[pipeline_index].get();
+  if (state->pipeline.finish != nullptr) {
+    zetasql_base::Status status = state->pipeline.finish();
+    if (!status.ok()) {
+      query->Fail(std::move(status));
+      return;
+    }
+  }
+  for (int dependent : state->dependents) {
+    if (--query->pipelines_[dependent]->num_pending == 0) {
+      StartPipeline(query, dependent);
+    }
+  }
+}
+
+}  // namespace zetasql
@@ -0,0 +1,231 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PUBLIC_MORSEL_SCHEDULER_H_
+#define ZETASQL_PUBLIC_MORSEL_SCHEDULER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/value_batch.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "zetasql/base/status.h"
+#include "zetasql/base/statusor.h"
+
+namespace zetasql {
+
+// One pipeline of a query plan: a chain of operators between two pipeline
+// breakers, such as the build side of a hash join, an aggregation or a sort,
+// which an engine runs over the rows of a source.
+//
+// The source is split into partitions, usually from
+// Table::CreatePartitionedIterators() or from the partitions of the output
+// of a breaker, and each partition is read in morsels of up to
+// MorselScheduler::Options::morsel_rows rows. Different morsels are processed
+// concurrently on different workers.
+struct MorselPipeline {
+  using PartitionList = std::vector<std::unique_ptr<EvaluatorTableIterator>>;
+
+  // Returns the partitions of the source. Called once when all
+  // <dependencies> have finished, on the worker that finished the last one,
+  // so that a pipeline can read the output of the breakers it depends on.
+  // Called by Submit() for pipelines without dependencies.
+  std::function<zetasql_base::StatusOr<PartitionList>()> create_partitions;
+
+  // Processes one morsel. <worker> is the index of the calling worker, in
+  // [0, MorselScheduler::num_threads()), and no two calls with the same
+  // <worker> run at the same time, so per-worker state such as the partial
+  // hash tables of a breaker needs no locking.
+  std::function<zetasql_base::Status(int worker, const ValueBatch& morsel)>
+      process_morsel;
+
+  // Called once after the last morsel, e.g. to merge the per-worker state of
+  // a breaker. May be null.
+  std::function<zetasql_base::Status()> finish;
+
+  // Indexes of the pipelines of the same query that must finish before this
+  // one starts. Each must be smaller than the index of this pipeline.
+  std::vector<int> dependencies;
+};
+
+// A query submitted to a MorselScheduler. Thread-safe.
+class MorselQuery {
+ public:
+  MorselQuery(const MorselQuery&) = delete;
+  MorselQuery& operator=(const MorselQuery&) = delete;
+
+  // Waits until all pipelines have finished, or until the query has failed
+  // and no worker touches it anymore. Returns the first error of a callback
+  // or a partition, kCancelled after Cancel(), or OK.
+  zetasql_base::Status Wait();
+
+  // Returns true if Wait() would not block.
+  bool IsDone() const;
+
+  // Stops the query at the next morsel of each partition. No callbacks of
+  // the query start afterwards.
+  void Cancel();
+
+  int priority() const { return priority_; }
+
+ private:
+  friend class MorselScheduler;
+
+  struct PipelineState {
+    MorselPipeline pipeline;
+    // The number of unfinished dependencies, then of unfinished partitions.
+    std::atomic<int> num_pending{0};
+    std::vector<int> dependents;
+  };
+
+  MorselQuery(std::vector<MorselPipeline> pipelines, int priority);
+
+  // Records <status> as the result if it is the first error.
+  void Fail(zetasql_base::Status status);
+  bool failed() const { return failed_.load(std::memory_order_acquire); }
+
+  // Updates the number of queued or running tasks, and finishes the query
+  // when it drops to zero.
+  void AddTasks(int num_tasks);
+  void RemoveTask();
+
+  const int priority_;
+  std::vector<std::unique_ptr<PipelineState>> pipelines_;
+  std::atomic<bool> failed_{false};
+  // Tasks of the query that are queued or running, plus one while it starts.
+  std::atomic<int> num_tasks_{1};
+
+  mutable absl::Mutex mutex_;
+  zetasql_base::Status status_ GUARDED_BY(mutex_);
+  bool done_ GUARDED_BY(mutex_) = false;
+};
+
+// Runs the pipelines of concurrent queries on a fixed set of worker threads,
+// one morsel at a time.
+//
+// Each worker has its own queue of tasks, one per partition being read, in
+// order of decreasing query priority. A worker takes the first task of its
+// queue, processes one morsel of it and queues it again, so that a newly
+// submitted query of a higher priority is picked up after at most one
+// morsel, and it otherwise keeps reading the same partition. A worker whose
+// queue is empty steals the first task of another worker's queue, so work
+// moves between queries and pipelines as partitions finish at different
+// speeds. The tasks of a pipeline that starts are spread over all queues.
+//
+// When the last partition of a pipeline is done, the worker calls its
+// finish() and starts the pipelines that depend on it. Callbacks run on the
+// workers, so they must not wait for other queries of the same scheduler.
+//
+// Example:
+//   MorselScheduler scheduler;
+//   std::vector<MorselPipeline> pipelines(2);
+//   pipelines[0].create_partitions = ...;  // Build side of a hash join.
+//   pipelines[0].process_morsel = ...;    // Insert into per-worker tables.
+//   pipelines[0].finish = ...;            // Merge the tables.
+//   pipelines[1].create_partitions = ...;  // Probe side.
+//   pipelines[1].process_morsel = ...;
+//   pipelines[1].dependencies = {0};
+//   ZETASQL_ASSIGN_OR_RETURN(std::shared_ptr<MorselQuery> query,
+//                    scheduler.Submit(std::move(pipelines), /*priority=*/0));
+//   ZETASQL_RETURN_IF_ERROR(query->Wait());
+class MorselScheduler {
+ public:
+  struct Options {
+    // The number of worker threads. Zero means one per hardware thread.
+    int num_threads = 0;
+    // The maximum number of rows of a morsel. Must be positive.
+    int morsel_rows = 1024;
+  };
+
+  MorselScheduler() : MorselScheduler(Options()) {}
+  explicit MorselScheduler(const Options& options);
+  MorselScheduler(const MorselScheduler&) = delete;
+  MorselScheduler& operator=(const MorselScheduler&) = delete;
+
+  // Cancels the queries that have not finished, and waits for the workers.
+  ~MorselScheduler();
+
+  int num_threads() const { return workers_.size(); }
+
+  // Starts running <pipelines> as one query. Tasks of queries with a higher
+  // <priority> are taken first. The pipelines without dependencies start
+  // immediately. Returns an error if the dependencies are not valid.
+  zetasql_base::StatusOr<std::shared_ptr<MorselQuery>> Submit(
+      std::vector<MorselPipeline> pipelines, int priority);
+
+ private:
+  // Reads one partition of a pipeline.
+  struct Task {
+    std::shared_ptr<MorselQuery> query;
+    int pipeline_index;
+    std::unique_ptr<EvaluatorTableIterator> partition;
+    ValueBatch morsel;
+  };
+
+  struct Worker {
+    absl::Mutex mutex;
+    // In order of decreasing priority of the queries.
+    std::deque<std::unique_ptr<Task>> queue GUARDED_BY(mutex);
+    std::thread thread;
+  };
+
+  void RunWorker(int worker);
+
+  // Returns the first task of the queue of <worker>, or steals one, or
+  // returns null.
+  std::unique_ptr<Task> TakeTask(int worker);
+
+  // Queues <task> on <worker>. If <first>, puts it before the other tasks
+  // of the same priority.
+  void QueueTask(int worker, std::unique_ptr<Task> task, bool first);
+
+  // Processes one morsel of <task> on <worker>; returns the task if it has
+  // more.
+  std::unique_ptr<Task> RunMorsel(int worker, std::unique_ptr<Task> task);
+
+  // Creates the partitions of a pipeline whose dependencies have finished
+  // and spreads their tasks over the queues, or finishes the pipeline at
+  // once if it has none.
+  void StartPipeline(const std::shared_ptr<MorselQuery>& query,
+                     int pipeline_index);
+  // Calls finish() of a pipeline whose partitions are all done, and starts
+  // the dependents that are then ready.
+  void FinishPipeline(const std::shared_ptr<MorselQuery>& query,
+                      int pipeline_index);
+
+  const int morsel_rows_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  // The number of tasks in all queues, checked by idle workers.
+  std::atomic<int64_t> num_queued_{0};
+  std::atomic<int> num_idle_{0};
+  std::atomic<bool> shutdown_{false};
+  // The first queue of the tasks of the next pipeline that starts.
+  std::atomic<int> next_worker_{0};
+  absl::Mutex idle_mutex_;
+  absl::CondVar idle_cond_var_;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_MORSEL_SCHEDULER_H_
@@ -0,0 +1,258 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/morsel_scheduler.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/public/value_batch.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+
+namespace zetasql {
+namespace {
+
+using zetasql_base::testing::StatusIs;
+
+// Returns rows (i) for i in [begin, end).
+class RangeIterator : public EvaluatorTableIterator {
+ public:
+  RangeIterator(int64_t begin, int64_t end) : next_(begin - 1), end_(end) {}
+
+  int NumColumns() const override { return 1; }
+  std::string GetColumnName(int i) const override { return "key"; }
+  const Type* GetColumnType(int i) const override {
+    return types::Int64Type();
+  }
+  bool NextRow() override {
+    if (next_ + 1 >= end_) return false;
+    value_ = Value::Int64(++next_);
+    return true;
+  }
+  const Value& GetValue(int i) const override { return value_; }
+  zetasql_base::Status Status() const override { return zetasql_base::OkStatus(); }
+  zetasql_base::Status Cancel() override { return zetasql_base::OkStatus(); }
+
+ private:
+  int64_t next_;
+  const int64_t end_;
+  Value value_;
+};
+
+// Returns a source of <num_partitions> partitions of <rows_per_partition>
+// consecutive keys from 0.
+std::function<zetasql_base::StatusOr<MorselPipeline::PartitionList>()>
+RangeSource(int num_partitions, int64_t rows_per_partition) {
+  return [=]() {
+    MorselPipeline::PartitionList partitions;
+    for (int i = 0; i < num_partitions; ++i) {
+      partitions.push_back(absl::make_unique<RangeIterator>(
+          i * rows_per_partition, (i + 1) * rows_per_partition));
+    }
+    return partitions;
+  };
+}
+
+int64_t SumKeys(const ValueBatch& morsel) {
+  int64_t sum = 0;
+  for (int i = 0; i < morsel.num_rows(); ++i) {
+    sum += morsel.column(0).int64_data()[i];
+  }
+  return sum;
+}
+
+TEST(MorselSchedulerTest, RunsPipelinesAfterTheirBreakers) {
+  MorselScheduler::Options options;
+  options.num_threads = 4;
+  options.morsel_rows = 100;
+  MorselScheduler scheduler(options);
+
+  // A build pipeline sums per worker without locking and merges the sums in
+  // finish(); the probe pipeline checks that it only starts afterwards.
+  std::vector<int64_t> partial_sums(scheduler.num_threads());
+  std::atomic<int64_t> build_sum{-1};
+  std::atomic<int64_t> probe_sum{0};
+  std::atomic<bool> probe_saw_build{true};
+  std::vector<MorselPipeline> pipelines(3);
+  pipelines[0].create_partitions = RangeSource(8, 1000);
+  pipelines[0].process_morsel = [&](int worker, const ValueBatch& morsel) {
+    partial_sums[worker] += SumKeys(morsel);
+    return zetasql_base::OkStatus();
+  };
+  pipelines[0].finish = [&]() {
+    int64_t sum = 0;
+    for (int64_t partial_sum : partial_sums) sum += partial_sum;
+    build_sum = sum;
+    return zetasql_base::OkStatus();
+  };
+  // No partitions, so it finishes as soon as it starts.
+  pipelines[1].create_partitions = RangeSource(0, 0);
+  pipelines[1].process_morsel = [](int worker, const ValueBatch& morsel) {
+    return zetasql_base::OkStatus();
+  };
+  pipelines[1].dependencies = {0};
+  pipelines[2].create_partitions = RangeSource(3, 250);
+  pipelines[2].process_morsel = [&](int worker, const ValueBatch& morsel) {
+    if (build_sum < 0) probe_saw_build = false;
+    probe_sum += SumKeys(morsel);
+    return zetasql_base::OkStatus();
+  };
+  pipelines[2].dependencies = {0, 1};
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<MorselQuery> query,
+                       scheduler.Submit(std::move(pipelines), 0));
+  ZETASQL_EXPECT_OK(query->Wait());
+  EXPECT_TRUE(query->IsDone());
+  EXPECT_EQ(7999 * 8000 / 2, build_sum);
+  EXPECT_EQ(749 * 750 / 2, probe_sum);
+  EXPECT_TRUE(probe_saw_build);
+}
+
+TEST(MorselSchedulerTest, ManyConcurrentQueries) {
+  MorselScheduler::Options options;
+  options.num_threads = 8;
+  options.morsel_rows = 64;
+  MorselScheduler scheduler(options);
+  constexpr int kNumQueries = 20;
+  std::vector<std::atomic<int64_t>> sums(kNumQueries);
+  std::vector<std::shared_ptr<MorselQuery>> queries;
+  for (int i = 0; i < kNumQueries; ++i) {
+    sums[i] = 0;
+    std::vector<MorselPipeline> pipelines(1);
+    pipelines[0].create_partitions = RangeSource(1 + i % 5, 500);
+    pipelines[0].process_morsel = [&sums, i](int worker,
+                                             const ValueBatch& morsel) {
+      sums[i] += SumKeys(morsel);
+      return zetasql_base::OkStatus();
+    };
+    ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<MorselQuery> query,
+                         scheduler.Submit(std::move(pipelines), i % 3));
+    queries.push_back(query);
+  }
+  for (int i = 0; i < kNumQueries; ++i) {
+    ZETASQL_EXPECT_OK(queries[i]->Wait());
+    const int64_t num_rows = (1 + i % 5) * 500;
+    EXPECT_EQ(num_rows * (num_rows - 1) / 2, sums[i]) << i;
+  }
+}
+
+TEST(MorselSchedulerTest, HigherPriorityRunsFirst) {
+  MorselScheduler::Options options;
+  options.num_threads = 1;
+  options.morsel_rows = 10;
+  MorselScheduler scheduler(options);
+
+  // Hold the only worker in the first morsel of the low priority query
+  // while the others are submitted.
+  absl::Notification started;
+  absl::Notification release;
+  absl::Mutex mutex;
+  std::vector<int> order;
+  auto pipelines = [&](int id) {
+    std::vector<MorselPipeline> pipelines(1);
+    pipelines[0].create_partitions = RangeSource(1, 30);
+    pipelines[0].process_morsel = [&, id](int worker,
+                                          const ValueBatch& morsel) {
+      if (id == 0 && !started.HasBeenNotified()) {
+        started.Notify();
+        release.WaitForNotification();
+      }
+      absl::MutexLock lock(&mutex);
+      order.push_back(id);
+      return zetasql_base::OkStatus();
+    };
+    return pipelines;
+  };
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<MorselQuery> low,
+                       scheduler.Submit(pipelines(0), /*priority=*/0));
+  started.WaitForNotification();
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<MorselQuery> other_low,
+                       scheduler.Submit(pipelines(1), /*priority=*/0));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<MorselQuery> high,
+                       scheduler.Submit(pipelines(2), /*priority=*/1));
+  release.Notify();
+  ZETASQL_EXPECT_OK(low->Wait());
+  ZETASQL_EXPECT_OK(other_low->Wait());
+  ZETASQL_EXPECT_OK(high->Wait());
+  // The running query keeps its place among those of its priority.
+  EXPECT_THAT(order, ::testing::ElementsAre(0, 2, 2, 2, 0, 0, 1, 1, 1));
+}
+
+TEST(MorselSchedulerTest, Errors) {
+  MorselScheduler::Options options;
+  options.num_threads = 2;
+  MorselScheduler scheduler(options);
+
+  std::vector<MorselPipeline> pipelines(2);
+  pipelines[0].create_partitions = RangeSource(4, 5000);
+  pipelines[0].process_morsel = [](int worker, const ValueBatch& morsel) {
+    return SumKeys(morsel) > 0 ? zetasql_base::OutOfRangeError("overflow")
+                               : zetasql_base::OkStatus();
+  };
+  std::atomic<bool> dependent_ran{false};
+  pipelines[1].create_partitions = [&]() {
+    dependent_ran = true;
+    return MorselPipeline::PartitionList();
+  };
+  pipelines[1].process_morsel = pipelines[0].process_morsel;
+  pipelines[1].dependencies = {0};
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<MorselQuery> query,
+                       scheduler.Submit(pipelines, 0));
+  EXPECT_THAT(query->Wait(),
+              StatusIs(zetasql_base::StatusCode::kOutOfRange));
+  EXPECT_FALSE(dependent_ran);
+
+  pipelines[1].dependencies = {1};
+  EXPECT_THAT(scheduler.Submit(pipelines, 0).status(),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+  pipelines[1].dependencies = {0};
+  pipelines[1].process_morsel = nullptr;
+  EXPECT_THAT(scheduler.Submit(pipelines, 0).status(),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+
+  // A cancelled query stops at the next morsel of its partition.
+  absl::Notification started;
+  absl::Notification release;
+  std::atomic<int> num_morsels{0};
+  pipelines.resize(1);
+  pipelines[0].create_partitions = RangeSource(1, 5000);
+  pipelines[0].process_morsel = [&](int worker, const ValueBatch& morsel) {
+    if (++num_morsels == 1) {
+      started.Notify();
+      release.WaitForNotification();
+    }
+    return zetasql_base::OkStatus();
+  };
+  ZETASQL_ASSERT_OK_AND_ASSIGN(query, scheduler.Submit(pipelines, 0));
+  started.WaitForNotification();
+  query->Cancel();
+  release.Notify();
+  EXPECT_THAT(query->Wait(), StatusIs(zetasql_base::StatusCode::kCancelled));
+  EXPECT_EQ(1, num_morsels);
+}
+
+}  // namespace
+}  // namespace zetasql
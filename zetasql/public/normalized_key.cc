@@ -0,0 +1,369 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/normalized_key.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <utility>
+
+#include "zetasql/public/civil_time.h"
+#include "zetasql/public/functions/date_time_util.h"
+#include "zetasql/public/numeric_value.h"
+#include "absl/time/time.h"
+#include "zetasql/base/logging.h"
+#include "zetasql/base/source_location.h"
+#include "zetasql/base/status_builder.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+namespace {
+
+constexpr uint64_t kSignBit = uint64_t{1} << 63;
+constexpr char kNullMarker = '\x00';
+constexpr char kNonNullMarker = '\x01';
+
+// Appends <value> in big-endian order, so that bytewise order is numeric.
+void AppendUint64(uint64_t value, std::string* key) {
+  char bytes[8];
+  for (int i = 7; i >= 0; --i) {
+    bytes[i] = static_cast<char>(value & 0xff);
+    value >>= 8;
+  }
+  key->append(bytes, 8);
+}
+
+void AppendInt64(int64_t value, std::string* key) {
+  AppendUint64(static_cast<uint64_t>(value) ^ kSignBit, key);
+}
+
+// Appends <bytes> with each 0 byte escaped as 0 0xff and a terminating 0 0,
+// so that a string sorts before its extensions.
+void AppendBytes(absl::string_view bytes, std::string* key) {
+  for (const char c : bytes) {
+    key->push_back(c);
+    if (c == '\0') key->push_back('\xff');
+  }
+  key->append(2, '\0');
+}
+
+// Appends the ascending encoding of <value>, which is not NULL.
+void AppendValue(const Value& value, std::string* key) {
+  switch (value.type_kind()) {
+    case TYPE_INT32:
+    case TYPE_INT64:
+    case TYPE_DATE:
+      AppendInt64(value.ToInt64(), key);
+      break;
+    case TYPE_ENUM:
+      AppendInt64(value.enum_value(), key);
+      break;
+    case TYPE_UINT32:
+    case TYPE_UINT64:
+      AppendUint64(value.ToUint64(), key);
+      break;
+    case TYPE_BOOL:
+      key->push_back(value.bool_value() ? '\x01' : '\x00');
+      break;
+    case TYPE_FLOAT:
+    case TYPE_DOUBLE: {
+      double d = value.ToDouble();
+      uint64_t bits = 0;  // NaNs sort first.
+      if (!std::isnan(d)) {
+        if (d == 0) d = 0;  // -0 is equal to 0.
+        memcpy(&bits, &d, sizeof(bits));
+        bits = (bits & kSignBit) != 0 ? ~bits : bits | kSignBit;
+      }
+      AppendUint64(bits, key);
+      break;
+    }
+    case TYPE_NUMERIC: {
+      const unsigned __int128 packed =
+          static_cast<unsigned __int128>(value.numeric_value().as_packed_int());
+      AppendUint64(static_cast<uint64_t>(packed >> 64) ^ kSignBit, key);
+      AppendUint64(static_cast<uint64_t>(packed), key);
+      break;
+    }
+    case TYPE_STRING:
+      AppendBytes(value.string_value(), key);
+      break;
+    case TYPE_BYTES:
+      AppendBytes(value.bytes_value(), key);
+      break;
+    case TYPE_TIMESTAMP: {
+      const absl::Time time = value.ToTime();
+      const int64_t seconds = absl::ToUnixSeconds(time);
+      AppendInt64(seconds, key);
+      AppendInt64(absl::ToInt64Nanoseconds(time - absl::FromUnixSeconds(seconds)),
+                  key);
+      break;
+    }
+    case TYPE_TIME:
+      AppendInt64(value.time_value().Packed32TimeSeconds(), key);
+      AppendInt64(value.time_value().Nanoseconds(), key);
+      break;
+    case TYPE_DATETIME:
+      AppendInt64(value.datetime_value().Packed64DatetimeSeconds(), key);
+      AppendInt64(value.datetime_value().Nanoseconds(), key);
+      break;
+    default:
+      LOG(DFATAL) << "Unsupported normalized key type "
+                  << value.type()->DebugString();
+  }
+}
+
+// Reads the pieces of a key from the front of a string_view, complementing
+// the bytes of descending keys.
+class KeyReader {
+ public:
+  KeyReader(bool descending, absl::string_view* key)
+      : mask_(descending ? 0xff : 0), key_(key) {}
+
+  KeyReader(const KeyReader&) = delete;
+  KeyReader& operator=(const KeyReader&) = delete;
+
+  bool ReadByte(char* byte) {
+    if (key_->empty()) return false;
+    *byte = static_cast<char>(key_->front() ^ mask_);
+    key_->remove_prefix(1);
+    return true;
+  }
+
+  bool ReadUint64(uint64_t* value) {
+    if (key_->size() < 8) return false;
+    *value = 0;
+    for (int i = 0; i < 8; ++i) {
+      *value = (*value << 8) | static_cast<uint8_t>((*key_)[i] ^ mask_);
+    }
+    key_->remove_prefix(8);
+    return true;
+  }
+
+  bool ReadInt64(int64_t* value) {
+    uint64_t bits;
+    if (!ReadUint64(&bits)) return false;
+    *value = static_cast<int64_t>(bits ^ kSignBit);
+    return true;
+  }
+
+  // Reads the escaped bytes of a STRING or BYTES key.
+  bool ReadBytes(std::string* bytes) {
+    bytes->clear();
+    char c;
+    while (ReadByte(&c)) {
+      if (c != '\0') {
+        bytes->push_back(c);
+        continue;
+      }
+      if (!ReadByte(&c)) return false;
+      if (c == '\0') return true;
+      if (c != '\xff') return false;
+      bytes->push_back('\0');
+    }
+    return false;
+  }
+
+ private:
+  const uint8_t mask_;
+  absl::string_view* key_;
+};
+
+zetasql_base::Status InvalidKeyError(const Type* type) {
+  return ::zetasql_base::OutOfRangeErrorBuilder(ZETASQL_LOC)
+         << "Invalid normalized key for type " << type->DebugString();
+}
+
+// Reads the encoding of a non-NULL value of <type>, which has normalized
+// keys.
+zetasql_base::StatusOr<Value> ReadValue(const Type* type, KeyReader* reader) {
+  int64_t int64_value;
+  uint64_t uint64_value;
+  switch (type->kind()) {
+    case TYPE_INT32:
+      if (!reader->ReadInt64(&int64_value) ||
+          int64_value < std::numeric_limits<int32_t>::min() ||
+          int64_value > std::numeric_limits<int32_t>::max()) {
+        break;
+      }
+      return Value::Int32(static_cast<int32_t>(int64_value));
+    case TYPE_INT64:
+      if (!reader->ReadInt64(&int64_value)) break;
+      return Value::Int64(int64_value);
+    case TYPE_DATE:
+      if (!reader->ReadInt64(&int64_value) ||
+          int64_value < std::numeric_limits<int32_t>::min() ||
+          int64_value > std::numeric_limits<int32_t>::max() ||
+          !functions::IsValidDate(static_cast<int32_t>(int64_value))) {
+        break;
+      }
+      return Value::Date(static_cast<int32_t>(int64_value));
+    case TYPE_ENUM:
+      if (!reader->ReadInt64(&int64_value) ||
+          int64_value < std::numeric_limits<int32_t>::min() ||
+          int64_value > std::numeric_limits<int32_t>::max() ||
+          type->AsEnum()->enum_descriptor()->FindValueByNumber(
+              static_cast<int>(int64_value)) == nullptr) {
+        break;
+      }
+      return Value::Enum(type->AsEnum(), static_cast<int>(int64_value));
+    case TYPE_UINT32:
+      if (!reader->ReadUint64(&uint64_value) ||
+          uint64_value > std::numeric_limits<uint32_t>::max()) {
+        break;
+      }
+      return Value::Uint32(static_cast<uint32_t>(uint64_value));
+    case TYPE_UINT64:
+      if (!reader->ReadUint64(&uint64_value)) break;
+      return Value::Uint64(uint64_value);
+    case TYPE_BOOL: {
+      char c;
+      if (!reader->ReadByte(&c) || (c != '\x00' && c != '\x01')) break;
+      return Value::Bool(c == '\x01');
+    }
+    case TYPE_FLOAT:
+    case TYPE_DOUBLE: {
+      if (!reader->ReadUint64(&uint64_value)) break;
+      double d = std::numeric_limits<double>::quiet_NaN();
+      if (uint64_value != 0) {
+        uint64_value = (uint64_value & kSignBit) != 0 ? uint64_value ^ kSignBit
+                                                      : ~uint64_value;
+        memcpy(&d, &uint64_value, sizeof(d));
+      }
+      if (type->kind() == TYPE_DOUBLE) return Value::Double(d);
+      return Value::Float(static_cast<float>(d));
+    }
+    case TYPE_NUMERIC: {
+      uint64_t low;
+      if (!reader->ReadUint64(&uint64_value) || !reader->ReadUint64(&low)) {
+        break;
+      }
+      const unsigned __int128 packed =
+          (static_cast<unsigned __int128>(uint64_value ^ kSignBit) << 64) |
+          low;
+      const zetasql_base::StatusOr<NumericValue> numeric =
+          NumericValue::FromPackedInt(static_cast<__int128>(packed));
+      if (!numeric.ok()) break;
+      return Value::Numeric(numeric.ValueOrDie());
+    }
+    case TYPE_STRING:
+    case TYPE_BYTES: {
+      std::string bytes;
+      if (!reader->ReadBytes(&bytes)) break;
+      if (type->kind() == TYPE_BYTES) return Value::Bytes(std::move(bytes));
+      return Value::StringValue(std::move(bytes));
+    }
+    case TYPE_TIMESTAMP: {
+      int64_t nanos;
+      if (!reader->ReadInt64(&int64_value) || !reader->ReadInt64(&nanos) ||
+          nanos < 0 || nanos >= 1000000000) {
+        break;
+      }
+      const absl::Time time =
+          absl::FromUnixSeconds(int64_value) + absl::Nanoseconds(nanos);
+      if (!functions::IsValidTime(time)) break;
+      return Value::Timestamp(time);
+    }
+    case TYPE_TIME: {
+      int64_t nanos;
+      if (!reader->ReadInt64(&int64_value) || !reader->ReadInt64(&nanos) ||
+          int64_value < std::numeric_limits<int32_t>::min() ||
+          int64_value > std::numeric_limits<int32_t>::max() || nanos < 0 ||
+          nanos >= 1000000000) {
+        break;
+      }
+      const TimeValue time = TimeValue::FromPacked32SecondsAndNanos(
+          static_cast<int32_t>(int64_value), static_cast<int32_t>(nanos));
+      if (!time.IsValid()) break;
+      return Value::Time(time);
+    }
+    case TYPE_DATETIME: {
+      int64_t nanos;
+      if (!reader->ReadInt64(&int64_value) || !reader->ReadInt64(&nanos) ||
+          nanos < 0 || nanos >= 1000000000) {
+        break;
+      }
+      const DatetimeValue datetime = DatetimeValue::FromPacked64SecondsAndNanos(
+          int64_value, static_cast<int32_t>(nanos));
+      if (!datetime.IsValid()) break;
+      return Value::Datetime(datetime);
+    }
+    default:
+      return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+             << "Type " << type->DebugString() << " has no normalized keys";
+  }
+  return InvalidKeyError(type);
+}
+
+}  // namespace
+
+bool SupportsNormalizedKey(const Type* type) {
+  switch (type->kind()) {
+    case TYPE_INT32:
+    case TYPE_INT64:
+    case TYPE_UINT32:
+    case TYPE_UINT64:
+    case TYPE_BOOL:
+    case TYPE_FLOAT:
+    case TYPE_DOUBLE:
+    case TYPE_NUMERIC:
+    case TYPE_STRING:
+    case TYPE_BYTES:
+    case TYPE_DATE:
+    case TYPE_TIMESTAMP:
+    case TYPE_TIME:
+    case TYPE_DATETIME:
+    case TYPE_ENUM:
+      return true;
+    default:
+      return false;
+  }
+}
+
+void AppendNormalizedKey(const Value& value, bool descending,
+                         std::string* key) {
+  const size_t start = key->size();
+  if (value.is_null()) {
+    key->push_back(kNullMarker);
+  } else {
+    key->push_back(kNonNullMarker);
+    AppendValue(value, key);
+  }
+  if (descending) {
+    for (size_t i = start; i < key->size(); ++i) {
+      (*key)[i] = ~(*key)[i];
+    }
+  }
+}
+
+zetasql_base::StatusOr<Value> ConsumeNormalizedKey(const Type* type, bool descending,
+                                           absl::string_view* key) {
+  if (!SupportsNormalizedKey(type)) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "Type " << type->DebugString() << " has no normalized keys";
+  }
+  KeyReader reader(descending, key);
+  char marker;
+  if (!reader.ReadByte(&marker)) return InvalidKeyError(type);
+  if (marker == kNullMarker) return Value::Null(type);
+  if (marker != kNonNullMarker) return InvalidKeyError(type);
+  return ReadValue(type, &reader);
+}
+
+}  // namespace zetasql
@@ -0,0 +1,88 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Normalized keys: binary encodings of Values whose bytewise order
+// (std::string::compare, memcmp) is the order of the Values, for sorting,
+// range partitioning and sorted storage of rows by their keys.
+//
+// The key of a tuple of values is the concatenation of the keys of its
+// values, each of which may be ascending or descending. Every key starts with
+// a NULL marker and is self-delimiting, so the key of one value never runs
+// into the key of the next, and no key is a prefix of another key of the same
+// type.
+//
+// Values are ordered as by Value::LessThan(): NULLs first, then for FLOAT and
+// DOUBLE NaNs, with -0 equal to 0; STRING and BYTES compare bytewise without
+// collation. A descending key reverses its order, NULLs included, which puts
+// NULLs last as SQL requires.
+//
+// The encodings are:
+//   integers, DATE, ENUM     8 bytes big-endian, sign bit flipped if signed
+//   BOOL                     1 byte
+//   FLOAT, DOUBLE            the IEEE bits of the DOUBLE, flipped so that they
+//                            order as integers; NaN is 0
+//   NUMERIC                  the 128-bit packed integer, big-endian, sign bit
+//                            flipped
+//   STRING, BYTES            the bytes, each 0 as 0 0xff, then 0 0
+//   TIMESTAMP, TIME,         the whole seconds and nanoseconds, each as an
+//   DATETIME                 integer
+// and descending keys have all their bytes complemented.
+//
+// Decoding gives back an equal Value, except that all NaNs decode to the same
+// NaN and -0 decodes to 0. Keys are stable across binaries and may be
+// persisted.
+//
+// Example:
+//   std::string key;
+//   AppendNormalizedKey(row[0], /*descending=*/false, &key);
+//   AppendNormalizedKey(row[1], /*descending=*/true, &key);
+//   ...
+//   absl::string_view rest = key;
+//   ZETASQL_ASSIGN_OR_RETURN(Value first,
+//                    ConsumeNormalizedKey(type0, /*descending=*/false, &rest));
+//   ZETASQL_ASSIGN_OR_RETURN(Value second,
+//                    ConsumeNormalizedKey(type1, /*descending=*/true, &rest));
+
+#ifndef ZETASQL_PUBLIC_NORMALIZED_KEY_H_
+#define ZETASQL_PUBLIC_NORMALIZED_KEY_H_
+
+#include <string>
+
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "absl/strings/string_view.h"
+#include "zetasql/base/statusor.h"
+
+namespace zetasql {
+
+// Returns whether values of <type> have normalized keys: the integer types,
+// BOOL, FLOAT, DOUBLE, NUMERIC, STRING, BYTES, DATE, TIMESTAMP, TIME,
+// DATETIME and ENUM.
+bool SupportsNormalizedKey(const Type* type);
+
+// Appends the normalized key of <value> to <key>.
+// REQUIRES: SupportsNormalizedKey(value.type()).
+void AppendNormalizedKey(const Value& value, bool descending, std::string* key);
+
+// Decodes the normalized key of a value of <type> at the front of <key>, and
+// removes it from <key>. Returns kOutOfRange if <key> does not start with a
+// valid key of <type>, and kInvalidArgument if <type> has no normalized keys.
+zetasql_base::StatusOr<Value> ConsumeNormalizedKey(const Type* type, bool descending,
+                                           absl::string_view* key);
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_NORMALIZED_KEY_H_
@@ -0,0 +1,211 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/normalized_key.h"
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/civil_time.h"
+#include "zetasql/public/numeric_value.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/testdata/test_schema.pb.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+
+namespace zetasql {
+
+using zetasql_base::testing::StatusIs;
+
+std::string Encode(const Value& value, bool descending = false) {
+  std::string key;
+  AppendNormalizedKey(value, descending, &key);
+  return key;
+}
+
+// Expects <values>, which are in strictly increasing order, to have keys in
+// the same order, in reverse order when descending, and to decode from their
+// keys.
+void ExpectOrderedAndDecodable(const std::vector<Value>& values) {
+  for (int i = 0; i < values.size(); ++i) {
+    const Value& value = values[i];
+    for (const bool descending : {false, true}) {
+      const std::string key = Encode(value, descending);
+      absl::string_view rest = key;
+      ZETASQL_ASSERT_OK_AND_ASSIGN(
+          const Value decoded,
+          ConsumeNormalizedKey(value.type(), descending, &rest));
+      EXPECT_EQ(value, decoded) << value.DebugString();
+      EXPECT_TRUE(rest.empty()) << value.DebugString();
+      // Truncated keys are rejected.
+      for (int size = 0; size < key.size(); ++size) {
+        absl::string_view prefix(key.data(), size);
+        EXPECT_FALSE(
+            ConsumeNormalizedKey(value.type(), descending, &prefix).ok())
+            << value.DebugString() << " " << size;
+      }
+    }
+    if (i + 1 == values.size()) break;
+    ASSERT_TRUE(value.LessThan(values[i + 1]))
+        << value.DebugString() << " " << values[i + 1].DebugString();
+    EXPECT_LT(Encode(value), Encode(values[i + 1]))
+        << value.DebugString() << " " << values[i + 1].DebugString();
+    EXPECT_GT(Encode(value, /*descending=*/true),
+              Encode(values[i + 1], /*descending=*/true))
+        << value.DebugString() << " " << values[i + 1].DebugString();
+  }
+}
+
+TEST(NormalizedKeyTest, Integers) {
+  ExpectOrderedAndDecodable(
+      {Value::NullInt32(), Value::Int32(std::numeric_limits<int32_t>::min()),
+       Value::Int32(-1), Value::Int32(0),
+       Value::Int32(std::numeric_limits<int32_t>::max())});
+  ExpectOrderedAndDecodable(
+      {Value::NullInt64(), Value::Int64(std::numeric_limits<int64_t>::min()),
+       Value::Int64(-1), Value::Int64(0), Value::Int64(1),
+       Value::Int64(std::numeric_limits<int64_t>::max())});
+  ExpectOrderedAndDecodable(
+      {Value::NullUint32(), Value::Uint32(0),
+       Value::Uint32(std::numeric_limits<uint32_t>::max())});
+  ExpectOrderedAndDecodable(
+      {Value::NullUint64(), Value::Uint64(0), Value::Uint64(1),
+       Value::Uint64(std::numeric_limits<uint64_t>::max())});
+  ExpectOrderedAndDecodable(
+      {Value::NullBool(), Value::Bool(false), Value::Bool(true)});
+}
+
+TEST(NormalizedKeyTest, FloatingPoint) {
+  const double inf = std::numeric_limits<double>::infinity();
+  ExpectOrderedAndDecodable(
+      {Value::NullDouble(), Value::Double(-inf), Value::Double(-1.5),
+       Value::Double(0), Value::Double(1e-300), Value::Double(2),
+       Value::Double(inf)});
+  ExpectOrderedAndDecodable(
+      {Value::NullFloat(), Value::Float(-3.5f), Value::Float(0),
+       Value::Float(std::numeric_limits<float>::max())});
+  EXPECT_LT(Encode(Value::Double(std::nan(""))), Encode(Value::Double(-inf)));
+  EXPECT_EQ(Encode(Value::Double(0)), Encode(Value::Double(-0.0)));
+
+  const std::string key = Encode(Value::Float(std::nanf("")));
+  absl::string_view rest = key;
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      const Value nan,
+      ConsumeNormalizedKey(types::FloatType(), /*descending=*/false, &rest));
+  EXPECT_TRUE(std::isnan(nan.float_value()));
+}
+
+TEST(NormalizedKeyTest, Numeric) {
+  ExpectOrderedAndDecodable(
+      {Value::NullNumeric(), Value::Numeric(NumericValue::MinValue()),
+       Value::Numeric(NumericValue(-1)), Value::Numeric(NumericValue()),
+       Value::Numeric(NumericValue(1)),
+       Value::Numeric(NumericValue::MaxValue())});
+}
+
+TEST(NormalizedKeyTest, StringsAndBytes) {
+  ExpectOrderedAndDecodable(
+      {Value::NullString(), Value::String(""), Value::String("a"),
+       Value::String(std::string("a\0", 2)),
+       Value::String(std::string("a\0b", 3)), Value::String("a\x01"),
+       Value::String("ab"), Value::String("b")});
+  ExpectOrderedAndDecodable({Value::NullBytes(), Value::Bytes(""),
+                             Value::Bytes(std::string("\0\0", 2)),
+                             Value::Bytes("\xff")});
+}
+
+TEST(NormalizedKeyTest, DateAndTime) {
+  ExpectOrderedAndDecodable(
+      {Value::NullDate(), Value::Date(-10), Value::Date(0), Value::Date(10)});
+  ExpectOrderedAndDecodable(
+      {Value::NullTimestamp(), Value::TimestampFromUnixMicros(-1000001),
+       Value::TimestampFromUnixMicros(-1), Value::TimestampFromUnixMicros(0),
+       Value::Timestamp(absl::FromUnixNanos(1))});
+  ExpectOrderedAndDecodable(
+      {Value::NullTime(), Value::Time(TimeValue::FromHMSAndNanos(0, 0, 0, 0)),
+       Value::Time(TimeValue::FromHMSAndNanos(1, 2, 3, 4)),
+       Value::Time(TimeValue::FromHMSAndNanos(23, 59, 59, 999999999))});
+  ExpectOrderedAndDecodable(
+      {Value::NullDatetime(),
+       Value::Datetime(DatetimeValue::FromYMDHMSAndNanos(1, 1, 1, 0, 0, 0, 0)),
+       Value::Datetime(
+           DatetimeValue::FromYMDHMSAndNanos(2019, 2, 3, 4, 5, 6, 7)),
+       Value::Datetime(
+           DatetimeValue::FromYMDHMSAndNanos(2019, 2, 3, 4, 5, 6, 8))});
+}
+
+TEST(NormalizedKeyTest, Enum) {
+  TypeFactory type_factory;
+  const EnumType* enum_type;
+  ZETASQL_ASSERT_OK(type_factory.MakeEnumType(zetasql_test::TestEnum_descriptor(),
+                                      &enum_type));
+  ExpectOrderedAndDecodable({Value::Null(enum_type),
+                             Value::Enum(enum_type, 0),
+                             Value::Enum(enum_type, 1)});
+}
+
+TEST(NormalizedKeyTest, Tuples) {
+  std::string a, b, c;
+  AppendNormalizedKey(Value::String("x"), /*descending=*/false, &a);
+  AppendNormalizedKey(Value::String("xy"), /*descending=*/false, &b);
+  AppendNormalizedKey(Value::String("xy"), /*descending=*/false, &c);
+  AppendNormalizedKey(Value::Int64(1), /*descending=*/true, &a);
+  AppendNormalizedKey(Value::Int64(2), /*descending=*/true, &b);
+  AppendNormalizedKey(Value::NullInt64(), /*descending=*/true, &c);
+  // The string keys must not run into the integer keys that follow them.
+  EXPECT_LT(a, b);
+  EXPECT_LT(b, c);
+
+  absl::string_view rest = b;
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      const Value first,
+      ConsumeNormalizedKey(types::StringType(), /*descending=*/false, &rest));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      const Value second,
+      ConsumeNormalizedKey(types::Int64Type(), /*descending=*/true, &rest));
+  EXPECT_EQ(Value::String("xy"), first);
+  EXPECT_EQ(Value::Int64(2), second);
+  EXPECT_TRUE(rest.empty());
+}
+
+TEST(NormalizedKeyTest, Errors) {
+  EXPECT_FALSE(SupportsNormalizedKey(types::Int64ArrayType()));
+  absl::string_view key = "\x01";
+  EXPECT_THAT(ConsumeNormalizedKey(types::Int64ArrayType(),
+                                   /*descending=*/false, &key)
+                  .status(),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+  key = "\x02";
+  EXPECT_THAT(
+      ConsumeNormalizedKey(types::BoolType(), /*descending=*/false, &key)
+          .status(),
+      StatusIs(zetasql_base::StatusCode::kOutOfRange));
+  // An INT64 key does not decode as an INT32 out of its range.
+  const std::string int64_key = Encode(Value::Int64(int64_t{1} << 40));
+  key = int64_key;
+  EXPECT_THAT(
+      ConsumeNormalizedKey(types::Int32Type(), /*descending=*/false, &key)
+          .status(),
+      StatusIs(zetasql_base::StatusCode::kOutOfRange));
+}
+
+}  // namespace zetasql
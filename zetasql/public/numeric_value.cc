@@ -352,8 +352,207 @@ void Uint224::LongDivision(const Uint224& x) {
   *this = quotient;
 }
 
+// Divides the unsigned 192-bit number 'dividend_hi' * 2^128 + 'dividend_lo' by
+// 'divisor', which must not be zero, and stores the quotient in 'quotient'.
+// Rounds the quotient away from zero if 'round_away_from_zero' is set to true,
+// which is equivalent to Uint224::Divide. Returns false if the quotient does
+// not fit in a non-negative __int128.
+//
+// The common cases are handled with native 128-bit operations: a dividend that
+// fits in 128 bits needs a single division, and a divisor that fits in 64 bits
+// needs three 128-by-64 bit divisions whose quotients always fit in 64 bits.
+// Only a dividend and a divisor that are both wider go through the 32-bit word
+// long division in Uint224.
+inline bool DivideUint192(uint64_t dividend_hi, unsigned __int128 dividend_lo,
+                          unsigned __int128 divisor, bool round_away_from_zero,
+                          __int128* quotient) {
+  unsigned __int128 q;
+  unsigned __int128 r;
+  if (dividend_hi == 0) {
+    q = dividend_lo / divisor;
+    r = dividend_lo % divisor;
+  } else if (static_cast<uint64_t>(divisor >> kBitsPerUint64) == 0) {
+    const uint64_t d = static_cast<uint64_t>(divisor);
+    if (dividend_hi >= d) {
+      // The quotient needs more than 128 bits.
+      return false;
+    }
+    unsigned __int128 t =
+        (static_cast<unsigned __int128>(dividend_hi) << kBitsPerUint64) |
+        static_cast<uint64_t>(dividend_lo >> kBitsPerUint64);
+    const uint64_t q1 = static_cast<uint64_t>(t / d);
+    t = (static_cast<unsigned __int128>(static_cast<uint64_t>(t % d))
+         << kBitsPerUint64) |
+        static_cast<uint64_t>(dividend_lo);
+    q = (static_cast<unsigned __int128>(q1) << kBitsPerUint64) |
+        static_cast<uint64_t>(t / d);
+    r = static_cast<uint64_t>(t % d);
+  } else {
+    Uint224 dividend(dividend_hi, dividend_lo);
+    dividend.Divide(Uint224(static_cast<__int128>(divisor)),
+                    round_away_from_zero);
+    auto to_int128_status = dividend.to_int128();
+    if (!to_int128_status.ok()) {
+      return false;
+    }
+    *quotient = to_int128_status.ValueOrDie();
+    return true;
+  }
+
+  if ((q >> (kBitsPerInt128 - 1)) != 0) {
+    return false;
+  }
+  // Rounding half away from zero increments the quotient when the remainder
+  // is at least half of the divisor.
+  if (round_away_from_zero && r >= divisor - r) {
+    ++q;
+    if ((q >> (kBitsPerInt128 - 1)) != 0) {
+      return false;
+    }
+  }
+  *quotient = static_cast<__int128>(q);
+  return true;
+}
+
+// Divides 'x' by 10^9 in place and returns the remainder. The division is
+// done in 32-bit steps so that the compiler can turn each of them into a
+// multiplication by the reciprocal of the constant.
+inline uint32_t DivModBy1e9(unsigned __int128* x) {
+  constexpr uint32_t kBillion = 1000000000;
+  const uint64_t hi = static_cast<uint64_t>(*x >> kBitsPerUint64);
+  const uint64_t lo = static_cast<uint64_t>(*x);
+  uint64_t t = hi >> kBitsPerUint32;
+  const uint64_t q3 = t / kBillion;
+  t = ((t % kBillion) << kBitsPerUint32) | (hi & 0xffffffff);
+  const uint64_t q2 = t / kBillion;
+  t = ((t % kBillion) << kBitsPerUint32) | (lo >> kBitsPerUint32);
+  const uint64_t q1 = t / kBillion;
+  t = ((t % kBillion) << kBitsPerUint32) | (lo & 0xffffffff);
+  const uint64_t q0 = t / kBillion;
+  *x = (static_cast<unsigned __int128>((q3 << kBitsPerUint32) | q2)
+        << kBitsPerUint64) |
+       ((q1 << kBitsPerUint32) | q0);
+  return static_cast<uint32_t>(t % kBillion);
+}
+
+// Pairs of decimal digits "00" to "99".
+constexpr char kTwoDigits[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// Writes exactly 9 decimal digits of 'x' < 10^9, with leading zeroes, to
+// 'out' and returns the position after the last digit.
+inline char* Write9Digits(uint32_t x, char* out) {
+  for (int i = 7; i > 0; i -= 2) {
+    memcpy(out + i, &kTwoDigits[2 * (x % 100)], 2);
+    x /= 100;
+  }
+  out[0] = static_cast<char>('0' + x);
+  return out + 9;
+}
+
+// Writes the decimal digits of 'x' < 10^9 without leading zeroes (a single
+// '0' for zero) to 'out' and returns the position after the last digit.
+inline char* WriteDigits(uint32_t x, char* out) {
+  char digits[9];
+  Write9Digits(x, digits);
+  int num_leading_zeroes = 0;
+  while (num_leading_zeroes < 8 && digits[num_leading_zeroes] == '0') {
+    ++num_leading_zeroes;
+  }
+  memcpy(out, digits + num_leading_zeroes, 9 - num_leading_zeroes);
+  return out + 9 - num_leading_zeroes;
+}
+
+// Parses 'str' of the form [-]DIGITS[.DIGITS] with at most kMaxIntegerDigits
+// integer digits and at most kMaxFractionalDigits fractional digits into the
+// packed NUMERIC value. Such input is always in range and needs no rounding.
+// Returns false for any other input, which is left to the general parser.
+inline bool ParsePlainDecimal(absl::string_view str, __int128* packed) {
+  constexpr uint64_t kPowersOfTen[] = {1,
+                                       10,
+                                       100,
+                                       1000,
+                                       10000,
+                                       100000,
+                                       1000000,
+                                       10000000,
+                                       100000000,
+                                       1000000000,
+                                       10000000000,
+                                       100000000000,
+                                       1000000000000,
+                                       10000000000000,
+                                       100000000000000,
+                                       1000000000000000,
+                                       10000000000000000,
+                                       100000000000000000,
+                                       1000000000000000000};
+  // Number of digits accumulated in a uint64_t before they are folded into
+  // the 128-bit value.
+  constexpr int kDigitsPerChunk = 18;
+
+  const char* c = str.data();
+  const char* const end = str.data() + str.size();
+  const bool negative = c < end && *c == '-';
+  if (negative) {
+    ++c;
+  }
+
+  const char* const int_start = c;
+  __int128 int_part = 0;
+  uint64_t chunk = 0;
+  int chunk_digits = 0;
+  for (; c < end && absl::ascii_isdigit(*c); ++c) {
+    chunk = chunk * 10 + (*c - '0');
+    if (++chunk_digits == kDigitsPerChunk) {
+      int_part = int_part * kPowersOfTen[kDigitsPerChunk] + chunk;
+      chunk = 0;
+      chunk_digits = 0;
+    }
+  }
+  const int64_t num_int_digits = c - int_start;
+  if (num_int_digits == 0 || num_int_digits > kMaxIntegerDigits) {
+    return false;
+  }
+  int_part = int_part * kPowersOfTen[chunk_digits] + chunk;
+
+  uint32_t fract_part = 0;
+  if (c < end) {
+    if (*c != '.') {
+      return false;
+    }
+    const char* const fract_start = ++c;
+    for (; c < end && absl::ascii_isdigit(*c); ++c) {
+      if (c - fract_start == kMaxFractionalDigits) {
+        return false;
+      }
+      fract_part = fract_part * 10 + (*c - '0');
+    }
+    const int64_t num_fract_digits = c - fract_start;
+    if (c != end || num_fract_digits == 0) {
+      return false;
+    }
+    fract_part *= kPowersOfTen[kMaxFractionalDigits - num_fract_digits];
+  }
+
+  const __int128 value = int_part * 1000000000 + fract_part;
+  *packed = negative ? -value : value;
+  return true;
+}
+
 }  // namespace
 
+constexpr int NumericValue::kMaxFormattedLength;
+
 zetasql_base::StatusOr<NumericValue> NumericValue::FromStringStrict(
     absl::string_view str) {
   return FromStringInternal(str, /*is_strict=*/true);
@@ -368,46 +567,45 @@ size_t NumericValue::HashCode() const {
 }
 
 std::string NumericValue::ToString() const {
-  const __int128 value = as_packed_int();
-  const __int128 abs_value = int128_abs(value);
+  char buf[kMaxFormattedLength];
+  return std::string(buf, FormatTo(buf));
+}
 
-  // First convert the integer part.
-  std::string ret;
-  for (__int128 int_part = abs_value / kScalingFactor;
-       int_part != 0; int_part /= 10) {
-    int digit = int_part % 10;
-    ret.append(1, digit + '0');
-  }
-  if (ret.empty()) {
-    ret = "0";
-  }
+void NumericValue::AppendToString(std::string* output) const {
+  char buf[kMaxFormattedLength];
+  output->append(buf, FormatTo(buf));
+}
+
+int NumericValue::FormatTo(char* buf) const {
+  const __int128 value = as_packed_int();
+  unsigned __int128 abs_value = int128_abs(value);
+  char* out = buf;
   if (value < 0) {
-    ret.append(1, '-');
+    *out++ = '-';
   }
-  std::reverse(ret.begin(), ret.end());
 
-  // And now convert the fractional part.
-  std::string fract_str;
-  for (__int128 fract_part = abs_value % kScalingFactor;
-       fract_part != 0; fract_part /= 10) {
-    int digit = fract_part % 10;
-    fract_str.append(1, digit + '0');
+  // Split the value into the fractional part and 9-digit chunks of the
+  // integer part. At most the leading chunk of 2 digits is left afterwards.
+  const uint32_t fract_part = DivModBy1e9(&abs_value);
+  uint32_t int_chunks[3];
+  int num_int_chunks = 0;
+  while (abs_value >= kScalingFactor) {
+    int_chunks[num_int_chunks++] = DivModBy1e9(&abs_value);
+  }
+  out = WriteDigits(static_cast<uint32_t>(abs_value), out);
+  while (num_int_chunks > 0) {
+    out = Write9Digits(int_chunks[--num_int_chunks], out);
   }
 
-  if (!fract_str.empty()) {
-    // Potentially add zeroes that will end up immediately after the decimal
-    // point.
-    if (fract_str.size() < kMaxFractionalDigits) {
-      fract_str.append(kMaxFractionalDigits - fract_str.size(), '0');
+  if (fract_part != 0) {
+    // Write all 9 fractional digits, then drop the trailing zeroes.
+    *out++ = '.';
+    out = Write9Digits(fract_part, out);
+    while (out[-1] == '0') {
+      --out;
     }
-    // Skip zeroes that will end up at the end of the fractional part.
-    auto idx = fract_str.find_first_not_of('0');
-    std::reverse(fract_str.begin() + idx, fract_str.end());
-    ret.append(1, '.');
-    ret.append(fract_str.substr(idx));
   }
-
-  return ret;
+  return static_cast<int>(out - buf);
 }
 
 // Parses a textual representation of a NUMERIC value. Returns an error if the
@@ -422,6 +620,11 @@ zetasql_base::StatusOr<NumericValue> NumericValue::FromStringInternal(
   // Max allowed value of the exponent part.
   const int kMaxNumericExponent = 65536;
 
+  __int128 packed;
+  if (ParsePlainDecimal(str, &packed)) {
+    return NumericValue(packed);
+  }
+
   if (str.empty()) {
     return MakeInvalidNumericError(str);
   }
@@ -858,20 +1061,26 @@ zetasql_base::StatusOr<NumericValue> NumericValue::DivideInternal(
                            << rh.ToString();
   }
 
-  Uint224 dividend(int128_abs(value));
-  Uint224 divisor(int128_abs(rh_value));
+  const unsigned __int128 a = int128_abs(value);
 
   // To preserve the scale of the result we need to multiply the dividend by the
-  // scaling factor first.
-  dividend.MultiplyByUint32(kScalingFactor);
-  dividend.Divide(divisor, round_away_from_zero);
-
-  auto to_int128_status = dividend.to_int128();
-  if (!to_int128_status.ok()) {
+  // scaling factor first. The product needs up to 158 bits.
+  const unsigned __int128 p0 =
+      static_cast<unsigned __int128>(static_cast<uint64_t>(a)) * kScalingFactor;
+  const unsigned __int128 p1 =
+      static_cast<unsigned __int128>(static_cast<uint64_t>(a >> 64)) *
+          kScalingFactor +
+      static_cast<uint64_t>(p0 >> 64);
+  const unsigned __int128 dividend_lo =
+      (p1 << 64) | static_cast<uint64_t>(p0);
+  const uint64_t dividend_hi = static_cast<uint64_t>(p1 >> 64);
+
+  __int128 res;
+  if (!DivideUint192(dividend_hi, dividend_lo, int128_abs(rh_value),
+                     round_away_from_zero, &res)) {
     return MakeEvalError() << "numeric overflow: " << ToString() << " / "
                            << rh.ToString();
   }
-  const __int128 res = to_int128_status.ValueOrDie();
   auto numeric_value_status = NumericValue::FromPackedInt(
       (sign_value * sign_rh_value) < 0 ? -res : res);
   if (!numeric_value_status.ok()) {
@@ -988,6 +1197,43 @@ void NumericValue::Aggregator::Add(NumericValue value) {
   }
 }
 
+void NumericValue::Aggregator::AddBatch(absl::Span<const NumericValue> values) {
+  // Each packed value is high * 2^64 + low with a signed 'high' and an unsigned
+  // 'low'. Summing the halves separately cannot overflow for fewer than 2^63
+  // values.
+  unsigned __int128 low_sum = 0;
+  __int128 high_sum = 0;
+  for (const NumericValue& value : values) {
+    low_sum += value.low_bits_;
+    high_sum += static_cast<int64_t>(value.high_bits_);
+  }
+  high_sum += static_cast<uint64_t>(low_sum >> kBitsPerUint64);
+
+  // The batch total is high_sum * 2^64 + low64. Split it into its lower 128
+  // bits and the remaining signed upper bits.
+  const unsigned __int128 batch_lower =
+      (static_cast<unsigned __int128>(high_sum) << kBitsPerUint64) |
+      static_cast<uint64_t>(low_sum);
+  int64_t batch_upper = static_cast<int64_t>(high_sum >> kBitsPerUint64);
+
+  // Add the current sum. sum_lower_ is signed, so its lower 128 bits are
+  // accompanied by an upper part of -1 when it is negative.
+  const unsigned __int128 lower =
+      batch_lower + static_cast<unsigned __int128>(sum_lower_);
+  batch_upper += sum_upper_ + (sum_lower_ < 0 ? -1 : 0) +
+                 (lower < batch_lower ? 1 : 0);
+
+  // Restore the representation used by Add(), where the total is
+  // sum_upper_ * 2^128 + sum_lower_ with a signed sum_lower_.
+  sum_lower_ = static_cast<__int128>(lower);
+  sum_upper_ = batch_upper + (sum_lower_ < 0 ? 1 : 0);
+}
+
+void NumericValue::Aggregator::Subtract(NumericValue value) {
+  // The NUMERIC range is symmetric, so the negation cannot overflow.
+  Add(NumericValue::UnaryMinus(value));
+}
+
 zetasql_base::StatusOr<NumericValue> NumericValue::Aggregator::GetSum() const {
   if (sum_upper_ != 0) {
     return MakeEvalError() << "numeric overflow: SUM";
@@ -1009,8 +1255,8 @@ NumericValue::Aggregator::GetAverage(uint64_t count) const {
     return MakeEvalError() << "division by zero: AVG";
   }
 
-  // The code below constructs an unsigned 196 bits of Uint224 from
-  // sum_upper_ and sum_lower_. The following cases need to be considered:
+  // The code below constructs an unsigned 192-bit dividend from sum_upper_
+  // and sum_lower_. The following cases need to be considered:
   // 1) If sum_upper_ is zero, the entire value (including the sign) comes
   //    from sum_lower_. We need to get abs(sum_lower_) because the division
   //    works on unsigned values.
@@ -1039,14 +1285,11 @@ NumericValue::Aggregator::GetAverage(uint64_t count) const {
       upper_abs--;
   }
 
-  Uint224 dividend(upper_abs, static_cast<unsigned __int128>(lower));
-  dividend.Divide(Uint224(count), /* round_away_from_zero */ true);
-
-  auto res_status = dividend.to_int128();
-  if (!res_status.ok()) {
+  __int128 res;
+  if (!DivideUint192(upper_abs, static_cast<unsigned __int128>(lower), count,
+                     /* round_away_from_zero */ true, &res)) {
     return MakeEvalError() << "numeric overflow: AVG";
   }
-  __int128 res = res_status.ValueOrDie();
   auto numeric_status = NumericValue::FromPackedInt(sign < 0 ? -res : res);
   if (!numeric_status.ok()) {
     return MakeEvalError() << "numeric overflow: AVG";
@@ -1075,8 +1318,46 @@ std::string NumericValue::Aggregator::SerializeAsProtoBytes() const {
   return res;
 }
 
+std::string NumericValue::Aggregator::SerializeAsCompactProtoBytes() const {
+  if (sum_upper_ != 0) {
+    return SerializeAsProtoBytes();
+  }
+
+  char bytes[kBytesPerInt128];
+  zetasql_base::LittleEndian::Store64(&bytes[0], static_cast<uint64_t>(sum_lower_));
+  zetasql_base::LittleEndian::Store64(
+      &bytes[kBytesPerInt64],
+      static_cast<uint64_t>(static_cast<unsigned __int128>(sum_lower_) >>
+                            kBitsPerUint64));
+  // Drop the most significant bytes that only repeat the sign.
+  int size = kBytesPerInt128;
+  while (size > 1) {
+    const char top = bytes[size - 1];
+    const bool next_is_negative = (bytes[size - 2] & 0x80) != 0;
+    if (top != (next_is_negative ? '\xff' : '\0')) {
+      break;
+    }
+    --size;
+  }
+  return std::string(bytes, size);
+}
+
 zetasql_base::StatusOr<NumericValue::Aggregator>
 NumericValue::Aggregator::DeserializeFromProtoBytes(absl::string_view bytes) {
+  if (!bytes.empty() && bytes.size() <= kBytesPerInt128) {
+    // The compact encoding of a sum that fits in 128 bits.
+    char extended[kBytesPerInt128];
+    memset(extended, (bytes[bytes.size() - 1] & 0x80) != 0 ? 0xff : 0,
+           kBytesPerInt128);
+    memcpy(extended, bytes.data(), bytes.size());
+    Aggregator res;
+    res.sum_lower_ = static_cast<__int128>(
+        (static_cast<unsigned __int128>(zetasql_base::LittleEndian::Load64(
+             &extended[kBytesPerInt64]))
+         << kBitsPerUint64) |
+        zetasql_base::LittleEndian::Load64(&extended[0]));
+    return res;
+  }
   if (bytes.size() != kBytesPerInt128 + kBytesPerInt64) {
     return MakeEvalError() << "Invalid NumericValue::Aggregator encoding";
   }
@@ -24,6 +24,7 @@
 
 #include <cstdint>
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "zetasql/base/status.h"
 #include "zetasql/base/statusor.h"
 
@@ -156,6 +157,18 @@ class NumericValue final {
   // "1.34", "123", "0.23".
   std::string ToString() const;
 
+  // Maximum number of characters produced by FormatTo(): a sign, 29 integer
+  // digits, the decimal point and 9 fractional digits.
+  static constexpr int kMaxFormattedLength = 40;
+
+  // Same as ToString() but appends the result to 'output'.
+  void AppendToString(std::string* output) const;
+
+  // Same as ToString() but writes the result to 'buf', which must have room
+  // for kMaxFormattedLength characters. Does not append a terminating null
+  // character. Returns the number of characters written.
+  int FormatTo(char* buf) const;
+
   // Returns the packed NUMERIC value.
   __int128 as_packed_int() const;
 
@@ -190,6 +203,14 @@ class NumericValue final {
    public:
     // Adds a NUMERIC value to the input.
     void Add(NumericValue value);
+    // Adds all the given NUMERIC values to the input. Equivalent to calling
+    // Add() for each value, but accumulates the low and the high 64-bit halves
+    // of the packed values separately and propagates the carries once at the
+    // end, so the loop has no data-dependent branches.
+    void AddBatch(absl::Span<const NumericValue> values);
+    // Removes a NUMERIC value that was added to the input, e.g. when it
+    // leaves a sliding window.
+    void Subtract(NumericValue value);
     // Returns sum of all input values. Returns OUT_OF_RANGE error on overflow.
     zetasql_base::StatusOr<NumericValue> GetSum() const;
     // Returns sum of all input values divided by the specified divisor.
@@ -206,6 +227,12 @@ class NumericValue final {
     // sum_lower and sum_upper fields are written as integers in binary little
     // endian mode - 16 bytes of sum_lower followed by 8 bytes of sum_upper.
     std::string SerializeAsProtoBytes() const;
+    // Same as SerializeAsProtoBytes(), except that a sum that fits in 128 bits
+    // (sum_upper is zero) is written as sum_lower alone in the minimal number
+    // of two's complement little endian bytes (1 to 16). This is the common
+    // case for partial aggregates that are exchanged between workers.
+    // DeserializeFromProtoBytes accepts both encodings.
+    std::string SerializeAsCompactProtoBytes() const;
     static zetasql_base::StatusOr<Aggregator> DeserializeFromProtoBytes(
         absl::string_view bytes);
 
@@ -221,6 +248,8 @@ class NumericValue final {
   };
 
  private:
+  friend class Value;  // Stores small NUMERIC values inline.
+
   NumericValue(uint64_t high_bits, uint64_t low_bits);
   explicit constexpr NumericValue(__int128 value);
 
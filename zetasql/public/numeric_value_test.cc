@@ -29,6 +29,7 @@
 #include "absl/numeric/int128.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/substitute.h"
+#include "absl/types/span.h"
 #include "zetasql/base/endian.h"
 #include "zetasql/base/canonical_errors.h"
 #include "zetasql/base/status_macros.h"
@@ -71,6 +72,15 @@ class NumericValueTest : public testing::Test {
     NumericValue deserialized_average =
         deserialized_aggregator.GetAverage(values.size()).ValueOrDie();
     EXPECT_EQ(original_average, deserialized_average);
+
+    std::string compact_bytes = aggregator.SerializeAsCompactProtoBytes();
+    EXPECT_LE(compact_bytes.size(), bytes.size());
+    NumericValue::Aggregator compact_aggregator =
+        NumericValue::Aggregator::DeserializeFromProtoBytes(compact_bytes)
+            .ValueOrDie();
+    EXPECT_EQ(original_average,
+              compact_aggregator.GetAverage(values.size()).ValueOrDie());
+    EXPECT_EQ(bytes, compact_aggregator.SerializeAsProtoBytes());
   }
 
   // Expected min and max numeric values. The max values consists of 29 '9's,
@@ -175,6 +185,34 @@ TEST_F(NumericValueTest, ToString) {
             NumericValue(std::numeric_limits<uint64_t>::max()).ToString());
 }
 
+TEST_F(NumericValueTest, AppendToStringAndFormatTo) {
+  const std::vector<NumericValue> values = {
+      NumericValue(),
+      NumericValue::MaxValue(),
+      NumericValue::MinValue(),
+      NumericValue::FromPackedInt(1).ValueOrDie(),
+      NumericValue(-1000000000),
+      MkNumeric("123456789.123456789"),
+      MkNumeric("-1000000000000000000.5"),
+      NumericValue(std::numeric_limits<uint64_t>::max()),
+  };
+  std::string appended = "prefix";
+  std::string expected = "prefix";
+  for (NumericValue value : values) {
+    value.AppendToString(&appended);
+    expected.append(value.ToString());
+
+    char buf[NumericValue::kMaxFormattedLength];
+    const int length = value.FormatTo(buf);
+    EXPECT_EQ(value.ToString(), std::string(buf, length));
+  }
+  EXPECT_EQ(expected, appended);
+
+  char buf[NumericValue::kMaxFormattedLength];
+  EXPECT_EQ(NumericValue::kMaxFormattedLength,
+            NumericValue::MinValue().FormatTo(buf));
+}
+
 TEST_F(NumericValueTest, FromString) {
   using FromStringFunc =
       std::function<zetasql_base::StatusOr<NumericValue>(absl::string_view)>;
@@ -1063,6 +1101,33 @@ TEST_F(NumericValueTest, Divide) {
 #undef NUM_DIVIDE
 }
 
+TEST_F(NumericValueTest, Divide_WideOperands) {
+#define NUM_DIVIDE(x, y) x.Divide(y).ValueOrDie()
+
+  // The scaled dividend fits in 128 bits only below 2^128 / 10^18.
+  EXPECT_EQ(MkNumeric("48611766702991209066.19637249"),
+            NUM_DIVIDE(MkNumeric("340282366920938463463.374607431"),
+                       NumericValue(7)));
+  EXPECT_EQ(MkNumeric("48611766702991209066.19637249"),
+            NUM_DIVIDE(MkNumeric("340282366920938463463.374607432"),
+                       NumericValue(7)));
+  EXPECT_EQ(MkNumeric("18446744073.709551615"),
+            NUM_DIVIDE(MkNumeric("340282366920938463463.374607432"),
+                       MkNumeric("18446744073.709551617")));
+  // Packed divisors of 2^64 - 1 and 2^64.
+  EXPECT_EQ(MkNumeric("5421010862427522170.331137592"),
+            NUM_DIVIDE(NumericValue::MaxValue(),
+                       MkNumeric("18446744073.709551615")));
+  EXPECT_EQ(MkNumeric("-5421010862427522170.037264004"),
+            NUM_DIVIDE(NumericValue::MinValue(),
+                       MkNumeric("18446744073.709551616")));
+  EXPECT_EQ(MkNumeric("-124999998.8609375"),
+            NUM_DIVIDE(MkNumeric("-12345678901234567890.123456789"),
+                       MkNumeric("98765432109.876543211")));
+
+#undef NUM_DIVIDE
+}
+
 TEST_F(NumericValueTest, Power) {
 #define NUM_POW(x, exp) x.Power(exp).ValueOrDie()
 
@@ -1233,6 +1298,24 @@ TEST_F(NumericValueTest, AggregatorMultipleValues) {
             a3.GetAverage(kCount).ValueOrDie());
 }
 
+TEST_F(NumericValueTest, AggregatorSubtract) {
+  NumericValue::Aggregator a1;
+  a1.Add(NumericValue::MaxValue());
+  a1.Add(NumericValue::MaxValue());
+  a1.Add(NumericValue(5));
+  EXPECT_FALSE(a1.GetSum().ok());
+  a1.Subtract(NumericValue::MaxValue());
+  EXPECT_FALSE(a1.GetSum().ok());
+  a1.Subtract(NumericValue::MaxValue());
+  ASSERT_EQ(NumericValue(5), a1.GetSum().ValueOrDie());
+
+  NumericValue::Aggregator a2;
+  a2.Add(NumericValue::MinValue());
+  a2.Add(NumericValue(-1));
+  a2.Subtract(NumericValue::MinValue());
+  ASSERT_EQ(NumericValue(-1), a2.GetSum().ValueOrDie());
+}
+
 TEST_F(NumericValueTest, AggregatorAverageRounding) {
   // 1/3 - rounding down.
   NumericValue::Aggregator a1;
@@ -1434,6 +1517,74 @@ TEST_F(NumericValueTest, AggregatorMergeWith) {
   }
 }
 
+TEST_F(NumericValueTest, AggregatorAddBatch) {
+  std::vector<NumericValue> values = {
+    NumericValue(0),
+    NumericValue(1),
+    NumericValue::MaxValue(),
+    MkNumeric("-123.01"),
+    NumericValue::MinValue(),
+    NumericValue::MinValue(),
+    NumericValue::MinValue(),
+    NumericValue::MaxValue(),
+    NumericValue::MaxValue(),
+    NumericValue::MaxValue(),
+    MkNumeric("56.999999999")
+  };
+
+  // Tests every split of the input into values added one at a time followed
+  // by a batch, against adding all of them one at a time.
+  for (int num_values = 0; num_values <= values.size(); num_values++) {
+    NumericValue::Aggregator control;
+    for (int i = 0; i < num_values; i++) {
+      control.Add(values[i]);
+    }
+    for (int num_single = 0; num_single <= num_values; num_single++) {
+      NumericValue::Aggregator test;
+      for (int i = 0; i < num_single; i++) {
+        test.Add(values[i]);
+      }
+      test.AddBatch(absl::MakeConstSpan(values).subspan(
+          num_single, num_values - num_single));
+      EXPECT_EQ(control.SerializeAsProtoBytes(), test.SerializeAsProtoBytes())
+          << num_values << " " << num_single;
+    }
+  }
+
+  std::vector<NumericValue> min_values(1000, NumericValue::MinValue());
+  NumericValue::Aggregator a1;
+  a1.AddBatch(min_values);
+  EXPECT_THAT(a1.GetSum(),
+              StatusIs(zetasql_base::OUT_OF_RANGE, "numeric overflow: SUM"));
+  EXPECT_EQ(NumericValue::MinValue(), a1.GetAverage(1000).ValueOrDie());
+}
+
+TEST_F(NumericValueTest, AggregatorCompactSerialization) {
+  NumericValue::Aggregator a1;
+  EXPECT_EQ(1, a1.SerializeAsCompactProtoBytes().size());
+  a1.Add(MkNumeric("0.000000127"));
+  EXPECT_EQ(1, a1.SerializeAsCompactProtoBytes().size());
+  a1.Add(MkNumeric("0.000000001"));
+  EXPECT_EQ(2, a1.SerializeAsCompactProtoBytes().size());
+  a1.Add(MkNumeric("-0.000000256"));
+  EXPECT_EQ(1, a1.SerializeAsCompactProtoBytes().size());
+
+  // A sum that overflows 128 bits requires the full encoding.
+  NumericValue::Aggregator a2;
+  for (int i = 0; i < 3; i++) {
+    a2.Add(NumericValue::MaxValue());
+  }
+  EXPECT_EQ(24, a2.SerializeAsCompactProtoBytes().size());
+
+  EXPECT_THAT(NumericValue::Aggregator::DeserializeFromProtoBytes(""),
+              StatusIs(zetasql_base::OUT_OF_RANGE,
+                       "Invalid NumericValue::Aggregator encoding"));
+  EXPECT_THAT(NumericValue::Aggregator::DeserializeFromProtoBytes(
+                  std::string(17, '\0')),
+              StatusIs(zetasql_base::OUT_OF_RANGE,
+                       "Invalid NumericValue::Aggregator encoding"));
+}
+
 TEST_F(NumericValueTest, HasFractionalPart) {
   const std::vector<std::pair<NumericValue, /*has_fractional_part*/ bool>>
       test_cases = {
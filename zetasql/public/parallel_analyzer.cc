@@ -0,0 +1,471 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/parallel_analyzer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "zetasql/common/errors.h"
+#include "zetasql/parser/parse_tree.h"
+#include "zetasql/parser/parse_tree_errors.h"
+#include "zetasql/parser/parser.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/parse_resume_location.h"
+#include "zetasql/public/sql_function.h"
+#include "zetasql/public/sql_tvf.h"
+#include "zetasql/public/statement_splitter.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/status.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+zetasql_base::Status SplitStatements(absl::string_view sql,
+                             std::vector<int>* statement_offsets) {
+  statement_offsets->clear();
+  std::vector<SplitStatement> statements;
+  ZETASQL_RETURN_IF_ERROR(StatementSplitter::Split(sql, &statements));
+  // Each statement starts where the previous one ended, so that whitespace
+  // and comments before it are included, as AnalyzeNextStatement() expects.
+  int start = 0;
+  for (const SplitStatement& statement : statements) {
+    statement_offsets->push_back(start);
+    start = statement.end;
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+namespace {
+
+// Calls <analyze> on every index in [0, num_items), in increasing order of
+// index, from up to <num_threads> threads.  Each thread copies <options>
+// once and passes the copy to all its calls, with a new IdStringPool and
+// arena for each call, since those belong to the AnalyzerOutput and neither
+// is thread-safe.
+void AnalyzeEachInParallel(
+    int num_items, const AnalyzerOptions& options, int num_threads,
+    const std::function<void(int index, const AnalyzerOptions& options)>&
+        analyze) {
+  std::atomic<int> next_index(0);
+  auto worker = [&]() {
+    AnalyzerOptions thread_options = options;
+    while (true) {
+      const int index = next_index.fetch_add(1);
+      if (index >= num_items) return;
+      thread_options.set_arena(nullptr);
+      thread_options.set_id_string_pool(nullptr);
+      thread_options.CreateDefaultArenasIfNotSet();
+      analyze(index, thread_options);
+    }
+  };
+
+  num_threads = std::min(num_threads, num_items);
+  if (num_threads <= 1) {
+    worker();
+  } else {
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads);
+    for (int i = 0; i < num_threads; ++i) {
+      threads.emplace_back(worker);
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+  }
+}
+
+}  // namespace
+
+zetasql_base::Status AnalyzeStatementsInParallel(
+    absl::string_view sql, const AnalyzerOptions& options, Catalog* catalog,
+    TypeFactory* type_factory, int num_threads,
+    std::vector<std::unique_ptr<const AnalyzerOutput>>* outputs) {
+  std::vector<int> statement_offsets;
+  ZETASQL_RETURN_IF_ERROR(SplitStatements(sql, &statement_offsets));
+  const int num_statements = static_cast<int>(statement_offsets.size());
+
+  outputs->clear();
+  outputs->resize(num_statements);
+  std::vector<zetasql_base::Status> statuses(num_statements);
+
+  // Once a statement fails, statements after it are skipped, since only the
+  // first error is returned.
+  std::atomic<int> first_error(num_statements);
+  AnalyzeEachInParallel(
+      num_statements, options, num_threads,
+      [&](int index, const AnalyzerOptions& statement_options) {
+        if (index > first_error.load()) return;
+        ParseResumeLocation resume_location =
+            ParseResumeLocation::FromStringView(sql);
+        resume_location.set_byte_position(statement_offsets[index]);
+        bool at_end_of_input;
+        statuses[index] =
+            AnalyzeNextStatement(&resume_location, statement_options, catalog,
+                                 type_factory, &(*outputs)[index],
+                                 &at_end_of_input);
+        if (!statuses[index].ok()) {
+          int current = first_error.load();
+          while (index < current &&
+                 !first_error.compare_exchange_weak(current, index)) {
+          }
+        }
+      });
+
+  if (first_error.load() < num_statements) {
+    return statuses[first_error.load()];
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+void AnalyzeStatements(
+    absl::Span<const absl::string_view> statements,
+    const AnalyzerOptions& options, Catalog* catalog, TypeFactory* type_factory,
+    int num_threads,
+    std::vector<std::unique_ptr<const AnalyzerOutput>>* outputs,
+    std::vector<zetasql_base::Status>* statuses) {
+  const int num_statements = static_cast<int>(statements.size());
+  outputs->clear();
+  outputs->resize(num_statements);
+  statuses->clear();
+  statuses->resize(num_statements);
+  AnalyzeEachInParallel(
+      num_statements, options, num_threads,
+      [&](int index, const AnalyzerOptions& statement_options) {
+        (*statuses)[index] =
+            AnalyzeStatement(statements[index], statement_options, catalog,
+                             type_factory, &(*outputs)[index]);
+      });
+}
+
+namespace {
+
+// Creates the functions defined in a script, analyzing each statement once
+// the functions it calls exist.  See AddSQLFunctionsInParallel().
+class ParallelFunctionCreator {
+ public:
+  ParallelFunctionCreator(absl::string_view sql, const AnalyzerOptions& options,
+                          SimpleCatalog* catalog, TypeFactory* type_factory)
+      : sql_(sql),
+        options_(options),
+        catalog_(catalog),
+        type_factory_(type_factory) {}
+  ParallelFunctionCreator(const ParallelFunctionCreator&) = delete;
+  ParallelFunctionCreator& operator=(const ParallelFunctionCreator&) = delete;
+
+  zetasql_base::Status Run(
+      int num_threads,
+      std::vector<std::unique_ptr<const AnalyzerOutput>>* outputs) {
+    ZETASQL_RETURN_IF_ERROR(ParseStatements());
+    ZETASQL_RETURN_IF_ERROR(FindDependencies());
+    const int num_statements = static_cast<int>(statements_.size());
+    outputs_ = outputs;
+    outputs_->clear();
+    outputs_->resize(num_statements);
+
+    num_threads = std::min(num_threads, num_statements);
+    if (num_threads <= 1) {
+      Work();
+    } else {
+      std::vector<std::thread> threads;
+      threads.reserve(num_threads);
+      for (int i = 0; i < num_threads; ++i) {
+        threads.emplace_back(&ParallelFunctionCreator::Work, this);
+      }
+      for (std::thread& thread : threads) {
+        thread.join();
+      }
+    }
+
+    for (const Statement& statement : statements_) {
+      ZETASQL_RETURN_IF_ERROR(statement.status);
+    }
+    for (int i = 0; i < num_statements; ++i) {
+      if (!statements_[i].analyzed) return MakeCycleError(i);
+    }
+    return ::zetasql_base::OkStatus();
+  }
+
+ private:
+  struct Statement {
+    std::unique_ptr<ParserOutput> parser_output;
+    const ASTCreateFunctionStmtBase* ast = nullptr;
+    bool is_table_function = false;
+    // The name as written, and in lower case.
+    std::string name;
+    std::string lower_name;
+    // Indexes of distinct statements defining functions that this one calls,
+    // and of those that call the function this one defines.
+    std::vector<int> dependencies;
+    std::vector<int> dependents;
+    // Dependencies that have not been added to the catalog yet.
+    int num_pending_dependencies = 0;
+    bool analyzed = false;
+    zetasql_base::Status status;
+  };
+
+  // Returns <status> with its location converted for the caller.
+  zetasql_base::Status ConvertError(const zetasql_base::Status& status) const {
+    return ConvertInternalErrorLocationAndAdjustErrorString(
+        options_.error_message_mode(), sql_, status);
+  }
+
+  zetasql_base::Status ParseStatements() {
+    std::vector<int> statement_offsets;
+    ZETASQL_RETURN_IF_ERROR(SplitStatements(sql_, &statement_offsets));
+    statements_.resize(statement_offsets.size());
+    for (int i = 0; i < statements_.size(); ++i) {
+      Statement& statement = statements_[i];
+      ParseResumeLocation resume_location =
+          ParseResumeLocation::FromStringView(sql_);
+      resume_location.set_byte_position(statement_offsets[i]);
+      bool at_end_of_input;
+      ZETASQL_RETURN_IF_ERROR(ConvertError(
+          ParseNextStatement(&resume_location, ParserOptions(),
+                             &statement.parser_output, &at_end_of_input)));
+      const ASTStatement* ast = statement.parser_output->statement();
+      if (ast->node_kind() != AST_CREATE_FUNCTION_STATEMENT &&
+          ast->node_kind() != AST_CREATE_TABLE_FUNCTION_STATEMENT) {
+        return ConvertError(
+            MakeSqlErrorAt(ast)
+            << "Only CREATE FUNCTION and CREATE TABLE FUNCTION statements "
+               "are supported when adding SQL functions to a catalog");
+      }
+      statement.ast = static_cast<const ASTCreateFunctionStmtBase*>(ast);
+      statement.is_table_function =
+          ast->node_kind() == AST_CREATE_TABLE_FUNCTION_STATEMENT;
+      const ASTPathExpression* name =
+          statement.ast->function_declaration()->name();
+      if (name->num_names() != 1) {
+        return ConvertError(MakeSqlErrorAt(name)
+                            << "Function names with more than one part are "
+                               "not supported when adding SQL functions to "
+                               "a catalog");
+      }
+      statement.name = name->first_name()->GetAsString();
+      statement.lower_name = absl::AsciiStrToLower(statement.name);
+    }
+    return ::zetasql_base::OkStatus();
+  }
+
+  zetasql_base::Status FindDependencies() {
+    // Scalar and table functions have separate namespaces.
+    absl::flat_hash_map<std::string, int> functions;
+    absl::flat_hash_map<std::string, int> table_functions;
+    for (int i = 0; i < statements_.size(); ++i) {
+      const Statement& statement = statements_[i];
+      auto& defined =
+          statement.is_table_function ? table_functions : functions;
+      if (!defined.emplace(statement.lower_name, i).second) {
+        return ConvertError(MakeSqlErrorAt(statement.ast)
+                            << "Function " << statement.name
+                            << " is defined more than once");
+      }
+    }
+    absl::MutexLock l(&mutex_);
+    for (int i = 0; i < statements_.size(); ++i) {
+      Statement& statement = statements_[i];
+      std::vector<const ASTNode*> calls;
+      statement.ast->GetDescendantsWithKinds({AST_FUNCTION_CALL, AST_TVF},
+                                             &calls);
+      std::set<int> dependencies;
+      for (const ASTNode* call : calls) {
+        const bool is_tvf = call->node_kind() == AST_TVF;
+        const ASTPathExpression* path =
+            is_tvf ? call->GetAsOrDie<ASTTVF>()->name()
+                   : call->GetAsOrDie<ASTFunctionCall>()->function();
+        if (path->num_names() != 1) continue;
+        const auto& defined = is_tvf ? table_functions : functions;
+        const auto it = defined.find(
+            absl::AsciiStrToLower(path->first_name()->GetAsString()));
+        if (it != defined.end()) dependencies.insert(it->second);
+      }
+      statement.dependencies.assign(dependencies.begin(), dependencies.end());
+      statement.num_pending_dependencies =
+          static_cast<int>(dependencies.size());
+      for (const int dependency : dependencies) {
+        statements_[dependency].dependents.push_back(i);
+      }
+      if (dependencies.empty()) ready_.insert(i);
+    }
+    return ::zetasql_base::OkStatus();
+  }
+
+  // Analyzes ready statements until no statement is ready or running.
+  void Work() LOCKS_EXCLUDED(mutex_) {
+    mutex_.Lock();
+    while (true) {
+      mutex_.Await(absl::Condition(this, &ParallelFunctionCreator::HasWork));
+      if (ready_.empty()) break;
+      // Statements are started in script order when possible, so that the
+      // first error is found early.
+      const int index = *ready_.begin();
+      ready_.erase(ready_.begin());
+      ++num_running_;
+      mutex_.Unlock();
+      const zetasql_base::Status status = AnalyzeAndAdd(index);
+      mutex_.Lock();
+      --num_running_;
+      Statement& statement = statements_[index];
+      statement.analyzed = true;
+      statement.status = status;
+      if (!status.ok()) continue;
+      for (const int dependent : statement.dependents) {
+        if (--statements_[dependent].num_pending_dependencies == 0) {
+          ready_.insert(dependent);
+        }
+      }
+    }
+    mutex_.Unlock();
+  }
+
+  bool HasWork() const EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return !ready_.empty() || num_running_ == 0;
+  }
+
+  zetasql_base::Status AnalyzeAndAdd(int index) {
+    Statement& statement = statements_[index];
+    std::unique_ptr<const AnalyzerOutput>& output = (*outputs_)[index];
+    // Each statement gets its own IdStringPool and arena, from its parser
+    // output, since neither is thread-safe.
+    AnalyzerOptions statement_options = options_;
+    statement_options.set_arena(nullptr);
+    statement_options.set_id_string_pool(nullptr);
+    ZETASQL_RETURN_IF_ERROR(AnalyzeStatementFromParserOutputOwnedOnSuccess(
+        &statement.parser_output, statement_options, sql_, catalog_,
+        type_factory_, &output));
+    const ResolvedStatement* resolved = output->resolved_statement();
+
+    if (statement.is_table_function) {
+      ZETASQL_RET_CHECK_EQ(RESOLVED_CREATE_TABLE_FUNCTION_STMT,
+                   resolved->node_kind());
+      std::unique_ptr<SQLTableValuedFunction> sql_tvf;
+      const zetasql_base::Status status = SQLTableValuedFunction::Create(
+          resolved->GetAs<ResolvedCreateTableFunctionStmt>(), &sql_tvf);
+      if (!status.ok()) {
+        return ConvertError(MakeSqlErrorAt(statement.ast) << status.message());
+      }
+      std::unique_ptr<TableValuedFunction> tvf = std::move(sql_tvf);
+      if (!catalog_->AddOwnedTableValuedFunctionIfNotPresent(statement.name,
+                                                             &tvf)) {
+        return ConvertError(MakeSqlErrorAt(statement.ast)
+                            << "Table function " << statement.name
+                            << " already exists");
+      }
+      return ::zetasql_base::OkStatus();
+    }
+
+    ZETASQL_RET_CHECK_EQ(RESOLVED_CREATE_FUNCTION_STMT, resolved->node_kind());
+    const auto* create = resolved->GetAs<ResolvedCreateFunctionStmt>();
+    if (create->function_expression() == nullptr) {
+      return ConvertError(MakeSqlErrorAt(statement.ast)
+                          << "Only non-templated SQL functions are supported "
+                             "when adding SQL functions to a catalog");
+    }
+    std::unique_ptr<SQLFunction> sql_function;
+    ZETASQL_RETURN_IF_ERROR(SQLFunction::Create(
+        statement.name,
+        create->is_aggregate() ? Function::AGGREGATE : Function::SCALAR,
+        {create->signature()}, FunctionOptions(),
+        create->function_expression(), create->argument_name_list(),
+        create->is_aggregate() ? &create->aggregate_expression_list()
+                               : nullptr,
+        /*parse_resume_location=*/absl::nullopt, &sql_function));
+    std::unique_ptr<Function> function = std::move(sql_function);
+    if (!catalog_->AddOwnedFunctionIfNotPresent(statement.name, &function)) {
+      return ConvertError(MakeSqlErrorAt(statement.ast)
+                          << "Function " << statement.name
+                          << " already exists");
+    }
+    return ::zetasql_base::OkStatus();
+  }
+
+  // Returns the error for statement <index>, which was not analyzed because
+  // it depends on a cycle of functions.  Follows dependencies that were not
+  // analyzed either until one repeats, and reports that cycle.
+  zetasql_base::Status MakeCycleError(int index) const {
+    std::vector<int> path;
+    std::vector<int> position(statements_.size(), -1);
+    while (position[index] < 0) {
+      position[index] = static_cast<int>(path.size());
+      path.push_back(index);
+      for (const int dependency : statements_[index].dependencies) {
+        if (!statements_[dependency].analyzed) {
+          index = dependency;
+          break;
+        }
+      }
+    }
+    const std::vector<int> cycle(path.begin() + position[index], path.end());
+    const Statement& statement = statements_[cycle[0]];
+    const char* object_type =
+        statement.is_table_function ? "table function" : "function";
+    if (cycle.size() == 1) {
+      return ConvertError(MakeSqlErrorAt(statement.ast)
+                          << "The " << object_type << " " << statement.name
+                          << " is recursive");
+    }
+    std::vector<std::string> names;
+    for (const int i : cycle) names.push_back(statements_[i].name);
+    names.push_back(statement.name);
+    return ConvertError(MakeSqlErrorAt(statement.ast)
+                        << "Recursive dependencies detected when resolving "
+                        << object_type << " " << statement.name
+                        << ", which include objects ("
+                        << absl::StrJoin(names, ", ") << ")");
+  }
+
+  const absl::string_view sql_;
+  const AnalyzerOptions& options_;
+  SimpleCatalog* const catalog_;
+  TypeFactory* const type_factory_;
+  std::vector<std::unique_ptr<const AnalyzerOutput>>* outputs_ = nullptr;
+
+  // After FindDependencies(), <num_pending_dependencies>, <analyzed> and
+  // <status> only change while <mutex_> is held.
+  std::vector<Statement> statements_;
+
+  absl::Mutex mutex_;
+  // Statements whose dependencies have all been added to the catalog.
+  std::set<int> ready_ GUARDED_BY(mutex_);
+  int num_running_ GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace
+
+zetasql_base::Status AddSQLFunctionsInParallel(
+    absl::string_view sql, const AnalyzerOptions& options,
+    SimpleCatalog* catalog, TypeFactory* type_factory, int num_threads,
+    std::vector<std::unique_ptr<const AnalyzerOutput>>* outputs) {
+  ParallelFunctionCreator creator(sql, options, catalog, type_factory);
+  return creator.Run(num_threads, outputs);
+}
+
+}  // namespace zetasql
@@ -0,0 +1,109 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PUBLIC_PARALLEL_ANALYZER_H_
+#define ZETASQL_PUBLIC_PARALLEL_ANALYZER_H_
+
+#include <memory>
+#include <vector>
+
+#include "zetasql/public/analyzer.h"
+#include "zetasql/public/catalog.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+
+// Splits <sql> into its semicolon-separated statements and returns the
+// byte offset of the start of each one in <*statement_offsets>.  Splitting
+// uses the tokenizer only, so quoted strings, identifiers and comments
+// containing ";" are handled correctly, but the statements themselves are
+// not parsed.  Trailing whitespace and comments after the last ";" do not
+// produce a statement.  Returns an error if <sql> cannot be tokenized.
+zetasql_base::Status SplitStatements(absl::string_view sql,
+                             std::vector<int>* statement_offsets);
+
+// Analyzes each statement in the multi-statement std::string <sql>, using up to
+// <num_threads> threads.  On success, <*outputs> has one AnalyzerOutput per
+// statement, in the order the statements appear in <sql>.  This produces the
+// same results as calling AnalyzeNextStatement() in a loop.
+//
+// Each statement is analyzed with its own IdStringPool and arena; any
+// arena or IdStringPool set in <options> is not used.  <catalog> and
+// <type_factory> are shared between threads, so <catalog> must support
+// concurrent lookups, as SimpleCatalog does.
+//
+// The analyzer does not apply DDL to the catalog, so statements never
+// depend on earlier statements in the script and can be analyzed in any
+// order.  Callers that apply DDL as they go must analyze sequentially.
+//
+// If any statement fails, returns the error of the first failing statement
+// in script order, and <*outputs> is unspecified.  Statements after a
+// failing statement may not be analyzed.
+zetasql_base::Status AnalyzeStatementsInParallel(
+    absl::string_view sql, const AnalyzerOptions& options, Catalog* catalog,
+    TypeFactory* type_factory, int num_threads,
+    std::vector<std::unique_ptr<const AnalyzerOutput>>* outputs);
+
+// Analyzes each of the single-statement strings <statements>, such as a log
+// of queries to replay, using up to <num_threads> threads.  <*outputs> and
+// <*statuses> get one entry per statement, in the order of <statements>,
+// with the result AnalyzeStatement() would give.  The output of a failing
+// statement is NULL, and failures do not stop the other statements.
+//
+// As in AnalyzeStatementsInParallel(), each statement gets its own
+// IdStringPool and arena, and <catalog> and <type_factory> are shared.
+void AnalyzeStatements(
+    absl::Span<const absl::string_view> statements,
+    const AnalyzerOptions& options, Catalog* catalog, TypeFactory* type_factory,
+    int num_threads,
+    std::vector<std::unique_ptr<const AnalyzerOutput>>* outputs,
+    std::vector<zetasql_base::Status>* statuses);
+
+// Analyzes the CREATE FUNCTION and CREATE TABLE FUNCTION statements in the
+// script <sql>, using up to <num_threads> threads, and adds the SQLFunctions
+// and SQLTableValuedFunctions they define to <catalog>.
+// This can be used to warm up a catalog of SQL-defined functions at startup
+// rather than create them one by one.
+//
+// Function bodies may call functions defined anywhere in <sql>.  Each
+// statement is analyzed once the functions its body calls have been added,
+// so independent functions are analyzed concurrently.  Calls are found from
+// the parse trees, by name, before analysis.  Functions that depend on each
+// other in a cycle are reported as recursive, like CycleDetector does.
+//
+// Only non-templated SQL functions with single-part names are supported.
+// Each statement is analyzed with its own IdStringPool and arena, as in
+// AnalyzeStatementsInParallel(), and <options> must support the statements.
+// The added functions refer to the resolved statements, so <*outputs>,
+// which has one AnalyzerOutput per statement in script order, must outlive
+// <catalog>.  <catalog> must not already define any of the functions.
+//
+// If any statement fails, returns the error of the first failing statement
+// in script order.  Statements that do not depend on a failing one are still
+// analyzed and added, so the result does not depend on timing, and
+// <*outputs> keeps their outputs; the other outputs are NULL.
+zetasql_base::Status AddSQLFunctionsInParallel(
+    absl::string_view sql, const AnalyzerOptions& options,
+    SimpleCatalog* catalog, TypeFactory* type_factory, int num_threads,
+    std::vector<std::unique_ptr<const AnalyzerOutput>>* outputs);
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_PARALLEL_ANALYZER_H_
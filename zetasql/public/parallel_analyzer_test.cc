@@ -0,0 +1,221 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/parallel_analyzer.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/analyzer.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/options.pb.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/sql_function.h"
+#include "zetasql/public/type.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+
+namespace zetasql {
+
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::zetasql_base::testing::StatusIs;
+
+TEST(SplitStatementsTest, Basic) {
+  std::vector<int> offsets;
+  ZETASQL_ASSERT_OK(SplitStatements("SELECT 1; SELECT ';' -- x;\n; SELECT 3;  ",
+                            &offsets));
+  EXPECT_THAT(offsets, ElementsAre(0, 9, 28));
+
+  ZETASQL_ASSERT_OK(SplitStatements("  /* nothing */ ", &offsets));
+  EXPECT_TRUE(offsets.empty());
+
+  EXPECT_FALSE(SplitStatements("SELECT 'abc", &offsets).ok());
+}
+
+class AnalyzeStatementsInParallelTest : public ::testing::Test {
+ protected:
+  AnalyzeStatementsInParallelTest() : catalog_("catalog", &type_factory_) {
+    catalog_.AddOwnedTable(
+        new SimpleTable("T", {{"key", type_factory_.get_int64()}}));
+  }
+
+  TypeFactory type_factory_;
+  SimpleCatalog catalog_;
+  AnalyzerOptions options_;
+};
+
+TEST_F(AnalyzeStatementsInParallelTest, ResultsAreInScriptOrder) {
+  std::string script;
+  for (int i = 0; i < 50; ++i) {
+    absl::StrAppend(&script, "SELECT key + ", i, " AS c", i, " FROM T;\n");
+  }
+  std::vector<std::unique_ptr<const AnalyzerOutput>> outputs;
+  ZETASQL_ASSERT_OK(AnalyzeStatementsInParallel(script, options_, &catalog_,
+                                        &type_factory_, /*num_threads=*/4,
+                                        &outputs));
+  ASSERT_EQ(50, outputs.size());
+  for (int i = 0; i < 50; ++i) {
+    const ResolvedQueryStmt* query =
+        outputs[i]->resolved_statement()->GetAs<ResolvedQueryStmt>();
+    ASSERT_EQ(1, query->output_column_list_size());
+    EXPECT_EQ(absl::StrCat("c", i), query->output_column_list(0)->name());
+  }
+}
+
+TEST_F(AnalyzeStatementsInParallelTest, ReturnsFirstError) {
+  std::vector<std::unique_ptr<const AnalyzerOutput>> outputs;
+  const zetasql_base::Status status = AnalyzeStatementsInParallel(
+      "SELECT 1; SELECT a FROM T; SELECT b FROM T; SELECT 4", options_,
+      &catalog_, &type_factory_, /*num_threads=*/2, &outputs);
+  EXPECT_FALSE(status.ok());
+  EXPECT_THAT(status.message(), HasSubstr("Unrecognized name: a"));
+}
+
+TEST_F(AnalyzeStatementsInParallelTest, AnalyzeStatements) {
+  std::vector<std::string> sqls;
+  for (int i = 0; i < 50; ++i) {
+    sqls.push_back(i % 10 == 3 ? absl::StrCat("SELECT c", i, " FROM T")
+                               : absl::StrCat("SELECT key + ", i, " FROM T"));
+  }
+  const std::vector<absl::string_view> statements(sqls.begin(), sqls.end());
+  for (int num_threads : {1, 4}) {
+    SCOPED_TRACE(num_threads);
+    std::vector<std::unique_ptr<const AnalyzerOutput>> outputs;
+    std::vector<zetasql_base::Status> statuses;
+    AnalyzeStatements(statements, options_, &catalog_, &type_factory_,
+                      num_threads, &outputs, &statuses);
+    ASSERT_EQ(50, outputs.size());
+    ASSERT_EQ(50, statuses.size());
+    for (int i = 0; i < 50; ++i) {
+      std::unique_ptr<const AnalyzerOutput> expected;
+      const zetasql_base::Status expected_status = AnalyzeStatement(
+          sqls[i], options_, &catalog_, &type_factory_, &expected);
+      EXPECT_EQ(expected_status, statuses[i]);
+      if (expected_status.ok()) {
+        EXPECT_EQ(expected->resolved_statement()->DebugString(),
+                  outputs[i]->resolved_statement()->DebugString());
+      } else {
+        EXPECT_EQ(nullptr, outputs[i]);
+      }
+    }
+    // Every output owns its own arena.
+    EXPECT_NE(outputs[0]->arena(), outputs[1]->arena());
+  }
+}
+
+class AddSQLFunctionsInParallelTest : public ::testing::Test {
+ protected:
+  AddSQLFunctionsInParallelTest() : catalog_("catalog", &type_factory_) {
+    catalog_.AddZetaSQLFunctions();
+    catalog_.AddOwnedTable(
+        new SimpleTable("T", {{"key", type_factory_.get_int64()}}));
+    options_.mutable_language()->EnableLanguageFeature(
+        FEATURE_TABLE_VALUED_FUNCTIONS);
+    options_.mutable_language()->EnableLanguageFeature(
+        FEATURE_CREATE_TABLE_FUNCTION);
+  }
+
+  zetasql_base::Status AddFunctions(absl::string_view sql) {
+    return AddSQLFunctionsInParallel(sql, options_, &catalog_, &type_factory_,
+                                     /*num_threads=*/4, &outputs_);
+  }
+
+  TypeFactory type_factory_;
+  SimpleCatalog catalog_;
+  AnalyzerOptions options_;
+  std::vector<std::unique_ptr<const AnalyzerOutput>> outputs_;
+};
+
+TEST_F(AddSQLFunctionsInParallelTest, FunctionsCanCallLaterFunctions) {
+  // f<i> calls f<i+1> and g<i>, and the table function calls f0.
+  std::string script =
+      "CREATE TABLE FUNCTION Tvf() AS (SELECT f0(key) FROM T);\n";
+  for (int i = 0; i < 20; ++i) {
+    const std::string next = i == 19 ? "x" : absl::StrCat("F", i + 1, "(x)");
+    absl::StrAppend(&script, "CREATE FUNCTION f", i, "(x INT64) AS (", next,
+                    " + g", i, "());\n");
+    absl::StrAppend(&script, "CREATE FUNCTION g", i, "() AS (", i, ");\n");
+  }
+  ZETASQL_ASSERT_OK(AddFunctions(script));
+  ASSERT_EQ(41, outputs_.size());
+  EXPECT_EQ(RESOLVED_CREATE_TABLE_FUNCTION_STMT,
+            outputs_[0]->resolved_statement()->node_kind());
+  EXPECT_EQ(RESOLVED_CREATE_FUNCTION_STMT,
+            outputs_[1]->resolved_statement()->node_kind());
+
+  const Function* function;
+  ZETASQL_ASSERT_OK(catalog_.GetFunction("f0", &function));
+  ASSERT_NE(nullptr, function);
+  EXPECT_EQ(SQLFunction::kSQLFunctionGroup, function->GetGroup());
+  const TableValuedFunction* tvf;
+  ZETASQL_ASSERT_OK(catalog_.GetTableValuedFunction("tvf", &tvf));
+  EXPECT_NE(nullptr, tvf);
+
+  std::unique_ptr<const AnalyzerOutput> output;
+  ZETASQL_EXPECT_OK(AnalyzeStatement("SELECT f0(1) FROM Tvf()", options_,
+                             &catalog_, &type_factory_, &output));
+}
+
+TEST_F(AddSQLFunctionsInParallelTest, Cycles) {
+  EXPECT_THAT(AddFunctions("CREATE FUNCTION a() AS (1);"
+                           "CREATE FUNCTION b() AS (c() + a());"
+                           "CREATE FUNCTION c() AS (d());"
+                           "CREATE FUNCTION d() AS (b());"),
+              StatusIs(
+                  zetasql_base::StatusCode::kInvalidArgument,
+                  HasSubstr("Recursive dependencies detected when resolving "
+                            "function b, which include objects (b, c, d, b)")));
+  // Functions outside the cycle are still added.
+  const Function* function;
+  ZETASQL_ASSERT_OK(catalog_.GetFunction("a", &function));
+  EXPECT_NE(nullptr, function);
+  ZETASQL_ASSERT_OK(catalog_.GetFunction("b", &function));
+  EXPECT_EQ(nullptr, function);
+
+  EXPECT_THAT(AddFunctions("CREATE FUNCTION self(x INT64) AS (SELF(x))"),
+              StatusIs(
+                  zetasql_base::StatusCode::kInvalidArgument,
+                  HasSubstr("The function self is recursive")));
+}
+
+TEST_F(AddSQLFunctionsInParallelTest, ReturnsFirstError) {
+  EXPECT_THAT(AddFunctions("CREATE FUNCTION a() AS (1);"
+                           "CREATE FUNCTION b() AS (a() + missing_b);"
+                           "CREATE FUNCTION c() AS (b());"
+                           "CREATE FUNCTION d() AS (missing_d)"),
+              StatusIs(
+                  zetasql_base::StatusCode::kInvalidArgument,
+                  HasSubstr("Unrecognized name: missing_b")));
+  ASSERT_EQ(4, outputs_.size());
+  EXPECT_NE(nullptr, outputs_[0]);
+  EXPECT_EQ(nullptr, outputs_[2]);
+
+  EXPECT_THAT(AddFunctions("CREATE FUNCTION a() AS (2)"),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument,
+                       HasSubstr("Function a already exists")));
+  EXPECT_THAT(AddFunctions("SELECT 1"),
+              StatusIs(
+                  zetasql_base::StatusCode::kInvalidArgument,
+                  HasSubstr("Only CREATE FUNCTION and CREATE TABLE FUNCTION")));
+}
+
+}  // namespace zetasql
@@ -0,0 +1,126 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/parse_location_table.h"
+
+#include <utility>
+
+#include "absl/strings/string_view.h"
+
+namespace zetasql {
+
+namespace {
+
+void PutVarint(uint64_t value, std::string* output) {
+  while (value >= 0x80) {
+    output->push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  output->push_back(static_cast<char>(value));
+}
+
+// Reads a varint written by PutVarint() at <*offset> in <data>, and moves
+// <*offset> past it.
+uint64_t GetVarint(const std::string& data, int* offset) {
+  uint64_t result = 0;
+  for (int shift = 0;; shift += 7) {
+    const uint8_t byte = static_cast<uint8_t>(data[(*offset)++]);
+    result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return result;
+    }
+  }
+}
+
+uint64_t ZigZagEncode(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+int64_t ZigZagDecode(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+}  // namespace
+
+int ParseLocationTable::Add(const ParseLocationRange& range) {
+  const int id = num_ranges_++;
+  if (id % kBlockSize == 0) {
+    block_offsets_.push_back(static_cast<uint32_t>(data_.size()));
+    last_start_ = 0;
+  }
+  const absl::string_view filename = range.start().filename();
+  if (!has_filename_ && filename == range.end().filename()) {
+    has_filename_ = true;
+    filename_ = std::string(filename);
+  }
+  if (!has_filename_ || filename != filename_ ||
+      range.end().filename() != filename_) {
+    irregular_ranges_.emplace(
+        id, IrregularRange{std::string(filename),
+                           std::string(range.end().filename()),
+                           range.start().GetByteOffset(),
+                           range.end().GetByteOffset()});
+    PutVarint(0, &data_);
+    PutVarint(0, &data_);
+    return id;
+  }
+  const int start = range.start().GetByteOffset();
+  const int end = range.end().GetByteOffset();
+  PutVarint(ZigZagEncode(int64_t{start} - last_start_), &data_);
+  PutVarint(ZigZagEncode(int64_t{end} - start), &data_);
+  last_start_ = start;
+  return id;
+}
+
+bool ParseLocationTable::Get(int id, ParseLocationRange* range) const {
+  if (id < 0 || id >= num_ranges_) {
+    return false;
+  }
+  auto it = irregular_ranges_.find(id);
+  if (it != irregular_ranges_.end()) {
+    const IrregularRange& irregular = it->second;
+    range->set_start(ParseLocationPoint::FromByteOffset(
+        irregular.start_filename, irregular.start));
+    range->set_end(ParseLocationPoint::FromByteOffset(irregular.end_filename,
+                                                      irregular.end));
+    return true;
+  }
+  int offset = block_offsets_[id / kBlockSize];
+  int64_t start = 0;
+  int64_t length = 0;
+  for (int i = id - id % kBlockSize; i <= id; ++i) {
+    start += ZigZagDecode(GetVarint(data_, &offset));
+    length = ZigZagDecode(GetVarint(data_, &offset));
+  }
+  range->set_start(
+      ParseLocationPoint::FromByteOffset(filename_, static_cast<int>(start)));
+  range->set_end(ParseLocationPoint::FromByteOffset(
+      filename_, static_cast<int>(start + length)));
+  return true;
+}
+
+int64_t ParseLocationTable::GetEstimatedOwnedMemoryBytesSize() const {
+  int64_t size = sizeof(*this) + filename_.capacity() + data_.capacity() +
+                 block_offsets_.capacity() * sizeof(uint32_t);
+  for (const auto& entry : irregular_ranges_) {
+    size += sizeof(entry) + entry.second.start_filename.capacity() +
+            entry.second.end_filename.capacity();
+  }
+  return size;
+}
+
+}  // namespace zetasql
@@ -0,0 +1,94 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PUBLIC_PARSE_LOCATION_TABLE_H_
+#define ZETASQL_PUBLIC_PARSE_LOCATION_TABLE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "zetasql/public/parse_location.h"
+#include "absl/container/node_hash_map.h"
+
+namespace zetasql {
+
+// A compact, append-only table of ParseLocationRanges, identified by the
+// order in which they were added.  Nodes refer to their locations by id
+// (see ResolvedNode::SetParseLocationId()) instead of each holding a
+// ParseLocationRange.
+//
+// Ranges take a few bytes each: byte offsets are stored as varint deltas
+// from the previous range, and the table keeps one copy of the filename
+// of the first range, which all ranges with that filename share.
+// Ranges whose filenames differ from it are stored separately, in full.
+// Finding a range decodes at most kBlockSize ranges.
+//
+// Ranges returned by Get() refer to filenames owned by the table, so they
+// are valid as long as the table is.  Concurrent calls of const methods are
+// safe.
+class ParseLocationTable {
+ public:
+  ParseLocationTable() {}
+  ParseLocationTable(const ParseLocationTable&) = delete;
+  ParseLocationTable& operator=(const ParseLocationTable&) = delete;
+
+  // Adds <range> and returns its id.  Ids are consecutive, starting at 0.
+  int Add(const ParseLocationRange& range);
+
+  // Sets <*range> to the range with <id> and returns true, or returns false
+  // if there is no such range.
+  bool Get(int id, ParseLocationRange* range) const;
+
+  // Returns the number of ranges added.
+  int size() const { return num_ranges_; }
+
+  // Returns the approximate number of bytes allocated by the table.
+  int64_t GetEstimatedOwnedMemoryBytesSize() const;
+
+ private:
+  // The number of ranges encoded after each entry of <block_offsets_>.
+  static constexpr int kBlockSize = 16;
+
+  // A range whose filenames are not <filename_>.
+  struct IrregularRange {
+    std::string start_filename;
+    std::string end_filename;
+    int start;
+    int end;
+  };
+
+  int num_ranges_ = 0;
+  // The filename of the first range added whose start and end have the
+  // same filename, once there is one.
+  bool has_filename_ = false;
+  std::string filename_;
+  // For each range, the difference of its start from the start of the
+  // previous range in its block, or from 0 for the first range of a block,
+  // and the difference of its end from its start, both zigzag-encoded as
+  // varints.  Irregular ranges are encoded as zeros.
+  std::string data_;
+  // The offset in <data_> of the range with id kBlockSize * i.
+  std::vector<uint32_t> block_offsets_;
+  // Stable, since Get() returns views of their filenames.
+  absl::node_hash_map<int, IrregularRange> irregular_ranges_;
+  // The start of the last range added to <data_>.
+  int last_start_ = 0;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_PARSE_LOCATION_TABLE_H_
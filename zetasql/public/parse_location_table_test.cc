@@ -0,0 +1,87 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/parse_location_table.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace zetasql {
+
+static ParseLocationRange MakeRange(absl::string_view filename, int start,
+                                    int end) {
+  ParseLocationRange range;
+  range.set_start(ParseLocationPoint::FromByteOffset(filename, start));
+  range.set_end(ParseLocationPoint::FromByteOffset(filename, end));
+  return range;
+}
+
+TEST(ParseLocationTable, AddAndGet) {
+  const std::string filename = "file.sql";
+  std::vector<ParseLocationRange> ranges;
+  // Offsets that go back and forth, across several blocks.
+  for (int i = 0; i < 100; ++i) {
+    const int start = (i % 3 == 0) ? 5000 - i : 7 * i;
+    ranges.push_back(MakeRange(filename, start, start + i % 11));
+  }
+  ranges.push_back(MakeRange(filename, -1, -1));
+  ranges.push_back(MakeRange(filename, 1 << 30, (1 << 30) + 1));
+
+  ParseLocationTable table;
+  for (int i = 0; i < ranges.size(); ++i) {
+    EXPECT_EQ(i, table.Add(ranges[i]));
+  }
+  EXPECT_EQ(ranges.size(), table.size());
+  for (int i = 0; i < ranges.size(); ++i) {
+    ParseLocationRange range;
+    ASSERT_TRUE(table.Get(i, &range));
+    EXPECT_EQ(ranges[i], range) << i;
+    // The filename is the copy in the table.
+    EXPECT_NE(filename.data(), range.start().filename().data());
+  }
+
+  ParseLocationRange range;
+  EXPECT_FALSE(table.Get(-1, &range));
+  EXPECT_FALSE(table.Get(ranges.size(), &range));
+  // Small ranges close to each other take a few bytes each.
+  EXPECT_LT(table.GetEstimatedOwnedMemoryBytesSize(),
+            ranges.size() * sizeof(ParseLocationRange));
+}
+
+TEST(ParseLocationTable, OtherFilenames) {
+  ParseLocationTable table;
+  EXPECT_EQ(0, table.Add(MakeRange("", 1, 2)));
+  EXPECT_EQ(1, table.Add(MakeRange("other", 3, 4)));
+  ParseLocationRange mixed;
+  mixed.set_start(ParseLocationPoint::FromByteOffset("a", 5));
+  mixed.set_end(ParseLocationPoint::FromByteOffset("b", 6));
+  EXPECT_EQ(2, table.Add(mixed));
+  EXPECT_EQ(3, table.Add(MakeRange("", 7, 8)));
+
+  ParseLocationRange range;
+  ASSERT_TRUE(table.Get(0, &range));
+  EXPECT_EQ(MakeRange("", 1, 2), range);
+  ASSERT_TRUE(table.Get(1, &range));
+  EXPECT_EQ(MakeRange("other", 3, 4), range);
+  ASSERT_TRUE(table.Get(2, &range));
+  EXPECT_EQ(mixed, range);
+  ASSERT_TRUE(table.Get(3, &range));
+  EXPECT_EQ(MakeRange("", 7, 8), range);
+}
+
+}  // namespace zetasql
@@ -61,68 +61,58 @@ static zetasql_base::Status MakeSyntaxErrorAtLocationOffset(
       << "Syntax error: " << error_message;
 }
 
-static zetasql_base::Status ConvertBisonToken(int bison_token,
-                                      const ParseLocationRange& location,
-                                      std::string image,
-                                      std::vector<ParseToken>* parse_tokens) {
-  using zetasql_bison_parser::BisonParserImpl;
+using zetasql_bison_parser::BisonParserImpl;
 
+// Returns the ParseToken kind for a token returned by the flex tokenizer.
+static ParseToken::Kind GetParseTokenKind(int bison_token,
+                                          absl::string_view image) {
   switch (bison_token) {
     case 0:
-      parse_tokens->emplace_back(location, std::move(image),
-                                 ParseToken::END_OF_INPUT);
-      break;
-
-    case ';': {
-      // The Flex tokenizer may include some whitespace in the ; token.
-      // We don't want to include that in the image.
-      ParseLocationRange adjusted_location = location;
-      adjusted_location.set_end(ParseLocationPoint::FromByteOffset(
-          location.start().filename(), location.start().GetByteOffset() + 1));
-      parse_tokens->emplace_back(adjusted_location, ";", ParseToken::KEYWORD);
-      break;
-    }
-
-    case BisonParserImpl::token::KW_OPEN_HINT: {
-      // This is one token "@{" in Flex, but we want to return two tokens.
-      ParseLocationRange first_location = location;
-      first_location.set_end(ParseLocationPoint::FromByteOffset(
-          location.start().filename(), location.start().GetByteOffset() + 1));
-      parse_tokens->emplace_back(first_location, "@", ParseToken::KEYWORD);
-
-      ParseLocationRange second_location = location;
-      second_location.set_start(ParseLocationPoint::FromByteOffset(
-          location.end().filename(), location.end().GetByteOffset() - 1));
-      parse_tokens->emplace_back(second_location, "{", ParseToken::KEYWORD);
-      break;
-    }
-
-    case BisonParserImpl::token::KW_DOT_STAR: {
-      // This is one token ".*" in Flex, but we want to return two tokens.
-      ParseLocationRange first_location = location;
-      first_location.set_end(ParseLocationPoint::FromByteOffset(
-          location.start().filename(), location.start().GetByteOffset() + 1));
-      parse_tokens->emplace_back(first_location, ".", ParseToken::KEYWORD);
-
-      ParseLocationRange second_location = location;
-      second_location.set_start(ParseLocationPoint::FromByteOffset(
-          location.end().filename(), location.end().GetByteOffset() - 1));
-      parse_tokens->emplace_back(second_location, "*", ParseToken::KEYWORD);
-      break;
-    }
+      return ParseToken::END_OF_INPUT;
+    case BisonParserImpl::token::STRING_LITERAL:
+    case BisonParserImpl::token::BYTES_LITERAL:
+    case BisonParserImpl::token::FLOATING_POINT_LITERAL:
+    case BisonParserImpl::token::INTEGER_LITERAL:
+      return ParseToken::VALUE;
+    case BisonParserImpl::token::COMMENT:
+      return ParseToken::COMMENT;
+    case BisonParserImpl::token::IDENTIFIER:
+      // Quoted identifiers and values that start with digits can never be
+      // keywords, so they are returned as IDENTIFIER.
+      if (image[0] == '`' || isdigit(image[0])) {
+        return ParseToken::IDENTIFIER;
+      }
+      // For consistency and backward compatibility, we force some
+      // words to be keywords. Some words are treated as regular identifiers
+      // in the Bison parser while historically they need to be keywords in
+      // the GetParseTokens() API. Others are only recognized as keywords
+      // with certain context, e.g. with or without a trailing "(", but here
+      // we return them as keywords always.
+      if (parser::IsKeywordInTokenizer(image)) {
+        return ParseToken::KEYWORD;
+      }
+      return ParseToken::IDENTIFIER_OR_KEYWORD;
+    default:
+      // All keywords and symbols become KEYWORD.
+      return ParseToken::KEYWORD;
+  }
+}
 
+zetasql_base::Status ParseTokenView::DecodeValue(Value* value) const {
+  *value = Value();
+  const ParseLocationRange& location = location_range_;
+  switch (bison_token_) {
     case BisonParserImpl::token::STRING_LITERAL: {
       std::string parsed_value;
       int error_offset;
       std::string error_message;
       const zetasql_base::Status parse_status = ParseStringLiteral(
-          image, &parsed_value, &error_message, &error_offset);
+          image_, &parsed_value, &error_message, &error_offset);
       if (!parse_status.ok()) {
         return MakeSyntaxErrorAtLocationOffset(location, error_offset,
                                                error_message);
       }
-      parse_tokens->emplace_back(location, std::move(image), ParseToken::VALUE,
-                                 Value::String(parsed_value));
+      *value = Value::String(parsed_value);
       break;
     }
 
@@ -131,40 +121,35 @@ static zetasql_base::Status ConvertBisonToken(int bison_token,
       int error_offset;
       std::string error_message;
       const zetasql_base::Status parse_status = ParseBytesLiteral(
-          image, &parsed_value, &error_message, &error_offset);
+          image_, &parsed_value, &error_message, &error_offset);
       if (!parse_status.ok()) {
         return MakeSyntaxErrorAtLocationOffset(location, error_offset,
                                                error_message);
       }
-      parse_tokens->emplace_back(location, std::move(image), ParseToken::VALUE,
-                                 Value::Bytes(parsed_value));
+      *value = Value::Bytes(parsed_value);
       break;
     }
 
     case BisonParserImpl::token::FLOATING_POINT_LITERAL: {
       double double_value;
-      if (!functions::StringToNumeric(image, &double_value, nullptr)) {
+      if (!functions::StringToNumeric(image_, &double_value, nullptr)) {
         return MakeSqlErrorAtPoint(location.start())
-               << "Invalid floating point literal: " << image;
+               << "Invalid floating point literal: " << image_;
       }
-      parse_tokens->emplace_back(location, std::move(image), ParseToken::VALUE,
-                                 Value::Double(double_value));
+      *value = Value::Double(double_value);
       break;
     }
 
     case BisonParserImpl::token::INTEGER_LITERAL: {
-      Value parsed_value;
-      if (!Value::ParseInteger(image, &parsed_value)) {
+      if (!Value::ParseInteger(image_, value)) {
         return MakeSqlErrorAtPoint(location.start())
-               << "Invalid integer literal: " << image;
+               << "Invalid integer literal: " << image_;
       }
-      parse_tokens->emplace_back(location, std::move(image), ParseToken::VALUE,
-                                 parsed_value);
       break;
     }
 
     case BisonParserImpl::token::COMMENT: {
-      std::string comment(image);
+      std::string comment(image_);
       if (comment[0] != '/') {
         // The Flex rule for the comment will match trailing whitespaces. The
         // input might contain '\n', '\r' or combination of the two, so we strip
@@ -178,114 +163,176 @@ static zetasql_base::Status ConvertBisonToken(int bison_token,
         absl::StripAsciiWhitespace(&comment);
         absl::StrAppend(&comment, "\n");
       }
-      parse_tokens->emplace_back(location, std::move(image),
-                                 ParseToken::COMMENT, Value::String(comment));
+      *value = Value::String(comment);
       break;
     }
 
     case BisonParserImpl::token::IDENTIFIER:
-      if (image[0] == '`') {
+      if (image_[0] == '`') {
         std::string identifier;
         int error_offset;
         std::string error_message;
         const zetasql_base::Status parse_status = ParseGeneralizedIdentifier(
-            image, &identifier, &error_message, &error_offset);
+            image_, &identifier, &error_message, &error_offset);
         if (!parse_status.ok()) {
           return MakeSyntaxErrorAtLocationOffset(location, error_offset,
                                                  error_message);
         }
-        parse_tokens->emplace_back(location, std::move(image),
-                                   ParseToken::IDENTIFIER,
-                                   Value::String(identifier));
-      } else if (isdigit(image[0])) {
-        // Values that start with digits also never can be keywords, so they are
-        // returned as IDENTIFIER.
-        parse_tokens->emplace_back(location, std::move(image),
-                                   ParseToken::IDENTIFIER,
-                                   Value::String(image));
-      } else {
-        if (parser::IsKeywordInTokenizer(image)) {
-          // For consistency and backward compatibility, we force some
-          // words to be keywords. Some words are treated as regular identifiers
-          // in the Bison parser while historically they need to be keywords in
-          // the GetParseTokens() API. Others are only recognized as keywords
-          // with certain context, e.g. with or without a trailing "(", but here
-          // we return them as keywords always.
-          parse_tokens->emplace_back(location, std::move(image),
-                                     ParseToken::KEYWORD);
-        } else {
-          parse_tokens->emplace_back(location, std::move(image),
-                                     ParseToken::IDENTIFIER_OR_KEYWORD,
-                                     Value::String(image));
-        }
+        *value = Value::String(identifier);
+      } else if (kind_ != ParseToken::KEYWORD) {
+        *value = Value::String(image_);
       }
       break;
 
     default:
-      // All keywords and symbols become KEYWORD.
-      parse_tokens->emplace_back(location, std::move(image),
-                                 ParseToken::KEYWORD);
       break;
   }
   return ::zetasql_base::OkStatus();
 }
 
-zetasql_base::Status GetParseTokens(const ParseTokenOptions& options,
-                            ParseResumeLocation* resume_location,
-                            std::vector<ParseToken>* tokens) {
-  if (!resume_location->allow_resume()) {
-    return MakeSqlError()
-           << "GetParseTokens() called on invalid ParseResumeLocation";
+zetasql_base::Status ParseTokenView::GetValue(Value* value) const {
+  if (kind_ != ParseToken::VALUE) {
+    *value = Value();
+    return ::zetasql_base::OkStatus();
   }
-  if (options.max_tokens > 0) {
-    resume_location->DisallowResume();
+  return ConvertInternalErrorLocationToExternal(DecodeValue(value), input_);
+}
+
+zetasql_base::Status ParseTokenView::GetIdentifier(std::string* identifier) const {
+  identifier->clear();
+  if (!IsIdentifier()) {
+    return ::zetasql_base::OkStatus();
   }
-  ZETASQL_RETURN_IF_ERROR(resume_location->Validate());
-  tokens->clear();
+  Value value;
+  ZETASQL_RETURN_IF_ERROR(
+      ConvertInternalErrorLocationToExternal(DecodeValue(&value), input_));
+  *identifier = value.string_value();
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status ParseTokenView::ToParseToken(ParseToken* token) const {
+  Value value;
+  ZETASQL_RETURN_IF_ERROR(
+      ConvertInternalErrorLocationToExternal(DecodeValue(&value), input_));
+  if (value.is_valid()) {
+    *token = ParseToken(location_range_, std::string(image_), kind_,
+                        std::move(value));
+  } else {
+    *token = ParseToken(location_range_, std::string(image_), kind_);
+  }
+  return ::zetasql_base::OkStatus();
+}
 
+ParseTokenStream::ParseTokenStream(const ParseTokenOptions& options,
+                                   ParseResumeLocation* resume_location)
+    : options_(options), resume_location_(resume_location) {
   auto mode = parser::BisonParserMode::kTokenizer;
   if (options.include_comments) {
     mode = parser::BisonParserMode::kTokenizerPreserveComments;
   }
-
-  auto tokenizer = absl::make_unique<parser::ZetaSqlFlexTokenizer>(
+  tokenizer_ = absl::make_unique<parser::ZetaSqlFlexTokenizer>(
       mode, resume_location->filename(), resume_location->input(),
       resume_location->byte_position());
+}
 
-  ParseLocationRange location;
-  while (true) {
-    int bison_token;
-    ZETASQL_RETURN_IF_ERROR(ConvertInternalErrorLocationToExternal(
-        tokenizer->GetNextToken(&location /* input and output */, &bison_token),
-        resume_location->input()));
+ParseTokenStream::~ParseTokenStream() {}
 
-    std::string image(absl::ClippedSubstr(
-        resume_location->input(), location.start().GetByteOffset(),
-        location.end().GetByteOffset() - location.start().GetByteOffset()));
-    ZETASQL_RETURN_IF_ERROR(ConvertInternalErrorLocationToExternal(
-        ConvertBisonToken(bison_token, location, std::move(image), tokens),
-        resume_location->input()));
+zetasql_base::Status ParseTokenStream::Create(
+    const ParseTokenOptions& options, ParseResumeLocation* resume_location,
+    std::unique_ptr<ParseTokenStream>* stream) {
+  if (!resume_location->allow_resume()) {
+    return MakeSqlError()
+           << "GetParseTokens() called on invalid ParseResumeLocation";
+  }
+  if (options.max_tokens > 0) {
+    resume_location->DisallowResume();
+  }
+  ZETASQL_RETURN_IF_ERROR(resume_location->Validate());
+  stream->reset(new ParseTokenStream(options, resume_location));
+  return ::zetasql_base::OkStatus();
+}
 
-    if (options.max_tokens > 0 && tokens->size() >= options.max_tokens) {
-      break;
-    }
-    if (bison_token == 0 /* EOF */) {
-      break;
-    }
-    if (options.stop_at_end_of_statement &&
-        tokens->back().kind() == ParseToken::KEYWORD &&
-        tokens->back().GetImage().substr(0, 1) == ";") {
-      break;
+zetasql_base::Status ParseTokenStream::Next(ParseTokenView* token) {
+  ZETASQL_RET_CHECK(!done_) << "ParseTokenStream::Next() called after done()";
+  const absl::string_view input = resume_location_->input();
+  int bison_token = 0;
+  if (has_pending_token_) {
+    *token = pending_token_;
+    has_pending_token_ = false;
+  } else {
+    ZETASQL_RETURN_IF_ERROR(ConvertInternalErrorLocationToExternal(
+        tokenizer_->GetNextToken(&location_ /* input and output */,
+                                 &bison_token),
+        input));
+    const int start = location_.start().GetByteOffset();
+    const int end = location_.end().GetByteOffset();
+    const absl::string_view image =
+        absl::ClippedSubstr(input, start, end - start);
+    auto make_location = [this](int token_start, int token_end) {
+      const absl::string_view filename = location_.start().filename();
+      ParseLocationRange location;
+      location.set_start(
+          ParseLocationPoint::FromByteOffset(filename, token_start));
+      location.set_end(ParseLocationPoint::FromByteOffset(filename, token_end));
+      return location;
+    };
+
+    switch (bison_token) {
+      case ';':
+        // The Flex tokenizer may include some whitespace in the ; token.
+        // We don't want to include that in the image.
+        *token = ParseTokenView(ParseToken::KEYWORD, bison_token, input,
+                                image.substr(0, 1),
+                                make_location(start, start + 1));
+        break;
+
+      case BisonParserImpl::token::KW_OPEN_HINT:
+      case BisonParserImpl::token::KW_DOT_STAR:
+        // This is one token "@{" or ".*" in Flex, but we want to return two
+        // tokens.
+        *token = ParseTokenView(ParseToken::KEYWORD, image[0], input,
+                                image.substr(0, 1),
+                                make_location(start, start + 1));
+        pending_token_ = ParseTokenView(ParseToken::KEYWORD, image.back(),
+                                        input, image.substr(image.size() - 1),
+                                        make_location(end - 1, end));
+        has_pending_token_ = true;
+        break;
+
+      default:
+        *token = ParseTokenView(GetParseTokenKind(bison_token, image),
+                                bison_token, input, image, location_);
+        break;
     }
   }
-  // Use the end of the last token returned by the tokenizer as the resume
-  // location. We shorten the ";" token in ConvertBisonToken(), so we should
-  // NOT use the token position directly from the tokenizer. Instead, we
-  // take the position from the last token, which should always exist
-  // because even if we have no real tokens, we always include an EOF token.
-  ZETASQL_RET_CHECK(!tokens->empty());
-  resume_location->set_byte_position(
-      tokens->back().GetLocationRange().end().GetByteOffset());
+  ++num_tokens_;
+
+  // Use the end of the last token returned as the resume location. We
+  // shorten the ";" token above, so we should NOT use the token position
+  // directly from the tokenizer.
+  resume_location_->set_byte_position(
+      token->GetLocationRange().end().GetByteOffset());
+  if (!has_pending_token_ &&
+      ((options_.max_tokens > 0 && num_tokens_ >= options_.max_tokens) ||
+       token->IsEndOfInput() ||
+       (options_.stop_at_end_of_statement && bison_token == ';'))) {
+    done_ = true;
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status GetParseTokens(const ParseTokenOptions& options,
+                            ParseResumeLocation* resume_location,
+                            std::vector<ParseToken>* tokens) {
+  std::unique_ptr<ParseTokenStream> stream;
+  ZETASQL_RETURN_IF_ERROR(ParseTokenStream::Create(options, resume_location, &stream));
+  tokens->clear();
+  while (!stream->done()) {
+    ParseTokenView token;
+    ZETASQL_RETURN_IF_ERROR(stream->Next(&token));
+    tokens->emplace_back();
+    ZETASQL_RETURN_IF_ERROR(token.ToParseToken(&tokens->back()));
+  }
   return ::zetasql_base::OkStatus();
 }
 
@@ -17,6 +17,7 @@
 #ifndef ZETASQL_PUBLIC_PARSE_TOKENS_H_
 #define ZETASQL_PUBLIC_PARSE_TOKENS_H_
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -28,6 +29,10 @@
 
 namespace zetasql {
 
+namespace parser {
+class ZetaSqlFlexTokenizer;
+}  // namespace parser
+
 // ParseToken represents one element in a statement fragment parsed by
 // GetParseTokens.  The token will be fully parsed, with any quoting or
 // escaping removed, and with literals resolved to concrete zetasql::Values.
@@ -204,6 +209,134 @@ zetasql_base::Status GetParseTokens(const ParseTokenOptions& options,
                             ParseResumeLocation* resume_location,
                             std::vector<ParseToken>* tokens);
 
+// ParseTokenView is a token returned by ParseTokenStream.  It classifies the
+// token like ParseToken does, but its image is a slice of the input rather
+// than a copy, and literals, quoted identifiers and comments are only decoded
+// when GetValue(), GetIdentifier() or ToParseToken() is called.  A
+// ParseTokenView is only valid while the input of the ParseTokenStream that
+// returned it is alive.
+class ParseTokenView {
+ public:
+  ParseTokenView() {}
+
+  ParseToken::Kind kind() const { return kind_; }
+
+  bool IsEndOfInput() const { return kind_ == ParseToken::END_OF_INPUT; }
+  bool IsKeyword() const {
+    return kind_ == ParseToken::KEYWORD ||
+           kind_ == ParseToken::IDENTIFIER_OR_KEYWORD;
+  }
+  bool IsIdentifier() const {
+    return kind_ == ParseToken::IDENTIFIER ||
+           kind_ == ParseToken::IDENTIFIER_OR_KEYWORD;
+  }
+  bool IsValue() const { return kind_ == ParseToken::VALUE; }
+  bool IsComment() const { return kind_ == ParseToken::COMMENT; }
+
+  // Returns the exact SQL text of this token, as a slice of the input.
+  absl::string_view GetImage() const { return image_; }
+
+  // Returns the location of the token in the input.
+  ParseLocationRange GetLocationRange() const { return location_range_; }
+
+  // Decodes the literal value of a VALUE token into <*value>, as
+  // ParseToken::GetValue() returns it.  Sets <*value> to an invalid Value for
+  // other token kinds.  Returns an error if the literal is malformed, e.g.
+  // because of an invalid escape sequence.
+  zetasql_base::Status GetValue(Value* value) const;
+
+  // Decodes the identifier into <*identifier>, as ParseToken::GetIdentifier()
+  // returns it, i.e. with quotes and escaping resolved.  Sets <*identifier>
+  // to "" if the token is not an identifier.
+  zetasql_base::Status GetIdentifier(std::string* identifier) const;
+
+  // Decodes this token into a ParseToken, as GetParseTokens() returns it.
+  zetasql_base::Status ToParseToken(ParseToken* token) const;
+
+ private:
+  friend class ParseTokenStream;
+
+  ParseTokenView(ParseToken::Kind kind, int bison_token,
+                 absl::string_view input, absl::string_view image,
+                 ParseLocationRange location_range)
+      : kind_(kind),
+        bison_token_(bison_token),
+        input_(input),
+        image_(image),
+        location_range_(location_range) {}
+
+  // Decodes the Value that ParseToken stores for this token, or returns an
+  // invalid Value for kinds that have none.
+  zetasql_base::Status DecodeValue(Value* value) const;
+
+  ParseToken::Kind kind_ = ParseToken::END_OF_INPUT;
+  // The token returned by the flex tokenizer, which determines how the image
+  // is decoded.
+  int bison_token_ = 0;
+  // The whole input, used to convert error locations.
+  absl::string_view input_;
+  absl::string_view image_;
+  ParseLocationRange location_range_;
+
+  // Copyable
+};
+
+// Returns tokens one at a time, without copying the input or decoding
+// literals, for callers like syntax highlighters and fingerprinters that
+// look at large numbers of tokens.  It follows the same tokenization rules
+// and <options> as GetParseTokens(), which is implemented on top of it.
+//
+// Example usage:
+//
+//   std::unique_ptr<ParseTokenStream> stream;
+//   ZETASQL_RETURN_IF_ERROR(ParseTokenStream::Create(options, &resume_location,
+//                                            &stream));
+//   while (!stream->done()) {
+//     ParseTokenView token;
+//     ZETASQL_RETURN_IF_ERROR(stream->Next(&token));
+//     if (token.IsComment()) Highlight(token.GetLocationRange());
+//   }
+class ParseTokenStream {
+ public:
+  ParseTokenStream(const ParseTokenStream&) = delete;
+  ParseTokenStream& operator=(const ParseTokenStream&) = delete;
+  ~ParseTokenStream();
+
+  // Creates a stream that starts at <resume_location>.  <resume_location> and
+  // its input must outlive the stream.  The byte position of
+  // <resume_location> is updated after each token, like GetParseTokens()
+  // updates it.
+  static zetasql_base::Status Create(const ParseTokenOptions& options,
+                             ParseResumeLocation* resume_location,
+                             std::unique_ptr<ParseTokenStream>* stream);
+
+  // Returns the next token in <*token>.  Must not be called once done() is
+  // true.  Returns an error on tokenization failures like bad characters or
+  // unclosed quotes, but not on malformed literals, which are only detected
+  // when the token is decoded.
+  zetasql_base::Status Next(ParseTokenView* token);
+
+  // True once the stream has returned the end of input, or returned as many
+  // tokens as <options> allows.
+  bool done() const { return done_; }
+
+ private:
+  ParseTokenStream(const ParseTokenOptions& options,
+                   ParseResumeLocation* resume_location);
+
+  const ParseTokenOptions options_;
+  ParseResumeLocation* const resume_location_;
+  std::unique_ptr<parser::ZetaSqlFlexTokenizer> tokenizer_;
+  // Location of the last token returned by the tokenizer.
+  ParseLocationRange location_;
+  // The second half of a tokenizer token that is returned as two tokens,
+  // like "@{".
+  bool has_pending_token_ = false;
+  ParseTokenView pending_token_;
+  int num_tokens_ = 0;
+  bool done_ = false;
+};
+
 }  // namespace zetasql
 
 #endif  // ZETASQL_PUBLIC_PARSE_TOKENS_H_
@@ -148,6 +148,35 @@ TEST(GetNextTokensTest, LargeMaxTokensNotResumable) {
           HasSubstr("GetParseTokens() called on invalid ParseResumeLocation")));
 }
 
+TEST(GetNextTokensTest, InputLargerThanTokenizerBuffer) {
+  ParseTokenOptions options;
+  std::vector<ParseToken> parse_tokens;
+  const std::string filename = "filename_InputLargerThanTokenizerBuffer";
+  // The tokenizer reads the input in chunks much smaller than this, starting
+  // at the resume location.
+  std::string input = "skipped ";
+  const int start_offset = input.size();
+  constexpr int kNumValues = 10000;
+  for (int i = 0; i < kNumValues; ++i) {
+    absl::StrAppend(&input, i, ",");
+  }
+  absl::StrAppend(&input, "last");
+  ParseResumeLocation location =
+      ParseResumeLocation::FromStringView(filename, input);
+  location.set_byte_position(start_offset);
+
+  ZETASQL_ASSERT_OK(GetParseTokens(options, &location, &parse_tokens));
+  ASSERT_EQ(2 * kNumValues + 2, parse_tokens.size());
+  EXPECT_EQ("VALUE:0", parse_tokens[0].DebugString());
+  EXPECT_EQ(absl::StrCat("VALUE:", kNumValues - 1),
+            parse_tokens[2 * kNumValues - 2].DebugString());
+  const ParseToken& last = parse_tokens[2 * kNumValues];
+  EXPECT_EQ("last", last.GetImage());
+  EXPECT_EQ(input.size() - 4, last.GetLocationRange().start().GetByteOffset());
+  EXPECT_EQ(input.size(), last.GetLocationRange().end().GetByteOffset());
+  EXPECT_TRUE(parse_tokens.back().IsEndOfInput());
+}
+
 TEST(GetNextTokensTest, PreserveCommentsWithoutEndingNewline) {
   ParseTokenOptions options;
   options.include_comments = true;
@@ -226,4 +255,78 @@ TEST(GetNextTokensTest, LocationsWithCommentsForNonCommentTokens) {
               IsOkAndHolds(std::make_pair(6, 1)));
 }
 
+TEST(ParseTokenStreamTest, MatchesGetParseTokens) {
+  ParseTokenOptions options;
+  options.include_comments = true;
+  const std::string input =
+      "SELECT @{hint=1} a.* , `b c`, 'x\\ny', b\"\\x01\", 1.5, 0x10 -- c\n;"
+      "SELECT 2";
+  ParseResumeLocation location = ParseResumeLocation::FromStringView(input);
+  std::vector<ParseToken> expected;
+  ZETASQL_ASSERT_OK(GetParseTokens(options, &location, &expected));
+
+  location = ParseResumeLocation::FromStringView(input);
+  std::unique_ptr<ParseTokenStream> stream;
+  ZETASQL_ASSERT_OK(ParseTokenStream::Create(options, &location, &stream));
+  int index = 0;
+  while (!stream->done()) {
+    ParseTokenView view;
+    ZETASQL_ASSERT_OK(stream->Next(&view));
+    ASSERT_LT(index, expected.size());
+    const ParseToken& token = expected[index++];
+    EXPECT_EQ(token.kind(), view.kind());
+    EXPECT_EQ(token.GetImage(), view.GetImage());
+    EXPECT_EQ(token.GetLocationRange(), view.GetLocationRange());
+    Value value;
+    ZETASQL_ASSERT_OK(view.GetValue(&value));
+    EXPECT_EQ(token.GetValue().DebugString(), value.DebugString());
+    std::string identifier;
+    ZETASQL_ASSERT_OK(view.GetIdentifier(&identifier));
+    EXPECT_EQ(token.GetIdentifier(), identifier);
+    ParseToken converted;
+    ZETASQL_ASSERT_OK(view.ToParseToken(&converted));
+    EXPECT_EQ(token.DebugString(), converted.DebugString());
+  }
+  EXPECT_EQ(expected.size(), index);
+  EXPECT_EQ(input.size(), location.byte_position());
+}
+
+TEST(ParseTokenStreamTest, StopsAtEndOfStatement) {
+  ParseTokenOptions options;
+  options.stop_at_end_of_statement = true;
+  const std::string input = "SELECT 1;  SELECT 2";
+  ParseResumeLocation location = ParseResumeLocation::FromStringView(input);
+  std::unique_ptr<ParseTokenStream> stream;
+  ZETASQL_ASSERT_OK(ParseTokenStream::Create(options, &location, &stream));
+  std::vector<std::string> images;
+  while (!stream->done()) {
+    ParseTokenView view;
+    ZETASQL_ASSERT_OK(stream->Next(&view));
+    images.push_back(std::string(view.GetImage()));
+  }
+  EXPECT_THAT(images, ::testing::ElementsAre("SELECT", "1", ";"));
+  EXPECT_EQ(9, location.byte_position());
+}
+
+TEST(ParseTokenStreamTest, LiteralsAreDecodedOnRequest) {
+  ParseTokenOptions options;
+  const std::string input = "SELECT '\\q'";
+  ParseResumeLocation location = ParseResumeLocation::FromStringView(input);
+  std::unique_ptr<ParseTokenStream> stream;
+  ZETASQL_ASSERT_OK(ParseTokenStream::Create(options, &location, &stream));
+  ParseTokenView view;
+  ZETASQL_ASSERT_OK(stream->Next(&view));
+  ZETASQL_ASSERT_OK(stream->Next(&view));
+  EXPECT_TRUE(view.IsValue());
+  EXPECT_EQ("'\\q'", view.GetImage());
+  Value value;
+  EXPECT_THAT(view.GetValue(&value),
+              StatusIs(_, HasSubstr("Illegal escape sequence")));
+
+  location = ParseResumeLocation::FromStringView(input);
+  std::vector<ParseToken> tokens;
+  EXPECT_THAT(GetParseTokens(options, &location, &tokens),
+              StatusIs(_, HasSubstr("Illegal escape sequence")));
+}
+
 }  // namespace zetasql
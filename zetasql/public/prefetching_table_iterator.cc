@@ -0,0 +1,199 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "zetasql/public/prefetching_table_iterator.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "zetasql/base/logging.h"
+#include "zetasql/base/source_location.h"
+#include "zetasql/base/status_builder.h"
+
+namespace zetasql {
+
+constexpr int PrefetchingTableIterator::kDefaultBatchSize;
+constexpr int PrefetchingTableIterator::kDefaultMaxBufferedBatches;
+
+PrefetchingTableIterator::PrefetchingTableIterator(
+    std::unique_ptr<EvaluatorTableIterator> input, int batch_size,
+    int max_buffered_batches)
+    : input_(std::move(input)),
+      batch_size_(batch_size),
+      max_buffered_batches_(max_buffered_batches) {
+  CHECK(input_ != nullptr);
+  CHECK_GT(batch_size_, 0);
+  CHECK_GT(max_buffered_batches_, 0);
+  for (int i = 0; i < input_->NumColumns(); ++i) {
+    column_names_.push_back(input_->GetColumnName(i));
+    column_types_.push_back(input_->GetColumnType(i));
+  }
+  current_ = ValueBatch(column_types_);
+  row_.resize(column_types_.size());
+}
+
+PrefetchingTableIterator::~PrefetchingTableIterator() {
+  if (!thread_.joinable()) return;
+  bool input_done;
+  {
+    absl::MutexLock lock(&mutex_);
+    cancelled_ = true;
+    input_done = input_done_;
+  }
+  if (!input_done) input_->Cancel().IgnoreError();
+  thread_.join();
+}
+
+zetasql_base::Status PrefetchingTableIterator::SetColumnFilterMap(
+    absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map) {
+  DCHECK(!thread_.joinable());
+  return input_->SetColumnFilterMap(std::move(filter_map));
+}
+
+zetasql_base::Status PrefetchingTableIterator::SetScanPushdown(
+    const ScanPushdown& pushdown, bool* rows_ordered) {
+  DCHECK(!thread_.joinable());
+  // The buffer keeps the order of the input rows.
+  return input_->SetScanPushdown(pushdown, rows_ordered);
+}
+
+zetasql_base::Status PrefetchingTableIterator::SetSample(
+    const TableSample& sample, bool* sampled) {
+  DCHECK(!thread_.joinable());
+  return input_->SetSample(sample, sampled);
+}
+
+void PrefetchingTableIterator::SetDeadline(absl::Time deadline) {
+  DCHECK(!thread_.joinable());
+  deadline_ = deadline;
+  input_->SetDeadline(deadline);
+}
+
+void PrefetchingTableIterator::StartPrefetching() {
+  if (!thread_.joinable()) {
+    thread_ = std::thread(&PrefetchingTableIterator::Prefetch, this);
+  }
+}
+
+void PrefetchingTableIterator::Prefetch() {
+  ValueBatch batch(column_types_);
+  while (true) {
+    {
+      absl::MutexLock lock(&mutex_);
+      mutex_.Await(
+          absl::Condition(this, &PrefetchingTableIterator::CanPrefetch));
+      if (cancelled_) return;
+    }
+    // Read without holding the lock, so that Cancel() and the buffered rows
+    // are not blocked by the input.
+    const bool has_rows = input_->NextBatch(batch_size_, &batch);
+    absl::MutexLock lock(&mutex_);
+    if (!has_rows) {
+      input_done_ = true;
+      if (status_.ok()) status_ = input_->Status();
+      return;
+    }
+    buffer_.push_back(std::move(batch));
+    batch = ValueBatch(column_types_);
+  }
+}
+
+bool PrefetchingTableIterator::CanPrefetch() const {
+  return cancelled_ || buffer_.size() < max_buffered_batches_;
+}
+
+bool PrefetchingTableIterator::CanConsume() const {
+  return cancelled_ || input_done_ || !buffer_.empty();
+}
+
+bool PrefetchingTableIterator::AdvanceBatch() {
+  StartPrefetching();
+  {
+    absl::MutexLock lock(&mutex_);
+    if (mutex_.AwaitWithDeadline(
+            absl::Condition(this, &PrefetchingTableIterator::CanConsume),
+            deadline_)) {
+      // Rows already buffered are still returned after the input has ended,
+      // but not after cancellation.
+      if (cancelled_ || buffer_.empty()) return false;
+      current_ = std::move(buffer_.front());
+      buffer_.pop_front();
+      next_row_in_current_ = 0;
+      return true;
+    }
+    if (cancelled_) return false;
+    cancelled_ = true;
+    status_ = ::zetasql_base::DeadlineExceededErrorBuilder(ZETASQL_LOC)
+              << "Deadline exceeded while reading table";
+  }
+  // Unblock the background thread if it is waiting for the input.
+  input_->Cancel().IgnoreError();
+  return false;
+}
+
+bool PrefetchingTableIterator::NextRow() {
+  if (next_row_in_current_ >= current_.num_rows() && !AdvanceBatch()) {
+    return false;
+  }
+  for (int i = 0; i < row_.size(); ++i) {
+    row_[i] = current_.column(i).GetValue(next_row_in_current_);
+  }
+  ++next_row_in_current_;
+  return true;
+}
+
+bool PrefetchingTableIterator::NextBatch(int max_rows, ValueBatch* batch) {
+  if (next_row_in_current_ >= current_.num_rows() && !AdvanceBatch()) {
+    batch->Clear();
+    return false;
+  }
+  if (next_row_in_current_ == 0 && current_.num_rows() <= max_rows) {
+    // Hand over the whole buffered batch without copying.
+    std::swap(*batch, current_);
+    current_ = ValueBatch(column_types_);
+    return true;
+  }
+  *batch = ValueBatch(column_types_);
+  const int end =
+      std::min(current_.num_rows(), next_row_in_current_ + max_rows);
+  batch->AppendRows(current_, next_row_in_current_, end);
+  next_row_in_current_ = end;
+  return true;
+}
+
+zetasql_base::Status PrefetchingTableIterator::Status() const {
+  absl::MutexLock lock(&mutex_);
+  return status_;
+}
+
+zetasql_base::Status PrefetchingTableIterator::Cancel() {
+  {
+    absl::MutexLock lock(&mutex_);
+    if (!cancelled_) {
+      cancelled_ = true;
+      // Cancelling after the last row has been buffered does not make the
+      // scan fail.
+      if (status_.ok() && !(input_done_ && buffer_.empty())) {
+        status_ = ::zetasql_base::CancelledErrorBuilder(ZETASQL_LOC)
+                  << "Table iterator was cancelled";
+      }
+    }
+  }
+  return input_->Cancel();
+}
+
+}  // namespace zetasql
@@ -0,0 +1,139 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef ZETASQL_PUBLIC_PREFETCHING_TABLE_ITERATOR_H_
+#define ZETASQL_PUBLIC_PREFETCHING_TABLE_ITERATOR_H_
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/public/value_batch.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+
+// An EvaluatorTableIterator that reads another iterator on a background
+// thread, so that the caller's work on one batch of rows overlaps the I/O for
+// the next ones.
+//
+// The background thread starts on the first call to NextRow() or
+// NextBatch(). It reads batches of up to 'batch_size' rows with
+// input->NextBatch() into a buffer of at most 'max_buffered_batches' batches,
+// and waits while the buffer is full. A row is only returned once its whole
+// batch has been read, so inputs that produce rows slowly should use a small
+// 'batch_size'. SetColumnFilterMap(), SetScanPushdown(), SetSample() and
+// SetDeadline() are passed on to the input before the thread starts.
+//
+// Cancel() and the deadline stop the background thread: the input is
+// cancelled, and NextRow() returns false with a kCancelled or
+// kDeadlineExceeded Status() as soon as the buffered rows run out, even if
+// the input is blocked. The input must support Cancel() from another thread,
+// as EvaluatorTableIterator requires.
+//
+// Example:
+//   ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<EvaluatorTableIterator> iter,
+//                    table->CreateEvaluatorTableIterator(column_indexes));
+//   iter = absl::make_unique<PrefetchingTableIterator>(std::move(iter));
+class PrefetchingTableIterator : public EvaluatorTableIterator {
+ public:
+  static constexpr int kDefaultBatchSize = 1024;
+  static constexpr int kDefaultMaxBufferedBatches = 4;
+
+  // 'batch_size' and 'max_buffered_batches' must be positive.
+  explicit PrefetchingTableIterator(
+      std::unique_ptr<EvaluatorTableIterator> input,
+      int batch_size = kDefaultBatchSize,
+      int max_buffered_batches = kDefaultMaxBufferedBatches);
+  PrefetchingTableIterator(const PrefetchingTableIterator&) = delete;
+  PrefetchingTableIterator& operator=(const PrefetchingTableIterator&) =
+      delete;
+
+  // Cancels the input if it is still being read, and waits for the
+  // background thread to finish.
+  ~PrefetchingTableIterator() override;
+
+  int NumColumns() const override { return column_types_.size(); }
+  std::string GetColumnName(int i) const override { return column_names_[i]; }
+  const Type* GetColumnType(int i) const override { return column_types_[i]; }
+
+  zetasql_base::Status SetColumnFilterMap(
+      absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map)
+      override;
+  zetasql_base::Status SetScanPushdown(const ScanPushdown& pushdown,
+                               bool* rows_ordered) override;
+  zetasql_base::Status SetSample(const TableSample& sample,
+                         bool* sampled) override;
+  void SetDeadline(absl::Time deadline) override;
+
+  bool NextRow() override;
+  const Value& GetValue(int i) const override { return row_[i]; }
+  bool NextBatch(int max_rows, ValueBatch* batch) override;
+
+  zetasql_base::Status Status() const override;
+  zetasql_base::Status Cancel() override;
+
+ private:
+  // Starts the background thread if it has not been started.
+  void StartPrefetching();
+
+  // The body of the background thread.
+  void Prefetch();
+
+  // Conditions for the background thread to read another batch, and for the
+  // consumer to stop waiting.
+  bool CanPrefetch() const EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  bool CanConsume() const EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Makes 'current_' the next buffered batch with at least one unread row.
+  // Returns false at the end of the rows, after setting 'status_'.
+  bool AdvanceBatch();
+
+  const std::unique_ptr<EvaluatorTableIterator> input_;
+  const int batch_size_;
+  const int max_buffered_batches_;
+  std::vector<std::string> column_names_;
+  std::vector<const Type*> column_types_;
+  absl::Time deadline_ = absl::InfiniteFuture();
+
+  // Accessed only by the thread calling NextRow() or NextBatch().
+  std::thread thread_;
+  ValueBatch current_;
+  int next_row_in_current_ = 0;  // Index of the next unread row of 'current_'.
+  std::vector<Value> row_;
+
+  mutable absl::Mutex mutex_;
+  std::deque<ValueBatch> buffer_ GUARDED_BY(mutex_);
+  // Set by the background thread when the input has no more rows.
+  bool input_done_ GUARDED_BY(mutex_) = false;
+  bool cancelled_ GUARDED_BY(mutex_) = false;
+  // The input's final Status, or the reason the rows ended early.
+  zetasql_base::Status status_ GUARDED_BY(mutex_);
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_PREFETCHING_TABLE_ITERATOR_H_
@@ -0,0 +1,140 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "zetasql/public/prefetching_table_iterator.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/public/value_batch.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace zetasql {
+namespace {
+
+using zetasql_base::testing::StatusIs;
+
+// Returns rows (i) for i in [0, num_rows), then blocks in NextRow() until
+// cancelled if <block_at_end> is true.
+class TestIterator : public EvaluatorTableIterator {
+ public:
+  TestIterator(int num_rows, bool block_at_end)
+      : num_rows_(num_rows), block_at_end_(block_at_end) {}
+
+  int NumColumns() const override { return 1; }
+  std::string GetColumnName(int i) const override { return "key"; }
+  const Type* GetColumnType(int i) const override {
+    return types::Int64Type();
+  }
+
+  bool NextRow() override {
+    if (next_row_ == num_rows_) {
+      if (block_at_end_) {
+        cancelled_.WaitForNotification();
+        status_ = zetasql_base::CancelledError("cancelled");
+      }
+      return false;
+    }
+    value_ = Value::Int64(next_row_++);
+    return true;
+  }
+  const Value& GetValue(int i) const override { return value_; }
+  zetasql_base::Status Status() const override { return status_; }
+  zetasql_base::Status Cancel() override {
+    if (!cancelled_.HasBeenNotified()) cancelled_.Notify();
+    return zetasql_base::OkStatus();
+  }
+
+ private:
+  const int num_rows_;
+  const bool block_at_end_;
+  int next_row_ = 0;
+  Value value_;
+  zetasql_base::Status status_;
+  absl::Notification cancelled_;
+};
+
+TEST(PrefetchingTableIteratorTest, NextRow) {
+  PrefetchingTableIterator iterator(
+      absl::make_unique<TestIterator>(/*num_rows=*/10, /*block_at_end=*/false),
+      /*batch_size=*/3, /*max_buffered_batches=*/2);
+  ASSERT_EQ(1, iterator.NumColumns());
+  EXPECT_EQ("key", iterator.GetColumnName(0));
+  EXPECT_TRUE(iterator.GetColumnType(0)->IsInt64());
+  for (int64_t i = 0; i < 10; ++i) {
+    ASSERT_TRUE(iterator.NextRow());
+    EXPECT_EQ(Value::Int64(i), iterator.GetValue(0));
+  }
+  EXPECT_FALSE(iterator.NextRow());
+  ZETASQL_EXPECT_OK(iterator.Status());
+}
+
+TEST(PrefetchingTableIteratorTest, NextBatch) {
+  PrefetchingTableIterator iterator(
+      absl::make_unique<TestIterator>(/*num_rows=*/10, /*block_at_end=*/false),
+      /*batch_size=*/4, /*max_buffered_batches=*/1);
+  ValueBatch batch;
+  std::vector<int> batch_sizes;
+  int64_t next_key = 0;
+  while (iterator.NextBatch(/*max_rows=*/3, &batch)) {
+    batch_sizes.push_back(batch.num_rows());
+    for (int row = 0; row < batch.num_rows(); ++row) {
+      EXPECT_EQ(next_key++, batch.column(0).int64_data()[row]);
+    }
+  }
+  ZETASQL_EXPECT_OK(iterator.Status());
+  EXPECT_EQ(10, next_key);
+  // Buffered batches of 4 are split to respect <max_rows>.
+  EXPECT_THAT(batch_sizes, testing::ElementsAre(3, 1, 3, 1, 2));
+}
+
+TEST(PrefetchingTableIteratorTest, Cancel) {
+  PrefetchingTableIterator iterator(
+      absl::make_unique<TestIterator>(/*num_rows=*/2, /*block_at_end=*/true),
+      /*batch_size=*/1, /*max_buffered_batches=*/4);
+  ASSERT_TRUE(iterator.NextRow());
+  ASSERT_TRUE(iterator.NextRow());
+  ZETASQL_EXPECT_OK(iterator.Cancel());
+  EXPECT_FALSE(iterator.NextRow());
+  EXPECT_THAT(iterator.Status(),
+              StatusIs(zetasql_base::StatusCode::kCancelled));
+}
+
+TEST(PrefetchingTableIteratorTest, Deadline) {
+  PrefetchingTableIterator iterator(
+      absl::make_unique<TestIterator>(/*num_rows=*/1, /*block_at_end=*/true),
+      /*batch_size=*/1);
+  iterator.SetDeadline(absl::Now() + absl::Milliseconds(10));
+  ASSERT_TRUE(iterator.NextRow());
+  // The input blocks until it is cancelled when the deadline passes.
+  EXPECT_FALSE(iterator.NextRow());
+  EXPECT_THAT(iterator.Status(),
+              StatusIs(zetasql_base::StatusCode::kDeadlineExceeded));
+}
+
+}  // namespace
+}  // namespace zetasql
@@ -37,8 +37,12 @@
 #include "absl/base/casts.h"
 #include <cstdint>
 #include "absl/base/optimization.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/inlined_vector.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/variant.h"
 #include "zetasql/base/map_util.h"
 #include "zetasql/base/source_location.h"
@@ -266,9 +270,84 @@ zetasql_base::Status GetProtoFieldDefaultRaw(const google::protobuf::FieldDescri
   return zetasql_base::OkStatus();
 }
 
+namespace {
+
+// Process-wide cache of the types and defaults of fields in the generated
+// DescriptorPool, keyed by field and <ignore_annotations>.  TypeFactory
+// returns types owned by a process-wide factory for those fields, so the
+// cached defaults stay valid.  Resolving a path like a.b.c.d computes the
+// same fields over and over, and defaults take annotation lookups to compute.
+class GeneratedPoolFieldCache {
+ public:
+  struct TypeAndDefault {
+    const Type* type;
+    Value default_value;
+  };
+
+  static GeneratedPoolFieldCache* Get() {
+    static GeneratedPoolFieldCache* cache = new GeneratedPoolFieldCache();
+    return cache;
+  }
+
+  static bool IsCacheable(const google::protobuf::FieldDescriptor* field) {
+    return field->file()->pool() == google::protobuf::DescriptorPool::generated_pool();
+  }
+
+  // Returns true if copies of <value> share no reference counted data, so
+  // that threads can copy it concurrently.  Values made in a
+  // Value::ThreadConfinedScope do not count references atomically.
+  static bool IsShareable(const Value& value) {
+    if (!value.is_valid() || value.is_null()) return true;
+    switch (value.type_kind()) {
+      case TYPE_STRING:
+      case TYPE_BYTES:
+      case TYPE_NUMERIC:
+      case TYPE_GEOGRAPHY:
+      case TYPE_ARRAY:
+      case TYPE_STRUCT:
+      case TYPE_PROTO:
+        return false;
+      default:
+        return true;
+    }
+  }
+
+  bool Find(const google::protobuf::FieldDescriptor* field, bool ignore_annotations,
+            const Type** type, Value* default_value) LOCKS_EXCLUDED(mutex_) {
+    absl::ReaderMutexLock l(&mutex_);
+    const auto it = entries_.find(std::make_pair(field, ignore_annotations));
+    if (it == entries_.end()) return false;
+    *type = it->second.type;
+    *default_value = it->second.default_value;
+    return true;
+  }
+
+  void Insert(const google::protobuf::FieldDescriptor* field, bool ignore_annotations,
+              const Type* type, const Value& default_value)
+      LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock l(&mutex_);
+    entries_.emplace(std::make_pair(field, ignore_annotations),
+                     TypeAndDefault{type, default_value});
+  }
+
+ private:
+  absl::Mutex mutex_;
+  absl::flat_hash_map<std::pair<const google::protobuf::FieldDescriptor*, bool>,
+                      TypeAndDefault>
+      entries_ GUARDED_BY(mutex_);
+};
+
+}  // namespace
+
 static zetasql_base::Status GetProtoFieldTypeAndDefaultImpl(
     const google::protobuf::FieldDescriptor* field, bool ignore_annotations,
     TypeFactory* type_factory, const Type** type, Value* default_value) {
+    const bool cacheable = default_value != nullptr &&
+                           GeneratedPoolFieldCache::IsCacheable(field);
+    if (cacheable && GeneratedPoolFieldCache::Get()->Find(
+                         field, ignore_annotations, type, default_value)) {
+      return ::zetasql_base::OkStatus();
+    }
     ZETASQL_RETURN_IF_ERROR(
         type_factory->GetProtoFieldType(ignore_annotations, field, type));
     if (default_value != nullptr) {
@@ -293,6 +372,10 @@ static zetasql_base::Status GetProtoFieldTypeAndDefaultImpl(
         << (*type)->DebugString() << "\n" << field->DebugString();
   }
 
+  if (cacheable && GeneratedPoolFieldCache::IsShareable(*default_value)) {
+    GeneratedPoolFieldCache::Get()->Insert(field, ignore_annotations, *type,
+                                           *default_value);
+  }
   return ::zetasql_base::OkStatus();
 }
 
@@ -385,7 +468,7 @@ using WireValueType = absl::variant<
 static bool ReadWireValue(
     google::protobuf::FieldDescriptor::Type field_type,
     uint32_t tag_and_type,
-    const std::string& bytes,
+    absl::string_view bytes,
     google::protobuf::io::CodedInputStream* in,
     WireValueType* value) {
   int32_t i32;
@@ -537,7 +620,7 @@ static bool ReadWireValue(
               WireFormatLite::WIRETYPE_END_GROUP));
       const int group_size =
           in->CurrentPosition() - start_position - end_group_tag_size;
-      *value = bytes.substr(start_position, group_size);
+      *value = std::string(bytes.substr(start_position, group_size));
       return true;
     }
   }
@@ -731,7 +814,7 @@ static bool ReadPackedWireValues(int tag_number,
     return false;
   }
   // Only primitive numeric/enum values can be packed.
-  std::string unused_bytes;
+  const absl::string_view unused_bytes;
   google::protobuf::io::CodedInputStream::Limit limit = in->PushLimit(length);
   uint32_t tag_and_type = WireFormatLite::MakeTag(
       tag_number, WireFormatLite::WireTypeForFieldType(
@@ -751,7 +834,7 @@ static bool ReadPackedWireValues(int tag_number,
 // Optimized version of ReadProtoFields where only one field is being fetched.
 static zetasql_base::StatusOr<Value> ReadSingularProtoField(
     const ProtoFieldInfo& field_info,
-    const std::string& bytes) {
+    absl::string_view bytes) {
   const int field_info_tag = field_info.descriptor->number();
 
   // The elements we have seen for 'field_info'. Only used if
@@ -851,7 +934,7 @@ using ElementValueList = std::vector<std::vector<zetasql_base::StatusOr<Value>>>
 
 zetasql_base::Status ReadProtoFields(
     absl::Span<const ProtoFieldInfo* const> field_infos,
-    const std::string& bytes,
+    absl::string_view bytes,
     ProtoFieldValueList* field_value_list) {
   const bool use_optimization = (field_infos.size() == 1);
   if (use_optimization) {
@@ -1018,6 +1101,155 @@ zetasql_base::Status ReadProtoField(
                         output_value);
 }
 
+// Finds the bytes of the message reached by following 'path' from 'bytes'.
+// Sets '*present' to false if a message along 'path' is missing, in which case
+// 'submessage_bytes' is not set.  As in ReadSingularProtoField(), the last
+// occurrence of each message field wins.
+static zetasql_base::Status FindSubmessageBytes(
+    absl::Span<const google::protobuf::FieldDescriptor* const> path,
+    absl::string_view bytes, absl::string_view* submessage_bytes,
+    bool* present) {
+  for (const google::protobuf::FieldDescriptor* field : path) {
+    ZETASQL_RET_CHECK(field->type() == google::protobuf::FieldDescriptor::TYPE_MESSAGE ||
+              field->type() == google::protobuf::FieldDescriptor::TYPE_GROUP)
+        << field->DebugString();
+    ZETASQL_RET_CHECK(!field->is_repeated()) << field->DebugString();
+    const int field_tag = field->number();
+    bool found = false;
+    absl::string_view found_bytes;
+    google::protobuf::io::ArrayInputStream stream(bytes.data(), bytes.size());
+    google::protobuf::io::CodedInputStream in(&stream);
+    uint32_t tag_and_type;
+    while (0 < (tag_and_type = in.ReadTag())) {
+      if (WireFormatLite::GetTagFieldNumber(tag_and_type) != field_tag) {
+        if (ABSL_PREDICT_TRUE(WireFormatLite::SkipField(&in, tag_and_type))) {
+          continue;
+        }
+        return ::zetasql_base::OutOfRangeErrorBuilder(ZETASQL_LOC)
+               << "Corrupted protocol buffer: "
+               << "Failed to skip field with tag number "
+               << WireFormatLite::GetTagFieldNumber(tag_and_type) << " in "
+               << field->containing_type()->full_name();
+      }
+      const WireFormatLite::WireType wire_type =
+          WireFormatLite::GetTagWireType(tag_and_type);
+      bool ok = false;
+      if (field->type() == google::protobuf::FieldDescriptor::TYPE_MESSAGE) {
+        int length;
+        if (wire_type == WireFormatLite::WIRETYPE_LENGTH_DELIMITED &&
+            in.ReadVarintSizeAsInt(&length) &&
+            length <= bytes.size() - in.CurrentPosition()) {
+          found_bytes = bytes.substr(in.CurrentPosition(), length);
+          ok = in.Skip(length);
+        }
+      } else {
+        const int start_position = in.CurrentPosition();
+        if (WireFormatLite::SkipField(&in, tag_and_type)) {
+          const int end_group_tag_size =
+              google::protobuf::io::CodedOutputStream::VarintSize32(WireFormatLite::MakeTag(
+                  field_tag, WireFormatLite::WIRETYPE_END_GROUP));
+          found_bytes = bytes.substr(
+              start_position,
+              in.CurrentPosition() - start_position - end_group_tag_size);
+          ok = true;
+        }
+      }
+      if (ABSL_PREDICT_FALSE(!ok)) {
+        return zetasql_base::OutOfRangeErrorBuilder(ZETASQL_LOC)
+               << "Corrupted protocol buffer: Failed to read value for field "
+               << field->full_name();
+      }
+      found = true;
+    }
+    if (!found) {
+      if (ABSL_PREDICT_FALSE(field->is_required())) {
+        return zetasql_base::OutOfRangeErrorBuilder(ZETASQL_LOC)
+               << "Protocol buffer missing required field "
+               << field->full_name();
+      }
+      *present = false;
+      return zetasql_base::OkStatus();
+    }
+    bytes = found_bytes;
+  }
+  *submessage_bytes = bytes;
+  *present = true;
+  return zetasql_base::OkStatus();
+}
+
+zetasql_base::Status ReadProtoFieldsAtPath(
+    absl::Span<const google::protobuf::FieldDescriptor* const> path,
+    absl::Span<const ProtoFieldInfo* const> field_infos,
+    absl::string_view bytes,
+    ProtoFieldValueList* field_value_list) {
+  ZETASQL_RET_CHECK(!field_infos.empty());
+  absl::string_view submessage_bytes;
+  bool present;
+  ZETASQL_RETURN_IF_ERROR(
+      FindSubmessageBytes(path, bytes, &submessage_bytes, &present));
+  if (present) {
+    return ReadProtoFields(field_infos, submessage_bytes, field_value_list);
+  }
+  // Reading a field of a NULL message gives NULL.
+  for (const ProtoFieldInfo* info : field_infos) {
+    field_value_list->push_back(info->get_has_bit ? Value::NullBool()
+                                                  : Value::Null(info->type));
+  }
+  return zetasql_base::OkStatus();
+}
+
+// Gives ReadProtoFieldsFromValue() access to the field cache in
+// Value::ProtoRep.
+struct ProtoFieldCache {
+  static const Value::ProtoRep* GetRep(const Value& value) {
+    return value.proto_ptr_;
+  }
+};
+
+zetasql_base::Status ReadProtoFieldsFromValue(
+    absl::Span<const ProtoFieldInfo* const> field_infos,
+    const Value& proto_value,
+    ProtoFieldValueList* field_value_list) {
+  ZETASQL_RET_CHECK(proto_value.type()->IsProto());
+  ZETASQL_RET_CHECK(!proto_value.is_null());
+  const Value::ProtoRep* rep = ProtoFieldCache::GetRep(proto_value);
+
+  const int start = field_value_list->size();
+  field_value_list->resize(start + field_infos.size());
+  std::vector<Value::ProtoRep::CachedField> missing_fields;
+  std::vector<const ProtoFieldInfo*> missing_infos;
+  std::vector<int> missing_idxs;
+  for (int i = 0; i < field_infos.size(); ++i) {
+    const ProtoFieldInfo* info = field_infos[i];
+    Value::ProtoRep::CachedField field{info->descriptor, info->format,
+                                       info->type, info->get_has_bit,
+                                       info->default_value, Value()};
+    Value value;
+    if (rep->LookupField(field, &value)) {
+      (*field_value_list)[start + i] = std::move(value);
+    } else {
+      missing_fields.push_back(std::move(field));
+      missing_infos.push_back(info);
+      missing_idxs.push_back(start + i);
+    }
+  }
+  if (missing_infos.empty()) return zetasql_base::OkStatus();
+
+  ProtoFieldValueList missing_values;
+  ZETASQL_RETURN_IF_ERROR(
+      ReadProtoFields(missing_infos, rep->value(), &missing_values));
+  ZETASQL_RET_CHECK_EQ(missing_values.size(), missing_infos.size());
+  for (int i = 0; i < missing_values.size(); ++i) {
+    // Errors are not cached; they are rare and cheap enough to recompute.
+    if (missing_values[i].ok()) {
+      missing_fields[i].value = missing_values[i].ValueOrDie();
+      rep->AddField(std::move(missing_fields[i]));
+    }
+    (*field_value_list)[missing_idxs[i]] = std::move(missing_values[i]);
+  }
+  return zetasql_base::OkStatus();
+}
+
 zetasql_base::Status ProtoHasField(
     int32_t field_tag,
     const std::string& bytes,
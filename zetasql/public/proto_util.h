@@ -25,6 +25,8 @@
 #include "zetasql/public/value.h"
 #include <cstdint>
 #include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "zetasql/base/status.h"
 #include "zetasql/base/statusor.h"
 
@@ -114,7 +116,35 @@ using ProtoFieldValueList = std::vector<zetasql_base::StatusOr<Value>>;
 // proto of the common google::protobuf::Descriptor.
 zetasql_base::Status ReadProtoFields(
     absl::Span<const ProtoFieldInfo* const> field_infos,
-    const std::string& bytes,
+    absl::string_view bytes,
+    ProtoFieldValueList* field_value_list);
+
+// Same as ReadProtoFields(), but reads the fields from the message reached by
+// following 'path' from 'bytes', as a chain of GetProtoField accesses would.
+// 'path' is a sequence of non-repeated message or group fields, each a field
+// of the message type of the previous one (the first one of the message type
+// of 'bytes'), and 'field_infos' are fields of the message type of the last
+// one. Only the wire format of the messages along 'path' is scanned, and the
+// submessages are neither parsed nor copied. If an optional message along
+// 'path' is missing, every output is NULL (of type Bool for has bits); a
+// missing required message is an error. As in ReadProtoFields(), the last
+// occurrence of each message along 'path' is used.
+zetasql_base::Status ReadProtoFieldsAtPath(
+    absl::Span<const google::protobuf::FieldDescriptor* const> path,
+    absl::Span<const ProtoFieldInfo* const> field_infos,
+    absl::string_view bytes,
+    ProtoFieldValueList* field_value_list);
+
+// Same as ReadProtoFields(), but reads from the non-NULL proto 'proto_value'
+// and appends the outputs to 'field_value_list'. Successfully decoded fields
+// are cached inside 'proto_value' (and shared by its copies), so reading the
+// same fields again does not rescan the bytes. The cache is bounded by
+// proto_value.physical_byte_size(); fields that do not fit are decoded on
+// every call. Thread-safe for a 'proto_value' that has been shared across
+// threads.
+zetasql_base::Status ReadProtoFieldsFromValue(
+    absl::Span<const ProtoFieldInfo* const> field_infos,
+    const Value& proto_value,
     ProtoFieldValueList* field_value_list);
 
 // Convenience form of ReadProtoFields() for reading a single field. Reads the
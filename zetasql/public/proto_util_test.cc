@@ -766,8 +766,205 @@ TEST_P(ReadProtoFieldsTest, SameFieldWithTwoFormats) {
   EXPECT_THAT(value_list[1], IsOkAndHolds(values::Date(10)));
 }
 
+TEST_P(ReadProtoFieldsTest, FieldsAtPath) {
+  const google::protobuf::FieldDescriptor* nested_value =
+      kitchen_sink_.GetDescriptor()->FindFieldByName("nested_value");
+  ASSERT_TRUE(nested_value != nullptr);
+  const google::protobuf::Descriptor* nested_descriptor =
+      nested_value->message_type();
+
+  ProtoFieldInfo int64_info;
+  int64_info.descriptor = nested_descriptor->FindFieldByName("nested_int64");
+  ASSERT_TRUE(int64_info.descriptor != nullptr);
+  int64_info.format = FieldFormat_Format_DEFAULT_FORMAT;
+  int64_info.type = types::Int64Type();
+  int64_info.default_value = values::Int64(88);
+
+  ProtoFieldInfo repeated_info;
+  repeated_info.descriptor =
+      nested_descriptor->FindFieldByName("nested_repeated_int64");
+  ASSERT_TRUE(repeated_info.descriptor != nullptr);
+  repeated_info.format = FieldFormat_Format_DEFAULT_FORMAT;
+  repeated_info.type = types::Int64ArrayType();
+  repeated_info.default_value = Value::Array(types::Int64ArrayType(), {});
+
+  ProtoFieldInfo has_info = int64_info;
+  has_info.get_has_bit = true;
+
+  // A missing message along the path gives NULLs.
+  std::string bytes;
+  kitchen_sink_.set_int64_val(5);
+  kitchen_sink_.SerializePartialToString(&bytes);
+  ProtoFieldValueList value_list;
+  ZETASQL_ASSERT_OK(ReadProtoFieldsAtPath({nested_value},
+                                  {&int64_info, &repeated_info, &has_info},
+                                  bytes, &value_list));
+  ASSERT_EQ(value_list.size(), 3);
+  EXPECT_THAT(value_list[0], IsOkAndHolds(values::NullInt64()));
+  EXPECT_THAT(value_list[1],
+              IsOkAndHolds(Value::Null(types::Int64ArrayType())));
+  EXPECT_THAT(value_list[2], IsOkAndHolds(values::NullBool()));
+
+  // A present but empty message gives the defaults.
+  kitchen_sink_.mutable_nested_value();
+  kitchen_sink_.SerializePartialToString(&bytes);
+  value_list.clear();
+  ZETASQL_ASSERT_OK(ReadProtoFieldsAtPath({nested_value},
+                                  {&int64_info, &repeated_info, &has_info},
+                                  bytes, &value_list));
+  ASSERT_EQ(value_list.size(), 3);
+  EXPECT_THAT(value_list[0], IsOkAndHolds(values::Int64(88)));
+  EXPECT_THAT(value_list[1],
+              IsOkAndHolds(Value::Array(types::Int64ArrayType(), {})));
+  EXPECT_THAT(value_list[2], IsOkAndHolds(values::Bool(false)));
+
+  kitchen_sink_.mutable_nested_value()->set_nested_int64(10);
+  kitchen_sink_.mutable_nested_value()->add_nested_repeated_int64(100);
+  kitchen_sink_.mutable_nested_value()->add_nested_repeated_int64(200);
+  kitchen_sink_.SerializePartialToString(&bytes);
+  value_list.clear();
+  ZETASQL_ASSERT_OK(ReadProtoFieldsAtPath({nested_value},
+                                  {&int64_info, &repeated_info, &has_info},
+                                  bytes, &value_list));
+  ASSERT_EQ(value_list.size(), 3);
+  EXPECT_THAT(value_list[0], IsOkAndHolds(values::Int64(10)));
+  EXPECT_THAT(value_list[1],
+              IsOkAndHolds(Value::Array(
+                  types::Int64ArrayType(),
+                  {values::Int64(100), values::Int64(200)})));
+  EXPECT_THAT(value_list[2], IsOkAndHolds(values::Bool(true)));
+
+  // An empty path reads from the top-level message.
+  ProtoFieldInfo top_info = int64_info;
+  top_info.descriptor =
+      kitchen_sink_.GetDescriptor()->FindFieldByName("int64_val");
+  top_info.default_value = values::Int64(0);
+  value_list.clear();
+  ZETASQL_ASSERT_OK(ReadProtoFieldsAtPath({}, {&top_info}, bytes, &value_list));
+  ASSERT_EQ(value_list.size(), 1);
+  EXPECT_THAT(value_list[0], IsOkAndHolds(values::Int64(5)));
+}
+
+TEST_P(ReadProtoFieldsTest, FieldsAtPathThroughGroup) {
+  const google::protobuf::FieldDescriptor* group_field =
+      kitchen_sink_.GetDescriptor()->FindFieldByName("optionalgroup");
+  ASSERT_TRUE(group_field != nullptr);
+
+  ProtoFieldInfo info;
+  info.descriptor = group_field->message_type()->FindFieldByName("string_val");
+  ASSERT_TRUE(info.descriptor != nullptr);
+  info.format = FieldFormat_Format_DEFAULT_FORMAT;
+  info.type = types::StringType();
+  info.default_value = values::String("");
+
+  kitchen_sink_.mutable_optionalgroup()->set_int64_val(10);
+  kitchen_sink_.mutable_optionalgroup()->set_string_val("foo");
+  kitchen_sink_.set_int64_val(20);
+  std::string bytes;
+  kitchen_sink_.SerializePartialToString(&bytes);
+
+  ProtoFieldValueList value_list;
+  ZETASQL_ASSERT_OK(
+      ReadProtoFieldsAtPath({group_field}, {&info}, bytes, &value_list));
+  ASSERT_EQ(value_list.size(), 1);
+  EXPECT_THAT(value_list[0], IsOkAndHolds(values::String("foo")));
+}
+
+TEST_P(ReadProtoFieldsTest, FieldsFromValue) {
+  kitchen_sink_.set_int64_key_1(1);
+  kitchen_sink_.set_int64_val(20);
+  std::string bytes;
+  kitchen_sink_.SerializePartialToString(&bytes);
+
+  const ProtoType* proto_type;
+  ZETASQL_ASSERT_OK(type_factory_.MakeProtoType(kitchen_sink_.GetDescriptor(),
+                                        &proto_type));
+  const Value proto_value = Value::Proto(proto_type, bytes);
+
+  ProtoFieldInfo val_info;
+  val_info.descriptor =
+      kitchen_sink_.GetDescriptor()->FindFieldByName("int64_val");
+  ASSERT_TRUE(val_info.descriptor != nullptr);
+  val_info.format = FieldFormat_Format_DEFAULT_FORMAT;
+  val_info.type = types::Int64Type();
+  val_info.default_value = values::Int64(0);
+
+  ProtoFieldInfo missing_info = val_info;
+  missing_info.descriptor =
+      kitchen_sink_.GetDescriptor()->FindFieldByName("uint64_val");
+  ASSERT_TRUE(missing_info.descriptor != nullptr);
+  missing_info.type = types::Uint64Type();
+  missing_info.default_value = values::Uint64(0);
+
+  ProtoFieldInfo has_info = val_info;
+  has_info.get_has_bit = true;
+
+  // Read twice, the second time from a copy, which shares the cache.
+  for (const Value& value : {proto_value, Value(proto_value)}) {
+    ProtoFieldValueList value_list;
+    ZETASQL_ASSERT_OK(ReadProtoFieldsFromValue(
+        {&val_info, &missing_info, &has_info}, value, &value_list));
+    ASSERT_EQ(value_list.size(), 3);
+    EXPECT_THAT(value_list[0], IsOkAndHolds(values::Int64(20)));
+    EXPECT_THAT(value_list[1], IsOkAndHolds(values::Uint64(0)));
+    EXPECT_THAT(value_list[2], IsOkAndHolds(values::Bool(true)));
+  }
+
+  // A different default value is a different field access.
+  missing_info.default_value = values::Uint64(7);
+  ProtoFieldValueList value_list;
+  ZETASQL_ASSERT_OK(
+      ReadProtoFieldsFromValue({&missing_info}, proto_value, &value_list));
+  ASSERT_EQ(value_list.size(), 1);
+  EXPECT_THAT(value_list[0], IsOkAndHolds(values::Uint64(7)));
+
+  // Errors are reported every time.
+  ProtoFieldInfo required_info = val_info;
+  required_info.descriptor =
+      kitchen_sink_.GetDescriptor()->FindFieldByName("int64_key_2");
+  for (int i = 0; i < 2; ++i) {
+    value_list.clear();
+    ZETASQL_ASSERT_OK(
+        ReadProtoFieldsFromValue({&required_info}, proto_value, &value_list));
+    ASSERT_EQ(value_list.size(), 1);
+    EXPECT_THAT(value_list[0],
+                StatusIs(zetasql_base::OUT_OF_RANGE,
+                         HasSubstr("Protocol buffer missing required field")));
+  }
+}
+
 INSTANTIATE_TEST_SUITE_P(ReadProtoFieldsTestInstantiation, ReadProtoFieldsTest,
                          ::testing::Values(false, true));
 
+TEST(GetProtoFieldTypeAndDefaultTest, RepeatedLookupsAgree) {
+  const google::protobuf::FieldDescriptor* date_field =
+      KitchenSinkPB::descriptor()->FindFieldByName("date_default");
+  const google::protobuf::FieldDescriptor* repeated_field =
+      KitchenSinkPB::descriptor()->FindFieldByName("repeated_int32_val");
+  ASSERT_NE(date_field, nullptr);
+  ASSERT_NE(repeated_field, nullptr);
+  for (int i = 0; i < 2; ++i) {
+    // Each lookup uses a new TypeFactory, as separate analyses would.
+    TypeFactory type_factory;
+    const Type* type;
+    Value default_value;
+    ZETASQL_ASSERT_OK(GetProtoFieldTypeAndDefault(date_field, &type_factory, &type,
+                                          &default_value));
+    EXPECT_TRUE(type->IsDate());
+    EXPECT_EQ(values::Date(10950), default_value);
+
+    ZETASQL_ASSERT_OK(GetProtoFieldTypeAndDefaultRaw(date_field, &type_factory, &type,
+                                             &default_value));
+    EXPECT_TRUE(type->IsInt32());
+    EXPECT_EQ(values::Int32(10950), default_value);
+
+    ZETASQL_ASSERT_OK(GetProtoFieldTypeAndDefault(repeated_field, &type_factory,
+                                          &type, &default_value));
+    ASSERT_TRUE(type->IsArray());
+    EXPECT_TRUE(type->AsArray()->element_type()->IsInt32());
+    EXPECT_EQ(values::EmptyArray(type->AsArray()), default_value);
+  }
+}
+
 }  // namespace
 }  // namespace zetasql
@@ -16,7 +16,9 @@
 
 #include "zetasql/public/proto_value_conversion.h"
 
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "google/protobuf/descriptor.pb.h"
@@ -31,6 +33,7 @@
 #include "zetasql/public/value.h"
 #include "zetasql/public/value.pb.h"
 #include <cstdint>
+#include "absl/memory/memory.h"
 #include "absl/strings/string_view.h"
 #include "zetasql/base/source_location.h"
 #include "zetasql/base/ret_check.h"
@@ -474,74 +477,14 @@ zetasql_base::Status ConvertStructOrArrayValueToProtoMessage(
                    << value.DebugString();
 }
 
-static zetasql_base::Status ProtoToStructValue(const google::protobuf::Message& proto,
-                                       const Type* type,
-                                       bool use_wire_format_annotations,
-                                       Value* value_out);
-
-// Mutually recursive with ProtoToStructValue.
-zetasql_base::Status ProtoFieldToValue(const google::protobuf::Message& proto,
-                               const google::protobuf::FieldDescriptor* field, int index,
-                               const Type* type,
-                               bool use_wire_format_annotations,
-                               Value* value_out) {
-  ZETASQL_RET_CHECK_NE(nullptr, value_out);
-  const google::protobuf::Reflection* reflection = proto.GetReflection();
-
-  const FieldFormat::Format field_format =
-      ProtoType::GetFormatAnnotation(field);
-  if (!type->IsDate() && !type->IsTimestamp() && !type->IsArray() &&
-      !type->IsTime() && !type->IsDatetime() && !type->IsGeography() &&
-      type->kind() != TYPE_NUMERIC) {
-    ZETASQL_RET_CHECK_EQ(FieldFormat::DEFAULT_FORMAT, field_format)
-        << "Format " << FieldFormat::Format_Name(field_format)
-        << " not supported for zetasql type " << type->DebugString();
-  }
-
-  bool is_wrapper = use_wire_format_annotations;
-  if (use_wire_format_annotations) {
-    ZETASQL_RETURN_IF_ERROR(ShouldTreatAsWrapperForType(field, type, &is_wrapper));
-  }
-  if (is_wrapper) {
-    // Special case for handling NULL arrays.  NULL arrays are indicated
-    // by the absence of a wrapper.  NULL non-arrays are indicated by the
-    // absence of the field within the wrapper.
-    if (type->IsArray()) {
-      ZETASQL_RET_CHECK(!field->is_repeated()) << field->DebugString();
-      if (!reflection->HasField(proto, field)) {
-        *value_out = Value::Null(type);
-        return ::zetasql_base::OkStatus();
-      }
-    }
-
-    ZETASQL_RET_CHECK_EQ(google::protobuf::FieldDescriptor::TYPE_MESSAGE, field->type())
-        << field->DebugString();
-    const google::protobuf::Message& wrapper = field->is_repeated() ?
-        reflection->GetRepeatedMessage(proto, field, index) :
-        reflection->GetMessage(proto, field);
-    const google::protobuf::Descriptor* wrapper_descriptor =
-        wrapper.GetDescriptor();
-    ZETASQL_RET_CHECK_EQ(1, wrapper_descriptor->field_count());
-    const google::protobuf::FieldDescriptor* unwrapped_field =
-        wrapper_descriptor->field(0);
-    return ProtoFieldToValue(wrapper, unwrapped_field, -1 /* index */, type,
-                             use_wire_format_annotations, value_out);
-  }
-
-  // If a non-repeated field is missing, the value is NULL.
-  if (!field->is_repeated()) {
-    ZETASQL_RET_CHECK_EQ(-1, index) << field->DebugString();
-    if (!reflection->HasField(proto, field)) {
-      *value_out = Value::Null(type);
-      return ::zetasql_base::OkStatus();
-    }
-  } else if (!type->IsArray()) {
-    // If the field is repeated, then we'll need to know the index we're
-    // looking at.  Except when we are expecting an array, in which case
-    // we will look at all members of the repeated field.
-    ZETASQL_RET_CHECK_GE(index, 0) << field->DebugString();
-  }
-
+// Populates 'value_out' with the Value of type 'type' of a present field that
+// does not need to be unwrapped.  'type' must not be an ARRAY or a STRUCT.
+// 'reflection' and 'field_format' are those of 'proto' and 'field'.  'index'
+// is the index of the element to read if 'field' is repeated.
+static zetasql_base::Status ProtoScalarFieldToValue(
+    const google::protobuf::Message& proto, const google::protobuf::Reflection* reflection,
+    const google::protobuf::FieldDescriptor* field, int index, const Type* type,
+    FieldFormat::Format field_format, Value* value_out) {
   switch (type->kind()) {
     case TypeKind::TYPE_ENUM: {
       ZETASQL_RET_CHECK_EQ(google::protobuf::FieldDescriptor::CPPTYPE_ENUM, field->cpp_type())
@@ -649,33 +592,6 @@ zetasql_base::Status ProtoFieldToValue(const google::protobuf::Message& proto,
           reflection->GetString(proto, field));
       return ::zetasql_base::OkStatus();
     }
-    case TypeKind::TYPE_ARRAY: {
-      // Array wrappers should have been handled above, so we can assert
-      // that we have a repeated field.
-      ZETASQL_RET_CHECK(field->is_repeated());
-      ZETASQL_RET_CHECK_EQ(-1, index);
-      const ArrayType* array_type = type->AsArray();
-      const int num_elements = reflection->FieldSize(proto, field);
-      std::vector<Value> values(num_elements);
-      for (int i = 0; i < num_elements; ++i) {
-        ZETASQL_RETURN_IF_ERROR(
-            ProtoFieldToValue(proto, field, i, array_type->element_type(),
-                              use_wire_format_annotations, &values[i]));
-      }
-      *value_out = Value::Array(array_type, values);
-      return ::zetasql_base::OkStatus();
-    }
-    case TypeKind::TYPE_STRUCT: {
-      ZETASQL_RET_CHECK_EQ(google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE, field->cpp_type())
-          << field->DebugString();
-      const google::protobuf::Message& submessage =
-          field->is_repeated() ?
-          reflection->GetRepeatedMessage(proto, field, index) :
-          reflection->GetMessage(proto, field);
-      ZETASQL_RETURN_IF_ERROR(ProtoToStructValue(
-          submessage, type, use_wire_format_annotations, value_out));
-      return ::zetasql_base::OkStatus();
-    }
     case TypeKind::TYPE_INT32: {
       ZETASQL_RET_CHECK_EQ(google::protobuf::FieldDescriptor::CPPTYPE_INT32, field->cpp_type())
           << field->DebugString();
@@ -799,6 +715,108 @@ zetasql_base::Status ProtoFieldToValue(const google::protobuf::Message& proto,
   }
 }
 
+static zetasql_base::Status ProtoToStructValue(const google::protobuf::Message& proto,
+                                       const Type* type,
+                                       bool use_wire_format_annotations,
+                                       Value* value_out);
+
+// Mutually recursive with ProtoToStructValue.
+zetasql_base::Status ProtoFieldToValue(const google::protobuf::Message& proto,
+                               const google::protobuf::FieldDescriptor* field, int index,
+                               const Type* type,
+                               bool use_wire_format_annotations,
+                               Value* value_out) {
+  ZETASQL_RET_CHECK_NE(nullptr, value_out);
+  const google::protobuf::Reflection* reflection = proto.GetReflection();
+
+  const FieldFormat::Format field_format =
+      ProtoType::GetFormatAnnotation(field);
+  if (!type->IsDate() && !type->IsTimestamp() && !type->IsArray() &&
+      !type->IsTime() && !type->IsDatetime() && !type->IsGeography() &&
+      type->kind() != TYPE_NUMERIC) {
+    ZETASQL_RET_CHECK_EQ(FieldFormat::DEFAULT_FORMAT, field_format)
+        << "Format " << FieldFormat::Format_Name(field_format)
+        << " not supported for zetasql type " << type->DebugString();
+  }
+
+  bool is_wrapper = use_wire_format_annotations;
+  if (use_wire_format_annotations) {
+    ZETASQL_RETURN_IF_ERROR(ShouldTreatAsWrapperForType(field, type, &is_wrapper));
+  }
+  if (is_wrapper) {
+    // Special case for handling NULL arrays.  NULL arrays are indicated
+    // by the absence of a wrapper.  NULL non-arrays are indicated by the
+    // absence of the field within the wrapper.
+    if (type->IsArray()) {
+      ZETASQL_RET_CHECK(!field->is_repeated()) << field->DebugString();
+      if (!reflection->HasField(proto, field)) {
+        *value_out = Value::Null(type);
+        return ::zetasql_base::OkStatus();
+      }
+    }
+
+    ZETASQL_RET_CHECK_EQ(google::protobuf::FieldDescriptor::TYPE_MESSAGE, field->type())
+        << field->DebugString();
+    const google::protobuf::Message& wrapper = field->is_repeated() ?
+        reflection->GetRepeatedMessage(proto, field, index) :
+        reflection->GetMessage(proto, field);
+    const google::protobuf::Descriptor* wrapper_descriptor =
+        wrapper.GetDescriptor();
+    ZETASQL_RET_CHECK_EQ(1, wrapper_descriptor->field_count());
+    const google::protobuf::FieldDescriptor* unwrapped_field =
+        wrapper_descriptor->field(0);
+    return ProtoFieldToValue(wrapper, unwrapped_field, -1 /* index */, type,
+                             use_wire_format_annotations, value_out);
+  }
+
+  // If a non-repeated field is missing, the value is NULL.
+  if (!field->is_repeated()) {
+    ZETASQL_RET_CHECK_EQ(-1, index) << field->DebugString();
+    if (!reflection->HasField(proto, field)) {
+      *value_out = Value::Null(type);
+      return ::zetasql_base::OkStatus();
+    }
+  } else if (!type->IsArray()) {
+    // If the field is repeated, then we'll need to know the index we're
+    // looking at.  Except when we are expecting an array, in which case
+    // we will look at all members of the repeated field.
+    ZETASQL_RET_CHECK_GE(index, 0) << field->DebugString();
+  }
+
+  switch (type->kind()) {
+    case TypeKind::TYPE_ARRAY: {
+      // Array wrappers should have been handled above, so we can assert
+      // that we have a repeated field.
+      ZETASQL_RET_CHECK(field->is_repeated());
+      ZETASQL_RET_CHECK_EQ(-1, index);
+      const ArrayType* array_type = type->AsArray();
+      const int num_elements = reflection->FieldSize(proto, field);
+      std::vector<Value> values(num_elements);
+      for (int i = 0; i < num_elements; ++i) {
+        ZETASQL_RETURN_IF_ERROR(
+            ProtoFieldToValue(proto, field, i, array_type->element_type(),
+                              use_wire_format_annotations, &values[i]));
+      }
+      *value_out = Value::UnsafeArray(array_type, std::move(values));
+      return ::zetasql_base::OkStatus();
+    }
+    case TypeKind::TYPE_STRUCT: {
+      ZETASQL_RET_CHECK_EQ(google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE, field->cpp_type())
+          << field->DebugString();
+      const google::protobuf::Message& submessage =
+          field->is_repeated() ?
+          reflection->GetRepeatedMessage(proto, field, index) :
+          reflection->GetMessage(proto, field);
+      ZETASQL_RETURN_IF_ERROR(ProtoToStructValue(
+          submessage, type, use_wire_format_annotations, value_out));
+      return ::zetasql_base::OkStatus();
+    }
+    default:
+      return ProtoScalarFieldToValue(proto, reflection, field, index, type,
+                                     field_format, value_out);
+  }
+}
+
 // Converts 'proto' to a Value of type 'type' and returns it in
 // 'value_out'.  'type' must be a STRUCT type.
 //
@@ -821,7 +839,7 @@ static zetasql_base::Status ProtoToStructValue(const google::protobuf::Message&
                                       use_wire_format_annotations, &values[i]));
   }
 
-  *value_out = Value::Struct(struct_type, values);
+  *value_out = Value::UnsafeStruct(struct_type, std::move(values));
   return ::zetasql_base::OkStatus();
 }
 
@@ -845,4 +863,205 @@ zetasql_base::Status ConvertProtoMessageToStructOrArrayValue(
   ZETASQL_RET_CHECK_FAIL() << type->DebugString();
 }
 
+namespace internal {
+
+// The parts of converting a field to a Value that depend only on the field and
+// the Type, as computed by ProtoFieldToValue() for each message.
+struct ProtoFieldConverter {
+  const google::protobuf::FieldDescriptor* field = nullptr;
+  const Type* type = nullptr;
+  FieldFormat::Format format = FieldFormat::DEFAULT_FORMAT;
+  // Set if 'field' is a wrapper: converts the single field of the wrapper.
+  std::unique_ptr<ProtoFieldConverter> unwrapped;
+  // Set if 'type' is an unwrapped ARRAY: converts each element of 'field'.
+  std::unique_ptr<ProtoFieldConverter> element;
+  // Set if 'type' is a STRUCT: one converter per field of the submessage.
+  std::vector<ProtoFieldConverter> struct_fields;
+};
+
+}  // namespace internal
+
+using internal::ProtoFieldConverter;
+
+// Fills 'converter' with the conversion of 'field' to 'type', doing the checks
+// that ProtoFieldToValue() does with use_wire_format_annotations = true.
+static zetasql_base::Status CompileFieldConverter(
+    const google::protobuf::FieldDescriptor* field, const Type* type,
+    ProtoFieldConverter* converter);
+
+// Fills 'converters' with the conversion of each field of 'descriptor' to the
+// corresponding field of 'type', which must be a STRUCT.
+static zetasql_base::Status CompileStructFieldConverters(
+    const google::protobuf::Descriptor* descriptor, const Type* type,
+    std::vector<ProtoFieldConverter>* converters) {
+  const StructType* struct_type = type->AsStruct();
+  ZETASQL_RET_CHECK(struct_type != nullptr) << type->DebugString();
+  ZETASQL_RET_CHECK_EQ(struct_type->num_fields(), descriptor->field_count());
+  converters->resize(descriptor->field_count());
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    ZETASQL_RETURN_IF_ERROR(CompileFieldConverter(
+        descriptor->field(i), struct_type->field(i).type, &(*converters)[i]));
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+static zetasql_base::Status CompileFieldConverter(
+    const google::protobuf::FieldDescriptor* field, const Type* type,
+    ProtoFieldConverter* converter) {
+  converter->field = field;
+  converter->type = type;
+  converter->format = ProtoType::GetFormatAnnotation(field);
+  if (!type->IsDate() && !type->IsTimestamp() && !type->IsArray() &&
+      !type->IsTime() && !type->IsDatetime() && !type->IsGeography() &&
+      type->kind() != TYPE_NUMERIC) {
+    ZETASQL_RET_CHECK_EQ(FieldFormat::DEFAULT_FORMAT, converter->format)
+        << "Format " << FieldFormat::Format_Name(converter->format)
+        << " not supported for zetasql type " << type->DebugString();
+  }
+
+  bool is_wrapper;
+  ZETASQL_RETURN_IF_ERROR(ShouldTreatAsWrapperForType(field, type, &is_wrapper));
+  if (is_wrapper) {
+    if (type->IsArray()) {
+      ZETASQL_RET_CHECK(!field->is_repeated()) << field->DebugString();
+    }
+    ZETASQL_RET_CHECK_EQ(google::protobuf::FieldDescriptor::TYPE_MESSAGE, field->type())
+        << field->DebugString();
+    const google::protobuf::Descriptor* wrapper_descriptor = field->message_type();
+    ZETASQL_RET_CHECK_EQ(1, wrapper_descriptor->field_count());
+    converter->unwrapped = absl::make_unique<ProtoFieldConverter>();
+    return CompileFieldConverter(wrapper_descriptor->field(0), type,
+                                 converter->unwrapped.get());
+  }
+
+  switch (type->kind()) {
+    case TypeKind::TYPE_ARRAY:
+      // Array wrappers are handled above, so this must be a repeated field.
+      ZETASQL_RET_CHECK(field->is_repeated());
+      converter->element = absl::make_unique<ProtoFieldConverter>();
+      return CompileFieldConverter(field, type->AsArray()->element_type(),
+                                   converter->element.get());
+    case TypeKind::TYPE_STRUCT:
+      ZETASQL_RET_CHECK_EQ(google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE, field->cpp_type())
+          << field->DebugString();
+      return CompileStructFieldConverters(field->message_type(), type,
+                                          &converter->struct_fields);
+    default:
+      return ::zetasql_base::OkStatus();
+  }
+}
+
+// Converts the fields of 'proto' with 'converters' into a STRUCT of 'type'.
+static zetasql_base::Status ConvertStructFields(
+    const std::vector<ProtoFieldConverter>& converters,
+    const google::protobuf::Message& proto, const Type* type, Value* value_out);
+
+// Same as ProtoFieldToValue() with use_wire_format_annotations = true, using
+// the checks and lookups already done in 'converter'.
+static zetasql_base::Status ConvertField(
+    const ProtoFieldConverter& converter,
+    const google::protobuf::Message& proto, const google::protobuf::Reflection* reflection,
+    int index, Value* value_out) {
+  const google::protobuf::FieldDescriptor* field = converter.field;
+  const Type* type = converter.type;
+  if (converter.unwrapped != nullptr) {
+    // NULL arrays are indicated by the absence of a wrapper.
+    if (type->IsArray() && !reflection->HasField(proto, field)) {
+      *value_out = Value::Null(type);
+      return ::zetasql_base::OkStatus();
+    }
+    const google::protobuf::Message& wrapper = field->is_repeated() ?
+        reflection->GetRepeatedMessage(proto, field, index) :
+        reflection->GetMessage(proto, field);
+    return ConvertField(*converter.unwrapped, wrapper,
+                        wrapper.GetReflection(), -1 /* index */, value_out);
+  }
+
+  // If a non-repeated field is missing, the value is NULL.
+  if (!field->is_repeated() && !reflection->HasField(proto, field)) {
+    *value_out = Value::Null(type);
+    return ::zetasql_base::OkStatus();
+  }
+
+  switch (type->kind()) {
+    case TypeKind::TYPE_ARRAY: {
+      const int num_elements = reflection->FieldSize(proto, field);
+      std::vector<Value> values(num_elements);
+      for (int i = 0; i < num_elements; ++i) {
+        ZETASQL_RETURN_IF_ERROR(
+            ConvertField(*converter.element, proto, reflection, i, &values[i]));
+      }
+      *value_out = Value::UnsafeArray(type->AsArray(), std::move(values));
+      return ::zetasql_base::OkStatus();
+    }
+    case TypeKind::TYPE_STRUCT: {
+      const google::protobuf::Message& submessage =
+          field->is_repeated() ?
+          reflection->GetRepeatedMessage(proto, field, index) :
+          reflection->GetMessage(proto, field);
+      return ConvertStructFields(converter.struct_fields, submessage, type,
+                                 value_out);
+    }
+    default:
+      return ProtoScalarFieldToValue(proto, reflection, field, index, type,
+                                     converter.format, value_out);
+  }
+}
+
+static zetasql_base::Status ConvertStructFields(
+    const std::vector<ProtoFieldConverter>& converters,
+    const google::protobuf::Message& proto, const Type* type, Value* value_out) {
+  const google::protobuf::Reflection* reflection = proto.GetReflection();
+  std::vector<Value> values(converters.size());
+  for (int i = 0; i < converters.size(); ++i) {
+    ZETASQL_RETURN_IF_ERROR(
+        ConvertField(converters[i], proto, reflection, -1 /* index */,
+                     &values[i]));
+  }
+  *value_out = Value::UnsafeStruct(type->AsStruct(), std::move(values));
+  return ::zetasql_base::OkStatus();
+}
+
+ProtoToValueConverter::ProtoToValueConverter(
+    const google::protobuf::Descriptor* descriptor, const Type* type)
+    : descriptor_(descriptor), type_(type) {}
+
+ProtoToValueConverter::~ProtoToValueConverter() {}
+
+zetasql_base::Status ProtoToValueConverter::Create(
+    const google::protobuf::Descriptor* descriptor, const Type* type,
+    std::unique_ptr<const ProtoToValueConverter>* converter) {
+  ZETASQL_RET_CHECK(descriptor != nullptr);
+  std::unique_ptr<ProtoToValueConverter> new_converter(
+      new ProtoToValueConverter(descriptor, type));
+  if (type->IsStruct()) {
+    ZETASQL_RETURN_IF_ERROR(CompileStructFieldConverters(descriptor, type,
+                                                 &new_converter->fields_));
+  } else if (type->IsArray()) {
+    // At the top level, an ARRAY is always a wrapper.
+    ZETASQL_RET_CHECK(ProtoType::GetIsWrapperAnnotation(descriptor));
+    ZETASQL_RET_CHECK_EQ(1, descriptor->field_count());
+    new_converter->fields_.resize(1);
+    ZETASQL_RETURN_IF_ERROR(CompileFieldConverter(descriptor->field(0), type,
+                                          &new_converter->fields_[0]));
+  } else {
+    ZETASQL_RET_CHECK_FAIL() << type->DebugString();
+  }
+  *converter = std::move(new_converter);
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status ProtoToValueConverter::Convert(const google::protobuf::Message& proto,
+                                            Value* value_out) const {
+  ZETASQL_RET_CHECK_NE(nullptr, value_out);
+  ZETASQL_RET_CHECK(proto.GetDescriptor() == descriptor_)
+      << proto.GetDescriptor()->full_name() << " vs "
+      << descriptor_->full_name();
+  if (type_->IsStruct()) {
+    return ConvertStructFields(fields_, proto, type_, value_out);
+  }
+  return ConvertField(fields_[0], proto, proto.GetReflection(),
+                      -1 /* index */, value_out);
+}
+
 }  // namespace zetasql
@@ -39,6 +39,7 @@
 #include "zetasql/public/value.h"
 #include "zetasql/resolved_ast/resolved_ast.h"
 #include "zetasql/resolved_ast/resolved_node_kind.pb.h"
+#include "zetasql/testdata/test_schema.pb.h"
 #include "zetasql/common/testing/proto_matchers.h"
 #include "zetasql/base/testing/status_matchers.h"
 #include "gmock/gmock.h"
@@ -198,6 +199,16 @@ class ProtoValueConversionTest : public ::testing::Test {
         << "Expression '" << expression_sql
         << "' evaluates to: " << value.DebugString()
         << " which round-trips to: " << round_tripped_value.DebugString();
+
+    // A ProtoToValueConverter must produce the same Value.
+    std::unique_ptr<const ProtoToValueConverter> converter;
+    ZETASQL_ASSERT_OK(ProtoToValueConverter::Create(
+        proto->GetDescriptor(), round_tripped_type, &converter));
+    Value converted_value;
+    ZETASQL_ASSERT_OK(converter->Convert(*proto, &converted_value));
+    ASSERT_TRUE(round_tripped_value.Equals(converted_value))
+        << "Expression '" << expression_sql
+        << "' converts to: " << converted_value.DebugString();
   }
 
   google::protobuf::DescriptorPool descriptor_pool_;
@@ -362,6 +373,76 @@ TEST_F(ProtoValueConversionTest, RoundTrip) {
   }
 }
 
+TEST_F(ProtoValueConversionTest, UnwrappedTypesAreReused) {
+  const Type* array_type;
+  ZETASQL_ASSERT_OK(type_factory_.MakeUnwrappedTypeFromProto(
+      zetasql_test::NullableArrayOfNullableInt::descriptor(), &array_type));
+  EXPECT_EQ("ARRAY<INT32>", array_type->DebugString());
+  const Type* again;
+  ZETASQL_ASSERT_OK(type_factory_.MakeUnwrappedTypeFromProto(
+      zetasql_test::NullableArrayOfNullableInt::descriptor(), &again));
+  EXPECT_EQ(array_type, again);
+
+  // Nested annotated messages unwrap to the same types as on their own.
+  const Type* int_type;
+  ZETASQL_ASSERT_OK(type_factory_.MakeUnwrappedTypeFromProto(
+      zetasql_test::RewrappedNullableInt::descriptor(), &int_type));
+  ZETASQL_ASSERT_OK(type_factory_.MakeUnwrappedTypeFromProto(
+      zetasql_test::NullableInt::descriptor(), &again));
+  EXPECT_EQ(int_type, again);
+  EXPECT_TRUE(int_type->IsInt32());
+
+  // The obsolete timestamp option is part of the key.
+  ZETASQL_ASSERT_OK(type_factory_.MakeUnwrappedTypeFromProto(
+      zetasql_test::KeyValueStruct::descriptor(),
+      /*use_obsolete_timestamp=*/true, &again));
+  const Type* struct_type;
+  ZETASQL_ASSERT_OK(type_factory_.MakeUnwrappedTypeFromProto(
+      zetasql_test::KeyValueStruct::descriptor(), &struct_type));
+  EXPECT_EQ("STRUCT<key STRING, value INT64>", struct_type->DebugString());
+}
+
+TEST_F(ProtoValueConversionTest, StructToProtoDescriptorCache) {
+  const EnumType* enum_type;
+  ZETASQL_ASSERT_OK(type_factory_.MakeEnumType(zetasql_test::TestEnum_descriptor(),
+                                       &enum_type));
+  const ProtoType* proto_type;
+  ZETASQL_ASSERT_OK(type_factory_.MakeProtoType(
+      zetasql_test::KitchenSinkPB::descriptor(), &proto_type));
+  const StructType* struct_type;
+  ZETASQL_ASSERT_OK(type_factory_.MakeStructType(
+      {{"a", types::Int64Type()}, {"e", enum_type}, {"p", proto_type}},
+      &struct_type));
+
+  StructToProtoDescriptorCache cache;
+  const google::protobuf::Descriptor* descriptor;
+  ZETASQL_ASSERT_OK(cache.GetDescriptor(struct_type, &descriptor));
+  EXPECT_EQ(cache.pool(), descriptor->file()->pool());
+  ASSERT_EQ(3, descriptor->field_count());
+  EXPECT_EQ("zetasql_test.KitchenSinkPB",
+            descriptor->field(2)->message_type()->full_name());
+
+  // The same schema from another TypeFactory is converted only once.
+  TypeFactory other_factory;
+  const StructType* same_struct;
+  ZETASQL_ASSERT_OK(other_factory.MakeStructType(
+      {{"a", types::Int64Type()}, {"e", enum_type}, {"p", proto_type}},
+      &same_struct));
+  const google::protobuf::Descriptor* same_descriptor;
+  ZETASQL_ASSERT_OK(cache.GetDescriptor(same_struct, &same_descriptor));
+  EXPECT_EQ(descriptor, same_descriptor);
+
+  // Field names are compared case sensitively.
+  const StructType* renamed_struct;
+  ZETASQL_ASSERT_OK(type_factory_.MakeStructType(
+      {{"A", types::Int64Type()}, {"e", enum_type}, {"p", proto_type}},
+      &renamed_struct));
+  const google::protobuf::Descriptor* renamed_descriptor;
+  ZETASQL_ASSERT_OK(cache.GetDescriptor(renamed_struct, &renamed_descriptor));
+  EXPECT_NE(descriptor, renamed_descriptor);
+  EXPECT_EQ(descriptor->name(), renamed_descriptor->name());
+}
+
 TEST_F(ProtoValueConversionTest, ToProtoDefaultOptions) {
   const ConvertTypeToProtoOptions default_options;
   const std::vector<std::pair<std::string, std::string>> tests = {
@@ -0,0 +1,199 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/query_result_cache.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "zetasql/proto/options.pb.h"
+#include "zetasql/public/catalog.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/statement_fingerprint.h"
+#include "zetasql/public/value.pb.h"
+#include "zetasql/resolved_ast/resolved_node_kind.pb.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "zetasql/base/status.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+namespace {
+
+// Appends <value> to <*key> with its type and a length prefix. Returns false
+// if it cannot be serialized.
+bool AppendValue(const Value& value, std::string* key) {
+  ValueProto value_proto;
+  std::string serialized_value;
+  if (!value.Serialize(&value_proto).ok() ||
+      !value_proto.SerializeToString(&serialized_value)) {
+    return false;
+  }
+  const std::string type = value.type()->DebugString();
+  absl::StrAppend(key, type.size(), ":", type, serialized_value.size(), ":",
+                  serialized_value);
+  return true;
+}
+
+}  // namespace
+
+bool IsDeterministicQuery(const ResolvedStatement* statement) {
+  if (statement->node_kind() != RESOLVED_QUERY_STMT) return false;
+  bool deterministic = true;
+  const auto pre_visit =
+      [&deterministic](
+          const ResolvedNode* node) -> zetasql_base::StatusOr<bool> {
+    switch (node->node_kind()) {
+      case RESOLVED_FUNCTION_CALL:
+      case RESOLVED_AGGREGATE_FUNCTION_CALL:
+      case RESOLVED_ANALYTIC_FUNCTION_CALL: {
+        const Function* function =
+            node->GetAs<ResolvedFunctionCallBase>()->function();
+        if (function->function_options().volatility !=
+            FunctionEnums::IMMUTABLE) {
+          deterministic = false;
+        }
+        break;
+      }
+      case RESOLVED_TVFSCAN:
+        deterministic = false;
+        break;
+      case RESOLVED_SAMPLE_SCAN:
+        if (node->GetAs<ResolvedSampleScan>()->repeatable_argument() ==
+            nullptr) {
+          deterministic = false;
+        }
+        break;
+      default:
+        break;
+    }
+    return deterministic;
+  };
+  return statement->TraverseNonRecursive(pre_visit, nullptr).ok() &&
+         deterministic;
+}
+
+QueryResultCache::QueryResultCache(int max_entries) : cache_(max_entries) {}
+
+QueryResultCache::~QueryResultCache() {}
+
+bool QueryResultCache::MakeKey(absl::string_view sql,
+                               const std::map<std::string, Value>& parameters,
+                               const AnalyzerOptions& options,
+                               SimpleCatalog* catalog,
+                               const TypeFactory* type_factory,
+                               std::string* key) {
+  if (options.lookup_expression_column_callback() != nullptr ||
+      options.ddl_pseudo_columns_callback() != nullptr ||
+      options.column_id_sequence_number() != nullptr) {
+    return false;
+  }
+  FileDescriptorSetMap file_descriptor_set_map;
+  AnalyzerOptionsProto options_proto;
+  std::string serialized_options;
+  if (!options.Serialize(&file_descriptor_set_map, &options_proto).ok() ||
+      !options_proto.SerializeToString(&serialized_options)) {
+    return false;
+  }
+  // The normalized SQL and the literals, rather than the 128-bit
+  // fingerprint alone, so that different queries never share an entry.
+  StatementFingerprint fingerprint;
+  if (!GetStatementFingerprint(sql, &fingerprint).ok()) return false;
+
+  *key = absl::StrCat(absl::Hex(catalog), ",", absl::Hex(type_factory), ",",
+                      catalog->version());
+  for (const auto& entry : file_descriptor_set_map) {
+    absl::StrAppend(key, ",", absl::Hex(entry.first));
+  }
+  absl::StrAppend(key, ";", serialized_options.size(), ":", serialized_options,
+                  fingerprint.normalized_sql.size(), ":",
+                  fingerprint.normalized_sql, fingerprint.literals.size(), ";");
+  for (const Value& literal : fingerprint.literals) {
+    if (!AppendValue(literal, key)) return false;
+  }
+  absl::StrAppend(key, parameters.size(), ";");
+  for (const auto& parameter : parameters) {
+    absl::StrAppend(key, parameter.first.size(), ":", parameter.first);
+    if (!AppendValue(parameter.second, key)) return false;
+  }
+
+  // Names that are not tables, like WITH aliases, are not found, and the
+  // query is not cached.
+  TableNamesSet table_names;
+  if (!ExtractTableNamesFromStatement(sql, options, &table_names).ok()) {
+    return false;
+  }
+  absl::StrAppend(key, table_names.size(), ";");
+  for (const std::vector<std::string>& table_name : table_names) {
+    const Table* table = nullptr;
+    if (!catalog->FindTable(table_name, &table).ok()) return false;
+    const std::string version = table->GetVersionToken();
+    if (version.empty()) return false;
+    // The table itself rather than its name, which may differ in case.
+    absl::StrAppend(key, absl::Hex(table), ",", version.size(), ":", version);
+  }
+  return true;
+}
+
+zetasql_base::Status QueryResultCache::ExecuteQuery(
+    absl::string_view sql, const std::map<std::string, Value>& parameters,
+    const AnalyzerOptions& options, SimpleCatalog* catalog,
+    TypeFactory* type_factory, const ExecuteFunction& execute,
+    std::shared_ptr<const QueryResult>* result, bool* cache_hit) {
+  if (cache_hit != nullptr) *cache_hit = false;
+  std::string key;
+  const bool cacheable =
+      MakeKey(sql, parameters, options, catalog, type_factory, &key);
+  Entry entry;
+  if (cacheable && cache_.Lookup(key, &entry)) {
+    *result = std::move(entry.result);
+    if (cache_hit != nullptr) *cache_hit = true;
+    return ::zetasql_base::OkStatus();
+  }
+  // Run outside of the cache lock.  Concurrent misses on the same key may
+  // both run the query; the last one to finish wins.
+  std::unique_ptr<const AnalyzerOutput> analyzer_output;
+  ZETASQL_RETURN_IF_ERROR(zetasql::AnalyzeStatement(sql, options, catalog,
+                                            type_factory, &analyzer_output));
+  auto query_result = absl::make_unique<QueryResult>();
+  ZETASQL_RETURN_IF_ERROR(
+      execute(*analyzer_output->resolved_statement(), query_result.get()));
+  *result = std::move(query_result);
+  if (!cacheable ||
+      !IsDeterministicQuery(analyzer_output->resolved_statement())) {
+    return ::zetasql_base::OkStatus();
+  }
+  int64_t result_bytes = 0;
+  for (const std::vector<Value>& row : (*result)->rows) {
+    for (const Value& value : row) {
+      result_bytes += value.physical_byte_size();
+    }
+    if (result_bytes > max_result_bytes_) return ::zetasql_base::OkStatus();
+  }
+  cache_.Insert(key, Entry{catalog, *result});
+  return ::zetasql_base::OkStatus();
+}
+
+int QueryResultCache::InvalidateCatalog(const SimpleCatalog* catalog) {
+  return cache_.EraseIf([catalog](const std::string& key, const Entry& entry) {
+    return entry.catalog == catalog;
+  });
+}
+
+}  // namespace zetasql
@@ -0,0 +1,140 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PUBLIC_QUERY_RESULT_CACHE_H_
+#define ZETASQL_PUBLIC_QUERY_RESULT_CACHE_H_
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/common/lru_cache.h"
+#include "zetasql/public/analyzer.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "absl/strings/string_view.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+
+// The result of a query: its output columns and rows, each with one value
+// per column.
+struct QueryResult {
+  std::vector<std::string> column_names;
+  std::vector<const Type*> column_types;
+  std::vector<std::vector<Value>> rows;
+};
+
+// Returns true if <statement> is a query that returns the same rows every
+// time it runs over the same table contents with the same parameters: all
+// its functions are FunctionEnums::IMMUTABLE, it has no table-valued
+// functions, and each TABLESAMPLE has a REPEATABLE seed. Queries whose
+// result is one of several valid ones, like a LIMIT without ORDER BY, are
+// considered deterministic, since any of their results may be reused.
+bool IsDeterministicQuery(const ResolvedStatement* statement);
+
+// A thread-safe, size-bounded LRU cache of the results of queries, for
+// dashboards and other clients that run the same queries repeatedly.
+//
+// Entries are keyed by
+//   - the StatementFingerprint of the SQL text and its literals, so that
+//     whitespace, comments and case do not matter,
+//   - the values of the query parameters,
+//   - the Table::GetVersionToken() of every table named by the statement,
+//     as found by ExtractTableNamesFromStatement(), and
+//   - the SimpleCatalog, its version() and the serialized AnalyzerOptions,
+//     as for AnalyzerOutputCache.
+// A change to a table therefore makes earlier results unreachable, and they
+// age out as new entries are added.
+//
+// A query is run without the cache if one of its tables is not found or has
+// no version token, if the options cannot be keyed, or if it is not
+// IsDeterministicQuery(). Functions with bodies in SQL must not read tables,
+// or must not be IMMUTABLE, since the tables they read are not named by the
+// statement.
+//
+// Errors are not cached.
+class QueryResultCache {
+ public:
+  // Runs the analyzed query <statement> and sets <*result> to its output.
+  typedef std::function<zetasql_base::Status(const ResolvedStatement& statement,
+                                     QueryResult* result)>
+      ExecuteFunction;
+
+  // <max_entries> must be positive.
+  explicit QueryResultCache(int max_entries);
+  QueryResultCache(const QueryResultCache&) = delete;
+  QueryResultCache& operator=(const QueryResultCache&) = delete;
+  ~QueryResultCache();
+
+  // Sets <*result> to the cached result of the query <sql> with the query
+  // parameter values <parameters>, whose types must have been added to
+  // <options>. On a miss, the query is analyzed and run with <execute>,
+  // and its result is cached if it can be. A cached result refers to types
+  // of <type_factory>, which must outlive it. <*cache_hit>, if not null, is
+  // set to whether the result came from the cache.
+  zetasql_base::Status ExecuteQuery(absl::string_view sql,
+                            const std::map<std::string, Value>& parameters,
+                            const AnalyzerOptions& options,
+                            SimpleCatalog* catalog, TypeFactory* type_factory,
+                            const ExecuteFunction& execute,
+                            std::shared_ptr<const QueryResult>* result,
+                            bool* cache_hit = nullptr);
+
+  // Removes all entries of queries against <catalog>. Must be called before
+  // <catalog> is destroyed if the cache may outlive it. Returns the number
+  // of entries removed.
+  int InvalidateCatalog(const SimpleCatalog* catalog);
+
+  // Results whose values take more than this many bytes, as estimated by
+  // Value::physical_byte_size(), are not cached. Defaults to 64 MiB.
+  void set_max_result_bytes(int64_t max_result_bytes) {
+    max_result_bytes_ = max_result_bytes;
+  }
+  int64_t max_result_bytes() const { return max_result_bytes_; }
+
+  // Removes all entries. Results already handed out remain valid.
+  void Clear() { cache_.Clear(); }
+
+  int max_entries() const { return cache_.max_entries(); }
+  int size() const { return cache_.size(); }
+  LruCacheStats stats() const { return cache_.stats(); }
+
+ private:
+  struct Entry {
+    const SimpleCatalog* catalog;
+    std::shared_ptr<const QueryResult> result;
+  };
+
+  // Computes the cache key for the given inputs into <*key>. Returns false
+  // if the query cannot be cached.
+  static bool MakeKey(absl::string_view sql,
+                      const std::map<std::string, Value>& parameters,
+                      const AnalyzerOptions& options, SimpleCatalog* catalog,
+                      const TypeFactory* type_factory, std::string* key);
+
+  LruCache<std::string, Entry> cache_;
+  int64_t max_result_bytes_ = int64_t{64} << 20;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_QUERY_RESULT_CACHE_H_
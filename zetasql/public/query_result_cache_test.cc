@@ -0,0 +1,163 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/query_result_cache.h"
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/analyzer.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+
+class QueryResultCacheTest : public ::testing::Test {
+ protected:
+  QueryResultCacheTest() : catalog_("catalog", &type_factory_) {
+    table_ = new SimpleTable("T", {{"key", type_factory_.get_int64()}});
+    catalog_.AddOwnedTable(table_);
+    ZETASQL_CHECK_OK(table_->SetContents({{Value::Int64(1)}}));
+    catalog_.AddZetaSQLFunctions();
+  }
+
+  // Runs <sql>, returning a result with the number of executions so far.
+  zetasql_base::Status Execute(absl::string_view sql,
+                       std::shared_ptr<const QueryResult>* result,
+                       bool* cache_hit = nullptr) {
+    const auto execute = [this](const ResolvedStatement& statement,
+                                QueryResult* result) -> zetasql_base::Status {
+      if (!execute_status_.ok()) return execute_status_;
+      ++num_executions_;
+      result->column_names = {"n"};
+      result->column_types = {type_factory_.get_int64()};
+      result->rows = {{Value::Int64(num_executions_)}};
+      return zetasql_base::OkStatus();
+    };
+    return cache_.ExecuteQuery(sql, parameters_, options_, &catalog_,
+                               &type_factory_, execute, result, cache_hit);
+  }
+
+  TypeFactory type_factory_;
+  SimpleCatalog catalog_;
+  SimpleTable* table_;
+  AnalyzerOptions options_;
+  std::map<std::string, Value> parameters_;
+  QueryResultCache cache_{/*max_entries=*/10};
+  int num_executions_ = 0;
+  zetasql_base::Status execute_status_;
+};
+
+TEST_F(QueryResultCacheTest, HitReturnsSameResult) {
+  std::shared_ptr<const QueryResult> result1;
+  std::shared_ptr<const QueryResult> result2;
+  bool cache_hit = true;
+  ZETASQL_ASSERT_OK(Execute("SELECT key FROM T", &result1, &cache_hit));
+  EXPECT_FALSE(cache_hit);
+  // The fingerprint ignores whitespace, comments and keyword case.
+  ZETASQL_ASSERT_OK(
+      Execute("select  key -- comment\n FROM T", &result2, &cache_hit));
+  EXPECT_TRUE(cache_hit);
+  EXPECT_EQ(result1.get(), result2.get());
+  EXPECT_EQ(1, num_executions_);
+  EXPECT_EQ(1, cache_.size());
+  EXPECT_EQ(1, cache_.stats().hits);
+}
+
+TEST_F(QueryResultCacheTest, LiteralsAndParametersAreKeyed) {
+  std::shared_ptr<const QueryResult> result;
+  ZETASQL_ASSERT_OK(Execute("SELECT key FROM T WHERE key = 1", &result));
+  ZETASQL_ASSERT_OK(Execute("SELECT key FROM T WHERE key = 2", &result));
+  // Literals with equal values but different types.
+  ZETASQL_ASSERT_OK(Execute("SELECT key FROM T WHERE key = 2.0", &result));
+  EXPECT_EQ(3, num_executions_);
+
+  ZETASQL_ASSERT_OK(options_.AddQueryParameter("p", type_factory_.get_int64()));
+  parameters_["p"] = Value::Int64(1);
+  ZETASQL_ASSERT_OK(Execute("SELECT key FROM T WHERE key = @p", &result));
+  ZETASQL_ASSERT_OK(Execute("SELECT key FROM T WHERE key = @p", &result));
+  EXPECT_EQ(4, num_executions_);
+  parameters_["p"] = Value::Int64(2);
+  ZETASQL_ASSERT_OK(Execute("SELECT key FROM T WHERE key = @p", &result));
+  EXPECT_EQ(5, num_executions_);
+}
+
+TEST_F(QueryResultCacheTest, TableVersionChangesInvalidate) {
+  std::shared_ptr<const QueryResult> result1;
+  std::shared_ptr<const QueryResult> result2;
+  const std::string version = table_->GetVersionToken();
+  EXPECT_FALSE(version.empty());
+  ZETASQL_ASSERT_OK(Execute("SELECT key FROM T", &result1));
+
+  ZETASQL_ASSERT_OK(table_->SetContents({{Value::Int64(2)}}));
+  EXPECT_NE(version, table_->GetVersionToken());
+  ZETASQL_ASSERT_OK(Execute("SELECT key FROM T", &result2));
+  EXPECT_NE(result1.get(), result2.get());
+  EXPECT_EQ(Value::Int64(2), result2->rows[0][0]);
+  EXPECT_EQ(2, cache_.size());
+
+  EXPECT_EQ(2, cache_.InvalidateCatalog(&catalog_));
+  EXPECT_EQ(0, cache_.size());
+}
+
+TEST_F(QueryResultCacheTest, UncacheableQueriesBypassCache) {
+  std::shared_ptr<const QueryResult> result;
+  // RAND() is VOLATILE.
+  ZETASQL_ASSERT_OK(Execute("SELECT key, RAND() FROM T", &result));
+  ZETASQL_ASSERT_OK(Execute("SELECT key, RAND() FROM T", &result));
+  EXPECT_EQ(2, num_executions_);
+
+  // Tables without contents have no version.
+  catalog_.AddOwnedTable(
+      new SimpleTable("U", {{"key", type_factory_.get_int64()}}));
+  ZETASQL_ASSERT_OK(Execute("SELECT key FROM U", &result));
+  ZETASQL_ASSERT_OK(Execute("SELECT key FROM U", &result));
+  EXPECT_EQ(4, num_executions_);
+
+  cache_.set_max_result_bytes(0);
+  ZETASQL_ASSERT_OK(Execute("SELECT key FROM T", &result));
+  EXPECT_EQ(0, cache_.size());
+}
+
+TEST_F(QueryResultCacheTest, ErrorsAreNotCached) {
+  std::shared_ptr<const QueryResult> result;
+  EXPECT_FALSE(Execute("SELECT missing FROM T", &result).ok());
+  execute_status_ = zetasql_base::InternalError("failed");
+  EXPECT_FALSE(Execute("SELECT key FROM T", &result).ok());
+  EXPECT_EQ(0, cache_.size());
+}
+
+TEST_F(QueryResultCacheTest, IsDeterministicQuery) {
+  const auto is_deterministic = [this](absl::string_view sql) {
+    std::unique_ptr<const AnalyzerOutput> output;
+    ZETASQL_CHECK_OK(AnalyzeStatement(sql, options_, &catalog_, &type_factory_,
+                              &output));
+    return IsDeterministicQuery(output->resolved_statement());
+  };
+  EXPECT_TRUE(is_deterministic("SELECT key + 1 FROM T"));
+  EXPECT_TRUE(is_deterministic("SELECT SUM(key) FROM T"));
+  EXPECT_FALSE(is_deterministic("SELECT CURRENT_TIMESTAMP()"));
+  EXPECT_FALSE(is_deterministic("SELECT (SELECT RAND()) FROM T"));
+}
+
+}  // namespace zetasql
@@ -16,6 +16,9 @@
 
 #include "zetasql/public/simple_catalog.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <map>
 #include <memory>
 
@@ -31,6 +34,7 @@
 #include "zetasql/base/case.h"
 #include "absl/strings/str_cat.h"
 #include "absl/synchronization/mutex.h"
+#include "zetasql/base/atomic_sequence_num.h"
 #include "zetasql/base/map_util.h"
 #include "zetasql/base/source_location.h"
 #include "zetasql/base/ret_check.h"
@@ -39,22 +43,177 @@
 
 namespace zetasql {
 
+namespace {
+
+// Source of SimpleCatalog versions.  Versions are drawn from a single
+// process-wide sequence so that a catalog never reuses a version that was
+// previously observed for it or for any other catalog, even one that was
+// destroyed and whose address was reused.  SimpleTable contents versions come
+// from the same sequence.
+zetasql_base::SequenceNumber catalog_version_sequence;
+
+zetasql_base::Status SerializeTableStatistics(const TableStatistics& statistics,
+                                      TableStatisticsProto* proto) {
+  if (statistics.row_count.has_value()) {
+    proto->set_row_count(*statistics.row_count);
+  }
+  if (statistics.total_bytes.has_value()) {
+    proto->set_total_bytes(*statistics.total_bytes);
+  }
+  for (const ColumnStatistics& column : statistics.columns) {
+    ColumnStatisticsProto* column_proto = proto->add_column();
+    if (column.distinct_count.has_value()) {
+      column_proto->set_distinct_count(*column.distinct_count);
+    }
+    if (column.null_fraction.has_value()) {
+      column_proto->set_null_fraction(*column.null_fraction);
+    }
+    if (column.min.is_valid()) {
+      ZETASQL_RETURN_IF_ERROR(column.min.Serialize(column_proto->mutable_min()));
+    }
+    if (column.max.is_valid()) {
+      ZETASQL_RETURN_IF_ERROR(column.max.Serialize(column_proto->mutable_max()));
+    }
+    if (!column.histogram_id.empty()) {
+      column_proto->set_histogram_id(column.histogram_id);
+    }
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+// Deserializes the statistics of <table>, whose columns give the types of
+// the column bounds.
+zetasql_base::Status DeserializeTableStatistics(const TableStatisticsProto& proto,
+                                        const Table& table,
+                                        TableStatistics* statistics) {
+  if (proto.has_row_count()) statistics->row_count = proto.row_count();
+  if (proto.has_total_bytes()) statistics->total_bytes = proto.total_bytes();
+  if (proto.column_size() > 0 && proto.column_size() != table.NumColumns()) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "Statistics of table " << table.FullName() << " have "
+           << proto.column_size() << " columns instead of "
+           << table.NumColumns();
+  }
+  for (int i = 0; i < proto.column_size(); ++i) {
+    const ColumnStatisticsProto& column_proto = proto.column(i);
+    const Type* type = table.GetColumn(i)->GetType();
+    ColumnStatistics column;
+    if (column_proto.has_distinct_count()) {
+      column.distinct_count = column_proto.distinct_count();
+    }
+    if (column_proto.has_null_fraction()) {
+      column.null_fraction = column_proto.null_fraction();
+    }
+    if (column_proto.has_min()) {
+      ZETASQL_ASSIGN_OR_RETURN(column.min,
+                       Value::Deserialize(column_proto.min(), type));
+    }
+    if (column_proto.has_max()) {
+      ZETASQL_ASSIGN_OR_RETURN(column.max,
+                       Value::Deserialize(column_proto.max(), type));
+    }
+    column.histogram_id = column_proto.histogram_id();
+    statistics->columns.push_back(std::move(column));
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+bool IsNullOrNaN(const Value& value) {
+  return value.is_null() ||
+         (value.type()->IsFloatingPoint() && std::isnan(value.ToDouble()));
+}
+
+// Returns the rows of a ColumnarTableContents found by an index lookup.
+class IndexLookupIterator : public EvaluatorTableIterator {
+ public:
+  // A row of the contents that matches the key at <key_index>.
+  struct Match {
+    int64_t key_index;
+    int chunk;
+    int row;
+  };
+
+  IndexLookupIterator(std::shared_ptr<const ColumnarTableContents> contents,
+                      std::vector<int> column_idxs,
+                      std::vector<std::string> column_names,
+                      std::vector<Match> matches)
+      : contents_(std::move(contents)),
+        column_idxs_(std::move(column_idxs)),
+        column_names_(std::move(column_names)),
+        matches_(std::move(matches)),
+        values_(column_idxs_.size() + 1) {}
+
+  int NumColumns() const override { return column_idxs_.size() + 1; }
+  std::string GetColumnName(int i) const override {
+    return i < column_idxs_.size() ? column_names_[i] : "key_index";
+  }
+  const Type* GetColumnType(int i) const override {
+    return i < column_idxs_.size() ? contents_->column_type(column_idxs_[i])
+                                   : types::Int64Type();
+  }
+
+  bool NextRow() override {
+    if (cancelled_) {
+      status_ = ::zetasql_base::CancelledErrorBuilder(ZETASQL_LOC)
+                << "Index lookup was cancelled";
+      return false;
+    }
+    if (next_match_ >= matches_.size()) return false;
+    const Match& match = matches_[next_match_++];
+    for (int i = 0; i < column_idxs_.size(); ++i) {
+      values_[i] = contents_->GetValue(match.chunk, match.row, column_idxs_[i]);
+    }
+    values_.back() = Value::Int64(match.key_index);
+    return true;
+  }
+
+  const Value& GetValue(int i) const override { return values_[i]; }
+  zetasql_base::Status Status() const override { return status_; }
+  zetasql_base::Status Cancel() override {
+    cancelled_ = true;
+    return ::zetasql_base::OkStatus();
+  }
+
+ private:
+  const std::shared_ptr<const ColumnarTableContents> contents_;
+  const std::vector<int> column_idxs_;
+  const std::vector<std::string> column_names_;
+  const std::vector<Match> matches_;
+  int64_t next_match_ = 0;
+  std::vector<Value> values_;
+  zetasql_base::Status status_;
+  std::atomic<bool> cancelled_{false};
+};
+
+}  // namespace
+
+// A hash index of the contents of a SimpleTable.
+struct SimpleTable::Index {
+  std::vector<int> key_columns;
+  // The (chunk, row) of the rows with each key, in order, for the keys
+  // without NULL or NaN values.
+  absl::flat_hash_map<std::vector<Value>, std::vector<std::pair<int, int>>>
+      rows;
+};
+
 SimpleCatalog::SimpleCatalog(const std::string& name, TypeFactory* type_factory)
-    : name_(name), type_factory_(type_factory) {
+    : name_(name),
+      type_factory_(type_factory),
+      version_(catalog_version_sequence.GetNext()) {
 }
 
 zetasql_base::Status SimpleCatalog::GetTable(
     const std::string& name,
     const Table** table,
     const FindOptions& options) {
-  absl::MutexLock l(&mutex_);
+  absl::MutexLockMaybe l(ReadMutex());
   *table = zetasql_base::FindPtrOrNull(tables_, absl::AsciiStrToLower(name));
   return ::zetasql_base::OkStatus();
 }
 
 zetasql_base::Status SimpleCatalog::GetModel(const std::string& name, const Model** model,
                                      const FindOptions& options) {
-  absl::MutexLock l(&mutex_);
+  absl::MutexLockMaybe l(ReadMutex());
   *model = zetasql_base::FindPtrOrNull(models_, absl::AsciiStrToLower(name));
   return ::zetasql_base::OkStatus();
 }
@@ -63,7 +222,7 @@ zetasql_base::Status SimpleCatalog::GetFunction(
     const std::string& name,
     const Function** function,
     const FindOptions& options) {
-  absl::MutexLock l(&mutex_);
+  absl::MutexLockMaybe l(ReadMutex());
   *function = zetasql_base::FindPtrOrNull(functions_, absl::AsciiStrToLower(name));
   return ::zetasql_base::OkStatus();
 }
@@ -72,7 +231,7 @@ zetasql_base::Status SimpleCatalog::GetTableValuedFunction(
     const std::string& name,
     const TableValuedFunction** function,
     const FindOptions& options) {
-  absl::MutexLock l(&mutex_);
+  absl::MutexLockMaybe l(ReadMutex());
   *function =
       zetasql_base::FindPtrOrNull(table_valued_functions_, absl::AsciiStrToLower(name));
   return ::zetasql_base::OkStatus();
@@ -82,7 +241,7 @@ zetasql_base::Status SimpleCatalog::GetProcedure(
     const std::string& name,
     const Procedure** procedure,
     const FindOptions& options) {
-  absl::MutexLock l(&mutex_);
+  absl::MutexLockMaybe l(ReadMutex());
   *procedure = zetasql_base::FindPtrOrNull(procedures_, absl::AsciiStrToLower(name));
   return ::zetasql_base::OkStatus();
 }
@@ -93,7 +252,7 @@ zetasql_base::Status SimpleCatalog::GetType(
     const FindOptions& options) {
   const google::protobuf::DescriptorPool* pool;
   {
-    absl::MutexLock l(&mutex_);
+    absl::MutexLockMaybe l(ReadMutex());
     *type = zetasql_base::FindPtrOrNull(types_, absl::AsciiStrToLower(name));
     if (*type != nullptr) {
       return ::zetasql_base::OkStatus();
@@ -127,15 +286,62 @@ zetasql_base::Status SimpleCatalog::GetCatalog(
     const std::string& name,
     Catalog** catalog,
     const FindOptions& options) {
-  absl::MutexLock l(&mutex_);
+  absl::MutexLockMaybe l(ReadMutex());
   *catalog = zetasql_base::FindPtrOrNull(catalogs_, absl::AsciiStrToLower(name));
   return ::zetasql_base::OkStatus();
 }
 
+zetasql_base::Status SimpleCatalog::FindTable(absl::Span<const IdString> path,
+                                      const Table** table,
+                                      const FindOptions& options) {
+  *table = nullptr;
+  if (path.empty()) {
+    return EmptyNamePathInternalError("Table");
+  }
+
+  if (path.size() > 1) {
+    Catalog* catalog = nullptr;
+    ZETASQL_RETURN_IF_ERROR(GetCatalog(path.front(), &catalog, options));
+    if (catalog != nullptr) {
+      const absl::Span<const IdString> path_suffix = path.subspan(1);
+      return TraceLookup(catalog, "Table", path_suffix, options, [&] {
+        return catalog->FindTable(path_suffix, table, options);
+      });
+    }
+  } else {
+    ZETASQL_RETURN_IF_ERROR(GetTable(path.front(), table, options));
+    if (*table != nullptr) {
+      return ::zetasql_base::OkStatus();
+    }
+  }
+  // Only build the std::string path for the error message.
+  std::vector<std::string> string_path;
+  for (const IdString name : path) {
+    string_path.push_back(name.ToString());
+  }
+  return TableNotFoundError(string_path);
+}
+
+zetasql_base::Status SimpleCatalog::GetTable(IdString name, const Table** table,
+                                     const FindOptions& options) {
+  absl::MutexLockMaybe l(ReadMutex());
+  const auto it = tables_.find(name);
+  *table = it == tables_.end() ? nullptr : it->second;
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status SimpleCatalog::GetCatalog(IdString name, Catalog** catalog,
+                                       const FindOptions& options) {
+  absl::MutexLockMaybe l(ReadMutex());
+  const auto it = catalogs_.find(name);
+  *catalog = it == catalogs_.end() ? nullptr : it->second;
+  return ::zetasql_base::OkStatus();
+}
+
 zetasql_base::Status SimpleCatalog::GetConstant(const std::string& name,
                                         const Constant** constant,
                                         const FindOptions& options) {
-  absl::MutexLock l(&mutex_);
+  absl::MutexLockMaybe l(ReadMutex());
   *constant = zetasql_base::FindPtrOrNull(constants_, absl::AsciiStrToLower(name));
   return ::zetasql_base::OkStatus();
 }
@@ -254,11 +460,15 @@ std::string SimpleCatalog::SuggestConstant(
 
 void SimpleCatalog::AddTable(const std::string& name, const Table* table) {
   absl::MutexLock l(&mutex_);
+  BumpVersionLocked();
+  RecordChangeLocked(kTableObject, absl::AsciiStrToLower(name),
+                     /*removed=*/false);
   zetasql_base::InsertOrDie(&tables_, absl::AsciiStrToLower(name), table);
 }
 
 void SimpleCatalog::AddModel(const std::string& name, const Model* model) {
   absl::MutexLock l(&mutex_);
+  BumpVersionLocked();
   zetasql_base::InsertOrDie(&models_, absl::AsciiStrToLower(name), model);
 }
 
@@ -268,6 +478,9 @@ void SimpleCatalog::AddType(const std::string& name, const Type* type) {
 }
 
 void SimpleCatalog::AddTypeLocked(const std::string& name, const Type* type) {
+  BumpVersionLocked();
+  RecordChangeLocked(kTypeObject, absl::AsciiStrToLower(name),
+                     /*removed=*/false);
   zetasql_base::InsertOrDie(&types_, absl::AsciiStrToLower(name), type);
 }
 
@@ -277,14 +490,23 @@ void SimpleCatalog::AddCatalog(const std::string& name, Catalog* catalog) {
 }
 
 void SimpleCatalog::AddCatalogLocked(const std::string& name, Catalog* catalog) {
+  BumpVersionLocked();
+  RecordChangeLocked(kCatalogObject, absl::AsciiStrToLower(name),
+                     /*removed=*/false);
   zetasql_base::InsertOrDie(&catalogs_, absl::AsciiStrToLower(name), catalog);
 }
 
 void SimpleCatalog::AddFunctionLocked(
     const std::string& name, const Function* function) {
+  BumpVersionLocked();
+  RecordChangeLocked(kFunctionObject, absl::AsciiStrToLower(name),
+                     /*removed=*/false);
   zetasql_base::InsertOrDie(&functions_, absl::AsciiStrToLower(name), function);
   if (!function->alias_name().empty() &&
       zetasql_base::StringCaseCompare(function->alias_name(), name) != 0) {
+    RecordChangeLocked(kFunctionObject,
+                       absl::AsciiStrToLower(function->alias_name()),
+                       /*removed=*/false);
     zetasql_base::InsertOrDie(&functions_, absl::AsciiStrToLower(function->alias_name()),
                      function);
   }
@@ -297,6 +519,9 @@ void SimpleCatalog::AddFunction(const std::string& name, const Function* functio
 
 void SimpleCatalog::AddTableValuedFunctionLocked(
     const std::string& name, const TableValuedFunction* table_function) {
+  BumpVersionLocked();
+  RecordChangeLocked(kTableValuedFunctionObject, absl::AsciiStrToLower(name),
+                     /*removed=*/false);
   zetasql_base::InsertOrDie(&table_valued_functions_, absl::AsciiStrToLower(name),
                    table_function);
 }
@@ -310,11 +535,17 @@ void SimpleCatalog::AddTableValuedFunction(
 void SimpleCatalog::AddProcedure(
     const std::string& name, const Procedure* procedure) {
   absl::MutexLock l(&mutex_);
+  BumpVersionLocked();
+  RecordChangeLocked(kProcedureObject, absl::AsciiStrToLower(name),
+                     /*removed=*/false);
   zetasql_base::InsertOrDie(&procedures_, absl::AsciiStrToLower(name), procedure);
 }
 
 void SimpleCatalog::AddConstant(const std::string& name, const Constant* constant) {
   absl::MutexLock l(&mutex_);
+  BumpVersionLocked();
+  RecordChangeLocked(kConstantObject, absl::AsciiStrToLower(name),
+                     /*removed=*/false);
   zetasql_base::InsertOrDie(&constants_, absl::AsciiStrToLower(name), constant);
 }
 
@@ -411,6 +642,101 @@ void SimpleCatalog::AddOwnedConstant(const std::string& name,
   AddOwnedConstant(name, absl::WrapUnique(constant));
 }
 
+// Deletes <object> if it is in <owned>.
+template <class T>
+static void EraseOwned(const T* object,
+                       std::vector<std::unique_ptr<const T>>* owned) {
+  for (auto it = owned->begin(); it != owned->end(); ++it) {
+    if (it->get() == object) {
+      owned->erase(it);
+      return;
+    }
+  }
+}
+
+bool SimpleCatalog::RemoveTable(const std::string& name) {
+  absl::MutexLock l(&mutex_);
+  const auto it = tables_.find(absl::AsciiStrToLower(name));
+  if (it == tables_.end()) {
+    return false;
+  }
+  BumpVersionLocked();
+  RecordChangeLocked(kTableObject, it->first, /*removed=*/true);
+  const Table* table = it->second;
+  tables_.erase(it);
+  EraseOwned(table, &owned_tables_);
+  return true;
+}
+
+bool SimpleCatalog::RemoveFunction(const std::string& name) {
+  absl::MutexLock l(&mutex_);
+  const Function* function =
+      zetasql_base::FindPtrOrNull(functions_, absl::AsciiStrToLower(name));
+  if (function == nullptr) {
+    return false;
+  }
+  BumpVersionLocked();
+  // The function may be found by <name>, its own name or its alias.
+  for (const std::string& key :
+       {absl::AsciiStrToLower(name), absl::AsciiStrToLower(function->Name()),
+        absl::AsciiStrToLower(function->alias_name())}) {
+    const auto it = functions_.find(key);
+    if (it != functions_.end() && it->second == function) {
+      RecordChangeLocked(kFunctionObject, key, /*removed=*/true);
+      functions_.erase(it);
+    }
+  }
+  EraseOwned(function, &owned_functions_);
+  return true;
+}
+
+bool SimpleCatalog::RemoveConstant(const std::string& name) {
+  absl::MutexLock l(&mutex_);
+  const auto it = constants_.find(absl::AsciiStrToLower(name));
+  if (it == constants_.end()) {
+    return false;
+  }
+  BumpVersionLocked();
+  RecordChangeLocked(kConstantObject, it->first, /*removed=*/true);
+  const Constant* constant = it->second;
+  constants_.erase(it);
+  EraseOwned(constant, &owned_constants_);
+  return true;
+}
+
+bool SimpleCatalog::RemoveTableValuedFunction(const std::string& name) {
+  absl::MutexLock l(&mutex_);
+  const auto it = table_valued_functions_.find(absl::AsciiStrToLower(name));
+  if (it == table_valued_functions_.end()) {
+    return false;
+  }
+  BumpVersionLocked();
+  RecordChangeLocked(kTableValuedFunctionObject, it->first, /*removed=*/true);
+  const TableValuedFunction* function = it->second;
+  table_valued_functions_.erase(it);
+  EraseOwned(function, &owned_table_valued_functions_);
+  return true;
+}
+
+bool SimpleCatalog::RemoveCatalog(const std::string& name) {
+  absl::MutexLock l(&mutex_);
+  const auto it = catalogs_.find(absl::AsciiStrToLower(name));
+  if (it == catalogs_.end()) {
+    return false;
+  }
+  BumpVersionLocked();
+  RecordChangeLocked(kCatalogObject, it->first, /*removed=*/true);
+  const Catalog* catalog = it->second;
+  const auto zetasql_it = owned_zetasql_subcatalogs_.find(it->first);
+  if (zetasql_it != owned_zetasql_subcatalogs_.end() &&
+      zetasql_it->second.get() == catalog) {
+    owned_zetasql_subcatalogs_.erase(zetasql_it);
+  }
+  catalogs_.erase(it);
+  EraseOwned(catalog, &owned_catalogs_);
+  return true;
+}
+
 void SimpleCatalog::AddTable(const Table* table) {
   AddTable(table->Name(), table);
 }
@@ -575,6 +901,7 @@ void SimpleCatalog::SetDescriptorPool(const google::protobuf::DescriptorPool* po
       << "SimpleCatalog::SetDescriptorPool can only be called once";
   owned_descriptor_pool_.reset();
   descriptor_pool_ = pool;
+  BumpVersionLocked();
 }
 
 void SimpleCatalog::SetOwnedDescriptorPool(const google::protobuf::DescriptorPool* pool) {
@@ -583,6 +910,7 @@ void SimpleCatalog::SetOwnedDescriptorPool(const google::protobuf::DescriptorPoo
       << "SimpleCatalog::SetDescriptorPool can only be called once";
   owned_descriptor_pool_.reset(pool);
   descriptor_pool_ = pool;
+  BumpVersionLocked();
 }
 
 void SimpleCatalog::AddZetaSQLFunctions(
@@ -593,34 +921,54 @@ void SimpleCatalog::AddZetaSQLFunctions(
   GetZetaSQLFunctions(type_factory, options, &function_map);
   for (auto& function_pair : function_map) {
     const std::vector<std::string>& path = function_pair.second->FunctionNamePath();
-    SimpleCatalog* catalog = this;
-    if (path.size() > 1) {
-      CHECK_LE(path.size(), 2);
-      absl::MutexLock l(&mutex_);
-      const std::string& space = path[0];
-      auto sub_entry = owned_zetasql_subcatalogs_.find(space);
-      if (sub_entry != owned_zetasql_subcatalogs_.end()) {
-        catalog = sub_entry->second.get();
-        CHECK(catalog != nullptr) << "internal state corrupt: " << space;
-      } else {
-        auto new_catalog =
-            absl::make_unique<SimpleCatalog>(space, type_factory);
-        AddCatalogLocked(space, new_catalog.get());
-        catalog = new_catalog.get();
-        CHECK(
-            owned_zetasql_subcatalogs_.emplace(space, std::move(new_catalog))
-                .second);
-      }
-    }
-    catalog->AddOwnedFunction(path.back(), std::move(function_pair.second));
+    GetZetaSQLFunctionCatalog(path, type_factory)
+        ->AddOwnedFunction(path.back(), std::move(function_pair.second));
   }
 }
 
+void SimpleCatalog::AddSharedZetaSQLFunctions(
+    const ZetaSQLBuiltinFunctionOptions& options) {
+  // We have to call type_factory() while not holding mutex_.
+  TypeFactory* type_factory = this->type_factory();
+  for (const auto& function_pair : GetSharedZetaSQLFunctions(options)) {
+    const std::vector<std::string>& path = function_pair.second->FunctionNamePath();
+    GetZetaSQLFunctionCatalog(path, type_factory)
+        ->AddFunction(path.back(), function_pair.second.get());
+  }
+}
+
+SimpleCatalog* SimpleCatalog::GetZetaSQLFunctionCatalog(
+    const std::vector<std::string>& path, TypeFactory* type_factory) {
+  if (path.size() <= 1) {
+    return this;
+  }
+  CHECK_LE(path.size(), 2);
+  absl::MutexLock l(&mutex_);
+  const std::string& space = path[0];
+  auto sub_entry = owned_zetasql_subcatalogs_.find(space);
+  if (sub_entry != owned_zetasql_subcatalogs_.end()) {
+    SimpleCatalog* catalog = sub_entry->second.get();
+    CHECK(catalog != nullptr) << "internal state corrupt: " << space;
+    return catalog;
+  }
+  auto new_catalog = absl::make_unique<SimpleCatalog>(space, type_factory);
+  SimpleCatalog* catalog = new_catalog.get();
+  AddCatalogLocked(space, catalog);
+  CHECK(owned_zetasql_subcatalogs_.emplace(space, std::move(new_catalog))
+            .second);
+  return catalog;
+}
+
 void SimpleCatalog::ClearFunctions() {
   absl::MutexLock l(&mutex_);
+  BumpVersionLocked();
+  for (const auto& entry : functions_) {
+    RecordChangeLocked(kFunctionObject, entry.first, /*removed=*/true);
+  }
   functions_.clear();
   owned_functions_.clear();
   for (const auto& pair : owned_zetasql_subcatalogs_) {
+    RecordChangeLocked(kCatalogObject, pair.first, /*removed=*/true);
     catalogs_.erase(pair.first);
   }
   owned_zetasql_subcatalogs_.clear();
@@ -628,16 +976,78 @@ void SimpleCatalog::ClearFunctions() {
 
 void SimpleCatalog::ClearTableValuedFunctions() {
   absl::MutexLock l(&mutex_);
+  BumpVersionLocked();
+  for (const auto& entry : table_valued_functions_) {
+    RecordChangeLocked(kTableValuedFunctionObject, entry.first,
+                       /*removed=*/true);
+  }
   table_valued_functions_.clear();
   owned_table_valued_functions_.clear();
   for (const auto& pair : owned_zetasql_subcatalogs_) {
+    RecordChangeLocked(kCatalogObject, pair.first, /*removed=*/true);
     catalogs_.erase(pair.first);
   }
   owned_zetasql_subcatalogs_.clear();
 }
 
-TypeFactory* SimpleCatalog::type_factory() {
+void SimpleCatalog::BumpVersionLocked() {
+  CHECK(!frozen_.load(std::memory_order_relaxed))
+      << "Cannot modify frozen SimpleCatalog " << name_;
+  version_ = catalog_version_sequence.GetNext();
+}
+
+void SimpleCatalog::RecordChangeLocked(ObjectKind kind,
+                                       const std::string& name,
+                                       bool removed) {
+  changes_[std::make_pair(kind, name)] = ObjectChange{version_, removed};
+}
+
+void SimpleCatalog::Freeze() {
+  // Create the TypeFactory now, since type_factory() cannot create it once
+  // the catalog is frozen.
+  type_factory();
   absl::MutexLock l(&mutex_);
+  for (const auto& entry : owned_zetasql_subcatalogs_) {
+    entry.second->Freeze();
+  }
+  // Writes to the maps above happen before this store, and lock-free readers
+  // load <frozen_> with acquire semantics before reading them.
+  frozen_.store(true, std::memory_order_release);
+}
+
+int64_t SimpleCatalog::version() const {
+  absl::flat_hash_set<const Catalog*> seen_catalogs;
+  return VersionImpl(&seen_catalogs);
+}
+
+int64_t SimpleCatalog::VersionImpl(
+    absl::flat_hash_set<const Catalog*>* seen_catalogs) const {
+  if (!seen_catalogs->insert(this).second) {
+    return -1;
+  }
+  int64_t version;
+  std::vector<const SimpleCatalog*> simple_subcatalogs;
+  {
+    absl::MutexLockMaybe l(ReadMutex());
+    version = version_;
+    for (const auto& entry : catalogs_) {
+      const SimpleCatalog* subcatalog =
+          dynamic_cast<const SimpleCatalog*>(entry.second);
+      if (subcatalog != nullptr) {
+        simple_subcatalogs.push_back(subcatalog);
+      }
+    }
+  }
+  // Recurse without holding mutex_, since subcatalogs may refer back to
+  // this catalog.
+  for (const SimpleCatalog* subcatalog : simple_subcatalogs) {
+    version = std::max(version, subcatalog->VersionImpl(seen_catalogs));
+  }
+  return version;
+}
+
+TypeFactory* SimpleCatalog::type_factory() {
+  absl::MutexLockMaybe l(ReadMutex());
   if (type_factory_ == nullptr) {
     DCHECK(owned_type_factory_ == nullptr);
     owned_type_factory_ = absl::make_unique<TypeFactory>();
@@ -646,9 +1056,7 @@ TypeFactory* SimpleCatalog::type_factory() {
   return type_factory_;
 }
 
-namespace {
-
-zetasql_base::Status DeserializeImpl(
+zetasql_base::Status SimpleCatalog::DeserializeImpl(
     const SimpleCatalogProto& proto,
     const std::vector<const google::protobuf::DescriptorPool*>& pools,
     SimpleCatalog* catalog) {
@@ -710,8 +1118,6 @@ zetasql_base::Status DeserializeImpl(
   return ::zetasql_base::OkStatus();
 }
 
-}  // namespace
-
 zetasql_base::Status SimpleCatalog::Deserialize(
     const SimpleCatalogProto& proto,
     const std::vector<const google::protobuf::DescriptorPool*>& pools,
@@ -849,43 +1255,386 @@ zetasql_base::Status SimpleCatalog::SerializeImpl(
   return ::zetasql_base::OkStatus();
 }
 
+zetasql_base::Status SimpleCatalog::SerializeDelta(
+    int64_t since_version, FileDescriptorSetMap* file_descriptor_set_map,
+    SimpleCatalogDeltaProto* proto, bool ignore_builtin,
+    bool ignore_recursive) const {
+  absl::flat_hash_set<const Catalog*> seen;
+  return SerializeDeltaImpl(since_version, &seen, file_descriptor_set_map,
+                            proto, ignore_builtin, ignore_recursive);
+}
+
+zetasql_base::Status SimpleCatalog::SerializeDeltaImpl(
+    int64_t since_version, absl::flat_hash_set<const Catalog*>* seen_catalogs,
+    FileDescriptorSetMap* file_descriptor_set_map,
+    SimpleCatalogDeltaProto* proto, bool ignore_builtin,
+    bool ignore_recursive) const {
+  seen_catalogs->insert(this);
+  proto->Clear();
+  proto->set_name(name_);
+
+  // The nested SimpleCatalogs that did not change themselves, by name.
+  std::map<std::string, const SimpleCatalog*> unchanged_catalogs;
+  {
+    absl::MutexLock l(&mutex_);
+    // Sorted so that the serialization output is deterministic.
+    std::map<std::pair<ObjectKind, std::string>, bool> changes;
+    for (const auto& entry : changes_) {
+      if (entry.second.version > since_version) {
+        changes.emplace(entry.first, entry.second.removed);
+      }
+    }
+
+    // A function is changed under its name and alias, but serialized once.
+    absl::flat_hash_set<const Function*> changed_functions;
+    for (const auto& entry : changes) {
+      const ObjectKind kind = entry.first.first;
+      const std::string& name = entry.first.second;
+      if (entry.second) {
+        switch (kind) {
+          case kTableObject:
+            proto->add_remove_table(name);
+            break;
+          case kFunctionObject:
+            proto->add_remove_function(name);
+            break;
+          case kTableValuedFunctionObject:
+            proto->add_remove_custom_tvf(name);
+            break;
+          case kCatalogObject:
+            proto->add_remove_catalog(name);
+            break;
+          case kConstantObject:
+            proto->add_remove_constant(name);
+            break;
+          case kTypeObject:
+          case kProcedureObject:
+            ZETASQL_RET_CHECK_FAIL() << "Removed object of kind " << kind;
+        }
+        continue;
+      }
+      switch (kind) {
+        case kTableObject: {
+          const Table* table = zetasql_base::FindPtrOrNull(tables_, name);
+          ZETASQL_RET_CHECK(table != nullptr) << name;
+          if (!table->Is<SimpleTable>()) {
+            return ::zetasql_base::UnknownErrorBuilder(ZETASQL_LOC)
+                   << "Cannot serialize non-SimpleTable " << name;
+          }
+          SimpleTableProto* const table_proto = proto->add_add_table();
+          ZETASQL_RETURN_IF_ERROR(table->GetAs<SimpleTable>()->Serialize(
+              file_descriptor_set_map, table_proto));
+          if (absl::AsciiStrToLower(table_proto->name()) != name) {
+            table_proto->set_name_in_catalog(name);
+          }
+          break;
+        }
+        case kTypeObject: {
+          const Type* type = zetasql_base::FindPtrOrNull(types_, name);
+          ZETASQL_RET_CHECK(type != nullptr) << name;
+          SimpleCatalogProto::NamedTypeProto* named_type =
+              proto->add_add_named_type();
+          ZETASQL_RETURN_IF_ERROR(
+              type->SerializeToProtoAndDistinctFileDescriptors(
+                  named_type->mutable_type(), file_descriptor_set_map));
+          named_type->set_name(name);
+          break;
+        }
+        case kFunctionObject: {
+          const Function* function =
+              zetasql_base::FindPtrOrNull(functions_, name);
+          ZETASQL_RET_CHECK(function != nullptr) << name;
+          if ((ignore_builtin && function->IsZetaSQLBuiltin()) ||
+              !changed_functions.insert(function).second) {
+            break;
+          }
+          ZETASQL_RETURN_IF_ERROR(function->Serialize(
+              file_descriptor_set_map, proto->add_add_custom_function()));
+          break;
+        }
+        case kTableValuedFunctionObject: {
+          const TableValuedFunction* function =
+              zetasql_base::FindPtrOrNull(table_valued_functions_, name);
+          ZETASQL_RET_CHECK(function != nullptr) << name;
+          ZETASQL_RETURN_IF_ERROR(function->Serialize(file_descriptor_set_map,
+                                              proto->add_add_custom_tvf()));
+          break;
+        }
+        case kProcedureObject: {
+          const Procedure* procedure =
+              zetasql_base::FindPtrOrNull(procedures_, name);
+          ZETASQL_RET_CHECK(procedure != nullptr) << name;
+          ZETASQL_RETURN_IF_ERROR(procedure->Serialize(file_descriptor_set_map,
+                                               proto->add_add_procedure()));
+          break;
+        }
+        case kCatalogObject: {
+          const Catalog* catalog = zetasql_base::FindPtrOrNull(catalogs_, name);
+          ZETASQL_RET_CHECK(catalog != nullptr) << name;
+          if (zetasql_base::ContainsKey(*seen_catalogs, catalog)) {
+            if (ignore_recursive) break;
+            return ::zetasql_base::UnknownErrorBuilder(ZETASQL_LOC)
+                   << "Recursive catalog not serializable.";
+          }
+          if (ignore_builtin &&
+              zetasql_base::ContainsKey(owned_zetasql_subcatalogs_, name)) {
+            break;
+          }
+          if (!catalog->Is<SimpleCatalog>()) {
+            return ::zetasql_base::UnknownErrorBuilder(ZETASQL_LOC)
+                   << "Cannot serialize non-SimpleCatalog " << name;
+          }
+          ZETASQL_RETURN_IF_ERROR(catalog->GetAs<SimpleCatalog>()->Serialize(
+              file_descriptor_set_map, proto->add_add_catalog(),
+              ignore_builtin, ignore_recursive));
+          break;
+        }
+        case kConstantObject: {
+          const Constant* constant =
+              zetasql_base::FindPtrOrNull(constants_, name);
+          ZETASQL_RET_CHECK(constant != nullptr) << name;
+          if (!constant->Is<SimpleConstant>()) {
+            return ::zetasql_base::UnknownErrorBuilder(ZETASQL_LOC)
+                   << "Cannot serialize non-SimpleConstant " << name;
+          }
+          ZETASQL_RETURN_IF_ERROR(constant->GetAs<SimpleConstant>()->Serialize(
+              file_descriptor_set_map, proto->add_add_constant()));
+          break;
+        }
+      }
+    }
+
+    for (const auto& entry : catalogs_) {
+      const bool builtin =
+          zetasql_base::ContainsKey(owned_zetasql_subcatalogs_, entry.first);
+      if (zetasql_base::ContainsKey(changes,
+                           std::make_pair(kCatalogObject, entry.first)) ||
+          zetasql_base::ContainsKey(*seen_catalogs, entry.second) ||
+          (ignore_builtin && builtin)) {
+        continue;
+      }
+      const SimpleCatalog* subcatalog =
+          dynamic_cast<const SimpleCatalog*>(entry.second);
+      if (subcatalog != nullptr) {
+        unchanged_catalogs.emplace(entry.first, subcatalog);
+      }
+    }
+  }
+  // Recurse without holding mutex_, since subcatalogs may refer back to
+  // this catalog.
+  for (const auto& entry : unchanged_catalogs) {
+    const SimpleCatalog* subcatalog = entry.second;
+    if (zetasql_base::ContainsKey(*seen_catalogs, subcatalog) ||
+        subcatalog->version() <= since_version) {
+      continue;
+    }
+    ZETASQL_RETURN_IF_ERROR(subcatalog->SerializeDeltaImpl(
+        since_version, seen_catalogs, file_descriptor_set_map,
+        proto->add_catalog(), ignore_builtin, ignore_recursive));
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+struct SimpleCatalog::DeltaObjects {
+  const SimpleCatalogDeltaProto* proto = nullptr;
+  SimpleCatalog* catalog = nullptr;
+  std::vector<std::pair<std::string, std::unique_ptr<SimpleTable>>> tables;
+  std::vector<std::pair<std::string, const Type*>> types;
+  std::vector<std::unique_ptr<Function>> functions;
+  std::vector<std::unique_ptr<TableValuedFunction>> table_valued_functions;
+  std::vector<std::unique_ptr<Procedure>> procedures;
+  std::vector<std::unique_ptr<SimpleCatalog>> catalogs;
+  std::vector<std::unique_ptr<SimpleConstant>> constants;
+  std::vector<DeltaObjects> nested;
+};
+
+zetasql_base::Status SimpleCatalog::ApplyDelta(
+    const SimpleCatalogDeltaProto& proto,
+    const std::vector<const google::protobuf::DescriptorPool*>& pools) {
+  DeltaObjects objects;
+  ZETASQL_RETURN_IF_ERROR(DeserializeDelta(proto, pools, &objects));
+  ApplyDeltaObjects(&objects);
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status SimpleCatalog::DeserializeDelta(
+    const SimpleCatalogDeltaProto& proto,
+    const std::vector<const google::protobuf::DescriptorPool*>& pools,
+    DeltaObjects* objects) {
+  objects->proto = &proto;
+  objects->catalog = this;
+  for (const auto& table_proto : proto.add_table()) {
+    std::unique_ptr<SimpleTable> table;
+    ZETASQL_RETURN_IF_ERROR(SimpleTable::Deserialize(table_proto, pools,
+                                             type_factory(), &table));
+    objects->tables.emplace_back(table_proto.has_name_in_catalog()
+                                     ? table_proto.name_in_catalog()
+                                     : table_proto.name(),
+                                 std::move(table));
+  }
+  for (const auto& named_type_proto : proto.add_named_type()) {
+    const Type* type;
+    ZETASQL_RETURN_IF_ERROR(
+        type_factory()->DeserializeFromProtoUsingExistingPools(
+            named_type_proto.type(), pools, &type));
+    objects->types.emplace_back(named_type_proto.name(), type);
+  }
+  for (const auto& function_proto : proto.add_custom_function()) {
+    std::unique_ptr<Function> function;
+    ZETASQL_RETURN_IF_ERROR(Function::Deserialize(function_proto, pools,
+                                          type_factory(), &function));
+    objects->functions.push_back(std::move(function));
+  }
+  for (const auto& tvf_proto : proto.add_custom_tvf()) {
+    std::unique_ptr<TableValuedFunction> tvf;
+    ZETASQL_RETURN_IF_ERROR(TableValuedFunction::Deserialize(
+        tvf_proto, pools, type_factory(), &tvf));
+    objects->table_valued_functions.push_back(std::move(tvf));
+  }
+  for (const auto& procedure_proto : proto.add_procedure()) {
+    std::unique_ptr<Procedure> procedure;
+    ZETASQL_RETURN_IF_ERROR(Procedure::Deserialize(procedure_proto, pools,
+                                           type_factory(), &procedure));
+    objects->procedures.push_back(std::move(procedure));
+  }
+  for (const auto& catalog_proto : proto.add_catalog()) {
+    auto catalog =
+        absl::make_unique<SimpleCatalog>(catalog_proto.name(), type_factory());
+    ZETASQL_RETURN_IF_ERROR(
+        DeserializeImpl(catalog_proto, pools, catalog.get()));
+    objects->catalogs.push_back(std::move(catalog));
+  }
+  for (const auto& constant_proto : proto.add_constant()) {
+    std::unique_ptr<SimpleConstant> constant;
+    ZETASQL_RETURN_IF_ERROR(SimpleConstant::Deserialize(
+        constant_proto, pools, type_factory(), &constant));
+    objects->constants.push_back(std::move(constant));
+  }
+  for (const auto& catalog_proto : proto.catalog()) {
+    Catalog* catalog = nullptr;
+    {
+      absl::MutexLock l(&mutex_);
+      catalog = zetasql_base::FindPtrOrNull(
+          catalogs_, absl::AsciiStrToLower(catalog_proto.name()));
+    }
+    SimpleCatalog* subcatalog = dynamic_cast<SimpleCatalog*>(catalog);
+    if (subcatalog == nullptr) {
+      return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+             << "Catalog " << name_ << " has no nested SimpleCatalog "
+             << catalog_proto.name() << " to apply a delta to";
+    }
+    objects->nested.emplace_back();
+    ZETASQL_RETURN_IF_ERROR(subcatalog->DeserializeDelta(catalog_proto, pools,
+                                                 &objects->nested.back()));
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+void SimpleCatalog::ApplyDeltaObjects(DeltaObjects* objects) {
+  const SimpleCatalogDeltaProto& proto = *objects->proto;
+  for (const std::string& name : proto.remove_table()) {
+    RemoveTable(name);
+  }
+  for (const std::string& name : proto.remove_function()) {
+    RemoveFunction(name);
+  }
+  for (const std::string& name : proto.remove_custom_tvf()) {
+    RemoveTableValuedFunction(name);
+  }
+  for (const std::string& name : proto.remove_catalog()) {
+    RemoveCatalog(name);
+  }
+  for (const std::string& name : proto.remove_constant()) {
+    RemoveConstant(name);
+  }
+
+  for (auto& name_and_table : objects->tables) {
+    RemoveTable(name_and_table.first);
+    AddOwnedTable(name_and_table.first, std::move(name_and_table.second));
+  }
+  for (const auto& name_and_type : objects->types) {
+    absl::MutexLock l(&mutex_);
+    // Types and procedures are never removed, so only a copy that is out
+    // of sync already has them.
+    types_.erase(absl::AsciiStrToLower(name_and_type.first));
+    AddTypeLocked(name_and_type.first, name_and_type.second);
+  }
+  for (std::unique_ptr<Function>& function : objects->functions) {
+    RemoveFunction(function->Name());
+    if (!function->alias_name().empty()) {
+      RemoveFunction(function->alias_name());
+    }
+    AddOwnedFunction(std::move(function));
+  }
+  for (std::unique_ptr<TableValuedFunction>& function :
+       objects->table_valued_functions) {
+    RemoveTableValuedFunction(function->Name());
+    AddOwnedTableValuedFunction(std::move(function));
+  }
+  for (std::unique_ptr<Procedure>& procedure : objects->procedures) {
+    {
+      absl::MutexLock l(&mutex_);
+      const auto it =
+          procedures_.find(absl::AsciiStrToLower(procedure->Name()));
+      if (it != procedures_.end()) {
+        EraseOwned(it->second, &owned_procedures_);
+        procedures_.erase(it);
+      }
+    }
+    AddOwnedProcedure(std::move(procedure));
+  }
+  for (std::unique_ptr<SimpleCatalog>& catalog : objects->catalogs) {
+    const std::string name = catalog->FullName();
+    RemoveCatalog(name);
+    AddOwnedCatalog(name, std::move(catalog));
+  }
+  for (std::unique_ptr<SimpleConstant>& constant : objects->constants) {
+    RemoveConstant(constant->Name());
+    AddOwnedConstant(std::move(constant));
+  }
+
+  for (DeltaObjects& nested : objects->nested) {
+    nested.catalog->ApplyDeltaObjects(&nested);
+  }
+}
+
 std::vector<std::string> SimpleCatalog::table_names() const {
-  absl::MutexLock l(&mutex_);
+  absl::MutexLockMaybe l(ReadMutex());
   std::vector<std::string> table_names;
   zetasql_base::AppendKeysFromMap(tables_, &table_names);
   return table_names;
 }
 
 std::vector<const Table*> SimpleCatalog::tables() const {
-  absl::MutexLock l(&mutex_);
+  absl::MutexLockMaybe l(ReadMutex());
   std::vector<const Table*> tables;
   zetasql_base::AppendValuesFromMap(tables_, &tables);
   return tables;
 }
 
 std::vector<const Type*> SimpleCatalog::types() const {
-  absl::MutexLock l(&mutex_);
+  absl::MutexLockMaybe l(ReadMutex());
   std::vector<const Type*> types;
   zetasql_base::AppendValuesFromMap(types_, &types);
   return types;
 }
 
 std::vector<std::string> SimpleCatalog::function_names() const {
-  absl::MutexLock l(&mutex_);
+  absl::MutexLockMaybe l(ReadMutex());
   std::vector<std::string> function_names;
   zetasql_base::AppendKeysFromMap(functions_, &function_names);
   return function_names;
 }
 
 std::vector<const Function*> SimpleCatalog::functions() const {
-  absl::MutexLock l(&mutex_);
+  absl::MutexLockMaybe l(ReadMutex());
   std::vector<const Function*> functions;
   zetasql_base::AppendValuesFromMap(functions_, &functions);
   return functions;
 }
 
 std::vector<std::string> SimpleCatalog::table_valued_function_names() const {
-  absl::MutexLock l(&mutex_);
+  absl::MutexLockMaybe l(ReadMutex());
   std::vector<std::string> table_valued_function_names;
   zetasql_base::AppendKeysFromMap(table_valued_functions_, &table_valued_function_names);
   return table_valued_function_names;
@@ -893,42 +1642,42 @@ std::vector<std::string> SimpleCatalog::table_valued_function_names() const {
 
 std::vector<const TableValuedFunction*> SimpleCatalog::table_valued_functions()
     const {
-  absl::MutexLock l(&mutex_);
+  absl::MutexLockMaybe l(ReadMutex());
   std::vector<const TableValuedFunction*> table_valued_functions;
   zetasql_base::AppendValuesFromMap(table_valued_functions_, &table_valued_functions);
   return table_valued_functions;
 }
 
 std::vector<const Procedure*> SimpleCatalog::procedures() const {
-  absl::MutexLock l(&mutex_);
+  absl::MutexLockMaybe l(ReadMutex());
   std::vector<const Procedure*> procedures;
   zetasql_base::AppendValuesFromMap(procedures_, &procedures);
   return procedures;
 }
 
 std::vector<std::string> SimpleCatalog::catalog_names() const {
-  absl::MutexLock l(&mutex_);
+  absl::MutexLockMaybe l(ReadMutex());
   std::vector<std::string> catalog_names;
   zetasql_base::AppendKeysFromMap(catalogs_, &catalog_names);
   return catalog_names;
 }
 
 std::vector<Catalog*> SimpleCatalog::catalogs() const {
-  absl::MutexLock l(&mutex_);
+  absl::MutexLockMaybe l(ReadMutex());
   std::vector<Catalog*> catalogs;
   zetasql_base::AppendValuesFromMap(catalogs_, &catalogs);
   return catalogs;
 }
 
 std::vector<std::string> SimpleCatalog::constant_names() const {
-  absl::MutexLock l(&mutex_);
+  absl::MutexLockMaybe l(ReadMutex());
   std::vector<std::string> constant_names;
   zetasql_base::AppendKeysFromMap(constants_, &constant_names);
   return constant_names;
 }
 
 std::vector<const Constant*> SimpleCatalog::constants() const {
-  absl::MutexLock l(&mutex_);
+  absl::MutexLockMaybe l(ReadMutex());
   std::vector<const Constant*> constants;
   zetasql_base::AppendValuesFromMap(constants_, &constants);
   return constants;
@@ -1016,6 +1765,193 @@ zetasql_base::Status SimpleTable::InsertColumnToColumnMap(const Column* column)
   return ::zetasql_base::OkStatus();
 }
 
+zetasql_base::Status SimpleTable::SetContents(
+    const std::vector<std::vector<Value>>& rows,
+    const ColumnarTableOptions& options) {
+  std::vector<const Type*> column_types;
+  for (const Column* column : columns_) {
+    column_types.push_back(column->GetType());
+  }
+  std::unique_ptr<ColumnarTableContents> contents;
+  ZETASQL_RETURN_IF_ERROR(
+      ColumnarTableContents::Create(column_types, rows, options, &contents));
+  contents_ = std::move(contents);
+  contents_version_ = catalog_version_sequence.GetNext();
+  for (std::shared_ptr<const Index>& index : indexes_) {
+    ZETASQL_ASSIGN_OR_RETURN(index, BuildIndex(index->key_columns));
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+std::string SimpleTable::GetVersionToken() const {
+  return contents_ == nullptr ? "" : absl::StrCat(contents_version_);
+}
+
+zetasql_base::Status SimpleTable::AddIndex(std::vector<int> key_column_idxs) {
+  if (contents_ == nullptr) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "Table " << FullName() << " has no contents to index";
+  }
+  ZETASQL_ASSIGN_OR_RETURN(std::shared_ptr<const Index> index,
+                   BuildIndex(std::move(key_column_idxs)));
+  indexes_.push_back(std::move(index));
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::StatusOr<std::shared_ptr<const SimpleTable::Index>>
+SimpleTable::BuildIndex(std::vector<int> key_columns) const {
+  ZETASQL_RETURN_IF_ERROR(GetColumnNames(key_columns).status());
+  auto index = std::make_shared<Index>();
+  index->key_columns = std::move(key_columns);
+  std::vector<Value> key(index->key_columns.size());
+  for (int chunk = 0; chunk < contents_->num_chunks(); ++chunk) {
+    for (int row = 0; row < contents_->chunk_num_rows(chunk); ++row) {
+      bool matchable = true;
+      for (int k = 0; k < key.size() && matchable; ++k) {
+        key[k] = contents_->GetValue(chunk, row, index->key_columns[k]);
+        matchable = !IsNullOrNaN(key[k]);
+      }
+      if (matchable) index->rows[key].emplace_back(chunk, row);
+    }
+  }
+  return std::shared_ptr<const Index>(std::move(index));
+}
+
+const SimpleTable::Index* SimpleTable::FindIndex(
+    absl::Span<const int> key_columns) const {
+  for (const std::shared_ptr<const Index>& index : indexes_) {
+    if (absl::Span<const int>(index->key_columns) == key_columns) {
+      return index.get();
+    }
+  }
+  return nullptr;
+}
+
+bool SimpleTable::SupportsIndexLookup(
+    absl::Span<const int> key_column_idxs) const {
+  return FindIndex(key_column_idxs) != nullptr;
+}
+
+zetasql_base::StatusOr<std::unique_ptr<EvaluatorTableIterator>>
+SimpleTable::CreateIndexLookupIterator(
+    absl::Span<const int> column_idxs, absl::Span<const int> key_column_idxs,
+    absl::Span<const std::vector<Value>> keys) const {
+  const Index* index = FindIndex(key_column_idxs);
+  if (index == nullptr) {
+    return Table::CreateIndexLookupIterator(column_idxs, key_column_idxs,
+                                            keys);
+  }
+  ZETASQL_ASSIGN_OR_RETURN(std::vector<std::string> column_names,
+                   GetColumnNames(column_idxs));
+  std::vector<IndexLookupIterator::Match> matches;
+  for (int64_t i = 0; i < keys.size(); ++i) {
+    const std::vector<Value>& key = keys[i];
+    if (key.size() != key_column_idxs.size()) {
+      return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+             << "Key " << i << " of the lookup in " << FullName() << " has "
+             << key.size() << " values instead of " << key_column_idxs.size();
+    }
+    for (int k = 0; k < key.size(); ++k) {
+      const Type* type = contents_->column_type(key_column_idxs[k]);
+      if (!key[k].is_valid() || !key[k].type()->Equivalent(type)) {
+        return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+               << "Key " << i << " of the lookup in " << FullName()
+               << " does not have the type " << type->DebugString()
+               << " of column " << columns_[key_column_idxs[k]]->Name();
+      }
+    }
+    const auto it = index->rows.find(key);
+    if (it == index->rows.end()) continue;
+    for (const std::pair<int, int>& row : it->second) {
+      matches.push_back({i, row.first, row.second});
+    }
+  }
+  return std::unique_ptr<EvaluatorTableIterator>(
+      absl::make_unique<IndexLookupIterator>(
+          contents_, std::vector<int>(column_idxs.begin(), column_idxs.end()),
+          std::move(column_names), std::move(matches)));
+}
+
+zetasql_base::StatusOr<std::unique_ptr<EvaluatorTableIterator>>
+SimpleTable::CreateEvaluatorTableIterator(
+    absl::Span<const int> column_idxs) const {
+  if (contents_ == nullptr) {
+    return Table::CreateEvaluatorTableIterator(column_idxs);
+  }
+  return CreateChunkIterator(column_idxs, 0, contents_->num_chunks());
+}
+
+zetasql_base::StatusOr<std::vector<std::unique_ptr<EvaluatorTableIterator>>>
+SimpleTable::CreatePartitionedIterators(absl::Span<const int> column_idxs,
+                                        int max_partitions) const {
+  if (contents_ == nullptr || max_partitions <= 0) {
+    return Table::CreatePartitionedIterators(column_idxs, max_partitions);
+  }
+  const int num_chunks = contents_->num_chunks();
+  const int num_partitions = std::max(1, std::min(max_partitions, num_chunks));
+  std::vector<std::unique_ptr<EvaluatorTableIterator>> iterators;
+  for (int i = 0; i < num_partitions; ++i) {
+    ZETASQL_ASSIGN_OR_RETURN(
+        std::unique_ptr<EvaluatorTableIterator> iterator,
+        CreateChunkIterator(column_idxs, num_chunks * i / num_partitions,
+                            num_chunks * (i + 1) / num_partitions));
+    iterators.push_back(std::move(iterator));
+  }
+  return iterators;
+}
+
+zetasql_base::StatusOr<std::unique_ptr<EvaluatorTableIterator>>
+SimpleTable::CreateChunkIterator(absl::Span<const int> column_idxs,
+                                 int begin_chunk, int end_chunk) const {
+  ZETASQL_ASSIGN_OR_RETURN(std::vector<std::string> column_names,
+                   GetColumnNames(column_idxs));
+  return ColumnarTableContents::CreateIterator(
+      contents_, column_idxs, std::move(column_names), begin_chunk, end_chunk);
+}
+
+zetasql_base::StatusOr<std::vector<std::string>> SimpleTable::GetColumnNames(
+    absl::Span<const int> column_idxs) const {
+  std::vector<std::string> column_names;
+  for (const int column : column_idxs) {
+    if (column < 0 || column >= contents_->num_columns()) {
+      return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+             << "Table " << FullName() << " has no column " << column;
+    }
+    column_names.push_back(columns_[column]->Name());
+  }
+  return column_names;
+}
+
+zetasql_base::Status SimpleTable::SetStatistics(TableStatistics statistics) {
+  if (!statistics.columns.empty() &&
+      statistics.columns.size() != columns_.size()) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "Statistics of table " << FullName() << " have "
+           << statistics.columns.size() << " columns instead of "
+           << columns_.size();
+  }
+  for (int i = 0; i < statistics.columns.size(); ++i) {
+    const ColumnStatistics& column = statistics.columns[i];
+    for (const Value* bound : {&column.min, &column.max}) {
+      if (bound->is_valid() &&
+          !bound->type()->Equivalent(columns_[i]->GetType())) {
+        return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+               << "Statistics of column " << columns_[i]->FullName()
+               << " have a bound of type " << bound->type()->DebugString()
+               << " instead of " << columns_[i]->GetType()->DebugString();
+      }
+    }
+    if (column.null_fraction.has_value() &&
+        !(*column.null_fraction >= 0 && *column.null_fraction <= 1)) {
+      return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+             << "Statistics of column " << columns_[i]->FullName()
+             << " have a null fraction outside [0, 1]";
+    }
+  }
+  statistics_ = std::move(statistics);
+  return ::zetasql_base::OkStatus();
+}
+
 zetasql_base::Status SimpleTable::Serialize(
     FileDescriptorSetMap* file_descriptor_set_map,
     SimpleTableProto* proto) const {
@@ -1036,6 +1972,10 @@ zetasql_base::Status SimpleTable::Serialize(
   if (allow_duplicate_column_names_) {
     proto->set_allow_duplicate_column_names(true);
   }
+  if (statistics_.has_value()) {
+    ZETASQL_RETURN_IF_ERROR(
+        SerializeTableStatistics(*statistics_, proto->mutable_statistics()));
+  }
   return ::zetasql_base::OkStatus();
 }
 
@@ -1058,6 +1998,12 @@ zetasql_base::Status SimpleTable::Deserialize(
         column_proto, table->Name(), pools, factory, &column));
     ZETASQL_RETURN_IF_ERROR(table->AddColumn(column.release(), true  /* owned */));
   }
+  if (proto.has_statistics()) {
+    TableStatistics statistics;
+    ZETASQL_RETURN_IF_ERROR(
+        DeserializeTableStatistics(proto.statistics(), *table, &statistics));
+    ZETASQL_RETURN_IF_ERROR(table->SetStatistics(std::move(statistics)));
+  }
   *result = std::move(table);
   return ::zetasql_base::OkStatus();
 }
@@ -17,6 +17,7 @@
 #ifndef ZETASQL_PUBLIC_SIMPLE_CATALOG_H_
 #define ZETASQL_PUBLIC_SIMPLE_CATALOG_H_
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <utility>
@@ -26,8 +27,10 @@
 #include "google/protobuf/descriptor.h"
 #include "zetasql/public/builtin_function.h"
 #include "zetasql/public/catalog.h"
+#include "zetasql/public/columnar_table_contents.h"
 #include "zetasql/public/constant.h"
 #include "zetasql/public/function.h"
+#include "zetasql/public/id_string.h"
 #include "zetasql/public/procedure.h"
 #include "zetasql/public/table_valued_function.h"
 #include "zetasql/public/type.h"
@@ -37,12 +40,14 @@
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "zetasql/base/ret_check.h"
 #include "zetasql/base/status.h"
 
 namespace zetasql {
 
+class SimpleCatalogDeltaProto;
 class SimpleCatalogProto;
 class SimpleColumnProto;
 class SimpleConstantProto;
@@ -101,6 +106,22 @@ class SimpleCatalog : public Catalog {
                            const FindOptions& options = FindOptions()) override
       LOCKS_EXCLUDED(mutex_);
 
+  // Finds a table by IdString path using the IdString versions of GetTable()
+  // and GetCatalog() below.  These use the case-insensitive hash memoized in
+  // each IdString, so no lower case copy of the names is made.
+  using Catalog::FindTable;
+  zetasql_base::Status FindTable(absl::Span<const IdString> path, const Table** table,
+                         const FindOptions& options = FindOptions()) override;
+
+  // IdString versions of GetTable() and GetCatalog().  Subclasses that
+  // override GetTable() or GetCatalog() must override these too.
+  virtual zetasql_base::Status GetTable(IdString name, const Table** table,
+                                const FindOptions& options = FindOptions())
+      LOCKS_EXCLUDED(mutex_);
+  virtual zetasql_base::Status GetCatalog(IdString name, Catalog** catalog,
+                                  const FindOptions& options = FindOptions())
+      LOCKS_EXCLUDED(mutex_);
+
   // For suggestions we look from the last level of <mistyped_path>:
   //  - Whether the object exists directly in sub-catalogs.
   //  - If not above, whether there is a single name that's misspelled in the
@@ -233,6 +254,17 @@ class SimpleCatalog : public Catalog {
   // Consider the unique_ptr version.
   void AddOwnedConstant(const Constant* constant) LOCKS_EXCLUDED(mutex_);
 
+  // Remove objects from the SimpleCatalog by name, case-insensitively.
+  // Removing a function also removes its alias.  Owned objects are deleted,
+  // so nothing may still be using them.  Return false if there is no object
+  // with <name>.
+  bool RemoveTable(const std::string& name) LOCKS_EXCLUDED(mutex_);
+  bool RemoveFunction(const std::string& name) LOCKS_EXCLUDED(mutex_);
+  bool RemoveConstant(const std::string& name) LOCKS_EXCLUDED(mutex_);
+  bool RemoveTableValuedFunction(const std::string& name)
+      LOCKS_EXCLUDED(mutex_);
+  bool RemoveCatalog(const std::string& name) LOCKS_EXCLUDED(mutex_);
+
   // Add ZetaSQL built-in function definitions into this catalog.
   // <options> can be used to select which functions get loaded.
   // See builtin_function.h. Provided such functions are specified in <options>
@@ -245,6 +277,16 @@ class SimpleCatalog : public Catalog {
                                  ZetaSQLBuiltinFunctionOptions())
       LOCKS_EXCLUDED(mutex_);
 
+  // Like AddZetaSQLFunctions(), but adds the functions from the process-wide
+  // registry returned by GetSharedZetaSQLFunctions() instead of building new
+  // ones.  After the first call with the same <options>, this constructs no
+  // Functions or FunctionSignatures.  The functions are not owned by this
+  // catalog, and their types come from the registry's TypeFactory rather
+  // than from type_factory().
+  void AddSharedZetaSQLFunctions(
+      const ZetaSQLBuiltinFunctionOptions& options =
+          ZetaSQLBuiltinFunctionOptions()) LOCKS_EXCLUDED(mutex_);
+
   // Set the google::protobuf::DescriptorPool to use when resolving Types.
   // All message and enum types declared in <pool> will be resolvable with
   // FindType or GetType, treating the full name as one identifier.
@@ -299,9 +341,59 @@ class SimpleCatalog : public Catalog {
                          bool ignore_recursive = true) const
       LOCKS_EXCLUDED(mutex_);
 
+  // Serializes the changes to this catalog and to the SimpleCatalogs nested
+  // in it since <since_version>, a value previously returned by version(),
+  // so that a copy of the catalog made at that version with Serialize() and
+  // Deserialize() can be brought up to date with ApplyDelta().  Objects
+  // added or replaced since then are serialized in full, and removed ones
+  // by name, so the delta costs in proportion to the changes rather than to
+  // the catalog.  The other arguments are as for Serialize().
+  //
+  // To keep a copy in sync, read version() before each call and pass it as
+  // <since_version> to the next one.  Changes made in between may then be
+  // sent twice, which is harmless.  As for version(), changes inside the
+  // objects, or inside nested catalogs that are not SimpleCatalogs, are not
+  // included.  Models are never serialized.
+  zetasql_base::Status SerializeDelta(int64_t since_version,
+                              FileDescriptorSetMap* file_descriptor_set_map,
+                              SimpleCatalogDeltaProto* proto,
+                              bool ignore_builtin = true,
+                              bool ignore_recursive = true) const
+      LOCKS_EXCLUDED(mutex_);
+
+  // Applies <proto>, from SerializeDelta() of another catalog, to this one.
+  // Types are deserialized using <pools> as in Deserialize().  All new
+  // objects are deserialized before the catalog is changed, so it is
+  // unchanged if an error is returned.
+  zetasql_base::Status ApplyDelta(
+      const SimpleCatalogDeltaProto& proto,
+      const std::vector<const google::protobuf::DescriptorPool*>& pools)
+      LOCKS_EXCLUDED(mutex_);
+
   // Return a TypeFactory owned by this SimpleCatalog.
   TypeFactory* type_factory() LOCKS_EXCLUDED(mutex_);
 
+  // Returns a value that changes whenever an object is added to or removed
+  // from this catalog or from any SimpleCatalog nested in it.  Versions only
+  // increase, and are never shared between two distinct catalog states, so
+  // (catalog pointer, version()) identifies the contents of the catalog
+  // tree.  Changes inside nested catalogs that are not SimpleCatalogs, or
+  // inside the objects the catalog refers to, are not reflected.
+  int64_t version() const LOCKS_EXCLUDED(mutex_);
+
+  // Makes this catalog read-only.  After Freeze() returns, lookups and the
+  // accessors below no longer take <mutex_>, so a frozen catalog can be
+  // shared by many threads without lock contention.  Any attempt to add or
+  // remove objects afterwards is a fatal error.
+  //
+  // Freeze() must not be called concurrently with mutations.  It also
+  // freezes the subcatalogs created by AddZetaSQLFunctions(), but not other
+  // nested catalogs, which may be shared with other parents.  Subclasses
+  // that add objects during lookups, like LazySimpleCatalog, must not be
+  // frozen.
+  void Freeze() LOCKS_EXCLUDED(mutex_);
+  bool is_frozen() const { return frozen_.load(std::memory_order_acquire); }
+
   // Accessors for reading a copy of the object lists in this SimpleCatalog.
   // This is intended primarily for tests.
   std::vector<const Table*> tables() const LOCKS_EXCLUDED(mutex_);
@@ -324,6 +416,14 @@ class SimpleCatalog : public Catalog {
   std::vector<std::string> catalog_names() const LOCKS_EXCLUDED(mutex_);
   std::vector<std::string> constant_names() const LOCKS_EXCLUDED(mutex_);
 
+ protected:
+  // Adds the objects described by <proto> to <catalog>, deserializing types
+  // using <catalog>'s TypeFactory and <pools>.
+  static zetasql_base::Status DeserializeImpl(
+      const SimpleCatalogProto& proto,
+      const std::vector<const google::protobuf::DescriptorPool*>& pools,
+      SimpleCatalog* catalog);
+
  private:
   zetasql_base::Status SerializeImpl(absl::flat_hash_set<const Catalog*>* seen_catalogs,
                              FileDescriptorSetMap* file_descriptor_set_map,
@@ -331,6 +431,24 @@ class SimpleCatalog : public Catalog {
                              bool ignore_recursive) const
       LOCKS_EXCLUDED(mutex_);
 
+  // The objects deserialized from a SimpleCatalogDeltaProto by ApplyDelta().
+  struct DeltaObjects;
+
+  // Implements SerializeDelta(), skipping catalogs in <seen_catalogs>.
+  zetasql_base::Status SerializeDeltaImpl(
+      int64_t since_version, absl::flat_hash_set<const Catalog*>* seen_catalogs,
+      FileDescriptorSetMap* file_descriptor_set_map,
+      SimpleCatalogDeltaProto* proto, bool ignore_builtin,
+      bool ignore_recursive) const LOCKS_EXCLUDED(mutex_);
+  // Deserializes the objects of <proto> to add to this catalog and to its
+  // nested catalogs.
+  zetasql_base::Status DeserializeDelta(
+      const SimpleCatalogDeltaProto& proto,
+      const std::vector<const google::protobuf::DescriptorPool*>& pools,
+      DeltaObjects* objects) LOCKS_EXCLUDED(mutex_);
+  // Applies the changes of <objects>, which cannot fail.
+  void ApplyDeltaObjects(DeltaObjects* objects) LOCKS_EXCLUDED(mutex_);
+
   // Implements AddCatalog() interface for callers that already own mutex_.
   void AddCatalogLocked(const std::string& name, Catalog* catalog)
       EXCLUSIVE_LOCKS_REQUIRED(mutex_);
@@ -352,6 +470,69 @@ class SimpleCatalog : public Catalog {
   void AddTypeLocked(const std::string& name, const Type* type)
       EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
+  // Returns the catalog to add the builtin function with name path <path>
+  // to: this catalog, or a subcatalog for the function's namespace, which is
+  // created if necessary.
+  SimpleCatalog* GetZetaSQLFunctionCatalog(const std::vector<std::string>& path,
+                                           TypeFactory* type_factory)
+      LOCKS_EXCLUDED(mutex_);
+
+  // Assigns a new version to this catalog.  Must be called by every method
+  // that changes the contents of the name maps below.  Fails if the catalog
+  // is frozen.
+  void BumpVersionLocked() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // The kinds of objects in <changes_>.
+  enum ObjectKind {
+    kTableObject,
+    kTypeObject,
+    kFunctionObject,
+    kTableValuedFunctionObject,
+    kProcedureObject,
+    kCatalogObject,
+    kConstantObject,
+  };
+  // Records in <changes_> that the object of <kind> with lower case name
+  // <name> was added or replaced, or <removed>, at the current version.
+  // Must be called after BumpVersionLocked().
+  void RecordChangeLocked(ObjectKind kind, const std::string& name,
+                          bool removed) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Returns the mutex to hold while reading the name maps below, or NULL if
+  // the catalog is frozen and no locking is needed.
+  absl::Mutex* ReadMutex() const LOCK_RETURNED(mutex_) {
+    return is_frozen() ? nullptr : &mutex_;
+  }
+
+  // Hash and equality functors for name maps keyed by lower case name, that
+  // also accept IdStrings as lookup keys.  Both hashes must agree with
+  // IdString::HashCase().
+  struct NameHash {
+    using is_transparent = void;
+    size_t operator()(const std::string& name) const {
+      return std::hash<std::string>()(name);
+    }
+    size_t operator()(IdString name) const { return name.HashCase(); }
+  };
+  struct NameEq {
+    using is_transparent = void;
+    bool operator()(const std::string& a, const std::string& b) const {
+      return a == b;
+    }
+    bool operator()(const std::string& a, IdString b) const {
+      return a == b.ToLowerStringView();
+    }
+    bool operator()(IdString a, const std::string& b) const {
+      return a.ToLowerStringView() == b;
+    }
+  };
+  template <class T>
+  using NameMap = absl::flat_hash_map<std::string, T, NameHash, NameEq>;
+
+  // Implements version(), skipping catalogs already in <seen_catalogs>.
+  int64_t VersionImpl(absl::flat_hash_set<const Catalog*>* seen_catalogs) const
+      LOCKS_EXCLUDED(mutex_);
+
   // Unified implementation of SuggestFunction and SuggestTableValuedFunction.
   std::string SuggestFunctionOrTableValuedFunction(
       bool is_table_valued_function, absl::Span<const std::string> mistyped_path);
@@ -364,14 +545,29 @@ class SimpleCatalog : public Catalog {
   TypeFactory* type_factory_ GUARDED_BY(mutex_);
   std::unique_ptr<TypeFactory> owned_type_factory_ GUARDED_BY(mutex_);
 
-  absl::flat_hash_map<std::string, const Table*> tables_ GUARDED_BY(mutex_);
+  int64_t version_ GUARDED_BY(mutex_);
+
+  // For SerializeDelta(): the last version at which the object of each kind
+  // and name was added or removed.  Removed names are kept, so this grows
+  // with the number of distinct names ever used.
+  struct ObjectChange {
+    int64_t version;
+    bool removed;
+  };
+  absl::flat_hash_map<std::pair<ObjectKind, std::string>, ObjectChange>
+      changes_ GUARDED_BY(mutex_);
+
+  // Once true, the catalog never changes again.  See Freeze().
+  std::atomic<bool> frozen_{false};
+
+  NameMap<const Table*> tables_ GUARDED_BY(mutex_);
   absl::flat_hash_map<std::string, const Model*> models_ GUARDED_BY(mutex_);
   absl::flat_hash_map<std::string, const Type*> types_ GUARDED_BY(mutex_);
   absl::flat_hash_map<std::string, const Function*> functions_ GUARDED_BY(mutex_);
   absl::flat_hash_map<std::string, const TableValuedFunction*>
       table_valued_functions_ GUARDED_BY(mutex_);
   absl::flat_hash_map<std::string, const Procedure*> procedures_ GUARDED_BY(mutex_);
-  absl::flat_hash_map<std::string, Catalog*> catalogs_ GUARDED_BY(mutex_);
+  NameMap<Catalog*> catalogs_ GUARDED_BY(mutex_);
   absl::flat_hash_map<std::string, const Constant*> constants_ GUARDED_BY(mutex_);
 
   std::vector<std::unique_ptr<const Table>> owned_tables_ GUARDED_BY(mutex_);
@@ -462,6 +658,55 @@ class SimpleTable : public Table {
   // deleted inside this function.
   zetasql_base::Status AddColumn(const Column* column, bool is_owned);
 
+  // Sets the rows returned by CreateEvaluatorTableIterator(), each with one
+  // value of the type of each column. The rows are stored by column in
+  // chunks, see ColumnarTableContents, and scans skip the chunks in which no
+  // row can pass the filters of the scan. Columns must not be added
+  // afterwards.
+  zetasql_base::Status SetContents(
+      const std::vector<std::vector<Value>>& rows,
+      const ColumnarTableOptions& options = ColumnarTableOptions());
+
+  // Returns the rows set by SetContents(), or null.
+  const ColumnarTableContents* contents() const { return contents_.get(); }
+
+  // Changes on every call to SetContents(). Empty without contents.
+  std::string GetVersionToken() const override;
+
+  // Adds a hash index on the columns <key_column_idxs> of the contents for
+  // CreateIndexLookupIterator(), which is rebuilt by later calls to
+  // SetContents(). Returns an error if SetContents() was not called or a
+  // column is out of range.
+  zetasql_base::Status AddIndex(std::vector<int> key_column_idxs);
+
+  // Sets the result of GetStatistics(). Returns an error if <statistics> has
+  // column statistics that are not one per column, or with a min or max of
+  // another type than the column. Columns must not be added afterwards.
+  zetasql_base::Status SetStatistics(TableStatistics statistics);
+
+  const TableStatistics* GetStatistics() const override {
+    return statistics_.has_value() ? &statistics_.value() : nullptr;
+  }
+
+  // Returns an error if SetContents() was not called.
+  zetasql_base::StatusOr<std::unique_ptr<EvaluatorTableIterator>>
+  CreateEvaluatorTableIterator(
+      absl::Span<const int> column_idxs) const override;
+
+  // With contents, each iterator reads a range of consecutive chunks.
+  zetasql_base::StatusOr<std::vector<std::unique_ptr<EvaluatorTableIterator>>>
+  CreatePartitionedIterators(absl::Span<const int> column_idxs,
+                             int max_partitions) const override;
+
+  // True if AddIndex() was called with <key_column_idxs>.
+  bool SupportsIndexLookup(
+      absl::Span<const int> key_column_idxs) const override;
+
+  zetasql_base::StatusOr<std::unique_ptr<EvaluatorTableIterator>>
+  CreateIndexLookupIterator(
+      absl::Span<const int> column_idxs, absl::Span<const int> key_column_idxs,
+      absl::Span<const std::vector<Value>> keys) const override;
+
   int64_t GetSerializationId() const override { return id_; }
 
   // Serialize this table into protobuf. The provided map is used to store
@@ -488,6 +733,8 @@ class SimpleTable : public Table {
  protected:
 
  private:
+  struct Index;
+
   // Insert a column to columns_map_. Return error when
   // allow_anonymous_column_name_ or allow_duplicate_column_names_ are violated.
   // Furthermore, if the column's name is duplicated, it's recorded in
@@ -495,6 +742,21 @@ class SimpleTable : public Table {
   // columns_map_.
   zetasql_base::Status InsertColumnToColumnMap(const Column* column);
 
+  // Returns an iterator over chunks [begin_chunk, end_chunk) of contents_.
+  zetasql_base::StatusOr<std::unique_ptr<EvaluatorTableIterator>>
+  CreateChunkIterator(absl::Span<const int> column_idxs, int begin_chunk,
+                      int end_chunk) const;
+
+  // Returns the names of <column_idxs>, or an error if one is out of range.
+  zetasql_base::StatusOr<std::vector<std::string>> GetColumnNames(
+      absl::Span<const int> column_idxs) const;
+
+  // Returns an index of contents_ on <key_columns>.
+  zetasql_base::StatusOr<std::shared_ptr<const Index>> BuildIndex(
+      std::vector<int> key_columns) const;
+  // Returns the index added on <key_columns>, or null.
+  const Index* FindIndex(absl::Span<const int> key_columns) const;
+
   const std::string name_;
   bool is_value_table_ = false;
   std::vector<const Column*> columns_;
@@ -505,6 +767,12 @@ class SimpleTable : public Table {
   bool allow_anonymous_column_name_ = false;
   bool anonymous_column_seen_ = false;
   bool allow_duplicate_column_names_ = false;
+  std::shared_ptr<const ColumnarTableContents> contents_;
+  // From the same process-wide sequence as SimpleCatalog versions, so that
+  // a token is never reused by another table.
+  int64_t contents_version_ = 0;
+  std::vector<std::shared_ptr<const Index>> indexes_;
+  absl::optional<TableStatistics> statistics_;
 
   static zetasql_base::Status ValidateNonEmptyColumnName(const std::string& column_name);
 };
@@ -0,0 +1,531 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/simple_catalog.h"
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/proto/simple_catalog.pb.h"
+#include "zetasql/public/builtin_function.h"
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/id_string.h"
+#include "zetasql/public/language_options.h"
+#include "zetasql/public/simple_table.pb.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/time/time.h"
+
+namespace zetasql {
+
+TEST(SimpleCatalogTest, FrozenCatalogLookups) {
+  SimpleCatalog catalog("root");
+  catalog.AddOwnedTable(
+      new SimpleTable("T", {{"a", catalog.type_factory()->get_int64()}}));
+  catalog.MakeOwnedSimpleCatalog("nested");
+  catalog.AddZetaSQLFunctions(
+      ZetaSQLBuiltinFunctionOptions(LanguageOptions()));
+  const int64_t version = catalog.version();
+
+  EXPECT_FALSE(catalog.is_frozen());
+  catalog.Freeze();
+  EXPECT_TRUE(catalog.is_frozen());
+  EXPECT_EQ(version, catalog.version());
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&catalog]() {
+      for (int j = 0; j < 100; ++j) {
+        const Table* table;
+        ZETASQL_EXPECT_OK(catalog.GetTable("t", &table));
+        EXPECT_EQ("T", table->Name());
+        const Function* function;
+        ZETASQL_EXPECT_OK(catalog.GetFunction("$add", &function));
+        EXPECT_NE(nullptr, function);
+        Catalog* nested;
+        ZETASQL_EXPECT_OK(catalog.GetCatalog("nested", &nested));
+        EXPECT_NE(nullptr, nested);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(1, catalog.tables().size());
+  EXPECT_NE(nullptr, catalog.type_factory());
+}
+
+TEST(SimpleCatalogTest, FindTableByIdString) {
+  SimpleCatalog catalog("root");
+  catalog.AddOwnedTable(
+      new SimpleTable("T1", {{"a", catalog.type_factory()->get_int64()}}));
+  SimpleCatalog* nested = catalog.MakeOwnedSimpleCatalog("Nested");
+  nested->AddOwnedTable(
+      new SimpleTable("T2", {{"b", catalog.type_factory()->get_int64()}}));
+
+  IdStringPool pool;
+  const Table* table;
+  ZETASQL_ASSERT_OK(catalog.FindTable({pool.Make("t1")}, &table));
+  EXPECT_EQ("T1", table->Name());
+  ZETASQL_ASSERT_OK(
+      catalog.FindTable({pool.Make("NESTED"), pool.Make("t2")}, &table));
+  EXPECT_EQ("T2", table->Name());
+
+  // Lookups through the Catalog interface use the same overload.
+  Catalog* base = &catalog;
+  ZETASQL_ASSERT_OK(base->FindTable({pool.Make("T1")}, &table));
+  EXPECT_EQ("T1", table->Name());
+
+  zetasql_base::Status status =
+      catalog.FindTable({pool.Make("nested"), pool.Make("t1")}, &table);
+  EXPECT_EQ(zetasql_base::StatusCode::kNotFound, status.code());
+  EXPECT_EQ(nullptr, table);
+  status = catalog.FindTable({pool.Make("missing"), pool.Make("t1")}, &table);
+  EXPECT_EQ(zetasql_base::StatusCode::kNotFound, status.code());
+  EXPECT_THAT(status.message(),
+              ::testing::HasSubstr("catalog missing not found"));
+}
+
+TEST(SimpleCatalogTest, LookupCallback) {
+  SimpleCatalog catalog("root");
+  SimpleCatalog* nested = catalog.MakeOwnedSimpleCatalog("nested");
+  nested->AddOwnedTable(
+      new SimpleTable("T", {{"a", catalog.type_factory()->get_int64()}}));
+  std::unique_ptr<SimpleConstant> constant;
+  ZETASQL_ASSERT_OK(SimpleConstant::Create({"C"}, Value::Int64(1), &constant));
+  nested->AddOwnedConstant(std::move(constant));
+
+  std::vector<std::string> events;
+  Catalog::FindOptions options;
+  options.set_lookup_callback([&events](const Catalog::LookupEvent& event) {
+    EXPECT_GE(event.latency, absl::ZeroDuration());
+    events.push_back(absl::StrCat(event.catalog->FullName(), " ",
+                                  event.object_kind, " ",
+                                  absl::StrJoin(event.path, "."), " ",
+                                  event.status->ok()));
+  });
+
+  // Lookups in nested catalogs are reported, by both FindTable() overloads.
+  const Table* table;
+  ZETASQL_ASSERT_OK(catalog.FindTable({"nested", "T"}, &table, options));
+  IdStringPool pool;
+  ZETASQL_ASSERT_OK(catalog.FindTable({pool.Make("nested"), pool.Make("t")}, &table,
+                              options));
+  const Constant* found_constant;
+  ZETASQL_ASSERT_OK(
+      catalog.FindConstant({"nested", "C"}, &found_constant, options));
+  const Type* type;
+  EXPECT_FALSE(catalog.FindType({"nested", "X"}, &type, options).ok());
+  EXPECT_THAT(events, ::testing::ElementsAre(
+                          "nested Table T 1", "nested Table t 1",
+                          "nested Constant C 1", "nested Type X 0"));
+
+  // Top-level lookups are reported by their callers, through TraceLookup().
+  events.clear();
+  const std::vector<std::string> path = {"nested", "T"};
+  ZETASQL_ASSERT_OK(Catalog::TraceLookup(&catalog, "Table", path, options, [&] {
+    return catalog.FindTable(path, &table, options);
+  }));
+  EXPECT_THAT(events, ::testing::ElementsAre("nested Table T 1",
+                                             "root Table nested.T 1"));
+
+  // Without a callback, nothing is reported.
+  events.clear();
+  ZETASQL_ASSERT_OK(catalog.FindTable({"nested", "T"}, &table));
+  EXPECT_TRUE(events.empty());
+}
+
+TEST(SimpleCatalogTest, RemoveObjects) {
+  SimpleCatalog catalog("root");
+  catalog.AddOwnedTable(
+      new SimpleTable("T", {{"a", catalog.type_factory()->get_int64()}}));
+  catalog.AddOwnedFunction(absl::make_unique<Function>(
+      "F", "test_group", Function::SCALAR, std::vector<FunctionSignature>(),
+      FunctionOptions().set_alias_name("F_alias")));
+  std::unique_ptr<SimpleConstant> constant;
+  ZETASQL_ASSERT_OK(SimpleConstant::Create({"C"}, Value::Int64(1), &constant));
+  catalog.AddOwnedConstant(std::move(constant));
+
+  int64_t version = catalog.version();
+  EXPECT_TRUE(catalog.RemoveTable("t"));
+  EXPECT_FALSE(catalog.RemoveTable("t"));
+  EXPECT_NE(version, catalog.version());
+  const Table* table;
+  EXPECT_FALSE(catalog.GetTable("T", &table).ok());
+
+  version = catalog.version();
+  EXPECT_TRUE(catalog.RemoveFunction("f_ALIAS"));
+  EXPECT_NE(version, catalog.version());
+  const Function* function;
+  EXPECT_FALSE(catalog.GetFunction("F", &function).ok());
+  EXPECT_FALSE(catalog.GetFunction("F_alias", &function).ok());
+  EXPECT_FALSE(catalog.RemoveFunction("F"));
+
+  EXPECT_TRUE(catalog.RemoveConstant("c"));
+  const Constant* found_constant;
+  EXPECT_FALSE(catalog.GetConstant("C", &found_constant).ok());
+
+  // Names can be reused after removal.
+  catalog.AddOwnedTable(
+      new SimpleTable("T", {{"b", catalog.type_factory()->get_string()}}));
+  ZETASQL_ASSERT_OK(catalog.GetTable("T", &table));
+  EXPECT_EQ("b", table->GetColumn(0)->Name());
+}
+
+TEST(SimpleCatalogTest, SerializeDelta) {
+  SimpleCatalog catalog("root");
+  TypeFactory* types = catalog.type_factory();
+  catalog.AddOwnedTable(new SimpleTable("T", {{"a", types->get_int64()}}));
+  catalog.AddOwnedTable(new SimpleTable("U", {{"a", types->get_int64()}}));
+  catalog.AddOwnedFunction(absl::make_unique<Function>(
+      "F", "test_group", Function::SCALAR, std::vector<FunctionSignature>(),
+      FunctionOptions().set_alias_name("F_alias")));
+  SimpleCatalog* nested = catalog.MakeOwnedSimpleCatalog("nested");
+  nested->AddOwnedTable(new SimpleTable("N", {{"a", types->get_int64()}}));
+
+  // A copy of the catalog made at <version>.
+  FileDescriptorSetMap file_descriptor_set_map;
+  SimpleCatalogProto proto;
+  ZETASQL_ASSERT_OK(catalog.Serialize(&file_descriptor_set_map, &proto));
+  std::unique_ptr<SimpleCatalog> copy;
+  ZETASQL_ASSERT_OK(SimpleCatalog::Deserialize(proto, {}, &copy));
+  int64_t version = catalog.version();
+
+  EXPECT_TRUE(catalog.RemoveTable("U"));
+  EXPECT_TRUE(catalog.RemoveTable("T"));
+  catalog.AddOwnedTable(new SimpleTable("T", {{"b", types->get_string()}}));
+  EXPECT_TRUE(catalog.RemoveFunction("F"));
+  std::unique_ptr<SimpleConstant> constant;
+  ZETASQL_ASSERT_OK(SimpleConstant::Create({"C"}, Value::Int64(1), &constant));
+  catalog.AddOwnedConstant(std::move(constant));
+  catalog.MakeOwnedSimpleCatalog("added")->AddOwnedTable(
+      new SimpleTable("A", {{"a", types->get_int64()}}));
+  nested->AddOwnedTable(new SimpleTable("M", {{"a", types->get_int64()}}));
+
+  SimpleCatalogDeltaProto delta;
+  ZETASQL_ASSERT_OK(catalog.SerializeDelta(version, &file_descriptor_set_map,
+                                   &delta));
+  EXPECT_THAT(delta.remove_table(), testing::ElementsAre("u"));
+  ASSERT_EQ(1, delta.add_table_size());
+  EXPECT_EQ("T", delta.add_table(0).name());
+  EXPECT_THAT(delta.remove_function(), testing::ElementsAre("f", "f_alias"));
+  EXPECT_EQ(0, delta.add_custom_function_size());
+  EXPECT_EQ(1, delta.add_constant_size());
+  ASSERT_EQ(1, delta.add_catalog_size());
+  EXPECT_EQ("added", delta.add_catalog(0).name());
+  ASSERT_EQ(1, delta.catalog_size());
+  EXPECT_EQ("nested", delta.catalog(0).name());
+  ASSERT_EQ(1, delta.catalog(0).add_table_size());
+  EXPECT_EQ("M", delta.catalog(0).add_table(0).name());
+
+  // The copy is brought up to date.
+  ZETASQL_ASSERT_OK(copy->ApplyDelta(delta, {}));
+  SimpleCatalogProto expected;
+  ZETASQL_ASSERT_OK(catalog.Serialize(&file_descriptor_set_map, &expected));
+  ZETASQL_ASSERT_OK(copy->Serialize(&file_descriptor_set_map, &proto));
+  EXPECT_EQ(expected.DebugString(), proto.DebugString());
+
+  // Nothing changed since.
+  version = catalog.version();
+  ZETASQL_ASSERT_OK(catalog.SerializeDelta(version, &file_descriptor_set_map,
+                                   &delta));
+  EXPECT_EQ("root", delta.name());
+  EXPECT_EQ(0, delta.add_table_size());
+  EXPECT_EQ(0, delta.catalog_size());
+
+  // A delta that does not apply leaves the copy unchanged.
+  version = copy->version();
+  delta.Clear();
+  delta.add_remove_table("t");
+  delta.add_catalog()->set_name("missing");
+  EXPECT_EQ(zetasql_base::StatusCode::kInvalidArgument,
+            copy->ApplyDelta(delta, {}).code());
+  EXPECT_EQ(version, copy->version());
+  const Table* table;
+  ZETASQL_EXPECT_OK(copy->GetTable("T", &table));
+}
+
+TEST(SimpleCatalogTest, SharedZetaSQLFunctions) {
+  const ZetaSQLBuiltinFunctionOptions options{LanguageOptions()};
+  SimpleCatalog catalog1("catalog1");
+  catalog1.AddSharedZetaSQLFunctions(options);
+  SimpleCatalog catalog2("catalog2");
+  catalog2.AddSharedZetaSQLFunctions(options);
+  SimpleCatalog owned_catalog("owned");
+  owned_catalog.AddZetaSQLFunctions(options);
+
+  // Both catalogs reference the same Function objects, which match those
+  // built by AddZetaSQLFunctions().
+  const Function* function1;
+  const Function* function2;
+  const Function* owned_function;
+  ZETASQL_ASSERT_OK(catalog1.GetFunction("concat", &function1));
+  ZETASQL_ASSERT_OK(catalog2.GetFunction("concat", &function2));
+  ZETASQL_ASSERT_OK(owned_catalog.GetFunction("concat", &owned_function));
+  ASSERT_NE(nullptr, function1);
+  EXPECT_EQ(function1, function2);
+  EXPECT_NE(function1, owned_function);
+  EXPECT_EQ(owned_function->DebugString(), function1->DebugString());
+  EXPECT_EQ(owned_catalog.function_names().size(),
+            catalog1.function_names().size());
+
+  // Different options get a different set of functions.
+  LanguageOptions external_options;
+  external_options.set_product_mode(PRODUCT_EXTERNAL);
+  SimpleCatalog external_catalog("external");
+  external_catalog.AddSharedZetaSQLFunctions(external_options);
+  const Function* external_function;
+  ZETASQL_ASSERT_OK(external_catalog.GetFunction("concat", &external_function));
+  EXPECT_NE(function1, external_function);
+
+  // Namespaced functions go in subcatalogs, as with AddZetaSQLFunctions().
+  SimpleCatalog full_catalog1("full1");
+  full_catalog1.AddSharedZetaSQLFunctions();
+  SimpleCatalog full_catalog2("full2");
+  full_catalog2.AddSharedZetaSQLFunctions();
+  ZETASQL_ASSERT_OK(
+      full_catalog1.FindFunction({"net", "format_ip"}, &function1));
+  ZETASQL_ASSERT_OK(
+      full_catalog2.FindFunction({"net", "format_ip"}, &function2));
+  ASSERT_NE(nullptr, function1);
+  EXPECT_EQ(function1, function2);
+}
+
+// An empty table that supports CreateEvaluatorTableIterator().
+class IterableTable : public SimpleTable {
+ public:
+  IterableTable() : SimpleTable("T", {{"a", types::Int64Type()}}) {}
+
+  zetasql_base::StatusOr<std::unique_ptr<EvaluatorTableIterator>>
+  CreateEvaluatorTableIterator(absl::Span<const int> column_idxs) const override {
+    return std::unique_ptr<EvaluatorTableIterator>(
+        absl::make_unique<EmptyIterator>());
+  }
+
+ private:
+  class EmptyIterator : public EvaluatorTableIterator {
+   public:
+    int NumColumns() const override { return 1; }
+    std::string GetColumnName(int i) const override { return "a"; }
+    const Type* GetColumnType(int i) const override {
+      return types::Int64Type();
+    }
+    bool NextRow() override { return false; }
+    const Value& GetValue(int i) const override { return value_; }
+    zetasql_base::Status Status() const override { return zetasql_base::OkStatus(); }
+    zetasql_base::Status Cancel() override { return zetasql_base::OkStatus(); }
+
+   private:
+    Value value_;
+  };
+};
+
+TEST(SimpleCatalogTest, CreatePartitionedIterators) {
+  // By default there is one partition, from CreateEvaluatorTableIterator().
+  IterableTable table;
+  auto iterators = table.CreatePartitionedIterators({0}, /*max_partitions=*/4);
+  ZETASQL_ASSERT_OK(iterators.status());
+  ASSERT_EQ(1, iterators.ValueOrDie().size());
+  EXPECT_FALSE(iterators.ValueOrDie()[0]->NextRow());
+
+  EXPECT_THAT(table.CreatePartitionedIterators({0}, /*max_partitions=*/0)
+                  .status(),
+              zetasql_base::testing::StatusIs(
+                  zetasql_base::StatusCode::kInvalidArgument));
+
+  SimpleTable simple_table("S", {{"a", types::Int64Type()}});
+  EXPECT_THAT(
+      simple_table.CreatePartitionedIterators({0}, /*max_partitions=*/1)
+          .status(),
+      zetasql_base::testing::StatusIs(zetasql_base::StatusCode::kUnimplemented));
+}
+
+TEST(SimpleCatalogTest, TableContents) {
+  SimpleTable table("T", {{"a", types::Int64Type()}, {"b", types::BoolType()}});
+  EXPECT_EQ(nullptr, table.contents());
+  EXPECT_EQ(zetasql_base::StatusCode::kInvalidArgument,
+            table.SetContents({{Value::Int64(1)}}).code());
+
+  std::vector<std::vector<Value>> rows;
+  for (int i = 0; i < 10; ++i) {
+    rows.push_back({Value::Int64(i), Value::Bool(i % 2 == 0)});
+  }
+  ColumnarTableOptions options;
+  options.chunk_rows = 3;
+  ZETASQL_ASSERT_OK(table.SetContents(rows, options));
+  ASSERT_NE(nullptr, table.contents());
+  EXPECT_EQ(4, table.contents()->num_chunks());
+
+  auto iterator = table.CreateEvaluatorTableIterator({1, 0});
+  ZETASQL_ASSERT_OK(iterator.status());
+  EXPECT_EQ("b", iterator.ValueOrDie()->GetColumnName(0));
+  int num_rows = 0;
+  while (iterator.ValueOrDie()->NextRow()) {
+    EXPECT_EQ(Value::Int64(num_rows), iterator.ValueOrDie()->GetValue(1));
+    ++num_rows;
+  }
+  EXPECT_EQ(10, num_rows);
+  EXPECT_THAT(table.CreateEvaluatorTableIterator({2}).status(),
+              zetasql_base::testing::StatusIs(
+                  zetasql_base::StatusCode::kInvalidArgument));
+
+  // Each partition reads whole chunks, and together they read all rows in
+  // order.
+  auto iterators = table.CreatePartitionedIterators({0}, /*max_partitions=*/3);
+  ZETASQL_ASSERT_OK(iterators.status());
+  ASSERT_EQ(3, iterators.ValueOrDie().size());
+  std::vector<int64_t> keys;
+  for (const auto& partition : iterators.ValueOrDie()) {
+    while (partition->NextRow()) {
+      keys.push_back(partition->GetValue(0).int64_value());
+    }
+  }
+  EXPECT_THAT(keys, ::testing::ElementsAre(0, 1, 2, 3, 4, 5, 6, 7, 8, 9));
+  iterators = table.CreatePartitionedIterators({0}, /*max_partitions=*/10);
+  ZETASQL_ASSERT_OK(iterators.status());
+  EXPECT_EQ(4, iterators.ValueOrDie().size());
+}
+
+TEST(SimpleCatalogTest, IndexLookup) {
+  SimpleTable table("T",
+                    {{"a", types::Int64Type()}, {"b", types::StringType()}});
+  EXPECT_FALSE(table.SupportsIndexLookup({0}));
+  EXPECT_THAT(table.CreateIndexLookupIterator({1}, {0}, {{Value::Int64(1)}})
+                  .status(),
+              zetasql_base::testing::StatusIs(
+                  zetasql_base::StatusCode::kUnimplemented));
+  EXPECT_THAT(table.AddIndex({0}),
+              zetasql_base::testing::StatusIs(
+                  zetasql_base::StatusCode::kInvalidArgument));
+
+  std::vector<std::vector<Value>> rows;
+  for (int i = 0; i < 10; ++i) {
+    rows.push_back({Value::Int64(i % 4), Value::String(absl::StrCat("b", i))});
+  }
+  rows.push_back({Value::NullInt64(), Value::String("null")});
+  ColumnarTableOptions options;
+  options.chunk_rows = 3;
+  ZETASQL_ASSERT_OK(table.SetContents(rows, options));
+  ZETASQL_ASSERT_OK(table.AddIndex({0}));
+  EXPECT_TRUE(table.SupportsIndexLookup({0}));
+  EXPECT_FALSE(table.SupportsIndexLookup({1}));
+  EXPECT_THAT(table.AddIndex({2}),
+              zetasql_base::testing::StatusIs(
+                  zetasql_base::StatusCode::kInvalidArgument));
+
+  // The rows of each key are grouped, in the order of the keys.
+  auto iterator = table.CreateIndexLookupIterator(
+      {1}, {0},
+      {{Value::Int64(3)}, {Value::NullInt64()}, {Value::Int64(7)},
+       {Value::Int64(1)}});
+  ZETASQL_ASSERT_OK(iterator.status());
+  ASSERT_EQ(2, iterator.ValueOrDie()->NumColumns());
+  EXPECT_EQ("b", iterator.ValueOrDie()->GetColumnName(0));
+  EXPECT_TRUE(iterator.ValueOrDie()->GetColumnType(1)->IsInt64());
+  std::vector<std::string> matches;
+  while (iterator.ValueOrDie()->NextRow()) {
+    matches.push_back(
+        absl::StrCat(iterator.ValueOrDie()->GetValue(1).int64_value(), ":",
+                     iterator.ValueOrDie()->GetValue(0).string_value()));
+  }
+  ZETASQL_EXPECT_OK(iterator.ValueOrDie()->Status());
+  EXPECT_THAT(matches,
+              ::testing::ElementsAre("0:b3", "0:b7", "3:b1", "3:b5", "3:b9"));
+
+  EXPECT_THAT(table.CreateIndexLookupIterator({1}, {0}, {{Value::Bool(true)}})
+                  .status(),
+              zetasql_base::testing::StatusIs(
+                  zetasql_base::StatusCode::kInvalidArgument));
+
+  // New contents rebuild the index.
+  ZETASQL_ASSERT_OK(table.SetContents({{Value::Int64(7), Value::String("x")}}));
+  iterator = table.CreateIndexLookupIterator({1}, {0}, {{Value::Int64(7)}});
+  ZETASQL_ASSERT_OK(iterator.status());
+  ASSERT_TRUE(iterator.ValueOrDie()->NextRow());
+  EXPECT_EQ("x", iterator.ValueOrDie()->GetValue(0).string_value());
+  EXPECT_FALSE(iterator.ValueOrDie()->NextRow());
+}
+
+TEST(SimpleCatalogTest, TableStatistics) {
+  SimpleTable table("T", {{"a", types::Int64Type()}, {"b", types::BoolType()}});
+  EXPECT_EQ(nullptr, table.GetStatistics());
+
+  TableStatistics statistics;
+  statistics.row_count = 1000;
+  statistics.total_bytes = 9000;
+  statistics.columns.resize(2);
+  statistics.columns[0].distinct_count = 900;
+  statistics.columns[0].null_fraction = 0.1;
+  statistics.columns[0].min = Value::Int64(-5);
+  statistics.columns[0].max = Value::Int64(70);
+  statistics.columns[1].histogram_id = "hist_b";
+  ZETASQL_ASSERT_OK(table.SetStatistics(statistics));
+
+  // Statistics survive serialization.
+  FileDescriptorSetMap file_descriptor_set_map;
+  SimpleTableProto proto;
+  ZETASQL_ASSERT_OK(table.Serialize(&file_descriptor_set_map, &proto));
+  TypeFactory type_factory;
+  std::unique_ptr<SimpleTable> deserialized;
+  ZETASQL_ASSERT_OK(
+      SimpleTable::Deserialize(proto, {}, &type_factory, &deserialized));
+  const TableStatistics* result = deserialized->GetStatistics();
+  ASSERT_NE(nullptr, result);
+  EXPECT_EQ(1000, result->row_count.value());
+  EXPECT_EQ(9000, result->total_bytes.value());
+  ASSERT_EQ(2, result->columns.size());
+  EXPECT_EQ(900, result->columns[0].distinct_count.value());
+  EXPECT_EQ(0.1, result->columns[0].null_fraction.value());
+  EXPECT_EQ(Value::Int64(-5), result->columns[0].min);
+  EXPECT_EQ(Value::Int64(70), result->columns[0].max);
+  EXPECT_FALSE(result->columns[1].distinct_count.has_value());
+  EXPECT_FALSE(result->columns[1].min.is_valid());
+  EXPECT_EQ("hist_b", result->columns[1].histogram_id);
+
+  // Column statistics must match the columns.
+  statistics.columns.resize(1);
+  EXPECT_EQ(zetasql_base::StatusCode::kInvalidArgument,
+            table.SetStatistics(statistics).code());
+  statistics.columns.resize(2);
+  statistics.columns[1].min = Value::Int64(1);
+  EXPECT_EQ(zetasql_base::StatusCode::kInvalidArgument,
+            table.SetStatistics(statistics).code());
+  statistics.columns[1].min = Value();
+  statistics.columns[1].null_fraction = 2;
+  EXPECT_EQ(zetasql_base::StatusCode::kInvalidArgument,
+            table.SetStatistics(statistics).code());
+  // The last valid statistics are kept.
+  EXPECT_EQ(900, table.GetStatistics()->columns[0].distinct_count.value());
+}
+
+TEST(SimpleCatalogDeathTest, FrozenCatalogRejectsMutations) {
+  SimpleCatalog catalog("root");
+  catalog.Freeze();
+  EXPECT_DEATH(catalog.AddOwnedTable(new SimpleTable(
+                   "T", std::vector<SimpleTable::NameAndType>{})),
+               "Cannot modify frozen SimpleCatalog root");
+}
+
+}  // namespace zetasql
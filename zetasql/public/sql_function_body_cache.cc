@@ -0,0 +1,299 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/sql_function_body_cache.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/proto/options.pb.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "zetasql/resolved_ast/resolved_node_kind.pb.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "zetasql/base/canonical_errors.h"
+#include "zetasql/base/source_location.h"
+#include "zetasql/base/status.h"
+#include "zetasql/base/status_builder.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+// A Catalog that forwards every lookup to another Catalog and records the
+// lookups that returned OK or NOT_FOUND, with their results.
+class SQLFunctionBodyCache::RecordingCatalog : public Catalog {
+ public:
+  explicit RecordingCatalog(Catalog* catalog) : catalog_(catalog) {}
+  RecordingCatalog(const RecordingCatalog&) = delete;
+  RecordingCatalog& operator=(const RecordingCatalog&) = delete;
+
+  std::string FullName() const override { return catalog_->FullName(); }
+
+  // The IdString variant of FindTable() forwards to the std::string variant.
+  using Catalog::FindTable;
+
+  zetasql_base::Status FindTable(const absl::Span<const std::string>& path,
+                         const Table** table,
+                         const FindOptions& options) override {
+    const zetasql_base::Status status =
+        catalog_->FindTable(path, table, options);
+    return Record(CatalogLookup::kTable, path, status, table);
+  }
+
+  zetasql_base::Status FindModel(const absl::Span<const std::string>& path,
+                         const Model** model,
+                         const FindOptions& options) override {
+    const zetasql_base::Status status =
+        catalog_->FindModel(path, model, options);
+    return Record(CatalogLookup::kModel, path, status, model);
+  }
+
+  zetasql_base::Status FindFunction(const absl::Span<const std::string>& path,
+                            const Function** function,
+                            const FindOptions& options) override {
+    const zetasql_base::Status status =
+        catalog_->FindFunction(path, function, options);
+    return Record(CatalogLookup::kFunction, path, status, function);
+  }
+
+  zetasql_base::Status FindTableValuedFunction(
+      const absl::Span<const std::string>& path,
+      const TableValuedFunction** function,
+      const FindOptions& options) override {
+    const zetasql_base::Status status =
+        catalog_->FindTableValuedFunction(path, function, options);
+    return Record(CatalogLookup::kTableValuedFunction, path, status, function);
+  }
+
+  zetasql_base::Status FindProcedure(const absl::Span<const std::string>& path,
+                             const Procedure** procedure,
+                             const FindOptions& options) override {
+    const zetasql_base::Status status =
+        catalog_->FindProcedure(path, procedure, options);
+    return Record(CatalogLookup::kProcedure, path, status, procedure);
+  }
+
+  zetasql_base::Status FindType(const absl::Span<const std::string>& path,
+                        const Type** type,
+                        const FindOptions& options) override {
+    const zetasql_base::Status status = catalog_->FindType(path, type, options);
+    return Record(CatalogLookup::kType, path, status, type);
+  }
+
+  zetasql_base::Status FindConstantWithPathPrefix(
+      const absl::Span<const std::string> path, int* num_names_consumed,
+      const Constant** constant, const FindOptions& options) override {
+    const zetasql_base::Status status = catalog_->FindConstantWithPathPrefix(
+        path, num_names_consumed, constant, options);
+    ZETASQL_RETURN_IF_ERROR(
+        Record(CatalogLookup::kConstant, path, status, constant));
+    if (status.ok()) {
+      lookups_->back().num_names_consumed = *num_names_consumed;
+    }
+    return status;
+  }
+
+  zetasql_base::Status PrefetchTables(
+      absl::Span<const std::vector<std::string>> paths,
+      const FindOptions& options) override {
+    return catalog_->PrefetchTables(paths, options);
+  }
+
+  std::string SuggestTable(
+      const absl::Span<const std::string>& mistyped_path) override {
+    return catalog_->SuggestTable(mistyped_path);
+  }
+  std::string SuggestModel(
+      const absl::Span<const std::string>& mistyped_path) override {
+    return catalog_->SuggestModel(mistyped_path);
+  }
+  std::string SuggestFunction(
+      const absl::Span<const std::string>& mistyped_path) override {
+    return catalog_->SuggestFunction(mistyped_path);
+  }
+  std::string SuggestTableValuedFunction(
+      const absl::Span<const std::string>& mistyped_path) override {
+    return catalog_->SuggestTableValuedFunction(mistyped_path);
+  }
+  std::string SuggestConstant(
+      const absl::Span<const std::string>& mistyped_path) override {
+    return catalog_->SuggestConstant(mistyped_path);
+  }
+
+  // Returns false if a lookup failed with an error other than NOT_FOUND, in
+  // which case the lookups were not all recorded.
+  bool all_lookups_recorded() const { return all_lookups_recorded_; }
+
+  std::shared_ptr<const std::vector<CatalogLookup>> release_lookups() {
+    return std::move(lookups_);
+  }
+
+ private:
+  // Records the lookup of <path> that returned <status>, and <*object> if
+  // <status> is OK.
+  template <class T>
+  zetasql_base::Status Record(CatalogLookup::Kind kind,
+                      absl::Span<const std::string> path,
+                      const zetasql_base::Status& status,
+                      const T* const* object) {
+    if (status.ok() || zetasql_base::IsNotFound(status)) {
+      lookups_->push_back(CatalogLookup{
+          kind, std::vector<std::string>(path.begin(), path.end()),
+          status.ok() ? *object : nullptr, /*num_names_consumed=*/0});
+    } else {
+      all_lookups_recorded_ = false;
+    }
+    return status;
+  }
+
+  Catalog* const catalog_;
+  std::shared_ptr<std::vector<CatalogLookup>> lookups_ =
+      std::make_shared<std::vector<CatalogLookup>>();
+  bool all_lookups_recorded_ = true;
+};
+
+SQLFunctionBodyCache::SQLFunctionBodyCache(int max_entries)
+    : cache_(max_entries) {}
+
+SQLFunctionBodyCache::~SQLFunctionBodyCache() {}
+
+bool SQLFunctionBodyCache::MakeKey(absl::string_view sql,
+                                   const AnalyzerOptions& options,
+                                   const TypeFactory* type_factory,
+                                   std::string* key) {
+  if (options.lookup_expression_column_callback() != nullptr ||
+      options.ddl_pseudo_columns_callback() != nullptr ||
+      options.column_id_sequence_number() != nullptr) {
+    return false;
+  }
+  FileDescriptorSetMap file_descriptor_set_map;
+  AnalyzerOptionsProto options_proto;
+  if (!options.Serialize(&file_descriptor_set_map, &options_proto).ok()) {
+    return false;
+  }
+  std::string serialized_options;
+  if (!options_proto.SerializeToString(&serialized_options)) {
+    return false;
+  }
+  *key = absl::StrCat(absl::Hex(type_factory));
+  for (const auto& entry : file_descriptor_set_map) {
+    absl::StrAppend(key, ",", absl::Hex(entry.first));
+  }
+  absl::StrAppend(key, ";", sql.size(), ":", sql, serialized_options);
+  return true;
+}
+
+bool SQLFunctionBodyCache::LookupsMatch(
+    const std::vector<CatalogLookup>& lookups, Catalog* catalog) {
+  for (const CatalogLookup& lookup : lookups) {
+    const void* object = nullptr;
+    int num_names_consumed = 0;
+    zetasql_base::Status status;
+    switch (lookup.kind) {
+      case CatalogLookup::kTable: {
+        const Table* table = nullptr;
+        status = catalog->FindTable(lookup.path, &table);
+        object = table;
+        break;
+      }
+      case CatalogLookup::kModel: {
+        const Model* model = nullptr;
+        status = catalog->FindModel(lookup.path, &model);
+        object = model;
+        break;
+      }
+      case CatalogLookup::kFunction: {
+        const Function* function = nullptr;
+        status = catalog->FindFunction(lookup.path, &function);
+        object = function;
+        break;
+      }
+      case CatalogLookup::kTableValuedFunction: {
+        const TableValuedFunction* function = nullptr;
+        status = catalog->FindTableValuedFunction(lookup.path, &function);
+        object = function;
+        break;
+      }
+      case CatalogLookup::kProcedure: {
+        const Procedure* procedure = nullptr;
+        status = catalog->FindProcedure(lookup.path, &procedure);
+        object = procedure;
+        break;
+      }
+      case CatalogLookup::kType: {
+        const Type* type = nullptr;
+        status = catalog->FindType(lookup.path, &type);
+        object = type;
+        break;
+      }
+      case CatalogLookup::kConstant: {
+        const Constant* constant = nullptr;
+        status = catalog->FindConstantWithPathPrefix(
+            lookup.path, &num_names_consumed, &constant);
+        object = constant;
+        break;
+      }
+    }
+    if (status.ok()) {
+      if (object != lookup.object ||
+          num_names_consumed != lookup.num_names_consumed) {
+        return false;
+      }
+    } else if (!zetasql_base::IsNotFound(status) || lookup.object != nullptr) {
+      return false;
+    }
+  }
+  return true;
+}
+
+zetasql_base::Status SQLFunctionBodyCache::AnalyzeCreateFunction(
+    absl::string_view sql, const AnalyzerOptions& options, Catalog* catalog,
+    TypeFactory* type_factory, std::shared_ptr<const AnalyzerOutput>* output) {
+  std::string key;
+  const bool cacheable = MakeKey(sql, options, type_factory, &key);
+  Entry entry;
+  if (cacheable && cache_.Lookup(key, &entry) &&
+      LookupsMatch(*entry.lookups, catalog)) {
+    *output = std::move(entry.output);
+    return ::zetasql_base::OkStatus();
+  }
+  // Analyze outside of the cache lock.  A miss, including one where the
+  // cached entry was analyzed against different catalog objects, replaces
+  // the entry.
+  RecordingCatalog recording_catalog(catalog);
+  std::unique_ptr<const AnalyzerOutput> analyzer_output;
+  ZETASQL_RETURN_IF_ERROR(zetasql::AnalyzeStatement(
+      sql, options, &recording_catalog, type_factory, &analyzer_output));
+  const ResolvedNodeKind kind =
+      analyzer_output->resolved_statement()->node_kind();
+  if (kind != RESOLVED_CREATE_FUNCTION_STMT &&
+      kind != RESOLVED_CREATE_TABLE_FUNCTION_STMT) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "Expected a CREATE FUNCTION or CREATE TABLE FUNCTION statement, "
+              "but got "
+           << analyzer_output->resolved_statement()->node_kind_string();
+  }
+  *output = std::move(analyzer_output);
+  if (cacheable && recording_catalog.all_lookups_recorded()) {
+    cache_.Insert(key, Entry{recording_catalog.release_lookups(), *output});
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+}  // namespace zetasql
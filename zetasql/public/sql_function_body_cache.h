@@ -0,0 +1,120 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PUBLIC_SQL_FUNCTION_BODY_CACHE_H_
+#define ZETASQL_PUBLIC_SQL_FUNCTION_BODY_CACHE_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/common/lru_cache.h"
+#include "zetasql/public/analyzer.h"
+#include "zetasql/public/catalog.h"
+#include "zetasql/public/type.h"
+#include "absl/strings/string_view.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+
+// A thread-safe, size-bounded LRU cache of analyzed CREATE FUNCTION and
+// CREATE TABLE FUNCTION statements that can be shared between catalog
+// instances.
+//
+// Catalogs rebuilt from DDL, e.g. one per tenant, analyze the same function
+// definitions again and again.  Unlike AnalyzerOutputCache, entries here
+// are keyed by content only: the SQL text of the statement (which includes
+// the body and the argument types), the serialized AnalyzerOptions and the
+// TypeFactory.  The catalog is not part of the key.  Instead, every catalog
+// lookup made while analyzing the statement is recorded with its result,
+// and an entry is only reused if the catalog passed to
+// AnalyzeCreateFunction() returns the same objects for the same names.
+// Bodies that only call functions shared between catalogs, e.g. through
+// SimpleCatalog::AddSharedZetaSQLFunctions(), are therefore analyzed once.
+//
+// SQLFunction and SQLTableValuedFunction do not own the resolved statement
+// that they are created from, so callers must keep the returned output
+// alive as long as such functions refer to it.
+//
+// Options that cannot be captured in the key bypass the cache, as for
+// AnalyzerOutputCache.  Objects found through the catalog and the
+// TypeFactory must outlive every output returned from the cache.
+// Analysis errors are not cached.
+class SQLFunctionBodyCache {
+ public:
+  // <max_entries> must be positive.
+  explicit SQLFunctionBodyCache(int max_entries);
+  SQLFunctionBodyCache(const SQLFunctionBodyCache&) = delete;
+  SQLFunctionBodyCache& operator=(const SQLFunctionBodyCache&) = delete;
+  ~SQLFunctionBodyCache();
+
+  // Analyzes <sql>, which must be a CREATE FUNCTION or CREATE TABLE FUNCTION
+  // statement, like zetasql::AnalyzeStatement().  Returns a shared
+  // AnalyzerOutput that may have been analyzed against another catalog.
+  zetasql_base::Status AnalyzeCreateFunction(
+      absl::string_view sql, const AnalyzerOptions& options, Catalog* catalog,
+      TypeFactory* type_factory, std::shared_ptr<const AnalyzerOutput>* output);
+
+  // Removes all entries.  Outputs already handed out remain valid.
+  void Clear() { cache_.Clear(); }
+
+  int max_entries() const { return cache_.max_entries(); }
+  int size() const { return cache_.size(); }
+  LruCacheStats stats() const { return cache_.stats(); }
+
+ private:
+  // A catalog lookup made while analyzing a statement.  <object> is the
+  // object found, or NULL if the lookup returned NOT_FOUND.
+  struct CatalogLookup {
+    enum Kind {
+      kTable,
+      kModel,
+      kFunction,
+      kTableValuedFunction,
+      kProcedure,
+      kType,
+      kConstant,
+    };
+    Kind kind;
+    std::vector<std::string> path;
+    const void* object;
+    // For kConstant only.
+    int num_names_consumed;
+  };
+
+  struct Entry {
+    std::shared_ptr<const std::vector<CatalogLookup>> lookups;
+    std::shared_ptr<const AnalyzerOutput> output;
+  };
+
+  class RecordingCatalog;
+
+  // Computes the cache key for the given inputs into <*key>.  Returns false
+  // if the inputs cannot be cached.
+  static bool MakeKey(absl::string_view sql, const AnalyzerOptions& options,
+                      const TypeFactory* type_factory, std::string* key);
+
+  // Returns true if repeating <lookups> against <catalog> finds the same
+  // objects.
+  static bool LookupsMatch(const std::vector<CatalogLookup>& lookups,
+                           Catalog* catalog);
+
+  LruCache<std::string, Entry> cache_;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_SQL_FUNCTION_BODY_CACHE_H_
@@ -0,0 +1,111 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/sql_function_body_cache.h"
+
+#include <memory>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/analyzer.h"
+#include "zetasql/public/builtin_function.h"
+#include "zetasql/public/language_options.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "absl/memory/memory.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace zetasql {
+
+using testing::HasSubstr;
+using zetasql_base::testing::StatusIs;
+
+class SQLFunctionBodyCacheTest : public ::testing::Test {
+ protected:
+  // Returns a new catalog with the process-wide builtin functions, so that
+  // catalogs created by separate calls share Function objects.
+  std::unique_ptr<SimpleCatalog> MakeTenantCatalog() {
+    auto catalog = absl::make_unique<SimpleCatalog>("tenant", &type_factory_);
+    catalog->AddSharedZetaSQLFunctions(
+        ZetaSQLBuiltinFunctionOptions(options_.language()));
+    return catalog;
+  }
+
+  zetasql_base::Status Analyze(absl::string_view sql, Catalog* catalog,
+                       std::shared_ptr<const AnalyzerOutput>* output) {
+    return cache_.AnalyzeCreateFunction(sql, options_, catalog, &type_factory_,
+                                        output);
+  }
+
+  TypeFactory type_factory_;
+  AnalyzerOptions options_;
+  SQLFunctionBodyCache cache_{/*max_entries=*/10};
+};
+
+TEST_F(SQLFunctionBodyCacheTest, SharedBetweenCatalogs) {
+  const std::string sql = "CREATE FUNCTION AddOne(x INT64) AS (x + 1)";
+  std::unique_ptr<SimpleCatalog> catalog1 = MakeTenantCatalog();
+  std::unique_ptr<SimpleCatalog> catalog2 = MakeTenantCatalog();
+  std::shared_ptr<const AnalyzerOutput> output1;
+  std::shared_ptr<const AnalyzerOutput> output2;
+  ZETASQL_ASSERT_OK(Analyze(sql, catalog1.get(), &output1));
+  ZETASQL_ASSERT_OK(Analyze(sql, catalog2.get(), &output2));
+  EXPECT_EQ(output1.get(), output2.get());
+  EXPECT_EQ(1, cache_.stats().hits);
+}
+
+TEST_F(SQLFunctionBodyCacheTest, DifferentCatalogObjectsMiss) {
+  const std::string sql =
+      "CREATE FUNCTION CountT() AS ((SELECT COUNT(*) FROM T))";
+  std::unique_ptr<SimpleCatalog> catalog1 = MakeTenantCatalog();
+  catalog1->AddOwnedTable(
+      new SimpleTable("T", {{"key", type_factory_.get_int64()}}));
+  std::unique_ptr<SimpleCatalog> catalog2 = MakeTenantCatalog();
+  catalog2->AddOwnedTable(
+      new SimpleTable("T", {{"key", type_factory_.get_int64()}}));
+
+  std::shared_ptr<const AnalyzerOutput> output1;
+  std::shared_ptr<const AnalyzerOutput> output2;
+  ZETASQL_ASSERT_OK(Analyze(sql, catalog1.get(), &output1));
+  ZETASQL_ASSERT_OK(Analyze(sql, catalog2.get(), &output2));
+  // The tables are different objects, so the body is analyzed again.
+  EXPECT_NE(output1.get(), output2.get());
+
+  // The entry now matches <catalog2>.
+  std::shared_ptr<const AnalyzerOutput> output3;
+  ZETASQL_ASSERT_OK(Analyze(sql, catalog2.get(), &output3));
+  EXPECT_EQ(output2.get(), output3.get());
+}
+
+TEST_F(SQLFunctionBodyCacheTest, ErrorsAreNotCached) {
+  const std::string sql = "CREATE FUNCTION F(x INT64) AS (Helper(x))";
+  std::unique_ptr<SimpleCatalog> catalog = MakeTenantCatalog();
+  std::shared_ptr<const AnalyzerOutput> output;
+  EXPECT_FALSE(Analyze(sql, catalog.get(), &output).ok());
+  EXPECT_EQ(0, cache_.size());
+}
+
+TEST_F(SQLFunctionBodyCacheTest, RejectsOtherStatements) {
+  std::unique_ptr<SimpleCatalog> catalog = MakeTenantCatalog();
+  std::shared_ptr<const AnalyzerOutput> output;
+  EXPECT_THAT(Analyze("SELECT 1", catalog.get(), &output),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument,
+                       HasSubstr("Expected a CREATE FUNCTION")));
+  EXPECT_EQ(0, cache_.size());
+}
+
+}  // namespace zetasql
@@ -0,0 +1,136 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/statement_fingerprint.h"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "zetasql/public/parse_resume_location.h"
+#include "zetasql/public/parse_tokens.h"
+#include "zetasql/public/strings.h"
+#include "zetasql/public/type.pb.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+namespace {
+
+// 128-bit FNV-1a.  Chosen because it is simple, has no dependencies and
+// gives the same result on every platform.
+absl::uint128 Fnv1a128(absl::string_view data) {
+  const absl::uint128 kPrime =
+      absl::MakeUint128(0x0000000001000000ULL, 0x000000000000013BULL);
+  absl::uint128 hash =
+      absl::MakeUint128(0x6c62272e07bb0142ULL, 0x62b821756295c58dULL);
+  for (const char c : data) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= kPrime;
+  }
+  return hash;
+}
+
+// Returns true if a "-" following <token> must be a binary minus, i.e.
+// <token> ends an operand.
+bool EndsOperand(const ParseToken& token) {
+  if (token.IsValue() || token.IsIdentifier()) return true;
+  const std::string keyword = token.GetKeyword();
+  return keyword == ")" || keyword == "]" || keyword == "NULL" ||
+         keyword == "TRUE" || keyword == "FALSE";
+}
+
+// Sets <*negated> to the negation of the numeric literal <value> and returns
+// true, or returns false if <value> cannot be negated.
+bool NegateLiteral(const Value& value, Value* negated) {
+  switch (value.type_kind()) {
+    case TYPE_INT64:
+      *negated = Value::Int64(-value.int64_value());
+      return true;
+    case TYPE_UINT64:
+      // Only -9223372036854775808 is tokenized as a negated UINT64.
+      if (value.uint64_value() ==
+          static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + 1) {
+        *negated = Value::Int64(std::numeric_limits<int64_t>::min());
+        return true;
+      }
+      return false;
+    case TYPE_DOUBLE:
+      *negated = Value::Double(-value.double_value());
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns the normalized form of a non-literal token.
+std::string NormalizeToken(const ParseToken& token) {
+  if (token.IsKeyword()) {
+    // Also covers unquoted identifiers, which are returned in upper case.
+    return token.GetKeyword();
+  }
+  // Identifiers are case insensitive.  A quoted identifier that does not
+  // need quoting normalizes to the same string as the unquoted form.
+  return absl::AsciiStrToUpper(ToIdentifierLiteral(token.GetIdentifier()));
+}
+
+}  // namespace
+
+zetasql_base::Status GetStatementFingerprint(absl::string_view sql,
+                                     StatementFingerprint* fingerprint) {
+  ParseResumeLocation resume_location = ParseResumeLocation::FromStringView(sql);
+  std::vector<ParseToken> tokens;
+  ZETASQL_RETURN_IF_ERROR(
+      GetParseTokens(ParseTokenOptions(), &resume_location, &tokens));
+
+  // Drop the end-of-input token and a trailing ";".
+  int num_tokens = static_cast<int>(tokens.size());
+  if (num_tokens > 0 && tokens[num_tokens - 1].IsEndOfInput()) --num_tokens;
+  if (num_tokens > 0 && tokens[num_tokens - 1].GetKeyword() == ";") {
+    --num_tokens;
+  }
+
+  *fingerprint = StatementFingerprint();
+  std::string& normalized_sql = fingerprint->normalized_sql;
+  for (int i = 0; i < num_tokens; ++i) {
+    const ParseToken& token = tokens[i];
+    if (!normalized_sql.empty()) normalized_sql.push_back(' ');
+    if (token.IsValue()) {
+      normalized_sql.push_back('?');
+      fingerprint->literals.push_back(token.GetValue());
+      continue;
+    }
+    // Fold a unary minus into the numeric literal that follows it, so that
+    // negative and positive literals normalize the same way.
+    Value negated;
+    if (token.GetKeyword() == "-" && i + 1 < num_tokens &&
+        tokens[i + 1].IsValue() && (i == 0 || !EndsOperand(tokens[i - 1])) &&
+        NegateLiteral(tokens[i + 1].GetValue(), &negated)) {
+      normalized_sql.push_back('?');
+      fingerprint->literals.push_back(negated);
+      ++i;
+      continue;
+    }
+    absl::StrAppend(&normalized_sql, NormalizeToken(token));
+  }
+  fingerprint->fingerprint = Fnv1a128(normalized_sql);
+  return ::zetasql_base::OkStatus();
+}
+
+}  // namespace zetasql
@@ -0,0 +1,64 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PUBLIC_STATEMENT_FINGERPRINT_H_
+#define ZETASQL_PUBLIC_STATEMENT_FINGERPRINT_H_
+
+#include <string>
+#include <vector>
+
+#include "zetasql/public/value.h"
+#include "absl/numeric/int128.h"
+#include "absl/strings/string_view.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+
+// The fingerprint of a statement with its literals removed.  Two statements
+// that differ only in whitespace, comments, the case of keywords and
+// identifiers, or the values of their literals have the same fingerprint.
+// For example, these have the same fingerprint:
+//   SELECT * FROM T WHERE id = 1
+//   select *   from t /* comment */ where ID=-25;
+//
+// The fingerprint is computed from the token stream produced by
+// GetParseTokens(), without parsing or resolving the statement, so it is
+// cheap to compute and is stable across processes and releases as long as
+// the tokenizer does not change.  It is not a cryptographic hash.
+struct StatementFingerprint {
+  // 128-bit hash of <normalized_sql>.
+  absl::uint128 fingerprint = 0;
+
+  // The statement with each literal replaced by "?" and tokens separated
+  // by single spaces, e.g. "SELECT * FROM T WHERE ID = ?".  Keywords and
+  // unquoted identifiers are upper case.  This is meant for display and
+  // debugging; it is not always valid SQL.
+  std::string normalized_sql;
+
+  // The removed literals, in the order they appear in the statement.
+  // A negated numeric literal such as "-25" is returned as a single
+  // negative value.
+  std::vector<Value> literals;
+};
+
+// Computes the StatementFingerprint of the single statement in <sql>.
+// A trailing ";" is ignored.  Returns an error if <sql> cannot be tokenized.
+zetasql_base::Status GetStatementFingerprint(absl::string_view sql,
+                                     StatementFingerprint* fingerprint);
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_STATEMENT_FINGERPRINT_H_
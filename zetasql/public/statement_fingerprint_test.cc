@@ -0,0 +1,80 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/statement_fingerprint.h"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/value.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace zetasql {
+
+using ::testing::ElementsAre;
+
+static StatementFingerprint Fingerprint(const std::string& sql) {
+  StatementFingerprint fingerprint;
+  ZETASQL_EXPECT_OK(GetStatementFingerprint(sql, &fingerprint));
+  return fingerprint;
+}
+
+TEST(StatementFingerprintTest, LiteralsAreRemoved) {
+  const StatementFingerprint fingerprint =
+      Fingerprint("SELECT * FROM T WHERE id = 1 AND name = 'abc'");
+  EXPECT_EQ("SELECT * FROM T WHERE ID = ? AND NAME = ?",
+            fingerprint.normalized_sql);
+  EXPECT_THAT(fingerprint.literals,
+              ElementsAre(Value::Int64(1), Value::String("abc")));
+  EXPECT_EQ(fingerprint.fingerprint,
+            Fingerprint("SELECT * FROM T WHERE id = 2 AND name = 'x'")
+                .fingerprint);
+}
+
+TEST(StatementFingerprintTest, WhitespaceCommentsAndCaseAreIgnored) {
+  EXPECT_EQ(Fingerprint("SELECT a FROM T WHERE id = 1").fingerprint,
+            Fingerprint("select  A\n from `t` /* comment */ where ID=5;")
+                .fingerprint);
+}
+
+TEST(StatementFingerprintTest, NegativeLiterals) {
+  const StatementFingerprint fingerprint =
+      Fingerprint("SELECT x - 1, -2, -9223372036854775808 FROM T");
+  EXPECT_EQ("SELECT X - ? , ? , ? FROM T", fingerprint.normalized_sql);
+  EXPECT_THAT(fingerprint.literals,
+              ElementsAre(Value::Int64(1), Value::Int64(-2),
+                          Value::Int64(std::numeric_limits<int64_t>::min())));
+  EXPECT_EQ(fingerprint.fingerprint,
+            Fingerprint("SELECT x - 5, 3, 4 FROM T").fingerprint);
+}
+
+TEST(StatementFingerprintTest, DifferentStatementsDiffer) {
+  EXPECT_NE(Fingerprint("SELECT a FROM T").fingerprint,
+            Fingerprint("SELECT b FROM T").fingerprint);
+  // A quoted reserved keyword is an identifier, not the keyword.
+  EXPECT_NE(Fingerprint("SELECT `select` FROM T").fingerprint,
+            Fingerprint("SELECT select FROM T").fingerprint);
+}
+
+TEST(StatementFingerprintTest, TokenizerErrors) {
+  StatementFingerprint fingerprint;
+  EXPECT_FALSE(GetStatementFingerprint("SELECT 'abc", &fingerprint).ok());
+}
+
+}  // namespace zetasql
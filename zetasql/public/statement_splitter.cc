@@ -0,0 +1,305 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/statement_splitter.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/common/errors.h"
+#include "zetasql/parser/bison_parser.bison.h"
+#include "zetasql/parser/bison_parser_mode.h"
+#include "zetasql/parser/flex_tokenizer.h"
+#include "zetasql/parser/keywords.h"
+#include "absl/memory/memory.h"
+#include "zetasql/base/status.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+namespace {
+
+using zetasql_bison_parser::BisonParserImpl;
+
+// The number of leading words, after any hint, that GuessStatementKind()
+// looks at.  "CREATE OR REPLACE TEMP AGGREGATE FUNCTION" is the longest
+// prefix that matters.
+constexpr int kMaxStatementKindWords = 6;
+
+// Returns the word that GuessStatementKind() sees for <bison_token>: the
+// upper case keyword for keywords, "(" for "(", and "" for everything else.
+std::string GetStatementKindWord(int bison_token) {
+  if (bison_token == '(') return "(";
+  const parser::KeywordInfo* keyword_info =
+      parser::GetKeywordInfoForBisonToken(bison_token);
+  return keyword_info == nullptr ? "" : keyword_info->keyword();
+}
+
+// Guesses the kind of the statement that starts with <words>, following the
+// next_statement_kind rules in bison_parser.y.
+ASTNodeKind GuessStatementKind(const std::vector<std::string>& words) {
+  int i = 0;
+  auto word = [&words](int index) -> absl::string_view {
+    return index < words.size() ? absl::string_view(words[index]) : "";
+  };
+  auto accept = [&word, &i](absl::string_view expected) {
+    if (word(i) != expected) return false;
+    ++i;
+    return true;
+  };
+
+  while (accept("(")) {
+  }
+  if (accept("SELECT") || accept("WITH")) return AST_QUERY_STATEMENT;
+  if (i > 0) return kUnknownASTNodeKind;
+
+  if (accept("EXPLAIN")) return AST_EXPLAIN_STATEMENT;
+  if (accept("DEFINE")) {
+    return accept("TABLE") ? AST_DEFINE_TABLE_STATEMENT : kUnknownASTNodeKind;
+  }
+  if (accept("EXPORT")) {
+    return accept("DATA") ? AST_EXPORT_DATA_STATEMENT : kUnknownASTNodeKind;
+  }
+  if (accept("INSERT")) return AST_INSERT_STATEMENT;
+  if (accept("UPDATE")) return AST_UPDATE_STATEMENT;
+  if (accept("DELETE")) return AST_DELETE_STATEMENT;
+  if (accept("MERGE")) return AST_MERGE_STATEMENT;
+  if (accept("DESCRIBE") || accept("DESC")) return AST_DESCRIBE_STATEMENT;
+  if (accept("SHOW")) return AST_SHOW_STATEMENT;
+  if (accept("DROP")) {
+    if (accept("ALL")) {
+      return accept("ROW") && accept("POLICIES")
+                 ? AST_DROP_ALL_ROW_POLICIES_STATEMENT
+                 : kUnknownASTNodeKind;
+    }
+    if (accept("ROW")) {
+      return accept("POLICY") ? AST_DROP_ROW_POLICY_STATEMENT
+                              : kUnknownASTNodeKind;
+    }
+    if (accept("FUNCTION")) return AST_DROP_FUNCTION_STATEMENT;
+    if (accept("MATERIALIZED")) {
+      return accept("VIEW") ? AST_DROP_MATERIALIZED_VIEW_STATEMENT
+                            : kUnknownASTNodeKind;
+    }
+    if ((accept("AGGREGATE") && accept("FUNCTION")) ||
+        (accept("EXTERNAL") && accept("TABLE")) || accept("CONSTANT") ||
+        accept("DATABASE") || accept("INDEX") || accept("MODEL") ||
+        accept("PROCEDURE") || accept("TABLE") || accept("VIEW")) {
+      return AST_DROP_STATEMENT;
+    }
+    return kUnknownASTNodeKind;
+  }
+  if (accept("GRANT")) return AST_GRANT_STATEMENT;
+  if (accept("REVOKE")) return AST_REVOKE_STATEMENT;
+  if (accept("RENAME")) return AST_RENAME_STATEMENT;
+  if (accept("START")) {
+    return accept("BATCH") ? AST_START_BATCH_STATEMENT : AST_BEGIN_STATEMENT;
+  }
+  if (accept("BEGIN")) return AST_BEGIN_STATEMENT;
+  if (accept("SET")) {
+    return accept("TRANSACTION") ? AST_SET_TRANSACTION_STATEMENT
+                                 : kUnknownASTNodeKind;
+  }
+  if (accept("COMMIT")) return AST_COMMIT_STATEMENT;
+  if (accept("ROLLBACK")) return AST_ROLLBACK_STATEMENT;
+  if (accept("RUN")) {
+    return accept("BATCH") ? AST_RUN_BATCH_STATEMENT : kUnknownASTNodeKind;
+  }
+  if (accept("ABORT")) {
+    return accept("BATCH") ? AST_ABORT_BATCH_STATEMENT : kUnknownASTNodeKind;
+  }
+  if (accept("ALTER")) {
+    if (accept("TABLE")) return AST_ALTER_TABLE_STATEMENT;
+    if (accept("ROW")) return AST_ALTER_ROW_POLICY_STATEMENT;
+    if (accept("VIEW")) return AST_ALTER_VIEW_STATEMENT;
+    if (accept("MATERIALIZED") && accept("VIEW")) {
+      return AST_ALTER_MATERIALIZED_VIEW_STATEMENT;
+    }
+    return kUnknownASTNodeKind;
+  }
+  if (accept("CREATE")) {
+    if (accept("DATABASE")) return AST_CREATE_DATABASE_STATEMENT;
+    if (accept("OR") && !accept("REPLACE")) return kUnknownASTNodeKind;
+    if (accept("ROW")) {
+      return accept("POLICY") ? AST_CREATE_ROW_POLICY_STATEMENT
+                              : kUnknownASTNodeKind;
+    }
+    if (accept("MATERIALIZED")) {
+      return accept("VIEW") ? AST_CREATE_MATERIALIZED_VIEW_STATEMENT
+                            : kUnknownASTNodeKind;
+    }
+    if (accept("UNIQUE")) {
+      return accept("INDEX") ? AST_CREATE_INDEX_STATEMENT
+                             : kUnknownASTNodeKind;
+    }
+    if (accept("INDEX")) return AST_CREATE_INDEX_STATEMENT;
+    // Optional scope.
+    for (absl::string_view scope : {"TEMP", "TEMPORARY", "PUBLIC", "PRIVATE"}) {
+      if (accept(scope)) break;
+    }
+    if (accept("AGGREGATE")) {
+      if (accept("CONSTANT")) return AST_CREATE_CONSTANT_STATEMENT;
+      if (accept("FUNCTION")) return AST_CREATE_FUNCTION_STATEMENT;
+      return kUnknownASTNodeKind;
+    }
+    if (accept("CONSTANT")) return AST_CREATE_CONSTANT_STATEMENT;
+    if (accept("FUNCTION")) return AST_CREATE_FUNCTION_STATEMENT;
+    if (accept("PROCEDURE")) return AST_CREATE_PROCEDURE_STATEMENT;
+    if (accept("TABLE")) {
+      return accept("FUNCTION") ? AST_CREATE_TABLE_FUNCTION_STATEMENT
+                                : AST_CREATE_TABLE_STATEMENT;
+    }
+    if (accept("MODEL")) return AST_CREATE_MODEL_STATEMENT;
+    if (accept("EXTERNAL")) return AST_CREATE_EXTERNAL_TABLE_STATEMENT;
+    if (accept("VIEW")) return AST_CREATE_VIEW_STATEMENT;
+    return kUnknownASTNodeKind;
+  }
+  if (accept("CALL")) return AST_CALL_STATEMENT;
+  if (accept("IMPORT")) return AST_IMPORT_STATEMENT;
+  if (accept("MODULE")) return AST_MODULE_STATEMENT;
+  if (accept("ASSERT")) return AST_ASSERT_STATEMENT;
+  return kUnknownASTNodeKind;
+}
+
+}  // namespace
+
+StatementSplitter::StatementSplitter(absl::string_view sql, int start_offset)
+    : sql_(sql),
+      tokenizer_(absl::make_unique<parser::ZetaSqlFlexTokenizer>(
+          parser::BisonParserMode::kTokenizer, /*filename=*/"", sql,
+          start_offset)) {
+  location_.set_start(ParseLocationPoint::FromByteOffset(start_offset));
+  location_.set_end(ParseLocationPoint::FromByteOffset(start_offset));
+}
+
+StatementSplitter::~StatementSplitter() {}
+
+zetasql_base::Status StatementSplitter::Next(SplitStatement* statement,
+                                     bool* at_end) {
+  *statement = SplitStatement();
+  *at_end = false;
+  if (at_end_) {
+    *at_end = true;
+    return ::zetasql_base::OkStatus();
+  }
+  bool has_tokens = false;
+  std::vector<std::string> words;
+  // Leading hints ("@{...}" or "@<integer>") are skipped.  <hint_depth> is
+  // the brace depth inside a hint body, and <in_integer_hint> is set after
+  // KW_OPEN_INTEGER_HINT, which is followed by the integer.
+  int hint_depth = 0;
+  bool in_integer_hint = false;
+  while (true) {
+    int bison_token;
+    ZETASQL_RETURN_IF_ERROR(ConvertInternalErrorLocationToExternal(
+        tokenizer_->GetNextToken(&location_ /* input and output */,
+                                 &bison_token),
+        sql_));
+    if (bison_token == 0 /* EOF */) {
+      at_end_ = true;
+      if (!has_tokens) {
+        *at_end = true;
+        return ::zetasql_base::OkStatus();
+      }
+      break;
+    }
+    const int token_start = location_.start().GetByteOffset();
+    if (!has_tokens) {
+      statement->start = token_start;
+      has_tokens = true;
+    }
+    if (bison_token == ';') {
+      // The tokenizer may include trailing whitespace in the ";" token.
+      statement->end = token_start + 1;
+      statement->has_semicolon = true;
+      break;
+    }
+    statement->end = location_.end().GetByteOffset();
+
+    if (hint_depth > 0) {
+      if (bison_token == '{') ++hint_depth;
+      if (bison_token == '}') --hint_depth;
+    } else if (in_integer_hint) {
+      in_integer_hint = false;
+    } else if (words.empty() &&
+               bison_token == BisonParserImpl::token::KW_OPEN_HINT) {
+      hint_depth = 1;
+    } else if (words.empty() &&
+               bison_token == BisonParserImpl::token::KW_OPEN_INTEGER_HINT) {
+      in_integer_hint = true;
+    } else if (words.size() < kMaxStatementKindWords) {
+      words.push_back(GetStatementKindWord(bison_token));
+    }
+  }
+  statement->kind = GuessStatementKind(words);
+  return ::zetasql_base::OkStatus();
+}
+
+// static
+zetasql_base::Status StatementSplitter::Split(absl::string_view sql,
+                                      std::vector<SplitStatement>* statements) {
+  statements->clear();
+  StatementSplitter splitter(sql);
+  while (true) {
+    SplitStatement statement;
+    bool at_end;
+    ZETASQL_RETURN_IF_ERROR(splitter.Next(&statement, &at_end));
+    if (at_end) break;
+    statements->push_back(statement);
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status StreamingStatementSplitter::AddInput(
+    absl::string_view chunk, std::vector<SplitStatement>* statements) {
+  pending_.append(chunk.data(), chunk.size());
+  StatementSplitter splitter(pending_);
+  int consumed = 0;
+  while (true) {
+    SplitStatement statement;
+    bool at_end;
+    // Errors and statements without a ";" may be caused by a token that
+    // continues in a later chunk, so they wait for more input.
+    if (!splitter.Next(&statement, &at_end).ok() || at_end ||
+        !statement.has_semicolon) {
+      break;
+    }
+    consumed = statement.end;
+    statement.start += pending_offset_;
+    statement.end += pending_offset_;
+    statements->push_back(statement);
+  }
+  pending_.erase(0, consumed);
+  pending_offset_ += consumed;
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status StreamingStatementSplitter::Finish(
+    std::vector<SplitStatement>* statements) {
+  std::vector<SplitStatement> remaining;
+  ZETASQL_RETURN_IF_ERROR(StatementSplitter::Split(pending_, &remaining));
+  for (SplitStatement& statement : remaining) {
+    statement.start += pending_offset_;
+    statement.end += pending_offset_;
+    statements->push_back(statement);
+  }
+  pending_offset_ += pending_.size();
+  pending_.clear();
+  return ::zetasql_base::OkStatus();
+}
+
+}  // namespace zetasql
@@ -0,0 +1,123 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PUBLIC_STATEMENT_SPLITTER_H_
+#define ZETASQL_PUBLIC_STATEMENT_SPLITTER_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/parser/ast_node_kind.h"
+#include "zetasql/public/parse_location.h"
+#include "absl/strings/string_view.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+
+namespace parser {
+class ZetaSqlFlexTokenizer;
+}  // namespace parser
+
+// A statement found by StatementSplitter.
+struct SplitStatement {
+  // Byte offset of the first token of the statement.
+  int start = 0;
+  // Byte offset just past the terminating ";", or past the last token if the
+  // statement is at the end of the input without a ";".
+  int end = 0;
+  // True if the statement is terminated by a ";".
+  bool has_semicolon = false;
+  // The statement kind guessed from the leading keywords, like
+  // ParseNextStatementKind() returns, or kUnknownASTNodeKind.  The rest of
+  // the statement is not checked, so the statement may still be invalid.
+  ASTNodeKind kind = kUnknownASTNodeKind;
+};
+
+// Splits a multi-statement script into statements using only the tokenizer,
+// without running the parser or building ASTs, for callers that only need
+// statement boundaries and kinds, e.g. for routing or auditing large dumps.
+//
+// Quoted strings, identifiers and comments containing ";" are handled like
+// the parser handles them.  A ";" with no tokens before it produces a
+// statement of kind kUnknownASTNodeKind.  Whitespace and comments after the
+// last statement do not produce a statement.
+//
+// The whole input is tokenized by one tokenizer, so splitting is linear in
+// the size of the input.
+class StatementSplitter {
+ public:
+  // <sql> must outlive this object.  Splitting starts at byte offset
+  // <start_offset>, which must be the start of a statement or of whitespace
+  // or comments before one.
+  explicit StatementSplitter(absl::string_view sql, int start_offset = 0);
+  StatementSplitter(const StatementSplitter&) = delete;
+  StatementSplitter& operator=(const StatementSplitter&) = delete;
+  ~StatementSplitter();
+
+  // Returns the next statement in <*statement> and sets <*at_end> to false,
+  // or sets <*at_end> to true if there are no more statements.  Returns an
+  // error if the input cannot be tokenized, e.g. because of an unterminated
+  // std::string literal; splitting cannot continue after an error.
+  zetasql_base::Status Next(SplitStatement* statement, bool* at_end);
+
+  // Splits all of <sql> into <*statements>.
+  static zetasql_base::Status Split(absl::string_view sql,
+                            std::vector<SplitStatement>* statements);
+
+ private:
+  const absl::string_view sql_;
+  std::unique_ptr<parser::ZetaSqlFlexTokenizer> tokenizer_;
+  // Location of the last token returned by the tokenizer.
+  ParseLocationRange location_;
+  bool at_end_ = false;
+};
+
+// Splits a script that arrives in chunks, such as a SQL dump read from a
+// file, into statements.  Offsets in the returned statements are relative
+// to the start of the whole stream.
+//
+// Only the text after the last complete statement is buffered.  Statements
+// longer than a chunk are tokenized again as each chunk arrives, so chunks
+// should be large relative to typical statements.
+class StreamingStatementSplitter {
+ public:
+  StreamingStatementSplitter() {}
+  StreamingStatementSplitter(const StreamingStatementSplitter&) = delete;
+  StreamingStatementSplitter& operator=(const StreamingStatementSplitter&) =
+      delete;
+
+  // Appends <chunk> to the input, and appends the statements that it
+  // completes to <*statements>.  Statements are only returned once their
+  // terminating ";" has been seen.
+  zetasql_base::Status AddInput(absl::string_view chunk,
+                        std::vector<SplitStatement>* statements);
+
+  // Signals the end of the input, and appends the final statement to
+  // <*statements> if it is not terminated by a ";".  Returns an error if the
+  // buffered input cannot be tokenized.  Error locations are relative to the
+  // buffered input, i.e. the text after the last complete statement.
+  zetasql_base::Status Finish(std::vector<SplitStatement>* statements);
+
+ private:
+  // Text after the last complete statement, and its offset in the stream.
+  std::string pending_;
+  int pending_offset_ = 0;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_STATEMENT_SPLITTER_H_
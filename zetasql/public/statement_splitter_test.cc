@@ -0,0 +1,163 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/statement_splitter.h"
+
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/string_view.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+
+using ::zetasql_base::testing::StatusIs;
+
+namespace {
+
+std::vector<std::string> StatementTexts(
+    absl::string_view sql, const std::vector<SplitStatement>& statements) {
+  std::vector<std::string> texts;
+  for (const SplitStatement& statement : statements) {
+    texts.push_back(std::string(
+        sql.substr(statement.start, statement.end - statement.start)));
+  }
+  return texts;
+}
+
+std::vector<ASTNodeKind> StatementKinds(
+    const std::vector<SplitStatement>& statements) {
+  std::vector<ASTNodeKind> kinds;
+  for (const SplitStatement& statement : statements) {
+    kinds.push_back(statement.kind);
+  }
+  return kinds;
+}
+
+}  // namespace
+
+TEST(StatementSplitterTest, SplitsOnSemicolons) {
+  const std::string sql =
+      "SELECT 1;  SELECT ';' -- ;\n FROM t /* ; */;\n"
+      "SELECT `a;b` FROM t  -- trailing comment\n";
+  std::vector<SplitStatement> statements;
+  ZETASQL_ASSERT_OK(StatementSplitter::Split(sql, &statements));
+  EXPECT_THAT(StatementTexts(sql, statements),
+              ::testing::ElementsAre("SELECT 1;",
+                                     "SELECT ';' -- ;\n FROM t /* ; */;",
+                                     "SELECT `a;b` FROM t"));
+  ASSERT_EQ(3, statements.size());
+  EXPECT_TRUE(statements[0].has_semicolon);
+  EXPECT_TRUE(statements[1].has_semicolon);
+  EXPECT_FALSE(statements[2].has_semicolon);
+}
+
+TEST(StatementSplitterTest, EmptyAndTrailingInput) {
+  std::vector<SplitStatement> statements;
+  ZETASQL_ASSERT_OK(StatementSplitter::Split("", &statements));
+  EXPECT_TRUE(statements.empty());
+  ZETASQL_ASSERT_OK(StatementSplitter::Split("  -- comment\n", &statements));
+  EXPECT_TRUE(statements.empty());
+  ZETASQL_ASSERT_OK(StatementSplitter::Split("SELECT 1;  /* x */ ", &statements));
+  EXPECT_EQ(1, statements.size());
+}
+
+TEST(StatementSplitterTest, GuessesStatementKinds) {
+  const std::string sql =
+      "SELECT 1; ((WITH t AS (SELECT 1) SELECT * FROM t));"
+      "@{hint=1} SELECT 2; @5 SELECT 3;"
+      "INSERT INTO t VALUES (1); DROP TABLE t; DROP FUNCTION f;"
+      "CREATE OR REPLACE TEMP AGGREGATE FUNCTION f(x INT64) AS (SUM(x));"
+      "CREATE TABLE FUNCTION f() AS SELECT 1;"
+      "CREATE TEMP TABLE t AS SELECT 1; CREATE UNIQUE INDEX i ON t(a);"
+      "BEGIN; START BATCH; COMMIT; EXPLAIN SELECT 1; foo bar;";
+  std::vector<SplitStatement> statements;
+  ZETASQL_ASSERT_OK(StatementSplitter::Split(sql, &statements));
+  EXPECT_THAT(StatementKinds(statements),
+              ::testing::ElementsAre(
+                  AST_QUERY_STATEMENT, AST_QUERY_STATEMENT,
+                  AST_QUERY_STATEMENT, AST_QUERY_STATEMENT,
+                  AST_INSERT_STATEMENT, AST_DROP_STATEMENT,
+                  AST_DROP_FUNCTION_STATEMENT, AST_CREATE_FUNCTION_STATEMENT,
+                  AST_CREATE_TABLE_FUNCTION_STATEMENT,
+                  AST_CREATE_TABLE_STATEMENT, AST_CREATE_INDEX_STATEMENT,
+                  AST_BEGIN_STATEMENT, AST_START_BATCH_STATEMENT,
+                  AST_COMMIT_STATEMENT, AST_EXPLAIN_STATEMENT,
+                  kUnknownASTNodeKind));
+}
+
+TEST(StatementSplitterTest, StartOffset) {
+  const std::string sql = "SELECT 1; SELECT 2; SELECT 3";
+  StatementSplitter splitter(sql, /*start_offset=*/9);
+  SplitStatement statement;
+  bool at_end;
+  ZETASQL_ASSERT_OK(splitter.Next(&statement, &at_end));
+  ASSERT_FALSE(at_end);
+  EXPECT_EQ(10, statement.start);
+  EXPECT_EQ(19, statement.end);
+  ZETASQL_ASSERT_OK(splitter.Next(&statement, &at_end));
+  ASSERT_FALSE(at_end);
+  EXPECT_EQ(20, statement.start);
+  ZETASQL_ASSERT_OK(splitter.Next(&statement, &at_end));
+  EXPECT_TRUE(at_end);
+  ZETASQL_ASSERT_OK(splitter.Next(&statement, &at_end));
+  EXPECT_TRUE(at_end);
+}
+
+TEST(StatementSplitterTest, TokenizerErrors) {
+  std::vector<SplitStatement> statements;
+  EXPECT_THAT(StatementSplitter::Split("SELECT 1; SELECT 'abc", &statements),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+}
+
+TEST(StreamingStatementSplitterTest, MatchesSplittingWholeInput) {
+  const std::string sql =
+      "SELECT 'a;b' FROM t;\n-- comment ;\nINSERT INTO t VALUES (1);"
+      "/* ; */ DELETE FROM t WHERE true;\nUPDATE t SET a = 1 WHERE true";
+  std::vector<SplitStatement> expected;
+  ZETASQL_ASSERT_OK(StatementSplitter::Split(sql, &expected));
+  ASSERT_EQ(4, expected.size());
+
+  for (int chunk_size = 1; chunk_size <= sql.size(); ++chunk_size) {
+    StreamingStatementSplitter splitter;
+    std::vector<SplitStatement> statements;
+    for (int i = 0; i < sql.size(); i += chunk_size) {
+      ZETASQL_ASSERT_OK(splitter.AddInput(absl::string_view(sql).substr(i, chunk_size),
+                                  &statements));
+    }
+    ZETASQL_ASSERT_OK(splitter.Finish(&statements));
+    ASSERT_EQ(expected.size(), statements.size()) << chunk_size;
+    for (int i = 0; i < expected.size(); ++i) {
+      EXPECT_EQ(expected[i].start, statements[i].start) << chunk_size;
+      EXPECT_EQ(expected[i].end, statements[i].end) << chunk_size;
+      EXPECT_EQ(expected[i].kind, statements[i].kind) << chunk_size;
+    }
+  }
+}
+
+TEST(StreamingStatementSplitterTest, FinishReportsErrors) {
+  StreamingStatementSplitter splitter;
+  std::vector<SplitStatement> statements;
+  ZETASQL_ASSERT_OK(splitter.AddInput("SELECT 1; SELECT \"abc", &statements));
+  EXPECT_EQ(1, statements.size());
+  EXPECT_THAT(splitter.Finish(&statements),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+}
+
+}  // namespace zetasql
@@ -17,9 +17,14 @@
 #include "zetasql/public/strings.h"
 
 #include <ctype.h>
+#include <string.h>
 
 #include <iterator>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "zetasql/base/logging.h"
 #include "zetasql/common/errors.h"
 #include "zetasql/common/utf_util.h"
@@ -32,6 +37,7 @@
 #include "absl/strings/str_cat.h"
 #include "unicode/utf.h"
 #include "unicode/utf8.h"
+#include "zetasql/base/bits.h"
 #include "zetasql/base/map_util.h"
 #include "zetasql/base/ret_check.h"
 #include "zetasql/base/status.h"
@@ -108,6 +114,82 @@ static int AppendCodePoint(char* s, UChar32 cp) {
   return cp_len;
 }
 
+// Returns the first '\\' or '\r' in [p, end), or 'end' if there is none. These
+// are the only bytes that CUnescapeInternal does not copy unchanged.
+static const char* FindBackslashOrCarriageReturn(const char* p,
+                                                 const char* end) {
+#if defined(__SSE2__)
+  const __m128i kBackslash = _mm_set1_epi8('\\');
+  const __m128i kCarriageReturn = _mm_set1_epi8('\r');
+  for (; p + 16 <= end; p += 16) {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const int mask = _mm_movemask_epi8(
+        _mm_or_si128(_mm_cmpeq_epi8(block, kBackslash),
+                     _mm_cmpeq_epi8(block, kCarriageReturn)));
+    if (mask != 0) {
+      return p + zetasql_base::Bits::FindLSBSetNonZero(mask);
+    }
+  }
+#endif
+  for (; p < end && *p != '\\' && *p != '\r'; ++p) {
+  }
+  return p;
+}
+
+// Returns true if CEscapeInternal() and EscapeBytes() copy the byte <c>
+// unchanged whatever the quote character and the preceding byte are. That is
+// printable ASCII other than '\\' and the quote characters, and also bytes
+// >= 0x80 if <allow_non_ascii> is true.
+static inline bool IsCopiedUnescaped(unsigned char c, bool allow_non_ascii) {
+  if (c >= 0x80) {
+    return allow_non_ascii;
+  }
+  return absl::ascii_isprint(c) && c != '\\' && c != '\'' && c != '"' &&
+         c != '`';
+}
+
+// Returns the length of the longest prefix of <src> consisting of bytes for
+// which IsCopiedUnescaped() is true, checking 16 bytes at a time with SSE2
+// where available.
+static size_t SpanCopiedUnescaped(absl::string_view src,
+                                  bool allow_non_ascii) {
+  const char* data = src.data();
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128i kZero = _mm_setzero_si128();
+  const __m128i kSpace = _mm_set1_epi8(' ');
+  const __m128i kDelete = _mm_set1_epi8('\x7f');
+  const __m128i kBackslash = _mm_set1_epi8('\\');
+  const __m128i kSingleQuote = _mm_set1_epi8('\'');
+  const __m128i kDoubleQuote = _mm_set1_epi8('"');
+  const __m128i kBackquote = _mm_set1_epi8('`');
+  for (; i + 16 <= src.size(); i += 16) {
+    const __m128i block =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    // Bytes >= 0x80 are negative as signed bytes, so they compare below ' '
+    // too and are excluded from the control characters.
+    const __m128i non_ascii = _mm_cmplt_epi8(block, kZero);
+    __m128i escaped =
+        _mm_andnot_si128(non_ascii, _mm_cmplt_epi8(block, kSpace));
+    escaped = _mm_or_si128(escaped, _mm_cmpeq_epi8(block, kDelete));
+    escaped = _mm_or_si128(escaped, _mm_cmpeq_epi8(block, kBackslash));
+    escaped = _mm_or_si128(escaped, _mm_cmpeq_epi8(block, kSingleQuote));
+    escaped = _mm_or_si128(escaped, _mm_cmpeq_epi8(block, kDoubleQuote));
+    escaped = _mm_or_si128(escaped, _mm_cmpeq_epi8(block, kBackquote));
+    if (!allow_non_ascii) {
+      escaped = _mm_or_si128(escaped, non_ascii);
+    }
+    const int mask = _mm_movemask_epi8(escaped);
+    if (mask != 0) {
+      return i + zetasql_base::Bits::FindLSBSetNonZero(mask);
+    }
+  }
+#endif
+  for (; i < src.size() && IsCopiedUnescaped(data[i], allow_non_ascii); ++i) {
+  }
+  return i;
+}
+
 // ----------------------------------------------------------------------
 // CUnescapeInternal()
 //    Unescapes C escape sequences and is the reverse of CEscape().
@@ -180,7 +262,11 @@ static bool CUnescapeInternal(absl::string_view source,
   while (p < end) {
     if (*p != '\\') {
       if (*p != '\r') {
-        *d++ = *p++;
+        // Copy everything up to the next escape or carriage return at once.
+        const char* run_end = FindBackslashOrCarriageReturn(p, end);
+        memcpy(d, p, run_end - p);
+        d += run_end - p;
+        p = run_end;
       } else {
         // All types of newlines in different platforms i.e. '\r', '\n', '\r\n'
         // are replaced with '\n'.
@@ -492,28 +578,39 @@ static bool CUnescapeInternal(absl::string_view source,
 // (from '"`) that matches escape_quote_char.
 // This allows writing "ab'cd" or 'ab"cd' or `ab"cd` without extra escaping.
 // ----------------------------------------------------------------------
-static std::string CEscapeInternal(absl::string_view src, bool utf8_safe,
-                              char escape_quote_char) {
-  std::string dest;
+static void CEscapeInternal(absl::string_view src, bool utf8_safe,
+                            char escape_quote_char, std::string* dest) {
+  dest->reserve(dest->size() + src.size());
   bool last_hex_escape = false;  // true if last output char was \xNN.
 
   for (const char* p = src.begin(); p < src.end(); ++p) {
+    if (!last_hex_escape) {
+      // Copy the run of bytes that need no escaping at once.
+      const size_t run_length = SpanCopiedUnescaped(
+          absl::string_view(p, src.end() - p), utf8_safe);
+      dest->append(p, run_length);
+      p += run_length;
+      if (p == src.end()) {
+        break;
+      }
+    }
+
     unsigned char c = *p;
     bool is_hex_escape = false;
     switch (c) {
-      case '\n': dest.append("\\" "n"); break;
-      case '\r': dest.append("\\" "r"); break;
-      case '\t': dest.append("\\" "t"); break;
-      case '\\': dest.append("\\" "\\"); break;
+      case '\n': dest->append("\\" "n"); break;
+      case '\r': dest->append("\\" "r"); break;
+      case '\t': dest->append("\\" "t"); break;
+      case '\\': dest->append("\\" "\\"); break;
 
       case '\'':
       case '\"':
       case '`':
         // Escape only quote chars that match escape_quote_char.
         if (escape_quote_char == 0 || c == escape_quote_char) {
-          dest.push_back('\\');
+          dest->push_back('\\');
         }
-        dest.push_back(c);
+        dest->push_back(c);
         break;
 
       default:
@@ -523,19 +620,62 @@ static std::string CEscapeInternal(absl::string_view src, bool utf8_safe,
         if ((!utf8_safe || c < 0x80) &&
             (!absl::ascii_isprint(c) ||
              (last_hex_escape && absl::ascii_isxdigit(c)))) {
-          dest.append("\\" "x");
-          dest.push_back(hex_char[c / 16]);
-          dest.push_back(hex_char[c % 16]);
+          dest->append("\\" "x");
+          dest->push_back(hex_char[c / 16]);
+          dest->push_back(hex_char[c % 16]);
           is_hex_escape = true;
         } else {
-          dest.push_back(c);
+          dest->push_back(c);
           break;
         }
     }
     last_hex_escape = is_hex_escape;
   }
+}
 
-  return dest;
+// Same as EscapeBytes(), but appends the result to <dest>.
+static void EscapeBytesInternal(absl::string_view str, bool escape_all_bytes,
+                                char escape_quote_char, std::string* dest) {
+  dest->reserve(dest->size() + str.size());
+  for (const char* p = str.begin(); p < str.end(); ++p) {
+    if (!escape_all_bytes) {
+      // Copy the run of bytes that need no escaping at once.
+      const size_t run_length = SpanCopiedUnescaped(
+          absl::string_view(p, str.end() - p), false /* allow_non_ascii */);
+      dest->append(p, run_length);
+      p += run_length;
+      if (p == str.end()) {
+        break;
+      }
+    }
+
+    unsigned char c = *p;
+    if (escape_all_bytes || !absl::ascii_isprint(c)) {
+      dest->append("\\x");
+      dest->push_back(hex_char[c / 16]);
+      dest->push_back(hex_char[c % 16]);
+    } else {
+      switch (c) {
+        // Note that we only handle printable escape characters here.  All
+        // unprintable (\n, \r, \t, etc.) are hex escaped above.
+        case '\\':
+          dest->append("\\\\");
+          break;
+        case '\'':
+        case '"':
+        case '`':
+          // Escape only quote chars that match escape_quote_char.
+          if (escape_quote_char == 0 || c == escape_quote_char) {
+            dest->push_back('\\');
+          }
+          dest->push_back(c);
+          break;
+        default:
+          dest->push_back(c);
+          break;
+      }
+    }
+  }
 }
 
 zetasql_base::Status UnescapeString(absl::string_view str, std::string* out,
@@ -567,39 +707,20 @@ zetasql_base::Status UnescapeBytes(absl::string_view str, std::string* out,
 }
 
 std::string EscapeString(absl::string_view str) {
-  return CEscapeInternal(str, true /* utf8_safe */, 0 /* escape_quote_char */);
+  std::string escaped;
+  AppendEscapedString(str, &escaped);
+  return escaped;
+}
+
+void AppendEscapedString(absl::string_view str, std::string* out) {
+  CEscapeInternal(str, true /* utf8_safe */, 0 /* escape_quote_char */, out);
 }
 
 std::string EscapeBytes(absl::string_view str, bool escape_all_bytes,
                    char escape_quote_char) {
   std::string escaped_bytes;
-  for (const char* p = str.begin(); p < str.end(); ++p) {
-    unsigned char c = *p;
-    if (escape_all_bytes || !absl::ascii_isprint(c)) {
-      escaped_bytes += "\\x";
-      escaped_bytes += absl::BytesToHexString(absl::string_view(p, 1));
-    } else {
-      switch (c) {
-        // Note that we only handle printable escape characters here.  All
-        // unprintable (\n, \r, \t, etc.) are hex escaped above.
-        case '\\':
-          escaped_bytes += "\\\\";
-          break;
-        case '\'':
-        case '"':
-        case '`':
-          // Escape only quote chars that match escape_quote_char.
-          if (escape_quote_char == 0 || c == escape_quote_char) {
-            escaped_bytes += '\\';
-          }
-          escaped_bytes += c;
-          break;
-        default:
-          escaped_bytes += c;
-          break;
-      }
-    }
-  }
+  EscapeBytesInternal(str, escape_all_bytes, escape_quote_char,
+                      &escaped_bytes);
   return escaped_bytes;
 }
 
@@ -715,39 +836,71 @@ zetasql_base::Status ParseBytesLiteral(absl::string_view str, std::string* out,
   return ::zetasql_base::OkStatus();
 }
 
+// Returns the quote character that ToStringLiteral() and ToBytesLiteral() use
+// for <str>: ' if <str> contains " but not ', and " otherwise.
+static char ChooseQuoteChar(absl::string_view str) {
+  return (str.find('"') != str.npos && str.find('\'') == str.npos) ? '\''
+                                                                     : '"';
+}
+
+// Appends <str> quoted with <quote> and escaped to <out>, prefixed with b for
+// bytes.
+static void AppendQuotedLiteral(absl::string_view str, char quote,
+                                bool is_bytes, std::string* out) {
+  out->reserve(out->size() + str.size() + 3);
+  if (is_bytes) {
+    out->push_back('b');
+    out->push_back(quote);
+    EscapeBytesInternal(str, false /* escape_all_bytes */, quote, out);
+  } else {
+    out->push_back(quote);
+    CEscapeInternal(str, true /* utf8_safe */, quote, out);
+  }
+  out->push_back(quote);
+}
+
 std::string ToStringLiteral(absl::string_view str) {
-  absl::string_view quote =
-      (str.find('"') != str.npos && str.find('\'') == str.npos) ? "'" : "\"";
-  return absl::StrCat(
-      quote, CEscapeInternal(str, true /* utf8_safe */, quote[0]), quote);
+  std::string literal;
+  AppendStringLiteral(str, &literal);
+  return literal;
+}
+
+void AppendStringLiteral(absl::string_view str, std::string* out) {
+  AppendQuotedLiteral(str, ChooseQuoteChar(str), false /* is_bytes */, out);
 }
 
 std::string ToSingleQuotedStringLiteral(absl::string_view str) {
-  return absl::StrCat("'", CEscapeInternal(str, true /* utf8_safe */, '\''),
-                      "'");
+  std::string literal;
+  AppendQuotedLiteral(str, '\'', false /* is_bytes */, &literal);
+  return literal;
 }
 
 std::string ToDoubleQuotedStringLiteral(absl::string_view str) {
-  return absl::StrCat("\"", CEscapeInternal(str, true /* utf8_safe */, '"'),
-                      "\"");
+  std::string literal;
+  AppendQuotedLiteral(str, '"', false /* is_bytes */, &literal);
+  return literal;
 }
 
 std::string ToBytesLiteral(absl::string_view str) {
-  absl::string_view quote =
-      (str.find('"') != str.npos && str.find('\'') == str.npos) ? "'" : "\"";
-  return absl::StrCat("b", quote,
-                      EscapeBytes(str, false /* escape_all_bytes */, quote[0]),
-                      quote);
+  std::string literal;
+  AppendBytesLiteral(str, &literal);
+  return literal;
+}
+
+void AppendBytesLiteral(absl::string_view str, std::string* out) {
+  AppendQuotedLiteral(str, ChooseQuoteChar(str), true /* is_bytes */, out);
 }
 
 std::string ToSingleQuotedBytesLiteral(absl::string_view str) {
-  return absl::StrCat(
-      "b'", EscapeBytes(str, false /* escape_all_bytes */, '\''), "'");
+  std::string literal;
+  AppendQuotedLiteral(str, '\'', true /* is_bytes */, &literal);
+  return literal;
 }
 
 std::string ToDoubleQuotedBytesLiteral(absl::string_view str) {
-  return absl::StrCat(
-      "b\"", EscapeBytes(str, false /* escape_all_bytes */, '"'), "\"");
+  std::string literal;
+  AppendQuotedLiteral(str, '"', true /* is_bytes */, &literal);
+  return literal;
 }
 
 // Return true if <str> is a valid identifier without quoting.
@@ -824,11 +977,13 @@ zetasql_base::Status ParseGeneralizedIdentifier(absl::string_view str, std::stri
 
 std::string ToIdentifierLiteral(absl::string_view str,
                            bool quote_reserved_keywords) {
-  return IsValidUnquotedIdentifier(str, !quote_reserved_keywords) &&
-                 !parser::NonReservedIdentifierMustBeBackquoted(str)
-             ? std::string(str)
-             : absl::StrCat(
-                   "`", CEscapeInternal(str, true /* utf8_safe */, '`'), "`");
+  if (IsValidUnquotedIdentifier(str, !quote_reserved_keywords) &&
+      !parser::NonReservedIdentifierMustBeBackquoted(str)) {
+    return std::string(str);
+  }
+  std::string literal;
+  AppendQuotedLiteral(str, '`', false /* is_bytes */, &literal);
+  return literal;
 }
 
 std::string ToIdentifierLiteral(IdString str, bool quote_reserved_keywords) {
@@ -917,8 +1072,8 @@ static zetasql_base::Status AddIdentifierPathSegment(absl::string_view segment,
       // Unescaped path components beginning with digits/containing reserved
       // keywords are valid but need to be quoted to ensure they are correctly
       // parsed.
-      const std::string quoted_segment = absl::StrCat(
-          "`", CEscapeInternal(segment, true /* utf8_safe */, '`'), "`");
+      std::string quoted_segment;
+      AppendQuotedLiteral(segment, '`', false /* is_bytes */, &quoted_segment);
       ZETASQL_RETURN_IF_ERROR(ParseIdentifier(quoted_segment, &out_string));
     }
   }
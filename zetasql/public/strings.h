@@ -56,6 +56,9 @@ zetasql_base::Status UnescapeBytes(absl::string_view str, std::string* out,
 // Escape a std::string without quoting it. All quote characters are escaped.
 std::string EscapeString(absl::string_view str);
 
+// Same as EscapeString(), but appends the result to <out>.
+void AppendEscapedString(absl::string_view str, std::string* out);
+
 // Escape a bytes value without quoting it.  Escaped bytes use hex escapes.
 // If <escape_all_bytes> is true then all bytes are escaped.  Otherwise only
 // unprintable bytes and escape/quote characters are escaped.
@@ -86,6 +89,9 @@ zetasql_base::Status ParseBytesLiteral(absl::string_view str, std::string* out,
 // May choose to quote with ' or " to produce nicer output.
 std::string ToStringLiteral(absl::string_view str);
 
+// Same as ToStringLiteral(), but appends the result to <out>.
+void AppendStringLiteral(absl::string_view str, std::string* out);
+
 // Return a quoted and escaped ZetaSQL std::string literal for <str>.
 // Always uses single quotes.
 std::string ToSingleQuotedStringLiteral(absl::string_view str);
@@ -98,6 +104,9 @@ std::string ToDoubleQuotedStringLiteral(absl::string_view str);
 // Prefixes with b and may choose to quote with ' or " to produce nicer output.
 std::string ToBytesLiteral(absl::string_view str);
 
+// Same as ToBytesLiteral(), but appends the result to <out>.
+void AppendBytesLiteral(absl::string_view str, std::string* out);
+
 // Return a quoted and escaped ZetaSQL bytes literal for <str>.
 // Prefixes with b and always uses single quotes.
 std::string ToSingleQuotedBytesLiteral(absl::string_view str);
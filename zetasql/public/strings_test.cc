@@ -409,6 +409,40 @@ TEST(StringsTest, RoundTrip) {
   TestValue("\\\"\xe8\xb0\xb7\xe6\xad\x8c\\\" is Google\\\'s Chinese name");
 }
 
+TEST(StringsTest, LongRoundTrip) {
+  // Long enough for the block-at-a-time scans, with characters that need
+  // escaping at every offset of the block.
+  const std::string plain = "abcdefghijklmnopqrstuvwxyz \xe8\xb0\xb7 0123456789";
+  for (const char* special : {"\n", "\r", "\\", "'", "\"", "`", "\x01",
+                              "\x7f", "\x12" "a"}) {
+    for (int i = 0; i <= plain.size(); ++i) {
+      const std::string value =
+          absl::StrCat(plain.substr(0, i), special, plain.substr(i), plain);
+      if (IsWellFormedUTF8(value)) {
+        TestValue(value);
+      }
+      std::string unquoted;
+      ZETASQL_EXPECT_OK(ParseBytesLiteral(ToBytesLiteral(value), &unquoted));
+      EXPECT_EQ(value, unquoted);
+    }
+  }
+}
+
+TEST(StringsTest, AppendForms) {
+  const std::string value = "ab'c\"d\n\xe8\xb0\xb7";
+  std::string out = "x";
+  AppendEscapedString(value, &out);
+  EXPECT_EQ(absl::StrCat("x", EscapeString(value)), out);
+
+  out = "x";
+  AppendStringLiteral(value, &out);
+  EXPECT_EQ(absl::StrCat("x", ToStringLiteral(value)), out);
+
+  out = "x";
+  AppendBytesLiteral(value, &out);
+  EXPECT_EQ(absl::StrCat("x", ToBytesLiteral(value)), out);
+}
+
 TEST(StringsTest, InvalidString) {
   const std::string kInvalidStringLiteral =  //
       "Invalid string literal";
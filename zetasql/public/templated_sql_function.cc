@@ -24,6 +24,7 @@
 #include "zetasql/public/parse_location.h"
 #include "zetasql/public/strings.h"
 #include "zetasql/resolved_ast/resolved_ast.h"
+#include "zetasql/resolved_ast/resolved_ast_deep_copy_visitor.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
@@ -92,6 +93,23 @@ zetasql_base::Status TemplatedSQLFunction::Serialize(
   return ::zetasql_base::OkStatus();
 }
 
+std::shared_ptr<const TemplatedSQLFunctionCall>
+TemplatedSQLFunction::FindCachedCall(const std::string& key) const {
+  absl::MutexLock l(&cache_mutex_);
+  auto it = cached_calls_.find(key);
+  if (it == cached_calls_.end()) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+void TemplatedSQLFunction::AddCachedCall(
+    const std::string& key,
+    std::shared_ptr<const TemplatedSQLFunctionCall> call) const {
+  absl::MutexLock l(&cache_mutex_);
+  cached_calls_.emplace(key, std::move(call));
+}
+
 TemplatedSQLFunctionCall::TemplatedSQLFunctionCall(const ResolvedExpr* expr)
     : expr_(expr) {}
 
@@ -130,6 +148,29 @@ std::string TemplatedSQLFunctionCall::DebugString() const {
                                     ResolvedComputedColumnFormatter));
 }
 
+zetasql_base::Status TemplatedSQLFunctionCall::Copy(
+    std::unique_ptr<TemplatedSQLFunctionCall>* copy) const {
+  ZETASQL_RET_CHECK(expr_ != nullptr);
+  ResolvedASTDeepCopyVisitor expr_copy_visitor;
+  ZETASQL_RETURN_IF_ERROR(expr_->Accept(&expr_copy_visitor));
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ResolvedExpr> expr_copy,
+                   expr_copy_visitor.ConsumeRootNode<ResolvedExpr>());
+
+  std::vector<std::unique_ptr<const ResolvedComputedColumn>>
+      aggregate_expr_list_copy;
+  for (const auto& computed_column : aggregate_expression_list_) {
+    ResolvedASTDeepCopyVisitor column_copy_visitor;
+    ZETASQL_RETURN_IF_ERROR(computed_column->Accept(&column_copy_visitor));
+    ZETASQL_ASSIGN_OR_RETURN(
+        std::unique_ptr<ResolvedComputedColumn> column_copy,
+        column_copy_visitor.ConsumeRootNode<ResolvedComputedColumn>());
+    aggregate_expr_list_copy.push_back(std::move(column_copy));
+  }
+  *copy = absl::make_unique<TemplatedSQLFunctionCall>(
+      std::move(expr_copy), std::move(aggregate_expr_list_copy));
+  return ::zetasql_base::OkStatus();
+}
+
 TemplatedSQLFunctionCall::~TemplatedSQLFunctionCall() {
   delete expr_;
 }
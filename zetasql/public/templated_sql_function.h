@@ -25,6 +25,9 @@
 #include "zetasql/public/function.h"
 #include "zetasql/public/parse_resume_location.h"
 #include "zetasql/public/type.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
 #include "zetasql/base/status.h"
 
 // This file includes interfaces and classes related to templated SQL
@@ -38,6 +41,7 @@ namespace zetasql {
 class FunctionProto;
 class ResolvedComputedColumn;
 class ResolvedExpr;
+class TemplatedSQLFunctionCall;
 
 // This represents a templated function with a SQL body.
 //
@@ -104,6 +108,26 @@ class TemplatedSQLFunction : public Function {
     return parse_resume_location_;
   }
 
+  // If true, the resolver caches the resolved function body for each list of
+  // concrete argument types it is called with, so repeated calls only copy
+  // the cached body instead of parsing and resolving it again.  Off by
+  // default.  Only enable this if every Catalog and TypeFactory used to
+  // resolve calls to this function outlives it, and if the catalogs do not
+  // change in ways that affect the function body.
+  void set_cache_resolved_calls(bool value) { cache_resolved_calls_ = value; }
+  bool cache_resolved_calls() const { return cache_resolved_calls_; }
+
+  // Returns the call cached under <key> by AddCachedCall(), or NULL.
+  // <key> is opaque to this class; the resolver builds it from everything
+  // that affects resolution of the body.
+  std::shared_ptr<const TemplatedSQLFunctionCall> FindCachedCall(
+      const std::string& key) const LOCKS_EXCLUDED(cache_mutex_);
+
+  // Caches <call> under <key>, unless a call is already cached there.
+  void AddCachedCall(const std::string& key,
+                     std::shared_ptr<const TemplatedSQLFunctionCall> call) const
+      LOCKS_EXCLUDED(cache_mutex_);
+
  private:
   // If non-NULL, this Catalog is used to override the catalog when the
   // resolver runs.
@@ -120,6 +144,13 @@ class TemplatedSQLFunction : public Function {
   // statement begins.  This allows the TemplatedSQLFunction to get access
   // to the SQL function body from the <parse_resume_location_> when needed.
   ParseResumeLocation parse_resume_location_;
+
+  bool cache_resolved_calls_ = false;
+
+  mutable absl::Mutex cache_mutex_;
+  mutable absl::flat_hash_map<std::string,
+                              std::shared_ptr<const TemplatedSQLFunctionCall>>
+      cached_calls_ GUARDED_BY(cache_mutex_);
 };
 
 // This is the context for a specific call to a templated SQL function. It
@@ -154,6 +185,9 @@ class TemplatedSQLFunctionCall : public ResolvedFunctionCallInfo {
 
   std::string DebugString() const override;
 
+  // Returns a deep copy of this call.
+  zetasql_base::Status Copy(std::unique_ptr<TemplatedSQLFunctionCall>* copy) const;
+
  private:
   const ResolvedExpr* const expr_;  // Owned
   std::vector<std::unique_ptr<const ResolvedComputedColumn>>
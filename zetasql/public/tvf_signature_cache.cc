@@ -0,0 +1,118 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/tvf_signature_cache.h"
+
+#include <memory>
+#include <string>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include "zetasql/proto/options.pb.h"
+#include "zetasql/public/input_argument_type.h"
+#include "zetasql/public/value.h"
+#include "absl/strings/str_cat.h"
+#include "zetasql/base/status.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+namespace {
+
+// Appends <str> to <*key>, prefixed with its length so that keys of
+// different parts cannot collide.
+void AppendString(const std::string& str, std::string* key) {
+  absl::StrAppend(key, str.size(), ":", str);
+}
+
+}  // namespace
+
+TVFSignatureCache::TVFSignatureCache(int max_entries) : cache_(max_entries) {}
+
+TVFSignatureCache::~TVFSignatureCache() {}
+
+std::string TVFSignatureCache::MakeKey(
+    const TableValuedFunction& tvf, const LanguageOptions& language_options,
+    const std::vector<TVFInputArgumentType>& actual_arguments,
+    const FunctionSignature& concrete_signature, const Catalog* catalog,
+    const TypeFactory* type_factory) {
+  std::string key = absl::StrCat(absl::Hex(&tvf), ",", absl::Hex(catalog),
+                                 ",", absl::Hex(type_factory), ";");
+  LanguageOptionsProto language_options_proto;
+  language_options.Serialize(&language_options_proto);
+  AppendString(language_options_proto.SerializeAsString(), &key);
+  AppendString(concrete_signature.DebugString(/*function_name=*/"",
+                                              /*verbose=*/true),
+               &key);
+  for (const TVFInputArgumentType& argument : actual_arguments) {
+    if (argument.is_relation()) {
+      const TVFRelation& relation = argument.relation();
+      absl::StrAppend(&key, relation.is_value_table() ? "V" : "R",
+                      relation.num_columns(), "(");
+      for (const TVFRelation::Column& column : relation.columns()) {
+        AppendString(column.name, &key);
+        absl::StrAppend(&key, absl::Hex(column.type),
+                        column.is_pseudo_column ? "P" : "", ",");
+      }
+      absl::StrAppend(&key, ")");
+    } else if (argument.is_model()) {
+      absl::StrAppend(&key, "M", absl::Hex(argument.model().model()), ",");
+    } else {
+      const InputArgumentType scalar =
+          argument.GetScalarArgType().ValueOrDie();
+      absl::StrAppend(&key, "S", absl::Hex(scalar.type()));
+      if (scalar.literal_value() != nullptr) {
+        absl::StrAppend(&key, "=");
+        AppendString(scalar.literal_value()->FullDebugString(), &key);
+      }
+      absl::StrAppend(&key, ",");
+    }
+  }
+  return key;
+}
+
+zetasql_base::Status TVFSignatureCache::Resolve(
+    const TableValuedFunction& tvf, const AnalyzerOptions* analyzer_options,
+    const LanguageOptions& language_options,
+    const std::vector<TVFInputArgumentType>& actual_arguments,
+    const FunctionSignature& concrete_signature, Catalog* catalog,
+    TypeFactory* type_factory,
+    std::shared_ptr<TVFSignature>* output_tvf_signature) {
+  const std::string key =
+      MakeKey(tvf, language_options, actual_arguments, concrete_signature,
+              catalog, type_factory);
+  std::shared_ptr<const Entry> entry;
+  if (cache_.Lookup(key, &entry)) {
+    // The cached signature may hold arguments of another call, e.g. with the
+    // scalar expressions of its analysis, so make one for this call.
+    *output_tvf_signature = std::make_shared<TVFSignature>(
+        actual_arguments, entry->result_schema, entry->options);
+    return ::zetasql_base::OkStatus();
+  }
+  // Resolve outside of the cache lock.
+  ZETASQL_RETURN_IF_ERROR(tvf.Resolve(analyzer_options, actual_arguments,
+                              concrete_signature, catalog, type_factory,
+                              output_tvf_signature));
+  const TVFSignature* signature = output_tvf_signature->get();
+  if (signature != nullptr && typeid(*signature) == typeid(TVFSignature)) {
+    cache_.Insert(key, std::shared_ptr<const Entry>(new Entry{
+                           signature->result_schema(), signature->options()}));
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+}  // namespace zetasql
@@ -0,0 +1,102 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_PUBLIC_TVF_SIGNATURE_CACHE_H_
+#define ZETASQL_PUBLIC_TVF_SIGNATURE_CACHE_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/common/lru_cache.h"
+#include "zetasql/public/catalog.h"
+#include "zetasql/public/function_signature.h"
+#include "zetasql/public/language_options.h"
+#include "zetasql/public/table_valued_function.h"
+#include "zetasql/public/type.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+
+class AnalyzerOptions;
+
+// A thread-safe, size-bounded LRU cache of the output schemas computed by
+// TableValuedFunction::Resolve(), shared between analyses through
+// AnalyzerOptions::set_tvf_signature_cache().
+//
+// TVFs with relation arguments compute their output schema for each call,
+// which can be expensive, e.g. when it calls a remote service.  Entries
+// are keyed by the TVF, the types and literal values of the scalar
+// arguments, the column names and types of the relation arguments, the
+// models, the concrete signature, the LanguageOptions, the Catalog and the
+// TypeFactory.  Types are compared by identity, so the same tables give
+// the same keys.
+//
+// Resolve() must return the same schema whenever these are the same, which
+// holds for FixedOutputSchemaTVF, ForwardInputSchemaToOutputSchemaTVF and
+// TVFs that only look at their arguments.  Objects found through the
+// catalog must not change in ways that change the schemas while the cache
+// is in use.  The Catalog, the TypeFactory and the types of the arguments
+// must outlive the entries made with them.
+//
+// Only signatures of class TVFSignature are cached; subclasses, which
+// engines use to carry more information about a call, are not.  Errors are
+// not cached.
+class TVFSignatureCache {
+ public:
+  // <max_entries> must be positive.
+  explicit TVFSignatureCache(int max_entries);
+  TVFSignatureCache(const TVFSignatureCache&) = delete;
+  TVFSignatureCache& operator=(const TVFSignatureCache&) = delete;
+  ~TVFSignatureCache();
+
+  // Same as tvf.Resolve() with the other arguments, but may return a new
+  // TVFSignature of <actual_arguments> with the schema of an earlier call.
+  // <language_options> must be those of <*analyzer_options>.
+  zetasql_base::Status Resolve(
+      const TableValuedFunction& tvf, const AnalyzerOptions* analyzer_options,
+      const LanguageOptions& language_options,
+      const std::vector<TVFInputArgumentType>& actual_arguments,
+      const FunctionSignature& concrete_signature, Catalog* catalog,
+      TypeFactory* type_factory,
+      std::shared_ptr<TVFSignature>* output_tvf_signature);
+
+  // Removes all entries.
+  void Clear() { cache_.Clear(); }
+
+  int max_entries() const { return cache_.max_entries(); }
+  int size() const { return cache_.size(); }
+  LruCacheStats stats() const { return cache_.stats(); }
+
+ private:
+  struct Entry {
+    TVFRelation result_schema;
+    TVFSignatureOptions options;
+  };
+
+  // Returns the cache key for the call.
+  static std::string MakeKey(
+      const TableValuedFunction& tvf, const LanguageOptions& language_options,
+      const std::vector<TVFInputArgumentType>& actual_arguments,
+      const FunctionSignature& concrete_signature, const Catalog* catalog,
+      const TypeFactory* type_factory);
+
+  LruCache<std::string, std::shared_ptr<const Entry>> cache_;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_TVF_SIGNATURE_CACHE_H_
@@ -0,0 +1,154 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/tvf_signature_cache.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/analyzer.h"
+#include "zetasql/public/function_signature.h"
+#include "zetasql/public/language_options.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/table_valued_function.h"
+#include "zetasql/public/type.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace zetasql {
+
+namespace {
+
+// Forwards its input schema, and counts the calls to Resolve().
+class CountingTVF : public ForwardInputSchemaToOutputSchemaTVF {
+ public:
+  CountingTVF()
+      : ForwardInputSchemaToOutputSchemaTVF(
+            {"counting_tvf"},
+            FunctionSignature(ARG_TYPE_RELATION,
+                              {FunctionArgumentType::AnyRelation(),
+                               FunctionArgumentType(types::Int64Type())},
+                              /*context_id=*/int64_t{0})) {}
+
+  zetasql_base::Status Resolve(
+      const AnalyzerOptions* analyzer_options,
+      const std::vector<TVFInputArgumentType>& actual_arguments,
+      const FunctionSignature& concrete_signature, Catalog* catalog,
+      TypeFactory* type_factory,
+      std::shared_ptr<TVFSignature>* output_tvf_signature) const override {
+    ++num_calls_;
+    return ForwardInputSchemaToOutputSchemaTVF::Resolve(
+        analyzer_options, actual_arguments, concrete_signature, catalog,
+        type_factory, output_tvf_signature);
+  }
+
+  int num_calls() const { return num_calls_; }
+
+ private:
+  mutable int num_calls_ = 0;
+};
+
+}  // namespace
+
+class TVFSignatureCacheTest : public ::testing::Test {
+ protected:
+  TVFSignatureCacheTest() : catalog_("catalog", &type_factory_) {
+    catalog_.AddZetaSQLFunctions();
+    catalog_.AddOwnedTable(
+        new SimpleTable("T", {{"a", types::Int64Type()},
+                              {"b", types::StringType()}}));
+    tvf_ = new CountingTVF;
+    catalog_.AddOwnedTableValuedFunction(tvf_);
+    options_.mutable_language()->EnableLanguageFeature(
+        FEATURE_TABLE_VALUED_FUNCTIONS);
+    options_.set_tvf_signature_cache(&cache_);
+  }
+
+  zetasql_base::Status Analyze(const std::string& sql) {
+    std::unique_ptr<const AnalyzerOutput> output;
+    return AnalyzeStatement(sql, options_, &catalog_, &type_factory_,
+                            &output);
+  }
+
+  TypeFactory type_factory_;
+  SimpleCatalog catalog_;
+  CountingTVF* tvf_;  // Owned by <catalog_>.
+  TVFSignatureCache cache_{/*max_entries=*/10};
+  AnalyzerOptions options_;
+};
+
+TEST_F(TVFSignatureCacheTest, SharedBetweenAnalyses) {
+  ZETASQL_ASSERT_OK(Analyze("SELECT a FROM counting_tvf(TABLE T, 1)"));
+  ZETASQL_ASSERT_OK(
+      Analyze("SELECT b FROM counting_tvf(TABLE T, 1) WHERE a > 0"));
+  ZETASQL_ASSERT_OK(
+      Analyze("SELECT * FROM counting_tvf((SELECT a, b FROM T), 1)"));
+  EXPECT_EQ(1, tvf_->num_calls());
+  EXPECT_EQ(1, cache_.size());
+  EXPECT_EQ(2, cache_.stats().hits);
+
+  // Other input schemas and literals are resolved again.
+  ZETASQL_ASSERT_OK(
+      Analyze("SELECT b FROM counting_tvf((SELECT b FROM T), 1)"));
+  ZETASQL_ASSERT_OK(
+      Analyze("SELECT x FROM counting_tvf((SELECT a AS x, b FROM T), 1)"));
+  ZETASQL_ASSERT_OK(Analyze("SELECT a FROM counting_tvf(TABLE T, 2)"));
+  EXPECT_EQ(4, tvf_->num_calls());
+  EXPECT_EQ(4, cache_.size());
+
+  // Errors of the query around the call do not affect the cache.
+  EXPECT_THAT(Analyze("SELECT c FROM counting_tvf(TABLE T, 1)"),
+              zetasql_base::testing::StatusIs(
+                  zetasql_base::StatusCode::kInvalidArgument));
+  EXPECT_EQ(4, tvf_->num_calls());
+
+  // Without the cache, every call is resolved.
+  options_.set_tvf_signature_cache(nullptr);
+  ZETASQL_ASSERT_OK(Analyze("SELECT a FROM counting_tvf(TABLE T, 1)"));
+  EXPECT_EQ(5, tvf_->num_calls());
+}
+
+TEST_F(TVFSignatureCacheTest, SignatureHasTheArgumentsOfTheCall) {
+  const std::vector<TVFInputArgumentType> arguments = {
+      TVFInputArgumentType(TVFRelation({{"a", types::Int64Type()}})),
+      TVFInputArgumentType(InputArgumentType(types::Int64Type()))};
+  const FunctionSignature& signature = *tvf_->GetSignature(0);
+  std::shared_ptr<TVFSignature> first;
+  ZETASQL_ASSERT_OK(cache_.Resolve(*tvf_, &options_, options_.language(),
+                           arguments, signature, &catalog_, &type_factory_,
+                           &first));
+  std::shared_ptr<TVFSignature> second;
+  ZETASQL_ASSERT_OK(cache_.Resolve(*tvf_, &options_, options_.language(),
+                           arguments, signature, &catalog_, &type_factory_,
+                           &second));
+  EXPECT_EQ(1, tvf_->num_calls());
+  EXPECT_NE(first.get(), second.get());
+  EXPECT_EQ(first->DebugString(), second->DebugString());
+  EXPECT_EQ(2, second->input_arguments().size());
+
+  // Another TypeFactory, whose types the schema could refer to, misses.
+  TypeFactory other_type_factory;
+  ZETASQL_ASSERT_OK(cache_.Resolve(*tvf_, &options_, options_.language(),
+                           arguments, signature, &catalog_,
+                           &other_type_factory, &second));
+  EXPECT_EQ(2, tvf_->num_calls());
+}
+
+}  // namespace zetasql
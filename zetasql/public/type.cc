@@ -19,6 +19,8 @@
 #include <stdlib.h>
 #include <algorithm>
 #include <limits>
+#include <tuple>
+#include <utility>
 
 #include "zetasql/base/logging.h"
 #include "google/protobuf/descriptor.pb.h"
@@ -36,6 +38,8 @@
 #include <cstdint>
 #include "absl/base/macros.h"
 #include "absl/base/optimization.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/hash/hash.h"
 #include "absl/memory/memory.h"
 #include "zetasql/base/case.h"
 #include "absl/strings/match.h"
@@ -203,8 +207,99 @@ static const std::set<TypeKind>& GetExternalModeSimpleTypeKinds() {
   return *kExternalModeSimpleTypeKinds;
 }
 
+namespace {
+
+// The number of feature set indexes of Type::FeatureSetIndex(), and the mask
+// of all of them.
+constexpr int kNumFeatureSets = 16;
+constexpr uint16_t kAllFeatureSets = (1 << kNumFeatureSets) - 1;
+
+// Returns the feature set indexes that have <feature_set_bit>.
+constexpr uint16_t FeatureSetsWith(int feature_set_bit) {
+  uint16_t mask = 0;
+  for (int i = 0; i < kNumFeatureSets; ++i) {
+    if ((i & feature_set_bit) != 0) mask |= 1 << i;
+  }
+  return mask;
+}
+
+bool HasFeatureSet(uint16_t mask, int feature_set_index) {
+  return ((mask >> feature_set_index) & 1) != 0;
+}
+
+}  // namespace
+
 Type::Type(const TypeFactory* factory, TypeKind kind)
-    : type_factory_(factory), kind_(kind) {
+    : grouping_mask_(kAllFeatureSets),
+      partitioning_mask_(kAllFeatureSets),
+      equality_mask_(kAllFeatureSets),
+      type_factory_(factory),
+      kind_(kind) {
+  // These match SupportsGroupingImpl(), SupportsPartitioningImpl() and
+  // SupportsEquality() of the non-ARRAY, non-STRUCT types.
+  switch (kind) {
+    case TYPE_GEOGRAPHY:
+      grouping_mask_ = 0;
+      partitioning_mask_ = 0;
+      equality_mask_ = 0;
+      break;
+    case TYPE_FLOAT:
+    case TYPE_DOUBLE:
+      grouping_mask_ = kAllFeatureSets &
+                       ~FeatureSetsWith(kDisallowGroupByFloatBit);
+      partitioning_mask_ = 0;
+      break;
+    case TYPE_PROTO:
+      grouping_mask_ = 0;
+      partitioning_mask_ = 0;
+      equality_mask_ = 0;
+      break;
+    default:
+      break;
+  }
+}
+
+// static
+int Type::FeatureSetIndex(const LanguageOptions& language_options) {
+  int index = 0;
+  if (language_options.LanguageFeatureEnabled(
+          FEATURE_DISALLOW_GROUP_BY_FLOAT)) {
+    index |= kDisallowGroupByFloatBit;
+  }
+  if (language_options.LanguageFeatureEnabled(FEATURE_V_1_2_GROUP_BY_ARRAY)) {
+    index |= kGroupByArrayBit;
+  }
+  if (language_options.LanguageFeatureEnabled(FEATURE_V_1_2_GROUP_BY_STRUCT)) {
+    index |= kGroupByStructBit;
+  }
+  if (language_options.LanguageFeatureEnabled(FEATURE_V_1_1_ARRAY_EQUALITY)) {
+    index |= kArrayEqualityBit;
+  }
+  return index;
+}
+
+// static
+int Type::NameCache::TypeNameEntry(ProductMode mode) {
+  switch (mode) {
+    case PRODUCT_INTERNAL:
+      return kTypeNameInternal;
+    case PRODUCT_EXTERNAL:
+      return kTypeNameExternal;
+    default:
+      return -1;
+  }
+}
+
+// static
+int Type::NameCache::ShortTypeNameEntry(ProductMode mode) {
+  switch (mode) {
+    case PRODUCT_INTERNAL:
+      return kShortTypeNameInternal;
+    case PRODUCT_EXTERNAL:
+      return kShortTypeNameExternal;
+    default:
+      return -1;
+  }
 }
 
 Type::~Type() {
@@ -514,6 +609,13 @@ bool Type::HasAnyFields() const {
 
 bool Type::SupportsGrouping(const LanguageOptions& language_options,
                             std::string* type_description) const {
+  if (HasFeatureSet(grouping_mask_, FeatureSetIndex(language_options))) {
+    return true;
+  }
+  if (type_description == nullptr) {
+    return false;
+  }
+  // Find the contained type that does not support grouping.
   const Type* no_grouping_type;
   const bool supports_grouping =
       this->SupportsGroupingImpl(language_options, &no_grouping_type);
@@ -546,6 +648,13 @@ bool Type::SupportsGroupingImpl(const LanguageOptions& language_options,
 
 bool Type::SupportsPartitioning(const LanguageOptions& language_options,
                                 std::string* type_description) const {
+  if (HasFeatureSet(partitioning_mask_, FeatureSetIndex(language_options))) {
+    return true;
+  }
+  if (type_description == nullptr) {
+    return false;
+  }
+  // Find the contained type that does not support partitioning.
   const Type* no_partitioning_type;
   const bool supports_partitioning =
       this->SupportsPartitioningImpl(language_options, &no_partitioning_type);
@@ -591,27 +700,11 @@ bool Type::SupportsOrdering() const {
 }
 
 // Array type equality support is controlled by the language option
-// FEATURE_V_1_1_ARRAY_EQUALITY. To test if 'type' supports equality,
-// checks the type recursively as array types can be nested under
-// struct types or vice versa.
+// FEATURE_V_1_1_ARRAY_EQUALITY.  Array types can be nested under struct
+// types or vice versa, which <equality_mask_> accounts for.
 bool Type::SupportsEquality(
     const LanguageOptions& language_options) const {
-  if (this->IsArray()) {
-    if (language_options.LanguageFeatureEnabled(FEATURE_V_1_1_ARRAY_EQUALITY)) {
-      return this->AsArray()->element_type()->SupportsEquality(
-          language_options);
-    } else {
-      return false;
-    }
-  } else if (this->IsStruct()) {
-    for (const StructField& field : this->AsStruct()->fields()) {
-      if (!field.type->SupportsEquality(language_options)) {
-        return false;
-      }
-    }
-    return true;
-  }
-  return this->SupportsEquality();
+  return HasFeatureSet(equality_mask_, FeatureSetIndex(language_options));
 }
 
 static int64_t FileDescriptorSetMapTotalSize(
@@ -643,6 +736,10 @@ static zetasql_base::Status PopulateDistinctFileDescriptorSets(
     file_descriptor_entry->descriptor_set_index =
         file_descriptor_set_map->size() - 1;
   }
+  *file_descriptor_set_index = file_descriptor_entry->descriptor_set_index;
+  if (file_descriptor_entry->file_descriptors_known_to_reader) {
+    return zetasql_base::OkStatus();
+  }
   absl::optional<int64_t> this_file_descriptor_set_max_size;
   if (file_descriptor_sets_max_size_bytes.has_value()) {
     const int64_t map_total_size =
@@ -655,7 +752,6 @@ static zetasql_base::Status PopulateDistinctFileDescriptorSets(
       file_descr, this_file_descriptor_set_max_size,
       &file_descriptor_entry->file_descriptor_set,
       &file_descriptor_entry->file_descriptors));
-  *file_descriptor_set_index = file_descriptor_entry->descriptor_set_index;
   return zetasql_base::OkStatus();
 }
 
@@ -688,6 +784,12 @@ ArrayType::ArrayType(const TypeFactory* factory, const Type* element_type)
     : Type(factory, TYPE_ARRAY),
       element_type_(element_type) {
   CHECK(!element_type->IsArray());  // Blocked in MakeArrayType.
+  grouping_mask_ =
+      element_type->grouping_mask_ & FeatureSetsWith(kGroupByArrayBit);
+  partitioning_mask_ =
+      element_type->partitioning_mask_ & FeatureSetsWith(kGroupByArrayBit);
+  equality_mask_ =
+      element_type->equality_mask_ & FeatureSetsWith(kArrayEqualityBit);
 }
 
 ArrayType::~ArrayType() {
@@ -721,7 +823,8 @@ bool ArrayType::SupportsOrdering(const LanguageOptions& language_options,
 }
 
 bool ArrayType::SupportsEquality() const {
-  return element_type()->SupportsEquality();
+  // Without a LanguageOptions, arrays are comparable if their elements are.
+  return HasFeatureSet(equality_mask_, kArrayEqualityBit);
 }
 
 bool ArrayType::SupportsGroupingImpl(const LanguageOptions& language_options,
@@ -774,14 +877,33 @@ zetasql_base::Status ArrayType::SerializeToProtoAndDistinctFileDescriptorsImpl(
 }
 
 std::string ArrayType::ShortTypeName(ProductMode mode) const {
-  return absl::StrCat("ARRAY<", element_type_->ShortTypeName(mode), ">");
+  const int entry = NameCache::ShortTypeNameEntry(mode);
+  if (entry < 0) return ComputeShortTypeName(mode);
+  return name_cache_.Get(entry, [&] { return ComputeShortTypeName(mode); });
 }
 
 std::string ArrayType::TypeName(ProductMode mode) const {
-  return absl::StrCat("ARRAY<", element_type_->TypeName(mode), ">");
+  const int entry = NameCache::TypeNameEntry(mode);
+  if (entry < 0) return ComputeTypeName(mode);
+  return name_cache_.Get(entry, [&] { return ComputeTypeName(mode); });
 }
 
 std::string ArrayType::DebugString(bool details) const {
+  // Details include whole proto descriptors, and are not cached.
+  if (details) return ComputeDebugString(details);
+  return name_cache_.Get(NameCache::kDebugString,
+                         [&] { return ComputeDebugString(details); });
+}
+
+std::string ArrayType::ComputeShortTypeName(ProductMode mode) const {
+  return absl::StrCat("ARRAY<", element_type_->ShortTypeName(mode), ">");
+}
+
+std::string ArrayType::ComputeTypeName(ProductMode mode) const {
+  return absl::StrCat("ARRAY<", element_type_->TypeName(mode), ">");
+}
+
+std::string ArrayType::ComputeDebugString(bool details) const {
   return absl::StrCat("ARRAY<", element_type_->DebugString(details), ">");
 }
 
@@ -789,7 +911,15 @@ StructType::StructType(const TypeFactory* factory,
                        std::vector<StructField> fields, int nesting_depth)
     : Type(factory, TYPE_STRUCT),
       fields_(std::move(fields)),
-      nesting_depth_(nesting_depth) {}
+      nesting_depth_(nesting_depth) {
+  grouping_mask_ = FeatureSetsWith(kGroupByStructBit);
+  partitioning_mask_ = FeatureSetsWith(kGroupByStructBit);
+  for (const StructField& field : fields_) {
+    grouping_mask_ &= field.type->grouping_mask_;
+    partitioning_mask_ &= field.type->partitioning_mask_;
+    equality_mask_ &= field.type->equality_mask_;
+  }
+}
 
 bool StructType::SupportsGroupingImpl(const LanguageOptions& language_options,
                                       const Type** no_grouping_type) const {
@@ -838,12 +968,9 @@ bool StructType::SupportsOrdering(const LanguageOptions& language_options,
 }
 
 bool StructType::SupportsEquality() const {
-  for (const StructField& field : fields_) {
-    if (!field.type->SupportsEquality()) {
-      return false;
-    }
-  }
-  return true;
+  // Without a LanguageOptions, arrays in the fields are comparable if their
+  // elements are.
+  return HasFeatureSet(equality_mask_, kArrayEqualityBit);
 }
 
 bool StructType::UsingFeatureV12CivilTimeType() const {
@@ -900,6 +1027,25 @@ std::string StructType::DebugStringImpl(
 }
 
 std::string StructType::ShortTypeName(ProductMode mode) const {
+  const int entry = NameCache::ShortTypeNameEntry(mode);
+  if (entry < 0) return ComputeShortTypeName(mode);
+  return name_cache_.Get(entry, [&] { return ComputeShortTypeName(mode); });
+}
+
+std::string StructType::TypeName(ProductMode mode) const {
+  const int entry = NameCache::TypeNameEntry(mode);
+  if (entry < 0) return ComputeTypeName(mode);
+  return name_cache_.Get(entry, [&] { return ComputeTypeName(mode); });
+}
+
+std::string StructType::DebugString(bool details) const {
+  // Details include whole proto descriptors, and are not cached.
+  if (details) return ComputeDebugString(details);
+  return name_cache_.Get(NameCache::kDebugString,
+                         [&] { return ComputeDebugString(details); });
+}
+
+std::string StructType::ComputeShortTypeName(ProductMode mode) const {
   // Limit the output to three struct fields to avoid long error messages.
   const int field_limit = 3;
   const auto field_debug_fn = [=](const zetasql::Type* type) {
@@ -908,14 +1054,14 @@ std::string StructType::ShortTypeName(ProductMode mode) const {
   return DebugStringImpl(field_limit, field_debug_fn);
 }
 
-std::string StructType::TypeName(ProductMode mode) const {
+std::string StructType::ComputeTypeName(ProductMode mode) const {
   const auto field_debug_fn = [=](const zetasql::Type* type) {
     return type->TypeName(mode);
   };
   return DebugStringImpl(std::numeric_limits<int>::max(), field_debug_fn);
 }
 
-std::string StructType::DebugString(bool details) const {
+std::string StructType::ComputeDebugString(bool details) const {
   const auto field_debug_fn = [=](const zetasql::Type* type) {
     return type->DebugString(details);
   };
@@ -923,6 +1069,18 @@ std::string StructType::DebugString(bool details) const {
   return DebugStringImpl(std::numeric_limits<int>::max(), field_debug_fn);
 }
 
+int StructType::FindFieldIndexLinear(absl::string_view name) const {
+  int found_index = -2;
+  for (int i = 0; i < num_fields(); ++i) {
+    // Unnamed fields never match, since <name> is not empty.
+    if (zetasql_base::CaseEqual(field(i).name, name)) {
+      if (found_index != -2) return -1;
+      found_index = i;
+    }
+  }
+  return found_index;
+}
+
 const StructType::StructField* StructType::FindField(
     const std::string& name, bool* is_ambiguous, int* found_idx) const {
   *is_ambiguous = false;
@@ -934,9 +1092,12 @@ const StructType::StructField* StructType::FindField(
   }
 
   int field_index;
-  {
-    absl::MutexLock lock(&mutex_);
-    if (ABSL_PREDICT_FALSE(field_name_to_index_map_.empty())) {
+  if (num_fields() <= kMaxFieldsForLinearFindField) {
+    field_index = FindFieldIndexLinear(name);
+    if (field_index == -2) return nullptr;
+  } else {
+    absl::call_once(field_name_to_index_map_once_, [this]() {
+      field_name_to_index_map_.reserve(num_fields());
       for (int i = 0; i < num_fields(); ++i) {
         const std::string& field_name = field(i).name;
         // Empty names indicate unnamed fields, not fields which can be looked
@@ -948,7 +1109,7 @@ const StructType::StructField* StructType::FindField(
           if (!result.second) result.first->second = -1;
         }
       }
-    }
+    });
     const auto iter = field_name_to_index_map_.find(name);
     if (ABSL_PREDICT_FALSE(iter == field_name_to_index_map_.end())) {
       return nullptr;
@@ -1046,7 +1207,10 @@ zetasql_base::Status ProtoType::GetFieldTypeByName(const std::string& name,
 }
 
 std::string ProtoType::TypeName() const {
-  return ToIdentifierLiteral(descriptor_->full_name());
+  absl::call_once(type_name_once_, [this] {
+    type_name_ = ToIdentifierLiteral(descriptor_->full_name());
+  });
+  return type_name_;
 }
 
 std::string ProtoType::ShortTypeName(ProductMode mode_unused) const {
@@ -1341,7 +1505,10 @@ zetasql_base::Status EnumType::SerializeToProtoAndDistinctFileDescriptorsImpl(
 }
 
 std::string EnumType::TypeName() const {
-  return ToIdentifierLiteral(enum_descriptor_->full_name());
+  absl::call_once(type_name_once_, [this] {
+    type_name_ = ToIdentifierLiteral(enum_descriptor_->full_name());
+  });
+  return type_name_;
 }
 
 std::string EnumType::ShortTypeName(ProductMode mode_unused) const {
@@ -1486,8 +1653,109 @@ bool TypeEquals::operator()(const Type* const type1,
   return type1->Equals(type2);
 }
 
+namespace {
+
+// Hash and equality for interning StructTypes by their field names and field
+// types.  Field names are compared case-sensitively, since the interned type
+// preserves the spelling of its field names.
+struct StructFieldsHash {
+  using is_transparent = void;
+
+  size_t operator()(absl::Span<const StructType::StructField> fields) const {
+    size_t hash = fields.size();
+    for (const StructType::StructField& field : fields) {
+      hash = absl::Hash<std::tuple<size_t, absl::string_view, const Type*>>()(
+          std::make_tuple(hash, absl::string_view(field.name), field.type));
+    }
+    return hash;
+  }
+  size_t operator()(const StructType* type) const {
+    return (*this)(type->fields());
+  }
+};
+
+struct StructFieldsEqual {
+  using is_transparent = void;
+
+  static absl::Span<const StructType::StructField> Fields(
+      absl::Span<const StructType::StructField> fields) {
+    return fields;
+  }
+  static absl::Span<const StructType::StructField> Fields(
+      const StructType* type) {
+    return type->fields();
+  }
+
+  template <class T1, class T2>
+  bool operator()(const T1& lhs, const T2& rhs) const {
+    const absl::Span<const StructType::StructField> fields1 = Fields(lhs);
+    const absl::Span<const StructType::StructField> fields2 = Fields(rhs);
+    if (fields1.size() != fields2.size()) return false;
+    for (int i = 0; i < fields1.size(); ++i) {
+      if (fields1[i].type != fields2[i].type ||
+          fields1[i].name != fields2[i].name) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+// Returns true if <file> is in the generated DescriptorPool, whose descriptors
+// live until the process exits.
+bool IsInGeneratedPool(const google::protobuf::FileDescriptor* file) {
+  return file->pool() == google::protobuf::DescriptorPool::generated_pool();
+}
+
+// Returns the process-wide TypeFactory that owns the canonical ProtoTypes,
+// EnumTypes and proto field types for descriptors in the generated pool.
+// It is never destroyed, so other factories do not track a dependency on it.
+TypeFactory* GeneratedPoolTypeFactory() {
+  static TypeFactory* factory = new TypeFactory();
+  return factory;
+}
+
+}  // namespace
+
+struct TypeFactory::InternedTypes {
+  static constexpr int kNumShards = 16;
+
+  struct Shard {
+    absl::Mutex mutex;
+    // Keyed by element type.
+    absl::flat_hash_map<const Type*, const ArrayType*> array_types
+        GUARDED_BY(mutex);
+    absl::flat_hash_set<const StructType*, StructFieldsHash, StructFieldsEqual>
+        struct_types GUARDED_BY(mutex);
+    absl::flat_hash_map<const google::protobuf::Descriptor*, const ProtoType*>
+        proto_types GUARDED_BY(mutex);
+    absl::flat_hash_map<const google::protobuf::EnumDescriptor*, const EnumType*>
+        enum_types GUARDED_BY(mutex);
+    // Keyed by field and <ignore_annotations>.  Only used in
+    // GeneratedPoolTypeFactory().
+    absl::flat_hash_map<std::pair<const google::protobuf::FieldDescriptor*, bool>,
+                        const Type*>
+        proto_field_types GUARDED_BY(mutex);
+    // Results of MakeUnwrappedTypeFromProto for messages with
+    // zetasql.is_struct or zetasql.is_wrapper annotations, keyed by message
+    // and <use_obsolete_timestamp>.
+    absl::flat_hash_map<std::pair<const google::protobuf::Descriptor*, bool>,
+                        const Type*>
+        unwrapped_proto_types GUARDED_BY(mutex);
+  };
+
+  Shard* GetShard(size_t hash) {
+    // The low bits select the bucket inside the shard's hash table, so use
+    // the high bits to select the shard.
+    return &shards[(hash >> (sizeof(size_t) * 8 - 4)) % kNumShards];
+  }
+
+  Shard shards[kNumShards];
+};
+
 TypeFactory::TypeFactory()
     : cached_simple_types_(),
+      interned_types_(absl::make_unique<InternedTypes>()),
       nesting_depth_limit_(kDefaultTypeFactoryNestingDepthLimit) {}
 
 TypeFactory::~TypeFactory() {
@@ -1518,16 +1786,14 @@ TypeFactory::~TypeFactory() {
 }
 
 int TypeFactory::nesting_depth_limit() const {
-  absl::MutexLock l(&mutex_);
-  return nesting_depth_limit_;
+  return nesting_depth_limit_.load(std::memory_order_relaxed);
 }
 
 void TypeFactory::set_nesting_depth_limit(int value) {
   // We don't want to have to check the depth for simple types, so a depth of
   // 0 must be allowed.
   DCHECK_GE(value, 0);
-  absl::MutexLock l(&mutex_);
-  nesting_depth_limit_ = value;
+  nesting_depth_limit_.store(value, std::memory_order_relaxed);
 }
 
 template <class TYPE>
@@ -1591,7 +1857,14 @@ zetasql_base::Status TypeFactory::MakeArrayType(
              << "Array type would exceed nesting depth limit of "
              << depth_limit;
     }
-    *result = TakeOwnership(new ArrayType(this, element_type));
+    InternedTypes::Shard* shard =
+        interned_types_->GetShard(absl::Hash<const Type*>()(element_type));
+    absl::MutexLock l(&shard->mutex);
+    const ArrayType*& array_type = shard->array_types[element_type];
+    if (array_type == nullptr) {
+      array_type = TakeOwnership(new ArrayType(this, element_type));
+    }
+    *result = array_type;
     return ::zetasql_base::OkStatus();
   }
 }
@@ -1629,10 +1902,20 @@ zetasql_base::Status TypeFactory::MakeStructTypeFromVector(
     }
     AddDependency(field.type);
   }
+  const absl::Span<const StructType::StructField> field_span(fields);
+  InternedTypes::Shard* shard =
+      interned_types_->GetShard(StructFieldsHash()(field_span));
+  absl::MutexLock l(&shard->mutex);
+  auto it = shard->struct_types.find(field_span);
+  if (it != shard->struct_types.end()) {
+    *result = *it;
+    return ::zetasql_base::OkStatus();
+  }
   // We calculate <max_nesting_depth> in the previous loop. We also need to
   // increment it to take into account the struct itself.
   *result = TakeOwnership(
       new StructType(this, std::move(fields), max_nesting_depth + 1));
+  shard->struct_types.insert(*result);
   return ::zetasql_base::OkStatus();
 }
 
@@ -1644,7 +1927,18 @@ zetasql_base::Status TypeFactory::MakeStructTypeFromVector(
 
 zetasql_base::Status TypeFactory::MakeProtoType(
     const google::protobuf::Descriptor* descriptor, const ProtoType** result) {
-  *result = TakeOwnership(new ProtoType(this, descriptor));
+  TypeFactory* generated_pool_factory = GeneratedPoolTypeFactory();
+  if (this != generated_pool_factory && IsInGeneratedPool(descriptor->file())) {
+    return generated_pool_factory->MakeProtoType(descriptor, result);
+  }
+  InternedTypes::Shard* shard = interned_types_->GetShard(
+      absl::Hash<const google::protobuf::Descriptor*>()(descriptor));
+  absl::MutexLock l(&shard->mutex);
+  const ProtoType*& proto_type = shard->proto_types[descriptor];
+  if (proto_type == nullptr) {
+    proto_type = TakeOwnership(new ProtoType(this, descriptor));
+  }
+  *result = proto_type;
   return ::zetasql_base::OkStatus();
 }
 
@@ -1655,7 +1949,19 @@ zetasql_base::Status TypeFactory::MakeProtoType(
 
 zetasql_base::Status TypeFactory::MakeEnumType(
     const google::protobuf::EnumDescriptor* enum_descriptor, const EnumType** result) {
-  *result = TakeOwnership(new EnumType(this, enum_descriptor));
+  TypeFactory* generated_pool_factory = GeneratedPoolTypeFactory();
+  if (this != generated_pool_factory &&
+      IsInGeneratedPool(enum_descriptor->file())) {
+    return generated_pool_factory->MakeEnumType(enum_descriptor, result);
+  }
+  InternedTypes::Shard* shard = interned_types_->GetShard(
+      absl::Hash<const google::protobuf::EnumDescriptor*>()(enum_descriptor));
+  absl::MutexLock l(&shard->mutex);
+  const EnumType*& enum_type = shard->enum_types[enum_descriptor];
+  if (enum_type == nullptr) {
+    enum_type = TakeOwnership(new EnumType(this, enum_descriptor));
+  }
+  *result = enum_type;
   return ::zetasql_base::OkStatus();
 }
 
@@ -1714,6 +2020,26 @@ zetasql_base::Status TypeFactory::MakeUnwrappedTypeFromProtoImpl(
     const google::protobuf::Descriptor* message, const Type* existing_message_type,
     bool use_obsolete_timestamp, const Type** result_type,
     std::set<const google::protobuf::Descriptor*>* ancestor_messages) {
+  // Annotated messages are unwrapped once per TypeFactory, so tables and
+  // fields that share message types reuse the result. A cached message cannot
+  // be one of 'ancestor_messages': unwrapping it succeeded, so the messages
+  // it contains do not contain it.
+  const bool is_annotated = ProtoType::GetIsWrapperAnnotation(message) ||
+                            ProtoType::GetIsStructAnnotation(message);
+  const auto cache_key = std::make_pair(message, use_obsolete_timestamp);
+  InternedTypes::Shard* shard = nullptr;
+  if (is_annotated) {
+    shard = interned_types_->GetShard(
+        absl::Hash<std::pair<const google::protobuf::Descriptor*, bool>>()(
+            cache_key));
+    absl::MutexLock l(&shard->mutex);
+    const auto it = shard->unwrapped_proto_types.find(cache_key);
+    if (it != shard->unwrapped_proto_types.end()) {
+      *result_type = it->second;
+      return ::zetasql_base::OkStatus();
+    }
+  }
+
   if (!ancestor_messages->insert(message).second) {
     return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
            << "Invalid proto " << message->full_name()
@@ -1779,6 +2105,12 @@ zetasql_base::Status TypeFactory::MakeUnwrappedTypeFromProtoImpl(
   } else {
     return_status = MakeProtoType(message, result_type);
   }
+  if (return_status.ok() && shard != nullptr) {
+    // The lock is not held while unwrapping, since that takes locks on other
+    // shards.  Concurrent misses compute the same interned type.
+    absl::MutexLock l(&shard->mutex);
+    shard->unwrapped_proto_types.emplace(cache_key, *result_type);
+  }
   return return_status;
 }
 
@@ -1840,6 +2172,36 @@ zetasql_base::Status TypeFactory::GetProtoFieldTypeWithKind(
 zetasql_base::Status TypeFactory::GetProtoFieldType(
     bool ignore_annotations, const google::protobuf::FieldDescriptor* field_descr,
     const Type** type) {
+  if (IsInGeneratedPool(field_descr->file())) {
+    // Types of fields in the generated pool are computed once per process.
+    TypeFactory* generated_pool_factory = GeneratedPoolTypeFactory();
+    const auto key = std::make_pair(field_descr, ignore_annotations);
+    InternedTypes::Shard* shard =
+        generated_pool_factory->interned_types_->GetShard(
+            absl::Hash<std::pair<const google::protobuf::FieldDescriptor*, bool>>()(
+                key));
+    {
+      absl::MutexLock l(&shard->mutex);
+      const auto it = shard->proto_field_types.find(key);
+      if (it != shard->proto_field_types.end()) {
+        *type = it->second;
+        return ::zetasql_base::OkStatus();
+      }
+    }
+    // The lock is not held while computing the type, since that takes locks
+    // on other shards.  Concurrent misses compute the same interned type.
+    ZETASQL_RETURN_IF_ERROR(generated_pool_factory->GetProtoFieldTypeUncached(
+        ignore_annotations, field_descr, type));
+    absl::MutexLock l(&shard->mutex);
+    shard->proto_field_types.emplace(key, *type);
+    return ::zetasql_base::OkStatus();
+  }
+  return GetProtoFieldTypeUncached(ignore_annotations, field_descr, type);
+}
+
+zetasql_base::Status TypeFactory::GetProtoFieldTypeUncached(
+    bool ignore_annotations, const google::protobuf::FieldDescriptor* field_descr,
+    const Type** type) {
   TypeKind kind;
   ZETASQL_RETURN_IF_ERROR(ProtoType::FieldDescriptorToTypeKindBase(ignore_annotations,
                                                            field_descr, &kind));
@@ -2367,7 +2729,10 @@ void TypeFactory::AddDependency(const Type* other_type) {
 
   // Do not add a dependency if the other factory is the same as this factory or
   // is the static factory (since the static factory is never destroyed).
-  if (other_factory == this || other_factory == types::s_type_factory) return;
+  if (other_factory == this || other_factory == types::s_type_factory ||
+      other_factory == GeneratedPoolTypeFactory()) {
+    return;
+  }
 
   {
     absl::MutexLock l(&mutex_);
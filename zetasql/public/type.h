@@ -20,6 +20,7 @@
 // TODO Maybe store and re-use the same type object for all identical
 //   struct/array/proto/enum types?
 
+#include <atomic>
 #include <cstddef>
 #include <functional>
 #include <memory>
@@ -34,6 +35,7 @@
 #include "zetasql/public/proto/type_annotation.pb.h"
 #include "zetasql/public/type.pb.h"
 #include "absl/base/attributes.h"
+#include "absl/base/call_once.h"
 #include <cstdint>
 #include "absl/base/macros.h"
 #include "absl/base/thread_annotations.h"
@@ -280,6 +282,10 @@ class Type {
     // DescriptorPool.
     google::protobuf::FileDescriptorSet file_descriptor_set;
     std::set<const google::protobuf::FileDescriptor*> file_descriptors;
+    // If true, the reader of the serialized types already has all the file
+    // descriptors of the pool, e.g. because it sent them, so serialization
+    // only uses <descriptor_set_index> and leaves the others empty.
+    bool file_descriptors_known_to_reader = false;
   };
 
   typedef std::map<const google::protobuf::DescriptorPool*,
@@ -449,6 +455,59 @@ class Type {
       absl::optional<int64_t> file_descriptor_sets_max_size_bytes,
       FileDescriptorSetMap* file_descriptor_set_map) const = 0;
 
+  // The language features that SupportsGrouping(), SupportsPartitioning()
+  // and SupportsEquality(language_options) depend on, as bits of a feature
+  // set index of the masks below.
+  enum FeatureSetBit {
+    kDisallowGroupByFloatBit = 1,
+    kGroupByArrayBit = 2,
+    kGroupByStructBit = 4,
+    kArrayEqualityBit = 8,
+  };
+
+  // Returns the feature set index of <language_options>.
+  static int FeatureSetIndex(const LanguageOptions& language_options);
+
+  // Set of feature set indexes, as a bitmask.
+  typedef uint16_t FeatureSetMask;
+
+  // The feature sets under which this type supports grouping, partitioning
+  // and equality.  Computed at construction, from the element and field
+  // types for ARRAY and STRUCT, so that these checks do not recurse.
+  FeatureSetMask grouping_mask_;
+  FeatureSetMask partitioning_mask_;
+  FeatureSetMask equality_mask_;
+
+  // Names of a type that are built from the names of the types it contains,
+  // each computed once on first use.
+  class NameCache {
+   public:
+    enum Entry {
+      kTypeNameInternal,
+      kTypeNameExternal,
+      kShortTypeNameInternal,
+      kShortTypeNameExternal,
+      kDebugString,
+      kNumEntries,
+    };
+
+    // Returns the entry for the TypeName() or ShortTypeName() of <mode>, or
+    // -1 if there is none.
+    static int TypeNameEntry(ProductMode mode);
+    static int ShortTypeNameEntry(ProductMode mode);
+
+    // Returns entry <entry>, calling <compute>() to get it the first time.
+    template <typename ComputeFn>
+    const std::string& Get(int entry, const ComputeFn& compute) const {
+      absl::call_once(once_[entry], [&] { names_[entry] = compute(); });
+      return names_[entry];
+    }
+
+   private:
+    mutable absl::once_flag once_[kNumEntries];
+    mutable std::string names_[kNumEntries];
+  };
+
   const TypeFactory* type_factory_;  // Used for lifetime checking only.
   const TypeKind kind_;
 
@@ -554,8 +613,15 @@ class ArrayType : public Type {
       absl::optional<int64_t> file_descriptor_sets_max_size_bytes,
       FileDescriptorSetMap* file_descriptor_set_map) const override;
 
+  // Returns the names of the type, without the cache.
+  std::string ComputeShortTypeName(ProductMode mode) const;
+  std::string ComputeTypeName(ProductMode mode) const;
+  std::string ComputeDebugString(bool details) const;
+
   const Type* const element_type_;
 
+  NameCache name_cache_;
+
   friend class TypeFactory;
 };
 
@@ -649,6 +715,11 @@ class StructType : public Type {
       const std::function<std::string(const zetasql::Type*)>&
           field_debug_fn) const;
 
+  // Returns the names of the type, without the cache.
+  std::string ComputeShortTypeName(ProductMode mode) const;
+  std::string ComputeTypeName(ProductMode mode) const;
+  std::string ComputeDebugString(bool details) const;
+
   const std::vector<StructField> fields_;
 
   // The deepest nesting depth in the type tree rooted at this StructType, i.e.,
@@ -657,12 +728,24 @@ class StructType : public Type {
   // This field is not serialized. It is recalculated during deserialization.
   const int nesting_depth_;
 
+  // Structs with at most this many fields are searched linearly by
+  // FindField, without building <field_name_to_index_map_>.
+  static constexpr int kMaxFieldsForLinearFindField = 8;
+
+  // Returns the index of the field named <name>, -1 if the lookup is
+  // ambiguous, or -2 if there is no such field.
+  int FindFieldIndexLinear(absl::string_view name) const;
+
   // Lazily built map from name to struct field index. Ambiguous lookups are
-  // designated with an index of -1. This is only built if FindField is called.
-  mutable absl::Mutex mutex_;
+  // designated with an index of -1. This is only built if FindField is called
+  // on a struct with more than kMaxFieldsForLinearFindField fields, and is
+  // never modified after <field_name_to_index_map_once_> has run.
+  mutable absl::once_flag field_name_to_index_map_once_;
   mutable absl::flat_hash_map<absl::string_view, int, zetasql_base::StringViewCaseHash,
                               zetasql_base::StringViewCaseEqual>
-      field_name_to_index_map_ GUARDED_BY(mutex_);
+      field_name_to_index_map_;
+
+  NameCache name_cache_;
 
   friend class TypeFactory;
 };
@@ -893,6 +976,10 @@ class ProtoType : public Type {
 
   const google::protobuf::Descriptor* descriptor_;  // Not owned.
 
+  // TypeName(), which also is the TypeName() of both modes.
+  mutable absl::once_flag type_name_once_;
+  mutable std::string type_name_;
+
   friend class TypeFactory;
 };
 
@@ -976,6 +1063,10 @@ class EnumType : public Type {
 
   const google::protobuf::EnumDescriptor* enum_descriptor_;  // Not owned.
 
+  // TypeName(), which also is the TypeName() of both modes.
+  mutable absl::once_flag type_name_once_;
+  mutable std::string type_name_;
+
   friend class TypeFactory;
 };
 
@@ -994,6 +1085,17 @@ struct TypeEquals {
 // The TypeFactory may return the same Type object from multiple calls that
 // request equivalent types.
 //
+// Array and struct types are interned: requesting an array type with the same
+// element type, or a struct type with the same field names and field types,
+// returns the same Type object, so those types compare equal by pointer.
+// Interning is sharded, so threads constructing different types concurrently
+// do not contend on a single lock.
+//
+// ProtoTypes and EnumTypes for descriptors in the generated DescriptorPool,
+// and the types of fields of those protos, are shared by all TypeFactories.
+// They are owned by a process-wide TypeFactory that is never destroyed, so
+// they outlive the TypeFactory that returned them.
+//
 // When a compound Type (array or struct) is constructed referring to a Type
 // from a separate TypeFactory, the constructed type may refer to the Type from
 // the separate TypeFactory, so that TypeFactory must outlive this one.
@@ -1171,8 +1273,8 @@ class TypeFactory {
   // it cannot destruct. Use kint32max for no limit. The default value of this
   // field is controlled by FLAGS_zetasql_type_factory_nesting_depth_limit.
   // The limit value must be >= 0.
-  int nesting_depth_limit() const LOCKS_EXCLUDED(mutex_);
-  void set_nesting_depth_limit(int value) LOCKS_EXCLUDED(mutex_);
+  int nesting_depth_limit() const;
+  void set_nesting_depth_limit(int value);
 
  private:
   // Store links to and from TypeFactories that this TypeFactory depends on.
@@ -1190,9 +1292,18 @@ class TypeFactory {
   const TYPE* TakeOwnershipLocked(const TYPE* type)
       EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
+  // Interned array and struct types, defined in type.cc.
+  struct InternedTypes;
+
   // Mark that <other_type>'s factory must outlive <this>.
   void AddDependency(const Type* other_type) LOCKS_EXCLUDED(mutex_);
 
+  // Implementation of GetProtoFieldType above, without the process-wide cache
+  // for fields in the generated pool.
+  zetasql_base::Status GetProtoFieldTypeUncached(
+      bool ignore_annotations, const google::protobuf::FieldDescriptor* field_descr,
+      const Type** type);
+
   // Get the Type for a proto field from its corresponding TypeKind. For
   // repeated fields, <kind> must be the base TypeKind for the field (i.e., the
   // TypeKind of the field, ignoring repeatedness), which can be obtained by
@@ -1222,7 +1333,9 @@ class TypeFactory {
   const Type* cached_simple_types_[TypeKind_ARRAYSIZE] GUARDED_BY(mutex_);
   std::vector<const Type*> owned_types_ GUARDED_BY(mutex_);
 
-  int nesting_depth_limit_ GUARDED_BY(mutex_);
+  const std::unique_ptr<InternedTypes> interned_types_;
+
+  std::atomic<int> nesting_depth_limit_;
 };
 
 namespace types {
@@ -0,0 +1,258 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/type.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/language_options.h"
+#include "zetasql/testdata/test_schema.pb.h"
+#include "google/protobuf/descriptor.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/base/macros.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+
+namespace zetasql {
+
+namespace {
+
+// The language features that grouping, partitioning and equality depend on.
+const LanguageFeature kFeatures[] = {
+    FEATURE_DISALLOW_GROUP_BY_FLOAT, FEATURE_V_1_2_GROUP_BY_ARRAY,
+    FEATURE_V_1_2_GROUP_BY_STRUCT, FEATURE_V_1_1_ARRAY_EQUALITY};
+
+// Returns the LanguageOptions with the features of the bits of <bits>.
+LanguageOptions OptionsWithFeatures(int bits) {
+  LanguageOptions language_options;
+  for (int i = 0; i < ABSL_ARRAYSIZE(kFeatures); ++i) {
+    if ((bits & (1 << i)) != 0) {
+      language_options.EnableLanguageFeature(kFeatures[i]);
+    }
+  }
+  return language_options;
+}
+
+// Recursive definitions of the properties, to compare with.
+bool ExpectedGrouping(const Type* type, const LanguageOptions& options) {
+  if (type->IsArray()) {
+    return options.LanguageFeatureEnabled(FEATURE_V_1_2_GROUP_BY_ARRAY) &&
+           ExpectedGrouping(type->AsArray()->element_type(), options);
+  }
+  if (type->IsStruct()) {
+    if (!options.LanguageFeatureEnabled(FEATURE_V_1_2_GROUP_BY_STRUCT)) {
+      return false;
+    }
+    for (const StructField& field : type->AsStruct()->fields()) {
+      if (!ExpectedGrouping(field.type, options)) return false;
+    }
+    return true;
+  }
+  if (type->IsFloatingPoint()) {
+    return !options.LanguageFeatureEnabled(FEATURE_DISALLOW_GROUP_BY_FLOAT);
+  }
+  return !type->IsGeography() && !type->IsProto();
+}
+
+bool ExpectedPartitioning(const Type* type, const LanguageOptions& options) {
+  if (type->IsArray()) {
+    return options.LanguageFeatureEnabled(FEATURE_V_1_2_GROUP_BY_ARRAY) &&
+           ExpectedPartitioning(type->AsArray()->element_type(), options);
+  }
+  if (type->IsStruct()) {
+    if (!options.LanguageFeatureEnabled(FEATURE_V_1_2_GROUP_BY_STRUCT)) {
+      return false;
+    }
+    for (const StructField& field : type->AsStruct()->fields()) {
+      if (!ExpectedPartitioning(field.type, options)) return false;
+    }
+    return true;
+  }
+  return !type->IsFloatingPoint() && !type->IsGeography() &&
+         !type->IsProto();
+}
+
+bool ExpectedEquality(const Type* type, const LanguageOptions& options) {
+  if (type->IsArray()) {
+    return options.LanguageFeatureEnabled(FEATURE_V_1_1_ARRAY_EQUALITY) &&
+           ExpectedEquality(type->AsArray()->element_type(), options);
+  }
+  if (type->IsStruct()) {
+    for (const StructField& field : type->AsStruct()->fields()) {
+      if (!ExpectedEquality(field.type, options)) return false;
+    }
+    return true;
+  }
+  return !type->IsGeography() && !type->IsProto();
+}
+
+}  // namespace
+
+TEST(TypeTest, GroupingPartitioningAndEqualityOfContainedTypes) {
+  TypeFactory factory;
+  const ProtoType* proto_type;
+  ZETASQL_ASSERT_OK(factory.MakeProtoType(
+      zetasql_test::KitchenSinkPB::descriptor(), &proto_type));
+  const EnumType* enum_type;
+  ZETASQL_ASSERT_OK(factory.MakeEnumType(zetasql_test::TestEnum_descriptor(),
+                                 &enum_type));
+  std::vector<const Type*> types = {
+      types::Int64Type(), types::DoubleType(), types::FloatType(),
+      types::GeographyType(), types::StringType(), proto_type, enum_type};
+  const StructType* empty_struct;
+  ZETASQL_ASSERT_OK(factory.MakeStructType({}, &empty_struct));
+  types.push_back(empty_struct);
+
+  // Arrays and structs of the types, nested a few levels deep.
+  const int num_leaf_types = types.size();
+  for (int depth = 0; depth < 3; ++depth) {
+    const int num_types = types.size();
+    for (int i = 0; i < num_types; ++i) {
+      const StructType* struct_type;
+      ZETASQL_ASSERT_OK(factory.MakeStructType(
+          {{"a", types[i]}, {"b", types[(i + 1) % num_leaf_types]}},
+          &struct_type));
+      types.push_back(struct_type);
+      if (!types[i]->IsArray()) {
+        const ArrayType* array_type;
+        ZETASQL_ASSERT_OK(factory.MakeArrayType(types[i], &array_type));
+        types.push_back(array_type);
+      }
+    }
+  }
+
+  for (int bits = 0; bits < 1 << ABSL_ARRAYSIZE(kFeatures); ++bits) {
+    const LanguageOptions options = OptionsWithFeatures(bits);
+    for (const Type* type : types) {
+      SCOPED_TRACE(absl::StrCat(type->DebugString(), " with features ", bits));
+      EXPECT_EQ(ExpectedGrouping(type, options),
+                type->SupportsGrouping(options));
+      EXPECT_EQ(ExpectedPartitioning(type, options),
+                type->SupportsPartitioning(options));
+      EXPECT_EQ(ExpectedEquality(type, options),
+                type->SupportsEquality(options));
+    }
+  }
+  for (const Type* type : types) {
+    EXPECT_EQ(ExpectedEquality(type, OptionsWithFeatures(8)),
+              type->SupportsEquality())
+        << type->DebugString();
+  }
+}
+
+TEST(TypeTest, DescriptionOfContainedTypeWithoutGrouping) {
+  TypeFactory factory;
+  const ArrayType* array_type;
+  ZETASQL_ASSERT_OK(factory.MakeArrayType(types::DoubleType(), &array_type));
+  const StructType* struct_type;
+  ZETASQL_ASSERT_OK(factory.MakeStructType({{"a", array_type}}, &struct_type));
+
+  LanguageOptions options;
+  options.EnableLanguageFeature(FEATURE_V_1_2_GROUP_BY_ARRAY);
+  options.EnableLanguageFeature(FEATURE_V_1_2_GROUP_BY_STRUCT);
+  std::string description;
+  EXPECT_TRUE(struct_type->SupportsGrouping(options, &description));
+  EXPECT_EQ("", description);
+  EXPECT_FALSE(struct_type->SupportsPartitioning(options, &description));
+  EXPECT_EQ("STRUCT containing DOUBLE", description);
+
+  options.EnableLanguageFeature(FEATURE_DISALLOW_GROUP_BY_FLOAT);
+  EXPECT_FALSE(struct_type->SupportsGrouping(options, &description));
+  EXPECT_EQ("STRUCT containing DOUBLE", description);
+
+  options = LanguageOptions();
+  options.EnableLanguageFeature(FEATURE_V_1_2_GROUP_BY_STRUCT);
+  EXPECT_FALSE(struct_type->SupportsGrouping(options, &description));
+  EXPECT_EQ("STRUCT containing ARRAY", description);
+}
+
+TEST(TypeTest, NamesOfContainedTypes) {
+  TypeFactory factory;
+  const ArrayType* array_type;
+  ZETASQL_ASSERT_OK(factory.MakeArrayType(types::DoubleType(), &array_type));
+  const ProtoType* proto_type;
+  ZETASQL_ASSERT_OK(factory.MakeProtoType(
+      zetasql_test::KitchenSinkPB::descriptor(), &proto_type));
+  const StructType* struct_type;
+  ZETASQL_ASSERT_OK(factory.MakeStructType(
+      {{"a", array_type}, {"", proto_type}, {"c", types::Int32Type()},
+       {"d", types::Int64Type()}},
+      &struct_type));
+
+  // Names are the same when computed again.
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_EQ("ARRAY<DOUBLE>", array_type->TypeName(PRODUCT_INTERNAL));
+    EXPECT_EQ("ARRAY<FLOAT64>", array_type->TypeName(PRODUCT_EXTERNAL));
+    EXPECT_EQ("ARRAY<DOUBLE>", array_type->DebugString());
+    EXPECT_EQ("`zetasql_test.KitchenSinkPB`", proto_type->TypeName());
+    EXPECT_EQ("STRUCT<a ARRAY<DOUBLE>, `zetasql_test.KitchenSinkPB`, "
+              "c INT32, d INT64>",
+              struct_type->TypeName(PRODUCT_INTERNAL));
+    EXPECT_EQ("STRUCT<a ARRAY<FLOAT64>, `zetasql_test.KitchenSinkPB`, "
+              "c INT32, d INT64>",
+              struct_type->TypeName(PRODUCT_EXTERNAL));
+    EXPECT_EQ("STRUCT<a ARRAY<FLOAT64>, zetasql_test.KitchenSinkPB, "
+              "c INT32, ...>",
+              struct_type->ShortTypeName(PRODUCT_EXTERNAL));
+    EXPECT_EQ("STRUCT<a ARRAY<DOUBLE>, PROTO<zetasql_test.KitchenSinkPB>, "
+              "c INT32, d INT64>",
+              struct_type->DebugString());
+  }
+  // Details are not cached.
+  EXPECT_NE(struct_type->DebugString(),
+            struct_type->DebugString(/*details=*/true));
+}
+
+TEST(TypeTest, SerializeWithFileDescriptorsKnownToReader) {
+  TypeFactory factory;
+  const ProtoType* proto_type;
+  ZETASQL_ASSERT_OK(factory.MakeProtoType(
+      zetasql_test::KitchenSinkPB::descriptor(), &proto_type));
+
+  FileDescriptorSetMap file_descriptor_set_map;
+  TypeProto type_proto;
+  ZETASQL_ASSERT_OK(proto_type->SerializeToProtoAndDistinctFileDescriptors(
+      &type_proto, &file_descriptor_set_map));
+  ASSERT_EQ(1, file_descriptor_set_map.size());
+  EXPECT_GT(file_descriptor_set_map.begin()
+                ->second->file_descriptor_set.file_size(),
+            0);
+
+  // The pool of the reader, at index 1, is not serialized again.
+  const google::protobuf::DescriptorPool other_pool;
+  file_descriptor_set_map.clear();
+  file_descriptor_set_map[&other_pool] =
+      absl::make_unique<Type::FileDescriptorEntry>();
+  const google::protobuf::DescriptorPool* pool =
+      google::protobuf::DescriptorPool::generated_pool();
+  std::unique_ptr<Type::FileDescriptorEntry>& entry =
+      file_descriptor_set_map[pool];
+  entry = absl::make_unique<Type::FileDescriptorEntry>();
+  entry->descriptor_set_index = 1;
+  entry->file_descriptors_known_to_reader = true;
+  type_proto.Clear();
+  ZETASQL_ASSERT_OK(proto_type->SerializeToProtoAndDistinctFileDescriptors(
+      &type_proto, &file_descriptor_set_map));
+  EXPECT_EQ(1, type_proto.proto_type().file_descriptor_set_index());
+  EXPECT_EQ(0, entry->file_descriptor_set.file_size());
+  EXPECT_TRUE(entry->file_descriptors.empty());
+}
+
+}  // namespace zetasql
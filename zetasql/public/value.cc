@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <limits>
 #include <memory>
 #include <utility>
 
@@ -27,8 +28,10 @@
 #include "google/protobuf/timestamp.pb.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/dynamic_message.h"
+#include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/message.h"
 #include "google/protobuf/util/message_differencer.h"
+#include "google/protobuf/wire_format_lite.h"
 #include "zetasql/common/string_util.h"
 #include "zetasql/public/functions/comparison.h"
 #include "zetasql/public/functions/convert_proto.h"
@@ -114,7 +117,9 @@ Value::Value(const Type* type)
       geography_ptr_ = new GeographyRef();
       break;
     case TYPE_NUMERIC:
-      numeric_ptr_ = new NumericRef();
+      // Stored inline as zero.
+      numeric_high_bits_ = 0;
+      numeric_low_bits_ = 0;
       break;
     case TYPE_ENUM:
       enum_type_ = type->AsEnum();
@@ -151,7 +156,7 @@ void Value::CopyFrom(const Value& that) {
       geography_ptr_->Ref();
       break;
     case TYPE_NUMERIC:
-      numeric_ptr_->Ref();
+      if (has_numeric_ref()) numeric_ptr_->Ref();
       break;
     case TYPE_PROTO:
       proto_ptr_->Ref();
@@ -159,6 +164,77 @@ void Value::CopyFrom(const Value& that) {
   }
 }
 
+// Number of ThreadConfinedScopes alive on the current thread.
+ABSL_CONST_INIT static thread_local int thread_confined_scope_depth = 0;
+
+Value::ThreadConfinedScope::ThreadConfinedScope() {
+  ++thread_confined_scope_depth;
+}
+
+Value::ThreadConfinedScope::~ThreadConfinedScope() {
+  --thread_confined_scope_depth;
+}
+
+bool Value::InThreadConfinedScope() {
+  return thread_confined_scope_depth > 0;
+}
+
+// The tracker of the innermost MemoryTrackingScope alive on the current
+// thread, or null.
+ABSL_CONST_INIT static thread_local Value::MemoryTracker* memory_tracker =
+    nullptr;
+
+zetasql_base::Status Value::MemoryTracker::status() const {
+  if (!exceeded()) return zetasql_base::OkStatus();
+  return zetasql_base::Status(
+      zetasql_base::StatusCode::kResourceExhausted,
+      absl::StrCat("Values allocated ", allocated_bytes_,
+                   " bytes, exceeding the limit of ", limit_bytes_, " bytes"));
+}
+
+Value::MemoryTrackingScope::MemoryTrackingScope(MemoryTracker* tracker)
+    : previous_(memory_tracker) {
+  memory_tracker = tracker;
+}
+
+Value::MemoryTrackingScope::~MemoryTrackingScope() {
+  memory_tracker = previous_;
+}
+
+void Value::TrackAllocation(uint64_t bytes) {
+  if (ABSL_PREDICT_FALSE(memory_tracker != nullptr)) {
+    memory_tracker->Add(bytes);
+  }
+}
+
+void Value::ShareAcrossThreads() const {
+  switch (type_kind_) {
+    case TYPE_STRUCT:
+    case TYPE_ARRAY:
+      list_ptr_->MakeShared();
+      // A shared list can still contain thread-confined values, so always
+      // recurse. The values of a generated list are shared when generated.
+      if (!list_ptr_->is_materialized()) break;
+      for (const Value& value : list_ptr_->values()) {
+        value.ShareAcrossThreads();
+      }
+      break;
+    case TYPE_STRING:
+    case TYPE_BYTES:
+      string_ptr_->MakeShared();
+      break;
+    case TYPE_GEOGRAPHY:
+      geography_ptr_->MakeShared();
+      break;
+    case TYPE_NUMERIC:
+      if (has_numeric_ref()) numeric_ptr_->MakeShared();
+      break;
+    case TYPE_PROTO:
+      proto_ptr_->MakeShared();
+      break;
+  }
+}
+
 Value::Value(TypeKind type_kind, int64_t value)
     : type_kind_(type_kind) {
   switch (type_kind) {
@@ -225,6 +301,57 @@ Value::Value(const ProtoType* proto_type, const std::string& value)
     : type_kind_(TYPE_PROTO),
       proto_ptr_(new ProtoRep(proto_type, std::move(value))) {}
 
+Value::Value(const ProtoType* proto_type,
+             std::shared_ptr<const google::protobuf::Message> message)
+    : type_kind_(TYPE_PROTO),
+      proto_ptr_(new ProtoRep(proto_type, std::move(message))) {}
+
+std::shared_ptr<const void> Value::StringRef::Keep() const {
+  if (external_ != nullptr) return external_->keeper;
+  // The returned owner may drop the last reference on another thread.
+  MakeShared();
+  Ref();
+  return std::shared_ptr<const void>(
+      this, [](const StringRef* string_ref) { string_ref->Unref(); });
+}
+
+// Returns an owner of external bytes that calls <releaser> when released.
+static std::shared_ptr<const void> MakeExternalKeeper(
+    absl::string_view data, std::function<void()> releaser) {
+  return std::shared_ptr<const void>(
+      data.data(), [releaser = std::move(releaser)](const void*) {
+        if (releaser != nullptr) releaser();
+      });
+}
+
+Value Value::ExternalString(absl::string_view data,
+                            std::function<void()> releaser) {
+  return Value(TYPE_STRING, data,
+               MakeExternalKeeper(data, std::move(releaser)));
+}
+
+Value Value::ExternalBytes(absl::string_view data,
+                           std::function<void()> releaser) {
+  return Value(TYPE_BYTES, data,
+               MakeExternalKeeper(data, std::move(releaser)));
+}
+
+// Slices shorter than this are copied, so that they do not keep large
+// buffers alive for a few bytes.
+static constexpr size_t kMinSharedSliceSize = 256;
+
+Value Value::Slice(size_t pos, size_t length) const {
+  const absl::string_view data = string_view_value();
+  CHECK_LE(pos, data.size()) << "Slice out of range";
+  const absl::string_view slice = data.substr(pos, length);
+  if (slice.size() == data.size()) return *this;
+  const TypeKind kind = static_cast<TypeKind>(type_kind_);
+  if (slice.size() < kMinSharedSliceSize) {
+    return Value(kind, std::string(slice));
+  }
+  return Value(kind, slice, string_ptr_->Keep());
+}
+
 #ifdef NDEBUG
 static constexpr bool kDebugMode = false;
 #else
@@ -239,6 +366,7 @@ Value Value::ArrayInternal(bool safe, const ArrayType* array_type,
   result.order_kind_ = order_kind;
   std::vector<Value>& value_list = result.list_ptr_->values();
   value_list = std::move(values);
+  TrackAllocation(value_list.size() * sizeof(Value));
   if (kDebugMode || safe) {
     for (const Value& v : value_list) {
       CHECK(v.type()->Equals(array_type->element_type()))
@@ -249,12 +377,23 @@ Value Value::ArrayInternal(bool safe, const ArrayType* array_type,
   return result;
 }
 
+Value Value::GeneratedArray(const ArrayType* array_type, int num_elements,
+                            std::function<Value(int)> generator) {
+  CHECK_GE(num_elements, 0);
+  Value result(array_type);
+  result.is_null_ = false;
+  result.order_kind_ = kPreservesOrder;
+  result.list_ptr_->SetGenerator(num_elements, std::move(generator));
+  return result;
+}
+
 Value Value::StructInternal(bool safe, const StructType* struct_type,
                             std::vector<Value>&& values) {
   Value result(struct_type);
   result.is_null_ = false;
   std::vector<Value>& value_list = result.list_ptr_->values();
   value_list = std::move(values);
+  TrackAllocation(value_list.size() * sizeof(Value));
   if (kDebugMode || safe) {
     // Check that values are compatible with the type.
     CHECK_EQ(struct_type->num_fields(), value_list.size());
@@ -430,7 +569,7 @@ uint64_t Value::physical_byte_size() const {
     case TYPE_TIMESTAMP:
       break;
     case TYPE_NUMERIC:
-      physical_size += sizeof(NumericRef);
+      if (has_numeric_ref()) physical_size += sizeof(NumericRef);
       break;
     case TYPE_STRING:
     case TYPE_BYTES:
@@ -457,7 +596,7 @@ std::string Value::ToCord() const {
   switch (type_kind_) {
     case TYPE_STRING:
     case TYPE_BYTES:
-      return string_ptr_->value();
+      return std::string(string_ptr_->view());
     case TYPE_PROTO:
       return proto_ptr_->value();
     default:
@@ -501,11 +640,21 @@ google::protobuf::Message* Value::ToMessage(
   CHECK(!is_null());
   std::unique_ptr<google::protobuf::Message> m(
       message_factory->GetPrototype(type()->AsProto()->descriptor())->New());
+  if (proto_ptr_->message() != nullptr) {
+    m->CopyFrom(*proto_ptr_->message());
+    return m.release();
+  }
   const bool success = m->ParsePartialFromString(ToCord());
   if (!success && return_null_on_error) return nullptr;
   return m.release();
 }
 
+std::shared_ptr<const google::protobuf::Message> Value::proto_message() const {
+  CHECK(type()->IsProto());
+  CHECK(!is_null());
+  return proto_ptr_->message();
+}
+
 const Value& Value::FindFieldByName(absl::string_view name) const {
   CHECK(type()->IsStruct());
   CHECK(!is_null()) << "Null value";
@@ -605,8 +754,9 @@ bool Value::EqualsInternal(const Value& x, const Value& y, bool allow_bags,
       return float_margin.Equal(x.float_value(), y.float_value());
     case TYPE_DOUBLE:
       return float_margin.Equal(x.double_value(), y.double_value());
-    case TYPE_STRING: return x.string_value() == y.string_value();
-    case TYPE_BYTES: return x.bytes_value() == y.bytes_value();
+    case TYPE_STRING:
+    case TYPE_BYTES:
+      return x.string_view_value() == y.string_view_value();
     case TYPE_DATE: return x.date_value() == y.date_value();
     case TYPE_TIMESTAMP:
       return x.timestamp_seconds_ == y.timestamp_seconds_ &&
@@ -1043,8 +1193,9 @@ bool Value::LessThan(const Value& that) const {
           return false;
         }
         return double_value() < that.double_value();
-      case TYPE_STRING: return string_value() < that.string_value();
-      case TYPE_BYTES: return bytes_value() < that.bytes_value();
+      case TYPE_STRING:
+      case TYPE_BYTES:
+        return string_view_value() < that.string_view_value();
       case TYPE_DATE: return date_value() < that.date_value();
       case TYPE_TIMESTAMP:
         return ToTime() < that.ToTime();
@@ -1097,6 +1248,190 @@ bool Value::LessThan(const Value& that) const {
   return false;
 }
 
+namespace {
+
+// Returns a negative, zero or positive number when 'a' orders before, like
+// or after 'b' in Value::LessThan().
+using ThreeWayComparator = std::function<int(const Value&, const Value&)>;
+
+// Returns whether 'a' sorts before 'b' when at least one of them is NULL.
+inline bool NullLess(const Value& a, const Value& b, bool nulls_last) {
+  return nulls_last ? !a.is_null() && b.is_null()
+                    : a.is_null() && !b.is_null();
+}
+
+// Returns a comparator that orders NULLs as requested and non-NULL values
+// with 'less', which need not handle NULLs.
+template <typename Less>
+Value::Comparator OrderBy(Less less, bool descending, bool nulls_last) {
+  if (descending) {
+    return [less, nulls_last](const Value& a, const Value& b) {
+      if (a.is_null() || b.is_null()) return NullLess(a, b, nulls_last);
+      return less(b, a);
+    };
+  }
+  return [less, nulls_last](const Value& a, const Value& b) {
+    if (a.is_null() || b.is_null()) return NullLess(a, b, nulls_last);
+    return less(a, b);
+  };
+}
+
+// NaN sorts before any other value.
+template <typename T>
+inline bool FloatingPointLess(T a, T b) {
+  if (std::isnan(a)) return !std::isnan(b);
+  return a < b;
+}
+
+ThreeWayComparator MakeThreeWayComparator(const Type* type) {
+  if (type->IsStruct()) {
+    std::vector<ThreeWayComparator> fields;
+    for (const StructField& field : type->AsStruct()->fields()) {
+      fields.push_back(MakeThreeWayComparator(field.type));
+    }
+    return [fields](const Value& a, const Value& b) {
+      if (a.is_null() || b.is_null()) return b.is_null() - a.is_null();
+      for (int i = 0; i < fields.size(); ++i) {
+        const int result = fields[i](a.field(i), b.field(i));
+        if (result != 0) return result;
+      }
+      return 0;
+    };
+  }
+  if (type->IsArray()) {
+    const ThreeWayComparator element =
+        MakeThreeWayComparator(type->AsArray()->element_type());
+    return [element](const Value& a, const Value& b) {
+      if (a.is_null() || b.is_null()) return b.is_null() - a.is_null();
+      const int size = std::min(a.num_elements(), b.num_elements());
+      for (int i = 0; i < size; ++i) {
+        const int result = element(a.element(i), b.element(i));
+        if (result != 0) return result;
+      }
+      return (a.num_elements() > size) - (b.num_elements() > size);
+    };
+  }
+  const Value::Comparator less = Value::MakeComparator(type);
+  return [less](const Value& a, const Value& b) {
+    return less(a, b) ? -1 : less(b, a) ? 1 : 0;
+  };
+}
+
+}  // namespace
+
+Value::Comparator Value::MakeComparator(const Type* type, bool descending,
+                                        bool nulls_last) {
+  switch (type->kind()) {
+    case TYPE_INT32:
+      return OrderBy(
+          [](const Value& a, const Value& b) {
+            return a.int32_value_ < b.int32_value_;
+          },
+          descending, nulls_last);
+    case TYPE_INT64:
+      return OrderBy(
+          [](const Value& a, const Value& b) {
+            return a.int64_value_ < b.int64_value_;
+          },
+          descending, nulls_last);
+    case TYPE_UINT32:
+      return OrderBy(
+          [](const Value& a, const Value& b) {
+            return a.uint32_value_ < b.uint32_value_;
+          },
+          descending, nulls_last);
+    case TYPE_UINT64:
+      return OrderBy(
+          [](const Value& a, const Value& b) {
+            return a.uint64_value_ < b.uint64_value_;
+          },
+          descending, nulls_last);
+    case TYPE_BOOL:
+      return OrderBy(
+          [](const Value& a, const Value& b) {
+            return a.bool_value_ < b.bool_value_;
+          },
+          descending, nulls_last);
+    case TYPE_FLOAT:
+      return OrderBy(
+          [](const Value& a, const Value& b) {
+            return FloatingPointLess(a.float_value_, b.float_value_);
+          },
+          descending, nulls_last);
+    case TYPE_DOUBLE:
+      return OrderBy(
+          [](const Value& a, const Value& b) {
+            return FloatingPointLess(a.double_value_, b.double_value_);
+          },
+          descending, nulls_last);
+    case TYPE_STRING:
+    case TYPE_BYTES:
+      return OrderBy(
+          [](const Value& a, const Value& b) {
+            return a.string_ptr_->view() < b.string_ptr_->view();
+          },
+          descending, nulls_last);
+    case TYPE_DATE:
+      return OrderBy(
+          [](const Value& a, const Value& b) {
+            return a.int32_value_ < b.int32_value_;
+          },
+          descending, nulls_last);
+    case TYPE_ENUM:
+      return OrderBy(
+          [](const Value& a, const Value& b) {
+            return a.enum_value_ < b.enum_value_;
+          },
+          descending, nulls_last);
+    case TYPE_TIMESTAMP:
+      return OrderBy(
+          [](const Value& a, const Value& b) {
+            return a.timestamp_seconds_ < b.timestamp_seconds_ ||
+                   (a.timestamp_seconds_ == b.timestamp_seconds_ &&
+                    a.subsecond_nanos_ < b.subsecond_nanos_);
+          },
+          descending, nulls_last);
+    case TYPE_TIME:
+      return OrderBy(
+          [](const Value& a, const Value& b) {
+            return a.bit_field_32_value_ < b.bit_field_32_value_ ||
+                   (a.bit_field_32_value_ == b.bit_field_32_value_ &&
+                    a.subsecond_nanos_ < b.subsecond_nanos_);
+          },
+          descending, nulls_last);
+    case TYPE_DATETIME:
+      return OrderBy(
+          [](const Value& a, const Value& b) {
+            return a.bit_field_64_value_ < b.bit_field_64_value_ ||
+                   (a.bit_field_64_value_ == b.bit_field_64_value_ &&
+                    a.subsecond_nanos_ < b.subsecond_nanos_);
+          },
+          descending, nulls_last);
+    case TYPE_NUMERIC:
+      return OrderBy(
+          [](const Value& a, const Value& b) {
+            return a.numeric_value() < b.numeric_value();
+          },
+          descending, nulls_last);
+    case TYPE_STRUCT:
+    case TYPE_ARRAY: {
+      const ThreeWayComparator compare = MakeThreeWayComparator(type);
+      return OrderBy(
+          [compare](const Value& a, const Value& b) {
+            return compare(a, b) < 0;
+          },
+          descending, nulls_last);
+    }
+    case TYPE_GEOGRAPHY:
+    case TYPE_PROTO:
+    case TYPE_UNKNOWN:
+    case __TypeKind__switch_must_have_a_default__:
+      break;
+  }
+  LOG(FATAL) << "Cannot compare values of type " << type->DebugString();
+  return nullptr;
+}
+
 static bool TypesSupportSqlLessThan(const Type* type1, const Type* type2) {
   switch (TYPE_KIND_PAIR(type1->kind(), type2->kind())) {
     case TYPE_KIND_PAIR(TYPE_INT32, TYPE_INT32):
@@ -1866,35 +2201,39 @@ bool Value::ParseInteger(absl::string_view input, Value* value) {
 namespace values {
 
 Value Int32Array(absl::Span<const int32_t> values) {
-  std::vector<Value> value_vector;
+  Value::ArrayBuilder builder(Int32ArrayType());
+  builder.reserve(values.size());
   for (auto v : values) {
-    value_vector.push_back(Int32(v));
+    builder.push_back(Int32(v));
   }
-  return Value::Array(Int32ArrayType(), value_vector);
+  return builder.Build();
 }
 
 Value Int64Array(absl::Span<const int64_t> values) {
-  std::vector<Value> value_vector;
+  Value::ArrayBuilder builder(Int64ArrayType());
+  builder.reserve(values.size());
   for (auto v : values) {
-    value_vector.push_back(Int64(v));
+    builder.push_back(Int64(v));
   }
-  return Value::Array(Int64ArrayType(), value_vector);
+  return builder.Build();
 }
 
 Value Uint32Array(absl::Span<const uint32_t> values) {
-  std::vector<Value> value_vector;
+  Value::ArrayBuilder builder(Uint32ArrayType());
+  builder.reserve(values.size());
   for (auto v : values) {
-    value_vector.push_back(Uint32(v));
+    builder.push_back(Uint32(v));
   }
-  return Value::Array(Uint32ArrayType(), value_vector);
+  return builder.Build();
 }
 
 Value Uint64Array(absl::Span<const uint64_t> values) {
-  std::vector<Value> value_vector;
+  Value::ArrayBuilder builder(Uint64ArrayType());
+  builder.reserve(values.size());
   for (auto v : values) {
-    value_vector.push_back(Uint64(v));
+    builder.push_back(Uint64(v));
   }
-  return Value::Array(Uint64ArrayType(), value_vector);
+  return builder.Build();
 }
 
 Value BoolArray(const std::vector<bool>& values) {
@@ -1907,48 +2246,134 @@ Value BoolArray(const std::vector<bool>& values) {
 }
 
 Value FloatArray(absl::Span<const float> values) {
-  std::vector<Value> value_vector;
+  Value::ArrayBuilder builder(FloatArrayType());
+  builder.reserve(values.size());
   for (auto v : values) {
-    value_vector.push_back(Float(v));
+    builder.push_back(Float(v));
   }
-  return Value::Array(FloatArrayType(), value_vector);
+  return builder.Build();
 }
 
 Value DoubleArray(absl::Span<const double> values) {
-  std::vector<Value> value_vector;
+  Value::ArrayBuilder builder(DoubleArrayType());
+  builder.reserve(values.size());
   for (auto v : values) {
-    value_vector.push_back(Double(v));
+    builder.push_back(Double(v));
   }
-  return Value::Array(DoubleArrayType(), value_vector);
+  return builder.Build();
 }
 
 Value StringArray(absl::Span<const std::string> values) {
-  std::vector<Value> value_vector;
+  Value::ArrayBuilder builder(StringArrayType());
+  builder.reserve(values.size());
   for (const std::string& v : values) {
-    value_vector.push_back(String(v));
+    builder.push_back(String(v));
   }
-  return Value::Array(StringArrayType(), value_vector);
+  return builder.Build();
 }
 
 Value BytesArray(absl::Span<const std::string> values) {
-  std::vector<Value> value_vector;
+  Value::ArrayBuilder builder(BytesArrayType());
+  builder.reserve(values.size());
   for (const std::string& v : values) {
-    value_vector.push_back(Bytes(v));
+    builder.push_back(Bytes(v));
   }
-  return Value::Array(BytesArrayType(), value_vector);
+  return builder.Build();
 }
 
 Value NumericArray(absl::Span<const NumericValue> values) {
-  std::vector<Value> value_vector;
+  Value::ArrayBuilder builder(NumericArrayType());
+  builder.reserve(values.size());
   for (auto v : values) {
-    value_vector.push_back(Value::Numeric(v));
+    builder.push_back(Value::Numeric(v));
   }
-  return Value::Array(NumericArrayType(), value_vector);
+  return builder.Build();
 }
 
 }  // namespace values
 
+// Returns whether ValueProto::Array has a packed encoding for arrays of
+// 'element_type'.
+static bool HasPackedEncoding(const Type* element_type) {
+  switch (element_type->kind()) {
+    case TYPE_INT32:
+    case TYPE_INT64:
+    case TYPE_UINT32:
+    case TYPE_UINT64:
+    case TYPE_BOOL:
+    case TYPE_DATE:
+    case TYPE_ENUM:
+    case TYPE_FLOAT:
+    case TYPE_DOUBLE:
+    case TYPE_STRING:
+    case TYPE_BYTES:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns the packed_int64 representation of the non-NULL 'value', whose
+// type is packed in packed_int64.
+static int64_t PackedInt64(const Value& value) {
+  switch (value.type_kind()) {
+    case TYPE_UINT64:
+      return static_cast<int64_t>(value.uint64_value());
+    case TYPE_ENUM:
+      return value.enum_value();
+    default:
+      return value.ToInt64();
+  }
+}
+
+// Appends the packed_strings representation of 'value' to 'out'.
+static void AppendPackedString(absl::string_view value, std::string* out) {
+  uint64_t length = value.size();
+  while (length >= 0x80) {
+    out->push_back(static_cast<char>(length | 0x80));
+    length >>= 7;
+  }
+  out->push_back(static_cast<char>(length));
+  out->append(value.data(), value.size());
+}
+
+// Sets the packed encoding of the elements of 'array' in 'array_proto'.
+// REQUIRES: HasPackedEncoding(array.type()->AsArray()->element_type()).
+static void SerializePackedArray(const Value& array,
+                                 ValueProto::Array* array_proto) {
+  const Type* element_type = array.type()->AsArray()->element_type();
+  const int num_elements = array.num_elements();
+  for (int i = 0; i < num_elements; ++i) {
+    if (array.element(i).is_null()) array_proto->add_packed_null_index(i);
+  }
+  if (element_type->IsFloatingPoint()) {
+    auto* packed = array_proto->mutable_packed_double();
+    packed->Reserve(num_elements);
+    for (const Value& element : array.elements()) {
+      packed->AddAlreadyReserved(element.is_null() ? 0 : element.ToDouble());
+    }
+  } else if (element_type->IsString() || element_type->IsBytes()) {
+    std::string* packed = array_proto->mutable_packed_strings();
+    for (const Value& element : array.elements()) {
+      AppendPackedString(element.is_null() ? absl::string_view()
+                                           : element.string_view_value(),
+                         packed);
+    }
+  } else {
+    auto* packed = array_proto->mutable_packed_int64();
+    packed->Reserve(num_elements);
+    for (const Value& element : array.elements()) {
+      packed->AddAlreadyReserved(element.is_null() ? 0 : PackedInt64(element));
+    }
+  }
+}
+
 zetasql_base::Status Value::Serialize(ValueProto* value_proto) const {
+  return Serialize(value_proto, /*pack_arrays=*/false);
+}
+
+zetasql_base::Status Value::Serialize(ValueProto* value_proto,
+                              bool pack_arrays) const {
   value_proto->Clear();
   if (is_null()) {
     return ::zetasql_base::OkStatus();
@@ -1980,10 +2405,12 @@ zetasql_base::Status Value::Serialize(ValueProto* value_proto) const {
       value_proto->set_numeric_value(numeric_value().SerializeAsProtoBytes());
       break;
     case TYPE_STRING:
-      value_proto->set_string_value(string_value());
+      value_proto->set_string_value(string_view_value().data(),
+                                    string_view_value().size());
       break;
     case TYPE_BYTES:
-      value_proto->set_bytes_value(bytes_value());
+      value_proto->set_bytes_value(string_view_value().data(),
+                                   string_view_value().size());
       break;
     case TYPE_DATE:
       value_proto->set_date_value(date_value());
@@ -2010,8 +2437,14 @@ zetasql_base::Status Value::Serialize(ValueProto* value_proto) const {
       // Create array_value so the result array is not NULL even when there
       // are no elements.
       auto* array_proto = value_proto->mutable_array_value();
+      if (pack_arrays &&
+          HasPackedEncoding(type()->AsArray()->element_type())) {
+        SerializePackedArray(*this, array_proto);
+        break;
+      }
       for (const Value& element : elements()) {
-        ZETASQL_RETURN_IF_ERROR(element.Serialize(array_proto->add_element()));
+        ZETASQL_RETURN_IF_ERROR(
+            element.Serialize(array_proto->add_element(), pack_arrays));
       }
       break;
     }
@@ -2020,7 +2453,8 @@ zetasql_base::Status Value::Serialize(ValueProto* value_proto) const {
       // are no fields in it.
       auto* struct_proto = value_proto->mutable_struct_value();
       for (const Value& field : fields()) {
-        ZETASQL_RETURN_IF_ERROR(field.Serialize(struct_proto->add_field()));
+        ZETASQL_RETURN_IF_ERROR(
+            field.Serialize(struct_proto->add_field(), pack_arrays));
       }
       break;
     }
@@ -2035,6 +2469,378 @@ zetasql_base::Status Value::Serialize(ValueProto* value_proto) const {
   return ::zetasql_base::OkStatus();
 }
 
+namespace {
+
+using ::google::protobuf::internal::WireFormatLite;
+
+// Writes the wire format of the ValueProto of a Value for
+// Value::SerializeToCodedStream(). ComputeSize() records the sizes of the
+// ValueProto::Array and ValueProto::Struct messages in pre-order, so that
+// Write() can emit each length prefix without recomputing the sizes of the
+// values nested in it.
+class ValueProtoWriter {
+ public:
+  explicit ValueProtoWriter(bool pack_arrays) : pack_arrays_(pack_arrays) {}
+
+  ValueProtoWriter(const ValueProtoWriter&) = delete;
+  ValueProtoWriter& operator=(const ValueProtoWriter&) = delete;
+
+  // Returns the size of the ValueProto of 'value'. Must be called once,
+  // before Write().
+  zetasql_base::StatusOr<size_t> ComputeSize(const Value& value);
+
+  // Writes the ValueProto of 'value'.
+  void Write(const Value& value, google::protobuf::io::CodedOutputStream* output);
+
+ private:
+  static size_t TagSize(int field_number) {
+    return google::protobuf::io::CodedOutputStream::VarintSize32(
+        WireFormatLite::MakeTag(field_number, WireFormatLite::WIRETYPE_VARINT));
+  }
+  static void WriteLengthDelimitedTag(int field_number, size_t size,
+                                      google::protobuf::io::CodedOutputStream* output) {
+    WireFormatLite::WriteTag(field_number,
+                             WireFormatLite::WIRETYPE_LENGTH_DELIMITED, output);
+    output->WriteVarint32(static_cast<uint32_t>(size));
+  }
+
+  // Returns the elements of an array or the fields of a struct.
+  static const std::vector<Value>& Children(const Value& value) {
+    return value.type_kind() == TYPE_ARRAY ? value.elements() : value.fields();
+  }
+
+  bool IsPacked(const Value& array) const {
+    return pack_arrays_ &&
+           HasPackedEncoding(array.type()->AsArray()->element_type());
+  }
+
+  // Pushes the payload sizes of the packed fields of 'array' to sizes_ and
+  // returns the size of its ValueProto::Array.
+  size_t ComputePackedArraySize(const Value& array);
+  void WritePackedArray(const Value& array,
+                        google::protobuf::io::CodedOutputStream* output);
+
+  const bool pack_arrays_;
+  std::vector<size_t> sizes_;
+  int next_size_ = 0;
+};
+
+zetasql_base::StatusOr<size_t> ValueProtoWriter::ComputeSize(const Value& value) {
+  if (value.is_null()) return 0;
+  switch (value.type_kind()) {
+    case TYPE_INT32:
+      return TagSize(ValueProto::kInt32ValueFieldNumber) +
+             WireFormatLite::Int32Size(value.int32_value());
+    case TYPE_INT64:
+      return TagSize(ValueProto::kInt64ValueFieldNumber) +
+             WireFormatLite::Int64Size(value.int64_value());
+    case TYPE_UINT32:
+      return TagSize(ValueProto::kUint32ValueFieldNumber) +
+             WireFormatLite::UInt32Size(value.uint32_value());
+    case TYPE_UINT64:
+      return TagSize(ValueProto::kUint64ValueFieldNumber) +
+             WireFormatLite::UInt64Size(value.uint64_value());
+    case TYPE_BOOL:
+      return TagSize(ValueProto::kBoolValueFieldNumber) +
+             WireFormatLite::kBoolSize;
+    case TYPE_FLOAT:
+      return TagSize(ValueProto::kFloatValueFieldNumber) +
+             WireFormatLite::kFloatSize;
+    case TYPE_DOUBLE:
+      return TagSize(ValueProto::kDoubleValueFieldNumber) +
+             WireFormatLite::kDoubleSize;
+    case TYPE_NUMERIC:
+      return TagSize(ValueProto::kNumericValueFieldNumber) +
+             WireFormatLite::BytesSize(
+                 value.numeric_value().SerializeAsProtoBytes());
+    case TYPE_STRING:
+      return TagSize(ValueProto::kStringValueFieldNumber) +
+             WireFormatLite::LengthDelimitedSize(
+                 value.string_view_value().size());
+    case TYPE_BYTES:
+      return TagSize(ValueProto::kBytesValueFieldNumber) +
+             WireFormatLite::LengthDelimitedSize(
+                 value.string_view_value().size());
+    case TYPE_DATE:
+      return TagSize(ValueProto::kDateValueFieldNumber) +
+             WireFormatLite::Int32Size(value.date_value());
+    case TYPE_TIMESTAMP: {
+      google::protobuf::Timestamp timestamp;
+      ZETASQL_RETURN_IF_ERROR(
+          zetasql_base::EncodeGoogleApiProto(value.ToTime(), &timestamp));
+      return TagSize(ValueProto::kTimestampValueFieldNumber) +
+             WireFormatLite::MessageSize(timestamp);
+    }
+    case TYPE_DATETIME:
+      return TagSize(ValueProto::kDatetimeValueFieldNumber) +
+             WireFormatLite::LengthDelimitedSize(
+                 TagSize(ValueProto::Datetime::
+                             kBitFieldDatetimeSecondsFieldNumber) +
+                 WireFormatLite::Int64Size(
+                     value.datetime_value().Packed64DatetimeSeconds()) +
+                 TagSize(ValueProto::Datetime::kNanosFieldNumber) +
+                 WireFormatLite::Int32Size(
+                     value.datetime_value().Nanoseconds()));
+    case TYPE_TIME:
+      return TagSize(ValueProto::kTimeValueFieldNumber) +
+             WireFormatLite::Int64Size(value.time_value().Packed64TimeNanos());
+    case TYPE_ENUM:
+      return TagSize(ValueProto::kEnumValueFieldNumber) +
+             WireFormatLite::Int32Size(value.enum_value());
+    case TYPE_ARRAY:
+    case TYPE_STRUCT: {
+      const int index = sizes_.size();
+      sizes_.push_back(0);
+      size_t size = 0;
+      if (value.type_kind() == TYPE_ARRAY && IsPacked(value)) {
+        size = ComputePackedArraySize(value);
+      } else {
+        // The element and field tags are both 1.
+        for (const Value& element : Children(value)) {
+          ZETASQL_ASSIGN_OR_RETURN(const size_t element_size, ComputeSize(element));
+          size += TagSize(ValueProto::Array::kElementFieldNumber) +
+                  WireFormatLite::LengthDelimitedSize(element_size);
+        }
+      }
+      if (size > std::numeric_limits<int32_t>::max()) {
+        return zetasql_base::Status(zetasql_base::StatusCode::kOutOfRange,
+                            "Serialized value exceeds 2GB");
+      }
+      sizes_[index] = size;
+      return TagSize(value.type_kind() == TYPE_ARRAY
+                         ? ValueProto::kArrayValueFieldNumber
+                         : ValueProto::kStructValueFieldNumber) +
+             WireFormatLite::LengthDelimitedSize(size);
+    }
+    case TYPE_PROTO:
+      return TagSize(ValueProto::kProtoValueFieldNumber) +
+             WireFormatLite::BytesSize(value.ToCord());
+    default:
+      return zetasql_base::Status(
+          zetasql_base::StatusCode::kInternal,
+          absl::StrCat("Unsupported type ", value.type()->DebugString()));
+  }
+}
+
+size_t ValueProtoWriter::ComputePackedArraySize(const Value& array) {
+  const Type* element_type = array.type()->AsArray()->element_type();
+  size_t payload = 0;
+  size_t null_payload = 0;
+  for (int i = 0; i < array.num_elements(); ++i) {
+    const Value& element = array.element(i);
+    if (element.is_null()) null_payload += WireFormatLite::Int32Size(i);
+    if (element_type->IsFloatingPoint()) {
+      payload += WireFormatLite::kDoubleSize;
+    } else if (element_type->IsString() || element_type->IsBytes()) {
+      payload += WireFormatLite::LengthDelimitedSize(
+          element.is_null() ? 0 : element.string_view_value().size());
+    } else {
+      payload += WireFormatLite::Int64Size(
+          element.is_null() ? 0 : PackedInt64(element));
+    }
+  }
+  sizes_.push_back(payload);
+  sizes_.push_back(null_payload);
+  size_t size = 0;
+  // Empty repeated fields are omitted, but packed_strings is always set.
+  if (element_type->IsString() || element_type->IsBytes()) {
+    size += TagSize(ValueProto::Array::kPackedStringsFieldNumber) +
+            WireFormatLite::LengthDelimitedSize(payload);
+  } else if (payload > 0) {
+    size += TagSize(element_type->IsFloatingPoint()
+                        ? ValueProto::Array::kPackedDoubleFieldNumber
+                        : ValueProto::Array::kPackedInt64FieldNumber) +
+            WireFormatLite::LengthDelimitedSize(payload);
+  }
+  if (null_payload > 0) {
+    size += TagSize(ValueProto::Array::kPackedNullIndexFieldNumber) +
+            WireFormatLite::LengthDelimitedSize(null_payload);
+  }
+  return size;
+}
+
+void ValueProtoWriter::Write(const Value& value,
+                             google::protobuf::io::CodedOutputStream* output) {
+  if (value.is_null()) return;
+  switch (value.type_kind()) {
+    case TYPE_INT32:
+      WireFormatLite::WriteInt32(ValueProto::kInt32ValueFieldNumber,
+                                 value.int32_value(), output);
+      break;
+    case TYPE_INT64:
+      WireFormatLite::WriteInt64(ValueProto::kInt64ValueFieldNumber,
+                                 value.int64_value(), output);
+      break;
+    case TYPE_UINT32:
+      WireFormatLite::WriteUInt32(ValueProto::kUint32ValueFieldNumber,
+                                  value.uint32_value(), output);
+      break;
+    case TYPE_UINT64:
+      WireFormatLite::WriteUInt64(ValueProto::kUint64ValueFieldNumber,
+                                  value.uint64_value(), output);
+      break;
+    case TYPE_BOOL:
+      WireFormatLite::WriteBool(ValueProto::kBoolValueFieldNumber,
+                                value.bool_value(), output);
+      break;
+    case TYPE_FLOAT:
+      WireFormatLite::WriteFloat(ValueProto::kFloatValueFieldNumber,
+                                 value.float_value(), output);
+      break;
+    case TYPE_DOUBLE:
+      WireFormatLite::WriteDouble(ValueProto::kDoubleValueFieldNumber,
+                                  value.double_value(), output);
+      break;
+    case TYPE_NUMERIC:
+      WireFormatLite::WriteBytes(ValueProto::kNumericValueFieldNumber,
+                                 value.numeric_value().SerializeAsProtoBytes(),
+                                 output);
+      break;
+    case TYPE_STRING:
+    case TYPE_BYTES: {
+      const absl::string_view bytes = value.string_view_value();
+      WriteLengthDelimitedTag(value.type_kind() == TYPE_STRING
+                                  ? ValueProto::kStringValueFieldNumber
+                                  : ValueProto::kBytesValueFieldNumber,
+                              bytes.size(), output);
+      output->WriteRaw(bytes.data(), bytes.size());
+      break;
+    }
+    case TYPE_DATE:
+      WireFormatLite::WriteInt32(ValueProto::kDateValueFieldNumber,
+                                 value.date_value(), output);
+      break;
+    case TYPE_TIMESTAMP: {
+      // ComputeSize() has checked that this succeeds.
+      google::protobuf::Timestamp timestamp;
+      zetasql_base::EncodeGoogleApiProto(value.ToTime(), &timestamp).IgnoreError();
+      WireFormatLite::WriteMessage(ValueProto::kTimestampValueFieldNumber,
+                                   timestamp, output);
+      break;
+    }
+    case TYPE_DATETIME: {
+      const int64_t seconds = value.datetime_value().Packed64DatetimeSeconds();
+      const int32_t nanos = value.datetime_value().Nanoseconds();
+      WriteLengthDelimitedTag(
+          ValueProto::kDatetimeValueFieldNumber,
+          TagSize(ValueProto::Datetime::kBitFieldDatetimeSecondsFieldNumber) +
+              WireFormatLite::Int64Size(seconds) +
+              TagSize(ValueProto::Datetime::kNanosFieldNumber) +
+              WireFormatLite::Int32Size(nanos),
+          output);
+      WireFormatLite::WriteInt64(
+          ValueProto::Datetime::kBitFieldDatetimeSecondsFieldNumber, seconds,
+          output);
+      WireFormatLite::WriteInt32(ValueProto::Datetime::kNanosFieldNumber,
+                                 nanos, output);
+      break;
+    }
+    case TYPE_TIME:
+      WireFormatLite::WriteInt64(ValueProto::kTimeValueFieldNumber,
+                                 value.time_value().Packed64TimeNanos(),
+                                 output);
+      break;
+    case TYPE_ENUM:
+      WireFormatLite::WriteInt32(ValueProto::kEnumValueFieldNumber,
+                                 value.enum_value(), output);
+      break;
+    case TYPE_ARRAY:
+    case TYPE_STRUCT:
+      WriteLengthDelimitedTag(value.type_kind() == TYPE_ARRAY
+                                  ? ValueProto::kArrayValueFieldNumber
+                                  : ValueProto::kStructValueFieldNumber,
+                              sizes_[next_size_++], output);
+      if (value.type_kind() == TYPE_ARRAY && IsPacked(value)) {
+        WritePackedArray(value, output);
+        break;
+      }
+      for (const Value& element : Children(value)) {
+        // The size of 'element' is needed before its own nested sizes, so
+        // it is computed here for scalars and taken from sizes_ otherwise.
+        size_t element_size;
+        if (!element.is_null() && (element.type_kind() == TYPE_ARRAY ||
+                                   element.type_kind() == TYPE_STRUCT)) {
+          element_size = TagSize(element.type_kind() == TYPE_ARRAY
+                                     ? ValueProto::kArrayValueFieldNumber
+                                     : ValueProto::kStructValueFieldNumber) +
+                         WireFormatLite::LengthDelimitedSize(
+                             sizes_[next_size_]);
+        } else {
+          // Scalars do not touch sizes_.
+          element_size = ComputeSize(element).ValueOrDie();
+        }
+        WriteLengthDelimitedTag(ValueProto::Array::kElementFieldNumber,
+                                element_size, output);
+        Write(element, output);
+      }
+      break;
+    case TYPE_PROTO:
+      WireFormatLite::WriteBytes(ValueProto::kProtoValueFieldNumber,
+                                 value.ToCord(), output);
+      break;
+    default:
+      // ComputeSize() has rejected other types.
+      break;
+  }
+}
+
+void ValueProtoWriter::WritePackedArray(
+    const Value& array, google::protobuf::io::CodedOutputStream* output) {
+  const Type* element_type = array.type()->AsArray()->element_type();
+  const size_t payload = sizes_[next_size_++];
+  const size_t null_payload = sizes_[next_size_++];
+  if (element_type->IsFloatingPoint()) {
+    if (payload > 0) {
+      WriteLengthDelimitedTag(ValueProto::Array::kPackedDoubleFieldNumber,
+                              payload, output);
+      for (const Value& element : array.elements()) {
+        WireFormatLite::WriteDoubleNoTag(
+            element.is_null() ? 0 : element.ToDouble(), output);
+      }
+    }
+  } else if (element_type->IsString() || element_type->IsBytes()) {
+    WriteLengthDelimitedTag(ValueProto::Array::kPackedStringsFieldNumber,
+                            payload, output);
+    for (const Value& element : array.elements()) {
+      const absl::string_view bytes =
+          element.is_null() ? absl::string_view()
+                            : element.string_view_value();
+      output->WriteVarint32(bytes.size());
+      output->WriteRaw(bytes.data(), bytes.size());
+    }
+  } else if (payload > 0) {
+    WriteLengthDelimitedTag(ValueProto::Array::kPackedInt64FieldNumber,
+                            payload, output);
+    for (const Value& element : array.elements()) {
+      WireFormatLite::WriteInt64NoTag(
+          element.is_null() ? 0 : PackedInt64(element), output);
+    }
+  }
+  if (null_payload > 0) {
+    WriteLengthDelimitedTag(ValueProto::Array::kPackedNullIndexFieldNumber,
+                            null_payload, output);
+    for (int i = 0; i < array.num_elements(); ++i) {
+      if (array.element(i).is_null()) {
+        WireFormatLite::WriteInt32NoTag(i, output);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+zetasql_base::Status Value::SerializeToCodedStream(
+    bool pack_arrays, google::protobuf::io::CodedOutputStream* output) const {
+  ValueProtoWriter writer(pack_arrays);
+  ZETASQL_RETURN_IF_ERROR(writer.ComputeSize(*this).status());
+  writer.Write(*this, output);
+  if (output->HadError()) {
+    return zetasql_base::Status(zetasql_base::StatusCode::kInternal,
+                        "Failed to write the serialized value");
+  }
+  return ::zetasql_base::OkStatus();
+}
+
 static zetasql_base::Status TypeMismatchError(const ValueProto& value_proto,
                                       const Type* type) {
   return zetasql_base::Status(
@@ -2044,6 +2850,126 @@ static zetasql_base::Status TypeMismatchError(const ValueProto& value_proto,
                    "> doesn't have field of that type and is not null."));
 }
 
+// Returns the element of type 'type' with packed_int64 representation
+// 'packed', or an error if it is out of range for 'type'.
+static zetasql_base::StatusOr<Value> FromPackedInt64(int64_t packed, const Type* type) {
+  switch (type->kind()) {
+    case TYPE_INT64:
+      return Value::Int64(packed);
+    case TYPE_UINT64:
+      return Value::Uint64(static_cast<uint64_t>(packed));
+    case TYPE_INT32:
+      if (packed >= std::numeric_limits<int32_t>::min() &&
+          packed <= std::numeric_limits<int32_t>::max()) {
+        return Value::Int32(static_cast<int32_t>(packed));
+      }
+      break;
+    case TYPE_UINT32:
+      if (packed >= 0 && packed <= std::numeric_limits<uint32_t>::max()) {
+        return Value::Uint32(static_cast<uint32_t>(packed));
+      }
+      break;
+    case TYPE_BOOL:
+      if (packed == 0 || packed == 1) return Value::Bool(packed == 1);
+      break;
+    case TYPE_DATE:
+      if (packed >= std::numeric_limits<int32_t>::min() &&
+          packed <= std::numeric_limits<int32_t>::max() &&
+          functions::IsValidDate(static_cast<int32_t>(packed))) {
+        return Value::Date(static_cast<int32_t>(packed));
+      }
+      break;
+    case TYPE_ENUM:
+      if (packed >= std::numeric_limits<int32_t>::min() &&
+          packed <= std::numeric_limits<int32_t>::max() &&
+          type->AsEnum()->enum_descriptor()->FindValueByNumber(
+              static_cast<int32_t>(packed)) != nullptr) {
+        return Value::Enum(type->AsEnum(), packed);
+      }
+      break;
+    default:
+      return zetasql_base::Status(
+          zetasql_base::StatusCode::kInternal,
+          absl::StrCat("Type ", type->DebugString(),
+                       " has no packed_int64 encoding"));
+  }
+  return zetasql_base::Status(
+      zetasql_base::StatusCode::kOutOfRange,
+      absl::StrCat("Invalid value for ", type->DebugString(), ": ", packed));
+}
+
+// Deserializes an array whose elements use one of the packed encodings of
+// ValueProto::Array.
+static zetasql_base::StatusOr<Value> DeserializePackedArray(
+    const ValueProto::Array& array_proto, const ArrayType* array_type) {
+  const Type* element_type = array_type->element_type();
+  const bool is_double = element_type->IsFloatingPoint();
+  const bool is_string = element_type->IsString() || element_type->IsBytes();
+  // Only the packed field for the element type may be set.
+  if (!HasPackedEncoding(element_type) || array_proto.element_size() > 0 ||
+      (!is_double && array_proto.packed_double_size() > 0) ||
+      (!is_string && array_proto.has_packed_strings()) ||
+      ((is_double || is_string) && array_proto.packed_int64_size() > 0)) {
+    return zetasql_base::Status(
+        zetasql_base::StatusCode::kInternal,
+        absl::StrCat("Invalid packed array for type ",
+                     array_type->DebugString()));
+  }
+  Value::ArrayBuilder elements(array_type);
+  // Returns true if the next element is NULL, and appends it.
+  const auto& null_indexes = array_proto.packed_null_index();
+  int next_null = 0;
+  auto add_if_null = [&]() {
+    if (next_null < null_indexes.size() &&
+        null_indexes.Get(next_null) == elements.size()) {
+      ++next_null;
+      elements.push_back(Value::Null(element_type));
+      return true;
+    }
+    return false;
+  };
+  if (is_double) {
+    elements.reserve(array_proto.packed_double_size());
+    for (const double packed : array_proto.packed_double()) {
+      if (add_if_null()) continue;
+      elements.push_back(element_type->IsFloat()
+                             ? Value::Float(static_cast<float>(packed))
+                             : Value::Double(packed));
+    }
+  } else if (is_string) {
+    const std::string& packed = array_proto.packed_strings();
+    google::protobuf::io::CodedInputStream input(
+        reinterpret_cast<const uint8_t*>(packed.data()), packed.size());
+    std::string element;
+    uint32_t length;
+    while (input.CurrentPosition() < packed.size()) {
+      if (!input.ReadVarint32(&length) ||
+          !input.ReadString(&element, length)) {
+        return zetasql_base::Status(zetasql_base::StatusCode::kOutOfRange,
+                            "Corrupted packed_strings in ValueProto::Array");
+      }
+      if (add_if_null()) continue;
+      elements.push_back(element_type->IsString() ? Value::String(element)
+                                                  : Value::Bytes(element));
+    }
+  } else {
+    elements.reserve(array_proto.packed_int64_size());
+    for (const int64_t packed : array_proto.packed_int64()) {
+      if (add_if_null()) continue;
+      ZETASQL_ASSIGN_OR_RETURN(Value element, FromPackedInt64(packed, element_type));
+      elements.push_back(std::move(element));
+    }
+  }
+  // Every index must have been used, which also requires them to be
+  // increasing and in range.
+  if (next_null != null_indexes.size()) {
+    return zetasql_base::Status(
+        zetasql_base::StatusCode::kOutOfRange,
+        "Invalid packed_null_index in ValueProto::Array");
+  }
+  return elements.Build();
+}
+
 zetasql_base::StatusOr<Value> Value::Deserialize(const ValueProto& value_proto,
                                          const Type* type) {
   if (value_proto.value_case() == ValueProto::VALUE_NOT_SET) {
@@ -2179,14 +3105,22 @@ zetasql_base::StatusOr<Value> Value::Deserialize(const ValueProto& value_proto,
       if (!value_proto.has_array_value()) {
         return TypeMismatchError(value_proto, type);
       }
-      std::vector<Value> elements;
+      const ValueProto::Array& array_proto = value_proto.array_value();
+      if (array_proto.packed_int64_size() > 0 ||
+          array_proto.packed_double_size() > 0 ||
+          array_proto.has_packed_strings() ||
+          array_proto.packed_null_index_size() > 0) {
+        return DeserializePackedArray(array_proto, type->AsArray());
+      }
+      ArrayBuilder elements(type->AsArray());
+      elements.reserve(value_proto.array_value().element_size());
       for (const auto& element : value_proto.array_value().element()) {
         auto status_or_value =
             Deserialize(element, type->AsArray()->element_type());
         ZETASQL_RETURN_IF_ERROR(status_or_value.status());
-        elements.push_back(status_or_value.ValueOrDie());
+        elements.push_back(std::move(status_or_value).ValueOrDie());
       }
-      return Array(type->AsArray(), elements);
+      return elements.Build();
     }
     case TYPE_STRUCT: {
       if (!value_proto.has_struct_value()) {
@@ -2201,14 +3135,14 @@ zetasql_base::StatusOr<Value> Value::Deserialize(const ValueProto& value_proto,
                          struct_type->num_fields(), " fields, but proto has ",
                          value_proto.struct_value().field_size(), " fields."));
       }
-      std::vector<Value> fields;
+      StructBuilder fields(struct_type);
       for (int i = 0; i < struct_type->num_fields(); i++) {
         auto status_or_value = Deserialize(value_proto.struct_value().field(i),
                                            struct_type->field(i).type);
         ZETASQL_RETURN_IF_ERROR(status_or_value.status());
-        fields.emplace_back(std::move(*status_or_value));
+        fields.push_back(std::move(*status_or_value));
       }
-      return Struct(struct_type, fields);
+      return fields.Build();
     }
     case TYPE_PROTO:
       if (!value_proto.has_proto_value()) {
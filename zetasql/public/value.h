@@ -18,12 +18,16 @@
 #define ZETASQL_PUBLIC_VALUE_H_
 
 #include <stddef.h>
+#include <functional>
 #include <iosfwd>
+#include <limits>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "google/protobuf/dynamic_message.h"
+#include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/message.h"
 #include "zetasql/common/float_margin.h"
 #include "zetasql/public/civil_time.h"
@@ -132,7 +136,7 @@ class Value {
   DatetimeValue datetime_value() const;  // REQUIRES: datetime type
 
   // REQUIRES: numeric type
-  const NumericValue& numeric_value() const;
+  NumericValue numeric_value() const;
 
   // Generic accessor for numeric PODs.
   // REQUIRES: T is one of int32_t, int64_t, uint32_t, uint64_t, bool, float, double.
@@ -148,6 +152,22 @@ class Value {
   double ToDouble() const;  // For bool, int_, date, timestamp_, enum types.
   std::string ToCord() const;  // For std::string, bytes, and protos
 
+  // Returns the bytes of a string or bytes value without copying them, unlike
+  // string_value() and bytes_value() for values made by ExternalString(),
+  // ExternalBytes() or Slice(). The view is valid while this Value or a copy
+  // of it is alive.
+  // REQUIRES: !is_null() && (type()->IsString() || type()->IsBytes())
+  absl::string_view string_view_value() const;
+
+  // Returns a value of the same type holding bytes [pos, pos + length) of
+  // this string or bytes value, like absl::string_view::substr(). Large
+  // slices share the bytes of this value instead of copying them. Offsets
+  // are in bytes, so for strings the caller must keep them on UTF-8
+  // character boundaries, e.g. when implementing SUBSTR.
+  // REQUIRES: !is_null() && (type()->IsString() || type()->IsBytes()) &&
+  //           pos <= string_view_value().size()
+  Value Slice(size_t pos, size_t length) const;
+
   // Convert this value to a dynamically allocated proto Message.
   //
   // If 'return_null_on_error' is false, this does a best-effort conversion of
@@ -169,6 +189,11 @@ class Value {
   google::protobuf::Message* ToMessage(google::protobuf::DynamicMessageFactory* message_factory,
                              bool return_null_on_error = false) const;
 
+  // Returns the message of a proto value created from a message, which
+  // spares parsing its bytes, or null for proto values created from bytes.
+  // REQUIRES: !is_null() && type()->IsProto()
+  std::shared_ptr<const google::protobuf::Message> proto_message() const;
+
   // Struct-specific methods. REQUIRES: !is_null().
   int num_fields() const;
   const Value& field(int i) const;
@@ -179,10 +204,16 @@ class Value {
   const Value& FindFieldByName(absl::string_view name) const;
 
   // Array-specific methods. REQUIRES: !is_null().
+  //
+  // element() and elements() return references, so they materialize the
+  // elements of a GeneratedArray(); num_elements(), empty() and
+  // ElementValue() do not.
   bool empty() const;
   int num_elements() const;
   const Value& element(int i) const;
   const std::vector<Value>& elements() const;
+  // Returns a copy of element 'i'.
+  Value ElementValue(int i) const;
 
   // Returns true if 'this' equals 'that' or both are null. This is *not* SQL
   // equality which returns null when either value is null. Returns false if
@@ -226,6 +257,21 @@ class Value {
   // or $greater_or_equals) in a resolved AST generated by the resolver.
   Value SqlLessThan(const Value& that) const;
 
+  // A strict weak ordering of Values of one type, as made by MakeComparator().
+  using Comparator = std::function<bool(const Value&, const Value&)>;
+
+  // Returns a comparator of Values of 'type' that orders them like
+  // LessThan(), but decides how to compare them once instead of on every
+  // call, e.g. for sorting many values or computing MIN and MAX. If
+  // 'descending' is true, non-NULL values are ordered in reverse. NULLs sort
+  // before all other values, or after them if 'nulls_last' is true. The
+  // fields of structs and the elements of arrays are compared like in
+  // LessThan(), with NULLs first.
+  //
+  // REQUIRES: 'type' is not a PROTO or GEOGRAPHY and does not contain one.
+  static Comparator MakeComparator(const Type* type, bool descending = false,
+                                   bool nulls_last = false);
+
   // Returns the hash code of a value.
   size_t HashCode() const;
 
@@ -291,6 +337,16 @@ class Value {
   static Value Bytes(absl::string_view v);
   // str may contain '\0' in the middle, without getting truncated.
   template <size_t N> static Value Bytes(const char (&str)[N]);
+  // Create string and bytes values that refer to 'data' without copying it,
+  // e.g. to blobs read by table iterators. 'releaser' is called, from any
+  // thread, once no value refers to 'data' anymore; until then 'data' must
+  // stay valid and unchanged. string_value() and bytes_value() copy the
+  // bytes on their first call; string_view_value() and serialization read
+  // them in place.
+  static Value ExternalString(absl::string_view data,
+                              std::function<void()> releaser);
+  static Value ExternalBytes(absl::string_view data,
+                             std::function<void()> releaser);
   static Value Date(int32_t v);
   // Creates a timestamp value from absl::Time at nanoseconds precision.
   static Value Timestamp(absl::Time t);
@@ -346,6 +402,14 @@ class Value {
   static Value Enum(const EnumType* type, absl::string_view name);
   // Creates a protocol buffer value.
   static Value Proto(const ProtoType* type, const std::string& value);
+  // Creates a protocol buffer value that holds 'message', which must have
+  // the descriptor of 'type' and must not be modified afterwards.  The bytes
+  // are serialized from it only when first needed, e.g. by ToCord() or
+  // Serialize(), and ToMessage() copies it instead of parsing them.  This
+  // spares a serialize and parse round trip for messages that are already
+  // parsed, e.g. by table iterators.
+  static Value Proto(const ProtoType* type,
+                     std::shared_ptr<const google::protobuf::Message> message);
 
   // Creates a struct of the specified 'type' and given 'values'. The size of
   // the 'values' vector must agree with the number of fields in 'type', and the
@@ -373,6 +437,28 @@ class Value {
   static Value UnsafeArray(const ArrayType* array_type,
                            std::vector<Value>&& values);
 #endif
+
+#ifndef SWIG
+  // Creates an array of the given 'array_type' with 'num_elements' elements,
+  // the i-th of which is 'generator(i)', without storing them. This suits
+  // arrays such as those of GENERATE_ARRAY and GENERATE_DATE_ARRAY, which are
+  // large, cheap to compute, and usually just iterated over with
+  // ElementValue(). The elements are generated and stored on the first call
+  // to element() or elements(), which the other operations on arrays, such
+  // as comparison, hashing and serialization, use.
+  //
+  // 'generator' must return values of array_type->element_type() and, since
+  // copies of the Value may be used on several threads, be safe to call
+  // concurrently. It is kept until the Value is destroyed.
+  static Value GeneratedArray(const ArrayType* array_type, int num_elements,
+                              std::function<Value(int)> generator);
+#endif
+
+#ifndef SWIG
+  // Builders for ARRAY and STRUCT values, see below.
+  class ArrayBuilder;
+  class StructBuilder;
+#endif
   // Creates a null of the given 'type'.
   static Value Null(const Type* type);
   // Creates an invalid value.
@@ -388,11 +474,90 @@ class Value {
   // Serializes the Value into ValueProto protocol buffer.
   zetasql_base::Status Serialize(ValueProto* value_proto) const;
 
+  // Same as above, but if 'pack_arrays' is true, arrays (at any depth) of
+  // the scalar types listed in ValueProto::Array use its packed encodings,
+  // with no ValueProto per element. Deserialize() reads both encodings.
+  zetasql_base::Status Serialize(ValueProto* value_proto, bool pack_arrays) const;
+
+  // Writes the wire format of the ValueProto that Serialize(value_proto,
+  // pack_arrays) produces to 'output', without building the ValueProto.
+  // Parsing the output gives an equal ValueProto.
+  zetasql_base::Status SerializeToCodedStream(
+      bool pack_arrays, google::protobuf::io::CodedOutputStream* output) const;
+
   // Deserializes a ValueProto into Value. Since ValueProto does not know its
   // full type, the type information is passed as an additional parameter.
   static zetasql_base::StatusOr<Value> Deserialize(const ValueProto& value_proto,
                                            const Type* type);
 
+  // While a ThreadConfinedScope is alive, the STRING, BYTES, NUMERIC,
+  // GEOGRAPHY, PROTO, ARRAY and STRUCT values created on the current thread
+  // use non-atomic reference counts, which makes copying and destroying them
+  // cheaper in single-threaded pipelines. Such values, and any copies of
+  // them, may only be used by that thread until ShareAcrossThreads() has been
+  // called on them. Scopes may be nested.
+  class ThreadConfinedScope {
+   public:
+    ThreadConfinedScope();
+    ThreadConfinedScope(const ThreadConfinedScope&) = delete;
+    ThreadConfinedScope& operator=(const ThreadConfinedScope&) = delete;
+    ~ThreadConfinedScope();
+  };
+
+  // Switches this value and all values nested in it to atomic reference
+  // counting, so that they can be passed to other threads. Must be called
+  // by the thread that created them, while that thread is their only owner,
+  // before they are passed on. Values that are already shared are not
+  // modified. Takes time linear in the size of the value.
+  void ShareAcrossThreads() const;
+
+  // Counts the bytes allocated for the STRING, BYTES, NUMERIC, GEOGRAPHY,
+  // PROTO, ARRAY and STRUCT values created on a thread while a
+  // MemoryTrackingScope using it is alive, as for physical_byte_size(), and
+  // compares them with a limit. The count is a running total of allocations,
+  // not of live bytes: copies of a value share its representation and add
+  // nothing, and destroying values does not decrease it. As Value
+  // construction cannot fail, callers building large values (e.g. for
+  // ARRAY_AGG) check status() as they go and stop once it is an error.
+  //
+  // This class is thread-compatible.
+  class MemoryTracker {
+   public:
+    explicit MemoryTracker(
+        int64_t limit_bytes = std::numeric_limits<int64_t>::max())
+        : limit_bytes_(limit_bytes) {}
+    MemoryTracker(const MemoryTracker&) = delete;
+    MemoryTracker& operator=(const MemoryTracker&) = delete;
+
+    int64_t limit_bytes() const { return limit_bytes_; }
+    int64_t allocated_bytes() const { return allocated_bytes_; }
+    bool exceeded() const { return allocated_bytes_ > limit_bytes_; }
+
+    // Returns a RESOURCE_EXHAUSTED error if exceeded().
+    zetasql_base::Status status() const;
+
+    // Adds <bytes>, e.g. for memory of the caller held outside Values.
+    void Add(int64_t bytes) { allocated_bytes_ += bytes; }
+
+   private:
+    const int64_t limit_bytes_;
+    int64_t allocated_bytes_ = 0;
+  };
+
+  // While a MemoryTrackingScope is alive, the values created on the current
+  // thread report their allocations to its tracker. Scopes may be nested;
+  // the innermost one is used.
+  class MemoryTrackingScope {
+   public:
+    explicit MemoryTrackingScope(MemoryTracker* tracker);
+    MemoryTrackingScope(const MemoryTrackingScope&) = delete;
+    MemoryTrackingScope& operator=(const MemoryTrackingScope&) = delete;
+    ~MemoryTrackingScope();
+
+   private:
+    MemoryTracker* const previous_;
+  };
+
  private:
   // For access to StringRef and TypedList.
   FRIEND_TEST(ValueTest, PhysicalByteSize);
@@ -403,6 +568,7 @@ class Value {
   friend class InternalValue;  // Defined in zetasql/common/internal_value.h.
   friend struct InternalComparer;  // Defined in value.cc.
   friend struct InternalHasher;    // Defined in value.cc
+  friend struct ProtoFieldCache;   // Defined in proto_util.cc
   class GeographyRef;  // Defined in value_inl.h
   class NumericRef;  // Defined in value_inl.h
   class StringRef;  // Defined in value_inl.h
@@ -419,6 +585,23 @@ class Value {
 
   static const int kInvalidTypeKind = __TypeKind__switch_must_have_a_default__;
 
+  // Returns true if a ThreadConfinedScope is alive on the current thread.
+  static bool InThreadConfinedScope();
+
+  // Adds <bytes> to the tracker of the current MemoryTrackingScope, if any.
+  static void TrackAllocation(uint64_t bytes);
+
+  // NUMERIC values whose packed representation fits in 96 bits are stored
+  // inline, in numeric_high_bits_ and numeric_low_bits_. Others are stored in
+  // numeric_ptr_, with numeric_high_bits_ set to this value.
+  static constexpr int32_t kNumericRefHighBits =
+      std::numeric_limits<int32_t>::min();
+
+  // Returns true if this NUMERIC value is stored in numeric_ptr_.
+  bool has_numeric_ref() const {
+    return numeric_high_bits_ == kNumericRefHighBits;
+  }
+
   // Constructors for non-null atomic values.
   explicit Value(int32_t value);
   explicit Value(int64_t value);
@@ -431,6 +614,10 @@ class Value {
   Value(TypeKind type_kind, int64_t value);
   // REQUIRES: type_kind is std::string or bytes
   Value(TypeKind type_kind, std::string value);
+  // Refers to 'data', which 'keeper' keeps alive.
+  // REQUIRES: type_kind is std::string or bytes
+  Value(TypeKind type_kind, absl::string_view data,
+        std::shared_ptr<const void> keeper);
 
   // Constructs a typed NULL of the given 'type'.
   explicit Value(const Type* type);
@@ -452,6 +639,8 @@ class Value {
 
   // Constructs a proto.
   Value(const ProtoType* proto_type, const std::string& value);
+  Value(const ProtoType* proto_type,
+        std::shared_ptr<const google::protobuf::Message> message);
 
   // Clears the contents of the value and makes it invalid. Must be called
   // exactly once prior to destruction or assignment.
@@ -543,6 +732,8 @@ class Value {
     // Used for google.protobuf.Timestamp.nanos and sub-second part of
     // DatetimeValue and TimeValue.
     int32_t subsecond_nanos_;
+    // Bits 64-95 of an inline NUMERIC, or kNumericRefHighBits.
+    int32_t numeric_high_bits_;
   };
 
   // 64-bit part of the value.
@@ -562,11 +753,68 @@ class Value {
     const EnumType* enum_type_;  // Not owned. Used for enums.
     ProtoRep* proto_ptr_;        // Reffed. Used for protos.
     GeographyRef* geography_ptr_;  // Owned. Used for geographies.
-    NumericRef* numeric_ptr_;  // Owned. Used for values of TYPE_NUMERIC.
+    uint64_t numeric_low_bits_;  // Bits 0-63 of an inline NUMERIC.
+    NumericRef* numeric_ptr_;  // Reffed. Used for large values of TYPE_NUMERIC.
   };
   // Intentionally copyable.
 };
 
+#ifndef SWIG
+// Builds an ARRAY value of 'array_type' by appending its elements, which
+// are moved into the array without further copies. As for UnsafeArray(),
+// element types are only CHECK'd in debug mode. Example:
+//   Value::ArrayBuilder builder(types::Int64ArrayType());
+//   builder.reserve(n);
+//   for (int64_t i = 0; i < n; ++i) builder.push_back(Value::Int64(i));
+//   Value array = builder.Build();
+class Value::ArrayBuilder {
+ public:
+  explicit ArrayBuilder(const ArrayType* array_type)
+      : array_type_(array_type) {}
+  ArrayBuilder(const ArrayBuilder&) = delete;
+  ArrayBuilder& operator=(const ArrayBuilder&) = delete;
+
+  void reserve(int num_elements) { values_.reserve(num_elements); }
+  void push_back(const Value& value) { values_.push_back(value); }
+  void push_back(Value&& value) { values_.push_back(std::move(value)); }
+  int size() const { return values_.size(); }
+  bool empty() const { return values_.empty(); }
+
+  // Returns the array of the elements appended so far, taking their
+  // buffer. The builder is left empty and can build another array.
+  Value Build();
+
+ private:
+  const ArrayType* const array_type_;
+  std::vector<Value> values_;
+};
+
+// Builds a STRUCT value of 'struct_type' by appending its field values in
+// order, like ArrayBuilder. Build() requires one value per field; that and
+// the field types are only CHECK'd in debug mode.
+class Value::StructBuilder {
+ public:
+  explicit StructBuilder(const StructType* struct_type)
+      : struct_type_(struct_type) {
+    values_.reserve(struct_type->num_fields());
+  }
+  StructBuilder(const StructBuilder&) = delete;
+  StructBuilder& operator=(const StructBuilder&) = delete;
+
+  void push_back(const Value& value) { values_.push_back(value); }
+  void push_back(Value&& value) { values_.push_back(std::move(value)); }
+  int size() const { return values_.size(); }
+
+  // Returns the struct of the field values appended so far, taking their
+  // buffer. The builder is left empty and can build another struct.
+  Value Build();
+
+ private:
+  const StructType* const struct_type_;
+  std::vector<Value> values_;
+};
+#endif
+
 #ifndef SWIG
 static_assert(sizeof(Value) == sizeof(int64_t) * 2, "Value size mismatch");
 #endif
@@ -0,0 +1,313 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/value_batch.h"
+
+#include "zetasql/base/source_location.h"
+#include "zetasql/base/status_builder.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+// Returns an error unless <value> can be stored in a column of <type>.
+static zetasql_base::Status CheckValueType(const Value& value, const Type* type) {
+  if (!value.is_valid() || !value.type()->Equivalent(type)) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "Cannot append value of type "
+           << (value.is_valid() ? value.type()->DebugString() : "INVALID")
+           << " to a column of type " << type->DebugString();
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+ColumnVector::ColumnVector(const Type* type)
+    : type_(type), storage_(StorageForType(type)) {
+  if (storage_ == kString) offsets_.push_back(0);
+}
+
+ColumnVector::Storage ColumnVector::StorageForType(const Type* type) {
+  CHECK(type != nullptr);
+  switch (type->kind()) {
+    case TYPE_INT32:
+    case TYPE_INT64:
+    case TYPE_UINT32:
+    case TYPE_UINT64:
+    case TYPE_BOOL:
+    case TYPE_DATE:
+    case TYPE_ENUM:
+      return kInt64;
+    case TYPE_FLOAT:
+    case TYPE_DOUBLE:
+      return kDouble;
+    case TYPE_STRING:
+    case TYPE_BYTES:
+      return kString;
+    default:
+      return kValue;
+  }
+}
+
+void ColumnVector::AppendValidity(bool valid) {
+  if (size_ % 64 == 0) validity_.push_back(0);
+  if (valid) {
+    validity_.back() |= uint64_t{1} << (size_ % 64);
+  } else {
+    ++null_count_;
+  }
+  ++size_;
+}
+
+void ColumnVector::AppendInt64(int64_t value) {
+  DCHECK_EQ(storage_, kInt64);
+  int64_data_.push_back(value);
+  AppendValidity(true);
+}
+
+void ColumnVector::AppendDouble(double value) {
+  DCHECK_EQ(storage_, kDouble);
+  double_data_.push_back(value);
+  AppendValidity(true);
+}
+
+void ColumnVector::AppendString(absl::string_view value) {
+  DCHECK_EQ(storage_, kString);
+  string_data_.append(value.data(), value.size());
+  offsets_.push_back(string_data_.size());
+  AppendValidity(true);
+}
+
+void ColumnVector::AppendNull() {
+  switch (storage_) {
+    case kInt64:
+      int64_data_.push_back(0);
+      break;
+    case kDouble:
+      double_data_.push_back(0);
+      break;
+    case kString:
+      offsets_.push_back(string_data_.size());
+      break;
+    case kValue:
+      value_data_.push_back(Value::Null(type_));
+      break;
+  }
+  AppendValidity(false);
+}
+
+zetasql_base::Status ColumnVector::Append(const Value& value) {
+  ZETASQL_RETURN_IF_ERROR(CheckValueType(value, type_));
+  if (value.is_null()) {
+    AppendNull();
+    return ::zetasql_base::OkStatus();
+  }
+  switch (storage_) {
+    case kInt64:
+      AppendInt64(type_->kind() == TYPE_UINT64
+                      ? static_cast<int64_t>(value.uint64_value())
+                      : value.ToInt64());
+      break;
+    case kDouble:
+      AppendDouble(value.ToDouble());
+      break;
+    case kString:
+      AppendString(type_->kind() == TYPE_STRING ? value.string_value()
+                                                : value.bytes_value());
+      break;
+    case kValue:
+      value_data_.push_back(value);
+      AppendValidity(true);
+      break;
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status ColumnVector::AppendValues(absl::Span<const Value> values) {
+  Reserve(size_ + values.size());
+  for (const Value& value : values) {
+    ZETASQL_RETURN_IF_ERROR(Append(value));
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+void ColumnVector::AppendRange(const ColumnVector& other, int begin,
+                               int end) {
+  DCHECK(other.type_->Equivalent(type_));
+  DCHECK_LE(0, begin);
+  DCHECK_LE(begin, end);
+  DCHECK_LE(end, other.size_);
+  Reserve(size_ + end - begin);
+  switch (storage_) {
+    case kInt64:
+      int64_data_.insert(int64_data_.end(), other.int64_data_.begin() + begin,
+                         other.int64_data_.begin() + end);
+      break;
+    case kDouble:
+      double_data_.insert(double_data_.end(),
+                          other.double_data_.begin() + begin,
+                          other.double_data_.begin() + end);
+      break;
+    case kString: {
+      const int64_t other_start = other.offsets_[begin];
+      const int64_t start = string_data_.size();
+      string_data_.append(other.string_data_, other_start,
+                          other.offsets_[end] - other_start);
+      for (int i = begin + 1; i <= end; ++i) {
+        offsets_.push_back(other.offsets_[i] - other_start + start);
+      }
+      break;
+    }
+    case kValue:
+      value_data_.insert(value_data_.end(), other.value_data_.begin() + begin,
+                         other.value_data_.begin() + end);
+      break;
+  }
+  for (int i = begin; i < end; ++i) {
+    AppendValidity(!other.IsNull(i));
+  }
+}
+
+Value ColumnVector::GetValue(int i) const {
+  DCHECK_GE(i, 0);
+  DCHECK_LT(i, size_);
+  if (storage_ == kValue) return value_data_[i];
+  if (IsNull(i)) return Value::Null(type_);
+  switch (type_->kind()) {
+    case TYPE_INT32:
+      return Value::Int32(static_cast<int32_t>(int64_data_[i]));
+    case TYPE_INT64:
+      return Value::Int64(int64_data_[i]);
+    case TYPE_UINT32:
+      return Value::Uint32(static_cast<uint32_t>(int64_data_[i]));
+    case TYPE_UINT64:
+      return Value::Uint64(static_cast<uint64_t>(int64_data_[i]));
+    case TYPE_BOOL:
+      return Value::Bool(int64_data_[i] != 0);
+    case TYPE_DATE:
+      return Value::Date(static_cast<int32_t>(int64_data_[i]));
+    case TYPE_ENUM:
+      return Value::Enum(type_->AsEnum(), int64_data_[i]);
+    case TYPE_FLOAT:
+      return Value::Float(static_cast<float>(double_data_[i]));
+    case TYPE_DOUBLE:
+      return Value::Double(double_data_[i]);
+    case TYPE_STRING:
+      return Value::String(GetStringView(i));
+    case TYPE_BYTES:
+      return Value::Bytes(GetStringView(i));
+    default:
+      LOG(FATAL) << "Unexpected type in ColumnVector: "
+                 << type_->DebugString();
+      return Value();
+  }
+}
+
+std::vector<Value> ColumnVector::GetValues() const {
+  std::vector<Value> values;
+  values.reserve(size_);
+  for (int i = 0; i < size_; ++i) {
+    values.push_back(GetValue(i));
+  }
+  return values;
+}
+
+void ColumnVector::Reserve(int size) {
+  validity_.reserve((size + 63) / 64);
+  switch (storage_) {
+    case kInt64:
+      int64_data_.reserve(size);
+      break;
+    case kDouble:
+      double_data_.reserve(size);
+      break;
+    case kString:
+      offsets_.reserve(size + 1);
+      break;
+    case kValue:
+      value_data_.reserve(size);
+      break;
+  }
+}
+
+void ColumnVector::Clear() {
+  size_ = 0;
+  null_count_ = 0;
+  validity_.clear();
+  int64_data_.clear();
+  double_data_.clear();
+  string_data_.clear();
+  value_data_.clear();
+  offsets_.clear();
+  if (storage_ == kString) offsets_.push_back(0);
+}
+
+ValueBatch::ValueBatch(absl::Span<const Type* const> column_types) {
+  columns_.reserve(column_types.size());
+  for (const Type* type : column_types) {
+    columns_.emplace_back(type);
+  }
+}
+
+void ValueBatch::set_num_rows(int num_rows) {
+  for (const ColumnVector& column : columns_) {
+    DCHECK_EQ(column.size(), num_rows);
+  }
+  num_rows_ = num_rows;
+}
+
+zetasql_base::Status ValueBatch::AppendRow(absl::Span<const Value> row) {
+  if (row.size() != columns_.size()) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "Row has " << row.size() << " values but the batch has "
+           << columns_.size() << " columns";
+  }
+  // Check all values first, so that a bad row leaves every column unchanged.
+  for (int i = 0; i < row.size(); ++i) {
+    ZETASQL_RETURN_IF_ERROR(CheckValueType(row[i], columns_[i].type()));
+  }
+  for (int i = 0; i < row.size(); ++i) {
+    ZETASQL_RETURN_IF_ERROR(columns_[i].Append(row[i]));
+  }
+  ++num_rows_;
+  return ::zetasql_base::OkStatus();
+}
+
+void ValueBatch::AppendRows(const ValueBatch& other, int begin, int end) {
+  DCHECK_EQ(columns_.size(), other.columns_.size());
+  for (int i = 0; i < columns_.size(); ++i) {
+    columns_[i].AppendRange(other.columns_[i], begin, end);
+  }
+  num_rows_ += end - begin;
+}
+
+std::vector<Value> ValueBatch::GetRow(int row) const {
+  DCHECK_GE(row, 0);
+  DCHECK_LT(row, num_rows_);
+  std::vector<Value> values;
+  values.reserve(columns_.size());
+  for (const ColumnVector& column : columns_) {
+    values.push_back(column.GetValue(row));
+  }
+  return values;
+}
+
+void ValueBatch::Clear() {
+  for (ColumnVector& column : columns_) {
+    column.Clear();
+  }
+  num_rows_ = 0;
+}
+
+}  // namespace zetasql
@@ -0,0 +1,217 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Columnar representation of a batch of rows, as an alternative to one Value
+// per cell.
+
+#ifndef ZETASQL_PUBLIC_VALUE_BATCH_H_
+#define ZETASQL_PUBLIC_VALUE_BATCH_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/logging.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+
+// A column of values of one ZetaSQL Type, stored in a typed contiguous
+// buffer plus a validity bitmap.
+//
+// The buffer used depends on the type, see Storage below. Each Value
+// appended is converted to the buffer's representation, and GetValue()
+// converts back; the conversion is lossless. NULL entries occupy a slot in
+// the buffer holding 0 or the empty string.
+//
+// Example:
+//   ColumnVector column(types::Int64Type());
+//   ZETASQL_RETURN_IF_ERROR(column.Append(Value::Int64(5)));
+//   column.AppendNull();
+//   int64_t sum = 0;
+//   for (int i = 0; i < column.size(); ++i) {
+//     if (!column.IsNull(i)) sum += column.int64_data()[i];
+//   }
+class ColumnVector {
+ public:
+  enum Storage {
+    // INT32, INT64, UINT32, UINT64, BOOL, DATE and ENUM values, in
+    // int64_data(). UINT64 values are stored bit-cast to int64_t.
+    kInt64,
+    // FLOAT and DOUBLE values, in double_data().
+    kDouble,
+    // STRING and BYTES values, concatenated in string_data(), with value i
+    // at [offsets()[i], offsets()[i + 1]).
+    kString,
+    // Values of all other types, as Values in value_data().
+    kValue,
+  };
+
+  // REQUIRES: <type> is not null.
+  explicit ColumnVector(const Type* type);
+
+  ColumnVector(const ColumnVector&) = default;
+  ColumnVector& operator=(const ColumnVector&) = default;
+  ColumnVector(ColumnVector&&) = default;
+  ColumnVector& operator=(ColumnVector&&) = default;
+
+  // Returns the buffer used for values of <type>.
+  static Storage StorageForType(const Type* type);
+
+  const Type* type() const { return type_; }
+  Storage storage() const { return storage_; }
+
+  int size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  int null_count() const { return null_count_; }
+
+  bool IsNull(int i) const {
+    DCHECK_GE(i, 0);
+    DCHECK_LT(i, size_);
+    return (validity_[i / 64] & (uint64_t{1} << (i % 64))) == 0;
+  }
+
+  // Bit i % 64 of word i / 64 is set if value i is not NULL.
+  absl::Span<const uint64_t> validity() const { return validity_; }
+
+  // REQUIRES: storage() == kInt64.
+  absl::Span<const int64_t> int64_data() const {
+    DCHECK_EQ(storage_, kInt64);
+    return int64_data_;
+  }
+
+  // REQUIRES: storage() == kDouble.
+  absl::Span<const double> double_data() const {
+    DCHECK_EQ(storage_, kDouble);
+    return double_data_;
+  }
+
+  // REQUIRES: storage() == kString.
+  absl::Span<const int64_t> offsets() const {
+    DCHECK_EQ(storage_, kString);
+    return offsets_;
+  }
+  absl::string_view string_data() const {
+    DCHECK_EQ(storage_, kString);
+    return string_data_;
+  }
+  absl::string_view GetStringView(int i) const {
+    DCHECK_EQ(storage_, kString);
+    return absl::string_view(string_data_)
+        .substr(offsets_[i], offsets_[i + 1] - offsets_[i]);
+  }
+
+  // REQUIRES: storage() == kValue.
+  absl::Span<const Value> value_data() const {
+    DCHECK_EQ(storage_, kValue);
+    return value_data_;
+  }
+
+  // Appends <value>, which must have type() or an equivalent type.
+  zetasql_base::Status Append(const Value& value);
+
+  // Appends each of <values>.
+  zetasql_base::Status AppendValues(absl::Span<const Value> values);
+
+  void AppendNull();
+
+  // Appends a non-NULL value directly to the buffer.
+  // REQUIRES: storage() is kInt64, kDouble or kString respectively.
+  void AppendInt64(int64_t value);
+  void AppendDouble(double value);
+  void AppendString(absl::string_view value);
+
+  // Appends entries [begin, end) of <other>, which must have type() or an
+  // equivalent type, copying its buffers without creating Values.
+  void AppendRange(const ColumnVector& other, int begin, int end);
+
+  // Returns entry i as a Value of type().
+  Value GetValue(int i) const;
+
+  // Returns all entries as Values.
+  std::vector<Value> GetValues() const;
+
+  // Reserves space for <size> entries in total.
+  void Reserve(int size);
+
+  // Removes all entries, keeping the allocated buffers.
+  void Clear();
+
+ private:
+  void AppendValidity(bool valid);
+
+  const Type* type_;
+  Storage storage_;
+  int size_ = 0;
+  int null_count_ = 0;
+  std::vector<uint64_t> validity_;
+
+  std::vector<int64_t> int64_data_;
+  std::vector<double> double_data_;
+  std::vector<int64_t> offsets_;  // Has size() + 1 entries.
+  std::string string_data_;
+  std::vector<Value> value_data_;
+};
+
+// A batch of rows stored as one ColumnVector per column. All columns have
+// num_rows() entries.
+class ValueBatch {
+ public:
+  ValueBatch() {}
+  explicit ValueBatch(absl::Span<const Type* const> column_types);
+
+  ValueBatch(const ValueBatch&) = default;
+  ValueBatch& operator=(const ValueBatch&) = default;
+  ValueBatch(ValueBatch&&) = default;
+  ValueBatch& operator=(ValueBatch&&) = default;
+
+  int num_columns() const { return columns_.size(); }
+  int num_rows() const { return num_rows_; }
+
+  const ColumnVector& column(int i) const { return columns_[i]; }
+
+  // Returns column i for filling it directly. After all columns have been
+  // filled, set_num_rows() must be called with their common size.
+  ColumnVector* mutable_column(int i) { return &columns_[i]; }
+
+  // REQUIRES: Every column has <num_rows> entries.
+  void set_num_rows(int num_rows);
+
+  // Appends a row with one value per column.
+  zetasql_base::Status AppendRow(absl::Span<const Value> row);
+
+  // Appends rows [begin, end) of <other>, which must have the same column
+  // types, copying its column buffers without creating Values.
+  void AppendRows(const ValueBatch& other, int begin, int end);
+
+  // Returns row <row> as Values.
+  std::vector<Value> GetRow(int row) const;
+
+  // Removes all rows, keeping the columns and their buffers.
+  void Clear();
+
+ private:
+  std::vector<ColumnVector> columns_;
+  int num_rows_ = 0;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_VALUE_BATCH_H_
@@ -0,0 +1,176 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/value_batch.h"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/numeric_value.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/testdata/test_schema.pb.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace zetasql {
+
+using zetasql_base::testing::StatusIs;
+
+// Appends <values> to a column of <type> and checks that they come back
+// unchanged.
+static void TestRoundTrip(const Type* type, ColumnVector::Storage storage,
+                          const std::vector<Value>& values) {
+  ColumnVector column(type);
+  EXPECT_EQ(storage, column.storage()) << type->DebugString();
+  ZETASQL_ASSERT_OK(column.AppendValues(values));
+  ZETASQL_ASSERT_OK(column.Append(Value::Null(type)));
+  ASSERT_EQ(values.size() + 1, column.size());
+  EXPECT_EQ(1, column.null_count());
+  for (int i = 0; i < values.size(); ++i) {
+    EXPECT_FALSE(column.IsNull(i));
+    EXPECT_EQ(values[i], column.GetValue(i)) << type->DebugString();
+  }
+  EXPECT_TRUE(column.IsNull(values.size()));
+  EXPECT_TRUE(column.GetValue(values.size()).is_null());
+  EXPECT_TRUE(column.GetValue(values.size()).type()->Equals(type));
+}
+
+TEST(ColumnVectorTest, RoundTrip) {
+  TestRoundTrip(types::Int32Type(), ColumnVector::kInt64,
+                {Value::Int32(std::numeric_limits<int32_t>::min()),
+                 Value::Int32(7)});
+  TestRoundTrip(types::Int64Type(), ColumnVector::kInt64,
+                {Value::Int64(std::numeric_limits<int64_t>::min()),
+                 Value::Int64(std::numeric_limits<int64_t>::max())});
+  TestRoundTrip(types::Uint32Type(), ColumnVector::kInt64,
+                {Value::Uint32(std::numeric_limits<uint32_t>::max())});
+  TestRoundTrip(types::Uint64Type(), ColumnVector::kInt64,
+                {Value::Uint64(std::numeric_limits<uint64_t>::max()),
+                 Value::Uint64(0)});
+  TestRoundTrip(types::BoolType(), ColumnVector::kInt64,
+                {Value::Bool(true), Value::Bool(false)});
+  TestRoundTrip(types::DateType(), ColumnVector::kInt64, {Value::Date(17000)});
+  TypeFactory type_factory;
+  const EnumType* enum_type;
+  ZETASQL_ASSERT_OK(type_factory.MakeEnumType(zetasql_test::TestEnum_descriptor(),
+                                      &enum_type));
+  TestRoundTrip(enum_type, ColumnVector::kInt64,
+                {Value::Enum(enum_type, 1), Value::Enum(enum_type, 2)});
+  TestRoundTrip(types::FloatType(), ColumnVector::kDouble,
+                {Value::Float(1.5), Value::Float(-0.1)});
+  TestRoundTrip(types::DoubleType(), ColumnVector::kDouble,
+                {Value::Double(-0.1)});
+  TestRoundTrip(types::StringType(), ColumnVector::kString,
+                {Value::String("abc"), Value::String(""), Value::String("d")});
+  TestRoundTrip(types::BytesType(), ColumnVector::kString,
+                {Value::Bytes("\x01\x02")});
+  TestRoundTrip(types::NumericType(), ColumnVector::kValue,
+                {Value::Numeric(NumericValue(5LL))});
+  TestRoundTrip(types::TimestampType(), ColumnVector::kValue,
+                {Value::TimestampFromUnixMicros(123456)});
+  TestRoundTrip(types::Int64ArrayType(), ColumnVector::kValue,
+                {Value::Array(types::Int64ArrayType(), {Value::Int64(1)})});
+}
+
+TEST(ColumnVectorTest, Buffers) {
+  ColumnVector column(types::StringType());
+  column.AppendString("ab");
+  column.AppendNull();
+  column.AppendString("cde");
+  EXPECT_EQ("abcde", column.string_data());
+  EXPECT_THAT(column.offsets(), testing::ElementsAre(0, 2, 2, 5));
+  EXPECT_EQ("cde", column.GetStringView(2));
+  ASSERT_EQ(1, column.validity().size());
+  EXPECT_EQ(0b101, column.validity()[0]);
+
+  ColumnVector int64_column(types::Int64Type());
+  for (int i = 0; i < 100; ++i) {
+    if (i % 10 == 0) {
+      int64_column.AppendNull();
+    } else {
+      int64_column.AppendInt64(i);
+    }
+  }
+  EXPECT_EQ(100, int64_column.int64_data().size());
+  EXPECT_EQ(2, int64_column.validity().size());
+  EXPECT_EQ(10, int64_column.null_count());
+  EXPECT_EQ(99, int64_column.int64_data()[99]);
+  EXPECT_TRUE(int64_column.IsNull(90));
+  EXPECT_FALSE(int64_column.IsNull(91));
+
+  int64_column.Clear();
+  EXPECT_TRUE(int64_column.empty());
+  EXPECT_EQ(0, int64_column.null_count());
+}
+
+TEST(ValueBatchTest, Rows) {
+  ValueBatch batch({types::Int64Type(), types::StringType()});
+  ASSERT_EQ(2, batch.num_columns());
+  ZETASQL_ASSERT_OK(batch.AppendRow({Value::Int64(1), Value::String("a")}));
+  ZETASQL_ASSERT_OK(batch.AppendRow({Value::NullInt64(), Value::String("b")}));
+  EXPECT_EQ(2, batch.num_rows());
+  EXPECT_THAT(batch.GetRow(1),
+              testing::ElementsAre(Value::NullInt64(), Value::String("b")));
+
+  // A bad row leaves the batch unchanged.
+  EXPECT_THAT(batch.AppendRow({Value::Int64(1), Value::Int64(2)}),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+  EXPECT_THAT(batch.AppendRow({Value::Int64(1)}),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+  EXPECT_EQ(2, batch.num_rows());
+  EXPECT_EQ(2, batch.column(0).size());
+
+  batch.mutable_column(0)->AppendInt64(3);
+  batch.mutable_column(1)->AppendString("c");
+  batch.set_num_rows(3);
+  EXPECT_THAT(batch.GetRow(2),
+              testing::ElementsAre(Value::Int64(3), Value::String("c")));
+
+  batch.Clear();
+  EXPECT_EQ(0, batch.num_rows());
+  EXPECT_EQ(2, batch.num_columns());
+}
+
+TEST(ValueBatchTest, AppendRows) {
+  ValueBatch source({types::Int64Type(), types::StringType(),
+                     types::DoubleType(), types::TimestampType()});
+  for (int i = 0; i < 70; ++i) {
+    ZETASQL_ASSERT_OK(source.AppendRow(
+        {i % 3 == 0 ? Value::NullInt64() : Value::Int64(i),
+         i % 5 == 0 ? Value::NullString() : Value::String(std::string(i, 'x')),
+         Value::Double(i), Value::TimestampFromUnixMicros(i)}));
+  }
+  ValueBatch batch({types::Int64Type(), types::StringType(),
+                    types::DoubleType(), types::TimestampType()});
+  ZETASQL_ASSERT_OK(batch.AppendRow({Value::Int64(-1), Value::String("first"),
+                             Value::NullDouble(), Value::NullTimestamp()}));
+  batch.AppendRows(source, 2, 68);
+  batch.AppendRows(source, 68, 68);
+  ASSERT_EQ(67, batch.num_rows());
+  for (int i = 2; i < 68; ++i) {
+    EXPECT_EQ(source.GetRow(i), batch.GetRow(i - 1));
+  }
+  EXPECT_EQ("first", batch.column(1).GetStringView(0));
+  EXPECT_EQ(22, batch.column(0).null_count());
+  EXPECT_EQ(batch.column(1).string_data().size(),
+            batch.column(1).offsets().back());
+}
+
+}  // namespace zetasql
@@ -0,0 +1,86 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "zetasql/public/value_bloom_filter.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace zetasql {
+
+// Returns true if <value> can never be equal to another value.
+static bool IsNullOrNaN(const Value& value) {
+  return value.is_null() ||
+         (value.type()->IsFloatingPoint() && std::isnan(value.ToDouble()));
+}
+
+ValueBloomFilter::ValueBloomFilter(int64_t expected_values,
+                                   double bits_per_value) {
+  const double bits =
+      std::max<double>(64, std::max<int64_t>(expected_values, 1) *
+                               std::max(bits_per_value, 1.0));
+  int64_t words = 1;
+  while (words * 64 < bits) words *= 2;
+  bits_.assign(words, 0);
+  // The optimal number of hashes is ln(2) * bits per value.
+  num_hashes_ = std::min(
+      16, std::max(1, static_cast<int>(std::lround(
+                          0.693 * words * 64 /
+                          std::max<int64_t>(expected_values, 1)))));
+}
+
+void ValueBloomFilter::SplitHash(uint64_t hash, uint64_t* h1, uint64_t* h2) {
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  hash ^= hash >> 33;
+  *h1 = hash;
+  // An odd step visits distinct bits until it wraps around.
+  *h2 = (hash >> 32) | (hash << 32) | 1;
+}
+
+void ValueBloomFilter::AddHash(uint64_t hash) {
+  uint64_t h1, h2;
+  SplitHash(hash, &h1, &h2);
+  const uint64_t mask = num_bits() - 1;
+  for (int i = 0; i < num_hashes_; ++i) {
+    const uint64_t bit = (h1 + i * h2) & mask;
+    bits_[bit / 64] |= uint64_t{1} << (bit % 64);
+  }
+}
+
+bool ValueBloomFilter::MayContainHash(uint64_t hash) const {
+  uint64_t h1, h2;
+  SplitHash(hash, &h1, &h2);
+  const uint64_t mask = num_bits() - 1;
+  for (int i = 0; i < num_hashes_; ++i) {
+    const uint64_t bit = (h1 + i * h2) & mask;
+    if ((bits_[bit / 64] & (uint64_t{1} << (bit % 64))) == 0) return false;
+  }
+  return true;
+}
+
+void ValueBloomFilter::Add(const Value& value) {
+  if (!IsNullOrNaN(value)) AddHash(value.HashCode());
+}
+
+bool ValueBloomFilter::MayContain(const Value& value) const {
+  return !IsNullOrNaN(value) && MayContainHash(value.HashCode());
+}
+
+}  // namespace zetasql
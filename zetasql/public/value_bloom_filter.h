@@ -0,0 +1,70 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef ZETASQL_PUBLIC_VALUE_BLOOM_FILTER_H_
+#define ZETASQL_PUBLIC_VALUE_BLOOM_FILTER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "zetasql/public/value.h"
+
+namespace zetasql {
+
+// A Bloom filter over Values, e.g. for skipping the rows of a scan whose
+// join key cannot match any key of the other join input.
+//
+// MayContain() returns true for every value that was added, and for other
+// values with a false positive rate of about 1% at 10 bits per value. Values
+// are hashed with Value::HashCode(), so a value only matches values of the
+// same type that are equal under Value::Equals(); callers probing with
+// another type (e.g. UINT64 for INT64) must convert first. NULLs and NaNs
+// are never added and never match, as for SQL equality.
+//
+// This class is thread-compatible; MayContain() can be called concurrently.
+class ValueBloomFilter {
+ public:
+  // Creates an empty filter sized for <expected_values> values at
+  // <bits_per_value> bits each.
+  explicit ValueBloomFilter(int64_t expected_values,
+                            double bits_per_value = 10);
+
+  ValueBloomFilter(const ValueBloomFilter&) = default;
+  ValueBloomFilter& operator=(const ValueBloomFilter&) = default;
+
+  void Add(const Value& value);
+  bool MayContain(const Value& value) const;
+
+  // Like Add() and MayContain(), for a value with HashCode() <hash>.
+  void AddHash(uint64_t hash);
+  bool MayContainHash(uint64_t hash) const;
+
+  int64_t num_bits() const { return bits_.size() * 64; }
+  int num_hashes() const { return num_hashes_; }
+
+ private:
+  // The bit positions are h1 + i * h2 for i in [0, num_hashes_), from the
+  // mixed halves of the hash.
+  static void SplitHash(uint64_t hash, uint64_t* h1, uint64_t* h2);
+
+  std::vector<uint64_t> bits_;  // The size is a power of two.
+  int num_hashes_;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_VALUE_BLOOM_FILTER_H_
@@ -0,0 +1,64 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "zetasql/public/value_bloom_filter.h"
+
+#include <cstdint>
+#include <limits>
+
+#include "zetasql/public/value.h"
+#include "gtest/gtest.h"
+
+namespace zetasql {
+
+TEST(ValueBloomFilterTest, ContainsAddedValues) {
+  ValueBloomFilter filter(/*expected_values=*/1000);
+  for (int64_t i = 0; i < 1000; ++i) {
+    filter.Add(Value::Int64(i * 7));
+  }
+  for (int64_t i = 0; i < 1000; ++i) {
+    EXPECT_TRUE(filter.MayContain(Value::Int64(i * 7)));
+  }
+  int false_positives = 0;
+  for (int64_t i = 0; i < 10000; ++i) {
+    if (filter.MayContain(Value::Int64(i * 7 + 1))) ++false_positives;
+  }
+  EXPECT_LT(false_positives, 300);
+  EXPECT_GE(filter.num_bits(), 10000);
+}
+
+TEST(ValueBloomFilterTest, NullsAndNaNs) {
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  ValueBloomFilter filter(/*expected_values=*/1);
+  filter.Add(Value::NullString());
+  filter.Add(Value::Double(nan));
+  filter.Add(Value::Double(0));
+  EXPECT_FALSE(filter.MayContain(Value::NullString()));
+  EXPECT_FALSE(filter.MayContain(Value::Double(nan)));
+  // -0 and 0 are equal.
+  EXPECT_TRUE(filter.MayContain(Value::Double(-0.0)));
+}
+
+TEST(ValueBloomFilterTest, Empty) {
+  ValueBloomFilter filter(/*expected_values=*/0);
+  EXPECT_EQ(64, filter.num_bits());
+  EXPECT_FALSE(filter.MayContain(Value::String("a")));
+  filter.Add(Value::String("a"));
+  EXPECT_TRUE(filter.MayContain(Value::String("a")));
+}
+
+}  // namespace zetasql
@@ -0,0 +1,204 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/value_hash.h"
+
+#include <string.h>
+
+#include <cmath>
+
+#include "zetasql/base/logging.h"
+
+namespace zetasql {
+
+namespace {
+
+constexpr uint64_t kMul1 = 0x9e3779b185ebca87ULL;
+constexpr uint64_t kMul2 = 0xc2b2ae3d27d4eb4fULL;
+constexpr uint64_t kNaNKeyHash = 0x7a6f9c4e1d3b5a29ULL;
+
+// The finalizer of MurmurHash3, a bijection that mixes all input bits into
+// all output bits.
+inline uint64_t Mix(uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+inline uint64_t RotateLeft(uint64_t x, int bits) {
+  return (x << bits) | (x >> (64 - bits));
+}
+
+// Combines the running hash of a key tuple with the hash of its next key.
+// The order of the keys matters.
+inline uint64_t Combine(uint64_t hash, uint64_t key_hash) {
+  return Mix(RotateLeft(hash, 27) ^ key_hash);
+}
+
+inline uint64_t Load64(const char* p) {
+  uint64_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+// One round of XXH64, for the four independent lanes of HashKeyString().
+inline uint64_t Round(uint64_t lane, uint64_t input) {
+  return RotateLeft(lane + input * kMul2, 31) * kMul1;
+}
+
+inline uint64_t Int64Hash(int64_t value) {
+  return Mix(static_cast<uint64_t>(value) ^ kMul2);
+}
+
+inline uint64_t DoubleHash(double value) {
+  if (std::isnan(value)) return kNaNKeyHash;
+  // -0.0 == 0.0, so this maps -0.0 to 0.0.
+  if (value == 0) value = 0;
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return Mix(bits ^ kMul1);
+}
+
+// Returns the hash of the value at <row> of <column>.
+uint64_t ColumnHash(const ColumnVector& column, int row) {
+  if (column.IsNull(row)) return kNullKeyHash;
+  switch (column.storage()) {
+    case ColumnVector::kInt64:
+      return Int64Hash(column.int64_data()[row]);
+    case ColumnVector::kDouble:
+      return DoubleHash(column.double_data()[row]);
+    case ColumnVector::kString:
+      return HashKeyString(column.GetStringView(row));
+    case ColumnVector::kValue:
+      break;
+  }
+  return HashKeyValue(column.value_data()[row]);
+}
+
+}  // namespace
+
+uint64_t HashKeyInt64(int64_t value) { return Int64Hash(value); }
+
+uint64_t HashKeyDouble(double value) { return DoubleHash(value); }
+
+uint64_t HashKeyString(absl::string_view value) {
+  const char* p = value.data();
+  size_t n = value.size();
+  uint64_t hash = kMul2 ^ (n * kMul1);
+  if (n >= 32) {
+    uint64_t lanes[4] = {kMul1 + kMul2, kMul2, 0, 0 - kMul1};
+    do {
+      for (int i = 0; i < 4; ++i) {
+        lanes[i] = Round(lanes[i], Load64(p + 8 * i));
+      }
+      p += 32;
+      n -= 32;
+    } while (n >= 32);
+    hash ^= RotateLeft(lanes[0], 1) + RotateLeft(lanes[1], 7) +
+            RotateLeft(lanes[2], 12) + RotateLeft(lanes[3], 18);
+  }
+  for (; n >= 8; p += 8, n -= 8) {
+    hash = RotateLeft(hash ^ Round(0, Load64(p)), 27) * kMul1;
+  }
+  if (n > 0) {
+    uint64_t tail = 0;
+    memcpy(&tail, p, n);
+    hash = RotateLeft(hash ^ Round(0, tail), 27) * kMul1;
+  }
+  return Mix(hash);
+}
+
+uint64_t HashKeyValue(const Value& value) {
+  if (value.is_null()) return kNullKeyHash;
+  switch (ColumnVector::StorageForType(value.type())) {
+    case ColumnVector::kInt64:
+      return Int64Hash(value.type_kind() == TYPE_UINT64
+                           ? static_cast<int64_t>(value.uint64_value())
+                           : value.ToInt64());
+    case ColumnVector::kDouble:
+      return DoubleHash(value.ToDouble());
+    case ColumnVector::kString:
+      return HashKeyString(value.type_kind() == TYPE_STRING
+                               ? value.string_value()
+                               : value.bytes_value());
+    case ColumnVector::kValue:
+      break;
+  }
+  // Value::HashCode() already hashes NaNs alike, and absl::Hash hashes -0.0
+  // like 0.0.
+  return Mix(value.HashCode());
+}
+
+uint64_t HashKeys(absl::Span<const Value> row, absl::Span<const int> keys,
+                  uint64_t seed) {
+  uint64_t hash = Mix(seed);
+  for (const int key : keys) {
+    hash = Combine(hash, HashKeyValue(row[key]));
+  }
+  return hash;
+}
+
+uint64_t HashKeyTuple(absl::Span<const Value> key, uint64_t seed) {
+  uint64_t hash = Mix(seed);
+  for (const Value& value : key) {
+    hash = Combine(hash, HashKeyValue(value));
+  }
+  return hash;
+}
+
+void HashBatchKeys(const ValueBatch& batch, absl::Span<const int> keys,
+                   uint64_t seed, std::vector<uint64_t>* hashes) {
+  const int num_rows = batch.num_rows();
+  hashes->assign(num_rows, Mix(seed));
+  uint64_t* out = hashes->data();
+  for (const int key : keys) {
+    const ColumnVector& column = batch.column(key);
+    DCHECK_EQ(column.size(), num_rows);
+    // Without NULLs, the typed buffers are hashed in tight loops.
+    const bool has_nulls = column.null_count() > 0;
+    if (!has_nulls && column.storage() == ColumnVector::kInt64) {
+      const int64_t* data = column.int64_data().data();
+      for (int r = 0; r < num_rows; ++r) {
+        out[r] = Combine(out[r], Int64Hash(data[r]));
+      }
+    } else if (!has_nulls && column.storage() == ColumnVector::kDouble) {
+      const double* data = column.double_data().data();
+      for (int r = 0; r < num_rows; ++r) {
+        out[r] = Combine(out[r], DoubleHash(data[r]));
+      }
+    } else {
+      for (int r = 0; r < num_rows; ++r) {
+        out[r] = Combine(out[r], ColumnHash(column, r));
+      }
+    }
+  }
+}
+
+bool KeysEqual(absl::Span<const Value> row_a, absl::Span<const int> keys_a,
+               absl::Span<const Value> row_b, absl::Span<const int> keys_b) {
+  DCHECK_EQ(keys_a.size(), keys_b.size());
+  for (int i = 0; i < keys_a.size(); ++i) {
+    // Value::Equals() treats NULLs as equal, NaNs as equal and -0.0 as
+    // equal to 0.0.
+    if (!row_a[keys_a[i]].Equals(row_b[keys_b[i]])) return false;
+  }
+  return true;
+}
+
+}  // namespace zetasql
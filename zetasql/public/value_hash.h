@@ -0,0 +1,91 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Hashing of grouping and join keys for hash tables, one row or one
+// ValueBatch column at a time.
+
+#ifndef ZETASQL_PUBLIC_VALUE_HASH_H_
+#define ZETASQL_PUBLIC_VALUE_HASH_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "zetasql/public/value.h"
+#include "zetasql/public/value_batch.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+
+namespace zetasql {
+
+// Seeded 64-bit hashes of key tuples, which are cheaper than combining
+// Value::HashCode() of each key: the scalar types that ColumnVector stores
+// in typed buffers are hashed from their int64_t, double or string
+// representation without going through absl::Hash, and strings are hashed
+// eight bytes at a time.
+//
+// Keys that are equal under KeysEqual() have equal hashes, following SQL
+// grouping semantics: all NULLs are equal, all NaNs are equal, and -0.0 is
+// equal to 0.0. A hash depends on the values but not on their Type, so the
+// key columns of rows hashed into one table must have equivalent types.
+// Hashing the rows of a ValueBatch with HashBatchKeys() gives the same
+// hashes as HashKeys() on each row.
+//
+// Different seeds give independent hashes, e.g. for the partitions of a
+// hash join and the buckets within a partition. Hashes may change between
+// binaries and must not be persisted.
+//
+// Example:
+//   std::vector<uint64_t> hashes;
+//   HashBatchKeys(batch, group_by_columns, kDefaultKeyHashSeed, &hashes);
+//   for (int r = 0; r < batch.num_rows(); ++r) {
+//     ... probe the hash table with hashes[r] ...
+//   }
+
+// The seed of HashKeys() when none is given.
+constexpr uint64_t kDefaultKeyHashSeed = 0x9e3779b97f4a7c15ULL;
+
+// Returns the hash of the key tuple made of the values of <keys> in <row>.
+uint64_t HashKeys(absl::Span<const Value> row, absl::Span<const int> keys,
+                  uint64_t seed = kDefaultKeyHashSeed);
+
+// Returns the hash of the key tuple <key>, which is HashKeys() of a row
+// holding only the key.
+uint64_t HashKeyTuple(absl::Span<const Value> key,
+                  uint64_t seed = kDefaultKeyHashSeed);
+
+// Sets <hashes> to one hash per row of <batch>, of the key tuple made of
+// the columns <keys>.
+void HashBatchKeys(const ValueBatch& batch, absl::Span<const int> keys,
+                   uint64_t seed, std::vector<uint64_t>* hashes);
+
+// Hashes of single keys, which HashKeys(), HashKeyTuple() and
+// HashBatchKeys() combine. HashKeyValue(value) is equal to the function for
+// the ColumnVector representation of <value>, or to kNullKeyHash for NULL.
+constexpr uint64_t kNullKeyHash = 0x2545f4914f6cdd1dULL;
+uint64_t HashKeyValue(const Value& value);
+uint64_t HashKeyInt64(int64_t value);
+uint64_t HashKeyDouble(double value);
+uint64_t HashKeyString(absl::string_view value);
+
+// Returns whether the values of <keys_a> in <row_a> equal those of <keys_b>
+// in <row_b>, with grouping semantics as described above.
+// REQUIRES: keys_a.size() == keys_b.size().
+bool KeysEqual(absl::Span<const Value> row_a, absl::Span<const int> keys_a,
+               absl::Span<const Value> row_b, absl::Span<const int> keys_b);
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_VALUE_HASH_H_
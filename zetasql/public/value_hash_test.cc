@@ -0,0 +1,111 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/value_hash.h"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/public/value_batch.h"
+#include "gtest/gtest.h"
+
+namespace zetasql {
+
+TEST(ValueHashTest, GroupingSemantics) {
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  EXPECT_EQ(HashKeyValue(Value::Double(nan)),
+            HashKeyValue(Value::Double(-nan)));
+  EXPECT_EQ(HashKeyValue(Value::Double(0.0)),
+            HashKeyValue(Value::Double(-0.0)));
+  EXPECT_EQ(HashKeyValue(Value::Float(-0.0f)),
+            HashKeyValue(Value::Float(0.0f)));
+  EXPECT_EQ(kNullKeyHash, HashKeyValue(Value::NullInt64()));
+  EXPECT_EQ(kNullKeyHash, HashKeyValue(Value::NullString()));
+  EXPECT_NE(HashKeyValue(Value::Int64(0)), HashKeyValue(Value::NullInt64()));
+  EXPECT_NE(HashKeyValue(Value::Double(0.0)), HashKeyValue(Value::Double(nan)));
+
+  const std::vector<Value> a = {Value::Double(-0.0), Value::NullString()};
+  const std::vector<Value> b = {Value::Double(0.0), Value::NullString()};
+  EXPECT_TRUE(KeysEqual(a, {0, 1}, b, {0, 1}));
+  EXPECT_EQ(HashKeyTuple(a), HashKeyTuple(b));
+  EXPECT_FALSE(KeysEqual(a, {0}, b, {1}));
+}
+
+TEST(ValueHashTest, SeedsAndOrder) {
+  const std::vector<Value> row = {Value::Int64(1), Value::Int64(2)};
+  EXPECT_EQ(HashKeys(row, {0, 1}), HashKeyTuple(row));
+  EXPECT_NE(HashKeys(row, {0, 1}), HashKeys(row, {1, 0}));
+  EXPECT_NE(HashKeys(row, {0, 1}, /*seed=*/1),
+            HashKeys(row, {0, 1}, /*seed=*/2));
+  EXPECT_NE(HashKeyTuple({Value::Int64(1)}), HashKeyTuple({Value::Int64(2)}));
+}
+
+TEST(ValueHashTest, Strings) {
+  // Prefixes of one string, covering the tail and the four-lane loop.
+  const std::string text =
+      "The quick brown fox jumps over the lazy dog, twice over the dog.";
+  std::vector<uint64_t> hashes;
+  for (int i = 0; i <= text.size(); ++i) {
+    const std::string prefix = text.substr(0, i);
+    EXPECT_EQ(HashKeyString(prefix), HashKeyValue(Value::String(prefix)));
+    EXPECT_EQ(HashKeyString(prefix), HashKeyValue(Value::Bytes(prefix)));
+    hashes.push_back(HashKeyString(prefix));
+  }
+  for (int i = 0; i < hashes.size(); ++i) {
+    for (int j = 0; j < i; ++j) {
+      EXPECT_NE(hashes[i], hashes[j]) << i << " " << j;
+    }
+  }
+}
+
+TEST(ValueHashTest, BatchMatchesRows) {
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  ValueBatch batch({types::Int32Type(), types::DoubleType(),
+                    types::StringType(), types::TimestampType(),
+                    types::Uint64Type()});
+  ZETASQL_ASSERT_OK(batch.AppendRow(
+      {Value::Int32(1), Value::Double(1.5), Value::String("a"),
+       Value::TimestampFromUnixMicros(10), Value::Uint64(1)}));
+  ZETASQL_ASSERT_OK(batch.AppendRow(
+      {Value::NullInt32(), Value::Double(nan), Value::NullString(),
+       Value::NullTimestamp(),
+       Value::Uint64(std::numeric_limits<uint64_t>::max())}));
+  ZETASQL_ASSERT_OK(batch.AppendRow(
+      {Value::Int32(-1), Value::Double(-0.0), Value::String(""),
+       Value::TimestampFromUnixMicros(-10), Value::NullUint64()}));
+  ZETASQL_ASSERT_OK(batch.AppendRow(
+      {Value::Int32(7), Value::NullDouble(), Value::String(std::string(40, 'x')),
+       Value::TimestampFromUnixMicros(0), Value::Uint64(0)}));
+
+  const std::vector<std::vector<int>> key_lists = {
+      {0}, {1}, {2}, {3}, {4}, {0, 1, 2, 3, 4}, {4, 2, 0}, {1, 1}};
+  for (const std::vector<int>& keys : key_lists) {
+    std::vector<uint64_t> hashes;
+    HashBatchKeys(batch, keys, /*seed=*/42, &hashes);
+    ASSERT_EQ(batch.num_rows(), hashes.size());
+    for (int r = 0; r < batch.num_rows(); ++r) {
+      EXPECT_EQ(HashKeys(batch.GetRow(r), keys, /*seed=*/42), hashes[r])
+          << "row " << r;
+    }
+  }
+}
+
+}  // namespace zetasql
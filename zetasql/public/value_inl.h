@@ -24,6 +24,8 @@
 
 #include <stddef.h>
 #include <string.h>
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <string>
 #include <utility>
@@ -40,8 +42,12 @@
 #include "zetasql/public/type.pb.h"
 #include "zetasql/public/value.h"  
 #include <cstdint>
+#include "absl/base/call_once.h"
+#include "absl/base/optimization.h"
+#include "absl/base/thread_annotations.h"
 #include "absl/hash/hash.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "zetasql/base/simple_reference_counted.h"
@@ -50,14 +56,51 @@ namespace zetasql {
 
 class Value::TypedList : public zetasql_base::SimpleReferenceCounted {
  public:
-  explicit TypedList(const Type* type) : type_(type) { CHECK(type != nullptr); }
+  explicit TypedList(const Type* type)
+      : SimpleReferenceCounted(InThreadConfinedScope()), type_(type) {
+    CHECK(type != nullptr);
+    TrackAllocation(sizeof(TypedList));
+  }
 
   TypedList(const TypedList&) = delete;
   TypedList& operator=(const TypedList&) = delete;
 
   const Type* type() const { return type_; }
-  std::vector<Value>& values() { return values_; }
+
+  // Makes this a generated list of 'size' values, the i-th of which is
+  // 'generator(i)'. REQUIRES: values() has not been called.
+  void SetGenerator(int size, std::function<Value(int)> generator) {
+    generated_.reset(new Generated{size, std::move(generator)});
+    materialized_.store(false, std::memory_order_release);
+  }
+
+  // Returns the values, which for a generated list are generated by the
+  // first call.
+  std::vector<Value>& values() {
+    if (ABSL_PREDICT_FALSE(!is_materialized())) {
+      absl::call_once(generated_->once, &TypedList::Materialize, this);
+    }
+    return values_;
+  }
+
+  bool is_materialized() const {
+    return materialized_.load(std::memory_order_acquire);
+  }
+
+  // Like values().size() and values()[i], but do not generate the values of
+  // a generated list.
+  int size() const {
+    return is_materialized() ? values_.size() : generated_->size;
+  }
+  Value value(int i) const {
+    return is_materialized() ? values_[i] : generated_->generator(i);
+  }
+
   uint64_t physical_byte_size() const {
+    // A generated list takes no memory for values until they are generated.
+    if (!is_materialized()) {
+      return sizeof(TypedList) + sizeof(Generated);
+    }
     if (physical_byte_size_.has_value()) {
       return physical_byte_size_.value();
     }
@@ -70,9 +113,33 @@ class Value::TypedList : public zetasql_base::SimpleReferenceCounted {
   }
 
  private:
+  // The state of a generated list. 'generator' is kept after the values are
+  // generated, so that value() can call it concurrently with Materialize().
+  struct Generated {
+    int size;
+    std::function<Value(int)> generator;
+    absl::once_flag once;
+  };
+
+  void Materialize() {
+    values_.reserve(generated_->size);
+    for (int i = 0; i < generated_->size; ++i) {
+      values_.push_back(generated_->generator(i));
+      // A list that is already shared must not hold thread-confined values.
+      if (!IsThreadConfined()) {
+        values_.back().ShareAcrossThreads();
+      }
+    }
+    TrackAllocation(values_.size() * sizeof(Value));
+    materialized_.store(true, std::memory_order_release);
+  }
+
   const Type* type_;  // not owned
   std::vector<Value> values_;
   mutable absl::optional<uint64_t> physical_byte_size_;
+  // Null unless this is a generated list.
+  std::unique_ptr<Generated> generated_;
+  std::atomic<bool> materialized_{true};
 };
 
 // -------------------------------------------------------
@@ -85,26 +152,113 @@ class Value::ProtoRep : public zetasql_base::SimpleReferenceCounted {
  public:
   using Cord = std::string;
   ProtoRep(const ProtoType* type, Cord value)
-      : type_(type), value_(std::move(value)) {
+      : SimpleReferenceCounted(InThreadConfinedScope()),
+        type_(type),
+        value_(std::move(value)),
+        byte_size_(value_.size()) {
     CHECK(type != nullptr);
     CHECK(type->descriptor() != nullptr);
+    TrackAllocation(physical_byte_size());
+  }
+
+  // Holds 'message', and serializes it on the first call to value().
+  ProtoRep(const ProtoType* type,
+           std::shared_ptr<const google::protobuf::Message> message)
+      : SimpleReferenceCounted(InThreadConfinedScope()),
+        type_(type),
+        message_(std::move(message)),
+        byte_size_(message_->ByteSizeLong()) {
+    CHECK(type != nullptr);
+    CHECK_EQ(type->descriptor(), message_->GetDescriptor());
+    TrackAllocation(physical_byte_size());
   }
 
   ProtoRep(const ProtoRep&) = delete;
   ProtoRep& operator=(const ProtoRep&) = delete;
 
   const ProtoType* type() const { return type_; }
-  const Cord& value() const { return value_; }
-  uint64_t physical_byte_size() const { return sizeof(ProtoRep) + value_.size(); }
+  const Cord& value() const {
+    if (message_ != nullptr) {
+      absl::call_once(serialize_once_, [this] {
+        message_->SerializePartialToString(&value_);
+      });
+    }
+    return value_;
+  }
+  // Null unless this was created from a message.
+  const std::shared_ptr<const google::protobuf::Message>& message() const {
+    return message_;
+  }
+  // For protos held as messages, the size of their bytes, whether or not
+  // they have been serialized yet.
+  uint64_t physical_byte_size() const { return sizeof(ProtoRep) + byte_size_; }
+
+  // Field values already decoded from value() by ReadProtoFieldsFromValue(),
+  // so that repeated accesses to the same field of this proto decode it once.
+  // The members other than 'value' identify the field access, as in
+  // ProtoFieldInfo. The cache never holds more than physical_byte_size()
+  // bytes of Values, and is not counted in physical_byte_size().
+  struct CachedField {
+    const google::protobuf::FieldDescriptor* descriptor;
+    int format;
+    const Type* type;
+    bool get_has_bit;
+    Value default_value;
+    Value value;
+  };
+
+  // Returns true and sets '*value' if 'field' (ignoring field.value) has been
+  // cached.
+  bool LookupField(const CachedField& field, Value* value) const
+      LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    for (const CachedField& cached : cached_fields_) {
+      if (cached.descriptor == field.descriptor &&
+          cached.format == field.format && cached.type == field.type &&
+          cached.get_has_bit == field.get_has_bit &&
+          cached.default_value.Equals(field.default_value)) {
+        *value = cached.value;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Caches 'field' if it fits within the cache budget. The cached Values are
+  // shared across threads, since this ProtoRep may be.
+  void AddField(CachedField field) LOCKS_EXCLUDED(mutex_) {
+    // 'default_value' is invalid for required fields and has bits.
+    const uint64_t field_size =
+        (field.default_value.is_valid()
+             ? field.default_value.physical_byte_size()
+             : sizeof(Value)) +
+        field.value.physical_byte_size();
+    absl::MutexLock lock(&mutex_);
+    if (cached_bytes_ + field_size > physical_byte_size()) return;
+    field.default_value.ShareAcrossThreads();
+    field.value.ShareAcrossThreads();
+    cached_bytes_ += field_size;
+    cached_fields_.push_back(std::move(field));
+  }
 
  private:
   const ProtoType* type_;
-  const Cord value_;
+  const std::shared_ptr<const google::protobuf::Message> message_;
+  // Set at construction, or from <message_> under <serialize_once_>.
+  mutable Cord value_;
+  mutable absl::once_flag serialize_once_;
+  const uint64_t byte_size_;
+
+  mutable absl::Mutex mutex_;
+  std::vector<CachedField> cached_fields_ GUARDED_BY(mutex_);
+  uint64_t cached_bytes_ GUARDED_BY(mutex_) = 0;
 };
 
 class Value::GeographyRef : public zetasql_base::SimpleReferenceCounted {
  public:
-  GeographyRef() {}
+  GeographyRef() : SimpleReferenceCounted(InThreadConfinedScope()) {
+    TrackAllocation(sizeof(GeographyRef));
+  }
   GeographyRef(const GeographyRef&) = delete;
   GeographyRef& operator=(const GeographyRef&) = delete;
 
@@ -114,13 +268,14 @@ class Value::GeographyRef : public zetasql_base::SimpleReferenceCounted {
 };
 
 // -------------------------------------------------------
-// NumericRef is ref count wrapper around NumericValue.
+// NumericRef is ref count wrapper around NumericValue. Used for NUMERIC values
+// that are too large to be stored inline in Value.
 // -------------------------------------------------------
 class Value::NumericRef : public zetasql_base::SimpleReferenceCounted {
  public:
-  NumericRef() {}
   explicit NumericRef(const NumericValue& value)
-      : value_(value) {
+      : SimpleReferenceCounted(InThreadConfinedScope()), value_(value) {
+    TrackAllocation(sizeof(NumericRef));
   }
 
   NumericRef(const NumericRef&) = delete;
@@ -135,28 +290,67 @@ class Value::NumericRef : public zetasql_base::SimpleReferenceCounted {
 };
 
 // -------------------------------------------------------
-// StringRef is ref count wrapper around std::string.
+// StringRef is ref count wrapper around std::string, or around bytes held by
+// another owner.
 // -------------------------------------------------------
 class Value::StringRef : public zetasql_base::SimpleReferenceCounted {
  public:
-  StringRef() {}
+  StringRef() : SimpleReferenceCounted(InThreadConfinedScope()) {
+    TrackAllocation(sizeof(StringRef));
+  }
   explicit StringRef(std::string value)
-      : value_(std::move(value)) {
+      : SimpleReferenceCounted(InThreadConfinedScope()),
+        value_(std::move(value)) {
+    TrackAllocation(physical_byte_size());
+  }
+  // Refers to 'data', which 'keeper' keeps alive, without copying it.
+  StringRef(absl::string_view data, std::shared_ptr<const void> keeper)
+      : SimpleReferenceCounted(InThreadConfinedScope()),
+        external_(new External{data, std::move(keeper)}) {
+    TrackAllocation(physical_byte_size());
   }
 
   StringRef(const StringRef&) = delete;
   StringRef& operator=(const StringRef&) = delete;
 
+  // Copies external bytes on the first call.
   const std::string& value() const {
+    if (ABSL_PREDICT_FALSE(external_ != nullptr)) {
+      absl::call_once(external_->copy_once, [this] {
+        value_.assign(external_->data.data(), external_->data.size());
+      });
+    }
     return value_;
   }
 
+  absl::string_view view() const {
+    return ABSL_PREDICT_FALSE(external_ != nullptr)
+               ? external_->data
+               : absl::string_view(value_);
+  }
+
+  // Returns an owner of the bytes of view(), which may be released on any
+  // thread.
+  std::shared_ptr<const void> Keep() const;
+
+  // The copy made by value() for external bytes is not counted.
   uint64_t physical_byte_size() const {
-    return sizeof(StringRef) + value_.size() * sizeof(char);
+    return sizeof(StringRef) +
+           (external_ != nullptr ? sizeof(External) + external_->data.size()
+                                 : value_.size() * sizeof(char));
   }
 
  private:
-  const std::string value_;
+  struct External {
+    absl::string_view data;
+    std::shared_ptr<const void> keeper;
+    absl::once_flag copy_once;
+  };
+
+  // Only set by value() after construction, under External::copy_once.
+  mutable std::string value_;
+  // Null unless the bytes are held by another owner.
+  const std::unique_ptr<External> external_;
 };
 
 // -------------------------------------------------------
@@ -187,7 +381,7 @@ inline void Value::Clear() {
       geography_ptr_->Unref();
       break;
     case TYPE_NUMERIC:
-      numeric_ptr_->Unref();
+      if (has_numeric_ref()) numeric_ptr_->Unref();
       break;
     case TYPE_PROTO:
       proto_ptr_->Unref();
@@ -262,8 +456,26 @@ inline Value::Value(TypeKind type_kind, std::string value)
         type_kind == TYPE_BYTES);
 }
 
-inline Value::Value(const NumericValue& numeric)
-    : type_kind_(TYPE_NUMERIC), numeric_ptr_(new NumericRef(numeric)) {
+inline Value::Value(TypeKind type_kind, absl::string_view data,
+                    std::shared_ptr<const void> keeper)
+    : type_kind_(static_cast<int16_t>(type_kind)),
+      string_ptr_(new StringRef(data, std::move(keeper))) {
+  CHECK(type_kind == TYPE_STRING ||
+        type_kind == TYPE_BYTES);
+}
+
+inline Value::Value(const NumericValue& numeric) : type_kind_(TYPE_NUMERIC) {
+  // The high 64 bits of the packed value, sign-extended from bit 95 if the
+  // value fits in 96 bits.
+  const int64_t high_bits = static_cast<int64_t>(numeric.high_bits());
+  if (high_bits > kNumericRefHighBits &&
+      high_bits <= std::numeric_limits<int32_t>::max()) {
+    numeric_high_bits_ = static_cast<int32_t>(high_bits);
+    numeric_low_bits_ = numeric.low_bits();
+  } else {
+    numeric_high_bits_ = kNumericRefHighBits;
+    numeric_ptr_ = new NumericRef(numeric);
+  }
 }
 
 inline Value Value::Struct(const StructType* type,
@@ -290,6 +502,19 @@ inline Value Value::UnsafeArray(const ArrayType* array_type,
                        std::move(values));
 }
 
+inline Value Value::ArrayBuilder::Build() {
+  Value array = UnsafeArray(array_type_, std::move(values_));
+  values_.clear();
+  return array;
+}
+
+inline Value Value::StructBuilder::Build() {
+  Value result = UnsafeStruct(struct_type_, std::move(values_));
+  values_.clear();
+  values_.reserve(struct_type_->num_fields());
+  return result;
+}
+
 inline Value Value::EmptyArray(const ArrayType* array_type) {
   return Array(array_type, {});
 }
@@ -346,6 +571,12 @@ inline Value Value::Proto(const ProtoType* type, const std::string& value) {
   return Value(type, std::move(value));
 }
 
+inline Value Value::Proto(
+    const ProtoType* type,
+    std::shared_ptr<const google::protobuf::Message> message) {
+  return Value(type, std::move(message));
+}
+
 inline Value Value::NullInt32() { return Value(types::Int32Type()); }
 inline Value Value::NullInt64() { return Value(types::Int64Type()); }
 inline Value Value::NullUint32() { return Value(types::Uint32Type()); }
@@ -465,6 +696,13 @@ inline const std::string& Value::bytes_value() const {
   return string_ptr_->value();
 }
 
+inline absl::string_view Value::string_view_value() const {
+  CHECK(type_kind_ == TYPE_STRING || type_kind_ == TYPE_BYTES)
+      << "Not a std::string or bytes value";
+  CHECK(!is_null_) << "Null value";
+  return string_ptr_->view();
+}
+
 inline int32_t Value::date_value() const {
   CHECK_EQ(TYPE_DATE, type_kind_) << "Not a date value";
   CHECK(!is_null_) << "Null value";
@@ -487,18 +725,29 @@ inline DatetimeValue Value::datetime_value() const {
       bit_field_64_value_, subsecond_nanos_);
 }
 
-inline const NumericValue& Value::numeric_value() const {
+inline NumericValue Value::numeric_value() const {
   CHECK_EQ(TYPE_NUMERIC, type_kind_) << "Not a numeric type";
   CHECK(!is_null_) << "Null value";
-  return numeric_ptr_->value();
+  if (has_numeric_ref()) return numeric_ptr_->value();
+  return NumericValue(
+      static_cast<uint64_t>(static_cast<int64_t>(numeric_high_bits_)),
+      numeric_low_bits_);
 }
 
 inline bool Value::empty() const {
-  return elements().empty();
+  return num_elements() == 0;
 }
 
 inline int Value::num_elements() const {
-  return elements().size();
+  CHECK_EQ(TYPE_ARRAY, type_kind_);
+  CHECK(!is_null()) << "Null value";
+  return list_ptr_->size();
+}
+
+inline Value Value::ElementValue(int i) const {
+  CHECK_EQ(TYPE_ARRAY, type_kind_);
+  CHECK(!is_null()) << "Null value";
+  return list_ptr_->value(i);
 }
 
 inline int Value::num_fields() const {
@@ -566,7 +815,7 @@ H Value::HashValueInternal(H h) const {
     }
     case TYPE_STRING:
     case TYPE_BYTES: {
-      return H::combine(std::move(h), string_ptr_->value());
+      return H::combine(std::move(h), string_ptr_->view());
     }
     case TYPE_DATE: {
       return H::combine(std::move(h), int32_value_);
@@ -19,9 +19,14 @@
 #include <math.h>
 #include <stdlib.h>
 #include <time.h>
+#include <algorithm>
 #include <limits>
+#include <memory>
+#include <string>
+#include <thread>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "zetasql/base/logging.h"
 
@@ -392,6 +397,109 @@ TEST_F(ValueTest, Numeric) {
     EXPECT_TRUE(!value.is_null());
     EXPECT_EQ(NumericValue(123LL), value.numeric_value());
   }
+
+  // Values that fit in 96 bits are stored inline, larger ones are not. Both
+  // must survive copies and assignments.
+  const int64_t kInt32Min = std::numeric_limits<int32_t>::min();
+  const int64_t kInt32Max = std::numeric_limits<int32_t>::max();
+  for (int64_t high_bits :
+       {int64_t{0}, int64_t{-1}, kInt32Max, kInt32Min + 1, kInt32Min,
+        kInt32Max + 1, kInt32Min - 1}) {
+    for (uint64_t low_bits : {uint64_t{0}, uint64_t{12345},
+                              std::numeric_limits<uint64_t>::max()}) {
+      const NumericValue numeric =
+          NumericValue::FromHighAndLowBits(static_cast<uint64_t>(high_bits),
+                                           low_bits)
+              .ValueOrDie();
+      const bool is_inline = high_bits > kInt32Min && high_bits <= kInt32Max;
+      Value v1 = Value::Numeric(numeric);
+      EXPECT_EQ(numeric, v1.numeric_value()) << numeric;
+      EXPECT_EQ(is_inline, v1.physical_byte_size() == sizeof(Value))
+          << numeric;
+      Value v2(v1);
+      Value v3 = Value::Numeric(NumericValue::MaxValue());
+      v3 = v1;
+      v1 = Value::NullNumeric();
+      EXPECT_EQ(numeric, v2.numeric_value()) << numeric;
+      EXPECT_EQ(numeric, v3.numeric_value()) << numeric;
+      EXPECT_EQ(v2, v3);
+      EXPECT_EQ(v2.HashCode(), Value::Numeric(numeric).HashCode());
+    }
+  }
+  EXPECT_EQ(sizeof(Value), Value::NullNumeric().physical_byte_size());
+}
+
+TEST_F(ValueTest, ThreadConfinedScope) {
+  Value array;
+  {
+    Value::ThreadConfinedScope scope;
+    std::vector<Value> values;
+    for (int i = 0; i < 10; ++i) {
+      values.push_back(Value::String(absl::StrCat("value_", i)));
+      values.push_back(Value::Bytes(absl::StrCat("bytes_", i)));
+      values.push_back(Value::Numeric(NumericValue::MaxValue()));
+    }
+    array = Value::Array(types::StringArrayType(),
+                         {values[0], values[3], values[6]});
+    // Copies and assignments of thread-confined values work as usual.
+    Value copy = array;
+    std::vector<Value> copies = values;
+    copies = values;
+    EXPECT_EQ(array, copy);
+    EXPECT_EQ(values, copies);
+    array.ShareAcrossThreads();
+  }
+
+  // After ShareAcrossThreads() the value can be copied from several threads.
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&array] {
+      for (int j = 0; j < 1000; ++j) {
+        Value copy = array;
+        Value element = copy.element(j % 3);
+        EXPECT_EQ(absl::StrCat("value_", j % 3), element.string_value());
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  EXPECT_EQ("value_2", array.element(2).string_value());
+}
+
+TEST_F(ValueTest, MemoryTrackingScope) {
+  Value::MemoryTracker tracker(/*limit_bytes=*/10000);
+  Value string;
+  {
+    Value::MemoryTrackingScope scope(&tracker);
+    string = Value::String(std::string(100, 'a'));
+    EXPECT_EQ(string.physical_byte_size() - sizeof(Value),
+              tracker.allocated_bytes());
+    // Int64 values and copies allocate nothing.
+    const int64_t before = tracker.allocated_bytes();
+    std::vector<Value> values(10, string);
+    values.push_back(Value::Int64(1));
+    EXPECT_EQ(before, tracker.allocated_bytes());
+
+    {
+      Value::MemoryTracker inner_tracker;
+      Value::MemoryTrackingScope inner_scope(&inner_tracker);
+      const Value bytes = Value::Bytes("b");
+      EXPECT_GT(inner_tracker.allocated_bytes(), 0);
+      EXPECT_EQ(before, tracker.allocated_bytes());
+    }
+
+    ZETASQL_EXPECT_OK(tracker.status());
+    std::vector<Value> elements;
+    for (int i = 0; i < 100 && !tracker.exceeded(); ++i) {
+      elements.push_back(Value::String(std::string(1000, 'x')));
+    }
+    EXPECT_LT(elements.size(), 100);
+    EXPECT_THAT(tracker.status(),
+                StatusIs(zetasql_base::StatusCode::kResourceExhausted));
+  }
+  // Without a scope, nothing is tracked.
+  const int64_t allocated = tracker.allocated_bytes();
+  const Value unscoped = Value::String("c");
+  EXPECT_EQ(allocated, tracker.allocated_bytes());
 }
 
 TEST_F(ValueTest, GenericAccessors) {
@@ -869,6 +977,72 @@ TEST_F(ValueTest, ArrayNotNull) {
   EXPECT_EQ("[1, 2]", value_copy.DebugString());
 }
 
+TEST_F(ValueTest, ArrayAndStructBuilders) {
+  const StructType* struct_type =
+      MakeStructType({{"a", Int64Type()}, {"b", StringType()}});
+  Value::ArrayBuilder array_builder(MakeArrayType(struct_type));
+  EXPECT_TRUE(array_builder.empty());
+  array_builder.reserve(3);
+  Value::StructBuilder struct_builder(struct_type);
+  for (int i = 0; i < 3; ++i) {
+    struct_builder.push_back(Value::Int64(i));
+    struct_builder.push_back(Value::String(absl::StrCat("s", i)));
+    EXPECT_EQ(2, struct_builder.size());
+    array_builder.push_back(struct_builder.Build());
+    EXPECT_EQ(0, struct_builder.size());
+  }
+  EXPECT_EQ(3, array_builder.size());
+  const Value array = TestGetSQL(array_builder.Build());
+  EXPECT_TRUE(array_builder.empty());
+  ASSERT_EQ(3, array.num_elements());
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(i, array.element(i).field(0).int64_value());
+    EXPECT_EQ(absl::StrCat("s", i), array.element(i).field(1).string_value());
+  }
+
+  // The builder can be reused.
+  const Value empty = array_builder.Build();
+  EXPECT_EQ(0, empty.num_elements());
+  EXPECT_EQ(array.type(), empty.type());
+}
+
+TEST_F(ValueTest, GeneratedArray) {
+  int num_generated = 0;
+  const Value dates = Value::GeneratedArray(
+      MakeArrayType(DateType()), 10000, [&num_generated](int i) {
+        ++num_generated;
+        return Value::Date(10957 + 7 * i);
+      });
+  EXPECT_FALSE(dates.is_null());
+  EXPECT_FALSE(dates.empty());
+  EXPECT_EQ(10000, dates.num_elements());
+  EXPECT_EQ(10957 + 7 * 42, dates.ElementValue(42).date_value());
+  EXPECT_EQ(1, num_generated);
+  // Nothing is stored until the elements are needed by reference.
+  EXPECT_LT(dates.physical_byte_size(), 1000);
+
+  const Value copy = dates;
+  EXPECT_EQ(10957 + 7 * 9999, copy.element(9999).date_value());
+  EXPECT_EQ(1 + 10000, num_generated);
+  EXPECT_GT(dates.physical_byte_size(), 10000 * sizeof(Value));
+  EXPECT_EQ(10957 + 7 * 42, dates.ElementValue(42).date_value());
+  EXPECT_EQ(1 + 10000, num_generated);
+
+  std::vector<Value> values;
+  for (int i = 0; i < 3; ++i) {
+    values.push_back(Value::Int64(i * 5));
+  }
+  const Value generated = Value::GeneratedArray(
+      Int64ArrayType(), 3, [](int i) { return Value::Int64(i * 5); });
+  EXPECT_TRUE(generated.Equals(Value::Array(Int64ArrayType(), values)));
+  EXPECT_EQ("[0, 5, 10]", generated.DebugString());
+
+  const Value empty = Value::GeneratedArray(
+      Int64ArrayType(), 0, [](int i) { return Value::Int64(i); });
+  EXPECT_TRUE(empty.empty());
+  EXPECT_TRUE(empty.Equals(Value::EmptyArray(Int64ArrayType())));
+}
+
 TEST_F(ValueTest, ArrayNull) {
   Value value = TestGetSQL(Value::Null(MakeArrayType(Int64Type())));
   EXPECT_TRUE(value.is_null());
@@ -1203,6 +1377,67 @@ TEST_F(ValueTest, StructWithNanAndInf) {
   EXPECT_FALSE(struct_anan_bnull.LessThan(struct_anan_bnull));
 }
 
+TEST_F(ValueTest, MakeComparator) {
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  const double inf = std::numeric_limits<double>::infinity();
+  const EnumType* enum_type = GetTestEnumType();
+  const std::vector<std::vector<Value>> values_of_one_type = {
+      {NullInt32(), Int32(-1), Int32(0), Int32(7)},
+      {NullInt64(), Int64(std::numeric_limits<int64_t>::min()), Int64(3)},
+      {NullUint32(), Uint32(0), Uint32(std::numeric_limits<uint32_t>::max())},
+      {NullUint64(), Uint64(1), Uint64(std::numeric_limits<uint64_t>::max())},
+      {NullBool(), Bool(false), Bool(true)},
+      {NullFloat(), Float(std::numeric_limits<float>::quiet_NaN()),
+       Float(-1.5), Float(0)},
+      {NullDouble(), Double(nan), Double(-inf), Double(0), Double(inf)},
+      {NullString(), String(""), String("a"), String("ab"), String("b")},
+      {NullBytes(), Bytes(""), Bytes("\x01"), Bytes("\xff")},
+      {NullDate(), Date(-10), Date(0), Date(10)},
+      {NullTimestamp(), TimestampFromUnixMicros(-1),
+       TimestampFromUnixMicros(0), TimestampFromUnixMicros(1)},
+      {Null(enum_type), Enum(enum_type, 0), Enum(enum_type, 1)},
+      {Null(Int64ArrayType()), EmptyArray(Int64ArrayType()),
+       Array({NullInt64()}), Int64Array({1}), Int64Array({1, 2}),
+       Int64Array({2})},
+      {Null(MakeStructType({{"a", Int64Type()}, {"b", StringType()}})),
+       Struct({"a", "b"}, {NullInt64(), String("z")}),
+       Struct({"a", "b"}, {Int64(1), NullString()}),
+       Struct({"a", "b"}, {Int64(1), String("a")}),
+       Struct({"a", "b"}, {Int64(2), String("a")})},
+  };
+  for (const std::vector<Value>& values : values_of_one_type) {
+    const Type* type = values[0].type();
+    const Value::Comparator ascending = Value::MakeComparator(type);
+    const Value::Comparator descending =
+        Value::MakeComparator(type, /*descending=*/true);
+    const Value::Comparator nulls_last = Value::MakeComparator(
+        type, /*descending=*/false, /*nulls_last=*/true);
+    const Value::Comparator descending_nulls_last = Value::MakeComparator(
+        type, /*descending=*/true, /*nulls_last=*/true);
+    for (const Value& a : values) {
+      for (const Value& b : values) {
+        const bool has_null = a.is_null() || b.is_null();
+        EXPECT_EQ(a.LessThan(b), ascending(a, b))
+            << a.DebugString() << " " << b.DebugString();
+        EXPECT_EQ(has_null ? a.LessThan(b) : b.LessThan(a), descending(a, b))
+            << a.DebugString() << " " << b.DebugString();
+        EXPECT_EQ(has_null ? b.LessThan(a) : a.LessThan(b), nulls_last(a, b))
+            << a.DebugString() << " " << b.DebugString();
+        EXPECT_EQ(b.LessThan(a), descending_nulls_last(a, b))
+            << a.DebugString() << " " << b.DebugString();
+      }
+    }
+  }
+
+  std::vector<Value> values = {Int64(2), NullInt64(), Int64(1), Int64(3)};
+  std::sort(values.begin(), values.end(),
+            Value::MakeComparator(types::Int64Type(), /*descending=*/true,
+                                  /*nulls_last=*/true));
+  EXPECT_EQ(Int64Array({3, 2, 1}).elements(),
+            std::vector<Value>(values.begin(), values.begin() + 3));
+  EXPECT_TRUE(values[3].is_null());
+}
+
 TEST_F(ValueTest, StructLessThanSimple) {
   const Value struct_a_1 = Struct({"a"}, {1});
   const Value struct_a_2 = Struct({"a"}, {2});
@@ -1528,6 +1763,84 @@ TEST_F(ValueTest, Proto) {
   TestHashEqual(set_value, unset_value);
 }
 
+TEST_F(ValueTest, ProtoFromMessage) {
+  const ProtoType* proto_type = GetTestProtoType();
+  auto message = std::make_shared<zetasql_test::KitchenSinkPB>();
+  message->set_int64_key_1(1);
+  message->set_int64_key_2(2);
+  message->add_repeated_int32_val(3);
+  const std::string bytes = message->SerializeAsString();
+
+  const Value value = Value::Proto(proto_type, message);
+  EXPECT_EQ(message.get(), value.proto_message().get());
+  EXPECT_EQ(nullptr, Value::Proto(proto_type, bytes).proto_message());
+  EXPECT_EQ(Value::Proto(proto_type, bytes).physical_byte_size(),
+            value.physical_byte_size());
+
+  // ToMessage() copies the message, without the bytes.
+  google::protobuf::DynamicMessageFactory factory;
+  std::unique_ptr<google::protobuf::Message> copy(value.ToMessage(&factory));
+  EXPECT_EQ(message->DebugString(), copy->DebugString());
+
+  // The bytes are serialized when needed, and the message does not change
+  // the value.
+  EXPECT_EQ(bytes, value.ToCord());
+  EXPECT_TRUE(value.Equals(Value::Proto(proto_type, bytes)));
+  TestHashEqual(value, Value::Proto(proto_type, bytes));
+  EXPECT_EQ(Value::Proto(proto_type, bytes).FullDebugString(),
+            value.FullDebugString());
+  ValueProto value_proto;
+  ZETASQL_ASSERT_OK(value.Serialize(&value_proto));
+  EXPECT_EQ(bytes, value_proto.proto_value());
+}
+
+TEST_F(ValueTest, ExternalBytesAndSlices) {
+  const std::string buffer(1000, 'x');
+  int num_releases = 0;
+  {
+    const Value external =
+        Value::ExternalBytes(buffer, [&num_releases] { ++num_releases; });
+    EXPECT_EQ(buffer.data(), external.string_view_value().data());
+    EXPECT_TRUE(external.Equals(Value::Bytes(buffer)));
+    TestHashEqual(external, Value::Bytes(buffer));
+    EXPECT_FALSE(external.LessThan(Value::Bytes(buffer)));
+    ValueProto value_proto;
+    ZETASQL_ASSERT_OK(external.Serialize(&value_proto));
+    EXPECT_EQ(buffer, value_proto.bytes_value());
+
+    // Large slices share the buffer, small ones are copied.
+    const Value large = external.Slice(100, 500);
+    EXPECT_EQ(buffer.data() + 100, large.string_view_value().data());
+    EXPECT_EQ(500, large.string_view_value().size());
+    const Value small = external.Slice(990, 100);
+    EXPECT_EQ(Value::Bytes(buffer.substr(990)), small);
+    EXPECT_NE(buffer.data() + 990, small.string_view_value().data());
+    EXPECT_EQ(buffer.data(),
+              external.Slice(0, 1000).string_view_value().data());
+
+    // bytes_value() copies the bytes.
+    EXPECT_EQ(buffer, external.bytes_value());
+    EXPECT_NE(buffer.data(), external.bytes_value().data());
+    EXPECT_EQ(buffer.data(), external.string_view_value().data());
+
+    Value copy = large;
+    EXPECT_EQ(0, num_releases);
+  }
+  EXPECT_EQ(1, num_releases);
+
+  // Slices of owned strings share them too, beyond the original value.
+  Value slice;
+  {
+    const Value owned = Value::String(buffer);
+    slice = owned.Slice(300, std::string::npos);
+    EXPECT_EQ(owned.string_view_value().data() + 300,
+              slice.string_view_value().data());
+  }
+  EXPECT_EQ(String(buffer.substr(300)), slice);
+  EXPECT_EQ(buffer.substr(300), slice.string_value());
+  EXPECT_EQ(Value::String("xx"), Value::ExternalString("xx", nullptr));
+}
+
 TEST_F(ValueTest, ClassAndProtoSize) {
   EXPECT_EQ(16, sizeof(Value))
       << "The size of Value class has changed, please also update the proto "
@@ -1535,7 +1848,7 @@ TEST_F(ValueTest, ClassAndProtoSize) {
   EXPECT_EQ(20, ValueProto::descriptor()->field_count())
       << "The number of fields in ValueProto has changed, please also update "
       << "the serialization code accordingly.";
-  EXPECT_EQ(1, ValueProto::Array::descriptor()->field_count())
+  EXPECT_EQ(5, ValueProto::Array::descriptor()->field_count())
       << "The number of fields in ValueProto::Array has changed, please also "
       << "update the serialization code accordingly.";
   EXPECT_EQ(1, ValueProto::Struct::descriptor()->field_count())
@@ -2164,6 +2477,116 @@ TEST_F(ValueTest, Serialize) {
                      {"t", TimestampFromUnixMicros(1430855635016138)}})}}));
 }
 
+// Roundtrips Value through ValueProto and back, with and without packed
+// arrays, and checks that SerializeToCodedStream() writes the same
+// ValueProtos.
+static void SerializeDeserializePacked(const Value& value) {
+  for (const bool pack_arrays : {false, true}) {
+    ValueProto value_proto;
+    ZETASQL_ASSERT_OK(value.Serialize(&value_proto, pack_arrays))
+        << value.DebugString();
+    auto status_or_value = Value::Deserialize(value_proto, value.type());
+    ZETASQL_ASSERT_OK(status_or_value.status()) << value_proto.DebugString();
+    EXPECT_EQ(value, status_or_value.ValueOrDie())
+        << "\nSerialized value:\n" << value_proto.DebugString();
+
+    std::string streamed;
+    {
+      google::protobuf::io::StringOutputStream string_stream(&streamed);
+      google::protobuf::io::CodedOutputStream output(&string_stream);
+      ZETASQL_ASSERT_OK(value.SerializeToCodedStream(pack_arrays, &output));
+    }
+    ValueProto streamed_proto;
+    ASSERT_TRUE(streamed_proto.ParseFromString(streamed));
+    EXPECT_THAT(streamed_proto, testing::EqualsProto(value_proto));
+    EXPECT_EQ(value_proto.ByteSizeLong(), streamed.size());
+  }
+}
+
+TEST_F(ValueTest, SerializePackedArrays) {
+  SerializeDeserializePacked(NullInt64());
+  SerializeDeserializePacked(Int64(-9876543210));
+  SerializeDeserializePacked(Null(Int64ArrayType()));
+  SerializeDeserializePacked(EmptyArray(Int64ArrayType()));
+  SerializeDeserializePacked(EmptyArray(StringArrayType()));
+  SerializeDeserializePacked(
+      Array({Int64(-1), NullInt64(), Int64(std::numeric_limits<int64_t>::max()),
+             Int64(std::numeric_limits<int64_t>::min())}));
+  SerializeDeserializePacked(Array({Int32(-5), NullInt32(), Int32(7)}));
+  SerializeDeserializePacked(
+      Array({Uint32(std::numeric_limits<uint32_t>::max()), NullUint32()}));
+  SerializeDeserializePacked(
+      Array({Uint64(std::numeric_limits<uint64_t>::max()), Uint64(0),
+             NullUint64()}));
+  SerializeDeserializePacked(Array({Bool(true), NullBool(), Bool(false)}));
+  SerializeDeserializePacked(Array({Date(-365), NullDate(), Date(365)}));
+  SerializeDeserializePacked(Array({Float(1.5), NullFloat(), Float(-0.0)}));
+  SerializeDeserializePacked(
+      Array({Double(std::numeric_limits<double>::infinity()), NullDouble(),
+             Double(3.25)}));
+  SerializeDeserializePacked(
+      Array({String(""), NullString(), String(std::string(300, 'x'))}));
+  SerializeDeserializePacked(Array({NullBytes(), Bytes("\001\000\002")}));
+
+  const EnumType* enum_type = GetTestEnumType();
+  SerializeDeserializePacked(
+      Value::Array(GetTestArrayEnumType(),
+                   {Null(enum_type), Enum(enum_type, 0), Enum(enum_type, 1)}));
+
+  // Arrays that are not packed, and packed arrays nested in them.
+  SerializeDeserializePacked(
+      Array({NullTimestamp(), TimestampFromUnixMicros(1430855635016138),
+             TimestampFromUnixMicros(0)}));
+  SerializeDeserializePacked(Array(
+      {NullDatetime(), Value::Datetime(DatetimeValue::FromYMDHMSAndNanos(
+                           1, 2, 3, 4, 5, 6, 7))}));
+  const StructType* struct_type =
+      MakeStructType({{"a", Int64ArrayType()}, {"b", BytesType()}});
+  SerializeDeserializePacked(Array(
+      {Null(struct_type),
+       Struct({{"a", Int64Array({0, 1, 300})}, {"b", Bytes("b")}}),
+       Struct({{"a", Null(Int64ArrayType())}, {"b", NullBytes()}}),
+       Struct({{"a", EmptyArray(Int64ArrayType())}, {"b", Bytes("")}})}));
+
+  // A packed array has no element ValueProtos.
+  ValueProto value_proto;
+  ZETASQL_ASSERT_OK(Int64Array({1, 2, 3}).Serialize(&value_proto,
+                                            /*pack_arrays=*/true));
+  EXPECT_EQ(0, value_proto.array_value().element_size());
+  EXPECT_EQ(3, value_proto.array_value().packed_int64_size());
+}
+
+TEST_F(ValueTest, SerializeStructsToCodedStream) {
+  SerializeDeserializePacked(Struct({}));
+  SerializeDeserializePacked(Null(MakeStructType({{"a", Int64Type()}})));
+  SerializeDeserializePacked(
+      Struct({{"a", Int64(1)}, {"b", NullString()}, {"c", String("c")}}));
+  SerializeDeserializePacked(Struct(
+      {{"a", Int64Array({1, 2})},
+       {"s", Struct({{"x", Bytes("x")}, {"y", Int32Array({-1, 3})}})},
+       {"t", TimestampFromUnixMicros(1430855635016138)}}));
+  SerializeDeserializePacked(
+      Array({Struct({{"a", Int64(1)}, {"b", String("b")}}),
+             Struct({{"a", NullInt64()}, {"b", String("")}})}));
+  SerializeDeserializePacked(
+      Array({Struct({{"s", Struct({{"i", Int64(5)}})}}),
+             Struct({{"s", Struct({{"i", Int64(6)}})}})}));
+}
+
+TEST_F(ValueTest, DeserializeInvalidPackedArrays) {
+  ValueProto value_proto;
+  ZETASQL_CHECK(google::protobuf::TextFormat::ParseFromString(
+      "array_value { packed_int64: [1, 2] packed_null_index: 2 }",
+      &value_proto));
+  EXPECT_FALSE(Value::Deserialize(value_proto, Int64ArrayType()).ok());
+  ZETASQL_CHECK(google::protobuf::TextFormat::ParseFromString(
+      "array_value { packed_double: [1] }", &value_proto));
+  EXPECT_FALSE(Value::Deserialize(value_proto, Int64ArrayType()).ok());
+  ZETASQL_CHECK(google::protobuf::TextFormat::ParseFromString(
+      "array_value { packed_strings: \"\\005ab\" }", &value_proto));
+  EXPECT_FALSE(Value::Deserialize(value_proto, StringArrayType()).ok());
+}
+
 TEST_F(ValueTest, Deserialize) {
   // Scalars.
   DeserializeSerialize("", Int32Type());
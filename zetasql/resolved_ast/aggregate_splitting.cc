@@ -0,0 +1,261 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/resolved_ast/aggregate_splitting.h"
+
+#include <utility>
+#include <vector>
+
+#include "zetasql/public/builtin_function.pb.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/function_signature.h"
+#include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/resolved_ast_deep_copy_visitor.h"
+#include "zetasql/resolved_ast/resolved_column.h"
+#include "zetasql/resolved_ast/resolved_node_kind.pb.h"
+#include "absl/strings/str_cat.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/source_location.h"
+#include "zetasql/base/status_builder.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+const char kAggregationPhaseHintName[] = "aggregation_phase";
+const char kPartialAggregationPhase[] = "PARTIAL";
+const char kFinalAggregationPhase[] = "FINAL";
+
+namespace {
+
+typedef std::vector<std::unique_ptr<const ResolvedExpr>> ExprList;
+
+std::unique_ptr<const ResolvedOption> PhaseHint(const char* phase) {
+  return MakeResolvedOption(/*qualifier=*/"", kAggregationPhaseHintName,
+                            MakeResolvedLiteral(Value::String(phase)));
+}
+
+std::unique_ptr<const ResolvedExpr> ColumnRef(const ResolvedColumn& column) {
+  return MakeResolvedColumnRef(column.type(), column, /*is_correlated=*/false);
+}
+
+// Returns the arguments of <call> after the aggregated one, like the number
+// of quantiles of APPROX_QUANTILES, which the final aggregate also needs.
+zetasql_base::StatusOr<ExprList> CopyExtraArguments(
+    const ResolvedAggregateFunctionCall* call) {
+  ExprList copies;
+  for (int i = 1; i < call->argument_list_size(); ++i) {
+    ResolvedASTDeepCopyVisitor copier;
+    ZETASQL_RETURN_IF_ERROR(call->argument_list(i)->Accept(&copier));
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ResolvedExpr> copy,
+                     copier.ConsumeRootNode<ResolvedExpr>());
+    copies.push_back(std::move(copy));
+  }
+  return copies;
+}
+
+}  // namespace
+
+zetasql_base::StatusOr<const Type*> GetPartialAggregateStateType(
+    const ResolvedAggregateFunctionCall* call, TypeFactory* type_factory) {
+  ZETASQL_RET_CHECK(call != nullptr);
+  const Function* function = call->function();
+  if (!function->IsZetaSQLBuiltin()) {
+    return ::zetasql_base::UnimplementedErrorBuilder(ZETASQL_LOC)
+           << "Cannot split aggregate function " << function->Name();
+  }
+  if (call->distinct() || call->having_modifier() != nullptr ||
+      call->order_by_item_list_size() > 0 || call->limit() != nullptr ||
+      call->null_handling_modifier() !=
+          ResolvedAggregateFunctionCall::DEFAULT_NULL_HANDLING ||
+      call->error_mode() != ResolvedAggregateFunctionCall::DEFAULT_ERROR_MODE) {
+    return ::zetasql_base::UnimplementedErrorBuilder(ZETASQL_LOC)
+           << "Cannot split call to " << function->Name()
+           << " with modifiers";
+  }
+  switch (call->signature().context_id()) {
+    case FN_COUNT:
+    case FN_COUNT_STAR:
+    case FN_COUNTIF:
+      return types::Int64Type();
+    case FN_SUM_NUMERIC:
+    case FN_APPROX_COUNT_DISTINCT:
+    case FN_APPROX_QUANTILES:
+    case FN_APPROX_TOP_COUNT:
+      return types::BytesType();
+    case FN_AVG_INT64:
+    case FN_AVG_UINT64:
+    case FN_AVG_DOUBLE:
+    case FN_AVG_NUMERIC: {
+      const bool numeric = call->signature().context_id() == FN_AVG_NUMERIC;
+      const StructType* state_type;
+      ZETASQL_RETURN_IF_ERROR(type_factory->MakeStructType(
+          {{"sum", numeric ? types::BytesType() : types::DoubleType()},
+           {"count", types::Int64Type()}},
+          &state_type));
+      return state_type;
+    }
+    case FN_SUM_INT64:
+    case FN_SUM_UINT64:
+    case FN_SUM_DOUBLE:
+    case FN_MIN:
+    case FN_MAX:
+    case FN_ANY_VALUE:
+    case FN_BIT_AND_INT32:
+    case FN_BIT_AND_INT64:
+    case FN_BIT_AND_UINT32:
+    case FN_BIT_AND_UINT64:
+    case FN_BIT_OR_INT32:
+    case FN_BIT_OR_INT64:
+    case FN_BIT_OR_UINT32:
+    case FN_BIT_OR_UINT64:
+    case FN_BIT_XOR_INT32:
+    case FN_BIT_XOR_INT64:
+    case FN_BIT_XOR_UINT32:
+    case FN_BIT_XOR_UINT64:
+    case FN_LOGICAL_AND:
+    case FN_LOGICAL_OR:
+      return call->type();
+    default:
+      return ::zetasql_base::UnimplementedErrorBuilder(ZETASQL_LOC)
+             << "Cannot split aggregate function " << function->Name();
+  }
+}
+
+zetasql_base::Status SplitAggregateScan(
+    const ColumnIdAllocator& allocate_column_id, TypeFactory* type_factory,
+    std::unique_ptr<const ResolvedAggregateScan>* aggregate,
+    AggregateSplit* split) {
+  ZETASQL_RET_CHECK(allocate_column_id);
+  ZETASQL_RET_CHECK(aggregate != nullptr && *aggregate != nullptr);
+  ZETASQL_RET_CHECK(split != nullptr);
+  auto* original = const_cast<ResolvedAggregateScan*>(aggregate->get());
+  if (original->grouping_set_list_size() > 0 ||
+      original->rollup_column_list_size() > 0) {
+    return ::zetasql_base::UnimplementedErrorBuilder(ZETASQL_LOC)
+           << "Cannot split an aggregate with grouping sets";
+  }
+
+  // Check all the aggregates before changing anything.
+  std::vector<const Type*> state_types;
+  for (const auto& computed : original->aggregate_list()) {
+    if (computed->expr()->node_kind() != RESOLVED_AGGREGATE_FUNCTION_CALL) {
+      return ::zetasql_base::UnimplementedErrorBuilder(ZETASQL_LOC)
+             << "Cannot split aggregate "
+             << computed->expr()->node_kind_string();
+    }
+    ZETASQL_ASSIGN_OR_RETURN(
+        const Type* state_type,
+        GetPartialAggregateStateType(
+            computed->expr()->GetAs<ResolvedAggregateFunctionCall>(),
+            type_factory));
+    state_types.push_back(state_type);
+  }
+
+  // Each column of the partial aggregate and of the boundary is a copy of
+  // a group-by or aggregate column with a new id.
+  std::vector<ResolvedColumn> partial_columns;
+  std::vector<ResolvedColumn> boundary_columns;
+  auto add_column = [&](const ResolvedColumn& column, const Type* type) {
+    partial_columns.emplace_back(allocate_column_id(), column.table_name_id(),
+                                 column.name_id(), type);
+    boundary_columns.emplace_back(allocate_column_id(),
+                                  column.table_name_id(), column.name_id(),
+                                  type);
+  };
+
+  std::vector<std::unique_ptr<const ResolvedComputedColumn>> partial_group_by;
+  std::vector<std::unique_ptr<const ResolvedComputedColumn>> final_group_by;
+  for (auto& computed : original->release_group_by_list()) {
+    const ResolvedColumn column = computed->column();
+    add_column(column, column.type());
+    partial_group_by.push_back(MakeResolvedComputedColumn(
+        partial_columns.back(),
+        const_cast<ResolvedComputedColumn*>(computed.get())->release_expr()));
+    final_group_by.push_back(
+        MakeResolvedComputedColumn(column, ColumnRef(boundary_columns.back())));
+  }
+
+  std::vector<std::unique_ptr<const ResolvedComputedColumn>> partial_aggregates;
+  std::vector<std::unique_ptr<const ResolvedComputedColumn>> final_aggregates;
+  std::vector<std::unique_ptr<const ResolvedComputedColumn>> aggregate_list =
+      original->release_aggregate_list();
+  for (int i = 0; i < aggregate_list.size(); ++i) {
+    const ResolvedColumn column = aggregate_list[i]->column();
+    std::unique_ptr<const ResolvedExpr> expr =
+        const_cast<ResolvedComputedColumn*>(aggregate_list[i].get())
+            ->release_expr();
+    auto* call = const_cast<ResolvedAggregateFunctionCall*>(
+        expr->GetAs<ResolvedAggregateFunctionCall>());
+    add_column(column, state_types[i]);
+
+    ExprList final_arguments;
+    final_arguments.push_back(ColumnRef(boundary_columns.back()));
+    ZETASQL_ASSIGN_OR_RETURN(ExprList extra_arguments,
+                     CopyExtraArguments(call));
+    for (auto& argument : extra_arguments) {
+      final_arguments.push_back(std::move(argument));
+    }
+    final_aggregates.push_back(MakeResolvedComputedColumn(
+        column,
+        MakeResolvedAggregateFunctionCall(
+            call->type(), call->function(), call->signature(),
+            std::move(final_arguments),
+            ResolvedFunctionCall::DEFAULT_ERROR_MODE, /*distinct=*/false,
+            ResolvedAggregateFunctionCall::DEFAULT_NULL_HANDLING,
+            /*having_modifier=*/nullptr, /*order_by_item_list=*/{},
+            /*limit=*/nullptr, call->function_call_info())));
+
+    call->set_type(state_types[i]);
+    partial_aggregates.push_back(
+        MakeResolvedComputedColumn(partial_columns.back(), std::move(expr)));
+  }
+
+  const std::string boundary_name =
+      absl::StrCat("$partial_aggregate_", allocate_column_id());
+  auto partial = MakeResolvedAggregateScan(
+      partial_columns, original->release_input_scan(),
+      std::move(partial_group_by), std::move(partial_aggregates),
+      /*grouping_set_list=*/{}, /*rollup_column_list=*/{});
+  partial->add_hint_list(PhaseHint(kPartialAggregationPhase));
+
+  auto final = MakeResolvedAggregateScan(
+      original->column_list(),
+      MakeResolvedWithRefScan(boundary_columns, boundary_name),
+      std::move(final_group_by), std::move(final_aggregates),
+      /*grouping_set_list=*/{}, /*rollup_column_list=*/{});
+  for (auto& hint : original->release_hint_list()) {
+    final->add_hint_list(std::move(hint));
+  }
+  final->add_hint_list(PhaseHint(kFinalAggregationPhase));
+
+  split->partial = std::move(partial);
+  split->final = std::move(final);
+  split->boundary_name = boundary_name;
+  aggregate->reset();
+  return ::zetasql_base::OkStatus();
+}
+
+std::unique_ptr<const ResolvedWithScan> MakeAggregateSplitScan(
+    AggregateSplit split) {
+  const std::vector<ResolvedColumn> columns = split.final->column_list();
+  std::vector<std::unique_ptr<const ResolvedWithEntry>> entries;
+  entries.push_back(
+      MakeResolvedWithEntry(split.boundary_name, std::move(split.partial)));
+  return MakeResolvedWithScan(columns, std::move(entries),
+                              std::move(split.final));
+}
+
+}  // namespace zetasql
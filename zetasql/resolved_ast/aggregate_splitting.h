@@ -0,0 +1,103 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_RESOLVED_AST_AGGREGATE_SPLITTING_H_
+#define ZETASQL_RESOLVED_AST_AGGREGATE_SPLITTING_H_
+
+#include <memory>
+#include <string>
+
+#include "zetasql/public/type.h"
+#include "zetasql/resolved_ast/common_subexpression_elimination.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "zetasql/base/status.h"
+#include "zetasql/base/statusor.h"
+
+namespace zetasql {
+
+// The name of the hint that marks the halves of a split aggregate, with
+// value kPartialAggregationPhase or kFinalAggregationPhase.
+extern const char kAggregationPhaseHintName[];
+extern const char kPartialAggregationPhase[];
+extern const char kFinalAggregationPhase[];
+
+// Returns the type of the partial state of <call> in an aggregate split by
+// SplitAggregateScan(), or kUnimplemented if <call> cannot be split.  The
+// states are those of local_service::HashAggregator in kPartial mode, and
+// the serialized sketches of zetasql/public/functions/approx_sketches.h:
+//   COUNT, COUNT(*), COUNTIF         INT64, the count.
+//   SUM of INT64, UINT64 or DOUBLE   The sum.
+//   SUM of NUMERIC                   BYTES, the serialized
+//                                    NumericValue::Aggregator of the sum.
+//   AVG                              STRUCT<sum, count INT64>, with the sum
+//                                    as for SUM, but DOUBLE for integers.
+//   MIN, MAX, ANY_VALUE, BIT_AND,    The argument type.
+//   BIT_OR, BIT_XOR, LOGICAL_AND,
+//   LOGICAL_OR
+//   APPROX_COUNT_DISTINCT            BYTES, a HyperLogLogPlusPlus.
+//   APPROX_QUANTILES                 BYTES, a KllQuantileSketch.
+//   APPROX_TOP_COUNT                 BYTES, a SpaceSavingTopK.
+// Calls with DISTINCT, HAVING, ORDER BY, LIMIT, IGNORE or RESPECT NULLS, or
+// SAFE cannot be split.  <type_factory> creates the STRUCT types.
+zetasql_base::StatusOr<const Type*> GetPartialAggregateStateType(
+    const ResolvedAggregateFunctionCall* call, TypeFactory* type_factory);
+
+// A ResolvedAggregateScan split into a partial aggregate, which can run
+// where parts of its input are, and a final aggregate merging the partial
+// states, e.g. on a coordinator.
+struct AggregateSplit {
+  // Aggregates the original input, grouped by the original group-by
+  // expressions, into the partial states of the aggregates.  Its
+  // column_list has new columns for the group-by columns followed by one
+  // state per aggregate.  It has a kAggregationPhaseHintName hint with
+  // value kPartialAggregationPhase.  Its aggregate calls are the original
+  // ones, with the type of their state.
+  std::unique_ptr<const ResolvedAggregateScan> partial;
+
+  // Merges the partial states, grouped by the group-by columns, into the
+  // original column_list.  Its input is a ResolvedWithRefScan named
+  // <boundary_name>, whose column_list matches that of <partial> 1:1 and
+  // which reads the rows of all the partial aggregates.  It has the hints
+  // of the original scan followed by a kAggregationPhaseHintName hint with
+  // value kFinalAggregationPhase.  Its aggregate calls are the original
+  // ones, each with the state of the original call as its first argument;
+  // COUNT(*) has the count as its only argument.
+  std::unique_ptr<const ResolvedAggregateScan> final;
+
+  // The with_query_name of the boundary between the two aggregates.
+  std::string boundary_name;
+};
+
+// Splits <*aggregate> into <*split>.  New columns take their ids from
+// <allocate_column_id>, which must not be empty.  Returns kUnimplemented,
+// leaving <*aggregate> unchanged, if the scan has grouping sets or an
+// aggregate that GetPartialAggregateStateType() does not accept.
+//
+// <partial> and <final> can be serialized separately, like other resolved
+// ASTs, to ship the partial aggregate to the workers.
+zetasql_base::Status SplitAggregateScan(
+    const ColumnIdAllocator& allocate_column_id, TypeFactory* type_factory,
+    std::unique_ptr<const ResolvedAggregateScan>* aggregate,
+    AggregateSplit* split);
+
+// Returns WITH <boundary_name> AS (<partial>) <final>, which computes the
+// same rows as the scan that was split, so <split> can be kept in the tree.
+std::unique_ptr<const ResolvedWithScan> MakeAggregateSplitScan(
+    AggregateSplit split);
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_RESOLVED_AST_AGGREGATE_SPLITTING_H_
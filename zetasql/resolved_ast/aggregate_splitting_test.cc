@@ -0,0 +1,246 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/resolved_ast/aggregate_splitting.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/builtin_function.pb.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/make_node_vector.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "zetasql/resolved_ast/resolved_column.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace zetasql {
+
+using zetasql_base::testing::StatusIs;
+
+class AggregateSplittingTest : public ::testing::Test {
+ protected:
+  AggregateSplittingTest()
+      : catalog_("catalog"),
+        table_("T", {{"a", types::Int64Type()}, {"n", types::NumericType()}}),
+        a_(1, "T", "a", types::Int64Type()),
+        n_(2, "T", "n", types::NumericType()),
+        g_(3, "$groupby", "a", types::Int64Type()),
+        sum_(4, "$aggregate", "sum", types::Int64Type()),
+        count_(5, "$aggregate", "count", types::Int64Type()),
+        numeric_sum_(6, "$aggregate", "numeric_sum", types::NumericType()),
+        avg_(7, "$aggregate", "avg", types::DoubleType()) {
+    catalog_.AddZetaSQLFunctions();
+  }
+
+  // Returns a call to builtin aggregate function <name> with signature <id>
+  // and the given arguments.
+  std::unique_ptr<ResolvedAggregateFunctionCall> Call(
+      const std::string& name, FunctionSignatureId id, const Type* type,
+      const std::vector<ResolvedColumn>& arguments, bool distinct = false) {
+    const Function* function = nullptr;
+    ZETASQL_CHECK_OK(catalog_.FindFunction({name}, &function));
+    std::vector<std::unique_ptr<const ResolvedExpr>> argument_list;
+    FunctionArgumentTypeList argument_types;
+    for (const ResolvedColumn& argument : arguments) {
+      argument_types.emplace_back(argument.type());
+      argument_list.push_back(ColumnRef(argument));
+    }
+    return MakeResolvedAggregateFunctionCall(
+        type, function, FunctionSignature(type, argument_types, id),
+        std::move(argument_list), ResolvedFunctionCall::DEFAULT_ERROR_MODE,
+        distinct, ResolvedAggregateFunctionCall::DEFAULT_NULL_HANDLING,
+        /*having_modifier=*/nullptr, /*order_by_item_list=*/{},
+        /*limit=*/nullptr, /*function_call_info=*/nullptr);
+  }
+
+  static std::unique_ptr<const ResolvedExpr> ColumnRef(
+      const ResolvedColumn& column) {
+    return MakeResolvedColumnRef(column.type(), column,
+                                 /*is_correlated=*/false);
+  }
+
+  // SELECT a, SUM(a), COUNT(*), SUM(n), AVG(a) FROM T GROUP BY a
+  std::unique_ptr<const ResolvedAggregateScan> Aggregate() {
+    return MakeResolvedAggregateScan(
+        {g_, sum_, count_, numeric_sum_, avg_},
+        MakeResolvedTableScan({a_, n_}, &table_,
+                              /*for_system_time_expr=*/nullptr),
+        MakeNodeVector(MakeResolvedComputedColumn(g_, ColumnRef(a_))),
+        MakeNodeVector(
+            MakeResolvedComputedColumn(
+                sum_, Call("sum", FN_SUM_INT64, types::Int64Type(), {a_})),
+            MakeResolvedComputedColumn(
+                count_,
+                Call("$count_star", FN_COUNT_STAR, types::Int64Type(), {})),
+            MakeResolvedComputedColumn(
+                numeric_sum_,
+                Call("sum", FN_SUM_NUMERIC, types::NumericType(), {n_})),
+            MakeResolvedComputedColumn(
+                avg_, Call("avg", FN_AVG_INT64, types::DoubleType(), {a_}))),
+        /*grouping_set_list=*/{}, /*rollup_column_list=*/{});
+  }
+
+  ColumnIdAllocator Allocator() {
+    return [this]() { return next_column_id_++; };
+  }
+
+  static std::string PhaseOf(const ResolvedScan* scan) {
+    for (const auto& hint : scan->hint_list()) {
+      if (hint->name() == kAggregationPhaseHintName) {
+        return hint->value()->GetAs<ResolvedLiteral>()->value().string_value();
+      }
+    }
+    return "";
+  }
+
+  SimpleCatalog catalog_;
+  SimpleTable table_;
+  TypeFactory type_factory_;
+  const ResolvedColumn a_;
+  const ResolvedColumn n_;
+  const ResolvedColumn g_;
+  const ResolvedColumn sum_;
+  const ResolvedColumn count_;
+  const ResolvedColumn numeric_sum_;
+  const ResolvedColumn avg_;
+  int next_column_id_ = 10;
+};
+
+TEST_F(AggregateSplittingTest, SplitsIntoPartialAndFinal) {
+  std::unique_ptr<const ResolvedAggregateScan> aggregate = Aggregate();
+  AggregateSplit split;
+  ZETASQL_ASSERT_OK(
+      SplitAggregateScan(Allocator(), &type_factory_, &aggregate, &split));
+  EXPECT_EQ(nullptr, aggregate);
+
+  // The partial aggregate groups the table by a, with the states as its
+  // aggregates.
+  const ResolvedAggregateScan* partial = split.partial.get();
+  EXPECT_EQ(kPartialAggregationPhase, PhaseOf(partial));
+  EXPECT_EQ(RESOLVED_TABLE_SCAN, partial->input_scan()->node_kind());
+  ASSERT_EQ(1, partial->group_by_list_size());
+  EXPECT_EQ(ColumnRef(a_)->DebugString(),
+            partial->group_by_list(0)->expr()->DebugString());
+  ASSERT_EQ(5, partial->column_list_size());
+  std::vector<int> partial_ids;
+  for (const ResolvedColumn& column : partial->column_list()) {
+    partial_ids.push_back(column.column_id());
+  }
+  EXPECT_THAT(partial_ids, ::testing::ElementsAre(10, 12, 14, 16, 18));
+  EXPECT_TRUE(partial->column_list(1).type()->IsInt64());
+  EXPECT_TRUE(partial->column_list(2).type()->IsInt64());
+  EXPECT_TRUE(partial->column_list(3).type()->IsBytes());
+  const Type* avg_state = partial->column_list(4).type();
+  ASSERT_TRUE(avg_state->IsStruct());
+  EXPECT_TRUE(avg_state->AsStruct()->field(0).type->IsDouble());
+  EXPECT_TRUE(avg_state->AsStruct()->field(1).type->IsInt64());
+  ASSERT_EQ(4, partial->aggregate_list_size());
+  EXPECT_TRUE(partial->aggregate_list(2)->expr()->type()->IsBytes());
+  EXPECT_EQ(FN_SUM_NUMERIC, partial->aggregate_list(2)
+                                ->expr()
+                                ->GetAs<ResolvedAggregateFunctionCall>()
+                                ->signature()
+                                .context_id());
+
+  // The final aggregate merges the states read through the boundary into
+  // the original columns.
+  const ResolvedAggregateScan* final = split.final.get();
+  EXPECT_EQ(kFinalAggregationPhase, PhaseOf(final));
+  EXPECT_EQ("$partial_aggregate_20", split.boundary_name);
+  EXPECT_EQ(Aggregate()->column_list(), final->column_list());
+  ASSERT_EQ(RESOLVED_WITH_REF_SCAN, final->input_scan()->node_kind());
+  const auto* boundary = final->input_scan()->GetAs<ResolvedWithRefScan>();
+  EXPECT_EQ(split.boundary_name, boundary->with_query_name());
+  ASSERT_EQ(5, boundary->column_list_size());
+  EXPECT_EQ(11, boundary->column_list(0).column_id());
+  EXPECT_EQ(g_, final->group_by_list(0)->column());
+  EXPECT_EQ(ColumnRef(boundary->column_list(0))->DebugString(),
+            final->group_by_list(0)->expr()->DebugString());
+
+  ASSERT_EQ(4, final->aggregate_list_size());
+  const auto* final_count = final->aggregate_list(1)
+                                ->expr()
+                                ->GetAs<ResolvedAggregateFunctionCall>();
+  EXPECT_EQ(count_, final->aggregate_list(1)->column());
+  EXPECT_EQ(FN_COUNT_STAR, final_count->signature().context_id());
+  ASSERT_EQ(1, final_count->argument_list_size());
+  EXPECT_EQ(ColumnRef(boundary->column_list(2))->DebugString(),
+            final_count->argument_list(0)->DebugString());
+  EXPECT_TRUE(final->aggregate_list(3)->expr()->type()->IsDouble());
+
+  // Both halves fit in one tree, in place of the original scan.
+  std::unique_ptr<const ResolvedWithScan> with_scan =
+      MakeAggregateSplitScan(std::move(split));
+  EXPECT_EQ(Aggregate()->column_list(), with_scan->column_list());
+  ASSERT_EQ(1, with_scan->with_entry_list_size());
+  EXPECT_EQ("$partial_aggregate_20",
+            with_scan->with_entry_list(0)->with_query_name());
+  EXPECT_EQ(RESOLVED_AGGREGATE_SCAN,
+            with_scan->with_entry_list(0)->with_subquery()->node_kind());
+}
+
+TEST_F(AggregateSplittingTest, KeepsAggregatesThatCannotBeSplit) {
+  // SELECT COUNT(DISTINCT a) FROM T
+  std::unique_ptr<const ResolvedAggregateScan> aggregate =
+      MakeResolvedAggregateScan(
+          {count_},
+          MakeResolvedTableScan({a_}, &table_,
+                                /*for_system_time_expr=*/nullptr),
+          /*group_by_list=*/{},
+          MakeNodeVector(MakeResolvedComputedColumn(
+              count_, Call("count", FN_COUNT, types::Int64Type(), {a_},
+                           /*distinct=*/true))),
+          /*grouping_set_list=*/{}, /*rollup_column_list=*/{});
+  const std::string original = aggregate->DebugString();
+  AggregateSplit split;
+  EXPECT_THAT(
+      SplitAggregateScan(Allocator(), &type_factory_, &aggregate, &split),
+      StatusIs(zetasql_base::StatusCode::kUnimplemented));
+  ASSERT_NE(nullptr, aggregate);
+  EXPECT_EQ(original, aggregate->DebugString());
+  EXPECT_EQ(nullptr, split.partial);
+}
+
+TEST_F(AggregateSplittingTest, StateTypes) {
+  EXPECT_THAT(GetPartialAggregateStateType(
+                  Call("string_agg", FN_STRING_AGG_STRING,
+                       types::StringType(), {}).get(),
+                  &type_factory_),
+              StatusIs(zetasql_base::StatusCode::kUnimplemented));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      const Type* type,
+      GetPartialAggregateStateType(
+          Call("approx_count_distinct", FN_APPROX_COUNT_DISTINCT,
+               types::Int64Type(), {a_}).get(),
+          &type_factory_));
+  EXPECT_TRUE(type->IsBytes());
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      type, GetPartialAggregateStateType(
+                Call("avg", FN_AVG_NUMERIC, types::NumericType(), {n_}).get(),
+                &type_factory_));
+  ASSERT_TRUE(type->IsStruct());
+  EXPECT_TRUE(type->AsStruct()->field(0).type->IsBytes());
+}
+
+}  // namespace zetasql
@@ -0,0 +1,196 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/resolved_ast/column_usage.h"
+
+#include <string>
+#include <vector>
+
+#include "zetasql/public/catalog.h"
+#include "zetasql/resolved_ast/resolved_column.h"
+#include "absl/container/flat_hash_set.h"
+#include "zetasql/base/case.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+// Returns the index in <table> of the column named <name>, or -1.
+static int FindColumnIndexByName(const Table* table, const std::string& name) {
+  for (int i = 0; i < table->NumColumns(); ++i) {
+    if (zetasql_base::StringCaseEqual(table->GetColumn(i)->Name(), name)) return i;
+  }
+  return -1;
+}
+
+namespace {
+
+// A node to visit, and the column whose liveness makes the columns it uses
+// live, or kAlwaysLive.
+struct PendingNode {
+  const ResolvedNode* node;
+  const ResolvedNode* parent;
+  int owner_column_id;
+};
+
+constexpr int kAlwaysLive = -1;
+
+// Returns true if <computed_column>, a child of <parent>, is only needed
+// when its column is: it is in the expr_list of a ResolvedProjectScan, or is
+// an aggregate or analytic function column.  GROUP BY columns and computed
+// columns elsewhere, for example in DML statements, are always needed.
+bool IsOnlyNeededIfUsed(const ResolvedNode* computed_column,
+                        const ResolvedNode* parent,
+                        std::vector<const ResolvedNode*>* child_nodes) {
+  if (parent == nullptr) return false;
+  switch (parent->node_kind()) {
+    case RESOLVED_PROJECT_SCAN:
+    case RESOLVED_ANALYTIC_FUNCTION_GROUP:
+      return true;
+    case RESOLVED_AGGREGATE_SCAN:
+      computed_column->GetChildNodes(child_nodes);
+      return child_nodes->size() == 1 &&
+             (*child_nodes)[0]->node_kind() ==
+                 RESOLVED_AGGREGATE_FUNCTION_CALL;
+    default:
+      return false;
+  }
+}
+
+// Returns true if nodes of <kind> refer to each column that they use from
+// their child scans.
+bool ListsUsedColumns(ResolvedNodeKind kind) {
+  switch (kind) {
+    case RESOLVED_QUERY_STMT:
+    case RESOLVED_SET_OPERATION_ITEM:
+    case RESOLVED_INSERT_STMT:
+    case RESOLVED_UPDATE_STMT:
+    case RESOLVED_DELETE_STMT:
+    case RESOLVED_MERGE_STMT:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+zetasql_base::Status FindTableScanColumnUsage(const ResolvedNode* node,
+                                      TableScanColumnUsage* usage) {
+  ZETASQL_RET_CHECK(node != nullptr);
+  usage->clear();
+
+  // Walk the tree, recording for each computed column the columns that its
+  // expression uses, and which columns are needed regardless of the rest of
+  // the tree.  Fields are only read through GetChildNodes() and
+  // AddColumnPointers(), so none are marked as accessed.
+  std::vector<int> live_roots;
+  absl::flat_hash_map<int, std::vector<int>> dependencies;
+  std::vector<const ResolvedTableScan*> table_scans;
+  std::vector<PendingNode> stack = {{node, nullptr, kAlwaysLive}};
+  std::vector<const ResolvedNode*> child_nodes;
+  std::vector<const ResolvedColumn*> columns;
+  const auto add_columns = [&](const ResolvedNode* current, int owner) {
+    columns.clear();
+    current->AddColumnPointers(&columns);
+    std::vector<int>& used = owner == kAlwaysLive ? live_roots
+                                                  : dependencies[owner];
+    for (const ResolvedColumn* column : columns) {
+      used.push_back(column->column_id());
+    }
+  };
+  while (!stack.empty()) {
+    const PendingNode pending = stack.back();
+    stack.pop_back();
+    const ResolvedNode* current = pending.node;
+    int owner = pending.owner_column_id;
+    if (current->node_kind() == RESOLVED_TABLE_SCAN) {
+      table_scans.push_back(current->GetAs<ResolvedTableScan>());
+    }
+    if (current->IsScan()) {
+      // The column_list of a scan only says which columns it produces.  A
+      // scan that is not the input of another scan, for example a WITH or
+      // expression subquery, is used in full by whatever consumes it, unless
+      // the consumer lists the columns it uses.
+      if (pending.parent == nullptr ||
+          (!pending.parent->IsScan() &&
+           !ListsUsedColumns(pending.parent->node_kind()))) {
+        add_columns(current, owner);
+      }
+    } else if (current->node_kind() == RESOLVED_COMPUTED_COLUMN) {
+      if (IsOnlyNeededIfUsed(current, pending.parent, &child_nodes)) {
+        columns.clear();
+        current->AddColumnPointers(&columns);
+        ZETASQL_RET_CHECK_EQ(1, columns.size());
+        owner = columns[0]->column_id();
+      }
+    } else if (current->node_kind() != RESOLVED_COLUMN_HOLDER) {
+      // Column references, output columns, the output columns of set
+      // operation branches, which decide which rows are distinct, and other
+      // columns stored outside scans.
+      add_columns(current, owner);
+    }
+    current->GetChildNodes(&child_nodes);
+    for (const ResolvedNode* child : child_nodes) {
+      stack.push_back({child, current, owner});
+    }
+  }
+
+  // Propagate liveness from the columns that are always needed.
+  absl::flat_hash_set<int> used_column_ids;
+  std::vector<int> worklist;
+  for (const int column_id : live_roots) {
+    if (used_column_ids.insert(column_id).second) {
+      worklist.push_back(column_id);
+    }
+  }
+  while (!worklist.empty()) {
+    const int column_id = worklist.back();
+    worklist.pop_back();
+    auto it = dependencies.find(column_id);
+    if (it == dependencies.end()) continue;
+    for (const int dependency : it->second) {
+      if (used_column_ids.insert(dependency).second) {
+        worklist.push_back(dependency);
+      }
+    }
+  }
+
+  for (const ResolvedTableScan* scan : table_scans) {
+    const Table* table = scan->table();
+    ZETASQL_RET_CHECK(table != nullptr);
+    const std::vector<ResolvedColumn>& column_list = scan->column_list();
+    const std::vector<int>& column_index_list = scan->column_index_list();
+    ZETASQL_RET_CHECK(column_index_list.empty() ||
+              column_index_list.size() == column_list.size());
+
+    std::vector<bool>& bits = (*usage)[scan];
+    bits.assign(table->NumColumns(), false);
+    for (int i = 0; i < column_list.size(); ++i) {
+      if (!used_column_ids.contains(column_list[i].column_id())) continue;
+      const int index = column_index_list.empty()
+                            ? FindColumnIndexByName(table, column_list[i].name())
+                            : column_index_list[i];
+      ZETASQL_RET_CHECK(index >= 0 && index < table->NumColumns())
+          << "Column " << column_list[i].DebugString()
+          << " not found in table " << table->Name();
+      bits[index] = true;
+    }
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+}  // namespace zetasql
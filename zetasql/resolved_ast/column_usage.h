@@ -0,0 +1,55 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_RESOLVED_AST_COLUMN_USAGE_H_
+#define ZETASQL_RESOLVED_AST_COLUMN_USAGE_H_
+
+#include <vector>
+
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "absl/container/flat_hash_map.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+
+// For each ResolvedTableScan, a bitset over the columns of its table.  Bit
+// i corresponds to table()->GetColumn(i).
+typedef absl::flat_hash_map<const ResolvedTableScan*, std::vector<bool>>
+    TableScanColumnUsage;
+
+// Finds, for each ResolvedTableScan in the tree rooted at <node>, which
+// columns of its table are used by the rest of the tree, for projection
+// pushdown into storage.
+//
+// Liveness is computed top-down from what the statement needs: its output
+// columns, columns referenced in filters, join conditions, GROUP BY, ORDER
+// BY and other clauses, and the outputs of set operation branches and
+// subqueries.  A computed column in a SELECT list, or an aggregate or
+// analytic function column, only makes the columns it references used if
+// it is used itself.  Appearing in the column_list of a parent scan does
+// not make a column used.  Columns that are in the table but not in the
+// scan's column_list are never used.  Scans without a column_index_list are
+// matched to table columns by name.  Fields are not marked as accessed.
+//
+// This is cheaper than AnalyzerOptions::prune_unused_columns for callers
+// that need per-scan bitsets, and works on trees that were not pruned or
+// were rewritten after analysis.
+zetasql_base::Status FindTableScanColumnUsage(const ResolvedNode* node,
+                                      TableScanColumnUsage* usage);
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_RESOLVED_AST_COLUMN_USAGE_H_
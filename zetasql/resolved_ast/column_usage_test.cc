@@ -0,0 +1,176 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/resolved_ast/column_usage.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/analyzer.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/resolved_ast/make_node_vector.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace zetasql {
+
+using testing::ElementsAre;
+
+TEST(ColumnUsageTest, TableScans) {
+  SimpleTable table("T", {{"a", types::Int64Type()},
+                          {"b", types::BoolType()},
+                          {"c", types::Int64Type()},
+                          {"d", types::Int64Type()}});
+  const ResolvedColumn a(1, "T", "a", types::Int64Type());
+  const ResolvedColumn b(2, "T", "b", types::BoolType());
+  const ResolvedColumn c(3, "T", "c", types::Int64Type());
+  const ResolvedColumn d(4, "T", "d", types::Int64Type());
+  const ResolvedColumn a2(5, "T", "a", types::Int64Type());
+  const ResolvedColumn d2(6, "T", "d", types::Int64Type());
+
+  // SELECT t1.a FROM T t1 JOIN T t2 ON t1.b WHERE ..., where the first scan
+  // has a column_index_list and the second matches columns by name.
+  auto scan1 = MakeResolvedTableScan({a, b, c, d}, &table,
+                                     /*for_system_time_expr=*/nullptr);
+  scan1->set_column_index_list({0, 1, 2, 3});
+  const ResolvedTableScan* scan1_ptr = scan1.get();
+  auto scan2 = MakeResolvedTableScan({d2, a2}, &table,
+                                     /*for_system_time_expr=*/nullptr);
+  const ResolvedTableScan* scan2_ptr = scan2.get();
+  auto join = MakeResolvedJoinScan(
+      {a, d2}, ResolvedJoinScan::INNER, std::move(scan1), std::move(scan2),
+      MakeResolvedColumnRef(types::BoolType(), b, /*is_correlated=*/false));
+  auto statement = MakeResolvedQueryStmt(
+      MakeNodeVector(MakeResolvedOutputColumn("a", a)),
+      /*is_value_table=*/false,
+      MakeResolvedProjectScan({a}, /*expr_list=*/{}, std::move(join)));
+
+  TableScanColumnUsage usage;
+  ZETASQL_ASSERT_OK(FindTableScanColumnUsage(statement.get(), &usage));
+  ASSERT_EQ(2, usage.size());
+  EXPECT_THAT(usage[scan1_ptr], ElementsAre(true, true, false, false));
+  // d2 is only in the column_list of the join.
+  EXPECT_THAT(usage[scan2_ptr], ElementsAre(false, false, false, false));
+
+  // Looking at columns does not mark fields as accessed.
+  statement->ClearFieldsAccessed();
+  ZETASQL_ASSERT_OK(FindTableScanColumnUsage(statement.get(), &usage));
+  EXPECT_FALSE(statement->CheckFieldsAccessed().ok());
+}
+
+class ColumnUsageAnalyzerTest : public ::testing::Test {
+ protected:
+  ColumnUsageAnalyzerTest() : catalog_("column_usage_test") {
+    catalog_.AddZetaSQLFunctions();
+    for (const std::string name : {"T", "U"}) {
+      catalog_.AddOwnedTable(
+          new SimpleTable(name, {{"a", types::Int64Type()},
+                                 {"b", types::Int64Type()},
+                                 {"c", types::Int64Type()},
+                                 {"d", types::Int64Type()}}));
+    }
+    // Keep every column in the scans, as if the tree had been rewritten.
+    options_.set_prune_unused_columns(false);
+  }
+
+  // Analyzes <sql> and returns the usage of each table with a single scan,
+  // by table name.
+  std::map<std::string, std::vector<bool>> UsageByTable(
+      const std::string& sql) {
+    std::unique_ptr<const AnalyzerOutput> output;
+    ZETASQL_EXPECT_OK(
+        AnalyzeStatement(sql, options_, &catalog_, &type_factory_, &output));
+    if (output == nullptr) return {};
+    TableScanColumnUsage usage;
+    ZETASQL_EXPECT_OK(
+        FindTableScanColumnUsage(output->resolved_statement(), &usage));
+    std::map<std::string, std::vector<bool>> usage_by_table;
+    for (const auto& entry : usage) {
+      EXPECT_TRUE(usage_by_table.emplace(entry.first->table()->Name(),
+                                         entry.second)
+                      .second)
+          << sql;
+    }
+    return usage_by_table;
+  }
+
+  AnalyzerOptions options_;
+  SimpleCatalog catalog_;
+  TypeFactory type_factory_;
+};
+
+TEST_F(ColumnUsageAnalyzerTest, Projections) {
+  EXPECT_THAT(UsageByTable("SELECT a FROM T")["T"],
+              ElementsAre(true, false, false, false));
+  EXPECT_THAT(UsageByTable("SELECT * FROM T")["T"],
+              ElementsAre(true, true, true, true));
+  // Unused SELECT list columns of a subquery do not count.
+  EXPECT_THAT(
+      UsageByTable("SELECT x FROM (SELECT a + 1 AS x, b + c AS y, d FROM T)")
+          ["T"],
+      ElementsAre(true, false, false, false));
+  EXPECT_THAT(UsageByTable("SELECT y FROM (SELECT y FROM (SELECT a AS x, "
+                           "b * 2 AS y FROM T))")["T"],
+              ElementsAre(false, true, false, false));
+}
+
+TEST_F(ColumnUsageAnalyzerTest, FiltersJoinsAndOrderBy) {
+  EXPECT_THAT(UsageByTable("SELECT a FROM T WHERE c > 0 ORDER BY d")["T"],
+              ElementsAre(true, false, true, true));
+  std::map<std::string, std::vector<bool>> usage =
+      UsageByTable("SELECT T.a FROM T JOIN U ON T.b = U.c WHERE U.d > 1");
+  EXPECT_THAT(usage["T"], ElementsAre(true, true, false, false));
+  EXPECT_THAT(usage["U"], ElementsAre(false, false, true, true));
+}
+
+TEST_F(ColumnUsageAnalyzerTest, Aggregates) {
+  // GROUP BY columns are needed even if they are not selected.
+  EXPECT_THAT(UsageByTable("SELECT SUM(c) FROM T GROUP BY d")["T"],
+              ElementsAre(false, false, true, true));
+  EXPECT_THAT(UsageByTable("SELECT d FROM (SELECT d, SUM(c) AS s, MAX(a) "
+                           "FROM T GROUP BY d)")["T"],
+              ElementsAre(false, false, false, true));
+  EXPECT_THAT(UsageByTable("SELECT COUNT(*) FROM T")["T"],
+              ElementsAre(false, false, false, false));
+  EXPECT_THAT(UsageByTable("SELECT s FROM (SELECT SUM(a) AS s, b FROM T "
+                           "GROUP BY b HAVING MAX(c) > 0)")["T"],
+              ElementsAre(true, true, true, false));
+}
+
+TEST_F(ColumnUsageAnalyzerTest, SubqueriesAndSetOperations) {
+  std::map<std::string, std::vector<bool>> usage = UsageByTable(
+      "SELECT a, (SELECT MAX(b) FROM U WHERE U.c = T.c) FROM T");
+  EXPECT_THAT(usage["T"], ElementsAre(true, false, true, false));
+  EXPECT_THAT(usage["U"], ElementsAre(false, true, true, false));
+
+  usage = UsageByTable(
+      "SELECT x FROM (SELECT a AS x, b FROM T UNION DISTINCT "
+      "SELECT c, d FROM U)");
+  EXPECT_THAT(usage["T"], ElementsAre(true, true, false, false));
+  EXPECT_THAT(usage["U"], ElementsAre(false, false, true, true));
+
+  EXPECT_THAT(
+      UsageByTable("WITH q AS (SELECT a, b + 1 AS y FROM T) SELECT a FROM q")
+          ["T"],
+      ElementsAre(true, true, false, false));
+}
+
+}  // namespace zetasql
@@ -0,0 +1,426 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/resolved_ast/common_subexpression_elimination.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/public/builtin_function.pb.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/id_string.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "zetasql/resolved_ast/resolved_column.h"
+#include "zetasql/resolved_ast/resolved_node_kind.pb.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/container/node_hash_map.h"
+#include "absl/memory/memory.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/status_macros.h"
+#include "zetasql/base/statusor.h"
+
+namespace zetasql {
+
+namespace {
+
+typedef std::unique_ptr<const ResolvedNode>* NodeSlot;
+
+// Returns the slots of the children of <node>, which the caller owns.
+std::vector<NodeSlot> MutableChildren(const ResolvedNode* node) {
+  std::vector<NodeSlot> children;
+  const_cast<ResolvedNode*>(node)->AddMutableChildNodePointers(&children);
+  return children;
+}
+
+// Returns the slot in <slots> holding <node>, or null.
+NodeSlot FindSlot(const std::vector<NodeSlot>& slots, const ResolvedNode* node) {
+  for (NodeSlot slot : slots) {
+    if (slot->get() == node) return slot;
+  }
+  return nullptr;
+}
+
+// Returns true for the expressions that can be shared, provided their
+// arguments can.
+bool IsShareableKind(const ResolvedNode* node) {
+  switch (node->node_kind()) {
+    case RESOLVED_FUNCTION_CALL:
+    case RESOLVED_CAST:
+    case RESOLVED_GET_STRUCT_FIELD:
+    case RESOLVED_GET_PROTO_FIELD:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns true if <call> only evaluates its first argument for every row,
+// and the others depending on its value.
+bool HasConditionalArguments(const ResolvedFunctionCall* call) {
+  if (!call->function()->IsZetaSQLBuiltin()) return false;
+  switch (call->signature().context_id()) {
+    case FN_AND:
+    case FN_OR:
+    case FN_IF:
+    case FN_IFNULL:
+    case FN_COALESCE:
+    case FN_CASE_NO_VALUE:
+    case FN_CASE_WITH_VALUE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Where the expressions of one group of scans are computed.
+enum Placement {
+  // Below the filter, for the filter and the scan consuming it.
+  kBelowFilter,
+  // Between the filter, if any, and the scan consuming it.
+  kBelowConsumer,
+};
+
+// The occurrences of one expression in a group of scans.
+struct Candidate {
+  explicit Candidate(const ResolvedExpr* expr) : expr(expr) {}
+
+  const ResolvedExpr* expr;  // The first occurrence.
+  int count_in_filter = 0;
+  int count_in_consumer = 0;
+  bool unconditional_in_filter = false;
+  bool unconditional_in_consumer = false;
+};
+
+class CommonSubexpressionEliminator {
+ public:
+  explicit CommonSubexpressionEliminator(ColumnIdAllocator allocate_column_id)
+      : allocate_column_id_(std::move(allocate_column_id)) {}
+
+  CommonSubexpressionEliminator(const CommonSubexpressionEliminator&) = delete;
+  CommonSubexpressionEliminator& operator=(
+      const CommonSubexpressionEliminator&) = delete;
+
+  // Rewrites every scan in the tree at <root>, top-down.
+  zetasql_base::Status Rewrite(const ResolvedNode* root) {
+    std::vector<const ResolvedNode*> stack = {root};
+    std::vector<const ResolvedNode*> children;
+    while (!stack.empty()) {
+      const ResolvedNode* node = stack.back();
+      stack.pop_back();
+      switch (node->node_kind()) {
+        case RESOLVED_PROJECT_SCAN:
+          ZETASQL_RETURN_IF_ERROR(RewriteProjectScan(
+              const_cast<ResolvedProjectScan*>(
+                  node->GetAs<ResolvedProjectScan>())));
+          break;
+        case RESOLVED_AGGREGATE_SCAN:
+          ZETASQL_RETURN_IF_ERROR(RewriteAggregateScan(
+              const_cast<ResolvedAggregateScan*>(
+                  node->GetAs<ResolvedAggregateScan>())));
+          break;
+        case RESOLVED_FILTER_SCAN:
+          if (!consumed_filters_.contains(node)) {
+            ZETASQL_RETURN_IF_ERROR(RewriteGroup(
+                /*consumer_exprs=*/{},
+                const_cast<ResolvedFilterScan*>(
+                    node->GetAs<ResolvedFilterScan>()),
+                /*below_consumer=*/nullptr));
+          }
+          break;
+        default:
+          break;
+      }
+      node->GetChildNodes(&children);
+      stack.insert(stack.end(), children.begin(), children.end());
+    }
+    return ::zetasql_base::OkStatus();
+  }
+
+ private:
+  zetasql_base::Status RewriteProjectScan(ResolvedProjectScan* scan) {
+    std::vector<NodeSlot> exprs;
+    for (const auto& computed_column : scan->expr_list()) {
+      ZETASQL_ASSIGN_OR_RETURN(NodeSlot slot, ExprSlot(computed_column.get()));
+      exprs.push_back(slot);
+    }
+    std::vector<std::unique_ptr<const ResolvedComputedColumn>> below_consumer;
+    ZETASQL_RETURN_IF_ERROR(
+        RewriteGroup(exprs, InputFilter(scan->input_scan()), &below_consumer));
+    if (!below_consumer.empty()) {
+      scan->set_input_scan(AddProjectScan(std::move(below_consumer),
+                                          scan->release_input_scan()));
+    }
+    return ::zetasql_base::OkStatus();
+  }
+
+  zetasql_base::Status RewriteAggregateScan(ResolvedAggregateScan* scan) {
+    std::vector<NodeSlot> exprs;
+    for (const auto& computed_column : scan->group_by_list()) {
+      ZETASQL_ASSIGN_OR_RETURN(NodeSlot slot, ExprSlot(computed_column.get()));
+      exprs.push_back(slot);
+    }
+    for (const auto& computed_column : scan->aggregate_list()) {
+      const ResolvedExpr* expr = computed_column->expr();
+      if (expr->node_kind() != RESOLVED_AGGREGATE_FUNCTION_CALL) continue;
+      const auto* call = expr->GetAs<ResolvedAggregateFunctionCall>();
+      const std::vector<NodeSlot> children = MutableChildren(call);
+      for (const auto& argument : call->argument_list()) {
+        NodeSlot slot = FindSlot(children, argument.get());
+        ZETASQL_RET_CHECK(slot != nullptr);
+        exprs.push_back(slot);
+      }
+    }
+    std::vector<std::unique_ptr<const ResolvedComputedColumn>> below_consumer;
+    ZETASQL_RETURN_IF_ERROR(
+        RewriteGroup(exprs, InputFilter(scan->input_scan()), &below_consumer));
+    if (!below_consumer.empty()) {
+      scan->set_input_scan(AddProjectScan(std::move(below_consumer),
+                                          scan->release_input_scan()));
+    }
+    return ::zetasql_base::OkStatus();
+  }
+
+  static zetasql_base::StatusOr<NodeSlot> ExprSlot(
+      const ResolvedComputedColumn* computed_column) {
+    NodeSlot slot =
+        FindSlot(MutableChildren(computed_column), computed_column->expr());
+    ZETASQL_RET_CHECK(slot != nullptr);
+    return slot;
+  }
+
+  ResolvedFilterScan* InputFilter(const ResolvedScan* input) {
+    if (input == nullptr || input->node_kind() != RESOLVED_FILTER_SCAN) {
+      return nullptr;
+    }
+    consumed_filters_.insert(input);
+    return const_cast<ResolvedFilterScan*>(input->GetAs<ResolvedFilterScan>());
+  }
+
+  // Shares expressions between <consumer_exprs>, computed by a scan, and the
+  // filter_expr of <filter>, that scan's input, which may be null.  The
+  // expressions that only the consumer shares are added to
+  // <*below_consumer>, to be computed by a scan the caller inserts below the
+  // consumer.
+  zetasql_base::Status RewriteGroup(
+      const std::vector<NodeSlot>& consumer_exprs, ResolvedFilterScan* filter,
+      std::vector<std::unique_ptr<const ResolvedComputedColumn>>*
+          below_consumer) {
+    STATIC_IDSTRING(kTableName, "$subexpr");
+    STATIC_IDSTRING(kColumnName, "$expr");
+
+    std::vector<NodeSlot> filter_exprs;
+    if (filter != nullptr) {
+      NodeSlot slot =
+          FindSlot(MutableChildren(filter), filter->filter_expr());
+      ZETASQL_RET_CHECK(slot != nullptr);
+      filter_exprs.push_back(slot);
+    }
+
+    std::vector<std::unique_ptr<const ResolvedComputedColumn>> below_filter;
+    while (true) {
+      candidates_.clear();
+      candidate_order_.clear();
+      for (NodeSlot slot : filter_exprs) {
+        Collect(slot->get(), /*in_filter=*/true, /*conditional=*/false);
+      }
+      for (NodeSlot slot : consumer_exprs) {
+        Collect(slot->get(), /*in_filter=*/false, /*conditional=*/false);
+      }
+
+      const std::string* best = nullptr;
+      Placement best_placement = kBelowFilter;
+      for (const std::string* key : candidate_order_) {
+        const Candidate& candidate = candidates_.at(*key);
+        Placement placement;
+        if (candidate.unconditional_in_filter &&
+            candidate.count_in_filter + candidate.count_in_consumer >= 2) {
+          placement = kBelowFilter;
+        } else if (candidate.unconditional_in_consumer &&
+                   candidate.count_in_consumer >= 2) {
+          placement = kBelowConsumer;
+        } else {
+          continue;
+        }
+        if (best == nullptr || key->size() > best->size()) {
+          best = key;
+          best_placement = placement;
+        }
+      }
+      if (best == nullptr) break;
+
+      const ResolvedColumn column(allocate_column_id_(), kTableName,
+                                  kColumnName,
+                                  candidates_.at(*best).expr->type());
+      std::unique_ptr<const ResolvedNode> expr;
+      if (best_placement == kBelowFilter) {
+        for (NodeSlot slot : filter_exprs) {
+          Replace(*best, column, slot, &expr);
+        }
+      }
+      for (NodeSlot slot : consumer_exprs) {
+        Replace(*best, column, slot, &expr);
+      }
+      ZETASQL_RET_CHECK(expr != nullptr);
+      auto computed_column = MakeResolvedComputedColumn(
+          column, absl::WrapUnique(expr.release()->GetAs<ResolvedExpr>()));
+      if (best_placement == kBelowFilter) {
+        below_filter.push_back(std::move(computed_column));
+      } else {
+        ZETASQL_RET_CHECK(below_consumer != nullptr);
+        below_consumer->push_back(std::move(computed_column));
+      }
+    }
+    candidates_.clear();
+    candidate_order_.clear();
+
+    if (!below_filter.empty()) {
+      for (const auto& computed_column : below_filter) {
+        filter->add_column_list(computed_column->column());
+      }
+      filter->set_input_scan(
+          AddProjectScan(std::move(below_filter), filter->release_input_scan()));
+    }
+    return ::zetasql_base::OkStatus();
+  }
+
+  // Returns a scan computing <expr_list> over the rows of <input>.
+  static std::unique_ptr<const ResolvedScan> AddProjectScan(
+      std::vector<std::unique_ptr<const ResolvedComputedColumn>> expr_list,
+      std::unique_ptr<const ResolvedScan> input) {
+    std::vector<ResolvedColumn> columns = input->column_list();
+    for (const auto& computed_column : expr_list) {
+      columns.push_back(computed_column->column());
+    }
+    return MakeResolvedProjectScan(columns, std::move(expr_list),
+                                   std::move(input));
+  }
+
+  // Records the candidates in <node>, and returns true if <node> only
+  // depends on columns, literals and parameters through expressions that can
+  // be shared.  <conditional> is true if <node> is not computed for every
+  // row.
+  bool Collect(const ResolvedNode* node, bool in_filter, bool conditional) {
+    bool shareable;
+    switch (node->node_kind()) {
+      case RESOLVED_LITERAL:
+      case RESOLVED_PARAMETER:
+      case RESOLVED_EXPRESSION_COLUMN:
+        return true;
+      case RESOLVED_COLUMN_REF:
+        return !node->GetAs<ResolvedColumnRef>()->is_correlated();
+      case RESOLVED_FUNCTION_CALL: {
+        const auto* call = node->GetAs<ResolvedFunctionCall>();
+        shareable = call->function()->function_options().volatility !=
+                    FunctionEnums::VOLATILE;
+        const bool lazy = HasConditionalArguments(call);
+        for (int i = 0; i < call->argument_list_size(); ++i) {
+          if (!Collect(call->argument_list(i), in_filter,
+                       conditional || (lazy && i > 0))) {
+            shareable = false;
+          }
+        }
+        break;
+      }
+      case RESOLVED_CAST:
+        shareable =
+            Collect(node->GetAs<ResolvedCast>()->expr(), in_filter, conditional);
+        break;
+      case RESOLVED_GET_STRUCT_FIELD:
+        shareable = Collect(node->GetAs<ResolvedGetStructField>()->expr(),
+                            in_filter, conditional);
+        break;
+      case RESOLVED_GET_PROTO_FIELD:
+        shareable = Collect(node->GetAs<ResolvedGetProtoField>()->expr(),
+                            in_filter, conditional);
+        break;
+      default:
+        return false;
+    }
+    if (!shareable) return false;
+
+    auto inserted = candidates_.emplace(node->DebugString(),
+                                        node->GetAs<ResolvedExpr>());
+    Candidate& candidate = inserted.first->second;
+    if (inserted.second) candidate_order_.push_back(&inserted.first->first);
+    if (in_filter) {
+      ++candidate.count_in_filter;
+      if (!conditional) candidate.unconditional_in_filter = true;
+    } else {
+      ++candidate.count_in_consumer;
+      if (!conditional) candidate.unconditional_in_consumer = true;
+    }
+    return true;
+  }
+
+  // Replaces the expressions matching <key> in the tree at <slot> by
+  // references to <column>.  The first one replaced goes to <*expr>.
+  static void Replace(const std::string& key, const ResolvedColumn& column,
+                      NodeSlot slot, std::unique_ptr<const ResolvedNode>* expr) {
+    const ResolvedNode* node = slot->get();
+    if (!IsShareableKind(node)) return;
+    if (node->DebugString() == key) {
+      std::unique_ptr<const ResolvedNode> ref =
+          MakeResolvedColumnRef(column.type(), column, /*is_correlated=*/false);
+      std::swap(*slot, ref);
+      if (*expr == nullptr) *expr = std::move(ref);
+      return;
+    }
+    for (NodeSlot child : MutableChildren(node)) {
+      Replace(key, column, child, expr);
+    }
+  }
+
+  const ColumnIdAllocator allocate_column_id_;
+  absl::flat_hash_set<const ResolvedNode*> consumed_filters_;
+
+  // The candidates found in the group being rewritten, by DebugString(), and
+  // their keys in the order they were found.
+  absl::node_hash_map<std::string, Candidate> candidates_;
+  std::vector<const std::string*> candidate_order_;
+};
+
+}  // namespace
+
+zetasql_base::Status EliminateCommonSubexpressions(
+    const ColumnIdAllocator& allocate_column_id,
+    std::unique_ptr<const ResolvedNode>* root) {
+  ZETASQL_RET_CHECK(root != nullptr && *root != nullptr);
+  ColumnIdAllocator allocator = allocate_column_id;
+  if (!allocator) {
+    int max_column_id = 0;
+    std::vector<const ResolvedNode*> stack = {root->get()};
+    std::vector<const ResolvedNode*> children;
+    std::vector<const ResolvedColumn*> columns;
+    while (!stack.empty()) {
+      const ResolvedNode* node = stack.back();
+      stack.pop_back();
+      columns.clear();
+      node->AddColumnPointers(&columns);
+      for (const ResolvedColumn* column : columns) {
+        max_column_id = std::max(max_column_id, column->column_id());
+      }
+      node->GetChildNodes(&children);
+      stack.insert(stack.end(), children.begin(), children.end());
+    }
+    allocator = [max_column_id]() mutable { return ++max_column_id; };
+  }
+  CommonSubexpressionEliminator eliminator(std::move(allocator));
+  return eliminator.Rewrite(root->get());
+}
+
+}  // namespace zetasql
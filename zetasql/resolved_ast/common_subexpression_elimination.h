@@ -0,0 +1,65 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_RESOLVED_AST_COMMON_SUBEXPRESSION_ELIMINATION_H_
+#define ZETASQL_RESOLVED_AST_COMMON_SUBEXPRESSION_ELIMINATION_H_
+
+#include <functional>
+#include <memory>
+
+#include "zetasql/resolved_ast/resolved_node.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+
+// Returns a new column id, distinct from all others in the tree, each time
+// it is called.
+typedef std::function<int()> ColumnIdAllocator;
+
+// Computes expressions that a scan would otherwise compute several times
+// per row only once, in the tree at <*root>, which is modified in place.
+//
+// For example, in
+//   SELECT UPPER(s) AS u, CONCAT(UPPER(s), 'x') AS v FROM T
+//   WHERE UPPER(s) != ''
+// UPPER(s) is computed, into a new column, by a ResolvedProjectScan
+// inserted below the ResolvedFilterScan, and all three occurrences are
+// replaced by references to that column.
+//
+// Expressions are shared between the expr_list of a ResolvedProjectScan,
+// the group_by_list and aggregate function arguments of a
+// ResolvedAggregateScan, and the filter_expr of a ResolvedFilterScan that
+// is one of these scans' input or stands alone.  Expressions are matched
+// structurally, so they must reference the same columns.  Only function
+// calls, casts and field accesses over columns, literals and parameters are
+// shared, and never calls to VOLATILE functions.  Larger expressions are
+// shared first.
+//
+// An expression is only moved to where it is computed for every row if one
+// of its occurrences was too: occurrences in the arguments of AND, OR, IF,
+// IFNULL, COALESCE and CASE other than the first do not count, so that
+// errors like division by zero are not raised for rows that would not have
+// computed the expression.
+//
+// New columns take their ids from <allocate_column_id>.  If it is empty,
+// they are numbered after the largest column id in the tree.
+zetasql_base::Status EliminateCommonSubexpressions(
+    const ColumnIdAllocator& allocate_column_id,
+    std::unique_ptr<const ResolvedNode>* root);
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_RESOLVED_AST_COMMON_SUBEXPRESSION_ELIMINATION_H_
@@ -0,0 +1,261 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/resolved_ast/common_subexpression_elimination.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/builtin_function.pb.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/make_node_vector.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "zetasql/resolved_ast/resolved_column.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+
+namespace zetasql {
+
+class CommonSubexpressionEliminationTest : public ::testing::Test {
+ protected:
+  CommonSubexpressionEliminationTest()
+      : table_("T", {{"a", types::Int64Type()}, {"b", types::BoolType()}}),
+        a_(1, "T", "a", types::Int64Type()),
+        b_(2, "T", "b", types::BoolType()) {}
+
+  // Returns a call to builtin function <name> with signature <id>, returning
+  // the type of its last argument.
+  template <typename T>
+  std::unique_ptr<const ResolvedExpr> Call(
+      const std::string& name, FunctionSignatureId id,
+      std::vector<std::unique_ptr<T>> argument_nodes,
+      const FunctionOptions& options = FunctionOptions()) {
+    functions_.push_back(absl::make_unique<Function>(
+        name, Function::kZetaSQLFunctionGroupName, Function::SCALAR,
+        options));
+    std::vector<std::unique_ptr<const ResolvedExpr>> arguments;
+    FunctionArgumentTypeList argument_types;
+    for (auto& argument : argument_nodes) {
+      argument_types.emplace_back(argument->type());
+      arguments.push_back(std::move(argument));
+    }
+    const Type* type = arguments.back()->type();
+    return MakeResolvedFunctionCall(
+        type, functions_.back().get(),
+        FunctionSignature(type, argument_types, id), std::move(arguments),
+        ResolvedFunctionCall::DEFAULT_ERROR_MODE);
+  }
+
+  // a + <value>
+  std::unique_ptr<const ResolvedExpr> APlus(int64_t value) {
+    return Call("$add", FN_ADD_INT64,
+                MakeNodeVector(ColumnRef(a_), Int64(value)));
+  }
+
+  static std::unique_ptr<const ResolvedExpr> ColumnRef(
+      const ResolvedColumn& column) {
+    return MakeResolvedColumnRef(column.type(), column,
+                                 /*is_correlated=*/false);
+  }
+
+  static std::unique_ptr<const ResolvedExpr> Int64(int64_t value) {
+    return MakeResolvedLiteral(Value::Int64(value));
+  }
+
+  std::unique_ptr<const ResolvedScan> TableScan() {
+    return MakeResolvedTableScan({a_, b_}, &table_,
+                                 /*for_system_time_expr=*/nullptr);
+  }
+
+  // Returns a scan computing <exprs>, as columns 10, 11 and so on, over
+  // <input>.
+  template <typename T>
+  static std::unique_ptr<const ResolvedProjectScan> Project(
+      std::vector<std::unique_ptr<T>> exprs,
+      std::unique_ptr<const ResolvedScan> input) {
+    std::vector<ResolvedColumn> columns;
+    std::vector<std::unique_ptr<const ResolvedComputedColumn>> expr_list;
+    for (auto& expr : exprs) {
+      columns.emplace_back(10 + columns.size(), "$query", "c", expr->type());
+      expr_list.push_back(
+          MakeResolvedComputedColumn(columns.back(), std::move(expr)));
+    }
+    return MakeResolvedProjectScan(columns, std::move(expr_list),
+                                   std::move(input));
+  }
+
+  static std::unique_ptr<const ResolvedNode> Eliminate(
+      std::unique_ptr<const ResolvedNode> node) {
+    ZETASQL_EXPECT_OK(EliminateCommonSubexpressions(ColumnIdAllocator(), &node));
+    return node;
+  }
+
+  // Returns the column referenced by <expr>, which must be a column ref.
+  static ResolvedColumn Referenced(const ResolvedExpr* expr) {
+    EXPECT_EQ(RESOLVED_COLUMN_REF, expr->node_kind());
+    if (expr->node_kind() != RESOLVED_COLUMN_REF) return ResolvedColumn();
+    return expr->GetAs<ResolvedColumnRef>()->column();
+  }
+
+  SimpleTable table_;
+  const ResolvedColumn a_;
+  const ResolvedColumn b_;
+  std::vector<std::unique_ptr<const Function>> functions_;
+};
+
+TEST_F(CommonSubexpressionEliminationTest, SharesWithinProjectScan) {
+  // SELECT a + 1, (a + 1) * (a + 1), a + 2 FROM T
+  auto node = Eliminate(Project(
+      MakeNodeVector(APlus(1),
+                     Call("$multiply", FN_MULTIPLY_INT64,
+                          MakeNodeVector(APlus(1), APlus(1))),
+                     APlus(2)),
+      TableScan()));
+
+  const auto* project = node->GetAs<ResolvedProjectScan>();
+  ASSERT_EQ(RESOLVED_PROJECT_SCAN, project->input_scan()->node_kind());
+  const auto* shared = project->input_scan()->GetAs<ResolvedProjectScan>();
+  EXPECT_EQ(RESOLVED_TABLE_SCAN, shared->input_scan()->node_kind());
+  ASSERT_EQ(1, shared->expr_list_size());
+  const ResolvedColumn column = shared->expr_list(0)->column();
+  EXPECT_EQ(13, column.column_id());
+  EXPECT_EQ(APlus(1)->DebugString(), shared->expr_list(0)->expr()->DebugString());
+  EXPECT_EQ(std::vector<ResolvedColumn>({a_, b_, column}),
+            shared->column_list());
+
+  EXPECT_EQ(column, Referenced(project->expr_list(0)->expr()));
+  const auto* product =
+      project->expr_list(1)->expr()->GetAs<ResolvedFunctionCall>();
+  EXPECT_EQ(column, Referenced(product->argument_list(0)));
+  EXPECT_EQ(column, Referenced(product->argument_list(1)));
+  EXPECT_EQ(RESOLVED_FUNCTION_CALL,
+            project->expr_list(2)->expr()->node_kind());
+}
+
+TEST_F(CommonSubexpressionEliminationTest, SharesWithFilter) {
+  // SELECT a + 1 FROM T WHERE a + 1 > 5
+  auto filter = MakeResolvedFilterScan(
+      {a_, b_}, TableScan(),
+      Call("$greater", FN_GREATER,
+           MakeNodeVector(APlus(1), Int64(5))));
+  auto node = Eliminate(Project(MakeNodeVector(APlus(1)), std::move(filter)));
+
+  const auto* project = node->GetAs<ResolvedProjectScan>();
+  ASSERT_EQ(RESOLVED_FILTER_SCAN, project->input_scan()->node_kind());
+  const auto* filter_scan = project->input_scan()->GetAs<ResolvedFilterScan>();
+  ASSERT_EQ(RESOLVED_PROJECT_SCAN, filter_scan->input_scan()->node_kind());
+  const auto* shared = filter_scan->input_scan()->GetAs<ResolvedProjectScan>();
+  ASSERT_EQ(1, shared->expr_list_size());
+  const ResolvedColumn column = shared->expr_list(0)->column();
+
+  EXPECT_EQ(std::vector<ResolvedColumn>({a_, b_, column}),
+            filter_scan->column_list());
+  EXPECT_EQ(column, Referenced(filter_scan->filter_expr()
+                                   ->GetAs<ResolvedFunctionCall>()
+                                   ->argument_list(0)));
+  EXPECT_EQ(column, Referenced(project->expr_list(0)->expr()));
+}
+
+TEST_F(CommonSubexpressionEliminationTest, SharesInAggregateScan) {
+  // SELECT SUM(a + 1) FROM T GROUP BY a + 1
+  const ResolvedColumn key(20, "$groupby", "key", types::Int64Type());
+  const ResolvedColumn sum(21, "$aggregate", "sum", types::Int64Type());
+  Function sum_function("sum", Function::kZetaSQLFunctionGroupName,
+                        Function::AGGREGATE);
+  auto aggregate = MakeResolvedAggregateScan(
+      {key, sum}, TableScan(),
+      MakeNodeVector(MakeResolvedComputedColumn(key, APlus(1))),
+      MakeNodeVector(MakeResolvedComputedColumn(
+          sum, MakeResolvedAggregateFunctionCall(
+                   types::Int64Type(), &sum_function,
+                   FunctionSignature(types::Int64Type(),
+                                     {types::Int64Type()}, FN_SUM_INT64),
+                   MakeNodeVector(APlus(1)),
+                   ResolvedFunctionCall::DEFAULT_ERROR_MODE,
+                   /*distinct=*/false,
+                   ResolvedAggregateFunctionCall::DEFAULT_NULL_HANDLING,
+                   /*having_modifier=*/nullptr,
+                   /*order_by_item_list=*/{}, /*limit=*/nullptr,
+                   /*function_call_info=*/nullptr))),
+      /*grouping_set_list=*/{}, /*rollup_column_list=*/{});
+  auto node = Eliminate(std::move(aggregate));
+
+  const auto* scan = node->GetAs<ResolvedAggregateScan>();
+  ASSERT_EQ(RESOLVED_PROJECT_SCAN, scan->input_scan()->node_kind());
+  const auto* shared = scan->input_scan()->GetAs<ResolvedProjectScan>();
+  ASSERT_EQ(1, shared->expr_list_size());
+  const ResolvedColumn column = shared->expr_list(0)->column();
+  EXPECT_EQ(22, column.column_id());
+  EXPECT_EQ(column, Referenced(scan->group_by_list(0)->expr()));
+  EXPECT_EQ(column, Referenced(scan->aggregate_list(0)
+                                   ->expr()
+                                   ->GetAs<ResolvedAggregateFunctionCall>()
+                                   ->argument_list(0)));
+}
+
+TEST_F(CommonSubexpressionEliminationTest, KeepsConditionalOccurrences) {
+  // SELECT IF(b, a + 1, 0), IF(b, 0, a + 1) FROM T
+  auto node = Eliminate(Project(
+      MakeNodeVector(
+          Call("if", FN_IF, MakeNodeVector(ColumnRef(b_), APlus(1), Int64(0))),
+          Call("if", FN_IF,
+               MakeNodeVector(ColumnRef(b_), Int64(0), APlus(1)))),
+      TableScan()));
+  EXPECT_EQ(RESOLVED_TABLE_SCAN,
+            node->GetAs<ResolvedProjectScan>()->input_scan()->node_kind());
+
+  // SELECT a + 1, IF(b, a + 1, 0) FROM T
+  node = Eliminate(Project(
+      MakeNodeVector(APlus(1), Call("if", FN_IF,
+                                    MakeNodeVector(ColumnRef(b_), APlus(1),
+                                                   Int64(0)))),
+      TableScan()));
+  EXPECT_EQ(RESOLVED_PROJECT_SCAN,
+            node->GetAs<ResolvedProjectScan>()->input_scan()->node_kind());
+}
+
+TEST_F(CommonSubexpressionEliminationTest, KeepsVolatileCalls) {
+  // SELECT RAND(), RAND() FROM T
+  FunctionOptions volatile_options;
+  volatile_options.set_volatility(FunctionEnums::VOLATILE);
+  auto rand = [&]() {
+    return Call("rand", FN_RAND,
+                MakeNodeVector(MakeResolvedLiteral(Value::Double(0))),
+                volatile_options);
+  };
+  auto node = Eliminate(Project(MakeNodeVector(rand(), rand()), TableScan()));
+  EXPECT_EQ(RESOLVED_TABLE_SCAN,
+            node->GetAs<ResolvedProjectScan>()->input_scan()->node_kind());
+}
+
+TEST_F(CommonSubexpressionEliminationTest, UsesColumnIdAllocator) {
+  std::unique_ptr<const ResolvedNode> node =
+      Project(MakeNodeVector(APlus(1), APlus(1)), TableScan());
+  ZETASQL_ASSERT_OK(
+      EliminateCommonSubexpressions([]() { return 100; }, &node));
+  const auto* shared = node->GetAs<ResolvedProjectScan>()
+                           ->input_scan()
+                           ->GetAs<ResolvedProjectScan>();
+  EXPECT_EQ(100, shared->expr_list(0)->column().column_id());
+}
+
+}  // namespace zetasql
@@ -0,0 +1,447 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/resolved_ast/compact_serialization.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/wire_format_lite.h"
+#include "google/protobuf/descriptor.h"
+#include "zetasql/public/type.pb.h"
+#include "zetasql/resolved_ast/resolved_ast.pb.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/node_hash_map.h"
+#include "zetasql/base/source_location.h"
+#include "zetasql/base/status_builder.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+using google::protobuf::Descriptor;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::Message;
+using google::protobuf::Reflection;
+using google::protobuf::io::CodedInputStream;
+using google::protobuf::io::CodedOutputStream;
+using google::protobuf::internal::WireFormatLite;
+
+namespace {
+
+// Bumped whenever the layout below changes incompatibly.
+//
+// Layout, with all integers as varints:
+//   version
+//   num_strings, then each string as length and bytes
+//   num_types, then each TypeProto as a message body
+//   the root message body
+// A message body is a sequence of (field number, value) pairs in field
+// number order, terminated by field number 0.  Repeated fields are written
+// once, as the element count followed by the values.  Strings and bytes are
+// written as string table indexes, TypeProto messages as type table
+// indexes, signed integers and enums zigzag-encoded, and floating point
+// values as little-endian fixed-width integers.
+constexpr uint32_t kCompactFormatVersion = 1;
+
+bool IsTypeProto(const Descriptor* descriptor) {
+  return descriptor == TypeProto::descriptor();
+}
+
+zetasql_base::Status MalformedError() {
+  return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+         << "Malformed compact resolved AST encoding";
+}
+
+class CompactEncoder {
+ public:
+  // Appends the complete encoding of <root> to <*output>.
+  void Encode(const Message& root, std::string* output) {
+    std::string body;
+    {
+      google::protobuf::io::StringOutputStream stream(&body);
+      CodedOutputStream out(&stream);
+      EncodeMessage(root, &out);
+    }
+    // Encoding the type table may add strings, so it must precede writing
+    // the string table.
+    std::string types;
+    {
+      google::protobuf::io::StringOutputStream stream(&types);
+      CodedOutputStream out(&stream);
+      in_type_table_ = true;
+      for (const Message* type : types_) {
+        EncodeMessage(*type, &out);
+      }
+      in_type_table_ = false;
+    }
+
+    google::protobuf::io::StringOutputStream stream(output);
+    CodedOutputStream out(&stream);
+    out.WriteVarint32(kCompactFormatVersion);
+    out.WriteVarint32(static_cast<uint32_t>(strings_.size()));
+    for (const std::string* str : strings_) {
+      out.WriteVarint32(static_cast<uint32_t>(str->size()));
+      out.WriteString(*str);
+    }
+    out.WriteVarint32(static_cast<uint32_t>(types_.size()));
+    out.WriteString(types);
+    out.WriteString(body);
+  }
+
+ private:
+  uint32_t InternString(const std::string& str) {
+    auto insert_result =
+        string_index_.emplace(str, static_cast<uint32_t>(strings_.size()));
+    if (insert_result.second) {
+      strings_.push_back(&insert_result.first->first);
+    }
+    return insert_result.first->second;
+  }
+
+  uint32_t InternType(const Message& type) {
+    auto insert_result = type_index_.emplace(
+        type.SerializeAsString(), static_cast<uint32_t>(types_.size()));
+    if (insert_result.second) {
+      types_.push_back(&type);
+    }
+    return insert_result.first->second;
+  }
+
+  void EncodeMessage(const Message& message, CodedOutputStream* out) {
+    const Reflection* reflection = message.GetReflection();
+    std::vector<const FieldDescriptor*> fields;
+    reflection->ListFields(message, &fields);
+    for (const FieldDescriptor* field : fields) {
+      out->WriteVarint32(static_cast<uint32_t>(field->number()));
+      if (field->is_repeated()) {
+        const int size = reflection->FieldSize(message, field);
+        out->WriteVarint32(static_cast<uint32_t>(size));
+        for (int i = 0; i < size; ++i) {
+          EncodeValue(message, field, i, out);
+        }
+      } else {
+        EncodeValue(message, field, /*index=*/-1, out);
+      }
+    }
+    out->WriteVarint32(0);
+  }
+
+  // Writes the value of <field> in <message>, or its element <index> if
+  // <field> is repeated.
+  void EncodeValue(const Message& message, const FieldDescriptor* field,
+                   int index, CodedOutputStream* out) {
+    const Reflection* reflection = message.GetReflection();
+    const bool repeated = index >= 0;
+    switch (field->cpp_type()) {
+      case FieldDescriptor::CPPTYPE_INT32:
+        out->WriteVarint32(WireFormatLite::ZigZagEncode32(
+            repeated ? reflection->GetRepeatedInt32(message, field, index)
+                     : reflection->GetInt32(message, field)));
+        break;
+      case FieldDescriptor::CPPTYPE_INT64:
+        out->WriteVarint64(WireFormatLite::ZigZagEncode64(
+            repeated ? reflection->GetRepeatedInt64(message, field, index)
+                     : reflection->GetInt64(message, field)));
+        break;
+      case FieldDescriptor::CPPTYPE_UINT32:
+        out->WriteVarint32(
+            repeated ? reflection->GetRepeatedUInt32(message, field, index)
+                     : reflection->GetUInt32(message, field));
+        break;
+      case FieldDescriptor::CPPTYPE_UINT64:
+        out->WriteVarint64(
+            repeated ? reflection->GetRepeatedUInt64(message, field, index)
+                     : reflection->GetUInt64(message, field));
+        break;
+      case FieldDescriptor::CPPTYPE_BOOL:
+        out->WriteVarint32(
+            (repeated ? reflection->GetRepeatedBool(message, field, index)
+                      : reflection->GetBool(message, field))
+                ? 1
+                : 0);
+        break;
+      case FieldDescriptor::CPPTYPE_ENUM:
+        out->WriteVarint32(WireFormatLite::ZigZagEncode32(
+            repeated ? reflection->GetRepeatedEnumValue(message, field, index)
+                     : reflection->GetEnumValue(message, field)));
+        break;
+      case FieldDescriptor::CPPTYPE_FLOAT:
+        out->WriteLittleEndian32(WireFormatLite::EncodeFloat(
+            repeated ? reflection->GetRepeatedFloat(message, field, index)
+                     : reflection->GetFloat(message, field)));
+        break;
+      case FieldDescriptor::CPPTYPE_DOUBLE:
+        out->WriteLittleEndian64(WireFormatLite::EncodeDouble(
+            repeated ? reflection->GetRepeatedDouble(message, field, index)
+                     : reflection->GetDouble(message, field)));
+        break;
+      case FieldDescriptor::CPPTYPE_STRING: {
+        std::string scratch;
+        const std::string& value =
+            repeated ? reflection->GetRepeatedStringReference(message, field,
+                                                              index, &scratch)
+                     : reflection->GetStringReference(message, field,
+                                                      &scratch);
+        out->WriteVarint32(InternString(value));
+        break;
+      }
+      case FieldDescriptor::CPPTYPE_MESSAGE: {
+        const Message& value =
+            repeated ? reflection->GetRepeatedMessage(message, field, index)
+                     : reflection->GetMessage(message, field);
+        if (!in_type_table_ && IsTypeProto(value.GetDescriptor())) {
+          out->WriteVarint32(InternType(value));
+        } else {
+          EncodeMessage(value, out);
+        }
+        break;
+      }
+    }
+  }
+
+  // Keys are stable across rehashing, so <strings_> can point to them.
+  absl::node_hash_map<std::string, uint32_t> string_index_;
+  std::vector<const std::string*> strings_;
+
+  // Keyed by serialized TypeProto.  The TypeProtos are owned by the message
+  // being encoded.
+  absl::flat_hash_map<std::string, uint32_t> type_index_;
+  std::vector<const Message*> types_;
+
+  // True while writing the type table.  TypeProtos nested inside a type
+  // table entry, like array element types, are written inline.
+  bool in_type_table_ = false;
+};
+
+class CompactDecoder {
+ public:
+  explicit CompactDecoder(absl::string_view encoded)
+      : encoded_(encoded),
+        in_(reinterpret_cast<const uint8_t*>(encoded.data()),
+            static_cast<int>(encoded.size())) {}
+
+  zetasql_base::Status Decode(Message* root) {
+    uint32_t version;
+    if (!in_.ReadVarint32(&version)) return MalformedError();
+    if (version != kCompactFormatVersion) {
+      return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+             << "Unsupported compact resolved AST encoding version "
+             << version;
+    }
+    uint32_t num_strings;
+    if (!in_.ReadVarint32(&num_strings)) return MalformedError();
+    for (uint32_t i = 0; i < num_strings; ++i) {
+      uint32_t length;
+      if (!in_.ReadVarint32(&length)) return MalformedError();
+      const int start = in_.CurrentPosition();
+      if (!in_.Skip(static_cast<int>(length))) return MalformedError();
+      strings_.push_back(encoded_.substr(start, length));
+    }
+    uint32_t num_types;
+    if (!in_.ReadVarint32(&num_types)) return MalformedError();
+    types_.resize(num_types);
+    in_type_table_ = true;
+    for (TypeProto& type : types_) {
+      ZETASQL_RETURN_IF_ERROR(DecodeMessage(&type));
+    }
+    in_type_table_ = false;
+    ZETASQL_RETURN_IF_ERROR(DecodeMessage(root));
+    if (in_.CurrentPosition() != static_cast<int>(encoded_.size())) {
+      return MalformedError();
+    }
+    return ::zetasql_base::OkStatus();
+  }
+
+ private:
+  zetasql_base::Status DecodeMessage(Message* message) {
+    const Descriptor* descriptor = message->GetDescriptor();
+    while (true) {
+      uint32_t number;
+      if (!in_.ReadVarint32(&number)) return MalformedError();
+      if (number == 0) return ::zetasql_base::OkStatus();
+      const FieldDescriptor* field =
+          descriptor->FindFieldByNumber(static_cast<int>(number));
+      if (field == nullptr) {
+        return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+               << "Unknown field " << number << " in "
+               << descriptor->full_name()
+               << " in compact resolved AST encoding";
+      }
+      if (field->is_repeated()) {
+        uint32_t size;
+        if (!in_.ReadVarint32(&size)) return MalformedError();
+        for (uint32_t i = 0; i < size; ++i) {
+          ZETASQL_RETURN_IF_ERROR(DecodeValue(field, message));
+        }
+      } else {
+        ZETASQL_RETURN_IF_ERROR(DecodeValue(field, message));
+      }
+    }
+  }
+
+  // Reads a value of <field> and sets it in, or adds it to, <*message>.
+  zetasql_base::Status DecodeValue(const FieldDescriptor* field, Message* message) {
+    const Reflection* reflection = message->GetReflection();
+    const bool repeated = field->is_repeated();
+    uint32_t value32;
+    uint64_t value64;
+    switch (field->cpp_type()) {
+      case FieldDescriptor::CPPTYPE_INT32:
+        if (!in_.ReadVarint32(&value32)) return MalformedError();
+        if (repeated) {
+          reflection->AddInt32(message, field,
+                               WireFormatLite::ZigZagDecode32(value32));
+        } else {
+          reflection->SetInt32(message, field,
+                               WireFormatLite::ZigZagDecode32(value32));
+        }
+        break;
+      case FieldDescriptor::CPPTYPE_INT64:
+        if (!in_.ReadVarint64(&value64)) return MalformedError();
+        if (repeated) {
+          reflection->AddInt64(message, field,
+                               WireFormatLite::ZigZagDecode64(value64));
+        } else {
+          reflection->SetInt64(message, field,
+                               WireFormatLite::ZigZagDecode64(value64));
+        }
+        break;
+      case FieldDescriptor::CPPTYPE_UINT32:
+        if (!in_.ReadVarint32(&value32)) return MalformedError();
+        if (repeated) {
+          reflection->AddUInt32(message, field, value32);
+        } else {
+          reflection->SetUInt32(message, field, value32);
+        }
+        break;
+      case FieldDescriptor::CPPTYPE_UINT64:
+        if (!in_.ReadVarint64(&value64)) return MalformedError();
+        if (repeated) {
+          reflection->AddUInt64(message, field, value64);
+        } else {
+          reflection->SetUInt64(message, field, value64);
+        }
+        break;
+      case FieldDescriptor::CPPTYPE_BOOL:
+        if (!in_.ReadVarint32(&value32)) return MalformedError();
+        if (repeated) {
+          reflection->AddBool(message, field, value32 != 0);
+        } else {
+          reflection->SetBool(message, field, value32 != 0);
+        }
+        break;
+      case FieldDescriptor::CPPTYPE_ENUM:
+        if (!in_.ReadVarint32(&value32)) return MalformedError();
+        if (repeated) {
+          reflection->AddEnumValue(message, field,
+                                   WireFormatLite::ZigZagDecode32(value32));
+        } else {
+          reflection->SetEnumValue(message, field,
+                                   WireFormatLite::ZigZagDecode32(value32));
+        }
+        break;
+      case FieldDescriptor::CPPTYPE_FLOAT:
+        if (!in_.ReadLittleEndian32(&value32)) return MalformedError();
+        if (repeated) {
+          reflection->AddFloat(message, field,
+                               WireFormatLite::DecodeFloat(value32));
+        } else {
+          reflection->SetFloat(message, field,
+                               WireFormatLite::DecodeFloat(value32));
+        }
+        break;
+      case FieldDescriptor::CPPTYPE_DOUBLE:
+        if (!in_.ReadLittleEndian64(&value64)) return MalformedError();
+        if (repeated) {
+          reflection->AddDouble(message, field,
+                                WireFormatLite::DecodeDouble(value64));
+        } else {
+          reflection->SetDouble(message, field,
+                                WireFormatLite::DecodeDouble(value64));
+        }
+        break;
+      case FieldDescriptor::CPPTYPE_STRING: {
+        if (!in_.ReadVarint32(&value32) || value32 >= strings_.size()) {
+          return MalformedError();
+        }
+        std::string value(strings_[value32]);
+        if (repeated) {
+          reflection->AddString(message, field, std::move(value));
+        } else {
+          reflection->SetString(message, field, std::move(value));
+        }
+        break;
+      }
+      case FieldDescriptor::CPPTYPE_MESSAGE: {
+        Message* value = repeated ? reflection->AddMessage(message, field)
+                                  : reflection->MutableMessage(message, field);
+        if (!in_type_table_ && IsTypeProto(value->GetDescriptor())) {
+          if (!in_.ReadVarint32(&value32) || value32 >= types_.size()) {
+            return MalformedError();
+          }
+          value->CopyFrom(types_[value32]);
+        } else {
+          ZETASQL_RETURN_IF_ERROR(DecodeMessage(value));
+        }
+        break;
+      }
+    }
+    return ::zetasql_base::OkStatus();
+  }
+
+  const absl::string_view encoded_;
+  CodedInputStream in_;
+  std::vector<absl::string_view> strings_;
+  std::vector<TypeProto> types_;
+  bool in_type_table_ = false;
+};
+
+}  // namespace
+
+zetasql_base::Status EncodeCompactResolvedAstProto(const Message& proto,
+                                           std::string* output) {
+  output->clear();
+  CompactEncoder().Encode(proto, output);
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status DecodeCompactResolvedAstProto(absl::string_view encoded,
+                                           Message* proto) {
+  proto->Clear();
+  return CompactDecoder(encoded).Decode(proto);
+}
+
+zetasql_base::Status SerializeResolvedStatementCompact(
+    const ResolvedStatement& statement,
+    Type::FileDescriptorSetMap* file_descriptor_set_map, std::string* output) {
+  AnyResolvedStatementProto proto;
+  ZETASQL_RETURN_IF_ERROR(statement.SaveTo(file_descriptor_set_map, &proto));
+  return EncodeCompactResolvedAstProto(proto, output);
+}
+
+zetasql_base::StatusOr<std::unique_ptr<ResolvedStatement>>
+DeserializeResolvedStatementCompact(absl::string_view encoded,
+                                    const ResolvedNode::RestoreParams& params) {
+  AnyResolvedStatementProto proto;
+  ZETASQL_RETURN_IF_ERROR(DecodeCompactResolvedAstProto(encoded, &proto));
+  return ResolvedStatement::RestoreFrom(proto, params);
+}
+
+}  // namespace zetasql
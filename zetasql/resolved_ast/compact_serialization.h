@@ -0,0 +1,70 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_RESOLVED_AST_COMPACT_SERIALIZATION_H_
+#define ZETASQL_RESOLVED_AST_COMPACT_SERIALIZATION_H_
+
+#include <memory>
+#include <string>
+
+#include "google/protobuf/message.h"
+#include "zetasql/public/type.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "zetasql/resolved_ast/resolved_node.h"
+#include "absl/strings/string_view.h"
+#include "zetasql/base/status.h"
+#include "zetasql/base/statusor.h"
+
+namespace zetasql {
+
+// A compact binary encoding of the protos in resolved_ast.proto, for
+// shipping resolved ASTs between processes.
+//
+// The proto form of a resolved AST repeats the full TypeProto of a column
+// and its table and column names on every node that references it.  The
+// compact encoding instead stores
+//   - a table of distinct TypeProtos, referenced by index,
+//   - a table of distinct strings, referenced by index, and
+//   - all integers, including column ids, as varints.
+//
+// The encoding is schema-dependent: it stores field numbers but not wire
+// types, so both sides must be built with the same resolved_ast.proto.
+// It is intended for transport, not for storage.
+
+// Encodes <proto>, which is usually an AnyResolvedStatementProto or
+// AnyResolvedNodeProto, into <*output>.
+zetasql_base::Status EncodeCompactResolvedAstProto(const google::protobuf::Message& proto,
+                                           std::string* output);
+
+// Decodes <encoded>, produced by EncodeCompactResolvedAstProto() for a
+// message of the same type as <*proto>, into <*proto>.
+zetasql_base::Status DecodeCompactResolvedAstProto(absl::string_view encoded,
+                                           google::protobuf::Message* proto);
+
+// Serializes <statement> with SaveTo() and encodes it compactly.
+// <file_descriptor_set_map> is used as in ResolvedNode::SaveTo().
+zetasql_base::Status SerializeResolvedStatementCompact(
+    const ResolvedStatement& statement,
+    Type::FileDescriptorSetMap* file_descriptor_set_map, std::string* output);
+
+// Restores a statement serialized by SerializeResolvedStatementCompact().
+zetasql_base::StatusOr<std::unique_ptr<ResolvedStatement>>
+DeserializeResolvedStatementCompact(absl::string_view encoded,
+                                    const ResolvedNode::RestoreParams& params);
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_RESOLVED_AST_COMPACT_SERIALIZATION_H_
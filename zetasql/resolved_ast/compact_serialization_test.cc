@@ -0,0 +1,121 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/resolved_ast/compact_serialization.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/id_string.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "zetasql/resolved_ast/resolved_ast.pb.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+
+namespace zetasql {
+
+using zetasql_base::testing::StatusIs;
+
+class CompactSerializationTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    const Type* struct_type;
+    ZETASQL_ASSERT_OK(type_factory_.MakeStructType(
+        {{"a", types::Int64Type()}, {"b", types::StringType()}},
+        &struct_type));
+    const Type* array_type;
+    ZETASQL_ASSERT_OK(type_factory_.MakeArrayType(struct_type, &array_type));
+
+    std::vector<SimpleTable::NameAndType> columns;
+    for (int i = 0; i < 20; ++i) {
+      columns.emplace_back(absl::StrCat("column_", i), array_type);
+    }
+    catalog_.AddOwnedTable(new SimpleTable("T", columns));
+    const Table* table;
+    ZETASQL_ASSERT_OK(catalog_.GetTable("T", &table));
+
+    std::vector<ResolvedColumn> column_list;
+    std::vector<std::unique_ptr<const ResolvedOutputColumn>> output_columns;
+    for (int i = 0; i < table->NumColumns(); ++i) {
+      column_list.emplace_back(1000000 + i, "T", table->GetColumn(i)->Name(),
+                               array_type);
+      output_columns.push_back(MakeResolvedOutputColumn(
+          table->GetColumn(i)->Name(), column_list.back()));
+    }
+    statement_ = MakeResolvedQueryStmt(
+        std::move(output_columns), /*is_value_table=*/false,
+        MakeResolvedProjectScan(
+            column_list, /*expr_list=*/{},
+            MakeResolvedTableScan(column_list, table,
+                                  /*for_system_time_expr=*/nullptr)));
+  }
+
+  TypeFactory type_factory_;
+  SimpleCatalog catalog_{"catalog"};
+  std::unique_ptr<const ResolvedQueryStmt> statement_;
+};
+
+TEST_F(CompactSerializationTest, ProtoRoundTrip) {
+  Type::FileDescriptorSetMap map;
+  AnyResolvedStatementProto proto;
+  ZETASQL_ASSERT_OK(statement_->SaveTo(&map, &proto));
+
+  std::string encoded;
+  ZETASQL_ASSERT_OK(EncodeCompactResolvedAstProto(proto, &encoded));
+  // Every column repeats the same type and table name, so the compact
+  // encoding should be much smaller.
+  EXPECT_LT(encoded.size() * 3, proto.ByteSizeLong());
+
+  AnyResolvedStatementProto decoded;
+  ZETASQL_ASSERT_OK(DecodeCompactResolvedAstProto(encoded, &decoded));
+  EXPECT_EQ(proto.DebugString(), decoded.DebugString());
+}
+
+TEST_F(CompactSerializationTest, StatementRoundTrip) {
+  Type::FileDescriptorSetMap map;
+  std::string encoded;
+  ZETASQL_ASSERT_OK(SerializeResolvedStatementCompact(*statement_, &map, &encoded));
+
+  IdStringPool string_pool;
+  ResolvedNode::RestoreParams params(/*pools=*/{}, &catalog_, &type_factory_,
+                                     &string_pool);
+  auto restored = DeserializeResolvedStatementCompact(encoded, params);
+  ZETASQL_ASSERT_OK(restored.status());
+  EXPECT_EQ(statement_->DebugString(), restored.ValueOrDie()->DebugString());
+}
+
+TEST_F(CompactSerializationTest, Malformed) {
+  Type::FileDescriptorSetMap map;
+  std::string encoded;
+  ZETASQL_ASSERT_OK(SerializeResolvedStatementCompact(*statement_, &map, &encoded));
+
+  AnyResolvedStatementProto decoded;
+  EXPECT_THAT(DecodeCompactResolvedAstProto(
+                  absl::string_view(encoded).substr(0, encoded.size() / 2),
+                  &decoded),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+  EXPECT_THAT(DecodeCompactResolvedAstProto(encoded + "x", &decoded),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+  EXPECT_THAT(DecodeCompactResolvedAstProto("\x7f", &decoded),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+}
+
+}  // namespace zetasql
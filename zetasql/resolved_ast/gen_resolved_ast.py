@@ -461,6 +461,7 @@ def Field(name,
       'element_unwrapper': element_unwrapper,
       'is_node_ptr': is_node_type and not vector,
       'is_node_vector': is_node_type and vector,
+      'is_resolved_column': ctype is SCALAR_RESOLVED_COLUMN,
       'is_enum_vector': is_enum and vector,
       'is_move_only': is_move_only,
       'is_not_ignorable': ignorable == NOT_IGNORABLE,
@@ -3277,10 +3278,50 @@ right.
       columns from outside.  It may reference other WITH subqueries.
 
       See ResolvedWithScan for full details.
+
+      The remaining fields describe how the entry is used, for consumers
+      choosing between materializing <with_subquery> and inlining it.  They
+      are only filled in by AnnotateWithEntries() in
+      resolved_ast/with_entries.h, as done by the analyzer when
+      AnalyzerOptions::annotate_with_entries() is set.
               """,
       fields=[
           Field('with_query_name', SCALAR_STRING, tag_id=2),
-          Field('with_subquery', 'ResolvedScan', tag_id=3)
+          Field('with_subquery', 'ResolvedScan', tag_id=3),
+          Field(
+              'reference_count',
+              SCALAR_INT,
+              tag_id=4,
+              ignorable=IGNORABLE_DEFAULT,
+              is_constructor_arg=False,
+              comment="""
+              The number of ResolvedWithRefScans in the statement that scan
+              this entry, including those in other WITH subqueries.
+                      """),
+          Field(
+              'is_deterministic',
+              SCALAR_BOOL,
+              tag_id=5,
+              ignorable=IGNORABLE_DEFAULT,
+              is_constructor_arg=False,
+              comment="""
+              True if running <with_subquery> again would return the same
+              rows: it calls no VOLATILE functions, has no TVF calls, LIMITs
+              or TABLESAMPLEs without REPEATABLE, and scans only
+              deterministic WITH entries.
+                      """),
+          Field(
+              'is_cheap',
+              SCALAR_BOOL,
+              tag_id=6,
+              ignorable=IGNORABLE_DEFAULT,
+              is_constructor_arg=False,
+              comment="""
+              True if <with_subquery> costs about as much to run again as to
+              read back once materialized: it only projects and filters a
+              single table scan, single row scan or cheap WITH entry, and has
+              no subquery expressions.
+                      """)
       ])
 
   gen.AddNode(
@@ -0,0 +1,617 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/resolved_ast/join_reordering.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "zetasql/public/builtin_function.pb.h"
+#include "zetasql/public/catalog.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/function_signature.h"
+#include "zetasql/public/type.h"
+#include "zetasql/resolved_ast/resolved_column.h"
+#include "zetasql/resolved_ast/resolved_node_kind.pb.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/status_macros.h"
+#include "zetasql/base/statusor.h"
+
+namespace zetasql {
+
+namespace {
+
+typedef std::unique_ptr<const ResolvedNode>* NodeSlot;
+typedef std::vector<std::unique_ptr<const ResolvedExpr>> ExprList;
+
+// The size of the subsets of inputs that the dynamic programming tracks
+// would grow as 2^n beyond this.
+constexpr int kMaxDpInputs = 16;
+
+// The selectivity of a conjunct without a better estimate.
+constexpr double kDefaultSelectivity = 1.0 / 3;
+
+// The selectivity of <column> = <literal> if the distinct count of the
+// column is unknown.
+constexpr double kLiteralEqualitySelectivity = 0.1;
+
+// Returns the slots of the children of <node>, which the caller owns.
+std::vector<NodeSlot> MutableChildren(const ResolvedNode* node) {
+  std::vector<NodeSlot> children;
+  const_cast<ResolvedNode*>(node)->AddMutableChildNodePointers(&children);
+  return children;
+}
+
+// Returns the slot of <child>, a child of <node>.
+zetasql_base::StatusOr<NodeSlot> ChildSlot(const ResolvedNode* node,
+                                   const ResolvedNode* child) {
+  for (NodeSlot slot : MutableChildren(node)) {
+    if (slot->get() == child) return slot;
+  }
+  ZETASQL_RET_CHECK_FAIL() << "Child not found in " << node->node_kind_string();
+}
+
+bool IsBuiltinCall(const ResolvedNode* node, FunctionSignatureId id) {
+  if (node->node_kind() != RESOLVED_FUNCTION_CALL) return false;
+  const auto* call = node->GetAs<ResolvedFunctionCall>();
+  return call->function()->IsZetaSQLBuiltin() &&
+         call->signature().context_id() == id;
+}
+
+// Adds the ids of the columns that <expr> references to <column_ids>, not
+// counting correlated references, and sets <*correlated> if there are any.
+// Returns false if <expr> cannot be moved.
+bool CollectColumns(const ResolvedNode* expr,
+                    absl::flat_hash_set<int>* column_ids, bool* correlated) {
+  switch (expr->node_kind()) {
+    case RESOLVED_SUBQUERY_EXPR:
+      return false;
+    case RESOLVED_FUNCTION_CALL:
+      if (expr->GetAs<ResolvedFunctionCall>()
+              ->function()
+              ->function_options()
+              .volatility == FunctionEnums::VOLATILE) {
+        return false;
+      }
+      break;
+    case RESOLVED_COLUMN_REF: {
+      const auto* ref = expr->GetAs<ResolvedColumnRef>();
+      if (ref->is_correlated()) {
+        *correlated = true;
+      } else {
+        column_ids->insert(ref->column().column_id());
+      }
+      return true;
+    }
+    default:
+      if (expr->IsScan()) return false;
+      break;
+  }
+  std::vector<const ResolvedNode*> children;
+  expr->GetChildNodes(&children);
+  for (const ResolvedNode* child : children) {
+    if (!CollectColumns(child, column_ids, correlated)) return false;
+  }
+  return true;
+}
+
+// Adds the conjuncts of <expr>, which may be nested ANDs, to <conjuncts>.
+void GetConjuncts(const ResolvedExpr* expr,
+                  std::vector<const ResolvedExpr*>* conjuncts) {
+  if (!IsBuiltinCall(expr, FN_AND)) {
+    conjuncts->push_back(expr);
+    return;
+  }
+  for (const auto& argument :
+       expr->GetAs<ResolvedFunctionCall>()->argument_list()) {
+    GetConjuncts(argument.get(), conjuncts);
+  }
+}
+
+// Returns the id of the column that <expr> references, or -1 if it is not a
+// non-correlated ResolvedColumnRef.
+int ColumnId(const ResolvedExpr* expr) {
+  if (expr->node_kind() != RESOLVED_COLUMN_REF) return -1;
+  const auto* ref = expr->GetAs<ResolvedColumnRef>();
+  return ref->is_correlated() ? -1 : ref->column().column_id();
+}
+
+// Returns the two arguments of <conjunct> if it uses =, or nullptrs.
+std::pair<const ResolvedExpr*, const ResolvedExpr*> EqualityArguments(
+    const ResolvedExpr* conjunct) {
+  if (!IsBuiltinCall(conjunct, FN_EQUAL)) return {nullptr, nullptr};
+  const auto& arguments =
+      conjunct->GetAs<ResolvedFunctionCall>()->argument_list();
+  if (arguments.size() != 2) return {nullptr, nullptr};
+  return {arguments[0].get(), arguments[1].get()};
+}
+
+// The estimated size of an input of a join chain.
+struct InputEstimate {
+  double rows = 0;
+  // Distinct counts of the columns of the input, by column id, if known.
+  absl::flat_hash_map<int, double> distinct_counts;
+
+  double DistinctCount(int column_id) const {
+    auto it = distinct_counts.find(column_id);
+    return std::max(
+        1.0, it == distinct_counts.end() ? rows : std::min(rows, it->second));
+  }
+};
+
+// Estimates the size of <scan>.  Returns false if it is unknown.
+bool EstimateInput(const ResolvedScan* scan, InputEstimate* estimate) {
+  switch (scan->node_kind()) {
+    case RESOLVED_TABLE_SCAN: {
+      const auto* table_scan = scan->GetAs<ResolvedTableScan>();
+      const TableStatistics* statistics =
+          table_scan->table()->GetStatistics();
+      if (statistics == nullptr || !statistics->row_count.has_value()) {
+        return false;
+      }
+      estimate->rows = *statistics->row_count;
+      const std::vector<int>& column_indexes =
+          table_scan->column_index_list();
+      for (int i = 0; i < column_indexes.size() &&
+                      i < table_scan->column_list_size();
+           ++i) {
+        const int index = column_indexes[i];
+        if (index < 0 || index >= statistics->columns.size() ||
+            !statistics->columns[index].distinct_count.has_value()) {
+          continue;
+        }
+        estimate->distinct_counts[table_scan->column_list(i).column_id()] =
+            *statistics->columns[index].distinct_count;
+      }
+      return true;
+    }
+    case RESOLVED_FILTER_SCAN: {
+      const auto* filter = scan->GetAs<ResolvedFilterScan>();
+      if (!EstimateInput(filter->input_scan(), estimate)) return false;
+      std::vector<const ResolvedExpr*> conjuncts;
+      GetConjuncts(filter->filter_expr(), &conjuncts);
+      double selectivity = 1.0;
+      for (const ResolvedExpr* conjunct : conjuncts) {
+        const auto arguments = EqualityArguments(conjunct);
+        int column_id = -1;
+        if (arguments.first != nullptr) {
+          if (arguments.second->node_kind() == RESOLVED_LITERAL) {
+            column_id = ColumnId(arguments.first);
+          } else if (arguments.first->node_kind() == RESOLVED_LITERAL) {
+            column_id = ColumnId(arguments.second);
+          }
+        }
+        if (column_id < 0) {
+          selectivity *= kDefaultSelectivity;
+        } else if (estimate->distinct_counts.contains(column_id)) {
+          selectivity /= estimate->DistinctCount(column_id);
+        } else {
+          selectivity *= kLiteralEqualitySelectivity;
+        }
+      }
+      estimate->rows = std::max(1.0, estimate->rows * selectivity);
+      return true;
+    }
+    case RESOLVED_PROJECT_SCAN:
+      return EstimateInput(scan->GetAs<ResolvedProjectScan>()->input_scan(),
+                           estimate);
+    default:
+      return false;
+  }
+}
+
+class JoinReorderer {
+ public:
+  explicit JoinReorderer(const JoinReorderingOptions& options)
+      : max_dp_inputs_(
+            std::min(std::max(options.max_dp_inputs, 0), kMaxDpInputs)) {}
+  JoinReorderer(const JoinReorderer&) = delete;
+  JoinReorderer& operator=(const JoinReorderer&) = delete;
+
+  // Reorders the join chains in the tree at <slot>, inner chains first.
+  zetasql_base::Status Reorder(NodeSlot slot) {
+    if (IsChainJoin(slot->get())) {
+      Chain chain;
+      ZETASQL_RETURN_IF_ERROR(Flatten(slot, &chain));
+      for (NodeSlot input : chain.inputs) {
+        ZETASQL_RETURN_IF_ERROR(Reorder(input));
+      }
+      for (const ResolvedJoinScan* join : chain.joins) {
+        if (join->join_expr() == nullptr) continue;
+        ZETASQL_ASSIGN_OR_RETURN(NodeSlot join_expr,
+                         ChildSlot(join, join->join_expr()));
+        ZETASQL_RETURN_IF_ERROR(Reorder(join_expr));
+      }
+      return ReorderChain(slot, chain);
+    }
+    for (NodeSlot child : MutableChildren(slot->get())) {
+      ZETASQL_RETURN_IF_ERROR(Reorder(child));
+    }
+    return ::zetasql_base::OkStatus();
+  }
+
+ private:
+  struct Chain {
+    // The slots of the inputs, from left to right.
+    std::vector<NodeSlot> inputs;
+    std::vector<const ResolvedJoinScan*> joins;
+  };
+
+  struct ConjunctInfo {
+    // The indexes of the inputs producing the columns of the conjunct.
+    std::vector<int> inputs;
+    double selectivity = kDefaultSelectivity;
+  };
+
+  static bool IsChainJoin(const ResolvedNode* node) {
+    if (node->node_kind() != RESOLVED_JOIN_SCAN) return false;
+    const auto* join = node->GetAs<ResolvedJoinScan>();
+    return join->join_type() == ResolvedJoinScan::INNER &&
+           join->hint_list().empty();
+  }
+
+  // Adds the inputs and joins of the chain at <slot> to <chain>.
+  static zetasql_base::Status Flatten(NodeSlot slot, Chain* chain) {
+    if (!IsChainJoin(slot->get())) {
+      chain->inputs.push_back(slot);
+      return ::zetasql_base::OkStatus();
+    }
+    const auto* join = (*slot)->GetAs<ResolvedJoinScan>();
+    chain->joins.push_back(join);
+    ZETASQL_ASSIGN_OR_RETURN(NodeSlot left, ChildSlot(join, join->left_scan()));
+    ZETASQL_RETURN_IF_ERROR(Flatten(left, chain));
+    ZETASQL_ASSIGN_OR_RETURN(NodeSlot right,
+                     ChildSlot(join, join->right_scan()));
+    return Flatten(right, chain);
+  }
+
+  // Replaces the chain at <slot> with a cheaper left-deep one, if its size
+  // can be estimated and there is one.
+  zetasql_base::Status ReorderChain(NodeSlot slot, const Chain& chain) {
+    const int num_inputs = chain.inputs.size();
+    // Swapping the two inputs of a join does not change any sizes.
+    if (num_inputs < 3) return ::zetasql_base::OkStatus();
+
+    std::vector<InputEstimate> estimates(num_inputs);
+    absl::flat_hash_map<int, int> input_of_column;
+    for (int i = 0; i < num_inputs; ++i) {
+      const auto* input = (*chain.inputs[i])->GetAs<ResolvedScan>();
+      if (!EstimateInput(input, &estimates[i])) {
+        return ::zetasql_base::OkStatus();
+      }
+      for (const ResolvedColumn& column : input->column_list()) {
+        if (!input_of_column.emplace(column.column_id(), i).second) {
+          return ::zetasql_base::OkStatus();
+        }
+      }
+    }
+
+    std::vector<const ResolvedExpr*> conjuncts;
+    for (const ResolvedJoinScan* join : chain.joins) {
+      if (join->join_expr() != nullptr) {
+        GetConjuncts(join->join_expr(), &conjuncts);
+      }
+    }
+    conjuncts_.clear();
+    for (const ResolvedExpr* conjunct : conjuncts) {
+      absl::flat_hash_set<int> column_ids;
+      bool correlated = false;
+      if (!CollectColumns(conjunct, &column_ids, &correlated)) {
+        return ::zetasql_base::OkStatus();
+      }
+      ConjunctInfo info;
+      for (int column_id : column_ids) {
+        auto it = input_of_column.find(column_id);
+        if (it == input_of_column.end()) return ::zetasql_base::OkStatus();
+        info.inputs.push_back(it->second);
+      }
+      std::sort(info.inputs.begin(), info.inputs.end());
+      info.inputs.erase(std::unique(info.inputs.begin(), info.inputs.end()),
+                        info.inputs.end());
+      const auto arguments = EqualityArguments(conjunct);
+      if (arguments.first != nullptr && info.inputs.size() == 2) {
+        const int column_id1 = ColumnId(arguments.first);
+        const int column_id2 = ColumnId(arguments.second);
+        if (column_id1 >= 0 && column_id2 >= 0) {
+          info.selectivity =
+              1.0 /
+              std::max(estimates[input_of_column[column_id1]].DistinctCount(
+                           column_id1),
+                       estimates[input_of_column[column_id2]].DistinctCount(
+                           column_id2));
+        }
+      }
+      conjuncts_.push_back(std::move(info));
+    }
+    input_rows_.clear();
+    for (const InputEstimate& estimate : estimates) {
+      input_rows_.push_back(estimate.rows);
+    }
+
+    std::vector<int> original_order(num_inputs);
+    for (int i = 0; i < num_inputs; ++i) original_order[i] = i;
+    const std::vector<int> order =
+        num_inputs <= max_dp_inputs_ ? DpOrder() : GreedyOrder();
+    if (order == original_order || Cost(order) >= Cost(original_order)) {
+      return ::zetasql_base::OkStatus();
+    }
+    return Rebuild(slot, chain, order);
+  }
+
+  // Returns the estimated number of rows of joining input <input> to <rows>
+  // rows of the inputs for which <is_joined> returns true.
+  template <typename IsJoined>
+  double JoinedRows(double rows, int input, IsJoined is_joined) const {
+    rows *= input_rows_[input];
+    for (const ConjunctInfo& conjunct : conjuncts_) {
+      bool applies = false;
+      bool complete = true;
+      for (int i : conjunct.inputs) {
+        if (i == input) {
+          applies = true;
+        } else if (!is_joined(i)) {
+          complete = false;
+        }
+      }
+      if (applies && complete) rows *= conjunct.selectivity;
+    }
+    return rows;
+  }
+
+  // Returns true if a conjunct relates <input> to an input for which
+  // <is_joined> returns true.
+  template <typename IsJoined>
+  bool IsConnected(int input, IsJoined is_joined) const {
+    for (const ConjunctInfo& conjunct : conjuncts_) {
+      if (!std::binary_search(conjunct.inputs.begin(), conjunct.inputs.end(),
+                              input)) {
+        continue;
+      }
+      for (int i : conjunct.inputs) {
+        if (i != input && is_joined(i)) return true;
+      }
+    }
+    return false;
+  }
+
+  // Returns the sum of the estimated sizes of the joins of the left-deep
+  // tree joining the inputs in <order>.
+  double Cost(const std::vector<int>& order) const {
+    std::vector<bool> joined(input_rows_.size(), false);
+    auto is_joined = [&joined](int i) { return joined[i]; };
+    double rows = 1.0;
+    double cost = 0;
+    for (int k = 0; k < order.size(); ++k) {
+      rows = JoinedRows(rows, order[k], is_joined);
+      if (k > 0) cost += rows;
+      joined[order[k]] = true;
+    }
+    return cost;
+  }
+
+  // Returns the cheapest left-deep order, by dynamic programming over the
+  // subsets of the inputs.  Inputs are only joined without a condition if no
+  // remaining input is related to the ones joined so far.
+  std::vector<int> DpOrder() const {
+    const int num_inputs = input_rows_.size();
+    const uint32_t all = (uint32_t{1} << num_inputs) - 1;
+    std::vector<double> rows(all + 1, 0);
+    std::vector<double> cost(all + 1, std::numeric_limits<double>::infinity());
+    std::vector<int> last(all + 1, -1);
+    for (int i = 0; i < num_inputs; ++i) {
+      const uint32_t subset = uint32_t{1} << i;
+      rows[subset] = JoinedRows(1.0, i, [](int) { return false; });
+      cost[subset] = 0;
+      last[subset] = i;
+    }
+    for (uint32_t subset = 1; subset < all; ++subset) {
+      if (last[subset] < 0) continue;
+      auto is_joined = [subset](int i) { return (subset >> i) & 1; };
+      std::vector<int> candidates;
+      for (int i = 0; i < num_inputs; ++i) {
+        if (!is_joined(i) && IsConnected(i, is_joined)) {
+          candidates.push_back(i);
+        }
+      }
+      if (candidates.empty()) {
+        for (int i = 0; i < num_inputs; ++i) {
+          if (!is_joined(i)) candidates.push_back(i);
+        }
+      }
+      for (int i : candidates) {
+        const uint32_t next = subset | (uint32_t{1} << i);
+        const double next_rows = JoinedRows(rows[subset], i, is_joined);
+        if (cost[subset] + next_rows < cost[next]) {
+          cost[next] = cost[subset] + next_rows;
+          rows[next] = next_rows;
+          last[next] = i;
+        }
+      }
+    }
+    std::vector<int> order;
+    for (uint32_t subset = all; subset != 0;
+         subset &= ~(uint32_t{1} << last[subset])) {
+      order.push_back(last[subset]);
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+  }
+
+  // Returns a left-deep order that starts with the smallest input and then
+  // joins the input giving the smallest result, preferring related ones.
+  std::vector<int> GreedyOrder() const {
+    const int num_inputs = input_rows_.size();
+    std::vector<bool> joined(num_inputs, false);
+    auto is_joined = [&joined](int i) { return joined[i]; };
+    std::vector<int> order;
+    double rows = 1.0;
+    while (order.size() < num_inputs) {
+      int best = -1;
+      bool best_connected = false;
+      double best_rows = 0;
+      for (int i = 0; i < num_inputs; ++i) {
+        if (joined[i]) continue;
+        const bool connected = IsConnected(i, is_joined);
+        const double next_rows = JoinedRows(rows, i, is_joined);
+        if (best < 0 || (connected && !best_connected) ||
+            (connected == best_connected && next_rows < best_rows)) {
+          best = i;
+          best_connected = connected;
+          best_rows = next_rows;
+        }
+      }
+      order.push_back(best);
+      joined[best] = true;
+      rows = best_rows;
+    }
+    return order;
+  }
+
+  // Replaces the chain at <slot> with the left-deep tree joining its inputs
+  // in <order>.
+  zetasql_base::Status Rebuild(NodeSlot slot, const Chain& chain,
+                       const std::vector<int>& order) {
+    // Takes the conjuncts in the order GetConjuncts() found them.
+    ExprList conjuncts;
+    for (const ResolvedJoinScan* join : chain.joins) {
+      if (join->join_expr() != nullptr) {
+        AddConjuncts(const_cast<ResolvedJoinScan*>(join)->release_join_expr(),
+                     &conjuncts);
+      }
+    }
+    ZETASQL_RET_CHECK_EQ(conjuncts.size(), conjuncts_.size());
+    std::vector<std::unique_ptr<const ResolvedScan>> inputs;
+    for (NodeSlot input : chain.inputs) {
+      inputs.emplace_back(input->release()->GetAs<ResolvedScan>());
+    }
+    const std::vector<ResolvedColumn> column_list =
+        (*slot)->GetAs<ResolvedScan>()->column_list();
+
+    std::vector<bool> joined(inputs.size(), false);
+    std::unique_ptr<const ResolvedScan> scan = std::move(inputs[order[0]]);
+    joined[order[0]] = true;
+    for (int k = 1; k < order.size(); ++k) {
+      const int input = order[k];
+      joined[input] = true;
+      ExprList join_conjuncts;
+      for (int c = 0; c < conjuncts.size(); ++c) {
+        if (conjuncts[c] == nullptr) continue;
+        const std::vector<int>& conjunct_inputs = conjuncts_[c].inputs;
+        if (std::all_of(conjunct_inputs.begin(), conjunct_inputs.end(),
+                        [&joined](int i) { return joined[i]; })) {
+          join_conjuncts.push_back(std::move(conjuncts[c]));
+        }
+      }
+      std::vector<ResolvedColumn> columns;
+      if (k + 1 == order.size()) {
+        columns = column_list;
+      } else {
+        columns = scan->column_list();
+        columns.insert(columns.end(), inputs[input]->column_list().begin(),
+                       inputs[input]->column_list().end());
+      }
+      ZETASQL_ASSIGN_OR_RETURN(scan,
+                       MakeJoin(columns, std::move(scan),
+                                std::move(inputs[input]),
+                                std::move(join_conjuncts)));
+    }
+    *slot = std::move(scan);
+    return ::zetasql_base::OkStatus();
+  }
+
+  // Adds the conjuncts of <expr>, which may be nested ANDs, to <conjuncts>.
+  void AddConjuncts(std::unique_ptr<const ResolvedExpr> expr,
+                    ExprList* conjuncts) {
+    if (!IsBuiltinCall(expr.get(), FN_AND)) {
+      conjuncts->push_back(std::move(expr));
+      return;
+    }
+    and_function_ = expr->GetAs<ResolvedFunctionCall>()->function();
+    for (auto& argument : const_cast<ResolvedFunctionCall*>(
+                              expr->GetAs<ResolvedFunctionCall>())
+                              ->release_argument_list()) {
+      AddConjuncts(std::move(argument), conjuncts);
+    }
+  }
+
+  // Returns an INNER join of <left> and <right> on <conjuncts>.  Without an
+  // $and function to combine them, all but the first conjunct are computed
+  // by ResolvedFilterScans above the join.
+  zetasql_base::StatusOr<std::unique_ptr<const ResolvedScan>> MakeJoin(
+      const std::vector<ResolvedColumn>& columns,
+      std::unique_ptr<const ResolvedScan> left,
+      std::unique_ptr<const ResolvedScan> right, ExprList conjuncts) {
+    if (conjuncts.size() > 1 && and_function_ != nullptr) {
+      FunctionArgumentTypeList argument_types(
+          conjuncts.size(), FunctionArgumentType(types::BoolType()));
+      std::unique_ptr<const ResolvedExpr> join_expr = MakeResolvedFunctionCall(
+          types::BoolType(), and_function_,
+          FunctionSignature(types::BoolType(), argument_types, FN_AND),
+          std::move(conjuncts), ResolvedFunctionCall::DEFAULT_ERROR_MODE);
+      conjuncts.clear();
+      conjuncts.push_back(std::move(join_expr));
+    }
+    if (conjuncts.size() <= 1) {
+      std::unique_ptr<const ResolvedExpr> join_expr;
+      if (!conjuncts.empty()) join_expr = std::move(conjuncts[0]);
+      return std::unique_ptr<const ResolvedScan>(MakeResolvedJoinScan(
+          columns, ResolvedJoinScan::INNER, std::move(left), std::move(right),
+          std::move(join_expr)));
+    }
+
+    // The filters may reference any column of the inputs.
+    std::vector<ResolvedColumn> input_columns = left->column_list();
+    input_columns.insert(input_columns.end(), right->column_list().begin(),
+                         right->column_list().end());
+    std::unique_ptr<const ResolvedScan> scan = MakeResolvedJoinScan(
+        input_columns, ResolvedJoinScan::INNER, std::move(left),
+        std::move(right), std::move(conjuncts[0]));
+    for (int i = 1; i < conjuncts.size(); ++i) {
+      scan = MakeResolvedFilterScan(input_columns, std::move(scan),
+                                    std::move(conjuncts[i]));
+    }
+    if (input_columns != columns) {
+      scan = MakeResolvedProjectScan(columns, {}, std::move(scan));
+    }
+    return scan;
+  }
+
+  const int max_dp_inputs_;
+
+  // The estimated rows of the inputs and the conjuncts of the chain being
+  // reordered.
+  std::vector<double> input_rows_;
+  std::vector<ConjunctInfo> conjuncts_;
+
+  // The $and function of the last join condition split into conjuncts.
+  const Function* and_function_ = nullptr;
+};
+
+}  // namespace
+
+zetasql_base::Status ReorderJoins(std::unique_ptr<const ResolvedNode>* root,
+                          const JoinReorderingOptions& options) {
+  ZETASQL_RET_CHECK(root != nullptr && *root != nullptr);
+  JoinReorderer reorderer(options);
+  return reorderer.Reorder(root);
+}
+
+}  // namespace zetasql
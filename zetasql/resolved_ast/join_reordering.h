@@ -0,0 +1,58 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_RESOLVED_AST_JOIN_REORDERING_H_
+#define ZETASQL_RESOLVED_AST_JOIN_REORDERING_H_
+
+#include <memory>
+
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+
+struct JoinReorderingOptions {
+  // Chains of at most this many inputs are ordered by dynamic programming
+  // over all left-deep join orders, longer ones greedily.  Values above 16
+  // are treated as 16.
+  int max_dp_inputs = 10;
+};
+
+// Reorders the chains of INNER ResolvedJoinScans in the tree at <*root> to
+// reduce the estimated sizes of their intermediate results, using the
+// Table::GetStatistics() of the scanned tables.  The tree is modified in
+// place.
+//
+// A chain is a maximal tree of INNER joins without hints.  Its inputs are
+// joined again as a left-deep tree, and each conjunct of its join
+// conditions is computed by the first join that has all of its columns.
+// The top join keeps the original column_list, so the chain produces the
+// same columns and rows as before, possibly in another order.
+//
+// The sizes of the inputs are estimated from the row and distinct counts of
+// ResolvedTableScans, seen through ResolvedFilterScans and
+// ResolvedProjectScans.  A chain is left unchanged if the size of one of
+// its inputs is unknown, if a conjunct calls a VOLATILE function or
+// contains a subquery, or if no order is estimated to be cheaper than the
+// original one.  Run this after PushDownPredicates(), so that filters are
+// below the joins.
+zetasql_base::Status ReorderJoins(std::unique_ptr<const ResolvedNode>* root,
+                          const JoinReorderingOptions& options =
+                              JoinReorderingOptions());
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_RESOLVED_AST_JOIN_REORDERING_H_
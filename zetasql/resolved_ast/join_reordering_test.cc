@@ -0,0 +1,190 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/resolved_ast/join_reordering.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/builtin_function.pb.h"
+#include "zetasql/public/catalog.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/make_node_vector.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "zetasql/resolved_ast/resolved_column.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+
+namespace zetasql {
+
+// Joins a fact table F with dimension tables D1 and D2, where the filter on
+// D2 leaves about one row.
+class JoinReorderingTest : public ::testing::Test {
+ protected:
+  JoinReorderingTest()
+      : fact_("F", {{"f1", types::Int64Type()}, {"f2", types::Int64Type()}}),
+        dimension1_("D1", {{"k1", types::Int64Type()}}),
+        dimension2_("D2", {{"k2", types::Int64Type()}}),
+        no_statistics_("N", {{"k1", types::Int64Type()}}),
+        f1_(1, "F", "f1", types::Int64Type()),
+        f2_(2, "F", "f2", types::Int64Type()),
+        k1_(3, "D1", "k1", types::Int64Type()),
+        k2_(4, "D2", "k2", types::Int64Type()) {
+    ZETASQL_CHECK_OK(fact_.SetStatistics(Statistics(1000000, {100, 10})));
+    ZETASQL_CHECK_OK(dimension1_.SetStatistics(Statistics(100, {100})));
+    ZETASQL_CHECK_OK(dimension2_.SetStatistics(Statistics(10, {10})));
+  }
+
+  static TableStatistics Statistics(int64_t row_count,
+                                    const std::vector<int64_t>& distinct) {
+    TableStatistics statistics;
+    statistics.row_count = row_count;
+    for (int64_t distinct_count : distinct) {
+      ColumnStatistics column;
+      column.distinct_count = distinct_count;
+      statistics.columns.push_back(column);
+    }
+    return statistics;
+  }
+
+  // <column1> = <argument2>
+  std::unique_ptr<const ResolvedExpr> Equal(
+      const ResolvedColumn& column1,
+      std::unique_ptr<const ResolvedExpr> argument2) {
+    functions_.push_back(absl::make_unique<Function>(
+        "$equal", Function::kZetaSQLFunctionGroupName, Function::SCALAR));
+    return MakeResolvedFunctionCall(
+        types::BoolType(), functions_.back().get(),
+        FunctionSignature(types::BoolType(),
+                          {types::Int64Type(), types::Int64Type()}, FN_EQUAL),
+        MakeNodeVector(ColumnRef(column1), std::move(argument2)),
+        ResolvedFunctionCall::DEFAULT_ERROR_MODE);
+  }
+
+  std::unique_ptr<const ResolvedExpr> Equal(const ResolvedColumn& column1,
+                                            const ResolvedColumn& column2) {
+    return Equal(column1, ColumnRef(column2));
+  }
+
+  static std::unique_ptr<const ResolvedExpr> ColumnRef(
+      const ResolvedColumn& column) {
+    return MakeResolvedColumnRef(column.type(), column,
+                                 /*is_correlated=*/false);
+  }
+
+  static std::unique_ptr<const ResolvedScan> TableScan(
+      const Table* table, const std::vector<ResolvedColumn>& columns) {
+    auto scan = MakeResolvedTableScan(columns, table,
+                                      /*for_system_time_expr=*/nullptr);
+    for (int i = 0; i < columns.size(); ++i) {
+      scan->add_column_index_list(i);
+    }
+    return std::move(scan);
+  }
+
+  static std::unique_ptr<const ResolvedScan> Join(
+      const std::vector<ResolvedColumn>& columns,
+      std::unique_ptr<const ResolvedScan> left,
+      std::unique_ptr<const ResolvedScan> right,
+      std::unique_ptr<const ResolvedExpr> join_expr) {
+    return MakeResolvedJoinScan(columns, ResolvedJoinScan::INNER,
+                                std::move(left), std::move(right),
+                                std::move(join_expr));
+  }
+
+  std::unique_ptr<const ResolvedScan> FilteredDimension2() {
+    return MakeResolvedFilterScan(
+        {k2_}, TableScan(&dimension2_, {k2_}),
+        Equal(k2_, MakeResolvedLiteral(Value::Int64(3))));
+  }
+
+  // SELECT f1, k1, k2
+  // FROM F JOIN <dimension1> ON f1 = k1 JOIN (D2 WHERE k2 = 3) ON f2 = k2
+  std::unique_ptr<const ResolvedNode> Query(const Table* dimension1) {
+    return Join({f1_, k1_, k2_},
+                Join({f1_, f2_, k1_}, TableScan(&fact_, {f1_, f2_}),
+                     TableScan(dimension1, {k1_}), Equal(f1_, k1_)),
+                FilteredDimension2(), Equal(f2_, k2_));
+  }
+
+  SimpleTable fact_;
+  SimpleTable dimension1_;
+  SimpleTable dimension2_;
+  SimpleTable no_statistics_;
+  const ResolvedColumn f1_;
+  const ResolvedColumn f2_;
+  const ResolvedColumn k1_;
+  const ResolvedColumn k2_;
+  std::vector<std::unique_ptr<const Function>> functions_;
+};
+
+TEST_F(JoinReorderingTest, JoinsSelectiveInputFirst) {
+  std::unique_ptr<const ResolvedNode> node = Query(&dimension1_);
+  ZETASQL_ASSERT_OK(ReorderJoins(&node));
+
+  // F JOIN D2 has about 100000 rows instead of the 1000000 of F JOIN D1.
+  // The top join keeps the output columns.
+  auto expected =
+      Join({f1_, k1_, k2_},
+           Join({f1_, f2_, k2_}, TableScan(&fact_, {f1_, f2_}),
+                FilteredDimension2(), Equal(f2_, k2_)),
+           TableScan(&dimension1_, {k1_}), Equal(f1_, k1_));
+  EXPECT_EQ(expected->DebugString(), node->DebugString());
+}
+
+TEST_F(JoinReorderingTest, GreedyOrder) {
+  std::unique_ptr<const ResolvedNode> node = Query(&dimension1_);
+  JoinReorderingOptions options;
+  options.max_dp_inputs = 0;
+  ZETASQL_ASSERT_OK(ReorderJoins(&node, options));
+
+  // The greedy order starts with the smallest input.
+  auto expected =
+      Join({f1_, k1_, k2_},
+           Join({k2_, f1_, f2_}, FilteredDimension2(),
+                TableScan(&fact_, {f1_, f2_}), Equal(f2_, k2_)),
+           TableScan(&dimension1_, {k1_}), Equal(f1_, k1_));
+  EXPECT_EQ(expected->DebugString(), node->DebugString());
+}
+
+TEST_F(JoinReorderingTest, KeepsOrderWithoutStatistics) {
+  std::unique_ptr<const ResolvedNode> node = Query(&no_statistics_);
+  const std::string original = node->DebugString();
+  ZETASQL_ASSERT_OK(ReorderJoins(&node));
+  EXPECT_EQ(original, node->DebugString());
+}
+
+TEST_F(JoinReorderingTest, OuterJoinsAreNotReordered) {
+  // The LEFT join is an input of the chain above it, and its own inputs
+  // are not moved out of it.
+  auto left_join = MakeResolvedJoinScan(
+      {f1_, f2_, k1_}, ResolvedJoinScan::LEFT, TableScan(&fact_, {f1_, f2_}),
+      TableScan(&dimension1_, {k1_}), Equal(f1_, k1_));
+  std::unique_ptr<const ResolvedNode> node =
+      Join({f1_, k1_, k2_}, std::move(left_join), FilteredDimension2(),
+           Equal(f2_, k2_));
+  const std::string original = node->DebugString();
+  ZETASQL_ASSERT_OK(ReorderJoins(&node));
+  EXPECT_EQ(original, node->DebugString());
+}
+
+}  // namespace zetasql
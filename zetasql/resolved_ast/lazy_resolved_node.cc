@@ -0,0 +1,274 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/resolved_ast/lazy_resolved_node.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/wire_format_lite.h"
+#include "zetasql/resolved_ast/resolved_ast.pb.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/match.h"
+#include "zetasql/base/map_util.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/source_location.h"
+#include "zetasql/base/status_builder.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+using google::protobuf::Descriptor;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::internal::WireFormatLite;
+
+namespace {
+
+zetasql_base::Status MalformedProtoError(const Descriptor* descriptor) {
+  return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+         << "Malformed serialized " << descriptor->name();
+}
+
+// True for the AnyResolved*Proto messages, which hold a oneof of the
+// concrete nodes of one class.
+bool IsAnyNodeProto(const Descriptor* descriptor) {
+  return absl::StartsWith(descriptor->name(), "AnyResolved");
+}
+
+// Maps each concrete node proto to the field numbers leading to it from
+// AnyResolvedNodeProto.  The last field number is the node kind.
+using NodePathMap = absl::flat_hash_map<const Descriptor*, std::vector<int>>;
+
+void AddNodePaths(const Descriptor* any_descriptor, std::vector<int>* path,
+                  NodePathMap* paths) {
+  for (int i = 0; i < any_descriptor->field_count(); ++i) {
+    const FieldDescriptor* field = any_descriptor->field(i);
+    path->push_back(field->number());
+    if (IsAnyNodeProto(field->message_type())) {
+      AddNodePaths(field->message_type(), path, paths);
+    } else {
+      paths->emplace(field->message_type(), *path);
+    }
+    path->pop_back();
+  }
+}
+
+const NodePathMap& GetNodePaths() {
+  static const NodePathMap* paths = [] {
+    NodePathMap* paths = new NodePathMap;
+    std::vector<int> path;
+    AddNodePaths(AnyResolvedNodeProto::descriptor(), &path, paths);
+    return paths;
+  }();
+  return *paths;
+}
+
+bool IsNodeField(const FieldDescriptor* field) {
+  return field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE &&
+         (IsAnyNodeProto(field->message_type()) ||
+          GetNodePaths().contains(field->message_type()));
+}
+
+// Appends the payload of every length-delimited occurrence of field
+// <field_number> in the serialized message <bytes> to <*values>.  Other
+// fields are skipped without being decoded.
+bool FindLengthDelimitedFields(absl::string_view bytes, int field_number,
+                               std::vector<absl::string_view>* values) {
+  google::protobuf::io::CodedInputStream input(
+      reinterpret_cast<const uint8_t*>(bytes.data()),
+      static_cast<int>(bytes.size()));
+  while (true) {
+    const uint32_t tag = input.ReadTag();
+    if (tag == 0) return input.ConsumedEntireMessage();
+    if (WireFormatLite::GetTagFieldNumber(tag) == field_number &&
+        WireFormatLite::GetTagWireType(tag) ==
+            WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+      uint32_t length;
+      if (!input.ReadVarint32(&length)) return false;
+      const int start = input.CurrentPosition();
+      if (!input.Skip(length)) return false;
+      values->push_back(bytes.substr(start, length));
+    } else if (!WireFormatLite::SkipField(&input, tag)) {
+      return false;
+    }
+  }
+}
+
+// Returns <bytes> as the payload of length-delimited field <field_number>.
+std::string WrapInField(int field_number, const std::string& bytes) {
+  std::string wrapped;
+  {
+    google::protobuf::io::StringOutputStream stream(&wrapped);
+    google::protobuf::io::CodedOutputStream output(&stream);
+    output.WriteTag(WireFormatLite::MakeTag(
+        field_number, WireFormatLite::WIRETYPE_LENGTH_DELIMITED));
+    output.WriteVarint32(static_cast<uint32_t>(bytes.size()));
+    output.WriteString(bytes);
+  }
+  return wrapped;
+}
+
+}  // namespace
+
+zetasql_base::StatusOr<LazyResolvedNode> LazyResolvedNode::FromAnyResolvedNodeProto(
+    absl::string_view serialized) {
+  return Create(AnyResolvedNodeProto::descriptor(), serialized);
+}
+
+zetasql_base::StatusOr<LazyResolvedNode>
+LazyResolvedNode::FromAnyResolvedStatementProto(absl::string_view serialized) {
+  return Create(AnyResolvedStatementProto::descriptor(), serialized);
+}
+
+zetasql_base::StatusOr<LazyResolvedNode> LazyResolvedNode::Create(
+    const Descriptor* descriptor, absl::string_view bytes) {
+  // Unwrap AnyResolved*Proto messages down to the concrete node.  Each has
+  // only a oneof, so the node is its last length-delimited field.
+  while (IsAnyNodeProto(descriptor)) {
+    const Descriptor* any_descriptor = descriptor;
+    google::protobuf::io::CodedInputStream input(
+        reinterpret_cast<const uint8_t*>(bytes.data()),
+        static_cast<int>(bytes.size()));
+    const FieldDescriptor* node_field = nullptr;
+    absl::string_view node_bytes;
+    while (true) {
+      const uint32_t tag = input.ReadTag();
+      if (tag == 0) break;
+      const FieldDescriptor* field = any_descriptor->FindFieldByNumber(
+          WireFormatLite::GetTagFieldNumber(tag));
+      if (field != nullptr && WireFormatLite::GetTagWireType(tag) ==
+                                  WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+        uint32_t length;
+        if (!input.ReadVarint32(&length)) {
+          return MalformedProtoError(any_descriptor);
+        }
+        const int start = input.CurrentPosition();
+        if (!input.Skip(length)) return MalformedProtoError(any_descriptor);
+        node_field = field;
+        node_bytes = bytes.substr(start, length);
+      } else if (!WireFormatLite::SkipField(&input, tag)) {
+        return MalformedProtoError(any_descriptor);
+      }
+    }
+    if (!input.ConsumedEntireMessage()) {
+      return MalformedProtoError(any_descriptor);
+    }
+    if (node_field == nullptr) {
+      return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+             << "Serialized " << any_descriptor->name() << " has no node";
+    }
+    descriptor = node_field->message_type();
+    bytes = node_bytes;
+  }
+
+  const std::vector<int>* path = zetasql_base::FindOrNull(GetNodePaths(), descriptor);
+  ZETASQL_RET_CHECK(path != nullptr) << descriptor->full_name() << " is not a node";
+  return LazyResolvedNode(descriptor, bytes,
+                          static_cast<ResolvedNodeKind>(path->back()));
+}
+
+zetasql_base::Status LazyResolvedNode::FindFieldValues(
+    absl::string_view field_name, const FieldDescriptor** field,
+    std::vector<absl::string_view>* values) const {
+  // Fields of superclasses are in the nested <parent> message.
+  const Descriptor* descriptor = descriptor_;
+  absl::string_view bytes = bytes_;
+  while (true) {
+    *field = descriptor->FindFieldByName(std::string(field_name));
+    if (*field != nullptr) break;
+    const FieldDescriptor* parent = descriptor->FindFieldByName("parent");
+    if (parent == nullptr) {
+      return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+             << ResolvedNodeKindToString(node_kind_) << " has no field "
+             << field_name;
+    }
+    std::vector<absl::string_view> parent_bytes;
+    if (!FindLengthDelimitedFields(bytes, parent->number(), &parent_bytes)) {
+      return MalformedProtoError(descriptor);
+    }
+    descriptor = parent->message_type();
+    // Repeated occurrences of a message field are merged when parsing, so
+    // only the last one is used here.  SaveTo() writes each field once.
+    bytes = parent_bytes.empty() ? absl::string_view() : parent_bytes.back();
+  }
+  if (!IsNodeField(*field)) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "Field " << field_name << " of "
+           << ResolvedNodeKindToString(node_kind_) << " is not a node";
+  }
+  if (!FindLengthDelimitedFields(bytes, (*field)->number(), values)) {
+    return MalformedProtoError(descriptor);
+  }
+  if (!(*field)->is_repeated() && values->size() > 1) {
+    values->erase(values->begin(), values->end() - 1);
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::StatusOr<LazyResolvedNode> LazyResolvedNode::GetChild(
+    absl::string_view field_name) const {
+  const FieldDescriptor* field;
+  std::vector<absl::string_view> values;
+  ZETASQL_RETURN_IF_ERROR(FindFieldValues(field_name, &field, &values));
+  if (field->is_repeated()) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "Field " << field_name << " of "
+           << ResolvedNodeKindToString(node_kind_)
+           << " is repeated; use GetChildren()";
+  }
+  if (values.empty()) {
+    return ::zetasql_base::NotFoundErrorBuilder(ZETASQL_LOC)
+           << "Field " << field_name << " of "
+           << ResolvedNodeKindToString(node_kind_) << " is not set";
+  }
+  return Create(field->message_type(), values.back());
+}
+
+zetasql_base::StatusOr<std::vector<LazyResolvedNode>> LazyResolvedNode::GetChildren(
+    absl::string_view field_name) const {
+  const FieldDescriptor* field;
+  std::vector<absl::string_view> values;
+  ZETASQL_RETURN_IF_ERROR(FindFieldValues(field_name, &field, &values));
+  std::vector<LazyResolvedNode> children;
+  children.reserve(values.size());
+  for (absl::string_view value : values) {
+    ZETASQL_ASSIGN_OR_RETURN(LazyResolvedNode child,
+                     Create(field->message_type(), value));
+    children.push_back(child);
+  }
+  return children;
+}
+
+zetasql_base::StatusOr<std::unique_ptr<ResolvedNode>> LazyResolvedNode::Restore(
+    const ResolvedNode::RestoreParams& params) const {
+  // Rewrap the node in the AnyResolved*Proto messages leading to it, so
+  // that the generic ResolvedNode::RestoreFrom() can dispatch on it.
+  const std::vector<int>& path = GetNodePaths().at(descriptor_);
+  std::string bytes(bytes_);
+  for (auto it = path.rbegin(); it != path.rend(); ++it) {
+    bytes = WrapInField(*it, bytes);
+  }
+  AnyResolvedNodeProto proto;
+  if (!proto.ParseFromString(bytes)) {
+    return MalformedProtoError(descriptor_);
+  }
+  return ResolvedNode::RestoreFrom(proto, params);
+}
+
+}  // namespace zetasql
@@ -0,0 +1,108 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_RESOLVED_AST_LAZY_RESOLVED_NODE_H_
+#define ZETASQL_RESOLVED_AST_LAZY_RESOLVED_NODE_H_
+
+#include <memory>
+#include <vector>
+
+#include "google/protobuf/descriptor.h"
+#include "zetasql/resolved_ast/resolved_node.h"
+#include "zetasql/resolved_ast/resolved_node_kind.h"
+#include "absl/strings/string_view.h"
+#include "zetasql/base/status.h"
+#include "zetasql/base/statusor.h"
+
+namespace zetasql {
+
+// A node in a serialized resolved AST that has not been deserialized.
+//
+// A LazyResolvedNode points at the serialized bytes of one node in an
+// AnyResolvedNodeProto or AnyResolvedStatementProto.  Its children are
+// reached by field name without parsing or restoring anything else, and
+// only the subtree that is finally needed is restored, with Restore().
+// For example, a worker that runs one scan of a serialized plan can do
+//
+//   ZETASQL_ASSIGN_OR_RETURN(LazyResolvedNode stmt,
+//                    LazyResolvedNode::FromAnyResolvedStatementProto(bytes));
+//   ZETASQL_ASSIGN_OR_RETURN(LazyResolvedNode query, stmt.GetChild("query"));
+//   ZETASQL_ASSIGN_OR_RETURN(LazyResolvedNode input, query.GetChild("input_scan"));
+//   ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ResolvedNode> scan,
+//                    input.Restore(params));
+//
+// Sibling subtrees are skipped using their length prefixes, so navigation
+// costs time proportional to the number of fields in the nodes on the
+// path, not the size of the tree.
+//
+// The serialized bytes are not copied and must outlive the
+// LazyResolvedNode and any nodes reached from it.
+class LazyResolvedNode {
+ public:
+  // Creates a node from a serialized AnyResolvedNodeProto.
+  static zetasql_base::StatusOr<LazyResolvedNode> FromAnyResolvedNodeProto(
+      absl::string_view serialized);
+
+  // Creates a node from a serialized AnyResolvedStatementProto.
+  static zetasql_base::StatusOr<LazyResolvedNode> FromAnyResolvedStatementProto(
+      absl::string_view serialized);
+
+  LazyResolvedNode(const LazyResolvedNode&) = default;
+  LazyResolvedNode& operator=(const LazyResolvedNode&) = default;
+
+  ResolvedNodeKind node_kind() const { return node_kind_; }
+
+  // Returns the child node in field <field_name>, which is the name of a
+  // node-valued field of this node or of one of its superclasses, as in
+  // resolved_ast.proto.  Returns an error if the field is not set, is
+  // repeated, or does not hold a node.
+  zetasql_base::StatusOr<LazyResolvedNode> GetChild(absl::string_view field_name) const;
+
+  // Returns the child nodes in field <field_name>, which may be repeated or
+  // not.  An unset field gives an empty vector.
+  zetasql_base::StatusOr<std::vector<LazyResolvedNode>> GetChildren(
+      absl::string_view field_name) const;
+
+  // Deserializes this node and its whole subtree.
+  zetasql_base::StatusOr<std::unique_ptr<ResolvedNode>> Restore(
+      const ResolvedNode::RestoreParams& params) const;
+
+ private:
+  LazyResolvedNode(const google::protobuf::Descriptor* descriptor,
+                   absl::string_view bytes, ResolvedNodeKind node_kind)
+      : descriptor_(descriptor), bytes_(bytes), node_kind_(node_kind) {}
+
+  // Creates the node for the serialized message <bytes> of type
+  // <descriptor>, which is either a concrete node proto like
+  // ResolvedProjectScanProto, or one of the AnyResolved*Proto wrappers.
+  static zetasql_base::StatusOr<LazyResolvedNode> Create(
+      const google::protobuf::Descriptor* descriptor, absl::string_view bytes);
+
+  // Finds the field named <field_name> in this node's proto or one of its
+  // <parent> protos, and returns all serialized values of it.
+  zetasql_base::Status FindFieldValues(absl::string_view field_name,
+                               const google::protobuf::FieldDescriptor** field,
+                               std::vector<absl::string_view>* values) const;
+
+  // The concrete node proto, e.g. ResolvedProjectScanProto, and its bytes.
+  const google::protobuf::Descriptor* descriptor_;
+  absl::string_view bytes_;
+  ResolvedNodeKind node_kind_;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_RESOLVED_AST_LAZY_RESOLVED_NODE_H_
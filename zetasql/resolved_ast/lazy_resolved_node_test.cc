@@ -0,0 +1,151 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/resolved_ast/lazy_resolved_node.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/id_string.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/make_node_vector.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "zetasql/resolved_ast/resolved_ast.pb.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace zetasql {
+
+using zetasql_base::testing::StatusIs;
+
+class LazyResolvedNodeTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    catalog_.AddOwnedTable(new SimpleTable(
+        "T", {{"a", types::Int64Type()}, {"b", types::StringType()}}));
+    const Table* table;
+    ZETASQL_ASSERT_OK(catalog_.GetTable("T", &table));
+
+    const ResolvedColumn a(1, "T", "a", types::Int64Type());
+    const ResolvedColumn b(2, "T", "b", types::StringType());
+    const ResolvedColumn c(3, "$query", "c", types::Int64Type());
+    statement_ = MakeResolvedQueryStmt(
+        MakeNodeVector(MakeResolvedOutputColumn("c", c)),
+        /*is_value_table=*/false,
+        MakeResolvedProjectScan(
+            {c},
+            MakeNodeVector(MakeResolvedComputedColumn(
+                c, MakeResolvedLiteral(Value::Int64(5)))),
+            MakeResolvedTableScan({a, b}, table,
+                                  /*for_system_time_expr=*/nullptr)));
+
+    Type::FileDescriptorSetMap map;
+    AnyResolvedStatementProto proto;
+    ZETASQL_ASSERT_OK(statement_->SaveTo(&map, &proto));
+    ASSERT_TRUE(proto.SerializeToString(&serialized_));
+  }
+
+  TypeFactory type_factory_;
+  SimpleCatalog catalog_{"catalog"};
+  std::unique_ptr<const ResolvedQueryStmt> statement_;
+  std::string serialized_;
+};
+
+TEST_F(LazyResolvedNodeTest, RestoreSubtree) {
+  auto statement = LazyResolvedNode::FromAnyResolvedStatementProto(serialized_);
+  ZETASQL_ASSERT_OK(statement.status());
+  EXPECT_EQ(RESOLVED_QUERY_STMT, statement.ValueOrDie().node_kind());
+
+  auto query = statement.ValueOrDie().GetChild("query");
+  ZETASQL_ASSERT_OK(query.status());
+  EXPECT_EQ(RESOLVED_PROJECT_SCAN, query.ValueOrDie().node_kind());
+
+  auto input_scan = query.ValueOrDie().GetChild("input_scan");
+  ZETASQL_ASSERT_OK(input_scan.status());
+  EXPECT_EQ(RESOLVED_TABLE_SCAN, input_scan.ValueOrDie().node_kind());
+
+  IdStringPool string_pool;
+  ResolvedNode::RestoreParams params(/*pools=*/{}, &catalog_, &type_factory_,
+                                     &string_pool);
+  auto restored = input_scan.ValueOrDie().Restore(params);
+  ZETASQL_ASSERT_OK(restored.status());
+  EXPECT_EQ(statement_->query()
+                ->GetAs<ResolvedProjectScan>()
+                ->input_scan()
+                ->DebugString(),
+            restored.ValueOrDie()->DebugString());
+
+  auto whole = statement.ValueOrDie().Restore(params);
+  ZETASQL_ASSERT_OK(whole.status());
+  EXPECT_EQ(statement_->DebugString(), whole.ValueOrDie()->DebugString());
+}
+
+TEST_F(LazyResolvedNodeTest, GetChildren) {
+  auto statement = LazyResolvedNode::FromAnyResolvedStatementProto(serialized_);
+  ZETASQL_ASSERT_OK(statement.status());
+  auto output_columns =
+      statement.ValueOrDie().GetChildren("output_column_list");
+  ZETASQL_ASSERT_OK(output_columns.status());
+  ASSERT_EQ(1, output_columns.ValueOrDie().size());
+  EXPECT_EQ(RESOLVED_OUTPUT_COLUMN,
+            output_columns.ValueOrDie()[0].node_kind());
+
+  auto query = statement.ValueOrDie().GetChild("query");
+  ZETASQL_ASSERT_OK(query.status());
+  auto expr_list = query.ValueOrDie().GetChildren("expr_list");
+  ZETASQL_ASSERT_OK(expr_list.status());
+  ASSERT_EQ(1, expr_list.ValueOrDie().size());
+  auto expr = expr_list.ValueOrDie()[0].GetChild("expr");
+  ZETASQL_ASSERT_OK(expr.status());
+  EXPECT_EQ(RESOLVED_LITERAL, expr.ValueOrDie().node_kind());
+
+  // Superclass fields are found through the <parent> message.
+  auto hints = query.ValueOrDie().GetChildren("hint_list");
+  ZETASQL_ASSERT_OK(hints.status());
+  EXPECT_TRUE(hints.ValueOrDie().empty());
+}
+
+TEST_F(LazyResolvedNodeTest, Errors) {
+  auto statement = LazyResolvedNode::FromAnyResolvedStatementProto(serialized_);
+  ZETASQL_ASSERT_OK(statement.status());
+  const LazyResolvedNode& node = statement.ValueOrDie();
+  EXPECT_THAT(node.GetChild("no_such_field").status(),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+  EXPECT_THAT(node.GetChild("is_value_table").status(),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+  EXPECT_THAT(node.GetChild("output_column_list").status(),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+  EXPECT_THAT(node.GetChild("hint_list").status(),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+
+  auto query = node.GetChild("query");
+  ZETASQL_ASSERT_OK(query.status());
+  auto input_scan = query.ValueOrDie().GetChild("input_scan");
+  ZETASQL_ASSERT_OK(input_scan.status());
+  EXPECT_THAT(input_scan.ValueOrDie().GetChild("for_system_time_expr").status(),
+              StatusIs(zetasql_base::StatusCode::kNotFound));
+
+  EXPECT_THAT(LazyResolvedNode::FromAnyResolvedStatementProto(
+                  serialized_.substr(0, serialized_.size() / 2))
+                  .status(),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+}
+
+}  // namespace zetasql
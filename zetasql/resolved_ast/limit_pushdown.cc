@@ -0,0 +1,317 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/resolved_ast/limit_pushdown.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/resolved_column.h"
+#include "zetasql/resolved_ast/resolved_node_kind.pb.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/status_macros.h"
+#include "zetasql/base/statusor.h"
+
+namespace zetasql {
+
+namespace {
+
+typedef std::unique_ptr<const ResolvedNode>* NodeSlot;
+
+// Returns the slots of the children of <node>, which the caller owns.
+std::vector<NodeSlot> MutableChildren(const ResolvedNode* node) {
+  std::vector<NodeSlot> children;
+  const_cast<ResolvedNode*>(node)->AddMutableChildNodePointers(&children);
+  return children;
+}
+
+// Sets <*count> to the value of <expr> if it is a non-NULL, non-negative
+// INT64 literal, and returns false otherwise.
+bool GetLiteralCount(const ResolvedExpr* expr, int64_t* count) {
+  if (expr->node_kind() != RESOLVED_LITERAL) return false;
+  const Value& value = expr->GetAs<ResolvedLiteral>()->value();
+  if (value.type_kind() != TYPE_INT64 || value.is_null() ||
+      value.int64_value() < 0) {
+    return false;
+  }
+  *count = value.int64_value();
+  return true;
+}
+
+// Sets <*rows> to the largest number of rows that <limit> reads from its
+// input, LIMIT + OFFSET, and returns false if that is not known.
+bool GetRowsRead(const ResolvedLimitOffsetScan* limit, int64_t* rows) {
+  int64_t count = 0;
+  if (!GetLiteralCount(limit->limit(), &count)) return false;
+  int64_t offset = 0;
+  if (limit->offset() != nullptr &&
+      !GetLiteralCount(limit->offset(), &offset)) {
+    return false;
+  }
+  if (count > std::numeric_limits<int64_t>::max() - offset) return false;
+  *rows = count + offset;
+  return true;
+}
+
+class LimitPusher {
+ public:
+  LimitPusher() {}
+  LimitPusher(const LimitPusher&) = delete;
+  LimitPusher& operator=(const LimitPusher&) = delete;
+
+  zetasql_base::Status Run(NodeSlot root) {
+    std::vector<NodeSlot> pending = {root};
+    while (!pending.empty()) {
+      NodeSlot slot = pending.back();
+      pending.pop_back();
+      // A limit moved below a projection is visited again as its child.
+      if ((*slot)->node_kind() == RESOLVED_LIMIT_OFFSET_SCAN) {
+        ZETASQL_RETURN_IF_ERROR(PushDownLimit(slot));
+      }
+      for (NodeSlot child : MutableChildren(slot->get())) {
+        pending.push_back(child);
+      }
+    }
+    return ::zetasql_base::OkStatus();
+  }
+
+ private:
+  // Moves the ResolvedLimitOffsetScan in <slot> one scan down, or adds
+  // limits to the inputs of the UNION ALL below it.
+  zetasql_base::Status PushDownLimit(NodeSlot slot) {
+    const auto* limit = (*slot)->GetAs<ResolvedLimitOffsetScan>();
+    int64_t rows = 0;
+    if (!GetRowsRead(limit, &rows)) return ::zetasql_base::OkStatus();
+    switch (limit->input_scan()->node_kind()) {
+      case RESOLVED_PROJECT_SCAN:
+        return MoveBelowProject(slot);
+      case RESOLVED_SET_OPERATION_SCAN:
+        return LimitInputs(
+            limit->input_scan()->GetAs<ResolvedSetOperationScan>(), rows);
+      default:
+        return ::zetasql_base::OkStatus();
+    }
+  }
+
+  // Swaps the ResolvedLimitOffsetScan in <slot> with the ResolvedProjectScan
+  // below it.
+  static zetasql_base::Status MoveBelowProject(NodeSlot slot) {
+    std::unique_ptr<ResolvedLimitOffsetScan> limit(
+        const_cast<ResolvedLimitOffsetScan*>(
+            slot->release()->GetAs<ResolvedLimitOffsetScan>()));
+    std::unique_ptr<const ResolvedScan> project_scan =
+        limit->release_input_scan();
+    ZETASQL_RET_CHECK_EQ(RESOLVED_PROJECT_SCAN, project_scan->node_kind());
+    auto* project = const_cast<ResolvedProjectScan*>(
+        project_scan->GetAs<ResolvedProjectScan>());
+
+    std::unique_ptr<const ResolvedScan> input = project->release_input_scan();
+    project->set_column_list(limit->column_list());
+    project->set_is_ordered(limit->is_ordered());
+    limit->set_column_list(input->column_list());
+    limit->set_is_ordered(input->is_ordered());
+    limit->set_input_scan(std::move(input));
+    project->set_input_scan(std::move(limit));
+    *slot = std::move(project_scan);
+    return ::zetasql_base::OkStatus();
+  }
+
+  // Adds a limit of <rows> rows to each input of <set_operation>, if it is
+  // a UNION ALL.
+  static zetasql_base::Status LimitInputs(
+      const ResolvedSetOperationScan* set_operation, int64_t rows) {
+    if (set_operation->op_type() != ResolvedSetOperationScan::UNION_ALL) {
+      return ::zetasql_base::OkStatus();
+    }
+    for (const auto& item : set_operation->input_item_list()) {
+      if (item->scan()->node_kind() == RESOLVED_LIMIT_OFFSET_SCAN) {
+        int64_t count = 0;
+        if (GetLiteralCount(
+                item->scan()->GetAs<ResolvedLimitOffsetScan>()->limit(),
+                &count) &&
+            count <= rows) {
+          continue;
+        }
+      }
+      auto* mutable_item = const_cast<ResolvedSetOperationItem*>(item.get());
+      std::unique_ptr<const ResolvedScan> scan = mutable_item->release_scan();
+      const std::vector<ResolvedColumn> columns = scan->column_list();
+      mutable_item->set_scan(MakeResolvedLimitOffsetScan(
+          columns, std::move(scan), MakeResolvedLiteral(Value::Int64(rows)),
+          /*offset=*/nullptr));
+    }
+    return ::zetasql_base::OkStatus();
+  }
+};
+
+// Finds the scans that LIMITs read a bounded number of rows from.
+class LimitFinder {
+ public:
+  // Either output may be null.
+  LimitFinder(OrderByScanLimits* order_by_limits,
+              TableScanPushdowns* pushdowns)
+      : order_by_limits_(order_by_limits), pushdowns_(pushdowns) {}
+  LimitFinder(const LimitFinder&) = delete;
+  LimitFinder& operator=(const LimitFinder&) = delete;
+
+  void Run(const ResolvedNode* root) {
+    std::vector<const ResolvedNode*> stack = {root};
+    std::vector<const ResolvedNode*> children;
+    while (!stack.empty()) {
+      const ResolvedNode* node = stack.back();
+      stack.pop_back();
+      if (node->node_kind() == RESOLVED_LIMIT_OFFSET_SCAN) {
+        const auto* limit = node->GetAs<ResolvedLimitOffsetScan>();
+        int64_t rows = 0;
+        if (GetRowsRead(limit, &rows)) {
+          Visit(limit->input_scan(), rows, /*order_by=*/nullptr);
+        }
+      }
+      node->GetChildNodes(&children);
+      stack.insert(stack.end(), children.begin(), children.end());
+    }
+  }
+
+ private:
+  // Records that at most <rows> rows are read from <scan>, in the order of
+  // <order_by> if it is not null.
+  void Visit(const ResolvedScan* scan, int64_t rows,
+             const ResolvedOrderByScan* order_by) {
+    switch (scan->node_kind()) {
+      case RESOLVED_PROJECT_SCAN:
+        Visit(scan->GetAs<ResolvedProjectScan>()->input_scan(), rows,
+              order_by);
+        return;
+      case RESOLVED_LIMIT_OFFSET_SCAN: {
+        // A limit below an ORDER BY does not return the first rows in its
+        // order.
+        if (order_by != nullptr) return;
+        const auto* limit = scan->GetAs<ResolvedLimitOffsetScan>();
+        int64_t count = 0;
+        int64_t offset = 0;
+        if (!GetLiteralCount(limit->limit(), &count) ||
+            (limit->offset() != nullptr &&
+             !GetLiteralCount(limit->offset(), &offset)) ||
+            count > std::numeric_limits<int64_t>::max() - offset) {
+          return;
+        }
+        Visit(limit->input_scan(), offset + std::min(rows, count), order_by);
+        return;
+      }
+      case RESOLVED_ORDER_BY_SCAN: {
+        // The order of an ORDER BY below another one does not matter.
+        if (order_by != nullptr) return;
+        const auto* order_by_scan = scan->GetAs<ResolvedOrderByScan>();
+        if (order_by_limits_ != nullptr) {
+          auto it = order_by_limits_->find(order_by_scan);
+          if (it == order_by_limits_->end()) {
+            (*order_by_limits_)[order_by_scan] = rows;
+          } else {
+            it->second = std::min(it->second, rows);
+          }
+        }
+        Visit(order_by_scan->input_scan(), rows, order_by_scan);
+        return;
+      }
+      case RESOLVED_SET_OPERATION_SCAN: {
+        const auto* set_operation = scan->GetAs<ResolvedSetOperationScan>();
+        if (order_by != nullptr ||
+            set_operation->op_type() != ResolvedSetOperationScan::UNION_ALL) {
+          return;
+        }
+        for (const auto& item : set_operation->input_item_list()) {
+          Visit(item->scan(), rows, /*order_by=*/nullptr);
+        }
+        return;
+      }
+      case RESOLVED_TABLE_SCAN:
+        AddPushdown(scan->GetAs<ResolvedTableScan>(), rows, order_by);
+        return;
+      default:
+        return;
+    }
+  }
+
+  void AddPushdown(const ResolvedTableScan* scan, int64_t rows,
+                   const ResolvedOrderByScan* order_by) {
+    if (pushdowns_ == nullptr) return;
+    std::vector<ScanPushdown::SortKey> sort_keys;
+    if (order_by != nullptr) {
+      for (const auto& item : order_by->order_by_item_list()) {
+        if (item->collation_name() != nullptr) return;
+        const int column_id = item->column_ref()->column().column_id();
+        int column = -1;
+        for (int i = 0; i < scan->column_list_size(); ++i) {
+          if (scan->column_list(i).column_id() == column_id) {
+            column = i;
+            break;
+          }
+        }
+        // Without the sort order, the first rows are not the top N.
+        if (column < 0) return;
+        ScanPushdown::SortKey key;
+        key.column = column;
+        key.descending = item->is_descending();
+        sort_keys.push_back(key);
+      }
+    }
+    auto it = pushdowns_->find(scan);
+    if (it != pushdowns_->end() && it->second.limit.has_value() &&
+        *it->second.limit <= rows) {
+      return;
+    }
+    ScanPushdown& pushdown = (*pushdowns_)[scan];
+    pushdown.limit = rows;
+    pushdown.order_by = std::move(sort_keys);
+  }
+
+  OrderByScanLimits* order_by_limits_;
+  TableScanPushdowns* pushdowns_;
+};
+
+}  // namespace
+
+zetasql_base::Status PushDownLimits(std::unique_ptr<const ResolvedNode>* root) {
+  ZETASQL_RET_CHECK(root != nullptr && *root != nullptr);
+  LimitPusher pusher;
+  return pusher.Run(root);
+}
+
+zetasql_base::Status FindTopNOrderByScans(const ResolvedNode* node,
+                                  OrderByScanLimits* limits) {
+  ZETASQL_RET_CHECK(node != nullptr);
+  ZETASQL_RET_CHECK(limits != nullptr);
+  limits->clear();
+  LimitFinder finder(limits, /*pushdowns=*/nullptr);
+  finder.Run(node);
+  return ::zetasql_base::OkStatus();
+}
+
+zetasql_base::Status FindTableScanPushdowns(const ResolvedNode* node,
+                                    TableScanPushdowns* pushdowns) {
+  ZETASQL_RET_CHECK(node != nullptr);
+  ZETASQL_RET_CHECK(pushdowns != nullptr);
+  pushdowns->clear();
+  LimitFinder finder(/*order_by_limits=*/nullptr, pushdowns);
+  finder.Run(node);
+  return ::zetasql_base::OkStatus();
+}
+
+}  // namespace zetasql
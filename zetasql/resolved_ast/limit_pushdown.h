@@ -0,0 +1,72 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_RESOLVED_AST_LIMIT_PUSHDOWN_H_
+#define ZETASQL_RESOLVED_AST_LIMIT_PUSHDOWN_H_
+
+#include <cstdint>
+#include <memory>
+
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "absl/container/flat_hash_map.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+
+// Moves the ResolvedLimitOffsetScans in the tree at <*root> closer to the
+// scans producing their rows, so that fewer rows are produced and computed.
+// The tree is modified in place.
+//
+// Only LIMITs and OFFSETs that are INT64 literals move.  A
+// ResolvedLimitOffsetScan
+//   - above a ResolvedProjectScan moves below it, so that the computed
+//     columns are only computed for the rows returned, and
+//   - above a UNION ALL ResolvedSetOperationScan stays, and each input of the
+//     union gets a copy with LIMIT <limit> + <offset> and no OFFSET, unless
+//     it already has a LIMIT that is no larger.
+zetasql_base::Status PushDownLimits(std::unique_ptr<const ResolvedNode>* root);
+
+// For each ResolvedOrderByScan read by a LIMIT, directly or through
+// ResolvedProjectScans and other LIMITs, the largest number of rows read from
+// it, so that the sort only needs to keep the top N rows.
+typedef absl::flat_hash_map<const ResolvedOrderByScan*, int64_t>
+    OrderByScanLimits;
+
+// Finds the top-N ResolvedOrderByScans in the tree at <node>.  Only LIMITs
+// and OFFSETs that are INT64 literals are used.
+zetasql_base::Status FindTopNOrderByScans(const ResolvedNode* node,
+                                  OrderByScanLimits* limits);
+
+// For each ResolvedTableScan read by a LIMIT, the ScanPushdown::limit and
+// ScanPushdown::order_by to pass to its EvaluatorTableIterator.  Column
+// numbers are indexes in the scan's column_list.
+typedef absl::flat_hash_map<const ResolvedTableScan*, ScanPushdown>
+    TableScanPushdowns;
+
+// Finds the pushdowns of the ResolvedTableScans in the tree at <node>.  A
+// LIMIT passes through the scans that FindTopNOrderByScans() looks through
+// and UNION ALLs.  A ResolvedOrderByScan of only columns of the table scan
+// below it, without collations, becomes the pushdown's order_by, so that an
+// iterator returning its rows in that order only reads the top N.  Other
+// scans, like filters, stop the LIMIT.  The required_columns and filters of
+// the pushdowns are not set.
+zetasql_base::Status FindTableScanPushdowns(const ResolvedNode* node,
+                                    TableScanPushdowns* pushdowns);
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_RESOLVED_AST_LIMIT_PUSHDOWN_H_
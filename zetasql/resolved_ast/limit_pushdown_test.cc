@@ -0,0 +1,220 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/resolved_ast/limit_pushdown.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/make_node_vector.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "zetasql/resolved_ast/resolved_column.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace zetasql {
+
+class LimitPushdownTest : public ::testing::Test {
+ protected:
+  LimitPushdownTest()
+      : table_("T", {{"a", types::Int64Type()}, {"b", types::Int64Type()}}),
+        a_(1, "T", "a", types::Int64Type()),
+        b_(2, "T", "b", types::Int64Type()),
+        c_(3, "T", "a", types::Int64Type()),
+        x_(4, "$query", "x", types::Int64Type()),
+        u_(5, "$union_all", "a", types::Int64Type()) {}
+
+  static std::unique_ptr<const ResolvedExpr> Int64(int64_t value) {
+    return MakeResolvedLiteral(Value::Int64(value));
+  }
+
+  std::unique_ptr<const ResolvedScan> TableScan(
+      const std::vector<ResolvedColumn>& columns) {
+    return MakeResolvedTableScan(columns, &table_,
+                                 /*for_system_time_expr=*/nullptr);
+  }
+
+  static std::unique_ptr<const ResolvedScan> Limit(
+      int64_t limit, std::unique_ptr<const ResolvedScan> input,
+      std::unique_ptr<const ResolvedExpr> offset = nullptr) {
+    const std::vector<ResolvedColumn> columns = input->column_list();
+    return MakeResolvedLimitOffsetScan(columns, std::move(input), Int64(limit),
+                                       std::move(offset));
+  }
+
+  // SELECT a, b, 1 AS x FROM <input>
+  std::unique_ptr<const ResolvedScan> Project(
+      std::unique_ptr<const ResolvedScan> input) {
+    return MakeResolvedProjectScan(
+        {a_, b_, x_}, MakeNodeVector(MakeResolvedComputedColumn(x_, Int64(1))),
+        std::move(input));
+  }
+
+  // <left> UNION ALL <right>, of the first columns of the inputs.
+  std::unique_ptr<const ResolvedScan> UnionAll(
+      std::unique_ptr<const ResolvedScan> left,
+      std::unique_ptr<const ResolvedScan> right) {
+    const ResolvedColumn left_column = left->column_list(0);
+    const ResolvedColumn right_column = right->column_list(0);
+    return MakeResolvedSetOperationScan(
+        {u_}, ResolvedSetOperationScan::UNION_ALL,
+        MakeNodeVector(
+            MakeResolvedSetOperationItem(std::move(left), {left_column}),
+            MakeResolvedSetOperationItem(std::move(right), {right_column})));
+  }
+
+  static std::unique_ptr<const ResolvedOrderByScan> OrderBy(
+      const ResolvedColumn& column, bool is_descending,
+      std::unique_ptr<const ResolvedScan> input) {
+    const std::vector<ResolvedColumn> columns = input->column_list();
+    auto order_by = MakeResolvedOrderByScan(
+        columns, std::move(input),
+        MakeNodeVector(MakeResolvedOrderByItem(
+            MakeResolvedColumnRef(column.type(), column,
+                                  /*is_correlated=*/false),
+            /*collation_name=*/nullptr, is_descending)));
+    order_by->set_is_ordered(true);
+    return std::move(order_by);
+  }
+
+  SimpleTable table_;
+  const ResolvedColumn a_;
+  const ResolvedColumn b_;
+  const ResolvedColumn c_;
+  const ResolvedColumn x_;
+  const ResolvedColumn u_;
+};
+
+TEST_F(LimitPushdownTest, MovesBelowProjectScan) {
+  // SELECT a, b, 1 AS x FROM T LIMIT 10 OFFSET 5
+  std::unique_ptr<const ResolvedNode> node =
+      Limit(10, Project(TableScan({a_, b_})), Int64(5));
+  ZETASQL_ASSERT_OK(PushDownLimits(&node));
+
+  auto expected = Project(Limit(10, TableScan({a_, b_}), Int64(5)));
+  EXPECT_EQ(expected->DebugString(), node->DebugString());
+}
+
+TEST_F(LimitPushdownTest, LimitsUnionAllInputs) {
+  // (SELECT a, b, 1 AS x FROM T) UNION ALL (SELECT a FROM T LIMIT 3)
+  // LIMIT 10 OFFSET 5
+  std::unique_ptr<const ResolvedNode> node =
+      Limit(10,
+            UnionAll(Project(TableScan({a_, b_})), Limit(3, TableScan({c_}))),
+            Int64(5));
+  ZETASQL_ASSERT_OK(PushDownLimits(&node));
+
+  // The first input reads 15 rows, and moves the limit below its projection.
+  // The second already reads fewer.
+  auto expected =
+      Limit(10,
+            UnionAll(Project(Limit(15, TableScan({a_, b_}))),
+                     Limit(3, TableScan({c_}))),
+            Int64(5));
+  EXPECT_EQ(expected->DebugString(), node->DebugString());
+
+  const std::string pushed = node->DebugString();
+  ZETASQL_ASSERT_OK(PushDownLimits(&node));
+  EXPECT_EQ(pushed, node->DebugString());
+}
+
+TEST_F(LimitPushdownTest, KeepsNonLiteralLimits) {
+  std::unique_ptr<const ResolvedNode> node = MakeResolvedLimitOffsetScan(
+      {a_, b_, x_}, Project(TableScan({a_, b_})),
+      MakeResolvedParameter(types::Int64Type(), "n", /*position=*/0,
+                            /*is_untyped=*/false),
+      /*offset=*/nullptr);
+  const std::string original = node->DebugString();
+  ZETASQL_ASSERT_OK(PushDownLimits(&node));
+  EXPECT_EQ(original, node->DebugString());
+}
+
+TEST_F(LimitPushdownTest, FindsTopNOrderByScans) {
+  // SELECT a, b, 1 AS x FROM T ORDER BY b DESC LIMIT 10 OFFSET 2
+  std::unique_ptr<const ResolvedNode> node =
+      Limit(10, Project(OrderBy(b_, /*is_descending=*/true,
+                                TableScan({a_, b_}))),
+            Int64(2));
+  const auto* order_by = node->GetAs<ResolvedLimitOffsetScan>()
+                             ->input_scan()
+                             ->GetAs<ResolvedProjectScan>()
+                             ->input_scan()
+                             ->GetAs<ResolvedOrderByScan>();
+  OrderByScanLimits limits;
+  ZETASQL_ASSERT_OK(FindTopNOrderByScans(node.get(), &limits));
+  ASSERT_EQ(1, limits.size());
+  EXPECT_EQ(12, limits.at(order_by));
+
+  TableScanPushdowns pushdowns;
+  ZETASQL_ASSERT_OK(FindTableScanPushdowns(node.get(), &pushdowns));
+  ASSERT_EQ(1, pushdowns.size());
+  const ScanPushdown& pushdown = pushdowns.begin()->second;
+  EXPECT_EQ(order_by->input_scan(), pushdowns.begin()->first);
+  EXPECT_EQ(12, pushdown.limit.value());
+  ASSERT_EQ(1, pushdown.order_by.size());
+  EXPECT_EQ(1, pushdown.order_by[0].column);
+  EXPECT_TRUE(pushdown.order_by[0].descending);
+  EXPECT_FALSE(pushdown.required_columns.has_value());
+}
+
+TEST_F(LimitPushdownTest, FindsUnionAllTableScanPushdowns) {
+  // (SELECT a FROM T) UNION ALL (SELECT a FROM T LIMIT 3) LIMIT 10
+  std::unique_ptr<const ResolvedNode> node =
+      Limit(10, UnionAll(TableScan({a_}), Limit(3, TableScan({c_}))));
+  const auto* set_operation = node->GetAs<ResolvedLimitOffsetScan>()
+                                  ->input_scan()
+                                  ->GetAs<ResolvedSetOperationScan>();
+  const ResolvedScan* left = set_operation->input_item_list(0)->scan();
+  const ResolvedScan* right = set_operation->input_item_list(1)
+                                  ->scan()
+                                  ->GetAs<ResolvedLimitOffsetScan>()
+                                  ->input_scan();
+
+  TableScanPushdowns pushdowns;
+  ZETASQL_ASSERT_OK(FindTableScanPushdowns(node.get(), &pushdowns));
+  ASSERT_EQ(2, pushdowns.size());
+  EXPECT_EQ(10, pushdowns.at(left->GetAs<ResolvedTableScan>()).limit.value());
+  EXPECT_EQ(3, pushdowns.at(right->GetAs<ResolvedTableScan>()).limit.value());
+  EXPECT_TRUE(
+      pushdowns.at(left->GetAs<ResolvedTableScan>()).order_by.empty());
+}
+
+TEST_F(LimitPushdownTest, FiltersAndComputedSortKeysStopLimits) {
+  TableScanPushdowns pushdowns;
+
+  // SELECT a, b FROM T WHERE TRUE LIMIT 10
+  std::unique_ptr<const ResolvedNode> filtered = Limit(
+      10, MakeResolvedFilterScan({a_, b_}, TableScan({a_, b_}),
+                                 MakeResolvedLiteral(Value::Bool(true))));
+  ZETASQL_ASSERT_OK(FindTableScanPushdowns(filtered.get(), &pushdowns));
+  EXPECT_TRUE(pushdowns.empty());
+
+  // SELECT a, b, 1 AS x FROM T ORDER BY x LIMIT 10
+  std::unique_ptr<const ResolvedNode> sorted = Limit(
+      10, OrderBy(x_, /*is_descending=*/false, Project(TableScan({a_, b_}))));
+  ZETASQL_ASSERT_OK(FindTableScanPushdowns(sorted.get(), &pushdowns));
+  EXPECT_TRUE(pushdowns.empty());
+  OrderByScanLimits limits;
+  ZETASQL_ASSERT_OK(FindTopNOrderByScans(sorted.get(), &limits));
+  EXPECT_EQ(1, limits.size());
+}
+
+}  // namespace zetasql
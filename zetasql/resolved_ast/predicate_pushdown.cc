@@ -0,0 +1,671 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/resolved_ast/predicate_pushdown.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include "zetasql/public/builtin_function.pb.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/function_signature.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/resolved_ast_deep_copy_visitor.h"
+#include "zetasql/resolved_ast/resolved_column.h"
+#include "zetasql/resolved_ast/resolved_node_kind.pb.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/memory/memory.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/status_macros.h"
+#include "zetasql/base/statusor.h"
+
+namespace zetasql {
+
+namespace {
+
+typedef std::unique_ptr<const ResolvedNode>* NodeSlot;
+typedef std::vector<std::unique_ptr<const ResolvedExpr>> ExprList;
+
+// Returns the slots of the children of <node>, which the caller owns.
+std::vector<NodeSlot> MutableChildren(const ResolvedNode* node) {
+  std::vector<NodeSlot> children;
+  const_cast<ResolvedNode*>(node)->AddMutableChildNodePointers(&children);
+  return children;
+}
+
+// Returns the slot of <child>, a child of <node>.
+zetasql_base::StatusOr<NodeSlot> ChildSlot(const ResolvedNode* node,
+                                   const ResolvedNode* child) {
+  for (NodeSlot slot : MutableChildren(node)) {
+    if (slot->get() == child) return slot;
+  }
+  ZETASQL_RET_CHECK_FAIL() << "Child not found in " << node->node_kind_string();
+}
+
+bool IsBuiltinCall(const ResolvedNode* node, FunctionSignatureId id) {
+  if (node->node_kind() != RESOLVED_FUNCTION_CALL) return false;
+  const auto* call = node->GetAs<ResolvedFunctionCall>();
+  return call->function()->IsZetaSQLBuiltin() &&
+         call->signature().context_id() == id;
+}
+
+// Adds the ids of the columns that <expr> references to <column_ids>, not
+// counting correlated references, and sets <*correlated> if there are any.
+// Returns false if <expr> cannot be moved.
+bool CollectColumns(const ResolvedNode* expr, absl::flat_hash_set<int>* column_ids,
+                    bool* correlated) {
+  switch (expr->node_kind()) {
+    case RESOLVED_SUBQUERY_EXPR:
+      return false;
+    case RESOLVED_FUNCTION_CALL:
+      if (expr->GetAs<ResolvedFunctionCall>()
+              ->function()
+              ->function_options()
+              .volatility == FunctionEnums::VOLATILE) {
+        return false;
+      }
+      break;
+    case RESOLVED_COLUMN_REF: {
+      const auto* ref = expr->GetAs<ResolvedColumnRef>();
+      if (ref->is_correlated()) {
+        *correlated = true;
+      } else {
+        column_ids->insert(ref->column().column_id());
+      }
+      return true;
+    }
+    default:
+      if (expr->IsScan()) return false;
+      break;
+  }
+  std::vector<const ResolvedNode*> children;
+  expr->GetChildNodes(&children);
+  for (const ResolvedNode* child : children) {
+    if (!CollectColumns(child, column_ids, correlated)) return false;
+  }
+  return true;
+}
+
+// Returns true if <scan> produces all of <column_ids>.
+bool ProducesAll(const ResolvedScan* scan,
+                 const absl::flat_hash_set<int>& column_ids) {
+  absl::flat_hash_set<int> produced;
+  for (const ResolvedColumn& column : scan->column_list()) {
+    produced.insert(column.column_id());
+  }
+  for (int id : column_ids) {
+    if (!produced.contains(id)) return false;
+  }
+  return true;
+}
+
+// Returns a copy of <expr> referencing <columns>[i] instead of
+// <from_columns>[i].
+zetasql_base::StatusOr<std::unique_ptr<const ResolvedExpr>> CopyWithColumns(
+    const ResolvedExpr* expr, const std::vector<ResolvedColumn>& from_columns,
+    const std::vector<ResolvedColumn>& columns) {
+  ZETASQL_RET_CHECK_EQ(from_columns.size(), columns.size());
+  absl::flat_hash_map<int, ResolvedColumn> column_map;
+  for (int i = 0; i < columns.size(); ++i) {
+    column_map[from_columns[i].column_id()] = columns[i];
+  }
+
+  ResolvedASTDeepCopyVisitor copier;
+  ZETASQL_RETURN_IF_ERROR(expr->Accept(&copier));
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ResolvedExpr> copy,
+                   copier.ConsumeRootNode<ResolvedExpr>());
+  std::unique_ptr<const ResolvedNode> root = std::move(copy);
+  std::vector<NodeSlot> pending = {&root};
+  while (!pending.empty()) {
+    NodeSlot slot = pending.back();
+    pending.pop_back();
+    if ((*slot)->node_kind() == RESOLVED_COLUMN_REF) {
+      const auto* ref = (*slot)->GetAs<ResolvedColumnRef>();
+      if (ref->is_correlated()) continue;
+      auto it = column_map.find(ref->column().column_id());
+      ZETASQL_RET_CHECK(it != column_map.end()) << ref->DebugString();
+      *slot = MakeResolvedColumnRef(ref->type(), it->second,
+                                    /*is_correlated=*/false);
+      continue;
+    }
+    const_cast<ResolvedNode*>(slot->get())->AddMutableChildNodePointers(
+        &pending);
+  }
+  return std::unique_ptr<const ResolvedExpr>(
+      root.release()->GetAs<ResolvedExpr>());
+}
+
+class PredicatePusher {
+ public:
+  PredicatePusher() {}
+  PredicatePusher(const PredicatePusher&) = delete;
+  PredicatePusher& operator=(const PredicatePusher&) = delete;
+
+  zetasql_base::Status Run(NodeSlot root) {
+    FindWithEntries(root->get());
+    std::vector<NodeSlot> pending = {root};
+    while (!pending.empty()) {
+      NodeSlot slot = pending.back();
+      pending.pop_back();
+      if ((*slot)->node_kind() == RESOLVED_FILTER_SCAN) {
+        ZETASQL_RETURN_IF_ERROR(PushDownFilter(slot));
+      }
+      const_cast<ResolvedNode*>(slot->get())->AddMutableChildNodePointers(
+          &pending);
+    }
+    return ::zetasql_base::OkStatus();
+  }
+
+ private:
+  struct WithEntryInfo {
+    const ResolvedWithEntry* entry = nullptr;
+    int num_definitions = 0;
+    int num_references = 0;
+  };
+
+  void FindWithEntries(const ResolvedNode* root) {
+    std::vector<const ResolvedNode*> stack = {root};
+    std::vector<const ResolvedNode*> children;
+    while (!stack.empty()) {
+      const ResolvedNode* node = stack.back();
+      stack.pop_back();
+      if (node->node_kind() == RESOLVED_WITH_ENTRY) {
+        const auto* entry = node->GetAs<ResolvedWithEntry>();
+        WithEntryInfo& info = with_entries_[entry->with_query_name()];
+        info.entry = entry;
+        ++info.num_definitions;
+      } else if (node->node_kind() == RESOLVED_WITH_REF_SCAN) {
+        ++with_entries_[node->GetAs<ResolvedWithRefScan>()->with_query_name()]
+              .num_references;
+      }
+      node->GetChildNodes(&children);
+      stack.insert(stack.end(), children.begin(), children.end());
+    }
+  }
+
+  // Moves the conjuncts of the ResolvedFilterScan in <slot> down, and
+  // removes it if none are left.
+  zetasql_base::Status PushDownFilter(NodeSlot slot) {
+    auto* filter =
+        const_cast<ResolvedFilterScan*>((*slot)->GetAs<ResolvedFilterScan>());
+    std::unique_ptr<const ResolvedExpr> and_call;
+    ExprList conjuncts;
+    std::unique_ptr<const ResolvedExpr> filter_expr =
+        filter->release_filter_expr();
+    if (IsBuiltinCall(filter_expr.get(), FN_AND)) {
+      const auto* call = filter_expr->GetAs<ResolvedFunctionCall>();
+      and_function_ = call->function();
+      AddConjuncts(std::move(filter_expr), &conjuncts);
+    } else {
+      conjuncts.push_back(std::move(filter_expr));
+    }
+
+    // The original positions, so that the conjuncts left keep their order.
+    absl::flat_hash_map<const ResolvedExpr*, int> positions;
+    ExprList movable;
+    ExprList kept;
+    for (int i = 0; i < conjuncts.size(); ++i) {
+      std::unique_ptr<const ResolvedExpr>& conjunct = conjuncts[i];
+      positions[conjunct.get()] = i;
+      absl::flat_hash_set<int> column_ids;
+      bool correlated = false;
+      if (CollectColumns(conjunct.get(), &column_ids, &correlated)) {
+        movable.push_back(std::move(conjunct));
+      } else {
+        kept.push_back(std::move(conjunct));
+      }
+    }
+
+    ZETASQL_ASSIGN_OR_RETURN(NodeSlot input, ChildSlot(filter, filter->input_scan()));
+    ZETASQL_ASSIGN_OR_RETURN(ExprList left, PushInto(input, std::move(movable)));
+    for (auto& conjunct : left) {
+      kept.push_back(std::move(conjunct));
+    }
+
+    if (kept.empty()) {
+      std::unique_ptr<const ResolvedScan> input_scan =
+          filter->release_input_scan();
+      if (input_scan->column_list() != filter->column_list()) {
+        input_scan = MakeResolvedProjectScan(filter->column_list(), {},
+                                             std::move(input_scan));
+      }
+      *slot = std::move(input_scan);
+      return ::zetasql_base::OkStatus();
+    }
+    std::sort(kept.begin(), kept.end(),
+              [&positions](const std::unique_ptr<const ResolvedExpr>& a,
+                           const std::unique_ptr<const ResolvedExpr>& b) {
+                return positions.at(a.get()) < positions.at(b.get());
+              });
+    ZETASQL_ASSIGN_OR_RETURN(filter_expr, MakeConjunction(std::move(kept)));
+    filter->set_filter_expr(std::move(filter_expr));
+    return ::zetasql_base::OkStatus();
+  }
+
+  // Adds the conjuncts of <expr>, which may be nested ANDs, to <conjuncts>.
+  static void AddConjuncts(std::unique_ptr<const ResolvedExpr> expr,
+                           ExprList* conjuncts) {
+    if (!IsBuiltinCall(expr.get(), FN_AND)) {
+      conjuncts->push_back(std::move(expr));
+      return;
+    }
+    for (auto& argument : const_cast<ResolvedFunctionCall*>(
+                              expr->GetAs<ResolvedFunctionCall>())
+                              ->release_argument_list()) {
+      AddConjuncts(std::move(argument), conjuncts);
+    }
+  }
+
+  zetasql_base::StatusOr<std::unique_ptr<const ResolvedExpr>> MakeConjunction(
+      ExprList conjuncts) {
+    ZETASQL_RET_CHECK(!conjuncts.empty());
+    if (conjuncts.size() == 1) return std::move(conjuncts[0]);
+    // Several conjuncts only end up together if they came from an AND.
+    ZETASQL_RET_CHECK(and_function_ != nullptr);
+    FunctionArgumentTypeList argument_types(conjuncts.size(),
+                                            FunctionArgumentType(
+                                                types::BoolType()));
+    return std::unique_ptr<const ResolvedExpr>(MakeResolvedFunctionCall(
+        types::BoolType(), and_function_,
+        FunctionSignature(types::BoolType(), argument_types, FN_AND),
+        std::move(conjuncts), ResolvedFunctionCall::DEFAULT_ERROR_MODE));
+  }
+
+  // Moves <conjuncts> into the scan in <slot>, and computes the ones that
+  // cannot move further in a new ResolvedFilterScan above it.
+  zetasql_base::Status PushIntoAndFilter(NodeSlot slot, ExprList conjuncts) {
+    ZETASQL_ASSIGN_OR_RETURN(ExprList left, PushInto(slot, std::move(conjuncts)));
+    if (left.empty()) return ::zetasql_base::OkStatus();
+    std::unique_ptr<const ResolvedScan> scan(
+        slot->release()->GetAs<ResolvedScan>());
+    const bool is_ordered = scan->is_ordered();
+    const std::vector<ResolvedColumn> columns = scan->column_list();
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<const ResolvedExpr> filter_expr,
+                     MakeConjunction(std::move(left)));
+    auto filter = MakeResolvedFilterScan(columns, std::move(scan),
+                                         std::move(filter_expr));
+    filter->set_is_ordered(is_ordered);
+    *slot = std::move(filter);
+    return ::zetasql_base::OkStatus();
+  }
+
+  // Moves <conjuncts> as far as possible into the scan in <slot>, and
+  // returns the ones that must be computed above it.
+  zetasql_base::StatusOr<ExprList> PushInto(NodeSlot slot, ExprList conjuncts) {
+    if (conjuncts.empty()) return conjuncts;
+    const ResolvedNode* scan = slot->get();
+    switch (scan->node_kind()) {
+      case RESOLVED_FILTER_SCAN: {
+        const auto* filter = scan->GetAs<ResolvedFilterScan>();
+        ZETASQL_ASSIGN_OR_RETURN(NodeSlot input,
+                         ChildSlot(filter, filter->input_scan()));
+        ZETASQL_RETURN_IF_ERROR(PushIntoAndFilter(input, std::move(conjuncts)));
+        return ExprList();
+      }
+      case RESOLVED_PROJECT_SCAN: {
+        const auto* project = scan->GetAs<ResolvedProjectScan>();
+        ZETASQL_ASSIGN_OR_RETURN(NodeSlot input,
+                         ChildSlot(project, project->input_scan()));
+        ExprList below;
+        ExprList left;
+        for (auto& conjunct : conjuncts) {
+          (Produces(project->input_scan(), conjunct.get()) ? below : left)
+              .push_back(std::move(conjunct));
+        }
+        ZETASQL_RETURN_IF_ERROR(PushIntoAndFilter(input, std::move(below)));
+        return left;
+      }
+      case RESOLVED_JOIN_SCAN: {
+        const auto* join = scan->GetAs<ResolvedJoinScan>();
+        const bool into_left = join->join_type() == ResolvedJoinScan::INNER ||
+                               join->join_type() == ResolvedJoinScan::LEFT;
+        const bool into_right = join->join_type() == ResolvedJoinScan::INNER ||
+                                join->join_type() == ResolvedJoinScan::RIGHT;
+        ExprList left_conjuncts;
+        ExprList right_conjuncts;
+        ExprList left;
+        for (auto& conjunct : conjuncts) {
+          if (into_left && Produces(join->left_scan(), conjunct.get())) {
+            left_conjuncts.push_back(std::move(conjunct));
+          } else if (into_right &&
+                     Produces(join->right_scan(), conjunct.get())) {
+            right_conjuncts.push_back(std::move(conjunct));
+          } else {
+            left.push_back(std::move(conjunct));
+          }
+        }
+        ZETASQL_ASSIGN_OR_RETURN(NodeSlot left_slot,
+                         ChildSlot(join, join->left_scan()));
+        ZETASQL_RETURN_IF_ERROR(
+            PushIntoAndFilter(left_slot, std::move(left_conjuncts)));
+        ZETASQL_ASSIGN_OR_RETURN(NodeSlot right_slot,
+                         ChildSlot(join, join->right_scan()));
+        ZETASQL_RETURN_IF_ERROR(
+            PushIntoAndFilter(right_slot, std::move(right_conjuncts)));
+        return left;
+      }
+      case RESOLVED_SET_OPERATION_SCAN: {
+        const auto* set_operation = scan->GetAs<ResolvedSetOperationScan>();
+        for (const auto& item : set_operation->input_item_list()) {
+          ExprList copies;
+          for (const auto& conjunct : conjuncts) {
+            ZETASQL_ASSIGN_OR_RETURN(
+                std::unique_ptr<const ResolvedExpr> copy,
+                CopyWithColumns(conjunct.get(), set_operation->column_list(),
+                                item->output_column_list()));
+            copies.push_back(std::move(copy));
+          }
+          ZETASQL_ASSIGN_OR_RETURN(NodeSlot item_slot,
+                           ChildSlot(item.get(), item->scan()));
+          ZETASQL_RETURN_IF_ERROR(PushIntoAndFilter(item_slot, std::move(copies)));
+        }
+        return ExprList();
+      }
+      case RESOLVED_WITH_REF_SCAN: {
+        const auto* ref = scan->GetAs<ResolvedWithRefScan>();
+        auto it = with_entries_.find(ref->with_query_name());
+        if (it == with_entries_.end() || it->second.num_definitions != 1 ||
+            it->second.num_references != 1) {
+          return conjuncts;
+        }
+        const ResolvedWithEntry* entry = it->second.entry;
+        ExprList copies;
+        ExprList left;
+        for (auto& conjunct : conjuncts) {
+          // WITH subqueries cannot see the columns of outer queries.
+          absl::flat_hash_set<int> column_ids;
+          bool correlated = false;
+          CollectColumns(conjunct.get(), &column_ids, &correlated);
+          if (correlated) {
+            left.push_back(std::move(conjunct));
+            continue;
+          }
+          ZETASQL_ASSIGN_OR_RETURN(
+              std::unique_ptr<const ResolvedExpr> copy,
+              CopyWithColumns(conjunct.get(), ref->column_list(),
+                              entry->with_subquery()->column_list()));
+          copies.push_back(std::move(copy));
+        }
+        ZETASQL_ASSIGN_OR_RETURN(NodeSlot subquery,
+                         ChildSlot(entry, entry->with_subquery()));
+        ZETASQL_RETURN_IF_ERROR(PushIntoAndFilter(subquery, std::move(copies)));
+        return left;
+      }
+      default:
+        return conjuncts;
+    }
+  }
+
+  // Returns true if <scan> produces all the columns <conjunct> references.
+  static bool Produces(const ResolvedScan* scan,
+                       const ResolvedExpr* conjunct) {
+    absl::flat_hash_set<int> column_ids;
+    bool correlated = false;
+    return CollectColumns(conjunct, &column_ids, &correlated) &&
+           ProducesAll(scan, column_ids);
+  }
+
+  absl::flat_hash_map<std::string, WithEntryInfo> with_entries_;
+
+  // The $and function of the last filter split into conjuncts.
+  const Function* and_function_ = nullptr;
+};
+
+// Returns true if <value> never compares equal to anything.
+bool IsNullOrNaN(const Value& value) {
+  if (value.is_null()) return true;
+  switch (value.type_kind()) {
+    case TYPE_FLOAT:
+      return std::isnan(value.float_value());
+    case TYPE_DOUBLE:
+      return std::isnan(value.double_value());
+    default:
+      return false;
+  }
+}
+
+bool SqlLess(const Value& a, const Value& b) {
+  const Value less = a.SqlLessThan(b);
+  return !less.is_null() && less.bool_value();
+}
+
+// Returns a filter that drops all rows.
+ColumnFilter NoRows() { return ColumnFilter(std::vector<Value>()); }
+
+// Adds the filters implied by <conjunct> on the columns in <column_indexes>,
+// by column id, to <filters>.
+void AddColumnFilters(const ResolvedExpr* conjunct,
+                      const absl::flat_hash_map<int, int>& column_indexes,
+                      std::vector<std::pair<int, ColumnFilter>>* filters) {
+  if (conjunct->node_kind() != RESOLVED_FUNCTION_CALL) return;
+  const auto* call = conjunct->GetAs<ResolvedFunctionCall>();
+  if (!call->function()->IsZetaSQLBuiltin()) return;
+
+  auto column_index = [&column_indexes](const ResolvedExpr* expr) {
+    if (expr->node_kind() != RESOLVED_COLUMN_REF) return -1;
+    const auto* ref = expr->GetAs<ResolvedColumnRef>();
+    if (ref->is_correlated()) return -1;
+    auto it = column_indexes.find(ref->column().column_id());
+    return it == column_indexes.end() ? -1 : it->second;
+  };
+  auto literal = [](const ResolvedExpr* expr) -> const Value* {
+    if (expr->node_kind() != RESOLVED_LITERAL) return nullptr;
+    return &expr->GetAs<ResolvedLiteral>()->value();
+  };
+
+  const auto& arguments = call->argument_list();
+  switch (call->signature().context_id()) {
+    case FN_AND:
+      for (const auto& argument : arguments) {
+        AddColumnFilters(argument.get(), column_indexes, filters);
+      }
+      return;
+    case FN_EQUAL:
+    case FN_LESS:
+    case FN_LESS_OR_EQUAL:
+    case FN_GREATER:
+    case FN_GREATER_OR_EQUAL: {
+      if (arguments.size() != 2) return;
+      FunctionSignatureId id =
+          static_cast<FunctionSignatureId>(call->signature().context_id());
+      int column = column_index(arguments[0].get());
+      const Value* value = literal(arguments[1].get());
+      if (column < 0 || value == nullptr) {
+        // <literal> op <column> is <column> reversed-op <literal>.
+        column = column_index(arguments[1].get());
+        value = literal(arguments[0].get());
+        if (column < 0 || value == nullptr) return;
+        switch (id) {
+          case FN_LESS:
+            id = FN_GREATER;
+            break;
+          case FN_LESS_OR_EQUAL:
+            id = FN_GREATER_OR_EQUAL;
+            break;
+          case FN_GREATER:
+            id = FN_LESS;
+            break;
+          case FN_GREATER_OR_EQUAL:
+            id = FN_LESS_OR_EQUAL;
+            break;
+          default:
+            break;
+        }
+      }
+      if (IsNullOrNaN(*value)) {
+        filters->emplace_back(column, NoRows());
+      } else if (id == FN_EQUAL) {
+        filters->emplace_back(column, ColumnFilter(std::vector<Value>{*value}));
+      } else if (id == FN_LESS || id == FN_LESS_OR_EQUAL) {
+        filters->emplace_back(column, ColumnFilter(Value(), *value));
+      } else {
+        filters->emplace_back(column, ColumnFilter(*value, Value()));
+      }
+      return;
+    }
+    case FN_BETWEEN: {
+      if (arguments.size() != 3) return;
+      const int column = column_index(arguments[0].get());
+      const Value* lower = literal(arguments[1].get());
+      const Value* upper = literal(arguments[2].get());
+      if (column < 0 || lower == nullptr || upper == nullptr) return;
+      if (IsNullOrNaN(*lower) || IsNullOrNaN(*upper) ||
+          SqlLess(*upper, *lower)) {
+        filters->emplace_back(column, NoRows());
+      } else {
+        filters->emplace_back(column, ColumnFilter(*lower, *upper));
+      }
+      return;
+    }
+    case FN_IN: {
+      if (arguments.empty()) return;
+      const int column = column_index(arguments[0].get());
+      if (column < 0) return;
+      std::vector<Value> in_list;
+      for (int i = 1; i < arguments.size(); ++i) {
+        const Value* value = literal(arguments[i].get());
+        if (value == nullptr) return;
+        if (!IsNullOrNaN(*value)) in_list.push_back(*value);
+      }
+      filters->emplace_back(column, ColumnFilter(in_list));
+      return;
+    }
+    default:
+      return;
+  }
+}
+
+// Returns true if <value> passes <filter>.
+bool Passes(const Value& value, const ColumnFilter& filter) {
+  switch (filter.kind()) {
+    case ColumnFilter::kRange:
+      return (!filter.lower_bound().is_valid() ||
+              !SqlLess(value, filter.lower_bound())) &&
+             (!filter.upper_bound().is_valid() ||
+              !SqlLess(filter.upper_bound(), value));
+    case ColumnFilter::kInList:
+      for (const Value& element : filter.in_list()) {
+        const Value equal = value.SqlEquals(element);
+        if (!equal.is_null() && equal.bool_value()) return true;
+      }
+      return false;
+    case ColumnFilter::kBloomFilter:
+      return filter.bloom_filter().MayContain(value);
+    default:
+      return true;
+  }
+}
+
+// Returns a filter passing the values that pass both <a> and <b>.
+ColumnFilter Intersect(const ColumnFilter& a, const ColumnFilter& b) {
+  // A Bloom filter only approximates its values, so the other filter is
+  // used instead.
+  if (a.kind() == ColumnFilter::kBloomFilter) return b;
+  if (b.kind() == ColumnFilter::kBloomFilter) return a;
+  if (a.kind() == ColumnFilter::kInList || b.kind() == ColumnFilter::kInList) {
+    const ColumnFilter& in_list = a.kind() == ColumnFilter::kInList ? a : b;
+    const ColumnFilter& other = a.kind() == ColumnFilter::kInList ? b : a;
+    std::vector<Value> values;
+    for (const Value& value : in_list.in_list()) {
+      if (Passes(value, other)) values.push_back(value);
+    }
+    return ColumnFilter(values);
+  }
+  Value lower = a.lower_bound();
+  if (!lower.is_valid() ||
+      (b.lower_bound().is_valid() && SqlLess(lower, b.lower_bound()))) {
+    lower = b.lower_bound();
+  }
+  Value upper = a.upper_bound();
+  if (!upper.is_valid() ||
+      (b.upper_bound().is_valid() && SqlLess(b.upper_bound(), upper))) {
+    upper = b.upper_bound();
+  }
+  if (lower.is_valid() && upper.is_valid() && SqlLess(upper, lower)) {
+    return NoRows();
+  }
+  return ColumnFilter(lower, upper);
+}
+
+}  // namespace
+
+zetasql_base::Status PushDownPredicates(std::unique_ptr<const ResolvedNode>* root) {
+  ZETASQL_RET_CHECK(root != nullptr && *root != nullptr);
+  PredicatePusher pusher;
+  return pusher.Run(root);
+}
+
+zetasql_base::Status FindTableScanColumnFilters(const ResolvedNode* node,
+                                        TableScanColumnFilters* filters) {
+  ZETASQL_RET_CHECK(node != nullptr);
+  filters->clear();
+
+  absl::flat_hash_set<const ResolvedNode*> visited_filters;
+  std::vector<const ResolvedNode*> stack = {node};
+  std::vector<const ResolvedNode*> children;
+  while (!stack.empty()) {
+    const ResolvedNode* current = stack.back();
+    stack.pop_back();
+    if (current->node_kind() == RESOLVED_FILTER_SCAN &&
+        !visited_filters.contains(current)) {
+      // Collect the filters down to the first other scan.
+      std::vector<const ResolvedExpr*> conjuncts;
+      const ResolvedScan* scan = current->GetAs<ResolvedScan>();
+      while (scan->node_kind() == RESOLVED_FILTER_SCAN) {
+        visited_filters.insert(scan);
+        const auto* filter = scan->GetAs<ResolvedFilterScan>();
+        conjuncts.push_back(filter->filter_expr());
+        scan = filter->input_scan();
+      }
+      if (scan->node_kind() == RESOLVED_TABLE_SCAN) {
+        absl::flat_hash_map<int, int> column_indexes;
+        for (int i = 0; i < scan->column_list_size(); ++i) {
+          column_indexes[scan->column_list(i).column_id()] = i;
+        }
+        std::vector<std::pair<int, ColumnFilter>> scan_filters;
+        for (const ResolvedExpr* conjunct : conjuncts) {
+          AddColumnFilters(conjunct, column_indexes, &scan_filters);
+        }
+        if (!scan_filters.empty()) {
+          (*filters)[scan->GetAs<ResolvedTableScan>()] =
+              std::move(scan_filters);
+        }
+      }
+    }
+    current->GetChildNodes(&children);
+    stack.insert(stack.end(), children.begin(), children.end());
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> MakeColumnFilterMap(
+    const std::vector<std::pair<int, ColumnFilter>>& filters) {
+  absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map;
+  for (const auto& filter : filters) {
+    std::unique_ptr<ColumnFilter>& combined = filter_map[filter.first];
+    if (combined == nullptr) {
+      combined = absl::make_unique<ColumnFilter>(filter.second);
+    } else {
+      combined =
+          absl::make_unique<ColumnFilter>(Intersect(*combined, filter.second));
+    }
+  }
+  return filter_map;
+}
+
+}  // namespace zetasql
@@ -0,0 +1,75 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_RESOLVED_AST_PREDICATE_PUSHDOWN_H_
+#define ZETASQL_RESOLVED_AST_PREDICATE_PUSHDOWN_H_
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "absl/container/flat_hash_map.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+
+// Moves the conjuncts of each ResolvedFilterScan in the tree at <*root> as
+// close to the scans producing their columns as possible, so that rows are
+// dropped early and the filters directly above a ResolvedTableScan can be
+// passed to its EvaluatorTableIterator.  The tree is modified in place.
+//
+// A conjunct moves down through
+//   - a ResolvedFilterScan,
+//   - a ResolvedProjectScan, if it does not reference the computed columns,
+//   - a ResolvedJoinScan, into the side that produces all of its columns;
+//     for outer joins only into the side whose rows are preserved,
+//   - a ResolvedSetOperationScan, into every input, and
+//   - a ResolvedWithRefScan, into the WITH subquery, if that is the only
+//     reference to it,
+// and stops at any other scan, where a new ResolvedFilterScan computes it.
+// A ResolvedFilterScan left without conjuncts is removed.
+//
+// Only conjuncts that call no VOLATILE functions and contain no subqueries
+// are moved.  Like any reordering of the conjuncts of a WHERE clause, this
+// may evaluate a conjunct for rows that another one would have dropped.
+zetasql_base::Status PushDownPredicates(std::unique_ptr<const ResolvedNode>* root);
+
+// For each ResolvedTableScan directly below one or more ResolvedFilterScans,
+// the conjuncts of their filters that compare a column of the scan with
+// literals, as ColumnFilters for ScanPushdown::filters.  Column numbers are
+// indexes in the scan's column_list.
+typedef absl::flat_hash_map<const ResolvedTableScan*,
+                            std::vector<std::pair<int, ColumnFilter>>>
+    TableScanColumnFilters;
+
+// Finds the column filters of every ResolvedTableScan in the tree at <node>.
+// Conjuncts using =, <, <=, >, >=, BETWEEN and IN with literals are
+// converted; other conjuncts are ignored, and the filters do not drop any
+// row that the conjuncts accept.
+zetasql_base::Status FindTableScanColumnFilters(const ResolvedNode* node,
+                                        TableScanColumnFilters* filters);
+
+// Combines <filters> into one filter per column, as taken by
+// EvaluatorTableIterator::SetColumnFilterMap(), by intersecting the filters
+// of each column.
+absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> MakeColumnFilterMap(
+    const std::vector<std::pair<int, ColumnFilter>>& filters);
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_RESOLVED_AST_PREDICATE_PUSHDOWN_H_
@@ -0,0 +1,296 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/resolved_ast/predicate_pushdown.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/builtin_function.pb.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/make_node_vector.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "zetasql/resolved_ast/resolved_column.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+
+namespace zetasql {
+
+class PredicatePushdownTest : public ::testing::Test {
+ protected:
+  PredicatePushdownTest()
+      : table_("T", {{"a", types::Int64Type()}, {"b", types::Int64Type()}}),
+        a_(1, "T", "a", types::Int64Type()),
+        b_(2, "T", "b", types::Int64Type()),
+        c_(3, "U", "c", types::Int64Type()),
+        d_(4, "U", "d", types::Int64Type()) {}
+
+  // Returns a call to builtin function <name> with signature <id>,
+  // returning BOOL.
+  template <typename T>
+  std::unique_ptr<const ResolvedExpr> Call(
+      const std::string& name, FunctionSignatureId id,
+      std::vector<std::unique_ptr<T>> argument_nodes,
+      const FunctionOptions& options = FunctionOptions()) {
+    functions_.push_back(absl::make_unique<Function>(
+        name, Function::kZetaSQLFunctionGroupName, Function::SCALAR,
+        options));
+    std::vector<std::unique_ptr<const ResolvedExpr>> arguments;
+    FunctionArgumentTypeList argument_types;
+    for (auto& argument : argument_nodes) {
+      argument_types.emplace_back(argument->type());
+      arguments.push_back(std::move(argument));
+    }
+    return MakeResolvedFunctionCall(
+        types::BoolType(), functions_.back().get(),
+        FunctionSignature(types::BoolType(), argument_types, id),
+        std::move(arguments), ResolvedFunctionCall::DEFAULT_ERROR_MODE);
+  }
+
+  template <typename T>
+  std::unique_ptr<const ResolvedExpr> And(
+      std::vector<std::unique_ptr<T>> arguments) {
+    return Call("$and", FN_AND, std::move(arguments));
+  }
+
+  // <column> > <value>
+  std::unique_ptr<const ResolvedExpr> Greater(const ResolvedColumn& column,
+                                              int64_t value) {
+    return Call("$greater", FN_GREATER,
+                MakeNodeVector(ColumnRef(column), Int64(value)));
+  }
+
+  // <column1> = <column2>
+  std::unique_ptr<const ResolvedExpr> Equal(const ResolvedColumn& column1,
+                                            const ResolvedColumn& column2) {
+    return Call("$equal", FN_EQUAL,
+                MakeNodeVector(ColumnRef(column1), ColumnRef(column2)));
+  }
+
+  static std::unique_ptr<const ResolvedExpr> ColumnRef(
+      const ResolvedColumn& column) {
+    return MakeResolvedColumnRef(column.type(), column,
+                                 /*is_correlated=*/false);
+  }
+
+  static std::unique_ptr<const ResolvedExpr> Int64(int64_t value) {
+    return MakeResolvedLiteral(Value::Int64(value));
+  }
+
+  std::unique_ptr<const ResolvedScan> TableScan(
+      const std::vector<ResolvedColumn>& columns) {
+    return MakeResolvedTableScan(columns, &table_,
+                                 /*for_system_time_expr=*/nullptr);
+  }
+
+  static std::unique_ptr<const ResolvedNode> PushDown(
+      std::unique_ptr<const ResolvedNode> node) {
+    ZETASQL_EXPECT_OK(PushDownPredicates(&node));
+    return node;
+  }
+
+  SimpleTable table_;
+  const ResolvedColumn a_;
+  const ResolvedColumn b_;
+  const ResolvedColumn c_;
+  const ResolvedColumn d_;
+  std::vector<std::unique_ptr<const Function>> functions_;
+};
+
+TEST_F(PredicatePushdownTest, PushesThroughProjectScan) {
+  // SELECT * FROM (SELECT a, a + 1 AS x FROM T) WHERE a > 5 AND x > 6
+  const ResolvedColumn x(10, "$query", "x", types::Int64Type());
+  auto project = MakeResolvedProjectScan(
+      {a_, x},
+      MakeNodeVector(MakeResolvedComputedColumn(
+          x, Call("$add", FN_ADD_INT64, MakeNodeVector(ColumnRef(a_),
+                                                       Int64(1))))),
+      TableScan({a_, b_}));
+  auto node = PushDown(MakeResolvedFilterScan(
+      {a_, x}, std::move(project),
+      And(MakeNodeVector(Greater(a_, 5), Greater(x, 6)))));
+
+  // x > 6 stays above the project scan, a > 5 moves below it.
+  ASSERT_EQ(RESOLVED_FILTER_SCAN, node->node_kind());
+  const auto* top = node->GetAs<ResolvedFilterScan>();
+  EXPECT_EQ(Greater(x, 6)->DebugString(), top->filter_expr()->DebugString());
+  const auto* project_scan = top->input_scan()->GetAs<ResolvedProjectScan>();
+  ASSERT_EQ(RESOLVED_FILTER_SCAN, project_scan->input_scan()->node_kind());
+  const auto* pushed =
+      project_scan->input_scan()->GetAs<ResolvedFilterScan>();
+  EXPECT_EQ(Greater(a_, 5)->DebugString(),
+            pushed->filter_expr()->DebugString());
+  EXPECT_EQ(std::vector<ResolvedColumn>({a_, b_}), pushed->column_list());
+  EXPECT_EQ(RESOLVED_TABLE_SCAN, pushed->input_scan()->node_kind());
+}
+
+TEST_F(PredicatePushdownTest, PushesIntoJoinSides) {
+  // SELECT * FROM T JOIN U WHERE a > 1 AND c > 2 AND b > 3 AND a = c
+  auto join = MakeResolvedJoinScan({a_, b_, c_, d_}, ResolvedJoinScan::INNER,
+                                   TableScan({a_, b_}), TableScan({c_, d_}),
+                                   /*join_expr=*/nullptr);
+  auto node = PushDown(MakeResolvedFilterScan(
+      {a_, b_, c_, d_}, std::move(join),
+      And(MakeNodeVector(Greater(a_, 1), Greater(c_, 2), Greater(b_, 3),
+                         Equal(a_, c_)))));
+
+  ASSERT_EQ(RESOLVED_FILTER_SCAN, node->node_kind());
+  const auto* top = node->GetAs<ResolvedFilterScan>();
+  EXPECT_EQ(Equal(a_, c_)->DebugString(), top->filter_expr()->DebugString());
+  const auto* join_scan = top->input_scan()->GetAs<ResolvedJoinScan>();
+  ASSERT_EQ(RESOLVED_FILTER_SCAN, join_scan->left_scan()->node_kind());
+  EXPECT_EQ(And(MakeNodeVector(Greater(a_, 1), Greater(b_, 3)))->DebugString(),
+            join_scan->left_scan()
+                ->GetAs<ResolvedFilterScan>()
+                ->filter_expr()
+                ->DebugString());
+  ASSERT_EQ(RESOLVED_FILTER_SCAN, join_scan->right_scan()->node_kind());
+  EXPECT_EQ(Greater(c_, 2)->DebugString(), join_scan->right_scan()
+                                               ->GetAs<ResolvedFilterScan>()
+                                               ->filter_expr()
+                                               ->DebugString());
+}
+
+TEST_F(PredicatePushdownTest, KeepsNullExtendedSideOfOuterJoin) {
+  // SELECT * FROM T LEFT JOIN U ON a = c WHERE a > 1 AND c > 2
+  auto join = MakeResolvedJoinScan({a_, b_, c_, d_}, ResolvedJoinScan::LEFT,
+                                   TableScan({a_, b_}), TableScan({c_, d_}),
+                                   Equal(a_, c_));
+  auto node = PushDown(MakeResolvedFilterScan(
+      {a_, b_, c_, d_}, std::move(join),
+      And(MakeNodeVector(Greater(a_, 1), Greater(c_, 2)))));
+
+  ASSERT_EQ(RESOLVED_FILTER_SCAN, node->node_kind());
+  const auto* top = node->GetAs<ResolvedFilterScan>();
+  EXPECT_EQ(Greater(c_, 2)->DebugString(), top->filter_expr()->DebugString());
+  const auto* join_scan = top->input_scan()->GetAs<ResolvedJoinScan>();
+  EXPECT_EQ(RESOLVED_FILTER_SCAN, join_scan->left_scan()->node_kind());
+  EXPECT_EQ(RESOLVED_TABLE_SCAN, join_scan->right_scan()->node_kind());
+}
+
+TEST_F(PredicatePushdownTest, PushesIntoSetOperationInputs) {
+  // SELECT * FROM (SELECT a FROM T UNION ALL SELECT c FROM U) WHERE x > 1
+  const ResolvedColumn x(10, "$union_all", "x", types::Int64Type());
+  auto set_operation = MakeResolvedSetOperationScan(
+      {x}, ResolvedSetOperationScan::UNION_ALL,
+      MakeNodeVector(MakeResolvedSetOperationItem(TableScan({a_}), {a_}),
+                     MakeResolvedSetOperationItem(TableScan({c_}), {c_})));
+  auto node = PushDown(
+      MakeResolvedFilterScan({x}, std::move(set_operation), Greater(x, 1)));
+
+  // The filter scan is gone.
+  ASSERT_EQ(RESOLVED_SET_OPERATION_SCAN, node->node_kind());
+  const auto* scan = node->GetAs<ResolvedSetOperationScan>();
+  ASSERT_EQ(RESOLVED_FILTER_SCAN, scan->input_item_list(0)->scan()->node_kind());
+  EXPECT_EQ(Greater(a_, 1)->DebugString(), scan->input_item_list(0)
+                                               ->scan()
+                                               ->GetAs<ResolvedFilterScan>()
+                                               ->filter_expr()
+                                               ->DebugString());
+  ASSERT_EQ(RESOLVED_FILTER_SCAN, scan->input_item_list(1)->scan()->node_kind());
+  EXPECT_EQ(Greater(c_, 1)->DebugString(), scan->input_item_list(1)
+                                               ->scan()
+                                               ->GetAs<ResolvedFilterScan>()
+                                               ->filter_expr()
+                                               ->DebugString());
+}
+
+TEST_F(PredicatePushdownTest, PushesIntoWithSubquery) {
+  // WITH w AS (SELECT a FROM T) SELECT * FROM w WHERE x > 1
+  const ResolvedColumn x(10, "w", "a", types::Int64Type());
+  auto with_scan = MakeResolvedWithScan(
+      {x}, MakeNodeVector(MakeResolvedWithEntry("w", TableScan({a_}))),
+      MakeResolvedFilterScan({x}, MakeResolvedWithRefScan({x}, "w"),
+                             Greater(x, 1)));
+  auto node = PushDown(std::move(with_scan));
+
+  const auto* scan = node->GetAs<ResolvedWithScan>();
+  EXPECT_EQ(RESOLVED_WITH_REF_SCAN, scan->query()->node_kind());
+  const ResolvedScan* subquery = scan->with_entry_list(0)->with_subquery();
+  ASSERT_EQ(RESOLVED_FILTER_SCAN, subquery->node_kind());
+  EXPECT_EQ(Greater(a_, 1)->DebugString(),
+            subquery->GetAs<ResolvedFilterScan>()->filter_expr()->DebugString());
+}
+
+TEST_F(PredicatePushdownTest, KeepsVolatileConjuncts) {
+  // SELECT * FROM (SELECT a FROM T) WHERE RAND() > 0.5
+  FunctionOptions volatile_options;
+  volatile_options.set_volatility(FunctionEnums::VOLATILE);
+  auto rand = Call("rand", FN_RAND, std::vector<std::unique_ptr<ResolvedExpr>>(),
+                   volatile_options);
+  auto project = MakeResolvedProjectScan({a_}, {}, TableScan({a_}));
+  auto node = PushDown(
+      MakeResolvedFilterScan({a_}, std::move(project), std::move(rand)));
+  ASSERT_EQ(RESOLVED_FILTER_SCAN, node->node_kind());
+  EXPECT_EQ(RESOLVED_PROJECT_SCAN,
+            node->GetAs<ResolvedFilterScan>()->input_scan()->node_kind());
+}
+
+TEST_F(PredicatePushdownTest, FindTableScanColumnFilters) {
+  // SELECT b FROM T WHERE b > 5 AND 10 >= b AND a IN (1, NULL, 3)
+  auto filter = MakeResolvedFilterScan(
+      {a_, b_}, TableScan({a_, b_}),
+      And(MakeNodeVector(
+          Greater(b_, 5),
+          Call("$greater_or_equal", FN_GREATER_OR_EQUAL,
+               MakeNodeVector(Int64(10), ColumnRef(b_))),
+          Call("$in", FN_IN,
+               MakeNodeVector(ColumnRef(a_), Int64(1),
+                              MakeResolvedLiteral(Value::NullInt64()),
+                              Int64(3))))));
+  TableScanColumnFilters filters;
+  ZETASQL_ASSERT_OK(FindTableScanColumnFilters(filter.get(), &filters));
+  const auto* scan = filter->input_scan()->GetAs<ResolvedTableScan>();
+  ASSERT_EQ(1, filters.size());
+  const std::vector<std::pair<int, ColumnFilter>>& scan_filters = filters[scan];
+  ASSERT_EQ(3, scan_filters.size());
+
+  EXPECT_EQ(1, scan_filters[0].first);
+  EXPECT_EQ(ColumnFilter::kRange, scan_filters[0].second.kind());
+  EXPECT_EQ(Value::Int64(5), scan_filters[0].second.lower_bound());
+  EXPECT_FALSE(scan_filters[0].second.upper_bound().is_valid());
+
+  EXPECT_EQ(1, scan_filters[1].first);
+  EXPECT_FALSE(scan_filters[1].second.lower_bound().is_valid());
+  EXPECT_EQ(Value::Int64(10), scan_filters[1].second.upper_bound());
+
+  EXPECT_EQ(0, scan_filters[2].first);
+  EXPECT_EQ(ColumnFilter::kInList, scan_filters[2].second.kind());
+  EXPECT_EQ(std::vector<Value>({Value::Int64(1), Value::Int64(3)}),
+            scan_filters[2].second.in_list());
+
+  auto filter_map = MakeColumnFilterMap(scan_filters);
+  ASSERT_EQ(2, filter_map.size());
+  EXPECT_EQ(Value::Int64(5), filter_map[1]->lower_bound());
+  EXPECT_EQ(Value::Int64(10), filter_map[1]->upper_bound());
+  EXPECT_EQ(2, filter_map[0]->in_list().size());
+
+  // An IN list intersected with a range keeps the values in the range.
+  std::vector<std::pair<int, ColumnFilter>> range_and_in_list;
+  range_and_in_list.emplace_back(
+      0, ColumnFilter(std::vector<Value>{Value::Int64(1), Value::Int64(7)}));
+  range_and_in_list.emplace_back(0, ColumnFilter(Value::Int64(5), Value()));
+  filter_map = MakeColumnFilterMap(range_and_in_list);
+  EXPECT_EQ(std::vector<Value>({Value::Int64(7)}), filter_map[0]->in_list());
+}
+
+}  // namespace zetasql
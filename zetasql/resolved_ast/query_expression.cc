@@ -19,30 +19,28 @@
 #include "zetasql/base/logging.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
-#include "absl/strings/str_join.h"
+#include "absl/strings/string_view.h"
 #include "zetasql/base/map_util.h"
 
 namespace zetasql {
 
-// Joins entries present in <list> (with pairs as elements) separated by
-// <delimiter>. While appending each pair we add the second element (if present)
-// as an alias to the first element.
-static std::string JoinListWithAliases(
+// Appends entries present in <list> (with pairs as elements) separated by
+// <delimiter> to <*out>. While appending each pair we add the second element
+// (if present) as an alias to the first element.
+static void AppendListWithAliases(
     const std::vector<std::pair<std::string, std::string>>& list,
-    const std::string& delimiter) {
-  std::string list_str;
+    absl::string_view delimiter, std::string* out) {
   bool first = true;
   for (const auto& entry : list) {
-    if (!first) absl::StrAppend(&list_str, delimiter);
+    if (!first) absl::StrAppend(out, delimiter);
 
     if (entry.second.empty()) {
-      absl::StrAppend(&list_str, entry.first);
+      absl::StrAppend(out, entry.first);
     } else {
-      absl::StrAppend(&list_str, entry.first, " AS ", entry.second);
+      absl::StrAppend(out, entry.first, " AS ", entry.second);
     }
     first = false;
   }
-  return list_str;
 }
 
 void QueryExpression::ClearAllClauses() {
@@ -65,18 +63,25 @@ void QueryExpression::ClearAllClauses() {
 
 std::string QueryExpression::GetSQLQuery() const {
   std::string sql;
+  AppendSQLQuery(&sql);
+  return sql;
+}
+
+void QueryExpression::AppendSQLQuery(std::string* sql) const {
   if (!with_list_.empty()) {
-    absl::StrAppend(&sql, "WITH ", JoinListWithAliases(with_list_, ", "), " ");
+    absl::StrAppend(sql, "WITH ");
+    AppendListWithAliases(with_list_, ", ", sql);
+    absl::StrAppend(sql, " ");
   }
   if (!select_list_.empty()) {
     DCHECK(set_op_type_.empty() && set_op_modifier_.empty() &&
            set_op_scan_list_.empty());
-    absl::StrAppend(&sql, "SELECT ",
-                    query_hints_.empty() ? "" : absl::StrCat(query_hints_, " "),
-                    select_as_modifier_.empty()
-                        ? ""
-                        : absl::StrCat(select_as_modifier_, " "),
-                    JoinListWithAliases(select_list_, ", "));
+    absl::StrAppend(sql, "SELECT ");
+    if (!query_hints_.empty()) absl::StrAppend(sql, query_hints_, " ");
+    if (!select_as_modifier_.empty()) {
+      absl::StrAppend(sql, select_as_modifier_, " ");
+    }
+    AppendListWithAliases(select_list_, ", ", sql);
   }
 
   if (!set_op_scan_list_.empty()) {
@@ -87,67 +92,70 @@ std::string QueryExpression::GetSQLQuery() const {
     for (int i = 0; i < set_op_scan_list_.size(); ++i) {
       const auto& qe = set_op_scan_list_[i];
       if (i > 0) {
-        absl::StrAppend(&sql, " ", set_op_type_);
+        absl::StrAppend(sql, " ", set_op_type_);
         if (i == 1) {
-          absl::StrAppend(&sql, " ", query_hints_);
+          absl::StrAppend(sql, " ", query_hints_);
         }
-        absl::StrAppend(&sql, " ", set_op_modifier_);
+        absl::StrAppend(sql, " ", set_op_modifier_);
       }
-      absl::StrAppend(&sql, "(", qe->GetSQLQuery(), ")");
+      absl::StrAppend(sql, "(");
+      qe->AppendSQLQuery(sql);
+      absl::StrAppend(sql, ")");
     }
   }
 
   if (!from_.empty()) {
-    absl::StrAppend(&sql, " FROM ", from_);
+    absl::StrAppend(sql, " FROM ", from_);
   }
 
   if (!where_.empty()) {
-    absl::StrAppend(&sql, " WHERE ", where_);
+    absl::StrAppend(sql, " WHERE ", where_);
   }
 
   if (!group_by_list_.empty()) {
-    absl::StrAppend(
-        &sql, " GROUP ",
-        group_by_hints_.empty() ? "" : absl::StrCat(group_by_hints_, " "),
-        "BY ");
+    absl::StrAppend(sql, " GROUP ");
+    if (!group_by_hints_.empty()) absl::StrAppend(sql, group_by_hints_, " ");
+    absl::StrAppend(sql, "BY ");
     if (!rollup_column_id_list_.empty()) {
-      absl::StrAppend(
-          &sql, "ROLLUP(",
-          absl::StrJoin(rollup_column_id_list_, ", ",
-                        [this](std::string* out, int column_id) {
-                          absl::StrAppend(
-                              out, zetasql_base::FindOrDie(group_by_list_, column_id));
-                        }),
-          ")");
+      absl::StrAppend(sql, "ROLLUP(");
+      bool first = true;
+      for (int column_id : rollup_column_id_list_) {
+        if (!first) absl::StrAppend(sql, ", ");
+        absl::StrAppend(sql, zetasql_base::FindOrDie(group_by_list_, column_id));
+        first = false;
+      }
+      absl::StrAppend(sql, ")");
     } else {
       // We assume while iterating the group_by_list_, the entries will be
       // sorted by the column id.
-      absl::StrAppend(
-          &sql,
-          absl::StrJoin(group_by_list_, ", ",
-                        [](std::string* out,
-                           const std::pair<int, std::string>& column_id_and_string) {
-                          absl::StrAppend(out, column_id_and_string.second);
-                        }));
+      bool first = true;
+      for (const auto& column_id_and_string : group_by_list_) {
+        if (!first) absl::StrAppend(sql, ", ");
+        absl::StrAppend(sql, column_id_and_string.second);
+        first = false;
+      }
     }
   }
 
   if (!order_by_list_.empty()) {
-    absl::StrAppend(
-        &sql, " ORDER ",
-        order_by_hints_.empty() ? "" : absl::StrCat(order_by_hints_, " "),
-        "BY ", absl::StrJoin(order_by_list_, ", "));
+    absl::StrAppend(sql, " ORDER ");
+    if (!order_by_hints_.empty()) absl::StrAppend(sql, order_by_hints_, " ");
+    absl::StrAppend(sql, "BY ");
+    bool first = true;
+    for (const std::string& order_by : order_by_list_) {
+      if (!first) absl::StrAppend(sql, ", ");
+      absl::StrAppend(sql, order_by);
+      first = false;
+    }
   }
 
   if (!limit_.empty()) {
-    absl::StrAppend(&sql, " LIMIT ", limit_);
+    absl::StrAppend(sql, " LIMIT ", limit_);
   }
 
   if (!offset_.empty()) {
-    absl::StrAppend(&sql, " OFFSET ", offset_);
+    absl::StrAppend(sql, " OFFSET ", offset_);
   }
-
-  return sql;
 }
 
 bool QueryExpression::CanFormSQLQuery() const {
@@ -157,9 +165,11 @@ bool QueryExpression::CanFormSQLQuery() const {
 void QueryExpression::Wrap(const std::string& alias) {
   DCHECK(CanFormSQLQuery());
   DCHECK(!alias.empty());
-  const std::string sql = GetSQLQuery();
+  std::string from = "(";
+  AppendSQLQuery(&from);
+  absl::StrAppend(&from, ") AS ", alias);
   ClearAllClauses();
-  from_ = absl::StrCat("(", sql, ") AS ", alias);
+  from_ = std::move(from);
 }
 
 bool QueryExpression::TrySetWithClause(
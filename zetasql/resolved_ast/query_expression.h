@@ -40,6 +40,10 @@ class QueryExpression {
 
   std::string GetSQLQuery() const;
 
+  // Appends the SQL query to <*sql>.  Subqueries of set operations are
+  // appended to the same buffer, so the query text is written only once.
+  void AppendSQLQuery(std::string* sql) const;
+
   // Mutates the QueryExpression, wrapping its previous form as a subquery in
   // the from_ clause, with the given <alias>.
   void Wrap(const std::string& alias);
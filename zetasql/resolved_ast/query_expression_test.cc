@@ -0,0 +1,68 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/resolved_ast/query_expression.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+
+namespace zetasql {
+
+static std::unique_ptr<QueryExpression> MakeSelect(const std::string& column,
+                                                   const std::string& from) {
+  auto query = absl::make_unique<QueryExpression>();
+  EXPECT_TRUE(query->TrySetFromClause(from));
+  EXPECT_TRUE(query->TrySetSelectClause({{column, ""}}, /*select_hints=*/""));
+  return query;
+}
+
+TEST(QueryExpressionTest, AppendSQLQuery) {
+  std::vector<std::unique_ptr<QueryExpression>> set_op_scans;
+  set_op_scans.push_back(MakeSelect("a", "T1"));
+  set_op_scans.push_back(MakeSelect("b", "T2"));
+  QueryExpression query;
+  ASSERT_TRUE(query.TrySetSetOpScanList(&set_op_scans, "UNION", "ALL",
+                                        /*query_hints=*/""));
+  ASSERT_TRUE(query.TrySetLimitClause("10"));
+
+  const std::string expected =
+      "(SELECT a FROM T1) UNION  ALL(SELECT b FROM T2) LIMIT 10";
+  EXPECT_EQ(expected, query.GetSQLQuery());
+
+  // AppendSQLQuery() appends to what is already in the buffer.
+  std::string sql = "prefix ";
+  query.AppendSQLQuery(&sql);
+  EXPECT_EQ("prefix " + expected, sql);
+
+  query.Wrap("q");
+  EXPECT_EQ("(" + expected + ") AS q", query.FromClause());
+  std::map<int, std::string> group_by_list = {{2, "q.b"}, {1, "q.a"}};
+  ASSERT_TRUE(query.TrySetGroupByClause(group_by_list, /*group_by_hints=*/"",
+                                        /*rollup_column_id_list=*/{}));
+  ASSERT_TRUE(query.TrySetSelectClause({{"q.a", "x"}}, /*select_hints=*/""));
+  ASSERT_TRUE(query.TrySetOrderByClause({"1", "2 DESC"},
+                                        /*order_by_hints=*/""));
+  EXPECT_EQ("SELECT q.a AS x FROM (" + expected +
+                ") AS q GROUP BY q.a, q.b ORDER BY 1, 2 DESC",
+            query.GetSQLQuery());
+}
+
+}  // namespace zetasql
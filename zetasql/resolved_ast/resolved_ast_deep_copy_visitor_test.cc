@@ -473,4 +473,58 @@ TEST_F(ResolvedASTDeepCopyVisitorTest, TestCastFilterScan) {
   ASSERT_EQ(ast->DebugString(), desired_ast->DebugString());
 }
 
+TEST(ResolvedASTDeepCopyVisitorRewriteTest, RewriteSubtrees) {
+  SimpleTable table("T", std::vector<SimpleTable::NameAndType>());
+  //   FilterScan
+  //     JoinScan
+  //       TableScan
+  //       TableScan
+  std::unique_ptr<const ResolvedNode> root = MakeResolvedFilterScan(
+      {} /* column_list */,
+      MakeResolvedJoinScan({} /* column_list */, ResolvedJoinScan::INNER,
+                           MakeResolvedTableScan({}, &table, nullptr),
+                           MakeResolvedTableScan({}, &table, nullptr),
+                           nullptr /* join_condition */),
+      nullptr /* filter_expr */);
+  const ResolvedNode* original_root = root.get();
+  const ResolvedNode* original_join =
+      root->GetAs<ResolvedFilterScan>()->input_scan();
+
+  // Nothing selected: the tree is left alone.
+  ModifyJoinScan copier;
+  std::vector<std::string> visited;
+  ZETASQL_ASSERT_OK(copier.RewriteSubtrees(
+      [&visited](const ResolvedNode* node) {
+        visited.push_back(node->node_kind_string());
+        return false;
+      },
+      &root));
+  EXPECT_EQ(4, visited.size());
+  EXPECT_EQ(original_root, root.get());
+  EXPECT_EQ(original_join, root->GetAs<ResolvedFilterScan>()->input_scan());
+
+  // Only the join is copied and modified; its parent is kept.
+  visited.clear();
+  ZETASQL_ASSERT_OK(copier.RewriteSubtrees(
+      [&visited](const ResolvedNode* node) {
+        visited.push_back(node->node_kind_string());
+        return node->node_kind() == RESOLVED_JOIN_SCAN;
+      },
+      &root));
+  EXPECT_THAT(visited, testing::ElementsAre("FilterScan", "JoinScan"));
+  EXPECT_EQ(original_root, root.get());
+  const ResolvedScan* join = root->GetAs<ResolvedFilterScan>()->input_scan();
+  EXPECT_NE(original_join, join);
+  EXPECT_EQ(ResolvedJoinScan::LEFT, join->GetAs<ResolvedJoinScan>()->join_type());
+
+  // The root itself can be replaced.
+  ZETASQL_ASSERT_OK(copier.RewriteSubtrees(
+      [](const ResolvedNode* node) { return true; }, &root));
+  EXPECT_NE(original_root, root.get());
+  EXPECT_EQ(ResolvedJoinScan::RIGHT, root->GetAs<ResolvedFilterScan>()
+                                         ->input_scan()
+                                         ->GetAs<ResolvedJoinScan>()
+                                         ->join_type());
+}
+
 }  // namespace zetasql
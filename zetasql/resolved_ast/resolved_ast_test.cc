@@ -21,22 +21,27 @@
 #include <utility>
 
 #include "zetasql/base/logging.h"
+#include "zetasql/base/arena.h"
 #include "zetasql/base/testing/status_matchers.h"
 #include "zetasql/public/analyzer.h"
 #include "zetasql/public/catalog.h"
 #include "zetasql/public/function.h"
 #include "zetasql/public/id_string.h"
+#include "zetasql/public/language_options.h"
 #include "zetasql/public/simple_catalog.h"
 #include "zetasql/public/type.h"
 #include "zetasql/public/type.pb.h"
 #include "zetasql/public/value.h"
 #include "zetasql/public/value.pb.h"
 #include "zetasql/resolved_ast/make_node_vector.h"
+#include "zetasql/resolved_ast/resolved_ast_static_visitor.h"
+#include "zetasql/resolved_ast/resolved_ast_visitor.h"
 #include "zetasql/resolved_ast/resolved_node_kind.h"
 #include "zetasql/resolved_ast/serialization.pb.h"
 #include "zetasql/resolved_ast/validator.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
 #include "zetasql/base/status.h"
 
 namespace zetasql {
@@ -481,6 +486,52 @@ TEST(ResolvedAST, Validator) {
           HasSubstr("ResolvedExpr does not have a Type:\nLiteral(value=4)")));
 }
 
+TEST(ResolvedAST, ValidatorParallelWithEntries) {
+  const int kNumEntries = 8;
+  std::vector<ResolvedColumn> entry_columns;
+  std::vector<std::unique_ptr<const ResolvedWithEntry>> with_entries;
+  std::vector<ResolvedProjectScan*> entry_scans;
+  for (int i = 0; i < kNumEntries; ++i) {
+    entry_columns.emplace_back(100 + i, "$with", "c", types::Int64Type());
+    auto scan = MakeResolvedProjectScan(
+        {entry_columns.back()},
+        MakeNodeVector(MakeResolvedComputedColumn(entry_columns.back(),
+                                                  MakeIntLiteral(i))),
+        MakeResolvedSingleRowScan());
+    entry_scans.push_back(scan.get());
+    with_entries.push_back(
+        MakeResolvedWithEntry(absl::StrCat("w", i), std::move(scan)));
+  }
+  const ResolvedColumn query_column(1, "w0", "c", types::Int64Type());
+  auto stmt = MakeResolvedQueryStmt(
+      MakeNodeVector(MakeResolvedOutputColumn("c", query_column)),
+      false /* is_value_table */,
+      MakeResolvedWithScan({query_column}, std::move(with_entries),
+                           MakeResolvedWithRefScan({query_column}, "w0")));
+
+  Validator sequential_validator;
+  Validator parallel_validator(LanguageOptions(), /*num_threads=*/4);
+  ZETASQL_EXPECT_OK(sequential_validator.ValidateResolvedStatement(stmt.get()));
+  ZETASQL_EXPECT_OK(parallel_validator.ValidateResolvedStatement(stmt.get()));
+
+  // The first invalid entry in the WITH clause is reported.
+  entry_scans[6]->set_column_list({entry_columns[0]});
+  entry_scans[3]->set_column_list({entry_columns[0]});
+  const auto expected_error =
+      StatusIs(zetasql_base::INTERNAL,
+               HasSubstr("Column list contains column $with.c#100 not "
+                         "visible in scan node\nProjectScan"));
+  EXPECT_THAT(sequential_validator.ValidateResolvedStatement(stmt.get()),
+              expected_error);
+  for (int i = 0; i < 10; ++i) {
+    const zetasql_base::Status status =
+        parallel_validator.ValidateResolvedStatement(stmt.get());
+    EXPECT_THAT(status, expected_error);
+    EXPECT_EQ(sequential_validator.ValidateResolvedStatement(stmt.get()),
+              status);
+  }
+}
+
 TEST(ResolvedAST, GetChildNodes) {
   // One child.
   {
@@ -537,6 +588,63 @@ TEST(ResolvedAST, GetChildNodes) {
   }
 }
 
+// Records the nodes visited, in order, and counts table scans.
+class ScanRecordingVisitor : public ResolvedASTVisitor {
+ public:
+  zetasql_base::Status DefaultVisit(const ResolvedNode* node) override {
+    visited_.push_back(node);
+    return ResolvedASTVisitor::DefaultVisit(node);
+  }
+  zetasql_base::Status VisitResolvedTableScan(const ResolvedTableScan* node) override {
+    ++num_table_scans_;
+    return DefaultVisit(node);
+  }
+
+  std::vector<const ResolvedNode*> visited_;
+  int num_table_scans_ = 0;
+};
+
+class StaticScanRecordingVisitor
+    : public ResolvedASTStaticVisitor<StaticScanRecordingVisitor> {
+ public:
+  zetasql_base::Status DefaultVisit(const ResolvedNode* node) {
+    visited_.push_back(node);
+    return VisitChildren(node);
+  }
+  zetasql_base::Status VisitResolvedTableScan(const ResolvedTableScan* node) {
+    ++num_table_scans_;
+    return DefaultVisit(node);
+  }
+
+  std::vector<const ResolvedNode*> visited_;
+  int num_table_scans_ = 0;
+};
+
+TEST(ResolvedAST, StaticVisitor) {
+  auto join_scan = MakeResolvedJoinScan(
+      {} /* column_list */, ResolvedJoinScan::INNER,
+      MakeResolvedTableScan({}, t1, nullptr),
+      MakeResolvedFilterScan({}, MakeResolvedTableScan({}, t2, nullptr),
+                             MakeResolvedLiteral(Value::Bool(true))),
+      nullptr /* join_condition */);
+  auto union_all = MakeResolvedSetOperationScan(
+      {} /* column_list */, ResolvedSetOperationScan::UNION_ALL,
+      MakeNodeVector(
+          MakeResolvedSetOperationItem(std::move(join_scan)),
+          MakeResolvedSetOperationItem(MakeResolvedTableScan({}, t1, nullptr))));
+
+  ScanRecordingVisitor visitor;
+  ZETASQL_ASSERT_OK(union_all->Accept(&visitor));
+  StaticScanRecordingVisitor static_visitor;
+  ZETASQL_ASSERT_OK(static_visitor.Visit(union_all.get()));
+  EXPECT_EQ(3, static_visitor.num_table_scans_);
+  EXPECT_EQ(visitor.num_table_scans_, static_visitor.num_table_scans_);
+  EXPECT_EQ(9, static_visitor.visited_.size());
+  EXPECT_THAT(static_visitor.visited_, ContainerEq(visitor.visited_));
+  // Visiting does not mark fields accessed.
+  EXPECT_FALSE(union_all->CheckFieldsAccessed().ok());
+}
+
 TEST(ResolvedAST, GetTreeDepth) {
   // Leaf node.
   {
@@ -616,6 +724,92 @@ TEST(ResolvedAST, GetTreeDepth) {
   }
 }
 
+TEST(ResolvedAST, TraverseNonRecursive) {
+  //   j1:Join
+  //     s1:TableScan
+  //     f1:Filter
+  //       s2:TableScan
+  auto s1 = MakeResolvedTableScan({}, t1, nullptr);
+  auto s2 = MakeResolvedTableScan({}, t2, nullptr);
+  auto f1 = MakeResolvedFilterScan({}, std::move(s2), nullptr /* filter_expr */);
+  auto j1 = MakeResolvedJoinScan({} /* column_list */, ResolvedJoinScan::INNER,
+                                 std::move(s1), std::move(f1),
+                                 nullptr /* join_condition */);
+
+  std::vector<std::string> events;
+  auto pre_visit = [&events](const ResolvedNode* node)
+      -> zetasql_base::StatusOr<bool> {
+    events.push_back("pre:" + node->node_kind_string());
+    return node->node_kind() != RESOLVED_FILTER_SCAN;
+  };
+  auto post_visit = [&events](const ResolvedNode* node) -> zetasql_base::Status {
+    events.push_back("post:" + node->node_kind_string());
+    return ::zetasql_base::OkStatus();
+  };
+  ZETASQL_ASSERT_OK(j1->TraverseNonRecursive(pre_visit, post_visit));
+  EXPECT_THAT(events, ElementsAre("pre:JoinScan", "pre:TableScan",
+                                  "post:TableScan", "pre:FilterScan",
+                                  "post:FilterScan", "post:JoinScan"));
+
+  // Errors stop the traversal.
+  events.clear();
+  EXPECT_THAT(
+      j1->TraverseNonRecursive(
+          [&events](const ResolvedNode* node) -> zetasql_base::StatusOr<bool> {
+            events.push_back(node->node_kind_string());
+            if (node->node_kind() == RESOLVED_TABLE_SCAN) {
+              return ::zetasql_base::InvalidArgumentError("stop");
+            }
+            return true;
+          },
+          nullptr),
+      StatusIs(zetasql_base::StatusCode::kInvalidArgument, HasSubstr("stop")));
+  EXPECT_THAT(events, ElementsAre("JoinScan", "TableScan"));
+}
+
+TEST(ResolvedAST, GetTreeDepthOfDeepTree) {
+  std::unique_ptr<const ResolvedScan> scan =
+      MakeResolvedTableScan({}, t1, nullptr);
+  const int kDepth = 10000;
+  for (int i = 1; i < kDepth; ++i) {
+    scan = MakeResolvedFilterScan({}, std::move(scan),
+                                  nullptr /* filter_expr */);
+  }
+  EXPECT_EQ(kDepth, scan->GetTreeDepth());
+}
+
+TEST(ResolvedAST, ArenaScope) {
+  zetasql_base::UnsafeArena arena(/*block_size=*/4096);
+  EXPECT_EQ(nullptr, ResolvedNode::current_arena());
+  std::unique_ptr<const ResolvedScan> scan;
+  {
+    ResolvedNode::ArenaScope arena_scope(&arena);
+    EXPECT_EQ(&arena, ResolvedNode::current_arena());
+    scan = MakeResolvedFilterScan({}, MakeResolvedTableScan({}, t1, nullptr),
+                                  nullptr /* filter_expr */);
+    EXPECT_LT(0, arena.status().bytes_allocated());
+
+    // A nested scope with no arena allocates on the heap.
+    const size_t bytes_allocated = arena.status().bytes_allocated();
+    {
+      ResolvedNode::ArenaScope heap_scope(nullptr);
+      EXPECT_EQ(nullptr, ResolvedNode::current_arena());
+      auto heap_scan = MakeResolvedTableScan({}, t2, nullptr);
+    }
+    EXPECT_EQ(bytes_allocated, arena.status().bytes_allocated());
+    EXPECT_EQ(&arena, ResolvedNode::current_arena());
+  }
+  EXPECT_EQ(nullptr, ResolvedNode::current_arena());
+  EXPECT_EQ(2, scan->GetTreeDepth());
+
+  // Arena-allocated and heap-allocated nodes can be mixed in one tree.
+  auto join = MakeResolvedJoinScan({} /* column_list */,
+                                   ResolvedJoinScan::INNER, std::move(scan),
+                                   MakeResolvedTableScan({}, t2, nullptr),
+                                   nullptr /* join_condition */);
+  EXPECT_EQ(3, join->GetTreeDepth());
+}
+
 TEST(ResolvedAST, GetDescendantsWithKinds) {
   // Build up a tree that looks like
   //   u1:SetOperation
@@ -17,7 +17,9 @@
 #include "zetasql/resolved_ast/resolved_column.h"
 
 #include <memory>
+#include <new>
 
+#include "zetasql/base/arena.h"
 #include "zetasql/resolved_ast/serialization.pb.h"
 #include "absl/strings/str_cat.h"
 #include "zetasql/base/status_macros.h"
@@ -34,13 +36,38 @@ ResolvedColumn::ResolvedColumn(int column_id, const std::string& table_name,
     : ResolvedColumn(column_id, IdString::MakeGlobal(table_name),
                      IdString::MakeGlobal(name), type) {}
 
+#ifdef ZETASQL_COMPACT_RESOLVED_COLUMN
+ResolvedColumn::ResolvedColumn(int column_id, IdString table_name,
+                               IdString name, const Type* type,
+                               IdStringPool* id_string_pool)
+    : column_id_(column_id) {
+  DCHECK_GT(column_id, 0) << "column_id should be positive";
+  DCHECK(!table_name.empty());
+  DCHECK(!name.empty());
+  DCHECK(type != nullptr);
+  void* buffer;
+  if (id_string_pool != nullptr) {
+    buffer = id_string_pool->mutable_arena()->AllocAligned(
+        sizeof(ResolvedColumnInfo), alignof(ResolvedColumnInfo));
+  } else {
+    // Like IdString::MakeGlobal, columns made without a pool are never freed.
+    static zetasql_base::SafeArena* global_arena =
+        new zetasql_base::SafeArena(/*block_size=*/16 * 1024);
+    buffer = global_arena->AllocAligned(sizeof(ResolvedColumnInfo),
+                                        alignof(ResolvedColumnInfo));
+  }
+  info_ = new (buffer) ResolvedColumnInfo{table_name, name, type};
+}
+#endif  // ZETASQL_COMPACT_RESOLVED_COLUMN
+
 std::string ResolvedColumn::DebugString() const {
-  return absl::StrCat(table_name_.ToStringView(), ".", name_.ToStringView(),
+  return absl::StrCat(table_name_id().ToStringView(), ".",
+                      name_id().ToStringView(),
                       "#", column_id_);
 }
 
 std::string ResolvedColumn::ShortDebugString() const {
-  return absl::StrCat(name_.ToStringView(), "#", column_id_);
+  return absl::StrCat(name_id().ToStringView(), "#", column_id_);
 }
 
 zetasql_base::Status ResolvedColumn::SaveTo(
@@ -48,11 +75,11 @@ zetasql_base::Status ResolvedColumn::SaveTo(
     ResolvedColumnProto* proto) const {
   // Consider serializing ResolvedColumn in a separate table, indexed by
   // column_id_, and then only serialize the column_id_ in the AST.
-  proto->set_table_name(std::string(table_name_.ToStringView()));
-  proto->set_name(std::string(name_.ToStringView()));
+  proto->set_table_name(std::string(table_name_id().ToStringView()));
+  proto->set_name(std::string(name_id().ToStringView()));
 
   proto->set_column_id(column_id_);
-  return type_->SerializeToProtoAndDistinctFileDescriptors(
+  return type()->SerializeToProtoAndDistinctFileDescriptors(
       proto->mutable_type(), file_descriptor_set_map);
 }
 
@@ -64,7 +91,8 @@ zetasql_base::StatusOr<ResolvedColumn> ResolvedColumn::RestoreFrom(
   const Type* type;
   ZETASQL_RETURN_IF_ERROR(params.type_factory->DeserializeFromProtoUsingExistingPools(
       proto.type(), params.pools, &type));
-  return ResolvedColumn(proto.column_id(), table_name, column_name, type);
+  return ResolvedColumn(proto.column_id(), table_name, column_name, type,
+                        params.string_pool);
 }
 
 std::string ResolvedColumnListToString(const ResolvedColumnList& columns) {
@@ -31,6 +31,16 @@
 
 namespace zetasql {
 
+#ifdef ZETASQL_COMPACT_RESOLVED_COLUMN
+// The names and type of a ResolvedColumn in compact mode, shared by all copies
+// of the column.  See ResolvedColumn.
+struct ResolvedColumnInfo {
+  IdString table_name;
+  IdString name;
+  const Type* type;
+};
+#endif  // ZETASQL_COMPACT_RESOLVED_COLUMN
+
 // A column produced by part of a query (e.g. a scan or subquery).
 //
 // This is used in the column_list of a resolved AST node to represent a
@@ -46,6 +56,13 @@ namespace zetasql {
 //
 // Joins and other combining nodes may propagate ResolvedColumns from their
 // inputs, with the same column_ids.
+//
+// When built with ZETASQL_COMPACT_RESOLVED_COLUMN defined (in all of the
+// program), a ResolvedColumn holds only its column_id and a pointer to a
+// ResolvedColumnInfo with its names and type, which halves the cost of
+// copying and storing column lists.  The ResolvedColumnInfo is allocated
+// when the column is constructed, in the IdStringPool passed to the
+// constructor if any, and is shared by all copies of the column.
 class ResolvedColumn {
  public:
   // Default constructor makes an uninitialized ResolvedColumn.
@@ -66,8 +83,22 @@ class ResolvedColumn {
   // zetasql code can't call it.
   ResolvedColumn(int column_id, const std::string& table_name,
                  const std::string& name, const Type* type);
+  // In compact mode, this allocates the column's ResolvedColumnInfo in a
+  // global arena that is never freed.  Prefer the constructor below there.
   ResolvedColumn(int column_id, IdString table_name,
                  IdString name, const Type* type)
+      : ResolvedColumn(column_id, table_name, name, type,
+                       /*id_string_pool=*/nullptr) {}
+  // Like the above, but in compact mode allocates the column's
+  // ResolvedColumnInfo in <id_string_pool>, usually the pool holding
+  // <table_name> and <name>.  <id_string_pool> must then outlive the column
+  // and its copies.  It is unused otherwise, and may be NULL.
+#ifdef ZETASQL_COMPACT_RESOLVED_COLUMN
+  ResolvedColumn(int column_id, IdString table_name, IdString name,
+                 const Type* type, IdStringPool* id_string_pool);
+#else
+  ResolvedColumn(int column_id, IdString table_name, IdString name,
+                 const Type* type, IdStringPool* /* id_string_pool */)
       : column_id_(column_id), table_name_(table_name),
         name_(name), type_(type) {
     DCHECK_GT(column_id, 0) << "column_id should be positive";
@@ -75,6 +106,7 @@ class ResolvedColumn {
     DCHECK(!name.empty());
     DCHECK(type != nullptr);
   }
+#endif  // ZETASQL_COMPACT_RESOLVED_COLUMN
 
   // Return true if this ResolvedColumn has been initialized.
   bool IsInitialized() const { return column_id_ > 0; }
@@ -82,9 +114,13 @@ class ResolvedColumn {
   // Reset this object so IsInitialized returns false.
   void Clear() {
     column_id_ = -1;
+#ifdef ZETASQL_COMPACT_RESOLVED_COLUMN
+    info_ = nullptr;
+#else
     table_name_.clear();
     name_.clear();
     type_ = nullptr;
+#endif
   }
 
   // Return "<table>.<column>#<column_id>".
@@ -106,12 +142,25 @@ class ResolvedColumn {
   // Get the table and column name.  The _id forms return an IdString so
   // do not have to copy a std::string.  The non-_id forms are slower and should
   // not be used in zetasql analysis code.
-  const std::string table_name() const { return table_name_.ToString(); }
-  const std::string name() const { return name_.ToString(); }
+  const std::string table_name() const { return table_name_id().ToString(); }
+  const std::string name() const { return name_id().ToString(); }
+#ifdef ZETASQL_COMPACT_RESOLVED_COLUMN
+  IdString table_name_id() const {
+    return info_ == nullptr ? IdString() : info_->table_name;
+  }
+  IdString name_id() const {
+    return info_ == nullptr ? IdString() : info_->name;
+  }
+
+  const Type* type() const {
+    return info_ == nullptr ? nullptr : info_->type;
+  }
+#else
   IdString table_name_id() const { return table_name_; }
   IdString name_id() const { return name_; }
 
   const Type* type() const { return type_; }
+#endif  // ZETASQL_COMPACT_RESOLVED_COLUMN
 
   // Equality is defined using column_id only.
   bool operator==(const ResolvedColumn& other) const {
@@ -133,6 +182,11 @@ class ResolvedColumn {
   // Always positive if valid.
   int column_id_ = -1;
 
+#ifdef ZETASQL_COMPACT_RESOLVED_COLUMN
+  // The names and type of this column, as below.  NULL if uninitialized.
+  // Not owned.
+  const ResolvedColumnInfo* info_ = nullptr;
+#else
   // Table name (or alias) this column comes from.
   // Not necessarily unique or meaningful - used only for DebugString to
   // make the resolved AST understandable when printed.
@@ -144,6 +198,7 @@ class ResolvedColumn {
 
   // The type of this column.  Not owned.
   const Type* type_ = nullptr;
+#endif  // ZETASQL_COMPACT_RESOLVED_COLUMN
 };
 
 // A vector of columns produced by an operation like a scan or subquery.
@@ -16,10 +16,12 @@
 
 #include "zetasql/resolved_ast/resolved_column.h"
 
+#include <cstdint>
 #include <set>
 #include <utility>
 
 #include "google/protobuf/descriptor.h"
+#include "zetasql/public/id_string.h"
 #include "zetasql/public/type.h"
 #include "zetasql/public/type.pb.h"
 #include "zetasql/resolved_ast/resolved_node.h"
@@ -64,6 +66,27 @@ TEST(ResolvedColumnTest, Test) {
   EXPECT_EQ(3, columns.size());
 }
 
+TEST(ResolvedColumnTest, ColumnsFromIdStringPool) {
+  TypeFactory type_factory;
+  IdStringPool id_string_pool;
+  const ResolvedColumn c1(1, id_string_pool.Make("T1"),
+                          id_string_pool.Make("C1"), type_factory.get_int32(),
+                          &id_string_pool);
+  const ResolvedColumn copy = c1;
+  EXPECT_EQ(c1, copy);
+  EXPECT_EQ("T1.C1#1", copy.DebugString());
+  EXPECT_EQ(c1.table_name_id(), copy.table_name_id());
+  EXPECT_EQ(c1.name_id(), copy.name_id());
+  EXPECT_EQ(type_factory.get_int32(), copy.type());
+
+  ResolvedColumn cleared = c1;
+  cleared.Clear();
+  EXPECT_FALSE(cleared.IsInitialized());
+  EXPECT_TRUE(cleared.name_id().empty());
+  EXPECT_EQ(nullptr, cleared.type());
+  EXPECT_EQ("C1#1", c1.ShortDebugString());
+}
+
 TEST(ResolvedColumnTest, SaveTo) {
   TypeFactory type_factory;
 
@@ -114,9 +137,15 @@ TEST(ResolvedColumnTest, ClassAndProtoSize) {
   EXPECT_EQ(16, sizeof(ResolvedNode))
       << "The size of ResolvedNode class has changed, please also update the "
       << "proto and serialization code if you added/removed fields in it.";
+#ifdef ZETASQL_COMPACT_RESOLVED_COLUMN
+  EXPECT_EQ(sizeof(int64_t) + sizeof(void*), sizeof(ResolvedColumn))
+      << "The size of ResolvedColumn class has changed, please also update the "
+      << "proto and serialization code if you added/removed fields in it.";
+#else
   EXPECT_EQ(2 * sizeof(IdString), sizeof(ResolvedColumn) - sizeof(ResolvedNode))
       << "The size of ResolvedColumn class has changed, please also update the "
       << "proto and serialization code if you added/removed fields in it.";
+#endif
   EXPECT_EQ(1, ResolvedNodeProto::descriptor()->field_count())
       << "The number of fields in ResolvedNodeProto has changed, please also "
       << "update the serialization code accordingly.";
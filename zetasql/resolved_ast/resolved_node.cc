@@ -16,6 +16,8 @@
 
 #include "zetasql/resolved_ast/resolved_node.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <queue>
 
 #include "zetasql/base/logging.h"
@@ -31,13 +33,43 @@
 #include "zetasql/resolved_ast/resolved_ast.h"
 #include "zetasql/resolved_ast/resolved_column.h"
 #include "zetasql/public/parse_location_range.pb.h"
-#include "absl/memory/memory.h"
+#include "absl/base/attributes.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "zetasql/base/map_util.h"
 
 namespace zetasql {
 
+namespace {
+
+// The arena of the innermost ResolvedNode::ArenaScope on this thread.
+ABSL_CONST_INIT thread_local zetasql_base::UnsafeArena* current_node_arena =
+    nullptr;
+
+// The number of ResolvedNodes constructed on this thread.
+ABSL_CONST_INIT thread_local int64_t num_nodes_created_on_thread = 0;
+
+}  // namespace
+
+ResolvedNode::ArenaScope::ArenaScope(zetasql_base::UnsafeArena* arena)
+    : previous_arena_(current_node_arena) {
+  current_node_arena = arena;
+}
+
+ResolvedNode::ArenaScope::~ArenaScope() {
+  current_node_arena = previous_arena_;
+}
+
+zetasql_base::UnsafeArena* ResolvedNode::current_arena() {
+  return current_node_arena;
+}
+
+int64_t ResolvedNode::num_nodes_created() {
+  return num_nodes_created_on_thread;
+}
+
+ResolvedNode::ResolvedNode() { ++num_nodes_created_on_thread; }
+
 // ResolvedNode::RestoreFrom is generated in resolved_node.cc.template.
 
 zetasql_base::Status ResolvedNode::Accept(ResolvedASTVisitor* visitor) const {
@@ -48,13 +80,25 @@ zetasql_base::Status ResolvedNode::ChildrenAccept(ResolvedASTVisitor* visitor) c
   return ::zetasql_base::OkStatus();
 }
 
+ResolvedNode::~ResolvedNode() { ClearParseLocationRange(); }
+
 void ResolvedNode::SetParseLocationRange(
     const ParseLocationRange& parse_location_range) {
-  parse_location_range_ =
-      absl::make_unique<ParseLocationRange>(parse_location_range);
+  ClearParseLocationRange();
+  parse_location_ = reinterpret_cast<uintptr_t>(
+      new ParseLocationRange(parse_location_range));
 }
 
-void ResolvedNode::ClearParseLocationRange() { parse_location_range_.reset(); }
+void ResolvedNode::SetParseLocationId(int id) {
+  DCHECK_GE(id, 0);
+  ClearParseLocationRange();
+  parse_location_ = (static_cast<uintptr_t>(id) << 1) | kParseLocationIdTag;
+}
+
+void ResolvedNode::ClearParseLocationRange() {
+  delete GetParseLocationRangeOrNULL();
+  parse_location_ = 0;
+}
 
 std::string ResolvedNode::DebugString() const {
   std::string output;
@@ -243,17 +287,66 @@ std::string ResolvedNode::GetNameForDebugStringWithNameFormat(
   }
 }
 
-const int ResolvedNode::GetTreeDepth() const {
-  int max_depth = 0;
-  std::vector<const ResolvedNode*> children;
-  GetChildNodes(&children);
-  for (const ResolvedNode* child : children) {
-    const int child_depth = child->GetTreeDepth();
-    if (child_depth > max_depth) {
-      max_depth = child_depth;
+zetasql_base::Status ResolvedNode::TraverseNonRecursive(
+    const std::function<zetasql_base::StatusOr<bool>(const ResolvedNode*)>&
+        pre_visit,
+    const std::function<zetasql_base::Status(const ResolvedNode*)>& post_visit)
+    const {
+  // Each entry is a node whose children are being visited, its children,
+  // and the index of the next child to visit.
+  struct StackEntry {
+    const ResolvedNode* node;
+    std::vector<const ResolvedNode*> children;
+    int next_child;
+  };
+  std::vector<StackEntry> stack;
+  auto enter = [&pre_visit, &post_visit,
+                &stack](const ResolvedNode* node) -> zetasql_base::Status {
+    bool visit_children = true;
+    if (pre_visit != nullptr) {
+      ZETASQL_ASSIGN_OR_RETURN(visit_children, pre_visit(node));
+    }
+    if (visit_children) {
+      stack.push_back({node, {}, 0});
+      node->GetChildNodes(&stack.back().children);
+    } else if (post_visit != nullptr) {
+      ZETASQL_RETURN_IF_ERROR(post_visit(node));
+    }
+    return ::zetasql_base::OkStatus();
+  };
+
+  ZETASQL_RETURN_IF_ERROR(enter(this));
+  while (!stack.empty()) {
+    StackEntry& top = stack.back();
+    if (top.next_child < top.children.size()) {
+      // <top> may be invalidated by enter().
+      const ResolvedNode* child = top.children[top.next_child++];
+      ZETASQL_RETURN_IF_ERROR(enter(child));
+    } else {
+      const ResolvedNode* node = top.node;
+      stack.pop_back();
+      if (post_visit != nullptr) {
+        ZETASQL_RETURN_IF_ERROR(post_visit(node));
+      }
     }
   }
-  return max_depth + 1;
+  return ::zetasql_base::OkStatus();
+}
+
+const int ResolvedNode::GetTreeDepth() const {
+  // Computed with a non-recursive traversal to avoid stack issues.
+  int depth = 0;
+  int max_depth = 0;
+  ZETASQL_CHECK_OK(TraverseNonRecursive(
+      [&depth, &max_depth](const ResolvedNode*) -> zetasql_base::StatusOr<bool> {
+        max_depth = std::max(max_depth, ++depth);
+        return true;
+      },
+      [&depth](const ResolvedNode*) -> zetasql_base::Status {
+        --depth;
+        return ::zetasql_base::OkStatus();
+      }));
+  return max_depth;
 }
 
 zetasql_base::Status ResolvedNode::SaveTo(FileDescriptorSetMap* file_descriptor_set_map,
@@ -17,6 +17,8 @@
 #ifndef ZETASQL_RESOLVED_AST_RESOLVED_NODE_H_
 #define ZETASQL_RESOLVED_AST_RESOLVED_NODE_H_
 
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <set>
 #include <string>
@@ -31,12 +33,15 @@
 #include "zetasql/resolved_ast/resolved_ast.pb.h"
 #include "zetasql/resolved_ast/resolved_node_kind.pb.h"
 #include "zetasql/resolved_ast/serialization.pb.h"
+#include "zetasql/base/arena.h"
+#include "zetasql/base/arena_allocator.h"
 #include "zetasql/base/status.h"
 #include "zetasql/base/statusor.h"
 
 namespace zetasql {
 
 class ResolvedASTVisitor;
+class ResolvedColumn;
 
 // This is the base class for the resolved AST.
 // Subclasses are in the generated file resolved_ast.h.
@@ -52,14 +57,42 @@ class ResolvedASTVisitor;
 // for organization only.
 //
 // Classes in this hierarchy always take ownership of their children.
-class ResolvedNode {
+//
+// Nodes are normally allocated on the heap.  While an ArenaScope is active,
+// the Make* functions in resolved_ast.h allocate nodes in its arena instead.
+// Arena-allocated nodes are still owned and deleted through unique_ptr as
+// usual, but deleting them does not free memory, and the arena must outlive
+// them.
+class ResolvedNode : public zetasql_base::Gladiator {
  public:
   using SUPER = void;  // Indicates that ResolvedNode has no parent.
 
-  ResolvedNode() {}
+  // While an ArenaScope is alive, nodes created on the current thread by the
+  // Make* functions in resolved_ast.h are allocated in <arena>.  Scopes may
+  // be nested; the innermost one is used.  A null <arena> allocates nodes on
+  // the heap.
+  class ArenaScope {
+   public:
+    explicit ArenaScope(zetasql_base::UnsafeArena* arena);
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+    ~ArenaScope();
+
+   private:
+    zetasql_base::UnsafeArena* const previous_arena_;
+  };
+
+  // Returns the arena of the innermost ArenaScope on the current thread, or
+  // NULL if there is none.
+  static zetasql_base::UnsafeArena* current_arena();
+
+  // Returns the number of nodes created on the current thread so far.
+  static int64_t num_nodes_created();
+
+  ResolvedNode();
   ResolvedNode(const ResolvedNode&) = delete;
   ResolvedNode& operator=(const ResolvedNode&) = delete;
-  virtual ~ResolvedNode() {}
+  virtual ~ResolvedNode();
 
   // Return this node's kind.
   // e.g. zetasql::RESOLVED_TABLE_SCAN for ResolvedTableScan.
@@ -188,6 +221,13 @@ class ResolvedNode {
       std::vector<std::unique_ptr<const ResolvedNode>*>*
           mutable_child_node_ptrs) {}
 
+  // Adds in 'columns' pointers to all ResolvedColumns stored in fields of this
+  // node, not including its children.  This includes both columns that the
+  // node references and columns that it defines, like the column_list of a
+  // ResolvedTableScan.  Fields are not marked as accessed.
+  virtual void AddColumnPointers(
+      std::vector<const ResolvedColumn*>* columns) const {}
+
   // Get all descendants of this node (inclusive) that have a type in
   // <node_kinds>.  Returns the matching nodes in <*found_nodes>.
   // Order of the output vector is not defined.
@@ -219,20 +259,52 @@ class ResolvedNode {
   // Records the parse location range.
   void SetParseLocationRange(const ParseLocationRange& parse_location_range);
 
-  // Clears the parse location range.
+  // Records the id of the parse location range in a ParseLocationTable,
+  // instead of the range itself.  <id> must be non-negative.
+  void SetParseLocationId(int id);
+
+  // Clears the parse location range or id.
   void ClearParseLocationRange();
 
   // Returns the previously recorded parsed location range, or NULL. Parse
   // location ranges are only filled for some nodes (ResolvedLiterals in
   // particular) and only if AnalyzerOption::record_parse_locations() is set.
+  // Returns NULL if the node has a parse location id instead.
   // DEPRECATED: Use GetParseLocationRangeOrNULL().
   const ParseLocationRange* GetParseLocationOrNULL() const {
-    return parse_location_range_.get();
+    return GetParseLocationRangeOrNULL();
   }
   const ParseLocationRange* GetParseLocationRangeOrNULL() const {
-    return parse_location_range_.get();
+    return (parse_location_ & kParseLocationIdTag) != 0
+               ? nullptr
+               : reinterpret_cast<const ParseLocationRange*>(parse_location_);
+  }
+
+  // Returns the id recorded by SetParseLocationId(), or -1.  With
+  // AnalyzerOptions::compact_parse_locations(), the range can be found with
+  // AnalyzerOutput::GetParseLocationRange().
+  int GetParseLocationId() const {
+    return (parse_location_ & kParseLocationIdTag) != 0
+               ? static_cast<int>(parse_location_ >> 1)
+               : -1;
   }
 
+  // Traverses this node and its descendants in depth-first order using an
+  // explicit stack instead of recursion, so arbitrarily deep trees can be
+  // traversed on small thread stacks.  Children are visited in the order
+  // returned by GetChildNodes().
+  //
+  // <pre_visit> is called on each node before its children, and returns
+  // whether to visit the children of that node.  <post_visit> is called
+  // after the children, for every node <pre_visit> was called on.  Either
+  // callback may be empty.  The traversal stops at the first error returned
+  // by a callback, and returns that error.
+  zetasql_base::Status TraverseNonRecursive(
+      const std::function<zetasql_base::StatusOr<bool>(const ResolvedNode*)>&
+          pre_visit,
+      const std::function<zetasql_base::Status(const ResolvedNode*)>& post_visit)
+      const;
+
   // Returns the depth of the Resolved AST tree rooted at the current node.
   // Considers all descendants of the current node, and returns the maximum
   // depth. Returns 1 if the current node is a leaf.
@@ -315,7 +387,13 @@ class ResolvedNode {
   friend class ResolvedMakeProtoField;
   friend class ResolvedOutputColumn;
 
-  std::unique_ptr<ParseLocationRange> parse_location_range_;  // May be NULL.
+  // Set in <parse_location_> if it holds a parse location id.
+  static constexpr uintptr_t kParseLocationIdTag = 1;
+
+  // Zero, an owned ParseLocationRange*, or a parse location id shifted left
+  // by one and tagged with kParseLocationIdTag, so that ids take no more
+  // space than pointers.
+  uintptr_t parse_location_ = 0;
 };
 
 }  // namespace zetasql
@@ -0,0 +1,116 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/resolved_ast/sample_pushdown.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/resolved_node_kind.pb.h"
+#include "zetasql/base/ret_check.h"
+
+namespace zetasql {
+
+namespace {
+
+// Returns the value of <expr> if it is a non-NULL literal, and null
+// otherwise.
+const Value* GetLiteral(const ResolvedExpr* expr) {
+  if (expr == nullptr || expr->node_kind() != RESOLVED_LITERAL) {
+    return nullptr;
+  }
+  const Value& value = expr->GetAs<ResolvedLiteral>()->value();
+  return value.is_null() ? nullptr : &value;
+}
+
+// Sets <*sample> to the TableSample of <scan>, and returns false if it
+// cannot be pushed down.
+bool GetTableSample(const ResolvedSampleScan* scan, TableSample* sample) {
+  if (scan->weight_column() != nullptr ||
+      !scan->partition_by_list().empty()) {
+    return false;
+  }
+  if (scan->method() == "bernoulli") {
+    sample->method = TableSample::kBernoulli;
+  } else if (scan->method() == "system") {
+    sample->method = TableSample::kSystem;
+  } else if (scan->method() == "reservoir") {
+    sample->method = TableSample::kReservoir;
+  } else {
+    return false;
+  }
+
+  const Value* size = GetLiteral(scan->size());
+  if (size == nullptr) return false;
+  if (scan->unit() == ResolvedSampleScan::PERCENT) {
+    if (sample->method == TableSample::kReservoir) return false;
+    double percent = 0;
+    if (size->type_kind() == TYPE_INT64) {
+      percent = size->int64_value();
+    } else if (size->type_kind() == TYPE_DOUBLE) {
+      percent = size->double_value();
+    } else {
+      return false;
+    }
+    // Also false for NaN.
+    if (!(percent >= 0 && percent <= 100)) return false;
+    sample->percent = percent;
+  } else {
+    if (sample->method != TableSample::kReservoir ||
+        size->type_kind() != TYPE_INT64 || size->int64_value() < 0) {
+      return false;
+    }
+    sample->rows = size->int64_value();
+  }
+
+  if (scan->repeatable_argument() != nullptr) {
+    const Value* seed = GetLiteral(scan->repeatable_argument());
+    if (seed == nullptr || seed->type_kind() != TYPE_INT64) return false;
+    sample->seed = seed->int64_value();
+  }
+  return true;
+}
+
+}  // namespace
+
+zetasql_base::Status FindTableScanSamples(const ResolvedNode* node,
+                                  TableScanSamples* samples) {
+  ZETASQL_RET_CHECK(node != nullptr);
+  ZETASQL_RET_CHECK(samples != nullptr);
+  samples->clear();
+  std::vector<const ResolvedNode*> stack = {node};
+  std::vector<const ResolvedNode*> children;
+  while (!stack.empty()) {
+    const ResolvedNode* current = stack.back();
+    stack.pop_back();
+    if (current->node_kind() == RESOLVED_SAMPLE_SCAN) {
+      const auto* sample_scan = current->GetAs<ResolvedSampleScan>();
+      TableSample sample;
+      if (sample_scan->input_scan()->node_kind() == RESOLVED_TABLE_SCAN &&
+          GetTableSample(sample_scan, &sample)) {
+        (*samples)[sample_scan->input_scan()->GetAs<ResolvedTableScan>()] =
+            sample;
+      }
+    }
+    current->GetChildNodes(&children);
+    stack.insert(stack.end(), children.begin(), children.end());
+  }
+  return ::zetasql_base::OkStatus();
+}
+
+}  // namespace zetasql
@@ -0,0 +1,45 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_RESOLVED_AST_SAMPLE_PUSHDOWN_H_
+#define ZETASQL_RESOLVED_AST_SAMPLE_PUSHDOWN_H_
+
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "absl/container/flat_hash_map.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+
+// For each ResolvedTableScan read directly by a ResolvedSampleScan, the
+// TableSample to pass to EvaluatorTableIterator::SetSample().
+typedef absl::flat_hash_map<const ResolvedTableScan*, TableSample>
+    TableScanSamples;
+
+// Finds the samples of the ResolvedTableScans in the tree at <node>.  Only
+// BERNOULLI and SYSTEM samples of a literal PERCENT and RESERVOIR samples of
+// a literal number of ROWS are found, with a REPEATABLE seed if it is an
+// INT64 literal, and without WITH WEIGHT or PARTITION BY.  Samples with
+// parameters must be found again after the parameters are bound.
+//
+// The ResolvedSampleScan must still be evaluated over the rows of an
+// iterator whose SetSample() did not set <*sampled>.
+zetasql_base::Status FindTableScanSamples(const ResolvedNode* node,
+                                  TableScanSamples* samples);
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_RESOLVED_AST_SAMPLE_PUSHDOWN_H_
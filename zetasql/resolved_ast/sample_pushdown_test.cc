@@ -0,0 +1,120 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/resolved_ast/sample_pushdown.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "zetasql/resolved_ast/resolved_column.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace zetasql {
+
+class SamplePushdownTest : public ::testing::Test {
+ protected:
+  SamplePushdownTest()
+      : table_("T", {{"a", types::Int64Type()}}),
+        a_(1, "T", "a", types::Int64Type()) {}
+
+  std::unique_ptr<const ResolvedScan> TableScan() {
+    return MakeResolvedTableScan({a_}, &table_,
+                                 /*for_system_time_expr=*/nullptr);
+  }
+
+  // <input> TABLESAMPLE <method> (<size> <unit>) REPEATABLE (<repeatable>)
+  static std::unique_ptr<const ResolvedScan> Sample(
+      std::unique_ptr<const ResolvedScan> input, const std::string& method,
+      Value size, ResolvedSampleScan::SampleUnit unit,
+      std::unique_ptr<const ResolvedExpr> repeatable = nullptr) {
+    const std::vector<ResolvedColumn> columns = input->column_list();
+    return MakeResolvedSampleScan(
+        columns, std::move(input), method, MakeResolvedLiteral(size), unit,
+        std::move(repeatable), /*weight_column=*/nullptr,
+        std::vector<std::unique_ptr<const ResolvedExpr>>());
+  }
+
+  SimpleTable table_;
+  const ResolvedColumn a_;
+};
+
+TEST_F(SamplePushdownTest, FindsTableScanSamples) {
+  // SELECT a FROM T TABLESAMPLE SYSTEM (1 PERCENT) REPEATABLE (17)
+  std::unique_ptr<const ResolvedNode> node =
+      Sample(TableScan(), "system", Value::Int64(1),
+             ResolvedSampleScan::PERCENT,
+             MakeResolvedLiteral(Value::Int64(17)));
+  const ResolvedScan* table_scan =
+      node->GetAs<ResolvedSampleScan>()->input_scan();
+  TableScanSamples samples;
+  ZETASQL_ASSERT_OK(FindTableScanSamples(node.get(), &samples));
+  ASSERT_EQ(1, samples.size());
+  const TableSample& sample =
+      samples.at(table_scan->GetAs<ResolvedTableScan>());
+  EXPECT_EQ(TableSample::kSystem, sample.method);
+  EXPECT_EQ(1, sample.percent);
+  EXPECT_EQ(17, sample.seed.value());
+
+  // SELECT a FROM T TABLESAMPLE RESERVOIR (100 ROWS)
+  node = Sample(TableScan(), "reservoir", Value::Int64(100),
+                ResolvedSampleScan::ROWS);
+  table_scan = node->GetAs<ResolvedSampleScan>()->input_scan();
+  ZETASQL_ASSERT_OK(FindTableScanSamples(node.get(), &samples));
+  ASSERT_EQ(1, samples.size());
+  const TableSample& reservoir =
+      samples.at(table_scan->GetAs<ResolvedTableScan>());
+  EXPECT_EQ(TableSample::kReservoir, reservoir.method);
+  EXPECT_EQ(100, reservoir.rows);
+  EXPECT_FALSE(reservoir.seed.has_value());
+}
+
+TEST_F(SamplePushdownTest, SkipsSamplesThatCannotBePushedDown) {
+  std::vector<std::unique_ptr<const ResolvedNode>> nodes;
+  // An unknown method.
+  nodes.push_back(Sample(TableScan(), "custom", Value::Int64(1),
+                         ResolvedSampleScan::PERCENT));
+  // Out of range, and NULL.
+  nodes.push_back(Sample(TableScan(), "bernoulli", Value::Double(101),
+                         ResolvedSampleScan::PERCENT));
+  nodes.push_back(Sample(TableScan(), "bernoulli", Value::NullDouble(),
+                         ResolvedSampleScan::PERCENT));
+  // A seed that is only known when the parameter is bound.
+  nodes.push_back(Sample(
+      TableScan(), "system", Value::Double(0.5), ResolvedSampleScan::PERCENT,
+      MakeResolvedParameter(types::Int64Type(), "seed", /*position=*/0,
+                            /*is_untyped=*/false)));
+  // Not directly above the table scan.
+  nodes.push_back(MakeResolvedLimitOffsetScan(
+      {a_},
+      Sample(MakeResolvedFilterScan({a_}, TableScan(),
+                                    MakeResolvedLiteral(Value::Bool(true))),
+             "system", Value::Int64(1), ResolvedSampleScan::PERCENT),
+      MakeResolvedLiteral(Value::Int64(10)), /*offset=*/nullptr));
+  for (const auto& node : nodes) {
+    TableScanSamples samples;
+    ZETASQL_ASSERT_OK(FindTableScanSamples(node.get(), &samples));
+    EXPECT_TRUE(samples.empty()) << node->DebugString();
+  }
+}
+
+}  // namespace zetasql
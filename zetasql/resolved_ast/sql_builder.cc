@@ -211,8 +211,8 @@ void SQLBuilder::PushQueryFragment(
 }
 
 void SQLBuilder::PushQueryFragment(const ResolvedNode* node,
-                                   const std::string& text) {
-  PushQueryFragment(absl::make_unique<QueryFragment>(node, text));
+                                   std::string text) {
+  PushQueryFragment(absl::make_unique<QueryFragment>(node, std::move(text)));
 }
 
 void SQLBuilder::PushQueryFragment(const ResolvedNode* node,
@@ -601,7 +601,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedWindowPartitioning(
   }
   absl::StrAppend(&sql, " BY ", absl::StrJoin(partition_by_list_sql, ", "));
 
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -621,7 +621,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedWindowOrdering(
   }
   absl::StrAppend(&sql, " BY ", absl::StrJoin(order_by_list_sql, ", "));
 
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -649,7 +649,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedWindowFrame(
                          : absl::StrCat(frame_unit_sql, " BETWEEN ",
                                         start_expr_sql, " AND ", end_expr_sql);
 
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -698,7 +698,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedWindowFrameExpr(
     }
   }
 
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -837,7 +837,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedGetProtoField(
     absl::StrAppend(&text, ")");
   }
 
-  PushQueryFragment(node, text);
+  PushQueryFragment(node, std::move(text));
   return ::zetasql_base::OkStatus();
 }
 
@@ -900,8 +900,9 @@ zetasql_base::Status SQLBuilder::VisitResolvedSubqueryExpr(
       result->query_expression.release());
   ZETASQL_RETURN_IF_ERROR(AddSelectListIfNeeded(node->subquery()->column_list(),
                                         subquery_result.get()));
-  absl::StrAppend(&text, "(", subquery_result->GetSQLQuery(), ")",
-                  node->in_expr() == nullptr ? "" : ")");
+  absl::StrAppend(&text, "(");
+  subquery_result->AppendSQLQuery(&text);
+  absl::StrAppend(&text, ")", node->in_expr() == nullptr ? "" : ")");
 
   // Dummy access on the parameter list so as to pass the final
   // CheckFieldsAccessed() on a statement level before building the sql.
@@ -1050,7 +1051,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedOption(const ResolvedOption* node)
     // std::string literals.
     absl::StrAppend(&text, "(", result->GetSQL(), ")");
   }
-  PushQueryFragment(node, text);
+  PushQueryFragment(node, std::move(text));
   return ::zetasql_base::OkStatus();
 }
 
@@ -1077,7 +1078,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedParameter(const ResolvedParameter*
       param_str =
           AddExplicitCast(param_str, node->type(), options_.product_mode);
     }
-    PushQueryFragment(node, param_str);
+    PushQueryFragment(node, std::move(param_str));
   }
   return ::zetasql_base::OkStatus();
 }
@@ -1097,7 +1098,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedMakeProto(const ResolvedMakeProto*
   }
   absl::StrAppend(&text, ")");
 
-  PushQueryFragment(node, text);
+  PushQueryFragment(node, std::move(text));
   return ::zetasql_base::OkStatus();
 }
 
@@ -1114,7 +1115,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedMakeProtoField(
   absl::StrAppend(&text, " AS ");
   AppendFieldOrParenthesizedExtensionName(node->field_descriptor(), &text);
 
-  PushQueryFragment(node, text);
+  PushQueryFragment(node, std::move(text));
   return ::zetasql_base::OkStatus();
 }
 
@@ -1137,7 +1138,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedMakeStruct(
     absl::StrAppend(&text, result->GetSQL());
   }
   absl::StrAppend(&text, ")");
-  PushQueryFragment(node, text);
+  PushQueryFragment(node, std::move(text));
   return ::zetasql_base::OkStatus();
 }
 
@@ -1156,7 +1157,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedGetStructField(
   const std::string& field_name =
       node->expr()->type()->AsStruct()->field(node->field_idx()).name;
   absl::StrAppend(&text, ToIdentifierLiteral(field_name));
-  PushQueryFragment(node, text);
+  PushQueryFragment(node, std::move(text));
   return ::zetasql_base::OkStatus();
 }
 
@@ -1892,7 +1893,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedOrderByItem(
   }
 
   absl::StrAppend(&text, node->is_descending() ? " DESC" : "");
-  PushQueryFragment(node, text);
+  PushQueryFragment(node, std::move(text));
   return ::zetasql_base::OkStatus();
 }
 
@@ -2019,9 +2020,11 @@ zetasql_base::Status SQLBuilder::VisitResolvedWithScan(const ResolvedWithScan* n
     ZETASQL_RETURN_IF_ERROR(
         AddSelectListIfNeeded(scan->column_list(), query_expression.get()));
 
-    with_list.push_back(std::make_pair(
-        ToIdentifierLiteral(name),
-        absl::StrCat("(", query_expression->GetSQLQuery(), ")")));
+    std::string with_query = "(";
+    query_expression->AppendSQLQuery(&with_query);
+    absl::StrAppend(&with_query, ")");
+    with_list.push_back(
+        std::make_pair(ToIdentifierLiteral(name), std::move(with_query)));
     SetPathForColumnList(scan->column_list(), ToIdentifierLiteral(name));
   }
   ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<QueryFragment> result,
@@ -2254,9 +2257,9 @@ zetasql_base::Status SQLBuilder::VisitResolvedQueryStmt(const ResolvedQueryStmt*
     ZETASQL_RET_CHECK_EQ(query_expression->SelectList().size(), 1);
     query_expression->SetSelectAsModifier("AS VALUE");
   }
-  absl::StrAppend(&sql, query_expression->GetSQLQuery());
+  query_expression->AppendSQLQuery(&sql);
 
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -2273,7 +2276,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedExplainStmt(
                    ProcessNode(node->statement()));
   absl::StrAppend(&sql, "EXPLAIN ", result->GetSQL());
 
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -2318,9 +2321,10 @@ zetasql_base::Status SQLBuilder::GetCreateViewStatement(
     ZETASQL_RET_CHECK_EQ(query_expression->SelectList().size(), 1);
     query_expression->SetSelectAsModifier("AS VALUE");
   }
-  absl::StrAppend(&sql, "AS ", query_expression->GetSQLQuery());
+  absl::StrAppend(&sql, "AS ");
+  query_expression->AppendSQLQuery(&sql);
 
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -2420,7 +2424,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedCreateDatabaseStmt(
                      GetHintListString(node->option_list()));
     absl::StrAppend(&sql, " OPTIONS(", options_string, ")");
   }
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -2579,7 +2583,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedCreateTableStmt(
   ZETASQL_ASSIGN_OR_RETURN(std::string sql,
                    ProcessCreateTableStmtBase(
                        node, /* process_column_definitions = */ true));
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -2622,9 +2626,10 @@ zetasql_base::Status SQLBuilder::VisitResolvedCreateTableAsSelectStmt(
     ZETASQL_RET_CHECK_EQ(query_expression->SelectList().size(), 1);
     query_expression->SetSelectAsModifier(" AS VALUE");
   }
-  absl::StrAppend(&sql, " AS ", query_expression->GetSQLQuery());
+  absl::StrAppend(&sql, " AS ");
+  query_expression->AppendSQLQuery(&sql);
 
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -2694,9 +2699,10 @@ zetasql_base::Status SQLBuilder::VisitResolvedCreateModelStmt(
   }
 
   // Append SELECT statement.
-  absl::StrAppend(&sql, " AS ", query_expression->GetSQLQuery());
+  absl::StrAppend(&sql, " AS ");
+  query_expression->AppendSQLQuery(&sql);
 
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -2785,7 +2791,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedCreateIndexStmt(
     absl::StrAppend(&sql, "OPTIONS(", options_string, ") ");
   }
 
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -2809,7 +2815,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedCreateExternalTableStmt(
                    GetHintListString(node->option_list()));
   absl::StrAppend(&sql, "OPTIONS(", options_string, ") ");
 
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -2848,7 +2854,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedCreateConstantStmt(
                    ProcessNode(node->expr()));
   absl::StrAppend(&sql, " = ", expr_fragment->GetSQL());
 
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -2897,7 +2903,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedCreateFunctionStmt(
     absl::StrAppend(&sql, " OPTIONS(", options_string, ") ");
   }
 
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -2930,7 +2936,8 @@ zetasql_base::Status SQLBuilder::VisitResolvedCreateTableFunctionStmt(
                      ProcessQuery(node->query(),
                                   node->output_column_list()));
     std::unique_ptr<QueryExpression> query_expression(query_result);
-    absl::StrAppend(&sql, " AS ", query_expression->GetSQLQuery());
+    absl::StrAppend(&sql, " AS ");
+    query_expression->AppendSQLQuery(&sql);
   } else if (!node->code().empty()) {
     if (is_external_language) {
       absl::StrAppend(&sql, " AS ", ToStringLiteral(node->code()));
@@ -2948,7 +2955,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedCreateTableFunctionStmt(
   // Dummy access on is_value_table field so as to pass the final
   // CheckFieldsAccessed() on a statement level before building the sql.
   node->is_value_table();
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -2969,7 +2976,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedCreateProcedureStmt(
 
   absl::StrAppend(&sql, "BEGIN\n", node->procedure_body(), "\nEND");
 
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -3021,9 +3028,10 @@ zetasql_base::Status SQLBuilder::VisitResolvedExportDataStmt(
     ZETASQL_RET_CHECK_EQ(query_expression->SelectList().size(), 1);
     query_expression->SetSelectAsModifier("AS VALUE");
   }
-  absl::StrAppend(&sql, "AS ", query_expression->GetSQLQuery());
+  absl::StrAppend(&sql, "AS ");
+  query_expression->AppendSQLQuery(&sql);
 
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -3041,7 +3049,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedCallStmt(const ResolvedCallStmt* n
     argument_list.push_back(result->GetSQL());
   }
   absl::StrAppend(&sql, "(", absl::StrJoin(argument_list, ", "), ")");
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -3057,7 +3065,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedDefineTableStmt(
   ZETASQL_ASSIGN_OR_RETURN(const std::string result, GetHintListString(node->option_list()));
   absl::StrAppend(&sql, "(", result, ")");
 
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -3070,7 +3078,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedDescribeStmt(
     absl::StrAppend(&sql, " FROM ",
                     IdentifierPathToString(node->from_name_path()));
   }
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -3087,7 +3095,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedShowStmt(
     ZETASQL_ASSIGN_OR_RETURN(const std::string result, GetSQL(value, options_.product_mode));
     absl::StrAppend(&sql, " LIKE ", result);
   }
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -3116,7 +3124,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedBeginStmt(
   if (!modes.empty()) {
     absl::StrAppend(&sql, " ", absl::StrJoin(modes, ", "));
   }
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -3144,7 +3152,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedSetTransactionStmt(
   if (!modes.empty()) {
     absl::StrAppend(&sql, " ", absl::StrJoin(modes, ", "));
   }
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -3166,7 +3174,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedStartBatchStmt(
   if (!node->batch_type().empty()) {
     absl::StrAppend(&sql, " ", node->batch_type());
   }
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -3191,7 +3199,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedAssertStmt(
   if (!node->description().empty()) {
     absl::StrAppend(&sql, " AS ", ToStringLiteral(node->description()));
   }
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -3257,7 +3265,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedDeleteStmt(
     absl::StrAppend(&sql, " ", assert_rows_modified->GetSQL());
   }
 
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -3267,7 +3275,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedDropStmt(
   absl::StrAppend(&sql, "DROP ", ToIdentifierLiteral(node->object_type()),
                   node->is_if_exists() ? " IF EXISTS " : " ",
                   IdentifierPathToString(node->name_path()));
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -3281,7 +3289,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedDropFunctionStmt(
     absl::StrAppend(&sql, node->signature()->signature().GetSQLDeclaration(
                               {} /* arg_name_list */, options_.product_mode));
   }
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -3291,7 +3299,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedDropMaterializedViewStmt(
   absl::StrAppend(&sql, "DROP MATERIALIZED VIEW",
                   node->is_if_exists() ? " IF EXISTS " : " ",
                   IdentifierPathToString(node->name_path()));
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -3308,7 +3316,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedDropRowPolicyStmt(
   }
   absl::StrAppend(&sql, " ON ",
                   IdentifierPathToString(node->target_name_path()));
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -3433,7 +3441,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedUpdateItem(
     absl::StrAppend(&sql, absl::StrJoin(nested_statements_sql, ", "));
 
     nested_dml_targets_.pop_back();
-    PushQueryFragment(node, sql);
+    PushQueryFragment(node, std::move(sql));
   }
 
   update_item_targets_and_offsets_.back().pop_back();
@@ -3524,7 +3532,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedUpdateStmt(
     absl::StrAppend(&sql, " ", assert_rows_modified->GetSQL());
   }
 
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -3620,7 +3628,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedInsertStmt(
     absl::StrAppend(&sql, " ", assert_rows_modified->GetSQL());
   }
 
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -3655,7 +3663,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedMergeStmt(const ResolvedMergeStmt*
                      ProcessNode(when_clause.get()));
     absl::StrAppend(&sql, " ", when_clause_sql->GetSQL());
   }
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -3705,7 +3713,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedMergeWhen(const ResolvedMergeWhen*
       absl::StrAppend(&sql, "DELETE");
       break;
   }
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -3718,7 +3726,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedAlterTableSetOptionsStmt(
   ZETASQL_ASSIGN_OR_RETURN(const std::string options_string,
                    GetHintListString(node->option_list()));
   absl::StrAppend(&sql, "SET OPTIONS(", options_string, ") ");
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -3730,7 +3738,7 @@ zetasql_base::Status SQLBuilder::GetResolvedAlterObjectStmtSQL(
   absl::StrAppend(
       &sql, object_kind, " ", node->is_if_exists() ? "IF EXISTS " : "",
       IdentifierPathToString(node->name_path()), " ", actions_string);
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -3840,7 +3848,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedAlterRowPolicyStmt(
     absl::StrAppend(&sql, " USING (", node->predicate_str(), ")");
   }
 
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -3858,7 +3866,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedPrivilege(const ResolvedPrivilege*
                     absl::StrJoin(node->unit_list(), ", ", formatter), ")");
   }
 
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -3889,7 +3897,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedAggregateHavingModifier(
   ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<QueryFragment> result,
                    ProcessNode(node->having_expr()));
   absl::StrAppend(&sql, result->GetSQL());
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -3907,7 +3915,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedGrantStmt(
   ZETASQL_RET_CHECK(!grantee_sql.empty());
   absl::StrAppend(&sql, grantee_sql);
 
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -3925,7 +3933,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedRevokeStmt(
   ZETASQL_RET_CHECK(!grantee_sql.empty());
   absl::StrAppend(&sql, grantee_sql);
 
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -3935,7 +3943,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedRenameStmt(
   absl::StrAppend(&sql, "RENAME ", ToIdentifierLiteral(node->object_type()),
                   " ", IdentifierPathToString(node->old_name_path()), " TO ",
                   IdentifierPathToString(node->new_name_path()));
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -3984,7 +3992,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedCreateRowPolicyStmt(
   // but we use the std::string form directly because it's simpler.
   absl::StrAppend(&sql, " USING (", node->predicate_str(), ")");
 
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -4027,7 +4035,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedImportStmt(
     absl::StrAppend(&sql, "OPTIONS(", result, ") ");
   }
 
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -4041,7 +4049,7 @@ zetasql_base::Status SQLBuilder::VisitResolvedModuleStmt(
     absl::StrAppend(&sql, "OPTIONS(", result, ") ");
   }
 
-  PushQueryFragment(node, sql);
+  PushQueryFragment(node, std::move(sql));
   return ::zetasql_base::OkStatus();
 }
 
@@ -327,7 +327,7 @@ class SQLBuilder : public ResolvedASTVisitor {
 
   // Helper functions which creates QueryFragment from the passed params and
   // push it on query_fragments_.
-  void PushQueryFragment(const ResolvedNode* node, const std::string& text);
+  void PushQueryFragment(const ResolvedNode* node, std::string text);
   void PushQueryFragment(const ResolvedNode* node,
                          QueryExpression* query_expression);
 
@@ -0,0 +1,674 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/resolved_ast/subquery_decorrelation.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/public/builtin_function.pb.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/function_signature.h"
+#include "zetasql/public/id_string.h"
+#include "zetasql/public/type.h"
+#include "zetasql/resolved_ast/make_node_vector.h"
+#include "zetasql/resolved_ast/resolved_column.h"
+#include "zetasql/resolved_ast/resolved_node_kind.pb.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/status_macros.h"
+#include "zetasql/base/statusor.h"
+
+namespace zetasql {
+
+namespace {
+
+typedef std::unique_ptr<const ResolvedNode>* NodeSlot;
+typedef std::vector<std::unique_ptr<const ResolvedExpr>> ExprList;
+
+// Returns the slots of the children of <node>, which the caller owns.
+std::vector<NodeSlot> MutableChildren(const ResolvedNode* node) {
+  std::vector<NodeSlot> children;
+  const_cast<ResolvedNode*>(node)->AddMutableChildNodePointers(&children);
+  return children;
+}
+
+// Returns the slot of <child>, a child of <node>.
+zetasql_base::StatusOr<NodeSlot> ChildSlot(const ResolvedNode* node,
+                                   const ResolvedNode* child) {
+  for (NodeSlot slot : MutableChildren(node)) {
+    if (slot->get() == child) return slot;
+  }
+  ZETASQL_RET_CHECK_FAIL() << "Child not found in " << node->node_kind_string();
+}
+
+bool IsBuiltinCall(const ResolvedNode* node, FunctionSignatureId id) {
+  if (node->node_kind() != RESOLVED_FUNCTION_CALL) return false;
+  const auto* call = node->GetAs<ResolvedFunctionCall>();
+  return call->function()->IsZetaSQLBuiltin() &&
+         call->signature().context_id() == id;
+}
+
+// Adds the conjuncts of <expr>, which may be nested ANDs, to <conjuncts>.
+void GetConjuncts(const ResolvedExpr* expr,
+                  std::vector<const ResolvedExpr*>* conjuncts) {
+  if (!IsBuiltinCall(expr, FN_AND)) {
+    conjuncts->push_back(expr);
+    return;
+  }
+  for (const auto& argument :
+       expr->GetAs<ResolvedFunctionCall>()->argument_list()) {
+    GetConjuncts(argument.get(), conjuncts);
+  }
+}
+
+// Returns true if the tree at <node> references a column in <column_ids>.
+bool References(const ResolvedNode* node,
+                const absl::flat_hash_set<int>& column_ids) {
+  if (node->node_kind() == RESOLVED_COLUMN_REF &&
+      column_ids.contains(
+          node->GetAs<ResolvedColumnRef>()->column().column_id())) {
+    return true;
+  }
+  std::vector<const ResolvedNode*> children;
+  node->GetChildNodes(&children);
+  for (const ResolvedNode* child : children) {
+    if (References(child, column_ids)) return true;
+  }
+  return false;
+}
+
+bool Produces(const ResolvedScan* scan, const ResolvedColumn& column) {
+  const std::vector<ResolvedColumn>& columns = scan->column_list();
+  return std::find(columns.begin(), columns.end(), column) != columns.end();
+}
+
+// Returns <columns> followed by the columns of <more> not in it.
+std::vector<ResolvedColumn> WithColumns(
+    std::vector<ResolvedColumn> columns,
+    const std::vector<ResolvedColumn>& more) {
+  for (const ResolvedColumn& column : more) {
+    if (std::find(columns.begin(), columns.end(), column) == columns.end()) {
+      columns.push_back(column);
+    }
+  }
+  return columns;
+}
+
+// Returns true for the aggregate function calls that return NULL for no
+// input rows.
+bool IsNullForNoRows(const ResolvedExpr* expr) {
+  if (expr->node_kind() != RESOLVED_AGGREGATE_FUNCTION_CALL) return false;
+  const auto* call = expr->GetAs<ResolvedAggregateFunctionCall>();
+  if (!call->function()->IsZetaSQLBuiltin()) return false;
+  switch (call->signature().context_id()) {
+    case FN_ANY_VALUE:
+    case FN_AVG_INT64:
+    case FN_AVG_UINT64:
+    case FN_AVG_DOUBLE:
+    case FN_AVG_NUMERIC:
+    case FN_MAX:
+    case FN_MIN:
+    case FN_SUM_INT64:
+    case FN_SUM_UINT64:
+    case FN_SUM_DOUBLE:
+    case FN_SUM_NUMERIC:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Adds the slots of the ResolvedSubqueryExprs in the expression at <slot>,
+// other than those inside scans or other subqueries, to <subqueries>.
+void FindSubqueries(NodeSlot slot, std::vector<NodeSlot>* subqueries) {
+  const ResolvedNode* node = slot->get();
+  if (node->node_kind() == RESOLVED_SUBQUERY_EXPR) {
+    subqueries->push_back(slot);
+    return;
+  }
+  if (node->IsScan()) return;
+  for (NodeSlot child : MutableChildren(node)) {
+    FindSubqueries(child, subqueries);
+  }
+}
+
+// Returns the subquery that <conjunct> tests with EXISTS or IN, or NOT
+// EXISTS if <*negated> is set, or null.
+const ResolvedSubqueryExpr* SemiJoinSubquery(const ResolvedExpr* conjunct,
+                                             bool* negated) {
+  *negated = IsBuiltinCall(conjunct, FN_NOT);
+  if (*negated) {
+    conjunct = conjunct->GetAs<ResolvedFunctionCall>()->argument_list(0);
+  }
+  if (conjunct->node_kind() != RESOLVED_SUBQUERY_EXPR) return nullptr;
+  const auto* subquery = conjunct->GetAs<ResolvedSubqueryExpr>();
+  switch (subquery->subquery_type()) {
+    case ResolvedSubqueryExpr::EXISTS:
+      return subquery;
+    case ResolvedSubqueryExpr::IN:
+      return *negated ? nullptr : subquery;
+    default:
+      return nullptr;
+  }
+}
+
+// A correlated subquery that a join can compute.
+struct Unnesting {
+  // A conjunct <inner> = <outer> of <filter>, with <outer> a parameter.
+  struct Key {
+    int conjunct = -1;
+    ResolvedColumn inner;
+    ResolvedColumn outer;
+  };
+
+  // The ResolvedProjectScans at the top of the subquery, from the top down.
+  std::vector<const ResolvedProjectScan*> projects;
+  // The aggregate of a scalar subquery.
+  const ResolvedAggregateScan* aggregate = nullptr;
+  // The filter with the keys, or null for uncorrelated IN subqueries.
+  const ResolvedFilterScan* filter = nullptr;
+  int num_conjuncts = 0;
+  std::vector<Key> keys;
+};
+
+class SubqueryDecorrelator {
+ public:
+  SubqueryDecorrelator(ColumnIdAllocator allocate_column_id, Catalog* catalog)
+      : allocate_column_id_(std::move(allocate_column_id)),
+        catalog_(catalog) {}
+  SubqueryDecorrelator(const SubqueryDecorrelator&) = delete;
+  SubqueryDecorrelator& operator=(const SubqueryDecorrelator&) = delete;
+
+  // Rewrites the tree at <slot>, bottom-up, so that subqueries nested in
+  // subqueries are rewritten first.
+  zetasql_base::Status Rewrite(NodeSlot slot) {
+    for (NodeSlot child : MutableChildren(slot->get())) {
+      ZETASQL_RETURN_IF_ERROR(Rewrite(child));
+    }
+    switch ((*slot)->node_kind()) {
+      case RESOLVED_PROJECT_SCAN:
+        return RewriteScalarSubqueries(slot->get()->GetAs<ResolvedScan>());
+      case RESOLVED_FILTER_SCAN:
+        ZETASQL_RETURN_IF_ERROR(
+            RewriteScalarSubqueries(slot->get()->GetAs<ResolvedScan>()));
+        return RewriteSemiJoins(slot);
+      default:
+        return ::zetasql_base::OkStatus();
+    }
+  }
+
+ private:
+  // Returns the slot of the input of <scan>, a ResolvedFilterScan or
+  // ResolvedProjectScan.
+  static zetasql_base::StatusOr<NodeSlot> InputSlot(const ResolvedScan* scan) {
+    if (scan->node_kind() == RESOLVED_FILTER_SCAN) {
+      return ChildSlot(scan, scan->GetAs<ResolvedFilterScan>()->input_scan());
+    }
+    ZETASQL_RET_CHECK_EQ(RESOLVED_PROJECT_SCAN, scan->node_kind());
+    return ChildSlot(scan, scan->GetAs<ResolvedProjectScan>()->input_scan());
+  }
+
+  // Rewrites the scalar subqueries in the expressions of <scan>.
+  zetasql_base::Status RewriteScalarSubqueries(const ResolvedScan* scan) {
+    std::vector<NodeSlot> subqueries;
+    for (NodeSlot child : MutableChildren(scan)) {
+      FindSubqueries(child, &subqueries);
+    }
+    for (NodeSlot slot : subqueries) {
+      const auto* subquery = (*slot)->GetAs<ResolvedSubqueryExpr>();
+      if (subquery->subquery_type() != ResolvedSubqueryExpr::SCALAR) continue;
+      ZETASQL_ASSIGN_OR_RETURN(NodeSlot input, InputSlot(scan));
+      Unnesting unnesting;
+      if (!Analyze(subquery, (*input)->GetAs<ResolvedScan>(), &unnesting)) {
+        continue;
+      }
+      const ResolvedColumn column = subquery->subquery()->column_list(0);
+      ExprList join_conjuncts;
+      ZETASQL_ASSIGN_OR_RETURN(
+          std::unique_ptr<const ResolvedScan> inner,
+          Unnest(const_cast<ResolvedSubqueryExpr*>(subquery), unnesting,
+                 &join_conjuncts, /*new_keys=*/nullptr));
+      ZETASQL_RETURN_IF_ERROR(Join(input, ResolvedJoinScan::LEFT, {column},
+                           std::move(inner), std::move(join_conjuncts)));
+      *slot = MakeResolvedColumnRef(column.type(), column,
+                                    /*is_correlated=*/false);
+    }
+    return ::zetasql_base::OkStatus();
+  }
+
+  // Rewrites the conjuncts EXISTS, NOT EXISTS and IN of the
+  // ResolvedFilterScan in <slot>, and removes it if none are left.
+  zetasql_base::Status RewriteSemiJoins(NodeSlot slot) {
+    auto* filter =
+        const_cast<ResolvedFilterScan*>((*slot)->GetAs<ResolvedFilterScan>());
+    std::vector<const ResolvedExpr*> candidates;
+    GetConjuncts(filter->filter_expr(), &candidates);
+    bool negated;
+    if (std::none_of(candidates.begin(), candidates.end(),
+                     [&negated](const ResolvedExpr* conjunct) {
+                       return SemiJoinSubquery(conjunct, &negated) != nullptr;
+                     })) {
+      return ::zetasql_base::OkStatus();
+    }
+
+    ExprList conjuncts;
+    AddConjuncts(filter->release_filter_expr(), &conjuncts);
+    ExprList kept;
+    for (auto& conjunct : conjuncts) {
+      const ResolvedSubqueryExpr* subquery =
+          SemiJoinSubquery(conjunct.get(), &negated);
+      ZETASQL_ASSIGN_OR_RETURN(NodeSlot input,
+                       ChildSlot(filter, filter->input_scan()));
+      Unnesting unnesting;
+      if (subquery == nullptr ||
+          !Analyze(subquery, (*input)->GetAs<ResolvedScan>(), &unnesting) ||
+          (negated && FindBuiltin("$is_null") == nullptr)) {
+        kept.push_back(std::move(conjunct));
+        continue;
+      }
+      ExprList join_conjuncts;
+      std::vector<ResolvedColumn> new_keys;
+      ZETASQL_ASSIGN_OR_RETURN(
+          std::unique_ptr<const ResolvedScan> inner,
+          Unnest(const_cast<ResolvedSubqueryExpr*>(subquery), unnesting,
+                 &join_conjuncts, &new_keys));
+      if (!negated) {
+        ZETASQL_RETURN_IF_ERROR(Join(input, ResolvedJoinScan::INNER, {},
+                             std::move(inner), std::move(join_conjuncts)));
+        continue;
+      }
+      // A row without a match has a NULL key. A match has a non-NULL one,
+      // since it is equal to a column of the row.
+      ZETASQL_RETURN_IF_ERROR(Join(input, ResolvedJoinScan::LEFT, {new_keys[0]},
+                           std::move(inner), std::move(join_conjuncts)));
+      const Type* key_type = new_keys[0].type();
+      kept.push_back(MakeResolvedFunctionCall(
+          types::BoolType(), FindBuiltin("$is_null"),
+          FunctionSignature(types::BoolType(), {key_type}, FN_IS_NULL),
+          MakeNodeVector(MakeResolvedColumnRef(key_type, new_keys[0],
+                                               /*is_correlated=*/false)),
+          ResolvedFunctionCall::DEFAULT_ERROR_MODE));
+    }
+
+    if (kept.empty()) {
+      std::unique_ptr<const ResolvedScan> input_scan =
+          filter->release_input_scan();
+      const std::vector<ResolvedColumn> columns = filter->column_list();
+      if (input_scan->column_list() != columns) {
+        input_scan =
+            MakeResolvedProjectScan(columns, {}, std::move(input_scan));
+      }
+      *slot = std::move(input_scan);
+      return ::zetasql_base::OkStatus();
+    }
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<const ResolvedExpr> filter_expr,
+                     MakeConjunction(std::move(kept)));
+    filter->set_filter_expr(std::move(filter_expr));
+    return ::zetasql_base::OkStatus();
+  }
+
+  // Returns true if <subquery>, evaluated for the rows of <outer>, has a
+  // form that a join can compute, described in <*unnesting>.
+  bool Analyze(const ResolvedSubqueryExpr* subquery, const ResolvedScan* outer,
+               Unnesting* unnesting) {
+    if (!subquery->hint_list().empty()) return false;
+    absl::flat_hash_set<int> parameters;
+    for (const auto& parameter : subquery->parameter_list()) {
+      if (!Produces(outer, parameter->column())) return false;
+      parameters.insert(parameter->column().column_id());
+    }
+    const bool scalar =
+        subquery->subquery_type() == ResolvedSubqueryExpr::SCALAR;
+    const ResolvedScan* scan = subquery->subquery();
+    while (scan->node_kind() == RESOLVED_PROJECT_SCAN) {
+      const auto* project = scan->GetAs<ResolvedProjectScan>();
+      // Computed columns of a scalar subquery would not be NULL for outer
+      // rows without a match.
+      if (scalar && !project->expr_list().empty()) return false;
+      for (const auto& computed_column : project->expr_list()) {
+        if (References(computed_column.get(), parameters)) return false;
+      }
+      unnesting->projects.push_back(project);
+      scan = project->input_scan();
+    }
+
+    if (scalar) {
+      if (scan->node_kind() != RESOLVED_AGGREGATE_SCAN) return false;
+      const auto* aggregate = scan->GetAs<ResolvedAggregateScan>();
+      if (!aggregate->group_by_list().empty() ||
+          !aggregate->grouping_set_list().empty() ||
+          aggregate->aggregate_list().empty()) {
+        return false;
+      }
+      for (const auto& computed_column : aggregate->aggregate_list()) {
+        if (!IsNullForNoRows(computed_column->expr()) ||
+            References(computed_column.get(), parameters)) {
+          return false;
+        }
+      }
+      unnesting->aggregate = aggregate;
+      scan = aggregate->input_scan();
+    }
+
+    if (scan->node_kind() == RESOLVED_FILTER_SCAN) {
+      const auto* filter = scan->GetAs<ResolvedFilterScan>();
+      scan = filter->input_scan();
+      std::vector<const ResolvedExpr*> conjuncts;
+      GetConjuncts(filter->filter_expr(), &conjuncts);
+      for (int i = 0; i < conjuncts.size(); ++i) {
+        if (!References(conjuncts[i], parameters)) continue;
+        Unnesting::Key key;
+        if (!IsKey(conjuncts[i], parameters, scan, &key)) return false;
+        key.conjunct = i;
+        unnesting->keys.push_back(key);
+      }
+      if (IsBuiltinCall(filter->filter_expr(), FN_AND)) {
+        and_function_ =
+            filter->filter_expr()->GetAs<ResolvedFunctionCall>()->function();
+      }
+      unnesting->filter = filter;
+      unnesting->num_conjuncts = conjuncts.size();
+    }
+    if (References(scan, parameters)) return false;
+
+    int num_join_conjuncts = unnesting->keys.size();
+    if (subquery->subquery_type() == ResolvedSubqueryExpr::IN) {
+      if (!subquery->in_expr()->type()->Equals(
+              subquery->subquery()->column_list(0).type()) ||
+          FindBuiltin("$equal") == nullptr) {
+        return false;
+      }
+      ++num_join_conjuncts;
+    }
+    // Without keys, an EXISTS or scalar subquery is uncorrelated.
+    return num_join_conjuncts > 0 &&
+           (num_join_conjuncts == 1 || and_function_ != nullptr ||
+            FindBuiltin("$and") != nullptr);
+  }
+
+  // Returns true if <conjunct> is <inner> = <outer>, with <outer> one of
+  // <parameters> and <inner> a column of <input>.
+  static bool IsKey(const ResolvedExpr* conjunct,
+                    const absl::flat_hash_set<int>& parameters,
+                    const ResolvedScan* input, Unnesting::Key* key) {
+    if (!IsBuiltinCall(conjunct, FN_EQUAL)) return false;
+    const auto& arguments =
+        conjunct->GetAs<ResolvedFunctionCall>()->argument_list();
+    if (arguments.size() != 2) return false;
+    bool has_inner = false;
+    bool has_outer = false;
+    for (const auto& argument : arguments) {
+      if (argument->node_kind() != RESOLVED_COLUMN_REF) return false;
+      const auto* ref = argument->GetAs<ResolvedColumnRef>();
+      if (ref->is_correlated() &&
+          parameters.contains(ref->column().column_id())) {
+        has_outer = true;
+        key->outer = ref->column();
+      } else if (!ref->is_correlated() && Produces(input, ref->column())) {
+        has_inner = true;
+        key->inner = ref->column();
+      }
+    }
+    return has_inner && has_outer;
+  }
+
+  // Takes the subquery out of <subquery> and rewrites it as described by
+  // <unnesting>, into a scan with one row per key.  Adds the conditions
+  // joining its rows to the outer rows to <join_conjuncts>.  For EXISTS and
+  // IN, the scan produces the distinct keys, whose columns are set in
+  // <*new_keys>.  For scalar subqueries, the aggregate is grouped by the
+  // keys.
+  zetasql_base::StatusOr<std::unique_ptr<const ResolvedScan>> Unnest(
+      ResolvedSubqueryExpr* subquery, const Unnesting& unnesting,
+      ExprList* join_conjuncts, std::vector<ResolvedColumn>* new_keys) {
+    // The new columns of the keys, by inner column id.
+    absl::flat_hash_map<int, ResolvedColumn> key_columns;
+    std::vector<ResolvedColumn> inner_columns;
+    std::vector<ResolvedColumn> grouped_columns;
+    for (const Unnesting::Key& key : unnesting.keys) {
+      if (key_columns.contains(key.inner.column_id())) continue;
+      const ResolvedColumn column(allocate_column_id_(), GroupByTableName(),
+                                  key.inner.name_id(), key.inner.type());
+      key_columns.emplace(key.inner.column_id(), column);
+      inner_columns.push_back(key.inner);
+      grouped_columns.push_back(column);
+    }
+
+    ExprList keys(unnesting.keys.size());
+    if (unnesting.filter != nullptr) {
+      ZETASQL_ASSIGN_OR_RETURN(keys,
+                       TakeKeys(subquery, unnesting, inner_columns));
+    }
+    for (int i = 0; i < keys.size(); ++i) {
+      const Unnesting::Key& key = unnesting.keys[i];
+      // Both arguments are column references.
+      for (NodeSlot argument : MutableChildren(keys[i].get())) {
+        const auto* ref = (*argument)->GetAs<ResolvedColumnRef>();
+        const ResolvedColumn column =
+            ref->is_correlated() ? key.outer
+                                 : key_columns.at(key.inner.column_id());
+        *argument = MakeResolvedColumnRef(column.type(), column,
+                                          /*is_correlated=*/false);
+      }
+      join_conjuncts->push_back(std::move(keys[i]));
+    }
+
+    if (unnesting.aggregate != nullptr) {
+      auto* aggregate =
+          const_cast<ResolvedAggregateScan*>(unnesting.aggregate);
+      for (int i = 0; i < inner_columns.size(); ++i) {
+        aggregate->add_group_by_list(MakeResolvedComputedColumn(
+            grouped_columns[i],
+            MakeResolvedColumnRef(inner_columns[i].type(), inner_columns[i],
+                                  /*is_correlated=*/false)));
+      }
+      aggregate->set_column_list(
+          WithColumns(aggregate->column_list(), grouped_columns));
+      for (const ResolvedProjectScan* project : unnesting.projects) {
+        const_cast<ResolvedProjectScan*>(project)->set_column_list(
+            WithColumns(project->column_list(), grouped_columns));
+      }
+      return subquery->release_subquery();
+    }
+
+    for (const ResolvedProjectScan* project : unnesting.projects) {
+      const_cast<ResolvedProjectScan*>(project)->set_column_list(
+          WithColumns(project->column_list(), inner_columns));
+    }
+    std::vector<std::unique_ptr<const ResolvedComputedColumn>> group_by_list;
+    for (int i = 0; i < inner_columns.size(); ++i) {
+      group_by_list.push_back(MakeResolvedComputedColumn(
+          grouped_columns[i],
+          MakeResolvedColumnRef(inner_columns[i].type(), inner_columns[i],
+                                /*is_correlated=*/false)));
+    }
+    if (subquery->subquery_type() == ResolvedSubqueryExpr::IN) {
+      const ResolvedColumn value = subquery->subquery()->column_list(0);
+      const ResolvedColumn column(allocate_column_id_(), GroupByTableName(),
+                                  value.name_id(), value.type());
+      group_by_list.push_back(MakeResolvedComputedColumn(
+          column, MakeResolvedColumnRef(value.type(), value,
+                                        /*is_correlated=*/false)));
+      grouped_columns.push_back(column);
+      ExprList arguments;
+      arguments.push_back(subquery->release_in_expr());
+      arguments.push_back(MakeResolvedColumnRef(value.type(), column,
+                                                /*is_correlated=*/false));
+      join_conjuncts->push_back(MakeResolvedFunctionCall(
+          types::BoolType(), FindBuiltin("$equal"),
+          FunctionSignature(types::BoolType(), {value.type(), value.type()},
+                            FN_EQUAL),
+          std::move(arguments), ResolvedFunctionCall::DEFAULT_ERROR_MODE));
+    }
+    *new_keys = grouped_columns;
+    return std::unique_ptr<const ResolvedScan>(MakeResolvedAggregateScan(
+        grouped_columns, subquery->release_subquery(), std::move(group_by_list),
+        /*aggregate_list=*/{}, /*grouping_set_list=*/{},
+        /*rollup_column_list=*/{}));
+  }
+
+  // Takes the key conjuncts out of the filter of <unnesting>, in the order
+  // of its keys, and makes <inner_columns> visible above it.  Removes the
+  // filter if no conjuncts are left.
+  zetasql_base::StatusOr<ExprList> TakeKeys(
+      const ResolvedSubqueryExpr* subquery, const Unnesting& unnesting,
+      const std::vector<ResolvedColumn>& inner_columns) {
+    auto* filter = const_cast<ResolvedFilterScan*>(unnesting.filter);
+    ExprList conjuncts;
+    AddConjuncts(filter->release_filter_expr(), &conjuncts);
+    ZETASQL_RET_CHECK_EQ(unnesting.num_conjuncts, conjuncts.size());
+    ExprList keys;
+    for (const Unnesting::Key& key : unnesting.keys) {
+      keys.push_back(std::move(conjuncts[key.conjunct]));
+    }
+    ExprList kept;
+    for (auto& conjunct : conjuncts) {
+      if (conjunct != nullptr) kept.push_back(std::move(conjunct));
+    }
+    const std::vector<ResolvedColumn> columns =
+        WithColumns(filter->column_list(), inner_columns);
+    if (!kept.empty()) {
+      ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<const ResolvedExpr> filter_expr,
+                       MakeConjunction(std::move(kept)));
+      filter->set_filter_expr(std::move(filter_expr));
+      filter->set_column_list(columns);
+      return keys;
+    }
+
+    const ResolvedNode* parent = subquery;
+    if (unnesting.aggregate != nullptr) {
+      parent = unnesting.aggregate;
+    } else if (!unnesting.projects.empty()) {
+      parent = unnesting.projects.back();
+    }
+    ZETASQL_ASSIGN_OR_RETURN(NodeSlot slot, ChildSlot(parent, filter));
+    std::unique_ptr<const ResolvedScan> input = filter->release_input_scan();
+    if (input->column_list() != columns) {
+      input = MakeResolvedProjectScan(columns, {}, std::move(input));
+    }
+    *slot = std::move(input);
+    return keys;
+  }
+
+  // Replaces the scan in <slot> with its join with <inner> on
+  // <join_conjuncts>, producing its columns and <inner_columns>.
+  zetasql_base::Status Join(NodeSlot slot, ResolvedJoinScan::JoinType join_type,
+                    const std::vector<ResolvedColumn>& inner_columns,
+                    std::unique_ptr<const ResolvedScan> inner,
+                    ExprList join_conjuncts) {
+    std::unique_ptr<const ResolvedScan> outer(
+        slot->release()->GetAs<ResolvedScan>());
+    std::vector<ResolvedColumn> columns = outer->column_list();
+    columns.insert(columns.end(), inner_columns.begin(), inner_columns.end());
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<const ResolvedExpr> join_expr,
+                     MakeConjunction(std::move(join_conjuncts)));
+    *slot = MakeResolvedJoinScan(columns, join_type, std::move(outer),
+                                 std::move(inner), std::move(join_expr));
+    return ::zetasql_base::OkStatus();
+  }
+
+  // Adds the conjuncts of <expr>, which may be nested ANDs, to <conjuncts>.
+  void AddConjuncts(std::unique_ptr<const ResolvedExpr> expr,
+                    ExprList* conjuncts) {
+    if (!IsBuiltinCall(expr.get(), FN_AND)) {
+      conjuncts->push_back(std::move(expr));
+      return;
+    }
+    and_function_ = expr->GetAs<ResolvedFunctionCall>()->function();
+    for (auto& argument : const_cast<ResolvedFunctionCall*>(
+                              expr->GetAs<ResolvedFunctionCall>())
+                              ->release_argument_list()) {
+      AddConjuncts(std::move(argument), conjuncts);
+    }
+  }
+
+  zetasql_base::StatusOr<std::unique_ptr<const ResolvedExpr>> MakeConjunction(
+      ExprList conjuncts) {
+    ZETASQL_RET_CHECK(!conjuncts.empty());
+    if (conjuncts.size() == 1) return std::move(conjuncts[0]);
+    const Function* and_function =
+        and_function_ != nullptr ? and_function_ : FindBuiltin("$and");
+    ZETASQL_RET_CHECK(and_function != nullptr);
+    FunctionArgumentTypeList argument_types(conjuncts.size(),
+                                            FunctionArgumentType(
+                                                types::BoolType()));
+    return std::unique_ptr<const ResolvedExpr>(MakeResolvedFunctionCall(
+        types::BoolType(), and_function,
+        FunctionSignature(types::BoolType(), argument_types, FN_AND),
+        std::move(conjuncts), ResolvedFunctionCall::DEFAULT_ERROR_MODE));
+  }
+
+  // Returns the builtin function <name> of the catalog, or null.
+  const Function* FindBuiltin(const std::string& name) {
+    auto it = functions_.find(name);
+    if (it != functions_.end()) return it->second;
+    const Function* function = nullptr;
+    if (catalog_ == nullptr ||
+        !catalog_->FindFunction({name}, &function).ok() ||
+        !function->IsZetaSQLBuiltin()) {
+      function = nullptr;
+    }
+    functions_[name] = function;
+    return function;
+  }
+
+  static IdString GroupByTableName() {
+    STATIC_IDSTRING(kGroupByTableName, "$groupby");
+    return kGroupByTableName;
+  }
+
+  const ColumnIdAllocator allocate_column_id_;
+  Catalog* const catalog_;
+  absl::flat_hash_map<std::string, const Function*> functions_;
+
+  // The $and function of the last expression split into conjuncts.
+  const Function* and_function_ = nullptr;
+};
+
+}  // namespace
+
+zetasql_base::Status DecorrelateSubqueries(
+    const ColumnIdAllocator& allocate_column_id, Catalog* catalog,
+    std::unique_ptr<const ResolvedNode>* root) {
+  ZETASQL_RET_CHECK(root != nullptr && *root != nullptr);
+  ColumnIdAllocator allocator = allocate_column_id;
+  if (!allocator) {
+    int max_column_id = 0;
+    std::vector<const ResolvedNode*> stack = {root->get()};
+    std::vector<const ResolvedNode*> children;
+    std::vector<const ResolvedColumn*> columns;
+    while (!stack.empty()) {
+      const ResolvedNode* node = stack.back();
+      stack.pop_back();
+      columns.clear();
+      node->AddColumnPointers(&columns);
+      for (const ResolvedColumn* column : columns) {
+        max_column_id = std::max(max_column_id, column->column_id());
+      }
+      node->GetChildNodes(&children);
+      stack.insert(stack.end(), children.begin(), children.end());
+    }
+    allocator = [max_column_id]() mutable { return ++max_column_id; };
+  }
+  SubqueryDecorrelator decorrelator(std::move(allocator), catalog);
+  return decorrelator.Rewrite(root);
+}
+
+}  // namespace zetasql
@@ -0,0 +1,67 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_RESOLVED_AST_SUBQUERY_DECORRELATION_H_
+#define ZETASQL_RESOLVED_AST_SUBQUERY_DECORRELATION_H_
+
+#include <memory>
+
+#include "zetasql/public/catalog.h"
+#include "zetasql/resolved_ast/common_subexpression_elimination.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+
+// Replaces correlated ResolvedSubqueryExprs in the tree at <*root> with
+// joins, so that the subqueries are computed once instead of once per row.
+// The tree is modified in place.
+//
+// A subquery is rewritten if it is in the filter_expr of a
+// ResolvedFilterScan or the expr_list of a ResolvedProjectScan, the input
+// of that scan produces all of its parameters, and its parameters are only
+// used in conjuncts <column> = <parameter> of a ResolvedFilterScan, where
+// <column> is produced by the input of that filter.  The forms rewritten
+// are, with those conjuncts as the join condition:
+//   - Conjuncts EXISTS(...) and <expr> IN (...) of a filter become INNER
+//     joins with the distinct values of the subquery's key columns (and
+//     its column, for IN).
+//   - Conjuncts NOT EXISTS(...) of a filter become LEFT joins with the
+//     distinct key values, and a filter keeping the rows without a match.
+//   - A scalar subquery aggregating its rows with MIN, MAX, SUM, AVG or
+//     ANY_VALUE, all of which return NULL for no rows, becomes a LEFT join
+//     with the aggregates grouped by the key columns, and the subquery is
+//     replaced by a reference to the aggregate column.
+//
+// Scans between the subquery's top and the filter must be
+// ResolvedProjectScans, without computed columns above the aggregate of a
+// scalar subquery.  NOT IN is not rewritten, because a NULL from the
+// subquery makes it NULL for all rows.  Since the joins compute scalar
+// subqueries for all rows, an aggregate may raise an error, like an
+// overflow, that a short-circuiting expression would have avoided.
+//
+// The $equal, $and and $is_null functions that the joins use are looked up
+// in <catalog>, which may be null; forms needing a function that is not
+// found are not rewritten.  New columns take their ids from
+// <allocate_column_id>.  If it is empty, they are numbered after the
+// largest column id in the tree.
+zetasql_base::Status DecorrelateSubqueries(
+    const ColumnIdAllocator& allocate_column_id, Catalog* catalog,
+    std::unique_ptr<const ResolvedNode>* root);
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_RESOLVED_AST_SUBQUERY_DECORRELATION_H_
@@ -0,0 +1,306 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/resolved_ast/subquery_decorrelation.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/builtin_function.pb.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/make_node_vector.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "zetasql/resolved_ast/resolved_column.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace zetasql {
+
+class SubqueryDecorrelationTest : public ::testing::Test {
+ protected:
+  SubqueryDecorrelationTest()
+      : catalog_("catalog"),
+        t_("T", {{"a", types::Int64Type()}, {"b", types::Int64Type()}}),
+        u_("U", {{"c", types::Int64Type()}, {"d", types::Int64Type()}}),
+        a_(1, "T", "a", types::Int64Type()),
+        b_(2, "T", "b", types::Int64Type()),
+        c_(3, "U", "c", types::Int64Type()),
+        d_(4, "U", "d", types::Int64Type()),
+        x_(5, "$expr", "x", types::Int64Type()) {
+    catalog_.AddZetaSQLFunctions();
+  }
+
+  const Function* Builtin(const std::string& name) {
+    const Function* function = nullptr;
+    ZETASQL_CHECK_OK(catalog_.FindFunction({name}, &function));
+    return function;
+  }
+
+  // Returns a call to builtin function <name> with signature <id>.
+  template <typename T>
+  std::unique_ptr<const ResolvedExpr> Call(
+      const std::string& name, FunctionSignatureId id, const Type* type,
+      std::vector<std::unique_ptr<T>> argument_nodes) {
+    std::vector<std::unique_ptr<const ResolvedExpr>> arguments;
+    FunctionArgumentTypeList argument_types;
+    for (auto& argument : argument_nodes) {
+      argument_types.emplace_back(argument->type());
+      arguments.push_back(std::move(argument));
+    }
+    return MakeResolvedFunctionCall(
+        type, Builtin(name), FunctionSignature(type, argument_types, id),
+        std::move(arguments), ResolvedFunctionCall::DEFAULT_ERROR_MODE);
+  }
+
+  std::unique_ptr<const ResolvedExpr> Equal(
+      std::unique_ptr<const ResolvedExpr> argument1,
+      std::unique_ptr<const ResolvedExpr> argument2) {
+    return Call("$equal", FN_EQUAL, types::BoolType(),
+                MakeNodeVector(std::move(argument1), std::move(argument2)));
+  }
+
+  static std::unique_ptr<const ResolvedExpr> Int64(int64_t value) {
+    return MakeResolvedLiteral(Value::Int64(value));
+  }
+
+  static std::unique_ptr<const ResolvedExpr> ColumnRef(
+      const ResolvedColumn& column, bool is_correlated = false) {
+    return MakeResolvedColumnRef(column.type(), column, is_correlated);
+  }
+
+  std::unique_ptr<const ResolvedScan> TScan() {
+    return MakeResolvedTableScan({a_, b_}, &t_,
+                                 /*for_system_time_expr=*/nullptr);
+  }
+
+  std::unique_ptr<const ResolvedScan> UScan() {
+    return MakeResolvedTableScan({c_, d_}, &u_,
+                                 /*for_system_time_expr=*/nullptr);
+  }
+
+  // <aggregate_column> := <name>(d), aggregating <input>.
+  std::unique_ptr<ResolvedAggregateScan> Aggregate(
+      const std::string& name, FunctionSignatureId id,
+      const ResolvedColumn& aggregate_column,
+      std::unique_ptr<const ResolvedScan> input) {
+    return MakeResolvedAggregateScan(
+        {aggregate_column}, std::move(input), /*group_by_list=*/{},
+        MakeNodeVector(MakeResolvedComputedColumn(
+            aggregate_column,
+            MakeResolvedAggregateFunctionCall(
+                types::Int64Type(), Builtin(name),
+                FunctionSignature(types::Int64Type(), {types::Int64Type()},
+                                  id),
+                MakeNodeVector(ColumnRef(d_)),
+                ResolvedFunctionCall::DEFAULT_ERROR_MODE,
+                /*distinct=*/false,
+                ResolvedAggregateFunctionCall::DEFAULT_NULL_HANDLING,
+                /*having_modifier=*/nullptr, /*order_by_item_list=*/{},
+                /*limit=*/nullptr, /*function_call_info=*/nullptr))),
+        /*grouping_set_list=*/{}, /*rollup_column_list=*/{});
+  }
+
+  // SELECT 1 AS x FROM U WHERE c = T.a
+  std::unique_ptr<const ResolvedScan> ExistsSubquery() {
+    return MakeResolvedProjectScan(
+        {x_}, MakeNodeVector(MakeResolvedComputedColumn(
+                  x_, MakeResolvedLiteral(Value::Int64(1)))),
+        MakeResolvedFilterScan({c_, d_}, UScan(),
+                               Equal(ColumnRef(c_),
+                                     ColumnRef(a_, /*is_correlated=*/true))));
+  }
+
+  std::unique_ptr<const ResolvedExpr> Subquery(
+      ResolvedSubqueryExpr::SubqueryType subquery_type, const Type* type,
+      std::unique_ptr<const ResolvedScan> subquery,
+      std::unique_ptr<const ResolvedExpr> in_expr = nullptr) {
+    return MakeResolvedSubqueryExpr(type, subquery_type,
+                                    MakeNodeVector(MakeResolvedColumnRef(
+                                        a_.type(), a_,
+                                        /*is_correlated=*/false)),
+                                    std::move(in_expr), std::move(subquery));
+  }
+
+  std::unique_ptr<const ResolvedNode> Decorrelate(
+      std::unique_ptr<const ResolvedNode> node) {
+    ZETASQL_EXPECT_OK(
+        DecorrelateSubqueries(ColumnIdAllocator(), &catalog_, &node));
+    return node;
+  }
+
+  SimpleCatalog catalog_;
+  SimpleTable t_;
+  SimpleTable u_;
+  const ResolvedColumn a_;
+  const ResolvedColumn b_;
+  const ResolvedColumn c_;
+  const ResolvedColumn d_;
+  const ResolvedColumn x_;
+};
+
+TEST_F(SubqueryDecorrelationTest, ExistsBecomesInnerJoin) {
+  // SELECT a, b FROM T
+  // WHERE EXISTS(SELECT 1 FROM U WHERE c = T.a AND d > 5)
+  auto subquery = MakeResolvedProjectScan(
+      {x_}, MakeNodeVector(MakeResolvedComputedColumn(
+                x_, MakeResolvedLiteral(Value::Int64(1)))),
+      MakeResolvedFilterScan(
+          {c_, d_}, UScan(),
+          Call("$and", FN_AND, types::BoolType(),
+               MakeNodeVector(
+                   Equal(ColumnRef(c_), ColumnRef(a_, /*is_correlated=*/true)),
+                   Call("$greater", FN_GREATER, types::BoolType(),
+                        MakeNodeVector(ColumnRef(d_), Int64(5)))))));
+  auto node = Decorrelate(MakeResolvedFilterScan(
+      {a_, b_}, TScan(),
+      Subquery(ResolvedSubqueryExpr::EXISTS, types::BoolType(),
+               std::move(subquery))));
+
+  // The filter is removed, and the join uses the distinct values of c.
+  const ResolvedColumn key(6, "$groupby", "c", types::Int64Type());
+  auto expected = MakeResolvedJoinScan(
+      {a_, b_}, ResolvedJoinScan::INNER, TScan(),
+      MakeResolvedAggregateScan(
+          {key},
+          MakeResolvedProjectScan(
+              {x_, c_},
+              MakeNodeVector(MakeResolvedComputedColumn(
+                  x_, MakeResolvedLiteral(Value::Int64(1)))),
+              MakeResolvedFilterScan(
+                  {c_, d_}, UScan(),
+                  Call("$greater", FN_GREATER, types::BoolType(),
+                       MakeNodeVector(ColumnRef(d_), Int64(5)))),
+          MakeNodeVector(MakeResolvedComputedColumn(key, ColumnRef(c_))),
+          /*aggregate_list=*/{}, /*grouping_set_list=*/{},
+          /*rollup_column_list=*/{}),
+      Equal(ColumnRef(key), ColumnRef(a_)));
+  EXPECT_EQ(expected->DebugString(), node->DebugString());
+}
+
+TEST_F(SubqueryDecorrelationTest, NotExistsBecomesLeftJoin) {
+  // SELECT a, b FROM T WHERE NOT EXISTS(SELECT 1 FROM U WHERE c = T.a)
+  auto node = Decorrelate(MakeResolvedFilterScan(
+      {a_, b_}, TScan(),
+      Call("$not", FN_NOT, types::BoolType(),
+           MakeNodeVector(Subquery(ResolvedSubqueryExpr::EXISTS,
+                                   types::BoolType(), ExistsSubquery())))));
+
+  const ResolvedColumn key(6, "$groupby", "c", types::Int64Type());
+  auto expected = MakeResolvedFilterScan(
+      {a_, b_},
+      MakeResolvedJoinScan(
+          {a_, b_, key}, ResolvedJoinScan::LEFT, TScan(),
+          MakeResolvedAggregateScan(
+              {key},
+              MakeResolvedProjectScan(
+                  {x_, c_},
+                  MakeNodeVector(MakeResolvedComputedColumn(
+                      x_, MakeResolvedLiteral(Value::Int64(1)))),
+                  UScan()),
+              MakeNodeVector(MakeResolvedComputedColumn(key, ColumnRef(c_))),
+              /*aggregate_list=*/{}, /*grouping_set_list=*/{},
+              /*rollup_column_list=*/{}),
+          Equal(ColumnRef(key), ColumnRef(a_))),
+      Call("$is_null", FN_IS_NULL, types::BoolType(),
+           MakeNodeVector(ColumnRef(key))));
+  EXPECT_EQ(expected->DebugString(), node->DebugString());
+}
+
+TEST_F(SubqueryDecorrelationTest, InBecomesInnerJoin) {
+  // SELECT a, b FROM T WHERE b IN (SELECT c FROM U WHERE d = T.a)
+  auto subquery = MakeResolvedProjectScan(
+      {c_}, /*expr_list=*/{},
+      MakeResolvedFilterScan(
+          {c_, d_}, UScan(),
+          Equal(ColumnRef(d_), ColumnRef(a_, /*is_correlated=*/true))));
+  auto node = Decorrelate(MakeResolvedFilterScan(
+      {a_, b_}, TScan(),
+      Subquery(ResolvedSubqueryExpr::IN, types::BoolType(),
+               std::move(subquery), ColumnRef(b_))));
+
+  const ResolvedColumn key(6, "$groupby", "d", types::Int64Type());
+  const ResolvedColumn value(7, "$groupby", "c", types::Int64Type());
+  auto expected = MakeResolvedJoinScan(
+      {a_, b_}, ResolvedJoinScan::INNER, TScan(),
+      MakeResolvedAggregateScan(
+          {key, value},
+          MakeResolvedProjectScan({c_, d_}, /*expr_list=*/{}, UScan()),
+          MakeNodeVector(MakeResolvedComputedColumn(key, ColumnRef(d_)),
+                         MakeResolvedComputedColumn(value, ColumnRef(c_))),
+          /*aggregate_list=*/{}, /*grouping_set_list=*/{},
+          /*rollup_column_list=*/{}),
+      Call("$and", FN_AND, types::BoolType(),
+           MakeNodeVector(Equal(ColumnRef(key), ColumnRef(a_)),
+                          Equal(ColumnRef(b_), ColumnRef(value)))));
+  EXPECT_EQ(expected->DebugString(), node->DebugString());
+}
+
+TEST_F(SubqueryDecorrelationTest, ScalarAggregateBecomesLeftJoin) {
+  // SELECT a, (SELECT MAX(d) FROM U WHERE c = T.a) AS m FROM T
+  const ResolvedColumn max(5, "$aggregate", "max", types::Int64Type());
+  const ResolvedColumn m(6, "$query", "m", types::Int64Type());
+  auto subquery = Aggregate(
+      "max", FN_MAX, max,
+      MakeResolvedFilterScan(
+          {c_, d_}, UScan(),
+          Equal(ColumnRef(c_), ColumnRef(a_, /*is_correlated=*/true))));
+  auto node = Decorrelate(MakeResolvedProjectScan(
+      {a_, m},
+      MakeNodeVector(MakeResolvedComputedColumn(
+          m, Subquery(ResolvedSubqueryExpr::SCALAR, types::Int64Type(),
+                      std::move(subquery)))),
+      TScan()));
+
+  // The aggregate is grouped by c.
+  const ResolvedColumn key(7, "$groupby", "c", types::Int64Type());
+  auto aggregate = Aggregate("max", FN_MAX, max, UScan());
+  aggregate->add_group_by_list(MakeResolvedComputedColumn(key, ColumnRef(c_)));
+  aggregate->set_column_list({max, key});
+  auto expected = MakeResolvedProjectScan(
+      {a_, m}, MakeNodeVector(MakeResolvedComputedColumn(m, ColumnRef(max))),
+      MakeResolvedJoinScan({a_, b_, max}, ResolvedJoinScan::LEFT, TScan(),
+                           std::move(aggregate),
+                           Equal(ColumnRef(key), ColumnRef(a_))));
+  EXPECT_EQ(expected->DebugString(), node->DebugString());
+}
+
+TEST_F(SubqueryDecorrelationTest, KeepsCountSubquery) {
+  // SELECT a, (SELECT COUNT(d) FROM U WHERE c = T.a) AS m FROM T
+  // COUNT returns 0 rather than NULL for outer rows without a match.
+  const ResolvedColumn count(5, "$aggregate", "count", types::Int64Type());
+  const ResolvedColumn m(6, "$query", "m", types::Int64Type());
+  auto subquery = Aggregate(
+      "count", FN_COUNT, count,
+      MakeResolvedFilterScan(
+          {c_, d_}, UScan(),
+          Equal(ColumnRef(c_), ColumnRef(a_, /*is_correlated=*/true))));
+  std::unique_ptr<const ResolvedNode> node = MakeResolvedProjectScan(
+      {a_, m},
+      MakeNodeVector(MakeResolvedComputedColumn(
+          m, Subquery(ResolvedSubqueryExpr::SCALAR, types::Int64Type(),
+                      std::move(subquery)))),
+      TScan());
+  const std::string original = node->DebugString();
+  node = Decorrelate(std::move(node));
+  EXPECT_EQ(original, node->DebugString());
+}
+
+}  // namespace zetasql
@@ -17,8 +17,12 @@
 #include "zetasql/resolved_ast/validator.h"
 
 #include <algorithm>
+#include <atomic>
+#include <set>
 #include <string>
+#include <thread>
 #include <type_traits>
+#include <vector>
 
 #include "zetasql/base/logging.h"
 #include "zetasql/base/varsetter.h"
@@ -50,6 +54,10 @@ namespace zetasql {
 Validator::Validator(const LanguageOptions& language_options)
     : language_options_(language_options) {}
 
+Validator::Validator(const LanguageOptions& language_options,
+                     int num_threads)
+    : language_options_(language_options), num_threads_(num_threads) {}
+
 static bool IsEmptyWindowFrame(const ResolvedWindowFrame& window_frame) {
   const ResolvedWindowFrameExpr* frame_start_expr = window_frame.start_expr();
   const ResolvedWindowFrameExpr* frame_end_expr = window_frame.end_expr();
@@ -100,7 +108,7 @@ zetasql_base::Status Validator::ValidateResolvedParameter(
 
 zetasql_base::Status Validator::CheckColumnIsPresentInColumnSet(
     const ResolvedColumn& column,
-    const std::set<ResolvedColumn>& visible_columns) const {
+    const ResolvedColumnSet& visible_columns) const {
   if (!zetasql_base::ContainsKey(visible_columns, column)) {
     return ::zetasql_base::InternalErrorBuilder(ZETASQL_LOC)
            << "Incorrect reference to column " << column.DebugString();
@@ -110,7 +118,7 @@ zetasql_base::Status Validator::CheckColumnIsPresentInColumnSet(
 
 zetasql_base::Status Validator::CheckColumnList(
     const ResolvedScan* scan,
-    const std::set<ResolvedColumn>& visible_columns) const {
+    const ResolvedColumnSet& visible_columns) const {
   ZETASQL_RET_CHECK(nullptr != scan);
   for (const ResolvedColumn& column : scan->column_list()) {
     if (!zetasql_base::ContainsKey(visible_columns, column)) {
@@ -128,8 +136,8 @@ Validator::Validator() {}
 Validator::~Validator() {}
 
 zetasql_base::Status Validator::ValidateResolvedExprList(
-    const std::set<ResolvedColumn>& visible_columns,
-    const std::set<ResolvedColumn>& visible_parameters,
+    const ResolvedColumnSet& visible_columns,
+    const ResolvedColumnSet& visible_parameters,
     const std::vector<std::unique_ptr<const ResolvedExpr>>& expr_list) const {
   for (const auto& expr_iter : expr_list) {
     ZETASQL_RETURN_IF_ERROR(ValidateResolvedExpr(visible_columns, visible_parameters,
@@ -139,8 +147,8 @@ zetasql_base::Status Validator::ValidateResolvedExprList(
 }
 
 zetasql_base::Status Validator::ValidateResolvedCast(
-    const std::set<ResolvedColumn>& visible_columns,
-    const std::set<ResolvedColumn>& visible_parameters,
+    const ResolvedColumnSet& visible_columns,
+    const ResolvedColumnSet& visible_parameters,
     const ResolvedCast* resolved_cast) const {
   ZETASQL_RETURN_IF_ERROR(ValidateResolvedExpr(visible_columns, visible_parameters,
                                        resolved_cast->expr()));
@@ -148,8 +156,8 @@ zetasql_base::Status Validator::ValidateResolvedCast(
 }
 
 zetasql_base::Status Validator::ValidateResolvedConstant(
-    const std::set<ResolvedColumn>& visible_columns,
-    const std::set<ResolvedColumn>& visible_parameters,
+    const ResolvedColumnSet& visible_columns,
+    const ResolvedColumnSet& visible_parameters,
     const ResolvedConstant* resolved_constant) const {
 
   ZETASQL_RET_CHECK(resolved_constant->constant() != nullptr)
@@ -165,8 +173,8 @@ zetasql_base::Status Validator::ValidateResolvedConstant(
 }
 
 zetasql_base::Status Validator::ValidateResolvedFunctionCallBase(
-    const std::set<ResolvedColumn>& visible_columns,
-    const std::set<ResolvedColumn>& visible_parameters,
+    const ResolvedColumnSet& visible_columns,
+    const ResolvedColumnSet& visible_parameters,
     const ResolvedFunctionCallBase* resolved_function_call) const {
 
   ZETASQL_RET_CHECK(resolved_function_call->function() != nullptr)
@@ -237,8 +245,8 @@ zetasql_base::Status Validator::ValidateStandaloneResolvedExpr(
 }
 
 zetasql_base::Status Validator::ValidateResolvedExpr(
-    const std::set<ResolvedColumn>& visible_columns,
-    const std::set<ResolvedColumn>& visible_parameters,
+    const ResolvedColumnSet& visible_columns,
+    const ResolvedColumnSet& visible_parameters,
     const ResolvedExpr* expr) const {
 
   ZETASQL_RET_CHECK(nullptr != expr);
@@ -365,8 +373,8 @@ zetasql_base::Status Validator::ValidateResolvedExpr(
 }
 
 zetasql_base::Status Validator::ValidateResolvedGetProtoFieldExpr(
-    const std::set<ResolvedColumn>& visible_columns,
-    const std::set<ResolvedColumn>& visible_parameters,
+    const ResolvedColumnSet& visible_columns,
+    const ResolvedColumnSet& visible_parameters,
     const ResolvedGetProtoField* get_proto_field) const {
   ZETASQL_RETURN_IF_ERROR(ValidateResolvedExpr(
       visible_columns, visible_parameters, get_proto_field->expr()));
@@ -399,8 +407,8 @@ zetasql_base::Status Validator::ValidateResolvedGetProtoFieldExpr(
 }
 
 zetasql_base::Status Validator::ValidateResolvedSubqueryExpr(
-    const std::set<ResolvedColumn>& visible_columns,
-    const std::set<ResolvedColumn>& visible_parameters,
+    const ResolvedColumnSet& visible_columns,
+    const ResolvedColumnSet& visible_parameters,
     const ResolvedSubqueryExpr* resolved_subquery_expr) const {
   ZETASQL_RET_CHECK_EQ(
       resolved_subquery_expr->subquery_type() == ResolvedSubqueryExpr::IN,
@@ -412,7 +420,7 @@ zetasql_base::Status Validator::ValidateResolvedSubqueryExpr(
                                          resolved_subquery_expr->in_expr()));
   }
 
-  std::set<ResolvedColumn> subquery_parameters;
+  ResolvedColumnSet subquery_parameters;
   for (const std::unique_ptr<const ResolvedColumnRef>& column_ref :
        resolved_subquery_expr->parameter_list()) {
     ZETASQL_RETURN_IF_ERROR(ValidateResolvedExpr(visible_columns, visible_parameters,
@@ -455,8 +463,8 @@ zetasql_base::Status Validator::ValidateResolvedSubqueryExpr(
 }
 
 zetasql_base::Status Validator::ValidateResolvedComputedColumn(
-    const std::set<ResolvedColumn>& visible_columns,
-    const std::set<ResolvedColumn>& visible_parameters,
+    const ResolvedColumnSet& visible_columns,
+    const ResolvedColumnSet& visible_parameters,
     const ResolvedComputedColumn* computed_column) const {
   ZETASQL_RET_CHECK(nullptr != computed_column);
 
@@ -482,8 +490,8 @@ zetasql_base::Status Validator::ValidateResolvedComputedColumn(
 }
 
 zetasql_base::Status Validator::ValidateResolvedComputedColumnList(
-    const std::set<ResolvedColumn>& visible_columns,
-    const std::set<ResolvedColumn>& visible_parameters,
+    const ResolvedColumnSet& visible_columns,
+    const ResolvedColumnSet& visible_parameters,
     const std::vector<std::unique_ptr<const ResolvedComputedColumn>>&
         computed_column_list)
     const {
@@ -496,7 +504,7 @@ zetasql_base::Status Validator::ValidateResolvedComputedColumnList(
 }
 
 zetasql_base::Status Validator::ValidateResolvedOutputColumn(
-    const std::set<ResolvedColumn>& visible_columns,
+    const ResolvedColumnSet& visible_columns,
     const ResolvedOutputColumn* output_column) const {
   ZETASQL_RET_CHECK(nullptr != output_column);
 
@@ -512,7 +520,7 @@ zetasql_base::Status Validator::ValidateResolvedOutputColumnList(
     bool is_value_table) const {
   ZETASQL_RET_CHECK(!output_column_list.empty())
       << "Statement must produce at least one output column";
-  const std::set<ResolvedColumn> visible_columns_set(
+  const ResolvedColumnSet visible_columns_set(
       visible_columns.begin(), visible_columns.end());
   for (const auto& output_column : output_column_list) {
     ZETASQL_RETURN_IF_ERROR(
@@ -536,7 +544,7 @@ zetasql_base::Status Validator::ValidateResolvedOutputColumnList(
 }
 
 zetasql_base::Status Validator::AddColumnList(const ResolvedColumnList& column_list,
-                                      std::set<ResolvedColumn>* visible_columns)
+                                      ResolvedColumnSet* visible_columns)
     const {
   ZETASQL_RET_CHECK(nullptr != visible_columns);
   for (const ResolvedColumn& column : column_list) {
@@ -547,7 +555,7 @@ zetasql_base::Status Validator::AddColumnList(const ResolvedColumnList& column_l
 
 zetasql_base::Status Validator::AddColumnFromComputedColumn(
     const ResolvedComputedColumn* computed_column,
-    std::set<ResolvedColumn>* visible_columns) const {
+    ResolvedColumnSet* visible_columns) const {
   ZETASQL_RET_CHECK(nullptr != visible_columns && nullptr != computed_column);
   visible_columns->insert(computed_column->column());
   return ::zetasql_base::OkStatus();
@@ -556,7 +564,7 @@ zetasql_base::Status Validator::AddColumnFromComputedColumn(
 zetasql_base::Status Validator::AddColumnsFromComputedColumnList(
     const std::vector<std::unique_ptr<const ResolvedComputedColumn>>&
         computed_column_list,
-    std::set<ResolvedColumn>* visible_columns) const {
+    ResolvedColumnSet* visible_columns) const {
   ZETASQL_RET_CHECK(nullptr != visible_columns);
   for (const auto& computed_column : computed_column_list) {
     ZETASQL_RETURN_IF_ERROR(AddColumnFromComputedColumn(computed_column.get(),
@@ -567,7 +575,7 @@ zetasql_base::Status Validator::AddColumnsFromComputedColumnList(
 
 zetasql_base::Status Validator::ValidateResolvedTableScan(
     const ResolvedTableScan* scan,
-    const std::set<ResolvedColumn>& visible_parameters) const {
+    const ResolvedColumnSet& visible_parameters) const {
 
   const Table* table = scan->table();
   ZETASQL_RET_CHECK(nullptr != table);
@@ -606,25 +614,29 @@ zetasql_base::Status Validator::ValidateResolvedTableScan(
 
 zetasql_base::Status Validator::ValidateResolvedJoinScan(
     const ResolvedJoinScan* scan,
-    const std::set<ResolvedColumn>& visible_parameters) const {
+    const ResolvedColumnSet& visible_parameters) const {
 
   ZETASQL_RET_CHECK(nullptr != scan->left_scan());
   ZETASQL_RETURN_IF_ERROR(ValidateResolvedScan(scan->left_scan(), visible_parameters));
   ZETASQL_RET_CHECK(nullptr != scan->right_scan());
   ZETASQL_RETURN_IF_ERROR(ValidateResolvedScan(scan->right_scan(), visible_parameters));
 
-  std::set<ResolvedColumn> left_visible_columns, right_visible_columns;
+  ResolvedColumnSet left_visible_columns, right_visible_columns;
   ZETASQL_RETURN_IF_ERROR(
       AddColumnList(scan->left_scan()->column_list(), &left_visible_columns));
   ZETASQL_RETURN_IF_ERROR(
       AddColumnList(scan->right_scan()->column_list(), &right_visible_columns));
   // Both left and right scans should not have any common column references
   // introduced in the visible set for the on_condition.
-  ZETASQL_RET_CHECK(!zetasql_base::SortedContainersHaveIntersection(left_visible_columns,
-                                                   right_visible_columns));
+  for (const ResolvedColumn& column : right_visible_columns) {
+    ZETASQL_RET_CHECK(!zetasql_base::ContainsKey(left_visible_columns, column))
+        << "Column " << column.DebugString()
+        << " is visible from both sides of a JoinScan";
+  }
 
-  const std::set<ResolvedColumn> visible_columns =
-      zetasql_base::STLSetUnion(left_visible_columns, right_visible_columns);
+  ResolvedColumnSet visible_columns = std::move(left_visible_columns);
+  visible_columns.insert(right_visible_columns.begin(),
+                         right_visible_columns.end());
   if (nullptr != scan->join_expr()) {
     ZETASQL_RETURN_IF_ERROR(ValidateResolvedExpr(visible_columns, visible_parameters,
                                          scan->join_expr()));
@@ -639,9 +651,9 @@ zetasql_base::Status Validator::ValidateResolvedJoinScan(
 
 zetasql_base::Status Validator::ValidateResolvedArrayScan(
     const ResolvedArrayScan* scan,
-    const std::set<ResolvedColumn>& visible_parameters) const {
+    const ResolvedColumnSet& visible_parameters) const {
 
-  std::set<ResolvedColumn> visible_columns;
+  ResolvedColumnSet visible_columns;
   if (nullptr != scan->input_scan()) {
     ZETASQL_RETURN_IF_ERROR(ValidateResolvedScan(scan->input_scan(),
                                          visible_parameters));
@@ -672,12 +684,12 @@ zetasql_base::Status Validator::ValidateResolvedArrayScan(
 
 zetasql_base::Status Validator::ValidateResolvedFilterScan(
     const ResolvedFilterScan* scan,
-    const std::set<ResolvedColumn>& visible_parameters) const {
+    const ResolvedColumnSet& visible_parameters) const {
 
   ZETASQL_RET_CHECK(nullptr != scan->input_scan());
   ZETASQL_RETURN_IF_ERROR(ValidateResolvedScan(scan->input_scan(), visible_parameters));
 
-  std::set<ResolvedColumn> visible_columns;
+  ResolvedColumnSet visible_columns;
   ZETASQL_RETURN_IF_ERROR(
       AddColumnList(scan->input_scan()->column_list(), &visible_columns));
   ZETASQL_RET_CHECK(nullptr != scan->filter_expr());
@@ -693,8 +705,8 @@ zetasql_base::Status Validator::ValidateResolvedFilterScan(
 
 zetasql_base::Status Validator::ValidateResolvedAggregateComputedColumn(
     const ResolvedComputedColumn* computed_column,
-    const std::set<ResolvedColumn>& input_scan_visible_columns,
-    const std::set<ResolvedColumn>& visible_parameters) const {
+    const ResolvedColumnSet& input_scan_visible_columns,
+    const ResolvedColumnSet& visible_parameters) const {
   ZETASQL_RET_CHECK_EQ(computed_column->expr()->node_kind(),
                RESOLVED_AGGREGATE_FUNCTION_CALL);
   const ResolvedAggregateFunctionCall* aggregate_function_call =
@@ -735,8 +747,8 @@ zetasql_base::Status Validator::ValidateResolvedAggregateComputedColumn(
 
 zetasql_base::Status Validator::ValidateResolvedAggregateScanBase(
     const ResolvedAggregateScanBase* scan,
-    const std::set<ResolvedColumn>& visible_parameters,
-    std::set<ResolvedColumn>* input_scan_visible_columns) const {
+    const ResolvedColumnSet& visible_parameters,
+    ResolvedColumnSet* input_scan_visible_columns) const {
 
   ZETASQL_RET_CHECK(nullptr != scan->input_scan());
   ZETASQL_RETURN_IF_ERROR(ValidateResolvedScan(scan->input_scan(), visible_parameters));
@@ -753,9 +765,9 @@ zetasql_base::Status Validator::ValidateResolvedAggregateScanBase(
 
 zetasql_base::Status Validator::ValidateResolvedAggregateScan(
     const ResolvedAggregateScan* scan,
-    const std::set<ResolvedColumn>& visible_parameters) const {
+    const ResolvedColumnSet& visible_parameters) const {
 
-  std::set<ResolvedColumn> input_scan_visible_columns;
+  ResolvedColumnSet input_scan_visible_columns;
   ZETASQL_RETURN_IF_ERROR(ValidateResolvedAggregateScanBase(
       scan, visible_parameters, &input_scan_visible_columns));
 
@@ -765,7 +777,7 @@ zetasql_base::Status Validator::ValidateResolvedAggregateScan(
     ZETASQL_RET_CHECK_EQ(scan->grouping_set_list_size(),
                  scan->rollup_column_list_size() + 1);
 
-    std::set<ResolvedColumn> group_by_columns;
+    ResolvedColumnSet group_by_columns;
     for (const auto& group_by_column : scan->group_by_list()) {
       group_by_columns.insert(group_by_column->column());
     }
@@ -773,7 +785,7 @@ zetasql_base::Status Validator::ValidateResolvedAggregateScan(
     // group_by_columns should be non-empty, and each item in the rollup list or
     // a grouping set should be a computed column from group_by_columns.
     ZETASQL_RET_CHECK(!group_by_columns.empty());
-    std::set<ResolvedColumn> rollup_columns;
+    ResolvedColumnSet rollup_columns;
     for (const auto& column_ref : scan->rollup_column_list()) {
       ZETASQL_RETURN_IF_ERROR(CheckColumnIsPresentInColumnSet(column_ref->column(),
                                                       group_by_columns));
@@ -788,7 +800,7 @@ zetasql_base::Status Validator::ValidateResolvedAggregateScan(
 
     for (const auto& grouping_set : scan->grouping_set_list()) {
       // Columns should be unique within each grouping set.
-      std::set<ResolvedColumn> grouping_set_columns;
+      ResolvedColumnSet grouping_set_columns;
       for (const auto& column_ref : grouping_set->group_by_column_list()) {
         ZETASQL_RETURN_IF_ERROR(CheckColumnIsPresentInColumnSet(column_ref->column(),
                                                         group_by_columns));
@@ -801,7 +813,7 @@ zetasql_base::Status Validator::ValidateResolvedAggregateScan(
     ZETASQL_RET_CHECK(scan->rollup_column_list().empty());
   }
 
-  std::set<ResolvedColumn> visible_columns;
+  ResolvedColumnSet visible_columns;
   ZETASQL_RETURN_IF_ERROR(AddColumnsFromComputedColumnList(
       scan->group_by_list(), &visible_columns));
   ZETASQL_RETURN_IF_ERROR(AddColumnsFromComputedColumnList(
@@ -849,7 +861,7 @@ static zetasql_base::Status ValidatePercentArgument(const ResolvedExpr* expr) {
 
 zetasql_base::Status Validator::ValidateResolvedSampleScan(
     const ResolvedSampleScan* scan,
-    const std::set<ResolvedColumn>& visible_parameters) const {
+    const ResolvedColumnSet& visible_parameters) const {
 
   ZETASQL_RET_CHECK(nullptr != scan->input_scan());
   ZETASQL_RETURN_IF_ERROR(ValidateResolvedScan(scan->input_scan(), visible_parameters));
@@ -870,7 +882,7 @@ zetasql_base::Status Validator::ValidateResolvedSampleScan(
         ValidateArgumentIsInt64Constant(scan->repeatable_argument()));
   }
 
-  std::set<ResolvedColumn> visible_columns;
+  ResolvedColumnSet visible_columns;
   ZETASQL_RETURN_IF_ERROR(
       AddColumnList(scan->input_scan()->column_list(), &visible_columns));
   if (nullptr != scan->weight_column()) {
@@ -892,12 +904,12 @@ zetasql_base::Status Validator::ValidateResolvedSampleScan(
 
 zetasql_base::Status Validator::ValidateResolvedAnalyticScan(
     const ResolvedAnalyticScan* scan,
-    const std::set<ResolvedColumn>& visible_parameters) const {
+    const ResolvedColumnSet& visible_parameters) const {
 
   ZETASQL_RET_CHECK(nullptr != scan->input_scan());
   ZETASQL_RETURN_IF_ERROR(ValidateResolvedScan(scan->input_scan(), visible_parameters));
 
-  std::set<ResolvedColumn> visible_columns;
+  ResolvedColumnSet visible_columns;
   ZETASQL_RETURN_IF_ERROR(AddColumnList(scan->input_scan()->column_list(),
                                 &visible_columns));
 
@@ -919,8 +931,8 @@ zetasql_base::Status Validator::ValidateResolvedAnalyticScan(
 
 zetasql_base::Status Validator::ValidateResolvedAnalyticFunctionGroup(
     const ResolvedAnalyticFunctionGroup* group,
-    const std::set<ResolvedColumn>& input_visible_columns,
-    const std::set<ResolvedColumn>& visible_parameters) const {
+    const ResolvedColumnSet& input_visible_columns,
+    const ResolvedColumnSet& visible_parameters) const {
 
   for (const auto& computed_column : group->analytic_function_list()) {
     const ResolvedAnalyticFunctionCall* analytic_function_call =
@@ -1038,8 +1050,8 @@ zetasql_base::Status Validator::ValidateResolvedAnalyticFunctionGroup(
 }
 
 zetasql_base::Status Validator::ValidateResolvedWindowFrame(
-    const std::set<ResolvedColumn>& visible_columns,
-    const std::set<ResolvedColumn>& visible_parameters,
+    const ResolvedColumnSet& visible_columns,
+    const ResolvedColumnSet& visible_parameters,
     const ResolvedWindowOrdering* window_ordering,
     const ResolvedWindowFrame* window_frame) const {
   ZETASQL_RET_CHECK(window_frame->start_expr() != nullptr &&
@@ -1073,8 +1085,8 @@ zetasql_base::Status Validator::ValidateResolvedWindowFrame(
 }
 
 zetasql_base::Status Validator::ValidateResolvedWindowFrameExpr(
-    const std::set<ResolvedColumn>& visible_columns,
-    const std::set<ResolvedColumn>& visible_parameters,
+    const ResolvedColumnSet& visible_columns,
+    const ResolvedColumnSet& visible_parameters,
     const ResolvedWindowOrdering* window_ordering,
     const ResolvedWindowFrame::FrameUnit& frame_unit,
     const ResolvedWindowFrameExpr* window_frame_expr) const {
@@ -1167,7 +1179,7 @@ zetasql_base::Status Validator::ValidateResolvedWindowFrameExprType(
 
 zetasql_base::Status Validator::ValidateResolvedSetOperationScan(
     const ResolvedSetOperationScan* set_op_scan,
-    const std::set<ResolvedColumn>& visible_parameters) const {
+    const ResolvedColumnSet& visible_parameters) const {
 
   ZETASQL_RET_CHECK_GE(set_op_scan->input_item_list_size(), 2);
 
@@ -1175,7 +1187,7 @@ zetasql_base::Status Validator::ValidateResolvedSetOperationScan(
     const ResolvedScan* input_scan = input_item->scan();
     ZETASQL_RETURN_IF_ERROR(ValidateResolvedScan(input_scan, visible_parameters));
 
-    const std::set<ResolvedColumn> produced_columns(
+    const ResolvedColumnSet produced_columns(
         input_scan->column_list().begin(), input_scan->column_list().end());
 
     // <set_op_scan>'s output <column_list> matches 1:1 with the
@@ -1230,7 +1242,7 @@ zetasql_base::Status Validator::ValidateArgumentIsInt64Constant(
 
 zetasql_base::Status Validator::ValidateResolvedLimitOffsetScan(
     const ResolvedLimitOffsetScan* scan,
-    const std::set<ResolvedColumn>& visible_parameters) const {
+    const ResolvedColumnSet& visible_parameters) const {
 
   ZETASQL_RET_CHECK(scan->limit() != nullptr);
   ZETASQL_RETURN_IF_ERROR(ValidateArgumentIsInt64Constant(scan->limit()));
@@ -1247,12 +1259,12 @@ zetasql_base::Status Validator::ValidateResolvedLimitOffsetScan(
 
 zetasql_base::Status Validator::ValidateResolvedProjectScan(
     const ResolvedProjectScan* scan,
-    const std::set<ResolvedColumn>& visible_parameters) const {
+    const ResolvedColumnSet& visible_parameters) const {
 
   ZETASQL_RET_CHECK(nullptr != scan->input_scan());
   ZETASQL_RETURN_IF_ERROR(ValidateResolvedScan(scan->input_scan(), visible_parameters));
 
-  std::set<ResolvedColumn> visible_columns;
+  ResolvedColumnSet visible_columns;
   ZETASQL_RETURN_IF_ERROR(
       AddColumnList(scan->input_scan()->column_list(), &visible_columns));
   ZETASQL_RETURN_IF_ERROR(
@@ -1267,7 +1279,7 @@ zetasql_base::Status Validator::ValidateResolvedProjectScan(
 
 zetasql_base::Status Validator::ValidateResolvedTVFScan(
     const ResolvedTVFScan* resolved_tvf_scan,
-    const std::set<ResolvedColumn>& visible_parameters) const {
+    const ResolvedColumnSet& visible_parameters) const {
   ZETASQL_RET_CHECK_EQ(resolved_tvf_scan->argument_list_size(),
                resolved_tvf_scan->signature()->input_arguments().size());
   for (int arg_idx = 0; arg_idx < resolved_tvf_scan->argument_list_size();
@@ -1332,7 +1344,7 @@ zetasql_base::Status Validator::ValidateResolvedTVFScan(
 
 zetasql_base::Status Validator::ValidateResolvedRelationArgumentScan(
     const ResolvedRelationArgumentScan* arg_ref,
-    const std::set<ResolvedColumn>& visible_parameters) const {
+    const ResolvedColumnSet& visible_parameters) const {
   // If we're currently validating a ResolvedCreateTableFunctionStmt, find the
   // argument in the current CREATE TABLE FUNCTION statement with the same name
   // as 'arg_ref'.
@@ -1349,7 +1361,7 @@ zetasql_base::Status Validator::ValidateResolvedRelationArgumentScan(
 
 zetasql_base::Status Validator::ValidateResolvedWithScan(
     const ResolvedWithScan* scan,
-    const std::set<ResolvedColumn>& visible_parameters) const {
+    const ResolvedColumnSet& visible_parameters) const {
 
   // The main query can be correlated. The aliased subqueries cannot.
   ZETASQL_RET_CHECK(nullptr != scan->query());
@@ -1357,11 +1369,17 @@ zetasql_base::Status Validator::ValidateResolvedWithScan(
 
   for (const auto& with_entry : scan->with_entry_list()) {
     ZETASQL_RET_CHECK(nullptr != with_entry);
-    ZETASQL_RETURN_IF_ERROR(ValidateResolvedScan(with_entry->with_subquery(),
-                                         {} /* visible_parameters */));
+  }
+  if (num_threads_ > 1 && scan->with_entry_list_size() > 1) {
+    ZETASQL_RETURN_IF_ERROR(ValidateWithEntriesInParallel(scan));
+  } else {
+    for (const auto& with_entry : scan->with_entry_list()) {
+      ZETASQL_RETURN_IF_ERROR(ValidateResolvedScan(with_entry->with_subquery(),
+                                           {} /* visible_parameters */));
+    }
   }
 
-  std::set<ResolvedColumn> visible_columns;
+  ResolvedColumnSet visible_columns;
   ZETASQL_RETURN_IF_ERROR(
       AddColumnList(scan->query()->column_list(), &visible_columns));
   ZETASQL_RETURN_IF_ERROR(CheckColumnList(scan, visible_columns));
@@ -1369,6 +1387,54 @@ zetasql_base::Status Validator::ValidateResolvedWithScan(
   return ::zetasql_base::OkStatus();
 }
 
+zetasql_base::Status Validator::ValidateWithEntriesInParallel(
+    const ResolvedWithScan* scan) const {
+  const int num_entries = scan->with_entry_list_size();
+  std::vector<zetasql_base::Status> statuses(num_entries);
+
+  // Entries are handed out in order from <next_entry>.  Each thread uses its
+  // own Validator, since the scoped state in a Validator is not thread-safe.
+  // Entries after a failing entry are skipped, since only the first error
+  // is returned.
+  std::atomic<int> next_entry(0);
+  std::atomic<int> first_error(num_entries);
+  auto worker = [&]() {
+    Validator validator(language_options_);
+    validator.allowed_argument_kinds_ = allowed_argument_kinds_;
+    validator.current_create_table_function_stmt_ =
+        current_create_table_function_stmt_;
+    while (true) {
+      const int index = next_entry.fetch_add(1);
+      if (index >= num_entries || index > first_error.load()) return;
+      statuses[index] = validator.ValidateResolvedScan(
+          scan->with_entry_list(index)->with_subquery(),
+          {} /* visible_parameters */);
+      if (!statuses[index].ok()) {
+        int current = first_error.load();
+        while (index < current &&
+               !first_error.compare_exchange_weak(current, index)) {
+        }
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  const int num_threads = std::min(num_threads_, num_entries);
+  threads.reserve(num_threads - 1);
+  for (int i = 1; i < num_threads; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  if (first_error.load() < num_entries) {
+    return statuses[first_error.load()];
+  }
+  return ::zetasql_base::OkStatus();
+}
+
 zetasql_base::Status Validator::ValidateResolvedStatement(
     const ResolvedStatement* statement) {
   ZETASQL_RET_CHECK(nullptr != statement);
@@ -1589,7 +1655,7 @@ zetasql_base::Status Validator::ValidateResolvedIndexStmt(
   ZETASQL_RETURN_IF_ERROR(ValidateHintList(stmt->option_list()));
 
   ZETASQL_RET_CHECK(stmt->table_scan() != nullptr);
-  std::set<ResolvedColumn> visible_columns;
+  ResolvedColumnSet visible_columns;
   ZETASQL_RETURN_IF_ERROR(AddColumnList(stmt->table_scan()->column_list(),
                                 &visible_columns));
 
@@ -1631,7 +1697,7 @@ zetasql_base::Status Validator::ValidateResolvedCreateTableStmtBase(
     const ResolvedCreateTableStmtBase* stmt) const {
   ZETASQL_RETURN_IF_ERROR(ValidateHintList(stmt->option_list()));
   // Build the list of visible_columns.
-  std::set<ResolvedColumn> visible_columns;
+  ResolvedColumnSet visible_columns;
   for (const auto& column_definition : stmt->column_definition_list()) {
     if (!zetasql_base::InsertIfNotPresent(&visible_columns,
                                  column_definition->column())) {
@@ -1765,7 +1831,7 @@ zetasql_base::Status Validator::ValidateResolvedCreateTableStmt(
 
 zetasql_base::Status Validator::ValidateResolvedGeneratedColumnInfo(
     const ResolvedColumnDefinition* column_definition,
-    const std::set<ResolvedColumn>& visible_columns) const {
+    const ResolvedColumnSet& visible_columns) const {
   const ResolvedGeneratedColumnInfo* generated_column_info =
       column_definition->generated_column_info();
   ZETASQL_RET_CHECK(generated_column_info->expression() != nullptr);
@@ -1863,7 +1929,7 @@ zetasql_base::Status Validator::ValidateResolvedCreateRowPolicyStmt(
     const ResolvedCreateRowPolicyStmt* stmt) const {
 
   ZETASQL_RET_CHECK(stmt->table_scan() != nullptr);
-  std::set<ResolvedColumn> visible_columns;
+  ResolvedColumnSet visible_columns;
   ZETASQL_RETURN_IF_ERROR(
       AddColumnList(stmt->table_scan()->column_list(), &visible_columns));
 
@@ -1915,7 +1981,7 @@ zetasql_base::Status Validator::ValidateResolvedCreateFunctionStmt(
 
   // For non-aggregates, no columns are visible.  For aggregates, columns
   // created by the aggregate expressions are visible.
-  std::set<ResolvedColumn> visible_columns;
+  ResolvedColumnSet visible_columns;
 
   if (!stmt->aggregate_expression_list().empty()) {
     ZETASQL_RET_CHECK(stmt->is_aggregate());
@@ -2153,12 +2219,12 @@ zetasql_base::Status Validator::ValidateResolvedRevokeStmt(
 
 zetasql_base::Status Validator::ValidateResolvedOrderByScan(
     const ResolvedOrderByScan* scan,
-    const std::set<ResolvedColumn>& visible_parameters) const {
+    const ResolvedColumnSet& visible_parameters) const {
 
   ZETASQL_RET_CHECK(nullptr != scan->input_scan());
   ZETASQL_RETURN_IF_ERROR(ValidateResolvedScan(scan->input_scan(), visible_parameters));
 
-  std::set<ResolvedColumn> visible_columns;
+  ResolvedColumnSet visible_columns;
   ZETASQL_RETURN_IF_ERROR(
       AddColumnList(scan->input_scan()->column_list(), &visible_columns));
   for (const auto& order_by_item : scan->order_by_item_list()) {
@@ -2182,7 +2248,7 @@ zetasql_base::Status Validator::ValidateResolvedQueryStmt(
 
 zetasql_base::Status Validator::ValidateResolvedScan(
     const ResolvedScan* scan,
-    const std::set<ResolvedColumn>& visible_parameters) const {
+    const ResolvedColumnSet& visible_parameters) const {
   ZETASQL_RET_CHECK(nullptr != scan);
 
   switch (scan->node_kind()) {
@@ -2333,7 +2399,7 @@ template <class STMT>
 zetasql_base::Status Validator::ValidateResolvedDMLStmt(
     const STMT* stmt,
     const ResolvedColumn* array_element_column,
-    std::set<ResolvedColumn>* visible_columns) const {
+    ResolvedColumnSet* visible_columns) const {
   visible_columns->clear();
   ZETASQL_RETURN_IF_ERROR(ValidateHintList(stmt->hint_list()));
 
@@ -2364,9 +2430,9 @@ zetasql_base::Status Validator::ValidateResolvedDMLStmt(
 
 zetasql_base::Status Validator::ValidateResolvedInsertStmt(
     const ResolvedInsertStmt* stmt,
-    const std::set<ResolvedColumn>* outer_visible_columns,
+    const ResolvedColumnSet* outer_visible_columns,
     const ResolvedColumn* array_element_column) const {
-  std::set<ResolvedColumn> visible_columns;
+  ResolvedColumnSet visible_columns;
   ZETASQL_RETURN_IF_ERROR(ValidateResolvedDMLStmt(stmt, array_element_column,
                                           &visible_columns));
 
@@ -2404,7 +2470,7 @@ zetasql_base::Status Validator::ValidateResolvedInsertStmt(
     ZETASQL_RET_CHECK_EQ(stmt->row_list_size(), 0)
         << "INSERT has both query and VALUES";
 
-    std::set<ResolvedColumn> visible_parameters;
+    ResolvedColumnSet visible_parameters;
     for (const std::unique_ptr<const ResolvedColumnRef>& parameter :
          stmt->query_parameter_list()) {
       ZETASQL_RETURN_IF_ERROR(ValidateResolvedExpr(visible_columns,
@@ -2415,7 +2481,7 @@ zetasql_base::Status Validator::ValidateResolvedInsertStmt(
 
     ZETASQL_RETURN_IF_ERROR(ValidateResolvedScan(stmt->query(), visible_parameters));
 
-    const std::set<ResolvedColumn> produced_columns(
+    const ResolvedColumnSet produced_columns(
         stmt->query()->column_list().begin(),
         stmt->query()->column_list().end());
 
@@ -2453,9 +2519,9 @@ zetasql_base::Status Validator::ValidateResolvedInsertStmt(
 
 zetasql_base::Status Validator::ValidateResolvedDeleteStmt(
     const ResolvedDeleteStmt* stmt,
-    const std::set<ResolvedColumn>* outer_visible_columns,
+    const ResolvedColumnSet* outer_visible_columns,
     const ResolvedColumn* array_element_column) const {
-  std::set<ResolvedColumn> visible_columns;
+  ResolvedColumnSet visible_columns;
   ZETASQL_RETURN_IF_ERROR(ValidateResolvedDMLStmt(stmt, array_element_column,
                                           &visible_columns));
   if (outer_visible_columns != nullptr) {
@@ -2503,9 +2569,9 @@ zetasql_base::Status Validator::CheckExprIsPath(const ResolvedExpr* expr,
 
 zetasql_base::Status Validator::ValidateResolvedUpdateStmt(
     const ResolvedUpdateStmt* stmt,
-    const std::set<ResolvedColumn>* outer_visible_columns,
+    const ResolvedColumnSet* outer_visible_columns,
     const ResolvedColumn* array_element_column) const {
-  std::set<ResolvedColumn> target_visible_columns;
+  ResolvedColumnSet target_visible_columns;
   ZETASQL_RETURN_IF_ERROR(ValidateResolvedDMLStmt(stmt, array_element_column,
                                           &target_visible_columns));
 
@@ -2521,7 +2587,7 @@ zetasql_base::Status Validator::ValidateResolvedUpdateStmt(
     ZETASQL_RET_CHECK_EQ(stmt->column_access_list().size(), 0);
   }
 
-  std::set<ResolvedColumn> all_visible_columns(target_visible_columns);
+  ResolvedColumnSet all_visible_columns(target_visible_columns);
   if (stmt->from_scan() != nullptr) {
     ZETASQL_RETURN_IF_ERROR(ValidateResolvedScan(stmt->from_scan(),
                                          {} /* visible_parameters */));
@@ -2558,8 +2624,8 @@ zetasql_base::Status Validator::ValidateResolvedUpdateStmt(
 zetasql_base::Status Validator::ValidateResolvedUpdateItem(
     const ResolvedUpdateItem* item, bool allow_nested_statements,
     const ResolvedColumn* array_element_column,
-    const std::set<ResolvedColumn>& target_visible_columns,
-    const std::set<ResolvedColumn>& offset_and_where_visible_columns) const {
+    const ResolvedColumnSet& target_visible_columns,
+    const ResolvedColumnSet& offset_and_where_visible_columns) const {
 
   ZETASQL_RET_CHECK(item->target() != nullptr);
   ZETASQL_RETURN_IF_ERROR(ValidateResolvedExpr(
@@ -2641,14 +2707,14 @@ zetasql_base::Status Validator::ValidateResolvedUpdateItem(
 
 zetasql_base::Status Validator::ValidateResolvedUpdateArrayItem(
     const ResolvedUpdateArrayItem* item, const ResolvedColumn& element_column,
-    const std::set<ResolvedColumn>& target_visible_columns,
-    const std::set<ResolvedColumn>& offset_and_where_visible_columns) const {
+    const ResolvedColumnSet& target_visible_columns,
+    const ResolvedColumnSet& offset_and_where_visible_columns) const {
   ZETASQL_RETURN_IF_ERROR(ValidateResolvedExpr(offset_and_where_visible_columns,
                                        /*visible_parameters=*/{},
                                        item->offset()));
   ZETASQL_RET_CHECK_EQ(item->offset()->type()->kind(), TYPE_INT64);
 
-  std::set<ResolvedColumn> child_target_visible_columns(target_visible_columns);
+  ResolvedColumnSet child_target_visible_columns(target_visible_columns);
   child_target_visible_columns.insert(element_column);
   // We don't allow [] in the target of a nested DML statement, and
   // gen_resolved_ast.py documents that a ResolvedUpdateItem child of a
@@ -2662,10 +2728,10 @@ zetasql_base::Status Validator::ValidateResolvedUpdateArrayItem(
 
 zetasql_base::Status Validator::ValidateResolvedMergeWhen(
     const ResolvedMergeWhen* merge_when,
-    const std::set<ResolvedColumn>& all_visible_columns,
-    const std::set<ResolvedColumn>& source_visible_columns,
-    const std::set<ResolvedColumn>& target_visible_columns) const {
-  const std::set<ResolvedColumn>* visible_columns = nullptr;
+    const ResolvedColumnSet& all_visible_columns,
+    const ResolvedColumnSet& source_visible_columns,
+    const ResolvedColumnSet& target_visible_columns) const {
+  const ResolvedColumnSet* visible_columns = nullptr;
   switch (merge_when->match_type()) {
     // For WHEN MATCHED and WHEN NOT MATCHED BY SOURCE clauses, only UPDATE and
     // DELETE are allowed.
@@ -2741,21 +2807,22 @@ zetasql_base::Status Validator::ValidateResolvedMergeStmt(
   ZETASQL_RET_CHECK_NE(nullptr, stmt->table_scan());
   ZETASQL_RETURN_IF_ERROR(
       ValidateResolvedScan(stmt->table_scan(), {} /* visible_parameters */));
-  std::set<ResolvedColumn> target_visible_columns;
+  ResolvedColumnSet target_visible_columns;
   ZETASQL_RETURN_IF_ERROR(AddColumnList(stmt->table_scan()->column_list(),
                                 &target_visible_columns));
   ZETASQL_RET_CHECK_EQ(stmt->table_scan()->column_index_list().size(),
                stmt->column_access_list().size());
 
   ZETASQL_RET_CHECK_NE(nullptr, stmt->from_scan());
-  std::set<ResolvedColumn> source_visible_columns;
+  ResolvedColumnSet source_visible_columns;
   ZETASQL_RETURN_IF_ERROR(
       ValidateResolvedScan(stmt->from_scan(), {} /* visible_parameters */));
   ZETASQL_RETURN_IF_ERROR(
       AddColumnList(stmt->from_scan()->column_list(), &source_visible_columns));
 
-  std::set<ResolvedColumn> all_visible_columns =
-      zetasql_base::STLSetUnion(source_visible_columns, target_visible_columns);
+  ResolvedColumnSet all_visible_columns = source_visible_columns;
+  all_visible_columns.insert(target_visible_columns.begin(),
+                             target_visible_columns.end());
   if (nullptr != stmt->merge_expr()) {
     ZETASQL_RETURN_IF_ERROR(ValidateResolvedExpr(
         all_visible_columns, {} /* visible_parameters */, stmt->merge_expr()));
@@ -2784,7 +2851,7 @@ zetasql_base::Status Validator::ValidateResolvedAlterRowPolicyStmt(
   bool has_new_name = !stmt->new_name().empty();
 
   ZETASQL_RET_CHECK(stmt->table_scan() != nullptr);
-  std::set<ResolvedColumn> visible_columns;
+  ResolvedColumnSet visible_columns;
   ZETASQL_RETURN_IF_ERROR(
       AddColumnList(stmt->table_scan()->column_list(), &visible_columns));
 
@@ -2860,7 +2927,7 @@ zetasql_base::Status Validator::ValidateResolvedAssertStmt(
 }
 
 zetasql_base::Status Validator::ValidateResolvedTVFArgument(
-    const std::set<ResolvedColumn>& visible_parameters,
+    const ResolvedColumnSet& visible_parameters,
     const ResolvedTVFArgument* resolved_tvf_arg) const {
   ZETASQL_RET_CHECK(resolved_tvf_arg != nullptr);
   if (resolved_tvf_arg->expr() != nullptr) {
@@ -2889,7 +2956,7 @@ zetasql_base::Status Validator::ValidateResolvedTVFArgument(
         ValidateResolvedScan(resolved_tvf_arg->scan(), visible_parameters));
     // Verify that columns in <argument_column_list> are actually available
     // in <scan>.
-    const std::set<ResolvedColumn> produced_columns(
+    const ResolvedColumnSet produced_columns(
         resolved_tvf_arg->scan()->column_list().begin(),
         resolved_tvf_arg->scan()->column_list().end());
     for (const ResolvedColumn& argument_column :
@@ -19,7 +19,6 @@
 
 #include <functional>
 #include <memory>
-#include <set>
 #include <vector>
 
 #include "zetasql/public/language_options.h"
@@ -40,6 +39,11 @@ class Validator {
  public:
   Validator();
   explicit Validator(const LanguageOptions& language_options);
+  // Validates the WITH entries of each WITH clause in parallel, using up to
+  // <num_threads> threads.  WITH entries cannot be correlated, so they are
+  // independent of each other and of the rest of the query.  Errors are
+  // the same as with sequential validation.
+  Validator(const LanguageOptions& language_options, int num_threads);
   Validator(const Validator&) = delete;
   Validator& operator=(const Validator&) = delete;
   ~Validator();
@@ -49,8 +53,14 @@ class Validator {
   zetasql_base::Status ValidateStandaloneResolvedExpr(const ResolvedExpr* expr) const;
 
  private:
+  // Visible columns and parameters, keyed by column id.
+  typedef absl::flat_hash_set<ResolvedColumn> ResolvedColumnSet;
+
   const LanguageOptions language_options_;
 
+  // Maximum number of threads used to validate WITH entries.
+  const int num_threads_ = 1;
+
   // Statements.
   zetasql_base::Status ValidateResolvedQueryStmt(const ResolvedQueryStmt* query) const;
   zetasql_base::Status ValidateResolvedCreateDatabaseStmt(
@@ -63,7 +73,7 @@ class Validator {
       const ResolvedCreateTableStmt* stmt) const;
   zetasql_base::Status ValidateResolvedGeneratedColumnInfo(
       const ResolvedColumnDefinition* column_definition,
-      const std::set<ResolvedColumn>& visible_columns) const;
+      const ResolvedColumnSet& visible_columns) const;
   zetasql_base::Status ValidateResolvedCreateTableAsSelectStmt(
       const ResolvedCreateTableAsSelectStmt* stmt) const;
   zetasql_base::Status ValidateResolvedCreateViewStmt(
@@ -130,15 +140,15 @@ class Validator {
   // <outer_visible_columns>.
   zetasql_base::Status ValidateResolvedInsertStmt(
       const ResolvedInsertStmt* stmt,
-      const std::set<ResolvedColumn>* outer_visible_columns = nullptr,
+      const ResolvedColumnSet* outer_visible_columns = nullptr,
       const ResolvedColumn* array_element_column = nullptr) const;
   zetasql_base::Status ValidateResolvedDeleteStmt(
       const ResolvedDeleteStmt* stmt,
-      const std::set<ResolvedColumn>* outer_visible_columns = nullptr,
+      const ResolvedColumnSet* outer_visible_columns = nullptr,
       const ResolvedColumn* array_element_column = nullptr) const;
   zetasql_base::Status ValidateResolvedUpdateStmt(
       const ResolvedUpdateStmt* stmt,
-      const std::set<ResolvedColumn>* outer_visible_columns = nullptr,
+      const ResolvedColumnSet* outer_visible_columns = nullptr,
       const ResolvedColumn* array_element_column = nullptr) const;
 
   // Can occur as a child of a ResolvedUpdateStmt or a
@@ -148,15 +158,15 @@ class Validator {
   zetasql_base::Status ValidateResolvedUpdateItem(
       const ResolvedUpdateItem* item, bool allow_nested_statements,
       const ResolvedColumn* array_element_column,
-      const std::set<ResolvedColumn>& target_visible_columns,
-      const std::set<ResolvedColumn>& offset_and_where_visible_columns) const;
+      const ResolvedColumnSet& target_visible_columns,
+      const ResolvedColumnSet& offset_and_where_visible_columns) const;
 
   // <element_column> is not in <target_visible_columns> or
   // <offset_and_where_visible_columns>
   zetasql_base::Status ValidateResolvedUpdateArrayItem(
       const ResolvedUpdateArrayItem* item, const ResolvedColumn& element_column,
-      const std::set<ResolvedColumn>& target_visible_columns,
-      const std::set<ResolvedColumn>& offset_and_where_visible_columns) const;
+      const ResolvedColumnSet& target_visible_columns,
+      const ResolvedColumnSet& offset_and_where_visible_columns) const;
 
   // Merge statement is not supported in nested-DML.
   zetasql_base::Status ValidateResolvedMergeStmt(const ResolvedMergeStmt* stmt) const;
@@ -166,64 +176,64 @@ class Validator {
   // parameter to avoid re-computing every time.
   zetasql_base::Status ValidateResolvedMergeWhen(
       const ResolvedMergeWhen* merge_when,
-      const std::set<ResolvedColumn>& all_visible_columns,
-      const std::set<ResolvedColumn>& source_visible_columns,
-      const std::set<ResolvedColumn>& target_visible_columns) const;
+      const ResolvedColumnSet& all_visible_columns,
+      const ResolvedColumnSet& source_visible_columns,
+      const ResolvedColumnSet& target_visible_columns) const;
 
   // Templated common code for all DML statements.
   template <class STMT>
   zetasql_base::Status ValidateResolvedDMLStmt(
       const STMT* stmt,
       const ResolvedColumn* array_element_column,
-      std::set<ResolvedColumn>* visible_columns) const;
+      ResolvedColumnSet* visible_columns) const;
 
   // Validation calls for various subtypes of ResolvedScan operations.
   zetasql_base::Status ValidateResolvedScan(
       const ResolvedScan* scan,
-      const std::set<ResolvedColumn>& visible_parameters) const;
+      const ResolvedColumnSet& visible_parameters) const;
   zetasql_base::Status ValidateResolvedAggregateScanBase(
       const ResolvedAggregateScanBase* scan,
-      const std::set<ResolvedColumn>& visible_parameters,
-      std::set<ResolvedColumn>* input_scan_visible_columns) const;
+      const ResolvedColumnSet& visible_parameters,
+      ResolvedColumnSet* input_scan_visible_columns) const;
   zetasql_base::Status ValidateResolvedAggregateScan(
       const ResolvedAggregateScan* scan,
-      const std::set<ResolvedColumn>& visible_parameters) const;
+      const ResolvedColumnSet& visible_parameters) const;
   zetasql_base::Status ValidateResolvedTableScan(
       const ResolvedTableScan* scan,
-      const std::set<ResolvedColumn>& visible_parameters) const;
+      const ResolvedColumnSet& visible_parameters) const;
   zetasql_base::Status ValidateResolvedJoinScan(
       const ResolvedJoinScan* scan,
-      const std::set<ResolvedColumn>& visible_parameters) const;
+      const ResolvedColumnSet& visible_parameters) const;
   zetasql_base::Status ValidateResolvedArrayScan(
       const ResolvedArrayScan* scan,
-      const std::set<ResolvedColumn>& visible_parameters) const;
+      const ResolvedColumnSet& visible_parameters) const;
   zetasql_base::Status ValidateResolvedFilterScan(
       const ResolvedFilterScan* scan,
-      const std::set<ResolvedColumn>& visible_parameters) const;
+      const ResolvedColumnSet& visible_parameters) const;
   zetasql_base::Status ValidateResolvedSetOperationScan(
       const ResolvedSetOperationScan* set_op_scan,
-      const std::set<ResolvedColumn>& visible_parameters) const;
+      const ResolvedColumnSet& visible_parameters) const;
   zetasql_base::Status ValidateResolvedProjectScan(
       const ResolvedProjectScan* scan,
-      const std::set<ResolvedColumn>& visible_parameters) const;
+      const ResolvedColumnSet& visible_parameters) const;
   zetasql_base::Status ValidateResolvedTVFScan(
       const ResolvedTVFScan* resolved_tvf_scan,
-      const std::set<ResolvedColumn>& visible_parameters) const;
+      const ResolvedColumnSet& visible_parameters) const;
   zetasql_base::Status ValidateResolvedRelationArgumentScan(
       const ResolvedRelationArgumentScan* arg_ref,
-      const std::set<ResolvedColumn>& visible_parameters) const;
+      const ResolvedColumnSet& visible_parameters) const;
   zetasql_base::Status ValidateResolvedOrderByScan(
       const ResolvedOrderByScan* scan,
-      const std::set<ResolvedColumn>& visible_parameters) const;
+      const ResolvedColumnSet& visible_parameters) const;
   zetasql_base::Status ValidateResolvedLimitOffsetScan(
       const ResolvedLimitOffsetScan* scan,
-      const std::set<ResolvedColumn>& visible_parameters) const;
+      const ResolvedColumnSet& visible_parameters) const;
   zetasql_base::Status ValidateResolvedAnalyticScan(
       const ResolvedAnalyticScan* scan,
-      const std::set<ResolvedColumn>& visible_parameters) const;
+      const ResolvedColumnSet& visible_parameters) const;
   zetasql_base::Status ValidateResolvedSampleScan(
       const ResolvedSampleScan* scan,
-      const std::set<ResolvedColumn>& visible_parameters) const;
+      const ResolvedColumnSet& visible_parameters) const;
 
   // For a scan with is_ordered=true, validate that this scan can legally
   // produce ordered output.
@@ -231,50 +241,53 @@ class Validator {
 
   zetasql_base::Status ValidateResolvedWithScan(
       const ResolvedWithScan* scan,
-      const std::set<ResolvedColumn>& visible_parameters) const;
+      const ResolvedColumnSet& visible_parameters) const;
+  // Validates the WITH entries of <scan> on up to <num_threads_> threads.
+  zetasql_base::Status ValidateWithEntriesInParallel(
+      const ResolvedWithScan* scan) const;
 
   zetasql_base::Status ValidateResolvedAggregateComputedColumn(
       const ResolvedComputedColumn* computed_column,
-      const std::set<ResolvedColumn>& input_scan_visible_columns,
-      const std::set<ResolvedColumn>& visible_parameters) const;
+      const ResolvedColumnSet& input_scan_visible_columns,
+      const ResolvedColumnSet& visible_parameters) const;
 
   // Verifies that all the internal references in <expr> are present in
   // the <visible_columns> scope.
   zetasql_base::Status ValidateResolvedExpr(
-      const std::set<ResolvedColumn>& visible_columns,
-      const std::set<ResolvedColumn>& visible_parameters,
+      const ResolvedColumnSet& visible_columns,
+      const ResolvedColumnSet& visible_parameters,
       const ResolvedExpr* expr) const;
 
   zetasql_base::Status ValidateResolvedGetProtoFieldExpr(
-      const std::set<ResolvedColumn>& visible_columns,
-      const std::set<ResolvedColumn>& visible_parameters,
+      const ResolvedColumnSet& visible_columns,
+      const ResolvedColumnSet& visible_parameters,
       const ResolvedGetProtoField* get_proto_field) const;
 
   zetasql_base::Status ValidateResolvedSubqueryExpr(
-      const std::set<ResolvedColumn>& visible_columns,
-      const std::set<ResolvedColumn>& visible_parameters,
+      const ResolvedColumnSet& visible_columns,
+      const ResolvedColumnSet& visible_parameters,
       const ResolvedSubqueryExpr* resolved_subquery_expr) const;
 
   // Verifies that all the internal references in <expr_list> are present
   // in the <visible_columns> scope.
   zetasql_base::Status ValidateResolvedExprList(
-      const std::set<ResolvedColumn>& visible_columns,
-      const std::set<ResolvedColumn>& visible_parameters,
+      const ResolvedColumnSet& visible_columns,
+      const ResolvedColumnSet& visible_parameters,
       const std::vector<std::unique_ptr<const ResolvedExpr>>& expr_list) const;
 
   zetasql_base::Status ValidateResolvedComputedColumn(
-      const std::set<ResolvedColumn>& visible_columns,
-      const std::set<ResolvedColumn>& visible_parameters,
+      const ResolvedColumnSet& visible_columns,
+      const ResolvedColumnSet& visible_parameters,
       const ResolvedComputedColumn* computed_column) const;
 
   zetasql_base::Status ValidateResolvedComputedColumnList(
-      const std::set<ResolvedColumn>& visible_columns,
-      const std::set<ResolvedColumn>& visible_parameters,
+      const ResolvedColumnSet& visible_columns,
+      const ResolvedColumnSet& visible_parameters,
       const std::vector<std::unique_ptr<const ResolvedComputedColumn>>&
           computed_column_list) const;
 
   zetasql_base::Status ValidateResolvedOutputColumn(
-      const std::set<ResolvedColumn>& visible_columns,
+      const ResolvedColumnSet& visible_columns,
       const ResolvedOutputColumn* output_column) const;
 
   zetasql_base::Status ValidateResolvedOutputColumnList(
@@ -286,18 +299,18 @@ class Validator {
       const ResolvedCreateTableStmtBase* stmt) const;
 
   zetasql_base::Status ValidateResolvedCast(
-      const std::set<ResolvedColumn>& visible_columns,
-      const std::set<ResolvedColumn>& visible_parameters,
+      const ResolvedColumnSet& visible_columns,
+      const ResolvedColumnSet& visible_parameters,
       const ResolvedCast* resolved_cast) const;
 
   zetasql_base::Status ValidateResolvedConstant(
-      const std::set<ResolvedColumn>& visible_columns,
-      const std::set<ResolvedColumn>& visible_parameters,
+      const ResolvedColumnSet& visible_columns,
+      const ResolvedColumnSet& visible_parameters,
       const ResolvedConstant* resolved_constant) const;
 
   zetasql_base::Status ValidateResolvedFunctionCallBase(
-      const std::set<ResolvedColumn>& visible_columns,
-      const std::set<ResolvedColumn>& visible_parameters,
+      const ResolvedColumnSet& visible_columns,
+      const ResolvedColumnSet& visible_parameters,
       const ResolvedFunctionCallBase* resolved_function_call) const;
 
   zetasql_base::Status ValidateHintList(
@@ -312,7 +325,7 @@ class Validator {
       const ResolvedParameter* resolved_param) const;
 
   zetasql_base::Status ValidateResolvedTVFArgument(
-      const std::set<ResolvedColumn>& visible_parameters,
+      const ResolvedColumnSet& visible_parameters,
       const ResolvedTVFArgument* resolved_tvf_arg) const;
 
   // Validates TVF relation argument schema against the required input schema
@@ -324,38 +337,38 @@ class Validator {
 
   zetasql_base::Status CheckColumnIsPresentInColumnSet(
       const ResolvedColumn& column,
-      const std::set<ResolvedColumn>& visible_columns) const;
+      const ResolvedColumnSet& visible_columns) const;
 
   // Verifies that the scan column list only contains column from the visible
   // set.
   zetasql_base::Status CheckColumnList(const ResolvedScan* scan,
-                               const std::set<ResolvedColumn>& visible_columns)
+                               const ResolvedColumnSet& visible_columns)
       const;
 
   zetasql_base::Status AddColumnList(const ResolvedColumnList& column_list,
-                             std::set<ResolvedColumn>* visible_columns) const;
+                             ResolvedColumnSet* visible_columns) const;
   zetasql_base::Status AddColumnFromComputedColumn(
       const ResolvedComputedColumn* computed_column,
-      std::set<ResolvedColumn>* visible_columns) const;
+      ResolvedColumnSet* visible_columns) const;
   zetasql_base::Status AddColumnsFromComputedColumnList(
       const std::vector<std::unique_ptr<const ResolvedComputedColumn>>&
           computed_column_list,
-      std::set<ResolvedColumn>* visible_columns) const;
+      ResolvedColumnSet* visible_columns) const;
 
   zetasql_base::Status ValidateResolvedAnalyticFunctionGroup(
       const ResolvedAnalyticFunctionGroup* group,
-      const std::set<ResolvedColumn>& input_visible_columns,
-      const std::set<ResolvedColumn>& visible_parameters) const;
+      const ResolvedColumnSet& input_visible_columns,
+      const ResolvedColumnSet& visible_parameters) const;
 
   zetasql_base::Status ValidateResolvedWindowFrame(
-      const std::set<ResolvedColumn>& visible_columns,
-      const std::set<ResolvedColumn>& visible_parameters,
+      const ResolvedColumnSet& visible_columns,
+      const ResolvedColumnSet& visible_parameters,
       const ResolvedWindowOrdering* window_ordering,
       const ResolvedWindowFrame* window_frame) const;
 
   zetasql_base::Status ValidateResolvedWindowFrameExpr(
-      const std::set<ResolvedColumn>& visible_columns,
-      const std::set<ResolvedColumn>& visible_parameters,
+      const ResolvedColumnSet& visible_columns,
+      const ResolvedColumnSet& visible_parameters,
       const ResolvedWindowOrdering* window_ordering,
       const ResolvedWindowFrame::FrameUnit& frame_unit,
       const ResolvedWindowFrameExpr* window_frame_expr) const;
@@ -0,0 +1,287 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/resolved_ast/with_entries.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/public/function.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "zetasql/resolved_ast/resolved_column.h"
+#include "zetasql/resolved_ast/resolved_node_kind.pb.h"
+#include "absl/container/flat_hash_map.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+namespace {
+
+typedef std::unique_ptr<const ResolvedNode>* NodeSlot;
+
+class WithEntryAnnotator {
+ public:
+  struct EntryInfo {
+    ResolvedWithEntry* entry = nullptr;
+    // Number of subquery expressions around the defining ResolvedWithScan.
+    int subquery_depth = 0;
+    int num_references = 0;
+    // True if a reference is in a subquery expression below the
+    // ResolvedWithScan.
+    bool referenced_from_subquery = false;
+    bool is_deterministic = true;
+    bool is_cheap = true;
+  };
+
+  WithEntryAnnotator() {}
+  WithEntryAnnotator(const WithEntryAnnotator&) = delete;
+  WithEntryAnnotator& operator=(const WithEntryAnnotator&) = delete;
+
+  zetasql_base::Status Run(const ResolvedNode* root) {
+    Properties properties;
+    ZETASQL_RETURN_IF_ERROR(Annotate(root, /*subquery_depth=*/0, &properties));
+    for (const auto& name_and_info : entries_) {
+      const EntryInfo& info = name_and_info.second;
+      info.entry->set_reference_count(info.num_references);
+      info.entry->set_is_deterministic(info.is_deterministic);
+      info.entry->set_is_cheap(info.is_cheap);
+    }
+    return ::zetasql_base::OkStatus();
+  }
+
+  const absl::flat_hash_map<std::string, EntryInfo>& entries() const {
+    return entries_;
+  }
+
+ private:
+  // Properties of a subtree, as defined for ResolvedWithEntry::with_subquery.
+  struct Properties {
+    bool is_deterministic = true;
+    bool is_cheap = true;
+  };
+
+  // Annotates the WITH entries in the tree at <node>, which is below
+  // <subquery_depth> subquery expressions, and clears the <properties> that
+  // it does not have.
+  zetasql_base::Status Annotate(const ResolvedNode* node, int subquery_depth,
+                        Properties* properties) {
+    switch (node->node_kind()) {
+      case RESOLVED_WITH_SCAN: {
+        // Entries are defined before they are referenced, so annotating
+        // them in order gives each one the properties of those it scans.
+        const auto* scan = node->GetAs<ResolvedWithScan>();
+        for (const auto& entry : scan->with_entry_list()) {
+          Properties entry_properties;
+          ZETASQL_RETURN_IF_ERROR(Annotate(entry->with_subquery(), subquery_depth,
+                                   &entry_properties));
+          EntryInfo& info = entries_[entry->with_query_name()];
+          ZETASQL_RET_CHECK(info.entry == nullptr)
+              << "Duplicate WITH entry " << entry->with_query_name();
+          info.entry = const_cast<ResolvedWithEntry*>(entry.get());
+          info.subquery_depth = subquery_depth;
+          info.is_deterministic = entry_properties.is_deterministic;
+          info.is_cheap = entry_properties.is_cheap;
+          properties->is_deterministic &= entry_properties.is_deterministic;
+        }
+        properties->is_cheap = false;
+        return Annotate(scan->query(), subquery_depth, properties);
+      }
+      case RESOLVED_WITH_REF_SCAN: {
+        const auto* scan = node->GetAs<ResolvedWithRefScan>();
+        auto it = entries_.find(scan->with_query_name());
+        ZETASQL_RET_CHECK(it != entries_.end())
+            << "WITH entry " << scan->with_query_name()
+            << " referenced before its definition";
+        EntryInfo& info = it->second;
+        ++info.num_references;
+        if (subquery_depth != info.subquery_depth) {
+          info.referenced_from_subquery = true;
+        }
+        properties->is_deterministic &= info.is_deterministic;
+        properties->is_cheap &= info.is_cheap;
+        return ::zetasql_base::OkStatus();
+      }
+      case RESOLVED_SUBQUERY_EXPR:
+        ++subquery_depth;
+        properties->is_cheap = false;
+        break;
+      case RESOLVED_FUNCTION_CALL:
+      case RESOLVED_AGGREGATE_FUNCTION_CALL:
+      case RESOLVED_ANALYTIC_FUNCTION_CALL:
+        if (node->GetAs<ResolvedFunctionCallBase>()
+                ->function()
+                ->function_options()
+                .volatility == FunctionEnums::VOLATILE) {
+          properties->is_deterministic = false;
+        }
+        break;
+      case RESOLVED_SAMPLE_SCAN:
+        if (node->GetAs<ResolvedSampleScan>()->repeatable_argument() ==
+            nullptr) {
+          properties->is_deterministic = false;
+        }
+        properties->is_cheap = false;
+        break;
+      case RESOLVED_TVFSCAN:
+      case RESOLVED_LIMIT_OFFSET_SCAN:
+        // Even over ordered input, LIMIT may pick any of the tied rows.
+        properties->is_deterministic = false;
+        properties->is_cheap = false;
+        break;
+      case RESOLVED_PROJECT_SCAN:
+      case RESOLVED_FILTER_SCAN:
+      case RESOLVED_TABLE_SCAN:
+      case RESOLVED_SINGLE_ROW_SCAN:
+        break;
+      default:
+        if (node->IsScan()) properties->is_cheap = false;
+        break;
+    }
+    std::vector<const ResolvedNode*> children;
+    node->GetChildNodes(&children);
+    for (const ResolvedNode* child : children) {
+      ZETASQL_RETURN_IF_ERROR(Annotate(child, subquery_depth, properties));
+    }
+    return ::zetasql_base::OkStatus();
+  }
+
+  absl::flat_hash_map<std::string, EntryInfo> entries_;
+};
+
+class WithEntryInliner {
+ public:
+  explicit WithEntryInliner(
+      const absl::flat_hash_map<std::string, WithEntryAnnotator::EntryInfo>&
+          entries)
+      : entries_(entries) {}
+  WithEntryInliner(const WithEntryInliner&) = delete;
+  WithEntryInliner& operator=(const WithEntryInliner&) = delete;
+
+  zetasql_base::Status Run(NodeSlot root) {
+    ZETASQL_RETURN_IF_ERROR(Rewrite(root));
+    ZETASQL_RET_CHECK(subqueries_.empty()) << "Inlined WITH entry not referenced";
+    return ::zetasql_base::OkStatus();
+  }
+
+ private:
+  bool ShouldInline(const std::string& with_query_name) const {
+    auto it = entries_.find(with_query_name);
+    return it != entries_.end() && it->second.num_references == 1 &&
+           !it->second.referenced_from_subquery;
+  }
+
+  zetasql_base::Status Rewrite(NodeSlot slot) {
+    switch ((*slot)->node_kind()) {
+      case RESOLVED_WITH_SCAN:
+        return RewriteWithScan(slot);
+      case RESOLVED_WITH_REF_SCAN: {
+        auto* ref = const_cast<ResolvedWithRefScan*>(
+            (*slot)->GetAs<ResolvedWithRefScan>());
+        auto it = subqueries_.find(ref->with_query_name());
+        if (it == subqueries_.end()) return ::zetasql_base::OkStatus();
+        std::unique_ptr<const ResolvedScan> subquery = std::move(it->second);
+        subqueries_.erase(it);
+
+        const std::vector<ResolvedColumn>& columns = ref->column_list();
+        const std::vector<ResolvedColumn>& subquery_columns =
+            subquery->column_list();
+        ZETASQL_RET_CHECK_EQ(columns.size(), subquery_columns.size());
+        std::vector<std::unique_ptr<const ResolvedComputedColumn>> expr_list;
+        for (int i = 0; i < columns.size(); ++i) {
+          expr_list.push_back(MakeResolvedComputedColumn(
+              columns[i],
+              MakeResolvedColumnRef(subquery_columns[i].type(),
+                                    subquery_columns[i],
+                                    /*is_correlated=*/false)));
+        }
+        auto project = MakeResolvedProjectScan(columns, std::move(expr_list),
+                                               std::move(subquery));
+        project->set_hint_list(ref->release_hint_list());
+        *slot = std::move(project);
+        return ::zetasql_base::OkStatus();
+      }
+      default: {
+        std::vector<NodeSlot> children;
+        const_cast<ResolvedNode*>(slot->get())
+            ->AddMutableChildNodePointers(&children);
+        for (NodeSlot child : children) {
+          ZETASQL_RETURN_IF_ERROR(Rewrite(child));
+        }
+        return ::zetasql_base::OkStatus();
+      }
+    }
+  }
+
+  // Rewrites the entries of the ResolvedWithScan at <slot> in order, setting
+  // aside those to inline for their references in later entries or in the
+  // query, then rewrites the query.
+  zetasql_base::Status RewriteWithScan(NodeSlot slot) {
+    auto* scan =
+        const_cast<ResolvedWithScan*>((*slot)->GetAs<ResolvedWithScan>());
+    std::vector<std::unique_ptr<const ResolvedWithEntry>> kept_entries;
+    for (auto& entry : scan->release_with_entry_list()) {
+      auto* mutable_entry = const_cast<ResolvedWithEntry*>(entry.get());
+      std::unique_ptr<const ResolvedNode> subquery =
+          mutable_entry->release_with_subquery();
+      ZETASQL_RETURN_IF_ERROR(Rewrite(&subquery));
+      std::unique_ptr<const ResolvedScan> subquery_scan(
+          subquery.release()->GetAs<ResolvedScan>());
+      if (ShouldInline(entry->with_query_name())) {
+        subqueries_[entry->with_query_name()] = std::move(subquery_scan);
+      } else {
+        mutable_entry->set_with_subquery(std::move(subquery_scan));
+        kept_entries.push_back(std::move(entry));
+      }
+    }
+
+    std::unique_ptr<const ResolvedNode> query = scan->release_query();
+    ZETASQL_RETURN_IF_ERROR(Rewrite(&query));
+    if (kept_entries.empty()) {
+      *slot = std::move(query);
+      return ::zetasql_base::OkStatus();
+    }
+    scan->set_with_entry_list(std::move(kept_entries));
+    scan->set_query(std::unique_ptr<const ResolvedScan>(
+        query.release()->GetAs<ResolvedScan>()));
+    return ::zetasql_base::OkStatus();
+  }
+
+  const absl::flat_hash_map<std::string, WithEntryAnnotator::EntryInfo>&
+      entries_;
+
+  // Subqueries of inlined entries whose reference has not been reached yet.
+  absl::flat_hash_map<std::string, std::unique_ptr<const ResolvedScan>>
+      subqueries_;
+};
+
+}  // namespace
+
+zetasql_base::Status AnnotateWithEntries(ResolvedNode* root) {
+  WithEntryAnnotator annotator;
+  return annotator.Run(root);
+}
+
+zetasql_base::Status InlineSingleUseWithEntries(
+    std::unique_ptr<const ResolvedNode>* root) {
+  WithEntryAnnotator annotator;
+  ZETASQL_RETURN_IF_ERROR(annotator.Run(root->get()));
+  WithEntryInliner inliner(annotator.entries());
+  return inliner.Run(root);
+}
+
+}  // namespace zetasql
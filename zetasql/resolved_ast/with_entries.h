@@ -0,0 +1,53 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_RESOLVED_AST_WITH_ENTRIES_H_
+#define ZETASQL_RESOLVED_AST_WITH_ENTRIES_H_
+
+#include <memory>
+
+#include "zetasql/resolved_ast/resolved_node.h"
+#include "zetasql/base/status.h"
+
+namespace zetasql {
+
+// Sets reference_count, is_deterministic and is_cheap on every
+// ResolvedWithEntry in the tree at <root>, which is modified in place.
+// See ResolvedWithEntry for what they mean.
+//
+// Reference counts are static: a ResolvedWithRefScan counts once even if it
+// is in a subquery expression that runs once per row of an outer query, or
+// in a WITH subquery that is itself referenced several times.
+zetasql_base::Status AnnotateWithEntries(ResolvedNode* root);
+
+// Annotates the tree at <*root> as AnnotateWithEntries() does, then inlines
+// every WITH subquery that is referenced exactly once.  The
+// ResolvedWithRefScan is replaced by a ResolvedProjectScan over the
+// subquery that renames its columns to those of the ResolvedWithRefScan, the
+// ResolvedWithEntry is removed, and a ResolvedWithScan left without entries
+// is replaced by its query.  The tree is modified in place.
+//
+// Running a subquery in place of its only reference does not change the
+// results even if it is not deterministic, but it could run it once per row
+// of an outer query, so references in subquery expressions below the
+// ResolvedWithScan that defines them are not inlined.  Entries that are
+// never referenced are kept; query engines may choose not to run them.
+zetasql_base::Status InlineSingleUseWithEntries(
+    std::unique_ptr<const ResolvedNode>* root);
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_RESOLVED_AST_WITH_ENTRIES_H_
@@ -0,0 +1,187 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/resolved_ast/with_entries.h"
+
+#include <memory>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/builtin_function.pb.h"
+#include "zetasql/public/function.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/resolved_ast/make_node_vector.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "zetasql/resolved_ast/resolved_column.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+
+namespace zetasql {
+
+class WithEntriesTest : public ::testing::Test {
+ protected:
+  WithEntriesTest()
+      : table_("T", {{"a", types::Int64Type()}}),
+        a_(1, "T", "a", types::Int64Type()),
+        x_(2, "w1", "a", types::Int64Type()),
+        y_(3, "w2", "a", types::Int64Type()),
+        z_(4, "w2", "a", types::Int64Type()) {}
+
+  std::unique_ptr<const ResolvedScan> TableScan() {
+    return MakeResolvedTableScan({a_}, &table_,
+                                 /*for_system_time_expr=*/nullptr);
+  }
+
+  // SELECT * FROM <left> JOIN <right>
+  static std::unique_ptr<const ResolvedScan> Join(
+      std::unique_ptr<const ResolvedScan> left,
+      std::unique_ptr<const ResolvedScan> right) {
+    std::vector<ResolvedColumn> columns = left->column_list();
+    for (const ResolvedColumn& column : right->column_list()) {
+      columns.push_back(column);
+    }
+    return MakeResolvedJoinScan(columns, ResolvedJoinScan::INNER,
+                                std::move(left), std::move(right),
+                                /*join_expr=*/nullptr);
+  }
+
+  SimpleTable table_;
+  const ResolvedColumn a_;
+  const ResolvedColumn x_;
+  const ResolvedColumn y_;
+  const ResolvedColumn z_;
+};
+
+TEST_F(WithEntriesTest, Annotates) {
+  // WITH w1 AS (SELECT a FROM T),
+  //      w2 AS (SELECT * FROM w1 LIMIT 1),
+  //      w3 AS (SELECT RAND())
+  // SELECT * FROM w2 JOIN w2
+  FunctionOptions volatile_options;
+  volatile_options.set_volatility(FunctionEnums::VOLATILE);
+  Function rand("rand", Function::kZetaSQLFunctionGroupName,
+                Function::SCALAR, volatile_options);
+  const ResolvedColumn r(5, "w3", "r", types::DoubleType());
+  auto rand_scan = MakeResolvedProjectScan(
+      {r},
+      MakeNodeVector(MakeResolvedComputedColumn(
+          r, MakeResolvedFunctionCall(
+                 types::DoubleType(), &rand,
+                 FunctionSignature(types::DoubleType(), {}, FN_RAND), {},
+                 ResolvedFunctionCall::DEFAULT_ERROR_MODE))),
+      MakeResolvedSingleRowScan());
+
+  auto with_scan = MakeResolvedWithScan(
+      {y_, z_},
+      MakeNodeVector(
+          MakeResolvedWithEntry("w1", TableScan()),
+          MakeResolvedWithEntry(
+              "w2", MakeResolvedLimitOffsetScan(
+                        {x_}, MakeResolvedWithRefScan({x_}, "w1"),
+                        MakeResolvedLiteral(Value::Int64(1)),
+                        /*offset=*/nullptr)),
+          MakeResolvedWithEntry("w3", std::move(rand_scan))),
+      Join(MakeResolvedWithRefScan({y_}, "w2"),
+           MakeResolvedWithRefScan({z_}, "w2")));
+  ZETASQL_ASSERT_OK(AnnotateWithEntries(with_scan.get()));
+
+  const ResolvedWithEntry* w1 = with_scan->with_entry_list(0);
+  EXPECT_EQ(1, w1->reference_count());
+  EXPECT_TRUE(w1->is_deterministic());
+  EXPECT_TRUE(w1->is_cheap());
+  const ResolvedWithEntry* w2 = with_scan->with_entry_list(1);
+  EXPECT_EQ(2, w2->reference_count());
+  EXPECT_FALSE(w2->is_deterministic());
+  EXPECT_FALSE(w2->is_cheap());
+  const ResolvedWithEntry* w3 = with_scan->with_entry_list(2);
+  EXPECT_EQ(0, w3->reference_count());
+  EXPECT_FALSE(w3->is_deterministic());
+  EXPECT_TRUE(w3->is_cheap());
+  EXPECT_THAT(w2->DebugString(), ::testing::HasSubstr("reference_count=2"));
+}
+
+TEST_F(WithEntriesTest, InlinesSingleUseEntries) {
+  // WITH w1 AS (SELECT a FROM T), w2 AS (SELECT * FROM w1)
+  // SELECT * FROM w2 JOIN w2
+  std::unique_ptr<const ResolvedNode> node = MakeResolvedWithScan(
+      {y_, z_},
+      MakeNodeVector(MakeResolvedWithEntry("w1", TableScan()),
+                     MakeResolvedWithEntry(
+                         "w2", MakeResolvedWithRefScan({x_}, "w1"))),
+      Join(MakeResolvedWithRefScan({y_}, "w2"),
+           MakeResolvedWithRefScan({z_}, "w2")));
+  ZETASQL_ASSERT_OK(InlineSingleUseWithEntries(&node));
+
+  ASSERT_EQ(RESOLVED_WITH_SCAN, node->node_kind());
+  const auto* with_scan = node->GetAs<ResolvedWithScan>();
+  ASSERT_EQ(1, with_scan->with_entry_list_size());
+  const ResolvedWithEntry* w2 = with_scan->with_entry_list(0);
+  EXPECT_EQ("w2", w2->with_query_name());
+  EXPECT_EQ(2, w2->reference_count());
+  ASSERT_EQ(RESOLVED_PROJECT_SCAN, w2->with_subquery()->node_kind());
+  const auto* project = w2->with_subquery()->GetAs<ResolvedProjectScan>();
+  EXPECT_EQ(std::vector<ResolvedColumn>{x_}, project->column_list());
+  ASSERT_EQ(1, project->expr_list_size());
+  EXPECT_EQ(x_, project->expr_list(0)->column());
+  const ResolvedExpr* expr = project->expr_list(0)->expr();
+  ASSERT_EQ(RESOLVED_COLUMN_REF, expr->node_kind());
+  EXPECT_EQ(a_, expr->GetAs<ResolvedColumnRef>()->column());
+  EXPECT_EQ(RESOLVED_TABLE_SCAN, project->input_scan()->node_kind());
+  EXPECT_EQ(RESOLVED_JOIN_SCAN, with_scan->query()->node_kind());
+}
+
+TEST_F(WithEntriesTest, RemovesEmptyWithScan) {
+  // WITH w1 AS (SELECT a FROM T) SELECT * FROM w1
+  std::unique_ptr<const ResolvedNode> node = MakeResolvedQueryStmt(
+      MakeNodeVector(MakeResolvedOutputColumn("a", x_)),
+      /*is_value_table=*/false,
+      MakeResolvedWithScan(
+          {x_}, MakeNodeVector(MakeResolvedWithEntry("w1", TableScan())),
+          MakeResolvedWithRefScan({x_}, "w1")));
+  ZETASQL_ASSERT_OK(InlineSingleUseWithEntries(&node));
+
+  const ResolvedScan* query = node->GetAs<ResolvedQueryStmt>()->query();
+  ASSERT_EQ(RESOLVED_PROJECT_SCAN, query->node_kind());
+  EXPECT_EQ(std::vector<ResolvedColumn>{x_}, query->column_list());
+  EXPECT_EQ(RESOLVED_TABLE_SCAN,
+            query->GetAs<ResolvedProjectScan>()->input_scan()->node_kind());
+}
+
+TEST_F(WithEntriesTest, KeepsEntriesReferencedFromSubqueries) {
+  // WITH w1 AS (SELECT a FROM T) SELECT (SELECT a FROM w1)
+  const ResolvedColumn s(5, "$query", "s", types::Int64Type());
+  auto subquery = MakeResolvedSubqueryExpr(
+      types::Int64Type(), ResolvedSubqueryExpr::SCALAR,
+      /*parameter_list=*/{}, /*in_expr=*/nullptr,
+      MakeResolvedWithRefScan({x_}, "w1"));
+  std::unique_ptr<const ResolvedNode> node = MakeResolvedWithScan(
+      {s}, MakeNodeVector(MakeResolvedWithEntry("w1", TableScan())),
+      MakeResolvedProjectScan(
+          {s},
+          MakeNodeVector(MakeResolvedComputedColumn(s, std::move(subquery))),
+          MakeResolvedSingleRowScan()));
+  ZETASQL_ASSERT_OK(InlineSingleUseWithEntries(&node));
+
+  ASSERT_EQ(RESOLVED_WITH_SCAN, node->node_kind());
+  const auto* with_scan = node->GetAs<ResolvedWithScan>();
+  ASSERT_EQ(1, with_scan->with_entry_list_size());
+  EXPECT_EQ(1, with_scan->with_entry_list(0)->reference_count());
+}
+
+}  // namespace zetasql
@@ -0,0 +1,191 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/testing/sql_workload_generator.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/public/catalog.h"
+#include "zetasql/public/function_signature.h"
+#include "zetasql/public/parse_resume_location.h"
+#include "zetasql/public/strings.h"
+#include "zetasql/public/templated_sql_function.h"
+#include "zetasql/public/type.h"
+#include "absl/strings/str_cat.h"
+#include "zetasql/base/source_location.h"
+#include "zetasql/base/status_builder.h"
+
+namespace zetasql {
+
+namespace {
+
+// The bodies of the functions of AddWorkloadFunctions(), of argument x.
+const char* const kWorkloadFunctionBodies[] = {
+    "x + 1",
+    "x * 2 - 1",
+    "workload_udf_0(x) + workload_udf_1(x)",
+};
+
+// Builds one query.  std::mt19937 is fully specified by the standard, unlike
+// the standard distributions, so the queries are the same on all platforms.
+class QueryBuilder {
+ public:
+  QueryBuilder(const SqlWorkloadOptions& options, int num_inputs)
+      : options_(options), num_inputs_(num_inputs), random_(options.seed) {}
+
+  int Next(int bound) { return static_cast<int>(random_() % bound); }
+
+  // Returns a FROM item giving column k: one of <tables>, or one of the
+  // first <num_ctes> WITH entries.
+  std::string Source(const std::vector<std::string>& tables, int num_ctes) {
+    const int choice = Next(num_inputs_ + num_ctes);
+    if (choice >= num_inputs_) {
+      return absl::StrCat("cte_", choice - num_inputs_);
+    }
+    return tables[choice];
+  }
+
+  // Returns <source> in <options_.nesting_depth> levels of subqueries.
+  std::string Nest(std::string source) {
+    for (int i = 0; i < options_.nesting_depth; ++i) {
+      if (i % 2 == 0) {
+        source = absl::StrCat("(SELECT k + ", i + 1, " AS k FROM ", source,
+                              ")");
+      } else {
+        source = absl::StrCat("(SELECT k FROM ", source,
+                              " WHERE k IS NOT NULL)");
+      }
+    }
+    return source;
+  }
+
+ private:
+  const SqlWorkloadOptions& options_;
+  const int num_inputs_;
+  std::mt19937 random_;
+};
+
+}  // namespace
+
+zetasql_base::StatusOr<SqlWorkloadGenerator> SqlWorkloadGenerator::Create(
+    const SimpleCatalog& catalog) {
+  std::vector<std::string> names = catalog.table_names();
+  std::sort(names.begin(), names.end());
+  std::vector<Input> inputs;
+  for (const std::string& name : names) {
+    const Table* table = nullptr;
+    if (!catalog.FindTable({name}, &table).ok() || table->IsValueTable()) {
+      continue;
+    }
+    for (int i = 0; i < table->NumColumns(); ++i) {
+      const Column* column = table->GetColumn(i);
+      if (column->GetType()->IsInt64() && !column->IsPseudoColumn() &&
+          !column->Name().empty()) {
+        inputs.push_back(
+            {ToIdentifierLiteral(name), ToIdentifierLiteral(column->Name())});
+        break;
+      }
+    }
+  }
+  if (inputs.empty()) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "Catalog " << catalog.FullName()
+           << " has no table with an INT64 column";
+  }
+  return SqlWorkloadGenerator(std::move(inputs));
+}
+
+void SqlWorkloadGenerator::AddWorkloadFunctions(SimpleCatalog* catalog) {
+  for (int i = 0; i < kNumWorkloadFunctions; ++i) {
+    catalog->AddOwnedFunction(new TemplatedSQLFunction(
+        {absl::StrCat("workload_udf_", i)},
+        FunctionSignature(FunctionArgumentType(ARG_TYPE_ARBITRARY),
+                          {FunctionArgumentType(types::Int64Type())},
+                          /*context_id=*/i),
+        /*argument_names=*/{"x"},
+        ParseResumeLocation::FromString(kWorkloadFunctionBodies[i])));
+  }
+}
+
+zetasql_base::StatusOr<std::string> SqlWorkloadGenerator::GenerateQuery(
+    const SqlWorkloadOptions& options) const {
+  if (options.num_joins < 0 || options.nesting_depth < 0 ||
+      options.expression_width < 1 || options.in_list_length < 0 ||
+      options.num_ctes < 0 || options.num_udf_calls < 0) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder(ZETASQL_LOC)
+           << "Workload options out of range";
+  }
+  QueryBuilder builder(options, inputs_.size());
+  std::vector<std::string> tables;
+  for (const Input& input : inputs_) {
+    tables.push_back(absl::StrCat("(SELECT ", input.column, " AS k FROM ",
+                                  input.table, ")"));
+  }
+
+  std::string sql;
+  for (int i = 0; i < options.num_ctes; ++i) {
+    // Skip the parentheses of table subqueries, which the entry has.
+    std::string source = builder.Source(tables, i);
+    if (source[0] == '(') {
+      source = source.substr(1, source.size() - 2);
+    } else {
+      source = absl::StrCat("SELECT k FROM ", source);
+    }
+    absl::StrAppend(&sql, i == 0 ? "WITH " : ",\n  ", "cte_", i, " AS (",
+                    source, ")");
+  }
+  if (!sql.empty()) absl::StrAppend(&sql, "\n");
+
+  const int num_aliases = options.num_joins + 1;
+  absl::StrAppend(&sql, "SELECT ");
+  for (int i = 0; i < options.expression_width; ++i) {
+    const int alias = builder.Next(num_aliases);
+    if (i > 0) absl::StrAppend(&sql, builder.Next(2) == 0 ? " + " : " - ");
+    absl::StrAppend(&sql, "t", alias, ".k");
+    if (builder.Next(2) == 0) {
+      absl::StrAppend(&sql, " * ", builder.Next(9) + 2);
+    }
+  }
+  absl::StrAppend(&sql, " AS e");
+  for (int i = 0; i < options.num_udf_calls; ++i) {
+    absl::StrAppend(&sql, ",\n  workload_udf_", i % kNumWorkloadFunctions,
+                    "(t", builder.Next(num_aliases), ".k) AS u", i);
+  }
+
+  absl::StrAppend(&sql, "\nFROM ",
+                  builder.Nest(builder.Source(tables, options.num_ctes)),
+                  " AS t0");
+  for (int i = 1; i < num_aliases; ++i) {
+    absl::StrAppend(&sql, "\n  ", builder.Next(2) == 0 ? "JOIN " : "LEFT JOIN ",
+                    builder.Nest(builder.Source(tables, options.num_ctes)),
+                    " AS t", i, " ON t", builder.Next(i), ".k = t", i, ".k");
+  }
+
+  if (options.in_list_length > 0) {
+    absl::StrAppend(&sql, "\nWHERE t0.k IN (");
+    for (int i = 0; i < options.in_list_length; ++i) {
+      absl::StrAppend(&sql, i == 0 ? "" : ", ", builder.Next(1000));
+    }
+    absl::StrAppend(&sql, ")");
+  }
+  return sql;
+}
+
+}  // namespace zetasql
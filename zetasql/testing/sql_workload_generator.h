@@ -0,0 +1,113 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_TESTING_SQL_WORKLOAD_GENERATOR_H_
+#define ZETASQL_TESTING_SQL_WORKLOAD_GENERATOR_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/base/status.h"
+#include "zetasql/base/statusor.h"
+
+namespace zetasql {
+
+// The size of a query made by SqlWorkloadGenerator.  Each field scales one
+// part of the query independently of the others, so that a scaling curve
+// can vary one of them and keep the rest fixed.
+struct SqlWorkloadOptions {
+  // The number of JOINs of the outermost FROM clause.
+  int num_joins = 0;
+
+  // The number of levels of subqueries around each input of the joins.
+  int nesting_depth = 0;
+
+  // The number of terms of the arithmetic expression of the select list.
+  int expression_width = 1;
+
+  // The number of literals of an IN list filtering the first join input,
+  // or 0 for no filter.
+  int in_list_length = 0;
+
+  // The number of WITH entries.  Each one reads a table or an earlier
+  // entry, and the join inputs read tables and entries.
+  int num_ctes = 0;
+
+  // The number of select-list columns calling one of the functions added by
+  // SqlWorkloadGenerator::AddWorkloadFunctions().
+  int num_udf_calls = 0;
+
+  // Seeds the choice of tables, columns, join kinds and literals.  The same
+  // options over the same catalog always give the same query.
+  uint32_t seed = 0;
+};
+
+// Makes valid queries of controllable size over the tables of a
+// SimpleCatalog, such as testdata/sample_catalog.h, for benchmarks and
+// scale tests.  Every table of the catalog with an INT64 column can be an
+// input; each input is projected to one INT64 column named k, so inputs of
+// any schema can be joined and nested.  For example, with num_joins 1,
+// nesting_depth 1, expression_width 2, in_list_length 2 and num_ctes 1, and
+// with line breaks added:
+//
+//   WITH cte_0 AS (SELECT Key AS k FROM keyvalue)
+//   SELECT t0.k + t1.k * 3 AS e
+//   FROM (SELECT k + 1 AS k FROM cte_0) AS t0
+//     LEFT JOIN (SELECT k + 1 AS k FROM (SELECT int64 AS k FROM simpletypes))
+//       AS t1 ON t0.k = t1.k
+//   WHERE t0.k IN (17, 402)
+class SqlWorkloadGenerator {
+ public:
+  // The number of functions added by AddWorkloadFunctions().
+  static constexpr int kNumWorkloadFunctions = 3;
+
+  // Returns a generator over the tables of <catalog>, which must have a
+  // table with an INT64 column.  Nested catalogs are not used.  The
+  // generator keeps no reference to <catalog>.
+  static zetasql_base::StatusOr<SqlWorkloadGenerator> Create(
+      const SimpleCatalog& catalog);
+
+  // Adds the templated SQL functions workload_udf_<i>(INT64), for i below
+  // kNumWorkloadFunctions, that the queries with num_udf_calls call.  The
+  // last one calls the others, so that calls also exercise nested function
+  // resolution.
+  static void AddWorkloadFunctions(SimpleCatalog* catalog);
+
+  // Returns a query of the size of <options>, or an error if a field of
+  // <options> is out of range.
+  zetasql_base::StatusOr<std::string> GenerateQuery(
+      const SqlWorkloadOptions& options) const;
+
+ private:
+  // A table and one of its INT64 columns, quoted.
+  struct Input {
+    std::string table;
+    std::string column;
+  };
+
+  explicit SqlWorkloadGenerator(std::vector<Input> inputs)
+      : inputs_(std::move(inputs)) {}
+
+  // In the order of the table names, for reproducibility.
+  std::vector<Input> inputs_;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_TESTING_SQL_WORKLOAD_GENERATOR_H_
@@ -0,0 +1,126 @@
+//
+// Copyright 2019 ZetaSQL Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/testing/sql_workload_generator.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/analyzer.h"
+#include "zetasql/public/language_options.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/testdata/sample_catalog.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+
+namespace zetasql {
+
+using zetasql_base::testing::StatusIs;
+
+class SqlWorkloadGeneratorTest : public ::testing::Test {
+ protected:
+  SqlWorkloadGeneratorTest() : catalog_(Options()) {
+    SqlWorkloadGenerator::AddWorkloadFunctions(catalog_.catalog());
+  }
+
+  static LanguageOptions Options() {
+    LanguageOptions language_options;
+    language_options.EnableMaximumLanguageFeatures();
+    return language_options;
+  }
+
+  zetasql_base::Status Analyze(const std::string& sql) {
+    TypeFactory type_factory;
+    std::unique_ptr<const AnalyzerOutput> output;
+    return AnalyzeStatement(sql, AnalyzerOptions(Options()),
+                            catalog_.catalog(), &type_factory, &output);
+  }
+
+  // Returns the number of occurrences of <part> in <sql>, plus one.
+  static int Count(const std::string& sql, const std::string& part) {
+    const std::vector<absl::string_view> pieces = absl::StrSplit(sql, part);
+    return static_cast<int>(pieces.size());
+  }
+
+  SampleCatalog catalog_;
+};
+
+TEST_F(SqlWorkloadGeneratorTest, GeneratesValidQueries) {
+  ZETASQL_ASSERT_OK_AND_ASSIGN(SqlWorkloadGenerator generator,
+                       SqlWorkloadGenerator::Create(*catalog_.catalog()));
+  for (uint32_t seed = 0; seed < 20; ++seed) {
+    SqlWorkloadOptions options;
+    options.num_joins = seed % 5;
+    options.nesting_depth = seed % 4;
+    options.expression_width = 1 + seed % 7;
+    options.in_list_length = 3 * (seed % 3);
+    options.num_ctes = seed % 3;
+    options.num_udf_calls = seed % 4;
+    options.seed = seed;
+    ZETASQL_ASSERT_OK_AND_ASSIGN(const std::string sql,
+                         generator.GenerateQuery(options));
+    ZETASQL_EXPECT_OK(Analyze(sql)) << sql;
+  }
+}
+
+TEST_F(SqlWorkloadGeneratorTest, ScalesEachDimension) {
+  ZETASQL_ASSERT_OK_AND_ASSIGN(SqlWorkloadGenerator generator,
+                       SqlWorkloadGenerator::Create(*catalog_.catalog()));
+  SqlWorkloadOptions options;
+  options.num_joins = 20;
+  options.nesting_depth = 10;
+  options.expression_width = 50;
+  options.in_list_length = 200;
+  options.num_ctes = 8;
+  options.num_udf_calls = 6;
+  options.seed = 7;
+  ZETASQL_ASSERT_OK_AND_ASSIGN(const std::string sql,
+                       generator.GenerateQuery(options));
+  ZETASQL_EXPECT_OK(Analyze(sql)) << sql;
+
+  EXPECT_EQ(options.num_joins, Count(sql, " JOIN ") - 1);
+  EXPECT_EQ(options.num_ctes, Count(sql, " AS (") - 1);
+  EXPECT_EQ(options.num_udf_calls, Count(sql, "workload_udf_") - 1);
+  EXPECT_EQ(options.expression_width,
+            Count(sql.substr(0, sql.find(" AS e")), ".k"));
+  EXPECT_TRUE(absl::StrContains(sql, "WHERE t0.k IN ("));
+  EXPECT_EQ(options.in_list_length,
+            Count(sql.substr(sql.find("WHERE")), ", "));
+
+  // The same options give the same query; another seed another query.
+  EXPECT_EQ(sql, generator.GenerateQuery(options).ValueOrDie());
+  options.seed = 8;
+  EXPECT_NE(sql, generator.GenerateQuery(options).ValueOrDie());
+}
+
+TEST_F(SqlWorkloadGeneratorTest, Errors) {
+  EXPECT_THAT(SqlWorkloadGenerator::Create(SimpleCatalog("empty")).status(),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(SqlWorkloadGenerator generator,
+                       SqlWorkloadGenerator::Create(*catalog_.catalog()));
+  SqlWorkloadOptions options;
+  options.expression_width = 0;
+  EXPECT_THAT(generator.GenerateQuery(options).status(),
+              StatusIs(zetasql_base::StatusCode::kInvalidArgument));
+}
+
+}  // namespace zetasql
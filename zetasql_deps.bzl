@@ -325,6 +325,17 @@ java_library(
             sha256 = "7850caaf8149a6aded637f472415f84e4246a21d979d3866d71b1e56242f8de2",
         )
 
+    # Google Benchmark, used by //zetasql/benchmarks.
+    if not native.existing_rule("com_github_google_benchmark"):
+        http_archive(
+            name = "com_github_google_benchmark",
+            urls = [
+                "https://github.com/google/benchmark/archive/v1.5.0.tar.gz",
+            ],
+            strip_prefix = "benchmark-1.5.0",
+            sha256 = "3c6a165b6ecc948967a1ead710d4a181d7b0fbcaa183ef7ea84604994966221a",
+        )
+
     # RE2 Regex Framework, mostly used in unit tests.
     if not native.existing_rule("com_google_re2"):
         http_archive(